@@ -214,6 +214,7 @@ formatter_import(PG_FUNCTION_ARGS)
 	int			  		data_cur;
 	int                 data_len;
 	int                 i;
+	bool			   *proj;
 	
 	/* Must be called via the external table format manager */
 	if (!CALLED_AS_FORMATTER(fcinfo))
@@ -288,6 +289,9 @@ formatter_import(PG_FUNCTION_ARGS)
 	m = FORMATTER_GET_PER_ROW_MEM_CTX(fcinfo);
 	oldcontext = MemoryContextSwitchTo(m);
 
+	/* columns the scan doesn't need are skipped and left NULL */
+	proj = FORMATTER_GET_PROJECTION(fcinfo);
+
 	for (i = 0; i < ncolumns; i++)
 	{
 		Oid		type    	= tupdesc->attrs[i]->atttypid;
@@ -313,7 +317,7 @@ formatter_import(PG_FUNCTION_ARGS)
 				
 				memcpy(&value, data_buf + data_cur, attr_len);
 				
-				if(value != NULL_FLOAT8_VALUE)
+				if(value != NULL_FLOAT8_VALUE && (proj == NULL || proj[i]))
 				{
 					myData->nulls[i] = false;
 					myData->values[i] = Float8GetDatum(value);
@@ -348,7 +352,7 @@ formatter_import(PG_FUNCTION_ARGS)
 					FORMATTER_RETURN_NOTIFICATION(fcinfo, FMT_NEED_MORE_DATA);
 				}
 				
-				if (len > 0)
+				if (len > 0 && (proj == NULL || proj[i]))
 				{
 					value = (text *) palloc(len + VARHDRSZ);
 					SET_VARSIZE(value, len + VARHDRSZ);
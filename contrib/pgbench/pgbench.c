@@ -163,6 +163,28 @@ typedef struct
 #define MAX_FILES		128		/* max number of SQL script files allowed */
 #define SHELL_COMMAND_SIZE	256	/* maximum size allowed for shell command */
 
+#define MAX_CLASS_SPECS	8		/* max number of -G workload classes */
+#define COPY_BATCH_ROWS	10000	/* rows sent by each COPY of the copy class */
+
+/*
+ * Latency histogram of a workload class, in microseconds. The first
+ * LATENCY_SUB_BUCKETS buckets are one microsecond wide; after that every
+ * power of two is split into LATENCY_SUB_BUCKETS buckets, which keeps the
+ * percentiles within about 6% up to several hours. It is a fixed size so
+ * that it can be returned through TResult even when threads are emulated
+ * with fork.
+ */
+#define LATENCY_SUB_BUCKETS	8
+#define LATENCY_BUCKETS		(32 * LATENCY_SUB_BUCKETS)
+
+typedef struct
+{
+	int64		count;
+	int64		sum_usec;
+	int64		max_usec;
+	int64		buckets[LATENCY_BUCKETS];
+} LatencyHist;
+
 #define MAX_FILES		128		/* max number of SQL script files allowed */
 
 /*
@@ -185,6 +207,8 @@ typedef struct
 	instr_time	txn_begin;		/* used for measuring latencies */
 	int			use_file;		/* index in sql_files for this client */
 	bool		prepared[MAX_FILES];
+	char	   *role;			/* SET ROLE to this after connecting, if set */
+	LatencyHist *latency;		/* record transaction latencies here, if set */
 } CState;
 
 /*
@@ -204,6 +228,7 @@ typedef struct
 {
 	instr_time		conn_time;
 	int				xacts;
+	LatencyHist		latency[MAX_CLASS_SPECS];	/* by -G class */
 } TResult;
 
 /*
@@ -276,6 +301,52 @@ static char *select_only = {
 	"SELECT abalance FROM pgbench_accounts WHERE aid = :aid;\n"
 };
 
+/*
+ * Greenplum workload classes for -G. Each client runs one class, so that a
+ * mix of point lookups, analytic queries and loads can be run at once and
+ * each class gets its own latencies. The tables are those created by -i.
+ */
+typedef struct
+{
+	const char *name;
+	const char *script;
+} WorkloadClass;
+
+static const WorkloadClass workload_classes[] = {
+	/* single-row lookups, dispatched directly to the segment with the row */
+	{"point",
+		"\\set naccounts " CppAsString2(naccounts) " * :scale\n"
+		"\\setrandom aid 1 :naccounts\n"
+		"SELECT abalance FROM pgbench_accounts WHERE aid = :aid;\n"},
+	/* an aggregate over a range of 10000 accounts on every segment */
+	{"short",
+		"\\set naccounts " CppAsString2(naccounts) " * :scale\n"
+		"\\setrandom aid 1 :naccounts\n"
+		"SELECT bid, count(*), sum(abalance) FROM pgbench_accounts WHERE aid BETWEEN :aid AND :aid + 10000 GROUP BY bid;\n"},
+	/* a scan of all accounts, moved through a Motion to join the tellers */
+	{"long",
+		"SELECT t.tid, count(*), sum(a.abalance) FROM pgbench_accounts a JOIN pgbench_tellers t ON a.bid = t.bid GROUP BY t.tid;\n"},
+	/* batches of 1000 rows appended to an append-only table */
+	{"aoinsert",
+		"\\set naccounts " CppAsString2(naccounts) " * :scale\n"
+		"\\setrandom aid 1 :naccounts\n"
+		"INSERT INTO pgbench_ao_history (tid, bid, aid, delta, mtime) SELECT g % " CppAsString2(ntellers) " + 1, 1, :aid, g, CURRENT_TIMESTAMP FROM generate_series(1, 1000) g;\n"},
+	/* bulk loads of COPY_BATCH_ROWS rows into an append-only table */
+	{"copy",
+		"COPY pgbench_ao_history (tid, bid, aid, delta, mtime) FROM STDIN;\n"}
+};
+
+/* a -G option: which class, how many clients run it and as which role */
+typedef struct
+{
+	int			workload;		/* index in workload_classes */
+	int			nclients;
+	char	   *role;
+} ClassSpec;
+
+static ClassSpec class_specs[MAX_CLASS_SPECS];
+static int	num_class_specs = 0;
+
 /* Function prototypes */
 static void setalarm(int seconds);
 static void* threadRun(void *arg);
@@ -298,6 +369,12 @@ usage(const char *progname)
 		   "  -D VARNAME=VALUE\n"
 		   "               define variable for use by custom script\n"
 		   "  -f FILENAME  read transaction script from FILENAME\n"
+		   "  -G CLASS=NUM[:ROLE]\n"
+		   "               run NUM clients of a Greenplum workload class, as ROLE if\n"
+		   "               given; repeat for a mix, and the latencies of each class\n"
+		   "               are reported. CLASS is point (direct dispatch lookups),\n"
+		   "               short or long (analytic queries), aoinsert (append-only\n"
+		   "               inserts) or copy (COPY bulk loads)\n"
 		   "  -j NUM       number of threads (default: 1)\n"
 		   "  -l           write transaction times to log file\n"
 		   "  -M {simple|extended|prepared}\n"
@@ -394,6 +471,121 @@ doConnect(void)
 	return conn;
 }
 
+/*
+ * Connect a client, and switch to its role. The role decides the resource
+ * queue or group that the client's queries run in.
+ */
+static PGconn *
+doClientConnect(CState *st)
+{
+	PGconn	   *conn = doConnect();
+
+	if (conn != NULL && st->role != NULL)
+	{
+		char		sql[256];
+		PGresult   *res;
+
+		snprintf(sql, sizeof(sql), "SET ROLE %s", st->role);
+		res = PQexec(conn, sql);
+		if (PQresultStatus(res) != PGRES_COMMAND_OK)
+		{
+			fprintf(stderr, "Client %d could not set role: %s", st->id,
+					PQerrorMessage(conn));
+			PQclear(res);
+			PQfinish(conn);
+			return NULL;
+		}
+		PQclear(res);
+	}
+
+	return conn;
+}
+
+/*
+ * Send the rows of a COPY ... FROM STDIN that a script started. Only
+ * sending blocks; the client then waits for the COPY to finish like for
+ * any other command.
+ */
+static bool
+sendCopyData(CState *st)
+{
+	char		row[128];
+	int			i;
+
+	for (i = 0; i < COPY_BATCH_ROWS; i++)
+	{
+		int			len;
+
+		len = snprintf(row, sizeof(row), "%d\t%d\t%d\t%d\t\\N\n",
+					   getrand(1, ntellers * scale),
+					   getrand(1, nbranches * scale),
+					   getrand(1, naccounts * scale),
+					   getrand(-5000, 5000));
+		if (PQputCopyData(st->con, row, len) != 1)
+			return false;
+	}
+
+	return PQputCopyEnd(st->con, NULL) == 1;
+}
+
+static void
+recordLatency(LatencyHist *hist, int64 usec)
+{
+	int			bucket;
+
+	if (usec < LATENCY_SUB_BUCKETS)
+		bucket = (int) usec;
+	else
+	{
+		int			msb = 0;
+		int64		v = usec;
+
+		while (v >>= 1)
+			msb++;
+		bucket = (msb - 2) * LATENCY_SUB_BUCKETS +
+			(int) ((usec >> (msb - 3)) & (LATENCY_SUB_BUCKETS - 1));
+		if (bucket >= LATENCY_BUCKETS)
+			bucket = LATENCY_BUCKETS - 1;
+	}
+
+	hist->buckets[bucket]++;
+	hist->count++;
+	hist->sum_usec += usec;
+	if (hist->max_usec < usec)
+		hist->max_usec = usec;
+}
+
+/* the middle of the bucket that the given fraction of latencies falls in */
+static double
+latencyPercentile(const LatencyHist *hist, double fraction)
+{
+	int64		rank = (int64) (fraction * hist->count);
+	int64		seen = 0;
+	int			bucket;
+
+	if (rank < fraction * hist->count)
+		rank++;
+	if (rank < 1)
+		rank = 1;
+
+	for (bucket = 0; bucket < LATENCY_BUCKETS - 1; bucket++)
+	{
+		seen += hist->buckets[bucket];
+		if (seen >= rank)
+			break;
+	}
+
+	if (bucket < LATENCY_SUB_BUCKETS)
+		return bucket + 0.5;
+	else
+	{
+		int			shift = bucket / LATENCY_SUB_BUCKETS - 1;
+		int64		lower = (int64) (LATENCY_SUB_BUCKETS + bucket % LATENCY_SUB_BUCKETS) << shift;
+
+		return Min(lower + ((int64) 1 << shift) / 2.0, (double) hist->max_usec);
+	}
+}
+
 /* throw away response from backend */
 static void
 discard_response(CState *state)
@@ -761,32 +953,6 @@ top:
 				return true;	/* don't have the whole result yet */
 		}
 
-		/*
-		 * transaction finished: record the time it took in the log
-		 */
-		if (use_log && commands[st->state + 1] == NULL)
-		{
-			instr_time	now;
-			instr_time	diff;
-			double		usec;
-
-			INSTR_TIME_SET_CURRENT(now);
-			diff = now;
-			INSTR_TIME_SUBTRACT(diff, st->txn_begin);
-			usec = (double) INSTR_TIME_GET_MICROSEC(diff);
-
-#ifndef WIN32
-			/* This is more than we really ought to know about instr_time */
-			fprintf(LOGFILE, "%d %d %.0f %d %ld %ld\n",
-					st->id, st->cnt, usec, st->use_file,
-					(long) now.tv_sec, (long) now.tv_usec);
-#else
-			/* On Windows, instr_time doesn't provide a timestamp anyway */
-			fprintf(LOGFILE, "%d %d %.0f %d 0 0\n",
-					st->id, st->cnt, usec, st->use_file);
-#endif
-		}
-
 		if (commands[st->state]->type == SQL_COMMAND)
 		{
 			res = PQgetResult(st->con);
@@ -795,6 +961,16 @@ top:
 				case PGRES_COMMAND_OK:
 				case PGRES_TUPLES_OK:
 					break;	/* OK */
+				case PGRES_COPY_IN:
+					/* send the data, then wait for the COPY to complete */
+					PQclear(res);
+					if (!sendCopyData(st))
+					{
+						fprintf(stderr, "Client %d aborted in state %d while sending COPY data: %s",
+							st->id, st->state, PQerrorMessage(st->con));
+						return clientDone(st, false);
+					}
+					return true;
 				default:
 					fprintf(stderr, "Client %d aborted in state %d: %s",
 						st->id, st->state, PQerrorMessage(st->con));
@@ -805,6 +981,39 @@ top:
 			discard_response(st);
 		}
 
+		/*
+		 * transaction finished: record the time it took in the log and in
+		 * the latencies of the client's workload class
+		 */
+		if ((use_log || st->latency) && commands[st->state + 1] == NULL)
+		{
+			instr_time	now;
+			instr_time	diff;
+			double		usec;
+
+			INSTR_TIME_SET_CURRENT(now);
+			diff = now;
+			INSTR_TIME_SUBTRACT(diff, st->txn_begin);
+			usec = (double) INSTR_TIME_GET_MICROSEC(diff);
+
+			if (st->latency)
+				recordLatency(st->latency, (int64) usec);
+
+			if (use_log)
+			{
+#ifndef WIN32
+				/* This is more than we really ought to know about instr_time */
+				fprintf(LOGFILE, "%d %d %.0f %d %ld %ld\n",
+						st->id, st->cnt, usec, st->use_file,
+						(long) now.tv_sec, (long) now.tv_usec);
+#else
+				/* On Windows, instr_time doesn't provide a timestamp anyway */
+				fprintf(LOGFILE, "%d %d %.0f %d 0 0\n",
+						st->id, st->cnt, usec, st->use_file);
+#endif
+			}
+		}
+
 		if (commands[st->state + 1] == NULL)
 		{
 			if (is_connect)
@@ -823,7 +1032,9 @@ top:
 		if (commands[st->state] == NULL)
 		{
 			st->state = 0;
-			st->use_file = getrand(0, num_files - 1);
+			/* a client of a -G class always runs its class's script */
+			if (num_class_specs == 0)
+				st->use_file = getrand(0, num_files - 1);
 			commands = sql_files[st->use_file];
 		}
 	}
@@ -833,7 +1044,7 @@ top:
 		instr_time	start, end;
 
 		INSTR_TIME_SET_CURRENT(start);
-		if ((st->con = doConnect()) == NULL)
+		if ((st->con = doClientConnect(st)) == NULL)
 		{
 			fprintf(stderr, "Client %d aborted in establishing connection.\n", st->id);
 			return clientDone(st, false);
@@ -842,7 +1053,7 @@ top:
 		INSTR_TIME_ACCUM_DIFF(*conn_time, end, start);
 	}
 
-	if (use_log && st->state == 0)
+	if ((use_log || st->latency) && st->state == 0)
 		INSTR_TIME_SET_CURRENT(st->txn_begin);
 
 	if (commands[st->state]->type == SQL_COMMAND)
@@ -1178,7 +1389,9 @@ init(void)
 		"drop table if exists pgbench_accounts",
 		"create table pgbench_accounts(aid int not null,bid int,abalance int,filler char(84)) with (fillfactor=%d, %s) DISTRIBUTED BY (aid)",
 		"drop table if exists pgbench_history",
-		"create table pgbench_history(tid int,bid int,aid int,delta int,mtime timestamp,filler char(22)) with (%s) DISTRIBUTED BY (tid)"
+		"create table pgbench_history(tid int,bid int,aid int,delta int,mtime timestamp,filler char(22)) with (%s) DISTRIBUTED BY (tid)",
+		"drop table if exists pgbench_ao_history",
+		"create table pgbench_ao_history(tid int,bid int,aid int,delta int,mtime timestamp,filler char(22)) with (appendonly=true) DISTRIBUTED RANDOMLY"
 	};
 	static char *DDLAFTERs[] = {
 		"alter table pgbench_branches add primary key (bid)",
@@ -1313,6 +1526,7 @@ init(void)
 	executeStatement(con, "vacuum analyze pgbench_tellers");
 	executeStatement(con, "vacuum analyze pgbench_accounts");
 	executeStatement(con, "vacuum analyze pgbench_history");
+	executeStatement(con, "analyze pgbench_ao_history");
 
 	fprintf(stderr, "done.\n");
 	PQfinish(con);
@@ -1606,7 +1820,7 @@ process_file(char *filename)
 }
 
 static Command **
-process_builtin(char *tb)
+process_builtin(const char *tb)
 {
 #define COMMANDS_ALLOC_NUM 128
 
@@ -1688,6 +1902,8 @@ printResults(int ttype, int normal_xacts, int nclients, int nthreads,
 		s = "Update only pgbench_accounts";
 	else if (ttype == 1)
 		s = "SELECT only";
+	else if (ttype == 4)
+		s = "Greenplum workload classes";
 	else
 		s = "Custom query";
 
@@ -1712,6 +1928,38 @@ printResults(int ttype, int normal_xacts, int nclients, int nthreads,
 	printf("tps = %f (excluding connections establishing)\n", tps_exclude);
 }
 
+/* print out the latencies of each -G workload class */
+static void
+printClassLatencies(const LatencyHist *latency, instr_time total_time)
+{
+	int			i;
+
+	printf("latency by workload class (ms):\n");
+	printf("%-10s %-12s %7s %9s %9s %9s %9s %9s %9s %9s\n",
+		   "class", "role", "clients", "xacts", "tps",
+		   "avg", "p50", "p90", "p99", "max");
+	for (i = 0; i < num_class_specs; i++)
+	{
+		const LatencyHist *hist = &latency[i];
+		const ClassSpec *spec = &class_specs[i];
+
+		printf("%-10s %-12s %7d %9ld %9.2f",
+			   workload_classes[spec->workload].name,
+			   spec->role ? spec->role : "-", spec->nclients,
+			   (long) hist->count,
+			   hist->count / INSTR_TIME_GET_DOUBLE(total_time));
+		if (hist->count > 0)
+			printf(" %9.3f %9.3f %9.3f %9.3f %9.3f\n",
+				   (double) hist->sum_usec / hist->count / 1000.0,
+				   latencyPercentile(hist, 0.50) / 1000.0,
+				   latencyPercentile(hist, 0.90) / 1000.0,
+				   latencyPercentile(hist, 0.99) / 1000.0,
+				   hist->max_usec / 1000.0);
+		else
+			printf(" %9s %9s %9s %9s %9s\n", "-", "-", "-", "-", "-");
+	}
+}
+
 
 int
 main(int argc, char **argv)
@@ -1723,9 +1971,11 @@ main(int argc, char **argv)
 	int			is_no_vacuum = 0;		/* no vacuum at all before testing? */
 	int			do_vacuum_accounts = 0; /* do vacuum accounts before testing? */
 	int			ttype = 0;		/* transaction type. 0: TPC-B, 1: SELECT only,
-								 * 2: skip update of branches and tellers */
+								 * 2: skip update of branches and tellers,
+								 * 3: custom scripts, 4: -G classes */
 	char	   *filename = NULL;
 	bool		scale_given = false;
+	bool		nclients_given = false;
 
 	CState	   *state;			/* status of clients */
 	TState	   *threads;		/* array of thread */
@@ -1734,6 +1984,7 @@ main(int argc, char **argv)
 	instr_time	total_time;
 	instr_time	conn_total_time;
 	int			total_xacts;
+	LatencyHist total_latency[MAX_CLASS_SPECS];
 
 	int			i;
 
@@ -1786,7 +2037,7 @@ main(int argc, char **argv)
 
 	memset(state, 0, sizeof(*state));
 
-	while ((c = getopt(argc, argv, "ih:nvp:dSNc:Cs:t:T:U:lf:D:F:M:j:x:q")) != -1)
+	while ((c = getopt(argc, argv, "ih:nvp:dSNc:Cs:t:T:U:lf:G:D:F:M:j:x:q")) != -1)
 	{
 		switch (c)
 		{
@@ -1821,6 +2072,7 @@ main(int argc, char **argv)
 				ttype = 2;
 				break;
 			case 'c':
+				nclients_given = true;
 				nclients = atoi(optarg);
 				if (nclients <= 0 || nclients > MAXCLIENTS)
 				{
@@ -1903,6 +2155,46 @@ main(int argc, char **argv)
 				if (process_file(filename) == false || *sql_files[num_files - 1] == NULL)
 					exit(1);
 				break;
+			case 'G':
+				{
+					ClassSpec  *spec;
+					char	   *p;
+					char	   *role;
+
+					if (num_class_specs >= MAX_CLASS_SPECS)
+					{
+						fprintf(stderr, "Up to only %d workload classes are allowed\n", MAX_CLASS_SPECS);
+						exit(1);
+					}
+					if ((p = strchr(optarg, '=')) == NULL)
+					{
+						fprintf(stderr, "invalid workload class: %s\n", optarg);
+						exit(1);
+					}
+					*p++ = '\0';
+					if ((role = strchr(p, ':')) != NULL)
+						*role++ = '\0';
+
+					spec = &class_specs[num_class_specs];
+					for (spec->workload = 0; spec->workload < lengthof(workload_classes); spec->workload++)
+						if (strcmp(optarg, workload_classes[spec->workload].name) == 0)
+							break;
+					if (spec->workload >= lengthof(workload_classes))
+					{
+						fprintf(stderr, "invalid workload class: %s\n", optarg);
+						exit(1);
+					}
+					spec->nclients = atoi(p);
+					if (spec->nclients <= 0)
+					{
+						fprintf(stderr, "invalid number of clients: %s\n", p);
+						exit(1);
+					}
+					spec->role = (role != NULL && *role != '\0') ? role : NULL;
+					num_class_specs++;
+					ttype = 4;
+				}
+				break;
 			case 'D':
 				{
 					char	   *p;
@@ -1969,6 +2261,28 @@ main(int argc, char **argv)
 		exit(0);
 	}
 
+	if (num_class_specs > 0)
+	{
+		if (num_files > 0)
+		{
+			fprintf(stderr, "specify either transaction scripts (-f) or workload classes (-G), not both.\n");
+			exit(1);
+		}
+		if (nclients_given)
+		{
+			fprintf(stderr, "the number of clients (-c) is set by the workload classes (-G).\n");
+			exit(1);
+		}
+		nclients = 0;
+		for (i = 0; i < num_class_specs; i++)
+			nclients += class_specs[i].nclients;
+		if (nclients > MAXCLIENTS)
+		{
+			fprintf(stderr, "invalid number of clients: %d\n", nclients);
+			exit(1);
+		}
+	}
+
 	/* Use DEFAULT_NXACTS if neither nxacts nor duration is specified. */
 	if (nxacts <= 0 && duration <= 0)
 		nxacts = DEFAULT_NXACTS;
@@ -2093,6 +2407,8 @@ main(int argc, char **argv)
 		executeStatement(con, "vacuum pgbench_branches");
 		executeStatement(con, "vacuum pgbench_tellers");
 		executeStatement(con, "truncate pgbench_history");
+		if (ttype == 4)
+			executeStatement(con, "truncate pgbench_ao_history");
 		fprintf(stderr, "end.\n");
 
 		if (do_vacuum_accounts)
@@ -2126,6 +2442,33 @@ main(int argc, char **argv)
 			num_files = 1;
 			break;
 
+		case 4:
+			{
+				int			client = 0;
+
+				/* one script per class, and the clients of each class in turn */
+				for (i = 0; i < num_class_specs; i++)
+				{
+					int			j;
+
+					sql_files[i] = process_builtin(workload_classes[class_specs[i].workload].script);
+					if (sql_files[i] == NULL)
+					{
+						fprintf(stderr, "could not parse workload class %s\n",
+								workload_classes[class_specs[i].workload].name);
+						exit(1);
+					}
+					for (j = 0; j < class_specs[i].nclients; j++)
+					{
+						state[client].use_file = i;
+						state[client].role = class_specs[i].role;
+						client++;
+					}
+				}
+				num_files = num_class_specs;
+			}
+			break;
+
 		default:
 			break;
 	}
@@ -2164,6 +2507,7 @@ main(int argc, char **argv)
 	/* wait for threads and accumulate results */
 	total_xacts = 0;
 	INSTR_TIME_SET_ZERO(conn_total_time);
+	memset(total_latency, 0, sizeof(total_latency));
 	for (i = 0; i < nthreads; i++)
 	{
 		void *ret = NULL;
@@ -2176,8 +2520,23 @@ main(int argc, char **argv)
 		if (ret != NULL)
 		{
 			TResult *r = (TResult *) ret;
+			int		j;
+
 			total_xacts += r->xacts;
 			INSTR_TIME_ADD(conn_total_time, r->conn_time);
+			for (j = 0; j < num_class_specs; j++)
+			{
+				LatencyHist *total = &total_latency[j];
+				LatencyHist *hist = &r->latency[j];
+				int		b;
+
+				total->count += hist->count;
+				total->sum_usec += hist->sum_usec;
+				if (total->max_usec < hist->max_usec)
+					total->max_usec = hist->max_usec;
+				for (b = 0; b < LATENCY_BUCKETS; b++)
+					total->buckets[b] += hist->buckets[b];
+			}
 			free(ret);
 		}
 	}
@@ -2187,6 +2546,8 @@ main(int argc, char **argv)
 	INSTR_TIME_SET_CURRENT(total_time);
 	INSTR_TIME_SUBTRACT(total_time, start_time);
 	printResults(ttype, total_xacts, nclients, nthreads, total_time, conn_total_time);
+	if (num_class_specs > 0)
+		printClassLatencies(total_latency, total_time);
 	if (LOGFILE)
 		fclose(LOGFILE);
 
@@ -2205,14 +2566,22 @@ threadRun(void *arg)
 	int			i;
 
 	result = malloc(sizeof(TResult));
+	memset(result, 0, sizeof(TResult));
 	INSTR_TIME_SET_ZERO(result->conn_time);
 
+	/* clients of -G classes record their latencies in the thread's result */
+	if (num_class_specs > 0)
+	{
+		for (i = 0; i < nstate; i++)
+			state[i].latency = &result->latency[state[i].use_file];
+	}
+
 	if (is_connect == 0)
 	{
 		/* make connections to the database */
 		for (i = 0; i < nstate; i++)
 		{
-			if ((state[i].con = doConnect()) == NULL)
+			if ((state[i].con = doClientConnect(&state[i])) == NULL)
 				goto done;
 		}
 	}
@@ -2228,7 +2597,8 @@ threadRun(void *arg)
 		Command   **commands = sql_files[st->use_file];
 		int			prev_ecnt = st->ecnt;
 
-		st->use_file = getrand(0, num_files - 1);
+		if (num_class_specs == 0)
+			st->use_file = getrand(0, num_files - 1);
 		if (!doCustom(st, &result->conn_time))
 			remains--;		/* I've aborted */
 
@@ -29,7 +29,7 @@ class DecompressReader : public Reader {
     void resizeDecompressReaderBuffer(uint64_t size);
 
    private:
-    void decompress();
+    bool decompress();
 
     uint64_t getDecompressedBytesNum() {
         return S3_ZIP_DECOMPRESS_CHUNKSIZE - this->zstream.avail_out;
@@ -42,6 +42,7 @@ class DecompressReader : public Reader {
     char *in;            // Input buffer for decompression.
     char *out;           // Output buffer for decompression.
     uint64_t outOffset;  // Next position to read in out buffer.
+    bool memberEnded;    // whether a gzip member has ended
 
     bool isClosed;
 };
@@ -8,6 +8,7 @@
 #include "s3interface.h"
 #include "s3log.h"
 #include "s3macros.h"
+#include "s3select_reader.h"
 #include "s3utils.h"
 
 class GPReader : public Reader {
@@ -38,6 +39,7 @@ class GPReader : public Reader {
     S3Params params;
     S3BucketReader bucketReader;
     S3CommonReader commonReader;
+    S3SelectReader selectReader;
     S3RESTfulService restfulService;
 
     S3InterfaceService s3InterfaceService;
@@ -48,7 +50,8 @@ class GPReader : public Reader {
 };
 
 // Following 3 functions are invoked by s3_import(), need to be exception safe
-GPReader *reader_init(const char *url_with_options);
+GPReader *reader_init(const char *url_with_options,
+                      const S3SelectOptions &selectOptions = S3SelectOptions());
 bool reader_transfer_data(GPReader *reader, char *data_buf, int &data_len);
 bool reader_cleanup(GPReader **reader);
 
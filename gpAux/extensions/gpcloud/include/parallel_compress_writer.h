@@ -0,0 +1,71 @@
+#ifndef INCLUDE_PARALLEL_COMPRESS_WRITER_H_
+#define INCLUDE_PARALLEL_COMPRESS_WRITER_H_
+
+#include "s3common_headers.h"
+#include "s3exception.h"
+#include "s3macros.h"
+#include "writer.h"
+
+// 4MB by default
+extern uint64_t S3_ZIP_PARALLEL_BLOCKSIZE;
+
+// A block of data to compress, and the gzip member it compresses into.
+struct CompressBlock {
+    CompressBlock() : done(false) {
+    }
+
+    vector<char> in;
+    vector<char> out;
+    bool done;
+    string error;  // not empty if it failed to compress
+};
+
+// ParallelCompressWriter gzips the data in blocks of S3_ZIP_PARALLEL_BLOCKSIZE on a pool of
+// compression threads, and writes the compressed blocks in order to the next writer. Each block
+// is a gzip member of its own; a gzip file may be made of several members.
+//
+// At most twice as many blocks as there are threads are in flight, so that the threads can go on
+// while the blocks ahead of them are being written.
+class ParallelCompressWriter : public Writer {
+   public:
+    ParallelCompressWriter();
+    virtual ~ParallelCompressWriter();
+
+    virtual void open(const S3Params &params);
+
+    // write() attempts to write up to count bytes from the buffer.
+    // Throw exception if encounters errors.
+    virtual uint64_t write(const char *buf, uint64_t count);
+
+    // This should be reentrant, has no side effects when called multiple times.
+    virtual void close();
+
+    void setWriter(Writer *writer);
+
+   private:
+    static void *CompressThreadFunc(void *p);
+    static void compressBlock(CompressBlock *block);
+
+    void submitBlock();
+    void writeDoneBlocks(uint64_t maxInFlight);
+    void stopThreads();
+
+    Writer *writer;
+
+    CompressBlock *current;  // block being filled by write()
+    bool anyBlock;           // whether any block was submitted since open()
+
+    std::deque<CompressBlock *> inFlight;  // submitted blocks, in write order
+    std::deque<CompressBlock *> pending;   // submitted blocks no thread has taken yet
+
+    vector<pthread_t> threads;
+    pthread_mutex_t mutex;
+    pthread_cond_t workCond;  // a block is pending, or threads should stop
+    pthread_cond_t doneCond;  // a block is compressed
+    bool stopping;
+
+    // add this flag to make close() reentrant
+    bool isClosed;
+};
+
+#endif /* INCLUDE_PARALLEL_COMPRESS_WRITER_H_ */
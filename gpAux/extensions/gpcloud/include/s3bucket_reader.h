@@ -6,6 +6,8 @@
 #include "s3exception.h"
 #include "s3interface.h"
 
+vector<uint64_t> AssignKeysToSegment(const vector<BucketContent> &keys, int segId, int segNum);
+
 // S3BucketReader read multiple files in a bucket.
 class S3BucketReader : public Reader {
    public:
@@ -45,8 +47,9 @@ class S3BucketReader : public Reader {
     // copy valid data into buf and return its size.
     uint64_t readWithoutHeaderLine(char *buf, uint64_t count);
 
-    ListBucketResult keyList;  // List of matched keys/files.
-    uint64_t keyIndex;         // BucketContent index of keylist->contents.
+    ListBucketResult keyList;      // List of matched keys/files.
+    vector<uint64_t> segmentKeys;  // Indexes of keyList.contents this segment reads.
+    uint64_t keyIndex;             // Next index of segmentKeys.
 
     BucketContent &getNextKey();
     S3Params constructReaderParams(BucketContent &key);
@@ -2,6 +2,7 @@
 #define INCLUDE_S3COMMON_WRITER_H_
 
 #include "compress_writer.h"
+#include "parallel_compress_writer.h"
 #include "s3common_headers.h"
 #include "s3key_writer.h"
 #include "s3url.h"
@@ -35,6 +36,7 @@ class S3CommonWriter : public Writer {
     S3Interface* s3InterfaceService;
     S3KeyWriter keyWriter;
     CompressWriter compressWriter;
+    ParallelCompressWriter parallelCompressWriter;
 };
 
 #endif
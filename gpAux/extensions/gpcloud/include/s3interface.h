@@ -67,6 +67,11 @@ class S3MessageParser {
     string code;
 };
 
+// Decode the AWS event stream of an S3 Select response: append the payloads of its Records
+// events to records, and return true if it ends with an End event. An error event, or a
+// malformed message, throws.
+bool DecodeSelectEventStream(const S3VectorUInt8 &stream, S3VectorUInt8 &records);
+
 class S3Interface {
    public:
     virtual ~S3Interface() {
@@ -77,6 +82,9 @@ class S3Interface {
     virtual uint64_t fetchData(uint64_t offset, S3VectorUInt8 &data, uint64_t len,
                                const S3Url &s3Url) = 0;
 
+    virtual uint64_t selectData(uint64_t offset, S3VectorUInt8 &data, uint64_t len, bool gzip,
+                                const S3Url &s3Url) = 0;
+
     virtual S3CompressionType checkCompressionType(const S3Url &s3Url) = 0;
 
     virtual bool checkKeyExistence(const S3Url &s3Url) = 0;
@@ -102,6 +110,9 @@ class S3InterfaceService : public S3Interface {
 
     uint64_t fetchData(uint64_t offset, S3VectorUInt8 &data, uint64_t len, const S3Url &s3Url);
 
+    uint64_t selectData(uint64_t offset, S3VectorUInt8 &data, uint64_t len, bool gzip,
+                        const S3Url &s3Url);
+
     S3CompressionType checkCompressionType(const S3Url &s3Url);
 
     bool checkKeyExistence(const S3Url &s3Url);
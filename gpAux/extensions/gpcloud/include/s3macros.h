@@ -27,6 +27,12 @@ extern uint64_t S3_ZIP_COMPRESS_CHUNKSIZE;
 
 #define S3_ZIP_DEFAULT_CHUNKSIZE (1024 * 1024 * 2)
 
+// block size of parallel compression, each block is compressed into a gzip member of its own
+#define S3_ZIP_PARALLEL_DEFAULT_BLOCKSIZE (1024 * 1024 * 4)
+
+// smallest chunk a key reader splits a key into to download it with more threads
+#define S3_MIN_SPLIT_CHUNKSIZE (1024 * 1024 * 8)
+
 // For deflate, windowBits can be greater than 15 for optional gzip encoding. Add 16 to windowBits
 // to write a simple gzip header and trailer around the compressed data instead of a zlib wrapper.
 #define S3_DEFLATE_WINDOWSBITS (MAX_WBITS + 16)
@@ -7,6 +7,18 @@
 
 enum S3SSEType { SSE_NONE, SSE_S3 };
 
+// What to ask S3 Select for: the SQL expression, and the CSV syntax of the keys, which is also
+// the syntax of the records it returns.
+struct S3SelectOptions {
+    S3SelectOptions() : fieldDelimiter(","), quoteCharacter("\""), quoteEscapeCharacter("\"") {
+    }
+
+    string expression;  // empty if not to use S3 Select
+    string fieldDelimiter;
+    string quoteCharacter;
+    string quoteEscapeCharacter;
+};
+
 class S3Params {
    public:
     S3Params(const string& sourceUrl = "", bool useHttps = true, const string& version = "",
@@ -15,11 +27,13 @@ class S3Params {
           keySize(0),
           chunkSize(0),
           numOfChunks(0),
+          numOfCompressThreads(1),
           lowSpeedLimit(0),
           lowSpeedTime(0),
           debugCurl(false),
           autoCompress(false),
           verifyCert(false),
+          s3Select(false),
           sseType(SSE_NONE) {
     }
 
@@ -62,6 +76,14 @@ class S3Params {
         this->numOfChunks = numOfChunks;
     }
 
+    uint64_t getNumOfCompressThreads() const {
+        return numOfCompressThreads;
+    }
+
+    void setNumOfCompressThreads(uint64_t numOfCompressThreads) {
+        this->numOfCompressThreads = numOfCompressThreads;
+    }
+
     uint64_t getKeySize() const {
         return keySize;
     }
@@ -137,6 +159,22 @@ class S3Params {
         this->proxy = proxy;
     }
 
+    bool isS3Select() const {
+        return s3Select;
+    }
+
+    void setS3Select(bool s3Select) {
+        this->s3Select = s3Select;
+    }
+
+    const S3SelectOptions& getSelectOptions() const {
+        return selectOptions;
+    }
+
+    void setSelectOptions(const S3SelectOptions& selectOptions) {
+        this->selectOptions = selectOptions;
+    }
+
     const string& getGpcheckcloud_newline() const {
         return gpcheckcloud_newline;
     }
@@ -155,6 +193,8 @@ class S3Params {
     uint64_t chunkSize;    // chunk size
     uint64_t numOfChunks;  // number of chunks(threads).
 
+    uint64_t numOfCompressThreads;  // number of threads to compress data before uploading
+
     uint64_t lowSpeedLimit;  // low speed limit
     uint64_t lowSpeedTime;   // low speed timeout
 
@@ -164,6 +204,9 @@ class S3Params {
     bool autoCompress;  // whether to compress data before uploading
     bool verifyCert;  // This option determines whether curl verifies the authenticity of the peer's
                       // certificate.
+    bool s3Select;    // whether to let S3 Select filter and project keys, where possible
+
+    S3SelectOptions selectOptions;
 
     S3SSEType sseType;
 
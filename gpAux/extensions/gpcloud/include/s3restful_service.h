@@ -10,6 +10,30 @@
 #include "s3macros.h"
 #include "s3params.h"
 
+// Idle curl handles, kept with their open connections so that later requests, of any thread and
+// for any key, reuse them instead of connecting again.
+class CURLHandlePool {
+   public:
+    CURLHandlePool() {
+        pthread_mutex_init(&this->poolLock, NULL);
+    }
+    ~CURLHandlePool() {
+        this->clear();
+        pthread_mutex_destroy(&this->poolLock);
+    }
+
+    CURL* acquire();
+    void release(CURL* curl);
+    void clear();
+
+   private:
+    CURLHandlePool(const CURLHandlePool&);
+    CURLHandlePool& operator=(const CURLHandlePool&);
+
+    pthread_mutex_t poolLock;
+    vector<CURL*> idleHandles;
+};
+
 class S3RESTfulService : public RESTfulService {
    public:
     S3RESTfulService();
@@ -39,6 +63,8 @@ class S3RESTfulService : public RESTfulService {
     uint64_t chunkBufferSize;
     S3MemoryContext s3MemContext;
 
+    CURLHandlePool curlPool;
+
     void performCurl(CURL* curl, Response& response);
 };
 
@@ -0,0 +1,52 @@
+#ifndef INCLUDE_S3SELECT_READER_H_
+#define INCLUDE_S3SELECT_READER_H_
+
+#include "reader.h"
+#include "s3common_headers.h"
+#include "s3exception.h"
+#include "s3interface.h"
+
+// S3SelectReader reads the records of a key that S3 Select lets through, one scan range of
+// chunkSize bytes at a time, or all at once for a gzip'ed key.
+class S3SelectReader : public Reader {
+   public:
+    S3SelectReader()
+        : s3Interface(NULL),
+          s3Url(""),
+          keySize(0),
+          chunkSize(0),
+          offset(0),
+          gzip(false),
+          bufferPos(0) {
+    }
+    virtual ~S3SelectReader() {
+        this->close();
+    }
+
+    void open(const S3Params& params);
+
+    // read() attempts to read up to count bytes into the buffer.
+    // Return 0 if EOF. Throw exception if encounters errors.
+    uint64_t read(char* buf, uint64_t count);
+
+    // This should be reentrant, has no side effects when called multiple times.
+    void close();
+
+    void setS3InterfaceService(S3Interface* s3) {
+        this->s3Interface = s3;
+    }
+
+   private:
+    S3Interface* s3Interface;
+    S3Url s3Url;
+
+    uint64_t keySize;
+    uint64_t chunkSize;
+    uint64_t offset;  // start of the next scan range
+    bool gzip;
+
+    S3VectorUInt8 buffer;  // records of the last scan range
+    uint64_t bufferPos;    // next byte of buffer to read
+};
+
+#endif /* INCLUDE_S3SELECT_READER_H_ */
@@ -2,7 +2,7 @@
 
 uint64_t S3_ZIP_DECOMPRESS_CHUNKSIZE = S3_ZIP_DEFAULT_CHUNKSIZE;
 
-DecompressReader::DecompressReader() : isClosed(true) {
+DecompressReader::DecompressReader() : memberEnded(false), isClosed(true) {
     this->reader = NULL;
     this->in = new char[S3_ZIP_DECOMPRESS_CHUNKSIZE];
     this->out = new char[S3_ZIP_DECOMPRESS_CHUNKSIZE];
@@ -42,6 +42,7 @@ void DecompressReader::open(const S3Params &params) {
     zstream.avail_out = S3_ZIP_DECOMPRESS_CHUNKSIZE;
 
     this->outOffset = 0;
+    this->memberEnded = false;
 
     // with S3_INFLATE_WINDOWSBITS, it could recognize and decode both zlib and gzip stream.
     int ret = inflateInit2(&zstream, S3_INFLATE_WINDOWSBITS);
@@ -55,10 +56,15 @@ void DecompressReader::open(const S3Params &params) {
 uint64_t DecompressReader::read(char *buf, uint64_t bufSize) {
     uint64_t remainingOutLen = this->getDecompressedBytesNum() - this->outOffset;
 
-    if (remainingOutLen == 0) {
-        this->decompress();
+    // The end of a gzip member and the header of the next one give no output, go on until there
+    // is some or the data ends.
+    while (remainingOutLen == 0) {
+        bool more = this->decompress();
         this->outOffset = 0;  // reset cursor for out buffer to read from beginning.
         remainingOutLen = this->getDecompressedBytesNum();
+        if (!more) {
+            break;
+        }
     }
 
     uint64_t count = std::min(remainingOutLen, bufSize);
@@ -70,8 +76,9 @@ uint64_t DecompressReader::read(char *buf, uint64_t bufSize) {
 }
 
 // Read compressed data from underlying reader and decompress to this->out buffer.
-// If no more data to consume, this->zstream.avail_out == S3_ZIP_DECOMPRESS_CHUNKSIZE;
-void DecompressReader::decompress() {
+// If no more data to consume, this->zstream.avail_out == S3_ZIP_DECOMPRESS_CHUNKSIZE and it
+// returns false.
+bool DecompressReader::decompress() {
     if (this->zstream.avail_in == 0) {
         this->zstream.avail_out = S3_ZIP_DECOMPRESS_CHUNKSIZE;
         this->zstream.next_out = (Byte *)this->out;
@@ -87,7 +94,7 @@ void DecompressReader::decompress() {
                 "No more data to decompress: avail_in = %u, avail_out = %u, total_in = %u, "
                 "total_out = %u",
                 zstream.avail_in, zstream.avail_out, zstream.total_in, zstream.total_out);
-            return;
+            return false;
         }
 
         // Fill this->in as possible as it could, otherwise data in this->in might not be able to be
@@ -113,13 +120,26 @@ void DecompressReader::decompress() {
 
     int status = inflate(&this->zstream, Z_NO_FLUSH);
     if (status == Z_STREAM_END) {
-        S3DEBUG("Decompression finished: Z_STREAM_END.");
+        // A gzip file may be made of several members, e.g. one per block of a parallel
+        // compression; get ready for the next one.
+        S3DEBUG("Decompression of a member finished: Z_STREAM_END.");
+        inflateReset(&this->zstream);
+        this->memberEnded = true;
+    } else if (status == Z_DATA_ERROR && this->memberEnded && this->zstream.total_out == 0) {
+        // Like gzip, ignore trailing garbage after a member, e.g. zero padding.
+        S3WARN("Ignored %u bytes of trailing garbage after compressed data",
+               this->zstream.avail_in);
+        this->zstream.avail_in = 0;
+        this->zstream.avail_out = S3_ZIP_DECOMPRESS_CHUNKSIZE;
+        return false;
     } else if (status < 0 || status == Z_NEED_DICT) {
         inflateEnd(&this->zstream);
         S3_CHECK_OR_DIE(
             false, S3RuntimeError,
             string("Failed to decompress data: ") + std::to_string((unsigned long long)status));
     }
+
+    return true;
 }
 
 void DecompressReader::close() {
@@ -5,11 +5,14 @@ extern "C" {
 #include "access/xact.h"
 #include "catalog/pg_exttable.h"
 #include "catalog/pg_proc.h"
+#include "catalog/pg_type.h"
 #include "fmgr.h"
 #include "funcapi.h"
+#include "nodes/primnodes.h"
 #include "port.h"  //for pg_strncasecmp
 #include "utils/array.h"
 #include "utils/builtins.h"
+#include "utils/lsyscache.h"
 #include "utils/memutils.h"
 #include "utils/resowner.h"
 
@@ -160,6 +163,165 @@ static void parseFormatOpts(FunctionCallInfo fcinfo) {
     }
 }
 
+/*
+ * Get the delimiter, quote and escape characters of a CSV table from its format options,
+ * "delimiter 'd' null 'n' escape 'e' quote 'q'...", and whether its null string is empty.
+ */
+static bool parseCsvFormatOpts(const char *fmtopts, S3SelectOptions &select, bool &nullIsEmpty) {
+    const char *p = fmtopts;
+
+    if (strncmp(p, "delimiter '", 11) != 0 || p[11] == '\0') return false;
+    select.fieldDelimiter = string(1, p[11]);
+    p += 12;
+
+    if (strncmp(p, "' null '", 8) != 0) return false;
+    p += 8;
+    nullIsEmpty = (strncmp(p, "' escape '", 10) == 0);
+
+    p = strstr(p, "' escape '");
+    if (p == NULL || p[10] == '\0') return false;
+    select.quoteEscapeCharacter = string(1, p[10]);
+    p += 11;
+
+    if (strncmp(p, "' quote '", 9) != 0 || p[9] == '\0' || p[10] != '\'') return false;
+    select.quoteCharacter = string(1, p[9]);
+
+    return true;
+}
+
+/*
+ * Turn a qual into an S3 Select condition, if it compares a column and a constant in a way that
+ * S3 Select can evaluate alike. Return "" otherwise. Columns are strings in S3 Select; integers
+ * and numerics are cast, which needs NULLs to be empty strings.
+ */
+static string selectCondition(Node *qual, const vector<int> &fieldOf, bool nullIsEmpty) {
+    if (!IsA(qual, OpExpr) || list_length(((OpExpr *)qual)->args) != 2) return "";
+
+    OpExpr *op = (OpExpr *)qual;
+    Node *left = (Node *)linitial(op->args);
+    Node *right = (Node *)lsecond(op->args);
+    bool commuted = false;
+
+    if (IsA(left, Const) && IsA(right, Var)) {
+        std::swap(left, right);
+        commuted = true;
+    }
+    if (!IsA(left, Var) || !IsA(right, Const) || ((Const *)right)->constisnull) return "";
+
+    Var *var = (Var *)left;
+    Const *con = (Const *)right;
+    if (var->varattno <= 0 || var->varattno > (int)fieldOf.size()) return "";
+
+    char *opname = get_opname(op->opno);
+    if (opname == NULL) return "";
+    string opstr(opname);
+    if (commuted) {
+        if (opstr == "<")
+            opstr = ">";
+        else if (opstr == ">")
+            opstr = "<";
+        else if (opstr == "<=")
+            opstr = ">=";
+        else if (opstr == ">=")
+            opstr = "<=";
+    }
+    if (opstr != "=" && opstr != "<>" && opstr != "<" && opstr != "<=" && opstr != ">" &&
+        opstr != ">=")
+        return "";
+
+    Oid typoutput;
+    bool typisvarlena;
+    getTypeOutputInfo(con->consttype, &typoutput, &typisvarlena);
+    string value(OidOutputFunctionCall(typoutput, con->constvalue));
+
+    string field = "s._" + std::to_string(fieldOf[var->varattno - 1]);
+
+    switch (var->vartype) {
+        case INT2OID:
+        case INT4OID:
+        case INT8OID:
+        case NUMERICOID:
+            if (!nullIsEmpty || (con->consttype != INT2OID && con->consttype != INT4OID &&
+                                 con->consttype != INT8OID && con->consttype != NUMERICOID))
+                return "";
+            if (value == "NaN") return "";
+            return "CAST(NULLIF(TRIM(" + field + "), '') AS " +
+                   (var->vartype == NUMERICOID ? "DECIMAL" : "INT") + ") " + opstr + " " + value;
+
+        case TEXTOID:
+        case VARCHAROID: {
+            // Only (in)equality: ordering depends on the collation.
+            if ((opstr != "=" && opstr != "<>") ||
+                (con->consttype != TEXTOID && con->consttype != VARCHAROID))
+                return "";
+
+            string literal;
+            for (char c : value) {
+                literal += c;
+                if (c == '\'') literal += c;
+            }
+            return field + " " + opstr + " '" + literal + "'";
+        }
+
+        default:
+            return "";
+    }
+}
+
+/*
+ * Build the S3 Select expression of a scan of a CSV table: the columns that the scan needs,
+ * empty strings for the others, and the records that may pass the quals that S3 Select can
+ * evaluate. The scan checks all quals anyway.
+ *
+ * Return an empty expression if the table isn't CSV or has a header line, or if S3 Select
+ * would send back everything.
+ */
+static S3SelectOptions buildSelectOptions(FunctionCallInfo fcinfo) {
+    S3SelectOptions select;
+    Relation rel = EXTPROTOCOL_GET_RELATION(fcinfo);
+    bool *proj = EXTPROTOCOL_GET_PROJECTION(fcinfo);
+    List *quals = EXTPROTOCOL_GET_QUALS(fcinfo);
+    ExtTableEntry *exttbl = GetExtTableEntry(rel->rd_id);
+    bool nullIsEmpty = false;
+
+    if (!fmttype_is_csv(exttbl->fmtcode) || hasHeader || strcmp(eolString, "\n") != 0 ||
+        !parseCsvFormatOpts(exttbl->fmtopts, select, nullIsEmpty))
+        return S3SelectOptions();
+
+    // The field number of each column in a record; dropped columns have none.
+    TupleDesc tupdesc = RelationGetDescr(rel);
+    vector<int> fieldOf(tupdesc->natts, 0);
+    string columns;
+    bool projected = false;
+    int nfields = 0;
+
+    for (int i = 0; i < tupdesc->natts; i++) {
+        if (tupdesc->attrs[i]->attisdropped) continue;
+
+        fieldOf[i] = ++nfields;
+        if (!columns.empty()) columns += ", ";
+        if (proj == NULL || proj[i]) {
+            columns += "s._" + std::to_string(nfields);
+        } else {
+            columns += "''";
+            projected = true;
+        }
+    }
+
+    string conditions;
+    ListCell *lc;
+    foreach (lc, quals) {
+        string condition = selectCondition((Node *)lfirst(lc), fieldOf, nullIsEmpty);
+        if (condition.empty()) continue;
+        conditions += (conditions.empty() ? " WHERE " : " AND ") + condition;
+    }
+
+    if (!projected && conditions.empty()) return S3SelectOptions();
+
+    select.expression = "SELECT " + columns + " FROM S3Object s" + conditions;
+    return select;
+}
+
 typedef struct gpcloudResHandle {
     GPReader *gpreader;
     GPWriter *gpwriter;
@@ -285,7 +447,7 @@ Datum s3_import(PG_FUNCTION_ARGS) {
 
         thread_setup();
 
-        resHandle->gpreader = reader_init(url_with_options);
+        resHandle->gpreader = reader_init(url_with_options, buildSelectOptions(fcinfo));
         if (!resHandle->gpreader) {
             ereport(ERROR, (0, errmsg("Failed to init gpcloud extension (segid = %d, "
                                       "segnum = %d), please check your "
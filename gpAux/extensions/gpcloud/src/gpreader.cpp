@@ -59,8 +59,14 @@ GPReader::GPReader(const S3Params& params)
 void GPReader::open(const S3Params& params) {
     this->s3InterfaceService.setRESTfulService(this->restfulServicePtr);
     this->bucketReader.setS3InterfaceService(&this->s3InterfaceService);
-    this->bucketReader.setUpstreamReader(&this->commonReader);
     this->commonReader.setS3InterfaceService(&this->s3InterfaceService);
+    this->selectReader.setS3InterfaceService(&this->s3InterfaceService);
+
+    if (this->params.getSelectOptions().expression.empty()) {
+        this->bucketReader.setUpstreamReader(&this->commonReader);
+    } else {
+        this->bucketReader.setUpstreamReader(&this->selectReader);
+    }
     this->bucketReader.open(this->params);
 }
 
@@ -76,7 +82,7 @@ void GPReader::close() {
 }
 
 // invoked by s3_import(), need to be exception safe
-GPReader* reader_init(const char* url_with_options) {
+GPReader* reader_init(const char* url_with_options, const S3SelectOptions& selectOptions) {
     GPReader* reader = NULL;
     s3extErrorMessage.clear();
 
@@ -89,6 +95,12 @@ GPReader* reader_init(const char* url_with_options) {
 
         S3Params params = InitConfig(urlWithOptions);
 
+        // S3 Select is used only if it is configured and the scan can make use of it
+        if (params.isS3Select() && !selectOptions.expression.empty()) {
+            S3INFO("Using S3 Select: %s", selectOptions.expression.c_str());
+            params.setSelectOptions(selectOptions);
+        }
+
         InitRemoteLog();
 
         // Prepare memory to be used for thread chunk buffer.
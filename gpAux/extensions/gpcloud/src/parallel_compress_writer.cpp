@@ -0,0 +1,221 @@
+#include "parallel_compress_writer.h"
+
+uint64_t S3_ZIP_PARALLEL_BLOCKSIZE = S3_ZIP_PARALLEL_DEFAULT_BLOCKSIZE;
+
+ParallelCompressWriter::ParallelCompressWriter()
+    : writer(NULL), current(NULL), anyBlock(false), stopping(false), isClosed(true) {
+    pthread_mutex_init(&this->mutex, NULL);
+    pthread_cond_init(&this->workCond, NULL);
+    pthread_cond_init(&this->doneCond, NULL);
+}
+
+ParallelCompressWriter::~ParallelCompressWriter() {
+    try {
+        this->close();
+    } catch (...) {
+    }
+    this->stopThreads();
+
+    pthread_mutex_destroy(&this->mutex);
+    pthread_cond_destroy(&this->workCond);
+    pthread_cond_destroy(&this->doneCond);
+}
+
+void ParallelCompressWriter::open(const S3Params& params) {
+    S3_CHECK_OR_DIE(params.getNumOfCompressThreads() > 0, S3RuntimeError,
+                    "numOfCompressThreads must not be zero");
+
+    this->current = new CompressBlock();
+    this->current->in.reserve(S3_ZIP_PARALLEL_BLOCKSIZE);
+    this->anyBlock = false;
+    this->stopping = false;
+    this->isClosed = false;
+
+    for (uint64_t i = 0; i < params.getNumOfCompressThreads(); i++) {
+        pthread_t thread;
+        int ret = pthread_create(&thread, NULL, CompressThreadFunc, this);
+        S3_CHECK_OR_DIE(ret == 0, S3RuntimeError, "Failed to create compression thread");
+        this->threads.push_back(thread);
+    }
+
+    this->writer->open(params);
+}
+
+uint64_t ParallelCompressWriter::write(const char* buf, uint64_t count) {
+    // Defensive code
+    if (buf == NULL || count == 0) {
+        return 0;
+    }
+
+    uint64_t offset = 0;
+    while (offset < count) {
+        uint64_t room = S3_ZIP_PARALLEL_BLOCKSIZE - this->current->in.size();
+        uint64_t len = std::min(room, count - offset);
+
+        this->current->in.insert(this->current->in.end(), buf + offset, buf + offset + len);
+        offset += len;
+
+        if (this->current->in.size() == S3_ZIP_PARALLEL_BLOCKSIZE) {
+            this->submitBlock();
+        }
+    }
+
+    return count;
+}
+
+void ParallelCompressWriter::close() {
+    if (this->isClosed) {
+        return;
+    }
+    this->isClosed = true;
+
+    // An empty file still needs a gzip header and trailer.
+    if (!this->current->in.empty() || !this->anyBlock) {
+        this->submitBlock();
+    }
+    this->writeDoneBlocks(0);
+    this->stopThreads();
+
+    S3DEBUG("Parallel compression finished.");
+
+    this->writer->close();
+}
+
+void ParallelCompressWriter::setWriter(Writer* writer) {
+    this->writer = writer;
+}
+
+void* ParallelCompressWriter::CompressThreadFunc(void* p) {
+    MaskThreadSignals();
+
+    ParallelCompressWriter* writer = (ParallelCompressWriter*)p;
+
+    while (true) {
+        CompressBlock* block;
+        {
+            UniqueLock lock(&writer->mutex);
+            while (writer->pending.empty() && !writer->stopping) {
+                pthread_cond_wait(&writer->workCond, &writer->mutex);
+            }
+            if (writer->stopping) {
+                break;
+            }
+            block = writer->pending.front();
+            writer->pending.pop_front();
+        }
+
+        compressBlock(block);
+
+        UniqueLock lock(&writer->mutex);
+        block->done = true;
+        pthread_cond_broadcast(&writer->doneCond);
+    }
+
+    return NULL;
+}
+
+void ParallelCompressWriter::compressBlock(CompressBlock* block) {
+    z_stream zstream;
+    zstream.zalloc = Z_NULL;
+    zstream.zfree = Z_NULL;
+    zstream.opaque = Z_NULL;
+
+    // With S3_DEFLATE_WINDOWSBITS, it generates gzip stream with header and trailer
+    int status = deflateInit2(&zstream, Z_DEFAULT_COMPRESSION, Z_DEFLATED, S3_DEFLATE_WINDOWSBITS,
+                              8, Z_DEFAULT_STRATEGY);
+    if (status != Z_OK) {
+        block->error = "Failed to initialize zlib library: " + std::to_string((long long)status);
+        return;
+    }
+
+    // deflateBound() leaves room for the gzip header and trailer, so one deflate() is enough.
+    block->out.resize(deflateBound(&zstream, block->in.size()));
+
+    zstream.next_in = (Byte*)block->in.data();
+    zstream.avail_in = block->in.size();
+    zstream.next_out = (Byte*)block->out.data();
+    zstream.avail_out = block->out.size();
+
+    status = deflate(&zstream, Z_FINISH);
+    if (status == Z_STREAM_END) {
+        block->out.resize(zstream.total_out);
+    } else {
+        block->error = string("Failed to compress data: ") +
+                       std::to_string((long long)status) + ", " +
+                       (zstream.msg != NULL ? zstream.msg : "");
+    }
+
+    deflateEnd(&zstream);
+
+    // The input is no longer needed, give its memory back early.
+    vector<char>().swap(block->in);
+}
+
+// Hand the current block to the compression threads, after waiting for room for it.
+void ParallelCompressWriter::submitBlock() {
+    this->writeDoneBlocks(this->threads.size() * 2 - 1);
+
+    {
+        UniqueLock lock(&this->mutex);
+        this->inFlight.push_back(this->current);
+        this->pending.push_back(this->current);
+        pthread_cond_signal(&this->workCond);
+    }
+
+    this->anyBlock = true;
+    this->current = new CompressBlock();
+    this->current->in.reserve(S3_ZIP_PARALLEL_BLOCKSIZE);
+}
+
+// Write out the compressed blocks at the head of the queue, until at most maxInFlight blocks are
+// left. The next writer is only called from this thread.
+void ParallelCompressWriter::writeDoneBlocks(uint64_t maxInFlight) {
+    while (true) {
+        CompressBlock* block;
+        {
+            UniqueLock lock(&this->mutex);
+            if (this->inFlight.empty()) {
+                return;
+            }
+
+            block = this->inFlight.front();
+            if (!block->done) {
+                if (this->inFlight.size() <= maxInFlight) {
+                    return;
+                }
+                pthread_cond_wait(&this->doneCond, &this->mutex);
+                continue;
+            }
+            this->inFlight.pop_front();
+        }
+
+        std::unique_ptr<CompressBlock> owner(block);
+        S3_CHECK_OR_DIE(block->error.empty(), S3RuntimeError, block->error);
+
+        this->writer->write(block->out.data(), block->out.size());
+    }
+}
+
+// Stop the compression threads and drop the blocks not written yet.
+void ParallelCompressWriter::stopThreads() {
+    {
+        UniqueLock lock(&this->mutex);
+        this->stopping = true;
+        pthread_cond_broadcast(&this->workCond);
+    }
+
+    for (size_t i = 0; i < this->threads.size(); i++) {
+        pthread_join(this->threads[i], NULL);
+    }
+    this->threads.clear();
+
+    // No thread holds a block any more.
+    for (size_t i = 0; i < this->inFlight.size(); i++) {
+        delete this->inFlight[i];
+    }
+    this->inFlight.clear();
+    this->pending.clear();
+
+    delete this->current;
+    this->current = NULL;
+}
@@ -1,7 +1,7 @@
 #include "s3bucket_reader.h"
 
 S3BucketReader::S3BucketReader() : Reader() {
-    this->keyIndex = 0;  // doesn't matter, be set in open()
+    this->keyIndex = 0;
 
     this->s3Interface = NULL;
     this->upstreamReader = NULL;
@@ -17,7 +17,7 @@ S3BucketReader::~S3BucketReader() {
 void S3BucketReader::open(const S3Params& params) {
     this->params = params;
 
-    this->keyIndex = s3ext_segid;  // we may change it in unit tests
+    this->keyIndex = 0;
 
     S3_CHECK_OR_DIE(this->s3Interface != NULL, S3RuntimeError, "s3Interface is NULL");
 
@@ -27,12 +27,49 @@ void S3BucketReader::open(const S3Params& params) {
                     s3Url.getFullUrlForCurl());
 
     this->keyList = this->s3Interface->listBucket(s3Url);
+    this->segmentKeys = AssignKeysToSegment(this->keyList.contents, s3ext_segid, s3ext_segnum);
+}
+
+// Pick the keys that a segment reads, so that every segment reads about the same number of
+// bytes: taking the keys from the largest, each goes to the segment with the fewest bytes so
+// far, or the lowest numbered one of them. Keys of the same size are thus dealt round-robin.
+// Every segment lists the same keys, so they all come to the same assignment on their own.
+// The keys of a segment are returned in listing order.
+vector<uint64_t> AssignKeysToSegment(const vector<BucketContent>& keys, int segId, int segNum) {
+    vector<uint64_t> bySize(keys.size());
+    for (uint64_t i = 0; i < keys.size(); i++) {
+        bySize[i] = i;
+    }
+    std::stable_sort(bySize.begin(), bySize.end(), [&keys](uint64_t a, uint64_t b) {
+        return keys[a].getSize() > keys[b].getSize();
+    });
+
+    // min-heap of (bytes assigned, segment id)
+    typedef std::pair<uint64_t, int> SegmentLoad;
+    std::priority_queue<SegmentLoad, vector<SegmentLoad>, std::greater<SegmentLoad> > loads;
+    for (int i = 0; i < segNum; i++) {
+        loads.push(SegmentLoad(0, i));
+    }
+
+    vector<uint64_t> assigned;
+    for (uint64_t i : bySize) {
+        SegmentLoad least = loads.top();
+        loads.pop();
+
+        if (least.second == segId) {
+            assigned.push_back(i);
+        }
+
+        least.first += keys[i].getSize();
+        loads.push(least);
+    }
+
+    std::sort(assigned.begin(), assigned.end());
+    return assigned;
 }
 
 BucketContent& S3BucketReader::getNextKey() {
-    BucketContent& key = this->keyList.contents[this->keyIndex];
-    this->keyIndex += s3ext_segnum;
-    return key;
+    return this->keyList.contents[this->segmentKeys[this->keyIndex++]];
 }
 
 S3Params S3BucketReader::constructReaderParams(BucketContent& key) {
@@ -98,7 +135,7 @@ uint64_t S3BucketReader::read(char* buf, uint64_t count) {
     uint64_t readCount = 0;
     while (true) {
         if (this->needNewReader) {
-            if (this->keyIndex >= this->keyList.contents.size()) {
+            if (this->keyIndex >= this->segmentKeys.size()) {
                 S3DEBUG("Read finished for segment: %d", s3ext_segid);
                 return 0;
             }
@@ -137,4 +174,6 @@ void S3BucketReader::close() {
     if (!this->keyList.contents.empty()) {
         this->keyList.contents.clear();
     }
+
+    this->segmentKeys.clear();
 }
\ No newline at end of file
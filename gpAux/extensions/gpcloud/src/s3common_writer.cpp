@@ -3,7 +3,10 @@
 void S3CommonWriter::open(const S3Params& params) {
     this->keyWriter.setS3InterfaceService(this->s3InterfaceService);
 
-    if (params.isAutoCompress()) {
+    if (params.isAutoCompress() && params.getNumOfCompressThreads() > 1) {
+        this->upstreamWriter = &this->parallelCompressWriter;
+        this->parallelCompressWriter.setWriter(&this->keyWriter);
+    } else if (params.isAutoCompress()) {
         this->upstreamWriter = &this->compressWriter;
         this->compressWriter.setWriter(&this->keyWriter);
     } else {
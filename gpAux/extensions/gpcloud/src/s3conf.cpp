@@ -85,6 +85,8 @@ S3Params InitConfig(const string& urlWithOptions) {
 
     params.setDebugCurl(s3Cfg.GetBool(configSection, "debug_curl", "false"));
 
+    params.setS3Select(s3Cfg.GetBool(configSection, "s3_select", "false"));
+
     params.setCred(s3Cfg.Get(configSection, "accessid", ""), s3Cfg.Get(configSection, "secret", ""),
                    s3Cfg.Get(configSection, "token", ""));
 
@@ -95,6 +97,9 @@ S3Params InitConfig(const string& urlWithOptions) {
     int64_t numOfChunks = s3Cfg.SafeScan("threadnum", configSection, 4, 1, 8);
     params.setNumOfChunks(numOfChunks);
 
+    int64_t numOfCompressThreads = s3Cfg.SafeScan("compress_threadnum", configSection, 1, 1, 8);
+    params.setNumOfCompressThreads(numOfCompressThreads);
+
     int64_t chunkSize = s3Cfg.SafeScan("chunksize", configSection, 64 * 1024 * 1024,
                                        8 * 1024 * 1024, 128 * 1024 * 1024);
     params.setChunkSize(chunkSize);
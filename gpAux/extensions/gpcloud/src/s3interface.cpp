@@ -337,6 +337,157 @@ uint64_t S3InterfaceService::fetchData(uint64_t offset, S3VectorUInt8 &data, uin
     }
 }
 
+static string XMLEscape(const string &src) {
+    string dst;
+    for (char c : src) {
+        switch (c) {
+            case '&':
+                dst += "&amp;";
+                break;
+            case '<':
+                dst += "&lt;";
+                break;
+            case '>':
+                dst += "&gt;";
+                break;
+            case '"':
+                dst += "&quot;";
+                break;
+            case '\'':
+                dst += "&apos;";
+                break;
+            default:
+                dst += c;
+        }
+    }
+    return dst;
+}
+
+// Run the S3 Select expression of params on the records of a key that start in
+// [offset, offset + len), or on all of them if the key is gzip'ed; scan ranges only work on
+// uncompressed keys. The matching records go to data, in the CSV syntax of the key.
+uint64_t S3InterfaceService::selectData(uint64_t offset, S3VectorUInt8 &data, uint64_t len,
+                                        bool gzip, const S3Url &s3Url) {
+    const S3SelectOptions &select = this->params.getSelectOptions();
+    HTTPHeaders headers;
+    stringstream body;
+
+    S3_CHECK_OR_DIE(!select.expression.empty(), S3RuntimeError, "no S3 Select expression");
+
+    string csv = "<FieldDelimiter>" + XMLEscape(select.fieldDelimiter) +
+                 "</FieldDelimiter><QuoteCharacter>" + XMLEscape(select.quoteCharacter) +
+                 "</QuoteCharacter><QuoteEscapeCharacter>" +
+                 XMLEscape(select.quoteEscapeCharacter) +
+                 "</QuoteEscapeCharacter><RecordDelimiter>&#10;</RecordDelimiter>";
+
+    body << "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+         << "<SelectObjectContentRequest xmlns=\"http://s3.amazonaws.com/doc/2006-03-01/\">"
+         << "<Expression>" << XMLEscape(select.expression) << "</Expression>"
+         << "<ExpressionType>SQL</ExpressionType>"
+         << "<InputSerialization><CompressionType>" << (gzip ? "GZIP" : "NONE")
+         << "</CompressionType><CSV><FileHeaderInfo>NONE</FileHeaderInfo>" << csv
+         << "</CSV></InputSerialization>"
+         << "<OutputSerialization><CSV><QuoteFields>ASNEEDED</QuoteFields>" << csv
+         << "</CSV></OutputSerialization>";
+    if (!gzip) {
+        body << "<ScanRange><Start>" << offset << "</Start><End>" << offset + len - 1
+             << "</End></ScanRange>";
+    }
+    body << "</SelectObjectContentRequest>";
+
+    string bodyString = body.str();
+
+    headers.Add(HOST, s3Url.getHostForCurl());
+    headers.Add(CONTENTTYPE, "application/xml");
+
+    char contentSha256[SHA256_DIGEST_STRING_LENGTH];  // 65
+    sha256_hex(bodyString.c_str(), contentSha256);
+    headers.Add(X_AMZ_CONTENT_SHA256, contentSha256);
+
+    headers.Add(CONTENTLENGTH, std::to_string((unsigned long long)bodyString.length()));
+
+    SignRequestV4("POST", &headers, s3Url.getRegion(), s3Url.getPathForCurl(),
+                  "select=&select-type=2", this->params.getCred());
+
+    Response resp =
+        this->postResponseWithRetries(s3Url.getFullUrlForCurl() + "?select&select-type=2",
+                                      headers, vector<uint8_t>(bodyString.begin(), bodyString.end()));
+    if (resp.getStatus() == RESPONSE_OK) {
+        data.clear();
+        S3_CHECK_OR_DIE(DecodeSelectEventStream(resp.getRawData(), data), S3RuntimeError,
+                        "S3 Select response of " + s3Url.getFullUrlForCurl() + " ends early");
+        return data.size();
+    } else if (resp.getStatus() == RESPONSE_ERROR) {
+        S3MessageParser s3msg(resp);
+        S3_DIE(S3LogicError, s3msg.getCode(), s3msg.getMessage());
+    } else {
+        S3_DIE(S3RuntimeError, "unexpected response status");
+    }
+}
+
+static uint32_t GetUInt32BE(const uint8_t *p) {
+    return ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) | ((uint32_t)p[2] << 8) | p[3];
+}
+
+// Each message of the stream is:
+//   total length (4 bytes), headers length (4 bytes), CRC32 of the 8 bytes before (4 bytes),
+//   headers, payload, CRC32 of everything before (4 bytes)
+// all big-endian. A header is a 1-byte name length, the name, a 1-byte value type, and for
+// strings (type 7, the only one S3 Select sends) a 2-byte value length and the value.
+bool DecodeSelectEventStream(const S3VectorUInt8 &stream, S3VectorUInt8 &records) {
+    const uint8_t *p = stream.data();
+    uint64_t left = stream.size();
+
+    while (left > 0) {
+        S3_CHECK_OR_DIE(left >= 16, S3RuntimeError, "truncated S3 Select event");
+
+        uint32_t totalLen = GetUInt32BE(p);
+        uint32_t headersLen = GetUInt32BE(p + 4);
+        S3_CHECK_OR_DIE(totalLen >= 16 && totalLen <= left && headersLen <= totalLen - 16,
+                        S3RuntimeError, "malformed S3 Select event");
+        S3_CHECK_OR_DIE(crc32(0L, p, 8) == GetUInt32BE(p + 8) &&
+                            crc32(0L, p, totalLen - 4) == GetUInt32BE(p + totalLen - 4),
+                        S3RuntimeError, "S3 Select event fails its checksum");
+
+        map<string, string> eventHeaders;
+        const uint8_t *h = p + 12;
+        const uint8_t *hend = h + headersLen;
+        while (h < hend) {
+            uint8_t nameLen = h[0];
+            S3_CHECK_OR_DIE(h + 1 + nameLen + 3 <= hend && h[1 + nameLen] == 7, S3RuntimeError,
+                            "malformed S3 Select event header");
+            string name((const char *)h + 1, nameLen);
+            h += 1 + nameLen + 1;
+
+            uint16_t valueLen = (h[0] << 8) | h[1];
+            S3_CHECK_OR_DIE(h + 2 + valueLen <= hend, S3RuntimeError,
+                            "malformed S3 Select event header");
+            eventHeaders[name] = string((const char *)h + 2, valueLen);
+            h += 2 + valueLen;
+        }
+
+        const uint8_t *payload = hend;
+        uint64_t payloadLen = totalLen - headersLen - 16;
+
+        if (eventHeaders[":message-type"] == "error") {
+            S3_DIE(S3LogicError, eventHeaders[":error-code"], eventHeaders[":error-message"]);
+        }
+
+        const string &eventType = eventHeaders[":event-type"];
+        if (eventType == "Records") {
+            records.insert(records.end(), payload, payload + payloadLen);
+        } else if (eventType == "End") {
+            return true;
+        }
+        // Stats, Progress and Cont(inuation) events carry nothing we need.
+
+        p += totalLen;
+        left -= totalLen;
+    }
+
+    return false;
+}
+
 S3CompressionType S3InterfaceService::checkCompressionType(const S3Url &s3Url) {
     HTTPHeaders headers;
 
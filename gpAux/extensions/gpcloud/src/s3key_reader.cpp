@@ -189,12 +189,27 @@ void S3KeyReader::open(const S3Params& params) {
     this->numOfChunks = params.getNumOfChunks();
     S3_CHECK_OR_DIE(this->numOfChunks > 0, S3RuntimeError, "numOfChunks must not be zero");
 
-    this->offsetMgr.setKeySize(params.getKeySize());
-    this->offsetMgr.setChunkSize(params.getChunkSize());
-
     S3_CHECK_OR_DIE(params.getChunkSize() > 0, S3RuntimeError,
                     "chunk size must be greater than zero");
 
+    uint64_t keySize = params.getKeySize();
+    uint64_t chunkSize = params.getChunkSize();
+
+    // A key smaller than all the chunks together is split into smaller chunks, so that every
+    // thread downloads part of it, but not below S3_MIN_SPLIT_CHUNKSIZE where the cost of a
+    // request outweighs the parallelism. Chunks can't grow, their memory is preallocated.
+    if (keySize < chunkSize * this->numOfChunks) {
+        uint64_t splitSize = (keySize + this->numOfChunks - 1) / this->numOfChunks;
+        chunkSize = std::min(chunkSize, std::max(splitSize, (uint64_t)S3_MIN_SPLIT_CHUNKSIZE));
+    }
+
+    // No more threads than chunks
+    uint64_t chunksOfKey = std::max((keySize + chunkSize - 1) / chunkSize, (uint64_t)1);
+    this->numOfChunks = std::min(this->numOfChunks, chunksOfKey);
+
+    this->offsetMgr.setKeySize(keySize);
+    this->offsetMgr.setChunkSize(chunkSize);
+
     this->chunkBuffers.reserve(this->numOfChunks);
 
     for (uint64_t i = 0; i < this->numOfChunks; i++) {
@@ -33,11 +33,46 @@ S3RESTfulService::S3RESTfulService(const S3Params &params)
 }
 
 S3RESTfulService::~S3RESTfulService() {
+    // The handles must go before curl_global_cleanup().
+    this->curlPool.clear();
+
     // This function is not thread safe, must NOT call it when any other
     // threads are running, that is, do NOT put it in threads.
     curl_global_cleanup();
 }
 
+CURL *CURLHandlePool::acquire() {
+    UniqueLock lock(&this->poolLock);
+    if (this->idleHandles.empty()) {
+        return curl_easy_init();
+    }
+
+    CURL *curl = this->idleHandles.back();
+    this->idleHandles.pop_back();
+    return curl;
+}
+
+// Reset the options of a handle and keep it for the next request. curl_easy_reset() keeps
+// the live connections, the DNS cache and the TLS session IDs of the handle.
+void CURLHandlePool::release(CURL *curl) {
+    if (curl == NULL) {
+        return;
+    }
+
+    curl_easy_reset(curl);
+
+    UniqueLock lock(&this->poolLock);
+    this->idleHandles.push_back(curl);
+}
+
+void CURLHandlePool::clear() {
+    UniqueLock lock(&this->poolLock);
+    for (size_t i = 0; i < this->idleHandles.size(); i++) {
+        curl_easy_cleanup(this->idleHandles[i]);
+    }
+    this->idleHandles.clear();
+}
+
 // curl's write function callback.
 static size_t RESTfulServiceWriteFuncCallback(char *ptr, size_t size, size_t nmemb, void *userp) {
     if (S3QueryIsAbortInProgress()) {
@@ -95,11 +130,11 @@ static size_t RESTfulServiceReadFuncCallback(char *ptr, size_t size, size_t nmem
 }
 
 struct CURLWrapper {
-    CURLWrapper(const string &url, curl_slist *headers, uint64_t lowSpeedLimit,
-                uint64_t lowSpeedTime, bool debugCurl, string proxy) {
-        curl = curl_easy_init();
+    CURLWrapper(CURLHandlePool &pool, const string &url, curl_slist *headers,
+                uint64_t lowSpeedLimit, uint64_t lowSpeedTime, bool debugCurl, string proxy)
+        : pool(pool) {
+        curl = pool.acquire();
         curl_easy_setopt(curl, CURLOPT_URL, url.c_str());
-        curl_easy_setopt(curl, CURLOPT_FORBID_REUSE, 1L);
         curl_easy_setopt(curl, CURLOPT_NOSIGNAL, 1L);
         curl_easy_setopt(curl, CURLOPT_HTTPHEADER, headers);
         curl_easy_setopt(curl, CURLOPT_LOW_SPEED_LIMIT, lowSpeedLimit);
@@ -114,8 +149,9 @@ struct CURLWrapper {
         }
     }
     ~CURLWrapper() {
-        curl_easy_cleanup(curl);
+        pool.release(curl);
     }
+    CURLHandlePool &pool;
     CURL *curl;
 };
 
@@ -152,8 +188,8 @@ Response S3RESTfulService::get(const string &url, HTTPHeaders &headers) {
     response.getRawData().reserve(this->chunkBufferSize);
 
     headers.CreateList();
-    CURLWrapper wrapper(url, headers.GetList(), this->lowSpeedLimit, this->lowSpeedTime,
-                        this->debugCurl, this->proxy);
+    CURLWrapper wrapper(this->curlPool, url, headers.GetList(), this->lowSpeedLimit,
+                        this->lowSpeedTime, this->debugCurl, this->proxy);
     CURL *curl = wrapper.curl;
 
     curl_easy_setopt(curl, CURLOPT_WRITEDATA, (void *)&response);
@@ -169,8 +205,8 @@ Response S3RESTfulService::put(const string &url, HTTPHeaders &headers, const S3
     Response response(RESPONSE_ERROR);
 
     headers.CreateList();
-    CURLWrapper wrapper(url, headers.GetList(), this->lowSpeedLimit, this->lowSpeedTime,
-                        this->debugCurl, this->proxy);
+    CURLWrapper wrapper(this->curlPool, url, headers.GetList(), this->lowSpeedLimit,
+                        this->lowSpeedTime, this->debugCurl, this->proxy);
     CURL *curl = wrapper.curl;
 
     curl_easy_setopt(curl, CURLOPT_WRITEDATA, (void *)&response);
@@ -196,8 +232,8 @@ Response S3RESTfulService::post(const string &url, HTTPHeaders &headers,
     Response response(RESPONSE_ERROR);
 
     headers.CreateList();
-    CURLWrapper wrapper(url, headers.GetList(), this->lowSpeedLimit, this->lowSpeedTime,
-                        this->debugCurl, this->proxy);
+    CURLWrapper wrapper(this->curlPool, url, headers.GetList(), this->lowSpeedLimit,
+                        this->lowSpeedTime, this->debugCurl, this->proxy);
     CURL *curl = wrapper.curl;
 
     curl_easy_setopt(curl, CURLOPT_WRITEDATA, (void *)&response);
@@ -225,8 +261,8 @@ ResponseCode S3RESTfulService::head(const string &url, HTTPHeaders &headers) {
     Response response(RESPONSE_ERROR);
 
     headers.CreateList();
-    CURLWrapper wrapper(url, headers.GetList(), this->lowSpeedLimit, this->lowSpeedTime,
-                        this->debugCurl, this->proxy);
+    CURLWrapper wrapper(this->curlPool, url, headers.GetList(), this->lowSpeedLimit,
+                        this->lowSpeedTime, this->debugCurl, this->proxy);
     CURL *curl = wrapper.curl;
 
     curl_easy_setopt(curl, CURLOPT_CUSTOMREQUEST, "HEAD");
@@ -242,8 +278,8 @@ Response S3RESTfulService::deleteRequest(const string &url, HTTPHeaders &headers
     Response response(RESPONSE_ERROR);
 
     headers.CreateList();
-    CURLWrapper wrapper(url, headers.GetList(), this->lowSpeedLimit, this->lowSpeedTime,
-                        this->debugCurl, this->proxy);
+    CURLWrapper wrapper(this->curlPool, url, headers.GetList(), this->lowSpeedLimit,
+                        this->lowSpeedTime, this->debugCurl, this->proxy);
     CURL *curl = wrapper.curl;
 
     curl_easy_setopt(curl, CURLOPT_WRITEDATA, (void *)&response);
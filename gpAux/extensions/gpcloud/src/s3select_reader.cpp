@@ -0,0 +1,47 @@
+#include "s3select_reader.h"
+
+void S3SelectReader::open(const S3Params& params) {
+    S3_CHECK_OR_DIE(this->s3Interface != NULL, S3RuntimeError, "s3Interface must not be NULL");
+    S3_CHECK_OR_DIE(params.getChunkSize() > 0, S3RuntimeError,
+                    "chunk size must be greater than zero");
+
+    this->s3Url = params.getS3Url();
+    this->keySize = params.getKeySize();
+    this->chunkSize = params.getChunkSize();
+    this->offset = 0;
+    this->bufferPos = 0;
+    this->buffer.release();
+
+    this->gzip = (this->keySize > 0 && this->s3Interface->checkCompressionType(this->s3Url) ==
+                                           S3_COMPRESSION_GZIP);
+}
+
+uint64_t S3SelectReader::read(char* buf, uint64_t count) {
+    // A scan range may have no matching records, move on until there are some.
+    while (this->bufferPos == this->buffer.size()) {
+        if (this->offset >= this->keySize) {
+            return 0;
+        }
+
+        uint64_t len = this->gzip ? this->keySize
+                                  : std::min(this->chunkSize, this->keySize - this->offset);
+
+        this->s3Interface->selectData(this->offset, this->buffer, len, this->gzip, this->s3Url);
+        S3DEBUG("Got %" PRIu64 " bytes of records from S3 Select", (uint64_t)this->buffer.size());
+
+        this->offset += len;
+        this->bufferPos = 0;
+    }
+
+    uint64_t readLen = std::min(count, this->buffer.size() - this->bufferPos);
+    memcpy(buf, this->buffer.data() + this->bufferPos, readLen);
+    this->bufferPos += readLen;
+
+    return readLen;
+}
+
+void S3SelectReader::close() {
+    this->buffer.release();
+    this->bufferPos = 0;
+    this->offset = this->keySize;
+}
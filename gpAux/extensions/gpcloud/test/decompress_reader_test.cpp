@@ -311,3 +311,60 @@ TEST_F(DecompressReaderTest, AbleToDecompressWithIncorrectEncodedStream) {
 
     EXPECT_THROW(decompressReader.read(outputBuffer, sizeof(outputBuffer)), S3RuntimeError);
 }
+
+// Append the gzip member of input to output.
+static void appendGzipMember(vector<uint8_t> &output, const char *input, uint64_t len) {
+    z_stream zstream;
+    zstream.zalloc = Z_NULL;
+    zstream.zfree = Z_NULL;
+    zstream.opaque = Z_NULL;
+    ASSERT_EQ(Z_OK, deflateInit2(&zstream, Z_DEFAULT_COMPRESSION, Z_DEFLATED,
+                                 S3_DEFLATE_WINDOWSBITS, 8, Z_DEFAULT_STRATEGY));
+
+    vector<uint8_t> member(deflateBound(&zstream, len));
+    zstream.next_in = (Byte *)input;
+    zstream.avail_in = len;
+    zstream.next_out = member.data();
+    zstream.avail_out = member.size();
+    ASSERT_EQ(Z_STREAM_END, deflate(&zstream, Z_FINISH));
+
+    output.insert(output.end(), member.begin(), member.begin() + zstream.total_out);
+    deflateEnd(&zstream);
+}
+
+TEST_F(DecompressReaderTest, AbleToDecompressConcatenatedMembers) {
+    S3_ZIP_DECOMPRESS_CHUNKSIZE = 8;
+    decompressReader.resizeDecompressReaderBuffer(S3_ZIP_DECOMPRESS_CHUNKSIZE);
+
+    const char first[] = "abcdefghigklm";
+    const char second[] = "nopqrstuvwxyz";
+
+    vector<uint8_t> data;
+    appendGzipMember(data, first, strlen(first));
+    appendGzipMember(data, "", 0);
+    appendGzipMember(data, second, strlen(second));
+    this->bufReader.setData(data.data(), data.size());
+
+    char outputBuffer[5];
+    string result;
+    uint64_t count;
+    while ((count = decompressReader.read(outputBuffer, sizeof(outputBuffer))) > 0) {
+        result.append(outputBuffer, count);
+    }
+
+    EXPECT_EQ("abcdefghigklmnopqrstuvwxyz", result);
+}
+
+TEST_F(DecompressReaderTest, AbleToIgnoreTrailingGarbage) {
+    const char hello[] = "The quick brown fox jumps over the lazy dog";
+
+    vector<uint8_t> data;
+    appendGzipMember(data, hello, sizeof(hello));
+    data.resize(data.size() + 100, 0);
+    this->bufReader.setData(data.data(), data.size());
+
+    char outputBuffer[10000];
+    EXPECT_EQ(sizeof(hello), decompressReader.read(outputBuffer, sizeof(outputBuffer)));
+    EXPECT_STREQ(hello, outputBuffer);
+    EXPECT_EQ((uint64_t)0, decompressReader.read(outputBuffer, sizeof(outputBuffer)));
+}
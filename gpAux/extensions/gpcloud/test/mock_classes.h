@@ -15,6 +15,9 @@ class MockS3Interface : public S3Interface {
     MOCK_METHOD4(fetchData,
                  uint64_t(uint64_t , S3VectorUInt8& , uint64_t len, const S3Url &));
 
+    MOCK_METHOD5(selectData,
+                 uint64_t(uint64_t, S3VectorUInt8&, uint64_t len, bool gzip, const S3Url &));
+
     MOCK_METHOD1(checkCompressionType, S3CompressionType(const S3Url&));
 
     MOCK_METHOD1(checkKeyExistence, bool(const S3Url&));
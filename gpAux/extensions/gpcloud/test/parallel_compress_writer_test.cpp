@@ -0,0 +1,164 @@
+#include "parallel_compress_writer.cpp"
+#include <random>
+#include "gtest/gtest.h"
+
+class MockBlockWriter : public Writer {
+   public:
+    MockBlockWriter() : writes(0), closed(false) {
+    }
+    virtual ~MockBlockWriter() {
+    }
+
+    virtual void open(const S3Params &params) {
+    }
+
+    virtual uint64_t write(const char *buf, uint64_t count) {
+        this->data.insert(this->data.end(), buf, buf + count);
+        this->writes++;
+        return count;
+    }
+
+    virtual void close() {
+        this->closed = true;
+    }
+
+    vector<char> data;
+    uint64_t writes;
+    bool closed;
+};
+
+class ParallelCompressWriterTest : public testing::Test {
+   protected:
+    // Remember that SetUp() is run immediately before a test starts.
+    virtual void SetUp() {
+        S3_ZIP_PARALLEL_BLOCKSIZE = 1024;
+
+        params.setNumOfCompressThreads(4);
+        compressWriter.setWriter(&writer);
+    }
+
+    // TearDown() is invoked immediately after a test finishes.
+    virtual void TearDown() {
+        compressWriter.close();
+
+        S3_ZIP_PARALLEL_BLOCKSIZE = S3_ZIP_PARALLEL_DEFAULT_BLOCKSIZE;
+    }
+
+    // Decompress all gzip members of the written data.
+    string uncompress() {
+        z_stream zstream;
+        zstream.zalloc = Z_NULL;
+        zstream.zfree = Z_NULL;
+        zstream.opaque = Z_NULL;
+        zstream.next_in = (Byte *)writer.data.data();
+        zstream.avail_in = writer.data.size();
+
+        int ret = inflateInit2(&zstream, S3_INFLATE_WINDOWSBITS);
+        S3_CHECK_OR_DIE(ret == Z_OK, S3RuntimeError, "failed to initialize zlib library");
+
+        string result;
+        char out[4096];
+        while (zstream.avail_in > 0) {
+            zstream.next_out = (Byte *)out;
+            zstream.avail_out = sizeof(out);
+
+            ret = inflate(&zstream, Z_NO_FLUSH);
+            result.append(out, sizeof(out) - zstream.avail_out);
+
+            if (ret == Z_STREAM_END) {
+                this->members++;
+                inflateReset(&zstream);
+            } else if (ret != Z_OK) {
+                break;
+            }
+        }
+
+        inflateEnd(&zstream);
+        return result;
+    }
+
+    S3Params params;
+    ParallelCompressWriter compressWriter;
+    MockBlockWriter writer;
+    uint64_t members = 0;
+};
+
+TEST_F(ParallelCompressWriterTest, OpenWithZeroThreads) {
+    params.setNumOfCompressThreads(0);
+    EXPECT_THROW(compressWriter.open(params), S3RuntimeError);
+}
+
+TEST_F(ParallelCompressWriterTest, AbleToInputNull) {
+    compressWriter.open(params);
+    EXPECT_EQ((uint64_t)0, compressWriter.write(NULL, 0));
+    EXPECT_EQ((uint64_t)0, writer.data.size());
+}
+
+TEST_F(ParallelCompressWriterTest, AbleToCompressEmptyData) {
+    compressWriter.open(params);
+    compressWriter.close();
+
+    ASSERT_LE((uint64_t)2, writer.data.size());
+    EXPECT_EQ(char(0x1f), writer.data[0]);
+    EXPECT_EQ(char(0x8b), writer.data[1]);
+    EXPECT_EQ("", this->uncompress());
+    EXPECT_EQ((uint64_t)1, this->members);
+    EXPECT_TRUE(writer.closed);
+}
+
+TEST_F(ParallelCompressWriterTest, AbleToCompressOneSmallString) {
+    const char hello[] = "The quick brown fox jumps over the lazy dog";
+
+    compressWriter.open(params);
+    compressWriter.write(hello, sizeof(hello) - 1);
+    compressWriter.close();
+
+    EXPECT_EQ(string(hello), this->uncompress());
+    EXPECT_EQ((uint64_t)1, this->members);
+}
+
+TEST_F(ParallelCompressWriterTest, CloseMultipleTimes) {
+    const char hello[] = "The quick brown fox jumps over the lazy dog";
+
+    compressWriter.open(params);
+    compressWriter.write(hello, sizeof(hello) - 1);
+    compressWriter.close();
+    compressWriter.close();
+
+    EXPECT_EQ(string(hello), this->uncompress());
+    EXPECT_EQ((uint64_t)1, this->members);
+}
+
+TEST_F(ParallelCompressWriterTest, AbleToCompressBlocksInOrder) {
+    std::mt19937 generator(42);
+    string input(S3_ZIP_PARALLEL_BLOCKSIZE * 50 + 10, 0);
+    for (size_t i = 0; i < input.size(); i++) {
+        input[i] = 'a' + generator() % 4;
+    }
+
+    compressWriter.open(params);
+
+    // Write in pieces that don't line up with blocks.
+    for (size_t offset = 0; offset < input.size(); offset += 700) {
+        uint64_t len = std::min((size_t)700, input.size() - offset);
+        EXPECT_EQ(len, compressWriter.write(input.data() + offset, len));
+    }
+    compressWriter.close();
+
+    EXPECT_EQ(input, this->uncompress());
+    EXPECT_EQ((uint64_t)51, this->members);
+    EXPECT_EQ((uint64_t)51, writer.writes);
+}
+
+TEST_F(ParallelCompressWriterTest, AbleToCompressWithOneThread) {
+    params.setNumOfCompressThreads(1);
+
+    string input(S3_ZIP_PARALLEL_BLOCKSIZE * 3, 'x');
+
+    compressWriter.open(params);
+    compressWriter.write(input.data(), input.size());
+    compressWriter.close();
+
+    EXPECT_EQ(input, this->uncompress());
+    EXPECT_EQ((uint64_t)3, this->members);
+}
@@ -285,3 +285,35 @@ TEST_F(S3BucketReaderTest, ReadBucketFileWithHeaderAndFuzyMatch) {
     eolString[0] = '\n';
     eolString[1] = '\0';
 }
+
+TEST(AssignKeysToSegment, KeysOfSameSizeAreDealtRoundRobin) {
+    vector<BucketContent> keys;
+    for (int i = 0; i < 7; i++) {
+        keys.emplace_back("key" + std::to_string(i), 100);
+    }
+
+    EXPECT_EQ(vector<uint64_t>({0, 3, 6}), AssignKeysToSegment(keys, 0, 3));
+    EXPECT_EQ(vector<uint64_t>({1, 4}), AssignKeysToSegment(keys, 1, 3));
+    EXPECT_EQ(vector<uint64_t>({2, 5}), AssignKeysToSegment(keys, 2, 3));
+}
+
+TEST(AssignKeysToSegment, BalanceBytesAcrossSegments) {
+    vector<BucketContent> keys;
+    keys.emplace_back("small1", 10);
+    keys.emplace_back("big", 100);
+    keys.emplace_back("small2", 10);
+    keys.emplace_back("medium", 50);
+    keys.emplace_back("small3", 30);
+
+    // big alone on segment 0; medium, small3 and the small ones on segment 1
+    EXPECT_EQ(vector<uint64_t>({1}), AssignKeysToSegment(keys, 0, 2));
+    EXPECT_EQ(vector<uint64_t>({0, 2, 3, 4}), AssignKeysToSegment(keys, 1, 2));
+}
+
+TEST(AssignKeysToSegment, MoreSegmentsThanKeys) {
+    vector<BucketContent> keys;
+    keys.emplace_back("foo", 456);
+
+    EXPECT_EQ(vector<uint64_t>({0}), AssignKeysToSegment(keys, 0, 16));
+    EXPECT_TRUE(AssignKeysToSegment(keys, 10, 16).empty());
+}
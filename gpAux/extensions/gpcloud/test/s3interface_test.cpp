@@ -746,3 +746,139 @@ TEST_F(S3InterfaceServiceTest, abortUploadErrorResponse) {
                      S3Url("https://s3-us-west-2.amazonaws.com/s3test.pivotal.io/whatever"), "xyz"),
                  S3LogicError);
 }
+
+static void PutUInt32BE(vector<uint8_t> &v, uint32_t n) {
+    v.push_back(n >> 24);
+    v.push_back(n >> 16);
+    v.push_back(n >> 8);
+    v.push_back(n);
+}
+
+// Append an event stream message with string headers to stream.
+static void AppendSelectEvent(vector<uint8_t> &stream, const map<string, string> &eventHeaders,
+                              const string &payload) {
+    vector<uint8_t> headers;
+    for (auto &h : eventHeaders) {
+        headers.push_back(h.first.size());
+        headers.insert(headers.end(), h.first.begin(), h.first.end());
+        headers.push_back(7);
+        headers.push_back(h.second.size() >> 8);
+        headers.push_back(h.second.size());
+        headers.insert(headers.end(), h.second.begin(), h.second.end());
+    }
+
+    vector<uint8_t> msg;
+    PutUInt32BE(msg, 16 + headers.size() + payload.size());
+    PutUInt32BE(msg, headers.size());
+    PutUInt32BE(msg, crc32(0L, msg.data(), 8));
+    msg.insert(msg.end(), headers.begin(), headers.end());
+    msg.insert(msg.end(), payload.begin(), payload.end());
+    PutUInt32BE(msg, crc32(0L, msg.data(), msg.size()));
+
+    stream.insert(stream.end(), msg.begin(), msg.end());
+}
+
+static void AppendSelectEvent(vector<uint8_t> &stream, const string &eventType,
+                              const string &payload = "") {
+    map<string, string> eventHeaders;
+    eventHeaders[":message-type"] = "event";
+    eventHeaders[":event-type"] = eventType;
+    AppendSelectEvent(stream, eventHeaders, payload);
+}
+
+TEST(DecodeSelectEventStream, RecordsUntilEnd) {
+    vector<uint8_t> stream;
+    AppendSelectEvent(stream, "Records", "1,a\n");
+    AppendSelectEvent(stream, "Cont");
+    AppendSelectEvent(stream, "Records", "2,b\n");
+    AppendSelectEvent(stream, "Stats", "<Stats></Stats>");
+    AppendSelectEvent(stream, "End");
+
+    S3VectorUInt8 records;
+    EXPECT_TRUE(DecodeSelectEventStream(S3VectorUInt8(stream), records));
+    EXPECT_EQ("1,a\n2,b\n", string(records.begin(), records.end()));
+}
+
+TEST(DecodeSelectEventStream, NoEndEvent) {
+    vector<uint8_t> stream;
+    AppendSelectEvent(stream, "Records", "1,a\n");
+
+    S3VectorUInt8 records;
+    EXPECT_FALSE(DecodeSelectEventStream(S3VectorUInt8(stream), records));
+}
+
+TEST(DecodeSelectEventStream, ErrorEvent) {
+    vector<uint8_t> stream;
+    map<string, string> eventHeaders;
+    eventHeaders[":message-type"] = "error";
+    eventHeaders[":error-code"] = "InternalError";
+    eventHeaders[":error-message"] = "oops";
+    AppendSelectEvent(stream, eventHeaders, "");
+
+    S3VectorUInt8 records;
+    EXPECT_THROW(DecodeSelectEventStream(S3VectorUInt8(stream), records), S3LogicError);
+}
+
+TEST(DecodeSelectEventStream, BadChecksum) {
+    vector<uint8_t> stream;
+    AppendSelectEvent(stream, "Records", "1,a\n");
+    stream[stream.size() - 5] ^= 1;
+
+    S3VectorUInt8 records;
+    EXPECT_THROW(DecodeSelectEventStream(S3VectorUInt8(stream), records), S3RuntimeError);
+}
+
+TEST(DecodeSelectEventStream, TruncatedEvent) {
+    vector<uint8_t> stream;
+    AppendSelectEvent(stream, "Records", "1,a\n");
+    stream.resize(stream.size() - 1);
+
+    S3VectorUInt8 records;
+    EXPECT_THROW(DecodeSelectEventStream(S3VectorUInt8(stream), records), S3RuntimeError);
+}
+
+TEST_F(S3InterfaceServiceTest, selectDataRoutine) {
+    S3SelectOptions select;
+    select.expression = "SELECT s._1 FROM S3Object s";
+    this->params.setSelectOptions(select);
+    S3InterfaceService service(this->params);
+    service.setRESTfulService(&mockRESTfulService);
+
+    vector<uint8_t> stream;
+    AppendSelectEvent(stream, "Records", "1\n2\n");
+    AppendSelectEvent(stream, "End");
+    Response response(RESPONSE_OK, stream);
+
+    EXPECT_CALL(mockRESTfulService, post(_, _, _)).WillOnce(Return(response));
+
+    S3VectorUInt8 data;
+    EXPECT_EQ(4, service.selectData(
+                     0, data, 128, false,
+                     S3Url("https://s3-us-west-2.amazonaws.com/s3test.pivotal.io/whatever")));
+    EXPECT_EQ("1\n2\n", string(data.begin(), data.end()));
+}
+
+TEST_F(S3InterfaceServiceTest, selectDataErrorResponse) {
+    S3SelectOptions select;
+    select.expression = "SELECT s._1 FROM S3Object s";
+    this->params.setSelectOptions(select);
+    S3InterfaceService service(this->params);
+    service.setRESTfulService(&mockRESTfulService);
+
+    uint8_t xml[] =
+        "<?xml version=\"1.0\" encoding=\"UTF-8\"?>"
+        "<Error>"
+        "<Code>InvalidTextEncoding</Code>"
+        "<Message>UTF-8 encoding is required.</Message>"
+        "</Error>";
+    vector<uint8_t> raw(xml, xml + sizeof(xml) - 1);
+    Response response(RESPONSE_ERROR, raw);
+
+    EXPECT_CALL(mockRESTfulService, post(_, _, _)).WillRepeatedly(Return(response));
+
+    S3VectorUInt8 data;
+    EXPECT_THROW(service.selectData(
+                     0, data, 128, false,
+                     S3Url("https://s3-us-west-2.amazonaws.com/s3test.pivotal.io/whatever")),
+                 S3LogicError);
+}
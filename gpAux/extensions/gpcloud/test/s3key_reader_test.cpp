@@ -504,6 +504,35 @@ TEST_F(S3KeyReaderTest, MTReadWith2Chunks) {
     EXPECT_EQ((uint64_t)0, this->read(buffer, 32));
 }
 
+TEST_F(S3KeyReaderTest, MTOpenSplitsSmallKeyIntoSmallerChunks) {
+    S3Params params("s3://abc/def");
+
+    params.setNumOfChunks(4);
+
+    params.setKeySize(S3_MIN_SPLIT_CHUNKSIZE * 2 + 100);
+    params.setChunkSize(S3_MIN_SPLIT_CHUNKSIZE * 8);
+
+    EXPECT_CALL(s3Interface, fetchData(0, _, S3_MIN_SPLIT_CHUNKSIZE, _))
+        .WillOnce(Invoke(MockFetchData(S3_MIN_SPLIT_CHUNKSIZE, S3_MIN_SPLIT_CHUNKSIZE)));
+    EXPECT_CALL(s3Interface, fetchData(S3_MIN_SPLIT_CHUNKSIZE, _, S3_MIN_SPLIT_CHUNKSIZE, _))
+        .WillOnce(Invoke(MockFetchData(S3_MIN_SPLIT_CHUNKSIZE, S3_MIN_SPLIT_CHUNKSIZE)));
+    EXPECT_CALL(s3Interface, fetchData(S3_MIN_SPLIT_CHUNKSIZE * 2, _, 100, _))
+        .WillOnce(Invoke(MockFetchData(100, 100)));
+
+    this->open(params);
+
+    EXPECT_EQ((uint64_t)S3_MIN_SPLIT_CHUNKSIZE, this->getOffsetMgr().getChunkSize());
+    EXPECT_EQ((uint64_t)3, this->getThreads().size());
+    EXPECT_EQ((uint64_t)3, this->getChunkBuffers().size());
+
+    // Read it all so that every chunk gets fetched; the key ends with an added EOL.
+    uint64_t total = 0, len;
+    while ((len = this->read(buffer, sizeof(buffer))) > 0) {
+        total += len;
+    }
+    EXPECT_EQ((uint64_t)S3_MIN_SPLIT_CHUNKSIZE * 2 + 101, total);
+}
+
 TEST_F(S3KeyReaderTest, MTReadWithRedundantChunks) {
     S3Params params("s3://abc/def");
 
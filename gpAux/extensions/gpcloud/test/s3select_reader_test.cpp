@@ -0,0 +1,127 @@
+#include "s3select_reader.cpp"
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "mock_classes.h"
+
+using ::testing::Invoke;
+using ::testing::Return;
+using ::testing::Throw;
+using ::testing::_;
+
+// Return the records "<offset>,<len>\n" for a scan range.
+static uint64_t selectRange(uint64_t offset, S3VectorUInt8& data, uint64_t len, bool gzip,
+                            const S3Url& s3Url) {
+    string records = std::to_string(offset) + "," + std::to_string(len) + "\n";
+    data.clear();
+    data.insert(data.end(), records.begin(), records.end());
+    return records.size();
+}
+
+static uint64_t selectNothing(uint64_t offset, S3VectorUInt8& data, uint64_t len, bool gzip,
+                              const S3Url& s3Url) {
+    data.clear();
+    return 0;
+}
+
+// ================== S3SelectReaderTest ===================
+
+class S3SelectReaderTest : public testing::Test, public S3SelectReader {
+   protected:
+    // Remember that SetUp() is run immediately before a test starts.
+    virtual void SetUp() {
+        memset(buffer, 0, sizeof(buffer));
+
+        this->setS3InterfaceService(&s3Interface);
+    }
+
+    // TearDown() is invoked immediately after a test finishes.
+    virtual void TearDown() {
+        this->close();
+    }
+
+    string readAll() {
+        string result;
+        uint64_t len;
+        while ((len = this->read(buffer, sizeof(buffer))) > 0) {
+            result.append(buffer, len);
+        }
+        return result;
+    }
+
+    char buffer[4];
+
+    MockS3Interface s3Interface;
+};
+
+TEST_F(S3SelectReaderTest, OpenWithoutInterface) {
+    S3SelectReader reader;
+    S3Params params("https://s3-us-west-2.amazonaws.com/s3test.pivotal.io/whatever");
+    params.setChunkSize(1000);
+
+    EXPECT_THROW(reader.open(params), S3RuntimeError);
+}
+
+TEST_F(S3SelectReaderTest, ReadsScanRangesOfChunkSize) {
+    S3Params params("https://s3-us-west-2.amazonaws.com/s3test.pivotal.io/whatever");
+    params.setKeySize(2500);
+    params.setChunkSize(1000);
+
+    EXPECT_CALL(s3Interface, checkCompressionType(_)).WillOnce(Return(S3_COMPRESSION_PLAIN));
+    EXPECT_CALL(s3Interface, selectData(0, _, 1000, false, _)).WillOnce(Invoke(selectRange));
+    EXPECT_CALL(s3Interface, selectData(1000, _, 1000, false, _)).WillOnce(Invoke(selectRange));
+    EXPECT_CALL(s3Interface, selectData(2000, _, 500, false, _)).WillOnce(Invoke(selectRange));
+
+    this->open(params);
+    EXPECT_EQ("0,1000\n1000,1000\n2000,500\n", this->readAll());
+}
+
+TEST_F(S3SelectReaderTest, ReadsGzipKeyWhole) {
+    S3Params params("https://s3-us-west-2.amazonaws.com/s3test.pivotal.io/whatever");
+    params.setKeySize(2500);
+    params.setChunkSize(1000);
+
+    EXPECT_CALL(s3Interface, checkCompressionType(_)).WillOnce(Return(S3_COMPRESSION_GZIP));
+    EXPECT_CALL(s3Interface, selectData(0, _, 2500, true, _)).WillOnce(Invoke(selectRange));
+
+    this->open(params);
+    EXPECT_EQ("0,2500\n", this->readAll());
+}
+
+TEST_F(S3SelectReaderTest, SkipsScanRangesWithoutRecords) {
+    S3Params params("https://s3-us-west-2.amazonaws.com/s3test.pivotal.io/whatever");
+    params.setKeySize(3000);
+    params.setChunkSize(1000);
+
+    EXPECT_CALL(s3Interface, checkCompressionType(_)).WillOnce(Return(S3_COMPRESSION_PLAIN));
+    EXPECT_CALL(s3Interface, selectData(0, _, 1000, false, _)).WillOnce(Invoke(selectNothing));
+    EXPECT_CALL(s3Interface, selectData(1000, _, 1000, false, _)).WillOnce(Invoke(selectNothing));
+    EXPECT_CALL(s3Interface, selectData(2000, _, 1000, false, _)).WillOnce(Invoke(selectRange));
+
+    this->open(params);
+    EXPECT_EQ("2000,1000\n", this->readAll());
+}
+
+TEST_F(S3SelectReaderTest, ZeroSizedKey) {
+    S3Params params("https://s3-us-west-2.amazonaws.com/s3test.pivotal.io/whatever");
+    params.setKeySize(0);
+    params.setChunkSize(1000);
+
+    EXPECT_CALL(s3Interface, checkCompressionType(_)).Times(0);
+    EXPECT_CALL(s3Interface, selectData(_, _, _, _, _)).Times(0);
+
+    this->open(params);
+    EXPECT_EQ((uint64_t)0, this->read(buffer, sizeof(buffer)));
+}
+
+TEST_F(S3SelectReaderTest, SelectError) {
+    S3Params params("https://s3-us-west-2.amazonaws.com/s3test.pivotal.io/whatever");
+    params.setKeySize(1000);
+    params.setChunkSize(1000);
+
+    EXPECT_CALL(s3Interface, checkCompressionType(_)).WillOnce(Return(S3_COMPRESSION_PLAIN));
+    EXPECT_CALL(s3Interface, selectData(_, _, _, _, _))
+        .WillOnce(Throw(S3LogicError("InvalidQuery", "bad expression")));
+
+    this->open(params);
+    EXPECT_THROW(this->read(buffer, sizeof(buffer)), S3LogicError);
+}
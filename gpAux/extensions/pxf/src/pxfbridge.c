@@ -132,6 +132,8 @@ add_querydata_to_http_headers(gphadoop_context *context)
 	inputData.headers = context->churl_headers;
 	inputData.gphduri = context->gphd_uri;
 	inputData.rel = context->relation;
+	inputData.proj = context->proj;
+	inputData.quals = context->quals;
 	build_http_headers(&inputData);
 }
 
@@ -40,6 +40,8 @@ typedef struct
 	ListCell   *current_fragment;
 	StringInfoData write_file_name;
 	Relation	relation;
+	bool	   *proj;			/* attributes the scan needs, NULL for all */
+	List	   *quals;			/* quals of the scan */
 } gphadoop_context;
 
 /*
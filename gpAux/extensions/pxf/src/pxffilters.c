@@ -0,0 +1,302 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "pxffilters.h"
+
+#include "fmgr.h"
+#include "lib/stringinfo.h"
+#include "nodes/primnodes.h"
+#include "utils/lsyscache.h"
+
+/* helper function declarations */
+static bool pxf_serialize_opexpr(OpExpr *expr, StringInfo buf);
+static bool pxf_serialize_operand(Node *node, StringInfo buf, bool *is_var);
+static bool pxf_get_operator(Oid dbop, PxfOperatorCode *pxfop);
+
+/*
+ * The operators PXF evaluates alike, by OID in pg_operator.  Text and
+ * boolean only have (in)equality, since their ordering in PXF follows
+ * neither the database collation nor the boolean order.
+ */
+typedef struct dbop_pxfop_map
+{
+	Oid			dbop;
+	PxfOperatorCode pxfop;
+} dbop_pxfop_map;
+
+static const dbop_pxfop_map pxf_supported_opr[] =
+{
+	/* int2 */
+	{94 /* int2eq */ , PXFOP_EQ},
+	{95 /* int2lt */ , PXFOP_LT},
+	{520 /* int2gt */ , PXFOP_GT},
+	{522 /* int2le */ , PXFOP_LE},
+	{524 /* int2ge */ , PXFOP_GE},
+	{519 /* int2ne */ , PXFOP_NE},
+
+	/* int4 */
+	{96 /* int4eq */ , PXFOP_EQ},
+	{97 /* int4lt */ , PXFOP_LT},
+	{521 /* int4gt */ , PXFOP_GT},
+	{523 /* int4le */ , PXFOP_LE},
+	{525 /* int4ge */ , PXFOP_GE},
+	{518 /* int4ne */ , PXFOP_NE},
+
+	/* int8 */
+	{410 /* int8eq */ , PXFOP_EQ},
+	{412 /* int8lt */ , PXFOP_LT},
+	{413 /* int8gt */ , PXFOP_GT},
+	{414 /* int8le */ , PXFOP_LE},
+	{415 /* int8ge */ , PXFOP_GE},
+	{411 /* int8ne */ , PXFOP_NE},
+
+	/* int2 and int4 */
+	{532 /* int24eq */ , PXFOP_EQ},
+	{534 /* int24lt */ , PXFOP_LT},
+	{536 /* int24gt */ , PXFOP_GT},
+	{540 /* int24le */ , PXFOP_LE},
+	{542 /* int24ge */ , PXFOP_GE},
+	{538 /* int24ne */ , PXFOP_NE},
+	{533 /* int42eq */ , PXFOP_EQ},
+	{535 /* int42lt */ , PXFOP_LT},
+	{537 /* int42gt */ , PXFOP_GT},
+	{541 /* int42le */ , PXFOP_LE},
+	{543 /* int42ge */ , PXFOP_GE},
+	{539 /* int42ne */ , PXFOP_NE},
+
+	/* int4 and int8 */
+	{15 /* int48eq */ , PXFOP_EQ},
+	{37 /* int48lt */ , PXFOP_LT},
+	{76 /* int48gt */ , PXFOP_GT},
+	{80 /* int48le */ , PXFOP_LE},
+	{82 /* int48ge */ , PXFOP_GE},
+	{36 /* int48ne */ , PXFOP_NE},
+	{416 /* int84eq */ , PXFOP_EQ},
+	{418 /* int84lt */ , PXFOP_LT},
+	{419 /* int84gt */ , PXFOP_GT},
+	{420 /* int84le */ , PXFOP_LE},
+	{430 /* int84ge */ , PXFOP_GE},
+	{417 /* int84ne */ , PXFOP_NE},
+
+	/* int2 and int8 */
+	{1862 /* int28eq */ , PXFOP_EQ},
+	{1864 /* int28lt */ , PXFOP_LT},
+	{1865 /* int28gt */ , PXFOP_GT},
+	{1866 /* int28le */ , PXFOP_LE},
+	{1867 /* int28ge */ , PXFOP_GE},
+	{1863 /* int28ne */ , PXFOP_NE},
+	{1868 /* int82eq */ , PXFOP_EQ},
+	{1870 /* int82lt */ , PXFOP_LT},
+	{1871 /* int82gt */ , PXFOP_GT},
+	{1872 /* int82le */ , PXFOP_LE},
+	{1873 /* int82ge */ , PXFOP_GE},
+	{1869 /* int82ne */ , PXFOP_NE},
+
+	/* float4 */
+	{620 /* float4eq */ , PXFOP_EQ},
+	{622 /* float4lt */ , PXFOP_LT},
+	{623 /* float4gt */ , PXFOP_GT},
+	{624 /* float4le */ , PXFOP_LE},
+	{625 /* float4ge */ , PXFOP_GE},
+	{621 /* float4ne */ , PXFOP_NE},
+
+	/* float8 */
+	{670 /* float8eq */ , PXFOP_EQ},
+	{672 /* float8lt */ , PXFOP_LT},
+	{674 /* float8gt */ , PXFOP_GT},
+	{673 /* float8le */ , PXFOP_LE},
+	{675 /* float8ge */ , PXFOP_GE},
+	{671 /* float8ne */ , PXFOP_NE},
+
+	/* float4 and float8 */
+	{1120 /* float48eq */ , PXFOP_EQ},
+	{1122 /* float48lt */ , PXFOP_LT},
+	{1123 /* float48gt */ , PXFOP_GT},
+	{1124 /* float48le */ , PXFOP_LE},
+	{1125 /* float48ge */ , PXFOP_GE},
+	{1121 /* float48ne */ , PXFOP_NE},
+	{1130 /* float84eq */ , PXFOP_EQ},
+	{1132 /* float84lt */ , PXFOP_LT},
+	{1133 /* float84gt */ , PXFOP_GT},
+	{1134 /* float84le */ , PXFOP_LE},
+	{1135 /* float84ge */ , PXFOP_GE},
+	{1131 /* float84ne */ , PXFOP_NE},
+
+	/* numeric */
+	{1752 /* numeric_eq */ , PXFOP_EQ},
+	{1754 /* numeric_lt */ , PXFOP_LT},
+	{1756 /* numeric_gt */ , PXFOP_GT},
+	{1755 /* numeric_le */ , PXFOP_LE},
+	{1757 /* numeric_ge */ , PXFOP_GE},
+	{1753 /* numeric_ne */ , PXFOP_NE},
+
+	/* date */
+	{1093 /* date_eq */ , PXFOP_EQ},
+	{1095 /* date_lt */ , PXFOP_LT},
+	{1097 /* date_gt */ , PXFOP_GT},
+	{1096 /* date_le */ , PXFOP_LE},
+	{1098 /* date_ge */ , PXFOP_GE},
+	{1094 /* date_ne */ , PXFOP_NE},
+
+	/* text, and varchar through its relabeling to text */
+	{98 /* texteq */ , PXFOP_EQ},
+	{531 /* textne */ , PXFOP_NE},
+
+	/* bool */
+	{91 /* booleq */ , PXFOP_EQ},
+	{85 /* boolne */ , PXFOP_NE}
+};
+
+/*
+ * Serializes the quals that PXF can evaluate, see pxffilters.h.
+ * Unsupported quals are left out; with the scan evaluating all quals
+ * anyway, PXF filtering on part of them still returns a superset of the
+ * rows.
+ */
+char *
+serializePxfFilterQuals(List *quals)
+{
+	StringInfoData buf;
+	ListCell   *lc;
+	int			nfilters = 0;
+
+	initStringInfo(&buf);
+
+	foreach(lc, quals)
+	{
+		Node	   *qual = (Node *) lfirst(lc);
+
+		if (qual == NULL || !IsA(qual, OpExpr))
+			continue;
+
+		if (!pxf_serialize_opexpr((OpExpr *) qual, &buf))
+			continue;
+
+		/* AND it with the filters before it */
+		if (++nfilters > 1)
+			appendStringInfo(&buf, "l%d", PXFLOP_AND);
+	}
+
+	if (nfilters == 0)
+	{
+		pfree(buf.data);
+		return NULL;
+	}
+
+	elog(DEBUG2, "pxf: filter string: %s", buf.data);
+
+	return buf.data;
+}
+
+/*
+ * Appends "<operand><operand>o<opcode>" for a comparison of an attribute and
+ * a constant, in either order.  Appends nothing and returns false for any
+ * other expression.
+ */
+static bool
+pxf_serialize_opexpr(OpExpr *expr, StringInfo buf)
+{
+	StringInfoData filter;
+	PxfOperatorCode pxfop;
+	bool		left_is_var;
+	bool		right_is_var;
+	bool		ok;
+
+	if (list_length(expr->args) != 2 || !pxf_get_operator(expr->opno, &pxfop))
+		return false;
+
+	initStringInfo(&filter);
+
+	ok = pxf_serialize_operand((Node *) linitial(expr->args), &filter, &left_is_var) &&
+		pxf_serialize_operand((Node *) lsecond(expr->args), &filter, &right_is_var) &&
+		left_is_var != right_is_var;
+
+	if (ok)
+		appendStringInfo(buf, "%so%d", filter.data, pxfop);
+
+	pfree(filter.data);
+	return ok;
+}
+
+/*
+ * Appends an attribute or a non-null constant
+ */
+static bool
+pxf_serialize_operand(Node *node, StringInfo buf, bool *is_var)
+{
+	/* e.g. varchar columns compared as text */
+	while (node != NULL && IsA(node, RelabelType))
+		node = (Node *) ((RelabelType *) node)->arg;
+
+	if (node == NULL)
+		return false;
+
+	if (IsA(node, Var))
+	{
+		Var		   *var = (Var *) node;
+
+		if (var->varattno <= 0 || var->varlevelsup != 0)
+			return false;
+
+		appendStringInfo(buf, "a%d", var->varattno - 1);
+		*is_var = true;
+		return true;
+	}
+
+	if (IsA(node, Const))
+	{
+		Const	   *con = (Const *) node;
+		Oid			typoutput;
+		bool		typisvarlena;
+		char	   *value;
+
+		if (con->constisnull)
+			return false;
+
+		getTypeOutputInfo(con->consttype, &typoutput, &typisvarlena);
+		value = OidOutputFunctionCall(typoutput, con->constvalue);
+
+		appendStringInfo(buf, "c%us%dd%s", con->consttype, (int) strlen(value), value);
+		pfree(value);
+		*is_var = false;
+		return true;
+	}
+
+	return false;
+}
+
+/*
+ * Maps a database operator to the PXF operator that evaluates it alike
+ */
+static bool
+pxf_get_operator(Oid dbop, PxfOperatorCode *pxfop)
+{
+	int			i;
+
+	for (i = 0; i < lengthof(pxf_supported_opr); i++)
+	{
+		if (pxf_supported_opr[i].dbop == dbop)
+		{
+			*pxfop = pxf_supported_opr[i].pxfop;
+			return true;
+		}
+	}
+
+	return false;
+}
@@ -0,0 +1,58 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#ifndef _PXFFILTERS_H_
+#define _PXFFILTERS_H_
+
+#include "postgres.h"
+#include "nodes/pg_list.h"
+
+/*
+ * Serializes the quals of a scan that PXF can evaluate into a filter string
+ * for the X-GP-FILTER header, in postfix notation:
+ *
+ *   a<attnum>                   attribute, 0-based
+ *   c<typeoid>s<len>d<data>     constant of <len> bytes in text form
+ *   o<opcode>                   comparison of the two operands before it
+ *   l<opcode>                   logical operation of the operands before it
+ *
+ * e.g. "a1c23s2d10o2" for "b > 10".
+ */
+typedef enum PxfOperatorCode
+{
+	PXFOP_LT = 1,
+	PXFOP_GT,
+	PXFOP_LE,
+	PXFOP_GE,
+	PXFOP_EQ,
+	PXFOP_NE
+} PxfOperatorCode;
+
+typedef enum PxfLogicalOperatorCode
+{
+	PXFLOP_AND = 0
+} PxfLogicalOperatorCode;
+
+/*
+ * Returns the filter string of the quals that can be pushed down, ANDed
+ * together, or NULL if there are none.  The scan still evaluates all quals.
+ */
+extern char *serializePxfFilterQuals(List *quals);
+
+#endif							/* _PXFFILTERS_H_ */
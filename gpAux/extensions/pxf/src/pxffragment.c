@@ -7,12 +7,14 @@
 #include "cdb/cdbvars.h"
 #include "commands/copy.h"
 #include "lib/stringinfo.h"
+#include "utils/int8.h"
 #include "utils/jsonapi.h"
 
 static List *get_data_fragment_list(GPHDUri *hadoop_uri, ClientContext *client_context);
 static void rest_request(GPHDUri *hadoop_uri, ClientContext *client_context, char *rest_msg);
 static List *parse_get_fragments_response(List *fragments, StringInfo rest_buf);
 static List *filter_fragments_for_segment(List *list);
+static List *filter_fragments_by_size(List *list, int4 shift);
 static void init(GPHDUri *uri, ClientContext *cl_context);
 static void print_fragment_list(List *fragments);
 static void init_client_context(ClientContext *client_context);
@@ -165,6 +167,7 @@ typedef enum pxf_fragment_object
 {
 	PXF_PARSE_START,
 	PXF_PARSE_INDEX,
+	PXF_PARSE_SIZE,
 	PXF_PARSE_USERDATA,
 	PXF_PARSE_PROFILE,
 	PXF_PARSE_SOURCENAME,
@@ -190,6 +193,8 @@ pxf_fragment_object_start(void *state, char *name, bool isnull)
 	{
 		if (pg_strcasecmp(name, "index") == 0)
 			s->object = PXF_PARSE_INDEX;
+		else if (pg_strcasecmp(name, "fragmentSize") == 0)
+			s->object = PXF_PARSE_SIZE;
 	}
 	else if (s->lex->token_type == JSON_TOKEN_STRING || s->lex->token_type == JSON_TOKEN_NULL)
 	{
@@ -268,6 +273,13 @@ pxf_fragment_scalar(void *state, char *token, JsonTokenType type)
 		case PXF_PARSE_INDEX:
 			check_and_assign(&(d->index), type, token, JSON_TOKEN_NUMBER, true);
 			break;
+		case PXF_PARSE_SIZE:
+			if (type != JSON_TOKEN_NUMBER)
+				ereport(ERROR,
+						(errcode(ERRCODE_SYNTAX_ERROR),
+						 errmsg("unexpected value \"%s\" for attribute", token)));
+			(void) scanint8(token, false, &d->size);
+			break;
 		case PXF_PARSE_REPLICAS:
 			if (type == JSON_TOKEN_STRING)
 				s->has_replicas = true;
@@ -299,6 +311,7 @@ pxf_array_element_start(void *state, bool isnull)
 	 * array, allocate a new fragment on the list to populate during parsing.
 	 */
 	data = palloc0(sizeof(FragmentData));
+	data->size = -1;
 	s->fragments = lappend(s->fragments, data);
 	s->has_replicas = false;
 	s->object = PXF_PARSE_START;
@@ -371,6 +384,9 @@ filter_fragments_for_segment(List *list)
 	 * elements across N segments global transaction ID is used as a
 	 * randomizer, as it is different for every query while being the same
 	 * across all segments for a given query
+	 *
+	 * When the Fragmenter reports the fragment sizes, balance the bytes
+	 * instead, see filter_fragments_by_size.
 	 */
 
 	List	   *result = list;
@@ -380,6 +396,14 @@ filter_fragments_for_segment(List *list)
 	int			index = 0;
 	int4		shift = xid % GpIdentity.numsegments;
 
+	foreach(current, list)
+	{
+		FragmentData *fragment = (FragmentData *) lfirst(current);
+
+		if (fragment && fragment->size >= 0)
+			return filter_fragments_by_size(list, shift);
+	}
+
 	for (current = list_head(list); current != NULL; index++)
 	{
 		if (GpIdentity.segindex == (index + shift) % GpIdentity.numsegments)
@@ -408,6 +432,123 @@ filter_fragments_for_segment(List *list)
 	return result;
 }
 
+/*
+ * A fragment and its position in the list returned by the Fragmenter
+ */
+typedef struct SizedFragment
+{
+	int			position;
+	int64		size;
+} SizedFragment;
+
+/*
+ * Largest fragments first, and in list order among fragments of the same size
+ */
+static int
+sized_fragment_cmp(const void *a, const void *b)
+{
+	const SizedFragment *fa = (const SizedFragment *) a;
+	const SizedFragment *fb = (const SizedFragment *) b;
+
+	if (fa->size != fb->size)
+		return (fa->size > fb->size) ? -1 : 1;
+	return fa->position - fb->position;
+}
+
+/*
+ * Size-aware variant of filter_fragments_for_segment
+ *
+ * Every segment runs the same greedy assignment over the same list: fragments
+ * are taken from the largest down, and each goes to the segment with the
+ * fewest bytes so far, then the fewest fragments, then the first one starting
+ * from the shifted segment. A few huge files then no longer land on the same
+ * segment only because of their position in the list. Fragments without a
+ * size count as empty, so when no sizes are known this gives the same
+ * assignment as the MOD function.
+ *
+ * The kept fragments stay in list order.
+ */
+static List *
+filter_fragments_by_size(List *list, int4 shift)
+{
+	int			numsegments = GpIdentity.numsegments;
+	int			nfragments = list_length(list);
+	SizedFragment *sorted;
+	bool	   *keep;
+	int64	   *seg_bytes;
+	int		   *seg_count;
+	List	   *result = list;
+	ListCell   *previous = NULL,
+			   *current = NULL;
+	int			i;
+
+	sorted = palloc(nfragments * sizeof(SizedFragment));
+	keep = palloc0(nfragments * sizeof(bool));
+	seg_bytes = palloc0(numsegments * sizeof(int64));
+	seg_count = palloc0(numsegments * sizeof(int));
+
+	i = 0;
+	foreach(current, list)
+	{
+		FragmentData *fragment = (FragmentData *) lfirst(current);
+
+		sorted[i].position = i;
+		sorted[i].size = (fragment && fragment->size > 0) ? fragment->size : 0;
+		i++;
+	}
+	qsort(sorted, nfragments, sizeof(SizedFragment), sized_fragment_cmp);
+
+	for (i = 0; i < nfragments; i++)
+	{
+		int			target = shift % numsegments;
+		int			k;
+
+		for (k = 1; k < numsegments; k++)
+		{
+			int			seg = (shift + k) % numsegments;
+
+			if (seg_bytes[seg] < seg_bytes[target] ||
+				(seg_bytes[seg] == seg_bytes[target] &&
+				 seg_count[seg] < seg_count[target]))
+				target = seg;
+		}
+
+		seg_bytes[target] += sorted[i].size;
+		seg_count[target]++;
+		keep[sorted[i].position] = (target == GpIdentity.segindex);
+	}
+
+	elog(FRAGDEBUG, "segment %d was assigned " INT64_FORMAT " bytes in %d fragments",
+		 GpIdentity.segindex, seg_bytes[GpIdentity.segindex],
+		 seg_count[GpIdentity.segindex]);
+
+	current = list_head(list);
+	for (i = 0; current != NULL; i++)
+	{
+		if (keep[i])
+		{
+			previous = current;
+			current = lnext(current);
+		}
+		else
+		{
+			ListCell   *to_delete = current;
+
+			if (to_delete->data.ptr_value)
+				free_fragment((FragmentData *) to_delete->data.ptr_value);
+			current = lnext(to_delete);
+			result = list_delete_cell(list, to_delete, previous);
+		}
+	}
+
+	pfree(sorted);
+	pfree(keep);
+	pfree(seg_bytes);
+	pfree(seg_count);
+
+	return result;
+}
+
 /*
  * Preliminary curl initializations for the REST communication
  */
@@ -473,6 +614,7 @@ print_fragment_list(List *fragments)
 		appendStringInfo(&log_str, "metadata: %s\n", frag->fragment_md ? frag->fragment_md : "NULL");
 		appendStringInfo(&log_str, "user data: %s\n", frag->user_data ? frag->user_data : "NULL");
 		appendStringInfo(&log_str, "profile: %s\n", frag->profile ? frag->profile : "NULL");
+		appendStringInfo(&log_str, "size: " INT64_FORMAT "\n", frag->size);
 	}
 
 	elog(FRAGDEBUG, "%s", log_str.data);
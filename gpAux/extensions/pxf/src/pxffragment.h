@@ -46,6 +46,8 @@ typedef struct sClientContext
  * and the index of a of list of fragments (splits/regions) for that source name.
  * The index refers to the list of the fragments of that source name.
  * user_data is optional.
+ * size is the size of the fragment in bytes as reported by the Fragmenter,
+ * or -1 if it did not report one.
  */
 typedef struct FragmentData
 {
@@ -55,6 +57,7 @@ typedef struct FragmentData
 	char	   *fragment_md;
 	char	   *user_data;
 	char	   *profile;
+	int64		size;
 } FragmentData;
 
 /*
@@ -18,6 +18,7 @@
  */
 
 #include "pxfheaders.h"
+#include "pxffilters.h"
 #include "pxfutils.h"
 #include "access/fileam.h"
 #include "catalog/pg_exttable.h"
@@ -25,6 +26,7 @@
 /* helper function declarations */
 static void add_alignment_size_httpheader(CHURL_HEADERS headers);
 static void add_tuple_desc_httpheader(CHURL_HEADERS headers, Relation rel);
+static void add_projection_desc_httpheader(CHURL_HEADERS headers, Relation rel, bool *proj);
 static void add_location_options_httpheader(CHURL_HEADERS headers, GPHDUri *gphduri);
 static char *get_format_name(char fmtcode);
 
@@ -53,6 +55,9 @@ build_http_headers(PxfInputData *input)
 
 		/* Record fields - name and type of each field */
 		add_tuple_desc_httpheader(headers, rel);
+
+		/* Fields the query needs */
+		add_projection_desc_httpheader(headers, rel, input->proj);
 	}
 
 	/* GP cluster configuration */
@@ -76,8 +81,16 @@ build_http_headers(PxfInputData *input)
 	churl_headers_append(headers, "X-GP-URI", gphduri->uri);
 
 	/* filters */
-	/* TODO port filter logic, for now assume no filters */
-	churl_headers_append(headers, "X-GP-HAS-FILTER", "0");
+	char	   *filter = input->quals != NIL ? serializePxfFilterQuals(input->quals) : NULL;
+
+	if (filter != NULL)
+	{
+		churl_headers_append(headers, "X-GP-HAS-FILTER", "1");
+		churl_headers_append(headers, "X-GP-FILTER", filter);
+		pfree(filter);
+	}
+	else
+		churl_headers_append(headers, "X-GP-HAS-FILTER", "0");
 }
 
 /* Report alignment size to remote component
@@ -223,6 +236,47 @@ add_tuple_desc_httpheader(CHURL_HEADERS headers, Relation rel)
 	pfree(formatter.data);
 }
 
+/*
+ * Report the attributes the query needs to remote component, so that it only
+ * reads those; it returns NULLs for the others.
+ * Nothing is reported if the query needs all of them, or none, e.g. for
+ * count(*).
+ * X-GP-ATTRS-PROJ - number of attributes the query needs
+ * X-GP-ATTRS-PROJ-IDX - comma separated indexes of those attributes
+ */
+static void
+add_projection_desc_httpheader(CHURL_HEADERS headers, Relation rel, bool *proj)
+{
+	char		long_number[sizeof(int32) * 8];
+	StringInfoData formatter;
+	TupleDesc	tuple = RelationGetDescr(rel);
+	int			nproj = 0;
+
+	if (proj == NULL)
+		return;
+
+	initStringInfo(&formatter);
+
+	for (int i = 0; i < tuple->natts; ++i)
+	{
+		if (!proj[i])
+			continue;
+
+		if (nproj++ > 0)
+			appendStringInfoChar(&formatter, ',');
+		appendStringInfo(&formatter, "%d", i);
+	}
+
+	if (nproj > 0 && nproj < tuple->natts)
+	{
+		pg_ltoa(nproj, long_number);
+		churl_headers_append(headers, "X-GP-ATTRS-PROJ", long_number);
+		churl_headers_append(headers, "X-GP-ATTRS-PROJ-IDX", formatter.data);
+	}
+
+	pfree(formatter.data);
+}
+
 /*
  * The options in the LOCATION statement of "create extenal table"
  * FRAGMENTER=HdfsDataFragmenter&ACCESSOR=SequenceFileAccessor...
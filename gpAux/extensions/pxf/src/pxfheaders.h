@@ -34,6 +34,8 @@ typedef struct sPxfInputData
 	CHURL_HEADERS headers;
 	GPHDUri    *gphduri;
 	Relation	rel;
+	bool	   *proj;			/* attributes the scan needs, NULL for all */
+	List	   *quals;			/* quals of the scan */
 } PxfInputData;
 
 /*
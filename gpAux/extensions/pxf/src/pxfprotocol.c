@@ -151,6 +151,11 @@ create_context(PG_FUNCTION_ARGS, bool is_import)
 	initStringInfo(&context->uri);
 	initStringInfo(&context->write_file_name);
 	context->relation = relation;
+	if (is_import)
+	{
+		context->proj = EXTPROTOCOL_GET_PROJECTION(fcinfo);
+		context->quals = EXTPROTOCOL_GET_QUALS(fcinfo);
+	}
 
 	return context;
 }
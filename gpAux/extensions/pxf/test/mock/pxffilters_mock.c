@@ -0,0 +1,7 @@
+/* mock functions for pxffilters.h */
+char *
+serializePxfFilterQuals(List *quals)
+{
+	check_expected(quals);
+	return (char *) mock();
+}
@@ -0,0 +1,192 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include "cmockery.h"
+
+/* Define UNIT_TESTING so that the extension can skip declaring PG_MODULE_MAGIC */
+#define UNIT_TESTING
+
+/* include unit under test */
+#include "../src/pxffilters.c"
+
+#include "catalog/pg_type.h"
+
+/* helper functions */
+static Var *build_var(AttrNumber attno, Oid vartype);
+static Const *build_const(Oid consttype, Datum value, bool isnull);
+static OpExpr *build_opexpr(Oid opno, Node *left, Node *right);
+static void expect_const_output(Oid consttype, char *output);
+
+void
+test_serializePxfFilterQuals_no_quals(void **state)
+{
+	assert_true(serializePxfFilterQuals(NIL) == NULL);
+}
+
+void
+test_serializePxfFilterQuals_var_op_const(void **state)
+{
+	/* b > 10 */
+	OpExpr	   *expr = build_opexpr(521 /* int4gt */ ,
+									(Node *) build_var(2, INT4OID),
+									(Node *) build_const(INT4OID, Int32GetDatum(10), false));
+
+	expect_const_output(INT4OID, "10");
+
+	char	   *filter = serializePxfFilterQuals(list_make1(expr));
+
+	assert_string_equal(filter, "a1c23s2d10o2");
+	pfree(filter);
+}
+
+void
+test_serializePxfFilterQuals_const_op_var(void **state)
+{
+	/* 10 < a */
+	OpExpr	   *expr = build_opexpr(97 /* int4lt */ ,
+									(Node *) build_const(INT4OID, Int32GetDatum(10), false),
+									(Node *) build_var(1, INT4OID));
+
+	expect_const_output(INT4OID, "10");
+
+	char	   *filter = serializePxfFilterQuals(list_make1(expr));
+
+	assert_string_equal(filter, "c23s2d10a0o1");
+	pfree(filter);
+}
+
+void
+test_serializePxfFilterQuals_and(void **state)
+{
+	/* a = 1 AND c <> 'abc' AND a = b, of which the last is left out */
+	OpExpr	   *expr1 = build_opexpr(96 /* int4eq */ ,
+									 (Node *) build_var(1, INT4OID),
+									 (Node *) build_const(INT4OID, Int32GetDatum(1), false));
+	RelabelType *relabel = makeNode(RelabelType);
+
+	relabel->arg = (Expr *) build_var(3, VARCHAROID);
+	relabel->resulttype = TEXTOID;
+	OpExpr	   *expr2 = build_opexpr(531 /* textne */ ,
+									 (Node *) relabel,
+									 (Node *) build_const(TEXTOID, PointerGetDatum(NULL), false));
+	OpExpr	   *expr3 = build_opexpr(96 /* int4eq */ ,
+									 (Node *) build_var(1, INT4OID),
+									 (Node *) build_var(2, INT4OID));
+
+	expect_const_output(INT4OID, "1");
+	expect_const_output(TEXTOID, "abc");
+
+	char	   *filter = serializePxfFilterQuals(list_make3(expr1, expr2, expr3));
+
+	assert_string_equal(filter, "a0c23s1d1o5a2c25s3dabco6l0");
+	pfree(filter);
+}
+
+void
+test_serializePxfFilterQuals_unsupported(void **state)
+{
+	/* text ordering is left to the scan */
+	OpExpr	   *expr1 = build_opexpr(664 /* text_lt */ ,
+									 (Node *) build_var(1, TEXTOID),
+									 (Node *) build_const(TEXTOID, PointerGetDatum(NULL), false));
+
+	/* so are comparisons with NULL */
+	OpExpr	   *expr2 = build_opexpr(96 /* int4eq */ ,
+									 (Node *) build_var(1, INT4OID),
+									 (Node *) build_const(INT4OID, (Datum) 0, true));
+
+	/* and other expressions */
+	BoolExpr   *expr3 = makeNode(BoolExpr);
+
+	expr3->boolop = OR_EXPR;
+	expr3->args = list_make2(expr1, expr2);
+
+	assert_true(serializePxfFilterQuals(list_make3(expr1, expr2, expr3)) == NULL);
+}
+
+static Var *
+build_var(AttrNumber attno, Oid vartype)
+{
+	Var		   *var = makeNode(Var);
+
+	var->varno = 1;
+	var->varattno = attno;
+	var->vartype = vartype;
+	var->varlevelsup = 0;
+
+	return var;
+}
+
+static Const *
+build_const(Oid consttype, Datum value, bool isnull)
+{
+	Const	   *con = makeNode(Const);
+
+	con->consttype = consttype;
+	con->constvalue = value;
+	con->constisnull = isnull;
+
+	return con;
+}
+
+static OpExpr *
+build_opexpr(Oid opno, Node *left, Node *right)
+{
+	OpExpr	   *expr = makeNode(OpExpr);
+
+	expr->opno = opno;
+	expr->opresulttype = BOOLOID;
+	expr->args = list_make2(left, right);
+
+	return expr;
+}
+
+static void
+expect_const_output(Oid consttype, char *output)
+{
+	expect_value(getTypeOutputInfo, type, consttype);
+	expect_any(getTypeOutputInfo, typOutput);
+	expect_any(getTypeOutputInfo, typIsVarlena);
+	will_be_called(getTypeOutputInfo);
+
+	expect_any(OidOutputFunctionCall, functionId);
+	expect_any(OidOutputFunctionCall, val);
+	will_return(OidOutputFunctionCall, pstrdup(output));
+}
+
+int
+main(int argc, char *argv[])
+{
+	cmockery_parse_arguments(argc, argv);
+
+	const		UnitTest tests[] = {
+		unit_test(test_serializePxfFilterQuals_no_quals),
+		unit_test(test_serializePxfFilterQuals_var_op_const),
+		unit_test(test_serializePxfFilterQuals_const_op_var),
+		unit_test(test_serializePxfFilterQuals_and),
+		unit_test(test_serializePxfFilterQuals_unsupported)
+	};
+
+	MemoryContextInit();
+
+	return run_tests(tests);
+}
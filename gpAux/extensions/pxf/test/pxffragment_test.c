@@ -21,6 +21,7 @@
 /* helper functions */
 static List *prepare_fragment_list(int fragtotal, int sefgindex, int segtotal, int xid);
 static void test_list(int segindex, int segtotal, int xid, int fragtotal, char *expected[], int expected_total);
+static void test_sized_list(int segindex, int segtotal, int xid, int64 sizes[], int fragtotal, char *expected[], int expected_total);
 static FragmentData *buildFragment(const char *index, const char *source, const char *userdata, const char *metadata, const char *profile);
 static bool compareLists(List *list1, List *list2, bool (*compareType) (void *, void *));
 static bool compareString(char *str1, char *str2);
@@ -183,6 +184,84 @@ test_filter_fragments_for_segment(void **state)
 	PG_END_TRY();
 }
 
+void
+test_filter_fragments_for_segment_by_size(void **state)
+{
+	/* the two large fragments go to different segments */
+	int64		sizes_1[4] = {100, 1, 100, 1};
+	char	   *expected_0_2_2_4[2] = {"0", "1"};
+	char	   *expected_1_2_2_4[2] = {"2", "3"};
+
+	/* xid = 2, seg = 0 */
+	test_sized_list(0, 2, 2, sizes_1, ARRSIZE(sizes_1), expected_0_2_2_4, ARRSIZE(expected_0_2_2_4));
+	/* xid = 2, seg = 1 */
+	test_sized_list(1, 2, 2, sizes_1, ARRSIZE(sizes_1), expected_1_2_2_4, ARRSIZE(expected_1_2_2_4));
+
+	/* one huge fragment keeps a segment busy while the other takes the rest */
+	int64		sizes_2[4] = {10, 10, 1000, 10};
+	char	   *expected_0_2_3_4[3] = {"0", "1", "3"};
+	char	   *expected_1_2_3_4[1] = {"2"};
+
+	/* xid = 3, seg = 0 */
+	test_sized_list(0, 2, 3, sizes_2, ARRSIZE(sizes_2), expected_0_2_3_4, ARRSIZE(expected_0_2_3_4));
+	/* xid = 3, seg = 1 */
+	test_sized_list(1, 2, 3, sizes_2, ARRSIZE(sizes_2), expected_1_2_3_4, ARRSIZE(expected_1_2_3_4));
+
+	/* without sizes, the same fragments as the MOD function */
+	int64		sizes_3[3] = {-1, -1, -1};
+	char	   *expected_0_2_1_3[1] = {"1"};
+	char	   *expected_1_2_1_3[2] = {"0", "2"};
+
+	/* xid = 1, seg = 0 */
+	test_sized_list(0, 2, 1, sizes_3, ARRSIZE(sizes_3), expected_0_2_1_3, ARRSIZE(expected_0_2_1_3));
+	/* xid = 1, seg = 1 */
+	test_sized_list(1, 2, 1, sizes_3, ARRSIZE(sizes_3), expected_1_2_1_3, ARRSIZE(expected_1_2_1_3));
+
+	/* more segments than fragments */
+	int64		sizes_4[2] = {5, 50};
+	char	   *expected_0_3_1_2[1] = {"0"};
+	char	   *expected_1_3_1_2[1] = {"1"};
+
+	/* xid = 1, seg = 0 */
+	test_sized_list(0, 3, 1, sizes_4, ARRSIZE(sizes_4), NULL, 0);
+	/* xid = 1, seg = 1 */
+	test_sized_list(1, 3, 1, sizes_4, ARRSIZE(sizes_4), expected_1_3_1_2, ARRSIZE(expected_1_3_1_2));
+	/* xid = 1, seg = 2 */
+	test_sized_list(2, 3, 1, sizes_4, ARRSIZE(sizes_4), expected_0_3_1_2, ARRSIZE(expected_0_3_1_2));
+}
+
+static void
+test_sized_list(int segindex, int segtotal, int xid, int64 sizes[], int fragtotal, char *expected[], int expected_total)
+{
+	/* prepare the input list */
+	List	   *list = prepare_fragment_list(fragtotal, segindex, segtotal, xid);
+	ListCell   *cell;
+	int			i;
+
+	foreach_with_count(cell, list, i)
+	{
+		((FragmentData *) lfirst(cell))->size = sizes[i];
+	}
+
+	/* filter the list */
+	List	   *filtered = filter_fragments_for_segment(list);
+
+	/* assert results */
+	if (expected_total > 0)
+	{
+		assert_int_equal(filtered->length, expected_total);
+
+		foreach_with_count(cell, filtered, i)
+		{
+			assert_true(compareString(((FragmentData *) lfirst(cell))->index, expected[i]));
+		}
+	}
+	else
+	{
+		assert_true(filtered == NIL);
+	}
+}
+
 static void
 test_list(int segindex, int segtotal, int xid, int fragtotal, char *expected[], int expected_total)
 {
@@ -263,6 +342,21 @@ test_parse_get_fragments_response(void **state)
 	assert_true(compareLists(data_fragments, expected_data_fragments, compareFragment));
 }
 
+void
+test_parse_get_fragments_response_size(void **state)
+{
+	List	   *data_fragments = NIL;
+	StringInfoData frag_json;
+
+	initStringInfo(&frag_json);
+	appendStringInfo(&frag_json, "{\"PXFFragments\":[{\"index\":0,\"sourceName\":\"demo/text2.csv\",\"fragmentSize\":134217728,\"metadata\":\"metadatavalue1\",\"replicas\":[\"localhost\"]},{\"index\":1,\"sourceName\":\"demo/text_csv.csv\",\"metadata\":\"metadatavalue2\",\"replicas\":[\"localhost\"]}]}");
+	data_fragments = parse_get_fragments_response(data_fragments, &frag_json);
+
+	assert_int_equal(list_length(data_fragments), 2);
+	assert_true(((FragmentData *) linitial(data_fragments))->size == INT64CONST(134217728));
+	assert_true(((FragmentData *) lsecond(data_fragments))->size == -1);
+}
+
 void
 test_parse_get_fragments_response_bad_index(void **state)
 {
@@ -469,7 +563,9 @@ main(int argc, char *argv[])
 
 	const		UnitTest tests[] = {
 		unit_test(test_filter_fragments_for_segment),
+		unit_test(test_filter_fragments_for_segment_by_size),
 		unit_test(test_parse_get_fragments_response),
+		unit_test(test_parse_get_fragments_response_size),
 		unit_test(test_parse_get_fragments_response_bad_metadata),
 		unit_test(test_parse_get_fragments_response_bad_index),
 		unit_test(test_parse_get_fragments_response_nullfragment),
@@ -30,6 +30,7 @@
 
 /* include mock files */
 #include "mock/libchurl_mock.c"
+#include "mock/pxffilters_mock.c"
 #include "mock/pxfutils_mock.c"
 
 /* helper functions */
@@ -256,6 +257,36 @@ test_add_tuple_desc_httpheader(void **state)
 	pfree(headers);
 }
 
+void
+test_add_projection_desc_httpheader(void **state)
+{
+	/* setup mock data and expectations */
+	CHURL_HEADERS headers = (CHURL_HEADERS) palloc0(sizeof(CHURL_HEADERS));
+	Relation	rel = (Relation) palloc0(sizeof(RelationData));
+	struct tupleDesc tuple;
+	bool		proj[4] = {true, false, false, true};
+	bool		proj_all[4] = {true, true, true, true};
+	bool		proj_none[4] = {false, false, false, false};
+
+	tuple.natts = 4;
+	rel->rd_att = &tuple;
+
+	expect_headers_append(headers, "X-GP-ATTRS-PROJ", "2");
+	expect_headers_append(headers, "X-GP-ATTRS-PROJ-IDX", "0,3");
+
+	/* call function under test */
+	add_projection_desc_httpheader(headers, rel, proj);
+
+	/* nothing to report for all attributes, or none */
+	add_projection_desc_httpheader(headers, rel, proj_all);
+	add_projection_desc_httpheader(headers, rel, proj_none);
+	add_projection_desc_httpheader(headers, rel, NULL);
+
+	/* cleanup */
+	pfree(rel);
+	pfree(headers);
+}
+
 void
 test_get_format_name(void **state)
 {
@@ -305,7 +336,8 @@ main(int argc, char *argv[])
 	const		UnitTest tests[] = {
 		unit_test(test_get_format_name),
 		unit_test(test_build_http_headers),
-		unit_test(test_add_tuple_desc_httpheader)
+		unit_test(test_add_tuple_desc_httpheader),
+		unit_test(test_add_projection_desc_httpheader)
 	};
 
 	MemoryContextInit();
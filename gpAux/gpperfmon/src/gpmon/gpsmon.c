@@ -1091,13 +1091,42 @@ static void gx_recvqexec(gpmon_packet_t* pkt)
 	return;
 }
 
+/* Process each record of a batch of QEXEC packets as a QEXEC packet of
+ its own.
+ */
+static void gx_recvqexec_batch(gpmon_qexec_batch_t* batch)
+{
+	gpmon_packet_t pkt;
+	int i;
+
+	for (i = 0; i < batch->nrecs; i++)
+	{
+		gpmon_qexec_rec_t* rec = &batch->recs[i];
+
+		memset(&pkt, 0, sizeof(pkt));
+		pkt.magic = batch->magic;
+		pkt.version = batch->version;
+		pkt.pkttype = GPMON_PKTTYPE_QEXEC;
+		pkt.u.qexec.key = rec->key;
+		pkt.u.qexec.status = rec->status;
+		pkt.u.qexec.rowsout = rec->rowsout;
+		pkt.u.qexec.rowsin = rec->rowsin;
+		gx_recvqexec(&pkt);
+	}
+}
+
 /* callback from libevent when a udp socket is ready to be read.
  This function determines the packet type, then calls
- gx_recvqlog() or gx_recvqexec().
+ gx_recvqlog(), gx_recvqexec() or gx_recvqexec_batch().
  */
 static void gx_recvfrom(SOCKET sock, short event, void* arg)
 {
-	gpmon_packet_t pkt;
+	union
+	{
+		gpmon_packet_t pkt;
+		gpmon_qexec_batch_t batch;
+	} buf;
+	gpmon_packet_t* pkt = &buf.pkt;
 	struct sockaddr_in addr;
 	socklen_t addrlen = sizeof(addr);
 	int n;
@@ -1105,40 +1134,58 @@ static void gx_recvfrom(SOCKET sock, short event, void* arg)
 	if (!(event & EV_READ))
 		return;
 
-	n = recvfrom(sock, &pkt, sizeof(pkt), 0, (void*) &addr, &addrlen);
+	n = recvfrom(sock, &buf, sizeof(buf), 0, (void*) &addr, &addrlen);
 	if (n == -1)
 	{
 		gpmon_warningx(FLINE, APR_FROM_OS_ERROR(errno), "recvfrom failed");
 		return;
 	}
 
-	if (n != sizeof(pkt))
+	if (n < (int) offsetof(gpmon_qexec_batch_t, recs))
 	{
-		gpmon_warning(FLINE, "bad packet (length %d). Expected packet size %d", n, sizeof(pkt));
+		gpmon_warning(FLINE, "bad packet (length %d)", n);
 		return;
 	}
 
 	/* do some packet marshaling */
-	if (0 != gpmon_ntohpkt(pkt.magic, pkt.version, pkt.pkttype))
+	if (0 != gpmon_ntohpkt(pkt->magic, pkt->version, pkt->pkttype))
 	{
 		gpmon_warning(FLINE, "error with packet marshaling");
 		return;
 	}
 
+	if (pkt->pkttype == GPMON_PKTTYPE_QEXEC_BATCH)
+	{
+		if (buf.batch.nrecs < 1 || buf.batch.nrecs > GPMON_QEXEC_BATCH_MAX ||
+			n != GPMON_QEXEC_BATCH_SIZE(buf.batch.nrecs))
+		{
+			gpmon_warning(FLINE, "bad batch packet (length %d, %d records)", n, buf.batch.nrecs);
+			return;
+		}
+		gx_recvqexec_batch(&buf.batch);
+		return;
+	}
+
+	if (n != sizeof(*pkt))
+	{
+		gpmon_warning(FLINE, "bad packet (length %d). Expected packet size %d", n, sizeof(*pkt));
+		return;
+	}
+
 	/* process the packet */
-	switch (pkt.pkttype)
+	switch (pkt->pkttype)
 	{
 	case GPMON_PKTTYPE_QLOG:
-		gx_recvqlog(&pkt);
+		gx_recvqlog(pkt);
 		break;
 	case GPMON_PKTTYPE_SEGINFO:
-		gx_recvsegment(&pkt);
+		gx_recvsegment(pkt);
 		break;
 	case GPMON_PKTTYPE_QEXEC:
-		gx_recvqexec(&pkt);
+		gx_recvqexec(pkt);
 		break;
 	default:
-		gpmon_warning(FLINE, "unexpected packet type %d", pkt.pkttype);
+		gpmon_warning(FLINE, "unexpected packet type %d", pkt->pkttype);
 		return;
 	}
 }
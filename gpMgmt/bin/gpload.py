@@ -2607,6 +2607,11 @@ class gpload:
         self.do_update(self.staging_table_name, 0)
 		
         # insert new rows to the target table
+        #
+        # This is written as NOT EXISTS rather than as an outer join filtered
+        # on IS NULL, so that the planner turns it into an anti-join: the
+        # target is only probed for the match columns (by index, when there
+        # is one on them) and no joined rows are built only to be thrown away.
         match = self.map_stuff('gpload:output:match_columns',lambda x,y:'into_table.%s=from_table.%s'%(x,y),0)
         matchColumns = self.getconfig('gpload:output:match_columns',list)
 		
@@ -2616,11 +2621,9 @@ class gpload:
         sql += '(SELECT %s ' % ','.join(map(lambda a:'from_table.%s' % a[0], cols))
         sql += 'FROM (SELECT *, row_number() OVER (PARTITION BY %s) AS gpload_row_number ' % ','.join(matchColumns)
         sql += 'FROM %s) AS from_table ' % self.staging_table_name
-        sql += 'LEFT OUTER JOIN %s into_table ' % self.get_qualified_tablename()
-        sql += 'ON %s '%' AND '.join(match)
-        where = self.map_stuff('gpload:output:match_columns',lambda x,y:'into_table.%s IS NULL'%x,0)
-        sql += 'WHERE %s ' % ' AND '.join(where)
-        sql += 'AND gpload_row_number=1)'
+        sql += 'WHERE gpload_row_number=1 '
+        sql += 'AND NOT EXISTS (SELECT 1 FROM %s into_table ' % self.get_qualified_tablename()
+        sql += 'WHERE %s))' % ' AND '.join(match)
 
         self.log(self.LOG, sql)
         if not self.options.D:
@@ -1,3 +1,4 @@
+import hashlib
 import shutil
 from gppylib.commands.base import ExecutionError
 from gppylib.commands.gp import Psql
@@ -85,6 +86,12 @@ GET_ALL_HEAP_DATATABLES_SQL = """
     %s AND ALLTABLES.oid not in (SELECT relid from pg_appendonly)
 """ % GET_ALL_DATATABLES_SQL
 
+# Run on every segment at once; see gp_relation_max_lsn()
+GET_HEAP_CHANGE_STATE_SQL = """
+    SELECT oid, gp_segment_id, relfilenode, pg_catalog.gp_relation_max_lsn(oid)
+    FROM gp_dist_random('pg_class') WHERE oid IN (%s)
+"""
+
 GET_ALL_AO_CO_DATATABLES_SQL = """
     %s AND ALLTABLES.oid in (SELECT relid from pg_appendonly)
 """ % GET_ALL_DATATABLES_SQL
@@ -126,6 +133,35 @@ def get_co_partition_state(context):
     co_partition_list = get_partition_state(context, 'pg_aoseg', co_partition_info)
     return co_partition_list
 
+def get_heap_partition_state(context):
+    """
+        Reads the state of every heap table, in the same
+        (schema, table, state) form as the AO and CO state files.
+
+        Heap tables have no modcount, so the state is a digest of each
+        segment's relfilenode and highest page LSN for the table.  Every
+        logged change to a page advances its LSN, and a rewrite gives the
+        table a new relfilenode, so the state changes whenever the data does.
+        Finding the LSNs reads the tables on all segments in parallel, which
+        is far cheaper than dumping them.
+    """
+    heap_partition_info = get_heap_partition_list(context)
+    if not heap_partition_info:
+        return []
+
+    names = dict((str(row[0]), (row[1], row[2])) for row in heap_partition_info)
+    sql = GET_HEAP_CHANGE_STATE_SQL % ','.join(names.keys())
+    segment_states = dict()
+    for (oid, segid, relfilenode, lsn) in execute_sql(sql, context.master_port, context.target_db):
+        segment_states.setdefault(str(oid), []).append('%s:%s:%s' % (segid, relfilenode, lsn))
+
+    partition_list = list()
+    for oid, (schemaname, tablename) in names.items():
+        state = hashlib.md5(','.join(sorted(segment_states.get(oid, [])))).hexdigest()
+        partition_list.append('%s, %s, %s' % (schemaname, tablename, state))
+
+    return partition_list
+
 def validate_modcount(schema, tablename, cnt):
     if not cnt:
         return
@@ -288,8 +324,8 @@ def compare_dict(last_dict, curr_dict):
 def get_filename_from_filetype(context, table_type, timestamp=None):
     if not timestamp:
         timestamp = context.timestamp
-    if table_type not in ["ao", "co"]:
-        raise Exception('Invalid table type %s provided. Supported table types ao/co.' % table_type)
+    if table_type not in ["ao", "co", "heap"]:
+        raise Exception('Invalid table type %s provided. Supported table types ao/co/heap.' % table_type)
     filename = context.generate_filename(table_type, timestamp=timestamp)
 
     return filename
@@ -305,8 +341,11 @@ def write_state_file(context, table_type, partition_list):
         copy_file_to_dd(context, filename)
 
 # return a list of dirty tables
-def get_dirty_tables(context, ao_partition_list, co_partition_list, last_operation_data):
-    dirty_heap_tables = get_dirty_heap_tables(context)
+def get_dirty_tables(context, ao_partition_list, co_partition_list, last_operation_data, heap_partition_list=None):
+    if heap_partition_list is None:
+        dirty_heap_tables = get_dirty_heap_tables(context)
+    else:
+        dirty_heap_tables = get_dirty_heap_partition_tables(context, heap_partition_list)
     dirty_ao_tables = get_dirty_partition_tables(context, 'ao', ao_partition_list)
     dirty_co_tables = get_dirty_partition_tables(context, 'co', co_partition_list)
     dirty_metadata_set = get_tables_with_dirty_metadata(context, last_operation_data)
@@ -323,6 +362,21 @@ def get_dirty_heap_tables(context):
         dirty_tables.add(tname)
     return dirty_tables
 
+def get_dirty_heap_partition_tables(context, curr_state_partition_list):
+    """
+    Heap tables whose state changed since the last backup.  A last backup
+    that recorded no heap state counts every heap table as dirty.
+    """
+    last_ts = get_last_dump_timestamp(context)
+    last_state_filename = get_filename_from_filetype(context, 'heap', last_ts.strip())
+    if context.netbackup_service_host is None:
+        if not os.path.isfile(last_state_filename):
+            return get_dirty_heap_tables(context)
+    elif not check_file_dumped_with_nbu(context, path=last_state_filename):
+        return get_dirty_heap_tables(context)
+
+    return get_dirty_partition_tables(context, 'heap', curr_state_partition_list)
+
 def write_dirty_file_to_temp(dirty_tables):
     return create_temp_file_from_list(dirty_tables, 'dirty_backup_list_')
 
@@ -510,6 +564,7 @@ def backup_state_files_with_nbu(context):
 
     backup_file_with_nbu(context, "ao")
     backup_file_with_nbu(context, "co")
+    backup_file_with_nbu(context, "heap")
     backup_file_with_nbu(context, "last_operation")
 
 def backup_config_files_with_nbu(context):
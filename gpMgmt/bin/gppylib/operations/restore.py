@@ -3,6 +3,7 @@ import gzip
 import os
 import shutil
 import socket
+import tempfile
 import time
 
 from pygresql import pg
@@ -247,6 +248,96 @@ def validate_restore_tables_list(plan_file_contents, restore_tables, restore_sch
     if invalid_tables != []:
         raise Exception('Invalid tables for -T option: The following tables were not found in plan file : "%s"' % (invalid_tables))
 
+# Post data items that only touch their own table and may be restored
+# concurrently with the items of other tables
+PARALLEL_POST_DATA_TYPES = ['INDEX', 'CONSTRAINT']
+POST_DATA_NAME_QUOTE = '"(?:[^"]|"")*"'
+POST_DATA_NAME = '(?:%s|[^\s".;(]+)' % POST_DATA_NAME_QUOTE
+POST_DATA_TABLE = '%s(?:\.%s)?' % (POST_DATA_NAME, POST_DATA_NAME)
+post_data_index_table = compile('^CREATE (?:UNIQUE )?INDEX %s ON (?:ONLY )?(%s)' % (POST_DATA_NAME, POST_DATA_TABLE))
+post_data_constraint_table = compile('^ALTER TABLE (?:ONLY )?(%s)' % POST_DATA_TABLE)
+post_data_item_header = compile('^-- Name: .*; Type: (.*?); Schema: ')
+
+class PostDataItem(object):
+    def __init__(self, type, settings):
+        self.type = type
+        self.settings = list(settings)
+        self.lines = []
+
+    def get_table(self):
+        """
+        Returns the table the item is built on, qualified by the search_path
+        it runs under, or None if the item must not run in parallel.
+        """
+        if self.type not in PARALLEL_POST_DATA_TYPES:
+            return None
+        statement = ''.join(self.lines).strip()
+        if self.type == 'INDEX':
+            m = post_data_index_table.match(statement)
+        else:
+            m = post_data_constraint_table.match(statement)
+        if not m:
+            return None
+        search_path = [s for s in self.settings if s.startswith('SET search_path ')]
+        return (''.join(search_path), m.group(1))
+
+    def get_sql(self):
+        return ''.join(self.settings) + ''.join(self.lines)
+
+def _post_data_setting_key(line):
+    words = line.split()
+    if len(words) > 2 and words[1].upper() == 'SESSION':
+        return 'SESSION AUTHORIZATION'
+    return words[1] if len(words) > 1 else line
+
+def split_post_data_file(fd):
+    """
+    Split the statements of a _post_data dump file into the items pg_dump
+    wrote them as, each prefixed by the SET commands in effect for it.
+
+    Returns (parallel_groups, serial_items): parallel_groups holds one list
+    of INDEX and CONSTRAINT items per table, in file order, and serial_items
+    everything else (foreign keys, triggers, rules, comments), which must
+    run after all the groups, in file order.
+    """
+    settings = []
+    items = []
+    item = None
+    for line in fd:
+        if line.startswith('SET ') or line.startswith('RESET '):
+            key = _post_data_setting_key(line)
+            settings = [s for s in settings if _post_data_setting_key(s) != key]
+            if line.startswith('SET '):
+                settings.append(line)
+            item = None
+        elif line.startswith('--'):
+            m = post_data_item_header.match(line)
+            if m:
+                item = PostDataItem(m.group(1), settings)
+                items.append(item)
+        elif line.strip():
+            if item is None:
+                item = PostDataItem(None, settings)
+                items.append(item)
+            item.lines.append(line)
+
+    groups = {}
+    group_order = []
+    serial_items = []
+    for item in items:
+        if not item.lines:
+            continue
+        table = item.get_table()
+        if table is None:
+            serial_items.append(item)
+            continue
+        if table not in groups:
+            groups[table] = []
+            group_order.append(table)
+        groups[table].append(item)
+
+    return ([groups[t] for t in group_order], serial_items)
+
 #NetBackup related functions
 def restore_state_files_with_nbu(context):
     restore_file_with_nbu(context, "ao")
@@ -351,11 +442,17 @@ class RestoreDatabase(Operation):
         else:
             table_filter_file = self.create_filter_file()
             if not self.context.metadata_only:
+                parallel_post_data = self.use_parallel_post_data(full_restore_with_filter)
                 restore_line = self.create_standard_restore_string(table_filter_file, full_restore_with_filter, change_schema_file, schema_level_restore_file)
+                if parallel_post_data:
+                    restore_line += " --gp-nopostdata"
                 logger.info('gp_restore commandline: %s: ' % restore_line)
                 cmd = Command('Invoking gp_restore', restore_line)
                 cmd.run(validateAfter=False)
                 self._process_result(cmd)
+                if parallel_post_data:
+                    logger.info("Running parallel post data restore")
+                    RestorePostDataInParallel(self.context, self.context.post_data_jobs).run()
 
             if full_restore_with_filter:
                 restore_line = self.create_post_data_schema_only_restore_string(table_filter_file, full_restore_with_filter, change_schema_file, schema_level_restore_file)
@@ -384,6 +481,24 @@ class RestoreDatabase(Operation):
         self.tmp_files = [table_filter_file, change_schema_file, schema_level_restore_file]
         self.cleanup_files_on_segments()
 
+    def use_parallel_post_data(self, full_restore_with_filter):
+        """
+        The parallel post data restore reads the master _post_data file
+        directly, so it only replaces gp_restore's own post data step for an
+        unfiltered restore from local disk.
+        """
+        if self.context.post_data_jobs <= 1:
+            return False
+        if full_restore_with_filter or self.context.no_plan:
+            return False
+        if len(self.context.restore_tables) > 0 or len(self.context.restore_schemas) > 0 or self.context.change_schema:
+            logger.info("Post data is restored serially when restoring a subset of tables or into a different schema")
+            return False
+        if self.context.ddboost or self.context.netbackup_service_host:
+            logger.info("Post data is restored serially when restoring from DDBoost or NetBackup")
+            return False
+        return True
+
     def _process_result(self, cmd):
         res = cmd.get_results()
         if res.rc == 0:
@@ -962,6 +1077,66 @@ class CopyPostData(Operation):
         fake_post_data = self.context.generate_filename("postdata", timestamp=self.fake_timestamp)
         shutil.copy(real_post_data, fake_post_data)
 
+class RestorePostDataInParallel(Operation):
+    ''' Restore the master _post_data file with several sessions at once.
+        The index and primary key/unique constraint builds of different
+        tables run concurrently, each table's in file order; foreign keys
+        and everything else follow in a single session once they are done. '''
+    def __init__(self, context, num_workers):
+        self.context = context
+        self.num_workers = num_workers
+
+    def execute(self):
+        post_data_file = self.context.generate_filename("postdata")
+        if post_data_file.endswith('.gz'):
+            fd = gzip.open(post_data_file, 'r')
+        else:
+            fd = open(post_data_file, 'r')
+        try:
+            (groups, serial_items) = split_post_data_file(fd)
+        finally:
+            fd.close()
+
+        logger.info("Restoring post data for %d tables with %d sessions" %
+                    (len(groups), min(len(groups), self.num_workers)))
+
+        tmp_dir = tempfile.mkdtemp(prefix='gpdbrestore_post_data_')
+        try:
+            if groups:
+                pool = WorkerPool(numWorkers=min(len(groups), self.num_workers))
+                try:
+                    for i, group in enumerate(groups):
+                        filename = self._write_sql_file(tmp_dir, 'group_%d.sql' % i, group)
+                        pool.addCommand(Psql('Restore post data group %d' % i, filename=filename,
+                                             database=self.context.target_db, port=self.context.master_port))
+                    pool.join()
+                    failed = [cmd for cmd in pool.getCompletedItems() if not cmd.was_successful()]
+                finally:
+                    pool.haltWork()
+                for cmd in failed:
+                    logger.error("%s failed: %s" % (cmd.name, cmd.get_results().stderr.strip()))
+                if failed:
+                    raise Exception('gpdbrestore finished unsuccessfully: %d of %d post data groups failed' % (len(failed), len(groups)))
+
+            if serial_items:
+                filename = self._write_sql_file(tmp_dir, 'serial.sql', serial_items)
+                cmd = Psql('Restore remaining post data', filename=filename,
+                           database=self.context.target_db, port=self.context.master_port)
+                cmd.run(validateAfter=False)
+                if not cmd.was_successful():
+                    logger.error("%s failed: %s" % (cmd.name, cmd.get_results().stderr.strip()))
+                    raise Exception('gpdbrestore finished unsuccessfully: restore of remaining post data failed')
+        finally:
+            shutil.rmtree(tmp_dir, ignore_errors=True)
+
+    def _write_sql_file(self, tmp_dir, name, items):
+        filename = os.path.join(tmp_dir, name)
+        with open(filename, 'w') as f:
+            f.write('\\set ON_ERROR_STOP on\n')
+            for item in items:
+                f.write(item.get_sql())
+        return filename
+
 class GetDbName(Operation):
     def __init__(self, createdb_file):
         self.createdb_file = createdb_file
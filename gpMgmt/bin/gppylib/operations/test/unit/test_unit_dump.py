@@ -2,6 +2,7 @@
 # Copyright (c) Greenplum Inc 2012. All Rights Reserved.
 #
 
+import hashlib
 import unittest
 from datetime import datetime
 from gppylib.commands.base import Command, CommandResult
@@ -42,6 +43,40 @@ class DumpTestCase(unittest.TestCase):
         with self.assertRaisesRegexp(Exception, 'Heap tables query returned rows with unexpected number of columns 0'):
             dirty_table_list = get_dirty_heap_tables(self.context)
 
+    @patch('gppylib.operations.dump.get_heap_partition_list', return_value=[[123, 'public', 't4'], [124, 'testschema', 't5']])
+    @patch('gppylib.operations.dump.execute_sql', return_value=[[123, 0, 16400, '0/1A0'], [123, 1, 16400, '0/2B0'], [124, 0, 16401, '0/0']])
+    def test_get_heap_partition_state_default(self, mock1, mock2):
+        output = sorted(get_heap_partition_state(self.context))
+        expected_output = sorted(['public, t4, %s' % hashlib.md5('0:16400:0/1A0,1:16400:0/2B0').hexdigest(),
+                                  'testschema, t5, %s' % hashlib.md5('0:16401:0/0').hexdigest()])
+        self.assertEqual(output, expected_output)
+
+    @patch('gppylib.operations.dump.get_heap_partition_list', return_value=[[123, 'public', 't4']])
+    @patch('gppylib.operations.dump.execute_sql', side_effect=[[[123, 1, 16400, '0/2B0'], [123, 0, 16400, '0/1A0']],
+                                                               [[123, 0, 16400, '0/1A0'], [123, 1, 16400, '0/2B0']]])
+    def test_get_heap_partition_state_segment_order(self, mock1, mock2):
+        self.assertEqual(get_heap_partition_state(self.context), get_heap_partition_state(self.context))
+
+    @patch('gppylib.operations.dump.get_heap_partition_list', return_value=[])
+    def test_get_heap_partition_state_no_tables(self, mock1):
+        self.assertEqual(get_heap_partition_state(self.context), [])
+
+    @patch('gppylib.operations.dump.get_last_dump_timestamp', return_value='20160101121212')
+    @patch('gppylib.operations.dump.os.path.isfile', return_value=False)
+    @patch('gppylib.operations.dump.get_dirty_heap_tables', return_value=set(['public.t4', 'public.t5']))
+    def test_get_dirty_heap_partition_tables_no_last_state(self, mock1, mock2, mock3):
+        curr_state_partition_list = ['public, t4, abc', 'public, t5, def']
+        result = get_dirty_heap_partition_tables(self.context, curr_state_partition_list)
+        self.assertEqual(result, set(['public.t4', 'public.t5']))
+
+    @patch('gppylib.operations.dump.get_last_dump_timestamp', return_value='20160101121212')
+    @patch('gppylib.operations.dump.os.path.isfile', return_value=True)
+    @patch('gppylib.operations.dump.get_last_state', return_value=['public, t4, abc', 'public, t5, def'])
+    def test_get_dirty_heap_partition_tables_default(self, mock1, mock2, mock3):
+        curr_state_partition_list = ['public, t4, abc', 'public, t5, xyz', 'public, t6, ghi']
+        result = get_dirty_heap_partition_tables(self.context, curr_state_partition_list)
+        self.assertEqual(result, set(['public.t5', 'public.t6']))
+
     def test_write_dirty_file_default(self):
         dirty_tables = ['t1', 't2', 't3']
         m = mock_open()
@@ -580,6 +615,14 @@ class DumpTestCase(unittest.TestCase):
         expected_output = ['public.heap_table1', 'public.ao_t1', 'public.ao_t2', 'public.co_t1', 'public.co_t2', 'public.ao_t3', 'public.co_t3']
         self.assertEqual(dirty_tables.sort(), expected_output.sort())
 
+    @patch('gppylib.operations.dump.get_dirty_heap_partition_tables', return_value=set(['public.heap_table2']))
+    @patch('gppylib.operations.dump.get_dirty_partition_tables', side_effect=[set(['public.ao_t1']), set(['public.co_t1'])])
+    @patch('gppylib.operations.dump.get_tables_with_dirty_metadata', return_value=set())
+    def test_get_dirty_tables_heap_state(self, mock1, mock2, mock3):
+        heap_partition_list = ['public, heap_table1, abc', 'public, heap_table2, def']
+        dirty_tables = get_dirty_tables(self.context, [], [], [], heap_partition_list)
+        self.assertEqual(sorted(dirty_tables), ['public.ao_t1', 'public.co_t1', 'public.heap_table2'])
+
     @patch('gppylib.operations.dump.get_latest_report_timestamp', return_value = '20160101010100')
     def test_validate_current_timestamp_default(self, mock):
         directory = '/foo'
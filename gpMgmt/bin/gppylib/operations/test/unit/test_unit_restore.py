@@ -1115,6 +1115,103 @@ CREATE DATABASE monkey WITH TEMPLATE = template0 ENCODING = 'UTF8' OWNER = thisg
             from gppylib.commands.base import REMOTE
             cmd.assert_called_with("restoring metadata files to segment", cmdStr, ctxt=REMOTE, remoteHost="sdw")
 
+    def test_split_post_data_file_groups_by_table(self):
+        post_data = """SET statement_timeout = 0;
+SET search_path = public, pg_catalog;
+
+SET default_tablespace = '';
+
+--
+-- Name: t1_pkey; Type: CONSTRAINT; Schema: public; Owner: gpadmin; Tablespace: 
+--
+
+ALTER TABLE ONLY t1
+    ADD CONSTRAINT t1_pkey PRIMARY KEY (a);
+
+
+--
+-- Name: t2_b_idx; Type: INDEX; Schema: public; Owner: gpadmin; Tablespace: 
+--
+
+CREATE INDEX t2_b_idx ON t2 USING bitmap (b);
+
+
+--
+-- Name: t1_c_idx; Type: INDEX; Schema: public; Owner: gpadmin; Tablespace: 
+--
+
+CREATE INDEX t1_c_idx ON t1 USING btree (c);
+
+
+SET search_path = "my schema", pg_catalog;
+
+--
+-- Name: t1_c_idx; Type: INDEX; Schema: my schema; Owner: gpadmin; Tablespace: 
+--
+
+CREATE INDEX t1_c_idx ON t1 USING btree (c);
+
+
+--
+-- Name: t2_fk; Type: FK CONSTRAINT; Schema: my schema; Owner: gpadmin
+--
+
+ALTER TABLE ONLY t2
+    ADD CONSTRAINT t2_fk FOREIGN KEY (a) REFERENCES t1(a);
+"""
+        (groups, serial_items) = split_post_data_file(post_data.splitlines(True))
+        self.assertEqual(len(groups), 3)
+        self.assertEqual([len(g) for g in groups], [2, 1, 1])
+        self.assertEqual(groups[0][0].type, 'CONSTRAINT')
+        self.assertEqual(groups[0][1].type, 'INDEX')
+        self.assertEqual(groups[0][0].get_sql(), "SET statement_timeout = 0;\nSET search_path = public, pg_catalog;\nSET default_tablespace = '';\n"
+                                                 "ALTER TABLE ONLY t1\n    ADD CONSTRAINT t1_pkey PRIMARY KEY (a);\n")
+        self.assertTrue('SET search_path = "my schema", pg_catalog;\n' in groups[2][0].settings)
+        self.assertFalse('SET search_path = public, pg_catalog;\n' in groups[2][0].settings)
+        self.assertEqual(len(serial_items), 1)
+        self.assertEqual(serial_items[0].type, 'FK CONSTRAINT')
+
+    def test_split_post_data_file_quoted_table(self):
+        post_data = """--
+-- Name: idx; Type: INDEX; Schema: public; Owner: gpadmin; Tablespace: 
+--
+
+CREATE UNIQUE INDEX idx ON "my ""big"" table" USING btree (a);
+
+--
+-- Name: INDEX idx; Type: COMMENT; Schema: public; Owner: gpadmin
+--
+
+COMMENT ON INDEX idx IS 'x';
+"""
+        (groups, serial_items) = split_post_data_file(post_data.splitlines(True))
+        self.assertEqual(len(groups), 1)
+        self.assertEqual(groups[0][0].get_table(), ('', '"my ""big"" table"'))
+        self.assertEqual(len(serial_items), 1)
+        self.assertEqual(serial_items[0].type, 'COMMENT')
+
+    def test_use_parallel_post_data_default(self):
+        self.context.restore_schemas = []
+        self.assertFalse(self.restore.use_parallel_post_data(False))
+
+    def test_use_parallel_post_data_with_jobs(self):
+        self.context.restore_schemas = []
+        self.context.post_data_jobs = 4
+        self.assertTrue(self.restore.use_parallel_post_data(False))
+
+    def test_use_parallel_post_data_with_table_filter(self):
+        self.context.restore_schemas = []
+        self.context.restore_tables = ['public.t1']
+        self.context.post_data_jobs = 4
+        self.assertFalse(self.restore.use_parallel_post_data(True))
+        self.assertFalse(self.restore.use_parallel_post_data(False))
+
+    def test_use_parallel_post_data_with_ddboost(self):
+        self.context.restore_schemas = []
+        self.context.post_data_jobs = 4
+        self.context.ddboost = True
+        self.assertFalse(self.restore.use_parallel_post_data(False))
+
     @patch('gppylib.gparray.GpDB.getSegmentHostName', return_value='sdw')
     def test_restore_config_files_with_nbu_default(self, mock1):
         with patch('gppylib.operations.restore.restore_file_with_nbu', side_effect=my_counter) as nbu_mock:
@@ -321,6 +321,59 @@ class GpCheckCatTestCase(GpTestCase):
         self.assertEquals(aTable.getPrimaryKey.call_count, 1)
         self.subject.setError.assert_called_once_with(self.subject.ERROR_REMOVE)
 
+    def _digest_catalog_table(self, name):
+        aTable = Mock(spec=GPCatalogTable)
+        aTable.getTableName.return_value = name
+        aTable.getTableColtypes.return_value = {'oid': 'oid', 'relname': 'name', 'reltype': 'oid'}
+        aTable.getTableColumns.return_value = ['oid', 'relname']
+        aTable.getPrimaryKey.return_value = ['oid']
+        self.subject.GV.catalogDigestMatches = {}
+        self.subject.GV.max_content = 1
+        return aTable
+
+    def test_catalogDigestMatches__same_digest_everywhere(self):
+        aTable = self._digest_catalog_table('pg_class')
+        self.db_connection.query.return_value.getresult.return_value = [(-1, 5, 'abc'), (0, 5, 'abc'), (1, 5, 'abc')]
+
+        self.assertTrue(self.subject.catalogDigestMatches(aTable))
+        self.assertTrue(self.subject.GV.catalogDigestMatches['pg_class'])
+
+    def test_catalogDigestMatches__different_digest(self):
+        aTable = self._digest_catalog_table('pg_class')
+        self.db_connection.query.return_value.getresult.return_value = [(-1, 5, 'abc'), (0, 5, 'abd'), (1, 5, 'abc')]
+
+        self.assertFalse(self.subject.catalogDigestMatches(aTable))
+
+    def test_catalogDigestMatches__segment_without_rows(self):
+        aTable = self._digest_catalog_table('pg_class')
+        self.db_connection.query.return_value.getresult.return_value = [(-1, 5, 'abc'), (1, 5, 'abc')]
+
+        self.assertFalse(self.subject.catalogDigestMatches(aTable))
+
+    def test_catalogDigestMatches__empty_everywhere(self):
+        aTable = self._digest_catalog_table('pg_class')
+        self.db_connection.query.return_value.getresult.return_value = [(-1, 0, '0' * 32)]
+
+        self.assertTrue(self.subject.catalogDigestMatches(aTable))
+
+    def test_catalogDigestMatches__query_error_runs_full_check(self):
+        aTable = self._digest_catalog_table('pg_class')
+        self.db_connection.query.side_effect = Exception('function gp_unordered_md5(text) does not exist')
+
+        self.assertFalse(self.subject.catalogDigestMatches(aTable))
+
+    def test_checkTableInconsistentEntry__skipped_when_digests_match(self):
+        aTable = self._digest_catalog_table('pg_class')
+        aTable.isMasterOnly.return_value = False
+        aTable.isShared.return_value = False
+        self.subject.GV.opt['-S'] = None
+        self.subject.GV.catalogDigestMatches = {'pg_class': True}
+
+        self.subject.checkTableInconsistentEntry(aTable)
+
+        self.db_connection.query.assert_not_called()
+        self.subject.logger.info.assert_called_with('[OK] Checking for inconsistent entries for pg_class')
+
     def test_getReportConfiguration_uses_contentid(self):
         report_cfg = self.subject.getReportConfiguration()
         self.assertEqual("content -1", report_cfg[-1]['segname'])
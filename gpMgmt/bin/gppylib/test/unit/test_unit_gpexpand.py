@@ -1,3 +1,4 @@
+import datetime
 import os
 import imp
 
@@ -112,6 +113,41 @@ class GpExpand(GpTestCase):
         self.subject.logger.error.assert_called_with("gpexpand failed: Invalid input file: No expansion "
                                                                   "segments defined \n\nExiting...")
 
+    def test_wait_for_admission_queue_does_nothing_without_max_queued(self):
+        conn = Mock()
+        self.options.max_queued = None
+
+        self.subject.wait_for_admission_queue(conn, self.options)
+
+        self.assertFalse(conn.commit.called)
+
+    @patch('gpexpand.sleep')
+    def test_wait_for_admission_queue_waits_while_queries_are_queued(self, mock_sleep):
+        conn = Mock()
+        self.options.max_queued = 1
+        busy = Mock()
+        busy.fetchone.return_value = (3,)
+        quiet = Mock()
+        quiet.fetchone.return_value = (1,)
+
+        with patch('gpexpand.dbconn.execSQL', side_effect=[busy, busy, quiet]):
+            self.subject.wait_for_admission_queue(conn, self.options)
+
+        self.assertEqual(mock_sleep.call_count, 2)
+
+    @patch('gpexpand.sleep')
+    def test_wait_for_admission_queue_stops_waiting_at_end_time(self, mock_sleep):
+        conn = Mock()
+        self.options.max_queued = 0
+        self.options.end = datetime.datetime.now() - datetime.timedelta(seconds=1)
+        busy = Mock()
+        busy.fetchone.return_value = (3,)
+
+        with patch('gpexpand.dbconn.execSQL', return_value=busy):
+            self.subject.wait_for_admission_queue(conn, self.options)
+
+        self.assertFalse(mock_sleep.called)
+
     def createGpArrayWith2Primary2Mirrors(self):
         self.master = GpDB.initFromString(
             "1|-1|p|p|s|u|mdw|mdw|5432|None|/data/master||/data/master/base/10899,/data/master/base/1,/data/master/base/10898,/data/master/base/25780,/data/master/base/34782")
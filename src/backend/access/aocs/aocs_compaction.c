@@ -20,6 +20,7 @@
 #include "access/aomd.h"
 #include "access/aocs_compaction.h"
 #include "access/appendonly_compaction.h"
+#include "access/tuptoaster.h"
 #include "catalog/catalog.h"
 #include "catalog/indexing.h"
 #include "catalog/pg_appendonly_fn.h"
@@ -82,6 +83,8 @@ AOCSCompaction_DropSegmentFile(Relation aorel,
 		DeleteGpRelationNodeTuple(aorel,
 								  pseudoSegNo);
 	}
+
+	AppendOnlyBlockDirectory_InvalidateCache(aorel, segno);
 }
 
 /*
@@ -273,6 +276,37 @@ AOCSMoveTuple(TupleTableSlot *slot,
 		   AOTupleIdGet_segmentFileNum(&newAoTupleId), AOTupleIdGet_rowNum(&newAoTupleId));
 }
 
+/*
+ * Drops a row that is no longer visible. The values it stored out of line
+ * belong to it alone, so they are deleted from the TOAST relation.
+ */
+static void
+AOCSThrowAwayTuple(Relation aorel, TupleTableSlot *slot)
+{
+	TupleDesc	tupDesc = RelationGetDescr(aorel);
+	AOTupleId  *oldAoTupleId;
+	Datum	   *values;
+	bool	   *isnull;
+	int			i;
+
+	oldAoTupleId = (AOTupleId *) slot_get_ctid(slot);
+	/* Extract all the values of the tuple */
+	slot_getallattrs(slot);
+	values = slot_get_values(slot);
+	isnull = slot_get_isnull(slot);
+
+	for (i = 0; i < tupDesc->natts; i++)
+	{
+		if (tupDesc->attrs[i]->attlen == -1 && !isnull[i] &&
+			VARATT_IS_EXTERNAL(DatumGetPointer(values[i])))
+			toast_delete_datum(aorel, values[i]);
+	}
+
+	elogif(Debug_appendonly_print_compaction, DEBUG5,
+		   "Compaction: Throw away tuple (%d," INT64_FORMAT ")",
+		   AOTupleIdGet_segmentFileNum(oldAoTupleId), AOTupleIdGet_rowNum(oldAoTupleId));
+}
+
 /*
  * Assumes that the segment file lock is already held.
  * Assumes that the segment file should be compacted.
@@ -290,7 +324,6 @@ AOCSSegmentFileFullCompaction(Relation aorel,
 	int			compact_segno;
 	int64		movedTupleCount = 0;
 	ResultRelInfo *resultRelInfo;
-	MemTupleBinding *mt_bind;
 	EState	   *estate;
 	bool	   *proj;
 	int			i;
@@ -330,7 +363,6 @@ AOCSSegmentFileFullCompaction(Relation aorel,
 
 	tupDesc = RelationGetDescr(aorel);
 	slot = MakeSingleTupleTableSlot(tupDesc);
-	mt_bind = create_memtuple_binding(tupDesc);
 
 	/*
 	 * We need a ResultRelInfo and an EState so we can use the regular
@@ -363,13 +395,8 @@ AOCSSegmentFileFullCompaction(Relation aorel,
 		}
 		else
 		{
-			MemTuple	tuple = TupGetMemTuple(slot);
-
 			/* Tuple is invisible and needs to be dropped */
-			AppendOnlyThrowAwayTuple(aorel,
-									 tuple,
-									 slot,
-									 mt_bind);
+			AOCSThrowAwayTuple(aorel, slot);
 		}
 
 		/*
@@ -411,7 +438,6 @@ AOCSSegmentFileFullCompaction(Relation aorel,
 	FreeExecutorState(estate);
 
 	ExecDropSingleTupleTableSlot(slot);
-	destroy_memtuple_binding(mt_bind);
 
 	aocs_endscan(scanDesc);
 	pfree(proj);
@@ -540,6 +566,14 @@ AOCSCompact(Relation aorel,
 	if (insert_segno >= 0)
 	{
 		insertDesc = aocs_insert_init(aorel, insert_segno, false);
+
+		/*
+		 * The moved rows keep their values where they are: those stored out
+		 * of line only have their pointers copied, and inline ones are not
+		 * moved out whatever gp_appendonly_toast_threshold says now.
+		 */
+		insertDesc->keepToastPointers = true;
+		insertDesc->toast_threshold = 0;
 	}
 
 	for (i = 0; i < total_segfiles; i++)
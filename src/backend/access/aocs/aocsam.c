@@ -38,8 +38,10 @@
 #include "cdb/cdbappendonlystorageread.h"
 #include "cdb/cdbappendonlystoragewrite.h"
 #include "cdb/cdbvars.h"
+#include "codegen/codegen_wrapper.h"
 #include "fmgr.h"
 #include "miscadmin.h"
+#include "nodes/execnodes.h"
 #include "pgstat.h"
 #include "storage/freespace.h"
 #include "storage/procarray.h"
@@ -275,6 +277,160 @@ aocs_initscan(AOCSScanDesc scan)
 	pgstat_count_heap_scan(scan->aos_rel);
 }
 
+static int
+skip_range_cmp(const void *a, const void *b)
+{
+	const AOCSSkipRange *ra = (const AOCSSkipRange *) a;
+	const AOCSSkipRange *rb = (const AOCSSkipRange *) b;
+
+	if (ra->firstRowNum < rb->firstRowNum)
+		return -1;
+	if (ra->firstRowNum > rb->firstRowNum)
+		return 1;
+	return 0;
+}
+
+/*
+ * Work out which rows of a segment file the zone quals rule out.
+ *
+ * Each qual is checked against the zone maps of its column; an entry whose
+ * zone excludes the qual contributes its row range.  The ranges are then
+ * sorted and merged so that aocs_getnext() can walk them in step with the
+ * scan.
+ */
+static void
+build_skip_ranges(AOCSScanDesc scan, AOCSFileSegInfo *segInfo)
+{
+	int			maxRanges = 0;
+	int			n = 0;
+	int			q;
+	int			i;
+
+	if (scan->skipRanges)
+	{
+		pfree(scan->skipRanges);
+		scan->skipRanges = NULL;
+	}
+	scan->numSkipRanges = 0;
+	scan->curSkipRange = 0;
+
+	if (scan->numZoneQuals == 0 || scan->blockDirectory)
+		return;
+
+	for (q = 0; q < scan->numZoneQuals; q++)
+	{
+		AppendOnlyZoneQual *qual = &scan->zoneQuals[q];
+		AOCSVPInfoEntry *e = getAOCSVPEntry(segInfo, qual->attno);
+		AppendOnlyBlockDirectoryZone *zones;
+		int			numZones;
+
+		zones = AppendOnlyBlockDirectory_GetZones(scan->aos_rel,
+												  scan->appendOnlyMetaDataSnapshot,
+												  segInfo->segno,
+												  qual->attno,
+												  e->eof,
+												  &numZones);
+		for (i = 0; i < numZones; i++)
+		{
+			if (!AppendOnlyBlockDirectory_ZoneExcludes(&zones[i].zone, qual))
+				continue;
+
+			if (n >= maxRanges)
+			{
+				maxRanges = (maxRanges == 0) ? 64 : maxRanges * 2;
+				if (scan->skipRanges == NULL)
+					scan->skipRanges = palloc(maxRanges * sizeof(AOCSSkipRange));
+				else
+					scan->skipRanges = repalloc(scan->skipRanges,
+												maxRanges * sizeof(AOCSSkipRange));
+			}
+			scan->skipRanges[n].firstRowNum = zones[i].firstRowNum;
+			scan->skipRanges[n].lastRowNum =
+				zones[i].firstRowNum + zones[i].rowCount - 1;
+			n++;
+		}
+
+		if (zones)
+			pfree(zones);
+	}
+
+	if (n == 0)
+		return;
+
+	qsort(scan->skipRanges, n, sizeof(AOCSSkipRange), skip_range_cmp);
+
+	/* Merge overlapping and adjacent ranges. */
+	scan->numSkipRanges = 1;
+	for (i = 1; i < n; i++)
+	{
+		AOCSSkipRange *last = &scan->skipRanges[scan->numSkipRanges - 1];
+
+		if (scan->skipRanges[i].firstRowNum <= last->lastRowNum + 1)
+		{
+			if (scan->skipRanges[i].lastRowNum > last->lastRowNum)
+				last->lastRowNum = scan->skipRanges[i].lastRowNum;
+		}
+		else
+			scan->skipRanges[scan->numSkipRanges++] = scan->skipRanges[i];
+	}
+}
+
+/*
+ * Give the scan quals to check against the block directory zone maps.
+ *
+ * The quals must hold for every row the scan returns, but the caller still
+ * evaluates them: skipping is only done a block at a time.  Must be called
+ * before the first aocs_getnext().
+ */
+void
+aocs_set_zone_quals(AOCSScanDesc scan, AppendOnlyZoneQual *quals, int numQuals)
+{
+	Assert(scan->cur_seg < 0);
+
+	if (numQuals == 0)
+		return;
+
+	scan->zoneQuals = palloc(numQuals * sizeof(AppendOnlyZoneQual));
+	memcpy(scan->zoneQuals, quals, numQuals * sizeof(AppendOnlyZoneQual));
+	scan->numZoneQuals = numQuals;
+}
+
+/*
+ * Ask the scan to read some of its projected columns late.
+ *
+ * lazy[attno] marks the columns that are only read for the rows the caller
+ * keeps: aocs_getnext_batch() leaves them out, and aocs_batch_store_row()
+ * reads them for the row it stores, skipping over the blocks of the rows in
+ * between without decompressing them.  The other projected columns are
+ * read for every row.  Must be called before the first row is read.
+ */
+void
+aocs_set_lazy_columns(AOCSScanDesc scan, bool *lazy)
+{
+	int			i;
+
+	Assert(scan->cur_seg < 0);
+	Assert(scan->lazy_atts == NULL);
+
+	scan->lazy_atts = palloc(scan->num_proj_atts * sizeof(int));
+	scan->eager_atts = palloc(scan->num_proj_atts * sizeof(int));
+	scan->num_lazy_atts = 0;
+	scan->num_eager_atts = 0;
+	for (i = 0; i < scan->num_proj_atts; i++)
+	{
+		int			attno = scan->proj_atts[i];
+
+		if (lazy[attno])
+			scan->lazy_atts[scan->num_lazy_atts++] = attno;
+		else
+			scan->eager_atts[scan->num_eager_atts++] = attno;
+	}
+
+	/* With nothing read eagerly, there would be nothing to go by. */
+	if (scan->num_eager_atts == 0)
+		scan->num_lazy_atts = 0;
+}
+
 static int
 open_next_scan_seg(AOCSScanDesc scan)
 {
@@ -338,6 +494,8 @@ open_next_scan_seg(AOCSScanDesc scan)
 															curSegInfo->segno,
 															nvp,
 															true);
+					/* The scan feeds the zones after reading each block. */
+					scan->blockDirectory->zoneFeedAfterInsert = true;
 
 					InsertFastSequenceEntry(scan->aos_rel->rd_appendonly->segrelid,
 											curSegInfo->segno,
@@ -351,6 +509,21 @@ open_next_scan_seg(AOCSScanDesc scan)
 												  scan->num_proj_atts,
 												  scan->blockDirectory);
 
+				build_skip_ranges(scan, curSegInfo);
+
+				/* Start out reading only the eager columns, if asked to. */
+				scan->segLazy = (scan->num_lazy_atts > 0);
+				if (scan->segLazy)
+				{
+					scan->read_atts = scan->eager_atts;
+					scan->num_read_atts = scan->num_eager_atts;
+				}
+				else
+				{
+					scan->read_atts = scan->proj_atts;
+					scan->num_read_atts = scan->num_proj_atts;
+				}
+
 				return scan->cur_seg;
 			}
 		}
@@ -493,6 +666,9 @@ aocs_beginscan_internal(Relation relation,
 			scan->proj_atts[scan->num_proj_atts++] = i;
 	}
 
+	scan->read_atts = scan->proj_atts;
+	scan->num_read_atts = scan->num_proj_atts;
+
 	scan->ds = (DatumStreamRead **) palloc0(sizeof(DatumStreamRead *) * nvp);
 
 	aocs_initscan(scan);
@@ -529,6 +705,16 @@ aocs_endscan(AOCSScanDesc scan)
 	pfree(scan->proj_atts);
 	pfree(scan->ds);
 
+	if (scan->lazy_atts)
+	{
+		pfree(scan->lazy_atts);
+		pfree(scan->eager_atts);
+	}
+	if (scan->zoneQuals)
+		pfree(scan->zoneQuals);
+	if (scan->skipRanges)
+		pfree(scan->skipRanges);
+
 	for (i = 0; i < scan->total_seg; ++i)
 	{
 		if (scan->seginfo[i])
@@ -545,23 +731,49 @@ aocs_endscan(AOCSScanDesc scan)
 	pfree(scan);
 }
 
-void
-aocs_getnext(AOCSScanDesc scan, ScanDirection direction, TupleTableSlot *slot)
+/*
+ * Read the lazy columns of the given row.  Their streams are only ever
+ * moved forward, so rows must be asked for in order.
+ */
+static void
+fetch_lazy_columns(AOCSScanDesc scan, int64 rowNum, Datum *d, bool *null)
+{
+	int			i;
+
+	for (i = 0; i < scan->num_lazy_atts; i++)
+	{
+		int			attno = scan->lazy_atts[i];
+		DatumStreamRead *ds = scan->ds[attno];
+		int			err;
+
+		if (datumstreamread_skip_to_row(ds, rowNum) < 0)
+			elog(ERROR, "could not find row " INT64_FORMAT " in column %d of segment file %d of relation \"%s\"",
+				 rowNum, attno + 1, scan->seginfo[scan->cur_seg]->segno,
+				 RelationGetRelationName(scan->aos_rel));
+
+		err = datumstreamread_advance(ds);
+		Assert(err > 0);
+		(void) err;
+		Assert(ds->blockFirstRowNum + datumstreamread_nth(ds) == rowNum);
+
+		datumstreamread_get(ds, &d[attno], &null[attno]);
+	}
+}
+
+/*
+ * Read the next visible row of the scan.  The values of the projected
+ * columns are stored in d and null, indexed by attribute number.  Returns
+ * false at the end of the scan.
+ */
+static bool
+aocs_read_next_row(AOCSScanDesc scan, Datum *d, bool *null,
+				   AOTupleId *aoTupleId)
 {
-	int			ncol;
-	Datum	   *d = slot_get_values(slot);
-	bool	   *null = slot_get_isnull(slot);
-	AOTupleId	aoTupleId;
 	int64		rowNum = INT64CONST(-1);
 	int			err = 0;
 	int			i;
 	bool		isSnapshotAny = (scan->snapshot == SnapshotAny);
 
-	Assert(ScanDirectionIsForward(direction));
-
-	ncol = slot->tts_tupleDescriptor->natts;
-	Assert(ncol <= scan->relationTupleDesc->natts);
-
 	while (1)
 	{
 ReadNext:
@@ -572,9 +784,8 @@ ReadNext:
 			if (err < 0)
 			{
 				/* No more seg, we are at the end */
-				ExecClearTuple(slot);
 				scan->cur_seg = -1;
-				return;
+				return false;
 			}
 			scan->cur_seg_row = 0;
 		}
@@ -582,9 +793,9 @@ ReadNext:
 		Assert(scan->cur_seg >= 0);
 
 		/* Read from cur_seg */
-		for (i = 0; i < scan->num_proj_atts; i++)
+		for (i = 0; i < scan->num_read_atts; i++)
 		{
-			int			attno = scan->proj_atts[i];
+			int			attno = scan->read_atts[i];
 
 			err = datumstreamread_advance(scan->ds[attno]);
 			Assert(err >= 0);
@@ -610,6 +821,11 @@ ReadNext:
 			 */
 			datumstreamread_get(scan->ds[attno], &d[attno], &null[attno]);
 
+			if (scan->blockDirectory)
+				AppendOnlyBlockDirectory_AddZoneValue(scan->blockDirectory,
+													  attno, d[attno],
+													  null[attno]);
+
 			if (rowNum == INT64CONST(-1) &&
 				scan->ds[attno]->blockFirstRowNum != INT64CONST(-1))
 			{
@@ -619,34 +835,445 @@ ReadNext:
 			}
 		}
 
-		AOTupleIdInit_Init(&aoTupleId);
-		AOTupleIdInit_segmentFileNum(&aoTupleId,
+		/*
+		 * If the zone maps rule out the rows from here on, skip the blocks
+		 * that hold them in every column we read, without decompressing
+		 * them.
+		 */
+		if (scan->numSkipRanges > 0 && rowNum != INT64CONST(-1))
+		{
+			while (scan->curSkipRange < scan->numSkipRanges &&
+				   scan->skipRanges[scan->curSkipRange].lastRowNum < rowNum)
+				scan->curSkipRange++;
+
+			if (scan->curSkipRange < scan->numSkipRanges &&
+				scan->skipRanges[scan->curSkipRange].firstRowNum <= rowNum)
+			{
+				int64		targetRowNum =
+				scan->skipRanges[scan->curSkipRange].lastRowNum + 1;
+
+				for (i = 0; i < scan->num_read_atts; i++)
+				{
+					if (datumstreamread_skip_to_row(scan->ds[scan->read_atts[i]],
+													targetRowNum) < 0)
+					{
+						close_cur_scan_seg(scan);
+						err = -1;
+						rowNum = INT64CONST(-1);
+						goto ReadNext;
+					}
+				}
+				rowNum = INT64CONST(-1);
+				goto ReadNext;
+			}
+		}
+
+		/*
+		 * The lazy columns are found by row number, which blocks written
+		 * before 4.0 don't have.  Those only ever come first in a segment
+		 * file, so if the first row has no row number, read every column of
+		 * this segment file for every row instead.
+		 */
+		if (scan->segLazy && rowNum == INT64CONST(-1))
+		{
+			if (scan->cur_seg_row != 0)
+				elog(ERROR, "block without row numbers in the middle of segment file %d of relation \"%s\"",
+					 scan->seginfo[scan->cur_seg]->segno,
+					 RelationGetRelationName(scan->aos_rel));
+
+			for (i = 0; i < scan->num_lazy_atts; i++)
+			{
+				int			attno = scan->lazy_atts[i];
+
+				err = datumstreamread_advance(scan->ds[attno]);
+				Assert(err == 0);
+				err = datumstreamread_block(scan->ds[attno], NULL, attno);
+				if (err < 0)
+					elog(ERROR, "column %d of segment file %d of relation \"%s\" has fewer rows than expected",
+						 attno + 1, scan->seginfo[scan->cur_seg]->segno,
+						 RelationGetRelationName(scan->aos_rel));
+				err = datumstreamread_advance(scan->ds[attno]);
+				Assert(err > 0);
+				datumstreamread_get(scan->ds[attno], &d[attno], &null[attno]);
+			}
+
+			scan->read_atts = scan->proj_atts;
+			scan->num_read_atts = scan->num_proj_atts;
+			scan->segLazy = false;
+		}
+
+		AOTupleIdInit_Init(aoTupleId);
+		AOTupleIdInit_segmentFileNum(aoTupleId,
 									 scan->seginfo[scan->cur_seg]->segno);
 
 		scan->cur_seg_row++;
 		if (rowNum == INT64CONST(-1))
 		{
-			AOTupleIdInit_rowNum(&aoTupleId, scan->cur_seg_row);
+			AOTupleIdInit_rowNum(aoTupleId, scan->cur_seg_row);
 		}
 		else
 		{
-			AOTupleIdInit_rowNum(&aoTupleId, rowNum);
+			AOTupleIdInit_rowNum(aoTupleId, rowNum);
 		}
 
-		if (!isSnapshotAny && !AppendOnlyVisimap_IsVisible(&scan->visibilityMap, &aoTupleId))
+		if (!isSnapshotAny && !AppendOnlyVisimap_IsVisible(&scan->visibilityMap, aoTupleId))
 		{
 			rowNum = INT64CONST(-1);
 			goto ReadNext;
 		}
-		scan->cdb_fake_ctid = *((ItemPointer) &aoTupleId);
+		return true;
+	}
+
+	Assert(!"Never here");
+	return false;
+}
+
+void
+aocs_getnext(AOCSScanDesc scan, ScanDirection direction, TupleTableSlot *slot)
+{
+	int			ncol;
+	AOTupleId	aoTupleId;
+
+	Assert(ScanDirectionIsForward(direction));
 
-		TupSetVirtualTupleNValid(slot, ncol);
-		slot_set_ctid(slot, &(scan->cdb_fake_ctid));
+	ncol = slot->tts_tupleDescriptor->natts;
+	Assert(ncol <= scan->relationTupleDesc->natts);
+
+	if (!aocs_read_next_row(scan, slot_get_values(slot), slot_get_isnull(slot),
+							&aoTupleId))
+	{
+		ExecClearTuple(slot);
 		return;
 	}
 
-	Assert(!"Never here");
-	return;
+	if (scan->segLazy)
+		fetch_lazy_columns(scan, AOTupleIdGet_rowNum(&aoTupleId),
+						   slot_get_values(slot), slot_get_isnull(slot));
+
+	scan->cdb_fake_ctid = *((ItemPointer) &aoTupleId);
+
+	TupSetVirtualTupleNValid(slot, ncol);
+	slot_set_ctid(slot, &(scan->cdb_fake_ctid));
+}
+
+/*
+ * aocs_create_batch
+ *
+ * Allocate a batch of up to maxRows rows for aocs_getnext_batch().
+ */
+AOCSBatch
+aocs_create_batch(AOCSScanDesc scan, int maxRows)
+{
+	AOCSBatch	batch;
+	int			nvp = scan->relationTupleDesc->natts;
+	int			i;
+
+	Assert(maxRows > 0);
+
+	batch = (AOCSBatch) palloc0(sizeof(AOCSBatchData));
+	batch->maxRows = maxRows;
+	batch->values = (Datum **) palloc0(nvp * sizeof(Datum *));
+	batch->isnull = (bool **) palloc0(nvp * sizeof(bool *));
+	batch->tids = (AOTupleId *) palloc(maxRows * sizeof(AOTupleId));
+	batch->selected = (int *) palloc(maxRows * sizeof(int));
+	batch->visible = (bool *) palloc(maxRows * sizeof(bool));
+	batch->rowValues = (Datum *) palloc(nvp * sizeof(Datum));
+	batch->rowIsnull = (bool *) palloc(nvp * sizeof(bool));
+	batch->codes = (int32 **) palloc0(nvp * sizeof(int32 *));
+	batch->dictCount = (int32 *) palloc0(nvp * sizeof(int32));
+
+	for (i = 0; i < scan->num_proj_atts; i++)
+	{
+		int			attno = scan->proj_atts[i];
+
+		batch->values[attno] = (Datum *) palloc(maxRows * sizeof(Datum));
+		batch->isnull[attno] = (bool *) palloc(maxRows * sizeof(bool));
+		batch->codes[attno] = (int32 *) palloc(maxRows * sizeof(int32));
+	}
+
+	return batch;
+}
+
+void
+aocs_free_batch(AOCSScanDesc scan, AOCSBatch batch)
+{
+	int			i;
+
+	for (i = 0; i < scan->num_proj_atts; i++)
+	{
+		int			attno = scan->proj_atts[i];
+
+		pfree(batch->values[attno]);
+		pfree(batch->isnull[attno]);
+		pfree(batch->codes[attno]);
+	}
+	pfree(batch->values);
+	pfree(batch->isnull);
+	pfree(batch->codes);
+	pfree(batch->dictCount);
+	pfree(batch->tids);
+	pfree(batch->selected);
+	pfree(batch->visible);
+	pfree(batch->rowValues);
+	pfree(batch->rowIsnull);
+	pfree(batch);
+}
+
+/*
+ * Read the next nrows rows of column attno into rows 1 to nrows of the batch.
+ *
+ * The caller made sure the rows are in the current block of the column.
+ * Blocks of datums passed by value are decoded a batch at a time, by a
+ * function codegen specializes on the datum length when it is enabled.
+ */
+static void
+aocs_read_column_batch(AOCSScanDesc scan, AOCSBatch batch, int attno,
+					   int nrows)
+{
+	DatumStreamRead *ds = scan->ds[attno];
+	Datum	   *values = &batch->values[attno][1];
+	bool	   *isnull = &batch->isnull[attno][1];
+	int			k;
+
+	if (ds->largeObjectState != DatumStreamLargeObjectState_None ||
+		batch->dictCount[attno] > 0)
+	{
+		for (k = 0; k < nrows; k++)
+		{
+			int			err;
+
+			err = datumstreamread_advance(ds);
+			Assert(err > 0);
+			(void) err;
+
+			datumstreamread_get(ds, &values[k], &isnull[k]);
+			if (batch->dictCount[attno] > 0)
+				batch->codes[attno][k + 1] = datumstreamread_dictionary_code(ds);
+		}
+	}
+	else
+	{
+		DatumStreamBlockRead *dsr = &ds->blockRead;
+		int			idx = -1;
+
+		if (dsr->typeInfo.byval)
+		{
+			switch (dsr->typeInfo.datumlen)
+			{
+				case 1:
+					idx = 0;
+					break;
+				case 2:
+					idx = 1;
+					break;
+				case 4:
+					idx = 2;
+					break;
+				case 8:
+					idx = 3;
+					break;
+			}
+		}
+
+		if (batch->getBatchGenInfo != NULL && idx >= 0)
+			call_DatumStreamBlockReadGetBatch(batch->getBatchGenInfo[idx],
+											  dsr, nrows, values, isnull);
+		else
+			DatumStreamBlockRead_GetBatch(dsr, nrows, values, isnull);
+	}
+
+	if (scan->blockDirectory)
+	{
+		for (k = 0; k < nrows; k++)
+			AppendOnlyBlockDirectory_AddZoneValue(scan->blockDirectory,
+												  attno,
+												  values[k],
+												  isnull[k]);
+	}
+}
+
+/*
+ * aocs_getnext_batch
+ *
+ * Read the next batch of rows, column by column.  Returns the number of rows
+ * read, 0 at the end of the scan.  Rows the visimap hides are left out of
+ * selected[].
+ *
+ * The first row is read as aocs_getnext() would, opening segment files and
+ * reading blocks as needed.  The rest are the rows that follow it in the
+ * current block of every projected column, so they are read with no block
+ * boundary checks, one column at a time.  The batch also stops short of
+ * the next range the zone maps skip.
+ */
+int
+aocs_getnext_batch(AOCSScanDesc scan, ScanDirection direction, AOCSBatch batch)
+{
+	AOTupleId	aoTupleId;
+	int32		segno;
+	int			limit;
+	int			n;
+	int			k;
+	int			i;
+	bool		isSnapshotAny = (scan->snapshot == SnapshotAny);
+
+	Assert(ScanDirectionIsForward(direction));
+
+	batch->nrows = 0;
+	batch->nselected = 0;
+	batch->nextRow = 0;
+
+	if (!aocs_read_next_row(scan, batch->rowValues, batch->rowIsnull,
+							&aoTupleId))
+		return 0;
+
+	for (i = 0; i < scan->num_read_atts; i++)
+	{
+		int			attno = scan->read_atts[i];
+
+		batch->values[attno][0] = batch->rowValues[attno];
+		batch->isnull[attno][0] = batch->rowIsnull[attno];
+		batch->dictCount[attno] = datumstreamread_dictionary_count(scan->ds[attno]);
+		if (batch->dictCount[attno] > 0)
+			batch->codes[attno][0] = datumstreamread_dictionary_code(scan->ds[attno]);
+	}
+	batch->tids[0] = aoTupleId;
+	n = 1;
+	batch->lazy = scan->segLazy;
+
+	if (scan->num_read_atts == 0)
+	{
+		batch->nrows = n;
+		batch->nselected = n;
+		batch->selected[0] = 0;
+		return n;
+	}
+
+	limit = batch->maxRows;
+	for (i = 0; i < scan->num_read_atts; i++)
+	{
+		int			left = datumstreamread_rows_left(scan->ds[scan->read_atts[i]]) + 1;
+
+		if (left < limit)
+			limit = left;
+	}
+	if (scan->curSkipRange < scan->numSkipRanges)
+	{
+		int64		gap = scan->skipRanges[scan->curSkipRange].firstRowNum -
+		AOTupleIdGet_rowNum(&aoTupleId);
+
+		if (gap < limit)
+			limit = (int) gap;
+	}
+
+	segno = scan->seginfo[scan->cur_seg]->segno;
+	if (limit > 1)
+	{
+		int64		rowNum = INT64CONST(-1);
+
+		/*
+		 * Row k of the batch is k rows after the first one in the block of
+		 * every column.
+		 */
+		for (i = 0; i < scan->num_read_atts; i++)
+		{
+			DatumStreamRead *ds = scan->ds[scan->read_atts[i]];
+
+			if (ds->blockFirstRowNum != INT64CONST(-1))
+			{
+				rowNum = ds->blockFirstRowNum + datumstreamread_nth(ds);
+				break;
+			}
+		}
+
+		for (i = 0; i < scan->num_read_atts; i++)
+			aocs_read_column_batch(scan, batch, scan->read_atts[i], limit - 1);
+
+		for (k = 1; k < limit; k++)
+		{
+			AOTupleId  *tid = &batch->tids[k];
+
+			AOTupleIdInit_Init(tid);
+			AOTupleIdInit_segmentFileNum(tid, segno);
+
+			scan->cur_seg_row++;
+			if (rowNum == INT64CONST(-1))
+				AOTupleIdInit_rowNum(tid, scan->cur_seg_row);
+			else
+				AOTupleIdInit_rowNum(tid, rowNum + k);
+		}
+		n = limit;
+	}
+
+	batch->nrows = n;
+
+	/*
+	 * The rows after the first are consecutive rows of one segment file, so
+	 * their visibility is found with one visimap lookup.  The first row was
+	 * checked when it was read.
+	 */
+	memset(batch->visible, true, n * sizeof(bool));
+	if (!isSnapshotAny && n > 1)
+	{
+		Assert(AOTupleIdGet_rowNum(&batch->tids[n - 1]) ==
+			   AOTupleIdGet_rowNum(&batch->tids[1]) + n - 2);
+
+		if (!AppendOnlyVisimap_GetVisibility(&scan->visibilityMap,
+											 segno,
+											 AOTupleIdGet_rowNum(&batch->tids[1]),
+											 n - 1,
+											 &batch->visible[1]))
+		{
+			int			nselected = 0;
+
+			for (k = 0; k < n; k++)
+			{
+				if (batch->visible[k])
+					batch->selected[nselected++] = k;
+			}
+			batch->nselected = nselected;
+			return n;
+		}
+	}
+
+	for (k = 0; k < n; k++)
+		batch->selected[k] = k;
+	batch->nselected = n;
+	return n;
+}
+
+/*
+ * aocs_batch_store_row
+ *
+ * Store one row of a batch in a virtual tuple slot.
+ */
+void
+aocs_batch_store_row(AOCSScanDesc scan, AOCSBatch batch, int row,
+					 bool withLazyColumns, TupleTableSlot *slot)
+{
+	Datum	   *d = slot_get_values(slot);
+	bool	   *null = slot_get_isnull(slot);
+	int			ncol = slot->tts_tupleDescriptor->natts;
+	int			i;
+
+	Assert(row < batch->nrows);
+	Assert(ncol <= scan->relationTupleDesc->natts);
+
+	for (i = 0; i < scan->num_read_atts; i++)
+	{
+		int			attno = scan->read_atts[i];
+
+		d[attno] = batch->values[attno][row];
+		null[attno] = batch->isnull[attno][row];
+	}
+
+	if (batch->lazy && withLazyColumns)
+		fetch_lazy_columns(scan, AOTupleIdGet_rowNum(&batch->tids[row]),
+						   d, null);
+
+	scan->cdb_fake_ctid = *((ItemPointer) &batch->tids[row]);
+
+	TupSetVirtualTupleNValid(slot, ncol);
+	slot_set_ctid(slot, &(scan->cdb_fake_ctid));
 }
 
 
@@ -797,6 +1424,10 @@ aocs_insert_init(Relation rel, int segno, bool update_mode)
 	desc->compType = NameStr(rel->rd_appendonly->compresstype);
 	desc->blocksz = rel->rd_appendonly->blocksize;
 
+	if (OidIsValid(rel->rd_rel->reltoastrelid))
+		desc->toast_threshold = gp_appendonly_toast_threshold * 1024;
+	desc->keepToastPointers = false;
+
 	OpenAOCSDatumStreams(desc);
 
 	/*
@@ -836,6 +1467,74 @@ aocs_insert_init(Relation rel, int segno, bool update_mode)
 }
 
 
+/*
+ * Prepare a varlena value to be written to a column file.
+ *
+ * The column files only hold toast pointers into the table's own TOAST
+ * relation. A value stored out of line elsewhere is fetched, and so is one
+ * of our own unless keepToastPointers says that the row being inserted owns
+ * it. An inline value larger than threshold bytes is compressed, if its
+ * storage allows, and saved to the TOAST relation instead. A threshold of 0
+ * keeps every value inline.
+ *
+ * Returns the datum to write. *toFree is set to a palloc'd copy to release
+ * once the datum has been written, or NULL.
+ */
+static Datum
+aocs_toast_value(Relation rel, Form_pg_attribute attr, int32 threshold,
+				 bool keepToastPointers, Datum value, void **toFree)
+{
+	struct varlena *v = (struct varlena *) DatumGetPointer(value);
+	struct varlena *copy = NULL;
+	Datum		result;
+
+	Assert(attr->attlen == -1);
+
+	*toFree = NULL;
+
+	if (VARATT_IS_EXTERNAL(v))
+	{
+		struct varatt_external toast_pointer;
+
+		memcpy(&toast_pointer, VARDATA_EXTERNAL(v), sizeof(toast_pointer));
+		if (keepToastPointers &&
+			toast_pointer.va_toastrelid == rel->rd_rel->reltoastrelid)
+			return value;
+
+		copy = heap_tuple_fetch_attr(v);
+		v = copy;
+	}
+
+	if (threshold == 0 || VARSIZE_ANY(v) <= threshold ||
+		(attr->attstorage != 'x' && attr->attstorage != 'e'))
+	{
+		*toFree = copy;
+		return PointerGetDatum(v);
+	}
+
+	Assert(OidIsValid(rel->rd_rel->reltoastrelid));
+
+	if (attr->attstorage == 'x' && !VARATT_IS_COMPRESSED(v))
+	{
+		Datum		compressed = toast_compress_datum(PointerGetDatum(v));
+
+		if (DatumGetPointer(compressed) != NULL)
+		{
+			if (copy != NULL)
+				pfree(copy);
+			copy = (struct varlena *) DatumGetPointer(compressed);
+			v = copy;
+		}
+	}
+
+	result = toast_save_datum(rel, PointerGetDatum(v), false, true, true);
+	if (copy != NULL)
+		pfree(copy);
+
+	*toFree = DatumGetPointer(result);
+	return result;
+}
+
 Oid
 aocs_insert_values(AOCSInsertDesc idesc, Datum *d, bool *null, AOTupleId *aoTupleId)
 {
@@ -858,9 +1557,19 @@ aocs_insert_values(AOCSInsertDesc idesc, Datum *d, bool *null, AOTupleId *aoTupl
 	/* As usual, at this moment, we assume one col per vp */
 	for (i = 0; i < RelationGetNumberOfAttributes(rel); ++i)
 	{
+		Form_pg_attribute attr = rel->rd_att->attrs[i];
 		void	   *toFree1;
+		void	   *toFreeToast = NULL;
 		Datum		datum = d[i];
-		int			err = datumstreamwrite_put(idesc->ds[i], datum, null[i], &toFree1);
+		bool		zoneFed = false;
+		int			err;
+
+		if (!null[i] && attr->attlen == -1)
+			datum = aocs_toast_value(rel, attr, idesc->toast_threshold,
+									 idesc->keepToastPointers,
+									 datum, &toFreeToast);
+
+		err = datumstreamwrite_put(idesc->ds[i], datum, null[i], &toFree1);
 
 		if (toFree1 != NULL)
 		{
@@ -905,6 +1614,11 @@ aocs_insert_values(AOCSInsertDesc idesc, Datum *d, bool *null, AOTupleId *aoTupl
 					idesc->ds[i]->ao_write.storageAttributes.compress = FALSE;
 				}
 
+				/* The lob's block is recorded right away; count it first. */
+				AppendOnlyBlockDirectory_AddZoneValue(&idesc->blockDirectory,
+													  i, d[i], null[i]);
+				zoneFed = true;
+
 				err = datumstreamwrite_lob(idesc->ds[i],
 										   datum,
 										   &idesc->blockDirectory,
@@ -921,8 +1635,18 @@ aocs_insert_values(AOCSInsertDesc idesc, Datum *d, bool *null, AOTupleId *aoTupl
 			}
 		}
 
+		/*
+		 * Count the value towards the zone of the block it went into, now
+		 * that any block it didn't fit in has been written out.
+		 */
+		if (!zoneFed)
+			AppendOnlyBlockDirectory_AddZoneValue(&idesc->blockDirectory,
+												  i, d[i], null[i]);
+
 		if (toFree1 != NULL)
 			pfree(toFree1);
+		if (toFreeToast != NULL)
+			pfree(toFreeToast);
 	}
 
 	idesc->insertCount++;
@@ -1283,12 +2007,19 @@ aocs_fetch(AOCSFetchDesc aocsFetchDesc,
 
 	Assert(numCols > 0);
 
+	/*
+	 * The visibility of the tuple is the same for all its columns, so check
+	 * it once, before fetching any of them.
+	 */
+	if (!isSnapshotAny && !AppendOnlyVisimap_IsVisible(&aocsFetchDesc->visibilityMap, aoTupleId))
+		found = false;
+
 	/*
 	 * Go through columns one by one. Check if the current block has the
 	 * requested tuple. If so, fetch it. Otherwise, read the block that
 	 * contains the requested tuple.
 	 */
-	for (colno = 0; colno < numCols; colno++)
+	for (colno = 0; found && colno < numCols; colno++)
 	{
 		DatumStreamFetchDesc datumStreamFetchDesc = aocsFetchDesc->datumStreamFetchDesc[colno];
 
@@ -1316,12 +2047,6 @@ aocs_fetch(AOCSFetchDesc aocsFetchDesc,
 			if (rowNum >= datumStreamFetchDesc->currentBlock.firstRowNum &&
 				rowNum <= datumStreamFetchDesc->currentBlock.lastRowNum)
 			{
-				if (!isSnapshotAny && !AppendOnlyVisimap_IsVisible(&aocsFetchDesc->visibilityMap, aoTupleId))
-				{
-					found = false;
-					break;
-				}
-
 				fetchFromCurrentBlock(aocsFetchDesc, rowNum, slot, colno);
 				continue;
 			}
@@ -1358,12 +2083,6 @@ aocs_fetch(AOCSFetchDesc aocsFetchDesc,
 					positionLimitToEndOfRange(datumStreamFetchDesc);
 				}
 
-				if (!isSnapshotAny && !AppendOnlyVisimap_IsVisible(&aocsFetchDesc->visibilityMap, aoTupleId))
-				{
-					found = false;
-					break;
-				}
-
 				if (!scanToFetchValue(aocsFetchDesc, rowNum, slot, colno))
 				{
 					found = false;
@@ -1414,12 +2133,6 @@ aocs_fetch(AOCSFetchDesc aocsFetchDesc,
 			break;
 		}
 
-		if (!isSnapshotAny && !AppendOnlyVisimap_IsVisible(&aocsFetchDesc->visibilityMap, aoTupleId))
-		{
-			found = false;
-			break;
-		}
-
 		/*
 		 * Set scan range covered by new Block Directory entry.
 		 */
@@ -1451,6 +2164,43 @@ aocs_fetch(AOCSFetchDesc aocsFetchDesc,
 	return found;
 }
 
+/*
+ * Is the tuple past the last row of its segment file?
+ *
+ * This is meant to be asked after aocs_fetch() failed to find the tuple.
+ * The fetch leaves the last block it read as the current block; if that is
+ * the last block of the segment file and it ends before the tuple, none of
+ * the later row numbers of the segment file can be found either, so a
+ * caller going through row numbers in ascending order may stop.
+ */
+bool
+aocs_fetch_past_end(AOCSFetchDesc aocsFetchDesc, AOTupleId *aoTupleId)
+{
+	int			segmentFileNum = AOTupleIdGet_segmentFileNum(aoTupleId);
+	int64		rowNum = AOTupleIdGet_rowNum(aoTupleId);
+	int			numCols = aocsFetchDesc->relation->rd_att->natts;
+	int			colno;
+
+	for (colno = 0; colno < numCols; colno++)
+	{
+		DatumStreamFetchDesc datumStreamFetchDesc = aocsFetchDesc->datumStreamFetchDesc[colno];
+
+		/* All columns have the same rows, so the first one fetched will do */
+		if (datumStreamFetchDesc == NULL)
+			continue;
+
+		return (datumStreamFetchDesc->currentSegmentFile.isOpen &&
+				datumStreamFetchDesc->currentSegmentFile.num == segmentFileNum &&
+				datumStreamFetchDesc->currentBlock.have &&
+				datumStreamFetchDesc->currentBlock.fileOffset +
+				datumStreamFetchDesc->currentBlock.overallBlockLen >=
+				datumStreamFetchDesc->currentSegmentFile.logicalEof &&
+				rowNum > datumStreamFetchDesc->currentBlock.lastRowNum);
+	}
+
+	return false;
+}
+
 void
 aocs_fetch_finish(AOCSFetchDesc aocsFetchDesc)
 {
@@ -1894,7 +2644,16 @@ aocs_addcol_insert_datum(AOCSAddColumnDesc desc, Datum *d, bool *isnull)
 
 	for (i = 0; i < desc->num_newcols; ++i)
 	{
+		Form_pg_attribute attr = desc->rel->rd_att->attrs[i + colno];
+		void	   *toFreeToast = NULL;
+
 		datum = d[i];
+
+		/* Values stored out of line elsewhere are fetched. */
+		if (!isnull[i] && attr->attlen == -1)
+			datum = aocs_toast_value(desc->rel, attr, 0, false,
+									 datum, &toFreeToast);
+
 		err = datumstreamwrite_put(desc->dsw[i], datum, isnull[i], &toFree1);
 		if (toFree1 != NULL)
 		{
@@ -1952,6 +2711,8 @@ aocs_addcol_insert_datum(AOCSAddColumnDesc desc, Datum *d, bool *isnull)
 		}
 		if (toFree1 != NULL)
 			pfree(toFree1);
+		if (toFreeToast != NULL)
+			pfree(toFreeToast);
 	}
 }
 
@@ -989,6 +989,55 @@ GetAOTotalBytes(Relation parentrel, Snapshot appendOnlyMetaDataSnapshot)
 	return result;
 }
 
+/*
+ * GetAOModCount
+ *
+ * Sum of the modification counters over all the segment files of an AO or
+ * AOCS table, as recorded in its pg_aoseg relation on this local segdb.
+ * Every DML command bumps the counter of the segment files it touches, so
+ * analyzedb treats a table whose sum is unchanged as not modified.
+ */
+int64
+GetAOModCount(Oid relid, bool columnstore, Snapshot appendOnlyMetaDataSnapshot)
+{
+	Relation	pg_aoseg_rel;
+	TupleDesc	pg_aoseg_dsc;
+	HeapTuple	tuple;
+	HeapScanDesc aoscan;
+	Oid			segrelid = InvalidOid;
+	AttrNumber	attnum;
+	int64		result;
+	Datum		modcount;
+	bool		isNull;
+
+	GetAppendOnlyEntryAuxOids(relid, appendOnlyMetaDataSnapshot,
+							  &segrelid, NULL, NULL, NULL, NULL);
+	if (!OidIsValid(segrelid))
+		return 0;
+
+	attnum = columnstore ? Anum_pg_aocs_modcount : Anum_pg_aoseg_modcount;
+	result = 0;
+
+	pg_aoseg_rel = heap_open(segrelid, AccessShareLock);
+	pg_aoseg_dsc = RelationGetDescr(pg_aoseg_rel);
+
+	aoscan = heap_beginscan(pg_aoseg_rel, appendOnlyMetaDataSnapshot, 0, NULL);
+
+	while ((tuple = heap_getnext(aoscan, ForwardScanDirection)) != NULL)
+	{
+		modcount = fastgetattr(tuple, attnum, pg_aoseg_dsc, &isNull);
+		if (!isNull)
+			result += DatumGetInt64(modcount);
+
+		CHECK_FOR_INTERRUPTS();
+	}
+
+	heap_endscan(aoscan);
+	heap_close(pg_aoseg_rel, AccessShareLock);
+
+	return result;
+}
+
 PG_FUNCTION_INFO_V1(gp_aoseg_history);
 
 extern Datum gp_aoseg_history(PG_FUNCTION_ARGS);
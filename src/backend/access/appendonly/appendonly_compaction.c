@@ -82,6 +82,8 @@ AppendOnlyCompaction_DropSegmentFile(Relation aorel,
 												  persistentSerialNum);
 
 	DeleteGpRelationNodeTuple(aorel, segno);
+
+	AppendOnlyBlockDirectory_InvalidateCache(aorel, segno);
 }
 
 /*
@@ -397,6 +399,15 @@ AppendOnlySegmentFileFullCompaction(Relation aorel,
 	estate->es_num_result_relations = 1;
 	estate->es_result_relation_info = resultRelInfo;
 
+	/*
+	 * Blocks without deleted tuples can be copied to the new segfile as they
+	 * are, saving decompressing and compressing them again.  The moved tuples
+	 * need new index entries, though, so this is only done without indexes.
+	 */
+	if (gp_appendonly_compaction_copy_blocks &&
+		resultRelInfo->ri_NumIndices == 0)
+		scanDesc->blockCopyDesc = insertDesc;
+
 	/*
 	 * Go through all visible tuples and move them to a new segfile.
 	 */
@@ -435,6 +446,8 @@ AppendOnlySegmentFileFullCompaction(Relation aorel,
 		}
 	}
 
+	movedTupleCount += scanDesc->blockCopyTupleCount;
+
 	SetFileSegInfoState(aorel, compact_segno, AOSEG_STATE_AWAITING_DROP);
 
 	AppendOnlyVisimap_DeleteSegmentFile(&visiMap, compact_segno);
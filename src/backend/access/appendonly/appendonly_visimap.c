@@ -212,6 +212,73 @@ AppendOnlyVisimap_IsVisible(
 											aoTupleId);
 }
 
+/*
+ * ANDs the visibility of nrows consecutive rows of a segment file, starting
+ * at firstRowNum, into visible[].  Returns true iff none of the rows is
+ * hidden.
+ *
+ * This is the batch form of AppendOnlyVisimap_IsVisible: the visimap entry
+ * is looked up once for each range of rows it covers, not once per row.
+ *
+ * Assumes that the visibility has been initialized and not finished.
+ */
+bool
+AppendOnlyVisimap_GetVisibility(
+								AppendOnlyVisimap *visiMap,
+								int segno,
+								int64 firstRowNum,
+								int nrows,
+								bool *visible)
+{
+	AOTupleId	aoTupleId;
+	bool		allVisible = true;
+
+	Assert(visiMap);
+	Assert(visible);
+
+	elogif(Debug_appendonly_print_visimap, LOG,
+		   "Append-only visi map: Visibility check of %d rows: "
+		   "(segno, firstRowNum) = (%d, " INT64_FORMAT ")",
+		   nrows, segno, firstRowNum);
+
+	while (nrows > 0)
+	{
+		int64		entryEnd;
+		int			count;
+
+		AOTupleIdInit_Init(&aoTupleId);
+		AOTupleIdInit_segmentFileNum(&aoTupleId, segno);
+		AOTupleIdInit_rowNum(&aoTupleId, firstRowNum);
+
+		if (!AppendOnlyVisimapEntry_CoversTuple(&visiMap->visimapEntry,
+												&aoTupleId))
+		{
+			/* if necessary persist the current entry before moving. */
+			if (AppendOnlyVisimapEntry_HasChanged(&visiMap->visimapEntry))
+			{
+				AppendOnlyVisimap_Store(visiMap);
+			}
+
+			AppendOnlyVisimap_Find(visiMap, &aoTupleId);
+		}
+
+		entryEnd = visiMap->visimapEntry.firstRowNum + APPENDONLY_VISIMAP_MAX_RANGE;
+		count = (int) Min((int64) nrows, entryEnd - firstRowNum);
+
+		if (!AppendOnlyVisimapEntry_GetVisibility(&visiMap->visimapEntry,
+												  firstRowNum,
+												  count,
+												  visible))
+			allVisible = false;
+
+		firstRowNum += count;
+		visible += count;
+		nrows -= count;
+	}
+
+	return allVisible;
+}
+
 /*
  * Stores the current visibility map entry information
  * in the relation either as update or delete.
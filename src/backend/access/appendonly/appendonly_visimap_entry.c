@@ -481,6 +481,70 @@ AppendOnlyVisimapEntry_IsVisible(
 	return visibilityBit;
 }
 
+/*
+ * ANDs the visibility of count consecutive rows, starting at rowNum, into
+ * visible[].  Returns true iff none of the rows is hidden.
+ *
+ * Zero words of the bitmap are skipped a word at a time, so a range with few
+ * hidden rows costs little more than one without.
+ *
+ * Should only be called if the current visimap entry covers all the rows.
+ */
+bool
+AppendOnlyVisimapEntry_GetVisibility(
+									 AppendOnlyVisimapEntry *visiMapEntry,
+									 int64 rowNum,
+									 int count,
+									 bool *visible)
+{
+	Bitmapset  *bitmap;
+	int64		rowNumOffset;
+	bool		allVisible = true;
+	int			i;
+
+	Assert(visiMapEntry);
+	Assert(AppendOnlyVisimapEntry_IsValid(visiMapEntry));
+	Assert(rowNum >= visiMapEntry->firstRowNum);
+	Assert(rowNum + count <= visiMapEntry->firstRowNum + APPENDONLY_VISIMAP_MAX_RANGE);
+	Assert(visible);
+
+	bitmap = visiMapEntry->bitmap;
+	if (bitmap == NULL)
+		return true;
+
+	rowNumOffset = 0;
+	AppendOnlyVisimapEntry_GetRownumOffset(visiMapEntry,
+										   rowNum, &rowNumOffset);
+
+	i = 0;
+	while (i < count)
+	{
+		int64		offset = rowNumOffset + i;
+		int			wordnum = offset / BITS_PER_BITMAPWORD;
+		int			bitnum = offset % BITS_PER_BITMAPWORD;
+		bitmapword	word;
+
+		if (wordnum >= bitmap->nwords)
+			break;
+
+		word = bitmap->words[wordnum];
+		if (word == 0)
+		{
+			i += BITS_PER_BITMAPWORD - bitnum;
+			continue;
+		}
+
+		if ((word & ((bitmapword) 1 << bitnum)) != 0)
+		{
+			visible[i] = false;
+			allVisible = false;
+		}
+		i++;
+	}
+
+	return allVisible;
+}
+
 /*
  * The minimal size (in uint32's elements) the entry array needs to have to
  * cover the given offset
@@ -142,6 +142,9 @@ static void AppendOnlyExecutorReadBlock_Finish(
 static void AppendOnlyExecutorReadBlock_ResetCounts(
 										AppendOnlyExecutorReadBlock *executorReadBlock);
 
+static void setupNextWriteBlock(AppendOnlyInsertDesc aoInsertDesc);
+static void finishWriteBlock(AppendOnlyInsertDesc aoInsertDesc);
+
 /* ----------------
  *		initscan - scan code common to appendonly_beginscan and appendonly_rescan
  * ----------------
@@ -1320,6 +1323,121 @@ AppendOnlyExecutorReadBlock_FetchTuple(AppendOnlyExecutorReadBlock *executorRead
 	/* No match. */
 }
 
+/*
+ * Find the visibility of the rows of the block the scan is positioned at,
+ * in scan->blockVisible.  Returns true iff all of them are visible.
+ */
+static bool
+getBlockVisibility(AppendOnlyScanDesc scan)
+{
+	AppendOnlyExecutorReadBlock *executorReadBlock = &scan->executorReadBlock;
+	int			rowCount = executorReadBlock->rowCount;
+
+	if (scan->blockVisible == NULL)
+		scan->blockVisible = (bool *)
+			MemoryContextAlloc(scan->aoScanInitContext,
+							   AOSmallContentHeader_MaxRowCount * sizeof(bool));
+
+	Assert(rowCount <= AOSmallContentHeader_MaxRowCount);
+	memset(scan->blockVisible, true, rowCount * sizeof(bool));
+	scan->blockAllVisible =
+		AppendOnlyVisimap_GetVisibility(&scan->visibilityMap,
+										executorReadBlock->segmentFileNum,
+										executorReadBlock->blockFirstRowNum,
+										rowCount,
+										scan->blockVisible);
+	return scan->blockAllVisible;
+}
+
+/*
+ * Copy the block the scan is positioned at to the compaction target, as it
+ * is stored, when all of its rows are visible.  The rows get new row numbers
+ * in the target segment file.
+ *
+ * Return true if the block was copied, and the scan is done with it.
+ */
+static bool
+copyBlockForCompaction(AppendOnlyScanDesc scan)
+{
+	AppendOnlyInsertDesc aoInsertDesc = scan->blockCopyDesc;
+	AppendOnlyExecutorReadBlock *executorReadBlock = &scan->executorReadBlock;
+	int			rowCount = executorReadBlock->rowCount;
+
+	if (executorReadBlock->executorBlockKind != AoExecutorBlockKind_VarBlock &&
+		executorReadBlock->executorBlockKind != AoExecutorBlockKind_SingleRow)
+		return false;
+	if (executorReadBlock->isLarge || rowCount <= 0)
+		return false;
+
+	if (!getBlockVisibility(scan))
+		return false;
+
+	/*
+	 * Write out the tuples moved so far, so the copied block gets the next
+	 * row numbers.
+	 */
+	finishWriteBlock(aoInsertDesc);
+
+	/*
+	 * Make sure the fast sequences cover the block, with some left for the
+	 * next insert.
+	 */
+	if (aoInsertDesc->numSequences <= rowCount)
+	{
+		int64		firstSequence;
+		int64		numSequences;
+
+		numSequences = rowCount - aoInsertDesc->numSequences + NUM_FAST_SEQUENCES;
+		firstSequence =
+			GetFastSequences(aoInsertDesc->aoi_rel->rd_appendonly->segrelid,
+							 aoInsertDesc->cur_segno,
+							 aoInsertDesc->lastSequence + aoInsertDesc->numSequences + 1,
+							 numSequences);
+
+		Assert(firstSequence == aoInsertDesc->lastSequence + aoInsertDesc->numSequences + 1);
+		aoInsertDesc->numSequences += numSequences;
+	}
+
+	AppendOnlyStorageWrite_SetFirstRowNum(&aoInsertDesc->storageWrite,
+										  aoInsertDesc->lastSequence + 1);
+
+	if (!AppendOnlyStorageWrite_CopyBlock(&aoInsertDesc->storageWrite,
+										  &scan->storageRead))
+	{
+		setupNextWriteBlock(aoInsertDesc);
+		return false;
+	}
+
+	AppendOnlyBlockDirectory_InsertEntry(
+										 &aoInsertDesc->blockDirectory,
+										 0,
+										 aoInsertDesc->lastSequence + 1,
+										 AppendOnlyStorageWrite_LogicalBlockStartOffset(&aoInsertDesc->storageWrite),
+										 rowCount,
+										 false);
+
+	aoInsertDesc->insertCount += rowCount;
+	aoInsertDesc->varblockCount++;
+	aoInsertDesc->lastSequence += rowCount;
+	aoInsertDesc->numSequences -= rowCount;
+	Assert(aoInsertDesc->numSequences > 0);
+
+	setupNextWriteBlock(aoInsertDesc);
+
+	AppendOnlyExecutionReadBlock_FinishedScanBlock(executorReadBlock);
+	scan->blockCopyTupleCount += rowCount;
+
+	elogif(Debug_appendonly_print_compaction, DEBUG5,
+		   "Compaction: Copied block of %d tuples (%d," INT64_FORMAT ") -> (%d," INT64_FORMAT ")",
+		   rowCount,
+		   executorReadBlock->segmentFileNum,
+		   executorReadBlock->blockFirstRowNum - rowCount,
+		   aoInsertDesc->cur_segno,
+		   aoInsertDesc->lastSequence - rowCount + 1);
+
+	return true;
+}
+
 /* ------------------------------------------------------------------------------ */
 
 /*
@@ -1337,34 +1455,63 @@ getNextBlock(AppendOnlyScanDesc scan)
 			return false;
 	}
 
-	if (!AppendOnlyExecutorReadBlock_GetBlockInfo(
-												  &scan->storageRead,
-												  &scan->executorReadBlock))
+	for (;;)
 	{
+		if (!AppendOnlyExecutorReadBlock_GetBlockInfo(
+													  &scan->storageRead,
+													  &scan->executorReadBlock))
+		{
+			if (scan->blockDirectory)
+			{
+				AppendOnlyBlockDirectory_End_forInsert(scan->blockDirectory);
+			}
+
+			/* done reading the file */
+			CloseScannedFileSeg(scan);
+
+			return false;
+		}
+
 		if (scan->blockDirectory)
 		{
-			AppendOnlyBlockDirectory_End_forInsert(scan->blockDirectory);
+			AppendOnlyBlockDirectory_InsertEntry(
+												 scan->blockDirectory, 0,
+												 scan->executorReadBlock.blockFirstRowNum,
+												 scan->executorReadBlock.headerOffsetInFile,
+												 scan->executorReadBlock.rowCount,
+												 false);
 		}
 
-		/* done reading the file */
-		CloseScannedFileSeg(scan);
+		/*
+		 * Sampling for ANALYZE.  Not when building the block directory, or
+		 * compacting, which need every block.
+		 */
+		if (scan->blockSampleFraction < 1.0 &&
+			scan->blockDirectory == NULL && scan->blockCopyDesc == NULL &&
+			((double) random()) / ((double) MAX_RANDOM_VALUE) >= scan->blockSampleFraction)
+		{
+			AppendOnlyStorageRead_SkipCurrentBlock(&scan->storageRead);
+			CHECK_FOR_INTERRUPTS();
+			continue;
+		}
 
-		return false;
-	}
+		if (scan->blockCopyDesc == NULL || !copyBlockForCompaction(scan))
+			break;
 
-	if (scan->blockDirectory)
-	{
-		AppendOnlyBlockDirectory_InsertEntry(
-											 scan->blockDirectory, 0,
-											 scan->executorReadBlock.blockFirstRowNum,
-											 scan->executorReadBlock.headerOffsetInFile,
-											 scan->executorReadBlock.rowCount,
-											 false);
+		/* Check interrupts as this may take time. */
+		CHECK_FOR_INTERRUPTS();
 	}
 
 	AppendOnlyExecutorReadBlock_GetContents(
 											&scan->executorReadBlock);
 
+	/*
+	 * Find the visibility of all the rows of the block at once, rather than
+	 * row by row as they are returned.
+	 */
+	if (scan->snapshot != SnapshotAny)
+		getBlockVisibility(scan);
+
 	return true;
 }
 
@@ -1420,13 +1567,11 @@ appendonlygettup(AppendOnlyScanDesc scan,
 														  slot);
 		if (tuple != NULL)
 		{
-
-			/*
-			 * Need to get the Block Directory entry that covers the TID.
-			 */
 			AOTupleId  *aoTupleId = (AOTupleId *) slot_get_ctid(slot);
 
-			if (!isSnapshotAny && !AppendOnlyVisimap_IsVisible(&scan->visibilityMap, aoTupleId))
+			if (!isSnapshotAny && !scan->blockAllVisible &&
+				!scan->blockVisible[AOTupleIdGet_rowNum(aoTupleId) -
+									scan->executorReadBlock.blockFirstRowNum])
 			{
 				/*
 				 * The tuple is invisible.
@@ -1732,6 +1877,7 @@ appendonly_beginrangescan_internal(Relation relation,
 	initscan(scan, key);
 
 	scan->blockDirectory = NULL;
+	scan->blockSampleFraction = gp_statistics_ao_block_sample_fraction;
 
 	AppendOnlyVisimap_Init(&scan->visibilityMap,
 						   relation->rd_appendonly->visimaprelid,
@@ -1865,6 +2011,9 @@ appendonly_endscan(AppendOnlyScanDesc scan)
 	AppendOnlyVisimap_Finish(&scan->visibilityMap, AccessShareLock);
 	pfree(scan->aos_filenamepath);
 
+	if (scan->blockVisible)
+		pfree(scan->blockVisible);
+
 	pfree(scan->title);
 
 	pfree(scan);
@@ -2489,6 +2638,32 @@ appendonly_fetch(AppendOnlyFetchDesc aoFetchDesc,
 	/* Segment file not in aoseg table.. */
 }
 
+/*
+ * appendonly_fetch_past_end -- is the tid past the last row of its segment
+ * file?
+ *
+ * This is meant to be asked after appendonly_fetch() failed to find the
+ * tuple.  The fetch leaves the last block it read as the current block; if
+ * that is the last block of the segment file and it ends before the tuple,
+ * none of the later row numbers of the segment file can be found either, so
+ * a caller going through row numbers in ascending order may stop.
+ */
+bool
+appendonly_fetch_past_end(AppendOnlyFetchDesc aoFetchDesc,
+						  AOTupleId *aoTupleId)
+{
+	int			segmentFileNum = AOTupleIdGet_segmentFileNum(aoTupleId);
+	int64		rowNum = AOTupleIdGet_rowNum(aoTupleId);
+
+	return (aoFetchDesc->currentSegmentFile.isOpen &&
+			aoFetchDesc->currentSegmentFile.num == segmentFileNum &&
+			aoFetchDesc->currentBlock.have &&
+			aoFetchDesc->currentBlock.fileOffset +
+			aoFetchDesc->currentBlock.overallBlockLen >=
+			aoFetchDesc->currentSegmentFile.logicalEof &&
+			rowNum > aoFetchDesc->currentBlock.lastRowNum);
+}
+
 void
 appendonly_fetch_finish(AppendOnlyFetchDesc aoFetchDesc)
 {
@@ -18,16 +18,63 @@
 #include "catalog/aoblkdir.h"
 #include "access/heapam.h"
 #include "access/genam.h"
+#include "access/hash.h"
+#include "access/xact.h"
 #include "catalog/indexing.h"
+#include "catalog/pg_type.h"
 #include "parser/parse_oper.h"
+#include "storage/shmem.h"
+#include "storage/spin.h"
+#include "utils/date.h"
 #include "utils/lsyscache.h"
 #include "utils/memutils.h"
 #include "utils/guc.h"
 #include "utils/fmgroids.h"
+#include "utils/timestamp.h"
 #include "cdb/cdbappendonlyam.h"
 
 int			gp_blockdirectory_entry_min_range = 0;
 int			gp_blockdirectory_minipage_size = NUM_MINIPAGE_ENTRIES;
+int			gp_blockdirectory_cache_size = 4096;
+
+/*
+ * Shared cache of block directory entries.
+ *
+ * An index fetch from an append-only table maps each row number to its
+ * block through the block directory, which costs a btree probe and a
+ * minipage copy whenever the row is not in the minipage we have in memory.
+ * The cache remembers the entries found that way, across queries and
+ * backends, in a direct-mapped array of slots.  A slot is picked by the
+ * segment file, the column group and the row number rounded down to
+ * BLKDIR_CACHE_ROWS_PER_SLOT, so an entry covering many rows may fill
+ * several slots.
+ *
+ * Only entries followed by another entry in their minipage are cached; the
+ * range of those never changes once written, while the last entry of a
+ * minipage grows with later inserts.  Entries written by our own
+ * transaction are not cached, since it may still abort.  A cached entry is
+ * only used if it ends within the eof the caller's snapshot sees, so it
+ * never exposes rows the block directory itself would hide.
+ */
+#define BLKDIR_CACHE_ROWS_PER_SLOT	1024
+
+typedef struct BlockDirectoryCacheKey
+{
+	RelFileNode relfilenode;
+	int32		segno;
+	int32		columnGroupNo;
+	int64		rowChunk;
+} BlockDirectoryCacheKey;
+
+typedef struct BlockDirectoryCacheSlot
+{
+	slock_t		mutex;
+	bool		valid;
+	BlockDirectoryCacheKey key;
+	AppendOnlyBlockDirectoryEntry entry;
+} BlockDirectoryCacheSlot;
+
+static BlockDirectoryCacheSlot *BlockDirectoryCache = NULL;
 
 static inline uint32
 minipage_size(uint32 nEntry)
@@ -62,6 +109,21 @@ static bool insert_new_entry(AppendOnlyBlockDirectory *blockDirectory,
 				 int64 fileOffset,
 				 int64 rowCount,
 				 bool addColAction);
+static void blkdir_cache_key(AppendOnlyBlockDirectory *blockDirectory,
+				 int segno, int columnGroupNo, int64 rowNum,
+				 BlockDirectoryCacheKey *key);
+static bool blkdir_cache_lookup(AppendOnlyBlockDirectory *blockDirectory,
+					int segno, int columnGroupNo, int64 rowNum, int64 eof,
+					AppendOnlyBlockDirectoryEntry *directoryEntry);
+static void blkdir_cache_store(AppendOnlyBlockDirectory *blockDirectory,
+				   int segno, int columnGroupNo, int64 rowNum,
+				   AppendOnlyBlockDirectoryEntry *directoryEntry);
+static void zone_reset(MinipageZone *zone);
+static void zone_merge(MinipageZone *dst, MinipageZone *src);
+static void take_pending_zone(MinipagePerColumnGroup *minipageInfo,
+				  int64 expectedRows,
+				  MinipageZone *zone);
+static void flush_pending_zone(MinipagePerColumnGroup *minipageInfo);
 
 void
 AppendOnlyBlockDirectoryEntry_GetBeginRange(
@@ -271,6 +333,36 @@ AppendOnlyBlockDirectory_Init_forInsert(
 
 	init_internal(blockDirectory);
 
+	/*
+	 * Keep zones for the columns of a column-oriented table.  There is one
+	 * column group per column there, so the group number is the attribute
+	 * number.  Without gp_appendonly_zone_maps the minipages are written in
+	 * the original format, which drops the zones of the ones rewritten.
+	 */
+	blockDirectory->zoneFeedAfterInsert = false;
+	if (isAOCol && gp_appendonly_zone_maps)
+	{
+		MemoryContext oldcxt;
+
+		oldcxt = MemoryContextSwitchTo(blockDirectory->memoryContext);
+		for (groupNo = 0; groupNo < blockDirectory->numColumnGroups &&
+			 groupNo < aoRel->rd_att->natts; groupNo++)
+		{
+			MinipagePerColumnGroup *minipageInfo =
+			&blockDirectory->minipages[groupNo];
+			Oid			typid = aoRel->rd_att->attrs[groupNo]->atttypid;
+
+			if (!AppendOnlyBlockDirectory_ZoneTypeSupported(typid))
+				continue;
+
+			minipageInfo->zones =
+				palloc0(sizeof(MinipageZone) * NUM_MINIPAGE_ENTRIES);
+			minipageInfo->zoneTypid = typid;
+			zone_reset(&minipageInfo->pendingZone);
+		}
+		MemoryContextSwitchTo(oldcxt);
+	}
+
 	ereportif(Debug_appendonly_print_blockdirectory, LOG,
 			  (errmsg("Append-only block directory init for insert: "
 					  "(segno, numColumnGroups, isAOCol, lastSequence)="
@@ -470,6 +562,7 @@ AppendOnlyBlockDirectory_GetEntry(
 	&blockDirectory->minipages[columnGroupNo];
 	int			entry_no = -1;
 	int			tmpGroupNo;
+	bool		cacheable = false;
 
 	if (blkdirRel == NULL || blkdirIdx == NULL)
 	{
@@ -552,6 +645,24 @@ AppendOnlyBlockDirectory_GetEntry(
 
 	Assert(fsInfo != NULL);
 
+	/*
+	 * Before probing the btree index, see if some earlier lookup left the
+	 * entry in the shared cache.
+	 */
+	if (BlockDirectoryCache != NULL && i < blockDirectory->totalSegfiles)
+	{
+		int64		eof;
+
+		if (!blockDirectory->isAOCol)
+			eof = fsInfo->eof;
+		else
+			eof = ((AOCSFileSegInfo *) fsInfo)->vpinfo.entry[columnGroupNo].eof;
+
+		if (blkdir_cache_lookup(blockDirectory, segmentFileNum, columnGroupNo,
+								rowNum, eof, directoryEntry))
+			return true;
+	}
+
 	/*
 	 * Search the btree index to find the minipage that contains the rowNum.
 	 * We find the minipages for all column groups, since currently we will
@@ -598,6 +709,10 @@ AppendOnlyBlockDirectory_GetEntry(
 							 tuple,
 							 heapTupleDesc,
 							 tmpGroupNo);
+
+			if (tmpGroupNo == columnGroupNo)
+				cacheable = !TransactionIdIsCurrentTransactionId(
+					HeapTupleHeaderGetXmin(tuple->t_data));
 		}
 		else
 		{
@@ -634,10 +749,17 @@ AppendOnlyBlockDirectory_GetEntry(
 			 */
 			entry_no = minipageInfo->numMinipageEntries - 1;
 		}
-		return set_directoryentry_range(blockDirectory,
-										columnGroupNo,
-										entry_no,
-										directoryEntry);
+		if (!set_directoryentry_range(blockDirectory,
+									  columnGroupNo,
+									  entry_no,
+									  directoryEntry))
+			return false;
+
+		if (cacheable &&
+			((uint32) entry_no) < minipageInfo->numMinipageEntries - 1)
+			blkdir_cache_store(blockDirectory, segmentFileNum, columnGroupNo,
+							   rowNum, directoryEntry);
+		return true;
 	}
 
 	return false;
@@ -693,6 +815,7 @@ insert_new_entry(
 	MinipagePerColumnGroup *minipageInfo;
 	int			minipageIndex;
 	int			lastEntryNo;
+	MinipageZone blockZone;
 
 	if (rowCount == 0)
 		return false;
@@ -722,6 +845,21 @@ insert_new_entry(
 	minipageInfo = &blockDirectory->minipages[minipageIndex];
 	Assert(minipageInfo->numMinipageEntries <= (uint32) NUM_MINIPAGE_ENTRIES);
 
+	/*
+	 * Work out the zone of the new block.  On the insert path its values
+	 * have already been fed.  When building from a scan they are fed after
+	 * this call, so finish the previous block's zone and start an empty one
+	 * that flush_pending_zone() completes later.
+	 */
+	if (blockDirectory->zoneFeedAfterInsert)
+	{
+		flush_pending_zone(minipageInfo);
+		zone_reset(&blockZone);
+		minipageInfo->pendingExpectedRows = rowCount;
+	}
+	else
+		take_pending_zone(minipageInfo, rowCount, &blockZone);
+
 	lastEntryNo = minipageInfo->numMinipageEntries - 1;
 	if (lastEntryNo >= 0)
 	{
@@ -732,7 +870,12 @@ insert_new_entry(
 
 		if (gp_blockdirectory_entry_min_range > 0 &&
 			fileOffset - entry->fileOffset < gp_blockdirectory_entry_min_range)
+		{
+			/* The block becomes part of the latest entry. */
+			if (minipageInfo->zones)
+				zone_merge(&minipageInfo->zones[lastEntryNo], &blockZone);
 			return true;
+		}
 
 		/* Update the rowCount in the latest entry */
 		Assert(entry->rowCount <= firstRowNum - entry->firstRowNum);
@@ -763,6 +906,9 @@ insert_new_entry(
 		 */
 		MemSet(minipageInfo->minipage->entry, 0,
 			   minipageInfo->numMinipageEntries * sizeof(MinipageEntry));
+		if (minipageInfo->zones)
+			MemSet(minipageInfo->zones, 0,
+				   minipageInfo->numMinipageEntries * sizeof(MinipageZone));
 		minipageInfo->numMinipageEntries = 0;
 	}
 
@@ -773,6 +919,9 @@ insert_new_entry(
 	entry->fileOffset = fileOffset;
 	entry->rowCount = rowCount;
 
+	if (minipageInfo->zones)
+		minipageInfo->zones[minipageInfo->numMinipageEntries] = blockZone;
+
 	minipageInfo->numMinipageEntries++;
 
 	ereportif(Debug_appendonly_print_blockdirectory, LOG,
@@ -830,6 +979,149 @@ AppendOnlyBlockDirectory_DeleteSegmentFile(Relation aoRel,
 	index_close(blkdirIdx, RowExclusiveLock);
 	heap_close(blkdirRel, RowExclusiveLock);
 
+	AppendOnlyBlockDirectory_InvalidateCache(aoRel, segno);
+}
+
+/*
+ * Report shared memory space needed by AppendOnlyBlockDirectory_CacheShmemInit.
+ */
+Size
+AppendOnlyBlockDirectory_CacheShmemSize(void)
+{
+	return mul_size(sizeof(BlockDirectoryCacheSlot), gp_blockdirectory_cache_size);
+}
+
+/*
+ * Allocate and initialize the shared block directory cache.
+ */
+void
+AppendOnlyBlockDirectory_CacheShmemInit(void)
+{
+	bool		found;
+	int			i;
+
+	if (gp_blockdirectory_cache_size == 0)
+		return;
+
+	BlockDirectoryCache = (BlockDirectoryCacheSlot *)
+		ShmemInitStruct("Append-only Block Directory Cache",
+						AppendOnlyBlockDirectory_CacheShmemSize(), &found);
+
+	if (!found)
+	{
+		for (i = 0; i < gp_blockdirectory_cache_size; i++)
+		{
+			SpinLockInit(&BlockDirectoryCache[i].mutex);
+			BlockDirectoryCache[i].valid = false;
+		}
+	}
+}
+
+/*
+ * AppendOnlyBlockDirectory_InvalidateCache
+ *
+ * Forget all cached block directory entries of the given segment file, for
+ * all column groups.  Must be called when the segment file is emptied.
+ */
+void
+AppendOnlyBlockDirectory_InvalidateCache(Relation aoRel, int segno)
+{
+	int			i;
+
+	if (BlockDirectoryCache == NULL)
+		return;
+
+	for (i = 0; i < gp_blockdirectory_cache_size; i++)
+	{
+		volatile BlockDirectoryCacheSlot *slot = &BlockDirectoryCache[i];
+
+		SpinLockAcquire(&slot->mutex);
+		if (slot->valid &&
+			slot->key.segno == segno &&
+			RelFileNodeEquals(slot->key.relfilenode, aoRel->rd_node))
+			slot->valid = false;
+		SpinLockRelease(&slot->mutex);
+	}
+}
+
+static void
+blkdir_cache_key(AppendOnlyBlockDirectory *blockDirectory,
+				 int segno, int columnGroupNo, int64 rowNum,
+				 BlockDirectoryCacheKey *key)
+{
+	/* Zero the padding too, the key is hashed and compared as bytes */
+	MemSet(key, 0, sizeof(BlockDirectoryCacheKey));
+	key->relfilenode = blockDirectory->aoRel->rd_node;
+	key->segno = segno;
+	key->columnGroupNo = columnGroupNo;
+	key->rowChunk = rowNum / BLKDIR_CACHE_ROWS_PER_SLOT;
+}
+
+/*
+ * Look up the entry covering rowNum in the shared cache.  eof is the end
+ * of the column group's segment file as the caller's snapshot sees it.
+ */
+static bool
+blkdir_cache_lookup(AppendOnlyBlockDirectory *blockDirectory,
+					int segno, int columnGroupNo, int64 rowNum, int64 eof,
+					AppendOnlyBlockDirectoryEntry *directoryEntry)
+{
+	BlockDirectoryCacheKey key;
+	volatile BlockDirectoryCacheSlot *slot;
+	bool		found = false;
+
+	blkdir_cache_key(blockDirectory, segno, columnGroupNo, rowNum, &key);
+	slot = &BlockDirectoryCache[hash_any((unsigned char *) &key, sizeof(key)) %
+								gp_blockdirectory_cache_size];
+
+	SpinLockAcquire(&slot->mutex);
+	if (slot->valid &&
+		memcmp((void *) &slot->key, &key, sizeof(key)) == 0 &&
+		rowNum >= slot->entry.range.firstRowNum &&
+		rowNum <= slot->entry.range.lastRowNum &&
+		slot->entry.range.afterFileOffset <= eof)
+	{
+		directoryEntry->range = slot->entry.range;
+		found = true;
+	}
+	SpinLockRelease(&slot->mutex);
+
+	if (found)
+		ereportif(Debug_appendonly_print_blockdirectory, LOG,
+				  (errmsg("Append-only block directory cache hit: "
+						  "(columnGroupNo, firstRowNum, fileOffset, lastRowNum, afterFileOffset) = "
+						  "(%d, " INT64_FORMAT ", " INT64_FORMAT ", " INT64_FORMAT ", " INT64_FORMAT ")",
+						  columnGroupNo, directoryEntry->range.firstRowNum,
+						  directoryEntry->range.fileOffset, directoryEntry->range.lastRowNum,
+						  directoryEntry->range.afterFileOffset)));
+
+	return found;
+}
+
+/*
+ * Remember the entry found for rowNum in the shared cache, replacing
+ * whatever was in its slot.
+ */
+static void
+blkdir_cache_store(AppendOnlyBlockDirectory *blockDirectory,
+				   int segno, int columnGroupNo, int64 rowNum,
+				   AppendOnlyBlockDirectoryEntry *directoryEntry)
+{
+	BlockDirectoryCacheKey key;
+	volatile BlockDirectoryCacheSlot *slot;
+
+	if (BlockDirectoryCache == NULL)
+		return;
+
+	blkdir_cache_key(blockDirectory, segno, columnGroupNo, rowNum, &key);
+	slot = &BlockDirectoryCache[hash_any((unsigned char *) &key, sizeof(key)) %
+								gp_blockdirectory_cache_size];
+
+	SpinLockAcquire(&slot->mutex);
+	memcpy((void *) &slot->key, &key, sizeof(key));
+	slot->entry.range = directoryEntry->range;
+	slot->valid = true;
+	SpinLockRelease(&slot->mutex);
 }
 
 /*
@@ -904,18 +1196,41 @@ copy_out_minipage(MinipagePerColumnGroup *minipageInfo,
 
 	Assert(!minipage_isnull);
 
+	Minipage   *minipage;
+	uint32		nEntry;
+
 	value = (struct varlena *)
 		DatumGetPointer(minipage_value);
 	detoast_value = pg_detoast_datum(value);
-	Assert(VARSIZE(detoast_value) <= minipage_size(NUM_MINIPAGE_ENTRIES));
+	minipage = (Minipage *) detoast_value;
+	nEntry = minipage->nEntry;
+	Assert(nEntry <= NUM_MINIPAGE_ENTRIES);
+
+	/*
+	 * Copy the header and the entries; zones, if any, go to their own
+	 * array.  Entries written before zones existed get an invalid zone.
+	 */
+	memcpy(minipageInfo->minipage, detoast_value, minipage_size(nEntry));
+	if (minipageInfo->zones)
+	{
+		if (minipage->version >= MINIPAGE_VERSION_ZONES)
+		{
+			Assert(VARSIZE(detoast_value) ==
+				   minipage_size(nEntry) + nEntry * sizeof(MinipageZone));
+			memcpy(minipageInfo->zones,
+				   ((char *) detoast_value) + minipage_size(nEntry),
+				   nEntry * sizeof(MinipageZone));
+		}
+		else
+			MemSet(minipageInfo->zones, 0, nEntry * sizeof(MinipageZone));
+	}
+	/* The in-memory copy never carries the zones inline. */
+	minipageInfo->minipage->version = MINIPAGE_VERSION_ORIGINAL;
 
-	memcpy(minipageInfo->minipage, detoast_value, VARSIZE(detoast_value));
 	if (detoast_value != value)
 		pfree(detoast_value);
 
-	Assert(minipageInfo->minipage->nEntry <= NUM_MINIPAGE_ENTRIES);
-
-	minipageInfo->numMinipageEntries = minipageInfo->minipage->nEntry;
+	minipageInfo->numMinipageEntries = nEntry;
 }
 
 
@@ -1131,6 +1446,7 @@ write_minipage(AppendOnlyBlockDirectory *blockDirectory,
 	bool	   *nulls = blockDirectory->nulls;
 	Relation	blkdirRel = blockDirectory->blkdirRel;
 	TupleDesc	heapTupleDesc = RelationGetDescr(blkdirRel);
+	Minipage   *zonedMinipage = NULL;
 
 	Assert(minipageInfo->numMinipageEntries > 0);
 
@@ -1153,8 +1469,24 @@ write_minipage(AppendOnlyBlockDirectory *blockDirectory,
 	SET_VARSIZE(minipageInfo->minipage,
 				minipage_size(minipageInfo->numMinipageEntries));
 	minipageInfo->minipage->nEntry = minipageInfo->numMinipageEntries;
-	values[Anum_pg_aoblkdir_minipage - 1] =
-		PointerGetDatum(minipageInfo->minipage);
+	if (minipageInfo->zones)
+	{
+		uint32		nEntry = minipageInfo->numMinipageEntries;
+		Size		len = minipage_size(nEntry) + nEntry * sizeof(MinipageZone);
+
+		zonedMinipage = palloc(len);
+		memcpy(zonedMinipage, minipageInfo->minipage, minipage_size(nEntry));
+		memcpy(((char *) zonedMinipage) + minipage_size(nEntry),
+			   minipageInfo->zones, nEntry * sizeof(MinipageZone));
+		SET_VARSIZE(zonedMinipage, len);
+		zonedMinipage->version = MINIPAGE_VERSION_ZONES;
+
+		values[Anum_pg_aoblkdir_minipage - 1] =
+			PointerGetDatum(zonedMinipage);
+	}
+	else
+		values[Anum_pg_aoblkdir_minipage - 1] =
+			PointerGetDatum(minipageInfo->minipage);
 	nulls[Anum_pg_aoblkdir_minipage - 1] = false;
 
 	tuple = heaptuple_form_to(heapTupleDesc,
@@ -1196,6 +1528,8 @@ write_minipage(AppendOnlyBlockDirectory *blockDirectory,
 	CatalogUpdateIndexes(blkdirRel, tuple);
 
 	heap_freetuple(tuple);
+	if (zonedMinipage)
+		pfree(zonedMinipage);
 
 	MemoryContextSwitchTo(oldcxt);
 }
@@ -1216,6 +1550,9 @@ AppendOnlyBlockDirectory_End_forInsert(
 		MinipagePerColumnGroup *minipageInfo =
 		&blockDirectory->minipages[groupNo];
 
+		if (blockDirectory->zoneFeedAfterInsert)
+			flush_pending_zone(minipageInfo);
+
 		if (minipageInfo->numMinipageEntries > 0)
 		{
 			write_minipage(blockDirectory, groupNo, minipageInfo);
@@ -1226,6 +1563,8 @@ AppendOnlyBlockDirectory_End_forInsert(
 		}
 
 		pfree(minipageInfo->minipage);
+		if (minipageInfo->zones)
+			pfree(minipageInfo->zones);
 	}
 
 	ereportif(Debug_appendonly_print_blockdirectory, LOG,
@@ -1337,3 +1676,316 @@ AppendOnlyBlockDirectory_End_addCol(
 
 	MemoryContextDelete(blockDirectory->memoryContext);
 }
+
+/*
+ * Zone maps
+ *
+ * For column-oriented tables the block directory also records, per entry,
+ * the smallest and largest value and the number of NULLs in the rows the
+ * entry covers.  A sequential scan can then skip the rows of entries whose
+ * range can't satisfy a "column op constant" qual.
+ *
+ * Zones are only kept for types that map onto int64 in sort order.
+ */
+bool
+AppendOnlyBlockDirectory_ZoneTypeSupported(Oid typid)
+{
+	switch (typid)
+	{
+		case INT2OID:
+		case INT4OID:
+		case INT8OID:
+		case DATEOID:
+#ifdef HAVE_INT64_TIMESTAMP
+		case TIMESTAMPOID:
+		case TIMESTAMPTZOID:
+#endif
+			return true;
+		default:
+			return false;
+	}
+}
+
+int64
+AppendOnlyBlockDirectory_ZoneValue(Oid typid, Datum value)
+{
+	switch (typid)
+	{
+		case INT2OID:
+			return (int64) DatumGetInt16(value);
+		case INT4OID:
+			return (int64) DatumGetInt32(value);
+		case INT8OID:
+			return DatumGetInt64(value);
+		case DATEOID:
+			return (int64) DatumGetDateADT(value);
+#ifdef HAVE_INT64_TIMESTAMP
+		case TIMESTAMPOID:
+			return (int64) DatumGetTimestamp(value);
+		case TIMESTAMPTZOID:
+			return (int64) DatumGetTimestampTz(value);
+#endif
+		default:
+			elog(ERROR, "type %u not supported by append-only zone maps", typid);
+			return 0;			/* keep compiler quiet */
+	}
+}
+
+/*
+ * AppendOnlyBlockDirectory_AddZoneValue
+ *
+ * Account for one row of the given column.  Must be called for every row
+ * written (or, when building the directory from a scan, read), otherwise
+ * the zones of the affected entries end up invalid.
+ */
+void
+AppendOnlyBlockDirectory_AddZoneValue(AppendOnlyBlockDirectory *blockDirectory,
+									  int columnGroupNo,
+									  Datum value,
+									  bool isnull)
+{
+	MinipagePerColumnGroup *minipageInfo;
+	MinipageZone *zone;
+	int64		v;
+
+	if (blockDirectory->blkdirRel == NULL ||
+		blockDirectory->blkdirIdx == NULL)
+		return;
+
+	minipageInfo = &blockDirectory->minipages[columnGroupNo];
+	if (minipageInfo->zones == NULL)
+		return;
+
+	zone = &minipageInfo->pendingZone;
+	minipageInfo->pendingRows++;
+
+	if (isnull)
+	{
+		zone->nullCount++;
+		return;
+	}
+
+	v = AppendOnlyBlockDirectory_ZoneValue(minipageInfo->zoneTypid, value);
+	if (!(zone->flags & MINIPAGE_ZONE_HAS_VALUES))
+	{
+		zone->minValue = v;
+		zone->maxValue = v;
+		zone->flags |= MINIPAGE_ZONE_HAS_VALUES;
+	}
+	else if (v < zone->minValue)
+		zone->minValue = v;
+	else if (v > zone->maxValue)
+		zone->maxValue = v;
+}
+
+/*
+ * AppendOnlyBlockDirectory_ZoneExcludes
+ *
+ * Can no row of a zone satisfy the qual?  The operators are strict, so
+ * NULLs never do.
+ */
+bool
+AppendOnlyBlockDirectory_ZoneExcludes(MinipageZone *zone,
+									  AppendOnlyZoneQual *qual)
+{
+	if (!(zone->flags & MINIPAGE_ZONE_VALID))
+		return false;
+
+	if (!(zone->flags & MINIPAGE_ZONE_HAS_VALUES))
+		return true;
+
+	switch (qual->strategy)
+	{
+		case BTLessStrategyNumber:
+			return zone->minValue >= qual->value;
+		case BTLessEqualStrategyNumber:
+			return zone->minValue > qual->value;
+		case BTEqualStrategyNumber:
+			return qual->value < zone->minValue || qual->value > zone->maxValue;
+		case BTGreaterEqualStrategyNumber:
+			return zone->maxValue < qual->value;
+		case BTGreaterStrategyNumber:
+			return zone->maxValue <= qual->value;
+		default:
+			return false;
+	}
+}
+
+/*
+ * AppendOnlyBlockDirectory_GetZones
+ *
+ * Return the valid zones of a column in a segment file, in row number
+ * order.  Entries at or beyond eof are left over from aborted inserts and
+ * are ignored, as in extract_minipage().
+ */
+AppendOnlyBlockDirectoryZone *
+AppendOnlyBlockDirectory_GetZones(Relation aoRel,
+								  Snapshot appendOnlyMetaDataSnapshot,
+								  int segno,
+								  int columnGroupNo,
+								  int64 eof,
+								  int *numZones)
+{
+	Relation	blkdirRel;
+	Relation	blkdirIdx;
+	TupleDesc	heapTupleDesc;
+	ScanKeyData scanKeys[2];
+	IndexScanDesc idxScanDesc;
+	HeapTuple	tuple;
+	AppendOnlyBlockDirectoryZone *zones = NULL;
+	int			maxZones = 0;
+
+	*numZones = 0;
+
+	if (!OidIsValid(aoRel->rd_appendonly->blkdirrelid) ||
+		!OidIsValid(aoRel->rd_appendonly->blkdiridxid))
+		return NULL;
+
+	blkdirRel = heap_open(aoRel->rd_appendonly->blkdirrelid, AccessShareLock);
+	blkdirIdx = index_open(aoRel->rd_appendonly->blkdiridxid, AccessShareLock);
+	heapTupleDesc = RelationGetDescr(blkdirRel);
+
+	ScanKeyInit(&scanKeys[0],
+				Anum_pg_aoblkdir_segno,
+				BTEqualStrategyNumber, F_INT4EQ,
+				Int32GetDatum(segno));
+	ScanKeyInit(&scanKeys[1],
+				Anum_pg_aoblkdir_columngroupno,
+				BTEqualStrategyNumber, F_INT4EQ,
+				Int32GetDatum(columnGroupNo));
+
+	idxScanDesc = index_beginscan(blkdirRel, blkdirIdx,
+								  appendOnlyMetaDataSnapshot,
+								  2, scanKeys);
+
+	while ((tuple = index_getnext(idxScanDesc, ForwardScanDirection)) != NULL)
+	{
+		bool		isnull;
+		Datum		d;
+		struct varlena *value;
+		Minipage   *minipage;
+		MinipageZone *minipageZones;
+		uint32		i;
+
+		d = heap_getattr(tuple, Anum_pg_aoblkdir_minipage,
+						 heapTupleDesc, &isnull);
+		Assert(!isnull);
+		value = pg_detoast_datum((struct varlena *) DatumGetPointer(d));
+		minipage = (Minipage *) value;
+
+		if (minipage->version >= MINIPAGE_VERSION_ZONES)
+		{
+			minipageZones = (MinipageZone *)
+				(((char *) minipage) + minipage_size(minipage->nEntry));
+
+			for (i = 0; i < minipage->nEntry; i++)
+			{
+				if (minipage->entry[i].fileOffset >= eof ||
+					!(minipageZones[i].flags & MINIPAGE_ZONE_VALID))
+					continue;
+
+				if (*numZones >= maxZones)
+				{
+					maxZones = (maxZones == 0) ? 64 : maxZones * 2;
+					if (zones == NULL)
+						zones = palloc(maxZones * sizeof(AppendOnlyBlockDirectoryZone));
+					else
+						zones = repalloc(zones, maxZones * sizeof(AppendOnlyBlockDirectoryZone));
+				}
+				zones[*numZones].firstRowNum = minipage->entry[i].firstRowNum;
+				zones[*numZones].rowCount = minipage->entry[i].rowCount;
+				zones[*numZones].zone = minipageZones[i];
+				(*numZones)++;
+			}
+		}
+
+		if ((Pointer) value != DatumGetPointer(d))
+			pfree(value);
+	}
+
+	index_endscan(idxScanDesc);
+	index_close(blkdirIdx, AccessShareLock);
+	heap_close(blkdirRel, AccessShareLock);
+
+	return zones;
+}
+
+static void
+zone_reset(MinipageZone *zone)
+{
+	zone->minValue = 0;
+	zone->maxValue = 0;
+	zone->nullCount = 0;
+	zone->flags = MINIPAGE_ZONE_VALID;
+}
+
+/*
+ * Fold src into dst.  The result is only valid if both were.
+ */
+static void
+zone_merge(MinipageZone *dst, MinipageZone *src)
+{
+	if (!(dst->flags & MINIPAGE_ZONE_VALID) ||
+		!(src->flags & MINIPAGE_ZONE_VALID))
+	{
+		dst->flags = 0;
+		return;
+	}
+
+	if (src->flags & MINIPAGE_ZONE_HAS_VALUES)
+	{
+		if (!(dst->flags & MINIPAGE_ZONE_HAS_VALUES))
+		{
+			dst->minValue = src->minValue;
+			dst->maxValue = src->maxValue;
+			dst->flags |= MINIPAGE_ZONE_HAS_VALUES;
+		}
+		else
+		{
+			if (src->minValue < dst->minValue)
+				dst->minValue = src->minValue;
+			if (src->maxValue > dst->maxValue)
+				dst->maxValue = src->maxValue;
+		}
+	}
+	dst->nullCount += src->nullCount;
+}
+
+/*
+ * Hand out the pending zone as the zone of a block of expectedRows rows,
+ * and start a new pending zone.
+ */
+static void
+take_pending_zone(MinipagePerColumnGroup *minipageInfo,
+				  int64 expectedRows,
+				  MinipageZone *zone)
+{
+	*zone = minipageInfo->pendingZone;
+	if (minipageInfo->zones == NULL ||
+		minipageInfo->pendingRows != expectedRows)
+		zone->flags = 0;
+
+	zone_reset(&minipageInfo->pendingZone);
+	minipageInfo->pendingRows = 0;
+}
+
+/*
+ * When the zone values are fed after their entry was inserted, fold what
+ * was fed since into the latest entry.
+ */
+static void
+flush_pending_zone(MinipagePerColumnGroup *minipageInfo)
+{
+	MinipageZone blockZone;
+
+	if (minipageInfo->zones == NULL ||
+		minipageInfo->numMinipageEntries == 0 ||
+		minipageInfo->pendingExpectedRows == 0)
+		return;
+
+	take_pending_zone(minipageInfo, minipageInfo->pendingExpectedRows,
+					  &blockZone);
+	zone_merge(&minipageInfo->zones[minipageInfo->numMinipageEntries - 1],
+			   &blockZone);
+	minipageInfo->pendingExpectedRows = 0;
+}
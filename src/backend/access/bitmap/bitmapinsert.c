@@ -93,12 +93,13 @@ static void buf_make_space(Relation rel,
 					  BMTidBuildBuf *tidLocsBuffer, bool use_wal);
 static void verify_bitmappages(Relation rel, BMLOVItem lovitem);
 static int16 buf_add_tid_with_fill(Relation rel, BMTIDBuffer *buf,
-								   Buffer lovBuffer, OffsetNumber off,
-								   uint64 tidnum, bool use_wal);
+								   Buffer lovBuffer, BlockNumber lovBlock,
+								   OffsetNumber off, uint64 tidnum,
+								   bool use_wal);
 static uint16 buf_extend(BMTIDBuffer *buf);
 static uint16 buf_ensure_head_space(Relation rel, BMTIDBuffer *buf,
-								   Buffer lovBuffer, OffsetNumber off,
-								   bool use_wal);
+								   Buffer lovBuffer, BlockNumber lovBlock,
+								   OffsetNumber off, bool use_wal);
 static uint16 buf_free_mem_block(Relation rel, BMTIDBuffer *buf,
 			  			         Buffer lovBuffer, OffsetNumber off,
 						         bool use_wal);
@@ -1723,13 +1724,14 @@ buf_add_tid(Relation rel, BMTidBuildBuf *tids, uint64 tidnum,
 
 	if (lov_buf->bufs[off - 1])
 	{
-
 		buf = lov_buf->bufs[off - 1];
 
-		Buffer lovbuf = _bitmap_getbuf(rel, lov_block, BM_WRITE);
-		buf_add_tid_with_fill(rel, buf, lovbuf, off,
+		/*
+		 * Most tids only go into the buffer; the LOV page is only locked
+		 * when some of the buffered words have to be written out.
+		 */
+		buf_add_tid_with_fill(rel, buf, InvalidBuffer, lov_block, off,
 							  tidnum, state->use_wal);
-		_bitmap_relbuf(lovbuf);
 	}
 	else
 	{
@@ -1757,7 +1759,7 @@ buf_add_tid(Relation rel, BMTidBuildBuf *tids, uint64 tidnum,
 		buf->curword = 0;
 		buf->start_wordno = 0;
 
-		buf_add_tid_with_fill(rel, buf, lovbuf, off, tidnum,
+		buf_add_tid_with_fill(rel, buf, lovbuf, lov_block, off, tidnum,
 							  state->use_wal);
 
 		_bitmap_relbuf(lovbuf);
@@ -1770,14 +1772,17 @@ buf_add_tid(Relation rel, BMTidBuildBuf *tids, uint64 tidnum,
 /*
  * buf_add_tid_with_fill() -- Worker for buf_add_tid().
  *
+ * lovBuffer is the LOV page, locked by the caller, or InvalidBuffer to have
+ * lovBlock locked only if words need to be written out.
+ *
  * Return how many bytes are used. Since we move words to disk when
  * there is no space left for new header words, this returning number
  * can be negative.
  */
 static int16
 buf_add_tid_with_fill(Relation rel, BMTIDBuffer *buf,
-					  Buffer lovBuffer, OffsetNumber off,
-					  uint64 tidnum, bool use_wal)
+					  Buffer lovBuffer, BlockNumber lovBlock,
+					  OffsetNumber off, uint64 tidnum, bool use_wal)
 {
 	int64 zeros;
 	uint16 inserting_pos;
@@ -1821,7 +1826,8 @@ buf_add_tid_with_fill(Relation rel, BMTIDBuffer *buf,
 			 * last bitmap complete word.
 			 */
 			bytes_used -=
-				buf_ensure_head_space(rel, buf, lovBuffer, off, use_wal);
+				buf_ensure_head_space(rel, buf, lovBuffer, lovBlock, off,
+									  use_wal);
 
 			bytes_used += mergewords(buf, false);
 			zeros -= zerosNeeded;
@@ -1848,7 +1854,8 @@ buf_add_tid_with_fill(Relation rel, BMTIDBuffer *buf,
 			buf->last_word = BM_MAKE_FILL_WORD(0, numOfFillWords);
 
 			bytes_used -= 
-				buf_ensure_head_space(rel, buf, lovBuffer, off, use_wal);
+				buf_ensure_head_space(rel, buf, lovBuffer, lovBlock, off,
+									  use_wal);
 			bytes_used += mergewords(buf, true);
 
 			numOfTotalFillWords -= numOfFillWords;
@@ -1878,7 +1885,8 @@ buf_add_tid_with_fill(Relation rel, BMTIDBuffer *buf,
 		}
 
 		bytes_used -=
-			buf_ensure_head_space(rel, buf, lovBuffer, off, use_wal);
+			buf_ensure_head_space(rel, buf, lovBuffer, lovBlock, off,
+									  use_wal);
 		bytes_used += mergewords(buf, lastWordFill);
 	}
 
@@ -1892,11 +1900,14 @@ buf_add_tid_with_fill(Relation rel, BMTIDBuffer *buf,
  * move words in the given buffer to disk and free the existing space,
  * and then allocate new space for future new words.
  *
+ * If lovBuffer is InvalidBuffer, the LOV page lovBlock is locked here.
+ *
  * The number of bytes freed are returned.
  */
 static uint16
 buf_ensure_head_space(Relation rel, BMTIDBuffer *buf, 
-					  Buffer lovBuffer, OffsetNumber off, bool use_wal)
+					  Buffer lovBuffer, BlockNumber lovBlock,
+					  OffsetNumber off, bool use_wal)
 {
 	uint16 bytes_freed = 0;
 
@@ -1904,7 +1915,10 @@ buf_ensure_head_space(Relation rel, BMTIDBuffer *buf,
 
 	if (buf->curword >= (BM_NUM_OF_HEADER_WORDS * BM_HRL_WORD_SIZE))
 	{
-		bytes_freed = buf_free_mem_block(rel, buf, lovBuffer, off, use_wal);
+		if (BufferIsValid(lovBuffer))
+			bytes_freed = buf_free_mem_block(rel, buf, lovBuffer, off, use_wal);
+		else
+			bytes_freed = buf_free_mem(rel, buf, lovBlock, off, use_wal);
 		bytes_freed -= buf_extend(buf);
 	}
 
@@ -2123,7 +2137,8 @@ insertsetbit(Relation rel, BlockNumber lovBlock, OffsetNumber lovOffset,
 	 * To insert this new set bit, we also need to add all zeros between
 	 * this set bit and last set bit. We construct all new words here.
 	 */
-	buf_add_tid_with_fill(rel, buf, lovBuffer, lovOffset, tidnum, use_wal);
+	buf_add_tid_with_fill(rel, buf, lovBuffer, lovBlock, lovOffset, tidnum,
+						  use_wal);
 	
 	/*
 	 * If there are only updates to the last bitmap complete word and
@@ -2216,6 +2231,28 @@ _bitmap_write_alltids(Relation rel, BMTidBuildBuf *tids,
 	tids->byte_size = 0;
 }
 
+/*
+ * build_create_lovitem() -- create the LOV item of a new value during the
+ *	bitmap index construction.
+ *
+ * The metapage is only needed, and locked, while a LOV item is created.
+ */
+static void
+build_create_lovitem(Relation rel, uint64 tidnum, TupleDesc tupDesc,
+					 Datum *attdata, bool *nulls, BMBuildState *state,
+					 BlockNumber *lovBlockP, OffsetNumber *lovOffsetP)
+{
+	Buffer		metabuf;
+
+	MIRROREDLOCK_BUFMGR_MUST_ALREADY_BE_HELD;
+
+	metabuf = _bitmap_getbuf(rel, BM_METAPAGE, BM_WRITE);
+	create_lovitem(rel, metabuf, tidnum, tupDesc, attdata, nulls,
+				   state->bm_lov_heap, state->bm_lov_index,
+				   lovBlockP, lovOffsetP, state->use_wal);
+	_bitmap_wrtbuf(metabuf);
+}
+
 /*
  * build_inserttuple() -- insert a new tuple into the bitmap index
  *	during the bitmap index construction.
@@ -2229,6 +2266,9 @@ _bitmap_write_alltids(Relation rel, BMTidBuildBuf *tids,
  *
  * If this insertion causes the buffer to overflow, we write tid locations
  * for enough distinct values to disk to accommodate this new tuple.
+ *
+ * No page is locked for a tuple whose value already has a LOV item and
+ * whose tid fits in the buffer.
  */
 static void
 build_inserttuple(Relation rel, uint64 tidnum,
@@ -2237,7 +2277,6 @@ build_inserttuple(Relation rel, uint64 tidnum,
 {
 	MIRROREDLOCK_BUFMGR_DECLARE;
 
-	Buffer 			metabuf;
 	BlockNumber		lovBlock;
 	OffsetNumber	lovOffset;
 	bool			blockNull;
@@ -2264,8 +2303,6 @@ build_inserttuple(Relation rel, uint64 tidnum,
 	// -------- MirroredLock ----------
 	MIRROREDLOCK_BUFMGR_LOCK;
 	
-	metabuf = _bitmap_getbuf(rel, BM_METAPAGE, BM_WRITE);
-	
 	/*
 	 * if the inserting tuple has the value of NULL, then
 	 * the corresponding tid array is the first.
@@ -2305,9 +2342,8 @@ build_inserttuple(Relation rel, uint64 tidnum,
 				 * If the inserting tuple has a new value, then we create a new
 				 * LOV item.
 				 */
-				create_lovitem(rel, metabuf, tidnum, tupDesc, attdata, 
-							   nulls, state->bm_lov_heap, state->bm_lov_index,
-							   &lovBlock, &lovOffset, state->use_wal);
+				build_create_lovitem(rel, tidnum, tupDesc, attdata, nulls,
+									 state, &lovBlock, &lovOffset);
 
 				lov = (BMBuildLovData *) (((char*)entry) + state->lovitem_hashKeySize );
 				lov->lov_block = lovBlock;
@@ -2355,15 +2391,13 @@ build_inserttuple(Relation rel, uint64 tidnum,
 				 * If the inserting tuple has a new value, then we create a new
 				 * LOV item.
 				 */
-				create_lovitem(rel, metabuf, tidnum, tupDesc, attdata, 
-							   nulls, state->bm_lov_heap, state->bm_lov_index,
-							   &lovBlock, &lovOffset, state->use_wal);
+				build_create_lovitem(rel, tidnum, tupDesc, attdata, nulls,
+									 state, &lovBlock, &lovOffset);
 			}
 		}
 	}
 
 	buf_add_tid(rel, tidLocsBuffer, tidnum, state, lovBlock, lovOffset);
-	_bitmap_wrtbuf(metabuf);
 
 	CHECK_FOR_INTERRUPTS();
 	
@@ -18,6 +18,10 @@
 #include "postgres.h"
 #include "miscadmin.h"
 
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
 #include "access/genam.h"
 #include "access/bitmap.h"
 #include "access/heapam.h"
@@ -26,6 +30,10 @@
 static void _bitmap_findnextword(BMBatchWords* words, uint64 nextReadNo);
 static void _bitmap_resetWord(BMBatchWords *words, uint32 prevStartNo);
 static uint8 _bitmap_find_bitset(BM_HRL_WORD word, uint8 lastPos);
+static uint32 count_literal_words(BMBatchWords *words);
+static void or_words(BM_HRL_WORD *dst, const BM_HRL_WORD *src, uint32 n);
+static uint32 union_literal_words(uint32 nbatches, BMBatchWords **batches,
+					BMBatchWords *result, uint64 nextReadNo);
 
 /*
  * _bitmap_formitem() -- construct a LOV entry.
@@ -551,6 +559,106 @@ fast_forward(uint32 nbatches, BMBatchWords **batches, BMBatchWords *result)
 	return batches[0]->nextread;
 }
 
+/*
+ * count_literal_words() -- the number of literal words from the read
+ * position of a batch, up to the next fill word.
+ *
+ * Looks at the header words rather than at one header bit at a time.
+ */
+static uint32
+count_literal_words(BMBatchWords *words)
+{
+	uint32		n = words->startNo;
+	uint32		end = words->startNo + words->nwords;
+
+	while (n < end)
+	{
+		/* shift the header bit of word n to the leftmost position */
+		BM_HRL_WORD h = words->hwords[n / BM_HRL_WORD_SIZE] <<
+			(n % BM_HRL_WORD_SIZE);
+
+		if (h != 0)
+		{
+			n += __builtin_clzll(h);
+			break;
+		}
+		n += BM_HRL_WORD_SIZE - (n % BM_HRL_WORD_SIZE);
+	}
+
+	return Min(n, end) - words->startNo;
+}
+
+/*
+ * or_words() -- OR 'n' literal words of 'src' into 'dst', two at a time
+ * where SSE2 is available.
+ */
+static void
+or_words(BM_HRL_WORD *dst, const BM_HRL_WORD *src, uint32 n)
+{
+	uint32		i = 0;
+
+#ifdef __SSE2__
+	for (; i + 2 <= n; i += 2)
+	{
+		__m128i		a = _mm_loadu_si128((const __m128i *) (dst + i));
+		__m128i		b = _mm_loadu_si128((const __m128i *) (src + i));
+
+		_mm_storeu_si128((__m128i *) (dst + i), _mm_or_si128(a, b));
+	}
+#endif
+	for (; i < n; i++)
+		dst[i] |= src[i];
+}
+
+/*
+ * union_literal_words() -- OR together the literal words that all batches
+ * have at position 'nextReadNo', and append them to the result.
+ *
+ * Returns the number of words ORed, 0 if some batch has no words or a fill
+ * word at that position; _bitmap_union() then handles the next word one
+ * batch at a time.
+ */
+static uint32
+union_literal_words(uint32 nbatches, BMBatchWords **batches,
+					BMBatchWords *result, uint64 nextReadNo)
+{
+	uint32		run = result->maxNumOfWords - result->nwords;
+	BM_HRL_WORD *dst;
+	uint32		i;
+
+	for (i = 0; i < nbatches && run > 0; i++)
+	{
+		BMBatchWords *bch = batches[i];
+		uint32		nliteral;
+
+		/* skip nextReadNo - nwordsread - 1 words */
+		_bitmap_findnextword(bch, nextReadNo);
+
+		nliteral = count_literal_words(bch);
+		if (nliteral < run)
+			run = nliteral;
+	}
+
+	if (run == 0)
+		return 0;
+
+	dst = result->cwords + result->nwords;
+	memcpy(dst, batches[0]->cwords + batches[0]->startNo,
+		   run * sizeof(BM_HRL_WORD));
+	for (i = 1; i < nbatches; i++)
+		or_words(dst, batches[i]->cwords + batches[i]->startNo, run);
+
+	for (i = 0; i < nbatches; i++)
+	{
+		batches[i]->startNo += run;
+		batches[i]->nwords -= run;
+		batches[i]->nwordsread += run;
+	}
+	result->nwords += run;
+
+	return run;
+}
+
 /*
  * _bitmap_union() -- union 'numBatches' bitmaps
  *
@@ -584,6 +692,18 @@ _bitmap_union(BMBatchWords **batches, uint32 numBatches, BMBatchWords *result)
 		BM_HRL_WORD orWord = LITERAL_ALL_ZERO;
 		BM_HRL_WORD	word;
 		bool		orWordIsLiteral = true;
+		uint32		nliteral;
+
+		/*
+		 * Where all batches have literal words, OR them together a run at a
+		 * time rather than word by word.
+		 */
+		nliteral = union_literal_words(numBatches, batches, result, nextReadNo);
+		if (nliteral > 0)
+		{
+			nextReadNo += nliteral;
+			continue;
+		}
 
 		for (batchNo = 0; batchNo < numBatches; batchNo++)
 		{
@@ -761,23 +881,16 @@ static uint8
 _bitmap_find_bitset(BM_HRL_WORD word, uint8 lastPos)
 {
 	uint8 pos = lastPos + 1;
-	BM_HRL_WORD	rightmostBitWord;
 
 	if (pos > BM_HRL_WORD_SIZE)
 	  return 0;
 
-	rightmostBitWord = (((BM_HRL_WORD)1) << (pos-1));
-
-	while (pos <= BM_HRL_WORD_SIZE && (word & rightmostBitWord) == 0)
-	{
-		rightmostBitWord <<= 1;
-		pos++;
-	}
-
-	if (pos > BM_HRL_WORD_SIZE)
-		pos = 0;
+	/* clear the bits up to 'lastPos' */
+	word &= ~((BM_HRL_WORD)0) << (pos-1);
+	if (word == 0)
+		return 0;
 
-	return pos;
+	return __builtin_ctzll(word) + 1;
 }
 
 /*
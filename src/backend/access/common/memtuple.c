@@ -13,6 +13,7 @@
 
 #include "postgres.h"
 
+#include "access/htup.h"
 #include "access/memtup.h"
 #include "access/tupmacs.h"
 #include "access/transam.h"
@@ -56,6 +57,13 @@
  * we use the null_saves in the binding to figure out how many columns that is
  * physically precedes the attribute is null and how much space we have saved,
  * then we use off minus saved bytes to find the attribute.
+ *
+ * Varlena attributes are already found through their offset in the fixed
+ * len area, so the only per-attribute cost that grows with the number of
+ * columns is summing the null saves of the preceding bitmap bytes.  When
+ * deforming several attributes, memtuple_get_values() sums them once per
+ * tuple, into a table of the space saved before each bitmap byte, which
+ * makes each attribute constant-time to locate.
  */
 
 static int
@@ -532,16 +540,22 @@ static inline char* memtuple_get_attr_ptr(char *start, MemTupleAttrBinding *bind
 	return start + bind->offset - ns;
 }
 
-static inline char* memtuple_get_attr_data_ptr(char *start, MemTupleAttrBinding *bind, short *null_saves, unsigned char* nullp)
+/* Follow the varlena offset stored at attrp, if the attr is a varlena */
+static inline char* memtuple_attr_data_ptr(char *start, MemTupleAttrBinding *bind, char *attrp)
 {
 	if(bind->flag == MTB_ByVal_Native || bind->flag == MTB_ByVal_Ptr)
-		return memtuple_get_attr_ptr(start, bind, null_saves, nullp);
+		return attrp;
 
 	if(bind->len == 2)
-		return start + (*(uint16 *) memtuple_get_attr_ptr(start, bind, null_saves, nullp));
+		return start + (*(uint16 *) attrp);
 
 	Assert(bind->len == 4);
-	return start + (*(uint32 *) memtuple_get_attr_ptr(start, bind, null_saves, nullp));
+	return start + (*(uint32 *) attrp);
+}
+
+static inline char* memtuple_get_attr_data_ptr(char *start, MemTupleAttrBinding *bind, short *null_saves, unsigned char* nullp)
+{
+	return memtuple_attr_data_ptr(start, bind, memtuple_get_attr_ptr(start, bind, null_saves, nullp));
 }
 
 static inline unsigned char *memtuple_get_nullp(MemTuple mtup, MemTupleBinding *pbind)
@@ -958,16 +972,71 @@ MemTuple memtuple_copy_to(MemTuple mtup, MemTuple dest, uint32 *destlen)
 	return dest;
 }
 
-static void memtuple_get_values(MemTuple mtup, MemTupleBinding *pbind, Datum *datum, bool *isnull, bool use_null_saves_aligned)
+/*
+ * Extract the first natts attributes.  Unlike calling memtuple_getattr()
+ * for each of them, the space saved by nulls is summed up once for the
+ * whole null bitmap, so this is linear rather than quadratic in the number
+ * of attributes of a tuple that has nulls.
+ */
+static void memtuple_get_values(MemTuple mtup, MemTupleBinding *pbind, int natts, Datum *datum, bool *isnull, bool use_null_saves_aligned)
 {
+	bool hasnull = memtuple_get_hasnull(mtup);
+	unsigned char *nullp = hasnull ? memtuple_get_nullp(mtup, pbind) : NULL;
+	char *start = (char *) mtup + (hasnull ? pbind->null_bitmap_extra_size : 0);
+	MemTupleBindingCols *colbind = memtuple_get_islarge(mtup) ? &pbind->large_bind : &pbind->bind;
+	short *null_saves = (use_null_saves_aligned ? colbind->null_saves_aligned : colbind->null_saves);
+	int null_save_before[(MaxTupleAttributeNumber + 7) / 8];
 	int i;
-	for(i=0; i<pbind->tupdesc->natts; ++i)
-		datum[i] = memtuple_getattr_by_alignment(mtup, pbind, i+1, &isnull[i], use_null_saves_aligned);
+
+	Assert(natts <= pbind->tupdesc->natts);
+	Assert(null_saves);
+
+	if(hasnull)
+	{
+		int nbytes = memtuple_get_nullp_len(pbind);
+		int ns = 0;
+
+		for(i=0; i<nbytes; ++i)
+		{
+			null_save_before[i] = ns;
+			ns += compute_null_save_b(null_saves + 32 * i, nullp[i]);
+		}
+	}
+
+	for(i=0; i<natts; ++i)
+	{
+		MemTupleAttrBinding *attrbind = &(colbind->bindings[i]);
+		char *attrp = start + attrbind->offset;
+
+		if(hasnull)
+		{
+			int nbyte = attrbind->null_byte;
+
+			if(nullp[nbyte] & attrbind->null_mask)
+			{
+				datum[i] = 0;
+				isnull[i] = true;
+				continue;
+			}
+
+			attrp -= null_save_before[nbyte] +
+				compute_null_save_b(null_saves + 32 * nbyte, nullp[nbyte] & (attrbind->null_mask - 1));
+		}
+
+		isnull[i] = false;
+		datum[i] = fetchatt(pbind->tupdesc->attrs[i], memtuple_attr_data_ptr(start, attrbind, attrp));
+	}
 }
 
 void memtuple_deform(MemTuple mtup, MemTupleBinding *pbind, Datum *datum, bool *isnull)
 {
-	memtuple_get_values(mtup, pbind, datum, isnull, true /* aligned */);
+	memtuple_get_values(mtup, pbind, pbind->tupdesc->natts, datum, isnull, true /* aligned */);
+}
+
+/* Extract the first natts attributes, see memtuple_get_values() */
+void memtuple_getattrs(MemTuple mtup, MemTupleBinding *pbind, int natts, Datum *datum, bool *isnull)
+{
+	memtuple_get_values(mtup, pbind, natts, datum, isnull, true /* aligned */);
 }
 
 
@@ -983,7 +1052,7 @@ void
 memtuple_deform_misaligned(MemTuple mtup, MemTupleBinding *pbind,
 						   Datum *datum, bool *isnull)
 {
-	memtuple_get_values(mtup, pbind, datum, isnull, false /* aligned */);
+	memtuple_get_values(mtup, pbind, pbind->tupdesc->natts, datum, isnull, false /* aligned */);
 }
 
 /*
@@ -207,6 +207,7 @@ setDefaultAOStorageOpts(StdRdOptions *copy)
 }
 
 static int setDefaultCompressionLevel(char* compresstype);
+static int maxCompressionLevel(char *compresstype);
 
 /*
  * Transform a relation options list (list of DefElem) into the text array
@@ -1001,7 +1002,8 @@ parse_validate_reloptions(StdRdOptions *result, Datum reloptions,
 			SOPT_COMPTYPE,
 			SOPT_COMPLEVEL,
 			SOPT_CHECKSUM,
-			SOPT_ORIENTATION
+			SOPT_ORIENTATION,
+			SOPT_KEEPCACHED
 	};
 	char	   *values[ARRAY_SIZE(default_keywords)];
 	int			j = 0;
@@ -1109,14 +1111,16 @@ parse_validate_reloptions(StdRdOptions *result, Datum reloptions,
 			ereport(ERROR,
 					(errcode(ERRCODE_INVALID_PARAMETER_VALUE),
 					 errmsg("compresstype can\'t be used with compresslevel 0")));
-		if (result->compresslevel < 0 || result->compresslevel > 9)
+		if (result->compresslevel < 0 ||
+			result->compresslevel > maxCompressionLevel(result->compresstype))
 		{
 			if (validate)
 				ereport(ERROR,
 						(errcode(ERRCODE_INVALID_PARAMETER_VALUE),
 						 errmsg("compresslevel=%d is out of range (should be "
-								"between 0 and 9)",
-								result->compresslevel)));
+								"between 0 and %d)",
+								result->compresslevel,
+								maxCompressionLevel(result->compresstype))));
 
 			result->compresslevel = setDefaultCompressionLevel(
 					result->compresstype);
@@ -1228,6 +1232,30 @@ parse_validate_reloptions(StdRdOptions *result, Datum reloptions,
 		}
 	}
 
+	/* keep_cached */
+	if (values[7] != NULL)
+	{
+		if (relkind != RELKIND_RELATION && validate)
+			ereport(ERROR,
+					(errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+					 errmsg("usage of parameter \"keep_cached\" in a non "
+							"relation object is not supported")));
+
+		if (result->appendonly && validate)
+			ereport(ERROR,
+					(errcode(ERRCODE_GP_FEATURE_NOT_SUPPORTED),
+					 errmsg("invalid option \"keep_cached\" for Append Only "
+							"relations. Only valid for heap relations")));
+
+		if (!parse_bool(values[7], &result->keep_cached) && validate)
+		{
+			ereport(ERROR,
+					(errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+					 errmsg("invalid parameter value for \"keep_cached\": \"%s\"",
+							values[7])));
+		}
+	}
+
 	if (result->appendonly && result->compresstype != NULL)
 		if (result->compresslevel == AO_DEFAULT_COMPRESSLEVEL)
 			result->compresslevel = setDefaultCompressionLevel(
@@ -1334,6 +1362,8 @@ void validateAppendOnlyRelOptions(bool ao,
 	if (comptype &&
 		(pg_strcasecmp(comptype, "quicklz") == 0 ||
 		 pg_strcasecmp(comptype, "zlib") == 0 ||
+		 pg_strcasecmp(comptype, "zstd") == 0 ||
+		 pg_strcasecmp(comptype, "lz4") == 0 ||
 		 pg_strcasecmp(comptype, "rle_type") == 0))
 	{
 
@@ -1351,11 +1381,11 @@ void validateAppendOnlyRelOptions(bool ao,
 					(errcode(ERRCODE_INVALID_PARAMETER_VALUE),
 					 errmsg("compresstype cannot be used with compresslevel 0")));
 
-		if (complevel < 0 || complevel > 9)
+		if (complevel < 0 || complevel > maxCompressionLevel(comptype))
 			ereport(ERROR,
 					(errcode(ERRCODE_INVALID_PARAMETER_VALUE),
-					 errmsg("compresslevel=%d is out of range (should be between 0 and 9)",
-							complevel)));
+					 errmsg("compresslevel=%d is out of range (should be between 0 and %d)",
+							complevel, maxCompressionLevel(comptype))));
 
 		if (comptype && (pg_strcasecmp(comptype, "quicklz") == 0) &&
 			(complevel != 1))
@@ -1397,9 +1427,21 @@ void validateAppendOnlyRelOptions(bool ao,
 						blocksize, gp_safefswritesize)));
 }
 
+/*
+ * Highest compresslevel accepted for a compressor.  zstd goes up to 19,
+ * everything else tops out at 9.
+ */
+static int
+maxCompressionLevel(char *compresstype)
+{
+	if (compresstype && pg_strcasecmp(compresstype, "zstd") == 0)
+		return 19;
+	return 9;
+}
+
 /*
  * if no compressor type was specified, we set to no compression (level 0)
- * otherwise default for both zlib, quicklz and RLE to level 1.
+ * otherwise default for zlib, zstd, lz4, quicklz and RLE to level 1.
  */
 static int setDefaultCompressionLevel(char* compresstype)
 {
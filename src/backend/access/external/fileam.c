@@ -119,7 +119,8 @@ elog(DEBUG2, "external_getnext returning tuple")
 FileScanDesc
 external_beginscan(Relation relation, Index scanrelid, uint32 scancounter,
 			   List *uriList, List *fmtOpts, char fmtType, bool isMasterOnly,
-			  int rejLimit, bool rejLimitInRows, Oid fmterrtbl, int encoding)
+			  int rejLimit, bool rejLimitInRows, Oid fmterrtbl, int encoding,
+			  bool *proj, List *quals)
 {
 	FileScanDesc scan;
 	TupleDesc	tupDesc = NULL;
@@ -238,6 +239,9 @@ external_beginscan(Relation relation, Index scanrelid, uint32 scancounter,
 	scan->attr = tupDesc->attrs;
 	scan->num_phys_attrs = tupDesc->natts;
 
+	scan->proj = proj;
+	scan->quals = quals;
+
 	scan->values = (Datum *) palloc(scan->num_phys_attrs * sizeof(Datum));
 	scan->nulls = (bool *) palloc(scan->num_phys_attrs * sizeof(bool));
 
@@ -274,6 +278,8 @@ external_beginscan(Relation relation, Index scanrelid, uint32 scancounter,
 		scan->fs_formatter = (FormatterData *) palloc0(sizeof(FormatterData));
 		initStringInfo(&scan->fs_formatter->fmt_databuf);
 		scan->fs_formatter->fmt_perrow_ctx = scan->fs_pstate->rowcontext;
+		scan->fs_formatter->fmt_proj = proj;
+		scan->fs_formatter->fmt_quals = quals;
 	}
 
 	/* pgstat_initstats(relation); */
@@ -849,6 +855,13 @@ parse_next_line(FileScanDesc scan)
 				char	   *string;
 				bool		isnull;
 
+				/* a column the scan doesn't need stays NULL */
+				if (scan->proj != NULL && !scan->proj[m])
+				{
+					scan->nulls[m] = true;
+					continue;
+				}
+
 				string = pstate->attribute_buf.data + pstate->attr_offsets[m];
 
 				if (!scan->nulls[m])
@@ -1564,6 +1577,9 @@ open_external_readable_source(FileScanDesc scan)
 							  false /* for read */ ,
 							  &extvar,
 							  scan->fs_pstate);
+
+	if (scan->fs_file->type == CFTYPE_CUSTOM)
+		url_custom_set_pushdown(scan->fs_file, scan->proj, scan->quals);
 }
 
 /*
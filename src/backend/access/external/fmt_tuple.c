@@ -0,0 +1,195 @@
+/*-------------------------------------------------------------------------
+ *
+ * fmt_tuple.c
+ *	  Built-in binary formatter for external tables, based on the
+ *	  interconnect's tuple serialization.
+ *
+ * gp_tuple_export() turns each row into the bytes the interconnect would
+ * send for it (see tupser.c), optionally pglz-compressed, and
+ * gp_tuple_import() turns them back into a row.  Moving data this way skips
+ * the per-column text output and input functions entirely, which is what
+ * dominates the cost of a TEXT or CSV transfer between two clusters.
+ *
+ * Each row is written as one line of hex digits.  That costs a factor of
+ * two on the wire, but gpfdist hands out its data to several readers split
+ * at line boundaries, and a raw binary stream would not survive that.  The
+ * data is only readable by a cluster with the same build and platform, with
+ * an identical table definition: it is meant for gptransfer, not archival.
+ *
+ * Usage:
+ *	  FORMAT 'CUSTOM' (FORMATTER=gp_tuple_export [, compress='false'])
+ *	  FORMAT 'CUSTOM' (FORMATTER=gp_tuple_import)
+ *
+ * Portions Copyright (c) 2012-Present Pivotal Software, Inc.
+ *
+ * IDENTIFICATION
+ *	  src/backend/access/external/fmt_tuple.c
+ *
+ *-------------------------------------------------------------------------
+ */
+
+#include "postgres.h"
+
+#include "access/formatter.h"
+#include "cdb/tupser.h"
+#include "funcapi.h"
+#include "utils/builtins.h"
+
+typedef struct TupleFormatState
+{
+	MemoryContext cxt;			/* where the state, and the output, live */
+	SerTupInfo	serInfo;
+	int			natts;
+	bool		compress;		/* export only */
+	StringInfoData raw;			/* serialized row, before hex encoding */
+	bytea	   *out;			/* export result, reused across rows */
+	int			outmax;
+	int			lineno;			/* import only, for error reporting */
+} TupleFormatState;
+
+static TupleFormatState *
+get_tuple_format_state(FunctionCallInfo fcinfo, const char *fname)
+{
+	TupleFormatState *state;
+	TupleDesc	tupdesc;
+	int			i;
+
+	if (!CALLED_AS_FORMATTER(fcinfo))
+		elog(ERROR, "%s: not called by format manager", fname);
+
+	tupdesc = FORMATTER_GET_TUPDESC(fcinfo);
+	state = (TupleFormatState *) FORMATTER_GET_USER_CTX(fcinfo);
+
+	if (state == NULL)
+	{
+		state = palloc0(sizeof(TupleFormatState));
+		state->cxt = CurrentMemoryContext;
+		state->natts = tupdesc->natts;
+		state->compress = true;
+
+		for (i = 1; i <= FORMATTER_GET_NUM_ARGS(fcinfo); i++)
+		{
+			char	   *key = FORMATTER_GET_NTH_ARG_KEY(fcinfo, i);
+			char	   *val = FORMATTER_GET_NTH_ARG_VAL(fcinfo, i);
+
+			if (pg_strcasecmp(key, "compress") == 0 &&
+				!parse_bool(val, &state->compress))
+				ereport(ERROR,
+						(errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+						 errmsg("%s: invalid value for \"compress\": \"%s\"",
+								fname, val)));
+		}
+
+		InitSerTupInfo(tupdesc, &state->serInfo);
+		if (state->serInfo.has_record_types)
+			ereport(ERROR,
+					(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+					 errmsg("%s: record type columns are not supported", fname)));
+
+		initStringInfo(&state->raw);
+
+		FORMATTER_SET_USER_CTX(fcinfo, state);
+	}
+
+	if (state->natts != tupdesc->natts)
+		elog(ERROR, "%s: unexpected change of record type", fname);
+
+	return state;
+}
+
+/*
+ * gp_tuple_export
+ *		Formatter for writable external tables: record -> bytea
+ */
+Datum
+gp_tuple_export(PG_FUNCTION_ARGS)
+{
+	TupleFormatState *state;
+	HeapTupleHeader rec;
+	HeapTupleData tuple;
+	int			outlen;
+	char	   *p;
+
+	state = get_tuple_format_state(fcinfo, "gp_tuple_export");
+
+	rec = PG_GETARG_HEAPTUPLEHEADER(0);
+	tuple.t_len = HeapTupleHeaderGetDatumLength(rec);
+	ItemPointerSetInvalid(&tuple.t_self);
+	tuple.t_data = rec;
+
+	resetStringInfo(&state->raw);
+	SerializeTupleIntoBuffer(&tuple, &state->serInfo, state->compress, &state->raw);
+
+	/*
+	 * The caller resets the per-row context before it looks at our result,
+	 * so the output buffer is kept in the state's context instead.
+	 */
+	outlen = state->raw.len * 2 + 1;
+	if (outlen > state->outmax)
+	{
+		if (state->out)
+			pfree(state->out);
+		state->outmax = Max(outlen, 2 * state->outmax);
+		state->out = MemoryContextAlloc(state->cxt, VARHDRSZ + state->outmax);
+	}
+
+	p = VARDATA(state->out);
+	p += hex_encode(state->raw.data, state->raw.len, p);
+	*p = '\n';
+	SET_VARSIZE(state->out, VARHDRSZ + outlen);
+
+	PG_RETURN_BYTEA_P(state->out);
+}
+
+/*
+ * gp_tuple_import
+ *		Formatter for readable external tables: () -> record
+ */
+Datum
+gp_tuple_import(PG_FUNCTION_ARGS)
+{
+	TupleFormatState *state;
+	TupleDesc	tupdesc;
+	HeapTuple	tuple;
+	MemoryContext oldcxt;
+	char	   *data_buf;
+	char	   *line;
+	char	   *eol;
+	char	   *raw;
+	int			rawlen;
+	int			linelen;
+
+	state = get_tuple_format_state(fcinfo, "gp_tuple_import");
+	tupdesc = FORMATTER_GET_TUPDESC(fcinfo);
+
+	data_buf = FORMATTER_GET_DATABUF(fcinfo);
+	line = data_buf + FORMATTER_GET_DATACURSOR(fcinfo);
+	eol = memchr(line, '\n', FORMATTER_GET_DATALEN(fcinfo) - FORMATTER_GET_DATACURSOR(fcinfo));
+	if (eol == NULL)
+		FORMATTER_RETURN_NOTIFICATION(fcinfo, FMT_NEED_MORE_DATA);
+	linelen = eol - line;
+
+	/* on error, single row error handling skips past this line */
+	FORMATTER_SET_BAD_ROW_NUM(fcinfo, ++state->lineno);
+	FORMATTER_SET_BAD_ROW_DATA(fcinfo, line, linelen + 1);
+
+	oldcxt = MemoryContextSwitchTo(FORMATTER_GET_PER_ROW_MEM_CTX(fcinfo));
+	raw = palloc(linelen / 2 + 1);
+	rawlen = hex_decode(line, linelen, raw);
+	MemoryContextSwitchTo(oldcxt);
+
+	/* the executor frees the tuple, so it must not be in the per-row context */
+	tuple = DeserializeTupleFromBuffer(&state->serInfo, raw, rawlen);
+
+	if (is_heaptuple_memtuple(tuple) ||
+		HeapTupleHeaderGetNatts(tuple->t_data) > tupdesc->natts)
+		ereport(ERROR,
+				(errcode(ERRCODE_INVALID_BINARY_REPRESENTATION),
+				 errmsg("gp_tuple_import: row does not match the table definition")));
+
+	FORMATTER_SET_DATACURSOR(fcinfo, FORMATTER_GET_DATACURSOR(fcinfo) + linelen + 1);
+	FORMATTER_SET_BYTE_NUMBER(fcinfo, linelen + 1);
+	FORMATTER_SET_TUPLE(fcinfo, tuple);
+
+	FORMATTER_RETURN_TUPLE(tuple);
+}
@@ -19,6 +19,7 @@
 
 /* GUC */
 int readable_external_table_timeout = 0;
+bool gpfdist_compress = false;
 
 /*
  * url_fopen
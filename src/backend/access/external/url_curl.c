@@ -21,6 +21,9 @@
 #include <arpa/inet.h>
 
 #include <curl/curl.h>
+#ifdef HAVE_LIBZSTD
+#include <zstd.h>
+#endif
 
 #include "cdb/cdbsreh.h"
 #include "cdb/cdbutil.h"
@@ -40,6 +43,9 @@ typedef struct curlhandle_t
 {
 	CURL	   *handle;		/* The curl handle */
 	struct curl_slist *x_httpheader;	/* list of headers */
+#ifdef HAVE_LIBZSTD
+	ZSTD_DCtx  *zstd_dctx;		/* decompresses 'Z' blocks, created lazily */
+#endif
 	bool		in_multi_handle;	/* T, if the handle is in global
 									 * multi_handle */
 
@@ -91,6 +97,10 @@ typedef struct
 	struct
 	{
 		int			datalen;	/* remaining datablock length */
+		char	   *zdata;		/* decompressed 'Z' block, or NULL */
+		int			zmax;		/* size of zdata[] */
+		int			zbot;		/* next byte of zdata[] to return */
+		bool		zactive;	/* is the current block in zdata[]? */
 	} block;
 
 } URL_CURL_FILE;
@@ -177,6 +187,9 @@ create_curlhandle(void)
 	h = MemoryContextAlloc(TopMemoryContext, sizeof(curlhandle_t));
 	h->handle = NULL;
 	h->x_httpheader = NULL;
+#ifdef HAVE_LIBZSTD
+	h->zstd_dctx = NULL;
+#endif
 	h->in_multi_handle = false;
 
 	h->owner = CurrentResourceOwner;
@@ -206,6 +219,14 @@ destroy_curlhandle(curlhandle_t *h)
 		h->x_httpheader = NULL;
 	}
 
+#ifdef HAVE_LIBZSTD
+	if (h->zstd_dctx)
+	{
+		ZSTD_freeDCtx(h->zstd_dctx);
+		h->zstd_dctx = NULL;
+	}
+#endif
+
 	if (h->handle)
 	{
 		/* If this handle was registered in the multi-handle, remove it */
@@ -1176,6 +1197,10 @@ url_curl_fopen(char *url, bool forwrite, extvar_t *ev, CopyState pstate)
 		set_httpheader(file, "X-GP-USER", ev->GP_USER);
 		set_httpheader(file, "X-GP-SEG-PORT", ev->GP_SEG_PORT);
 		set_httpheader(file, "X-GP-SESSION-ID", ev->GP_SESSION_ID);
+#ifdef HAVE_LIBZSTD
+		if (gpfdist_compress)
+			set_httpheader(file, "X-GP-ZSTD", "1");
+#endif
 	}
 		
 	{
@@ -1389,6 +1414,12 @@ url_curl_fclose(URL_FILE *fileg, bool failOnError, const char *relname)
 		file->curl_url = NULL;
 	}
 
+	if (file->block.zdata)
+	{
+		pfree(file->block.zdata);
+		file->block.zdata = NULL;
+	}
+
 	if (file->out.ptr)
 	{
 		Assert(file->for_write);
@@ -1453,6 +1484,62 @@ gp_proto0_read(char *buf, int bufsz, URL_CURL_FILE *file)
 	return n;
 }
 
+#ifdef HAVE_LIBZSTD
+/*
+ * gp_proto1_decompress
+ *
+ * Decompress a 'Z' block of len bytes into file->block.zdata, from where
+ * gp_proto1_read() returns it like the data of a 'D' block.
+ */
+static void
+gp_proto1_decompress(URL_CURL_FILE *file, int len)
+{
+	unsigned long long rawlen;
+	size_t		n;
+
+	fill_buffer(file, len);
+	if (file->in.top - file->in.bot < len)
+		elog(ERROR, "gpfdist error: stream ends suddenly");
+
+	rawlen = ZSTD_getFrameContentSize(file->in.ptr + file->in.bot, len);
+	if (rawlen == ZSTD_CONTENTSIZE_UNKNOWN || rawlen == ZSTD_CONTENTSIZE_ERROR ||
+		rawlen == 0 || rawlen > MaxAllocSize)
+		elog(ERROR, "gpfdist error: bad compressed data block");
+
+	if (file->curl->zstd_dctx == NULL)
+	{
+		file->curl->zstd_dctx = ZSTD_createDCtx();
+		if (file->curl->zstd_dctx == NULL)
+			ereport(ERROR,
+					(errcode(ERRCODE_OUT_OF_MEMORY),
+					 errmsg("out of memory")));
+	}
+
+	if (file->block.zdata == NULL)
+	{
+		file->block.zdata = palloc(rawlen);
+		file->block.zmax = rawlen;
+	}
+	else if (file->block.zmax < rawlen)
+	{
+		file->block.zdata = repalloc(file->block.zdata, rawlen);
+		file->block.zmax = rawlen;
+	}
+
+	n = ZSTD_decompressDCtx(file->curl->zstd_dctx,
+							file->block.zdata, rawlen,
+							file->in.ptr + file->in.bot, len);
+	if (ZSTD_isError(n) || n != rawlen)
+		elog(ERROR, "gpfdist error: could not decompress data block: %s",
+			 ZSTD_isError(n) ? ZSTD_getErrorName(n) : "short block");
+
+	file->in.bot += len;
+	file->block.datalen = (int) rawlen;
+	file->block.zbot = 0;
+	file->block.zactive = true;
+}
+#endif
+
 /*
  * gp_proto1_read
  *
@@ -1461,6 +1548,9 @@ gp_proto0_read(char *buf, int bufsz, URL_CURL_FILE *file)
  * byte 0: type (can be 'F'ilename, 'O'ffset, 'D'ata, 'E'rror, 'L'inenumber)
  * byte 1-4: length. # bytes of following data block. in network-order.
  * byte 5-X: the block itself.
+ *
+ * If we asked for it with gpfdist_compress, data blocks may also come as
+ * 'Z'std compressed blocks, which are decompressed here in one go.
  */
 static size_t
 gp_proto1_read(char *buf, int bufsz, URL_CURL_FILE *file, CopyState pstate, char *buf2)
@@ -1609,6 +1699,15 @@ gp_proto1_read(char *buf, int bufsz, URL_CURL_FILE *file, CopyState pstate, char
 			break;
 		}
 
+#ifdef HAVE_LIBZSTD
+		/* Compressed data */
+		if (type == 'Z')
+		{
+			gp_proto1_decompress(file, len);
+			break;
+		}
+#endif
+
 		elog(ERROR, "gpfdist error: unknown meta type %d", type);
 	}
 
@@ -1616,6 +1715,15 @@ gp_proto1_read(char *buf, int bufsz, URL_CURL_FILE *file, CopyState pstate, char
 	if (bufsz > file->block.datalen)
 		bufsz = file->block.datalen;
 
+	if (file->block.zactive)
+	{
+		memcpy(buf, file->block.zdata + file->block.zbot, bufsz);
+		file->block.zbot += bufsz;
+		file->block.datalen -= bufsz;
+		file->block.zactive = (file->block.datalen > 0);
+		return bufsz;
+	}
+
 	fill_buffer(file, bufsz);
 	n = file->in.top - file->in.bot;
 
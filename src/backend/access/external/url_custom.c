@@ -92,12 +92,27 @@ url_custom_fopen(char *url, bool forwrite, extvar_t *ev, CopyState pstate)
 	file->extprotocol->prot_last_call = false;
 	file->extprotocol->prot_url = NULL;
 	file->extprotocol->prot_databuf = NULL;
+	file->extprotocol->prot_proj = NULL;
+	file->extprotocol->prot_quals = NIL;
 
 	pfree(prot_name);
 
 	return (URL_FILE *) file;
 }
 
+/*
+ * Let the protocol of a readable table know which columns and quals the
+ * scan has; see ExtProtocolData.
+ */
+void
+url_custom_set_pushdown(URL_FILE *file, bool *proj, List *quals)
+{
+	URL_CUSTOM_FILE   *cfile = (URL_CUSTOM_FILE *) file;
+
+	cfile->extprotocol->prot_proj = proj;
+	cfile->extprotocol->prot_quals = quals;
+}
+
 void
 url_custom_fclose(URL_FILE *file, bool failOnError, const char *relname)
 {
@@ -61,6 +61,7 @@
 #include "utils/syscache.h"
 #include "utils/tqual.h"
 
+#include "cdb/cdbpartition.h"
 #include "cdb/cdbpersistentstore.h"
 #include "cdb/cdbvars.h"
 #include "utils/visibility_summary.h"
@@ -123,6 +124,11 @@ initscan(HeapScanDesc scan, ScanKey key, bool is_rescan)
 	 * these behaviors, independently of the size of the table; also there
 	 * is a GUC variable that can disable synchronized scanning.)
 	 *
+	 * With gp_scan_resistant_buffers, a scan of any user table too large to
+	 * fit in the ring goes through the ring too, so that reporting queries
+	 * over fact tables leave the dimension tables and catalogs cached.  A
+	 * table with keep_cached set never goes through the ring.
+	 *
 	 * During a rescan, don't make a new strategy object if we don't have to.
 	 */
 	if (!scan->rs_rd->rd_istemp &&
@@ -132,8 +138,19 @@ initscan(HeapScanDesc scan, ScanKey key, bool is_rescan)
 		allow_sync = scan->rs_allow_sync;
 	}
 	else
+	{
 		allow_strat = allow_sync = false;
 
+		if (gp_scan_resistant_buffers &&
+			!scan->rs_rd->rd_istemp &&
+			!IsSystemRelation(scan->rs_rd) &&
+			scan->rs_nblocks > GetAccessStrategyRingSize(BAS_BULKREAD))
+			allow_strat = scan->rs_allow_strat;
+	}
+
+	if (RelationKeepCached(scan->rs_rd))
+		allow_strat = false;
+
 	if (allow_strat)
 	{
 		if (scan->rs_strategy == NULL)
@@ -166,6 +183,9 @@ initscan(HeapScanDesc scan, ScanKey key, bool is_rescan)
 		scan->rs_startblock = 0;
 	}
 
+	scan->rs_prefetch_next = 0;
+	scan->rs_prefetch_pages = 0;
+
 	scan->rs_inited = false;
 	scan->rs_ctup.t_data = NULL;
 	ItemPointerSetInvalid(&scan->rs_ctup.t_self);
@@ -190,6 +210,41 @@ initscan(HeapScanDesc scan, ScanKey key, bool is_rescan)
 	pgstat_count_heap_scan(scan->rs_rd);
 }
 
+/*
+ * heapscan_prefetch - ask the kernel for the pages a seqscan is about to read
+ *
+ * Keeps effective_io_concurrency pages ahead of the given one prefetched.
+ * Pages are counted from rs_startblock, because a synchronized scan wraps
+ * around the end of the relation.  Backward scans get no read-ahead.
+ */
+static void
+heapscan_prefetch(HeapScanDesc scan, BlockNumber page)
+{
+	BlockNumber pos;
+	BlockNumber last;
+
+	if (page >= scan->rs_startblock)
+		pos = page - scan->rs_startblock;
+	else
+		pos = page + (scan->rs_nblocks - scan->rs_startblock);
+
+	last = pos + Min((BlockNumber) effective_io_concurrency,
+					 scan->rs_nblocks - 1 - pos);
+
+	if (scan->rs_prefetch_next <= pos)
+		scan->rs_prefetch_next = pos + 1;
+
+	while (scan->rs_prefetch_next <= last)
+	{
+		BlockNumber next = scan->rs_startblock + scan->rs_prefetch_next;
+
+		if (next >= scan->rs_nblocks)
+			next -= scan->rs_nblocks;
+		PrefetchBuffer(scan->rs_rd, next);
+		scan->rs_prefetch_next++;
+	}
+}
+
 /*
  * heapgetpage - subroutine for heapgettup()
  *
@@ -228,6 +283,9 @@ heapgetpage(HeapScanDesc scan, BlockNumber page)
 	 */
 	CHECK_FOR_INTERRUPTS();
 
+	if (effective_io_concurrency > 0)
+		heapscan_prefetch(scan, page);
+
 	/* read page using selected strategy */
 	scan->rs_cbuf = ReadBufferWithStrategy(scan->rs_rd,
 										   page,
@@ -1030,6 +1088,25 @@ try_relation_open(Oid relationId, LOCKMODE lockmode, bool noWait)
 
 
 
+/*
+ * CdbGlobalDeadlockDetectorCovers -- can UPDATE and DELETE on the relation
+ * rely on the global deadlock detector, instead of an ExclusiveLock on the QD,
+ * to get out of distributed deadlocks?
+ *
+ * Only heap tables qualify. Append-only tables need the table lock for their
+ * segment files, and for partitioned tables we don't know up front which
+ * parts a statement will write.
+ */
+bool
+CdbGlobalDeadlockDetectorCovers(Oid relid)
+{
+	if (!gp_enable_global_deadlock_detector)
+		return false;
+
+	return get_rel_relstorage(relid) == RELSTORAGE_HEAP &&
+		!rel_is_partitioned(relid);
+}
+
 /*
  * CdbTryOpenRelation -- Opens a relation with a specified lock mode.
  *
@@ -1061,6 +1138,10 @@ CdbTryOpenRelation(Oid relid, LOCKMODE reqmode, bool noWait, bool *lockUpgraded)
 	 * to the same partitioned table.  
 	 *
 	 * Note: This code could be improved substantiatally.
+	 *
+	 * When the global deadlock detector runs, heap tables that aren't
+	 * partitioned keep the RowExclusiveLock, and the detector breaks any
+	 * deadlock between their writers.
 	 */
 	if (lockmode == RowExclusiveLock)
 	{
@@ -1069,7 +1150,8 @@ CdbTryOpenRelation(Oid relid, LOCKMODE reqmode, bool noWait, bool *lockUpgraded)
 			return NULL;
 		
 		if (rel->rd_cdbpolicy &&
-			rel->rd_cdbpolicy->ptype == POLICYTYPE_PARTITIONED)
+			rel->rd_cdbpolicy->ptype == POLICYTYPE_PARTITIONED &&
+			!CdbGlobalDeadlockDetectorCovers(relid))
 		{
 			lockmode = ExclusiveLock;
 			if (lockUpgraded != NULL)
@@ -1091,7 +1173,8 @@ CdbTryOpenRelation(Oid relid, LOCKMODE reqmode, bool noWait, bool *lockUpgraded)
 	 */
 	if (lockmode == RowExclusiveLock &&
 		rel->rd_cdbpolicy &&
-		rel->rd_cdbpolicy->ptype == POLICYTYPE_PARTITIONED)
+		rel->rd_cdbpolicy->ptype == POLICYTYPE_PARTITIONED &&
+		!CdbGlobalDeadlockDetectorCovers(relid))
 	{
 		elog(ERROR, "relation \"%s\" concurrently updated", 
 			 RelationGetRelationName(rel));
@@ -2213,43 +2296,19 @@ UpdateXmaxHintBits(HeapTupleHeader tuple, Buffer buffer, TransactionId xid, Rela
 }
 
 /*
- *	heap_insert		- insert tuple into a heap
- *
- * The new tuple is stamped with current transaction ID and the specified
- * command ID.
+ * heap_prepare_insert
  *
- * If use_wal is false, the new tuple is not logged in WAL, even for a
- * non-temp relation.  Safe usage of this behavior requires that we arrange
- * that all new tuples go into new pages not containing any tuples from other
- * transactions, and that the relation gets fsync'd before commit.
- * (See also heap_sync() comments)
- *
- * use_fsm is passed directly to RelationGetBufferForTuple, which see for
- * more info.
- *
- * Note that use_wal and use_fsm will be applied when inserting into the
- * heap's TOAST table, too, if the tuple requires any out-of-line data.
- *
- * The return value is the OID assigned to the tuple (either here or by the
- * caller), or InvalidOid if no OID.  The header fields of *tup are updated
- * to match the stored tuple; in particular tup->t_self receives the actual
- * TID where the tuple was stored.	But note that any toasting of fields
- * within the tuple data is NOT reflected into *tup.
+ * Prepare a tuple for insertion into a heap: assign it an OID if the
+ * relation has OIDs, stamp it with the transaction and command IDs, and
+ * toast it if needed. Returns the tuple to store, which is either tup or a
+ * toasted copy of it. Shared by heap_insert and heap_multi_insert.
  */
-Oid
-heap_insert(Relation relation, HeapTuple tup, CommandId cid,
-			bool use_wal, bool use_fsm, TransactionId xid)
+static HeapTuple
+heap_prepare_insert(Relation relation, HeapTuple tup, CommandId cid,
+					bool use_wal, bool use_fsm, TransactionId xid)
 {
-	MIRROREDLOCK_BUFMGR_DECLARE;
-
 	bool		isFrozen = (xid == FrozenTransactionId);
 	HeapTuple	heaptup;
-	Buffer		buffer;
-
-	Insist(RelationIsHeap(relation));
-
-	// Fetch gp_persistent_relation_node information that will be added to XLOG record.
-	RelationFetchGpRelationNodeForXLog(relation);
 
 	if (relation->rd_rel->relhasoids)
 	{
@@ -2320,7 +2379,51 @@ heap_insert(Relation relation, HeapTuple tup, CommandId cid,
 										 use_wal, use_fsm);
 	else
 		heaptup = tup;
-	
+
+	return heaptup;
+}
+
+/*
+ *	heap_insert		- insert tuple into a heap
+ *
+ * The new tuple is stamped with current transaction ID and the specified
+ * command ID.
+ *
+ * If use_wal is false, the new tuple is not logged in WAL, even for a
+ * non-temp relation.  Safe usage of this behavior requires that we arrange
+ * that all new tuples go into new pages not containing any tuples from other
+ * transactions, and that the relation gets fsync'd before commit.
+ * (See also heap_sync() comments)
+ *
+ * use_fsm is passed directly to RelationGetBufferForTuple, which see for
+ * more info.
+ *
+ * Note that use_wal and use_fsm will be applied when inserting into the
+ * heap's TOAST table, too, if the tuple requires any out-of-line data.
+ *
+ * The return value is the OID assigned to the tuple (either here or by the
+ * caller), or InvalidOid if no OID.  The header fields of *tup are updated
+ * to match the stored tuple; in particular tup->t_self receives the actual
+ * TID where the tuple was stored.	But note that any toasting of fields
+ * within the tuple data is NOT reflected into *tup.
+ */
+Oid
+heap_insert(Relation relation, HeapTuple tup, CommandId cid,
+			bool use_wal, bool use_fsm, TransactionId xid)
+{
+	MIRROREDLOCK_BUFMGR_DECLARE;
+
+	bool		isFrozen = (xid == FrozenTransactionId);
+	HeapTuple	heaptup;
+	Buffer		buffer;
+
+	Insist(RelationIsHeap(relation));
+
+	// Fetch gp_persistent_relation_node information that will be added to XLOG record.
+	RelationFetchGpRelationNodeForXLog(relation);
+
+	heaptup = heap_prepare_insert(relation, tup, cid, use_wal, use_fsm, xid);
+
 	// -------- MirroredLock ----------
 	MIRROREDLOCK_BUFMGR_LOCK;
 
@@ -2444,6 +2547,202 @@ heap_insert(Relation relation, HeapTuple tup, CommandId cid,
 	return HeapTupleGetOid(tup);
 }
 
+/*
+ *	heap_multi_insert	- insert multiple tuples into a heap
+ *
+ * This is like calling heap_insert for each tuple, but the tuples are put
+ * on as few pages as possible, and each page is written with a single WAL
+ * record, XLOG_HEAP2_MULTI_INSERT. That saves the per-tuple buffer lookup,
+ * locking and WAL record overhead of heap_insert. The arguments are as for
+ * heap_insert, and t_self of each tuple receives its TID.
+ */
+void
+heap_multi_insert(Relation relation, HeapTuple *tuples, int ntuples,
+				  CommandId cid, bool use_wal, bool use_fsm, TransactionId xid)
+{
+	MIRROREDLOCK_BUFMGR_DECLARE;
+
+	bool		isFrozen = (xid == FrozenTransactionId);
+	bool		needwal;
+	HeapTuple  *heaptuples;
+	char	   *scratch = NULL;
+	Size		saveFreeSpace;
+	int			ndone;
+	int			i;
+
+	Insist(RelationIsHeap(relation));
+
+	// Fetch gp_persistent_relation_node information that will be added to XLOG record.
+	RelationFetchGpRelationNodeForXLog(relation);
+
+	needwal = use_wal && !relation->rd_istemp;
+	saveFreeSpace = RelationGetTargetPageFreeSpace(relation,
+												   HEAP_DEFAULT_FILLFACTOR);
+
+	/* Toast and stamp all the tuples first, no locks are held for that */
+	heaptuples = palloc(ntuples * sizeof(HeapTuple));
+	for (i = 0; i < ntuples; i++)
+		heaptuples[i] = heap_prepare_insert(relation, tuples[i], cid,
+											use_wal, use_fsm, xid);
+
+	/*
+	 * The WAL record of a page is built here. The tuples it describes fit on
+	 * the page, and their WAL headers are smaller than their line pointers
+	 * and tuple headers, so a block is enough.
+	 */
+	if (needwal)
+		scratch = palloc(BLCKSZ);
+
+	ndone = 0;
+	while (ndone < ntuples)
+	{
+		Buffer		buffer;
+		Page		page;
+		int			nthispage;
+
+		// -------- MirroredLock ----------
+		MIRROREDLOCK_BUFMGR_LOCK;
+
+		/* Find a buffer for the first tuple, the others go on the same page */
+		buffer = RelationGetBufferForTuple(relation, heaptuples[ndone]->t_len,
+										   InvalidBuffer, use_fsm);
+		page = BufferGetPage(buffer);
+
+		/* NO EREPORT(ERROR) from here till changes are logged */
+		START_CRIT_SECTION();
+
+		RelationPutHeapTuple(relation, buffer, heaptuples[ndone]);
+		for (nthispage = 1; ndone + nthispage < ntuples; nthispage++)
+		{
+			HeapTuple	heaptup = heaptuples[ndone + nthispage];
+
+			if (PageGetHeapFreeSpace(page) < MAXALIGN(heaptup->t_len) + saveFreeSpace)
+				break;
+
+			RelationPutHeapTuple(relation, buffer, heaptup);
+		}
+
+		MarkBufferDirty(buffer);
+
+		/* XLOG stuff */
+		if (needwal)
+		{
+			xl_heap_multi_insert *xlrec;
+			XLogRecPtr	recptr;
+			XLogRecData rdata[2];
+			uint8		info = XLOG_HEAP2_MULTI_INSERT;
+			char	   *tupledata;
+			char	   *scratchptr = scratch;
+			bool		init;
+
+			/*
+			 * If the page was empty, the redo can reinit it and take the
+			 * offsets in order, so they are not logged.
+			 */
+			init = (ItemPointerGetOffsetNumber(&(heaptuples[ndone]->t_self)) == FirstOffsetNumber &&
+					PageGetMaxOffsetNumber(page) == FirstOffsetNumber + nthispage - 1);
+
+			xlrec = (xl_heap_multi_insert *) scratchptr;
+			scratchptr += SizeOfHeapMultiInsert;
+			if (!init)
+				scratchptr += nthispage * sizeof(OffsetNumber);
+			tupledata = scratchptr;
+
+			xl_heapnode_set(&xlrec->heapnode, relation);
+			xlrec->blkno = BufferGetBlockNumber(buffer);
+			xlrec->ntuples = nthispage;
+
+			for (i = 0; i < nthispage; i++)
+			{
+				HeapTuple	heaptup = heaptuples[ndone + i];
+				xl_multi_insert_tuple *tuphdr;
+				int			datalen;
+
+				if (!init)
+					xlrec->offsets[i] = ItemPointerGetOffsetNumber(&heaptup->t_self);
+
+				tuphdr = (xl_multi_insert_tuple *) SHORTALIGN(scratchptr);
+				scratchptr = ((char *) tuphdr) + SizeOfMultiInsertTuple;
+
+				tuphdr->t_infomask2 = heaptup->t_data->t_infomask2;
+				tuphdr->t_infomask = heaptup->t_data->t_infomask;
+				tuphdr->t_hoff = heaptup->t_data->t_hoff;
+
+				/* PG73FORMAT: write bitmap [+ padding] [+ oid] + data */
+				datalen = heaptup->t_len - offsetof(HeapTupleHeaderData, t_bits);
+				memcpy(scratchptr,
+					   (char *) heaptup->t_data + offsetof(HeapTupleHeaderData, t_bits),
+					   datalen);
+				tuphdr->datalen = datalen;
+				scratchptr += datalen;
+			}
+			Assert(scratchptr - scratch < BLCKSZ);
+
+			rdata[0].data = (char *) xlrec;
+			rdata[0].len = tupledata - scratch;
+			rdata[0].buffer = InvalidBuffer;
+			rdata[0].next = &(rdata[1]);
+
+			/*
+			 * note we mark rdata[1] as belonging to buffer; if XLogInsert
+			 * decides to write the whole page to the xlog, we don't need to
+			 * store the tuples in the xlog.
+			 */
+			rdata[1].data = tupledata;
+			rdata[1].len = scratchptr - tupledata;
+			rdata[1].buffer = buffer;
+			rdata[1].buffer_std = true;
+			rdata[1].next = NULL;
+
+			if (init)
+			{
+				info |= XLOG_HEAP_INIT_PAGE;
+				rdata[1].buffer = InvalidBuffer;
+			}
+
+			if (!isFrozen)
+				recptr = XLogInsert(RM_HEAP2_ID, info, rdata);
+			else
+				recptr = XLogInsert_OverrideXid(RM_HEAP2_ID, info, rdata, FrozenTransactionId);
+
+			PageSetLSN(page, recptr);
+		}
+
+		END_CRIT_SECTION();
+
+		UnlockReleaseBuffer(buffer);
+
+		MIRROREDLOCK_BUFMGR_UNLOCK;
+		// -------- MirroredLock ----------
+
+		ndone += nthispage;
+	}
+
+	/* See heap_insert */
+	for (i = 0; i < ntuples; i++)
+	{
+		if (IsSystemRelation(relation))
+		{
+			if (Gp_role == GP_ROLE_DISPATCH && relation->rd_rel->relhasoids)
+				AddDispatchOidFromTuple(relation, heaptuples[i]);
+
+			CacheInvalidateHeapTuple(relation, heaptuples[i]);
+		}
+
+		pgstat_count_heap_insert(relation);
+
+		if (heaptuples[i] != tuples[i])
+		{
+			tuples[i]->t_self = heaptuples[i]->t_self;
+			heap_freetuple(heaptuples[i]);
+		}
+	}
+
+	if (scratch)
+		pfree(scratch);
+	pfree(heaptuples);
+}
+
 /*
  *	simple_heap_insert - insert a tuple
  *
@@ -5368,6 +5667,125 @@ heap_xlog_insert(XLogRecPtr lsn, XLogRecord *record)
 	
 }
 
+/*
+ * Handles MULTI_INSERT
+ */
+static void
+heap_xlog_multi_insert(XLogRecPtr lsn, XLogRecord *record)
+{
+	MIRROREDLOCK_BUFMGR_DECLARE;
+
+	char	   *recdata = XLogRecGetData(record);
+	xl_heap_multi_insert *xlrec;
+	bool		isinit = (record->xl_info & XLOG_HEAP_INIT_PAGE) != 0;
+	Relation	reln;
+	Buffer		buffer;
+	Page		page;
+	struct
+	{
+		HeapTupleHeaderData hdr;
+		char		data[MaxHeapTupleSize];
+	}			tbuf;
+	HeapTupleHeader htup;
+	uint32		newlen;
+	int			i;
+
+	xlrec = (xl_heap_multi_insert *) recdata;
+	recdata += SizeOfHeapMultiInsert;
+	/* the offsets are only logged if the page was not empty */
+	if (!isinit)
+		recdata += sizeof(OffsetNumber) * xlrec->ntuples;
+
+	if (IsBkpBlockApplied(record, 0))
+		return;
+
+	reln = XLogOpenRelation(xlrec->heapnode.node);
+
+	// -------- MirroredLock ----------
+	MIRROREDLOCK_BUFMGR_LOCK;
+
+	if (isinit)
+	{
+		buffer = XLogReadBuffer(reln, xlrec->blkno, true);
+		Assert(BufferIsValid(buffer));
+		page = (Page) BufferGetPage(buffer);
+
+		PageInit(page, BufferGetPageSize(buffer), 0);
+	}
+	else
+	{
+		buffer = XLogReadBuffer(reln, xlrec->blkno, false);
+		REDO_PRINT_READ_BUFFER_NOT_FOUND(reln, xlrec->blkno, buffer, lsn);
+		if (!BufferIsValid(buffer))
+		{
+			MIRROREDLOCK_BUFMGR_UNLOCK;
+			// -------- MirroredLock ----------
+
+			return;
+		}
+
+		page = (Page) BufferGetPage(buffer);
+
+		REDO_PRINT_LSN_APPLICATION(reln, xlrec->blkno, page, lsn);
+
+		if (XLByteLE(lsn, PageGetLSN(page)))	/* changes are applied */
+		{
+			UnlockReleaseBuffer(buffer);
+
+			MIRROREDLOCK_BUFMGR_UNLOCK;
+			// -------- MirroredLock ----------
+
+			return;
+		}
+	}
+
+	for (i = 0; i < xlrec->ntuples; i++)
+	{
+		OffsetNumber offnum;
+		xl_multi_insert_tuple *xlhdr;
+
+		if (isinit)
+			offnum = FirstOffsetNumber + i;
+		else
+			offnum = xlrec->offsets[i];
+		if (PageGetMaxOffsetNumber(page) + 1 < offnum)
+			elog(PANIC, "heap_multi_insert_redo: invalid max offset number: "
+				 "%u, expected %u", offnum, (OffsetNumber)PageGetMaxOffsetNumber(page) + 1);
+
+		xlhdr = (xl_multi_insert_tuple *) SHORTALIGN(recdata);
+		recdata = ((char *) xlhdr) + SizeOfMultiInsertTuple;
+
+		newlen = xlhdr->datalen;
+		Assert(newlen <= MaxHeapTupleSize);
+		htup = &tbuf.hdr;
+		MemSet((char *) htup, 0, sizeof(HeapTupleHeaderData));
+		/* PG73FORMAT: get bitmap [+ padding] [+ oid] + data */
+		memcpy((char *) htup + offsetof(HeapTupleHeaderData, t_bits),
+			   recdata,
+			   newlen);
+		recdata += newlen;
+
+		newlen += offsetof(HeapTupleHeaderData, t_bits);
+		htup->t_infomask2 = xlhdr->t_infomask2;
+		htup->t_infomask = xlhdr->t_infomask;
+		htup->t_hoff = xlhdr->t_hoff;
+		HeapTupleHeaderSetXmin(htup, record->xl_xid);
+		HeapTupleHeaderSetCmin(htup, FirstCommandId);
+		ItemPointerSet(&htup->t_ctid, xlrec->blkno, offnum);
+
+		offnum = PageAddItem(page, (Item) htup, newlen, offnum, true, true);
+		if (offnum == InvalidOffsetNumber)
+			elog(PANIC, "heap_multi_insert_redo: failed to add tuple");
+	}
+
+	PageSetLSN(page, lsn);
+	MarkBufferDirty(buffer);
+	UnlockReleaseBuffer(buffer);
+
+	MIRROREDLOCK_BUFMGR_UNLOCK;
+	// -------- MirroredLock ----------
+}
+
 /*
  * Handles UPDATE, HOT_UPDATE & MOVE
  */
@@ -5794,6 +6212,9 @@ heap2_redo(XLogRecPtr beginLoc, XLogRecPtr lsn, XLogRecord *record)
 		case XLOG_HEAP2_CLEAN_MOVE:
 			heap_xlog_clean(lsn, record, true);
 			break;
+		case XLOG_HEAP2_MULTI_INSERT:
+			heap_xlog_multi_insert(lsn, record);
+			break;
 		default:
 			elog(PANIC, "heap2_redo: unknown op code %u", info);
 	}
@@ -5999,6 +6420,19 @@ heap2_desc(StringInfo buf, XLogRecPtr beginLoc, XLogRecord *record)
 						 xlrec->heapnode.node.spcNode, xlrec->heapnode.node.dbNode,
 						 xlrec->heapnode.node.relNode, xlrec->block);
 	}
+	else if (info == XLOG_HEAP2_MULTI_INSERT)
+	{
+		xl_heap_multi_insert *xlrec = (xl_heap_multi_insert *) rec;
+
+		if (xl_info & XLOG_HEAP_INIT_PAGE)
+			appendStringInfo(buf, "multi-insert (init): ");
+		else
+			appendStringInfo(buf, "multi-insert: ");
+		appendStringInfo(buf, "rel %u/%u/%u; blk %u; %d tuples",
+						 xlrec->heapnode.node.spcNode, xlrec->heapnode.node.dbNode,
+						 xlrec->heapnode.node.relNode, xlrec->blkno,
+						 xlrec->ntuples);
+	}
 	else
 		appendStringInfo(buf, "UNKNOWN");
 }
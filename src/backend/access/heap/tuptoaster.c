@@ -75,9 +75,6 @@ do { \
 
 #define SET_VARSIZE_C(PTR)			(((varattrib_1b *) (PTR))->va_header |= 0x40)
 
-static void toast_delete_datum(Relation rel, Datum value);
-static Datum toast_save_datum(Relation rel, Datum value, bool isFrozen,
-						bool use_wal, bool use_fsm);
 static struct varlena *toast_fetch_datum(struct varlena * attr);
 static struct varlena *toast_fetch_datum_slice(struct varlena * attr,
 						int32 sliceoffset, int32 length);
@@ -1387,7 +1384,7 @@ toast_compress_datum(Datum value)
  *	a Datum reference for it.
  * ----------
  */
-static Datum
+Datum
 toast_save_datum(Relation rel, Datum value, bool isFrozen,
 				 bool use_wal, bool use_fsm)
 {
@@ -1563,7 +1560,7 @@ toast_save_datum(Relation rel, Datum value, bool isFrozen,
  *	Delete a single external stored value.
  * ----------
  */
-static void
+void
 toast_delete_datum(Relation rel __attribute__((unused)), Datum value)
 {
 	struct varlena *attr = (struct varlena *) DatumGetPointer(value);
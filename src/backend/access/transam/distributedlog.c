@@ -29,6 +29,7 @@
 #include "postgres.h"
 
 #include "miscadmin.h"
+#include "pgstat.h"
 
 #include "access/slru.h"
 #include "access/transam.h"
@@ -173,51 +174,63 @@ DistributedLog_CommittedCheck(
 
 	MIRRORED_LOCK;
 
-	LWLockAcquire(DistributedLogControlLock, LW_EXCLUSIVE);
+	/*
+	 * Visibility checks on old data come here a lot, so first look for the
+	 * page among the buffers holding only a shared lock.
+	 */
+	LWLockAcquire(DistributedLogControlLock, LW_SHARED);
 
-	if (DistributedLogShared->knowHighestUnusedPage &&
-		page <= DistributedLogShared->highestUnusedPage)
+	slotno = SimpleLruFindResidentPage(DistributedLogCtl, page);
+	if (slotno < 0)
 	{
-		/*
-		 * We prevously discovered we didn't have the page...
-		 */
 		LWLockRelease(DistributedLogControlLock);
+		LWLockAcquire(DistributedLogControlLock, LW_EXCLUSIVE);
 
-		MIRRORED_UNLOCK;
+		if (DistributedLogShared->knowHighestUnusedPage &&
+			page <= DistributedLogShared->highestUnusedPage)
+		{
+			/*
+			 * We prevously discovered we didn't have the page...
+			 */
+			LWLockRelease(DistributedLogControlLock);
 
-		*distribTimeStamp = 0;	// Set it to something.
-		*distribXid = 0;
+			MIRRORED_UNLOCK;
 
-		return false;
-	}
-	
-	/*
-	 * Peek to see if page exists.
-	 */
-	if (!SimpleLruPageExists(DistributedLogCtl, page))
-	{
-		if (DistributedLogShared->knowHighestUnusedPage)
-		{
-			if (DistributedLogShared->highestUnusedPage > page)
-				DistributedLogShared->highestUnusedPage = page;
+			*distribTimeStamp = 0;	// Set it to something.
+			*distribXid = 0;
+
+			return false;
 		}
-		else
+
+		/*
+		 * Peek to see if page exists.
+		 */
+		if (!SimpleLruPageExists(DistributedLogCtl, page))
 		{
-			DistributedLogShared->knowHighestUnusedPage = true;
-			DistributedLogShared->highestUnusedPage = page;
-		}
-		
-		LWLockRelease(DistributedLogControlLock);
+			if (DistributedLogShared->knowHighestUnusedPage)
+			{
+				if (DistributedLogShared->highestUnusedPage > page)
+					DistributedLogShared->highestUnusedPage = page;
+			}
+			else
+			{
+				DistributedLogShared->knowHighestUnusedPage = true;
+				DistributedLogShared->highestUnusedPage = page;
+			}
 
-		MIRRORED_UNLOCK;
+			LWLockRelease(DistributedLogControlLock);
 
-		*distribTimeStamp = 0;	// Set it to something.
-		*distribXid = 0;
+			MIRRORED_UNLOCK;
 
-		return false;
+			*distribTimeStamp = 0;	// Set it to something.
+			*distribXid = 0;
+
+			return false;
+		}
+
+		slotno = SimpleLruReadPage(DistributedLogCtl, page, true, localXid);
 	}
-		
-	slotno = SimpleLruReadPage(DistributedLogCtl, page, true, localXid);
+
 	ptr = (DistributedLogEntry *) DistributedLogCtl->shared->page_buffer[slotno];
 	ptr += entryno;
 	*distribTimeStamp = ptr->distribTimeStamp;
@@ -364,7 +377,7 @@ DistributedLog_ShmemSize(void)
 {
 	Size size;
 	
-	size = SimpleLruShmemSize(NUM_DISTRIBUTEDLOG_BUFFERS, 0);
+	size = SimpleLruShmemSize(gp_distributedlog_buffers, 0);
 
 	size += DistributedLog_SharedShmemSize();
 
@@ -378,7 +391,8 @@ DistributedLog_ShmemInit(void)
 
 	/* Set up SLRU for the distributed log. */
 	DistributedLogCtl->PagePrecedes = DistributedLog_PagePrecedes;
-	SimpleLruInit(DistributedLogCtl, "DistributedLogCtl", NUM_DISTRIBUTEDLOG_BUFFERS, 0,
+	DistributedLogCtl->ioWaitEvent = WAIT_EVENT_DISTRIBUTEDLOG_IO;
+	SimpleLruInit(DistributedLogCtl, "DistributedLogCtl", gp_distributedlog_buffers, 0,
 				  DistributedLogControlLock, DISTRIBUTEDLOG_DIR);
 
 	/* Create or attach to the shared structure */
@@ -40,6 +40,40 @@ typedef struct CTContext
 } CTContext;
 
 
+/*
+ * Open the given changetracking log file and position 'context' at its
+ * first record.
+ */
+static void
+initCTContext(CTContext *context, int ftype)
+{
+	if (ftype != CTF_LOG_FULL && 
+		ftype != CTF_LOG_COMPACT && 
+		ftype != CTF_LOG_TRANSIENT)
+		elog(ERROR, "invalid log file descriptor specified (%d). "
+					"valid values are %d (full), %d (compact), or %d (transient). ", 
+					ftype, CTF_LOG_FULL, CTF_LOG_COMPACT, CTF_LOG_TRANSIENT);
+
+	/* make sure log file exists. then open it */
+	if(!ChangeTracking_DoesFileExist(ftype))
+		ereport(ERROR,
+				(errcode_for_file_access(),
+				 errmsg("gp_changetracking_log couldn't open %s file on segment %d dbid %d", 
+						 ChangeTracking_FtypeToString(ftype), Gp_segment, GpIdentity.dbid)));
+			
+	context->file = ChangeTracking_OpenFile(ftype);
+	FileSeek(context->file, 0, SEEK_SET); 
+	Assert(context->file >= 0);
+	
+	context->block_number = 0;
+	context->logPageOff = -CHANGETRACKING_BLCKSZ; /* so 1st increment will give 0 */
+	context->logRecOff = 0;
+	context->recs_in_page = 0;
+	context->recs_read = 0;
+	context->readHeaderBuf = (char *) palloc(sizeof(ChangeTrackingPageHeader));
+	context->readRecordBuf = (char *) palloc(sizeof(ChangeTrackingRecord));
+}
+
 /* Read another page, if possible */
 static bool
 readChangeTrackingPage(CTContext *context)
@@ -187,31 +221,7 @@ gp_changetracking_log(PG_FUNCTION_ARGS)
 		context = (CTContext *) palloc(sizeof(CTContext));
 	
 
-		if (ftype != CTF_LOG_FULL && 
-			ftype != CTF_LOG_COMPACT && 
-			ftype != CTF_LOG_TRANSIENT)
-			elog(ERROR, "invalid log file descriptor specified (%d). "
-						"valid values are %d (full), %d (compact), or %d (transient). ", 
-						ftype, CTF_LOG_FULL, CTF_LOG_COMPACT, CTF_LOG_TRANSIENT);
-
-		/* make sure log file exists. then open it */
-		if(!ChangeTracking_DoesFileExist(ftype))
-			ereport(ERROR,
-					(errcode_for_file_access(),
-					 errmsg("gp_changetracking_log couldn't open %s file on segment %d dbid %d", 
-							 ChangeTracking_FtypeToString(ftype), Gp_segment, GpIdentity.dbid)));
-				
-		context->file = ChangeTracking_OpenFile(ftype);
-		FileSeek(context->file, 0, SEEK_SET); 
-		Assert(context->file >= 0);
-		
-		context->block_number = 0;
-		context->logPageOff = -CHANGETRACKING_BLCKSZ; /* so 1st increment will give 0 */
-		context->logRecOff = 0;
-		context->recs_in_page = 0;
-		context->recs_read = 0;
-		context->readHeaderBuf = (char *) palloc(sizeof(ChangeTrackingPageHeader));
-		context->readRecordBuf = (char *) palloc(sizeof(ChangeTrackingRecord));
+		initCTContext(context, ftype);
 
         /* form the sample tuple and tuple data that will be updated on each function call */
         MemSet(context->tupleValuesToCopy, 0, sizeof(context->tupleValuesToCopy));
@@ -293,3 +303,115 @@ gp_changetracking_log(PG_FUNCTION_ARGS)
 	SRF_RETURN_DONE(funcctx);
 }
 
+
+/*
+ * Read the given changetracking log once and build a map from every changed
+ * relation to a bitmap of its changed blocks.  The map and the bitmaps are
+ * allocated in 'cxt'.
+ *
+ * Resync workers use this to find the blocks to ship to the mirror, instead
+ * of scanning the whole log through gp_changetracking_log() for every batch
+ * of changes they ask for.
+ */
+HTAB *
+ChangeTracking_BuildDirtyBlockMap(CTFType ftype, MemoryContext cxt)
+{
+	HASHCTL		hash_ctl;
+	HTAB	   *map;
+	CTContext  *context;
+	int64		nrecords = 0;
+
+	MemSet(&hash_ctl, 0, sizeof(hash_ctl));
+	hash_ctl.keysize = sizeof(RelFileNode);
+	hash_ctl.entrysize = sizeof(ChangeTrackingDirtyBlocks);
+	hash_ctl.hash = tag_hash;
+	hash_ctl.hcxt = cxt;
+
+	map = hash_create("ChangeTracking dirty block map", 1024, &hash_ctl,
+					  HASH_ELEM | HASH_FUNCTION | HASH_CONTEXT);
+
+	context = (CTContext *) palloc(sizeof(CTContext));
+	initCTContext(context, ftype);
+
+	while (ReadRecord(context))
+	{
+		ChangeTrackingRecord *record = (ChangeTrackingRecord *) context->readRecordBuf;
+		ChangeTrackingDirtyBlocks *blocks;
+		BlockNumber blkno = record->bufferPoolBlockNum;
+		int			word = blkno / 32;
+		bool		found;
+
+		blocks = (ChangeTrackingDirtyBlocks *)
+			hash_search(map, &record->relFileNode, HASH_ENTER, &found);
+		if (!found)
+		{
+			blocks->nwords = 0;
+			blocks->words = NULL;
+		}
+
+		if (word >= blocks->nwords)
+		{
+			/* grow geometrically, relations are usually changed in order */
+			int			nwords = Max(blocks->nwords * 2, word + 1);
+
+			if (blocks->words == NULL)
+				blocks->words = (uint32 *)
+					MemoryContextAllocZero(cxt, nwords * sizeof(uint32));
+			else
+			{
+				blocks->words = (uint32 *)
+					repalloc(blocks->words, nwords * sizeof(uint32));
+				MemSet(blocks->words + blocks->nwords, 0,
+					   (nwords - blocks->nwords) * sizeof(uint32));
+			}
+			blocks->nwords = nwords;
+		}
+
+		blocks->words[word] |= ((uint32) 1) << (blkno % 32);
+		nrecords++;
+	}
+
+	pfree(context->readHeaderBuf);
+	pfree(context->readRecordBuf);
+	FileClose(context->file);
+	pfree(context);
+
+	elog(LOG, "changetracking: read " INT64_FORMAT " records from %s file, "
+		 "%ld relations changed",
+		 nrecords, ChangeTracking_FtypeToString(ftype), hash_get_num_entries(map));
+
+	return map;
+}
+
+/*
+ * Return the first changed block of the relation at or after 'start', or
+ * InvalidBlockNumber if there is none.
+ */
+BlockNumber
+ChangeTracking_NextDirtyBlock(ChangeTrackingDirtyBlocks *blocks, BlockNumber start)
+{
+	int			word = start / 32;
+	uint32		bits;
+
+	if (start == InvalidBlockNumber || word >= blocks->nwords)
+		return InvalidBlockNumber;
+
+	/* ignore the bits below 'start' in the first word */
+	bits = blocks->words[word] & (~((uint32) 0) << (start % 32));
+
+	while (bits == 0)
+	{
+		if (++word >= blocks->nwords)
+			return InvalidBlockNumber;
+		bits = blocks->words[word];
+	}
+
+	start = (BlockNumber) word * 32;
+	while ((bits & 1) == 0)
+	{
+		bits >>= 1;
+		start++;
+	}
+
+	return start;
+}
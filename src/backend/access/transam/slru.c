@@ -57,6 +57,7 @@
 #include "storage/fd.h"
 #include "storage/shmem.h"
 #include "miscadmin.h"
+#include "pgstat.h"
 
 #include "cdb/cdbfilerepprimary.h"
 #include "cdb/cdbmirroredflatfile.h"
@@ -466,7 +467,11 @@ SimpleLruReadPage_Internal(SlruCtl ctl, int pageno, bool write_ok, TransactionId
 		LWLockRelease(shared->ControlLock);
 
 		/* Do the read */
+		if (ctl->ioWaitEvent != WAIT_EVENT_NONE)
+			pgstat_report_wait_start(ctl->ioWaitEvent);
 		ok = SlruPhysicalReadPage(ctl, pageno, slotno);
+		if (ctl->ioWaitEvent != WAIT_EVENT_NONE)
+			pgstat_report_wait_end();
 
 		/* Set the LSNs for this newly read-in page to zero */
 		SimpleLruZeroLSNs(ctl, slotno);
@@ -547,6 +552,36 @@ SimpleLruReadPage_ReadOnly(SlruCtl ctl, int pageno, TransactionId xid, bool *val
 	return SimpleLruReadPage_Internal(ctl, pageno, true, xid, valid);
 }
 
+/*
+ * Find a page that is already in a shared buffer, without reading it in.
+ *
+ * Returns the shared-buffer slot number holding the page, or -1 if it is not
+ * in memory. The buffer's LRU access info is updated.
+ *
+ * Control lock must be held at entry, and will be held at exit; a shared
+ * lock is enough.
+ */
+int
+SimpleLruFindResidentPage(SlruCtl ctl, int pageno)
+{
+	SlruShared	shared = ctl->shared;
+	int			slotno;
+
+	for (slotno = 0; slotno < shared->num_slots; slotno++)
+	{
+		if (shared->page_number[slotno] == pageno &&
+			shared->page_status[slotno] != SLRU_PAGE_EMPTY &&
+			shared->page_status[slotno] != SLRU_PAGE_READ_IN_PROGRESS)
+		{
+			/* See comments for SlruRecentlyUsed macro */
+			SlruRecentlyUsed(shared, slotno);
+			return slotno;
+		}
+	}
+
+	return -1;
+}
+
 /*
  * Write a page from a shared buffer, if necessary.
  * Does nothing if the specified slot is not dirty.
@@ -595,7 +630,11 @@ SimpleLruWritePage(SlruCtl ctl, int slotno, SlruFlush fdata)
 	LWLockRelease(shared->ControlLock);
 
 	/* Do the write */
+	if (ctl->ioWaitEvent != WAIT_EVENT_NONE)
+		pgstat_report_wait_start(ctl->ioWaitEvent);
 	ok = SlruPhysicalWritePage(ctl, pageno, slotno, fdata);
+	if (ctl->ioWaitEvent != WAIT_EVENT_NONE)
+		pgstat_report_wait_end();
 
 	/* If we failed, and we're in a flush, better close the files */
 	if (!ok && fdata)
@@ -1388,7 +1427,11 @@ SimpleLruPageExists(SlruCtl ctl, int pageno)
 		LWLockRelease(shared->ControlLock);
 
 		/* Do the read */
+		if (ctl->ioWaitEvent != WAIT_EVENT_NONE)
+			pgstat_report_wait_start(ctl->ioWaitEvent);
 		ok = SlruPhysicalReadPage(ctl, pageno, slotno);
+		if (ctl->ioWaitEvent != WAIT_EVENT_NONE)
+			pgstat_report_wait_end();
 
 		/* Re-acquire control lock and update page state */
 		LWLockAcquire(shared->ControlLock, LW_EXCLUSIVE);
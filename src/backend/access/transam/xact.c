@@ -60,10 +60,15 @@
 #include "pg_trace.h"
 
 #include "access/distributedlog.h"
+#include "cdb/cdbappendonlystoragewrite.h"
+#include "cdb/cdbdisp.h"
 #include "cdb/cdbdistributedsnapshot.h"
+#include "cdb/cdbendpoint.h"
 #include "cdb/cdbgang.h"
 #include "cdb/cdblocaldistribxact.h"
 #include "cdb/cdbpersistentstore.h"
+#include "cdb/cdbprogress.h"
+#include "cdb/cdbqueryhistory.h"
 #include "cdb/cdbtm.h"
 #include "cdb/cdbvars.h" /* Gp_role, Gp_is_writer, interconnect_setup_timeout */
 #include "utils/vmem_tracker.h"
@@ -2609,6 +2614,12 @@ CommitTransaction(void)
 	 */
 	AtEOXact_UpdateFlatFiles(true);
 
+	/*
+	 * Collect the results of a command left running on the QEs by pipelined
+	 * dispatch.  This can still fail.
+	 */
+	cdbdisp_syncPipeline();
+
 	/*
 	 * Prepare all QE.
 	 */
@@ -3161,6 +3172,9 @@ AbortTransaction(void)
 	 */
 	LWLockReleaseAll();
 
+	/* Clear wait information */
+	pgstat_report_wait_end();
+
 	/* Clean up buffer I/O and buffer context locks, too */
 	AbortBufferIO();
 	UnlockBuffers();
@@ -3208,6 +3222,10 @@ AbortTransaction(void)
 	 */
 	AfterTriggerEndXact(false);
 	AtAbort_Portals();
+	AtAbort_Endpoints();
+	AtAbort_QueryProgress();
+	AtAbort_QueryHistory();
+	cdbdisp_cancelPipeline();
 
 	AtEOXact_SharedSnapshot();
 
@@ -3216,6 +3234,7 @@ AbortTransaction(void)
 		AtAbort_ResScheduler();
 		
 	/* Perform any AO table abort processing */
+	AtAbort_AppendOnlyCompress();
 	AtAbort_AppendOnly();
 
 	AtEOXact_DispatchOids(false);
@@ -5376,6 +5395,9 @@ AbortSubTransaction(void)
 	AtSubAbort_Memory();
 	AtSubAbort_ResourceOwner();
 
+	/* Append-only compression workers may write into memory we free. */
+	AtAbort_AppendOnlyCompress();
+
 	/*
 	 * Release any LW locks we might be holding as quickly as possible.
 	 * (Regular locks, however, must be held till we finish aborting.)
@@ -5387,6 +5409,8 @@ AbortSubTransaction(void)
 	 */
 	LWLockReleaseAll();
 
+	pgstat_report_wait_end();
+
 	AbortBufferIO();
 	UnlockBuffers();
 
@@ -5409,6 +5433,12 @@ AbortSubTransaction(void)
 	 */
 	SetUserIdAndSecContext(s->prevUser, s->prevSecContext);
 
+	/*
+	 * A command left running on the QEs by pipelined dispatch belongs to
+	 * this subtransaction, as beginning one dispatches a command.
+	 */
+	cdbdisp_cancelPipeline();
+
 	/*
 	 * We can skip all this stuff if the subxact failed before creating a
 	 * ResourceOwner...
@@ -306,6 +306,14 @@ static XLogRecPtr RedoStartLSN = {0, 0};
  *
  * WALInsertLock: must be held to insert a record into the WAL buffers.
  *
+ * XLogInsertSlotLock(i): a record that fits on the current WAL page only
+ * has its space reserved under WALInsertLock.  Its data is copied in after
+ * WALInsertLock is released, while holding one of NUM_XLOG_INSERT_SLOTS
+ * slot locks instead, so that backends copy their records in parallel.  The
+ * slot lock is taken before WALInsertLock is released, so XLogWrite only
+ * has to cycle through the slot locks to know that every record reserved
+ * before its request has been copied in.
+ *
  * WALWriteLock: must be held to write WAL buffers to disk (XLogWrite or
  * XLogFlush).
  *
@@ -523,6 +531,9 @@ static ControlFileWatch *ControlFileWatcher = NULL;
 		XLogCtl->xlblocks[curridx].xrecoff - INSERT_FREESPACE(Insert) \
 	)
 
+/* Lock under which records are copied into the WAL buffers, see above */
+#define XLogInsertSlotLock(i)	((LWLockId) (FirstXLogInsertSlotLock + (i)))
+
 #define PrevBufIdx(idx)		\
 		(((idx) == 0) ? XLogCtl->XLogCacheBlck : ((idx) - 1))
 
@@ -631,6 +642,7 @@ static void RestoreBackupBlockContents(XLogRecPtr lsn, BkpBlock bkpb,
 
 static bool AdvanceXLInsertBuffer(bool new_segment);
 static void XLogWrite(XLogwrtRqst WriteRqst, bool flexible, bool xlog_switch);
+static void WaitXLogInsertionsToFinish(void);
 static void XLogFileInit(
 			 MirroredFlatFileOpen *mirroredOpen,
 			 uint32 log, uint32 seg,
@@ -644,6 +656,10 @@ static void XLogFileOpen(
 				uint32 log,
 				uint32 seg);
 
+static FILE *CreateRecoveryXactFile(void);
+static void WriteRecoveryXactFile(FILE *file, XLogRecPtr *beginLoc,
+					  XLogRecPtr *endLoc, XLogRecord *record);
+static bool StartupXLOG_Pass2_ReadRecoveryXactFile(void);
 static bool StartupXLOG_Pass4_CheckIfAnyInDoubtPreparedTransactions(void);
 static void StartupXLOG_Pass4_NonDBSpecificPTCatVerification(void);
 static void StartupXLOG_Pass4_DBSpecificPTCatVerification(void);
@@ -849,6 +865,9 @@ XLogInsert_Internal(RmgrId rmid, uint8 info, XLogRecData *rdata, TransactionId h
 	bool		isLogSwitch = (rmid == RM_XLOG_ID && info == XLOG_SWITCH);
 	bool		rdata_iscopy = false;
 	uint8       extended_info = 0;
+	bool		copyUnlocked;
+	char	   *copypos = NULL;
+	LWLockId	slotLock = XLogInsertSlotLock(MyProcPid % NUM_XLOG_INSERT_SLOTS);
 
     /* Safety check in case our assumption is ever broken. */
 	/* NOTE: This is slightly modified from the one in xact.c -- the test for */
@@ -1192,6 +1211,13 @@ begin:;
 		freespace = INSERT_FREESPACE(Insert);
 	}
 
+	/*
+	 * If the whole record fits on this page, we only reserve the space for
+	 * its data here, and copy the data in after releasing WALInsertLock.
+	 */
+	copyUnlocked = (!isLogSwitch &&
+					write_len <= freespace - SizeOfXLogRecord);
+
 	/* Compute record's XLOG location */
 	curridx = Insert->curridx;
 	INSERT_RECPTR(RecPtr, Insert, curridx);
@@ -1292,7 +1318,13 @@ begin:;
 	/*
 	 * Append the data, including backup blocks if any
 	 */
-	while (write_len)
+	if (copyUnlocked)
+	{
+		copypos = Insert->currpos;
+		Insert->currpos += write_len;
+		freespace -= write_len;
+	}
+	while (!copyUnlocked && write_len)
 	{
 		while (rdata->data == NULL)
 			rdata = rdata->next;
@@ -1495,8 +1527,23 @@ begin:;
 
 	LWLockRelease(ChangeTrackingTransitionLock);
 
+	if (copyUnlocked)
+		LWLockAcquire(slotLock, LW_EXCLUSIVE);
+
 	LWLockRelease(WALInsertLock);
 
+	if (copyUnlocked)
+	{
+		for (; rdata != NULL; rdata = rdata->next)
+		{
+			if (rdata->data == NULL)
+				continue;
+			memcpy(copypos, rdata->data, rdata->len);
+			copypos += rdata->len;
+		}
+		LWLockRelease(slotLock);
+	}
+
 	if (updrqst)
 	{
 		/* use volatile pointer to prevent code rearrangement */
@@ -1935,6 +1982,27 @@ XLogCheckpointNeeded(void)
 	return false;
 }
 
+/*
+ * Wait for the records whose data is being copied into the WAL buffers
+ * without WALInsertLock to be copied in.
+ *
+ * A backend holds its slot lock exclusively while it copies, and takes it
+ * before it releases WALInsertLock, so this covers every record reserved
+ * before the caller decided what to write.  The caller may hold
+ * WALInsertLock: a backend holding a slot lock never waits for anything.
+ */
+static void
+WaitXLogInsertionsToFinish(void)
+{
+	int			i;
+
+	for (i = 0; i < NUM_XLOG_INSERT_SLOTS; i++)
+	{
+		LWLockAcquire(XLogInsertSlotLock(i), LW_SHARED);
+		LWLockRelease(XLogInsertSlotLock(i));
+	}
+}
+
 /*
  * Write and/or fsync the log at least as far as WriteRqst indicates.
  *
@@ -1967,6 +2035,9 @@ XLogWrite(XLogwrtRqst WriteRqst, bool flexible, bool xlog_switch)
 	/* We should always be inside a critical section here */
 	Assert(CritSectionCount > 0);
 
+	/* Don't write out records that are still being copied in */
+	WaitXLogInsertionsToFinish();
+
 	/*
 	 * Update local LogwrtResult (caller probably did this already, but...)
 	 */
@@ -6537,6 +6608,7 @@ StartupXLOG(void)
 	XLogRecord *record;
 	uint32		freespace;
 	bool		multipleRecoveryPassesNeeded = false;
+	FILE	   *recoveryXactFile = NULL;
 	bool		backupEndRequired = false;
 
 	/*
@@ -7025,6 +7097,12 @@ StartupXLOG(void)
 		 */
 		multipleRecoveryPassesNeeded = true;
 
+		/*
+		 * Pass 2 needs the transaction records of the redo range; save them
+		 * as we go, so that it doesn't have to read the whole XLOG again.
+		 */
+		recoveryXactFile = CreateRecoveryXactFile();
+
 		/*
 		 * main redo apply loop, executed if we have record after checkpoint
 		 */
@@ -7101,6 +7179,10 @@ StartupXLOG(void)
 				/* Pop the error context stack */
 				error_context_stack = errcontext.previous;
 
+				if (record->xl_rmid == RM_XACT_ID)
+					WriteRecoveryXactFile(recoveryXactFile,
+										  &ReadRecPtr, &EndRecPtr, record);
+
 				LastRec = ReadRecPtr;
 
 				record = XLogReadRecord(NULL, false, LOG);
@@ -7140,6 +7222,12 @@ StartupXLOG(void)
 		/*
 		 * end of main redo apply loop
 		 */
+
+		if (FreeFile(recoveryXactFile))
+			ereport(ERROR,
+					(errcode_for_file_access(),
+					 errmsg("could not write recovery transaction file: %m")));
+		recoveryXactFile = NULL;
 	}
 
 	/*
@@ -7457,6 +7545,151 @@ bool XLogStartupIntegrityCheckNeeded(void)
 	return XLogCtl->integrityCheckNeeded;
 }
 
+/*
+ * The recovery transaction file holds a copy of the RM_XACT_ID records pass 1
+ * replayed.  Pass 2 builds the persistent tables' end-of-transaction work from
+ * those records only, so it reads this file instead of the whole XLOG.  Each
+ * entry is the record's begin and end location followed by the record.
+ */
+static void
+GetRecoveryXactFileName(char *path)
+{
+	char *xlogDir = makeRelativeToTxnFilespace(XLOGDIR);
+	if (snprintf(path, MAXPGPATH, "%s/RecoveryXactFile", xlogDir) > MAXPGPATH)
+	{
+		ereport(ERROR, (errmsg("cannot generate pathname %s/RecoveryXactFile", xlogDir)));
+	}
+	pfree(xlogDir);
+}
+
+static FILE *
+CreateRecoveryXactFile(void)
+{
+	char	path[MAXPGPATH];
+
+	FILE   *result;
+
+	GetRecoveryXactFileName(path);
+
+	result = AllocateFile(path, PG_BINARY_W);
+	if (result == NULL)
+	{
+		ereport(ERROR,
+				(errcode_for_file_access(),
+				 errmsg("could not create recovery transaction file \"%s\": %m",
+						path)));
+	}
+
+	return result;
+}
+
+static void
+WriteRecoveryXactFile(FILE *file, XLogRecPtr *beginLoc, XLogRecPtr *endLoc,
+					  XLogRecord *record)
+{
+	if (fwrite(beginLoc, sizeof(XLogRecPtr), 1, file) != 1 ||
+		fwrite(endLoc, sizeof(XLogRecPtr), 1, file) != 1 ||
+		fwrite(record, record->xl_tot_len, 1, file) != 1)
+	{
+		ereport(ERROR,
+				(errcode_for_file_access(),
+				 errmsg("could not write recovery transaction file: %m")));
+	}
+}
+
+/*
+ * Hand the transaction records pass 1 saved to persistent recovery.  Returns
+ * false, leaving it to the caller to scan the XLOG, if there is no file.
+ */
+static bool
+StartupXLOG_Pass2_ReadRecoveryXactFile(void)
+{
+	char		path[MAXPGPATH];
+	FILE	   *file;
+	XLogRecPtr	beginLoc;
+	XLogRecPtr	endLoc;
+	char	   *buffer;
+	uint32		bufferSize = BLCKSZ;
+	int			count = 0;
+
+	GetRecoveryXactFileName(path);
+
+	file = AllocateFile(path, PG_BINARY_R);
+	if (file == NULL)
+	{
+		ereport(LOG,
+				(errcode_for_file_access(),
+				 errmsg("could not open recovery transaction file \"%s\", scanning the transaction log instead: %m",
+						path)));
+		return false;
+	}
+
+	buffer = palloc(bufferSize);
+
+	while (fread(&beginLoc, sizeof(XLogRecPtr), 1, file) == 1)
+	{
+		XLogRecord *record = (XLogRecord *) buffer;
+		uint32		totalLen;
+
+		if (fread(&endLoc, sizeof(XLogRecPtr), 1, file) != 1 ||
+			fread(buffer, SizeOfXLogRecord, 1, file) != 1 ||
+			record->xl_tot_len < SizeOfXLogRecord)
+			ereport(ERROR,
+					(errcode_for_file_access(),
+					 errmsg("could not read recovery transaction file \"%s\"",
+							path)));
+
+		totalLen = record->xl_tot_len;
+		if (totalLen > bufferSize)
+		{
+			bufferSize = totalLen;
+			buffer = repalloc(buffer, bufferSize);
+			record = (XLogRecord *) buffer;
+		}
+
+		if (totalLen > SizeOfXLogRecord &&
+			fread(buffer + SizeOfXLogRecord,
+				  totalLen - SizeOfXLogRecord, 1, file) != 1)
+			ereport(ERROR,
+					(errcode_for_file_access(),
+					 errmsg("could not read recovery transaction file \"%s\"",
+							path)));
+
+		/*
+		 * In standby mode pass 1 moves the start of the redo range forward
+		 * at every checkpoint it replays, so skip what is outside it now.
+		 */
+		if (XLByteLT(beginLoc, XLogCtl->pass1StartLoc) ||
+			XLByteLT(XLogCtl->pass1LastLoc, beginLoc))
+			continue;
+
+		PersistentRecovery_HandlePass2XLogRec(&beginLoc, &endLoc, record);
+		count++;
+	}
+
+	if (ferror(file))
+		ereport(ERROR,
+				(errcode_for_file_access(),
+				 errmsg("could not read recovery transaction file \"%s\": %m",
+						path)));
+
+	FreeFile(file);
+
+	pfree(buffer);
+
+	if (unlink(path) < 0)
+		ereport(ERROR,
+				(errcode_for_file_access(),
+				 errmsg("could not unlink recovery transaction file \"%s\": %m", path)));
+
+	if (Debug_persistent_recovery_print)
+		elog(PersistentRecovery_DebugPrintLevel(),
+			 "StartupXLOG_Pass2: handled %d transaction records saved by pass 1",
+			 count);
+
+	return true;
+}
+
 static void
 GetRedoRelationFileName(char *path)
 {
@@ -7574,21 +7807,24 @@ StartupXLOG_Pass2(void)
 			SetupCheckpointPreparedTransactionList(ckptExtended.ptas);
 	}
 
-	record = XLogReadRecord(&XLogCtl->pass1StartLoc, false, PANIC);
-
 	/*
-	 * Pass 2 XLOG scan
+	 * Pass 2 XLOG scan, unless pass 1 saved the records we need
 	 */
-	while (true)
+	if (!StartupXLOG_Pass2_ReadRecoveryXactFile())
 	{
-		PersistentRecovery_HandlePass2XLogRec(&ReadRecPtr, &EndRecPtr, record);
+		record = XLogReadRecord(&XLogCtl->pass1StartLoc, false, PANIC);
 
-		if (XLByteEQ(ReadRecPtr, XLogCtl->pass1LastLoc))
-			break;
+		while (true)
+		{
+			PersistentRecovery_HandlePass2XLogRec(&ReadRecPtr, &EndRecPtr, record);
 
-		Assert(XLByteLE(ReadRecPtr,XLogCtl->pass1LastLoc));
+			if (XLByteEQ(ReadRecPtr, XLogCtl->pass1LastLoc))
+				break;
+
+			Assert(XLByteLE(ReadRecPtr,XLogCtl->pass1LastLoc));
 
-		record = XLogReadRecord(NULL, false, PANIC);
+			record = XLogReadRecord(NULL, false, PANIC);
+		}
 	}
 	XLogCloseReadRecord();
 
@@ -473,7 +473,8 @@ ExecuteGrantStmt(GrantStmt *stmt)
 		CdbDispatchUtilityStatement((Node *) stmt,
 									DF_CANCEL_ON_ERROR|
 									DF_WITH_SNAPSHOT|
-									DF_NEED_TWO_PHASE,
+									DF_NEED_TWO_PHASE|
+									DF_PIPELINE,
 									NIL,
 									NULL);
 	}
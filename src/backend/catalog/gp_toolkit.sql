@@ -852,6 +852,204 @@ AS
 GRANT SELECT ON TABLE gp_toolkit.gp_skew_idle_fractions TO public;
 
 
+--------------------------------------------------------------------------------
+-- @view:
+--        gp_toolkit.gp_skew_size_coefficients
+--
+-- @doc:
+--        Coefficient of variation of the size of each table on each segment.
+--        Unlike gp_skew_coefficients, this doesn't count rows: it only looks
+--        at the size of the files, pages for heap tables and segment files
+--        for append-only tables, so it is cheap enough to run on every table
+--        of a large database.
+--
+--------------------------------------------------------------------------------
+CREATE VIEW gp_toolkit.gp_skew_size_coefficients
+AS
+    SELECT
+        aut.autoid     AS sscoid,
+        aut.autnspname AS sscnamespace,
+        aut.autrelname AS sscrelname,
+        segsize.sscsize,
+        CASE
+            WHEN segsize.sscmean > 0 THEN ((segsize.sscdev / segsize.sscmean) * 100.0)
+            ELSE 0
+        END
+        AS ssccoeff
+    FROM
+    (
+        SELECT
+            segoid,
+            SUM(segbytes)::bigint AS sscsize,
+            STDDEV(segbytes) AS sscdev,
+            AVG(segbytes) AS sscmean
+        FROM
+        (
+            SELECT oid AS segoid, pg_catalog.pg_relation_size(oid) AS segbytes
+            FROM gp_dist_random('pg_catalog.pg_class')
+            WHERE relkind = 'r' AND relstorage IN ('h', 'a', 'c')
+        ) segs
+        GROUP BY segoid
+    ) segsize
+
+    JOIN
+    gp_toolkit.__gp_user_data_tables_readable aut
+    ON (segsize.segoid = aut.autoid);
+
+GRANT SELECT ON TABLE gp_toolkit.gp_skew_size_coefficients TO public;
+
+
+--------------------------------------------------------------------------------
+-- @function:
+--        gp_toolkit.gp_distribution_key_advice
+-- @in:
+--        oid - oid of table for which to evaluate distribution keys
+--        float8 - fraction of the rows to sample
+-- @out:
+--        name - candidate distribution key column
+--        boolean - whether the table is distributed by that column now
+--        float8 - number of distinct values in the sample
+--        numeric - skew coefficient if distributed by that column
+--        numeric - fraction of the rows that would change segment
+--        bigint - bytes that would change segment
+--
+-- @doc:
+--        Evaluate every column of a table as a single-column distribution
+--        key, on one sample of its rows: the segment each sampled row would
+--        hash to, the skew that results and how much data would have to
+--        move. The number of distinct values is estimated with a
+--        HyperLogLog sketch; a key with fewer distinct values than there
+--        are segments cannot spread the table evenly.
+--
+--------------------------------------------------------------------------------
+CREATE FUNCTION gp_toolkit.gp_distribution_key_advice(targetoid oid, samplefraction float8,
+    OUT dkaattname name, OUT dkacurrent boolean, OUT dkandistinct float8,
+    OUT dkacoeff numeric, OUT dkamovedfraction numeric, OUT dkamovedbytes bigint)
+RETURNS SETOF record
+AS
+$$
+DECLARE
+    dkatable text;
+    dkasample text;
+    dkanumsegs int;
+    dkasize bigint;
+    dkacurkey name;
+    dkaatt record;
+    dkarec record;
+
+BEGIN
+    IF samplefraction <= 0 OR samplefraction > 1 THEN
+        RAISE EXCEPTION 'sample fraction must be greater than 0 and at most 1';
+    END IF;
+
+    SELECT quote_ident(fnnspname) || '.' || quote_ident(fnrelname) INTO dkatable
+    FROM gp_toolkit.__gp_fullname
+    WHERE fnoid = targetoid;
+    IF NOT FOUND THEN
+        RAISE EXCEPTION 'relation with OID % does not exist', targetoid;
+    END IF;
+
+    SELECT numsegments INTO dkanumsegs FROM gp_toolkit.__gp_number_of_segments;
+    dkasize := pg_catalog.pg_relation_size(targetoid);
+
+    -- only a single-column key can match a candidate
+    SELECT pga.attname INTO dkacurkey
+    FROM pg_catalog.gp_distribution_policy pol, pg_catalog.pg_attribute pga
+    WHERE pol.localoid = targetoid
+      AND array_upper(pol.attrnums, 1) = 1
+      AND pga.attrelid = targetoid
+      AND pga.attnum = pol.attrnums[1];
+
+    -- Sample the table once, keeping the segment each row is on now
+    dkasample := 'gp_distribution_key_advice_' || targetoid;
+    PERFORM 1 FROM pg_catalog.pg_class
+    WHERE relname = dkasample AND relnamespace = pg_catalog.pg_my_temp_schema();
+    IF FOUND THEN
+        EXECUTE 'DROP TABLE ' || dkasample;
+    END IF;
+    EXECUTE 'CREATE TEMP TABLE ' || dkasample || ' AS ' ||
+            'SELECT t.*, t.gp_segment_id AS gp_dka_segid FROM ONLY ' || dkatable || ' t ' ||
+            'WHERE pg_catalog.random() < ' || samplefraction || ' DISTRIBUTED RANDOMLY';
+
+    FOR dkaatt IN
+        SELECT attname, attnum
+        FROM pg_catalog.pg_attribute
+        WHERE attrelid = dkasample::regclass
+          AND attnum > 0
+          AND NOT attisdropped
+          AND attname <> 'gp_dka_segid'
+        ORDER BY attnum
+    LOOP
+        BEGIN
+            EXECUTE 'SELECT COALESCE(SUM(cnt), 0) AS total, COALESCE(SUM(moved), 0) AS moved, ' ||
+                    'COALESCE(STDDEV(cnt), 0) AS dev, COALESCE(AVG(cnt), 0) AS mean ' ||
+                    'FROM (SELECT segid, COALESCE(cnt, 0) AS cnt, COALESCE(moved, 0) AS moved ' ||
+                          'FROM generate_series(0, ' || dkanumsegs - 1 || ') segid ' ||
+                          'LEFT OUTER JOIN ' ||
+                              '(SELECT seg, COUNT(*) AS cnt, ' ||
+                                      'SUM(CASE WHEN seg <> gp_dka_segid THEN 1 ELSE 0 END) AS moved ' ||
+                               'FROM (SELECT pg_catalog.gp_hash_target_segment(s.*, ''{' || dkaatt.attnum || '}''::int2[]) AS seg, ' ||
+                                            's.gp_dka_segid ' ||
+                                     'FROM ' || dkasample || ' s) hashed ' ||
+                               'GROUP BY seg) dist ' ||
+                          'ON segid = seg) segs'
+            INTO dkarec;
+
+            EXECUTE 'SELECT pg_catalog.gp_hll_ndistinct(' || quote_ident(dkaatt.attname) || ') FROM ' || dkasample
+            INTO dkandistinct;
+        EXCEPTION WHEN OTHERS THEN
+            -- not a type the table can be distributed by
+            CONTINUE;
+        END;
+
+        dkaattname := dkaatt.attname;
+        dkacurrent := (dkaatt.attname = dkacurkey) IS TRUE;
+        IF dkarec.mean > 0 THEN
+            dkacoeff := (dkarec.dev / dkarec.mean) * 100.0;
+        ELSE
+            dkacoeff := 0;
+        END IF;
+        IF dkarec.total > 0 THEN
+            dkamovedfraction := dkarec.moved::numeric / dkarec.total;
+        ELSE
+            dkamovedfraction := 0;
+        END IF;
+        dkamovedbytes := (dkasize * dkamovedfraction)::bigint;
+        RETURN NEXT;
+    END LOOP;
+
+    EXECUTE 'DROP TABLE ' || dkasample;
+    RETURN;
+END
+$$
+LANGUAGE plpgsql MODIFIES SQL DATA;
+
+GRANT EXECUTE ON FUNCTION gp_toolkit.gp_distribution_key_advice(oid, float8) TO public;
+
+
+--------------------------------------------------------------------------------
+-- @function:
+--        gp_toolkit.gp_distribution_key_advice
+-- @in:
+--        oid - oid of table for which to evaluate distribution keys
+--
+-- @doc:
+--        Same as above, on a 1% sample
+--
+--------------------------------------------------------------------------------
+CREATE FUNCTION gp_toolkit.gp_distribution_key_advice(targetoid oid,
+    OUT dkaattname name, OUT dkacurrent boolean, OUT dkandistinct float8,
+    OUT dkacoeff numeric, OUT dkamovedfraction numeric, OUT dkamovedbytes bigint)
+RETURNS SETOF record
+AS
+$$
+    SELECT * FROM gp_toolkit.gp_distribution_key_advice($1, 0.01);
+$$
+LANGUAGE sql MODIFIES SQL DATA;
+
+GRANT EXECUTE ON FUNCTION gp_toolkit.gp_distribution_key_advice(oid) TO public;
+
+
 --------------------------------------------------------------------------------
 -- detection of missing stats
 --------------------------------------------------------------------------------
@@ -2192,6 +2390,487 @@ ORDER BY segid;
 
 GRANT SELECT ON gp_toolkit.gp_workfile_mgr_used_diskspace TO public;
 
+-- Query progress views
+--------------------------------------------------------------------------------
+
+--------------------------------------------------------------------------------
+-- @function:
+--        gp_toolkit.__gp_query_progress_f
+--
+-- @in:
+--
+-- @out:
+--        int - segment id
+--        int - process id,
+--        int - session id,
+--        int - command count,
+--        int - slice id,
+--        int - plan node id,
+--        text - plan node type,
+--        float8 - estimated rows,
+--        bigint - rows returned (or sent, by a Motion) so far,
+--        bigint - bytes sent or received by a Motion so far,
+--        bigint - workfile bytes of the whole query on the segment
+--
+-- @doc:
+--        UDF to retrieve the live per-node progress of the queries running
+--        on one segment
+--
+--------------------------------------------------------------------------------
+
+CREATE FUNCTION gp_toolkit.__gp_query_progress_f_on_master()
+RETURNS SETOF record
+AS 'gp_query_progress'
+LANGUAGE internal VOLATILE EXECUTE ON MASTER;
+
+GRANT EXECUTE ON FUNCTION gp_toolkit.__gp_query_progress_f_on_master() TO public;
+
+CREATE FUNCTION gp_toolkit.__gp_query_progress_f_on_segments()
+RETURNS SETOF record
+AS 'gp_query_progress'
+LANGUAGE internal VOLATILE EXECUTE ON ALL SEGMENTS;
+
+GRANT EXECUTE ON FUNCTION gp_toolkit.__gp_query_progress_f_on_segments() TO public;
+
+--------------------------------------------------------------------------------
+-- @view:
+--        gp_toolkit.gp_query_progress
+--
+-- @doc:
+--        Live per-node, per-segment progress of the running queries of
+--        other sessions, without gpperfmon. Only the plan nodes that each
+--        process executes itself are shown, up to
+--        gp_query_progress_max_nodes per process.
+--
+--------------------------------------------------------------------------------
+
+CREATE VIEW gp_toolkit.gp_query_progress AS
+WITH all_nodes AS (
+   SELECT C.*
+          FROM gp_toolkit.__gp_query_progress_f_on_master() AS C (
+            segid int,
+            pid int,
+            sess_id int,
+            command_cnt int,
+            slice_id int,
+            node_id int,
+            node_type text,
+            plan_rows float8,
+            actual_rows bigint,
+            motion_bytes bigint,
+            spill_bytes bigint
+          )
+    UNION ALL
+    SELECT C.*
+          FROM gp_toolkit.__gp_query_progress_f_on_segments() AS C (
+            segid int,
+            pid int,
+            sess_id int,
+            command_cnt int,
+            slice_id int,
+            node_id int,
+            node_type text,
+            plan_rows float8,
+            actual_rows bigint,
+            motion_bytes bigint,
+            spill_bytes bigint
+          ))
+SELECT S.datname,
+       S.usename,
+       C.sess_id,
+       C.command_cnt,
+       C.slice_id,
+       C.segid,
+       C.pid,
+       C.node_id,
+       C.node_type,
+       C.plan_rows,
+       C.actual_rows,
+       (CASE WHEN C.plan_rows > 0
+             THEN round((C.actual_rows / C.plan_rows)::numeric, 2)
+        END) AS actual_vs_plan,
+       C.motion_bytes,
+       C.spill_bytes
+FROM all_nodes C LEFT OUTER JOIN
+pg_stat_activity as S
+ON C.sess_id = S.sess_id
+WHERE C.sess_id <> pg_catalog.current_setting('gp_session_id')::int;
+
+GRANT SELECT ON gp_toolkit.gp_query_progress TO public;
+
+--------------------------------------------------------------------------------
+-- @view:
+--        gp_toolkit.gp_query_slice_progress
+--
+-- @doc:
+--        Rows produced so far by each slice of the running queries on each
+--        segment, taken from the top plan node of the slice, and how far
+--        each segment is behind the fastest one of its slice.
+--
+--------------------------------------------------------------------------------
+
+CREATE VIEW gp_toolkit.gp_query_slice_progress AS
+SELECT sess_id,
+       command_cnt,
+       slice_id,
+       segid,
+       node_id AS top_node_id,
+       node_type AS top_node_type,
+       actual_rows,
+       max(actual_rows) OVER w - actual_rows AS rows_behind_fastest,
+       motion_bytes
+FROM (SELECT DISTINCT ON (sess_id, command_cnt, slice_id, segid) *
+      FROM gp_toolkit.gp_query_progress
+      ORDER BY sess_id, command_cnt, slice_id, segid, node_id) P
+WINDOW w AS (PARTITION BY sess_id, command_cnt, slice_id);
+
+GRANT SELECT ON gp_toolkit.gp_query_slice_progress TO public;
+
+-- Wait event views
+--------------------------------------------------------------------------------
+
+--------------------------------------------------------------------------------
+-- @function:
+--        gp_toolkit.__gp_wait_event_samples_f
+--
+-- @in:
+--        int - sampling duration in milliseconds,
+--        int - sampling interval in milliseconds
+--
+-- @out:
+--        int - segment id
+--        int - session id,
+--        int - command count,
+--        text - wait event,
+--        bigint - number of samples the query's processes were waiting on
+--                 the event,
+--        bigint - number of samples taken
+--
+-- @doc:
+--        UDF to sample the wait events of the queries running on one
+--        segment
+--
+--------------------------------------------------------------------------------
+
+CREATE FUNCTION gp_toolkit.__gp_wait_event_samples_f_on_master(int, int)
+RETURNS SETOF record
+AS 'gp_wait_event_samples'
+LANGUAGE internal STRICT VOLATILE EXECUTE ON MASTER;
+
+GRANT EXECUTE ON FUNCTION gp_toolkit.__gp_wait_event_samples_f_on_master(int, int) TO public;
+
+CREATE FUNCTION gp_toolkit.__gp_wait_event_samples_f_on_segments(int, int)
+RETURNS SETOF record
+AS 'gp_wait_event_samples'
+LANGUAGE internal STRICT VOLATILE EXECUTE ON ALL SEGMENTS;
+
+GRANT EXECUTE ON FUNCTION gp_toolkit.__gp_wait_event_samples_f_on_segments(int, int) TO public;
+
+--------------------------------------------------------------------------------
+-- @view:
+--        gp_toolkit.gp_wait_events
+--
+-- @doc:
+--        What the processes of the running queries of other sessions are
+--        waiting on right now, per segment.
+--
+--------------------------------------------------------------------------------
+
+CREATE VIEW gp_toolkit.gp_wait_events AS
+WITH all_waits AS (
+   SELECT C.*
+          FROM gp_toolkit.__gp_wait_event_samples_f_on_master(0, 1) AS C (
+            segid int,
+            sess_id int,
+            command_cnt int,
+            wait_event text,
+            samples bigint,
+            sample_rounds bigint
+          )
+    UNION ALL
+    SELECT C.*
+          FROM gp_toolkit.__gp_wait_event_samples_f_on_segments(0, 1) AS C (
+            segid int,
+            sess_id int,
+            command_cnt int,
+            wait_event text,
+            samples bigint,
+            sample_rounds bigint
+          ))
+SELECT S.datname,
+       S.usename,
+       C.sess_id,
+       C.command_cnt,
+       C.segid,
+       C.wait_event,
+       C.samples AS processes
+FROM all_waits C LEFT OUTER JOIN
+pg_stat_activity as S
+ON C.sess_id = S.sess_id
+WHERE C.sess_id <> pg_catalog.current_setting('gp_session_id')::int;
+
+GRANT SELECT ON gp_toolkit.gp_wait_events TO public;
+
+--------------------------------------------------------------------------------
+-- @function:
+--        gp_toolkit.gp_wait_event_profile
+--
+-- @in:
+--        int - sampling duration in milliseconds,
+--        int - sampling interval in milliseconds
+--
+-- @out:
+--        int - session id,
+--        int - command count,
+--        text - wait event,
+--        int - number of segments where the query waited on the event,
+--        bigint - number of samples its processes were waiting on the event,
+--        numeric - average number of its processes waiting on the event
+--
+-- @doc:
+--        Sample the wait events of the running queries of other sessions
+--        on the master and all segments for the given duration, and show
+--        where each query spends its time waiting, most waited on first.
+--
+--------------------------------------------------------------------------------
+
+CREATE FUNCTION gp_toolkit.gp_wait_event_profile(duration_ms int, interval_ms int,
+	OUT sess_id int, OUT command_cnt int, OUT wait_event text,
+	OUT segments int, OUT samples bigint, OUT avg_waiting_processes numeric)
+RETURNS SETOF record
+AS
+$$
+    WITH all_samples AS (
+       SELECT C.*
+              FROM gp_toolkit.__gp_wait_event_samples_f_on_master($1, $2) AS C (
+                segid int,
+                sess_id int,
+                command_cnt int,
+                wait_event text,
+                samples bigint,
+                sample_rounds bigint
+              )
+        UNION ALL
+        SELECT C.*
+              FROM gp_toolkit.__gp_wait_event_samples_f_on_segments($1, $2) AS C (
+                segid int,
+                sess_id int,
+                command_cnt int,
+                wait_event text,
+                samples bigint,
+                sample_rounds bigint
+              ))
+    SELECT sess_id,
+           command_cnt,
+           wait_event,
+           count(DISTINCT segid)::int,
+           sum(samples)::bigint,
+           round(sum(samples::numeric / sample_rounds), 2)
+    FROM all_samples
+    WHERE sess_id <> pg_catalog.current_setting('gp_session_id')::int
+    GROUP BY sess_id, command_cnt, wait_event
+    ORDER BY 5 DESC, 1, 2, 3
+$$
+LANGUAGE sql VOLATILE;
+
+GRANT EXECUTE ON FUNCTION gp_toolkit.gp_wait_event_profile(int, int) TO public;
+
+--------------------------------------------------------------------------------
+
+-- Query resource history views
+--------------------------------------------------------------------------------
+
+--------------------------------------------------------------------------------
+-- @function:
+--        gp_toolkit.__gp_query_resource_history_f
+--
+-- @in:
+--
+-- @out:
+--        int - segment id
+--        int - process id,
+--        int - session id,
+--        int - command count,
+--        int - slice id,
+--        oid - user id,
+--        oid - resource group id,
+--        boolean - whether the query failed,
+--        timestamptz - query start,
+--        timestamptz - query end,
+--        bigint - memory quota of the query,
+--        bigint - peak vmem reserved by the process,
+--        bigint - bytes spilled by sorts,
+--        bigint - bytes spilled by hash joins,
+--        bigint - bytes spilled by hash aggregates,
+--        bigint - bytes spilled by materialize and shared scans,
+--        bigint - bytes spilled by other operators,
+--        bigint - hash aggregate passes over spilled batches,
+--        bigint - batches of spilling hash joins,
+--        bigint - total bytes spilled
+--
+-- @doc:
+--        UDF to retrieve the memory and spill usage of the recently
+--        completed queries on one segment, one row per process
+--
+--------------------------------------------------------------------------------
+
+CREATE FUNCTION gp_toolkit.__gp_query_resource_history_f_on_master()
+RETURNS SETOF record
+AS 'gp_query_resource_history'
+LANGUAGE internal VOLATILE EXECUTE ON MASTER;
+
+GRANT EXECUTE ON FUNCTION gp_toolkit.__gp_query_resource_history_f_on_master() TO public;
+
+CREATE FUNCTION gp_toolkit.__gp_query_resource_history_f_on_segments()
+RETURNS SETOF record
+AS 'gp_query_resource_history'
+LANGUAGE internal VOLATILE EXECUTE ON ALL SEGMENTS;
+
+GRANT EXECUTE ON FUNCTION gp_toolkit.__gp_query_resource_history_f_on_segments() TO public;
+
+--------------------------------------------------------------------------------
+-- @view:
+--        gp_toolkit.gp_query_resource_history
+--
+-- @doc:
+--        Memory and spill usage of the recently completed queries, one row
+--        per query and segment, to size resource groups with. peak_vmem is
+--        the sum of the peaks of the query's processes on the segment. Only
+--        the last gp_query_history_size processes of each segment are kept.
+--
+--------------------------------------------------------------------------------
+
+CREATE VIEW gp_toolkit.gp_query_resource_history AS
+WITH all_processes AS (
+   SELECT C.*
+          FROM gp_toolkit.__gp_query_resource_history_f_on_master() AS C (
+            segid int,
+            pid int,
+            sess_id int,
+            command_cnt int,
+            slice_id int,
+            userid oid,
+            rsgid oid,
+            aborted boolean,
+            start_time timestamptz,
+            end_time timestamptz,
+            query_mem bigint,
+            peak_vmem bigint,
+            sort_spill_bytes bigint,
+            hashjoin_spill_bytes bigint,
+            hashagg_spill_bytes bigint,
+            material_spill_bytes bigint,
+            other_spill_bytes bigint,
+            hashagg_passes bigint,
+            hashjoin_batches bigint,
+            spill_bytes bigint
+          )
+    UNION ALL
+    SELECT C.*
+          FROM gp_toolkit.__gp_query_resource_history_f_on_segments() AS C (
+            segid int,
+            pid int,
+            sess_id int,
+            command_cnt int,
+            slice_id int,
+            userid oid,
+            rsgid oid,
+            aborted boolean,
+            start_time timestamptz,
+            end_time timestamptz,
+            query_mem bigint,
+            peak_vmem bigint,
+            sort_spill_bytes bigint,
+            hashjoin_spill_bytes bigint,
+            hashagg_spill_bytes bigint,
+            material_spill_bytes bigint,
+            other_spill_bytes bigint,
+            hashagg_passes bigint,
+            hashjoin_batches bigint,
+            spill_bytes bigint
+          ))
+SELECT C.sess_id,
+       C.command_cnt,
+       C.segid,
+       R.rolname AS usename,
+       G.rsgname,
+       C.aborted,
+       C.start_time,
+       C.end_time,
+       C.processes,
+       C.query_mem,
+       C.peak_vmem,
+       C.spill_bytes,
+       C.sort_spill_bytes,
+       C.hashjoin_spill_bytes,
+       C.hashagg_spill_bytes,
+       C.material_spill_bytes,
+       C.other_spill_bytes,
+       C.hashagg_passes,
+       C.hashjoin_batches
+FROM (SELECT sess_id,
+             command_cnt,
+             segid,
+             max(userid) AS userid,
+             max(rsgid) AS rsgid,
+             bool_or(aborted) AS aborted,
+             min(start_time) AS start_time,
+             max(end_time) AS end_time,
+             count(*)::int AS processes,
+             max(query_mem) AS query_mem,
+             sum(peak_vmem)::bigint AS peak_vmem,
+             sum(spill_bytes)::bigint AS spill_bytes,
+             sum(sort_spill_bytes)::bigint AS sort_spill_bytes,
+             sum(hashjoin_spill_bytes)::bigint AS hashjoin_spill_bytes,
+             sum(hashagg_spill_bytes)::bigint AS hashagg_spill_bytes,
+             sum(material_spill_bytes)::bigint AS material_spill_bytes,
+             sum(other_spill_bytes)::bigint AS other_spill_bytes,
+             sum(hashagg_passes)::bigint AS hashagg_passes,
+             sum(hashjoin_batches)::bigint AS hashjoin_batches
+      FROM all_processes
+      GROUP BY sess_id, command_cnt, segid) C
+LEFT OUTER JOIN pg_catalog.pg_roles R ON C.userid = R.oid
+LEFT OUTER JOIN pg_catalog.pg_resgroup G ON C.rsgid = G.oid;
+
+GRANT SELECT ON gp_toolkit.gp_query_resource_history TO public;
+
+--------------------------------------------------------------------------------
+-- Statement latency views
+--------------------------------------------------------------------------------
+
+--------------------------------------------------------------------------------
+-- @view:
+--        gp_toolkit.gp_statement_stats
+--
+-- @doc:
+--        Latency of the statements run on the master, by database, user,
+--        statement text with constants removed, and phase: waiting for a
+--        resource queue or group, planning, dispatching, executing, and in
+--        total. Percentiles come from a histogram, and are accurate to
+--        within 1/8 of their value. Only gp_statement_stats_max statements
+--        are kept; the least run ones make room for new ones.
+--
+--------------------------------------------------------------------------------
+
+CREATE VIEW gp_toolkit.gp_statement_stats AS
+SELECT D.datname,
+       R.rolname AS usename,
+       C.fingerprint,
+       C.phase,
+       C.calls,
+       C.total_ms,
+       C.mean_ms,
+       C.p50_ms,
+       C.p90_ms,
+       C.p99_ms,
+       C.max_ms,
+       C.query
+FROM pg_catalog.gp_statement_stats() C
+LEFT OUTER JOIN pg_catalog.pg_database D ON C.dbid = D.oid
+LEFT OUTER JOIN pg_catalog.pg_roles R ON C.userid = R.oid;
+
+GRANT SELECT ON gp_toolkit.gp_statement_stats TO public;
+
 --------------------------------------------------------------------------------
 
 -- Finalize install
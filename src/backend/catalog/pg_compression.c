@@ -38,6 +38,14 @@
 #include "utils/syscache.h"
 #include "utils/faultinjector.h"
 
+#ifdef HAVE_LIBZSTD
+#include <zstd.h>
+#endif
+#ifdef HAVE_LIBLZ4
+#include <lz4.h>
+#include <lz4hc.h>
+#endif
+
 /* names we expect to see in ENCODING clauses */
 char *storage_directive_names[] = {"compresstype", "compresslevel",
 								   "blocksize", NULL};
@@ -65,6 +73,30 @@ typedef struct zlib_state
 
 } zlib_state;
 
+#ifdef HAVE_LIBZSTD
+/*
+ * Internal state for zstd.  The context is created once per
+ * CompressionState and reused for every block, which saves the
+ * allocation and table setup zstd would otherwise do per call.
+ */
+typedef struct zstd_state
+{
+	int			level;			/* compression level */
+	bool		compress;		/* compress or decompress? */
+	ZSTD_CCtx  *cctx;
+	ZSTD_DCtx  *dctx;
+} zstd_state;
+#endif
+
+#ifdef HAVE_LIBLZ4
+/* Internal state for lz4 */
+typedef struct lz4_state
+{
+	int			level;			/* 1 is the fast compressor, 2-9 use LZ4HC */
+	bool		compress;		/* compress or decompress? */
+} lz4_state;
+#endif
+
 static NameData
 comptype_to_name(char *comptype)
 {
@@ -374,6 +406,297 @@ zlib_validator(PG_FUNCTION_ARGS)
 	PG_RETURN_VOID();
 }
 
+#ifdef HAVE_LIBZSTD
+
+Datum
+zstd_constructor(PG_FUNCTION_ARGS)
+{
+	/* PG_GETARG_POINTER(0) is TupleDesc that is currently unused. */
+	StorageAttributes *sa = (StorageAttributes *) PG_GETARG_POINTER(1);
+	CompressionState *cs = palloc0(sizeof(CompressionState));
+	zstd_state *state = palloc0(sizeof(zstd_state));
+	bool		compress = PG_GETARG_BOOL(2);
+
+	cs->opaque = (void *) state;
+	cs->desired_sz = NULL;
+
+	Insist(PointerIsValid(sa->comptype));
+
+	if (sa->complevel == 0)
+		sa->complevel = 1;
+
+	state->level = sa->complevel;
+	state->compress = compress;
+
+	if (compress)
+		state->cctx = ZSTD_createCCtx();
+	else
+		state->dctx = ZSTD_createDCtx();
+
+	if (state->cctx == NULL && state->dctx == NULL)
+		elog(ERROR, "out of memory");
+
+	PG_RETURN_POINTER(cs);
+}
+
+Datum
+zstd_destructor(PG_FUNCTION_ARGS)
+{
+	CompressionState *cs = (CompressionState *) PG_GETARG_POINTER(0);
+
+	if (cs != NULL && cs->opaque != NULL)
+	{
+		zstd_state *state = (zstd_state *) cs->opaque;
+
+		if (state->cctx)
+			ZSTD_freeCCtx(state->cctx);
+		if (state->dctx)
+			ZSTD_freeDCtx(state->dctx);
+		pfree(state);
+	}
+
+	PG_RETURN_VOID();
+}
+
+Datum
+zstd_compress(PG_FUNCTION_ARGS)
+{
+	const void *src = PG_GETARG_POINTER(0);
+	int32		src_sz = PG_GETARG_INT32(1);
+	void	   *dst = PG_GETARG_POINTER(2);
+	int32		dst_sz = PG_GETARG_INT32(3);
+	int32	   *dst_used = (int32 *) PG_GETARG_POINTER(4);
+	CompressionState *cs = (CompressionState *) PG_GETARG_POINTER(5);
+	zstd_state *state = (zstd_state *) cs->opaque;
+	size_t		dst_length_used;
+
+	dst_length_used = ZSTD_compressCCtx(state->cctx, dst, dst_sz,
+										src, src_sz, state->level);
+
+	if (ZSTD_isError(dst_length_used))
+	{
+		/*
+		 * zstd fails with dstSize_tooSmall when the data didn't compress
+		 * into a buffer smaller than the input.  Like zlib's Z_BUF_ERROR,
+		 * the caller detects incompressible data by dst_used.
+		 */
+		if (ZSTD_getErrorCode(dst_length_used) != ZSTD_error_dstSize_tooSmall)
+			elog(ERROR, "%s", ZSTD_getErrorName(dst_length_used));
+
+		*dst_used = src_sz;
+	}
+	else
+		*dst_used = (int32) dst_length_used;
+
+	PG_RETURN_VOID();
+}
+
+Datum
+zstd_decompress(PG_FUNCTION_ARGS)
+{
+	const char *src = PG_GETARG_POINTER(0);
+	int32		src_sz = PG_GETARG_INT32(1);
+	void	   *dst = PG_GETARG_POINTER(2);
+	int32		dst_sz = PG_GETARG_INT32(3);
+	int32	   *dst_used = (int32 *) PG_GETARG_POINTER(4);
+	CompressionState *cs = (CompressionState *) PG_GETARG_POINTER(5);
+	zstd_state *state = (zstd_state *) cs->opaque;
+	size_t		dst_length_used;
+
+	Insist(src_sz > 0 && dst_sz > 0);
+
+	dst_length_used = ZSTD_decompressDCtx(state->dctx, dst, dst_sz,
+										  src, src_sz);
+
+	if (ZSTD_isError(dst_length_used))
+		elog(ERROR, "zstd decompression failed: %s",
+			 ZSTD_getErrorName(dst_length_used));
+
+	*dst_used = (int32) dst_length_used;
+
+	PG_RETURN_VOID();
+}
+
+Datum
+zstd_validator(PG_FUNCTION_ARGS)
+{
+	PG_RETURN_VOID();
+}
+
+#else							/* HAVE_LIBZSTD */
+
+Datum
+zstd_constructor(PG_FUNCTION_ARGS)
+{
+	elog(ERROR, "zstd compression not supported by this build");
+	PG_RETURN_VOID();
+}
+
+Datum
+zstd_destructor(PG_FUNCTION_ARGS)
+{
+	elog(ERROR, "zstd compression not supported by this build");
+	PG_RETURN_VOID();
+}
+
+Datum
+zstd_compress(PG_FUNCTION_ARGS)
+{
+	elog(ERROR, "zstd compression not supported by this build");
+	PG_RETURN_VOID();
+}
+
+Datum
+zstd_decompress(PG_FUNCTION_ARGS)
+{
+	elog(ERROR, "zstd compression not supported by this build");
+	PG_RETURN_VOID();
+}
+
+Datum
+zstd_validator(PG_FUNCTION_ARGS)
+{
+	elog(ERROR, "zstd compression not supported by this build");
+	PG_RETURN_VOID();
+}
+
+#endif							/* HAVE_LIBZSTD */
+
+#ifdef HAVE_LIBLZ4
+
+Datum
+lz4_constructor(PG_FUNCTION_ARGS)
+{
+	/* PG_GETARG_POINTER(0) is TupleDesc that is currently unused. */
+	StorageAttributes *sa = (StorageAttributes *) PG_GETARG_POINTER(1);
+	CompressionState *cs = palloc0(sizeof(CompressionState));
+	lz4_state  *state = palloc0(sizeof(lz4_state));
+	bool		compress = PG_GETARG_BOOL(2);
+
+	cs->opaque = (void *) state;
+	cs->desired_sz = NULL;
+
+	Insist(PointerIsValid(sa->comptype));
+
+	if (sa->complevel == 0)
+		sa->complevel = 1;
+
+	state->level = sa->complevel;
+	state->compress = compress;
+
+	PG_RETURN_POINTER(cs);
+}
+
+Datum
+lz4_destructor(PG_FUNCTION_ARGS)
+{
+	CompressionState *cs = (CompressionState *) PG_GETARG_POINTER(0);
+
+	if (cs != NULL && cs->opaque != NULL)
+		pfree(cs->opaque);
+
+	PG_RETURN_VOID();
+}
+
+Datum
+lz4_compress(PG_FUNCTION_ARGS)
+{
+	const char *src = PG_GETARG_POINTER(0);
+	int32		src_sz = PG_GETARG_INT32(1);
+	char	   *dst = PG_GETARG_POINTER(2);
+	int32		dst_sz = PG_GETARG_INT32(3);
+	int32	   *dst_used = (int32 *) PG_GETARG_POINTER(4);
+	CompressionState *cs = (CompressionState *) PG_GETARG_POINTER(5);
+	lz4_state  *state = (lz4_state *) cs->opaque;
+	int			compressed;
+
+	/*
+	 * Level 1 is plain LZ4, which is what people pick lz4 for: cheap
+	 * compression and very fast decompression.  Higher levels trade
+	 * compression speed for ratio with LZ4HC; the output format is the
+	 * same, so decompression doesn't care which one wrote the block.
+	 */
+	if (state->level <= 1)
+		compressed = LZ4_compress_default(src, dst, src_sz, dst_sz);
+	else
+		compressed = LZ4_compress_HC(src, dst, src_sz, dst_sz, state->level);
+
+	/* 0 means the output didn't fit; the caller treats it as incompressible */
+	if (compressed <= 0)
+		*dst_used = src_sz;
+	else
+		*dst_used = compressed;
+
+	PG_RETURN_VOID();
+}
+
+Datum
+lz4_decompress(PG_FUNCTION_ARGS)
+{
+	const char *src = PG_GETARG_POINTER(0);
+	int32		src_sz = PG_GETARG_INT32(1);
+	char	   *dst = PG_GETARG_POINTER(2);
+	int32		dst_sz = PG_GETARG_INT32(3);
+	int32	   *dst_used = (int32 *) PG_GETARG_POINTER(4);
+	int			decompressed;
+
+	Insist(src_sz > 0 && dst_sz > 0);
+
+	decompressed = LZ4_decompress_safe(src, dst, src_sz, dst_sz);
+
+	if (decompressed < 0)
+		elog(ERROR, "lz4 encountered data in an unexpected format");
+
+	*dst_used = decompressed;
+
+	PG_RETURN_VOID();
+}
+
+Datum
+lz4_validator(PG_FUNCTION_ARGS)
+{
+	PG_RETURN_VOID();
+}
+
+#else							/* HAVE_LIBLZ4 */
+
+Datum
+lz4_constructor(PG_FUNCTION_ARGS)
+{
+	elog(ERROR, "lz4 compression not supported by this build");
+	PG_RETURN_VOID();
+}
+
+Datum
+lz4_destructor(PG_FUNCTION_ARGS)
+{
+	elog(ERROR, "lz4 compression not supported by this build");
+	PG_RETURN_VOID();
+}
+
+Datum
+lz4_compress(PG_FUNCTION_ARGS)
+{
+	elog(ERROR, "lz4 compression not supported by this build");
+	PG_RETURN_VOID();
+}
+
+Datum
+lz4_decompress(PG_FUNCTION_ARGS)
+{
+	elog(ERROR, "lz4 compression not supported by this build");
+	PG_RETURN_VOID();
+}
+
+Datum
+lz4_validator(PG_FUNCTION_ARGS)
+{
+	elog(ERROR, "lz4 compression not supported by this build");
+	PG_RETURN_VOID();
+}
+
+#endif							/* HAVE_LIBLZ4 */
+
 Datum
 rle_type_constructor(PG_FUNCTION_ARGS)
 {
@@ -466,7 +789,7 @@ compresstype_is_valid(char *comptype)
 	 * must change!
 	 */
 	static const char *const valid_comptypes[] =
-			{"quicklz", "zlib", "rle_type", "none"};
+			{"quicklz", "zlib", "zstd", "lz4", "rle_type", "none"};
 	for (i = 0; !found && i < ARRAY_SIZE(valid_comptypes); ++i)
 	{
 		if (pg_strcasecmp(valid_comptypes[i], comptype) == 0)
@@ -473,14 +473,16 @@ CREATE VIEW pg_resqueue_status AS
 			q.rsqcostlimit, 
 			s.queuecostvalue AS rsqcostvalue,
 			s.queuewaiters AS rsqwaiters,
-			s.queueholders AS rsqholders
+			s.queueholders AS rsqholders,
+			s.queuewaithistogram AS rsqwaithistogram
 	FROM pg_resqueue AS q 
 			INNER JOIN pg_resqueue_status() AS s 
 			(	queueid oid, 
 	 			queuecountvalue float4, 
 				queuecostvalue float4,
 				queuewaiters int4,
-				queueholders int4)
+				queueholders int4,
+				queuewaithistogram int8[])
 			ON (s.queueid = q.oid);
 			
 -- External table views
@@ -1233,6 +1233,31 @@ AppendOnlyStorageRead_GetBuffer(AppendOnlyStorageRead *storageRead)
 	return content;
 }
 
+/*
+ * Get a pointer to the *small* content exactly as it is stored, without
+ * decompressing it.
+ *
+ * The content is compressed when the block is, and is then as long as
+ * AppendOnlyStorageRead_CurrentCompressedLen.  This lets a writer copy the
+ * block to another segment file of the same relation.
+ */
+uint8 *
+AppendOnlyStorageRead_GetStoredContent(AppendOnlyStorageRead *storageRead)
+{
+	uint8	   *header;
+	uint8	   *content;
+
+	Assert(storageRead != NULL);
+	Assert(storageRead->isActive);
+	Assert(!storageRead->current.isLarge);
+
+	AppendOnlyStorageRead_InternalGetBuffer(storageRead,
+											&header,
+											&content);
+
+	return content;
+}
+
 /*
  * Copy the large and/or decompressed content out.
  *
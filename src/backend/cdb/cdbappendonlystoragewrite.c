@@ -20,6 +20,7 @@
 #endif
 #include <sys/file.h>
 #include <unistd.h>
+#include <pthread.h>
 
 #include "catalog/heap.h"
 #include "catalog/pg_compression.h"
@@ -28,10 +29,16 @@
 #include "cdb/cdbappendonlystoragelayer.h"
 #include "cdb/cdbappendonlystorageformat.h"
 #include "cdb/cdbappendonlystoragewrite.h"
+#include "cdb/cdbgang.h"
 #include "cdb/cdbmirroredfilesysobj.h"
 #include "cdb/cdbpersistentfilesysobj.h"
+#include "cdb/cdbvars.h"
+#include "miscadmin.h"
 #include "utils/guc.h"
 
+static void AppendOnlyStorageWrite_FinishCompress(AppendOnlyStorageWrite *storageWrite);
+static void AppendOnlyStorageWrite_EndCompressSession(AppendOnlyStorageWrite *storageWrite);
+
 
 /*----------------------------------------------------------------
  * Initialization
@@ -191,6 +198,8 @@ AppendOnlyStorageWrite_FinishSession(AppendOnlyStorageWrite *storageWrite)
 	if (!storageWrite->isActive)
 		return;
 
+	AppendOnlyStorageWrite_EndCompressSession(storageWrite);
+
 	oldMemoryContext = MemoryContextSwitchTo(storageWrite->memoryContext);
 
 	/*
@@ -534,6 +543,8 @@ AppendOnlyStorageWrite_FlushAndCloseFile(
 		return;
 	}
 
+	AppendOnlyStorageWrite_FinishCompress(storageWrite);
+
 	/*
 	 * We pad out append commands to the page boundary.
 	 */
@@ -623,6 +634,9 @@ AppendOnlyStorageWrite_TransactionFlushAndCloseFile(
 
 	startEof = storageWrite->startEof;
 
+	/* Finish any block being compressed before taking the lock. */
+	AppendOnlyStorageWrite_FinishCompress(storageWrite);
+
 	/*
 	 * Use the MirroredLock here to cover the flush (and close) and evaluation
 	 * below whether we must catchup the mirror.
@@ -953,6 +967,8 @@ AppendOnlyStorageWrite_CurrentPosition(AppendOnlyStorageWrite *storageWrite)
 	Assert(storageWrite != NULL);
 	Assert(storageWrite->isActive);
 
+	AppendOnlyStorageWrite_FinishCompress(storageWrite);
+
 	return BufferedAppendCurrentBufferPosition(
 											   &storageWrite->bufferedAppend);
 }
@@ -967,6 +983,8 @@ AppendOnlyStorageWrite_GetCurrentInternalBuffer(AppendOnlyStorageWrite *storageW
 	Assert(storageWrite != NULL);
 	Assert(storageWrite->isActive);
 
+	AppendOnlyStorageWrite_FinishCompress(storageWrite);
+
 	return BufferedAppendGetCurrentBuffer(&storageWrite->bufferedAppend);
 }
 
@@ -1253,59 +1271,282 @@ AppendOnlyStorageWrite_VerifyWriteBlock(AppendOnlyStorageWrite *storageWrite,
 #endif
 }
 
-static void
-AppendOnlyStorageWrite_CompressAppend(AppendOnlyStorageWrite *storageWrite,
-									  uint8 *sourceData,
-									  int32 sourceLen,
-									  int executorBlockKind,
-									  int itemCount,
-									  int32 *compressedLen,
-									  int32 *bufferLen)
+/*----------------------------------------------------------------
+ * Compression
+ *----------------------------------------------------------------
+ */
+
+/*
+ * A small content block being compressed.
+ *
+ * Compression is split in three steps: reserving the block in the
+ * BufferedAppend buffer, running the compressor into it, and making the
+ * header.  Normally they all run at once.  With compression workers, the
+ * compressor runs on a worker thread while the backend goes on producing
+ * the next block, and the header is made when the block is needed.  Only
+ * the compressor itself runs off the main thread.
+ */
+typedef struct AppendOnlyCompressJob
 {
+	uint8	   *sourceData;
+	int32		sourceLen;
+
+	/* The block's space in the BufferedAppend buffer. */
 	uint8	   *header;
 	uint8	   *dataBuffer;
-	int32		dataRoundedUpLen = 0;	/* Shutup compiler. */
-	int32		dataBufferWithOverrrunLen;
-	PGFunction *cfns = storageWrite->compression_functions;
+	int32		dataBufferLen;
+
+	/* What the storage header needs, as of when the block was finished. */
+	AoHeaderKind aoHeaderKind;
+	int32		completeHeaderLen;
+	bool		isFirstRowNumSet;
+	int64		firstRowNum;
+	int			executorBlockKind;
+	int			itemCount;
+	int64		headerOffsetInFile;
+
+	int32		compressedLen;
+
+	/* Used by the compression workers only. */
+	uint8	   *buffer;			/* owned copy of the content */
 	PGFunction	compressor;
+	CompressionState *compressionState;
+	bool		inFlight;		/* given to the workers and not finished */
+	bool		done;			/* the worker has run the compressor */
+	struct AppendOnlyCompressJob *next;
+} AppendOnlyCompressJob;
 
-	if (cfns == NULL)
-		compressor = NULL;
+/*
+ * The compression workers of this backend, shared by all the append-only
+ * writers.  Each writer has at most one block with the workers at a time,
+ * so the writers of the columns of a column-oriented table compress in
+ * parallel, and a row-oriented table overlaps compressing a block with
+ * filling the next.  Blocks are still written in order.
+ */
+static pthread_mutex_t CompressPoolMutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t CompressPoolWorkCond = PTHREAD_COND_INITIALIZER;
+static pthread_cond_t CompressPoolDoneCond = PTHREAD_COND_INITIALIZER;
+static AppendOnlyCompressJob *CompressPoolHead = NULL;
+static AppendOnlyCompressJob *CompressPoolTail = NULL;
+static int	CompressPoolJobsInFlight = 0;
+static int	CompressPoolThreads = 0;
+
+static void *
+AppendOnlyCompressWorkerMain(void *arg)
+{
+	gp_set_thread_sigmasks();
+
+	pthread_mutex_lock(&CompressPoolMutex);
+	for (;;)
+	{
+		AppendOnlyCompressJob *job;
+
+		while (CompressPoolHead == NULL)
+			pthread_cond_wait(&CompressPoolWorkCond, &CompressPoolMutex);
+
+		job = CompressPoolHead;
+		CompressPoolHead = job->next;
+		if (CompressPoolHead == NULL)
+			CompressPoolTail = NULL;
+		pthread_mutex_unlock(&CompressPoolMutex);
+
+		/*
+		 * The compressors allowed here (see
+		 * AppendOnlyStorageWrite_UseCompressWorkers) don't allocate memory or
+		 * report errors, except on out-of-memory inside the library.
+		 */
+		callCompressionActuator(job->compressor,
+								job->sourceData,
+								job->sourceLen,
+								(char *) job->dataBuffer,
+								job->dataBufferLen,
+								&job->compressedLen,
+								job->compressionState);
+
+		pthread_mutex_lock(&CompressPoolMutex);
+		job->done = true;
+		CompressPoolJobsInFlight--;
+		pthread_cond_broadcast(&CompressPoolDoneCond);
+	}
+
+	return NULL;
+}
+
+/*
+ * Start compression workers up to gp_appendonly_compress_workers.  Returns
+ * false if there are none.
+ */
+static bool
+AppendOnlyCompressPoolStart(void)
+{
+	while (CompressPoolThreads < gp_appendonly_compress_workers)
+	{
+		pthread_t	thread;
+		int			pthread_err;
+
+		pthread_err = gp_pthread_create(&thread, AppendOnlyCompressWorkerMain,
+										NULL, "AppendOnlyCompress");
+		if (pthread_err != 0)
+		{
+			elog(LOG, "could not create append-only compression worker thread: error %d",
+				 pthread_err);
+			break;
+		}
+		pthread_detach(thread);
+		CompressPoolThreads++;
+	}
+
+	return (CompressPoolThreads > 0);
+}
+
+static void
+AppendOnlyCompressPoolSubmit(AppendOnlyCompressJob *job)
+{
+	job->done = false;
+	job->next = NULL;
+	job->inFlight = true;
+
+	pthread_mutex_lock(&CompressPoolMutex);
+	if (CompressPoolTail == NULL)
+		CompressPoolHead = job;
 	else
-		compressor = cfns[COMPRESSION_COMPRESS];
+		CompressPoolTail->next = job;
+	CompressPoolTail = job;
+	CompressPoolJobsInFlight++;
+	pthread_cond_signal(&CompressPoolWorkCond);
+	pthread_mutex_unlock(&CompressPoolMutex);
+}
+
+static void
+AppendOnlyCompressPoolWait(AppendOnlyCompressJob *job)
+{
+	pthread_mutex_lock(&CompressPoolMutex);
+	while (!job->done)
+		pthread_cond_wait(&CompressPoolDoneCond, &CompressPoolMutex);
+	pthread_mutex_unlock(&CompressPoolMutex);
+}
+
+/*
+ * Wait for the compression workers to be done with all blocks, before the
+ * memory they write into goes away.
+ */
+void
+AtAbort_AppendOnlyCompress(void)
+{
+	if (CompressPoolThreads == 0)
+		return;
+
+	pthread_mutex_lock(&CompressPoolMutex);
+	while (CompressPoolJobsInFlight > 0)
+		pthread_cond_wait(&CompressPoolDoneCond, &CompressPoolMutex);
+	pthread_mutex_unlock(&CompressPoolMutex);
+}
+
+/*
+ * Should this writer hand its blocks to the compression workers?
+ */
+static bool
+AppendOnlyStorageWrite_UseCompressWorkers(AppendOnlyStorageWrite *storageWrite)
+{
+	if (gp_appendonly_compress_workers <= 0 ||
+		!storageWrite->storageAttributes.compress)
+		return false;
+
+	if (!storageWrite->compressJobChecked)
+	{
+		char	   *compressType = storageWrite->storageAttributes.compressType;
+
+		storageWrite->compressJobChecked = true;
+
+		/*
+		 * Only compressors that are safe to run on a thread.
+		 */
+		if (storageWrite->compression_functions != NULL &&
+			compressType != NULL &&
+			(pg_strcasecmp(compressType, "zlib") == 0 ||
+			 pg_strcasecmp(compressType, "zstd") == 0 ||
+			 pg_strcasecmp(compressType, "lz4") == 0))
+		{
+			AppendOnlyCompressJob *job;
+
+			job = (AppendOnlyCompressJob *)
+				MemoryContextAllocZero(storageWrite->memoryContext,
+									   sizeof(AppendOnlyCompressJob));
+			job->buffer = (uint8 *)
+				MemoryContextAlloc(storageWrite->memoryContext,
+								   storageWrite->maxBufferLen);
+			job->compressor =
+				storageWrite->compression_functions[COMPRESSION_COMPRESS];
+			job->compressionState = storageWrite->compressionState;
+
+			storageWrite->compressJob = job;
+		}
+	}
 
+	return (storageWrite->compressJob != NULL && AppendOnlyCompressPoolStart());
+}
+
+/*
+ * Reserve the block in the BufferedAppend buffer.
+ */
+static void
+AppendOnlyStorageWrite_PrepareCompress(AppendOnlyStorageWrite *storageWrite,
+									   AppendOnlyCompressJob *job,
+									   uint8 *sourceData,
+									   int32 sourceLen,
+									   int executorBlockKind,
+									   int itemCount)
+{
 	/* UNDONE: This can be a duplicate call... */
 	storageWrite->currentCompleteHeaderLen =
 		AppendOnlyStorageWrite_CompleteHeaderLen(
 												 storageWrite,
 												 storageWrite->getBufferAoHeaderKind);
 
-	header = BufferedAppendGetMaxBuffer(&storageWrite->bufferedAppend);
-	if (header == NULL)
+	job->header = BufferedAppendGetMaxBuffer(&storageWrite->bufferedAppend);
+	if (job->header == NULL)
 		ereport(ERROR,
 				(errcode(ERRCODE_GP_INTERNAL_ERROR),
 				 errmsg("We do not expect files to be have a maximum length"),
 				 errcontext_appendonly_write_storage_block(storageWrite)));
 
-	dataBuffer = &header[storageWrite->currentCompleteHeaderLen];
-	dataBufferWithOverrrunLen =
+	job->dataBuffer = &job->header[storageWrite->currentCompleteHeaderLen];
+	job->dataBufferLen =
 		storageWrite->maxBufferWithCompressionOverrrunLen
 		- storageWrite->currentCompleteHeaderLen;
 
-	/*
-	 * Compress into the BufferedAppend buffer after the large header (and
-	 * optional checksum, etc.
-	 */
-	(void) gp_trycompress_new(
-							  sourceData,
-							  sourceLen,
-							  dataBuffer,
-							  dataBufferWithOverrrunLen,
-							  sourceLen, //Limit compression to be no more than the input size.
-							  compressedLen,
-							  storageWrite->storageAttributes.compressLevel,
-							  compressor,
-							  storageWrite->compressionState);
+	job->sourceData = sourceData;
+	job->sourceLen = sourceLen;
+	job->aoHeaderKind = storageWrite->getBufferAoHeaderKind;
+	job->completeHeaderLen = storageWrite->currentCompleteHeaderLen;
+	job->isFirstRowNumSet = storageWrite->isFirstRowNumSet;
+	job->firstRowNum = storageWrite->firstRowNum;
+	job->executorBlockKind = executorBlockKind;
+	job->itemCount = itemCount;
+	job->headerOffsetInFile =
+		BufferedAppendCurrentBufferPosition(&storageWrite->bufferedAppend);
+	job->compressedLen = 0;
+}
+
+/*
+ * Make the header of a block the compressor has run on, or store the data
+ * uncompressed if it didn't get smaller.
+ */
+static void
+AppendOnlyStorageWrite_FormatCompressed(AppendOnlyStorageWrite *storageWrite,
+										AppendOnlyCompressJob *job,
+										int32 *compressedLen,
+										int32 *bufferLen)
+{
+	uint8	   *header = job->header;
+	uint8	   *dataBuffer = job->dataBuffer;
+	uint8	   *sourceData = job->sourceData;
+	int32		sourceLen = job->sourceLen;
+	int			executorBlockKind = job->executorBlockKind;
+	int			itemCount = job->itemCount;
+	int32		dataRoundedUpLen = 0;	/* Shutup compiler. */
+
+	*compressedLen = job->compressedLen;
 
 	/*
 	 * We always store the data compressed if the compressed length is less
@@ -1330,7 +1571,7 @@ AppendOnlyStorageWrite_CompressAppend(AppendOnlyStorageWrite *storageWrite,
 						  *compressedLen,
 						  dataRoundedUpLen);
 
-		switch (storageWrite->getBufferAoHeaderKind)
+		switch (job->aoHeaderKind)
 		{
 			case AoHeaderKind_SmallContent:
 
@@ -1340,9 +1581,9 @@ AppendOnlyStorageWrite_CompressAppend(AppendOnlyStorageWrite *storageWrite,
 				AppendOnlyStorageFormat_MakeSmallContentHeader
 					(header,
 					 storageWrite->storageAttributes.checksum,
-					 storageWrite->isFirstRowNumSet,
+					 job->isFirstRowNumSet,
 					 storageWrite->formatVersion,
-					 storageWrite->firstRowNum,
+					 job->firstRowNum,
 					 executorBlockKind,
 					 itemCount,
 					 sourceLen,
@@ -1357,9 +1598,9 @@ AppendOnlyStorageWrite_CompressAppend(AppendOnlyStorageWrite *storageWrite,
 				AppendOnlyStorageFormat_MakeBulkDenseContentHeader
 					(header,
 					 storageWrite->storageAttributes.checksum,
-					 storageWrite->isFirstRowNumSet,
+					 job->isFirstRowNumSet,
 					 storageWrite->formatVersion,
-					 storageWrite->firstRowNum,
+					 job->firstRowNum,
 					 executorBlockKind,
 					 itemCount,
 					 sourceLen,
@@ -1368,7 +1609,7 @@ AppendOnlyStorageWrite_CompressAppend(AppendOnlyStorageWrite *storageWrite,
 
 			default:
 				elog(ERROR, "Unexpected Append-Only header kind %d",
-					 storageWrite->getBufferAoHeaderKind);
+					 job->aoHeaderKind);
 				break;
 		}
 
@@ -1414,9 +1655,9 @@ AppendOnlyStorageWrite_CompressAppend(AppendOnlyStorageWrite *storageWrite,
 		AppendOnlyStorageFormat_MakeSmallContentHeader
 			(header,
 			 storageWrite->storageAttributes.checksum,
-			 storageWrite->isFirstRowNumSet,
+			 job->isFirstRowNumSet,
 			 storageWrite->formatVersion,
-			 storageWrite->firstRowNum,
+			 job->firstRowNum,
 			 executorBlockKind,
 			 itemCount,
 			 sourceLen,
@@ -1441,7 +1682,131 @@ AppendOnlyStorageWrite_CompressAppend(AppendOnlyStorageWrite *storageWrite,
 			   storageWrite->bufferCount);
 	}
 
-	*bufferLen = storageWrite->currentCompleteHeaderLen + dataRoundedUpLen;
+	*bufferLen = job->completeHeaderLen + dataRoundedUpLen;
+}
+
+static void
+AppendOnlyStorageWrite_CompressAppend(AppendOnlyStorageWrite *storageWrite,
+									  uint8 *sourceData,
+									  int32 sourceLen,
+									  int executorBlockKind,
+									  int itemCount,
+									  int32 *compressedLen,
+									  int32 *bufferLen)
+{
+	AppendOnlyCompressJob job;
+	PGFunction *cfns = storageWrite->compression_functions;
+	PGFunction	compressor;
+
+	if (cfns == NULL)
+		compressor = NULL;
+	else
+		compressor = cfns[COMPRESSION_COMPRESS];
+
+	AppendOnlyStorageWrite_PrepareCompress(storageWrite, &job,
+										   sourceData, sourceLen,
+										   executorBlockKind, itemCount);
+
+	/*
+	 * Compress into the BufferedAppend buffer after the large header (and
+	 * optional checksum, etc.
+	 */
+	(void) gp_trycompress_new(
+							  sourceData,
+							  sourceLen,
+							  job.dataBuffer,
+							  job.dataBufferLen,
+							  sourceLen, //Limit compression to be no more than the input size.
+							  &job.compressedLen,
+							  storageWrite->storageAttributes.compressLevel,
+							  compressor,
+							  storageWrite->compressionState);
+
+	AppendOnlyStorageWrite_FormatCompressed(storageWrite, &job,
+											compressedLen, bufferLen);
+}
+
+/*
+ * Hand the content in the compress job's buffer to the compression workers.
+ * The block goes right after the previous one, which must be finished.
+ */
+static void
+AppendOnlyStorageWrite_StartCompress(AppendOnlyStorageWrite *storageWrite,
+									 int32 sourceLen,
+									 int executorBlockKind,
+									 int itemCount)
+{
+	AppendOnlyCompressJob *job = storageWrite->compressJob;
+
+	Assert(!job->inFlight);
+
+	AppendOnlyStorageWrite_PrepareCompress(storageWrite, job,
+										   job->buffer, sourceLen,
+										   executorBlockKind, itemCount);
+
+	storageWrite->logicalBlockStartOffset =
+		BufferedAppendNextBufferPosition(&storageWrite->bufferedAppend);
+
+	AppendOnlyCompressPoolSubmit(job);
+
+	/* Declare it finished, as far as the caller is concerned. */
+	storageWrite->currentCompleteHeaderLen = 0;
+}
+
+/*
+ * Finish the block the compression workers have, if any, and add it to the
+ * BufferedAppend buffer.
+ */
+static void
+AppendOnlyStorageWrite_FinishCompress(AppendOnlyStorageWrite *storageWrite)
+{
+	AppendOnlyCompressJob *job = storageWrite->compressJob;
+	int32		compressedLen;
+	int32		bufferLen;
+
+	if (job == NULL || !job->inFlight)
+		return;
+
+	AppendOnlyCompressPoolWait(job);
+	job->inFlight = false;
+
+	AppendOnlyStorageWrite_FormatCompressed(storageWrite, job,
+											&compressedLen, &bufferLen);
+
+	if (gp_appendonly_verify_write_block)
+		AppendOnlyStorageWrite_VerifyWriteBlock(storageWrite,
+												job->headerOffsetInFile,
+												bufferLen,
+												job->sourceData,
+												job->sourceLen,
+												job->executorBlockKind,
+												job->itemCount,
+												compressedLen);
+
+	BufferedAppendFinishBuffer(&storageWrite->bufferedAppend,
+							   bufferLen,
+							   job->completeHeaderLen +
+							   AOStorage_RoundUp(job->sourceLen, storageWrite->formatVersion) /* non-compressed size */ );
+}
+
+/*
+ * Wait for the compression workers to let go of this writer's block, and
+ * free the compress job.
+ */
+static void
+AppendOnlyStorageWrite_EndCompressSession(AppendOnlyStorageWrite *storageWrite)
+{
+	AppendOnlyCompressJob *job = storageWrite->compressJob;
+
+	if (job == NULL)
+		return;
+
+	if (job->inFlight)
+		AppendOnlyCompressPoolWait(job);
+
+	pfree(job->buffer);
+	pfree(job);
+	storageWrite->compressJob = NULL;
 }
 
 /*
@@ -1485,6 +1850,9 @@ AppendOnlyStorageWrite_FinishBuffer(AppendOnlyStorageWrite *storageWrite,
 			 (storageWrite->isFirstRowNumSet ? "true" : "false"));
 
 
+	/* The previous block goes first. */
+	AppendOnlyStorageWrite_FinishCompress(storageWrite);
+
 	headerOffsetInFile = BufferedAppendCurrentBufferPosition(&storageWrite->bufferedAppend);
 
 	if (!storageWrite->storageAttributes.compress)
@@ -1588,6 +1956,22 @@ AppendOnlyStorageWrite_FinishBuffer(AppendOnlyStorageWrite *storageWrite,
 			   storageWrite->bufferCount);
 
 	}
+	else if (AppendOnlyStorageWrite_UseCompressWorkers(storageWrite))
+	{
+		uint8	   *content = storageWrite->uncompressedBuffer;
+
+		/*
+		 * The job takes the content buffer, and gives its own buffer for the
+		 * next block.
+		 */
+		storageWrite->uncompressedBuffer = storageWrite->compressJob->buffer;
+		storageWrite->compressJob->buffer = content;
+
+		AppendOnlyStorageWrite_StartCompress(storageWrite,
+											 contentLen,
+											 executorBlockKind,
+											 rowCount);
+	}
 	else
 	{
 		int32		compressedLen = 0;
@@ -1644,6 +2028,8 @@ AppendOnlyStorageWrite_CancelLastBuffer(
 
 	Assert(storageWrite->currentCompleteHeaderLen > 0);
 
+	AppendOnlyStorageWrite_FinishCompress(storageWrite);
+
 	if (storageWrite->currentBuffer != NULL)
 	{
 		BufferedAppendCancelLastBuffer(&storageWrite->bufferedAppend);
@@ -1705,6 +2091,9 @@ AppendOnlyStorageWrite_Content(AppendOnlyStorageWrite *storageWrite,
 	Assert(storageWrite != NULL);
 	Assert(storageWrite->isActive);
 
+	/* The previous block goes first. */
+	AppendOnlyStorageWrite_FinishCompress(storageWrite);
+
 	completeHeaderLen =
 		AppendOnlyStorageWrite_CompleteHeaderLen(storageWrite,
 												 AoHeaderKind_SmallContent);
@@ -1729,6 +2118,19 @@ AppendOnlyStorageWrite_Content(AppendOnlyStorageWrite *storageWrite,
 												rowCount);
 			Assert(storageWrite->currentCompleteHeaderLen == 0);
 		}
+		else if (AppendOnlyStorageWrite_UseCompressWorkers(storageWrite))
+		{
+			/*
+			 * The caller may reuse the content right away, so the job gets a
+			 * copy.
+			 */
+			storageWrite->getBufferAoHeaderKind = AoHeaderKind_SmallContent;
+			memcpy(storageWrite->compressJob->buffer, content, contentLen);
+			AppendOnlyStorageWrite_StartCompress(storageWrite,
+												 contentLen,
+												 executorBlockKind,
+												 rowCount);
+		}
 		else
 		{
 			/*
@@ -1924,6 +2326,112 @@ AppendOnlyStorageWrite_Content(AppendOnlyStorageWrite *storageWrite,
  */
 
 
+/*
+ * Append the current block of a read session on another segment file of the
+ * same relation, without decompressing and compressing it again.
+ *
+ * Only the header is made again, with the first row number set for this
+ * writer.  Return false, and do nothing, if the block cannot be copied as it
+ * is: large content, a different format version, or a block that does not
+ * fit once the header grows.  The caller then reads the block's content the
+ * usual way.
+ */
+bool
+AppendOnlyStorageWrite_CopyBlock(AppendOnlyStorageWrite *storageWrite,
+								 AppendOnlyStorageRead *storageRead)
+{
+	AppendOnlyStorageReadCurrent *current;
+	int32		storedLen;
+	int32		completeHeaderLen;
+	int32		dataRoundedUpLen;
+	int32		bufferLen;
+	int64		headerOffsetInFile;
+	uint8	   *header;
+	uint8	   *data;
+	uint8	   *content;
+
+	Assert(storageWrite != NULL);
+	Assert(storageWrite->isActive);
+	Assert(storageRead != NULL);
+	Assert(storageRead->isActive);
+	Assert(storageWrite->currentCompleteHeaderLen == 0);
+
+	current = &storageRead->current;
+
+	if (current->headerKind != AoHeaderKind_SmallContent ||
+		current->isLarge ||
+		storageRead->formatVersion != storageWrite->formatVersion ||
+		(current->isCompressed && !storageWrite->storageAttributes.compress))
+		return false;
+
+	storedLen = (current->isCompressed ?
+				 current->compressedLen : current->uncompressedLen);
+
+	completeHeaderLen =
+		AppendOnlyStorageWrite_CompleteHeaderLen(storageWrite,
+												 AoHeaderKind_SmallContent);
+	dataRoundedUpLen = AOStorage_RoundUp(storedLen, storageWrite->formatVersion);
+	bufferLen = completeHeaderLen + dataRoundedUpLen;
+	if (bufferLen > storageWrite->maxBufferLen)
+		return false;
+
+	/* The previous block goes first. */
+	AppendOnlyStorageWrite_FinishCompress(storageWrite);
+
+	content = AppendOnlyStorageRead_GetStoredContent(storageRead);
+
+	headerOffsetInFile = BufferedAppendCurrentBufferPosition(&storageWrite->bufferedAppend);
+	storageWrite->logicalBlockStartOffset =
+		BufferedAppendNextBufferPosition(&(storageWrite->bufferedAppend));
+
+	header = BufferedAppendGetBuffer(&storageWrite->bufferedAppend, bufferLen);
+
+	data = &header[completeHeaderLen];
+	memcpy(data, content, storedLen);
+	AOStorage_ZeroPad(data, storedLen, dataRoundedUpLen);
+
+	/*
+	 * Make the header and compute the checksum if necessary.
+	 */
+	AppendOnlyStorageFormat_MakeSmallContentHeader
+		(header,
+		 storageWrite->storageAttributes.checksum,
+		 storageWrite->isFirstRowNumSet,
+		 storageWrite->formatVersion,
+		 storageWrite->firstRowNum,
+		 current->executorBlockKind,
+		 current->rowCount,
+		 current->uncompressedLen,
+		 (current->isCompressed ? current->compressedLen : 0));
+
+	if (Debug_appendonly_print_storage_headers)
+	{
+		AppendOnlyStorageWrite_LogBlockHeader(storageWrite,
+											  headerOffsetInFile,
+											  header);
+	}
+
+	BufferedAppendFinishBuffer(&storageWrite->bufferedAppend,
+							   bufferLen,
+							   completeHeaderLen +
+							   AOStorage_RoundUp(current->uncompressedLen, storageWrite->formatVersion) /* non-compressed size */ );
+
+	elogif(Debug_appendonly_print_insert, LOG,
+		   "Append-only insert copied block for table '%s' "
+		   "(segment file '%s', header offset in file " INT64_FORMAT ", "
+		   "length = %d, compressed length %d, item count %d)",
+		   storageWrite->relationName,
+		   storageWrite->segmentFileName,
+		   headerOffsetInFile,
+		   current->uncompressedLen,
+		   (current->isCompressed ? current->compressedLen : 0),
+		   current->rowCount);
+
+	storageWrite->isFirstRowNumSet = false;
+
+	return true;
+}
+
 /*
  * Set the first row value for the next Append-Only Storage Block to be
  * written.  Only applies to the next block.
@@ -13,6 +13,7 @@
 #include "postgres.h"
 
 #include "regex/regex.h"
+#include "access/heapam.h"
 #include "libpq/libpq-be.h"
 #include "fmgr.h"
 #include "funcapi.h"
@@ -23,6 +24,7 @@
 #include "cdb/cdbtimer.h"
 #include "miscadmin.h"
 #include "postmaster/postmaster.h"
+#include "storage/bufmgr.h"
 #include "utils/guc.h"
 
 #define DUMP_PREFIX (dump_prefix==NULL?"":dump_prefix)
@@ -1320,6 +1322,71 @@ gp_write_backup_file__(PG_FUNCTION_ARGS)
 	return CStringGetTextDatum(pszFileName);
 }
 
+/*
+ * gp_relation_max_lsn( REGCLASS ) returns TEXT
+ *
+ * Returns the highest page LSN of a heap relation on this segment, as
+ * 'X/X', or NULL if the relation is not heap storage or has been dropped.
+ * Every WAL-logged change to a page advances its LSN, so if neither this
+ * nor the relfilenode moved since the last backup, the table's data on
+ * this segment did not change either.  Incremental gpcrondump runs this
+ * on all segments at once, through gp_dist_random('pg_class'), to skip
+ * heap tables that have not changed, as it already does for append-only
+ * tables by their modcount.
+ *
+ * This reads every block of the relation, through a bulk-read ring so as
+ * not to flush the buffer cache, but produces no output.  It is still much
+ * cheaper than dumping the table.
+ */
+Datum
+gp_relation_max_lsn(PG_FUNCTION_ARGS)
+{
+	Oid			relid = PG_GETARG_OID(0);
+	Relation	rel;
+	BufferAccessStrategy strategy;
+	BlockNumber nblocks;
+	BlockNumber blkno;
+	XLogRecPtr	maxlsn = {0, 0};
+	char		buf[32];
+
+	rel = try_relation_open(relid, AccessShareLock, false);
+
+	/* dropped concurrently, as for pg_relation_size() */
+	if (!RelationIsValid(rel))
+		PG_RETURN_NULL();
+
+	if (!RelationIsHeap(rel) || rel->rd_node.relNode == 0)
+	{
+		relation_close(rel, AccessShareLock);
+		PG_RETURN_NULL();
+	}
+
+	strategy = GetAccessStrategy(BAS_BULKREAD);
+	nblocks = RelationGetNumberOfBlocks(rel);
+
+	for (blkno = 0; blkno < nblocks; blkno++)
+	{
+		Buffer		buffer;
+		XLogRecPtr	lsn;
+
+		CHECK_FOR_INTERRUPTS();
+
+		buffer = ReadBufferWithStrategy(rel, blkno, strategy);
+		LockBuffer(buffer, BUFFER_LOCK_SHARE);
+		lsn = PageGetLSN(BufferGetPage(buffer));
+		UnlockReleaseBuffer(buffer);
+
+		if (XLByteLT(maxlsn, lsn))
+			maxlsn = lsn;
+	}
+
+	FreeAccessStrategy(strategy);
+	relation_close(rel, AccessShareLock);
+
+	snprintf(buf, sizeof(buf), "%X/%X", maxlsn.xlogid, maxlsn.xrecoff);
+	PG_RETURN_TEXT_P(cstring_to_text(buf));
+}
+
 /*
  * createBackupDirectory( char* pszPathName ) return bool
  *
@@ -0,0 +1,1022 @@
+/*-------------------------------------------------------------------------
+ *
+ * cdbbench.c
+ *	  Micro-benchmarks of the database's own code paths.
+ *
+ * gpcheckperf measures what the hardware can do, with dd, stream and
+ * netperf. The functions here measure what the database gets out of it:
+ * each one times one of the kernels that queries spend their time in, on
+ * the segment it runs on, and returns the throughput.
+ *
+ *	gp_bench_compress	 AO block compression and decompression, per codec
+ *	gp_bench_workfile	 writing and reading back a spill file
+ *	gp_bench_hash		 hashing values to segments, as a Motion does
+ *	gp_bench_sort		 sorting int8 values in memory
+ *	gp_bench_interconnect	 moving rows between segments through Motions
+ *	gp_bench_operators	 the per-row kernels of the executor's operators
+ *
+ * All but gp_bench_interconnect can run on every segment at once, which
+ * makes a slow host stand out:
+ *
+ *	  SELECT gp_segment_id, (gp_bench_compress('zlib', 1, 256)).*
+ *	  FROM gp_dist_random('gp_id');
+ *
+ * Store the results in a table to compare them across upgrades.
+ *
+ * Portions Copyright (c) 2012-Present Pivotal Software, Inc.
+ *
+ *
+ * IDENTIFICATION
+ *	    src/backend/cdb/cdbbench.c
+ *
+ *-------------------------------------------------------------------------
+ */
+#include "postgres.h"
+
+#include "access/heapam.h"
+#include "catalog/pg_compression.h"
+#include "catalog/pg_operator.h"
+#include "catalog/pg_type.h"
+#include "cdb/cdbhash.h"
+#include "cdb/cdbvars.h"
+#include "cdb/tupser.h"
+#include "executor/executor.h"
+#include "executor/spi.h"
+#include "funcapi.h"
+#include "miscadmin.h"
+#include "portability/instr_time.h"
+#include "storage/buffile.h"
+#include "utils/builtins.h"
+#include "utils/memutils.h"
+#include "utils/tuplesort.h"
+
+/* AO tables are written in blocks of this size by default */
+#define BENCH_BLOCK_SIZE	(32 * 1024)
+
+/* how many different blocks of sample data to cycle through */
+#define BENCH_SAMPLE_BLOCKS 64
+
+/* values hashed per call of the batch hash functions */
+#define BENCH_HASH_BATCH	1024
+
+/* width of the rows sent through the interconnect */
+#define BENCH_ROW_WIDTH		1024
+
+/* gather queries run to measure the interconnect's latency */
+#define BENCH_LATENCY_RUNS	10
+
+/* rows generated at a time for gp_bench_operators() */
+#define BENCH_ROW_BATCH		1024
+
+/* The kernels timed by gp_bench_operators(), in the order they are returned */
+typedef enum BenchKernel
+{
+	BENCH_KERNEL_CDBHASH = 0,
+	BENCH_KERNEL_HASH_BUILD,
+	BENCH_KERNEL_HASH_PROBE,
+	BENCH_KERNEL_SORT,
+	BENCH_KERNEL_SERIALIZE,
+	BENCH_KERNEL_DESERIALIZE,
+	BENCH_KERNEL_COMPRESS,
+	BENCH_KERNEL_DECOMPRESS
+} BenchKernel;
+
+#define NUM_BENCH_KERNELS (BENCH_KERNEL_DECOMPRESS + 1)
+
+static const char *const bench_kernel_names[NUM_BENCH_KERNELS] = {
+	"cdbhash", "hash_build", "hash_probe", "sort",
+	"serialize", "deserialize", "compress", "decompress"
+};
+
+/*
+ * Synthetic rows of (k int8, pad text), generated a batch at a time so that
+ * the number of rows isn't limited by memory. k takes ndistinct different
+ * values and pad is a slice of the sample data that makes the row about
+ * width bytes wide. Rewinding replays the same rows.
+ */
+typedef struct BenchRows
+{
+	TupleDesc	tupdesc;
+	int64		ntuples;
+	int32		ndistinct;
+	int			padlen;
+	char	   *sample;
+	uint32		seed;
+	int64		done;
+	MemoryContext batchcxt;		/* holds the current batch */
+	HeapTuple	batch[BENCH_ROW_BATCH];
+	int			nbatch;
+} BenchRows;
+
+static void check_bench_privilege(void);
+static char *make_sample_data(int nblocks);
+static double elapsed_seconds(instr_time start);
+static double mbytes_per_second(int64 bytes, double seconds);
+static Datum make_result(FunctionCallInfo fcinfo, Datum *values, int nvalues);
+static void bench_rows_rewind(BenchRows *rows);
+static bool bench_rows_next_batch(BenchRows *rows);
+static void bench_cdbhash(BenchRows *rows, instr_time *elapsed);
+static void bench_hash_table(BenchRows *rows, instr_time *build, instr_time *probe);
+static void bench_sort(BenchRows *rows, instr_time *elapsed);
+static void bench_serialize(BenchRows *rows, instr_time *ser, instr_time *deser);
+static void bench_block_compress(BenchRows *rows, instr_time *comp, instr_time *decomp);
+
+/*
+ * The benchmarks can keep a segment busy for as long as the caller asks,
+ * so like gpcheckperf they are for administrators only.
+ */
+static void
+check_bench_privilege(void)
+{
+	if (!superuser())
+		ereport(ERROR,
+				(errcode(ERRCODE_INSUFFICIENT_PRIVILEGE),
+				 errmsg("must be superuser to run benchmarks")));
+}
+
+/*
+ * Fill nblocks blocks with something that looks like the text of a fact
+ * table: rows of numbers and repeated words, which compress about as well
+ * as real data does. A fixed generator makes every segment compress the
+ * same bytes.
+ */
+static char *
+make_sample_data(int nblocks)
+{
+	static const char *const words[] = {
+		"FURNITURE", "BUILDING", "AUTOMOBILE", "MACHINERY", "HOUSEHOLD",
+		"DELIVER IN PERSON", "COLLECT COD", "TAKE BACK RETURN", "NONE"
+	};
+	Size		len = (Size) nblocks * BENCH_BLOCK_SIZE;
+	char	   *data = palloc(len + 128);
+	Size		off = 0;
+	uint32		seed = 12345;
+
+	while (off < len)
+	{
+		uint32		r1,
+					r2;
+
+		seed = seed * 1103515245 + 12345;
+		r1 = seed >> 8;
+		seed = seed * 1103515245 + 12345;
+		r2 = seed >> 8;
+
+		off += snprintf(data + off, 128, "%u|%u|%u.%02u|%s|1995-%02u-%02u\n",
+						r1 % 6000000, r2 % 200000, r1 % 100000, r2 % 100,
+						words[r2 % lengthof(words)],
+						1 + r1 % 12, 1 + r2 % 28);
+	}
+
+	return data;
+}
+
+static double
+elapsed_seconds(instr_time start)
+{
+	instr_time	now;
+
+	INSTR_TIME_SET_CURRENT(now);
+	INSTR_TIME_SUBTRACT(now, start);
+
+	/* guard against a clock too coarse for a very short run */
+	return Max(INSTR_TIME_GET_DOUBLE(now), 1e-6);
+}
+
+static double
+mbytes_per_second(int64 bytes, double seconds)
+{
+	return (double) bytes / (1024.0 * 1024.0) / seconds;
+}
+
+static Datum
+make_result(FunctionCallInfo fcinfo, Datum *values, int nvalues)
+{
+	TupleDesc	tupdesc;
+	bool	   *nulls;
+
+	if (get_call_result_type(fcinfo, NULL, &tupdesc) != TYPEFUNC_COMPOSITE)
+		elog(ERROR, "return type must be a row type");
+	Assert(tupdesc->natts == nvalues);
+
+	nulls = palloc0(nvalues * sizeof(bool));
+
+	return HeapTupleGetDatum(heap_form_tuple(BlessTupleDesc(tupdesc),
+											 values, nulls));
+}
+
+/*
+ * gp_bench_compress(compresstype, compresslevel, mbytes)
+ *
+ * Compress mbytes of sample data in AO-sized blocks with the given codec,
+ * then decompress it again. Returns the throughput of both directions, in
+ * MB of uncompressed data per second, and the compression ratio.
+ */
+Datum
+gp_bench_compress(PG_FUNCTION_ARGS)
+{
+	char	   *comptype = text_to_cstring(PG_GETARG_TEXT_P(0));
+	int32		complevel = PG_GETARG_INT32(1);
+	int32		mbytes = PG_GETARG_INT32(2);
+	PGFunction *funcs;
+	StorageAttributes sa;
+	CompressionState *compressState;
+	CompressionState *decompressState;
+	char	   *sample;
+	char	   *compressed;
+	char	   *uncompressed;
+	int32	   *compressedLen;
+	int			compressedMax;
+	int			nblocks;
+	int			i;
+	int64		totalCompressed = 0;
+	instr_time	start;
+	double		compressSecs;
+	double		decompressSecs;
+	Datum		values[3];
+
+	check_bench_privilege();
+
+	if (mbytes <= 0)
+		ereport(ERROR,
+				(errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+				 errmsg("amount of data to compress must be positive")));
+
+	if (!compresstype_is_valid(comptype))
+		ereport(ERROR,
+				(errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+				 errmsg("unknown compresstype \"%s\"", comptype)));
+	if (pg_strcasecmp(comptype, "rle_type") == 0)
+		ereport(ERROR,
+				(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+				 errmsg("compresstype \"%s\" only applies to column data", comptype)));
+
+	funcs = GetCompressionImplementation(comptype);
+	callCompressionValidator(funcs[COMPRESSION_VALIDATOR], comptype, complevel,
+							 BENCH_BLOCK_SIZE, InvalidOid);
+
+	sa.comptype = comptype;
+	sa.complevel = complevel;
+	sa.blocksize = BENCH_BLOCK_SIZE;
+	sa.typid = InvalidOid;
+	compressState = callCompressionConstructor(funcs[COMPRESSION_CONSTRUCTOR],
+											   NULL, &sa, true);
+	decompressState = callCompressionConstructor(funcs[COMPRESSION_CONSTRUCTOR],
+												 NULL, &sa, false);
+
+	/* room for data that doesn't compress, as the AO writer allows */
+	compressedMax = compressState->desired_sz ?
+		(int) compressState->desired_sz(BENCH_BLOCK_SIZE) :
+		BENCH_BLOCK_SIZE * 2;
+
+	sample = make_sample_data(BENCH_SAMPLE_BLOCKS);
+	compressed = palloc((Size) BENCH_SAMPLE_BLOCKS * compressedMax);
+	compressedLen = palloc(BENCH_SAMPLE_BLOCKS * sizeof(int32));
+	uncompressed = palloc(BENCH_BLOCK_SIZE);
+	nblocks = (int) (((int64) mbytes * 1024 * 1024) / BENCH_BLOCK_SIZE);
+
+	INSTR_TIME_SET_CURRENT(start);
+	for (i = 0; i < nblocks; i++)
+	{
+		int			b = i % BENCH_SAMPLE_BLOCKS;
+
+		callCompressionActuator(funcs[COMPRESSION_COMPRESS],
+								sample + (Size) b * BENCH_BLOCK_SIZE,
+								BENCH_BLOCK_SIZE,
+								compressed + (Size) b * compressedMax,
+								compressedMax, &compressedLen[b],
+								compressState);
+		totalCompressed += compressedLen[b];
+
+		CHECK_FOR_INTERRUPTS();
+	}
+	compressSecs = elapsed_seconds(start);
+
+	INSTR_TIME_SET_CURRENT(start);
+	for (i = 0; i < nblocks; i++)
+	{
+		int			b = i % BENCH_SAMPLE_BLOCKS;
+		int32		len;
+
+		callCompressionActuator(funcs[COMPRESSION_DECOMPRESS],
+								compressed + (Size) b * compressedMax,
+								compressedLen[b],
+								uncompressed, BENCH_BLOCK_SIZE, &len,
+								decompressState);
+		if (len != BENCH_BLOCK_SIZE)
+			elog(ERROR, "decompressed block is %d bytes, expected %d",
+				 len, BENCH_BLOCK_SIZE);
+
+		CHECK_FOR_INTERRUPTS();
+	}
+	decompressSecs = elapsed_seconds(start);
+
+	callCompressionDestructor(funcs[COMPRESSION_DESTRUCTOR], compressState);
+	callCompressionDestructor(funcs[COMPRESSION_DESTRUCTOR], decompressState);
+
+	values[0] = Float8GetDatum(mbytes_per_second((int64) nblocks * BENCH_BLOCK_SIZE,
+												 compressSecs));
+	values[1] = Float8GetDatum(mbytes_per_second((int64) nblocks * BENCH_BLOCK_SIZE,
+												 decompressSecs));
+	values[2] = Float8GetDatum(totalCompressed > 0 ?
+							   (double) nblocks * BENCH_BLOCK_SIZE / totalCompressed :
+							   0.0);
+
+	PG_RETURN_DATUM(make_result(fcinfo, values, 3));
+}
+
+/*
+ * gp_bench_workfile(mbytes)
+ *
+ * Write mbytes to a temporary file the way executor nodes spill, then read
+ * it back. The file is usually still in the OS cache when it is read, as it
+ * would be for a spill that fits in memory.
+ */
+Datum
+gp_bench_workfile(PG_FUNCTION_ARGS)
+{
+	int32		mbytes = PG_GETARG_INT32(0);
+	BufFile    *file;
+	char	   *sample;
+	int			nblocks;
+	int			i;
+	instr_time	start;
+	double		writeSecs;
+	double		readSecs;
+	Datum		values[2];
+
+	check_bench_privilege();
+
+	if (mbytes <= 0)
+		ereport(ERROR,
+				(errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+				 errmsg("amount of data to write must be positive")));
+
+	sample = make_sample_data(BENCH_SAMPLE_BLOCKS);
+	nblocks = (int) (((int64) mbytes * 1024 * 1024) / BENCH_BLOCK_SIZE);
+
+	file = BufFileCreateTemp("gp_bench_workfile", false);
+
+	INSTR_TIME_SET_CURRENT(start);
+	for (i = 0; i < nblocks; i++)
+	{
+		char	   *block = sample + (Size) (i % BENCH_SAMPLE_BLOCKS) * BENCH_BLOCK_SIZE;
+
+		if (BufFileWrite(file, block, BENCH_BLOCK_SIZE) != BENCH_BLOCK_SIZE)
+			ereport(ERROR,
+					(errcode_for_file_access(),
+					 errmsg("could not write to temporary file: %m")));
+
+		CHECK_FOR_INTERRUPTS();
+	}
+	BufFileFlush(file);
+	writeSecs = elapsed_seconds(start);
+
+	if (BufFileSeek(file, 0, 0, SEEK_SET) != 0)
+		ereport(ERROR,
+				(errcode_for_file_access(),
+				 errmsg("could not rewind temporary file: %m")));
+
+	INSTR_TIME_SET_CURRENT(start);
+	for (i = 0; i < nblocks; i++)
+	{
+		if (BufFileRead(file, sample, BENCH_BLOCK_SIZE) != BENCH_BLOCK_SIZE)
+			ereport(ERROR,
+					(errcode_for_file_access(),
+					 errmsg("could not read from temporary file: %m")));
+
+		CHECK_FOR_INTERRUPTS();
+	}
+	readSecs = elapsed_seconds(start);
+
+	BufFileClose(file);
+
+	values[0] = Float8GetDatum(mbytes_per_second((int64) nblocks * BENCH_BLOCK_SIZE,
+												 writeSecs));
+	values[1] = Float8GetDatum(mbytes_per_second((int64) nblocks * BENCH_BLOCK_SIZE,
+												 readSecs));
+
+	PG_RETURN_DATUM(make_result(fcinfo, values, 2));
+}
+
+/*
+ * gp_bench_hash(nvalues)
+ *
+ * Hash nvalues int8 values and reduce them to a segment number, as a
+ * Redistribute Motion does for every row it sends. Returns millions of
+ * values per second.
+ */
+Datum
+gp_bench_hash(PG_FUNCTION_ARGS)
+{
+	int32		nvalues = PG_GETARG_INT32(0);
+	CdbHash    *h;
+	uint32		hashes[BENCH_HASH_BATCH];
+	Datum		values[BENCH_HASH_BATCH];
+	bool		isnull[BENCH_HASH_BATCH];
+	unsigned int segs[BENCH_HASH_BATCH];
+	int64		done = 0;
+	instr_time	start;
+
+	check_bench_privilege();
+
+	if (nvalues <= 0)
+		ereport(ERROR,
+				(errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+				 errmsg("number of values to hash must be positive")));
+
+	h = makeCdbHash(Max(GpIdentity.numsegments, 1));
+	memset(isnull, 0, sizeof(isnull));
+
+	INSTR_TIME_SET_CURRENT(start);
+	while (done < nvalues)
+	{
+		int			n = (int) Min(nvalues - done, BENCH_HASH_BATCH);
+		int			i;
+
+		for (i = 0; i < n; i++)
+			values[i] = Int64GetDatum(done + i);
+
+		cdbhashinit_batch(hashes, n);
+		cdbhash_batch(hashes, n, values, isnull, INT8OID);
+		cdbhashreduce_batch(h, hashes, n, segs);
+		done += n;
+
+		CHECK_FOR_INTERRUPTS();
+	}
+
+	PG_RETURN_FLOAT8((double) nvalues / 1e6 / elapsed_seconds(start));
+}
+
+/*
+ * gp_bench_sort(nvalues)
+ *
+ * Sort nvalues pseudo-random int8 values with the executor's sort, which
+ * spills once they no longer fit in work_mem. Returns millions of values
+ * per second.
+ */
+Datum
+gp_bench_sort(PG_FUNCTION_ARGS)
+{
+	int32		nvalues = PG_GETARG_INT32(0);
+	Tuplesortstate *sortstate;
+	uint32		seed = 12345;
+	Datum		val;
+	bool		isnull;
+	int32		i;
+	instr_time	start;
+
+	check_bench_privilege();
+
+	if (nvalues <= 0)
+		ereport(ERROR,
+				(errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+				 errmsg("number of values to sort must be positive")));
+
+	INSTR_TIME_SET_CURRENT(start);
+
+	sortstate = tuplesort_begin_datum(NULL, INT8OID, Int8LessOperator, false,
+									  work_mem, false);
+	for (i = 0; i < nvalues; i++)
+	{
+		seed = seed * 1103515245 + 12345;
+		tuplesort_putdatum(sortstate, Int64GetDatum((int64) seed), false);
+
+		CHECK_FOR_INTERRUPTS();
+	}
+	tuplesort_performsort(sortstate);
+	while (tuplesort_getdatum(sortstate, true, &val, &isnull))
+		CHECK_FOR_INTERRUPTS();
+	tuplesort_end(sortstate);
+
+	PG_RETURN_FLOAT8((double) nvalues / 1e6 / elapsed_seconds(start));
+}
+
+/*
+ * gp_bench_interconnect(mbytes)
+ *
+ * Every segment generates mbytes of 1 kB rows and sends them to the other
+ * segments through a Redistribute Motion, over whichever interconnect is
+ * configured. Returns the aggregate throughput, which also includes the
+ * cost of generating the rows and of the HashAgg that receives them, so it
+ * is a lower bound; and the average time of a query that does nothing but
+ * gather one row from every segment.
+ */
+Datum
+gp_bench_interconnect(PG_FUNCTION_ARGS)
+{
+	int32		mbytes = PG_GETARG_INT32(0);
+	int			nsegs;
+	int			rows;
+	int			i;
+	StringInfoData sql;
+	instr_time	start;
+	double		transferSecs;
+	double		latencySecs;
+	Datum		values[2];
+
+	check_bench_privilege();
+
+	if (Gp_role != GP_ROLE_DISPATCH)
+		ereport(ERROR,
+				(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+				 errmsg("the interconnect can only be benchmarked from the master")));
+
+	if (mbytes <= 0)
+		ereport(ERROR,
+				(errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+				 errmsg("amount of data to send must be positive")));
+
+	nsegs = getgpsegmentCount();
+	rows = (int) (((int64) mbytes * 1024 * 1024) / BENCH_ROW_WIDTH);
+
+	/*
+	 * The segment id makes every row distinct, so the first phase of the
+	 * DISTINCT removes nothing and every row crosses the Motion.
+	 */
+	initStringInfo(&sql);
+	appendStringInfo(&sql,
+					 "SELECT count(*) FROM (SELECT DISTINCT g, pad FROM "
+					 "(SELECT g, repeat('x', %d) || gp_segment_id AS pad "
+					 "FROM gp_dist_random('gp_id'), generate_series(1, %d) g) s) d",
+					 BENCH_ROW_WIDTH - 8, rows);
+
+	if (SPI_connect() != SPI_OK_CONNECT)
+		elog(ERROR, "SPI_connect failed");
+
+	INSTR_TIME_SET_CURRENT(start);
+	if (SPI_execute(sql.data, true, 0) != SPI_OK_SELECT)
+		elog(ERROR, "could not run interconnect benchmark query");
+	transferSecs = elapsed_seconds(start);
+
+	INSTR_TIME_SET_CURRENT(start);
+	for (i = 0; i < BENCH_LATENCY_RUNS; i++)
+	{
+		if (SPI_execute("SELECT count(*) FROM gp_dist_random('gp_id')", true, 0) != SPI_OK_SELECT)
+			elog(ERROR, "could not run interconnect latency query");
+	}
+	latencySecs = elapsed_seconds(start) / BENCH_LATENCY_RUNS;
+
+	SPI_finish();
+
+	values[0] = Float8GetDatum(mbytes_per_second((int64) nsegs * rows * BENCH_ROW_WIDTH,
+												 transferSecs));
+	values[1] = Float8GetDatum(latencySecs * 1000.0);
+
+	PG_RETURN_DATUM(make_result(fcinfo, values, 2));
+}
+
+static void
+bench_rows_rewind(BenchRows *rows)
+{
+	rows->seed = 12345;
+	rows->done = 0;
+	rows->nbatch = 0;
+}
+
+/*
+ * Replace the current batch with the next one. Returns false when all the
+ * rows have been generated.
+ */
+static bool
+bench_rows_next_batch(BenchRows *rows)
+{
+	MemoryContext oldcontext;
+	Datum		values[2];
+	bool		isnull[2] = {false, false};
+	int			i;
+
+	MemoryContextReset(rows->batchcxt);
+	rows->nbatch = 0;
+
+	if (rows->done >= rows->ntuples)
+		return false;
+
+	oldcontext = MemoryContextSwitchTo(rows->batchcxt);
+
+	rows->nbatch = (int) Min(rows->ntuples - rows->done, BENCH_ROW_BATCH);
+	for (i = 0; i < rows->nbatch; i++)
+	{
+		rows->seed = rows->seed * 1103515245 + 12345;
+		values[0] = Int64GetDatum((int64) ((rows->seed >> 8) % rows->ndistinct));
+		rows->seed = rows->seed * 1103515245 + 12345;
+		values[1] = PointerGetDatum(cstring_to_text_with_len(
+							rows->sample + (rows->seed >> 8) % (BENCH_BLOCK_SIZE - rows->padlen),
+							rows->padlen));
+
+		rows->batch[i] = heap_form_tuple(rows->tupdesc, values, isnull);
+	}
+	rows->done += rows->nbatch;
+
+	MemoryContextSwitchTo(oldcontext);
+
+	return true;
+}
+
+/* Hash the key of every row to a segment, as a Redistribute Motion does */
+static void
+bench_cdbhash(BenchRows *rows, instr_time *elapsed)
+{
+	CdbHash    *h = makeCdbHash(Max(GpIdentity.numsegments, 1));
+	TupleTableSlot *slot = MakeSingleTupleTableSlot(rows->tupdesc);
+	instr_time	start,
+				end;
+
+	bench_rows_rewind(rows);
+	while (bench_rows_next_batch(rows))
+	{
+		int			i;
+
+		INSTR_TIME_SET_CURRENT(start);
+		for (i = 0; i < rows->nbatch; i++)
+		{
+			bool		isnull;
+			Datum		k;
+
+			ExecStoreHeapTuple(rows->batch[i], slot, InvalidBuffer, false);
+			k = slot_getattr(slot, 1, &isnull);
+
+			cdbhashinit(h);
+			cdbhash(h, k, INT8OID);
+			(void) cdbhashreduce(h);
+		}
+		INSTR_TIME_SET_CURRENT(end);
+		INSTR_TIME_ACCUM_DIFF(*elapsed, end, start);
+
+		CHECK_FOR_INTERRUPTS();
+	}
+
+	ExecDropSingleTupleTableSlot(slot);
+}
+
+/*
+ * Insert every row's key into a tuple hash table, then look every row up
+ * again. ExecHashTableInsert() and the HashAgg lookup can only be driven
+ * through a Hash or Agg node initialized from a plan, so this uses the
+ * executor's generic tuple hash table, which hashes, chases buckets and
+ * compares keys the same way.
+ */
+static void
+bench_hash_table(BenchRows *rows, instr_time *build, instr_time *probe)
+{
+	MemoryContext tablecxt;
+	TupleHashTable hashtable;
+	TupleTableSlot *slot = MakeSingleTupleTableSlot(rows->tupdesc);
+	AttrNumber	keyColIdx[1] = {1};
+	Oid			eqOperators[1] = {Int8EqualOperator};
+	FmgrInfo   *eqfunctions;
+	FmgrInfo   *hashfunctions;
+	instr_time	start,
+				end;
+
+	tablecxt = AllocSetContextCreate(CurrentMemoryContext,
+									 "gp_bench_operators hash table",
+									 ALLOCSET_DEFAULT_MINSIZE,
+									 ALLOCSET_DEFAULT_INITSIZE,
+									 ALLOCSET_DEFAULT_MAXSIZE);
+
+	execTuplesHashPrepare(1, eqOperators, &eqfunctions, &hashfunctions);
+	hashtable = BuildTupleHashTable(1, keyColIdx, eqfunctions, hashfunctions,
+									Min(rows->ndistinct, rows->ntuples),
+									sizeof(TupleHashEntryData),
+									tablecxt, rows->batchcxt);
+
+	bench_rows_rewind(rows);
+	while (bench_rows_next_batch(rows))
+	{
+		int			i;
+		bool		isnew;
+
+		INSTR_TIME_SET_CURRENT(start);
+		for (i = 0; i < rows->nbatch; i++)
+		{
+			ExecStoreHeapTuple(rows->batch[i], slot, InvalidBuffer, false);
+			(void) LookupTupleHashEntry(hashtable, slot, &isnew);
+		}
+		INSTR_TIME_SET_CURRENT(end);
+		INSTR_TIME_ACCUM_DIFF(*build, end, start);
+
+		CHECK_FOR_INTERRUPTS();
+	}
+
+	/* the same rows again, so that every probe finds its match */
+	bench_rows_rewind(rows);
+	while (bench_rows_next_batch(rows))
+	{
+		int			i;
+
+		INSTR_TIME_SET_CURRENT(start);
+		for (i = 0; i < rows->nbatch; i++)
+		{
+			ExecStoreHeapTuple(rows->batch[i], slot, InvalidBuffer, false);
+			if (FindTupleHashEntry(hashtable, slot, eqfunctions, hashfunctions) == NULL)
+				elog(ERROR, "benchmark row not found in hash table");
+		}
+		INSTR_TIME_SET_CURRENT(end);
+		INSTR_TIME_ACCUM_DIFF(*probe, end, start);
+
+		CHECK_FOR_INTERRUPTS();
+	}
+
+	ExecDropSingleTupleTableSlot(slot);
+	MemoryContextDelete(tablecxt);
+}
+
+/*
+ * Sort the rows on k with the executor's sort, which is the MK sort unless
+ * gp_enable_mk_sort is off, and read them back. The sort spills once the
+ * rows no longer fit in work_mem.
+ */
+static void
+bench_sort(BenchRows *rows, instr_time *elapsed)
+{
+	Tuplesortstate *sortstate;
+	TupleTableSlot *slot = MakeSingleTupleTableSlot(rows->tupdesc);
+	AttrNumber	attNums[1] = {1};
+	Oid			sortOperators[1] = {Int8LessOperator};
+	bool		nullsFirst[1] = {false};
+	instr_time	start,
+				end;
+
+	sortstate = tuplesort_begin_heap(NULL, rows->tupdesc, 1, attNums,
+									 sortOperators, nullsFirst,
+									 work_mem, false);
+
+	bench_rows_rewind(rows);
+	while (bench_rows_next_batch(rows))
+	{
+		int			i;
+
+		INSTR_TIME_SET_CURRENT(start);
+		for (i = 0; i < rows->nbatch; i++)
+		{
+			ExecStoreHeapTuple(rows->batch[i], slot, InvalidBuffer, false);
+			tuplesort_puttupleslot(sortstate, slot);
+		}
+		INSTR_TIME_SET_CURRENT(end);
+		INSTR_TIME_ACCUM_DIFF(*elapsed, end, start);
+
+		CHECK_FOR_INTERRUPTS();
+	}
+
+	INSTR_TIME_SET_CURRENT(start);
+	tuplesort_performsort(sortstate);
+	while (tuplesort_gettupleslot(sortstate, true, slot))
+		CHECK_FOR_INTERRUPTS();
+	tuplesort_end(sortstate);
+	INSTR_TIME_SET_CURRENT(end);
+	INSTR_TIME_ACCUM_DIFF(*elapsed, end, start);
+
+	ExecDropSingleTupleTableSlot(slot);
+}
+
+/*
+ * Break every row into tuple chunks, as a sending Motion does, then put the
+ * chunks back together into a tuple, as the receiving Motion does.
+ */
+static void
+bench_serialize(BenchRows *rows, instr_time *ser, instr_time *deser)
+{
+	SerTupInfo	serInfo;
+	TupleChunkListData *tcLists;
+	instr_time	start,
+				end;
+
+	InitSerTupInfo(rows->tupdesc, &serInfo);
+	tcLists = palloc(BENCH_ROW_BATCH * sizeof(TupleChunkListData));
+
+	bench_rows_rewind(rows);
+	while (bench_rows_next_batch(rows))
+	{
+		MemoryContext oldcontext = MemoryContextSwitchTo(rows->batchcxt);
+		int			i;
+
+		INSTR_TIME_SET_CURRENT(start);
+		for (i = 0; i < rows->nbatch; i++)
+			SerializeTupleIntoChunks(rows->batch[i], &serInfo, &tcLists[i]);
+		INSTR_TIME_SET_CURRENT(end);
+		INSTR_TIME_ACCUM_DIFF(*ser, end, start);
+
+		INSTR_TIME_SET_CURRENT(start);
+		for (i = 0; i < rows->nbatch; i++)
+			(void) CvtChunksToHeapTup(&tcLists[i], &serInfo, NULL);
+		INSTR_TIME_SET_CURRENT(end);
+		INSTR_TIME_ACCUM_DIFF(*deser, end, start);
+
+		MemoryContextSwitchTo(oldcontext);
+
+		CHECK_FOR_INTERRUPTS();
+	}
+
+	pfree(tcLists);
+	CleanupSerTupInfo(&serInfo);
+}
+
+/*
+ * Pack the rows into AO-sized blocks and compress each block with zlib at
+ * level 1, the defaults of an AO table, then decompress it again.
+ */
+static void
+bench_block_compress(BenchRows *rows, instr_time *comp, instr_time *decomp)
+{
+	PGFunction *funcs = GetCompressionImplementation("zlib");
+	StorageAttributes sa;
+	CompressionState *compressState;
+	CompressionState *decompressState;
+	char	   *block;
+	char	   *compressed;
+	char	   *uncompressed;
+	int			compressedMax;
+	int			used = 0;
+	instr_time	start,
+				end;
+
+	sa.comptype = "zlib";
+	sa.complevel = 1;
+	sa.blocksize = BENCH_BLOCK_SIZE;
+	sa.typid = InvalidOid;
+	compressState = callCompressionConstructor(funcs[COMPRESSION_CONSTRUCTOR],
+											   NULL, &sa, true);
+	decompressState = callCompressionConstructor(funcs[COMPRESSION_CONSTRUCTOR],
+												 NULL, &sa, false);
+	compressedMax = compressState->desired_sz ?
+		(int) compressState->desired_sz(BENCH_BLOCK_SIZE) :
+		BENCH_BLOCK_SIZE * 2;
+
+	block = palloc(BENCH_BLOCK_SIZE);
+	compressed = palloc(compressedMax);
+	uncompressed = palloc(BENCH_BLOCK_SIZE);
+
+	bench_rows_rewind(rows);
+	for (;;)
+	{
+		bool		more = bench_rows_next_batch(rows);
+		int			i = 0;
+
+		/* fill blocks with rows, flushing each when full and at the end */
+		while (i < rows->nbatch || (!more && used > 0))
+		{
+			if (i < rows->nbatch &&
+				used + (int) rows->batch[i]->t_len <= BENCH_BLOCK_SIZE)
+			{
+				memcpy(block + used, rows->batch[i]->t_data, rows->batch[i]->t_len);
+				used += rows->batch[i]->t_len;
+				i++;
+				continue;
+			}
+			else
+			{
+				int32		compressedLen;
+				int32		len;
+
+				INSTR_TIME_SET_CURRENT(start);
+				callCompressionActuator(funcs[COMPRESSION_COMPRESS],
+										block, used,
+										compressed, compressedMax, &compressedLen,
+										compressState);
+				INSTR_TIME_SET_CURRENT(end);
+				INSTR_TIME_ACCUM_DIFF(*comp, end, start);
+
+				INSTR_TIME_SET_CURRENT(start);
+				callCompressionActuator(funcs[COMPRESSION_DECOMPRESS],
+										compressed, compressedLen,
+										uncompressed, BENCH_BLOCK_SIZE, &len,
+										decompressState);
+				INSTR_TIME_SET_CURRENT(end);
+				INSTR_TIME_ACCUM_DIFF(*decomp, end, start);
+
+				if (len != used)
+					elog(ERROR, "decompressed block is %d bytes, expected %d",
+						 len, used);
+				used = 0;
+			}
+		}
+
+		CHECK_FOR_INTERRUPTS();
+
+		if (!more)
+			break;
+	}
+
+	callCompressionDestructor(funcs[COMPRESSION_DESTRUCTOR], compressState);
+	callCompressionDestructor(funcs[COMPRESSION_DESTRUCTOR], decompressState);
+}
+
+/*
+ * gp_bench_operators(ntuples, width, ndistinct)
+ *
+ * Run ntuples synthetic rows, about width bytes wide and with ndistinct
+ * different keys, through each of the per-row kernels that the executor's
+ * operators are built on, one at a time. Returns one row per kernel with
+ * the time it took per row, in nanoseconds. Generating the rows isn't
+ * counted, so a change to one kernel can be measured on its own.
+ */
+Datum
+gp_bench_operators(PG_FUNCTION_ARGS)
+{
+	FuncCallContext *funcctx;
+	double	   *nsPerTuple;
+
+	if (SRF_IS_FIRSTCALL())
+	{
+		int32		ntuples = PG_GETARG_INT32(0);
+		int32		width = PG_GETARG_INT32(1);
+		int32		ndistinct = PG_GETARG_INT32(2);
+		TupleDesc	tupdesc;
+		MemoryContext oldcontext;
+		MemoryContext benchcxt;
+		BenchRows	rows;
+		instr_time	elapsed[NUM_BENCH_KERNELS];
+		int			i;
+
+		check_bench_privilege();
+
+		if (ntuples <= 0)
+			ereport(ERROR,
+					(errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+					 errmsg("number of rows must be positive")));
+		if (width < (int32) sizeof(int64) || width > BENCH_BLOCK_SIZE / 2)
+			ereport(ERROR,
+					(errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+					 errmsg("row width must be between %d and %d bytes",
+							(int) sizeof(int64), BENCH_BLOCK_SIZE / 2)));
+		if (ndistinct <= 0)
+			ereport(ERROR,
+					(errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+					 errmsg("number of distinct keys must be positive")));
+
+		funcctx = SRF_FIRSTCALL_INIT();
+
+		oldcontext = MemoryContextSwitchTo(funcctx->multi_call_memory_ctx);
+
+		/* this had better match the definition in pg_proc.sql */
+		tupdesc = CreateTemplateTupleDesc(2, false);
+		TupleDescInitEntry(tupdesc, (AttrNumber) 1, "kernel", TEXTOID, -1, 0);
+		TupleDescInitEntry(tupdesc, (AttrNumber) 2, "ns_per_tuple", FLOAT8OID, -1, 0);
+		funcctx->tuple_desc = BlessTupleDesc(tupdesc);
+
+		nsPerTuple = palloc(NUM_BENCH_KERNELS * sizeof(double));
+		funcctx->user_fctx = nsPerTuple;
+		funcctx->max_calls = NUM_BENCH_KERNELS;
+
+		MemoryContextSwitchTo(oldcontext);
+
+		/* everything the kernels allocate goes away with this */
+		benchcxt = AllocSetContextCreate(CurrentMemoryContext,
+										 "gp_bench_operators",
+										 ALLOCSET_DEFAULT_MINSIZE,
+										 ALLOCSET_DEFAULT_INITSIZE,
+										 ALLOCSET_DEFAULT_MAXSIZE);
+		oldcontext = MemoryContextSwitchTo(benchcxt);
+
+		rows.tupdesc = CreateTemplateTupleDesc(2, false);
+		TupleDescInitEntry(rows.tupdesc, (AttrNumber) 1, "k", INT8OID, -1, 0);
+		TupleDescInitEntry(rows.tupdesc, (AttrNumber) 2, "pad", TEXTOID, -1, 0);
+		rows.ntuples = ntuples;
+		rows.ndistinct = ndistinct;
+		rows.padlen = width - (int) sizeof(int64);
+		rows.sample = make_sample_data(1);
+		rows.batchcxt = AllocSetContextCreate(benchcxt,
+											  "gp_bench_operators rows",
+											  ALLOCSET_DEFAULT_MINSIZE,
+											  ALLOCSET_DEFAULT_INITSIZE,
+											  ALLOCSET_DEFAULT_MAXSIZE);
+
+		for (i = 0; i < NUM_BENCH_KERNELS; i++)
+			INSTR_TIME_SET_ZERO(elapsed[i]);
+
+		bench_cdbhash(&rows, &elapsed[BENCH_KERNEL_CDBHASH]);
+		bench_hash_table(&rows, &elapsed[BENCH_KERNEL_HASH_BUILD],
+						 &elapsed[BENCH_KERNEL_HASH_PROBE]);
+		bench_sort(&rows, &elapsed[BENCH_KERNEL_SORT]);
+		bench_serialize(&rows, &elapsed[BENCH_KERNEL_SERIALIZE],
+						&elapsed[BENCH_KERNEL_DESERIALIZE]);
+		bench_block_compress(&rows, &elapsed[BENCH_KERNEL_COMPRESS],
+							 &elapsed[BENCH_KERNEL_DECOMPRESS]);
+
+		for (i = 0; i < NUM_BENCH_KERNELS; i++)
+			nsPerTuple[i] = INSTR_TIME_GET_DOUBLE(elapsed[i]) * 1e9 / ntuples;
+
+		MemoryContextSwitchTo(oldcontext);
+		MemoryContextDelete(benchcxt);
+	}
+
+	funcctx = SRF_PERCALL_SETUP();
+	nsPerTuple = (double *) funcctx->user_fctx;
+
+	if (funcctx->call_cntr < funcctx->max_calls)
+	{
+		int			k = (int) funcctx->call_cntr;
+		Datum		values[2];
+		bool		nulls[2] = {false, false};
+		HeapTuple	tuple;
+
+		values[0] = CStringGetTextDatum(bench_kernel_names[k]);
+		values[1] = Float8GetDatum(nsPerTuple[k]);
+		tuple = heap_form_tuple(funcctx->tuple_desc, values, nulls);
+
+		SRF_RETURN_NEXT(funcctx, HeapTupleGetDatum(tuple));
+	}
+
+	SRF_RETURN_DONE(funcctx);
+}
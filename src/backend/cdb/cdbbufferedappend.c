@@ -20,6 +20,7 @@
 #include <unistd.h>				/* for write() */
 
 #include "cdb/cdbbufferedappend.h"
+#include "cdb/cdbvars.h"
 #include "utils/guc.h"
 
 static void BufferedAppendWrite(
@@ -133,6 +134,73 @@ BufferedAppendSetFile(
 	bufferedAppend->fileLen_uncompressed = eof_uncompressed;
 
 	bufferedAppend->initialSetFilePosition = eof;
+
+	bufferedAppend->allocatedEnd = eof;
+	bufferedAppend->dropCachePosition = eof;
+}
+
+/*
+ * Reserve disk space ahead of a large write, gp_appendonly_preallocate_size
+ * at a time.  Failure (e.g. a file system without fallocate) is ignored;
+ * the write itself will allocate the space.
+ */
+static void
+BufferedAppendPreallocate(
+						  BufferedAppend *bufferedAppend)
+{
+	int64		writeEnd;
+	int64		extentLen;
+
+	if (gp_appendonly_preallocate_size <= 0)
+		return;
+
+	writeEnd = bufferedAppend->largeWritePosition + bufferedAppend->largeWriteLen;
+	if (writeEnd <= bufferedAppend->allocatedEnd)
+		return;
+
+	extentLen = (int64) gp_appendonly_preallocate_size * 1024;
+	if (extentLen < writeEnd - bufferedAppend->allocatedEnd)
+		extentLen = writeEnd - bufferedAppend->allocatedEnd;
+
+	(void) FileAllocate(bufferedAppend->file,
+						bufferedAppend->allocatedEnd, extentLen);
+
+	bufferedAppend->allocatedEnd += extentLen;
+}
+
+/*
+ * Keep what we write out of the page cache: start the writeback of the large
+ * write just done, and evict what the earlier ones left, by now most likely
+ * written back.
+ */
+static void
+BufferedAppendDropCache(
+						BufferedAppend *bufferedAppend)
+{
+	int64		writePosition = bufferedAppend->largeWritePosition;
+
+	if (!gp_appendonly_write_nocache)
+	{
+		bufferedAppend->dropCachePosition =
+			writePosition + bufferedAppend->largeWriteLen;
+		return;
+	}
+
+	if (writePosition > bufferedAppend->dropCachePosition)
+	{
+		(void) FileWriteback(bufferedAppend->file,
+							 bufferedAppend->dropCachePosition,
+							 writePosition - bufferedAppend->dropCachePosition,
+							 true);
+		(void) FileDropCache(bufferedAppend->file,
+							 bufferedAppend->dropCachePosition,
+							 writePosition - bufferedAppend->dropCachePosition);
+	}
+
+	(void) FileWriteback(bufferedAppend->file,
+						 writePosition, bufferedAppend->largeWriteLen, false);
+
+	bufferedAppend->dropCachePosition = writePosition;
 }
 
 
@@ -172,6 +240,8 @@ BufferedAppendWrite(
 	}
 #endif
 
+	BufferedAppendPreallocate(bufferedAppend);
+
 	while (writeLen > 0)
 	{
 		int			primaryError;
@@ -206,6 +276,8 @@ BufferedAppendWrite(
 		largeWriteMemory += actualLen;
 	}
 
+	BufferedAppendDropCache(bufferedAppend);
+
 	bufferedAppend->largeWritePosition += bufferedAppend->largeWriteLen;
 	bufferedAppend->largeWriteLen = 0;
 
@@ -419,6 +491,18 @@ BufferedAppendCompleteFile(
 	if (bufferedAppend->largeWriteLen > 0)
 		BufferedAppendWrite(bufferedAppend);
 
+	if (gp_appendonly_write_nocache &&
+		bufferedAppend->fileLen > bufferedAppend->dropCachePosition)
+	{
+		(void) FileWriteback(bufferedAppend->file,
+							 bufferedAppend->dropCachePosition,
+							 bufferedAppend->fileLen - bufferedAppend->dropCachePosition,
+							 true);
+		(void) FileDropCache(bufferedAppend->file,
+							 bufferedAppend->dropCachePosition,
+							 bufferedAppend->fileLen - bufferedAppend->dropCachePosition);
+	}
+
 	*fileLen = bufferedAppend->fileLen;
 	*fileLen_uncompressed = bufferedAppend->fileLen_uncompressed;
 
@@ -433,6 +517,8 @@ BufferedAppendCompleteFile(
 	bufferedAppend->filePathName = NULL;
 
 	bufferedAppend->initialSetFilePosition = 0;
+	bufferedAppend->allocatedEnd = 0;
+	bufferedAppend->dropCachePosition = 0;
 }
 
 /*
@@ -16,9 +16,12 @@
  */
 #include "cdb/cdbbufferedread.h"
 #include <unistd.h>				/* for read() */
+#include "cdb/cdbvars.h"
 #include "utils/guc.h"
 #include "miscadmin.h"
 
+static void BufferedReadPrefetch(
+			   BufferedRead *bufferedRead);
 static void BufferedReadIo(
 			   BufferedRead *bufferedRead);
 static uint8 *BufferedReadUseBeforeBuffer(
@@ -109,6 +112,8 @@ BufferedReadInit(
 	 */
 	bufferedRead->haveTemporaryLimitInEffect = false;
 	bufferedRead->temporaryLimitFileLen = 0;
+
+	bufferedRead->prefetchEnd = 0;
 }
 
 /*
@@ -142,6 +147,8 @@ BufferedReadSetFile(
 	bufferedRead->haveTemporaryLimitInEffect = false;
 	bufferedRead->temporaryLimitFileLen = 0;
 
+	bufferedRead->prefetchEnd = 0;
+
 	if (fileLen > 0)
 	{
 		/*
@@ -155,6 +162,53 @@ BufferedReadSetFile(
 	}
 }
 
+/*
+ * Ask the kernel to start reading the large reads that follow the one about
+ * to be done, so that the disk is busy while the caller decompresses and
+ * processes the current one.
+ *
+ * Up to gp_appendonly_prefetch_depth large reads are kept in flight.  Each
+ * range is advised only once; prefetchEnd remembers how far we got.  We
+ * never advise past the in-effect EOF, so a random read with a temporary
+ * range doesn't drag in the rest of the segment file.
+ */
+static void
+BufferedReadPrefetch(
+			   BufferedRead *bufferedRead)
+{
+	int64		inEffectFileLen;
+	int64		prefetchStart;
+	int64		prefetchEnd;
+
+	if (gp_appendonly_prefetch_depth <= 0)
+		return;
+
+	if (bufferedRead->haveTemporaryLimitInEffect)
+		inEffectFileLen = bufferedRead->temporaryLimitFileLen;
+	else
+		inEffectFileLen = bufferedRead->fileLen;
+
+	prefetchStart = bufferedRead->largeReadPosition +
+		bufferedRead->largeReadLen;
+	if (bufferedRead->prefetchEnd > prefetchStart)
+		prefetchStart = bufferedRead->prefetchEnd;
+
+	prefetchEnd = bufferedRead->largeReadPosition +
+		bufferedRead->largeReadLen +
+		(int64) gp_appendonly_prefetch_depth * bufferedRead->maxLargeReadLen;
+	if (prefetchEnd > inEffectFileLen)
+		prefetchEnd = inEffectFileLen;
+
+	if (prefetchEnd <= prefetchStart)
+		return;
+
+	/* Purely advisory; a failure just means we read synchronously. */
+	(void) FilePrefetch(bufferedRead->file, prefetchStart,
+						(int) (prefetchEnd - prefetchStart));
+
+	bufferedRead->prefetchEnd = prefetchEnd;
+}
+
 /*
  * Perform a large read i/o.
  */
@@ -170,6 +224,8 @@ BufferedReadIo(
 	Assert(bufferedRead->largeReadLen > 0);
 	largeReadMemory = bufferedRead->largeReadMemory;
 
+	BufferedReadPrefetch(bufferedRead);
+
 #ifdef USE_ASSERT_CHECKING
 	{
 		int64		currentReadPosition;
@@ -240,6 +296,16 @@ BufferedReadIo(
 		offset += actualLen;
 	}
 
+	/*
+	 * The data is in our memory now.  A sequential scan won't come back for
+	 * it, so let the kernel reuse the pages if asked to; random reads within
+	 * a temporary limit are left alone.
+	 */
+	if (gp_appendonly_scan_nocache && !bufferedRead->haveTemporaryLimitInEffect)
+		(void) FileDropCache(bufferedRead->file,
+							 bufferedRead->largeReadPosition,
+							 bufferedRead->largeReadLen);
+
 	if (VacuumCostActive)
 		VacuumCostBalance += VacuumCostPageMiss;
 }
@@ -413,6 +479,10 @@ BufferedReadSetTemporaryRange(
 		}
 	}
 
+	/* Set before any read so that prefetching stops at the temporary EOF. */
+	bufferedRead->haveTemporaryLimitInEffect = true;
+	bufferedRead->temporaryLimitFileLen = afterFileOffset;
+
 	if (newReadNeeded)
 	{
 		int64		remainingFileLen;
@@ -442,14 +512,12 @@ BufferedReadSetTemporaryRange(
 			bufferedRead->largeReadLen = (int32) remainingFileLen;
 
 		bufferedRead->largeReadPosition = beginFileOffset;
+		bufferedRead->prefetchEnd = 0;
 
 		if (bufferedRead->largeReadLen > 0)
 			BufferedReadIo(bufferedRead);
 	}
 
-	bufferedRead->haveTemporaryLimitInEffect = true;
-	bufferedRead->temporaryLimitFileLen = afterFileOffset;
-
 }
 
 /*
@@ -698,6 +766,8 @@ BufferedReadCompleteFile(
 
 	bufferedRead->largeReadPosition = 0;
 	bufferedRead->largeReadLen = 0;
+
+	bufferedRead->prefetchEnd = 0;
 }
 
 
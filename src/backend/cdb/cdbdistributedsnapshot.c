@@ -100,6 +100,71 @@ localXidSatisfiesAnyDistributedSnapshot(TransactionId localXid)
 	return true;
 }
 
+/*
+ * Binary search the sorted in-progress array of a distributed snapshot.
+ * createDtxSnapshot sorts it in ascending order of distributed xid.
+ */
+static bool
+DistributedSnapshot_IsInProgress(DistributedSnapshot *ds,
+								 DistributedTransactionId distribXid)
+{
+	int32		low = 0;
+	int32		high = (int32) ds->count - 1;
+
+	while (low <= high)
+	{
+		int32		mid = low + (high - low) / 2;
+		DistributedTransactionId midXid = ds->inProgressXidArray[mid];
+
+		if (distribXid == midXid)
+			return true;
+		if (distribXid < midXid)
+			high = mid - 1;
+		else
+			low = mid + 1;
+	}
+
+	return false;
+}
+
+/*
+ * Binary search the local xid cache of a snapshot, which is kept sorted in
+ * xid order. Sets *found, and returns the position of localXid in the cache,
+ * or the position it should be inserted at.
+ *
+ * All the cached xids belong to transactions that were running when the
+ * snapshot was taken, so they are close enough together for
+ * TransactionIdPrecedes() to order them.
+ */
+static int32
+LocalXidCacheSearch(DistributedSnapshotWithLocalMapping *dslm,
+					TransactionId localXid, bool *found)
+{
+	int32		low = 0;
+	int32		high = dslm->currentLocalXidsCount - 1;
+
+	while (low <= high)
+	{
+		int32		mid = low + (high - low) / 2;
+		TransactionId midXid = dslm->inProgressMappedLocalXids[mid];
+
+		Assert(TransactionIdIsValid(midXid));
+
+		if (TransactionIdEquals(localXid, midXid))
+		{
+			*found = true;
+			return mid;
+		}
+		if (TransactionIdPrecedes(localXid, midXid))
+			high = mid - 1;
+		else
+			low = mid + 1;
+	}
+
+	*found = false;
+	return low;
+}
+
 /*
  * DistributedSnapshotWithLocalMapping_CommittedTest
  *		Is the given XID still-in-progress according to the
@@ -116,7 +181,6 @@ DistributedSnapshotWithLocalMapping_CommittedTest(
 												  bool isVacuumCheck)
 {
 	DistributedSnapshot *ds = &dslm->ds;
-	uint32		i;
 	DistributedTransactionId distribXid = InvalidDistributedTransactionId;
 
 	/*
@@ -145,14 +209,11 @@ DistributedSnapshotWithLocalMapping_CommittedTest(
 		if (TransactionIdFollows(localXid, dslm->minCachedLocalXid) &&
 			TransactionIdPrecedes(localXid, dslm->maxCachedLocalXid))
 		{
-			for (i = 0; i < dslm->currentLocalXidsCount; i++)
-			{
-				Assert(dslm->inProgressMappedLocalXids != NULL);
-				Assert(TransactionIdIsValid(dslm->inProgressMappedLocalXids[i]));
+			bool		found;
 
-				if (TransactionIdEquals(localXid, dslm->inProgressMappedLocalXids[i]))
-					return DISTRIBUTEDSNAPSHOT_COMMITTED_INPROGRESS;
-			}
+			(void) LocalXidCacheSearch(dslm, localXid, &found);
+			if (found)
+				return DISTRIBUTEDSNAPSHOT_COMMITTED_INPROGRESS;
 		}
 	}
 
@@ -263,46 +324,37 @@ DistributedSnapshotWithLocalMapping_CommittedTest(
 		return DISTRIBUTEDSNAPSHOT_COMMITTED_INPROGRESS;
 	}
 
-	for (i = 0; i < ds->count; i++)
+	if (DistributedSnapshot_IsInProgress(ds, distribXid))
 	{
-		if (distribXid == ds->inProgressXidArray[i])
+		/*
+		 * Save the relationship to the local xid so we may avoid checking
+		 * the distributed committed log in a subsequent check. We can only
+		 * record local xids till cache size permits.
+		 */
+		if (dslm->currentLocalXidsCount < dslm->maxLocalXidsCount)
 		{
-			/*
-			 * Save the relationship to the local xid so we may avoid checking
-			 * the distributed committed log in a subsequent check. We can
-			 * only record local xids till cache size permits.
-			 */
-			if (dslm->currentLocalXidsCount < dslm->maxLocalXidsCount)
+			bool		found;
+			int32		pos;
+
+			Assert(dslm->inProgressMappedLocalXids != NULL);
+
+			/* Keep the cache sorted, so that lookups can binary search */
+			pos = LocalXidCacheSearch(dslm, localXid, &found);
+			if (!found)
 			{
-				Assert(dslm->inProgressMappedLocalXids != NULL);
-
-				dslm->inProgressMappedLocalXids[dslm->currentLocalXidsCount++] =
-					localXid;
-
-				if (!TransactionIdIsValid(dslm->minCachedLocalXid) ||
-					TransactionIdPrecedes(localXid, dslm->minCachedLocalXid))
-				{
-					dslm->minCachedLocalXid = localXid;
-				}
-
-				if (!TransactionIdIsValid(dslm->maxCachedLocalXid) ||
-					TransactionIdFollows(localXid, dslm->maxCachedLocalXid))
-				{
-					dslm->maxCachedLocalXid = localXid;
-				}
+				memmove(&dslm->inProgressMappedLocalXids[pos + 1],
+						&dslm->inProgressMappedLocalXids[pos],
+						(dslm->currentLocalXidsCount - pos) * sizeof(TransactionId));
+				dslm->inProgressMappedLocalXids[pos] = localXid;
+				dslm->currentLocalXidsCount++;
+
+				dslm->minCachedLocalXid = dslm->inProgressMappedLocalXids[0];
+				dslm->maxCachedLocalXid =
+					dslm->inProgressMappedLocalXids[dslm->currentLocalXidsCount - 1];
 			}
-
-			return DISTRIBUTEDSNAPSHOT_COMMITTED_INPROGRESS;
 		}
 
-		/*
-		 * Leverage the fact that ds->inProgressXidArray is sorted in
-		 * ascending order based on distribXid while creating the snapshot in
-		 * createDtxSnapshot. So, can fail fast once known are lower than rest
-		 * of them.
-		 */
-		if (distribXid < ds->inProgressXidArray[i])
-			break;
+		return DISTRIBUTEDSNAPSHOT_COMMITTED_INPROGRESS;
 	}
 
 	/*
@@ -0,0 +1,1202 @@
+/*-------------------------------------------------------------------------
+ *
+ * cdbendpoint.c
+ *	   Endpoints of PARALLEL RETRIEVE cursors.
+ *
+ * The root slice of a PARALLEL RETRIEVE cursor runs on the segments, with
+ * no Gather Motion to the QD.  On each segment, the QE executing the root
+ * slice sends its rows to an endpoint: a ring buffer in shared memory,
+ * identified by a token that the QD generated when the cursor was
+ * declared.  A client retrieves the rows by connecting to the segment in
+ * utility mode and running
+ *
+ *		RETRIEVE ALL FROM ENDPOINT '<token>';
+ *
+ * so the result set never passes through the QD.  On the QD,
+ * gp_endpoints() lists the endpoints of the session's cursors, and
+ * gp_wait_parallel_retrieve_cursor() waits until all rows of a cursor
+ * have been retrieved.  On a segment, gp_segment_endpoints() shows the
+ * endpoints there and who is attached to them.
+ *
+ * The stream of an endpoint consists of a tuple descriptor followed by
+ * the rows, each as a length word and the tuple's t_data.  Toasted
+ * attributes are flattened by the sender, so the rows can be read
+ * without access to the tables they came from.
+ *
+ * The number of endpoints is fixed at postmaster start by
+ * gp_max_endpoints, each with a ENDPOINT_BUFFER_SIZE ring buffer.
+ *
+ * Portions Copyright (c) 2012-Present Pivotal Software, Inc.
+ *
+ *
+ * IDENTIFICATION
+ *	    src/backend/cdb/cdbendpoint.c
+ *
+ *-------------------------------------------------------------------------
+ */
+
+#include "postgres.h"
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "access/heapam.h"
+#include "access/tuptoaster.h"
+#include "catalog/pg_type.h"
+#include "executor/execdesc.h"
+#include "executor/tuptable.h"
+#include "funcapi.h"
+#include "miscadmin.h"
+#include "storage/ipc.h"
+#include "storage/proc.h"
+#include "storage/shmem.h"
+#include "storage/spin.h"
+#include "utils/builtins.h"
+#include "utils/memutils.h"
+
+#include "cdb/cdbdisp.h"
+#include "cdb/cdbendpoint.h"
+#include "cdb/cdbgang.h"
+#include "cdb/cdbutil.h"
+#include "cdb/cdbvars.h"
+
+/* Size of the ring buffer of each endpoint */
+#define ENDPOINT_BUFFER_SIZE	(256 * 1024)
+
+/* How long RETRIEVE waits for the QE to set up the endpoint, in seconds */
+#define ENDPOINT_ATTACH_TIMEOUT	10
+
+#define NUM_ENDPOINTS_COLUMNS	5
+#define NUM_SEGMENT_ENDPOINTS_COLUMNS	6
+
+typedef enum EndpointState
+{
+	ENDPOINT_FREE = 0,			/* slot is unused */
+	ENDPOINT_READY,				/* sender is producing rows */
+	ENDPOINT_FINISHED,			/* sender has written all rows */
+	ENDPOINT_ABORTED			/* sender or receiver gave up */
+} EndpointState;
+
+/*
+ * Header of an endpoint in shared memory.  The ring buffer follows it.
+ *
+ * 'written' and 'read' are byte positions in the stream; the buffer holds
+ * the bytes between them.  Only the sender advances 'written' and only the
+ * receiver advances 'read', so the data itself is copied without holding
+ * the spinlock.
+ */
+typedef struct EndpointSlot
+{
+	slock_t		mutex;
+	EndpointState state;
+	char		token[ENDPOINT_TOKEN_LEN + 1];
+	Oid			userid;			/* session user of the cursor */
+	int			sessionId;		/* gp_session_id of the cursor */
+	PGPROC	   *sender;			/* QE executing the root slice */
+	PGPROC	   *receiver;		/* session running RETRIEVE, if any */
+	uint64		written;
+	uint64		read;
+} EndpointSlot;
+
+#define EndpointSlotStride \
+	(MAXALIGN(sizeof(EndpointSlot)) + ENDPOINT_BUFFER_SIZE)
+#define EndpointSlotGet(i) \
+	((volatile EndpointSlot *) (EndpointArray + (Size) (i) * EndpointSlotStride))
+#define EndpointSlotData(slot) \
+	((char *) (slot) + MAXALIGN(sizeof(EndpointSlot)))
+
+/* Private state of the DestReceiver returned by CreateEndpointDestReceiver */
+typedef struct EndpointSendState
+{
+	DestReceiver pub;
+	char		token[ENDPOINT_TOKEN_LEN + 1];
+	TupleDesc	tupdesc;
+	bool		aborted;		/* stop sending, the query is finishing */
+} EndpointSendState;
+
+/* A PARALLEL RETRIEVE cursor of this session, on the QD */
+typedef struct ParallelRetrieveCursor
+{
+	char	   *name;
+	char	   *token;
+	List	   *contentIds;		/* segments running the root slice */
+} ParallelRetrieveCursor;
+
+static char *EndpointArray = NULL;
+
+/* QE: the endpoint this process sends to */
+static volatile EndpointSlot *SenderSlot = NULL;
+
+/* utility mode: the endpoint this session retrieves from */
+static char RetrieveToken[ENDPOINT_TOKEN_LEN + 1];
+static volatile EndpointSlot *RetrieveSlot = NULL;
+static TupleDesc RetrieveTupleDesc = NULL;
+static bool RetrieveInProgress = false;
+
+/* QD: list of ParallelRetrieveCursor, in TopMemoryContext */
+static List *ParallelRetrieveCursors = NIL;
+
+static bool endpoint_exit_registered = false;
+
+static void endpoint_wait(long timeout);
+static void endpoint_detach(volatile EndpointSlot *slot, bool sender,
+				bool abort);
+static void endpoint_on_exit(int code, Datum arg);
+static void endpoint_register_exit(void);
+static bool endpoint_write(EndpointSendState *self, const void *data,
+			   Size len);
+static bool endpoint_read(volatile EndpointSlot *slot, void *data, Size len,
+			  bool eofOK);
+static void endpoint_attach(const char *token);
+static void endpoint_send_startup(DestReceiver *self, int operation,
+					  TupleDesc typeinfo);
+static void endpoint_send_slot(TupleTableSlot *slot, DestReceiver *self);
+static void endpoint_send_shutdown(DestReceiver *self);
+static void endpoint_send_destroy(DestReceiver *self);
+
+/*
+ * Report shared memory space needed by EndpointShmemInit.
+ */
+Size
+EndpointShmemSize(void)
+{
+	return mul_size(EndpointSlotStride, gp_max_endpoints);
+}
+
+/*
+ * Allocate and initialize the endpoints in shared memory.
+ */
+void
+EndpointShmemInit(void)
+{
+	bool		found;
+	int			i;
+
+	EndpointArray = (char *)
+		ShmemInitStruct("Parallel Retrieve Endpoints", EndpointShmemSize(), &found);
+
+	if (!found)
+	{
+		for (i = 0; i < gp_max_endpoints; i++)
+		{
+			volatile EndpointSlot *slot = EndpointSlotGet(i);
+
+			SpinLockInit(&slot->mutex);
+			slot->state = ENDPOINT_FREE;
+			slot->token[0] = '\0';
+			slot->sender = NULL;
+			slot->receiver = NULL;
+			slot->written = 0;
+			slot->read = 0;
+		}
+	}
+}
+
+/*
+ * Wait for the process latch to be set by the other side of an endpoint,
+ * or for 'timeout' milliseconds.
+ *
+ * The caller must reset the latch before checking the condition it waits
+ * for.
+ */
+static void
+endpoint_wait(long timeout)
+{
+	int			rc;
+
+	rc = WaitLatch(&MyProc->procLatch,
+				   WL_LATCH_SET | WL_POSTMASTER_DEATH | WL_TIMEOUT,
+				   timeout);
+
+	if (rc & WL_POSTMASTER_DEATH)
+		proc_exit(1);
+
+	CHECK_FOR_INTERRUPTS();
+}
+
+/*
+ * Detach the sender or the receiver from an endpoint.  With 'abort', the
+ * other side is told that the stream is incomplete.  The slot is freed
+ * once neither side is attached.
+ */
+static void
+endpoint_detach(volatile EndpointSlot *slot, bool sender, bool abort)
+{
+	PGPROC	   *other;
+
+	SpinLockAcquire(&slot->mutex);
+	if (abort && slot->state != ENDPOINT_FREE)
+		slot->state = ENDPOINT_ABORTED;
+	if (sender)
+	{
+		slot->sender = NULL;
+		other = slot->receiver;
+	}
+	else
+	{
+		slot->receiver = NULL;
+		other = slot->sender;
+	}
+	if (slot->sender == NULL && slot->receiver == NULL)
+	{
+		slot->state = ENDPOINT_FREE;
+		slot->token[0] = '\0';
+	}
+	SpinLockRelease(&slot->mutex);
+
+	if (other)
+		SetLatch(&other->procLatch);
+}
+
+static void
+endpoint_on_exit(int code, Datum arg)
+{
+	if (SenderSlot)
+	{
+		endpoint_detach(SenderSlot, true, true);
+		SenderSlot = NULL;
+	}
+	if (RetrieveSlot)
+	{
+		endpoint_detach(RetrieveSlot, false, true);
+		RetrieveSlot = NULL;
+	}
+}
+
+static void
+endpoint_register_exit(void)
+{
+	if (!endpoint_exit_registered)
+	{
+		on_shmem_exit(endpoint_on_exit, 0);
+		endpoint_exit_registered = true;
+	}
+}
+
+/*
+ * Transaction abort: give up the endpoint this process was sending to, and
+ * the endpoint it was in the middle of retrieving from.  An endpoint whose
+ * RETRIEVE completed normally stays attached.
+ */
+void
+AtAbort_Endpoints(void)
+{
+	if (SenderSlot)
+	{
+		endpoint_detach(SenderSlot, true, true);
+		SenderSlot = NULL;
+	}
+	if (RetrieveInProgress)
+	{
+		if (RetrieveSlot)
+		{
+			endpoint_detach(RetrieveSlot, false, true);
+			RetrieveSlot = NULL;
+		}
+		RetrieveToken[0] = '\0';
+		RetrieveInProgress = false;
+	}
+}
+
+/*
+ * Append 'len' bytes to the stream of the endpoint, waiting for the
+ * receiver to make room as needed.  Returns false if the query is being
+ * finished, in which case the endpoint has been aborted.
+ */
+static bool
+endpoint_write(EndpointSendState *self, const void *data, Size len)
+{
+	volatile EndpointSlot *slot = SenderSlot;
+	char	   *buf = EndpointSlotData(slot);
+	const char *src = (const char *) data;
+
+	while (len > 0)
+	{
+		EndpointState state;
+		uint64		written;
+		uint64		read;
+		PGPROC	   *receiver = NULL;
+		bool		wasEmpty;
+		Size		avail;
+		Size		off;
+		Size		n;
+
+		ResetLatch(&MyProc->procLatch);
+
+		SpinLockAcquire(&slot->mutex);
+		state = slot->state;
+		written = slot->written;
+		read = slot->read;
+		SpinLockRelease(&slot->mutex);
+
+		if (state == ENDPOINT_ABORTED)
+			ereport(ERROR,
+					(errcode(ERRCODE_QUERY_CANCELED),
+					 errmsg("endpoint \"%s\" was aborted by the retrieving session",
+							self->token)));
+
+		if (QueryFinishPending)
+		{
+			endpoint_detach(slot, true, true);
+			SenderSlot = NULL;
+			self->aborted = true;
+			return false;
+		}
+
+		avail = ENDPOINT_BUFFER_SIZE - (Size) (written - read);
+		if (avail == 0)
+		{
+			endpoint_wait(1000);
+			continue;
+		}
+
+		off = (Size) (written % ENDPOINT_BUFFER_SIZE);
+		n = Min(len, avail);
+		n = Min(n, ENDPOINT_BUFFER_SIZE - off);
+		memcpy(buf + off, src, n);
+
+		SpinLockAcquire(&slot->mutex);
+		wasEmpty = (slot->written == slot->read);
+		slot->written += n;
+		if (wasEmpty)
+			receiver = slot->receiver;
+		SpinLockRelease(&slot->mutex);
+
+		/* The receiver only sleeps on an empty buffer */
+		if (receiver)
+			SetLatch(&receiver->procLatch);
+
+		src += n;
+		len -= n;
+	}
+
+	return true;
+}
+
+/*
+ * Read 'len' bytes from the stream of the endpoint, waiting for the sender
+ * as needed.  Returns false at the end of the stream, which is only
+ * acceptable if 'eofOK' and no bytes have been read yet.
+ */
+static bool
+endpoint_read(volatile EndpointSlot *slot, void *data, Size len, bool eofOK)
+{
+	char	   *buf = EndpointSlotData(slot);
+	char	   *dst = (char *) data;
+	bool		first = true;
+
+	while (len > 0)
+	{
+		EndpointState state;
+		uint64		written;
+		uint64		read;
+		PGPROC	   *sender = NULL;
+		bool		wasFull;
+		Size		avail;
+		Size		off;
+		Size		n;
+
+		ResetLatch(&MyProc->procLatch);
+
+		SpinLockAcquire(&slot->mutex);
+		state = slot->state;
+		written = slot->written;
+		read = slot->read;
+		SpinLockRelease(&slot->mutex);
+
+		avail = (Size) (written - read);
+		if (avail == 0)
+		{
+			if (state == ENDPOINT_ABORTED)
+				ereport(ERROR,
+						(errcode(ERRCODE_QUERY_CANCELED),
+						 errmsg("endpoint \"%s\" was aborted", RetrieveToken)));
+			if (state == ENDPOINT_FINISHED)
+			{
+				if (eofOK && first)
+					return false;
+				ereport(ERROR,
+						(errcode(ERRCODE_INTERNAL_ERROR),
+						 errmsg("unexpected end of stream of endpoint \"%s\"",
+								RetrieveToken)));
+			}
+			endpoint_wait(1000);
+			continue;
+		}
+
+		off = (Size) (read % ENDPOINT_BUFFER_SIZE);
+		n = Min(len, avail);
+		n = Min(n, ENDPOINT_BUFFER_SIZE - off);
+		memcpy(dst, buf + off, n);
+
+		SpinLockAcquire(&slot->mutex);
+		wasFull = (slot->written - slot->read == ENDPOINT_BUFFER_SIZE);
+		slot->read += n;
+		if (wasFull || slot->state == ENDPOINT_FINISHED)
+			sender = slot->sender;
+		SpinLockRelease(&slot->mutex);
+
+		/*
+		 * The sender sleeps on a full buffer, and at the end of its query
+		 * until everything has been read.
+		 */
+		if (sender)
+			SetLatch(&sender->procLatch);
+
+		dst += n;
+		len -= n;
+		first = false;
+	}
+
+	return true;
+}
+
+/*
+ * Generate the token of a new PARALLEL RETRIEVE cursor.  It is a random
+ * string of ENDPOINT_TOKEN_LEN hex digits, palloc'd in the current memory
+ * context.  Since the token is all a client needs to retrieve the rows of
+ * a cursor (as the same user), it must not be guessable.
+ */
+char *
+GenerateEndpointToken(void)
+{
+	unsigned char bytes[ENDPOINT_TOKEN_LEN / 2];
+	char	   *token;
+	int			fd;
+	int			i;
+
+	fd = open("/dev/urandom", O_RDONLY, 0);
+	if (fd < 0)
+		ereport(ERROR,
+				(errcode_for_file_access(),
+				 errmsg("could not open \"/dev/urandom\": %m")));
+	if (read(fd, bytes, sizeof(bytes)) != sizeof(bytes))
+	{
+		close(fd);
+		ereport(ERROR,
+				(errcode_for_file_access(),
+				 errmsg("could not read from \"/dev/urandom\": %m")));
+	}
+	close(fd);
+
+	token = palloc(ENDPOINT_TOKEN_LEN + 1);
+	for (i = 0; i < sizeof(bytes); i++)
+		sprintf(token + 2 * i, "%02x", bytes[i]);
+
+	return token;
+}
+
+/*
+ * Is this the Query of a DECLARE ... PARALLEL RETRIEVE CURSOR?
+ */
+bool
+IsParallelRetrieveCursorQuery(Query *query)
+{
+	return (query->utilityStmt != NULL &&
+			IsA(query->utilityStmt, DeclareCursorStmt) &&
+			(((DeclareCursorStmt *) query->utilityStmt)->options &
+			 CURSOR_OPT_PARALLEL_RETRIEVE) != 0);
+}
+
+/*
+ * Remember a PARALLEL RETRIEVE cursor that has just been started, with
+ * the segments its root slice was dispatched to.
+ */
+void
+RegisterParallelRetrieveCursor(Portal portal)
+{
+	QueryDesc  *queryDesc = PortalGetQueryDesc(portal);
+	PlannedStmt *stmt = queryDesc->plannedstmt;
+	Slice	   *rootSlice;
+	ParallelRetrieveCursor *cursor;
+	MemoryContext oldcontext;
+	ListCell   *lc;
+
+	Assert(stmt->parallelRetrieveToken != NULL);
+
+	rootSlice = (Slice *) linitial(queryDesc->estate->es_sliceTable->slices);
+	Assert(rootSlice->sliceIndex == 0);
+
+	oldcontext = MemoryContextSwitchTo(TopMemoryContext);
+
+	cursor = palloc(sizeof(ParallelRetrieveCursor));
+	cursor->name = pstrdup(portal->name);
+	cursor->token = pstrdup(stmt->parallelRetrieveToken);
+	cursor->contentIds = NIL;
+	foreach(lc, rootSlice->primaryProcesses)
+	{
+		CdbProcess *proc = (CdbProcess *) lfirst(lc);
+
+		if (proc)
+			cursor->contentIds = lappend_int(cursor->contentIds, proc->contentid);
+	}
+
+	ParallelRetrieveCursors = lappend(ParallelRetrieveCursors, cursor);
+
+	MemoryContextSwitchTo(oldcontext);
+}
+
+/*
+ * Forget a PARALLEL RETRIEVE cursor when its portal is dropped.  Does
+ * nothing for other portals.
+ */
+void
+UnregisterParallelRetrieveCursor(Portal portal)
+{
+	ListCell   *lc;
+	ListCell   *prev = NULL;
+
+	foreach(lc, ParallelRetrieveCursors)
+	{
+		ParallelRetrieveCursor *cursor = (ParallelRetrieveCursor *) lfirst(lc);
+
+		if (strcmp(cursor->name, portal->name) == 0)
+		{
+			ParallelRetrieveCursors =
+				list_delete_cell(ParallelRetrieveCursors, lc, prev);
+			pfree(cursor->name);
+			pfree(cursor->token);
+			list_free(cursor->contentIds);
+			pfree(cursor);
+			return;
+		}
+		prev = lc;
+	}
+}
+
+/*
+ * Create the DestReceiver of the root slice of a PARALLEL RETRIEVE cursor
+ * on a QE.
+ */
+DestReceiver *
+CreateEndpointDestReceiver(const char *token)
+{
+	EndpointSendState *self = (EndpointSendState *) palloc0(sizeof(EndpointSendState));
+
+	self->pub.receiveSlot = endpoint_send_slot;
+	self->pub.rStartup = endpoint_send_startup;
+	self->pub.rShutdown = endpoint_send_shutdown;
+	self->pub.rDestroy = endpoint_send_destroy;
+	self->pub.mydest = DestNone;
+
+	strlcpy(self->token, token, sizeof(self->token));
+
+	return (DestReceiver *) self;
+}
+
+/*
+ * Set up the endpoint, and send the tuple descriptor.
+ */
+static void
+endpoint_send_startup(DestReceiver *self, int operation, TupleDesc typeinfo)
+{
+	EndpointSendState *myState = (EndpointSendState *) self;
+	volatile EndpointSlot *slot = NULL;
+	int32		natts;
+	int			i;
+
+	Assert(SenderSlot == NULL);
+
+	if (EndpointArray == NULL)
+		elog(ERROR, "endpoints are not initialized");
+
+	for (i = 0; i < gp_max_endpoints; i++)
+	{
+		volatile EndpointSlot *s = EndpointSlotGet(i);
+
+		SpinLockAcquire(&s->mutex);
+		if (s->state == ENDPOINT_FREE)
+		{
+			s->state = ENDPOINT_READY;
+			strlcpy((char *) s->token, myState->token, sizeof(s->token));
+			s->userid = GetSessionUserId();
+			s->sessionId = gp_session_id;
+			s->sender = MyProc;
+			s->receiver = NULL;
+			s->written = 0;
+			s->read = 0;
+			slot = s;
+		}
+		SpinLockRelease(&s->mutex);
+
+		if (slot)
+			break;
+	}
+
+	if (slot == NULL)
+		ereport(ERROR,
+				(errcode(ERRCODE_INSUFFICIENT_RESOURCES),
+				 errmsg("too many endpoints of parallel retrieve cursors on segment %d",
+						GpIdentity.segindex),
+				 errhint("Retrieve from or close other parallel retrieve cursors, "
+						 "or increase \"gp_max_endpoints\".")));
+
+	SenderSlot = slot;
+	endpoint_register_exit();
+
+	myState->tupdesc = typeinfo;
+	myState->aborted = false;
+
+	natts = typeinfo->natts;
+	if (!endpoint_write(myState, &natts, sizeof(natts)))
+		return;
+	for (i = 0; i < natts; i++)
+	{
+		Form_pg_attribute attr = typeinfo->attrs[i];
+
+		if (!endpoint_write(myState, &attr->atttypid, sizeof(Oid)) ||
+			!endpoint_write(myState, &attr->atttypmod, sizeof(int32)) ||
+			!endpoint_write(myState, &attr->attname, sizeof(NameData)))
+			return;
+	}
+}
+
+/*
+ * Send a row.
+ */
+static void
+endpoint_send_slot(TupleTableSlot *slot, DestReceiver *self)
+{
+	EndpointSendState *myState = (EndpointSendState *) self;
+	HeapTuple	tuple;
+	uint32		len;
+
+	if (myState->aborted)
+		return;
+
+	tuple = ExecFetchSlotHeapTuple(slot);
+	if (HeapTupleHasExternal(tuple))
+		tuple = toast_flatten_tuple(tuple, myState->tupdesc);
+
+	len = tuple->t_len;
+	if (endpoint_write(myState, &len, sizeof(len)))
+		endpoint_write(myState, tuple->t_data, len);
+}
+
+/*
+ * The query is done.  Wait for the rows to be retrieved, so that the QD
+ * sees the query finish only once they have all reached the client.
+ */
+static void
+endpoint_send_shutdown(DestReceiver *self)
+{
+	EndpointSendState *myState = (EndpointSendState *) self;
+	volatile EndpointSlot *slot = SenderSlot;
+	PGPROC	   *receiver;
+
+	if (myState->aborted || slot == NULL)
+		return;
+
+	SpinLockAcquire(&slot->mutex);
+	if (slot->state == ENDPOINT_READY)
+		slot->state = ENDPOINT_FINISHED;
+	receiver = slot->receiver;
+	SpinLockRelease(&slot->mutex);
+
+	/* Wake up a receiver waiting for more rows, to let it see the end */
+	if (receiver)
+		SetLatch(&receiver->procLatch);
+
+	for (;;)
+	{
+		EndpointState state;
+		bool		drained;
+
+		ResetLatch(&MyProc->procLatch);
+
+		SpinLockAcquire(&slot->mutex);
+		state = slot->state;
+		drained = (slot->read == slot->written);
+		SpinLockRelease(&slot->mutex);
+
+		if (state == ENDPOINT_ABORTED)
+			ereport(ERROR,
+					(errcode(ERRCODE_QUERY_CANCELED),
+					 errmsg("endpoint \"%s\" was aborted by the retrieving session",
+							myState->token)));
+		if (drained)
+			break;
+
+		if (QueryFinishPending)
+		{
+			endpoint_detach(slot, true, true);
+			SenderSlot = NULL;
+			myState->aborted = true;
+			return;
+		}
+
+		endpoint_wait(1000);
+	}
+
+	endpoint_detach(slot, true, false);
+	SenderSlot = NULL;
+}
+
+static void
+endpoint_send_destroy(DestReceiver *self)
+{
+	pfree(self);
+}
+
+/*
+ * Attach this session to the endpoint with the given token as its
+ * receiver, and read the tuple descriptor.  The QE may not have set up
+ * the endpoint yet, so wait for it for a while.
+ */
+static void
+endpoint_attach(const char *token)
+{
+	volatile EndpointSlot *slot = NULL;
+	bool		busy = false;
+	bool		denied = false;
+	int			waited = 0;
+	int32		natts;
+	TupleDesc	tupdesc;
+	MemoryContext oldcontext;
+	int			i;
+
+	if (EndpointArray == NULL)
+		elog(ERROR, "endpoints are not initialized");
+
+	for (;;)
+	{
+		for (i = 0; i < gp_max_endpoints && slot == NULL; i++)
+		{
+			volatile EndpointSlot *s = EndpointSlotGet(i);
+
+			SpinLockAcquire(&s->mutex);
+			if (s->state != ENDPOINT_FREE && strcmp((char *) s->token, token) == 0)
+			{
+				if (s->userid != GetSessionUserId() && !superuser())
+					denied = true;
+				else if (s->receiver != NULL || s->state == ENDPOINT_ABORTED)
+					busy = true;
+				else
+				{
+					s->receiver = MyProc;
+					slot = s;
+				}
+			}
+			SpinLockRelease(&s->mutex);
+
+			if (denied || busy)
+				break;
+		}
+
+		if (denied)
+			ereport(ERROR,
+					(errcode(ERRCODE_INSUFFICIENT_PRIVILEGE),
+					 errmsg("permission denied to retrieve from endpoint \"%s\"",
+							token),
+					 errdetail("Only the owner of the cursor may retrieve from its endpoints.")));
+		if (busy)
+			ereport(ERROR,
+					(errcode(ERRCODE_OBJECT_IN_USE),
+					 errmsg("endpoint \"%s\" is already being retrieved by another session",
+							token)));
+		if (slot)
+			break;
+
+		if (waited >= ENDPOINT_ATTACH_TIMEOUT * 10)
+			ereport(ERROR,
+					(errcode(ERRCODE_UNDEFINED_OBJECT),
+					 errmsg("endpoint \"%s\" does not exist on segment %d",
+							token, GpIdentity.segindex)));
+
+		pg_usleep(100000L);
+		waited++;
+		CHECK_FOR_INTERRUPTS();
+	}
+
+	endpoint_register_exit();
+
+	RetrieveSlot = slot;
+	strlcpy(RetrieveToken, token, sizeof(RetrieveToken));
+	RetrieveInProgress = true;
+
+	endpoint_read(slot, &natts, sizeof(natts), false);
+
+	oldcontext = MemoryContextSwitchTo(TopMemoryContext);
+	tupdesc = CreateTemplateTupleDesc(natts, false);
+	MemoryContextSwitchTo(oldcontext);
+
+	for (i = 0; i < natts; i++)
+	{
+		Oid			typid;
+		int32		typmod;
+		NameData	attname;
+
+		endpoint_read(slot, &typid, sizeof(Oid), false);
+		endpoint_read(slot, &typmod, sizeof(int32), false);
+		endpoint_read(slot, &attname, sizeof(NameData), false);
+
+		TupleDescInitEntry(tupdesc, (AttrNumber) (i + 1), NameStr(attname),
+						   typid, typmod, 0);
+	}
+
+	RetrieveTupleDesc = tupdesc;
+	RetrieveInProgress = false;
+}
+
+/*
+ * Return the tuple descriptor of the rows a RETRIEVE returns, attaching
+ * to the endpoint first if needed.
+ */
+TupleDesc
+GetRetrieveStmtTupleDesc(RetrieveStmt *stmt)
+{
+	if (Gp_role != GP_ROLE_UTILITY)
+		ereport(ERROR,
+				(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+				 errmsg("RETRIEVE can only be run in utility mode"),
+				 errhint("Connect to the segment of the endpoint with gp_session_role=utility.")));
+
+	if (strlen(stmt->endpoint) != ENDPOINT_TOKEN_LEN ||
+		strspn(stmt->endpoint, "0123456789abcdef") != ENDPOINT_TOKEN_LEN)
+		ereport(ERROR,
+				(errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+				 errmsg("invalid endpoint token \"%s\"", stmt->endpoint)));
+
+	if (strcmp(RetrieveToken, stmt->endpoint) != 0)
+	{
+		if (RetrieveSlot != NULL)
+			ereport(ERROR,
+					(errcode(ERRCODE_OBJECT_IN_USE),
+					 errmsg("this session is already retrieving from endpoint \"%s\"",
+							RetrieveToken),
+					 errhint("Retrieve all rows of that endpoint first, or use another session.")));
+
+		if (RetrieveTupleDesc)
+		{
+			FreeTupleDesc(RetrieveTupleDesc);
+			RetrieveTupleDesc = NULL;
+		}
+		RetrieveToken[0] = '\0';
+
+		endpoint_attach(stmt->endpoint);
+	}
+
+	return CreateTupleDescCopy(RetrieveTupleDesc);
+}
+
+/*
+ * Execute RETRIEVE: read up to stmt->count rows from the endpoint and send
+ * them to 'dest'.  At the end of the stream, the session detaches from the
+ * endpoint; retrieving from it again returns no rows.
+ */
+void
+ExecRetrieveStmt(RetrieveStmt *stmt, DestReceiver *dest, char *completionTag)
+{
+	TupleDesc	tupdesc;
+	TupleTableSlot *slot;
+	int64		nprocessed = 0;
+
+	tupdesc = GetRetrieveStmtTupleDesc(stmt);
+	slot = MakeSingleTupleTableSlot(tupdesc);
+
+	(*dest->rStartup) (dest, CMD_SELECT, tupdesc);
+
+	RetrieveInProgress = true;
+
+	while (RetrieveSlot != NULL &&
+		   (stmt->count == FETCH_ALL || nprocessed < stmt->count))
+	{
+		uint32		len;
+		HeapTuple	tuple;
+
+		if (!endpoint_read(RetrieveSlot, &len, sizeof(len), true))
+		{
+			endpoint_detach(RetrieveSlot, false, false);
+			RetrieveSlot = NULL;
+			break;
+		}
+
+		tuple = (HeapTuple) palloc(HEAPTUPLESIZE + len);
+		tuple->t_len = len;
+		ItemPointerSetInvalid(&tuple->t_self);
+		tuple->t_data = (HeapTupleHeader) ((char *) tuple + HEAPTUPLESIZE);
+		endpoint_read(RetrieveSlot, tuple->t_data, len, false);
+
+		ExecStoreHeapTuple(tuple, slot, InvalidBuffer, true);
+		(*dest->receiveSlot) (slot, dest);
+		nprocessed++;
+	}
+
+	RetrieveInProgress = false;
+
+	(*dest->rShutdown) (dest);
+	ExecDropSingleTupleTableSlot(slot);
+
+	if (completionTag)
+		snprintf(completionTag, COMPLETION_TAG_BUFSIZE,
+				 "RETRIEVE " INT64_FORMAT, nprocessed);
+}
+
+/*
+ * gp_endpoints
+ *		List the endpoints of the PARALLEL RETRIEVE cursors of this
+ *		session, with the segment to connect to for each.
+ */
+Datum
+gp_endpoints(PG_FUNCTION_ARGS)
+{
+	typedef struct EndpointRow
+	{
+		int			segindex;
+		char	   *hostname;
+		int			port;
+		char	   *cursorname;
+		char	   *token;
+	} EndpointRow;
+
+	FuncCallContext *funcctx;
+	List	   *rows;
+
+	if (SRF_IS_FIRSTCALL())
+	{
+		TupleDesc	tupdesc;
+		MemoryContext oldcontext;
+		CdbComponentDatabases *cdbs = NULL;
+		ListCell   *lc;
+
+		funcctx = SRF_FIRSTCALL_INIT();
+
+		oldcontext = MemoryContextSwitchTo(funcctx->multi_call_memory_ctx);
+
+		/* this had better match the definition in pg_proc.sql */
+		tupdesc = CreateTemplateTupleDesc(NUM_ENDPOINTS_COLUMNS, false);
+		TupleDescInitEntry(tupdesc, (AttrNumber) 1, "gp_segment_id", INT4OID, -1, 0);
+		TupleDescInitEntry(tupdesc, (AttrNumber) 2, "hostname", TEXTOID, -1, 0);
+		TupleDescInitEntry(tupdesc, (AttrNumber) 3, "port", INT4OID, -1, 0);
+		TupleDescInitEntry(tupdesc, (AttrNumber) 4, "cursorname", TEXTOID, -1, 0);
+		TupleDescInitEntry(tupdesc, (AttrNumber) 5, "token", TEXTOID, -1, 0);
+
+		funcctx->tuple_desc = BlessTupleDesc(tupdesc);
+
+		if (ParallelRetrieveCursors != NIL)
+			cdbs = getCdbComponentDatabases();
+
+		rows = NIL;
+		foreach(lc, ParallelRetrieveCursors)
+		{
+			ParallelRetrieveCursor *cursor = (ParallelRetrieveCursor *) lfirst(lc);
+			ListCell   *lc2;
+
+			foreach(lc2, cursor->contentIds)
+			{
+				int			contentid = lfirst_int(lc2);
+				EndpointRow *row = palloc0(sizeof(EndpointRow));
+				int			i;
+
+				row->segindex = contentid;
+				row->cursorname = cursor->name;
+				row->token = cursor->token;
+				for (i = 0; i < cdbs->total_segment_dbs; i++)
+				{
+					CdbComponentDatabaseInfo *cdi = &cdbs->segment_db_info[i];
+
+					if (cdi->segindex == contentid && SEGMENT_IS_ACTIVE_PRIMARY(cdi))
+					{
+						row->hostname = cdi->hostname;
+						row->port = cdi->port;
+						break;
+					}
+				}
+				rows = lappend(rows, row);
+			}
+		}
+		funcctx->user_fctx = (void *) rows;
+
+		MemoryContextSwitchTo(oldcontext);
+	}
+
+	funcctx = SRF_PERCALL_SETUP();
+	rows = (List *) funcctx->user_fctx;
+
+	if (rows != NIL)
+	{
+		EndpointRow *row = (EndpointRow *) linitial(rows);
+		Datum		values[NUM_ENDPOINTS_COLUMNS];
+		bool		nulls[NUM_ENDPOINTS_COLUMNS];
+		HeapTuple	tuple;
+
+		funcctx->user_fctx = (void *) list_delete_first(rows);
+
+		MemSet(nulls, false, sizeof(nulls));
+		values[0] = Int32GetDatum(row->segindex);
+		if (row->hostname)
+		{
+			values[1] = CStringGetTextDatum(row->hostname);
+			values[2] = Int32GetDatum(row->port);
+		}
+		else
+		{
+			nulls[1] = true;
+			nulls[2] = true;
+		}
+		values[3] = CStringGetTextDatum(row->cursorname);
+		values[4] = CStringGetTextDatum(row->token);
+
+		tuple = heap_form_tuple(funcctx->tuple_desc, values, nulls);
+		SRF_RETURN_NEXT(funcctx, HeapTupleGetDatum(tuple));
+	}
+
+	SRF_RETURN_DONE(funcctx);
+}
+
+/*
+ * gp_segment_endpoints
+ *		List the endpoints on this instance, with the state of their
+ *		sender and receiver.  A client that is not a superuser only sees
+ *		the endpoints of its own cursors.
+ */
+Datum
+gp_segment_endpoints(PG_FUNCTION_ARGS)
+{
+	typedef struct SegmentEndpointRow
+	{
+		char		token[ENDPOINT_TOKEN_LEN + 1];
+		Oid			userid;
+		int			sessionId;
+		EndpointState state;
+		int			senderPid;
+		int			receiverPid;
+	} SegmentEndpointRow;
+
+	FuncCallContext *funcctx;
+	List	   *rows;
+
+	if (SRF_IS_FIRSTCALL())
+	{
+		TupleDesc	tupdesc;
+		MemoryContext oldcontext;
+		bool		su = superuser();
+		Oid			userid = GetSessionUserId();
+		int			i;
+
+		funcctx = SRF_FIRSTCALL_INIT();
+
+		oldcontext = MemoryContextSwitchTo(funcctx->multi_call_memory_ctx);
+
+		/* this had better match the definition in pg_proc.sql */
+		tupdesc = CreateTemplateTupleDesc(NUM_SEGMENT_ENDPOINTS_COLUMNS, false);
+		TupleDescInitEntry(tupdesc, (AttrNumber) 1, "token", TEXTOID, -1, 0);
+		TupleDescInitEntry(tupdesc, (AttrNumber) 2, "username", TEXTOID, -1, 0);
+		TupleDescInitEntry(tupdesc, (AttrNumber) 3, "session_id", INT4OID, -1, 0);
+		TupleDescInitEntry(tupdesc, (AttrNumber) 4, "state", TEXTOID, -1, 0);
+		TupleDescInitEntry(tupdesc, (AttrNumber) 5, "sender_pid", INT4OID, -1, 0);
+		TupleDescInitEntry(tupdesc, (AttrNumber) 6, "receiver_pid", INT4OID, -1, 0);
+
+		funcctx->tuple_desc = BlessTupleDesc(tupdesc);
+
+		rows = NIL;
+		for (i = 0; EndpointArray != NULL && i < gp_max_endpoints; i++)
+		{
+			volatile EndpointSlot *slot = EndpointSlotGet(i);
+			SegmentEndpointRow *row = palloc(sizeof(SegmentEndpointRow));
+
+			SpinLockAcquire(&slot->mutex);
+			strlcpy(row->token, (char *) slot->token, sizeof(row->token));
+			row->userid = slot->userid;
+			row->sessionId = slot->sessionId;
+			row->state = slot->state;
+			row->senderPid = slot->sender ? slot->sender->pid : 0;
+			row->receiverPid = slot->receiver ? slot->receiver->pid : 0;
+			SpinLockRelease(&slot->mutex);
+
+			if (row->state == ENDPOINT_FREE || (!su && row->userid != userid))
+				pfree(row);
+			else
+				rows = lappend(rows, row);
+		}
+		funcctx->user_fctx = (void *) rows;
+
+		MemoryContextSwitchTo(oldcontext);
+	}
+
+	funcctx = SRF_PERCALL_SETUP();
+	rows = (List *) funcctx->user_fctx;
+
+	if (rows != NIL)
+	{
+		SegmentEndpointRow *row = (SegmentEndpointRow *) linitial(rows);
+		Datum		values[NUM_SEGMENT_ENDPOINTS_COLUMNS];
+		bool		nulls[NUM_SEGMENT_ENDPOINTS_COLUMNS];
+		const char *state;
+		HeapTuple	tuple;
+
+		funcctx->user_fctx = (void *) list_delete_first(rows);
+
+		switch (row->state)
+		{
+			case ENDPOINT_READY:
+				state = "ready";
+				break;
+			case ENDPOINT_FINISHED:
+				state = "finished";
+				break;
+			default:
+				state = "aborted";
+				break;
+		}
+
+		MemSet(nulls, false, sizeof(nulls));
+		values[0] = CStringGetTextDatum(row->token);
+		values[1] = CStringGetTextDatum(GetUserNameFromId(row->userid));
+		values[2] = Int32GetDatum(row->sessionId);
+		values[3] = CStringGetTextDatum(state);
+		values[4] = Int32GetDatum(row->senderPid);
+		nulls[4] = (row->senderPid == 0);
+		values[5] = Int32GetDatum(row->receiverPid);
+		nulls[5] = (row->receiverPid == 0);
+
+		tuple = heap_form_tuple(funcctx->tuple_desc, values, nulls);
+		SRF_RETURN_NEXT(funcctx, HeapTupleGetDatum(tuple));
+	}
+
+	SRF_RETURN_DONE(funcctx);
+}
+
+/*
+ * gp_wait_parallel_retrieve_cursor
+ *		Wait until all rows of a PARALLEL RETRIEVE cursor have been
+ *		retrieved from its endpoints.  Reports the error of any QE that
+ *		failed.
+ */
+Datum
+gp_wait_parallel_retrieve_cursor(PG_FUNCTION_ARGS)
+{
+	char	   *name = text_to_cstring(PG_GETARG_TEXT_P(0));
+	Portal		portal;
+	QueryDesc  *queryDesc;
+	StringInfoData qeErrorMsg;
+
+	portal = GetPortalByName(name);
+	if (!PortalIsValid(portal))
+		ereport(ERROR,
+				(errcode(ERRCODE_UNDEFINED_CURSOR),
+				 errmsg("cursor \"%s\" does not exist", name)));
+
+	if (!(portal->cursorOptions & CURSOR_OPT_PARALLEL_RETRIEVE))
+		ereport(ERROR,
+				(errcode(ERRCODE_WRONG_OBJECT_TYPE),
+				 errmsg("cursor \"%s\" is not a parallel retrieve cursor", name)));
+
+	queryDesc = PortalGetQueryDesc(portal);
+	if (queryDesc == NULL || queryDesc->estate == NULL)
+		PG_RETURN_BOOL(true);
+
+	initStringInfo(&qeErrorMsg);
+	if (cdbdisp_getDispatchResults(queryDesc->estate->dispatcherState,
+								   &qeErrorMsg) == NULL &&
+		qeErrorMsg.len > 0)
+	{
+		/* As in cdbdisp_finishCommand(), the error code is a guess. */
+		ereport(ERROR,
+				(errcode(ERRCODE_DATA_EXCEPTION),
+				 errmsg("%s", qeErrorMsg.data)));
+	}
+	pfree(qeErrorMsg.data);
+
+	PG_RETURN_BOOL(true);
+}
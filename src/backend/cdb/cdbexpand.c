@@ -0,0 +1,470 @@
+/*-------------------------------------------------------------------------
+ *
+ * cdbexpand.c
+ *	  Online redistribution of a table after the cluster has been expanded.
+ *
+ * gpexpand sets the policy of every table to DISTRIBUTED RANDOMLY when it
+ * adds the new segments, and later restores the original policy of each
+ * table. ALTER TABLE SET WITH (REORGANIZE=true) does that by rewriting the
+ * whole table under an AccessExclusiveLock.
+ *
+ * The functions here do it a segment at a time instead. For one target
+ * segment, gp_expand_redistribute() moves the rows that hash to it but are
+ * stored elsewhere, in one transaction that holds an ExclusiveLock: writers
+ * wait, readers don't. The rows that are already in place are not touched.
+ * Once every segment is done, gp_expand_redistribute_finish() moves what
+ * concurrent inserts have misplaced since, and restores the hash policy.
+ *
+ * The rows are moved with SQL: they are copied into a temporary table
+ * distributed by the key, which sends each row to its segment, deleted
+ * from the table, and inserted back from the temporary table, with the
+ * table's policy set to the key for the duration of the INSERT so that the
+ * rows stay where they are. The policy change is undone before the
+ * transaction commits, so no other session ever sees it.
+ *
+ * Portions Copyright (c) 2012-Present Pivotal Software, Inc.
+ *
+ *
+ * IDENTIFICATION
+ *	    src/backend/cdb/cdbexpand.c
+ *
+ *-------------------------------------------------------------------------
+ */
+#include "postgres.h"
+
+#include "access/heapam.h"
+#include "catalog/gp_policy.h"
+#include "catalog/namespace.h"
+#include "catalog/pg_type.h"
+#include "cdb/cdbhash.h"
+#include "cdb/cdbpartition.h"
+#include "cdb/cdbvars.h"
+#include "executor/spi.h"
+#include "funcapi.h"
+#include "lib/stringinfo.h"
+#include "miscadmin.h"
+#include "utils/acl.h"
+#include "utils/array.h"
+#include "utils/builtins.h"
+#include "utils/guc.h"
+#include "utils/inval.h"
+#include "utils/lsyscache.h"
+#include "utils/memutils.h"
+#include "utils/typcache.h"
+
+static void extract_policy_attrs(ArrayType *array, int *nattrs, AttrNumber **attrs);
+static Oid	hash_type_of(Oid typid);
+static GpPolicy *make_key_policy(Relation rel, ArrayType *array);
+static Relation open_expanding_relation(Oid relid);
+static void set_relation_policy(Relation rel, GpPolicy *policy);
+static int64 move_misplaced_rows(Relation rel, GpPolicy *policy, int segindex);
+
+
+/*
+ * Extract the attribute numbers of a distribution key from an int2[], the
+ * form gp_distribution_policy.attrnums has.
+ */
+static void
+extract_policy_attrs(ArrayType *array, int *nattrs, AttrNumber **attrs)
+{
+	int16	   *values;
+	int			n;
+	int			i;
+
+	if (ARR_NDIM(array) != 1 || ARR_HASNULL(array) ||
+		ARR_ELEMTYPE(array) != INT2OID)
+		ereport(ERROR,
+				(errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+				 errmsg("distribution key must be a one-dimensional int2 array without nulls")));
+
+	n = ARR_DIMS(array)[0];
+	if (n <= 0)
+		ereport(ERROR,
+				(errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+				 errmsg("distribution key must not be empty")));
+
+	values = (int16 *) ARR_DATA_PTR(array);
+	*attrs = (AttrNumber *) palloc(n * sizeof(AttrNumber));
+	for (i = 0; i < n; i++)
+		(*attrs)[i] = values[i];
+	*nattrs = n;
+}
+
+/*
+ * The type a value of type typid is hashed as, the same way as the hash
+ * filter of a Result node does it.
+ */
+static Oid
+hash_type_of(Oid typid)
+{
+	if (get_typtype(typid) == 'd')
+		typid = getBaseType(typid);
+
+	switch (typid)
+	{
+		case INT2ARRAYOID:
+		case INT4ARRAYOID:
+		case INT8ARRAYOID:
+		case FLOAT4ARRAYOID:
+		case FLOAT8ARRAYOID:
+		case REGTYPEARRAYOID:
+			return ANYARRAYOID;
+		default:
+			return typid;
+	}
+}
+
+/*
+ * gp_hash_target_segment(record, int2[]) => int4
+ *
+ * The segment a row belongs on, if its table is distributed by the given
+ * attributes. Called with the whole row of a table, t.*.
+ */
+Datum
+gp_hash_target_segment(PG_FUNCTION_ARGS)
+{
+	HeapTupleHeader rec = PG_GETARG_HEAPTUPLEHEADER(0);
+	ArrayType  *array = PG_GETARG_ARRAYTYPE_P(1);
+	CdbHash    *hash;
+	AttrNumber *attrs;
+	int			nattrs;
+	TupleDesc	tupdesc;
+	HeapTupleData tuple;
+	int			i;
+
+	/* Keep the CdbHash across calls, it is the same for every row */
+	hash = (CdbHash *) fcinfo->flinfo->fn_extra;
+	if (hash == NULL)
+	{
+		MemoryContext oldcontext;
+
+		oldcontext = MemoryContextSwitchTo(fcinfo->flinfo->fn_mcxt);
+		hash = makeCdbHash(GpIdentity.numsegments);
+		MemoryContextSwitchTo(oldcontext);
+
+		fcinfo->flinfo->fn_extra = hash;
+	}
+
+	extract_policy_attrs(array, &nattrs, &attrs);
+
+	tupdesc = lookup_rowtype_tupdesc(HeapTupleHeaderGetTypeId(rec),
+									 HeapTupleHeaderGetTypMod(rec));
+
+	tuple.t_len = HeapTupleHeaderGetDatumLength(rec);
+	ItemPointerSetInvalid(&(tuple.t_self));
+	tuple.t_data = rec;
+
+	cdbhashinit(hash);
+	for (i = 0; i < nattrs; i++)
+	{
+		AttrNumber	attnum = attrs[i];
+		Datum		value;
+		bool		isnull;
+
+		if (attnum <= 0 || attnum > tupdesc->natts ||
+			tupdesc->attrs[attnum - 1]->attisdropped)
+			ereport(ERROR,
+					(errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+					 errmsg("distribution key attribute %d does not exist in the row",
+							attnum)));
+
+		value = heap_getattr(&tuple, attnum, tupdesc, &isnull);
+		if (isnull)
+			cdbhashnull(hash);
+		else
+			cdbhash(hash, value,
+					hash_type_of(tupdesc->attrs[attnum - 1]->atttypid));
+	}
+
+	ReleaseTupleDesc(tupdesc);
+
+	PG_RETURN_INT32(cdbhashreduce(hash));
+}
+
+/*
+ * Build the hash policy rel is to be distributed by, from the attribute
+ * numbers in array.
+ */
+static GpPolicy *
+make_key_policy(Relation rel, ArrayType *array)
+{
+	TupleDesc	tupdesc = RelationGetDescr(rel);
+	GpPolicy   *policy;
+	AttrNumber *attrs;
+	int			nattrs;
+	int			i;
+
+	extract_policy_attrs(array, &nattrs, &attrs);
+
+	policy = (GpPolicy *) palloc(SizeOfGpPolicy(nattrs));
+	policy->ptype = POLICYTYPE_PARTITIONED;
+	policy->nattrs = nattrs;
+
+	for (i = 0; i < nattrs; i++)
+	{
+		AttrNumber	attnum = attrs[i];
+
+		if (attnum <= 0 || attnum > tupdesc->natts ||
+			tupdesc->attrs[attnum - 1]->attisdropped)
+			ereport(ERROR,
+					(errcode(ERRCODE_UNDEFINED_COLUMN),
+					 errmsg("attribute %d of relation \"%s\" does not exist",
+							attnum, RelationGetRelationName(rel))));
+
+		if (!isGreenplumDbHashable(tupdesc->attrs[attnum - 1]->atttypid))
+			ereport(ERROR,
+					(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+					 errmsg("type of column \"%s\" can not be part of a distribution key",
+							NameStr(tupdesc->attrs[attnum - 1]->attname))));
+
+		policy->attrs[i] = attnum;
+	}
+
+	return policy;
+}
+
+/*
+ * Open a table that is being redistributed: a randomly distributed table,
+ * not the root of a partitioned table, owned by the current user.
+ *
+ * The ExclusiveLock keeps writers out until the end of the transaction, so
+ * that no row is misplaced while we move rows, but lets readers in.
+ */
+static Relation
+open_expanding_relation(Oid relid)
+{
+	Relation	rel;
+
+	if (Gp_role != GP_ROLE_DISPATCH)
+		ereport(ERROR,
+				(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+				 errmsg("tables can only be redistributed from the master")));
+
+	rel = heap_open(relid, ExclusiveLock);
+
+	if (!pg_class_ownercheck(relid, GetUserId()))
+		aclcheck_error(ACLCHECK_NOT_OWNER, ACL_KIND_CLASS,
+					   RelationGetRelationName(rel));
+
+	if (rel->rd_rel->relkind != RELKIND_RELATION ||
+		RelationIsExternal(rel) ||
+		rel->rd_cdbpolicy == NULL ||
+		rel->rd_cdbpolicy->ptype != POLICYTYPE_PARTITIONED)
+		ereport(ERROR,
+				(errcode(ERRCODE_WRONG_OBJECT_TYPE),
+				 errmsg("\"%s\" is not a distributed table",
+						RelationGetRelationName(rel))));
+
+	if (rel->rd_cdbpolicy->nattrs != 0)
+		ereport(ERROR,
+				(errcode(ERRCODE_OBJECT_NOT_IN_PREREQUISITE_STATE),
+				 errmsg("table \"%s\" is not distributed randomly",
+						RelationGetRelationName(rel)),
+				 errhint("Only tables that gpexpand has set to DISTRIBUTED RANDOMLY can be redistributed online.")));
+
+	if (rel_is_partitioned(relid))
+		ereport(ERROR,
+				(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+				 errmsg("cannot redistribute the root of partitioned table \"%s\" online",
+						RelationGetRelationName(rel)),
+				 errhint("Redistribute its leaf partitions.")));
+
+	return rel;
+}
+
+/*
+ * Change the distribution policy of rel, in the catalog and in its relcache
+ * entry, like ALTER TABLE SET DISTRIBUTED BY does. The relcache is also
+ * invalidated, so that it is rebuilt from the catalog if we abort.
+ */
+static void
+set_relation_policy(Relation rel, GpPolicy *policy)
+{
+	GpPolicyReplace(RelationGetRelid(rel), policy);
+	rel->rd_cdbpolicy = GpPolicyCopy(GetMemoryChunkContext(rel), policy);
+	CacheInvalidateRelcache(rel);
+
+	CommandCounterIncrement();
+}
+
+/*
+ * Move the rows of rel that policy puts on segment segindex, or on any
+ * segment if segindex is -1, but are stored on another one. Returns the
+ * number of rows moved.
+ */
+static int64
+move_misplaced_rows(Relation rel, GpPolicy *policy, int segindex)
+{
+	TupleDesc	tupdesc = RelationGetDescr(rel);
+	GpPolicy   *random_policy = GpPolicyCopy(CurrentMemoryContext, rel->rd_cdbpolicy);
+	char	   *relname;
+	char		stagename[NAMEDATALEN];
+	StringInfoData keys;
+	StringInfoData attrs;
+	StringInfoData pred;
+	StringInfoData sql;
+	bool		save_optimizer = optimizer;
+	int64		moved = 0;
+	int			i;
+
+	relname = quote_qualified_identifier(get_namespace_name(RelationGetNamespace(rel)),
+										 RelationGetRelationName(rel));
+	snprintf(stagename, sizeof(stagename), "gp_expand_stage_%u",
+			 RelationGetRelid(rel));
+
+	initStringInfo(&keys);
+	initStringInfo(&attrs);
+	for (i = 0; i < policy->nattrs; i++)
+	{
+		Form_pg_attribute attr = tupdesc->attrs[policy->attrs[i] - 1];
+
+		appendStringInfo(&keys, "%s%s", i > 0 ? ", " : "",
+						 quote_identifier(NameStr(attr->attname)));
+		appendStringInfo(&attrs, "%s%d", i > 0 ? "," : "", policy->attrs[i]);
+	}
+
+	initStringInfo(&pred);
+	if (segindex >= 0)
+		appendStringInfo(&pred,
+						 "pg_catalog.gp_hash_target_segment(t.*, '{%s}'::int2[]) = %d "
+						 "AND t.gp_segment_id <> %d",
+						 attrs.data, segindex, segindex);
+	else
+		appendStringInfo(&pred,
+						 "pg_catalog.gp_hash_target_segment(t.*, '{%s}'::int2[]) "
+						 "<> t.gp_segment_id",
+						 attrs.data);
+
+	initStringInfo(&sql);
+
+	if (SPI_connect() != SPI_OK_CONNECT)
+		elog(ERROR, "SPI_connect failed");
+
+	/*
+	 * As in ALTER TABLE SET DISTRIBUTED BY, the legacy planner is used, as
+	 * we rely on how it places the rows of an INSERT ... SELECT.
+	 */
+	optimizer = false;
+
+	PG_TRY();
+	{
+		/* Send the misplaced rows to their segments */
+		appendStringInfo(&sql,
+						 "CREATE TEMP TABLE %s AS SELECT * FROM ONLY %s t WHERE %s "
+						 "DISTRIBUTED BY (%s)",
+						 quote_identifier(stagename), relname, pred.data, keys.data);
+		if (SPI_execute(sql.data, false, 0) < 0)
+			elog(ERROR, "could not stage the misplaced rows of \"%s\"",
+				 RelationGetRelationName(rel));
+
+		resetStringInfo(&sql);
+		appendStringInfo(&sql, "DELETE FROM ONLY %s t WHERE %s",
+						 relname, pred.data);
+		if (SPI_execute(sql.data, false, 0) != SPI_OK_DELETE)
+			elog(ERROR, "could not delete the misplaced rows of \"%s\"",
+				 RelationGetRelationName(rel));
+		moved = SPI_processed;
+
+		/*
+		 * With the table distributed like the staged rows, the INSERT needs
+		 * no motion, and each row is stored on the segment it was sent to.
+		 */
+		if (moved > 0)
+		{
+			set_relation_policy(rel, policy);
+
+			resetStringInfo(&sql);
+			appendStringInfo(&sql, "INSERT INTO %s SELECT * FROM %s",
+							 relname, quote_identifier(stagename));
+			if (SPI_execute(sql.data, false, 0) != SPI_OK_INSERT)
+				elog(ERROR, "could not insert the misplaced rows of \"%s\"",
+					 RelationGetRelationName(rel));
+
+			if (SPI_processed != moved)
+				elog(ERROR, "moved " INT64_FORMAT " rows of \"%s\", but deleted " INT64_FORMAT,
+					 (int64) SPI_processed, RelationGetRelationName(rel), moved);
+
+			set_relation_policy(rel, random_policy);
+		}
+
+		resetStringInfo(&sql);
+		appendStringInfo(&sql, "DROP TABLE %s", quote_identifier(stagename));
+		if (SPI_execute(sql.data, false, 0) < 0)
+			elog(ERROR, "could not drop \"%s\"", stagename);
+
+		optimizer = save_optimizer;
+	}
+	PG_CATCH();
+	{
+		optimizer = save_optimizer;
+		PG_RE_THROW();
+	}
+	PG_END_TRY();
+
+	SPI_finish();
+
+	pfree(sql.data);
+	pfree(pred.data);
+	pfree(attrs.data);
+	pfree(keys.data);
+
+	return moved;
+}
+
+/*
+ * gp_expand_redistribute(regclass, int2[], int4) => int8
+ *
+ * Move the rows of a randomly distributed table that belong on segment
+ * segindex when it is distributed by the given attributes, and return how
+ * many were moved.
+ */
+Datum
+gp_expand_redistribute(PG_FUNCTION_ARGS)
+{
+	Oid			relid = PG_GETARG_OID(0);
+	ArrayType  *array = PG_GETARG_ARRAYTYPE_P(1);
+	int32		segindex = PG_GETARG_INT32(2);
+	Relation	rel;
+	GpPolicy   *policy;
+	int64		moved;
+
+	if (segindex < 0 || segindex >= GpIdentity.numsegments)
+		ereport(ERROR,
+				(errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+				 errmsg("segment %d does not exist", segindex)));
+
+	rel = open_expanding_relation(relid);
+	policy = make_key_policy(rel, array);
+
+	moved = move_misplaced_rows(rel, policy, segindex);
+
+	heap_close(rel, NoLock);
+
+	PG_RETURN_INT64(moved);
+}
+
+/*
+ * gp_expand_redistribute_finish(regclass, int2[]) => int8
+ *
+ * Move the rows still misplaced, on any segment, and distribute the table
+ * by the given attributes. Returns the number of rows moved.
+ */
+Datum
+gp_expand_redistribute_finish(PG_FUNCTION_ARGS)
+{
+	Oid			relid = PG_GETARG_OID(0);
+	ArrayType  *array = PG_GETARG_ARRAYTYPE_P(1);
+	Relation	rel;
+	GpPolicy   *policy;
+	int64		moved;
+
+	rel = open_expanding_relation(relid);
+	policy = make_key_policy(rel, array);
+
+	moved = move_misplaced_rows(rel, policy, -1);
+	set_relation_policy(rel, policy);
+
+	heap_close(rel, NoLock);
+
+	PG_RETURN_INT64(moved);
+}
@@ -13,6 +13,15 @@
  *-------------------------------------------------------------------------
  */
 #include "postgres.h"
+
+#ifdef HAVE_SYS_RESOURCE_H
+#include <sys/time.h>
+#include <sys/resource.h>
+#endif
+#ifndef HAVE_GETRUSAGE
+#include "rusagestub.h"
+#endif
+
 #include "portability/instr_time.h"
 
 #include "gp-libpq-fe.h"
@@ -20,11 +29,13 @@
 #include "cdb/cdbconn.h"		/* SegmentDatabaseDescriptor */
 #include "cdb/cdbdispatchresult.h"	/* CdbDispatchResults */
 #include "cdb/cdbexplain.h"		/* me */
+#include "cdb/cdbinterconnect.h"	/* MotionLayerState */
 #include "cdb/cdbpartition.h"
 #include "cdb/cdbvars.h"		/* Gp_segment */
 #include "executor/execUtils.h"
 #include "executor/instrument.h"	/* Instrumentation */
 #include "lib/stringinfo.h"		/* StringInfo */
+#include "storage/fd.h"			/* FileReadBytes, FileWriteBytes */
 #include "libpq/pqformat.h"		/* pq_beginmessage() etc. */
 #include "utils/memutils.h"		/* MemoryContextGetPeakSpace() */
 #include "cdb/memquota.h"
@@ -112,6 +123,20 @@ typedef struct CdbExplain_SliceWorker
 	double		vmem_reserved;	/* vmem reserved by a QE */
 	double		memory_accounting_global_peak;	/* peak memory observed during
 												 * memory accounting */
+
+	/* Dispatch timing, see CdbExplain_QEDispatchTiming (secs) */
+	TimestampTz dispatchReceivedAt; /* wall clock when the plan came in */
+	double		deserializeTime;
+	double		executorStartTime;
+	double		firstTupleTime; /* from receipt of the plan */
+
+	/* Resource usage, see cdbexplain_startSliceUsage() */
+	double		cpuTime;		/* user + system CPU secs */
+	double		waitTime;		/* elapsed secs not spent on the CPU */
+	double		fileReadBytes;	/* read with FileRead() */
+	double		fileWriteBytes; /* written with FileWrite() */
+	double		netSendBytes;	/* sent by Motions, including headers */
+	double		netRecvBytes;	/* received by Motions, including headers */
 } CdbExplain_SliceWorker;
 
 
@@ -214,6 +239,22 @@ typedef struct CdbExplain_SliceSummary
 
 	/* How many workers were dispatched and returned results? (0 if local) */
 	CdbExplain_DispatchSummary dispatchSummary;
+
+	/* Dispatch timing (secs); dispatchStart is 0 if not dispatched */
+	TimestampTz dispatchStart;	/* when qDisp started sending the slice */
+	double		dispatchSendTime;	/* qDisp time to send the slice */
+	CdbExplain_Agg dispatchRecvTime;	/* dispatchStart until qExec got it */
+	CdbExplain_Agg deserializeTime;
+	CdbExplain_Agg executorStartTime;
+	CdbExplain_Agg firstTupleTime;
+
+	/* Resource usage */
+	CdbExplain_Agg cpuTime;
+	CdbExplain_Agg waitTime;
+	CdbExplain_Agg fileReadBytes;
+	CdbExplain_Agg fileWriteBytes;
+	CdbExplain_Agg netSendBytes;
+	CdbExplain_Agg netRecvBytes;
 } CdbExplain_SliceSummary;
 
 
@@ -231,6 +272,13 @@ typedef struct CdbExplain_ShowStatCtx
 	int			nslice;			/* num of slots in slices array */
 	CdbExplain_SliceSummary *slices;	/* -> array[0..nslice-1] of
 										 * SliceSummary */
+
+	/* qDisp's dispatch timing, summed over the plans dispatched (secs) */
+	bool		dispatched;
+	double		serializeTime;
+	double		compressTime;
+	double		gangAllocTime;
+	double		dispatchWaitTime;
 } CdbExplain_ShowStatCtx;
 
 
@@ -309,6 +357,18 @@ typedef struct CdbExplain_LocalStatCtx
 	CdbExplain_StatHdr *msgptrs[1];
 } CdbExplain_LocalStatCtx;
 
+CdbExplain_QEDispatchTiming cdbexplain_qeDispatchTiming;
+
+/* Where this process's resource usage stood when the slice started */
+static struct
+{
+	bool		valid;
+	struct rusage rusage;
+	instr_time	started;
+	uint64		fileReadBytes;
+	uint64		fileWriteBytes;
+} cdbexplain_sliceUsageStart;
+
 
 static CdbVisitOpt
 			cdbexplain_localStatWalker(PlanState *planstate, void *context);
@@ -329,6 +389,8 @@ static int
 			cdbexplain_collectExtraText(PlanState *planstate, StringInfo notebuf);
 static int
 			cdbexplain_countLeafPartTables(PlanState *planstate);
+static void cdbexplain_showDispatchTiming(CdbExplain_ShowStatCtx *showstatctx,
+							  StringInfo str);
 
 /*
  * Convert the sort method in string to corresponding
@@ -534,14 +596,21 @@ cdbexplain_sendExecStats(QueryDesc *queryDesc)
 	/* Obtain per-slice stats and put them in StatHdr. */
 	cdbexplain_collectSliceStats(planstate, &ctx.hdr.worker);
 
-	/* Append MemoryAccount Tree */
+	/*
+	 * Append MemoryAccount Tree, which is only shown by
+	 * explain_memory_verbosity = detail.
+	 */
 	ctx.hdr.memAccountStartOffset = ctx.buf.len - hoff;
-	initStringInfo(&memoryAccountTreeBuffer);
-	uint		totalSerialized = MemoryAccounting_Serialize(&memoryAccountTreeBuffer);
+	ctx.hdr.memAccountCount = 0;
+	if (EXPLAIN_MEMORY_VERBOSITY_DETAIL <= explain_memory_verbosity)
+	{
+		initStringInfo(&memoryAccountTreeBuffer);
+		uint		totalSerialized = MemoryAccounting_Serialize(&memoryAccountTreeBuffer);
 
-	ctx.hdr.memAccountCount = totalSerialized;
-	appendBinaryStringInfo(&ctx.buf, memoryAccountTreeBuffer.data, memoryAccountTreeBuffer.len);
-	pfree(memoryAccountTreeBuffer.data);
+		ctx.hdr.memAccountCount = totalSerialized;
+		appendBinaryStringInfo(&ctx.buf, memoryAccountTreeBuffer.data, memoryAccountTreeBuffer.len);
+		pfree(memoryAccountTreeBuffer.data);
+	}
 
 	/* Append the extra message text. */
 	ctx.hdr.bnotes = ctx.buf.len - hoff;
@@ -806,9 +875,89 @@ cdbexplain_collectSliceStats(PlanState *planstate,
 
 	out_worker->memory_accounting_global_peak = (double) MemoryAccounting_GetGlobalPeak();
 
+	/* How long it took the qExec to get going, from receipt of the plan. */
+	if (Gp_role == GP_ROLE_EXECUTE)
+	{
+		CdbExplain_QEDispatchTiming *timing = &cdbexplain_qeDispatchTiming;
+
+		out_worker->dispatchReceivedAt = timing->receivedAt;
+		out_worker->deserializeTime = timing->deserializeTime;
+		out_worker->executorStartTime = timing->executorStartTime;
+
+		if (planstate->instrument &&
+			planstate->instrument->nloops > 0 &&
+			!INSTR_TIME_IS_ZERO(timing->runStarted))
+		{
+			instr_time	timediff;
+
+			INSTR_TIME_SET_ZERO(timediff);
+			INSTR_TIME_ACCUM_DIFF(timediff, timing->runStarted, timing->received);
+			out_worker->firstTupleTime = INSTR_TIME_GET_DOUBLE(timediff) +
+				planstate->instrument->startup;
+		}
+	}
+
+	/* What executing the slice cost, to tell CPU-, I/O- and network-bound apart */
+	if (cdbexplain_sliceUsageStart.valid)
+	{
+		struct rusage rusage;
+		instr_time	elapsed;
+		double		elapsedTime;
+
+		getrusage(RUSAGE_SELF, &rusage);
+		out_worker->cpuTime =
+			(rusage.ru_utime.tv_sec - cdbexplain_sliceUsageStart.rusage.ru_utime.tv_sec) +
+			(rusage.ru_utime.tv_usec - cdbexplain_sliceUsageStart.rusage.ru_utime.tv_usec) / 1000000.0 +
+			(rusage.ru_stime.tv_sec - cdbexplain_sliceUsageStart.rusage.ru_stime.tv_sec) +
+			(rusage.ru_stime.tv_usec - cdbexplain_sliceUsageStart.rusage.ru_stime.tv_usec) / 1000000.0;
+
+		INSTR_TIME_SET_CURRENT(elapsed);
+		INSTR_TIME_SUBTRACT(elapsed, cdbexplain_sliceUsageStart.started);
+		elapsedTime = INSTR_TIME_GET_DOUBLE(elapsed);
+		if (elapsedTime > out_worker->cpuTime)
+			out_worker->waitTime = elapsedTime - out_worker->cpuTime;
+
+		out_worker->fileReadBytes = (double)
+			(FileReadBytes - cdbexplain_sliceUsageStart.fileReadBytes);
+		out_worker->fileWriteBytes = (double)
+			(FileWriteBytes - cdbexplain_sliceUsageStart.fileWriteBytes);
+	}
+
+	/* The motion layer's entries are per statement, so need no baseline */
+	if (estate->motionlayer_context)
+	{
+		MotionLayerState *mlStates = (MotionLayerState *) estate->motionlayer_context;
+		int			i;
+
+		for (i = 0; i < mlStates->mneCount; i++)
+		{
+			MotionNodeEntry *pMNEntry = &mlStates->mnEntries[i];
+
+			if (!pMNEntry->valid)
+				continue;
+			out_worker->netSendBytes += (double) pMNEntry->stat_total_bytes_sent;
+			out_worker->netRecvBytes += (double) pMNEntry->stat_total_bytes_recvd;
+		}
+	}
 }								/* cdbexplain_collectSliceStats */
 
 
+/*
+ * cdbexplain_startSliceUsage
+ *	  Note this process's resource usage so far, to be subtracted from its
+ *	  usage when the slice is done.
+ */
+void
+cdbexplain_startSliceUsage(void)
+{
+	getrusage(RUSAGE_SELF, &cdbexplain_sliceUsageStart.rusage);
+	INSTR_TIME_SET_CURRENT(cdbexplain_sliceUsageStart.started);
+	cdbexplain_sliceUsageStart.fileReadBytes = FileReadBytes;
+	cdbexplain_sliceUsageStart.fileWriteBytes = FileWriteBytes;
+	cdbexplain_sliceUsageStart.valid = true;
+}								/* cdbexplain_startSliceUsage */
+
+
 /*
  * cdbexplain_depositSliceStats
  *	  Transfer a worker's per-slice stats contribution from StatHdr into the
@@ -890,6 +1039,29 @@ cdbexplain_depositSliceStats(CdbExplain_StatHdr *hdr,
 	cdbexplain_agg_upd(&ss->vmem_reserved, hdr->worker.vmem_reserved, hdr->segindex);
 	cdbexplain_agg_upd(&ss->memory_accounting_global_peak, hdr->worker.memory_accounting_global_peak, hdr->segindex);
 
+	/* Rollup of dispatch timing */
+	if (ss->dispatchStart != 0 && hdr->worker.dispatchReceivedAt != 0)
+	{
+		long		secs;
+		int			usecs;
+
+		/* Reads as zero, and is left out, if the qExec's clock is behind. */
+		TimestampDifference(ss->dispatchStart, hdr->worker.dispatchReceivedAt,
+							&secs, &usecs);
+		cdbexplain_agg_upd(&ss->dispatchRecvTime, secs + usecs / 1000000.0, hdr->segindex);
+	}
+	cdbexplain_agg_upd(&ss->deserializeTime, hdr->worker.deserializeTime, hdr->segindex);
+	cdbexplain_agg_upd(&ss->executorStartTime, hdr->worker.executorStartTime, hdr->segindex);
+	cdbexplain_agg_upd(&ss->firstTupleTime, hdr->worker.firstTupleTime, hdr->segindex);
+
+	/* Rollup of resource usage */
+	cdbexplain_agg_upd(&ss->cpuTime, hdr->worker.cpuTime, hdr->segindex);
+	cdbexplain_agg_upd(&ss->waitTime, hdr->worker.waitTime, hdr->segindex);
+	cdbexplain_agg_upd(&ss->fileReadBytes, hdr->worker.fileReadBytes, hdr->segindex);
+	cdbexplain_agg_upd(&ss->fileWriteBytes, hdr->worker.fileWriteBytes, hdr->segindex);
+	cdbexplain_agg_upd(&ss->netSendBytes, hdr->worker.netSendBytes, hdr->segindex);
+	cdbexplain_agg_upd(&ss->netRecvBytes, hdr->worker.netRecvBytes, hdr->segindex);
+
 	/* Rollup of per-node stats over all nodes of the slice into SliceSummary */
 	ss->workmemused_max = recvstatctx->workmemused_max;
 	ss->workmemwanted_max = recvstatctx->workmemwanted_max;
@@ -1456,6 +1628,9 @@ cdbexplain_showExecStatsBegin(struct QueryDesc *queryDesc,
 	/* Allocate a buffer in which we can collect any extra message text. */
 	initStringInfoOfSize(&ctx->extratextbuf, 4000);
 
+	/* The root slice runs here; measure its resource usage from now */
+	cdbexplain_startSliceUsage();
+
 	return ctx;
 }								/* cdbexplain_showExecStatsBegin */
 
@@ -1954,6 +2129,257 @@ cdbexplain_showExecStats(struct PlanState *planstate,
 }								/* cdbexplain_showExecStats */
 
 
+/*
+ * cdbexplain_recordSerializeTime
+ *	  Called by qDisp to note the time spent serializing and compressing a
+ *	  plan for dispatch.
+ */
+void
+cdbexplain_recordSerializeTime(struct CdbExplain_ShowStatCtx *ctx,
+							   double serializeTime, double compressTime)
+{
+	if (ctx == NULL)
+		return;
+
+	ctx->dispatched = true;
+	ctx->serializeTime += serializeTime;
+	ctx->compressTime += compressTime;
+}								/* cdbexplain_recordSerializeTime */
+
+
+/*
+ * cdbexplain_recordGangAllocTime
+ *	  Called by qDisp to note the time spent allocating gangs for a query.
+ */
+void
+cdbexplain_recordGangAllocTime(struct CdbExplain_ShowStatCtx *ctx,
+							   double gangAllocTime)
+{
+	if (ctx == NULL)
+		return;
+
+	ctx->dispatched = true;
+	ctx->gangAllocTime += gangAllocTime;
+}								/* cdbexplain_recordGangAllocTime */
+
+
+/*
+ * cdbexplain_recordSliceDispatch
+ *	  Called by qDisp to note when it started sending a slice to its gang,
+ *	  and how long that took.
+ */
+void
+cdbexplain_recordSliceDispatch(struct CdbExplain_ShowStatCtx *ctx,
+							   int sliceIndex, TimestampTz sendStart,
+							   double sendTime)
+{
+	CdbExplain_SliceSummary *ss;
+
+	if (ctx == NULL || sliceIndex < 0 || sliceIndex >= ctx->nslice)
+		return;
+
+	ss = &ctx->slices[sliceIndex];
+	ss->dispatchStart = sendStart;
+	ss->dispatchSendTime = sendTime;
+	ctx->dispatched = true;
+}								/* cdbexplain_recordSliceDispatch */
+
+
+/*
+ * cdbexplain_recordDispatchWaitTime
+ *	  Called by qDisp to note the time spent waiting for a dispatched plan
+ *	  to be sent out completely.
+ */
+void
+cdbexplain_recordDispatchWaitTime(struct CdbExplain_ShowStatCtx *ctx,
+								  double waitTime)
+{
+	if (ctx == NULL)
+		return;
+
+	ctx->dispatched = true;
+	ctx->dispatchWaitTime += waitTime;
+}								/* cdbexplain_recordDispatchWaitTime */
+
+
+/*
+ * cdbexplain_showDispatchAgg
+ *	  Format a dispatch timing statistic of a slice's workers.
+ */
+static void
+cdbexplain_showDispatchAgg(StringInfo str, const char *label,
+						   CdbExplain_Agg *agg, int nworker)
+{
+	char		avgbuf[50];
+	char		maxbuf[50];
+	char		segbuf[50];
+
+	if (agg->vcnt == 0)
+		return;
+
+	cdbexplain_formatSeconds(maxbuf, sizeof(maxbuf), agg->vmax);
+	if (agg->vcnt == 1)
+	{
+		cdbexplain_formatSeg(segbuf, sizeof(segbuf), agg->imax, 999);
+		appendStringInfo(str, "  %s: %s%s.", label, maxbuf, segbuf);
+	}
+	else
+	{
+		cdbexplain_formatSeconds(avgbuf, sizeof(avgbuf), cdbexplain_agg_avg(agg));
+		cdbexplain_formatSeg(segbuf, sizeof(segbuf), agg->imax, nworker);
+		appendStringInfo(str, "  %s: %s avg x %d workers, %s max%s.",
+						 label, avgbuf, agg->vcnt, maxbuf, segbuf);
+	}
+}								/* cdbexplain_showDispatchAgg */
+
+
+/*
+ * cdbexplain_showDispatchTiming
+ *	  Format where the time went in dispatching the query: on the qDisp,
+ *	  serializing and compressing the plan, allocating gangs and sending
+ *	  each slice; on the qExecs, receiving, deserializing and starting the
+ *	  plan, and producing the slice's first tuple.
+ *
+ * "Receive" is measured from the qDisp's clock to the qExec's, so it is
+ * only as accurate as the hosts' clocks are in sync.  "First tuple" is from
+ * the qExec's receipt of the plan.
+ */
+static void
+cdbexplain_showDispatchTiming(CdbExplain_ShowStatCtx *showstatctx,
+							  StringInfo str)
+{
+	char		serializebuf[50];
+	char		compressbuf[50];
+	char		gangbuf[50];
+	char		waitbuf[50];
+	int			sliceIndex;
+
+	if (!showstatctx->dispatched)
+		return;
+
+	cdbexplain_formatSeconds(serializebuf, sizeof(serializebuf), showstatctx->serializeTime);
+	cdbexplain_formatSeconds(compressbuf, sizeof(compressbuf), showstatctx->compressTime);
+	cdbexplain_formatSeconds(gangbuf, sizeof(gangbuf), showstatctx->gangAllocTime);
+	cdbexplain_formatSeconds(waitbuf, sizeof(waitbuf), showstatctx->dispatchWaitTime);
+
+	appendStringInfoString(str, "Dispatch timing:\n");
+	appendStringInfo(str,
+					 "  (plan)      Serialize: %s.  Compress: %s.  Gang allocation: %s.  Send wait: %s.\n",
+					 serializebuf, compressbuf, gangbuf, waitbuf);
+
+	for (sliceIndex = 0; sliceIndex < showstatctx->nslice; sliceIndex++)
+	{
+		CdbExplain_SliceSummary *ss = &showstatctx->slices[sliceIndex];
+		char		sendbuf[50];
+
+		if (ss->dispatchStart == 0)
+			continue;
+
+		appendStringInfo(str, "  (slice%d) ", sliceIndex);
+		if (sliceIndex < 10)
+			appendStringInfoChar(str, ' ');
+
+		cdbexplain_formatSeconds(sendbuf, sizeof(sendbuf), ss->dispatchSendTime);
+		appendStringInfo(str, "  Send: %s.", sendbuf);
+
+		cdbexplain_showDispatchAgg(str, "Receive", &ss->dispatchRecvTime, ss->nworker);
+		cdbexplain_showDispatchAgg(str, "Deserialize", &ss->deserializeTime, ss->nworker);
+		cdbexplain_showDispatchAgg(str, "ExecutorStart", &ss->executorStartTime, ss->nworker);
+		cdbexplain_showDispatchAgg(str, "First tuple", &ss->firstTupleTime, ss->nworker);
+
+		appendStringInfoChar(str, '\n');
+	}
+}								/* cdbexplain_showDispatchTiming */
+
+
+/*
+ * cdbexplain_showUsageAgg
+ *	  Format a slice's resource usage statistic, summarized over its
+ *	  workers, using 'format' for the values.
+ */
+static void
+cdbexplain_showUsageAgg(StringInfo str, const char *label,
+						CdbExplain_Agg *agg, int nworker,
+						void (*format) (char *outbuf, int bufsize, double value))
+{
+	char		minbuf[50];
+	char		avgbuf[50];
+	char		maxbuf[50];
+	char		segbuf[50];
+
+	if (agg->vcnt == 0)
+		return;
+
+	format(maxbuf, sizeof(maxbuf), agg->vmax);
+	if (agg->vcnt == 1)
+	{
+		cdbexplain_formatSeg(segbuf, sizeof(segbuf), agg->imax, 999);
+		appendStringInfo(str, "  %s: %s%s.", label, maxbuf, segbuf);
+	}
+	else
+	{
+		format(minbuf, sizeof(minbuf), agg->vmin);
+		format(avgbuf, sizeof(avgbuf), cdbexplain_agg_avg(agg));
+		cdbexplain_formatSeg(segbuf, sizeof(segbuf), agg->imax, nworker);
+		appendStringInfo(str, "  %s: %s min, %s avg x %d workers, %s max%s.",
+						 label, minbuf, avgbuf, agg->vcnt, maxbuf, segbuf);
+	}
+}								/* cdbexplain_showUsageAgg */
+
+
+/*
+ * cdbexplain_showResourceUsage
+ *	  Format what each slice's workers spent executing it: time on and off
+ *	  the CPU, bytes read and written through fd.c, and bytes sent and
+ *	  received by Motions.  A slice that spent its time waiting, with much
+ *	  file or Motion I/O, is I/O- or network-bound rather than CPU-bound.
+ *
+ * Only workers with a nonzero value are counted in each statistic.
+ */
+static void
+cdbexplain_showResourceUsage(CdbExplain_ShowStatCtx *showstatctx,
+							 StringInfo str)
+{
+	bool		header = false;
+	int			sliceIndex;
+
+	for (sliceIndex = 0; sliceIndex < showstatctx->nslice; sliceIndex++)
+	{
+		CdbExplain_SliceSummary *ss = &showstatctx->slices[sliceIndex];
+
+		if (ss->cpuTime.vcnt + ss->waitTime.vcnt +
+			ss->fileReadBytes.vcnt + ss->fileWriteBytes.vcnt +
+			ss->netSendBytes.vcnt + ss->netRecvBytes.vcnt == 0)
+			continue;
+
+		if (!header)
+		{
+			appendStringInfoString(str, "Slice resource usage:\n");
+			header = true;
+		}
+
+		appendStringInfo(str, "  (slice%d) ", sliceIndex);
+		if (sliceIndex < 10)
+			appendStringInfoChar(str, ' ');
+
+		cdbexplain_showUsageAgg(str, "CPU", &ss->cpuTime, ss->nworker,
+								cdbexplain_formatSeconds);
+		cdbexplain_showUsageAgg(str, "Wait", &ss->waitTime, ss->nworker,
+								cdbexplain_formatSeconds);
+		cdbexplain_showUsageAgg(str, "File read", &ss->fileReadBytes, ss->nworker,
+								cdbexplain_formatMemory);
+		cdbexplain_showUsageAgg(str, "File written", &ss->fileWriteBytes, ss->nworker,
+								cdbexplain_formatMemory);
+		cdbexplain_showUsageAgg(str, "Motion sent", &ss->netSendBytes, ss->nworker,
+								cdbexplain_formatMemory);
+		cdbexplain_showUsageAgg(str, "Motion received", &ss->netRecvBytes, ss->nworker,
+								cdbexplain_formatMemory);
+
+		appendStringInfoChar(str, '\n');
+	}
+}								/* cdbexplain_showResourceUsage */
+
+
 /*
  * cdbexplain_showExecStatsEnd
  *	  Called by qDisp process to format the overall statistics for a query
@@ -2193,6 +2619,9 @@ cdbexplain_showExecStatsEnd(struct PlannedStmt *stmt,
 		appendStringInfo(str, "Total memory used across slices: %.0fK bytes \n", total_memory_across_slices);
 	}
 
+	cdbexplain_showDispatchTiming(showstatctx, str);
+	cdbexplain_showResourceUsage(showstatctx, str);
+
 	if (!IsResManagerMemoryPolicyNone())
 	{
 		appendStringInfoString(str, "Statement statistics:\n");
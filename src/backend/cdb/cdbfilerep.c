@@ -431,6 +431,15 @@ int			file_rep_min_data_before_flush = 128 * 1024;
  */
 int			file_rep_socket_timeout = 10;
 
+/*
+ * GUC parameter
+ *          file_rep_compress_messages
+ *
+ * Compress messages shipped between primary and mirror with LZ4 (when the
+ * server is built with LZ4 support).
+ */
+bool		file_rep_compress_messages = false;
+
 FileRepShmem_s *fileRepShmemArray[FILEREP_SHMEM_MAX_SLOTS];
 FileRepShmem_s *fileRepAckShmemArray[FILEREP_ACKSHMEM_MAX_SLOTS];
 
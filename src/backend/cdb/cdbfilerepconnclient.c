@@ -29,8 +29,28 @@
 #include "gp-libpq-int.h"
 #include "cdb/cdbfilerepservice.h"
 
+#ifdef HAVE_LIBLZ4
+#include <lz4.h>
+#endif
+
+/*
+ * Messages shorter than this are never compressed; control messages
+ * carry no body and would not shrink.
+ */
+#define FILEREP_COMPRESS_MIN_LENGTH		1024
+
 static PGconn *filerep_conn = NULL;
 
+#ifdef HAVE_LIBLZ4
+/* scratch buffer holding the compressed form of the message being sent */
+static char *compressBuffer = NULL;
+static int	compressBufferSize = 0;
+
+static int	FileRepConnClient_CompressMessage(char *message, uint32 messageLength);
+#endif
+
+static bool FileRepConnClient_Flush(void);
+
 /*
  *
  */
@@ -115,31 +135,56 @@ FileRepConnClient_CloseConnection(void)
  * Data Message has msg_type='M'.
  * Data Message is inserted in Shared memory and consumed by Consumer
  * thread on mirror side.
+ *
+ * With filerep_compress_messages on, a data message large enough to be
+ * worth it is sent LZ4 compressed, with msg_type 'l', 'a' or 'w' instead of
+ * '1', '2' or '3'; its body is the uncompressed length followed by the
+ * compressed message.
+ *
+ * The message is only buffered, unless flushNow is set or enough data has
+ * accumulated; see FileRepConnClient_FlushMessages().
  */
 bool
 FileRepConnClient_SendMessage(
 							  FileRepConsumerProcIndex_e messageType,
-							  bool messageSynchronous,
+							  bool flushNow,
 							  char *message,
 							  uint32 messageLength)
 {
 	char		msgType = 0;
-	int			status = STATUS_OK;
+	bool		compressed = false;
+	uint32		payloadLength = messageLength;
 
 #ifdef USE_ASSERT_CHECKING
 	int			prevOutCount = filerep_conn->outCount;
 #endif							/* // USE_ASSERT_CHECKING */
 
+#ifdef HAVE_LIBLZ4
+	if (file_rep_compress_messages &&
+		messageType != FileRepMessageTypeShutdown &&
+		messageLength >= FILEREP_COMPRESS_MIN_LENGTH)
+	{
+		int			compressedLength;
+
+		compressedLength = FileRepConnClient_CompressMessage(message, messageLength);
+		if (compressedLength > 0)
+		{
+			compressed = true;
+			payloadLength = sizeof(uint32) + compressedLength;
+		}
+	}
+#endif
+
 	switch (messageType)
 	{
 		case FileRepMessageTypeXLog:
-			msgType = '1';
+			msgType = compressed ? 'l' : '1';
 			break;
 		case FileRepMessageTypeAO01:
-			msgType = '2';
+			msgType = compressed ? 'a' : '2';
 			break;
 		case FileRepMessageTypeWriter:
-			msgType = '3';
+			msgType = compressed ? 'w' : '3';
 			break;
 		case FileRepMessageTypeShutdown:
 			msgType = 'S';
@@ -157,6 +202,17 @@ FileRepConnClient_SendMessage(
 		return false;
 	}
 
+#ifdef HAVE_LIBLZ4
+	if (compressed)
+	{
+		if (pqPutInt(messageLength, sizeof(uint32), filerep_conn) < 0 ||
+			pqPutnchar(compressBuffer, payloadLength - sizeof(uint32), filerep_conn) < 0)
+		{
+			return false;
+		}
+	}
+	else
+#endif
 	if (pqPutnchar(message, messageLength, filerep_conn) < 0)
 	{
 		return false;
@@ -169,7 +225,7 @@ FileRepConnClient_SendMessage(
 	pqPutMsgEndNoAutoFlush(filerep_conn);
 
 	/* assert that a flush did not occur */
-	Assert(prevOutCount + messageLength + 5 == filerep_conn->outCount); /* the +5 is the amount
+	Assert(prevOutCount + payloadLength + 5 == filerep_conn->outCount); /* the +5 is the amount
 																		 * added by
 																		 * pgPutMsgStart */
 
@@ -177,46 +233,96 @@ FileRepConnClient_SendMessage(
 	 * note also that we could do a flush beforehand to avoid having
 	 * pqPutMsgStart and pqPutnchar growing the buffer
 	 */
-	if (messageSynchronous || filerep_conn->outCount >= file_rep_min_data_before_flush)
-	{
-		int			result = 0;
+	if (flushNow || filerep_conn->outCount >= file_rep_min_data_before_flush)
+		return FileRepConnClient_Flush();
 
-		/* wait and timeout will be handled by pqWaitTimeout */
-		while ((status = pqFlushNonBlocking(filerep_conn)) > 0)
-		{
-			/* retry on timeout */
-			while (!(result = pqWaitTimeout(FALSE, TRUE, filerep_conn, time(NULL) + file_rep_socket_timeout)))
-			{
-				if (FileRepSubProcess_IsStateTransitionRequested())
-				{
-					elog(WARNING, "segment state transition requested while waiting to write data to socket");
-					status = -1;
-					break;
-				}
-			}
+	return true;
+}
+
+/*
+ * Send all buffered messages to the mirror.
+ *
+ * The sender defers the flush of a synchronous message while more messages
+ * are already queued behind it, so that a group of them goes out in one
+ * write; it calls this before it waits for the next message.
+ */
+bool
+FileRepConnClient_FlushMessages(void)
+{
+	if (filerep_conn == NULL || filerep_conn->outCount == 0)
+		return true;
+
+	return FileRepConnClient_Flush();
+}
 
-			if (result < 0)
+static bool
+FileRepConnClient_Flush(void)
+{
+	int			status = STATUS_OK;
+	int			result = 0;
+
+	/* wait and timeout will be handled by pqWaitTimeout */
+	while ((status = pqFlushNonBlocking(filerep_conn)) > 0)
+	{
+		/* retry on timeout */
+		while (!(result = pqWaitTimeout(FALSE, TRUE, filerep_conn, time(NULL) + file_rep_socket_timeout)))
+		{
+			if (FileRepSubProcess_IsStateTransitionRequested())
 			{
-				ereport(WARNING,
-						(errcode_for_socket_access(),
-						 errmsg("could not write data to socket, failure detected : %m")));
+				elog(WARNING, "segment state transition requested while waiting to write data to socket");
 				status = -1;
 				break;
 			}
+		}
 
-			if (status == -1)
-			{
-				break;
-			}
+		if (result < 0)
+		{
+			ereport(WARNING,
+					(errcode_for_socket_access(),
+					 errmsg("could not write data to socket, failure detected : %m")));
+			status = -1;
+			break;
 		}
 
-		if (status < 0)
+		if (status == -1)
 		{
-			return false;
+			break;
 		}
-		Assert(status == 0);
-		return true;
 	}
 
+	if (status < 0)
+	{
+		return false;
+	}
+	Assert(status == 0);
 	return true;
 }
+
+#ifdef HAVE_LIBLZ4
+/*
+ * Compress the message into compressBuffer.  Returns the compressed length,
+ * or 0 if compression would not save anything.
+ */
+static int
+FileRepConnClient_CompressMessage(char *message, uint32 messageLength)
+{
+	int			bound = LZ4_compressBound(messageLength);
+
+	if (bound > compressBufferSize)
+	{
+		if (compressBuffer)
+			pfree(compressBuffer);
+		compressBuffer = MemoryContextAlloc(TopMemoryContext, bound);
+		compressBufferSize = bound;
+	}
+
+	/*
+	 * Leave room for the uncompressed length; a message that does not shrink
+	 * below its own size is sent as is.
+	 */
+	return LZ4_compress_default(message,
+								compressBuffer,
+								messageLength,
+								messageLength - sizeof(uint32) - 1);
+}
+#endif
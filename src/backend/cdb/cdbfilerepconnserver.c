@@ -31,9 +31,28 @@
 #include "libpq/auth.h"
 #include "libpq/pqformat.h"
 
+#ifdef HAVE_LIBLZ4
+#include <lz4.h>
+#endif
+
 static Port *port;
 static void ConnFree(void);
 
+/*
+ * Whether the message being received was sent compressed, and if so the
+ * length of its compressed form; see FileRepConnClient_SendMessage().
+ * Receivers are not aware of it: the length and data they get back are
+ * those of the uncompressed message.
+ */
+static bool messageCompressed = false;
+static uint32 messageCompressedLength = 0;
+
+#ifdef HAVE_LIBLZ4
+/* scratch buffer the compressed message is received into */
+static char *compressBuffer = NULL;
+static uint32 compressBufferSize = 0;
+#endif
+
 static int	listenSocket[FILEREP_MAX_LISTEN];
 
 /*
@@ -330,6 +349,7 @@ FileRepConnServer_ReceiveMessageType(
 
 	messageType = pq_getbyte();
 
+	messageCompressed = false;
 
 	switch (messageType)
 	{
@@ -346,6 +366,23 @@ FileRepConnServer_ReceiveMessageType(
 			*fileRepMessageType = FileRepMessageTypeWriter;
 			break;
 
+#ifdef HAVE_LIBLZ4
+		case 'l':
+			*fileRepMessageType = FileRepMessageTypeXLog;
+			messageCompressed = true;
+			break;
+
+		case 'a':
+			*fileRepMessageType = FileRepMessageTypeAO01;
+			messageCompressed = true;
+			break;
+
+		case 'w':
+			*fileRepMessageType = FileRepMessageTypeWriter;
+			messageCompressed = true;
+			break;
+#endif
+
 		case 'S':
 			*fileRepMessageType = FileRepMessageTypeShutdown;
 			break;
@@ -407,6 +444,31 @@ FileRepConnServer_ReceiveMessageLength(uint32 *len)
 
 	length -= 4;
 
+	if (messageCompressed)
+	{
+		uint32		rawLength;
+
+		if (length < sizeof(uint32))
+		{
+			ereport(WARNING,
+					(errmsg("receive unexpected message length on connection")));
+			return STATUS_ERROR;
+		}
+
+		/* the uncompressed length precedes the compressed message */
+		if (pq_getbytes((char *) &rawLength, sizeof(uint32)) == EOF)
+		{
+			ereport(WARNING,
+					(errcode_for_socket_access(),
+					 errmsg("receive EOF on connection: %m")));
+
+			return STATUS_ERROR;
+		}
+
+		messageCompressedLength = length - sizeof(uint32);
+		length = ntohl(rawLength);
+	}
+
 	*len = length;
 
 	return STATUS_OK;
@@ -421,8 +483,26 @@ FileRepConnServer_ReceiveMessageData(
 									 char *data,
 									 uint32 length)
 {
+	char	   *buf = data;
+	uint32		bufLength = length;
+
+#ifdef HAVE_LIBLZ4
+	if (messageCompressed)
+	{
+		if (messageCompressedLength > compressBufferSize)
+		{
+			if (compressBuffer)
+				pfree(compressBuffer);
+			compressBuffer = MemoryContextAlloc(TopMemoryContext, messageCompressedLength);
+			compressBufferSize = messageCompressedLength;
+		}
 
-	if (pq_getbytes(data, length) == EOF)
+		buf = compressBuffer;
+		bufLength = messageCompressedLength;
+	}
+#endif
+
+	if (pq_getbytes(buf, bufLength) == EOF)
 	{
 		ereport(WARNING,
 				(errcode_for_socket_access(),
@@ -431,5 +511,16 @@ FileRepConnServer_ReceiveMessageData(
 		return STATUS_ERROR;
 	}
 
+#ifdef HAVE_LIBLZ4
+	if (messageCompressed &&
+		LZ4_decompress_safe(compressBuffer, data, messageCompressedLength, length) != (int) length)
+	{
+		ereport(WARNING,
+				(errmsg("could not decompress message received on connection")));
+
+		return STATUS_ERROR;
+	}
+#endif
+
 	return STATUS_OK;
 }
@@ -1630,6 +1630,9 @@ FileRepPrimary_RunSender(void)
 	FileRepMessageHeader_s *fileRepMessageHeader;
 	FileRepShmem_s *fileRepShmem = fileRepShmemArray[fileRepProcIndex];
 	FileRepConsumerProcIndex_e messageType = FileRepMessageTypeUndefined;
+	bool		nextMessageReady;
+	bool		flushPending = FALSE;
+	bool		flushFailed = FALSE;
 
 	FileRep_InsertConfigLogEntry("run sender");
 
@@ -1670,6 +1673,21 @@ FileRepPrimary_RunSender(void)
 
 			LWLockRelease(FileRepShmemLock);
 
+			/*
+			 * No more messages to group with the buffered ones, send them
+			 * before going to sleep.
+			 */
+			if (flushPending)
+			{
+				flushPending = FALSE;
+				if (!FileRepConnClient_FlushMessages())
+				{
+					flushFailed = TRUE;
+					LWLockAcquire(FileRepShmemLock, LW_EXCLUSIVE);
+					break;
+				}
+			}
+
 			FileRepSubProcess_ProcessSignals();
 			if (FileRepSubProcess_GetState() != FileRepStateReady &&
 				FileRepSubProcess_GetState() != FileRepStateInitialization)
@@ -1695,10 +1713,53 @@ FileRepPrimary_RunSender(void)
 			fileRepShmemMessageDescr =
 				(FileRepShmemMessageDescr_s *) fileRepShmem->positionConsume;
 		}
+		/*
+		 * Group batching: if the next message is already queued, the flush
+		 * of a synchronous message is deferred so that both go out in one
+		 * write.
+		 */
+		nextMessageReady = FALSE;
+		if (!flushFailed && fileRepShmem->positionConsume != fileRepShmem->positionInsert)
+		{
+			char	   *positionNext;
+
+			positionNext = fileRepShmem->positionConsume +
+				fileRepShmemMessageDescr->messageLength +
+				sizeof(FileRepShmemMessageDescr_s);
+
+			if (positionNext == fileRepShmem->positionWraparound &&
+				fileRepShmem->positionInsert != fileRepShmem->positionWraparound)
+			{
+				positionNext = fileRepShmem->positionBegin;
+			}
+
+			nextMessageReady =
+				(positionNext != fileRepShmem->positionInsert &&
+				 ((FileRepShmemMessageDescr_s *) positionNext)->messageState == FileRepShmemMessageStateReady);
+		}
+
 		fileRepShmem->consumeCount++;
 
 		LWLockRelease(FileRepShmemLock);
 
+		if (flushFailed)
+		{
+			if (!primaryMirrorIsIOSuspended())
+			{
+				ereport(WARNING,
+						(errcode_for_socket_access(),
+						 errmsg("mirror failure, "
+								"could not sent messages to mirror local count '%d' : %m, "
+								"failover requested",
+								spare),
+						 errhint("run gprecoverseg to re-establish mirror connectivity"),
+						 FileRep_errdetail_Shmem(),
+						 FileRep_errcontext()));
+			}
+			status = STATUS_ERROR;
+			break;
+		}
+
 		FileRepSubProcess_ProcessSignals();
 		if (FileRepSubProcess_GetState() != FileRepStateReady &&
 			FileRepSubProcess_GetState() != FileRepStateInitialization)
@@ -1781,9 +1842,12 @@ FileRepPrimary_RunSender(void)
 				break;
 		}
 
+		if (fileRepShmemMessageDescr->messageSync)
+			flushPending = nextMessageReady;
+
 		if (!FileRepConnClient_SendMessage(
 										   messageType,
-										   fileRepShmemMessageDescr->messageSync,
+										   fileRepShmemMessageDescr->messageSync && !nextMessageReady,
 										   fileRepMessage,
 										   fileRepShmemMessageDescr->messageLength))
 		{
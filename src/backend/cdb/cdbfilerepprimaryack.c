@@ -377,7 +377,7 @@ FileRepAckPrimary_ShmemSize(void)
 	Size		size;
 
 	size = hash_estimate_size(
-							  (Size) FILEREP_MAX_OPEN_FILES,
+							  (Size) FILEREP_MAX_OUTSTANDING_ACKS,
 							  sizeof(FileRepAckHashEntry_s));
 
 	size = add_size(size, sizeof(FileRepAckHashShmem_s));
@@ -419,8 +419,8 @@ FileRepAckPrimary_ShmemInit(void)
 	hash_ctl.hash = string_hash;
 
 	fileRepAckHashShmem->hash = ShmemInitHash("filerep ack hash",
-											  FILEREP_MAX_OPEN_FILES,
-											  FILEREP_MAX_OPEN_FILES,
+											  FILEREP_MAX_OUTSTANDING_ACKS,
+											  FILEREP_MAX_OUTSTANDING_ACKS,
 											  &hash_ctl,
 											  HASH_ELEM | HASH_FUNCTION);
 
@@ -601,6 +601,7 @@ FileRepAckPrimary_NewHashEntry(
 	int			status = STATUS_OK;
 	int			retry = 0;
 	bool		wait = FALSE;
+	bool		windowFull = FALSE;
 
 	fileName = FileRep_GetFileName(fileRepIdentifier, fileRepRelationType);
 
@@ -617,9 +618,24 @@ FileRepAckPrimary_NewHashEntry(
 			}
 		}
 
-		entry = FileRepAckPrimary_InsertHashEntry(fileName, &exists);
+		/*
+		 * Operations waiting for an ack from the mirror are pipelined, up to
+		 * a window of FILEREP_MAX_OUTSTANDING_ACKS.  Beyond it the backend
+		 * waits for an ack to retire an entry, the same way it waits for an
+		 * entry of the same file, rather than running the ack table out of
+		 * shared memory and failing over.
+		 */
+		windowFull = (hash_get_num_entries(fileRepAckHashShmem->hash) >= FILEREP_MAX_OUTSTANDING_ACKS);
 
-		if (entry == NULL)
+		if (windowFull)
+		{
+			entry = NULL;
+			exists = TRUE;
+		}
+		else
+			entry = FileRepAckPrimary_InsertHashEntry(fileName, &exists);
+
+		if (entry == NULL && !windowFull)
 		{
 			LWLockRelease(FileRepAckHashShmemLock);
 			status = STATUS_ERROR;
@@ -682,8 +698,9 @@ FileRepAckPrimary_NewHashEntry(
 
 		ereport(WARNING,
 				(errmsg("mirror failure, "
-						"could not insert ack entry into ack table, entry exists "
-						"failover requested"),
+						"could not insert ack entry into ack table, %s "
+						"failover requested",
+						windowFull ? "too many outstanding acks" : "entry exists"),
 				 errhint("run gprecoverseg to re-establish mirror connectivity"),
 				 FileRep_errdetail(fileRepIdentifier,
 								   fileRepRelationType,
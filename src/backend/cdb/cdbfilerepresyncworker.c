@@ -184,6 +184,8 @@ FileRepPrimary_RunResyncWorker(void)
 
 	}
 
+	ChangeTracking_FreeDirtyBlockMap();
+
 	return status;
 }
 
@@ -560,19 +562,8 @@ FileRepPrimary_ResyncBufferPoolIncrementalWrite(ChangeTrackingRequest *request)
 
 	while (1)
 	{
-		/*
-		 * ChangeTracking_GetChanges() invokes a SQL query using SPI, which
-		 * could result in dirty buffers being written out.  Setting
-		 * readBufferRequest indicates that these writes are performed on
-		 * primary as well as mirror.  When readBufferRequest flag is unset,
-		 * resync workers send changed blocks only to mirror without writing
-		 * them on primary.
-		 */
-		FileRepResync_SetReadBufferRequest();
 		if ((result = ChangeTracking_GetChanges(request)) != NULL)
 		{
-			FileRepResync_ResetReadBufferRequest();
-
 			for (ii = 0; ii < result->count; ii++)
 			{
 
@@ -658,7 +649,8 @@ FileRepPrimary_ResyncBufferPoolIncrementalWrite(ChangeTrackingRequest *request)
 
 				if (XLByteLE(result->entries[ii].lsn_end, PageGetLSN(page)))
 				{
-					if (!XLByteEQ(PageGetLSN(page), result->entries[ii].lsn_end))
+					if (!XLogRecPtrIsInvalid(result->entries[ii].lsn_end) &&
+						!XLByteEQ(PageGetLSN(page), result->entries[ii].lsn_end))
 					{
 						ereport(LOG,
 								(errmsg("Resynchonize buffer pool relation '%s' block '%d' has page lsn more than CT lsn, "
@@ -792,7 +784,6 @@ FileRepPrimary_ResyncBufferPoolIncrementalWrite(ChangeTrackingRequest *request)
 					count++;
 			}
 		}
-		FileRepResync_ResetReadBufferRequest();
 		if (result == NULL || result->ask_for_more == false)
 			break;
 	}
@@ -48,9 +48,11 @@
 #include "parser/parse_expr.h"
 #include "parser/parse_oper.h"
 #include "parser/parse_relation.h"
+#include "utils/fmgroids.h"
 #include "utils/lsyscache.h"
 #include "utils/selfuncs.h"
 #include "utils/syscache.h"
+#include "utils/typcache.h"
 #include "catalog/pg_aggregate.h"
 
 #include "cdb/cdbllize.h"
@@ -402,6 +404,21 @@ static Cost incremental_motion_cost(double sendrows, double recvrows);
 
 static bool contain_aggfilters(Node *node);
 
+/*
+ * DqaExpandContext is the state of cdb_expand_multi_dqa().  The columns of
+ * the expanded subquery are the grouping expressions, then the tag, then
+ * the distinct DQA arguments.
+ */
+typedef struct DqaExpandContext
+{
+	List	   *groupExprs;		/* grouping expressions */
+	List	   *dqaArgs;		/* distinct DQA arguments */
+	bool		failed;			/* the query can't be rewritten */
+} DqaExpandContext;
+
+static bool dqa_expand_collect_walker(Node *node, DqaExpandContext *ctx);
+static Node *dqa_expand_mutator(Node *node, DqaExpandContext *ctx);
+
 /*---------------------------------------------
  * WITHIN/Percentile stuff
  *---------------------------------------------*/
@@ -7275,3 +7292,367 @@ contain_aggfilters(Node *node)
 {
 	return contain_aggfilters_walker(node, NULL);
 }
+
+
+/*
+ * cdb_expand_multi_dqa
+ *
+ * Rewrite a query with DISTINCT-qualified aggregates on several different
+ * arguments, so that its input is read and deduplicated once, rather than
+ * once per argument by the coplans of make_three_stage_agg_plan():
+ *
+ *		SELECT g, count(DISTINCT a), sum(DISTINCT b) FROM t GROUP BY g
+ *
+ * becomes
+ *
+ *		SELECT g, count(a'), sum(b')
+ *		  FROM (SELECT g, tag,
+ *					   CASE WHEN tag = 0 THEN a END AS a',
+ *					   CASE WHEN tag = 1 THEN b END AS b'
+ *				  FROM t CROSS JOIN (VALUES (0), (1)) AS tags(tag)
+ *				 GROUP BY g, tag, a', b') AS dqa_expand
+ *		 GROUP BY g
+ *
+ * Each input row is expanded into one row per argument, tagged with the
+ * argument's number and carrying only that argument.  The subquery's GROUP
+ * BY, with no aggregates, removes the duplicates of every argument at once
+ * and is planned as a (two-phase) HashAgg.  The outer aggregates then see
+ * each distinct value of their argument once, and NULLs for the rows of
+ * the other arguments, which they skip since their transition functions
+ * are strict.
+ *
+ * This only applies when every aggregate of the query is such a DQA, with
+ * no FILTER or ordering, and the grouping keys and arguments are hashable.
+ * The query is rewritten in place; returns false, leaving it untouched,
+ * if it doesn't qualify.
+ */
+bool
+cdb_expand_multi_dqa(Query *parse)
+{
+	DqaExpandContext ctx;
+	Query	   *subq;
+	RangeTblEntry *valuesRte;
+	RangeTblEntry *subqRte;
+	RangeTblRef *rtr;
+	Node	   *input;
+	List	   *subTlist = NIL;
+	List	   *subGroupClause = NIL;
+	List	   *colnames = NIL;
+	List	   *valuesLists = NIL;
+	List	   *newTlist = NIL;
+	Node	   *newHaving;
+	Index		valuesRti;
+	Var		   *tagVar;
+	ListCell   *lc;
+	int			ngroupcols;
+	int			i;
+
+	if (parse->commandType != CMD_SELECT || !parse->hasAggs ||
+		parse->hasWindowFuncs || parse->hasSubLinks ||
+		parse->resultRelation != 0 || parse->setOperations != NULL ||
+		parse->cteList != NIL || parse->rowMarks != NIL ||
+		parse->scatterClause != NIL || parse->returningList != NIL ||
+		list_length(parse->jointree->fromlist) > 1 ||
+		contain_vars_of_level_or_above((Node *) parse, 1))
+		return false;
+
+	/* Collect the grouping expressions.  No grouping extensions. */
+	ctx.groupExprs = NIL;
+	ctx.dqaArgs = NIL;
+	ctx.failed = false;
+	foreach(lc, parse->groupClause)
+	{
+		GroupClause *gc = (GroupClause *) lfirst(lc);
+		TargetEntry *tle;
+
+		if (!IsA(gc, GroupClause))
+			return false;
+		tle = get_sortgroupclause_tle(gc, parse->targetList);
+		if (!hash_safe_type(exprType((Node *) tle->expr)))
+			return false;
+		ctx.groupExprs = lappend(ctx.groupExprs, tle->expr);
+	}
+	ngroupcols = list_length(ctx.groupExprs);
+
+	/* Collect the DQA arguments, checking every aggregate qualifies. */
+	dqa_expand_collect_walker((Node *) parse->targetList, &ctx);
+	dqa_expand_collect_walker(parse->havingQual, &ctx);
+	if (ctx.failed || list_length(ctx.dqaArgs) < 2)
+		return false;
+
+	/*
+	 * Rewrite the target list and HAVING qual on top of the subquery's
+	 * columns, now that we know how many there are.  They mustn't refer to
+	 * the input other than through the grouping expressions and DQAs.
+	 */
+	foreach(lc, parse->targetList)
+	{
+		TargetEntry *tle = (TargetEntry *) copyObject(lfirst(lc));
+
+		tle->expr = (Expr *) dqa_expand_mutator((Node *) tle->expr, &ctx);
+		newTlist = lappend(newTlist, tle);
+	}
+	newHaving = dqa_expand_mutator(parse->havingQual, &ctx);
+	if (ctx.failed)
+		return false;
+
+	/* The tags, one per DQA argument. */
+	for (i = 0; i < list_length(ctx.dqaArgs); i++)
+		valuesLists = lappend(valuesLists,
+							  list_make1(makeConst(INT4OID, -1, sizeof(int32),
+												   Int32GetDatum(i),
+												   false, true)));
+	valuesRte = makeNode(RangeTblEntry);
+	valuesRte->rtekind = RTE_VALUES;
+	valuesRte->values_lists = valuesLists;
+	valuesRte->eref = makeAlias("dqa_tags", list_make1(makeString("tag")));
+	valuesRte->inFromCl = true;
+	valuesRti = list_length(parse->rtable) + 1;
+
+	/* The subquery's target list and grouping: keys, tag, arguments. */
+	i = 0;
+	foreach(lc, ctx.groupExprs)
+	{
+		Expr	   *expr = (Expr *) lfirst(lc);
+		GroupClause *gc = (GroupClause *) list_nth(parse->groupClause, i);
+		GroupClause *subgc;
+		TargetEntry *origtle = get_sortgroupclause_tle(gc, parse->targetList);
+		TargetEntry *tle;
+
+		i++;
+		tle = makeTargetEntry((Expr *) copyObject(expr), i,
+							  origtle->resname ? pstrdup(origtle->resname) : NULL,
+							  false);
+		tle->ressortgroupref = i;
+		subTlist = lappend(subTlist, tle);
+
+		subgc = makeNode(GroupClause);
+		subgc->tleSortGroupRef = i;
+		subgc->sortop = gc->sortop;
+		subgc->nulls_first = gc->nulls_first;
+		subGroupClause = lappend(subGroupClause, subgc);
+	}
+
+	tagVar = makeVar(valuesRti, 1, INT4OID, -1, 0);
+	for (i = 0; i <= list_length(ctx.dqaArgs); i++)
+	{
+		AttrNumber	resno = ngroupcols + 1 + i;
+		Expr	   *expr;
+		TargetEntry *tle;
+		GroupClause *subgc;
+		char		buffer[50];
+
+		if (i == 0)
+		{
+			expr = (Expr *) copyObject(tagVar);
+			strcpy(buffer, "dqa_tag");
+		}
+		else
+		{
+			Expr	   *arg = (Expr *) list_nth(ctx.dqaArgs, i - 1);
+			CaseExpr   *caseexpr = makeNode(CaseExpr);
+			CaseWhen   *casewhen = makeNode(CaseWhen);
+			OpExpr	   *cond;
+
+			cond = (OpExpr *) make_opclause(Int4EqualOperator, BOOLOID, false,
+											(Expr *) copyObject(tagVar),
+											(Expr *) makeConst(INT4OID, -1,
+															   sizeof(int32),
+															   Int32GetDatum(i - 1),
+															   false, true));
+			cond->opfuncid = F_INT4EQ;
+
+			casewhen->expr = (Expr *) cond;
+			casewhen->result = (Expr *) copyObject(arg);
+			casewhen->location = -1;
+			caseexpr->casetype = exprType((Node *) arg);
+			caseexpr->args = list_make1(casewhen);
+			caseexpr->defresult = (Expr *) makeNullConst(exprType((Node *) arg),
+														 exprTypmod((Node *) arg));
+			caseexpr->location = -1;
+			expr = (Expr *) caseexpr;
+			snprintf(buffer, sizeof(buffer), "dqa_arg_%d", i);
+		}
+
+		tle = makeTargetEntry(expr, resno, pstrdup(buffer), false);
+		tle->ressortgroupref = resno;
+		subTlist = lappend(subTlist, tle);
+
+		subgc = makeNode(GroupClause);
+		subgc->tleSortGroupRef = resno;
+		subgc->sortop = lookup_type_cache(exprType((Node *) expr),
+										  TYPECACHE_LT_OPR)->lt_opr;
+		subgc->nulls_first = false;
+		if (!OidIsValid(subgc->sortop))
+			return false;
+		subGroupClause = lappend(subGroupClause, subgc);
+	}
+
+	foreach(lc, subTlist)
+	{
+		TargetEntry *tle = (TargetEntry *) lfirst(lc);
+
+		colnames = lappend(colnames,
+						   makeString(tle->resname ? pstrdup(tle->resname) :
+									  pstrdup("?column?")));
+	}
+
+	/* The subquery: the input cross joined with the tags. */
+	rtr = makeNode(RangeTblRef);
+	rtr->rtindex = valuesRti;
+	if (parse->jointree->fromlist != NIL)
+	{
+		JoinExpr   *join = makeNode(JoinExpr);
+
+		join->jointype = JOIN_INNER;
+		join->isNatural = false;
+		join->larg = (Node *) linitial(parse->jointree->fromlist);
+		join->rarg = (Node *) rtr;
+		join->quals = NULL;		/* cross product */
+		join->rtindex = 0;
+		input = (Node *) join;
+	}
+	else
+		input = (Node *) rtr;
+
+	subq = makeNode(Query);
+	subq->commandType = CMD_SELECT;
+	subq->querySource = QSRC_PLANNER;
+	subq->canSetTag = true;
+	subq->hasDynamicFunctions = parse->hasDynamicFunctions;
+	subq->hasFuncsWithExecRestrictions = parse->hasFuncsWithExecRestrictions;
+	subq->rtable = lappend(parse->rtable, valuesRte);
+	subq->jointree = makeFromExpr(list_make1(input), parse->jointree->quals);
+	subq->targetList = subTlist;
+	subq->groupClause = subGroupClause;
+
+	subqRte = makeNode(RangeTblEntry);
+	subqRte->rtekind = RTE_SUBQUERY;
+	subqRte->subquery = subq;
+	subqRte->eref = makeAlias("dqa_expand", colnames);
+	subqRte->inFromCl = true;
+
+	/* The outer query aggregates the subquery's rows. */
+	rtr = makeNode(RangeTblRef);
+	rtr->rtindex = 1;
+	parse->rtable = list_make1(subqRte);
+	parse->jointree = makeFromExpr(list_make1(rtr), NULL);
+	parse->targetList = newTlist;
+	parse->havingQual = newHaving;
+
+	return true;
+}
+
+/*
+ * Collect the distinct arguments of the DQAs into ctx->dqaArgs.  Set
+ * ctx->failed if there is an aggregate that cdb_expand_multi_dqa() can't
+ * compute from the deduplicated rows.
+ */
+static bool
+dqa_expand_collect_walker(Node *node, DqaExpandContext *ctx)
+{
+	if (node == NULL)
+		return false;
+
+	if (IsA(node, Aggref))
+	{
+		Aggref	   *aggref = (Aggref *) node;
+		Node	   *arg;
+		HeapTuple	aggtuple;
+		Oid			transfn;
+
+		if (!aggref->aggdistinct || aggref->aggstar ||
+			aggref->agglevelsup != 0 || aggref->aggfilter != NULL ||
+			aggref->aggorder != NULL || list_length(aggref->args) != 1)
+		{
+			ctx->failed = true;
+			return true;
+		}
+
+		arg = (Node *) linitial(aggref->args);
+		if (!hash_safe_type(exprType(arg)))
+		{
+			ctx->failed = true;
+			return true;
+		}
+
+		/* NULLs stand for the rows of the other arguments. */
+		aggtuple = SearchSysCache(AGGFNOID,
+								  ObjectIdGetDatum(aggref->aggfnoid),
+								  0, 0, 0);
+		if (!HeapTupleIsValid(aggtuple))
+			elog(ERROR, "cache lookup failed for aggregate %u",
+				 aggref->aggfnoid);
+		transfn = ((Form_pg_aggregate) GETSTRUCT(aggtuple))->aggtransfn;
+		ReleaseSysCache(aggtuple);
+		if (!func_strict(transfn))
+		{
+			ctx->failed = true;
+			return true;
+		}
+
+		if (!list_member(ctx->dqaArgs, arg))
+			ctx->dqaArgs = lappend(ctx->dqaArgs, arg);
+		return false;
+	}
+
+	if (IsA(node, PercentileExpr) || IsA(node, GroupingFunc) ||
+		IsA(node, GroupId) || IsA(node, Grouping))
+	{
+		ctx->failed = true;
+		return true;
+	}
+
+	return expression_tree_walker(node, dqa_expand_collect_walker, ctx);
+}
+
+/*
+ * Replace the grouping expressions with Vars of the subquery, and the
+ * DQAs with plain aggregates of the subquery's argument columns.  Set
+ * ctx->failed if there's any other reference to the input.
+ */
+static Node *
+dqa_expand_mutator(Node *node, DqaExpandContext *ctx)
+{
+	ListCell   *lc;
+	int			i;
+
+	if (node == NULL)
+		return NULL;
+
+	i = 0;
+	foreach(lc, ctx->groupExprs)
+	{
+		i++;
+		if (equal(node, lfirst(lc)))
+			return (Node *) makeVar(1, i, exprType(node), exprTypmod(node), 0);
+	}
+
+	if (IsA(node, Aggref))
+	{
+		Aggref	   *aggref = (Aggref *) copyObject(node);
+		Node	   *arg = (Node *) linitial(aggref->args);
+
+		i = list_length(ctx->groupExprs) + 1;
+		foreach(lc, ctx->dqaArgs)
+		{
+			i++;
+			if (equal(arg, lfirst(lc)))
+				break;
+		}
+		Assert(lc != NULL);
+
+		aggref->aggdistinct = false;
+		aggref->args = list_make1(makeVar(1, i, exprType(arg),
+										  exprTypmod(arg), 0));
+		return (Node *) aggref;
+	}
+
+	if (IsA(node, Var))
+	{
+		ctx->failed = true;
+		return node;
+	}
+
+	return expression_tree_mutator(node, dqa_expand_mutator, ctx);
+}
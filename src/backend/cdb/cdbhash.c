@@ -36,6 +36,7 @@
 #include "utils/complex_type.h"
 #include "cdb/cdbhash.h"
 #include "cdb/cdbutil.h"
+#include "cdb/cdbvars.h"
 
 /* 32 bit FNV-1  non-zero initial basis */
 #define FNV1_32_INIT ((uint32)0x811c9dc5)
@@ -58,11 +59,17 @@
 /* Fast mod using a bit mask, assuming that y is a power of 2 */
 #define FASTMOD(x,y)		((x) & ((y)-1))
 
+/* Rows hashed per pass by the batch API, bounds its stack buffers */
+#define HASH_BATCH_CHUNK 256
+
 /* local function declarations */
 static uint32 fnv1_32_buf(void *buf, size_t len, uint32 hashval);
+static void fnv1_32_batch(uint32 *hashes, const uint64 *keys, int n, int keylen);
+static void hashResolvedDatum(Datum datum, Oid type, datumHashFunction hashFn, void *clientData);
 static int	inet_getkey(inet *addr, unsigned char *inet_key, int key_size);
 static int	ignoreblanks(char *data, int len);
 static int	ispowof2(int numsegs);
+static int	jump_consistent_hash(uint64 key, int numsegs);
 
 
 /*================================================================
@@ -82,6 +89,11 @@ static int	ispowof2(int numsegs);
  * 1 - number of segments in Greenplum Database.
  * 2 - reduction method.
  *
+ * The reduction method decides which segment every row of every hash
+ * distributed table lives on, so it must be the same on all segments for
+ * the whole life of the data: gp_use_jump_consistent_hash is a postmaster
+ * GUC for that reason.
+ *
  * The hash value itself will be initialized for every tuple in cdbhashinit()
  */
 CdbHash *
@@ -101,10 +113,14 @@ makeCdbHash(int numsegs)
 	h->numsegs = numsegs;
 
 	/*
-	 * set the reduction algorithm: If num_segs is power of 2 use bit mask,
-	 * else use lazy mod (h mod n)
+	 * set the reduction algorithm: jump consistent hash if enabled, else if
+	 * num_segs is power of 2 use bit mask, else use lazy mod (h mod n)
 	 */
-	if (ispowof2(numsegs))
+	if (gp_use_jump_consistent_hash)
+	{
+		h->reducealg = REDUCE_JUMP_CONSISTENT;
+	}
+	else if (ispowof2(numsegs))
 	{
 		h->reducealg = REDUCE_BITMASK;
 	}
@@ -176,6 +192,19 @@ cdbhash(CdbHash *h, Datum datum, Oid type)
  */
 void
 hashDatum(Datum datum, Oid type, datumHashFunction hashFn, void *clientData)
+{
+	if (typeIsEnumType(type))
+		type = ANYENUMOID;
+
+	hashResolvedDatum(datum, type, hashFn, clientData);
+}
+
+/*
+ * Guts of hashDatum(), for a type that has already been mapped to
+ * ANYENUMOID if it is an enum.
+ */
+static void
+hashResolvedDatum(Datum datum, Oid type, datumHashFunction hashFn, void *clientData)
 {
 	void	   *buf = NULL;		/* pointer to the data */
 	size_t		len = 0;		/* length for the data buffer */
@@ -225,9 +254,6 @@ hashDatum(Datum datum, Oid type, datumHashFunction hashFn, void *clientData)
 
 	void	   *tofree = NULL;
 
-	if (typeIsEnumType(type))
-		type = ANYENUMOID;
-
 	/*
 	 * Select the hash to be performed according to the field type we are
 	 * adding to the hash.
@@ -663,7 +689,9 @@ cdbhashreduce(CdbHash *h)
 								 * Database and therefore initialize to this
 								 * value for error checking? */
 
-	Assert(h->reducealg == REDUCE_BITMASK || h->reducealg == REDUCE_LAZYMOD);
+	Assert(h->reducealg == REDUCE_BITMASK ||
+		   h->reducealg == REDUCE_LAZYMOD ||
+		   h->reducealg == REDUCE_JUMP_CONSISTENT);
 
 	/*
 	 * Reduce our 32-bit hash value to a segment number
@@ -677,11 +705,222 @@ cdbhashreduce(CdbHash *h)
 		case REDUCE_LAZYMOD:
 			result = (h->hash) % (h->numsegs);	/* simple mod */
 			break;
+
+		case REDUCE_JUMP_CONSISTENT:
+			result = jump_consistent_hash(h->hash, h->numsegs);
+			break;
 	}
 
 	return result;
 }
 
+/*================================================================
+ *
+ * BATCH HASH API
+ *
+ * These hash a batch of rows one key column at a time, keeping one running
+ * hash value per row in an array. For every row the result is the same as
+ * cdbhashinit(), cdbhash()/cdbhashnull() for each key and cdbhashreduce()
+ * would give, so rows hashed either way land on the same segment.
+ *
+ * For the fixed-width types redistribute keys mostly are, the per-datum
+ * type switch and byte loop are replaced by one pass over all rows per key
+ * byte, which the compiler turns into SIMD code.
+ *
+ *================================================================
+ */
+
+/*
+ * Initialize the hash values of n rows.
+ */
+void
+cdbhashinit_batch(uint32 *hashes, int n)
+{
+	int			i;
+
+	for (i = 0; i < n; i++)
+		hashes[i] = FNV1_32_INIT;
+}
+
+/*
+ * Add one key column of n rows to their hash values. The caller should
+ * provide the base type if the column is of a domain type, as for cdbhash().
+ */
+void
+cdbhash_batch(uint32 *hashes, int n, Datum *values, bool *isnull, Oid typid)
+{
+	uint64		keys[HASH_BATCH_CHUNK];
+	uint32		nullbuf = NULL_VAL;
+	int			keylen;
+	int			start;
+	int			i;
+
+	if (typeIsEnumType(typid))
+		typid = ANYENUMOID;
+
+	/* Key length in bytes, as hashed by hashResolvedDatum() */
+	switch (typid)
+	{
+		case INT2OID:
+		case INT4OID:
+		case INT8OID:
+		case OIDOID:
+		case REGPROCOID:
+		case REGPROCEDUREOID:
+		case REGOPEROID:
+		case REGOPERATOROID:
+		case REGCLASSOID:
+		case REGTYPEOID:
+		case ANYENUMOID:
+		case TIMESTAMPOID:
+		case TIMESTAMPTZOID:
+		case TIMEOID:
+			keylen = 8;
+			break;
+		case DATEOID:
+			keylen = 4;
+			break;
+		default:
+			keylen = 0;
+			break;
+	}
+
+	if (keylen == 0)
+	{
+		CdbHash		h;
+
+		for (i = 0; i < n; i++)
+		{
+			h.hash = hashes[i];
+			if (isnull[i])
+				hashNullDatum(addToCdbHash, &h);
+			else
+				hashResolvedDatum(values[i], typid, addToCdbHash, &h);
+			hashes[i] = h.hash;
+		}
+		return;
+	}
+
+	for (start = 0; start < n; start += HASH_BATCH_CHUNK)
+	{
+		int			count = Min(n - start, HASH_BATCH_CHUNK);
+		uint32	   *h = hashes + start;
+		Datum	   *v = values + start;
+		bool	   *nulls = isnull + start;
+		bool		anynull = false;
+
+		/* Extract the bytes hashDatum() would hash, as an integer */
+		for (i = 0; i < count; i++)
+		{
+			if (nulls[i])
+			{
+				keys[i] = 0;
+				anynull = true;
+				continue;
+			}
+
+			switch (typid)
+			{
+				case INT2OID:
+					keys[i] = (uint64) (int64) DatumGetInt16(v[i]);
+					break;
+				case INT4OID:
+					keys[i] = (uint64) (int64) DatumGetInt32(v[i]);
+					break;
+				case INT8OID:
+					keys[i] = (uint64) DatumGetInt64(v[i]);
+					break;
+				case DATEOID:
+					keys[i] = (uint32) DatumGetDateADT(v[i]);
+					break;
+				case TIMESTAMPOID:
+				case TIMESTAMPTZOID:
+					{
+						/* may be a double, hash its bits */
+						Timestamp	ts = DatumGetTimestamp(v[i]);
+
+						memcpy(&keys[i], &ts, sizeof(keys[i]));
+						break;
+					}
+				case TIMEOID:
+					{
+						TimeADT		t = DatumGetTimeADT(v[i]);
+
+						memcpy(&keys[i], &t, sizeof(keys[i]));
+						break;
+					}
+				default:
+					/* the OID types */
+					keys[i] = (uint64) (int64) DatumGetUInt32(v[i]);
+					break;
+			}
+		}
+
+		if (!anynull)
+			fnv1_32_batch(h, keys, count, keylen);
+		else
+		{
+			uint32		nullhashes[HASH_BATCH_CHUNK];
+
+			for (i = 0; i < count; i++)
+				if (nulls[i])
+					nullhashes[i] = fnv1_32_buf(&nullbuf, sizeof(nullbuf), h[i]);
+
+			fnv1_32_batch(h, keys, count, keylen);
+
+			for (i = 0; i < count; i++)
+				if (nulls[i])
+					h[i] = nullhashes[i];
+		}
+	}
+}
+
+/*
+ * Hash n rows of a relation with an empty policy, as cdbhashnokey() would.
+ */
+void
+cdbhashnokey_batch(CdbHash *h, uint32 *hashes, int n)
+{
+	int			i;
+
+	for (i = 0; i < n; i++)
+	{
+		uint32		rrbuf = h->rrindex++;
+
+		hashes[i] = fnv1_32_buf(&rrbuf, sizeof(rrbuf), hashes[i]);
+	}
+}
+
+/*
+ * Reduce the hash values of n rows to segment numbers.
+ */
+void
+cdbhashreduce_batch(CdbHash *h, const uint32 *hashes, int n, unsigned int *segs)
+{
+	uint32		numsegs = (uint32) h->numsegs;
+	int			i;
+
+	Assert(h->reducealg == REDUCE_BITMASK ||
+		   h->reducealg == REDUCE_LAZYMOD ||
+		   h->reducealg == REDUCE_JUMP_CONSISTENT);
+
+	if (h->reducealg == REDUCE_BITMASK)
+	{
+		for (i = 0; i < n; i++)
+			segs[i] = FASTMOD(hashes[i], numsegs);
+	}
+	else if (h->reducealg == REDUCE_JUMP_CONSISTENT)
+	{
+		for (i = 0; i < n; i++)
+			segs[i] = jump_consistent_hash(hashes[i], h->numsegs);
+	}
+	else
+	{
+		for (i = 0; i < n; i++)
+			segs[i] = hashes[i] % numsegs;
+	}
+}
+
 bool
 typeIsArrayType(Oid typeoid)
 {
@@ -823,6 +1062,42 @@ fnv1_32_buf(void *buf, size_t len, uint32 hval)
 	return hval;
 }
 
+/*
+ * fnv1_32_batch - perform a 32 bit FNV 1 hash of a keylen byte key on each
+ * of n rows
+ *
+ * The key bytes of a row are hashed in memory order, as fnv1_32_buf() would
+ * hash the integer keys[i] stored in keylen bytes. Iterating over the rows
+ * in the inner loop keeps it free of dependencies, so that it vectorizes.
+ */
+static void
+fnv1_32_batch(uint32 *hashes, const uint64 *keys, int n, int keylen)
+{
+	int			b;
+	int			i;
+
+	for (b = 0; b < keylen; b++)
+	{
+#ifdef WORDS_BIGENDIAN
+		int			shift = 8 * (keylen - 1 - b);
+#else
+		int			shift = 8 * b;
+#endif
+
+		for (i = 0; i < n; i++)
+		{
+			uint32		hval = hashes[i];
+
+#if defined(NO_FNV_GCC_OPTIMIZATION)
+			hval *= FNV_32_PRIME;
+#else
+			hval += (hval << 1) + (hval << 4) + (hval << 7) + (hval << 8) + (hval << 24);
+#endif
+			hashes[i] = hval ^ (uint32) ((keys[i] >> shift) & 0xff);
+		}
+	}
+}
+
 /*
  * Support function for hashing on inet/cidr (see network.c)
  *
@@ -893,3 +1168,29 @@ ispowof2(int numsegs)
 {
 	return !(numsegs & (numsegs - 1));
 }
+
+/*
+ * Map a hash value to one of numsegs buckets with the jump consistent hash
+ * of Lamping and Veach, "A Fast, Minimal Memory, Consistent Hash Algorithm".
+ *
+ * When numsegs grows from n to n + k, a key either stays in its bucket or
+ * moves to one of the k new ones, so only about k / (n + k) of the rows of a
+ * table have to move when the cluster is expanded. With the modulo methods
+ * above nearly every row changes segment.
+ */
+static int
+jump_consistent_hash(uint64 key, int numsegs)
+{
+	int64		b = -1;
+	int64		j = 0;
+
+	while (j < numsegs)
+	{
+		b = j;
+		key = key * UINT64CONST(2862933555777941757) + 1;
+		j = (int64) ((b + 1) * ((double) (INT64CONST(1) << 31) /
+								(double) ((key >> 33) + 1)));
+	}
+
+	return (int) b;
+}
@@ -0,0 +1,464 @@
+/*-------------------------------------------------------------------------
+ *
+ * cdbhostarena.c
+ *	   Shared memory arenas between the QEs of a host.
+ *
+ * Some data is built identically by every QE of a slice, e.g. the hash
+ * table of a hash join whose inner side is broadcast.  On a host running
+ * several segments, one copy of it is enough.  A host arena is a POSIX
+ * shared memory object named after the command, slice and plan node it
+ * belongs to, so that the QEs of the same slice on one host find each
+ * other's without any coordination through the QD.
+ *
+ * The first QE to get there creates the arena, fills it in and publishes
+ * it; the others attach to it and wait until it is published.  The data
+ * is mapped at a different address in each process, so it must not hold
+ * pointers.  The last process to detach from an arena unlinks it.  Arenas
+ * still attached at transaction end, e.g. after an error, are detached
+ * then.
+ *
+ * Arenas live in tmpfs.  The QE that creates one charges it to the vmem
+ * tracker until it detaches, and gives up on sharing if that fails, so a
+ * host arena never lets a query use more memory than its own copy would
+ * have.
+ *
+ * A QE that crashes while attached leaves its arena behind.  The postmaster
+ * removes the leftovers whose creator is gone when it starts and when it
+ * reinitializes after a crash.  The names include the start time of the
+ * QD's transaction manager, so a later incarnation of the cluster, whose
+ * session ids start over, never attaches to an arena left by an earlier
+ * one.
+ *
+ * Portions Copyright (c) 2012-Present Pivotal Software, Inc.
+ *
+ *
+ * IDENTIFICATION
+ *	    src/backend/cdb/cdbhostarena.c
+ *
+ *-------------------------------------------------------------------------
+ */
+
+#include "postgres.h"
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "cdb/cdbdtxcontextinfo.h"
+#include "cdb/cdbhostarena.h"
+#include "cdb/cdbvars.h"
+#include "miscadmin.h"
+#include "port/atomics.h"
+#include "storage/fd.h"
+#include "utils/resowner.h"
+#include "utils/vmem_tracker.h"
+
+#define HOST_ARENA_MAGIC		0x48415245	/* "HARE" */
+
+#define HOST_ARENA_BUILDING		0
+#define HOST_ARENA_READY		1
+#define HOST_ARENA_FAILED		2
+
+/* How often an attaching QE checks whether the arena is published */
+#define HOST_ARENA_POLL_US		1000
+
+/*
+ * Where the POSIX shared memory objects show up as files, and the prefix of
+ * the names of ours there
+ */
+#define HOST_ARENA_DIR			"/dev/shm"
+#define HOST_ARENA_PREFIX		"gpdb_"
+
+/* Leftovers without a readable header are removed once they're this old */
+#define HOST_ARENA_STALE_SECS	60
+
+/* Header at the start of the shared memory object */
+typedef struct HostArenaHeader
+{
+	uint32		magic;
+	pg_atomic_uint32 state;		/* HOST_ARENA_* */
+	pg_atomic_uint32 refcount;	/* # processes attached */
+	pid_t		creatorPid;
+	Size		size;			/* # bytes of user data */
+} HostArenaHeader;
+
+#define HOST_ARENA_HEADER_SIZE	MAXALIGN(sizeof(HostArenaHeader))
+
+#define ArenaHeader(arena) \
+	((HostArenaHeader *) ((arena)->data - HOST_ARENA_HEADER_SIZE))
+
+/* Arenas this process is attached to */
+static HostArena *attachedArenas = NULL;
+static bool callbackRegistered = false;
+
+static HostArena *HostArenaMap(const char *name, int fd, Size mapsize,
+			 bool creator);
+static void HostArenaReleaseCallback(ResourceReleasePhase phase,
+						 bool isCommit, bool isTopLevel, void *arg);
+
+/*
+ * HostArenaName
+ *		The name of the arena of a plan node in the current command
+ */
+void
+HostArenaName(char *name, Size namesize, int sliceId, int planNodeId)
+{
+	snprintf(name, namesize, "/" HOST_ARENA_PREFIX "%d_%u_%d_%d_%d_%d",
+			 qdPostmasterPort, QEDtxContextInfo.distributedTimeStamp,
+			 gp_session_id, gp_command_count, sliceId, planNodeId);
+}
+
+/*
+ * HostArenaCreate
+ *		Create an arena with room for size bytes
+ *
+ * Returns NULL if the arena exists already, or can't be created, also for
+ * lack of vmem.  The caller fills in arena->data and then calls
+ * HostArenaPublish().
+ */
+HostArena *
+HostArenaCreate(const char *name, Size size)
+{
+	Size		mapsize = HOST_ARENA_HEADER_SIZE + size;
+	HostArena  *arena;
+	HostArenaHeader *header;
+	int			fd;
+
+	if (VmemTracker_ReserveVmem(mapsize) != MemoryAllocation_Success)
+	{
+		elog(DEBUG1, "not enough vmem for host arena \"%s\" of " UINT64_FORMAT " bytes",
+			 name, (uint64) mapsize);
+		return NULL;
+	}
+
+	fd = shm_open(name, O_RDWR | O_CREAT | O_EXCL, S_IRUSR | S_IWUSR);
+	if (fd < 0)
+	{
+		if (errno != EEXIST)
+			elog(DEBUG1, "could not create host arena \"%s\": %m", name);
+		VmemTracker_ReleaseVmem(mapsize);
+		return NULL;
+	}
+
+	if (ftruncate(fd, mapsize) != 0)
+	{
+		elog(DEBUG1, "could not size host arena \"%s\" to " UINT64_FORMAT " bytes: %m",
+			 name, (uint64) mapsize);
+		close(fd);
+		shm_unlink(name);
+		VmemTracker_ReleaseVmem(mapsize);
+		return NULL;
+	}
+
+	arena = HostArenaMap(name, fd, mapsize, true);
+	close(fd);
+	if (arena == NULL)
+	{
+		shm_unlink(name);
+		VmemTracker_ReleaseVmem(mapsize);
+		return NULL;
+	}
+
+	header = ArenaHeader(arena);
+	header->creatorPid = MyProcPid;
+	header->size = size;
+	pg_atomic_init_u32(&header->state, HOST_ARENA_BUILDING);
+	pg_atomic_init_u32(&header->refcount, 1);
+	pg_write_barrier();
+	header->magic = HOST_ARENA_MAGIC;
+
+	return arena;
+}
+
+/*
+ * HostArenaAttach
+ *		Attach to an arena that another QE has created
+ *
+ * Waits up to timeoutMs for the arena to be published.  Returns NULL if
+ * there's no such arena, if it wasn't published in time, or if its creator
+ * gave up on it.
+ */
+HostArena *
+HostArenaAttach(const char *name, int timeoutMs)
+{
+	HostArena  *arena;
+	HostArenaHeader *header;
+	struct stat st;
+	long		waited = 0;
+	long		timeoutUs = (long) timeoutMs * 1000;
+	int			fd;
+
+	fd = shm_open(name, O_RDWR, 0);
+	if (fd < 0)
+		return NULL;
+
+	/* The creator may not have sized it yet. */
+	for (;;)
+	{
+		if (fstat(fd, &st) != 0)
+		{
+			close(fd);
+			return NULL;
+		}
+		if (st.st_size >= HOST_ARENA_HEADER_SIZE)
+			break;
+		if (waited >= timeoutUs)
+		{
+			close(fd);
+			return NULL;
+		}
+		CHECK_FOR_INTERRUPTS();
+		pg_usleep(HOST_ARENA_POLL_US);
+		waited += HOST_ARENA_POLL_US;
+	}
+
+	arena = HostArenaMap(name, fd, st.st_size, false);
+	close(fd);
+	if (arena == NULL)
+		return NULL;
+
+	header = ArenaHeader(arena);
+	pg_atomic_fetch_add_u32(&header->refcount, 1);
+
+	for (;;)
+	{
+		uint32		state;
+
+		if (header->magic == HOST_ARENA_MAGIC)
+		{
+			state = pg_atomic_read_u32(&header->state);
+			if (state == HOST_ARENA_READY)
+				break;
+			if (state == HOST_ARENA_FAILED)
+			{
+				HostArenaDetach(arena);
+				return NULL;
+			}
+
+			/* Give up on a creator that died before publishing. */
+			if (kill(header->creatorPid, 0) != 0 && errno == ESRCH)
+			{
+				HostArenaDetach(arena);
+				return NULL;
+			}
+		}
+
+		if (waited >= timeoutUs)
+		{
+			HostArenaDetach(arena);
+			return NULL;
+		}
+		CHECK_FOR_INTERRUPTS();
+		pg_usleep(HOST_ARENA_POLL_US);
+		waited += HOST_ARENA_POLL_US;
+	}
+
+	pg_read_barrier();
+
+	if (HOST_ARENA_HEADER_SIZE + header->size > (Size) st.st_size)
+	{
+		HostArenaDetach(arena);
+		return NULL;
+	}
+	arena->size = header->size;
+
+	return arena;
+}
+
+/*
+ * HostArenaPublish
+ *		Let the attached QEs use the arena the caller created
+ *
+ * With success false, they give up on it instead.
+ */
+void
+HostArenaPublish(HostArena *arena, bool success)
+{
+	HostArenaHeader *header = ArenaHeader(arena);
+
+	Assert(arena->creator);
+
+	pg_write_barrier();
+	pg_atomic_write_u32(&header->state,
+						success ? HOST_ARENA_READY : HOST_ARENA_FAILED);
+}
+
+/*
+ * HostArenaDetach
+ *		Unmap an arena, and unlink it if no one else is attached
+ */
+void
+HostArenaDetach(HostArena *arena)
+{
+	HostArenaHeader *header = ArenaHeader(arena);
+	HostArena **prev;
+
+	for (prev = &attachedArenas; *prev != NULL; prev = &(*prev)->next)
+	{
+		if (*prev == arena)
+		{
+			*prev = arena->next;
+			break;
+		}
+	}
+
+	/* A creator that never published it leaves it to no one. */
+	if (arena->creator &&
+		pg_atomic_read_u32(&header->state) == HOST_ARENA_BUILDING)
+		pg_atomic_write_u32(&header->state, HOST_ARENA_FAILED);
+
+	if (pg_atomic_sub_fetch_u32(&header->refcount, 1) == 0)
+		shm_unlink(arena->name);
+
+	if (munmap(header, HOST_ARENA_HEADER_SIZE + arena->size) != 0)
+		elog(LOG, "could not unmap host arena \"%s\": %m", arena->name);
+
+	/* The creator's share of the arena was charged in HostArenaCreate() */
+	if (arena->creator)
+		VmemTracker_ReleaseVmem(HOST_ARENA_HEADER_SIZE + arena->size);
+
+	pfree(arena);
+}
+
+/*
+ * HostArenaIsStale
+ *		Is the arena of the given name left over from a process that's gone?
+ */
+static bool
+HostArenaIsStale(const char *name)
+{
+	HostArenaHeader *header;
+	struct stat st;
+	bool		stale;
+	int			fd;
+
+	fd = shm_open(name, O_RDONLY, 0);
+	if (fd < 0)
+		return false;
+
+	if (fstat(fd, &st) != 0)
+	{
+		close(fd);
+		return false;
+	}
+
+	/* Too small for a header yet: its creator is still setting it up, or died. */
+	if (st.st_size < HOST_ARENA_HEADER_SIZE)
+	{
+		close(fd);
+		return time(NULL) - st.st_mtime > HOST_ARENA_STALE_SECS;
+	}
+
+	header = mmap(NULL, HOST_ARENA_HEADER_SIZE, PROT_READ, MAP_SHARED, fd, 0);
+	close(fd);
+	if (header == MAP_FAILED)
+		return false;
+
+	if (header->magic != HOST_ARENA_MAGIC)
+		stale = time(NULL) - st.st_mtime > HOST_ARENA_STALE_SECS;
+	else
+		stale = kill(header->creatorPid, 0) != 0 && errno == ESRCH;
+
+	munmap(header, HOST_ARENA_HEADER_SIZE);
+
+	return stale;
+}
+
+/*
+ * HostArenaRemoveStale
+ *		Unlink the arenas on this host whose creator is gone
+ *
+ * Called by the postmaster when it starts and when it reinitializes after a
+ * crash.  The processes of other segments on the host may be using arenas,
+ * so only those whose creator has exited are removed.  That may include an
+ * arena still attached by the other QEs of its slice, if the creator was
+ * done with it first; they keep their mapping, and a QE that would have
+ * attached to it builds its own copy instead.
+ */
+void
+HostArenaRemoveStale(void)
+{
+	DIR		   *dir;
+	struct dirent *de;
+	char		name[MAXPGPATH];
+	int			nremoved = 0;
+
+	dir = AllocateDir(HOST_ARENA_DIR);
+	if (dir == NULL)
+		return;
+
+	while ((de = ReadDir(dir, HOST_ARENA_DIR)) != NULL)
+	{
+		if (strncmp(de->d_name, HOST_ARENA_PREFIX, strlen(HOST_ARENA_PREFIX)) != 0)
+			continue;
+
+		snprintf(name, sizeof(name), "/%s", de->d_name);
+		if (HostArenaIsStale(name) && shm_unlink(name) == 0)
+			nremoved++;
+	}
+
+	FreeDir(dir);
+
+	if (nremoved > 0)
+		elog(LOG, "removed %d stale host arenas", nremoved);
+}
+
+/*
+ * HostArenaMap
+ *		Map an arena's shared memory object and remember it
+ */
+static HostArena *
+HostArenaMap(const char *name, int fd, Size mapsize, bool creator)
+{
+	HostArena  *arena;
+	void	   *addr;
+
+	addr = mmap(NULL, mapsize, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	if (addr == MAP_FAILED)
+	{
+		elog(DEBUG1, "could not map host arena \"%s\": %m", name);
+		return NULL;
+	}
+
+	if (!callbackRegistered)
+	{
+		RegisterResourceReleaseCallback(HostArenaReleaseCallback, NULL);
+		callbackRegistered = true;
+	}
+
+	arena = (HostArena *) MemoryContextAllocZero(TopMemoryContext,
+												 sizeof(HostArena));
+	strlcpy(arena->name, name, sizeof(arena->name));
+	arena->data = (char *) addr + HOST_ARENA_HEADER_SIZE;
+	arena->size = mapsize - HOST_ARENA_HEADER_SIZE;
+	arena->creator = creator;
+	arena->next = attachedArenas;
+	attachedArenas = arena;
+
+	return arena;
+}
+
+/*
+ * Detach from the arenas left behind at the end of a transaction.  Their
+ * users detach from them when they're done, so there are only leftovers
+ * after an error.
+ */
+static void
+HostArenaReleaseCallback(ResourceReleasePhase phase,
+						 bool isCommit, bool isTopLevel, void *arg)
+{
+	if (phase != RESOURCE_RELEASE_AFTER_LOCKS || !isTopLevel)
+		return;
+
+	while (attachedArenas != NULL)
+	{
+		if (isCommit)
+			elog(WARNING, "host arena \"%s\" still attached at commit",
+				 attachedArenas->name);
+		HostArenaDetach(attachedArenas);
+	}
+}
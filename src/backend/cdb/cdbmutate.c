@@ -44,6 +44,7 @@
 #include "catalog/pg_proc.h"
 
 #include "cdb/cdbdisp_query.h"
+#include "cdb/cdbendpoint.h"	/* IsParallelRetrieveCursorQuery() */
 #include "cdb/cdbhash.h"		/* isGreenplumDbHashable() */
 #include "cdb/cdbllize.h"
 #include "cdb/cdbmutate.h"
@@ -456,7 +457,12 @@ apply_motion(PlannerInfo *root, Plan *plan, Query *query)
 
 			}
 
-			if (plan->flow->flotype == FLOW_PARTITIONED && !query->intoClause)
+			/*
+			 * The root slice of a PARALLEL RETRIEVE cursor stays on the
+			 * segments, and sends its rows to the endpoints.
+			 */
+			if (plan->flow->flotype == FLOW_PARTITIONED && !query->intoClause &&
+				!IsParallelRetrieveCursorQuery(query))
 			{
 				/*
 				 * Query result needs to be brought back to the QD. Ask for
@@ -485,7 +491,8 @@ apply_motion(PlannerInfo *root, Plan *plan, Query *query)
 				else
 					Insist(focusPlan(plan, false, false));
 			}
-			needToAssignDirectDispatchContentIds = root->config->gp_enable_direct_dispatch && !query->intoClause;
+			needToAssignDirectDispatchContentIds = root->config->gp_enable_direct_dispatch && !query->intoClause &&
+				!IsParallelRetrieveCursorQuery(query);
 			break;
 
 		case CMD_INSERT:
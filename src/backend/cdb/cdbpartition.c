@@ -53,9 +53,11 @@
 #include "utils/datum.h"
 #include "utils/elog.h"
 #include "utils/fmgroids.h"
+#include "utils/inval.h"
 #include "utils/lsyscache.h"
 #include "utils/memutils.h"
 #include "utils/syscache.h"
+#include "utils/typcache.h"
 
 #define DEFAULT_CONSTRAINT_ESTIMATE 16
 #define MIN_XCHG_CONTEXT_SIZE 4096
@@ -75,6 +77,31 @@ typedef struct
 	Node	   *entry;
 } ConNodeEntry;
 
+/* One list value of a LIST partition rule, see PartitionNodeIndex */
+typedef struct PartitionListValue
+{
+	uint32		hash;			/* hash of colvals */
+	int			ruleno;			/* position of the rule in the PartitionNode */
+	List	   *colvals;		/* a Const for each key column */
+	PartitionRule *rule;
+} PartitionListValue;
+
+/*
+ * The rules of a PartitionNode, arranged for searching. Partition selection
+ * keeps one for every PartitionNode it visits, in the level's state in the
+ * PartitionAccessMethods, so that inserting a tuple doesn't walk the list of
+ * rules. RANGE rules are in order of their bounds, so they are searched by
+ * binary search in the rules array; LIST values by hash in listvalues.
+ */
+typedef struct PartitionNodeIndex
+{
+	PartitionNode *partnode;	/* hash key, must be first */
+	int			nrules;
+	PartitionRule **rules;		/* partnode->rules as an array */
+	int			nlistvalues;	/* -1 if the values can't be hashed */
+	PartitionListValue *listvalues; /* sorted by hash and rule position */
+} PartitionNodeIndex;
+
 
 typedef enum
 {
@@ -150,6 +177,11 @@ static bool compare_partn_opfuncid(PartitionNode *partnode,
 					   List *colvals,
 					   Datum *values, bool *isnull,
 					   TupleDesc tupdesc);
+static PartitionNodeIndex *get_partition_node_index(HTAB **nodeIndexes, MemoryContext cxt,
+						 PartitionNode *partnode, TupleDesc tupdesc,
+						 PartitionListState *ls);
+static bool list_values_match(Partition *part, List *colvals, Datum *values, bool *isnull,
+				  TupleDesc tupdesc, PartitionListState *ls, Oid exprTypeOid);
 static PartitionNode *selectListPartition(PartitionNode *partnode, Datum *values, bool *isnull,
 					TupleDesc tupdesc, PartitionAccessMethods *accessMethods,
 					Oid *foundOid, PartitionRule **prule, Oid exprTypid);
@@ -1968,6 +2000,7 @@ parruleord_open_gap(Oid partid, int2 level, Oid parent, int2 ruleord,
 	HeapTuple	tuple;
 	ScanKeyData scankey[3];
 	IndexScanDesc sd;
+	CatalogIndexState indstate;
 
 	/*---
 	 * This is equivalent to:
@@ -1994,6 +2027,12 @@ parruleord_open_gap(Oid partid, int2 level, Oid parent, int2 ruleord,
 	ScanKeyInit(&scankey[2], 3,
 				BTLessEqualStrategyNumber, F_INT2LE,
 				Int16GetDatum(ruleord));
+	/*
+	 * A gap may have to be opened over every rule of a table with thousands
+	 * of partitions, so open the catalog indexes once for all the updates.
+	 */
+	indstate = CatalogOpenIndexes(rel);
+
 	sd = index_beginscan(rel, irel, SnapshotNow, 3, scankey);
 	while (HeapTupleIsValid(tuple = index_getnext(sd, BackwardScanDirection)))
 	{
@@ -2011,7 +2050,7 @@ parruleord_open_gap(Oid partid, int2 level, Oid parent, int2 ruleord,
 		closegap ? rule_desc->parruleord-- : rule_desc->parruleord++;
 
 		simple_heap_update(rel, &tuple->t_self, tuple);
-		CatalogUpdateIndexes(rel, tuple);
+		CatalogIndexInsert(indstate, tuple);
 
 		heap_freetuple(tuple);
 
@@ -2019,6 +2058,7 @@ parruleord_open_gap(Oid partid, int2 level, Oid parent, int2 ruleord,
 			break;
 	}
 	index_endscan(sd);
+	CatalogCloseIndexes(indstate);
 	heap_close(irel, RowExclusiveLock);
 	heap_close(rel, RowExclusiveLock);
 
@@ -2327,13 +2367,112 @@ RelationBuildPartitionDesc(Relation rel, bool inctemplate)
 	return RelationBuildPartitionDescByOid(RelationGetRelid(rel), inctemplate);
 }
 
+/*
+ * Cache of the PartitionNode trees built by RelationBuildPartitionDescByOid,
+ * so that the planner and the executor don't read pg_partition and
+ * pg_partition_rule again for every query on a partitioned table.
+ *
+ * Any change to those catalogs flushes the whole cache; partition DDL is
+ * rare compared to queries.
+ */
+typedef struct PartitionDescCacheKey
+{
+	Oid			relid;
+	bool		inctemplate;
+} PartitionDescCacheKey;
+
+typedef struct PartitionDescCacheEntry
+{
+	PartitionDescCacheKey key;	/* hash key, must be first */
+	PartitionNode *pnode;		/* in PartitionDescCacheContext, may be NULL */
+} PartitionDescCacheEntry;
+
+static HTAB *PartitionDescCache = NULL;
+static MemoryContext PartitionDescCacheContext = NULL;
+static uint64 PartitionDescCacheInvalCount = 0;
+
+static void
+PartitionDescCacheCallback(Datum arg, int cacheid, ItemPointer tuplePtr)
+{
+	PartitionDescCacheInvalCount++;
+
+	if (PartitionDescCache)
+	{
+		/* the hash table lives in the context too */
+		PartitionDescCache = NULL;
+		MemoryContextReset(PartitionDescCacheContext);
+	}
+}
+
 PartitionNode *
 RelationBuildPartitionDescByOid(Oid relid, bool inctemplate)
 {
+	PartitionDescCacheKey key;
+	PartitionDescCacheEntry *entry;
 	PartitionNode *n;
+	uint64		invalCount;
+	bool		found;
+
+	/* pg_partition is only populated on the entry database */
+	if (Gp_segment != -1)
+		return NULL;
+
+	if (PartitionDescCacheContext == NULL)
+	{
+		if (!CacheMemoryContext)
+			CreateCacheMemoryContext();
+
+		PartitionDescCacheContext = AllocSetContextCreate(CacheMemoryContext,
+														  "PartitionDescCache",
+														  ALLOCSET_DEFAULT_MINSIZE,
+														  ALLOCSET_DEFAULT_INITSIZE,
+														  ALLOCSET_DEFAULT_MAXSIZE);
+		CacheRegisterSyscacheCallback(PARTOID, PartitionDescCacheCallback, (Datum) 0);
+		CacheRegisterSyscacheCallback(PARTRULEOID, PartitionDescCacheCallback, (Datum) 0);
+	}
+
+	if (PartitionDescCache == NULL)
+	{
+		HASHCTL		ctl;
+
+		MemSet(&ctl, 0, sizeof(ctl));
+		ctl.keysize = sizeof(PartitionDescCacheKey);
+		ctl.entrysize = sizeof(PartitionDescCacheEntry);
+		ctl.hash = tag_hash;
+		ctl.hcxt = PartitionDescCacheContext;
+		PartitionDescCache = hash_create("PartitionDescCache", 64, &ctl,
+										 HASH_ELEM | HASH_FUNCTION | HASH_CONTEXT);
+	}
+
+	MemSet(&key, 0, sizeof(key));
+	key.relid = relid;
+	key.inctemplate = inctemplate;
+
+	entry = (PartitionDescCacheEntry *) hash_search(PartitionDescCache, &key,
+													HASH_FIND, NULL);
+	if (entry)
+		return entry->pnode ? (PartitionNode *) copyObject(entry->pnode) : NULL;
+
+	/*
+	 * Build the tree. If the catalogs change while we read them, what we read
+	 * may be stale, so don't keep it.
+	 */
+	invalCount = PartitionDescCacheInvalCount;
 
 	n = get_parts(relid, 0, 0, inctemplate, true /* includesubparts */ );
 
+	if (invalCount == PartitionDescCacheInvalCount && PartitionDescCache)
+	{
+		MemoryContext oldcxt = MemoryContextSwitchTo(PartitionDescCacheContext);
+		PartitionNode *copy = n ? (PartitionNode *) copyObject(n) : NULL;
+
+		entry = (PartitionDescCacheEntry *) hash_search(PartitionDescCache, &key,
+														HASH_ENTER, &found);
+		entry->pnode = copy;
+
+		MemoryContextSwitchTo(oldcxt);
+	}
+
 	return n;
 }
 
@@ -3809,6 +3948,317 @@ compare_partn_opfuncid(PartitionNode *partnode,
 	return true;
 }								/* end compare_partn_opfuncid */
 
+/*
+ * Hash the list values colvals of a rule, for PartitionListValue.hash. A NULL
+ * hashes as 0, like in selectHashPartition().
+ */
+static uint32
+list_values_hash_consts(List *colvals, PartitionListState *ls)
+{
+	uint32		hash = 0;
+	ListCell   *lc;
+	int			i = 0;
+
+	foreach(lc, colvals)
+	{
+		Const	   *c = (Const *) lfirst(lc);
+
+		/* rotate hash left 1 bit at each step */
+		hash = (hash << 1) | ((hash & 0x80000000) ? 1 : 0);
+
+		if (!c->constisnull)
+			hash ^= DatumGetUInt32(FunctionCall1(&ls->hashfuncs[i], c->constvalue));
+		i++;
+	}
+
+	return hash;
+}
+
+/*
+ * Likewise, hash the key columns of a tuple.
+ */
+static uint32
+list_values_hash_tuple(Partition *part, Datum *values, bool *isnull,
+					   PartitionListState *ls)
+{
+	uint32		hash = 0;
+	int			i;
+
+	for (i = 0; i < part->parnatts; i++)
+	{
+		AttrNumber	attno = part->paratts[i];
+
+		hash = (hash << 1) | ((hash & 0x80000000) ? 1 : 0);
+
+		if (!isnull[attno - 1])
+			hash ^= DatumGetUInt32(FunctionCall1(&ls->hashfuncs[i], values[attno - 1]));
+	}
+
+	return hash;
+}
+
+static int
+list_value_cmp(const void *a, const void *b)
+{
+	const PartitionListValue *va = (const PartitionListValue *) a;
+	const PartitionListValue *vb = (const PartitionListValue *) b;
+
+	if (va->hash != vb->hash)
+		return (va->hash < vb->hash) ? -1 : 1;
+	if (va->ruleno != vb->ruleno)
+		return (va->ruleno < vb->ruleno) ? -1 : 1;
+	return 0;
+}
+
+/*
+ * Find out whether the key columns of a LIST level can be hashed consistently
+ * with the "=" operator that selectListPartition() compares them with, and
+ * set up ls->hashfuncs if so.
+ */
+static void
+init_list_hash_functions(PartitionNode *partnode, TupleDesc tupdesc,
+						 PartitionListState *ls)
+{
+	Partition  *part = partnode->part;
+	List	   *opname = list_make2(makeString("pg_catalog"), makeString("="));
+	int			i;
+
+	ls->hashfuncs = MemoryContextAllocZero(ls->cxt, sizeof(FmgrInfo) * part->parnatts);
+	ls->hashable = 1;
+
+	for (i = 0; i < part->parnatts; i++)
+	{
+		Oid			typid = tupdesc->attrs[part->paratts[i] - 1]->atttypid;
+		TypeCacheEntry *typentry = lookup_type_cache(typid, TYPECACHE_EQ_OPR);
+		RegProcedure lhs_proc;
+		RegProcedure rhs_proc;
+
+		if (!OidIsValid(typentry->eq_opr) ||
+			!op_hashjoinable(typentry->eq_opr) ||
+			!get_op_hash_functions(typentry->eq_opr, &lhs_proc, &rhs_proc) ||
+			lhs_proc != rhs_proc ||
+			get_opcode(typentry->eq_opr) != get_opfuncid_by_opname(opname, typid, typid))
+		{
+			ls->hashable = -1;
+			break;
+		}
+
+		fmgr_info_cxt(lhs_proc, &ls->hashfuncs[i], ls->cxt);
+	}
+
+	list_free_deep(opname);
+}
+
+/*
+ * Build the PartitionListValues of a LIST PartitionNode: every list value of
+ * every rule, sorted by hash. Left empty, with nlistvalues -1, if the values
+ * can't be hashed.
+ */
+static void
+build_partition_list_values(PartitionNodeIndex *pni, PartitionNode *partnode,
+							TupleDesc tupdesc, PartitionListState *ls)
+{
+	Partition  *part = partnode->part;
+	PartitionListValue *listvalues;
+	int			nlistvalues = 0;
+	int			ruleno = 0;
+	ListCell   *lc;
+
+	if (ls->hashable == 0)
+		init_list_hash_functions(partnode, tupdesc, ls);
+	if (ls->hashable < 0)
+		return;
+
+	foreach(lc, partnode->rules)
+		nlistvalues += list_length(((PartitionRule *) lfirst(lc))->parlistvalues);
+
+	listvalues = palloc(sizeof(PartitionListValue) * Max(nlistvalues, 1));
+	nlistvalues = 0;
+
+	foreach(lc, partnode->rules)
+	{
+		PartitionRule *rule = (PartitionRule *) lfirst(lc);
+		ListCell   *lc2;
+
+		foreach(lc2, rule->parlistvalues)
+		{
+			List	   *colvals = (List *) lfirst(lc2);
+			ListCell   *lc3;
+			int			i = 0;
+
+			if (list_length(colvals) != part->parnatts)
+			{
+				pfree(listvalues);
+				return;
+			}
+
+			/* the hash functions are for the types of the key columns */
+			foreach(lc3, colvals)
+			{
+				Const	   *c = (Const *) lfirst(lc3);
+
+				if (!c->constisnull &&
+					c->consttype != tupdesc->attrs[part->paratts[i] - 1]->atttypid)
+				{
+					pfree(listvalues);
+					return;
+				}
+				i++;
+			}
+
+			listvalues[nlistvalues].hash = list_values_hash_consts(colvals, ls);
+			listvalues[nlistvalues].ruleno = ruleno;
+			listvalues[nlistvalues].colvals = colvals;
+			listvalues[nlistvalues].rule = rule;
+			nlistvalues++;
+		}
+		ruleno++;
+	}
+
+	qsort(listvalues, nlistvalues, sizeof(PartitionListValue), list_value_cmp);
+
+	pni->listvalues = listvalues;
+	pni->nlistvalues = nlistvalues;
+}
+
+/*
+ * Get the PartitionNodeIndex of a PartitionNode from nodeIndexes, building it
+ * in cxt the first time.
+ *
+ * This is only worth it when the index is used for many tuples, that is when
+ * the partition state is kept in a PartitionAccessMethods.
+ */
+static PartitionNodeIndex *
+get_partition_node_index(HTAB **nodeIndexes, MemoryContext cxt,
+						 PartitionNode *partnode, TupleDesc tupdesc,
+						 PartitionListState *ls)
+{
+	PartitionNodeIndex *pni;
+	PartitionRule **rules;
+	MemoryContext oldcxt;
+	ListCell   *lc;
+	bool		found;
+	int			i = 0;
+
+	if (*nodeIndexes == NULL)
+	{
+		HASHCTL		ctl;
+
+		MemSet(&ctl, 0, sizeof(ctl));
+		ctl.keysize = sizeof(PartitionNode *);
+		ctl.entrysize = sizeof(PartitionNodeIndex);
+		ctl.hash = tag_hash;
+		ctl.hcxt = cxt;
+		*nodeIndexes = hash_create("partition rule indexes", 16, &ctl,
+								   HASH_ELEM | HASH_FUNCTION | HASH_CONTEXT);
+	}
+
+	pni = (PartitionNodeIndex *) hash_search(*nodeIndexes, &partnode,
+											 HASH_ENTER, &found);
+	if (found)
+		return pni;
+
+	pni->nrules = 0;
+	pni->rules = NULL;
+	pni->nlistvalues = -1;
+	pni->listvalues = NULL;
+
+	oldcxt = MemoryContextSwitchTo(cxt);
+
+	rules = palloc(sizeof(PartitionRule *) * Max(list_length(partnode->rules), 1));
+	foreach(lc, partnode->rules)
+		rules[i++] = (PartitionRule *) lfirst(lc);
+	pni->rules = rules;
+	pni->nrules = i;
+
+	if (ls)
+		build_partition_list_values(pni, partnode, tupdesc, ls);
+
+	MemoryContextSwitchTo(oldcxt);
+
+	return pni;
+}
+
+/*
+ * Does the tuple match the list values colvals of a rule?
+ */
+static bool
+list_values_match(Partition *part, List *colvals, Datum *values, bool *isnull,
+				  TupleDesc tupdesc, PartitionListState *ls, Oid exprTypeOid)
+{
+	ListCell   *lc3;
+	int			i = 0;
+
+	foreach(lc3, colvals)
+	{
+		Const	   *c = lfirst(lc3);
+		AttrNumber	attno = part->paratts[i];
+
+		if (isnull[attno - 1])
+		{
+			if (!c->constisnull)
+				return false;
+		}
+		else if (c->constisnull)
+		{
+			/* constant is null but datum isn't so break */
+			return false;
+		}
+		else
+		{
+			Datum		res;
+			Datum		d = values[attno - 1];
+			FmgrInfo   *finfo;
+
+			if (!ls->eqinit[i])
+			{
+
+				/*
+				 * Compute the type of the LHS and RHS for the equality
+				 * comparator. The way we call the comparator is comp(expr,
+				 * rule) So lhstypid = type(expr) and rhstypeid = type(rule)
+				 */
+
+				/*
+				 * The tupdesc tuple descriptor matches the table schema, so
+				 * it has the rule type
+				 */
+				Oid			rhstypid = tupdesc->attrs[attno - 1]->atttypid;
+
+				/*
+				 * exprTypeOid is passed to us from our caller which evaluated
+				 * the expression. In some cases (e.g legacy optimizer doing
+				 * explicit casting), we don't compute specify exprTypeOid.
+				 * Assume lhstypid = rhstypid in those cases
+				 */
+				Oid			lhstypid = exprTypeOid;
+
+				if (!OidIsValid(lhstypid))
+				{
+					lhstypid = rhstypid;
+				}
+
+				List	   *opname = list_make2(makeString("pg_catalog"),
+												makeString("="));
+
+				Oid			opfuncid = get_opfuncid_by_opname(opname, lhstypid, rhstypid);
+
+				fmgr_info(opfuncid, &(ls->eqfuncs[i]));
+				ls->eqinit[i] = true;
+			}
+
+			finfo = &(ls->eqfuncs[i]);
+			res = FunctionCall2(finfo, d, c->constvalue);
+
+			if (!DatumGetBool(res))
+				return false;
+		}
+		i++;
+	}
+
+	return true;
+}
+
 /*
  *	Given a partition-by-list PartitionNode, search for
  *	a part that matches the given datum value.
@@ -3831,6 +4281,7 @@ selectListPartition(PartitionNode *partnode, Datum *values, bool *isnull,
 	Partition  *part = partnode->part;
 	MemoryContext oldcxt = NULL;
 	PartitionListState *ls;
+	PartitionRule *matchedRule = NULL;
 
 	if (accessMethods && accessMethods->amstate[partnode->part->parlevel])
 		ls = (PartitionListState *) accessMethods->amstate[partnode->part->parlevel];
@@ -3842,6 +4293,10 @@ selectListPartition(PartitionNode *partnode, Datum *values, bool *isnull,
 
 		ls->eqfuncs = palloc(sizeof(FmgrInfo) * natts);
 		ls->eqinit = palloc0(sizeof(bool) * natts);
+		ls->hashfuncs = NULL;
+		ls->hashable = 0;
+		ls->nodeIndexes = NULL;
+		ls->cxt = CurrentMemoryContext;
 
 		if (accessMethods)
 			accessMethods->amstate[partnode->part->parlevel] = (void *) ls;
@@ -3852,13 +4307,56 @@ selectListPartition(PartitionNode *partnode, Datum *values, bool *isnull,
 
 	*foundOid = InvalidOid;
 
-	/* With LIST, we have no choice at the moment except to be exhaustive */
+	/*
+	 * If the state is kept for the next tuples, look the values up by hash
+	 * among all the values of all the rules. That needs the expression to be
+	 * of the type the values are hashed as.
+	 */
+	if (accessMethods &&
+		(!OidIsValid(exprTypeOid) ||
+		 (part->parnatts == 1 &&
+		  exprTypeOid == tupdesc->attrs[part->paratts[0] - 1]->atttypid)))
+	{
+		PartitionNodeIndex *pni = get_partition_node_index(&ls->nodeIndexes, ls->cxt,
+														   partnode, tupdesc, ls);
+
+		if (pni->nlistvalues >= 0)
+		{
+			uint32		hash = list_values_hash_tuple(part, values, isnull, ls);
+			int			low = 0;
+			int			high = pni->nlistvalues;
+
+			/* find the first value with this hash */
+			while (low < high)
+			{
+				int			mid = low + (high - low) / 2;
+
+				if (pni->listvalues[mid].hash < hash)
+					low = mid + 1;
+				else
+					high = mid;
+			}
+
+			/* they are in rule order, so the first match is the right one */
+			for (; low < pni->nlistvalues && pni->listvalues[low].hash == hash; low++)
+			{
+				if (list_values_match(part, pni->listvalues[low].colvals,
+									  values, isnull, tupdesc, ls, exprTypeOid))
+				{
+					matchedRule = pni->listvalues[low].rule;
+					break;
+				}
+			}
+
+			goto l_fin_list;
+		}
+	}
+
+	/* Otherwise, we have no choice except to be exhaustive */
 	foreach(lc, partnode->rules)
 	{
 		PartitionRule *rule = lfirst(lc);
-		List	   *vals = rule->parlistvalues;
 		ListCell   *lc2;
-		bool		matched = false;
 
 		/*
 		 * list values are stored in a list of lists to support multi column
@@ -3870,114 +4368,36 @@ selectListPartition(PartitionNode *partnode, Datum *values, bool *isnull,
 		 *
 		 * Each iteraction is one element of the values list. In the first
 		 * example, we iterate '1', '2' then '3'. For the second, we iterate
-		 * through '(1, '2005-01-01')' then '(2, '2006-01-01')'. It's for that
-		 * reason that we need the inner loop.
+		 * through '(1, '2005-01-01')' then '(2, '2006-01-01')'.
 		 */
-		foreach(lc2, vals)
+		foreach(lc2, rule->parlistvalues)
 		{
-			ListCell   *lc3;
-			List	   *colvals = (List *) lfirst(lc2);
-			int			i = 0;
-
-			matched = true;		/* prove untrue */
-
-			foreach(lc3, colvals)
+			if (list_values_match(part, (List *) lfirst(lc2), values, isnull,
+								  tupdesc, ls, exprTypeOid))
 			{
-				Const	   *c = lfirst(lc3);
-				AttrNumber	attno = part->paratts[i];
-
-				if (isnull[attno - 1])
-				{
-					if (!c->constisnull)
-					{
-						matched = false;
-						break;
-					}
-				}
-				else if (c->constisnull)
-				{
-					/* constant is null but datum isn't so break */
-					matched = false;
-					break;
-				}
-				else
-				{
-					Datum		res;
-					Datum		d = values[attno - 1];
-					FmgrInfo   *finfo;
-
-					if (!ls->eqinit[i])
-					{
-
-						/*
-						 * Compute the type of the LHS and RHS for the
-						 * equality comparator. The way we call the comparator
-						 * is comp(expr, rule) So lhstypid = type(expr) and
-						 * rhstypeid = type(rule)
-						 */
-
-						/*
-						 * The tupdesc tuple descriptor matches the table
-						 * schema, so it has the rule type
-						 */
-						Oid			rhstypid = tupdesc->attrs[attno - 1]->atttypid;
-
-						/*
-						 * exprTypeOid is passed to us from our caller which
-						 * evaluated the expression. In some cases (e.g legacy
-						 * optimizer doing explicit casting), we don't compute
-						 * specify exprTypeOid. Assume lhstypid = rhstypid in
-						 * those cases
-						 */
-						Oid			lhstypid = exprTypeOid;
-
-						if (!OidIsValid(lhstypid))
-						{
-							lhstypid = rhstypid;
-						}
-
-						List	   *opname = list_make2(makeString("pg_catalog"),
-														makeString("="));
-
-						Oid			opfuncid = get_opfuncid_by_opname(opname, lhstypid, rhstypid);
-
-						fmgr_info(opfuncid, &(ls->eqfuncs[i]));
-						ls->eqinit[i] = true;
-					}
-
-					finfo = &(ls->eqfuncs[i]);
-					res = FunctionCall2(finfo, d, c->constvalue);
-
-					if (!DatumGetBool(res))
-					{
-						/* found it */
-						matched = false;
-						break;
-					}
-				}
-				i++;
-			}
-			if (matched)
+				matchedRule = rule;
 				break;
+			}
 		}
 
-		if (matched)
-		{
-			*foundOid = rule->parchildrelid;
-			*prule = rule;
-
-			/* go to the next level */
-			if (oldcxt)
-				MemoryContextSwitchTo(oldcxt);
-			return rule->children;
-		}
+		if (matchedRule)
+			break;
 	}
 
+l_fin_list:
 	if (oldcxt)
 		MemoryContextSwitchTo(oldcxt);
 
-	return NULL;
+	if (matchedRule)
+	{
+		*foundOid = matchedRule->parchildrelid;
+		*prule = matchedRule;
 
+		/* go to the next level */
+		return matchedRule->children;
+	}
+
+	return NULL;
 }
 
 /*
@@ -4174,6 +4594,7 @@ selectRangePartition(PartitionNode *partnode, Datum *values, bool *isnull,
 	PartitionRule *rule = NULL;
 	PartitionNode *pNode = NULL;
 	PartitionRangeState *rs = NULL;
+	PartitionRule **rulearray = NULL;
 	MemoryContext oldcxt = NULL;
 
 	Assert(partnode->part->parkind == 'r');
@@ -4212,24 +4633,18 @@ selectRangePartition(PartitionNode *partnode, Datum *values, bool *isnull,
 			rs->lefuncs_inverse[keyno].fn_oid = InvalidOid;
 		}
 
-		/*
-		 * Unrolling the rules into an array currently works for the top level
-		 * partition only
-		 */
-		if (partnode->part->parlevel == 0)
-		{
-			int			i = 0;
-			ListCell   *lc;
-
-			rs->rules = palloc(sizeof(PartitionRule *) * list_length(rules));
-
-			foreach(lc, rules)
-				rs->rules[i++] = (PartitionRule *) lfirst(lc);
-		}
-		else
-			rs->rules = NULL;
+		rs->nodeIndexes = NULL;
+		rs->cxt = CurrentMemoryContext;
 	}
 
+	/*
+	 * If the state is kept for the next tuples, unroll the rules into an
+	 * array, so that the search below doesn't walk the list.
+	 */
+	if (accessMethods)
+		rulearray = get_partition_node_index(&rs->nodeIndexes, rs->cxt,
+											 partnode, tupdesc, NULL)->rules;
+
 	if (accessMethods && accessMethods->part_cxt)
 		oldcxt = MemoryContextSwitchTo(accessMethods->part_cxt);
 
@@ -4262,8 +4677,8 @@ selectRangePartition(PartitionNode *partnode, Datum *values, bool *isnull,
 
 		mid = low + (high - low) / 2;
 
-		if (rs->rules)
-			rule = rs->rules[mid];
+		if (rulearray)
+			rule = rulearray[mid];
 		else
 			rule = (PartitionRule *) list_nth(rules, mid);
 
@@ -4338,7 +4753,8 @@ selectRangePartition(PartitionNode *partnode, Datum *values, bool *isnull,
 				int			ret;
 
 				if (j != mid)
-					rule = (PartitionRule *) list_nth(rules, j);
+					rule = rulearray ? rulearray[j] :
+						(PartitionRule *) list_nth(rules, j);
 
 				if (isnull[attno - 1])
 				{
@@ -4398,7 +4814,8 @@ selectRangePartition(PartitionNode *partnode, Datum *values, bool *isnull,
 				Datum		d = values[attno - 1];
 				int			ret;
 
-				rule = (PartitionRule *) list_nth(rules, j);
+				rule = rulearray ? rulearray[j] :
+					(PartitionRule *) list_nth(rules, j);
 
 				if (isnull[attno - 1])
 				{
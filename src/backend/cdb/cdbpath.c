@@ -15,9 +15,11 @@
 
 #include "catalog/pg_operator.h"
 #include "catalog/pg_proc.h"	/* CDB_PROC_TIDTOI8 */
+#include "catalog/pg_statistic.h"	/* STATISTIC_KIND_MCV */
 #include "catalog/pg_type.h"	/* INT8OID */
 #include "nodes/makefuncs.h"	/* makeFuncExpr() */
 #include "nodes/relation.h"		/* PlannerInfo, RelOptInfo, CdbRelDedupInfo */
+#include "optimizer/clauses.h"	/* get_leftop() */
 #include "optimizer/cost.h"		/* cpu_tuple_cost */
 #include "optimizer/pathnode.h" /* Path, pathnode_walker() */
 #include "optimizer/paths.h"
@@ -26,6 +28,8 @@
 #include "parser/parse_expr.h"	/* exprType() */
 #include "parser/parse_oper.h"
 
+#include "utils/lsyscache.h"	/* get_attstatsslot() */
+#include "utils/selfuncs.h"		/* examine_variable() */
 #include "utils/syscache.h"
 
 #include "cdb/cdbdef.h"			/* CdbSwap() */
@@ -768,6 +772,15 @@ cdbpath_partkeys_from_preds(PlannerInfo *root,
  * It comes from select_mergejoin_clauses() in joinpath.c.
  */
 
+static int
+cdbpath_compare_hashes(const void *a, const void *b)
+{
+	uint32		ha = *(const uint32 *) a;
+	uint32		hb = *(const uint32 *) b;
+
+	return (ha > hb) - (ha < hb);
+}
+
 typedef struct
 {
 	CdbPathLocus locus;
@@ -779,6 +792,97 @@ typedef struct
 	bool		has_wts;		/* Does the rel have WorkTableScan? */
 } CdbpathMfjRel;
 
+/*
+ * cdbpath_hot_key_hashes
+ *    Finds the hot join keys of a rel that is about to be redistributed on
+ *    the equijoin predicate in mergeclause_list.
+ *
+ *    A key is hot if pg_statistic says it occurs in at least
+ *    gp_motion_hot_key_fraction of the rel's rows.  Returns the number of
+ *    hot keys and a palloc'd, sorted array of their cdbhash() values in
+ *    *p_hashes.  Only a single equijoin predicate on a column with MCV
+ *    statistics is considered.
+ */
+static int
+cdbpath_hot_key_hashes(PlannerInfo *root,
+					   List *mergeclause_list,
+					   Path *path,
+					   uint32 **p_hashes)
+{
+	RestrictInfo *rinfo;
+	Node	   *expr;
+	VariableStatData vardata;
+	Datum	   *values;
+	int			nvalues;
+	float4	   *numbers;
+	int			nnumbers;
+	uint32	   *hashes;
+	int			nhashes = 0;
+	Oid			typid;
+	int			i;
+
+	if (gp_motion_hot_key_fraction <= 0.0 ||
+		list_length(mergeclause_list) != 1)
+		return 0;
+
+	rinfo = (RestrictInfo *) linitial(mergeclause_list);
+	if (!is_opclause(rinfo->clause))
+		return 0;
+	if (bms_is_subset(rinfo->left_relids, path->parent->relids))
+		expr = (Node *) get_leftop(rinfo->clause);
+	else if (bms_is_subset(rinfo->right_relids, path->parent->relids))
+		expr = (Node *) get_rightop(rinfo->clause);
+	else
+		return 0;
+
+	examine_variable(root, expr, 0, &vardata);
+	if (!HeapTupleIsValid(vardata.statsTuple))
+	{
+		ReleaseVariableStats(vardata);
+		return 0;
+	}
+
+	typid = getBaseType(vardata.atttype);
+	if (!isGreenplumDbHashable(typid) ||
+		!get_attstatsslot(vardata.statsTuple,
+						  vardata.atttype, vardata.atttypmod,
+						  STATISTIC_KIND_MCV, InvalidOid,
+						  &values, &nvalues,
+						  &numbers, &nnumbers))
+	{
+		ReleaseVariableStats(vardata);
+		return 0;
+	}
+
+	hashes = palloc(nvalues * sizeof(uint32));
+	for (i = 0; i < nvalues && i < nnumbers; i++)
+	{
+		CdbHash    *h;
+
+		if (numbers[i] < gp_motion_hot_key_fraction)
+			continue;
+
+		h = makeCdbHash(root->config->cdbpath_segments);
+		cdbhashinit(h);
+		cdbhash(h, values[i], typid);
+		hashes[nhashes++] = h->hash;
+		pfree(h);
+	}
+
+	free_attstatsslot(vardata.atttype, values, nvalues, numbers, nnumbers);
+	ReleaseVariableStats(vardata);
+
+	if (nhashes == 0)
+	{
+		pfree(hashes);
+		return 0;
+	}
+
+	qsort(hashes, nhashes, sizeof(uint32), cdbpath_compare_hashes);
+	*p_hashes = hashes;
+	return nhashes;
+}								/* cdbpath_hot_key_hashes */
+
 CdbPathLocus
 cdbpath_motion_for_join(PlannerInfo *root,
 						JoinType jointype,	/* JOIN_INNER/FULL/LEFT/RIGHT/IN */
@@ -792,6 +896,9 @@ cdbpath_motion_for_join(PlannerInfo *root,
 {
 	CdbpathMfjRel outer;
 	CdbpathMfjRel inner;
+	CdbpathMfjRel *spread = NULL;
+	uint32	   *hot_hashes = NULL;
+	int			num_hot_hashes = 0;
 
 	outer.path = *p_outer_path;
 	inner.path = *p_inner_path;
@@ -1051,6 +1158,24 @@ cdbpath_motion_for_join(PlannerInfo *root,
 											 &large->move_to,
 											 &small->move_to))
 		{
+			/*
+			 * If a few join keys account for much of one rel, hashing would
+			 * pile up their rows on a few segments.  Spread that rel's hot-key
+			 * rows round-robin instead, and broadcast the other rel's rows
+			 * with those keys.  The broadcast side must not be the preserved
+			 * side of an outer join, or its unmatched rows would be emitted
+			 * once per segment.
+			 */
+			if (jointype == JOIN_INNER)
+				spread = large;
+			else if (jointype == JOIN_LEFT)
+				spread = &outer;
+
+			if (spread)
+				num_hot_hashes = cdbpath_hot_key_hashes(root,
+														mergeclause_list,
+														spread->path,
+														&hot_hashes);
 		}
 
 		/*
@@ -1101,6 +1226,34 @@ cdbpath_motion_for_join(PlannerInfo *root,
 			goto fail;
 	}
 
+	/*
+	 * Mark the hot keys on both Redistribute Motions.  The join result is then
+	 * no longer hashed on the join key, so it is reported as strewn.
+	 */
+	if (num_hot_hashes > 0 &&
+		outer.path != *p_outer_path &&
+		inner.path != *p_inner_path &&
+		IsA(outer.path, CdbMotionPath) &&
+		IsA(inner.path, CdbMotionPath))
+	{
+		CdbMotionPath *outer_motion = (CdbMotionPath *) outer.path;
+		CdbMotionPath *inner_motion = (CdbMotionPath *) inner.path;
+		CdbPathLocus locus;
+
+		outer_motion->skewMode = (spread == &outer) ? MOTIONSKEW_SPREAD : MOTIONSKEW_BROADCAST;
+		outer_motion->numSkewHashes = num_hot_hashes;
+		outer_motion->skewHashes = hot_hashes;
+		inner_motion->skewMode = (spread == &inner) ? MOTIONSKEW_SPREAD : MOTIONSKEW_BROADCAST;
+		inner_motion->numSkewHashes = num_hot_hashes;
+		inner_motion->skewHashes = hot_hashes;
+
+		*p_outer_path = outer.path;
+		*p_inner_path = inner.path;
+
+		CdbPathLocus_MakeStrewn(&locus);
+		return locus;
+	}
+
 	/*
 	 * Ok to join.  Give modified subpaths to caller.
 	 */
@@ -177,6 +177,11 @@ cdbpathtoplan_create_motion_plan(PlannerInfo *root,
 		motion = make_hashed_motion(subplan,
 									hashExpr,
 									false /* useExecutorVarFormat */ );
+
+		/* Route the hot join keys, if cdbpath_motion_for_join found any. */
+		motion->skewMode = path->skewMode;
+		motion->numSkewHashes = path->numSkewHashes;
+		motion->skewHashes = path->skewHashes;
 	}
 	else
 		Insist(0);
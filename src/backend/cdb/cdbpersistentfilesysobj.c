@@ -6072,6 +6072,78 @@ void PersistentFileSysObj_ResynchronizeRelationComplete(
 
 }
 
+/*
+ * Does the gp_persistent_relation_node tuple at persistentTid still describe
+ * the given, not yet dropped, relation file with the given serial number?
+ */
+static bool PersistentFileSysObj_RelationTupleMatches(
+	RelFileNode 		*relFileNode,
+	int32				segmentFileNum,
+	ItemPointer			persistentTid,
+	int64				persistentSerialNum)
+{
+	Datum values[Natts_gp_persistent_relation_node];
+	HeapTuple tupleCopy;
+
+	RelFileNode 					candidateRelFileNode;
+	int32 							candidateSegmentFileNum;
+
+	PersistentFileSysRelStorageMgr	relationStorageManager;
+	PersistentFileSysState			persistentState;
+	int64							createMirrorDataLossTrackingSessionNum;
+	MirroredObjectExistenceState	mirrorExistenceState;
+	MirroredRelDataSynchronizationState mirrorDataSynchronizationState;
+	bool							mirrorBufpoolMarkedForScanIncrementalResync;
+	int64							mirrorBufpoolResyncChangedPageCount;
+	XLogRecPtr						mirrorBufpoolResyncCkptLoc;
+	BlockNumber 					mirrorBufpoolResyncCkptBlockNum;
+	int64							mirrorAppendOnlyLossEof;
+	int64							mirrorAppendOnlyNewEof;
+	PersistentFileSysRelBufpoolKind relBufpoolKind;
+	TransactionId					parentXid;
+	int64							serialNum;
+
+	PersistentFileSysObj_ReadTuple(
+							PersistentFsObjType_RelationFile,
+							persistentTid,
+							values,
+							&tupleCopy);
+	if (tupleCopy == NULL)
+		return false;
+
+	GpPersistentRelationNode_GetValues(
+									values,
+									&candidateRelFileNode.spcNode,
+									&candidateRelFileNode.dbNode,
+									&candidateRelFileNode.relNode,
+									&candidateSegmentFileNum,
+									&relationStorageManager,
+									&persistentState,
+									&createMirrorDataLossTrackingSessionNum,
+									&mirrorExistenceState,
+									&mirrorDataSynchronizationState,
+									&mirrorBufpoolMarkedForScanIncrementalResync,
+									&mirrorBufpoolResyncChangedPageCount,
+									&mirrorBufpoolResyncCkptLoc,
+									&mirrorBufpoolResyncCkptBlockNum,
+									&mirrorAppendOnlyLossEof,
+									&mirrorAppendOnlyNewEof,
+									&relBufpoolKind,
+									&parentXid,
+									&serialNum);
+
+	heap_freetuple(tupleCopy);
+
+	if (persistentState != PersistentFileSysState_BulkLoadCreatePending &&
+		persistentState != PersistentFileSysState_CreatePending &&
+		persistentState != PersistentFileSysState_Created)
+		return false;
+
+	return (RelFileNodeEquals(candidateRelFileNode, *relFileNode) &&
+			candidateSegmentFileNum == segmentFileNum &&
+			serialNum == persistentSerialNum);
+}
+
 bool PersistentFileSysObj_ScanForRelation(
 	RelFileNode 		*relFileNode,
 				/* The tablespace, database, and relation OIDs for the create. */
@@ -6115,6 +6187,44 @@ bool PersistentFileSysObj_ScanForRelation(
 								&fileSysObjData,
 								&fileSysObjSharedData);
 
+	/*
+	 * Try the relation file index first.  It only tells us where the tuple
+	 * was, so check it is still there before believing it.
+	 */
+	if (PersistentRelation_IndexLookup(
+								relFileNode,
+								segmentFileNum,
+								persistentTid,
+								persistentSerialNum))
+	{
+		READ_PERSISTENT_STATE_ORDERED_LOCK;
+
+		found = PersistentFileSysObj_RelationTupleMatches(
+												relFileNode,
+												segmentFileNum,
+												persistentTid,
+												*persistentSerialNum);
+
+		READ_PERSISTENT_STATE_ORDERED_UNLOCK;
+
+		if (found)
+		{
+			if (Debug_persistent_print)
+				elog(Persistent_DebugPrintLevel(),
+				     "Index found persistent relation %u/%u/%u, segment file #%d with serial number " INT64_FORMAT " at TID %s",
+					 relFileNode->spcNode,
+					 relFileNode->dbNode,
+					 relFileNode->relNode,
+					 segmentFileNum,
+					 *persistentSerialNum,
+					 ItemPointerToString(persistentTid));
+
+			return true;
+		}
+
+		PersistentRelation_IndexRemove(relFileNode, segmentFileNum);
+	}
+
 	found = false;
 	MemSet(persistentTid, 0, sizeof(ItemPointerData));
 	*persistentSerialNum = 0;
@@ -6193,6 +6303,13 @@ bool PersistentFileSysObj_ScanForRelation(
 
 	PersistentStore_EndScan(&storeScan);
 
+	if (found)
+		PersistentRelation_IndexAdd(
+								relFileNode,
+								segmentFileNum,
+								persistentTid,
+								*persistentSerialNum);
+
 	if (found && Debug_persistent_print)
 		elog(Persistent_DebugPrintLevel(),
 		     "Scan found persistent relation %u/%u/%u, segment file #%d with serial number " INT64_FORMAT " at TID %s",
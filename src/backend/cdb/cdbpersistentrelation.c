@@ -39,11 +39,13 @@
 #include "storage/itemptr.h"
 #include "utils/hsearch.h"
 #include "storage/shmem.h"
+#include "storage/spin.h"
 #include "utils/guc.h"
 #include "storage/smgr.h"
 #include "storage/ipc.h"
 #include "utils/builtins.h"
 #include "utils/faultinjector.h"
+#include "utils/syncrefhashtable.h"
 
 /*
  * This module is for generic relation file create and drop.
@@ -77,6 +79,158 @@ PersistentRelationSharedData *persistentRelationSharedData = NULL;
 
 PersistentRelationData persistentRelationData = PersistentRelationData_StaticInit;
 
+/*
+ * The relation file index maps a relation file (RelFileNode and segment file
+ * number) to the TID and serial number of its gp_persistent_relation_node
+ * tuple, so that finding it doesn't need a scan of the whole persistent table
+ * under the persistent lock.  It is a SyncHT, locked by partition.
+ *
+ * The index is only a hint: entries are added when a relation file is added
+ * to the persistent table or found by a scan, and removed when it is dropped,
+ * but a lookup always re-reads the tuple and checks it still describes the
+ * relation file with the same serial number.  Once the index is full nothing
+ * more is added to it.
+ */
+typedef struct PersistentRelationIndexKey
+{
+	RelFileNode relFileNode;
+	int32		segmentFileNum;
+} PersistentRelationIndexKey;
+
+typedef struct PersistentRelationIndexEntry
+{
+	PersistentRelationIndexKey key;
+	int32		pinCount;		/* maintained by SyncHT */
+
+	slock_t		mutex;			/* protects the fields below */
+	bool		valid;
+	ItemPointerData persistentTid;
+	int64		persistentSerialNum;
+} PersistentRelationIndexEntry;
+
+static SyncHT *persistentRelationIndex = NULL;
+
+static bool
+PersistentRelation_IndexEntryIsEmpty(const void *entry)
+{
+	return !((PersistentRelationIndexEntry *) entry)->valid;
+}
+
+static void
+PersistentRelation_IndexEntryInit(void *entry)
+{
+	PersistentRelationIndexEntry *e = (PersistentRelationIndexEntry *) entry;
+
+	SpinLockInit(&e->mutex);
+	e->pinCount = 0;
+	e->valid = false;
+}
+
+static void
+PersistentRelation_IndexMakeKey(PersistentRelationIndexKey *key,
+								RelFileNode *relFileNode,
+								int32 segmentFileNum)
+{
+	MemSet(key, 0, sizeof(PersistentRelationIndexKey));
+	key->relFileNode = *relFileNode;
+	key->segmentFileNum = segmentFileNum;
+}
+
+/*
+ * Remember where the persistent tuple of a relation file is.
+ */
+void
+PersistentRelation_IndexAdd(RelFileNode *relFileNode,
+							int32 segmentFileNum,
+							ItemPointer persistentTid,
+							int64 persistentSerialNum)
+{
+	volatile PersistentRelationIndexEntry *entry;
+	PersistentRelationIndexKey key;
+	bool		existing;
+
+	if (persistentRelationIndex == NULL)
+		return;
+
+	PersistentRelation_IndexMakeKey(&key, relFileNode, segmentFileNum);
+
+	entry = SyncHTInsert(persistentRelationIndex, &key, &existing);
+	if (entry == NULL)
+		return;					/* the index is full */
+
+	SpinLockAcquire(&entry->mutex);
+	entry->persistentTid = *persistentTid;
+	entry->persistentSerialNum = persistentSerialNum;
+	entry->valid = true;
+	SpinLockRelease(&entry->mutex);
+
+	SyncHTRelease(persistentRelationIndex, (void *) entry);
+}
+
+/*
+ * Look up where the persistent tuple of a relation file was, last we knew.
+ * The caller must verify the tuple.
+ */
+bool
+PersistentRelation_IndexLookup(RelFileNode *relFileNode,
+							   int32 segmentFileNum,
+							   ItemPointer persistentTid,
+							   int64 *persistentSerialNum)
+{
+	volatile PersistentRelationIndexEntry *entry;
+	PersistentRelationIndexKey key;
+	bool		found = false;
+
+	if (persistentRelationIndex == NULL)
+		return false;
+
+	PersistentRelation_IndexMakeKey(&key, relFileNode, segmentFileNum);
+
+	entry = SyncHTLookup(persistentRelationIndex, &key);
+	if (entry == NULL)
+		return false;
+
+	SpinLockAcquire(&entry->mutex);
+	if (entry->valid)
+	{
+		*persistentTid = entry->persistentTid;
+		*persistentSerialNum = entry->persistentSerialNum;
+		found = true;
+	}
+	SpinLockRelease(&entry->mutex);
+
+	SyncHTRelease(persistentRelationIndex, (void *) entry);
+
+	return found;
+}
+
+/*
+ * Forget a relation file.  The entry leaves the index once nobody has it
+ * pinned.
+ */
+void
+PersistentRelation_IndexRemove(RelFileNode *relFileNode,
+							   int32 segmentFileNum)
+{
+	volatile PersistentRelationIndexEntry *entry;
+	PersistentRelationIndexKey key;
+
+	if (persistentRelationIndex == NULL)
+		return;
+
+	PersistentRelation_IndexMakeKey(&key, relFileNode, segmentFileNum);
+
+	entry = SyncHTLookup(persistentRelationIndex, &key);
+	if (entry == NULL)
+		return;
+
+	SpinLockAcquire(&entry->mutex);
+	entry->valid = false;
+	SpinLockRelease(&entry->mutex);
+
+	SyncHTRelease(persistentRelationIndex, (void *) entry);
+}
+
 static void
 PersistentRelation_VerifyInitScan(void)
 {
@@ -348,6 +502,9 @@ PersistentRelation_AddCreatePending(
 								  persistentTid,
 								  serialNum);
 
+	PersistentRelation_IndexAdd(relFileNode, segmentFileNum,
+								persistentTid, *serialNum);
+
 	/*
 	 * This XLOG must be generated under the persistent write-lock.
 	 */
@@ -472,6 +629,9 @@ PersistentRelation_AddCreated(
 								  persistentTid,
 								  persistentSerialNum);
 
+	PersistentRelation_IndexAdd(relFileNode, segmentFileNum,
+								persistentTid, *persistentSerialNum);
+
 	WRITE_PERSISTENT_STATE_ORDERED_UNLOCK;
 
 	if (Debug_persistent_print)
@@ -1085,6 +1245,8 @@ PersistentRelation_Dropped(
 										 &oldState,
 										 PersistentRelation_DroppedVerifiedActionCallback);
 
+	PersistentRelation_IndexRemove(relFileNode, segmentFileNum);
+
 	WRITE_PERSISTENT_STATE_ORDERED_UNLOCK;
 
 	if (Debug_persistent_print)
@@ -1207,6 +1369,11 @@ PersistentRelation_ShmemSize(void)
 	/* The shared-memory structure. */
 	size = add_size(size, PersistentRelation_SharedDataSize());
 
+	/* The relation file index. */
+	if (gp_persistent_relation_index_entries > 0)
+		size = add_size(size, hash_estimate_size(gp_persistent_relation_index_entries,
+												 sizeof(PersistentRelationIndexEntry)));
+
 	return size;
 }
 
@@ -1237,5 +1404,29 @@ PersistentRelation_ShmemInit(void)
 							  PersistentFsObjType_RelationFile,
 							   /* scanTupleCallback */ NULL);
 
+	if (gp_persistent_relation_index_entries > 0)
+	{
+		SyncHTCtl	ctl;
+
+		MemSet(&ctl, 0, sizeof(ctl));
+		ctl.keySize = sizeof(PersistentRelationIndexKey);
+		ctl.entrySize = sizeof(PersistentRelationIndexEntry);
+		ctl.hash = tag_hash;
+		ctl.match = (HashCompareFunc) memcmp;
+		ctl.keyCopy = (HashCopyFunc) memcpy;
+		ctl.tabName = "Persistent Relation Index";
+		ctl.numElements = gp_persistent_relation_index_entries;
+		ctl.baseLWLockId = FirstPersistentRelationIndexLock;
+		ctl.numPartitions = NUM_PERSISTENT_RELATION_INDEX_PARTITIONS;
+		ctl.keyOffset = GPDB_OFFSET(PersistentRelationIndexEntry, key);
+		ctl.pinCountOffset = GPDB_OFFSET(PersistentRelationIndexEntry, pinCount);
+		ctl.isEmptyEntry = PersistentRelation_IndexEntryIsEmpty;
+		ctl.initEntry = PersistentRelation_IndexEntryInit;
+
+		persistentRelationIndex = SyncHTCreate(&ctl);
+		if (persistentRelationIndex == NULL)
+			elog(FATAL, "could not initialize persistent relation index");
+	}
+
 	Assert(persistentRelationSharedData != NULL);
 }
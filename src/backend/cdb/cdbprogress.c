@@ -0,0 +1,321 @@
+/*-------------------------------------------------------------------------
+ * cdbprogress.c
+ *	   Live per-node progress of running queries, published in shared
+ *	   memory.
+ *
+ * While a backend executes a top-level query, each plan node of its slice
+ * gets a QueryProgressNode in the backend's QueryProgressSlot, and the
+ * executor counts the node's tuples, and a Motion's bytes, directly into
+ * it.  gp_query_progress() reports the slots of all backends of the local
+ * database instance, so that gp_toolkit.gp_query_progress can gather them
+ * from the master and all segments while the query runs, without
+ * gpperfmon.
+ *
+ * Portions Copyright (c) 2012-Present Pivotal Software, Inc.
+ *
+ *
+ * IDENTIFICATION
+ *	    src/backend/cdb/cdbprogress.c
+ *
+ *-------------------------------------------------------------------------
+ */
+
+#include "postgres.h"
+
+#include "access/heapam.h"
+#include "catalog/pg_type.h"
+#include "funcapi.h"
+#include "miscadmin.h"
+#include "nodes/print.h"
+#include "port/atomics.h"
+#include "storage/backendid.h"
+#include "storage/shmem.h"
+#include "utils/builtins.h"
+#include "utils/workfile_mgr.h"
+
+#include "cdb/cdbprogress.h"
+#include "cdb/cdbvars.h"
+
+#define NUM_QUERY_PROGRESS_COLUMNS 11
+
+static char *QueryProgressArray = NULL;
+
+/* the query whose nodes this backend is publishing, if any */
+static EState *progress_estate = NULL;
+
+static Size
+QueryProgressSlotSize(void)
+{
+	return MAXALIGN(offsetof(QueryProgressSlot, nodes) +
+					gp_query_progress_max_nodes * sizeof(QueryProgressNode));
+}
+
+static volatile QueryProgressSlot *
+QueryProgressGetSlot(int index)
+{
+	return (volatile QueryProgressSlot *)
+		(QueryProgressArray + index * QueryProgressSlotSize());
+}
+
+/*
+ * Report shared memory space needed by QueryProgressShmemInit.
+ */
+Size
+QueryProgressShmemSize(void)
+{
+	if (gp_query_progress_max_nodes <= 0)
+		return 0;
+
+	return mul_size(QueryProgressSlotSize(), MaxBackends);
+}
+
+/*
+ * Allocate and initialize the slots in shared memory.
+ */
+void
+QueryProgressShmemInit(void)
+{
+	bool		found;
+
+	if (gp_query_progress_max_nodes <= 0)
+		return;
+
+	QueryProgressArray = (char *)
+		ShmemInitStruct("Query Progress Array", QueryProgressShmemSize(), &found);
+
+	if (!found)
+		MemSet(QueryProgressArray, 0, QueryProgressShmemSize());
+}
+
+/*
+ * Start publishing the progress of the query of 'estate', unless this
+ * backend is already publishing an outer query: the nodes of queries run
+ * from within functions are not tracked.
+ */
+void
+QueryProgressStart(EState *estate)
+{
+	volatile QueryProgressSlot *slot;
+
+	if (QueryProgressArray == NULL || progress_estate != NULL ||
+		MyBackendId < 1 || MyBackendId > MaxBackends)
+		return;
+
+	slot = QueryProgressGetSlot(MyBackendId - 1);
+	slot->changecount++;
+	pg_write_barrier();
+
+	slot->pid = MyProcPid;
+	slot->sessionId = gp_session_id;
+	slot->commandCount = gp_command_count;
+	slot->numNodes = 0;
+
+	pg_write_barrier();
+	slot->changecount++;
+
+	progress_estate = estate;
+}
+
+/*
+ * Add a plan node of the published query to this backend's slot.
+ *
+ * Returns the node's counters, or NULL if the node is not tracked.
+ */
+QueryProgressNode *
+QueryProgressAddNode(PlanState *ps)
+{
+	volatile QueryProgressSlot *slot;
+	QueryProgressNode *node;
+
+	if (progress_estate == NULL || ps->state != progress_estate)
+		return NULL;
+
+	slot = QueryProgressGetSlot(MyBackendId - 1);
+	if (slot->numNodes >= gp_query_progress_max_nodes)
+		return NULL;
+
+	slot->changecount++;
+	pg_write_barrier();
+
+	node = (QueryProgressNode *) &slot->nodes[slot->numNodes];
+	node->planNodeId = ps->plan->plan_node_id;
+	node->sliceId = LocallyExecutingSliceIndex(ps->state);
+	StrNCpy(node->nodeType, plannode_type(ps->plan), QUERY_PROGRESS_NODE_TYPE_LEN);
+	node->planRows = ps->plan->plan_rows;
+	node->tuples = 0;
+	node->motionBytes = 0;
+	slot->numNodes++;
+
+	pg_write_barrier();
+	slot->changecount++;
+
+	return node;
+}
+
+static void
+QueryProgressClear(void)
+{
+	volatile QueryProgressSlot *slot;
+
+	slot = QueryProgressGetSlot(MyBackendId - 1);
+	slot->changecount++;
+	pg_write_barrier();
+
+	slot->pid = 0;
+	slot->numNodes = 0;
+
+	pg_write_barrier();
+	slot->changecount++;
+
+	progress_estate = NULL;
+}
+
+/*
+ * Stop publishing the query of 'estate', if it's the one being published.
+ */
+void
+QueryProgressEnd(EState *estate)
+{
+	if (progress_estate != NULL && progress_estate == estate)
+		QueryProgressClear();
+}
+
+/*
+ * A query that errors out never reaches ExecutorEnd.
+ */
+void
+AtAbort_QueryProgress(void)
+{
+	if (progress_estate != NULL)
+		QueryProgressClear();
+}
+
+/*
+ * gp_query_progress
+ *		Report the per-node progress of the queries currently being
+ *		executed by the backends of this database instance.
+ *
+ * spill_bytes is the workfile space used by the whole query on this
+ * instance, so it is the same for all nodes of a query.
+ */
+Datum
+gp_query_progress(PG_FUNCTION_ARGS)
+{
+	typedef struct Context
+	{
+		int			currentSlot;
+		int			currentNode;
+		int64		spillBytes;
+		QueryProgressSlot *local;	/* copy of the current slot */
+	} Context;
+
+	FuncCallContext *funcctx = NULL;
+	Context    *context = NULL;
+	QueryProgressSlot *local;
+	QueryProgressNode *node;
+	Datum		values[NUM_QUERY_PROGRESS_COLUMNS];
+	bool		nulls[NUM_QUERY_PROGRESS_COLUMNS];
+	HeapTuple	tuple;
+
+	if (SRF_IS_FIRSTCALL())
+	{
+		TupleDesc	tupdesc;
+		MemoryContext oldcontext;
+
+		funcctx = SRF_FIRSTCALL_INIT();
+
+		oldcontext = MemoryContextSwitchTo(funcctx->multi_call_memory_ctx);
+
+		/* this had better match the definition in pg_proc.sql */
+		tupdesc = CreateTemplateTupleDesc(NUM_QUERY_PROGRESS_COLUMNS, false);
+		TupleDescInitEntry(tupdesc, (AttrNumber) 1, "segid", INT4OID, -1, 0);
+		TupleDescInitEntry(tupdesc, (AttrNumber) 2, "pid", INT4OID, -1, 0);
+		TupleDescInitEntry(tupdesc, (AttrNumber) 3, "sess_id", INT4OID, -1, 0);
+		TupleDescInitEntry(tupdesc, (AttrNumber) 4, "command_count", INT4OID, -1, 0);
+		TupleDescInitEntry(tupdesc, (AttrNumber) 5, "slice_id", INT4OID, -1, 0);
+		TupleDescInitEntry(tupdesc, (AttrNumber) 6, "node_id", INT4OID, -1, 0);
+		TupleDescInitEntry(tupdesc, (AttrNumber) 7, "node_type", TEXTOID, -1, 0);
+		TupleDescInitEntry(tupdesc, (AttrNumber) 8, "plan_rows", FLOAT8OID, -1, 0);
+		TupleDescInitEntry(tupdesc, (AttrNumber) 9, "actual_rows", INT8OID, -1, 0);
+		TupleDescInitEntry(tupdesc, (AttrNumber) 10, "motion_bytes", INT8OID, -1, 0);
+		TupleDescInitEntry(tupdesc, (AttrNumber) 11, "spill_bytes", INT8OID, -1, 0);
+
+		funcctx->tuple_desc = BlessTupleDesc(tupdesc);
+
+		context = (Context *) palloc(sizeof(Context));
+		funcctx->user_fctx = (void *) context;
+		context->currentSlot = 0;
+		context->currentNode = 0;
+		context->spillBytes = 0;
+		context->local = NULL;
+		if (QueryProgressArray != NULL)
+			context->local = palloc0(QueryProgressSlotSize());
+		MemoryContextSwitchTo(oldcontext);
+	}
+
+	funcctx = SRF_PERCALL_SETUP();
+	context = (Context *) funcctx->user_fctx;
+	Assert(context);
+
+	if (QueryProgressArray == NULL)
+		SRF_RETURN_DONE(funcctx);
+
+	local = context->local;
+
+	/* Move on to the next slot that has nodes, if we're done with this one */
+	while (local->pid == 0 || context->currentNode >= local->numNodes)
+	{
+		volatile QueryProgressSlot *slot;
+
+		if (context->currentSlot >= MaxBackends)
+			SRF_RETURN_DONE(funcctx);
+		slot = QueryProgressGetSlot(context->currentSlot++);
+
+		/*
+		 * Follow the protocol of retrying if changecount changes while
+		 * we copy the slot, or if it's odd.
+		 */
+		for (;;)
+		{
+			int			save_changecount = slot->changecount;
+
+			pg_read_barrier();
+			memcpy(local, (char *) slot, QueryProgressSlotSize());
+			pg_read_barrier();
+
+			if (save_changecount == slot->changecount &&
+				(save_changecount & 1) == 0)
+				break;
+
+			/* Make sure we can break out of loop if stuck... */
+			CHECK_FOR_INTERRUPTS();
+		}
+
+		context->currentNode = 0;
+		if (local->pid != 0 && local->numNodes > 0)
+			context->spillBytes = WorkfileQueryspace_GetSize(local->sessionId,
+															 local->commandCount);
+	}
+
+	node = &local->nodes[context->currentNode++];
+
+	MemSet(nulls, false, sizeof(nulls));
+	values[0] = Int32GetDatum(GpIdentity.segindex);
+	values[1] = Int32GetDatum(local->pid);
+	values[2] = Int32GetDatum(local->sessionId);
+	values[3] = Int32GetDatum(local->commandCount);
+	values[4] = Int32GetDatum(node->sliceId);
+	values[5] = Int32GetDatum(node->planNodeId);
+	values[6] = CStringGetTextDatum(node->nodeType);
+	values[7] = Float8GetDatum(node->planRows);
+	values[8] = Int64GetDatum(node->tuples);
+	values[9] = Int64GetDatum(node->motionBytes);
+	values[10] = Int64GetDatum(Max(context->spillBytes, 0));
+
+	/* Only Motions move bytes */
+	if (strcmp(node->nodeType, "MOTION") != 0)
+		nulls[9] = true;
+
+	tuple = heap_form_tuple(funcctx->tuple_desc, values, nulls);
+	SRF_RETURN_NEXT(funcctx, HeapTupleGetDatum(tuple));
+}
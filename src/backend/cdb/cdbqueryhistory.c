@@ -0,0 +1,363 @@
+/*-------------------------------------------------------------------------
+ * cdbqueryhistory.c
+ *	   Memory and spill usage of recently completed queries, kept in a ring
+ *	   buffer in shared memory.
+ *
+ * While a backend executes a top-level query, it counts the bytes its
+ * operators spill to workfiles, by kind of operator, and the extra passes
+ * that HashAgg and hash joins make over their spilled data.  When the query
+ * ends, successfully or not, the backend records these together with its
+ * peak vmem and the query's memory quota in the next entry of the ring.
+ * gp_query_resource_history() reports the entries of the local database
+ * instance, so that gp_toolkit.gp_query_resource_history can show the
+ * history of the master and all segments, to size resource groups with.
+ *
+ * Portions Copyright (c) 2012-Present Pivotal Software, Inc.
+ *
+ *
+ * IDENTIFICATION
+ *	    src/backend/cdb/cdbqueryhistory.c
+ *
+ *-------------------------------------------------------------------------
+ */
+
+#include "postgres.h"
+
+#include "access/heapam.h"
+#include "catalog/pg_type.h"
+#include "executor/executor.h"
+#include "funcapi.h"
+#include "miscadmin.h"
+#include "port/atomics.h"
+#include "storage/shmem.h"
+#include "utils/resgroup.h"
+#include "utils/vmem_tracker.h"
+
+#include "cdb/cdbqueryhistory.h"
+#include "cdb/cdbvars.h"
+
+#define NUM_QUERY_HISTORY_COLUMNS 20
+
+typedef struct QueryHistoryShared
+{
+	pg_atomic_uint32 next;		/* entry to use next, modulo the size */
+	QueryHistoryEntry entries[1];	/* VARIABLE LENGTH ARRAY */
+} QueryHistoryShared;
+
+static QueryHistoryShared *QueryHistory = NULL;
+
+/* the query whose usage this backend is counting, if any */
+static EState *history_estate = NULL;
+
+/* what it has used so far */
+static QueryHistoryEntry history_current;
+
+/*
+ * Report shared memory space needed by QueryHistoryShmemInit.
+ */
+Size
+QueryHistoryShmemSize(void)
+{
+	if (gp_query_history_size <= 0)
+		return 0;
+
+	return add_size(offsetof(QueryHistoryShared, entries),
+					mul_size(gp_query_history_size, sizeof(QueryHistoryEntry)));
+}
+
+/*
+ * Allocate and initialize the ring buffer in shared memory.
+ */
+void
+QueryHistoryShmemInit(void)
+{
+	bool		found;
+
+	if (gp_query_history_size <= 0)
+		return;
+
+	QueryHistory = (QueryHistoryShared *)
+		ShmemInitStruct("Query History", QueryHistoryShmemSize(), &found);
+
+	if (!found)
+	{
+		MemSet(QueryHistory, 0, QueryHistoryShmemSize());
+		pg_atomic_init_u32(&QueryHistory->next, 0);
+	}
+}
+
+/*
+ * Start counting the usage of the query of 'queryDesc', unless this backend
+ * is already counting for an outer query: queries run from within functions
+ * are accounted to the query that runs the function.
+ */
+void
+QueryHistoryStart(QueryDesc *queryDesc, int eflags)
+{
+	if (QueryHistory == NULL || history_estate != NULL ||
+		(eflags & EXEC_FLAG_EXPLAIN_ONLY))
+		return;
+
+	MemSet(&history_current, 0, sizeof(history_current));
+	history_current.pid = MyProcPid;
+	history_current.sessionId = gp_session_id;
+	history_current.commandCount = gp_command_count;
+	history_current.sliceId = currentSliceId;
+	history_current.userId = GetUserId();
+	history_current.startTime = GetCurrentTimestamp();
+	history_current.queryMemBytes = (int64) queryDesc->plannedstmt->query_mem;
+
+	history_estate = queryDesc->estate;
+}
+
+/*
+ * Record the usage of the query being counted in the next entry of the
+ * ring, overwriting the oldest one.
+ */
+static void
+QueryHistoryRecord(bool aborted)
+{
+	volatile QueryHistoryEntry *entry;
+	int			changecount;
+	uint32		index;
+
+	history_current.aborted = aborted;
+	history_current.endTime = GetCurrentTimestamp();
+	history_current.resGroupId = GetMyResGroupId();
+	history_current.peakVmemBytes = VmemTracker_GetMaxReservedVmemBytes();
+
+	index = pg_atomic_fetch_add_u32(&QueryHistory->next, 1) % gp_query_history_size;
+	entry = &QueryHistory->entries[index];
+
+	/*
+	 * Only another backend that has gone around the whole ring meanwhile
+	 * could be writing this entry at the same time, and then one of the two
+	 * records may be garbled.  That's acceptable for statistics, as long as
+	 * the ring is larger than the number of backends.
+	 */
+	changecount = entry->changecount;
+	entry->changecount = changecount + 1;
+	pg_write_barrier();
+
+	memcpy((char *) entry + offsetof(QueryHistoryEntry, pid),
+		   (char *) &history_current + offsetof(QueryHistoryEntry, pid),
+		   sizeof(QueryHistoryEntry) - offsetof(QueryHistoryEntry, pid));
+
+	pg_write_barrier();
+	entry->changecount = changecount + 2;
+
+	history_estate = NULL;
+}
+
+/*
+ * Record the usage of the query of 'queryDesc', if it's the one being
+ * counted.
+ */
+void
+QueryHistoryEnd(QueryDesc *queryDesc)
+{
+	if (history_estate != NULL && history_estate == queryDesc->estate)
+		QueryHistoryRecord(false);
+}
+
+/*
+ * A query that errors out never reaches ExecutorEnd, but what it used
+ * before failing, running out of memory for example, is worth keeping.
+ */
+void
+AtAbort_QueryHistory(void)
+{
+	if (history_estate != NULL)
+		QueryHistoryRecord(true);
+}
+
+/*
+ * Count 'bytes' written to the workfiles of an operator of type 'nodeType'.
+ */
+void
+QueryHistoryCountSpill(NodeTag nodeType, int64 bytes)
+{
+	QueryHistorySpillKind kind;
+
+	if (history_estate == NULL)
+		return;
+
+	switch (nodeType)
+	{
+		case T_SortState:
+		case T_Invalid:
+			/*
+			 * tuplesort_mk doesn't pass its PlanState, and the workfiles
+			 * without a workfile set are mostly tuplesort's tapes.
+			 */
+			kind = QH_SPILL_SORT;
+			break;
+		case T_HashJoinState:
+			kind = QH_SPILL_HASHJOIN;
+			break;
+		case T_AggState:
+			kind = QH_SPILL_HASHAGG;
+			break;
+		case T_MaterialState:
+		case T_ShareInputScanState:
+			kind = QH_SPILL_MATERIAL;
+			break;
+		default:
+			kind = QH_SPILL_OTHER;
+			break;
+	}
+
+	history_current.spillBytes[kind] += bytes;
+}
+
+void
+QueryHistoryCountHashAggPass(void)
+{
+	if (history_estate != NULL)
+		history_current.hashAggPasses++;
+}
+
+void
+QueryHistoryCountHashJoinBatches(int nbatch)
+{
+	if (history_estate != NULL && nbatch > 1)
+		history_current.hashJoinBatches += nbatch;
+}
+
+/*
+ * gp_query_resource_history
+ *		Report the memory and spill usage of the queries recently completed
+ *		by the backends of this database instance, oldest first.
+ */
+Datum
+gp_query_resource_history(PG_FUNCTION_ARGS)
+{
+	typedef struct Context
+	{
+		uint32		next;		/* where the ring ended when we started */
+		int			remaining;
+	} Context;
+
+	FuncCallContext *funcctx = NULL;
+	Context    *context = NULL;
+	QueryHistoryEntry local;
+	Datum		values[NUM_QUERY_HISTORY_COLUMNS];
+	bool		nulls[NUM_QUERY_HISTORY_COLUMNS];
+	HeapTuple	tuple;
+	int64		spillBytes = 0;
+	int			i;
+
+	if (SRF_IS_FIRSTCALL())
+	{
+		TupleDesc	tupdesc;
+		MemoryContext oldcontext;
+
+		funcctx = SRF_FIRSTCALL_INIT();
+
+		oldcontext = MemoryContextSwitchTo(funcctx->multi_call_memory_ctx);
+
+		/* this had better match the definition in pg_proc.sql */
+		tupdesc = CreateTemplateTupleDesc(NUM_QUERY_HISTORY_COLUMNS, false);
+		TupleDescInitEntry(tupdesc, (AttrNumber) 1, "segid", INT4OID, -1, 0);
+		TupleDescInitEntry(tupdesc, (AttrNumber) 2, "pid", INT4OID, -1, 0);
+		TupleDescInitEntry(tupdesc, (AttrNumber) 3, "sess_id", INT4OID, -1, 0);
+		TupleDescInitEntry(tupdesc, (AttrNumber) 4, "command_count", INT4OID, -1, 0);
+		TupleDescInitEntry(tupdesc, (AttrNumber) 5, "slice_id", INT4OID, -1, 0);
+		TupleDescInitEntry(tupdesc, (AttrNumber) 6, "userid", OIDOID, -1, 0);
+		TupleDescInitEntry(tupdesc, (AttrNumber) 7, "rsgid", OIDOID, -1, 0);
+		TupleDescInitEntry(tupdesc, (AttrNumber) 8, "aborted", BOOLOID, -1, 0);
+		TupleDescInitEntry(tupdesc, (AttrNumber) 9, "start_time", TIMESTAMPTZOID, -1, 0);
+		TupleDescInitEntry(tupdesc, (AttrNumber) 10, "end_time", TIMESTAMPTZOID, -1, 0);
+		TupleDescInitEntry(tupdesc, (AttrNumber) 11, "query_mem", INT8OID, -1, 0);
+		TupleDescInitEntry(tupdesc, (AttrNumber) 12, "peak_vmem", INT8OID, -1, 0);
+		TupleDescInitEntry(tupdesc, (AttrNumber) 13, "sort_spill_bytes", INT8OID, -1, 0);
+		TupleDescInitEntry(tupdesc, (AttrNumber) 14, "hashjoin_spill_bytes", INT8OID, -1, 0);
+		TupleDescInitEntry(tupdesc, (AttrNumber) 15, "hashagg_spill_bytes", INT8OID, -1, 0);
+		TupleDescInitEntry(tupdesc, (AttrNumber) 16, "material_spill_bytes", INT8OID, -1, 0);
+		TupleDescInitEntry(tupdesc, (AttrNumber) 17, "other_spill_bytes", INT8OID, -1, 0);
+		TupleDescInitEntry(tupdesc, (AttrNumber) 18, "hashagg_passes", INT8OID, -1, 0);
+		TupleDescInitEntry(tupdesc, (AttrNumber) 19, "hashjoin_batches", INT8OID, -1, 0);
+		TupleDescInitEntry(tupdesc, (AttrNumber) 20, "spill_bytes", INT8OID, -1, 0);
+
+		funcctx->tuple_desc = BlessTupleDesc(tupdesc);
+
+		context = (Context *) palloc(sizeof(Context));
+		funcctx->user_fctx = (void *) context;
+		context->next = 0;
+		context->remaining = 0;
+		if (QueryHistory != NULL)
+		{
+			context->next = pg_atomic_read_u32(&QueryHistory->next);
+			context->remaining = gp_query_history_size;
+		}
+		MemoryContextSwitchTo(oldcontext);
+	}
+
+	funcctx = SRF_PERCALL_SETUP();
+	context = (Context *) funcctx->user_fctx;
+	Assert(context);
+
+	/* Starting from the oldest entry, find the next one that's in use */
+	for (;;)
+	{
+		volatile QueryHistoryEntry *entry;
+
+		if (context->remaining <= 0)
+			SRF_RETURN_DONE(funcctx);
+		context->remaining--;
+		entry = &QueryHistory->entries[context->next++ % gp_query_history_size];
+
+		/*
+		 * Follow the protocol of retrying if changecount changes while we
+		 * copy the entry, or if it's odd.
+		 */
+		for (;;)
+		{
+			int			save_changecount = entry->changecount;
+
+			pg_read_barrier();
+			memcpy(&local, (char *) entry, sizeof(QueryHistoryEntry));
+			pg_read_barrier();
+
+			if (save_changecount == entry->changecount &&
+				(save_changecount & 1) == 0)
+				break;
+
+			/* Make sure we can break out of loop if stuck... */
+			CHECK_FOR_INTERRUPTS();
+		}
+
+		if (local.pid != 0)
+			break;
+	}
+
+	MemSet(nulls, false, sizeof(nulls));
+	values[0] = Int32GetDatum(GpIdentity.segindex);
+	values[1] = Int32GetDatum(local.pid);
+	values[2] = Int32GetDatum(local.sessionId);
+	values[3] = Int32GetDatum(local.commandCount);
+	values[4] = Int32GetDatum(local.sliceId);
+	values[5] = ObjectIdGetDatum(local.userId);
+	values[6] = ObjectIdGetDatum(local.resGroupId);
+	values[7] = BoolGetDatum(local.aborted);
+	values[8] = TimestampTzGetDatum(local.startTime);
+	values[9] = TimestampTzGetDatum(local.endTime);
+	values[10] = Int64GetDatum(local.queryMemBytes);
+	values[11] = Int64GetDatum(local.peakVmemBytes);
+	for (i = 0; i < NUM_QH_SPILL_KINDS; i++)
+	{
+		values[12 + i] = Int64GetDatum(local.spillBytes[i]);
+		spillBytes += local.spillBytes[i];
+	}
+	values[17] = Int64GetDatum(local.hashAggPasses);
+	values[18] = Int64GetDatum(local.hashJoinBatches);
+	values[19] = Int64GetDatum(spillBytes);
+
+	if (!OidIsValid(local.resGroupId))
+		nulls[6] = true;
+	if (local.queryMemBytes == 0)
+		nulls[10] = true;
+
+	tuple = heap_form_tuple(funcctx->tuple_desc, values, nulls);
+	SRF_RETURN_NEXT(funcctx, HeapTupleGetDatum(tuple));
+}
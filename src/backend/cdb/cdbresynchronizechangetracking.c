@@ -64,8 +64,6 @@ ChangeTrackingLogCompactingStateData *changeTrackingCompState;	/* state of data
 																 * compacting in log
 																 * files */
 
-extern bool enable_groupagg;	/* from guc.h */
-
 /*
  * Local functions
  */
@@ -688,6 +686,20 @@ ChangeTracking_GetRelationChangeInfoFromXlog(
 															 xlrec->heapnode.persistentSerialNum);
 						break;
 					}
+				case XLOG_HEAP2_MULTI_INSERT:
+					{
+						xl_heap_multi_insert *xlrec = (xl_heap_multi_insert *) data;
+
+						ChangeTracking_AddRelationChangeInfo(
+															 relationChangeInfoArray,
+															 relationChangeInfoArrayCount,
+															 relationChangeInfoMaxSize,
+															 &(xlrec->heapnode.node),
+															 xlrec->blkno,
+															 &xlrec->heapnode.persistentTid,
+															 xlrec->heapnode.persistentSerialNum);
+						break;
+					}
 				default:
 					elog(ERROR, "internal error: unsupported RM_HEAP2_ID op (%u) in ChangeTracking_GetRelationChangeInfoFromXlog", info);
 			}
@@ -1625,14 +1637,67 @@ ChangeTracking_AddResultEntry(ChangeTrackingResult *result,
 	result->count++;
 }
 
+/*
+ * Map of changed relations to their dirty block bitmaps, built from the
+ * compact log the first time a resync worker asks for changes.  The compact
+ * log doesn't change during resync, so it is read only once per worker.
+ */
+static HTAB *dirtyBlockMap = NULL;
+static MemoryContext dirtyBlockMapCxt = NULL;
+
+/*
+ * Add the changed blocks of the requested relations to 'result', up to
+ * 'limit' entries, and return the number of changed blocks found (at most
+ * 'limit').  'result' may be NULL to only count them.
+ */
+static int
+ChangeTracking_CollectChanges(ChangeTrackingRequest *request,
+							  ChangeTrackingResult *result,
+							  int limit)
+{
+	XLogRecPtr	lsn_end = {0, 0};
+	int			count = 0;
+	int			i;
+
+	for (i = 0; i < request->count && count < limit; i++)
+	{
+		RelFileNode *relFileNode = &request->entries[i].relFileNode;
+		BlockNumber last_fetched = request->entries[i].last_fetched;
+		ChangeTrackingDirtyBlocks *blocks;
+		BlockNumber blkno;
+
+		blocks = (ChangeTrackingDirtyBlocks *)
+			hash_search(dirtyBlockMap, relFileNode, HASH_FIND, NULL);
+		if (blocks == NULL)
+			continue;
+
+		for (blkno = ChangeTracking_NextDirtyBlock(blocks, last_fetched > 0 ? last_fetched + 1 : 0);
+			 blkno != InvalidBlockNumber && count < limit;
+			 blkno = ChangeTracking_NextDirtyBlock(blocks, blkno + 1))
+		{
+			if (result != NULL)
+				ChangeTracking_AddResultEntry(result,
+											  relFileNode->spcNode,
+											  relFileNode->dbNode,
+											  relFileNode->relNode,
+											  blkno,
+											  &lsn_end);
+			count++;
+		}
+	}
+
+	return count;
+}
+
 /*
  * We are in resync mode and the synchronizer module is asking
  * us for the information we have gathered.
  *
- * The synchronizer passes in a list of relfilenodes, each with
- * a start and end LSN. For each of those relations that are
- * found in the change tracking log file this routine will return
- * the list of block numbers and the end LSN of each.
+ * The synchronizer passes in a list of relfilenodes. For each of those
+ * relations that are found in the change tracking log file this routine
+ * will return the list of changed block numbers, in block order. The
+ * lsn_end of the returned entries is left invalid, see
+ * ChangeTrackingResultEntry.
  *
  * We restrict the total number of changes that this routine returns to
  * gp_filerep_ct_batch_size, in order to not overflow memory.  If a specific
@@ -1646,230 +1711,72 @@ ChangeTracking_AddResultEntry(ChangeTrackingResult *result,
 ChangeTrackingResult *
 ChangeTracking_GetChanges(ChangeTrackingRequest *request)
 {
-	ChangeTrackingResult *result = NULL;
-	StringInfoData sqlstmt;
-	int			ret;
-	int			proc;
-	int			i;
-	volatile bool connected = false;	/* needs to survive PG_TRY()/CATCH() */
-	ResourceOwner save = CurrentResourceOwner;
-	MemoryContext oldcontext = CurrentMemoryContext;
-	CTFType		ftype = CTF_LOG_COMPACT;	/* always read from the compact
-											 * log only */
+	ChangeTrackingResult *result;
+	int			count;
 
 	Assert(dataState == DataStateInResync);
 	Assert(gp_change_tracking);
 
-	/* assemble our query string */
-	initStringInfo(&sqlstmt);
-	appendStringInfo(&sqlstmt, "SELECT space, db, rel, blocknum, max(xlogloc) "
-					 "FROM gp_changetracking_log(%d) "
-					 "WHERE ", ftype);
-
-	for (i = 0; i < request->count; i++)
+	if (dirtyBlockMap == NULL)
 	{
-		Oid			space = request->entries[i].relFileNode.spcNode;
-		Oid			db = request->entries[i].relFileNode.dbNode;
-		Oid			rel = request->entries[i].relFileNode.relNode;
-		BlockNumber last_fetched = request->entries[i].last_fetched;
-
-		if (i != 0)
-			appendStringInfo(&sqlstmt, "OR ");
-
-		appendStringInfo(&sqlstmt, "(space = %u AND "
-						 "db = %u AND "
-						 "rel = %u",
-						 space, db, rel);
-		if (last_fetched > 0)
-			appendStringInfo(&sqlstmt, " AND blocknum > %u) ", last_fetched);
-		else
-			appendStringInfo(&sqlstmt, ") ");
-
+		dirtyBlockMapCxt = AllocSetContextCreate(TopMemoryContext,
+												 "ChangeTracking dirty block map",
+												 ALLOCSET_DEFAULT_MINSIZE,
+												 ALLOCSET_DEFAULT_INITSIZE,
+												 ALLOCSET_DEFAULT_MAXSIZE);
+
+		/* always read from the compact log only */
+		dirtyBlockMap = ChangeTracking_BuildDirtyBlockMap(CTF_LOG_COMPACT,
+														  dirtyBlockMapCxt);
 	}
-	appendStringInfo(&sqlstmt, "GROUP BY space, db, rel, blocknum "
-					 "ORDER BY space, db, rel, blocknum ");
 
 	/*
-	 * We limit the result to our max value so that we don't use too much
-	 * memory both in the query result and in the actual result returned to
-	 * the caller.
-	 *
-	 * The +1 is there in order to "peek" if there's more data to be returned.
-	 * Therefore if MAX+1 records were returned from the query we return MAX
-	 * records to the caller and indicate that there are more records to
-	 * return in the next call with the same request (we don't return the last
-	 * record found. we'll return it next time).
+	 * Count one change past our max value, in order to "peek" if there's
+	 * more data to be returned.  If so we return MAX changes to the caller
+	 * and indicate that there are more to return in the next call with the
+	 * same request.
 	 */
-	appendStringInfo(&sqlstmt, "LIMIT %d", gp_filerep_ct_batch_size + 1);
-	bool		old_enable_groupagg = enable_groupagg;
-
-	enable_groupagg = false;	/* disable sort group agg -- our query works
-								 * better with hash agg */
+	count = ChangeTracking_CollectChanges(request, NULL,
+										  gp_filerep_ct_batch_size + 1);
+	if (count == 0)
+		return NULL;
 
-	PG_TRY();
+	if (count <= gp_filerep_ct_batch_size)
+		result = ChangeTracking_FormResult(count);
+	else
 	{
-		/* must be in a transaction in order to use SPI */
-		StartTransactionCommand();
-		ActiveSnapshot = CopySnapshot(GetTransactionSnapshot());
-		SetSessionUserId(BOOTSTRAP_SUPERUSERID, true);
-
-		if (SPI_OK_CONNECT != SPI_connect())
-		{
-			ereport(ERROR, (errcode(ERRCODE_CDB_INTERNAL_ERROR),
-							errmsg("Unable to obtain change tracking information from segment database."),
-							errdetail("SPI_connect failed in ChangeTracking_GetChanges()")));
-		}
-		connected = true;
-
-		/* Do the query. */
-		ret = SPI_execute(sqlstmt.data, true, 0);
-		proc = SPI_processed;
-
-
-		if (ret > 0 && SPI_tuptable != NULL)
-		{
-			TupleDesc	tupdesc = SPI_tuptable->tupdesc;
-			SPITupleTable *tuptable = SPI_tuptable;
-			MemoryContext cxt_save;
-			int			i;
-
-			/*
-			 * if got gp_filerep_ct_batch_size changes or less, it means we
-			 * satisfied all the requests. If not, it means there are still
-			 * more results to return in the next calls.
-			 */
-			bool		satisfied_request = (proc <= gp_filerep_ct_batch_size);
-
-			/*
-			 * Iterate through each result tuple
-			 */
-			for (i = 0; i < proc; i++)
-			{
-				HeapTuple	tuple = tuptable->vals[i];
+		if (request->count != 1)
+			elog(ERROR, "internal error in ChangeTracking_GetChanges(): caller "
+				 "passed in an invalid request (expecting more than %d "
+				 "result entries for more than a single relation)",
+				 gp_filerep_ct_batch_size);
 
-				BlockNumber blocknum;
-				XLogRecPtr *endlsn;
-				Oid			space;
-				Oid			db;
-				Oid			rel;
-				char	   *str_space;
-				char	   *str_db;
-				char	   *str_rel;
-				char	   *str_blocknum;
-				char	   *str_endlsn;
-
-
-				/* get result columns from SPI (as strings) */
-				str_space = SPI_getvalue(tuple, tupdesc, 1);
-				str_db = SPI_getvalue(tuple, tupdesc, 2);
-				str_rel = SPI_getvalue(tuple, tupdesc, 3);
-				str_blocknum = SPI_getvalue(tuple, tupdesc, 4);
-				str_endlsn = SPI_getvalue(tuple, tupdesc, 5);
-
-				/*
-				 * elog(NOTICE,"tuple %d: %s %s %s block %s lsn %s", i,
-				 * str_space, str_db, str_rel, str_blocknum, str_endlsn);
-				 */
-
-				/* use our own context so that SPI won't free our stuff later */
-				cxt_save = MemoryContextSwitchTo(oldcontext);
-
-				/* init the result memory on first pass */
-				if (i == 0)
-				{
-					if (satisfied_request)
-					{
-						/* prepare memory for 'proc' entries (full result) */
-						result = ChangeTracking_FormResult(proc);
-					}
-					else
-					{
-						/* prepare memory for partial result */
-						if (request->count != 1)
-							elog(ERROR, "internal error in ChangeTracking_GetChanges(): caller "
-								 "passed in an invalid request (expecting more than %d "
-								 "result entries for more than a single relation)",
-								 gp_filerep_ct_batch_size);
-
-						result = ChangeTracking_FormResult(gp_filerep_ct_batch_size);
-
-						/*
-						 * tell caller to call us again with the same relation
-						 * (but different start lsn)
-						 */
-						result->ask_for_more = true;
-					}
-				}
-
-
-				/* convert to desired data type */
-				space = DatumGetObjectId(DirectFunctionCall1(oidin, CStringGetDatum(str_space)));
-				db = DatumGetObjectId(DirectFunctionCall1(oidin, CStringGetDatum(str_db)));
-				rel = DatumGetObjectId(DirectFunctionCall1(oidin, CStringGetDatum(str_rel)));
-				blocknum = DatumGetUInt32(DirectFunctionCall1(int4in, CStringGetDatum(str_blocknum)));
-				endlsn = (XLogRecPtr *) DatumGetPointer(DirectFunctionCall1(gpxloglocin, CStringGetDatum(str_endlsn)));
-
-				/*
-				 * TODO: in the above should use DatumGetXLogLoc instead, but
-				 * it's not public
-				 */
-
-				/*
-				 * skip the last "extra" entry if satisfied_request is false
-				 */
-				if (i == gp_filerep_ct_batch_size)
-				{
-					Assert(!satisfied_request);
-					Assert(result->ask_for_more);
-					MemoryContextSwitchTo(cxt_save);
-					break;
-				}
-
-				/* add our entry to the result */
-				ChangeTracking_AddResultEntry(result,
-											  space,
-											  db,
-											  rel,
-											  blocknum,
-											  endlsn);
-
-				MemoryContextSwitchTo(cxt_save);
-			}
-		}
-		else
-		{
-			/* no results for this given request */
-			result = NULL;
-		}
-
-		connected = false;
-		SPI_finish();
+		result = ChangeTracking_FormResult(gp_filerep_ct_batch_size);
 
-		CommitTransactionCommand();
-		enable_groupagg = old_enable_groupagg;
+		/*
+		 * tell caller to call us again with the same relation (but a
+		 * different last_fetched block)
+		 */
+		result->ask_for_more = true;
 	}
 
-	/* Clean up in case of error. */
-	PG_CATCH();
-	{
-		if (connected)
-			SPI_finish();
-
-		AbortCurrentTransaction();
-
-		enable_groupagg = old_enable_groupagg;
-
-		/* Carry on with error handling. */
-		PG_RE_THROW();
-	}
-	PG_END_TRY();
+	ChangeTracking_CollectChanges(request, result, result->max_count);
 
-	pfree(sqlstmt.data);
+	return result;
+}
 
-	MemoryContextSwitchTo(oldcontext);
-	CurrentResourceOwner = save;
+/*
+ * Release the dirty block map built by ChangeTracking_GetChanges(), once the
+ * resync worker is done with it.
+ */
+void
+ChangeTracking_FreeDirtyBlockMap(void)
+{
+	if (dirtyBlockMapCxt != NULL)
+		MemoryContextDelete(dirtyBlockMapCxt);
 
-	return result;
+	dirtyBlockMap = NULL;
+	dirtyBlockMapCxt = NULL;
 }
 
 /*
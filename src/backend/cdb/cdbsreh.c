@@ -46,11 +46,31 @@
 static int	GetNextSegid(CdbSreh *cdbsreh);
 static void PreprocessByteaData(char *src);
 static void ErrorLogWrite(CdbSreh *cdbsreh);
+static void ErrorLogFlush(Oid relationId);
 
 #define ErrorLogDir "errlog"
 #define ErrorLogFileName(fname, dbId, relId) \
 	snprintf(fname, MAXPGPATH, "errlog/%u_%u", dbId, relId)
 
+/*
+ * The records for an error log file are collected in a buffer, and written
+ * out when it is this full, when the reject limit is reached, when the SREH
+ * state is destroyed, and at the end of the transaction. This saves opening
+ * the file and taking ErrorLogLock for every rejected row.
+ */
+#define ERRORLOG_BUFFER_SIZE (64 * 1024)
+
+typedef struct ErrorLogBuffer
+{
+	Oid			databaseId;
+	Oid			relationId;
+	StringInfoData data;		/* length, crc and tuple data of each record */
+} ErrorLogBuffer;
+
+/* The ErrorLogBuffers of this transaction, in TopMemoryContext */
+static List *errorLogBuffers = NIL;
+static bool errorLogXactCallbackRegistered = false;
+
 /*
  * Function context for gp_read_error_log
  */
@@ -121,6 +141,9 @@ makeCdbSreh(int rejectlimit, bool is_limit_in_rows,
 void
 destroyCdbSreh(CdbSreh *cdbsreh)
 {
+	/* write out the errors still buffered */
+	if (cdbsreh->log_to_file && OidIsValid(cdbsreh->relid))
+		ErrorLogFlush(cdbsreh->relid);
 
 	/* delete the bad row context */
 	MemoryContextDelete(cdbsreh->badrowcontext);
@@ -388,6 +411,10 @@ ErrorIfRejectLimitReached(CdbSreh *cdbsreh, CdbCopy *cdbCopy)
 	if (cdbCopy)
 		cdbCopyEnd(cdbCopy);
 
+	/* the rejected rows explain the error, make sure they are in the log */
+	if (cdbsreh->log_to_file && OidIsValid(cdbsreh->relid))
+		ErrorLogFlush(cdbsreh->relid);
+
 	switch (code)
 	{
 		case REJECT_FIRST_BAD_LIMIT:
@@ -561,57 +588,174 @@ VerifyRejectLimit(char rejectlimittype, int rejectlimit)
 }
 
 /*
- * Write into the error log file.  This opens the file every time,
- * so that we can keep it simple to deal with concurrent write.
+ * Write the buffered records of an error log file and empty the buffer.
+ * This opens the file every time, so that we can keep it simple to deal
+ * with concurrent write.
+ *
+ * At the end of an aborted transaction errors must not be thrown, a failure
+ * is only reported as a WARNING and the records are lost.
  */
 static void
-ErrorLogWrite(CdbSreh *cdbsreh)
+ErrorLogWriteBuffer(ErrorLogBuffer *buf, bool isAbort)
 {
-	HeapTuple	tuple;
 	char		filename[MAXPGPATH];
 	FILE	   *fp;
-	pg_crc32	crc;
+	int			elevel = isAbort ? WARNING : ERROR;
 	int			ret;
 
-	Assert(OidIsValid(cdbsreh->relid));
-	ErrorLogFileName(filename, MyDatabaseId, cdbsreh->relid);
-	tuple = FormErrorTuple(cdbsreh);
+	if (buf->data.len == 0)
+		return;
 
-	INIT_CRC32C(crc);
-	COMP_CRC32C(crc, tuple->t_data, tuple->t_len);
-	FIN_CRC32C(crc);
+	ErrorLogFileName(filename, buf->databaseId, buf->relationId);
 
 	LWLockAcquire(ErrorLogLock, LW_EXCLUSIVE);
 	fp = AllocateFile(filename, "a");
 
-	if (!fp && (errno == EMFILE || errno == ENFILE))
-		ereport(ERROR, (errmsg("could not open \"%s\", too many open files: %m", filename)));
-
 	if (!fp && errno == ENOENT)
 	{
 		ret = mkdir(ErrorLogDir, S_IRWXU);
 		if (ret == 0)
 			fp = AllocateFile(filename, "a");
 		else
-			ereport(ERROR, (errmsg("could not create directory for errorlog \"%s\": %m", ErrorLogDir)));
+		{
+			LWLockRelease(ErrorLogLock);
+			resetStringInfo(&buf->data);
+			ereport(elevel, (errmsg("could not create directory for errorlog \"%s\": %m", ErrorLogDir)));
+			return;
+		}
 	}
 	if (!fp)
-		ereport(ERROR, (errmsg("could not open \"%s\": %m", filename)));
+	{
+		LWLockRelease(ErrorLogLock);
+		resetStringInfo(&buf->data);
+		if (errno == EMFILE || errno == ENFILE)
+			ereport(elevel, (errmsg("could not open \"%s\", too many open files: %m", filename)));
+		else
+			ereport(elevel, (errmsg("could not open \"%s\": %m", filename)));
+		return;
+	}
 
 	/*
-	 * format: 0-4: length 5-8: crc 9-n: tuple data
+	 * format of each record: 0-4: length 5-8: crc 9-n: tuple data
 	 */
-	if (fwrite(&tuple->t_len, 1, sizeof(tuple->t_len), fp) != sizeof(tuple->t_len))
-		elog(ERROR, "could not write tuple length: %m");
-	if (fwrite(&crc, 1, sizeof(pg_crc32), fp) != sizeof(pg_crc32))
-		elog(ERROR, "could not write checksum: %m");
-	if (fwrite(tuple->t_data, 1, tuple->t_len, fp) != tuple->t_len)
-		elog(ERROR, "could not write tuple data: %m");
+	if (fwrite(buf->data.data, 1, buf->data.len, fp) != buf->data.len)
+	{
+		FreeFile(fp);
+		LWLockRelease(ErrorLogLock);
+		resetStringInfo(&buf->data);
+		ereport(elevel, (errmsg("could not write error log \"%s\": %m", filename)));
+		return;
+	}
 
 	FreeFile(fp);
 	LWLockRelease(ErrorLogLock);
 
+	resetStringInfo(&buf->data);
+}
+
+/*
+ * Write out and forget the buffered records of all error log files.
+ */
+static void
+ErrorLogXactCallback(XactEvent event, void *arg)
+{
+	List	   *buffers = errorLogBuffers;
+	ListCell   *lc;
+
+	/* Forget them first, so that an error here doesn't bring us back */
+	errorLogBuffers = NIL;
+
+	foreach(lc, buffers)
+	{
+		ErrorLogBuffer *buf = (ErrorLogBuffer *) lfirst(lc);
+
+		ErrorLogWriteBuffer(buf, event == XACT_EVENT_ABORT);
+		pfree(buf->data.data);
+		pfree(buf);
+	}
+	list_free(buffers);
+}
+
+/*
+ * Write out and forget the buffered records of an error log file.
+ */
+static void
+ErrorLogFlush(Oid relationId)
+{
+	ListCell   *lc;
+
+	foreach(lc, errorLogBuffers)
+	{
+		ErrorLogBuffer *buf = (ErrorLogBuffer *) lfirst(lc);
+
+		if (buf->databaseId == MyDatabaseId && buf->relationId == relationId)
+		{
+			errorLogBuffers = list_delete_ptr(errorLogBuffers, buf);
+			ErrorLogWriteBuffer(buf, false);
+			pfree(buf->data.data);
+			pfree(buf);
+			return;
+		}
+	}
+}
+
+/*
+ * Add a record to the error log file, through its buffer.
+ */
+static void
+ErrorLogWrite(CdbSreh *cdbsreh)
+{
+	HeapTuple	tuple;
+	ErrorLogBuffer *buf = NULL;
+	ListCell   *lc;
+	pg_crc32	crc;
+
+	Assert(OidIsValid(cdbsreh->relid));
+	tuple = FormErrorTuple(cdbsreh);
+
+	INIT_CRC32C(crc);
+	COMP_CRC32C(crc, tuple->t_data, tuple->t_len);
+	FIN_CRC32C(crc);
+
+	foreach(lc, errorLogBuffers)
+	{
+		ErrorLogBuffer *b = (ErrorLogBuffer *) lfirst(lc);
+
+		if (b->databaseId == MyDatabaseId && b->relationId == cdbsreh->relid)
+		{
+			buf = b;
+			break;
+		}
+	}
+
+	if (buf == NULL)
+	{
+		MemoryContext oldcontext = MemoryContextSwitchTo(TopMemoryContext);
+
+		if (!errorLogXactCallbackRegistered)
+		{
+			RegisterXactCallback(ErrorLogXactCallback, NULL);
+			errorLogXactCallbackRegistered = true;
+		}
+
+		buf = palloc(sizeof(ErrorLogBuffer));
+		buf->databaseId = MyDatabaseId;
+		buf->relationId = cdbsreh->relid;
+		initStringInfo(&buf->data);
+		errorLogBuffers = lappend(errorLogBuffers, buf);
+
+		MemoryContextSwitchTo(oldcontext);
+	}
+
+	/* the buffer data is in TopMemoryContext, it keeps growing there */
+	appendBinaryStringInfo(&buf->data, (char *) &tuple->t_len, sizeof(tuple->t_len));
+	appendBinaryStringInfo(&buf->data, (char *) &crc, sizeof(pg_crc32));
+	appendBinaryStringInfo(&buf->data, (char *) tuple->t_data, tuple->t_len);
+
 	heap_freetuple(tuple);
+
+	if (buf->data.len >= ERRORLOG_BUFFER_SIZE)
+		ErrorLogWriteBuffer(buf, false);
 }
 
 /*
@@ -14,19 +14,65 @@
  */
 
 #include "postgres.h"
+#include "access/hash.h"
 #include "cdb/cdbplan.h"
 #include "cdb/cdbsrlz.h"
+#include "cdb/cdbvars.h"
 #include <math.h>
 #include "miscadmin.h"
 #include "nodes/print.h"
 #include "optimizer/clauses.h"
+#include "portability/instr_time.h"
 #include "regex/regex.h"
 #include "utils/guc.h"
+#include "utils/inval.h"
 #include "utils/memaccounting.h"
+#include "utils/memutils.h"
 #include "utils/zlib_wrapper.h"
 
+/*
+ * A small cache of recently (de)serialized plans, so that a statement that is
+ * dispatched over and over doesn't pay for compressing the same plan on the
+ * QD, or for uncompressing and reading it on the QEs, every time.
+ *
+ * Entries are keyed by the serialized bytes themselves: the uncompressed
+ * binary string on the QD, and the compressed string on the QE.  A key is
+ * only remembered by its hash the first time it is seen, so that one-off
+ * queries don't pay for copying their plans into the cache.
+ */
+typedef struct NodeCacheEntry
+{
+	uint32		hash;			/* hash_any() of the key */
+	int			keylen;			/* length of the key; 0 if entry is unused */
+	char	   *key;			/* the key, or NULL if seen only once */
+	void	   *data;			/* compressed string, or deserialized node */
+	MemoryContext cxt;			/* holds key and data */
+	int			size;			/* length of a compressed string */
+	int			uncompressed_size;
+	uint64		lastUsed;
+} NodeCacheEntry;
+
+typedef struct NodeCache
+{
+	NodeCacheEntry *entries;
+	int			nentries;
+	uint64		clock;
+} NodeCache;
+
+static MemoryContext NodeCacheContext = NULL;
+static NodeCache serializeCache;
+static NodeCache deserializeCache;
+
 static char *compress_string(const char *src, int uncompressed_size, int *size);
 static char *uncompress_string(const char *src, int size, int *uncompressed_len);
+static NodeCacheEntry *nodecache_lookup(NodeCache *cache, const char *key, int keylen,
+										bool *found);
+static MemoryContext nodecache_entry_context(void);
+static void nodecache_store(NodeCacheEntry *entry, const char *key, int keylen,
+							MemoryContext cxt, void *data, int size);
+static void nodecache_clear_entry(NodeCacheEntry *entry);
+static void nodecache_reset(NodeCache *cache);
+static void nodecache_inval_callback(Datum arg, Oid relid);
 
 /*
  * This is used by dispatcher to serialize Plan and Query Trees for
@@ -59,6 +105,88 @@ serializeNode(Node *node, int *size, int *uncompressed_size_out)
 	return sNode;
 }
 
+/*
+ * Like serializeNode(), but the compressed string of a plan that was
+ * serialized recently is reused rather than compressed again.
+ *
+ * If serialize_time and compress_time are not NULL, the seconds spent
+ * writing out the node and compressing it are returned in them, for
+ * EXPLAIN ANALYZE.
+ */
+char *
+serializeNodeCached(Node *node, int *size, int *uncompressed_size_out,
+					double *serialize_time, double *compress_time)
+{
+	char	   *pszNode;
+	char	   *sNode;
+	int			uncompressed_size;
+	NodeCacheEntry *entry = NULL;
+	bool		found = false;
+	bool		timing = (serialize_time != NULL && compress_time != NULL);
+	instr_time	starttime;
+	instr_time	endtime;
+
+	Assert(node != NULL);
+	Assert(size != NULL);
+
+	if (timing)
+	{
+		*serialize_time = 0;
+		*compress_time = 0;
+		INSTR_TIME_SET_CURRENT(starttime);
+	}
+
+	START_MEMORY_ACCOUNT(MemoryAccounting_CreateAccount(0, MEMORY_OWNER_TYPE_Serializer));
+	{
+		pszNode = nodeToBinaryStringFast(node, &uncompressed_size);
+		Assert(pszNode != NULL);
+
+		if (NULL != uncompressed_size_out)
+			*uncompressed_size_out = uncompressed_size;
+
+		if (timing)
+		{
+			INSTR_TIME_SET_CURRENT(endtime);
+			INSTR_TIME_SUBTRACT(endtime, starttime);
+			*serialize_time = INSTR_TIME_GET_DOUBLE(endtime);
+			INSTR_TIME_SET_CURRENT(starttime);
+		}
+
+		if (gp_dispatch_plan_cache_size > 0)
+			entry = nodecache_lookup(&serializeCache, pszNode, uncompressed_size, &found);
+		if (found)
+		{
+			*size = entry->size;
+			sNode = palloc(entry->size);
+			memcpy(sNode, entry->data, entry->size);
+		}
+		else
+		{
+			sNode = compress_string(pszNode, uncompressed_size, size);
+
+			if (entry)
+			{
+				MemoryContext cxt = nodecache_entry_context();
+				char	   *data = MemoryContextAlloc(cxt, *size);
+
+				memcpy(data, sNode, *size);
+				nodecache_store(entry, pszNode, uncompressed_size, cxt, data, *size);
+			}
+		}
+		pfree(pszNode);
+
+		if (timing)
+		{
+			INSTR_TIME_SET_CURRENT(endtime);
+			INSTR_TIME_SUBTRACT(endtime, starttime);
+			*compress_time = INSTR_TIME_GET_DOUBLE(endtime);
+		}
+	}
+	END_MEMORY_ACCOUNT();
+
+	return sNode;
+}
+
 /*
  * This is used on the qExecs to deserialize serialized Plan and Query Trees
  * received from the dispatcher.
@@ -88,6 +216,183 @@ deserializeNode(const char *strNode, int size)
 	return node;
 }
 
+/*
+ * Like deserializeNode(), but a plan that was received recently is copied
+ * from the cache rather than uncompressed and read again.  The returned node
+ * is always a fresh copy, which the caller is free to scribble on.
+ */
+Node *
+deserializeNodeCached(const char *strNode, int size)
+{
+	NodeCacheEntry *entry;
+	bool		found;
+	Node	   *node;
+	Node	   *data;
+	MemoryContext cxt;
+	MemoryContext oldcontext;
+
+	Assert(strNode != NULL);
+
+	if (gp_dispatch_plan_cache_size <= 0)
+		return deserializeNode(strNode, size);
+
+	entry = nodecache_lookup(&deserializeCache, strNode, size, &found);
+	if (found)
+		return (Node *) copyObject(entry->data);
+
+	node = deserializeNode(strNode, size);
+
+	if (entry)
+	{
+		cxt = nodecache_entry_context();
+		oldcontext = MemoryContextSwitchTo(cxt);
+		data = copyObject(node);
+		MemoryContextSwitchTo(oldcontext);
+		nodecache_store(entry, strNode, size, cxt, data, 0);
+	}
+
+	return node;
+}
+
+/*
+ * Look up a key in a node cache.
+ *
+ * If the key is cached, sets *found and returns its entry.  Otherwise, if the
+ * key has been seen once before, returns its entry so that the caller can
+ * pass the data to nodecache_store().  Otherwise the key is
+ * remembered by its hash in the least recently used entry, and NULL is
+ * returned.
+ */
+static NodeCacheEntry *
+nodecache_lookup(NodeCache *cache, const char *key, int keylen, bool *found)
+{
+	uint32		hash;
+	NodeCacheEntry *victim = NULL;
+	int			i;
+
+	*found = false;
+
+	if (NodeCacheContext == NULL)
+	{
+		NodeCacheContext = AllocSetContextCreate(TopMemoryContext,
+												 "Plan Serialization Cache",
+												 ALLOCSET_SMALL_MINSIZE,
+												 ALLOCSET_SMALL_INITSIZE,
+												 ALLOCSET_DEFAULT_MAXSIZE);
+		/* The catalog may give the same bytes a different meaning later. */
+		CacheRegisterRelcacheCallback(nodecache_inval_callback, (Datum) 0);
+	}
+
+	if (cache->nentries != gp_dispatch_plan_cache_size)
+	{
+		nodecache_reset(cache);
+		if (cache->entries)
+			pfree(cache->entries);
+		cache->nentries = gp_dispatch_plan_cache_size;
+		cache->entries = MemoryContextAllocZero(NodeCacheContext,
+												cache->nentries * sizeof(NodeCacheEntry));
+	}
+
+	hash = DatumGetUInt32(hash_any((const unsigned char *) key, keylen));
+	cache->clock++;
+
+	for (i = 0; i < cache->nentries; i++)
+	{
+		NodeCacheEntry *entry = &cache->entries[i];
+
+		if (entry->keylen == keylen && entry->hash == hash &&
+			(entry->key == NULL || memcmp(entry->key, key, keylen) == 0))
+		{
+			entry->lastUsed = cache->clock;
+			*found = (entry->key != NULL);
+			return entry;
+		}
+
+		if (victim == NULL || entry->lastUsed < victim->lastUsed)
+			victim = entry;
+	}
+
+	nodecache_clear_entry(victim);
+	victim->hash = hash;
+	victim->keylen = keylen;
+	victim->lastUsed = cache->clock;
+
+	return NULL;
+}
+
+/*
+ * Create a memory context for the key and data of a new node cache entry.
+ */
+static MemoryContext
+nodecache_entry_context(void)
+{
+	return AllocSetContextCreate(NodeCacheContext,
+								 "Plan Serialization Cache Entry",
+								 ALLOCSET_SMALL_MINSIZE,
+								 ALLOCSET_SMALL_INITSIZE,
+								 ALLOCSET_DEFAULT_MAXSIZE);
+}
+
+/*
+ * Store the data for a key in the entry nodecache_lookup() returned for it.
+ * 'data' must have been allocated in 'cxt', which the entry takes over.
+ */
+static void
+nodecache_store(NodeCacheEntry *entry, const char *key, int keylen,
+				MemoryContext cxt, void *data, int size)
+{
+	/* The cache may have been reset by an invalidation in the meantime. */
+	if (entry->keylen != keylen || entry->key != NULL)
+	{
+		MemoryContextDelete(cxt);
+		return;
+	}
+
+	entry->key = MemoryContextAlloc(cxt, keylen);
+	memcpy(entry->key, key, keylen);
+	entry->data = data;
+	entry->size = size;
+	entry->cxt = cxt;
+}
+
+/*
+ * Release the key and data of a node cache entry.
+ */
+static void
+nodecache_clear_entry(NodeCacheEntry *entry)
+{
+	if (entry->cxt)
+		MemoryContextDelete(entry->cxt);
+	entry->cxt = NULL;
+	entry->key = NULL;
+	entry->data = NULL;
+	entry->size = 0;
+}
+
+/*
+ * Forget everything in a node cache.
+ */
+static void
+nodecache_reset(NodeCache *cache)
+{
+	int			i;
+
+	for (i = 0; i < cache->nentries; i++)
+		nodecache_clear_entry(&cache->entries[i]);
+	if (cache->nentries > 0)
+		MemSet(cache->entries, 0, cache->nentries * sizeof(NodeCacheEntry));
+}
+
+/*
+ * Relcache invalidation callback.  Deserialized plans are dropped on any
+ * catalog change; compressed strings don't depend on the catalog.
+ */
+static void
+nodecache_inval_callback(Datum arg, Oid relid)
+{
+	nodecache_reset(&deserializeCache);
+}
+
 /*
  * Compress a (binary) string using zlib.
  *
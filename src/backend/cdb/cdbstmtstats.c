@@ -0,0 +1,606 @@
+/*-------------------------------------------------------------------------
+ * cdbstmtstats.c
+ *	   Latency histograms of the statements run on the QD, by normalized
+ *	   query text and by phase, kept in shared memory.
+ *
+ * A statement's text is normalized by folding case and whitespace, and by
+ * replacing constants with '?', so that statements differing only in their
+ * constants share a fingerprint.  While the statement runs, the backend
+ * adds up the time it spends waiting for a resource queue or group,
+ * planning, and allocating gangs and dispatching plans; the rest of the
+ * statement's elapsed time is execution.  When the statement completes,
+ * each phase's latency is counted in a log-linear histogram of the
+ * fingerprint's entry, like an HDR histogram with 3 significant bits, so
+ * that percentiles can be reported within 1/8 of their value.
+ *
+ * Statements that fail are not counted: they never reach StmtStatsEnd(),
+ * and the next StmtStatsStart() starts over.
+ *
+ * Portions Copyright (c) 2012-Present Pivotal Software, Inc.
+ *
+ *
+ * IDENTIFICATION
+ *	    src/backend/cdb/cdbstmtstats.c
+ *
+ *-------------------------------------------------------------------------
+ */
+
+#include "postgres.h"
+
+#include <ctype.h>
+#include <math.h>
+
+#include "access/hash.h"
+#include "access/heapam.h"
+#include "catalog/pg_type.h"
+#include "funcapi.h"
+#include "mb/pg_wchar.h"
+#include "miscadmin.h"
+#include "storage/lwlock.h"
+#include "storage/shmem.h"
+#include "storage/spin.h"
+#include "utils/builtins.h"
+#include "utils/hsearch.h"
+
+#include "cdb/cdbstmtstats.h"
+#include "cdb/cdbvars.h"
+
+#define NUM_STMT_STATS_COLUMNS 12
+
+/* Length kept of the normalized text of a statement */
+#define STMT_STATS_QUERY_LEN 1024
+
+/*
+ * Histogram buckets.  Latencies below 8 usecs get a bucket each; above,
+ * each power of 2 is split into 8 buckets.  The last bucket, for 2^40 usecs
+ * (12 days) and above, takes all longer latencies.
+ */
+#define STMT_STATS_SUB_BITS 3
+#define STMT_STATS_SUB_BUCKETS (1 << STMT_STATS_SUB_BITS)
+#define STMT_STATS_BUCKETS (38 * STMT_STATS_SUB_BUCKETS)
+
+typedef struct StmtStatsKey
+{
+	Oid			dbid;
+	Oid			userid;
+	uint32		fingerprint;	/* hash of the normalized text */
+} StmtStatsKey;
+
+typedef struct StmtStatsHist
+{
+	double		totalUsecs;
+	uint64		maxUsecs;
+	uint32		buckets[STMT_STATS_BUCKETS];
+} StmtStatsHist;
+
+typedef struct StmtStatsEntry
+{
+	StmtStatsKey key;			/* hash key of entry - MUST BE FIRST */
+	slock_t		mutex;			/* protects the counters */
+	int64		calls;
+	StmtStatsHist phases[NUM_STMT_PHASES];
+	char		query[STMT_STATS_QUERY_LEN];	/* normalized text */
+} StmtStatsEntry;
+
+typedef struct StmtStatsShared
+{
+	LWLockId	lock;			/* protects the hash table, not the entries */
+} StmtStatsShared;
+
+static StmtStatsShared *StmtStats = NULL;
+static HTAB *StmtStatsHash = NULL;
+
+/* the statement this backend is timing, if any */
+static bool stmt_active = false;
+static instr_time stmt_started;
+static uint64 stmt_usecs[NUM_STMT_PHASES];
+static uint32 stmt_fingerprint;
+static char stmt_query[STMT_STATS_QUERY_LEN];
+
+static const char *const StmtStatsPhaseNames[NUM_STMT_PHASES] = {
+	"queue",
+	"plan",
+	"dispatch",
+	"execute",
+	"total"
+};
+
+/*
+ * Report shared memory space needed by StmtStatsShmemInit.
+ */
+Size
+StmtStatsShmemSize(void)
+{
+	if (gp_statement_stats_max <= 0)
+		return 0;
+
+	return add_size(MAXALIGN(sizeof(StmtStatsShared)),
+					hash_estimate_size(gp_statement_stats_max,
+									   sizeof(StmtStatsEntry)));
+}
+
+/*
+ * Allocate and initialize the hash table in shared memory.
+ */
+void
+StmtStatsShmemInit(void)
+{
+	HASHCTL		info;
+	bool		found;
+
+	if (gp_statement_stats_max <= 0)
+		return;
+
+	StmtStats = (StmtStatsShared *)
+		ShmemInitStruct("Statement Stats", sizeof(StmtStatsShared), &found);
+	if (!found)
+		StmtStats->lock = LWLockAssign();
+
+	MemSet(&info, 0, sizeof(info));
+	info.keysize = sizeof(StmtStatsKey);
+	info.entrysize = sizeof(StmtStatsEntry);
+	info.hash = tag_hash;
+	StmtStatsHash = ShmemInitHash("Statement Stats Hash",
+								  gp_statement_stats_max,
+								  gp_statement_stats_max,
+								  &info,
+								  HASH_ELEM | HASH_FUNCTION);
+}
+
+static bool
+StmtStatsIsIdentChar(char c)
+{
+	return isalnum((unsigned char) c) || c == '_' || c == '$' ||
+		IS_HIGHBIT_SET(c);
+}
+
+/*
+ * Normalize 'query' into 'buf', which must be at least as long: fold
+ * identifiers and keywords to lower case, whitespace and comments to a
+ * single space, and string and numeric constants to '?'.  Quoted
+ * identifiers and parameters like $1 are kept as they are.
+ */
+static void
+StmtStatsNormalize(const char *query, char *buf)
+{
+	const char *p = query;
+	int			len = 0;
+	bool		space = false;
+
+	while (*p)
+	{
+		if (isspace((unsigned char) *p))
+		{
+			space = true;
+			p++;
+			continue;
+		}
+		if (p[0] == '-' && p[1] == '-')
+		{
+			while (*p && *p != '\n')
+				p++;
+			space = true;
+			continue;
+		}
+		if (p[0] == '/' && p[1] == '*')
+		{
+			p += 2;
+			while (*p && !(p[0] == '*' && p[1] == '/'))
+				p++;
+			if (*p)
+				p += 2;
+			space = true;
+			continue;
+		}
+
+		if (space && len > 0)
+			buf[len++] = ' ';
+		space = false;
+
+		if (*p == '\'')
+		{
+			/* String constant, escape string syntax or not */
+			p++;
+			while (*p)
+			{
+				if (p[0] == '\'' && p[1] == '\'')
+					p += 2;
+				else if (p[0] == '\'')
+				{
+					p++;
+					break;
+				}
+				else if (p[0] == '\\' && p[1])
+					p += 2;
+				else
+					p++;
+			}
+			buf[len++] = '?';
+		}
+		else if (*p == '"')
+		{
+			/* Quoted identifier */
+			buf[len++] = *p++;
+			while (*p)
+			{
+				if (p[0] == '"' && p[1] == '"')
+				{
+					buf[len++] = *p++;
+					buf[len++] = *p++;
+				}
+				else if (p[0] == '"')
+				{
+					buf[len++] = *p++;
+					break;
+				}
+				else
+					buf[len++] = *p++;
+			}
+		}
+		else if (isdigit((unsigned char) *p) &&
+				 !(len > 0 && StmtStatsIsIdentChar(buf[len - 1])))
+		{
+			/* Numeric constant */
+			while (isdigit((unsigned char) *p) || *p == '.')
+				p++;
+			if ((*p == 'e' || *p == 'E') &&
+				(isdigit((unsigned char) p[1]) ||
+				 ((p[1] == '+' || p[1] == '-') && isdigit((unsigned char) p[2]))))
+			{
+				p += 2;
+				while (isdigit((unsigned char) *p))
+					p++;
+			}
+			buf[len++] = '?';
+		}
+		else if (StmtStatsIsIdentChar(*p))
+		{
+			while (StmtStatsIsIdentChar(*p))
+				buf[len++] = pg_tolower((unsigned char) *p++);
+		}
+		else
+			buf[len++] = *p++;
+	}
+
+	buf[len] = '\0';
+}
+
+/*
+ * Start timing a statement on the QD, about to run 'query_string'.
+ */
+void
+StmtStatsStart(const char *query_string)
+{
+	char	   *normalized;
+	int			len;
+
+	stmt_active = false;
+
+	if (StmtStats == NULL || Gp_role == GP_ROLE_EXECUTE ||
+		query_string == NULL)
+		return;
+
+	normalized = palloc(strlen(query_string) + 1);
+	StmtStatsNormalize(query_string, normalized);
+	len = strlen(normalized);
+	if (len == 0)
+	{
+		pfree(normalized);
+		return;
+	}
+
+	stmt_fingerprint = DatumGetUInt32(hash_any((unsigned char *) normalized, len));
+	len = pg_mbcliplen(normalized, len, STMT_STATS_QUERY_LEN - 1);
+	memcpy(stmt_query, normalized, len);
+	stmt_query[len] = '\0';
+	pfree(normalized);
+
+	MemSet(stmt_usecs, 0, sizeof(stmt_usecs));
+	INSTR_TIME_SET_CURRENT(stmt_started);
+	stmt_active = true;
+}
+
+/*
+ * Add the time since 'starttime' to 'phase' of the statement being timed.
+ */
+void
+StmtStatsAddTime(StmtStatsPhase phase, instr_time starttime)
+{
+	instr_time	elapsed;
+
+	if (!stmt_active)
+		return;
+
+	INSTR_TIME_SET_CURRENT(elapsed);
+	INSTR_TIME_SUBTRACT(elapsed, starttime);
+	stmt_usecs[phase] += INSTR_TIME_GET_MICROSEC(elapsed);
+}
+
+static int
+StmtStatsBucket(uint64 usecs)
+{
+	int			msb = 0;
+	int			bucket;
+
+	if (usecs < STMT_STATS_SUB_BUCKETS)
+		return (int) usecs;
+
+	while ((usecs >> msb) > 1)
+		msb++;
+	bucket = (msb - STMT_STATS_SUB_BITS + 1) * STMT_STATS_SUB_BUCKETS +
+		(int) ((usecs >> (msb - STMT_STATS_SUB_BITS)) & (STMT_STATS_SUB_BUCKETS - 1));
+
+	return Min(bucket, STMT_STATS_BUCKETS - 1);
+}
+
+/* The highest latency, in usecs, that falls in 'bucket' */
+static uint64
+StmtStatsBucketMax(int bucket)
+{
+	int			group = bucket / STMT_STATS_SUB_BUCKETS;
+	uint64		sub = bucket % STMT_STATS_SUB_BUCKETS;
+
+	if (group == 0)
+		return sub;
+
+	return (((STMT_STATS_SUB_BUCKETS + sub + 1) << (group - 1)) - 1);
+}
+
+/*
+ * Count the statement being timed, which has completed, in the entry of
+ * its fingerprint.
+ */
+void
+StmtStatsEnd(void)
+{
+	StmtStatsKey key;
+	StmtStatsEntry *entry;
+	instr_time	elapsed;
+	uint64		others = 0;
+	int			phase;
+
+	if (!stmt_active)
+		return;
+	stmt_active = false;
+
+	INSTR_TIME_SET_CURRENT(elapsed);
+	INSTR_TIME_SUBTRACT(elapsed, stmt_started);
+	stmt_usecs[STMT_PHASE_TOTAL] = INSTR_TIME_GET_MICROSEC(elapsed);
+	for (phase = 0; phase < STMT_PHASE_EXECUTE; phase++)
+		others += stmt_usecs[phase];
+	if (stmt_usecs[STMT_PHASE_TOTAL] > others)
+		stmt_usecs[STMT_PHASE_EXECUTE] = stmt_usecs[STMT_PHASE_TOTAL] - others;
+
+	MemSet(&key, 0, sizeof(key));
+	key.dbid = MyDatabaseId;
+	key.userid = GetUserId();
+	key.fingerprint = stmt_fingerprint;
+
+	LWLockAcquire(StmtStats->lock, LW_SHARED);
+
+	entry = (StmtStatsEntry *) hash_search(StmtStatsHash, &key, HASH_FIND, NULL);
+	if (entry == NULL)
+	{
+		bool		found;
+
+		/* Need exclusive lock to make a new entry */
+		LWLockRelease(StmtStats->lock);
+		LWLockAcquire(StmtStats->lock, LW_EXCLUSIVE);
+
+		/* Make room by dropping the least used entry, if full */
+		if (hash_get_num_entries(StmtStatsHash) >= gp_statement_stats_max &&
+			hash_search(StmtStatsHash, &key, HASH_FIND, NULL) == NULL)
+		{
+			HASH_SEQ_STATUS status;
+			StmtStatsEntry *victim = NULL;
+			StmtStatsEntry *e;
+
+			hash_seq_init(&status, StmtStatsHash);
+			while ((e = (StmtStatsEntry *) hash_seq_search(&status)) != NULL)
+			{
+				if (victim == NULL || e->calls < victim->calls)
+					victim = e;
+			}
+			if (victim != NULL)
+				hash_search(StmtStatsHash, &victim->key, HASH_REMOVE, NULL);
+		}
+
+		entry = (StmtStatsEntry *) hash_search(StmtStatsHash, &key, HASH_ENTER_NULL, &found);
+		if (entry == NULL)
+		{
+			LWLockRelease(StmtStats->lock);
+			return;
+		}
+		if (!found)
+		{
+			SpinLockInit(&entry->mutex);
+			entry->calls = 0;
+			MemSet(entry->phases, 0, sizeof(entry->phases));
+			StrNCpy(entry->query, stmt_query, STMT_STATS_QUERY_LEN);
+		}
+	}
+
+	/* Grab the spinlock while updating the counters */
+	{
+		volatile StmtStatsEntry *e = (volatile StmtStatsEntry *) entry;
+
+		SpinLockAcquire(&e->mutex);
+		e->calls++;
+		for (phase = 0; phase < NUM_STMT_PHASES; phase++)
+		{
+			volatile StmtStatsHist *hist = &e->phases[phase];
+			uint64		usecs = stmt_usecs[phase];
+
+			hist->totalUsecs += usecs;
+			if (usecs > hist->maxUsecs)
+				hist->maxUsecs = usecs;
+			hist->buckets[StmtStatsBucket(usecs)]++;
+		}
+		SpinLockRelease(&e->mutex);
+	}
+
+	LWLockRelease(StmtStats->lock);
+}
+
+/* The latency, in msecs, below which 'fraction' of the calls fall */
+static double
+StmtStatsPercentile(StmtStatsHist *hist, int64 calls, double fraction)
+{
+	int64		rank = (int64) ceil(fraction * calls);
+	int64		seen = 0;
+	int			bucket;
+
+	for (bucket = 0; bucket < STMT_STATS_BUCKETS; bucket++)
+	{
+		seen += hist->buckets[bucket];
+		if (seen >= rank && seen > 0)
+			return Min(StmtStatsBucketMax(bucket), hist->maxUsecs) / 1000.0;
+	}
+
+	return hist->maxUsecs / 1000.0;
+}
+
+/*
+ * gp_statement_stats
+ *		Report the latency of the statements run on this QD, one row for
+ *		each fingerprint and phase.
+ */
+Datum
+gp_statement_stats(PG_FUNCTION_ARGS)
+{
+	typedef struct Context
+	{
+		StmtStatsEntry *entries;	/* copies of the entries */
+		int			nentries;
+		int			current;	/* row to return next */
+	} Context;
+
+	FuncCallContext *funcctx = NULL;
+	Context    *context = NULL;
+	StmtStatsEntry *entry;
+	StmtStatsHist *hist;
+	int			phase;
+	Datum		values[NUM_STMT_STATS_COLUMNS];
+	bool		nulls[NUM_STMT_STATS_COLUMNS];
+	HeapTuple	tuple;
+
+	if (SRF_IS_FIRSTCALL())
+	{
+		TupleDesc	tupdesc;
+		MemoryContext oldcontext;
+
+		funcctx = SRF_FIRSTCALL_INIT();
+
+		oldcontext = MemoryContextSwitchTo(funcctx->multi_call_memory_ctx);
+
+		/* this had better match the definition in pg_proc.sql */
+		tupdesc = CreateTemplateTupleDesc(NUM_STMT_STATS_COLUMNS, false);
+		TupleDescInitEntry(tupdesc, (AttrNumber) 1, "dbid", OIDOID, -1, 0);
+		TupleDescInitEntry(tupdesc, (AttrNumber) 2, "userid", OIDOID, -1, 0);
+		TupleDescInitEntry(tupdesc, (AttrNumber) 3, "fingerprint", INT8OID, -1, 0);
+		TupleDescInitEntry(tupdesc, (AttrNumber) 4, "phase", TEXTOID, -1, 0);
+		TupleDescInitEntry(tupdesc, (AttrNumber) 5, "calls", INT8OID, -1, 0);
+		TupleDescInitEntry(tupdesc, (AttrNumber) 6, "total_ms", FLOAT8OID, -1, 0);
+		TupleDescInitEntry(tupdesc, (AttrNumber) 7, "mean_ms", FLOAT8OID, -1, 0);
+		TupleDescInitEntry(tupdesc, (AttrNumber) 8, "p50_ms", FLOAT8OID, -1, 0);
+		TupleDescInitEntry(tupdesc, (AttrNumber) 9, "p90_ms", FLOAT8OID, -1, 0);
+		TupleDescInitEntry(tupdesc, (AttrNumber) 10, "p99_ms", FLOAT8OID, -1, 0);
+		TupleDescInitEntry(tupdesc, (AttrNumber) 11, "max_ms", FLOAT8OID, -1, 0);
+		TupleDescInitEntry(tupdesc, (AttrNumber) 12, "query", TEXTOID, -1, 0);
+
+		funcctx->tuple_desc = BlessTupleDesc(tupdesc);
+
+		context = (Context *) palloc(sizeof(Context));
+		funcctx->user_fctx = (void *) context;
+		context->entries = NULL;
+		context->nentries = 0;
+		context->current = 0;
+
+		if (StmtStats != NULL)
+		{
+			HASH_SEQ_STATUS status;
+			StmtStatsEntry *e;
+
+			LWLockAcquire(StmtStats->lock, LW_SHARED);
+
+			context->entries = (StmtStatsEntry *)
+				palloc(Max(hash_get_num_entries(StmtStatsHash), 1) * sizeof(StmtStatsEntry));
+
+			hash_seq_init(&status, StmtStatsHash);
+			while ((e = (StmtStatsEntry *) hash_seq_search(&status)) != NULL)
+			{
+				volatile StmtStatsEntry *ve = (volatile StmtStatsEntry *) e;
+
+				SpinLockAcquire(&ve->mutex);
+				memcpy(&context->entries[context->nentries], e, sizeof(StmtStatsEntry));
+				SpinLockRelease(&ve->mutex);
+				context->nentries++;
+			}
+
+			LWLockRelease(StmtStats->lock);
+		}
+		MemoryContextSwitchTo(oldcontext);
+	}
+
+	funcctx = SRF_PERCALL_SETUP();
+	context = (Context *) funcctx->user_fctx;
+	Assert(context);
+
+	if (context->current >= context->nentries * NUM_STMT_PHASES)
+		SRF_RETURN_DONE(funcctx);
+
+	entry = &context->entries[context->current / NUM_STMT_PHASES];
+	phase = context->current % NUM_STMT_PHASES;
+	hist = &entry->phases[phase];
+	context->current++;
+
+	MemSet(nulls, false, sizeof(nulls));
+	values[0] = ObjectIdGetDatum(entry->key.dbid);
+	values[1] = ObjectIdGetDatum(entry->key.userid);
+	values[2] = Int64GetDatum((int64) entry->key.fingerprint);
+	values[3] = CStringGetTextDatum(StmtStatsPhaseNames[phase]);
+	values[4] = Int64GetDatum(entry->calls);
+	values[5] = Float8GetDatum(hist->totalUsecs / 1000.0);
+	values[6] = Float8GetDatum(hist->totalUsecs / 1000.0 / Max(entry->calls, 1));
+	values[7] = Float8GetDatum(StmtStatsPercentile(hist, entry->calls, 0.50));
+	values[8] = Float8GetDatum(StmtStatsPercentile(hist, entry->calls, 0.90));
+	values[9] = Float8GetDatum(StmtStatsPercentile(hist, entry->calls, 0.99));
+	values[10] = Float8GetDatum(hist->maxUsecs / 1000.0);
+	/* Only superusers see the text of other users' statements */
+	if (superuser() || entry->key.userid == GetUserId())
+		values[11] = CStringGetTextDatum(entry->query);
+	else
+		values[11] = CStringGetTextDatum("<insufficient privilege>");
+
+	tuple = heap_form_tuple(funcctx->tuple_desc, values, nulls);
+	SRF_RETURN_NEXT(funcctx, HeapTupleGetDatum(tuple));
+}
+
+/*
+ * gp_statement_stats_reset
+ *		Forget the latency of all statements.
+ */
+Datum
+gp_statement_stats_reset(PG_FUNCTION_ARGS)
+{
+	HASH_SEQ_STATUS status;
+	StmtStatsEntry *entry;
+
+	if (!superuser())
+		ereport(ERROR,
+				(errcode(ERRCODE_INSUFFICIENT_PRIVILEGE),
+				 errmsg("must be superuser to reset statement statistics")));
+
+	if (StmtStats == NULL)
+		PG_RETURN_VOID();
+
+	LWLockAcquire(StmtStats->lock, LW_EXCLUSIVE);
+
+	hash_seq_init(&status, StmtStatsHash);
+	while ((entry = (StmtStatsEntry *) hash_seq_search(&status)) != NULL)
+		hash_search(StmtStatsHash, &entry->key, HASH_REMOVE, NULL);
+
+	LWLockRelease(StmtStats->lock);
+
+	PG_RETURN_VOID();
+}
@@ -61,7 +61,9 @@ typedef struct DirectDispatchCalculationInfo
 {
 	/*
 	 * In this use of the  DirectDispatchInfo structure, a NULL contentIds
-	 * means that ANY contentID is valid (when dd->isDirectDispatch is true)
+	 * means that ANY contentID is valid (when dd->isDirectDispatch is true),
+	 * unless dd->paramKeys is set: then the contentIds are only known once
+	 * the parameter values are.
 	 *
 	 * Note also that we don't free dd->contentIds.  We let memory context
 	 * cleanup handle that.
@@ -127,6 +129,66 @@ CdbHashConstValue(CdbHash *h, Const *c)
 	}
 }
 
+/**
+ * Look for a top-level "var = $n" conjunct of the given qualification, where the
+ *   Param is an extern Param that can be hashed like var.
+ *
+ * @return the Param, or NULL if there is no such conjunct
+ */
+static Param *
+FindExternParamForVariable(Node *qualification, Var *var)
+{
+	List	   *quals;
+	ListCell   *lc;
+
+	if (qualification == NULL)
+		return NULL;
+
+	if (IsA(qualification, List))
+		quals = (List *) qualification;
+	else
+		quals = make_ands_implicit((Expr *) qualification);
+
+	foreach(lc, quals)
+	{
+		OpExpr	   *expr = (OpExpr *) lfirst(lc);
+		Node	   *leftop;
+		Node	   *rightop;
+		Node	   *varExpr;
+		Param	   *param;
+
+		if (!IsA(expr, OpExpr) || list_length(expr->args) != 2)
+			continue;
+
+		leftop = get_leftop((Expr *) expr);
+		rightop = get_rightop((Expr *) expr);
+
+		if (IsA(rightop, Param))
+		{
+			param = (Param *) rightop;
+			varExpr = leftop;
+		}
+		else if (IsA(leftop, Param))
+		{
+			param = (Param *) leftop;
+			varExpr = rightop;
+		}
+		else
+			continue;
+
+		if (IsA(varExpr, RelabelType))
+			varExpr = (Node *) ((RelabelType *) varExpr)->arg;
+
+		if (param->paramkind == PARAM_EXTERN &&
+			equal(varExpr, var) &&
+			is_builtin_greenplum_hashable_equality_between_same_type(expr->opno) &&
+			isGreenplumDbHashable(param->paramtype))
+			return param;
+	}
+
+	return NULL;
+}
+
 /**
  * Initialize a DirectDispatchCalculationInfo.
  */
@@ -135,6 +197,7 @@ InitDirectDispatchCalculationInfo(DirectDispatchCalculationInfo *data)
 {
 	data->dd.isDirectDispatch = false;
 	data->dd.contentIds = NULL;
+	data->dd.paramKeys = NIL;
 	data->haveProcessedAnyCalculations = false;
 }
 
@@ -147,6 +210,7 @@ DisableTargetedDispatch(DirectDispatchCalculationInfo *data)
 	data->dd.isDirectDispatch = false;
 	data->dd.contentIds = NULL; /* leaks but it's okay, we made a new memory
 								 * context for the entire calculation */
+	data->dd.paramKeys = NIL;
 	data->haveProcessedAnyCalculations = true;
 }
 
@@ -225,6 +289,7 @@ GetContentIdsFromPlanForSingleRelation(List *rtable, Plan *plan, int rangeTableI
 	else
 	{
 		long		totalCombinations = 1;
+		bool		haveParams = false;
 
 		/* calculate possible value set for each partitioning attribute */
 		for (i = 0; i < policy->nattrs; i++)
@@ -243,13 +308,25 @@ GetContentIdsFromPlanForSingleRelation(List *rtable, Plan *plan, int rangeTableI
 
 			if (pvs.isAnyValuePossible)
 			{
-				/*
-				 * can't isolate to single statement -- totalCombinations = -1
-				 * will signal this
-				 */
+				Param	   *param = FindExternParamForVariable(qualification, var);
+
 				DeletePossibleValueSetData(&pvs);
-				totalCombinations = -1;
-				break;
+
+				if (param == NULL)
+				{
+					/*
+					 * can't isolate to single statement -- totalCombinations
+					 * = -1 will signal this
+					 */
+					totalCombinations = -1;
+					break;
+				}
+
+				/* the value is only known at execute time */
+				parts[i].values = (Node **) palloc(sizeof(Node *));
+				parts[i].values[0] = (Node *) param;
+				parts[i].numValues = 1;
+				haveParams = true;
 			}
 			else
 			{
@@ -276,6 +353,26 @@ GetContentIdsFromPlanForSingleRelation(List *rtable, Plan *plan, int rangeTableI
 		}
 		else if (totalCombinations > 0 &&
 			/* don't bother for ones which will likely hash to many segments */
+				 totalCombinations < GpIdentity.numsegments * 3 &&
+				 haveParams)
+		{
+			/*
+			 * leave the hashing to the executor, which knows the values of
+			 * the Params
+			 */
+			result.dd.isDirectDispatch = true;
+			result.dd.contentIds = NULL;
+			for (i = 0; i < policy->nattrs; i++)
+			{
+				List	   *values = NIL;
+				int			j;
+
+				for (j = 0; j < parts[i].numValues; j++)
+					values = lappend(values, parts[i].values[j]);
+				result.dd.paramKeys = lappend(result.dd.paramKeys, values);
+			}
+		}
+		else if (totalCombinations > 0 &&
 				 totalCombinations < GpIdentity.numsegments * 3)
 		{
 			CdbHash    *h = makeCdbHash(GpIdentity.numsegments);
@@ -316,17 +413,12 @@ GetContentIdsFromPlanForSingleRelation(List *rtable, Plan *plan, int rangeTableI
 
 				hashCode = cdbhashreduce(h);
 
-				/*
-				 * right now we only allow ONE contentid
-				 */
-				if (result.dd.contentIds == NULL)
-					result.dd.contentIds = list_make1_int(hashCode);
-				else if (linitial_int(result.dd.contentIds) != hashCode)
-				{
-					result.dd.isDirectDispatch = false;
-					break;
-				}
+				result.dd.contentIds = list_append_unique_int(result.dd.contentIds, hashCode);
 			}
+
+			/* no point in targeting every segment */
+			if (list_length(result.dd.contentIds) >= GpIdentity.numsegments)
+				result.dd.isDirectDispatch = false;
 		}
 		else
 		{
@@ -356,29 +448,32 @@ MergeDirectDispatchCalculationInfo(DirectDispatchCalculationInfo *to, DirectDisp
 	{
 		/* to cannot get better -- leave it alone */
 	}
-	else if (from->dd.contentIds == NULL)
+	else if (from->dd.contentIds == NULL && from->dd.paramKeys == NIL)
 	{
 		/* from says that it doesn't need to run anywhere -- so we accept to */
 	}
-	else if (to->dd.contentIds == NULL)
+	else if (to->dd.contentIds == NULL && to->dd.paramKeys == NIL)
 	{
 		/* to didn't even think it needed to run so accept from */
 		to->dd.contentIds = from->dd.contentIds;
+		to->dd.paramKeys = from->dd.paramKeys;
 	}
-	else if (linitial_int(to->dd.contentIds) != linitial_int(from->dd.contentIds))
+	else if (to->dd.paramKeys != NIL || from->dd.paramKeys != NIL)
 	{
 		/*
-		 * we only support dispatch to single segment or all segments, so
-		 * can't support this right now
+		 * the executor only computes targets for a single set of keys, so
+		 * we can't support this right now
 		 */
-		/* but this needs to be a union of the segments */
 		to->dd.isDirectDispatch = false;
+		to->dd.paramKeys = NIL;
 	}
 	else
 	{
-		/* they matched -- no merge required! */
+		/* the slice must run wherever either of them does */
+		to->dd.contentIds = list_union_int(to->dd.contentIds, from->dd.contentIds);
 
-		Assert(list_length(to->dd.contentIds) == list_length(from->dd.contentIds));
+		if (list_length(to->dd.contentIds) >= GpIdentity.numsegments)
+			to->dd.isDirectDispatch = false;
 	}
 
 	to->haveProcessedAnyCalculations = true;
@@ -419,11 +514,25 @@ FinalizeDirectDispatchDataForSlice(Node *node, ContentIdAssignmentData *data, bo
 
 		list_free(plan->directDispatch.contentIds);
 		plan->directDispatch.contentIds = NIL;
+		plan->directDispatch.paramKeys = NIL;
 
 		if (ddcr->haveProcessedAnyCalculations)
 		{
 			plan->directDispatch.isDirectDispatch = ddcr->dd.isDirectDispatch;
-			if (ddcr->dd.isDirectDispatch)
+			if (ddcr->dd.isDirectDispatch && ddcr->dd.paramKeys != NIL)
+			{
+				MemoryContext oldContext;
+
+				/* the executor will decide, see GetContentIdsFromParamKeys */
+				plan->directDispatch.isDirectDispatch = false;
+				if (ShouldPrintTestMessages())
+					elog(INFO, "DDCR learned dispatch depends on parameter values");
+
+				oldContext = MemoryContextSwitchTo(data->memoryContextForOutput);
+				plan->directDispatch.paramKeys = copyObject(ddcr->dd.paramKeys);
+				MemoryContextSwitchTo(oldContext);
+			}
+			else if (ddcr->dd.isDirectDispatch)
 			{
 				MemoryContext oldContext;
 
@@ -433,11 +542,16 @@ FinalizeDirectDispatchDataForSlice(Node *node, ContentIdAssignmentData *data, bo
 					if (ShouldPrintTestMessages())
 						elog(INFO, "DDCR learned no content dispatch is required");
 				}
-				else
+				else if (list_length(ddcr->dd.contentIds) == 1)
 				{
 					if (ShouldPrintTestMessages())
 						elog(INFO, "DDCR learned dispatch to content %d", linitial_int(ddcr->dd.contentIds));
 				}
+				else
+				{
+					if (ShouldPrintTestMessages())
+						elog(INFO, "DDCR learned dispatch to %d contents", list_length(ddcr->dd.contentIds));
+				}
 
 				oldContext = MemoryContextSwitchTo(data->memoryContextForOutput);
 				plan->directDispatch.contentIds = list_copy(ddcr->dd.contentIds);
@@ -717,8 +831,83 @@ AssignContentIdsToPlanData(Query *query, Plan *plan, PlannerInfo *root)
 			plan->directDispatch.isDirectDispatch = false;
 			list_free(plan->directDispatch.contentIds);
 			plan->directDispatch.contentIds = NIL;
+			plan->directDispatch.paramKeys = NIL;
 		}
 	}
 
 	DeleteAndRestoreSwitchedMemoryContext(mem);
 }
+
+/**
+ * Compute the contents that a plan node must run on from its directDispatch.paramKeys,
+ *   now that the values of the Params in them are known.
+ *
+ * @return the list of content ids, or NIL if the node must run on all contents
+ */
+List *
+GetContentIdsFromParamKeys(DirectDispatchInfo *dd, ParamListInfo params)
+{
+	CdbHash    *h;
+	List	   *contentIds = NIL;
+	long		totalCombinations = 1;
+	long		index;
+	ListCell   *lc;
+
+	Assert(dd->paramKeys != NIL);
+
+	foreach(lc, dd->paramKeys)
+		totalCombinations *= list_length((List *) lfirst(lc));
+
+	h = makeCdbHash(GpIdentity.numsegments);
+
+	/* for each combination of keys calculate target segment */
+	for (index = 0; index < totalCombinations; index++)
+	{
+		long		curIndex = index;
+
+		/* hash the attribute values */
+		cdbhashinit(h);
+
+		foreach(lc, dd->paramKeys)
+		{
+			List	   *values = (List *) lfirst(lc);
+			int			numValues = list_length(values);
+			Node	   *val = list_nth(values, curIndex % numValues);
+
+			if (IsA(val, Const))
+			{
+				CdbHashConstValue(h, (Const *) val);
+			}
+			else
+			{
+				Param	   *param = (Param *) val;
+				ParamExternData *prm;
+
+				Assert(IsA(param, Param) && param->paramkind == PARAM_EXTERN);
+
+				if (params == NULL ||
+					param->paramid <= 0 ||
+					param->paramid > params->numParams)
+					return NIL;
+
+				prm = &params->params[param->paramid - 1];
+				if (prm->ptype != param->paramtype)
+					return NIL;
+
+				if (prm->isnull)
+					cdbhashnull(h);
+				else
+					cdbhash(h, prm->value, typeIsArrayType(prm->ptype) ? ANYARRAYOID : prm->ptype);
+			}
+			curIndex /= numValues;
+		}
+
+		contentIds = list_append_unique_int(contentIds, cdbhashreduce(h));
+	}
+
+	/* no point in targeting every segment */
+	if (list_length(contentIds) >= GpIdentity.numsegments)
+		return NIL;
+
+	return contentIds;
+}
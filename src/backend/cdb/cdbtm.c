@@ -380,8 +380,7 @@ copyDirectDispatchFromTransaction(CdbDispatchDirectDesc *dOut)
 	if (currentGxact->directTransaction)
 	{
 		dOut->directed_dispatch = true;
-		dOut->count = 1;
-		dOut->content[0] = currentGxact->directTransactionContentId;
+		dOut->contentIds = list_make1_int(currentGxact->directTransactionContentId);
 	}
 	else
 	{
@@ -398,7 +397,12 @@ GetRootNodeIsDirectDispatch(PlannedStmt *stmt)
 	if (stmt->planTree == NULL)
 		return false;
 
-	return stmt->planTree->directDispatch.isDirectDispatch;
+	/*
+	 * A plan whose targets are computed from its parameters may be directed,
+	 * too; either way, it is not known here to which contents.
+	 */
+	return stmt->planTree->directDispatch.isDirectDispatch ||
+		stmt->planTree->directDispatch.paramKeys != NIL;
 }
 
 /**
@@ -415,6 +419,11 @@ GetPlannedStmtDirectDispatch_AndUsingNodeIsSufficient(PlannedStmt *stmt)
 	if (!GetRootNodeIsDirectDispatch(stmt))
 		return false;
 
+	/* a direct transaction runs on a single content */
+	if (!stmt->planTree->directDispatch.isDirectDispatch ||
+		list_length(stmt->planTree->directDispatch.contentIds) != 1)
+		return false;
+
 	/*
 	 * now look at number initplans .. we do something simple.  ANY initPlans
 	 * means we don't do directDispatch at the dtm level.  It's technically
@@ -2155,7 +2164,7 @@ doDispatchDtxProtocolCommand(DtxProtocolCommand dtxProtocolCommand, int flags,
 	elog(DTM_DEBUG5,
 		 "dispatchDtxProtocolCommand: %d ('%s'), direct content #: %d",
 		 dtxProtocolCommand, dtxProtocolCommandStr,
-		 direct->directed_dispatch ? direct->content[0] : -1);
+		 direct->directed_dispatch ? linitial_int(direct->contentIds) : -1);
 
 	initStringInfo(&errbuf);
 	results = CdbDispatchDtxProtocolCommand(dtxProtocolCommand, flags,
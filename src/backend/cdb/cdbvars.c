@@ -84,15 +84,26 @@ int			gp_backup_directIO_read_chunk_mb = 20;	/* size of readChunk
 
 bool		gp_external_enable_exec = true; /* allow ext tables with EXECUTE */
 
+bool		gp_external_projection = true;	/* parse only the needed columns */
+
 int			gp_external_max_segs;	/* max segdbs per gpfdist/gpfdists URI */
 
 int			gp_safefswritesize; /* set for safe AO writes in non-mature fs */
+int			gp_appendonly_prefetch_depth;	/* large reads to prefetch ahead */
+int			gp_appendonly_compress_workers;	/* threads compressing AO blocks */
+int			gp_appendonly_preallocate_size;	/* kB reserved ahead of AO writes */
 
 int			gp_connections_per_thread;	/* How many libpq connections are
 										 * handled in each thread */
 
 int			gp_cached_gang_threshold;	/* How many gangs to keep around from
 										 * stmt to stmt. */
+int			gp_cached_gang_low_watermark;	/* How many idle gangs to set
+											 * up ahead of need. */
+int			gp_sequence_lease_max;	/* Max sequence values a QE leases
+									 * per seqserver round-trip. */
+int			gp_max_endpoints;	/* How many endpoints of parallel retrieve
+								 * cursors each segment can hold. */
 
 int			Gp_segment = UNDEF_SEGMENT; /* What content this QE is handling. */
 
@@ -144,8 +155,8 @@ int			gp_fts_probe_timeout = 20;
 int			gp_fts_probe_interval = 60;
 
 /*
- * Number of threads to use for probe of segments (it is a good idea to have this
- * larger than the number of segments per host.
+ * Number of threads to use for probe of segments.  No longer used: the prober
+ * probes all segments in parallel from a single event loop.
  */
 int			gp_fts_probe_threadcount = 16;
 
@@ -205,6 +216,8 @@ int			Gp_interconnect_fc_method = INTERCONNECT_FC_METHOD_LOSS;
 int			Gp_interconnect_transmit_timeout = 3600;
 int			Gp_interconnect_min_retries_before_timeout = 100;
 int			Gp_interconnect_debug_retry_interval = 10;
+int			Gp_interconnect_mmsg_batch_size = 1;
+int			Gp_interconnect_tcp_conn_cache_size = 0;
 
 int			Gp_interconnect_hash_multiplier = 2;	/* sets the size of the
 													 * hash table used by the
@@ -223,6 +236,8 @@ bool		gp_interconnect_log_stats = false;	/* emit stats at log-level */
 
 bool		gp_interconnect_cache_future_packets = true;
 
+int			gp_interconnect_compress_min_size = 0;	/* compress big tuples */
+
 int			Gp_udp_bufsize_k;	/* UPD recv buf size, in KB */
 
 #ifdef USE_ASSERT_CHECKING
@@ -256,10 +271,23 @@ double		gp_hashagg_respill_bias = 1;
  */
 
 double		gp_motion_cost_per_row = 0;
+double		gp_motion_hot_key_fraction = 0;
 int			gp_segments_for_planner = 0;
 
 int			gp_hashagg_default_nbatches = 32;
 
+/* streaming hashagg to keep its hot groups in memory when it flushes */
+bool		gp_hashagg_stream_keep_hot = false;
+
+/* hashagg to look up groups through an open-addressing index */
+bool		gp_hashagg_index_groups = false;
+
+/* groups per input row above which streaming hashagg stops aggregating */
+double		gp_hashagg_passthrough_ratio = 0.9;
+
+/* outer rows a nestloop reads ahead to probe its inner index scan */
+int			gp_nestloop_probe_batch = 0;
+
 bool		gp_adjust_selectivity_for_outerjoins = TRUE;
 bool		gp_selectivity_damping_for_scans = false;
 bool		gp_selectivity_damping_for_joins = false;
@@ -278,12 +306,28 @@ int			gp_hashagg_spillbatch_max = 0;
 /* hash join to use bloom filter: default to 0, means not used */
 int			gp_hashjoin_bloomfilter = 0;
 
+/* hash join to filter the outer scan by the inner side's hash values */
+bool		gp_hashjoin_runtime_filter = false;
+
+/* hash join to probe a contiguous copy of each batch's bucket chains */
+bool		gp_hashjoin_compact_buckets = false;
+
+/* threads helping a hash join link its in-memory batch */
+int			gp_hashjoin_build_threads = 0;
+
+/* semi and anti hash joins to keep one inner tuple per distinct key */
+bool		gp_hashjoin_dedup_inner = false;
+
+/* QEs of a host to share the hash table of a broadcast inner side */
+bool		gp_hashjoin_share_broadcast = false;
+
 /* Analyzing aid */
 int			gp_motion_slice_noop = 0;
 
 /* Greenplum Database Experimental Feature GUCs */
 int			gp_distinct_grouping_sets_threshold = 32;
 bool		gp_enable_explain_allstat = FALSE;
+int			gp_explain_analyze_timing_sample = 1;
 bool		gp_enable_motion_deadlock_sanity = FALSE;	/* planning time sanity
 														 * check */
 
@@ -311,11 +355,21 @@ int			gp_segworker_relative_priority = PRIO_MAX;
 /* Max size of dispatched plans; 0 if no limit */
 int			gp_max_plan_size = 0;
 
+/* Number of recently dispatched plans to keep serialized; 0 to disable */
+int			gp_dispatch_plan_cache_size = 16;
+
+/* Send session-level SET commands along with the next dispatched command */
+bool		gp_dispatch_session_state_delta = false;
+
+/* Leave utility commands in a transaction block running on the QEs */
+bool		gp_dispatch_pipeline = false;
+
 /* Disable setting of tuple hints while reading */
 bool		gp_disable_tuple_hints = false;
 
 int			gp_workfile_compress_algorithm = 0;
 bool		gp_workfile_checksumming = false;
+int			gp_workfile_io_size = 0;
 int			gp_workfile_caching_loglevel = DEBUG1;
 int			gp_sessionstate_loglevel = DEBUG1;
 
@@ -327,6 +381,15 @@ double		gp_workfile_limit_per_query = 0;
 
 /* Maximum number of workfiles to be created by a query */
 int			gp_workfile_limit_files_per_query = 0;
+
+/* Directories to spill to instead of the temporary filespace, by tier */
+char	   *gp_workfile_spill_locations = NULL;
+
+/* Free space, in kilobytes, below which a spill location is passed over */
+int			gp_workfile_spill_location_min_free = 1048576;
+
+/* Workfiles, in kilobytes, of Material results kept for later queries */
+int			gp_workfile_reuse_limit = 0;
 bool		gp_workfile_faultinject = false;
 int			gp_workfile_bytes_to_checksum = 16;
 
@@ -336,14 +399,25 @@ int			gp_workfile_type_hashjoin = 0;
 /* Gpmon */
 bool		gp_enable_gpperfmon = false;
 int			gp_gpperfmon_send_interval = 1;
+int			gp_query_progress_max_nodes = 64;
+int			gp_query_history_size = 1000;
+int			gp_statement_stats_max = 1000;
 GpperfmonLogAlertLevel gpperfmon_log_alert_level = GPPERFMON_LOG_ALERT_LEVEL_NONE;
 
 /* Enable single-slice single-row inserts ?*/
 bool		gp_enable_fast_sri = true;
 
+/* Reduce distribution hashes with jump consistent hash, see cdbhash.c */
+bool		gp_use_jump_consistent_hash = false;
+
 /* Enable single-mirror pair dispatch. */
 bool		gp_enable_direct_dispatch = true;
 
+/* Global deadlock detector */
+bool		gp_enable_global_deadlock_detector = false;
+int			gp_global_deadlock_detector_period = 120;
+bool		gp_enable_generic_plans = false;
+
 /* Disable logging while creating mapreduce objects */
 bool		gp_mapreduce_define = false;
 
@@ -359,6 +433,7 @@ char	   *gp_autostats_mode_string;
 GpAutoStatsModeValue gp_autostats_mode_in_functions;
 char	   *gp_autostats_mode_in_functions_string;
 int			gp_autostats_on_change_threshold = 100000;
+int			gp_autostats_min_interval = 60;
 bool		log_autostats = true;
 
 /* --------------------------------------------------------------------------------------------------
@@ -952,6 +1027,8 @@ gpvars_assign_gp_interconnect_fc_method(const char *newval, bool doit, GucSource
 		newmethod = INTERCONNECT_FC_METHOD_CAPACITY;
 	else if (!pg_strcasecmp("loss", newval))
 		newmethod = INTERCONNECT_FC_METHOD_LOSS;
+	else if (!pg_strcasecmp("adaptive", newval))
+		newmethod = INTERCONNECT_FC_METHOD_ADAPTIVE;
 	else
 		elog(ERROR, "Unknown interconnect flow control method. (current method is '%s')", gpvars_show_gp_interconnect_fc_method());
 
@@ -972,6 +1049,8 @@ gpvars_show_gp_interconnect_fc_method(void)
 			return "CAPACITY";
 		case INTERCONNECT_FC_METHOD_LOSS:
 			return "LOSS";
+		case INTERCONNECT_FC_METHOD_ADAPTIVE:
+			return "ADAPTIVE";
 		default:
 			return "CAPACITY";
 	}
@@ -998,6 +1077,10 @@ gpvars_parse_gp_autostats_mode(const char *newval, bool inFunctions)
 	{
 		newtype = GP_AUTOSTATS_ON_NO_STATS;
 	}
+	else if (!pg_strcasecmp("on_change_since_analyze", newval))
+	{
+		newtype = GP_AUTOSTATS_ON_CHANGE_SINCE_ANALYZE;
+	}
 	else
 	{
 		const char *autostats_mode_string;
@@ -1058,6 +1141,8 @@ gpvars_show_gp_autostats_mode_common(bool inFunctions)
 			return "ON_CHANGE";
 		case GP_AUTOSTATS_ON_NO_STATS:
 			return "ON_NO_STATS";
+		case GP_AUTOSTATS_ON_CHANGE_SINCE_ANALYZE:
+			return "ON_CHANGE_SINCE_ANALYZE";
 		default:
 			return "NONE";
 	}
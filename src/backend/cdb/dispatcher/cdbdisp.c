@@ -18,6 +18,7 @@
 #include "postgres.h"
 #include <limits.h>
 
+#include "access/xact.h"
 #include "storage/ipc.h"		/* For proc_exit_inprogress */
 #include "tcop/tcopprot.h"
 #include "cdb/cdbdisp.h"
@@ -34,12 +35,18 @@
 /*
  * default directed-dispatch parameters: don't direct anything.
  */
-CdbDispatchDirectDesc default_dispatch_direct_desc = {false, 0, {0}};
+CdbDispatchDirectDesc default_dispatch_direct_desc = {false, NIL};
 
 static void cdbdisp_clearGangActiveFlag(CdbDispatcherState *ds);
 
 static DispatcherInternalFuncs *pDispatchFuncs = NULL;
 
+/*
+ * A command that was left running on the QEs by cdbdisp_pipelineDispatch(),
+ * whose results have not been collected yet.
+ */
+static CdbDispatcherState pipelinedDispatch = {NULL, NULL, NULL};
+
 /*
  * cdbdisp_dispatchToGang:
  * Send the strCommand SQL statement to the subset of all segdbs in the cluster
@@ -100,6 +107,14 @@ cdbdisp_dispatchToGang(struct CdbDispatcherState *ds,
 		}
 	}
 
+	/*
+	 * The QEs that receive the command will also have the session state
+	 * changes it carries.
+	 */
+	if (ds->sessionStateTo != 0)
+		MarkSessionStateSent(gp, disp_direct->directed_dispatch ? disp_direct->contentIds : NIL,
+							 ds->sessionStateFrom, ds->sessionStateTo);
+
 	/*
 	 * WIP: will use a function pointer for implementation later, currently
 	 * just use an internal function to move dispatch thread related code into
@@ -424,6 +439,8 @@ cdbdisp_destroyDispatcherState(CdbDispatcherState *ds)
 	ds->dispatchStateContext = NULL;
 	ds->dispatchParams = NULL;
 	ds->primaryResults = NULL;
+	ds->sessionStateFrom = 0;
+	ds->sessionStateTo = 0;
 }
 
 void
@@ -432,6 +449,96 @@ cdbdisp_cancelDispatch(CdbDispatcherState *ds)
 	CdbCheckDispatchResult(ds, DISPATCH_WAIT_CANCEL);
 }
 
+/*
+ * Can a command that is being dispatched be left running on the QEs?
+ *
+ * Only in a transaction block: the results are collected at the latest when
+ * the transaction commits, and an error fails the transaction, as it would
+ * have if it had been reported right away.
+ */
+bool
+cdbdisp_canPipeline(void)
+{
+	return gp_dispatch_pipeline &&
+		Gp_role == GP_ROLE_DISPATCH &&
+		IsTransactionBlock() &&
+		pipelinedDispatch.primaryResults == NULL;
+}
+
+/*
+ * Take over a dispatched command, without waiting for the QEs to finish it.
+ * The results are collected by cdbdisp_syncPipeline(), before anything else
+ * is dispatched.  ds is left empty, for the caller to destroy as usual.
+ */
+void
+cdbdisp_pipelineDispatch(CdbDispatcherState *ds)
+{
+	Assert(pipelinedDispatch.primaryResults == NULL);
+	Assert(ds->primaryResults != NULL);
+
+	pipelinedDispatch = *ds;
+
+	ds->primaryResults = NULL;
+	ds->dispatchParams = NULL;
+	ds->dispatchStateContext = NULL;
+	ds->sessionStateFrom = 0;
+	ds->sessionStateTo = 0;
+}
+
+/*
+ * Wait for the command left running by cdbdisp_pipelineDispatch(), if any,
+ * and throw its error if it failed on a QE.
+ *
+ * This is the sync point of the pipeline: it is called before dispatching
+ * any other command, since the gangs can only run one command at a time and
+ * the next command may depend on the previous one, and before the
+ * transaction commits.
+ */
+void
+cdbdisp_syncPipeline(void)
+{
+	CdbDispatcherState ds;
+
+	if (pipelinedDispatch.primaryResults == NULL)
+		return;
+
+	ds = pipelinedDispatch;
+	MemSet(&pipelinedDispatch, 0, sizeof(pipelinedDispatch));
+
+	PG_TRY();
+	{
+		cdbdisp_finishCommand(&ds);
+	}
+	PG_CATCH();
+	{
+		CdbCheckDispatchResult(&ds, DISPATCH_WAIT_CANCEL);
+		cdbdisp_destroyDispatcherState(&ds);
+		PG_RE_THROW();
+	}
+	PG_END_TRY();
+}
+
+/*
+ * Cancel the command left running by cdbdisp_pipelineDispatch(), if any.
+ * Used when the (sub)transaction it belongs to aborts, and when the gangs
+ * are destroyed.
+ */
+void
+cdbdisp_cancelPipeline(void)
+{
+	CdbDispatcherState ds;
+
+	if (pipelinedDispatch.primaryResults == NULL)
+		return;
+
+	ds = pipelinedDispatch;
+	MemSet(&pipelinedDispatch, 0, sizeof(pipelinedDispatch));
+
+	if (!proc_exit_inprogress)
+		CdbCheckDispatchResult(&ds, DISPATCH_WAIT_CANCEL);
+	cdbdisp_destroyDispatcherState(&ds);
+}
+
 /*
  * Clear our "active" flags; so that we know that the writer gangs are busy -- and don't stomp on
  * internal dispatcher structures.
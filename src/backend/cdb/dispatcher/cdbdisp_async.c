@@ -24,6 +24,10 @@
 #ifdef HAVE_SYS_POLL_H
 #include <sys/poll.h>
 #endif
+#ifdef __linux__
+#include <sys/epoll.h>
+#define USE_DISPATCH_EPOLL
+#endif
 
 #include "storage/ipc.h"		/* For proc_exit_inprogress  */
 #include "tcop/tcopprot.h"
@@ -46,6 +50,12 @@
  */
 #define DISPATCH_WAIT_CANCEL_TIMEOUT_MSEC 100
 
+/*
+ * Below this many QE connections, rebuilding the poll() array on every pass
+ * is cheaper than setting up an epoll instance.
+ */
+#define DISPATCH_EPOLL_MIN_CONNECTIONS 64
+
 typedef struct CdbDispatchCmdAsync
 {
 
@@ -113,6 +123,9 @@ static void dispatchCommand(CdbDispatchResult *dispatchResult,
 
 static void checkDispatchResult(CdbDispatcherState *ds,
 					bool wait);
+#ifdef USE_DISPATCH_EPOLL
+static bool checkDispatchResultEpoll(CdbDispatcherState *ds);
+#endif
 
 static bool processResults(CdbDispatchResult *dispatchResult);
 
@@ -128,6 +141,9 @@ static void
 static void
 			handlePollSuccess(CdbDispatchCmdAsync *pParms, struct pollfd *fds);
 
+static void
+			handleResults(CdbDispatchCmdAsync *pParms, int i);
+
 /*
  * Check dispatch result.
  * Don't wait all dispatch commands to complete.
@@ -254,9 +270,7 @@ cdbdisp_dispatchToGang_async(struct CdbDispatcherState *ds,
 
 		if (dispDirect->directed_dispatch)
 		{
-			/* We can direct dispatch to one segment DB only */
-			Assert(dispDirect->count == 1);
-			if (dispDirect->content[0] != segdbDesc->segindex)
+			if (!list_member_int(dispDirect->contentIds, segdbDesc->segindex))
 				continue;
 		}
 
@@ -364,6 +378,13 @@ checkDispatchResult(CdbDispatcherState *ds,
 	struct pollfd *fds;
 
 	db_count = pParms->dispatchCount;
+
+#ifdef USE_DISPATCH_EPOLL
+	if (wait && db_count >= DISPATCH_EPOLL_MIN_CONNECTIONS &&
+		checkDispatchResultEpoll(ds))
+		return;
+#endif
+
 	fds = (struct pollfd *) palloc(db_count * sizeof(struct pollfd));
 
 	/*
@@ -491,6 +512,185 @@ checkDispatchResult(CdbDispatcherState *ds,
 	pfree(fds);
 }
 
+#ifdef USE_DISPATCH_EPOLL
+/*
+ * Like checkDispatchResult(ds, true), but waits with epoll, so that each
+ * wakeup costs time in proportion to the number of QEs that have sent us
+ * something rather than to the number of QEs still running.
+ *
+ * The sockets are registered level-triggered: processResults() may leave
+ * data unread in the socket, which an edge-triggered registration would
+ * never report again.
+ *
+ * Returns false, without having waited, if epoll could not be set up.
+ */
+static bool
+checkDispatchResultEpoll(CdbDispatcherState *ds)
+{
+	CdbDispatchCmdAsync *pParms = (CdbDispatchCmdAsync *) ds->dispatchParams;
+	CdbDispatchResults *meleeResults = ds->primaryResults;
+	struct epoll_event *events;
+	int			db_count = pParms->dispatchCount;
+	int			nrunning = 0;
+	int			timeout = 0;
+	bool		sentSignal = false;
+	int			epfd;
+	int			i;
+
+	epfd = epoll_create(db_count);
+	if (epfd < 0)
+	{
+		elog(LOG, "epoll_create() failed; errno=%d", errno);
+		return false;
+	}
+
+	for (i = 0; i < db_count; i++)
+	{
+		CdbDispatchResult *dispatchResult = pParms->dispatchResultPtrArray[i];
+		struct epoll_event ev;
+
+		if (!dispatchResult->stillRunning)
+			continue;
+
+		Assert(!cdbconn_isBadConnection(dispatchResult->segdbDesc));
+
+		MemSet(&ev, 0, sizeof(ev));
+		ev.events = EPOLLIN;
+		ev.data.u32 = i;
+		if (epoll_ctl(epfd, EPOLL_CTL_ADD, PQsocket(dispatchResult->segdbDesc->conn), &ev) < 0)
+		{
+			elog(LOG, "epoll_ctl() failed; errno=%d", errno);
+			close(epfd);
+			return false;
+		}
+		nrunning++;
+	}
+
+	events = (struct epoll_event *) palloc(db_count * sizeof(struct epoll_event));
+
+	PG_TRY();
+	{
+		for (;;)
+		{
+			int			n;
+
+			/*
+			 * bail-out if we are dying. Once QD dies, QE will recognize it
+			 * shortly anyway.
+			 */
+			if (proc_exit_inprogress)
+				break;
+
+			/*
+			 * escalate waitMode to cancel if: - user interrupt has occurred,
+			 * - or an error has been reported by any QE, - in case the caller
+			 * wants cancelOnError
+			 */
+			if ((InterruptPending || meleeResults->errcode) && meleeResults->cancelOnError)
+				pParms->waitMode = DISPATCH_WAIT_CANCEL;
+
+			/*
+			 * Break out when no QEs still running.
+			 */
+			if (nrunning <= 0)
+				break;
+
+			/*
+			 * Lower the timeout if we need send signal to QEs.
+			 */
+			if (pParms->waitMode == DISPATCH_WAIT_NONE || sentSignal)
+				timeout = DISPATCH_WAIT_TIMEOUT_MSEC;
+			else
+				timeout = DISPATCH_WAIT_CANCEL_TIMEOUT_MSEC;
+
+			n = epoll_wait(epfd, events, db_count, timeout);
+
+			if (n < 0)
+			{
+				int			sock_errno = SOCK_ERRNO;
+
+				if (sock_errno == EINTR)
+					continue;
+
+				elog(LOG, "handlePollError epoll_wait() failed; errno=%d", sock_errno);
+
+				/*
+				 * Connections that these close are dropped from the epoll set
+				 * along with their sockets.
+				 */
+				handlePollError(pParms);
+				checkSegmentAlive(pParms);
+
+				if (pParms->waitMode != DISPATCH_WAIT_NONE)
+				{
+					signalQEs(pParms);
+					sentSignal = true;
+				}
+			}
+			/* If the time limit expires, epoll_wait() returns 0 */
+			else if (n == 0)
+			{
+				if (pParms->waitMode != DISPATCH_WAIT_NONE)
+				{
+					signalQEs(pParms);
+					sentSignal = true;
+				}
+
+				if (timeoutCounter++ > 30)
+				{
+					checkSegmentAlive(pParms);
+					timeoutCounter = 0;
+				}
+			}
+			/* We have data waiting on one or more of the connections. */
+			else
+			{
+				int			k;
+
+				for (k = 0; k < n; k++)
+				{
+					CdbDispatchResult *dispatchResult;
+
+					i = events[k].data.u32;
+					dispatchResult = pParms->dispatchResultPtrArray[i];
+
+					if (!dispatchResult->stillRunning)
+						continue;
+
+					/* Assume the socket is readable on an error or hangup, too */
+					handleResults(pParms, i);
+
+					if (!dispatchResult->stillRunning &&
+						!cdbconn_isBadConnection(dispatchResult->segdbDesc))
+						epoll_ctl(epfd, EPOLL_CTL_DEL,
+								  PQsocket(dispatchResult->segdbDesc->conn), &events[k]);
+				}
+				continue;
+			}
+
+			/* Some QEs may have been given up on; count the others again. */
+			nrunning = 0;
+			for (i = 0; i < db_count; i++)
+			{
+				if (pParms->dispatchResultPtrArray[i]->stillRunning)
+					nrunning++;
+			}
+		}
+	}
+	PG_CATCH();
+	{
+		close(epfd);
+		PG_RE_THROW();
+	}
+	PG_END_TRY();
+
+	close(epfd);
+	pfree(events);
+
+	return true;
+}
+#endif   /* USE_DISPATCH_EPOLL */
+
 /*
  * Helper function that actually kicks off the command on the libpq connection.
  */
@@ -599,7 +799,6 @@ handlePollSuccess(CdbDispatchCmdAsync *pParms,
 	 */
 	for (i = 0; i < pParms->dispatchCount; i++)
 	{
-		bool		finished;
 		int			sock;
 		CdbDispatchResult *dispatchResult = pParms->dispatchResultPtrArray[i];
 		SegmentDatabaseDescriptor *segdbDesc = dispatchResult->segdbDesc;
@@ -626,42 +825,55 @@ handlePollSuccess(CdbDispatchCmdAsync *pParms,
 		ELOG_DISPATCHER_DEBUG("PQsocket says there are results from %d of %d (%s)",
 							  i + 1, pParms->dispatchCount, segdbDesc->whoami);
 
-		/*
-		 * Receive and process results from this QE.
-		 */
-		finished = processResults(dispatchResult);
+		handleResults(pParms, i);
+	}
+}
 
-		/*
-		 * Are we through with this QE now?
-		 */
-		if (finished)
-		{
-			dispatchResult->stillRunning = false;
+/*
+ * Receive and process results from the i'th QE, which has input available.
+ */
+static void
+handleResults(CdbDispatchCmdAsync *pParms, int i)
+{
+	CdbDispatchResult *dispatchResult = pParms->dispatchResultPtrArray[i];
+	SegmentDatabaseDescriptor *segdbDesc = dispatchResult->segdbDesc;
+	bool		finished;
 
-			ELOG_DISPATCHER_DEBUG("processResults says we are finished with %d of %d (%s)",
-								  i + 1, pParms->dispatchCount, segdbDesc->whoami);
+	/*
+	 * Receive and process results from this QE.
+	 */
+	finished = processResults(dispatchResult);
 
-			if (DEBUG1 >= log_min_messages)
-			{
-				char		msec_str[32];
+	/*
+	 * Are we through with this QE now?
+	 */
+	if (finished)
+	{
+		dispatchResult->stillRunning = false;
 
-				switch (check_log_duration(msec_str, false))
-				{
-					case 1:
-					case 2:
-						elog(LOG, "duration to dispatch result received from %d (seg %d): %s ms",
-							 i + 1, dispatchResult->segdbDesc->segindex, msec_str);
-						break;
-				}
-			}
+		ELOG_DISPATCHER_DEBUG("processResults says we are finished with %d of %d (%s)",
+							  i + 1, pParms->dispatchCount, segdbDesc->whoami);
 
-			if (PQisBusy(dispatchResult->segdbDesc->conn))
-				elog(LOG, "We thought we were done, because finished==true, but libpq says we are still busy");
+		if (DEBUG1 >= log_min_messages)
+		{
+			char		msec_str[32];
+
+			switch (check_log_duration(msec_str, false))
+			{
+				case 1:
+				case 2:
+					elog(LOG, "duration to dispatch result received from %d (seg %d): %s ms",
+						 i + 1, dispatchResult->segdbDesc->segindex, msec_str);
+					break;
+			}
 		}
-		else
-			ELOG_DISPATCHER_DEBUG("processResults says we have more to do with %d of %d (%s)",
-								  i + 1, pParms->dispatchCount, segdbDesc->whoami);
+
+		if (PQisBusy(dispatchResult->segdbDesc->conn))
+			elog(LOG, "We thought we were done, because finished==true, but libpq says we are still busy");
 	}
+	else
+		ELOG_DISPATCHER_DEBUG("processResults says we have more to do with %d of %d (%s)",
+							  i + 1, pParms->dispatchCount, segdbDesc->whoami);
 }
 
 /*
@@ -94,10 +94,13 @@ CdbDispatchDtxProtocolCommand(DtxProtocolCommand dtxProtocolCommand,
 	elog((Debug_print_full_dtm ? LOG : DEBUG5),
 		 "CdbDispatchDtxProtocolCommand: %s for gid = %s, direct content #: %d",
 		 dtxProtocolCommandLoggingStr, gid,
-		 direct->directed_dispatch ? direct->content[0] : -1);
+		 direct->directed_dispatch ? linitial_int(direct->contentIds) : -1);
 
 	*badGangs = false;
 
+	/* The previous command must be done before the gang is used again. */
+	cdbdisp_syncPipeline();
+
 	MemSet(&dtxProtocolParms, 0, sizeof(dtxProtocolParms));
 	dtxProtocolParms.dtxProtocolCommand = dtxProtocolCommand;
 	dtxProtocolParms.flags = flags;
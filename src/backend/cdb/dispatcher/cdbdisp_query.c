@@ -20,6 +20,7 @@
 #include "gp-libpq-fe.h"
 #include "gp-libpq-int.h"
 #include "cdb/cdbconn.h"
+#include "cdb/cdbexplain.h"
 #include "cdb/cdbgang.h"
 #include "cdb/cdbutil.h"
 #include "cdb/cdbvars.h"
@@ -100,6 +101,12 @@ typedef struct DispatchCommandQueryParms
 	/* the map from sliceIndex to gang_id, in array form */
 	int			numSlices;
 	int		   *sliceIndexGangIdMap;
+
+	/*
+	 * The gangs the command is dispatched to, whose QEs must be sent the
+	 * session state changes they lack.
+	 */
+	List	   *gangs;
 } DispatchCommandQueryParms;
 
 static void cdbdisp_dispatchCommandInternal(const char *strCommand,
@@ -136,7 +143,8 @@ static void
 static void cdbdisp_dispatchX(DispatchCommandQueryParms *pQueryParms,
 				  bool cancelOnError,
 				  struct SliceTable *sliceTbl,
-				  struct CdbDispatcherState *ds);
+				  struct CdbDispatcherState *ds,
+				  struct CdbExplain_ShowStatCtx *showstatctx);
 
 static int *buildSliceIndexGangIdMap(SliceVec *sliceVec, int numSlices, int numTotalSlices);
 
@@ -193,6 +201,9 @@ CdbDispatchPlan(struct QueryDesc *queryDesc,
 	Assert(Gp_role == GP_ROLE_DISPATCH);
 	Assert(queryDesc != NULL && queryDesc->estate != NULL);
 
+	/* The previous command must be done before the gangs are used again. */
+	cdbdisp_syncPipeline();
+
 	/*
 	 * Later we'll need to operate with the slice table provided via the
 	 * EState structure in the argument QueryDesc. Cache this information
@@ -274,7 +285,8 @@ CdbDispatchPlan(struct QueryDesc *queryDesc,
 	ds->primaryResults = NULL;
 	ds->dispatchParams = NULL;
 
-	cdbdisp_dispatchX(pQueryParms, cancelOnError, sliceTbl, ds);
+	cdbdisp_dispatchX(pQueryParms, cancelOnError, sliceTbl, ds,
+					  queryDesc->showstatctx);
 
 	cdbdisp_destroyQueryParms(pQueryParms);
 
@@ -296,6 +308,9 @@ CdbDispatchSetCommand(const char *strCommand,
 		 "CdbDispatchSetCommand for command = '%s', needTwoPhase = %s",
 		 strCommand, (needTwoPhase ? "true" : "false"));
 
+	/* The previous command must be done before the gangs are used again. */
+	cdbdisp_syncPipeline();
+
 	dtmPreCommand("CdbDispatchSetCommand", strCommand, NULL, needTwoPhase,
 				  withSnapshot, false /* inCursor */ );
 
@@ -455,6 +470,10 @@ cdbdisp_dispatchCommandInternal(const char *strCommand,
 	bool		cancelOnError = flags & DF_CANCEL_ON_ERROR;
 	bool		needTwoPhase = flags & DF_NEED_TWO_PHASE;
 	bool		withSnapshot = flags & DF_WITH_SNAPSHOT;
+	bool		pipeline = (flags & DF_PIPELINE) && cdb_pgresults == NULL;
+
+	/* The previous command must be done before the gang is used again. */
+	cdbdisp_syncPipeline();
 
 	dtmPreCommand("cdbdisp_dispatchCommandOrSerializedQuerytree", strCommand,
 				  NULL, needTwoPhase, withSnapshot,
@@ -482,6 +501,8 @@ cdbdisp_dispatchCommandInternal(const char *strCommand,
 
 	Assert(primaryGang);
 
+	pQueryParms->gangs = list_make1(primaryGang);
+
 	/*
 	 * Serialize a version of our DTX Context Info
 	 */
@@ -518,40 +539,51 @@ cdbdisp_dispatchCommandInternal(const char *strCommand,
 		cdbdisp_waitDispatchFinish(&ds);
 
 		/*
-		 * Block until valid results is available or one or more QEs got
-		 * errors.
+		 * Leave the command running on the QEs if the caller doesn't need
+		 * it to have finished.  Its results are checked at the next sync
+		 * point.
 		 */
-		dispatchresults = cdbdisp_getDispatchResults(&ds, &qeErrorMsg);
-
-		/*
-		 * If QEs have errors, throw it up
-		 */
-		if (!dispatchresults)
+		if (pipeline && cdbdisp_canPipeline())
+			cdbdisp_pipelineDispatch(&ds);
+		else
 		{
 			/*
-			 * debug_string_query is not meaningful for utility statement
+			 * Block until valid results is available or one or more QEs got
+			 * errors.
 			 */
+			dispatchresults = cdbdisp_getDispatchResults(&ds, &qeErrorMsg);
+
 			/*
-			 * XXX: It would be nice to get more details from the segment, not
-			 * just the error message. In particular, an error code would be
-			 * nice. DATA_EXCEPTION is a pretty wild guess on the real cause.
+			 * If QEs have errors, throw it up
 			 */
-			if (serializedQuerytree != NULL)
-				ereport(ERROR,
-						(errcode(ERRCODE_DATA_EXCEPTION),
-						 errmsg("%s", qeErrorMsg.data)));
-			else
-
-				ereport(ERROR,
-						(errcode(ERRCODE_DATA_EXCEPTION),
-						 errmsg("could not execute command on QE"),
-						 errdetail("%s", qeErrorMsg.data),
-						 errhint("command: '%s'", strCommand)));
-		}
+			if (!dispatchresults)
+			{
+				/*
+				 * debug_string_query is not meaningful for utility statement
+				 */
+				/*
+				 * XXX: It would be nice to get more details from the segment,
+				 * not just the error message. In particular, an error code
+				 * would be nice. DATA_EXCEPTION is a pretty wild guess on the
+				 * real cause.
+				 */
+				if (serializedQuerytree != NULL)
+					ereport(ERROR,
+							(errcode(ERRCODE_DATA_EXCEPTION),
+							 errmsg("%s", qeErrorMsg.data)));
+				else
 
-		if (cdb_pgresults)
-		{
-			cdbdisp_returnResults(dispatchresults, cdb_pgresults);
+					ereport(ERROR,
+							(errcode(ERRCODE_DATA_EXCEPTION),
+							 errmsg("could not execute command on QE"),
+							 errdetail("%s", qeErrorMsg.data),
+							 errhint("command: '%s'", strCommand)));
+			}
+
+			if (cdb_pgresults)
+			{
+				cdbdisp_returnResults(dispatchresults, cdb_pgresults);
+			}
 		}
 
 	}
@@ -599,7 +631,20 @@ cdbdisp_buildPlanQueryParms(struct QueryDesc *queryDesc,
 	 * (corresponding to an initPlan or the main plan), so the parameters are
 	 * fixed and we can include them in the prefix.
 	 */
-	splan = serializeNode((Node *) queryDesc->plannedstmt, &splan_len, &splan_len_uncompressed);
+	if (queryDesc->showstatctx)
+	{
+		double		serializeTime;
+		double		compressTime;
+
+		splan = serializeNodeCached((Node *) queryDesc->plannedstmt, &splan_len,
+									&splan_len_uncompressed,
+									&serializeTime, &compressTime);
+		cdbexplain_recordSerializeTime(queryDesc->showstatctx,
+									   serializeTime, compressTime);
+	}
+	else
+		splan = serializeNodeCached((Node *) queryDesc->plannedstmt, &splan_len,
+									&splan_len_uncompressed, NULL, NULL);
 
 	uint64		plan_size_in_kb = ((uint64) splan_len_uncompressed) / (uint64) 1024;
 
@@ -785,6 +830,9 @@ cdbdisp_destroyQueryParms(DispatchCommandQueryParms *pQueryParms)
 		pQueryParms->sliceIndexGangIdMap = NULL;
 	}
 
+	list_free(pQueryParms->gangs);
+	pQueryParms->gangs = NIL;
+
 	pfree(pQueryParms);
 }
 
@@ -992,6 +1040,7 @@ buildGpQueryString(struct CdbDispatcherState *ds,
 	bool		sessionUserIsSuper = superuser_arg(GetSessionUserId());
 	bool		outerUserIsSuper = superuser_arg(GetSessionUserId());
 	StringInfoData resgroupInfo;
+	StringInfoData sessionState;
 
 	int			tmp,
 				len,
@@ -1007,6 +1056,10 @@ buildGpQueryString(struct CdbDispatcherState *ds,
 	if (IsResGroupActivated())
 		SerializeResGroupInfo(&resgroupInfo);
 
+	initStringInfo(&sessionState);
+	SerializeSessionState(&sessionState, pQueryParms->gangs,
+						  &ds->sessionStateFrom, &ds->sessionStateTo);
+
 	total_query_len = 1 /* 'M' */ +
 		sizeof(len) /* message length */ +
 		sizeof(gp_command_count) +
@@ -1034,7 +1087,9 @@ buildGpQueryString(struct CdbDispatcherState *ds,
 		sizeof(numSlices) +
 		sizeof(int) * numSlices +
 		sizeof(resgroupInfo.len) +
-		resgroupInfo.len;
+		resgroupInfo.len +
+		sizeof(sessionState.len) +
+		sessionState.len;
 
 	if (ds->dispatchStateContext == NULL)
 		ds->dispatchStateContext = AllocSetContextCreate(TopMemoryContext,
@@ -1197,6 +1252,16 @@ buildGpQueryString(struct CdbDispatcherState *ds,
 		pos += resgroupInfo.len;
 	}
 
+	tmp = htonl(sessionState.len);
+	memcpy(pos, &tmp, sizeof(sessionState.len));
+	pos += sizeof(sessionState.len);
+
+	if (sessionState.len > 0)
+	{
+		memcpy(pos, sessionState.data, sessionState.len);
+		pos += sessionState.len;
+	}
+
 	len = pos - shared_query - 1;
 
 	/*
@@ -1220,7 +1285,8 @@ static void
 cdbdisp_dispatchX(DispatchCommandQueryParms *pQueryParms,
 				  bool cancelOnError,
 				  struct SliceTable *sliceTbl,
-				  struct CdbDispatcherState *ds)
+				  struct CdbDispatcherState *ds,
+				  struct CdbExplain_ShowStatCtx *showstatctx)
 {
 	SliceVec   *sliceVector = NULL;
 	int			nSlices = 1;	/* slices this dispatch cares about */
@@ -1251,6 +1317,14 @@ cdbdisp_dispatchX(DispatchCommandQueryParms *pQueryParms,
 	pQueryParms->numSlices = nTotalSlices;
 	pQueryParms->sliceIndexGangIdMap = buildSliceIndexGangIdMap(sliceVector, nSlices, nTotalSlices);
 
+	for (iSlice = 0; iSlice < nSlices; iSlice++)
+	{
+		Slice	   *slice = sliceVector[iSlice].slice;
+
+		if (slice->primaryGang != NULL)
+			pQueryParms->gangs = list_append_unique_ptr(pQueryParms->gangs, slice->primaryGang);
+	}
+
 	/*
 	 * Allocate result array with enough slots for QEs of primary gangs.
 	 */
@@ -1311,25 +1385,21 @@ cdbdisp_dispatchX(DispatchCommandQueryParms *pQueryParms,
 		if (slice->directDispatch.isDirectDispatch)
 		{
 			direct.directed_dispatch = true;
-			Assert(list_length(slice->directDispatch.contentIds) == 1);
-			direct.count = 1;
-
-			/*
-			 * We only support single content right now. If this changes then
-			 * we need to change from a list to another structure to avoid n^2
-			 * cases
-			 */
-			direct.content[0] = linitial_int(slice->directDispatch.contentIds);
+			direct.contentIds = slice->directDispatch.contentIds;
 
 			if (Test_print_direct_dispatch_info)
 			{
-				elog(INFO, "Dispatch command to SINGLE content");
+				if (list_length(direct.contentIds) == 1)
+					elog(INFO, "Dispatch command to SINGLE content");
+				else
+					elog(INFO, "Dispatch command to %d contents",
+						 list_length(direct.contentIds));
 			}
 		}
 		else
 		{
 			direct.directed_dispatch = false;
-			direct.count = 0;
+			direct.contentIds = NIL;
 
 			if (Test_print_direct_dispatch_info)
 			{
@@ -1351,14 +1421,43 @@ cdbdisp_dispatchX(DispatchCommandQueryParms *pQueryParms,
 		if (primaryGang->type == GANGTYPE_PRIMARY_WRITER)
 			ds->primaryResults->writer_gang = primaryGang;
 
-		cdbdisp_dispatchToGang(ds, primaryGang, si, &direct);
+		if (showstatctx)
+		{
+			TimestampTz sendStart = GetCurrentTimestamp();
+			instr_time	starttime;
+			instr_time	endtime;
+
+			INSTR_TIME_SET_CURRENT(starttime);
+			cdbdisp_dispatchToGang(ds, primaryGang, si, &direct);
+			INSTR_TIME_SET_CURRENT(endtime);
+			INSTR_TIME_SUBTRACT(endtime, starttime);
+
+			cdbexplain_recordSliceDispatch(showstatctx, si, sendStart,
+										   INSTR_TIME_GET_DOUBLE(endtime));
+		}
+		else
+			cdbdisp_dispatchToGang(ds, primaryGang, si, &direct);
 
 		SIMPLE_FAULT_INJECTOR(AfterOneSliceDispatched);
 	}
 
 	pfree(sliceVector);
 
-	cdbdisp_waitDispatchFinish(ds);
+	if (showstatctx)
+	{
+		instr_time	starttime;
+		instr_time	endtime;
+
+		INSTR_TIME_SET_CURRENT(starttime);
+		cdbdisp_waitDispatchFinish(ds);
+		INSTR_TIME_SET_CURRENT(endtime);
+		INSTR_TIME_SUBTRACT(endtime, starttime);
+
+		cdbexplain_recordDispatchWaitTime(showstatctx,
+										  INSTR_TIME_GET_DOUBLE(endtime));
+	}
+	else
+		cdbdisp_waitDispatchFinish(ds);
 
 	/*
 	 * If bailed before completely dispatched, stop QEs and throw error.
@@ -1462,6 +1561,15 @@ cdbdisp_dispatchSetCommandToAllGangs(const char *strCommand,
 	idleReaderGangs = getAllIdleReaderGangs();
 	allocatedReaderGangs = getAllAllocatedReaderGangs();
 
+	pQueryParms->gangs = lcons(primaryGang, list_copy(idleReaderGangs));
+	foreach(le, allocatedReaderGangs)
+	{
+		Gang	   *rg = lfirst(le);
+
+		if (rg->portal_name == NULL)
+			pQueryParms->gangs = lappend(pQueryParms->gangs, rg);
+	}
+
 	/*
 	 * Dispatch the command.
 	 */
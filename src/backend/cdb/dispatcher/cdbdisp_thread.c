@@ -202,9 +202,7 @@ cdbdisp_initDispatchParmsForGang(struct CdbDispatcherState *ds,
 
 		if (disp_direct->directed_dispatch)
 		{
-			/* currently we allow direct-to-one dispatch, only */
-			Assert(disp_direct->count == 1);
-			if (disp_direct->content[0] != segdbDesc->segindex)
+			if (!list_member_int(disp_direct->contentIds, segdbDesc->segindex))
 				continue;
 		}
 
@@ -17,10 +17,15 @@
 #include <unistd.h>				/* getpid() */
 #include <pthread.h>
 #include <limits.h>
+#ifdef HAVE_SYS_RESOURCE_H
+#include <sys/time.h>
+#include <sys/resource.h>
+#endif
 
 #include "gp-libpq-fe.h"
 #include "miscadmin.h"			/* MyDatabaseId */
 #include "storage/proc.h"		/* MyProc */
+#include "storage/fd.h"			/* max_files_per_process */
 #include "storage/ipc.h"
 #include "utils/memutils.h"
 
@@ -37,6 +42,7 @@
 #include "gp-libpq-fe.h"
 #include "gp-libpq-int.h"
 #include "cdb/cdbconn.h"		/* SegmentDatabaseDescriptor */
+#include "cdb/cdbdisp.h"
 #include "cdb/cdbfts.h"
 #include "cdb/cdbdisp_query.h"
 #include "cdb/cdbgang.h"		/* me */
@@ -53,6 +59,12 @@
 
 #define MAX_CACHED_1_GANGS 1
 
+/*
+ * The idle reader gangs may together hold on to up to 1/GANG_CACHE_VMEM_SHARE
+ * of gp_vmem_protect_limit on a segment.
+ */
+#define GANG_CACHE_VMEM_SHARE 4
+
 /*
  * Which gang this QE belongs to; this would be used in PostgresMain to find out
  * the slice this QE should execute
@@ -68,6 +80,7 @@ MemoryContext GangContext = NULL;
 Gang	   *CurrentGangCreating = NULL;
 
 CreateGangFunc pCreateGangFunc = NULL;
+CreateGangsFunc pCreateGangsFunc = NULL;
 
 /*
  * Points to the result of getCdbComponentDatabases()
@@ -85,6 +98,35 @@ static List *allocatedReaderGangs1 = NIL;
 static List *availableReaderGangs1 = NIL;
 static Gang *primaryWriterGang = NULL;
 
+/*
+ * Session state changes that some QE may not have yet.
+ *
+ * A session-level SET outside a transaction block is not dispatched on its
+ * own: the change is numbered and kept here, and the next command dispatched
+ * to a QE carries the changes that the QE has not been sent.  A new QE starts
+ * from version 0, as its connection options only carry the GUC_GPDB_ADDOPT
+ * settings.  A QE only keeps the changes sent in a transaction that commits,
+ * so the QEs' sent versions fall back to their committed ones when a
+ * (sub)transaction aborts.
+ *
+ * The log is transactional too: a change made by a (sub)transaction that
+ * aborts is dropped with it, as the QD's own setting is rolled back.  A
+ * change supersedes the earlier ones of the same GUC only once it commits;
+ * after that there is at most one committed change per GUC.
+ */
+typedef struct SessionStateChange
+{
+	uint32		version;
+	SubTransactionId subid;		/* InvalidSubTransactionId once committed */
+	GucContext	context;		/* PGC_SUSET if made by a superuser */
+	char	   *name;			/* NULL for RESET ALL */
+	char	   *value;			/* NULL for RESET */
+} SessionStateChange;
+
+static uint32 sessionStateVersion = 0;
+static List *sessionStateChanges = NIL; /* oldest first */
+static bool sessionStateCallbacksRegistered = false;
+
 /*
  * Every gang created must have a unique identifier
  */
@@ -99,6 +141,14 @@ static bool isTargetPortal(const char *p1, const char *p2);
 static bool cleanupGang(Gang *gp);
 static void resetSessionForPrimaryGangLoss(void);
 static const char *gangTypeToString(GangType);
+static void SessionStateXactCallback(XactEvent event, void *arg);
+static void SessionStateSubXactCallback(SubXactEvent event, SubTransactionId mySubid,
+							SubTransactionId parentSubid, void *arg);
+static void finishGangSessionState(Gang *gp, bool isCommit);
+static void AtEOXact_SessionState(bool isCommit);
+static void freeSessionStateChange(SessionStateChange *change);
+static void commitSessionStateChanges(void);
+static void abortSessionStateChanges(SubTransactionId subid);
 static CdbComponentDatabaseInfo *copyCdbComponentDatabaseInfo(
 							 CdbComponentDatabaseInfo *dbInfo);
 static CdbComponentDatabaseInfo *findDatabaseInfoBySegIndex(
@@ -291,6 +341,71 @@ createGang(GangType type, int gang_id, int size, int content)
 	return pCreateGangFunc(type, gang_id, size, content);
 }
 
+/*
+ * Make sure there are enough idle primary reader gangs for a query that is
+ * about to allocate 'nreaders' of them, and in any case at least
+ * gp_cached_gang_low_watermark of them (but no more than
+ * gp_cached_gang_threshold, which cleanupPortalGangs() trims them to).
+ *
+ * The missing gangs are created all at once, which takes about as long as
+ * creating one of them, instead of one at a time as AllocateReaderGang()
+ * would.  The writer gang must exist already, since it has to be created
+ * before any reader gang.
+ */
+void
+PrewarmReaderGangs(int nreaders)
+{
+	MemoryContext oldContext;
+	Gang	  **gangs;
+	int			target;
+	int			ncreate;
+	int			i;
+
+	if (Gp_role != GP_ROLE_DISPATCH || primaryWriterGang == NULL)
+		return;
+
+	target = Max(nreaders, Min(gp_cached_gang_low_watermark, gp_cached_gang_threshold));
+	ncreate = target - list_length(availableReaderGangsN);
+
+	/* Nothing to gain over AllocateReaderGang() for a single gang. */
+	if (ncreate <= 0 || (ncreate == 1 && nreaders > 0))
+		return;
+
+	insist_log(IsTransactionOrTransactionBlock(),
+			   "cannot allocate segworker group outside of transaction");
+
+	ELOG_DISPATCHER_DEBUG("PrewarmReaderGangs: creating %d reader N-gangs, availableReaderGangsN %d",
+						  ncreate, list_length(availableReaderGangsN));
+
+	Assert(GangContext != NULL);
+	oldContext = MemoryContextSwitchTo(GangContext);
+
+	gangs = palloc(ncreate * sizeof(Gang *));
+
+	if (pCreateGangsFunc != NULL)
+	{
+		pCreateGangsFunc(GANGTYPE_PRIMARY_READER, gang_id_counter, ncreate,
+						 getgpsegmentCount(), 0, gangs);
+		gang_id_counter += ncreate;
+	}
+	else
+	{
+		for (i = 0; i < ncreate; i++)
+			gangs[i] = createGang(GANGTYPE_PRIMARY_READER, gang_id_counter++,
+								  getgpsegmentCount(), 0);
+	}
+
+	for (i = 0; i < ncreate; i++)
+	{
+		gangs[i]->allocated = false;
+		availableReaderGangsN = lappend(availableReaderGangsN, gangs[i]);
+	}
+
+	pfree(gangs);
+
+	MemoryContextSwitchTo(oldContext);
+}
+
 /*
  * Test if the connections of the primary writer gang are alive.
  */
@@ -691,6 +806,341 @@ makeOptions(void)
 	return string.data;
 }
 
+/*
+ * Record a session-level change of a GUC on the QD, to be sent to the QEs
+ * with the next command dispatched to them.  A NULL name stands for RESET
+ * ALL, a NULL value for RESET.
+ */
+void
+RecordSessionStateChange(const char *name, const char *value)
+{
+	MemoryContext oldContext;
+	SessionStateChange *change;
+
+	Assert(Gp_role == GP_ROLE_DISPATCH);
+	Assert(IsTransactionState());
+
+	if (!sessionStateCallbacksRegistered)
+	{
+		RegisterXactCallback(SessionStateXactCallback, NULL);
+		RegisterSubXactCallback(SessionStateSubXactCallback, NULL);
+		sessionStateCallbacksRegistered = true;
+	}
+
+	oldContext = MemoryContextSwitchTo(TopMemoryContext);
+
+	change = (SessionStateChange *) palloc(sizeof(SessionStateChange));
+	change->version = ++sessionStateVersion;
+	change->subid = GetCurrentSubTransactionId();
+	/* the QE applies it with the privileges of the role that issued it */
+	change->context = superuser() ? PGC_SUSET : PGC_USERSET;
+	change->name = name ? pstrdup(name) : NULL;
+	change->value = value ? pstrdup(value) : NULL;
+	sessionStateChanges = lappend(sessionStateChanges, change);
+
+	MemoryContextSwitchTo(oldContext);
+}
+
+/*
+ * Record a change of a GUC that was dispatched to the QEs right away.  The
+ * QEs have it already, but it must still supersede the changes recorded
+ * before it, or QEs started later would be sent the stale values.  Nothing
+ * to do as long as no change was recorded.
+ */
+void
+RecordDispatchedSessionStateChange(const char *name, const char *value)
+{
+	if (sessionStateChanges != NIL)
+		RecordSessionStateChange(name, value);
+}
+
+static void
+freeSessionStateChange(SessionStateChange *change)
+{
+	if (change->name)
+		pfree(change->name);
+	if (change->value)
+		pfree(change->value);
+	pfree(change);
+}
+
+/*
+ * At commit, mark the changes of the transaction committed, and drop the
+ * changes they supersede: the earlier ones of the same GUC, or all earlier
+ * ones for RESET ALL.
+ */
+static void
+commitSessionStateChanges(void)
+{
+	ListCell   *cell;
+	ListCell   *prev;
+	ListCell   *next;
+	int			i;
+
+	for (i = list_length(sessionStateChanges) - 1; i >= 0; i--)
+	{
+		SessionStateChange *change = list_nth(sessionStateChanges, i);
+
+		if (change->subid == InvalidSubTransactionId)
+			continue;
+		change->subid = InvalidSubTransactionId;
+
+		prev = NULL;
+		for (cell = list_head(sessionStateChanges); cell != NULL; cell = next)
+		{
+			SessionStateChange *old = (SessionStateChange *) lfirst(cell);
+
+			next = lnext(cell);
+
+			if (old == change)
+				break;
+
+			if (change->name == NULL ||
+				(old->name != NULL && pg_strcasecmp(old->name, change->name) == 0))
+			{
+				sessionStateChanges = list_delete_cell(sessionStateChanges, cell, prev);
+				freeSessionStateChange(old);
+				i--;
+			}
+			else
+				prev = cell;
+		}
+	}
+}
+
+/*
+ * Drop the changes made by the given subtransaction, or by the whole
+ * transaction if subid is InvalidSubTransactionId.  The changes of its
+ * committed children carry its subid already.
+ */
+static void
+abortSessionStateChanges(SubTransactionId subid)
+{
+	ListCell   *cell;
+	ListCell   *prev = NULL;
+	ListCell   *next;
+
+	for (cell = list_head(sessionStateChanges); cell != NULL; cell = next)
+	{
+		SessionStateChange *change = (SessionStateChange *) lfirst(cell);
+
+		next = lnext(cell);
+
+		if (change->subid != InvalidSubTransactionId &&
+			(subid == InvalidSubTransactionId || change->subid == subid))
+		{
+			sessionStateChanges = list_delete_cell(sessionStateChanges, cell, prev);
+			freeSessionStateChange(change);
+		}
+		else
+			prev = cell;
+	}
+}
+
+/*
+ * Append to buf the session state changes that some QE of the given gangs
+ * has not been sent yet.  They are the changes after *from, up to *to.
+ */
+void
+SerializeSessionState(StringInfo buf, List *gangs, uint32 *from, uint32 *to)
+{
+	ListCell   *cell;
+
+	*from = *to = sessionStateVersion;
+
+	if (sessionStateChanges == NIL)
+		return;
+
+	foreach(cell, gangs)
+	{
+		Gang	   *gp = (Gang *) lfirst(cell);
+		int			i;
+
+		for (i = 0; i < gp->size; i++)
+			*from = Min(*from, gp->db_descriptors[i].sessionStateSent);
+	}
+
+	foreach(cell, sessionStateChanges)
+	{
+		SessionStateChange *change = (SessionStateChange *) lfirst(cell);
+
+		if (change->version <= *from)
+			continue;
+
+		if (change->name == NULL)
+		{
+			appendStringInfoChar(buf, 'A');
+			continue;
+		}
+
+		appendStringInfoChar(buf, change->value == NULL ? 'R' : 'S');
+		appendStringInfoChar(buf, change->context == PGC_SUSET ? 's' : 'u');
+		appendBinaryStringInfo(buf, change->name, strlen(change->name) + 1);
+		if (change->value != NULL)
+			appendBinaryStringInfo(buf, change->value, strlen(change->value) + 1);
+	}
+}
+
+/*
+ * Note that the QEs of gang gp, or those for the given contents if
+ * contentIds is not NIL, are being sent the session state changes after
+ * from, up to to.
+ */
+void
+MarkSessionStateSent(Gang *gp, List *contentIds, uint32 from, uint32 to)
+{
+	int			i;
+
+	for (i = 0; i < gp->size; i++)
+	{
+		SegmentDatabaseDescriptor *segdbDesc = &gp->db_descriptors[i];
+
+		if (contentIds != NIL && !list_member_int(contentIds, segdbDesc->segindex))
+			continue;
+
+		/* the command does not carry all the changes this QE lacks */
+		if (segdbDesc->sessionStateSent < from)
+			continue;
+
+		segdbDesc->sessionStateSent = Max(segdbDesc->sessionStateSent, to);
+	}
+}
+
+/*
+ * Apply, on a QE, the session state changes serialized by
+ * SerializeSessionState().
+ */
+void
+ApplySessionState(const char *buf, int len)
+{
+	const char *pos = buf;
+	const char *end = buf + len;
+
+	Assert(Gp_role == GP_ROLE_EXECUTE);
+
+	while (pos < end)
+	{
+		char		kind = *pos++;
+		char		context;
+		const char *name;
+		const char *value = NULL;
+
+		if (kind == 'A')
+		{
+			ResetAllOptions();
+			continue;
+		}
+
+		context = (pos < end) ? *pos++ : '\0';
+		name = pos;
+		pos += strnlen(pos, end - pos) + 1;
+		if (kind == 'S')
+		{
+			value = pos;
+			pos += strnlen(pos, end - pos) + 1;
+		}
+		else if (kind != 'R')
+			pos = end + 1;
+
+		if (pos > end || (context != 's' && context != 'u'))
+			ereport(ERROR,
+					(errcode(ERRCODE_PROTOCOL_VIOLATION),
+					 errmsg("invalid session state in dispatched command")));
+
+		/*
+		 * The current user here is the one of the command being run, not
+		 * necessarily the one that issued the SET on the QD.
+		 */
+		set_config_option(name,
+						  value,
+						  (context == 's' ? PGC_SUSET : PGC_USERSET),
+						  PGC_S_SESSION,
+						  GUC_ACTION_SET,
+						  true);
+	}
+}
+
+static void
+SessionStateXactCallback(XactEvent event, void *arg)
+{
+	if (event == XACT_EVENT_COMMIT)
+	{
+		commitSessionStateChanges();
+		AtEOXact_SessionState(true);
+	}
+	else if (event == XACT_EVENT_ABORT)
+	{
+		abortSessionStateChanges(InvalidSubTransactionId);
+		AtEOXact_SessionState(false);
+	}
+}
+
+static void
+SessionStateSubXactCallback(SubXactEvent event, SubTransactionId mySubid,
+							SubTransactionId parentSubid, void *arg)
+{
+	ListCell   *cell;
+
+	if (event == SUBXACT_EVENT_COMMIT_SUB)
+	{
+		/* the parent owns the changes now */
+		foreach(cell, sessionStateChanges)
+		{
+			SessionStateChange *change = (SessionStateChange *) lfirst(cell);
+
+			if (change->subid == mySubid)
+				change->subid = parentSubid;
+		}
+	}
+	else if (event == SUBXACT_EVENT_ABORT_SUB)
+	{
+		abortSessionStateChanges(mySubid);
+
+		/*
+		 * Changes sent before the subtransaction started are resent too,
+		 * which is harmless.
+		 */
+		AtEOXact_SessionState(false);
+	}
+}
+
+/*
+ * Move the committed session state version of gp's QEs up to the sent one
+ * when the transaction commits, or the other way round when it aborts.
+ */
+static void
+finishGangSessionState(Gang *gp, bool isCommit)
+{
+	int			i;
+
+	for (i = 0; i < gp->size; i++)
+	{
+		SegmentDatabaseDescriptor *segdbDesc = &gp->db_descriptors[i];
+
+		if (isCommit)
+			segdbDesc->sessionStateCommitted = segdbDesc->sessionStateSent;
+		else
+			segdbDesc->sessionStateSent = segdbDesc->sessionStateCommitted;
+	}
+}
+
+static void
+AtEOXact_SessionState(bool isCommit)
+{
+	ListCell   *cell;
+
+	if (primaryWriterGang != NULL)
+		finishGangSessionState(primaryWriterGang, isCommit);
+	foreach(cell, allocatedReaderGangsN)
+		finishGangSessionState((Gang *) lfirst(cell), isCommit);
+	foreach(cell, availableReaderGangsN)
+		finishGangSessionState((Gang *) lfirst(cell), isCommit);
+	foreach(cell, allocatedReaderGangs1)
+		finishGangSessionState((Gang *) lfirst(cell), isCommit);
+	foreach(cell, availableReaderGangs1)
+		finishGangSessionState((Gang *) lfirst(cell), isCommit);
+}
+
 /*
  * build_gpqeid_param
  *
@@ -855,97 +1305,68 @@ static Gang *
 getAvailableGang(GangType type, int size, int content)
 {
 	Gang	   *retGang = NULL;
+	List	  **gplist;
 
 	switch (type)
 	{
 		case GANGTYPE_SINGLETON_READER:
 		case GANGTYPE_ENTRYDB_READER:
-			if (availableReaderGangs1 != NULL)	/* There are gangs already
-												 * created */
-			{
-				ListCell   *cur_item = NULL;
-				ListCell   *prev_item = NULL;
-				ListCell   *next_item = NULL;
-
-				cur_item = list_head(availableReaderGangs1);
-
-				while (cur_item != NULL)
-				{
-					Gang	   *gang = (Gang *) lfirst(cur_item);
-
-					Assert(gang != NULL);
-					Assert(gang->size == size);
-
-					next_item = lnext(cur_item);
-
-					if (gang->db_descriptors[0].segindex == content)
-					{
-						availableReaderGangs1 = list_delete_cell(availableReaderGangs1, cur_item, prev_item);
-
-						/* sanity check */
-						if (!GangOK(gang))
-						{
-							/* connection is bad or segment is down */
-							DisconnectAndDestroyGang(gang);
-						}
-						else
-						{
-							ELOG_DISPATCHER_DEBUG("reusing an available reader 1-gang for seg%d", content);
-							retGang = gang;
-							break;
-						}
-						/* prev_item does not advance */
-					}
-					else
-					{
-						prev_item = cur_item;
-					}
-
-					cur_item = next_item;
-				}
-			}
+			gplist = &availableReaderGangs1;
 			break;
 
 		case GANGTYPE_PRIMARY_READER:
-			if (availableReaderGangsN != NULL)	/* There are gangs already
-												 * created */
-			{
-				ListCell   *cur_item = NULL;
-				ListCell   *prev_item = NULL;
-				ListCell   *next_item = NULL;
-
-				cur_item = list_head(availableReaderGangsN);
-
-				while (cur_item != NULL)
-				{
-					Gang	   *gang = (Gang *) lfirst(cur_item);
-
-					Assert(gang != NULL);
-					Assert(gang->size == size);
-					next_item = lnext(cur_item);
-
-					availableReaderGangsN = list_delete_cell(availableReaderGangsN, cur_item, prev_item);
-
-					/* sanity check */
-					if (!GangOK(gang))
-					{
-						/* connection is bad or segment is down */
-						DisconnectAndDestroyGang(gang);
-					}
-					else
-					{
-						ELOG_DISPATCHER_DEBUG("reusing an available reader N-gang");
-						retGang = gang;
-						break;
-					}
-					/* prev_item does not advance */
-					cur_item = next_item;
-				}
-			}
+			gplist = &availableReaderGangsN;
 			break;
 
 		default:
 			Assert(false);
+			return NULL;
+	}
+
+	/*
+	 * The available lists are kept in least recently used order, so take
+	 * the most recently released gang that fits: the gangs at the head of
+	 * the list are the ones cleanupPortalGangs() lets go of first.
+	 */
+	while (retGang == NULL)
+	{
+		ListCell   *cell;
+		Gang	   *gang = NULL;
+
+		foreach(cell, *gplist)
+		{
+			Gang	   *candidate = (Gang *) lfirst(cell);
+
+			Assert(candidate != NULL);
+			Assert(candidate->size == size);
+
+			if (type == GANGTYPE_PRIMARY_READER ||
+				candidate->db_descriptors[0].segindex == content)
+				gang = candidate;
+		}
+
+		if (gang == NULL)
+			break;
+
+		*gplist = list_delete_ptr(*gplist, gang);
+
+		/* sanity check */
+		if (!GangOK(gang))
+		{
+			/* connection is bad or segment is down */
+			DisconnectAndDestroyGang(gang);
+			continue;
+		}
+
+		if (type == GANGTYPE_PRIMARY_READER)
+		{
+			ELOG_DISPATCHER_DEBUG("reusing an available reader N-gang");
+		}
+		else
+		{
+			ELOG_DISPATCHER_DEBUG("reusing an available reader 1-gang for seg%d", content);
+		}
+		retGang = gang;
 	}
 
 	return retGang;
@@ -1042,19 +1463,21 @@ getCdbProcessList(Gang *gang, int sliceIndex, DirectDispatchInfo *directDispatch
 
 	if (directDispatch != NULL && directDispatch->isDirectDispatch)
 	{
-		/* Currently, direct dispatch is to one segment db. */
-		Assert(list_length(directDispatch->contentIds) == 1);
+		ListCell   *lc;
 
 		/* initialize a list of NULL */
 		for (i = 0; i < gang->size; i++)
 			list = lappend(list, NULL);
 
-		int			directDispatchContentId = linitial_int(directDispatch->contentIds);
-		SegmentDatabaseDescriptor *segdbDesc = &gang->db_descriptors[directDispatchContentId];
-		CdbProcess *process = makeCdbProcess(segdbDesc);
+		foreach(lc, directDispatch->contentIds)
+		{
+			int			directDispatchContentId = lfirst_int(lc);
+			SegmentDatabaseDescriptor *segdbDesc = &gang->db_descriptors[directDispatchContentId];
+			CdbProcess *process = makeCdbProcess(segdbDesc);
 
-		setQEIdentifier(segdbDesc, sliceIndex, gang->perGangContext);
-		list_nth_replace(list, directDispatchContentId, process);
+			setQEIdentifier(segdbDesc, sliceIndex, gang->perGangContext);
+			list_nth_replace(list, directDispatchContentId, process);
+		}
 	}
 	else
 	{
@@ -1225,6 +1648,9 @@ DisconnectAndDestroyAllGangs(bool resetSession)
 
 	ELOG_DISPATCHER_DEBUG("DisconnectAndDestroyAllGangs");
 
+	/* a pipelined command must not outlive the gang it runs on */
+	cdbdisp_cancelPipeline();
+
 	/* for now, destroy all readers, regardless of the portal that owns them */
 	disconnectAndDestroyAllReaderGangs(true);
 
@@ -1385,47 +1811,111 @@ isTargetPortal(const char *p1, const char *p2)
 }
 
 /*
- * remove elements from gang list when:
- * 1. list size > cachelimit
- * 2. max mop of this gang > gp_vmem_protect_gang_cache_limit
+ * How many QE connections the idle reader gangs may hold on to.
+ *
+ * libpq sockets are not managed by fd.c, which may itself keep up to
+ * max_files_per_process files open, so the connections have to fit in what
+ * RLIMIT_NOFILE leaves over; fd.c is left at least half of the limit.  The
+ * connections of the writer gang and of the allocated reader gangs come
+ * first.  Returns INT_MAX if there is no limit.
+ */
+static int
+getGangCacheFdBudget(void)
+{
+#if defined(HAVE_GETRLIMIT) && defined(RLIMIT_NOFILE)
+	struct rlimit rlim;
+	int64		budget;
+	ListCell   *cell;
+
+	if (getrlimit(RLIMIT_NOFILE, &rlim) < 0 ||
+		rlim.rlim_cur == RLIM_INFINITY ||
+		rlim.rlim_cur >= INT_MAX)
+		return INT_MAX;
+
+	budget = (int64) rlim.rlim_cur -
+		Min((int64) max_files_per_process, (int64) rlim.rlim_cur / 2);
+
+	if (primaryWriterGang != NULL)
+		budget -= primaryWriterGang->size;
+	foreach(cell, allocatedReaderGangsN)
+		budget -= ((Gang *) lfirst(cell))->size;
+	foreach(cell, allocatedReaderGangs1)
+		budget -= ((Gang *) lfirst(cell))->size;
+
+	return (int) Max(budget, 0);
+#else
+	return INT_MAX;
+#endif
+}
+
+/*
+ * Trim a list of idle reader gangs, which is in least recently used order.
+ *
+ * The gangs are kept from the most recently used one down, as long as:
+ * 1. no more than cachelimit of them are kept
+ * 2. their connections fit in *fdbudget, which is reduced accordingly
+ * 3. max mop of the gang <= gp_vmem_protect_gang_cache_limit
+ * 4. all the kept gangs together have a max mop of no more than
+ *    GANG_CACHE_VMEM_SHARE of gp_vmem_protect_limit, since their QEs hold
+ *    on to that much memory on some segment while idle
+ *
+ * The others are destroyed.
  */
 static List *
-cleanupPortalGangList(List *gplist, int cachelimit)
+cleanupPortalGangList(List *gplist, int cachelimit, int *fdbudget)
 {
+	Gang	  **gangs;
 	ListCell   *cell = NULL;
-	ListCell   *prevcell = NULL;
-	int			nLeft = list_length(gplist);
+	List	   *kept = NIL;
+	int			ngangs = list_length(gplist);
+	int			nkept = 0;
+	int64		vmemkept = 0;
+	int64		vmemlimit = -1;
+	int			i = 0;
 
 	if (gplist == NULL)
 		return NULL;
 
-	cell = list_head(gplist);
-	while (cell != NULL)
+	if (gp_vmem_protect_limit > 0)
+		vmemlimit = (int64) gp_vmem_protect_limit / GANG_CACHE_VMEM_SHARE;
+
+	gangs = palloc(ngangs * sizeof(Gang *));
+	foreach(cell, gplist)
+		gangs[i++] = (Gang *) lfirst(cell);
+
+	for (i = ngangs - 1; i >= 0; i--)
 	{
-		Gang	   *gang = (Gang *) lfirst(cell);
+		Gang	   *gang = gangs[i];
+		int			vmem = getGangMaxVmem(gang);
 
 		Assert(gang->type != GANGTYPE_PRIMARY_WRITER);
 
-		if (nLeft > cachelimit ||
-			getGangMaxVmem(gang) > gp_vmem_protect_gang_cache_limit)
+		if (nkept < cachelimit &&
+			gang->size <= *fdbudget &&
+			vmem <= gp_vmem_protect_gang_cache_limit &&
+			(vmemlimit < 0 || vmemkept + vmem <= vmemlimit))
 		{
-			DisconnectAndDestroyGang(gang);
-			gplist = list_delete_cell(gplist, cell, prevcell);
-			nLeft--;
-
-			if (prevcell != NULL)
-				cell = lnext(prevcell);
-			else
-				cell = list_head(gplist);
+			nkept++;
+			vmemkept += vmem;
+			*fdbudget -= gang->size;
 		}
 		else
 		{
-			prevcell = cell;
-			cell = lnext(cell);
+			DisconnectAndDestroyGang(gang);
+			gangs[i] = NULL;
 		}
 	}
 
-	return gplist;
+	for (i = 0; i < ngangs; i++)
+	{
+		if (gangs[i] != NULL)
+			kept = lappend(kept, gangs[i]);
+	}
+
+	list_free(gplist);
+	pfree(gangs);
+
+	return kept;
 }
 
 /*
@@ -1436,6 +1926,7 @@ cleanupPortalGangs(Portal portal)
 {
 	MemoryContext oldContext;
 	const char *portal_name;
+	int			fdbudget;
 
 	if (portal->name && strcmp(portal->name, "") != 0)
 	{
@@ -1453,8 +1944,13 @@ cleanupPortalGangs(Portal portal)
 	else
 		oldContext = MemoryContextSwitchTo(TopMemoryContext);
 
-	availableReaderGangsN = cleanupPortalGangList(availableReaderGangsN, gp_cached_gang_threshold);
-	availableReaderGangs1 = cleanupPortalGangList(availableReaderGangs1, MAX_CACHED_1_GANGS);
+	fdbudget = getGangCacheFdBudget();
+	availableReaderGangsN = cleanupPortalGangList(availableReaderGangsN,
+												  gp_cached_gang_threshold,
+												  &fdbudget);
+	availableReaderGangs1 = cleanupPortalGangList(availableReaderGangs1,
+												  MAX_CACHED_1_GANGS,
+												  &fdbudget);
 
 	ELOG_DISPATCHER_DEBUG("cleanupPortalGangs '%s'. Reader gang inventory: "
 						  "allocatedN=%d availableN=%d allocated1=%d available1=%d",
@@ -1477,6 +1973,10 @@ cleanupPortalGangs(Portal portal)
  * cleanupGang() tells us that the gang has a problem, the gang has
  * been free()ed and we should discard it -- otherwise it is good as
  * far as we can tell.
+ *
+ * The gangs go back at the tail of the available lists, which are kept in
+ * least recently used order, so the next portal or cursor of the session
+ * picks them up first.
  */
 void
 freeGangsForPortal(char *portal_name)
@@ -1867,7 +2367,13 @@ void
 cdbgang_setAsync(bool async)
 {
 	if (async)
+	{
 		pCreateGangFunc = pCreateGangFuncAsync;
+		pCreateGangsFunc = pCreateGangsFuncAsync;
+	}
 	else
+	{
 		pCreateGangFunc = pCreateGangFuncThreaded;
+		pCreateGangsFunc = NULL;
+	}
 }
@@ -36,8 +36,13 @@
 
 static int	getPollTimeout(const struct timeval *startTS);
 static Gang *createGang_async(GangType type, int gang_id, int size, int content);
+static void createGangs_async(GangType type, int first_gang_id, int ngangs,
+				  int size, int content, Gang **gangs);
+static void connectGangs_async(Gang **gangs, int ngangs,
+				   int *successful_connections, int *in_recovery_mode_count);
 
 CreateGangFunc pCreateGangFuncAsync = createGang_async;
+CreateGangsFunc pCreateGangsFuncAsync = createGangs_async;
 
 /*
  * Creates a new gang by logging on a session to each segDB involved.
@@ -49,21 +54,10 @@ static Gang *
 createGang_async(GangType type, int gang_id, int size, int content)
 {
 	Gang	   *newGangDefinition;
-	SegmentDatabaseDescriptor *segdbDesc = NULL;
-	int			i = 0;
 	int			create_gang_retry_counter = 0;
 	int			in_recovery_mode_count = 0;
 	int			successful_connections = 0;
 	bool		retry = false;
-	int			poll_timeout = 0;
-	struct timeval startTS;
-	PostgresPollingStatusType *pollingStatus = NULL;
-
-	/*
-	 * true means connection status is confirmed, either established or in
-	 * recovery mode
-	 */
-	bool	   *connStatusDone = NULL;
 
 	ELOG_DISPATCHER_DEBUG("createGang type = %d, gang_id = %d, size = %d, content = %d",
 						  type, gang_id, size, content);
@@ -92,20 +86,199 @@ create_gang_retry:
 	Assert(newGangDefinition != NULL);
 	Assert(newGangDefinition->size == size);
 	Assert(newGangDefinition->perGangContext != NULL);
-	MemoryContextSwitchTo(newGangDefinition->perGangContext);
+
+	PG_TRY();
+	{
+		connectGangs_async(&newGangDefinition, 1,
+						   &successful_connections, &in_recovery_mode_count);
+
+		ELOG_DISPATCHER_DEBUG("createGang: %d processes requested; %d successful connections %d in recovery",
+							  size, successful_connections, in_recovery_mode_count);
+
+		/* some segments are in recovery mode */
+		if (successful_connections != size)
+		{
+			Assert(successful_connections + in_recovery_mode_count == size);
+
+			if (gp_gang_creation_retry_count <= 0 ||
+				create_gang_retry_counter++ >= gp_gang_creation_retry_count ||
+				type != GANGTYPE_PRIMARY_WRITER)
+				ereport(ERROR, (errcode(ERRCODE_GP_INTERCONNECTION_ERROR),
+								errmsg("failed to acquire resources on one or more segments"),
+								errdetail("segments is in recovery mode")));
+
+			ELOG_DISPATCHER_DEBUG("createGang: gang creation failed, but retryable.");
+
+			DisconnectAndDestroyGang(newGangDefinition);
+			newGangDefinition = NULL;
+			CurrentGangCreating = NULL;
+			retry = true;
+		}
+	}
+	PG_CATCH();
+	{
+		MemoryContextSwitchTo(GangContext);
+
+		/* FTS shows some segment DBs are down */
+		if (isFTSEnabled() &&
+			FtsTestSegmentDBIsDown(newGangDefinition->db_descriptors, size))
+		{
+
+			DisconnectAndDestroyGang(newGangDefinition);
+			newGangDefinition = NULL;
+			CurrentGangCreating = NULL;
+			DisconnectAndDestroyAllGangs(true);
+			CheckForResetSession();
+			ereport(ERROR, (errcode(ERRCODE_GP_INTERCONNECTION_ERROR),
+							errmsg("failed to acquire resources on one or more segments"),
+							errdetail("FTS detected one or more segments are down")));
+
+		}
+
+		DisconnectAndDestroyGang(newGangDefinition);
+		newGangDefinition = NULL;
+		CurrentGangCreating = NULL;
+
+		if (type == GANGTYPE_PRIMARY_WRITER)
+		{
+			DisconnectAndDestroyAllGangs(true);
+			CheckForResetSession();
+		}
+
+		PG_RE_THROW();
+	}
+	PG_END_TRY();
+
+	SIMPLE_FAULT_INJECTOR(GangCreated);
+
+	if (retry)
+	{
+		CHECK_FOR_INTERRUPTS();
+		pg_usleep(gp_gang_creation_retry_timer * 1000);
+		CHECK_FOR_INTERRUPTS();
+
+		goto create_gang_retry;
+	}
+
+	setLargestGangsize(size);
+
+	CurrentGangCreating = NULL;
+
+	return newGangDefinition;
+}
+
+/*
+ * Creates several reader gangs at once, with the connections to all of their
+ * segDBs started together, so that setting them up takes about as long as
+ * setting up one gang.
+ *
+ * Reader gangs are not retried when a segment is in recovery mode, so a
+ * failure to create any of the gangs is an error, and none of them is kept.
+ *
+ * call this function in GangContext memory context.
+ */
+static void
+createGangs_async(GangType type, int first_gang_id, int ngangs,
+				  int size, int content, Gang **gangs)
+{
+	int			in_recovery_mode_count = 0;
+	int			successful_connections = 0;
+	int			i;
+
+	ELOG_DISPATCHER_DEBUG("createGangs type = %d, first gang_id = %d, ngangs = %d, size = %d, content = %d",
+						  type, first_gang_id, ngangs, size, content);
+
+	Assert(type != GANGTYPE_PRIMARY_WRITER);
+	Assert(size == 1 || size == getgpsegmentCount());
+	Assert(CurrentResourceOwner != NULL);
+	Assert(CurrentMemoryContext == GangContext);
+	Assert(CurrentGangCreating == NULL);
+
+	MemSet(gangs, 0, ngangs * sizeof(Gang *));
+
+	PG_TRY();
+	{
+		for (i = 0; i < ngangs; i++)
+			gangs[i] = buildGangDefinition(type, first_gang_id + i, size, content);
+
+		connectGangs_async(gangs, ngangs,
+						   &successful_connections, &in_recovery_mode_count);
+
+		ELOG_DISPATCHER_DEBUG("createGangs: %d processes requested; %d successful connections %d in recovery",
+							  ngangs * size, successful_connections, in_recovery_mode_count);
+
+		if (successful_connections != ngangs * size)
+			ereport(ERROR, (errcode(ERRCODE_GP_INTERCONNECTION_ERROR),
+							errmsg("failed to acquire resources on one or more segments"),
+							errdetail("segments is in recovery mode")));
+	}
+	PG_CATCH();
+	{
+		MemoryContextSwitchTo(GangContext);
+
+		for (i = 0; i < ngangs; i++)
+		{
+			if (gangs[i] != NULL)
+				DisconnectAndDestroyGang(gangs[i]);
+			gangs[i] = NULL;
+		}
+
+		PG_RE_THROW();
+	}
+	PG_END_TRY();
+
+	for (i = 0; i < ngangs; i++)
+		SIMPLE_FAULT_INJECTOR(GangCreated);
+
+	setLargestGangsize(size);
+}
+
+/*
+ * Start the connections to the segDBs of the given gangs, and poll them until
+ * every one of them is either established or found to be in recovery mode.
+ *
+ * Returns to the GangContext memory context; errors out on any other failure.
+ */
+static void
+connectGangs_async(Gang **gangs, int ngangs,
+				   int *successful_connections, int *in_recovery_mode_count)
+{
+	SegmentDatabaseDescriptor **segdbDescs;
+	SegmentDatabaseDescriptor *segdbDesc;
+	PostgresPollingStatusType *pollingStatus;
+	struct pollfd *fds;
+	struct timeval startTS;
+	int			poll_timeout = 0;
+	int			nconns = 0;
+	int			g;
+	int			i;
+
+	/*
+	 * true means connection status is confirmed, either established or in
+	 * recovery mode
+	 */
+	bool	   *connStatusDone;
+
+	for (g = 0; g < ngangs; g++)
+		nconns += gangs[g]->size;
 
 	/*
-	 * allocate memory within perGangContext and will be freed automatically
-	 * when gang is destroyed
+	 * allocate memory within the first gang's perGangContext and will be
+	 * freed automatically when gang is destroyed
 	 */
-	pollingStatus = palloc(sizeof(PostgresPollingStatusType) * size);
-	connStatusDone = palloc(sizeof(bool) * size);
+	MemoryContextSwitchTo(gangs[0]->perGangContext);
 
-	struct pollfd *fds;
+	segdbDescs = palloc(sizeof(SegmentDatabaseDescriptor *) * nconns);
+	pollingStatus = palloc(sizeof(PostgresPollingStatusType) * nconns);
+	connStatusDone = palloc(sizeof(bool) * nconns);
 
-	PG_TRY();
+	i = 0;
+	for (g = 0; g < ngangs; g++)
 	{
-		for (i = 0; i < size; i++)
+		Gang	   *gang = gangs[g];
+		int			j;
+
+		for (j = 0; j < gang->size; j++)
 		{
 			char		gpqeid[100];
 			char	   *options;
@@ -115,7 +288,8 @@ create_gang_retry:
 			 * valid segdb we error out.  Also, if this segdb is invalid, we
 			 * must fail the connection.
 			 */
-			segdbDesc = &newGangDefinition->db_descriptors[i];
+			segdbDesc = &gang->db_descriptors[j];
+			segdbDescs[i] = segdbDesc;
 
 			/*
 			 * Build the connection string.  Writer-ness needs to be processed
@@ -124,8 +298,8 @@ create_gang_retry:
 			 */
 			build_gpqeid_param(gpqeid, sizeof(gpqeid),
 							   segdbDesc->segindex,
-							   type == GANGTYPE_PRIMARY_WRITER,
-							   gang_id,
+							   gang->type == GANGTYPE_PRIMARY_WRITER,
+							   gang->gang_id,
 							   segdbDesc->segment_database_info->hostSegs);
 
 			options = makeOptions();
@@ -146,203 +320,130 @@ create_gang_retry:
 			 * returned PGRES_POLLING_WRITING
 			 */
 			pollingStatus[i] = PGRES_POLLING_WRITING;
+			i++;
 		}
+	}
 
-		/*
-		 * Ok, we've now launched all the connection attempts. Start the
-		 * timeout clock (= get the start timestamp), and poll until they're
-		 * all completed or we reach timeout.
-		 */
-		gettimeofday(&startTS, NULL);
-		fds = (struct pollfd *) palloc0(sizeof(struct pollfd) * size);
+	/*
+	 * Ok, we've now launched all the connection attempts. Start the timeout
+	 * clock (= get the start timestamp), and poll until they're all completed
+	 * or we reach timeout.
+	 */
+	gettimeofday(&startTS, NULL);
+	fds = (struct pollfd *) palloc0(sizeof(struct pollfd) * nconns);
 
-		for (;;)
+	for (;;)
+	{
+		int			nready;
+		int			nfds = 0;
+
+		poll_timeout = getPollTimeout(&startTS);
+
+		for (i = 0; i < nconns; i++)
 		{
-			int			nready;
-			int			nfds = 0;
+			segdbDesc = segdbDescs[i];
 
-			poll_timeout = getPollTimeout(&startTS);
+			/*
+			 * Skip established connections and in-recovery-mode connections
+			 */
+			if (connStatusDone[i])
+				continue;
 
-			for (i = 0; i < size; i++)
+			switch (pollingStatus[i])
 			{
-				segdbDesc = &newGangDefinition->db_descriptors[i];
-
-				/*
-				 * Skip established connections and in-recovery-mode
-				 * connections
-				 */
-				if (connStatusDone[i])
+				case PGRES_POLLING_OK:
+					cdbconn_doConnectComplete(segdbDesc);
+					if (segdbDesc->motionListener == 0)
+						ereport(ERROR, (errcode(ERRCODE_GP_INTERCONNECTION_ERROR),
+										errmsg("failed to acquire resources on one or more segments"),
+										errdetail("Internal error: No motion listener port (%s)", segdbDesc->whoami)));
+					(*successful_connections)++;
+					connStatusDone[i] = true;
 					continue;
 
-				switch (pollingStatus[i])
-				{
-					case PGRES_POLLING_OK:
-						cdbconn_doConnectComplete(segdbDesc);
-						if (segdbDesc->motionListener == 0)
-							ereport(ERROR, (errcode(ERRCODE_GP_INTERCONNECTION_ERROR),
-											errmsg("failed to acquire resources on one or more segments"),
-											errdetail("Internal error: No motion listener port (%s)", segdbDesc->whoami)));
-						successful_connections++;
+				case PGRES_POLLING_READING:
+					fds[nfds].fd = PQsocket(segdbDesc->conn);
+					fds[nfds].events = POLLIN;
+					nfds++;
+					break;
+
+				case PGRES_POLLING_WRITING:
+					fds[nfds].fd = PQsocket(segdbDesc->conn);
+					fds[nfds].events = POLLOUT;
+					nfds++;
+					break;
+
+				case PGRES_POLLING_FAILED:
+					if (segment_failure_due_to_recovery(PQerrorMessage(segdbDesc->conn)))
+					{
+						(*in_recovery_mode_count)++;
 						connStatusDone[i] = true;
-						continue;
-
-					case PGRES_POLLING_READING:
-						fds[nfds].fd = PQsocket(segdbDesc->conn);
-						fds[nfds].events = POLLIN;
-						nfds++;
-						break;
-
-					case PGRES_POLLING_WRITING:
-						fds[nfds].fd = PQsocket(segdbDesc->conn);
-						fds[nfds].events = POLLOUT;
-						nfds++;
-						break;
-
-					case PGRES_POLLING_FAILED:
-						if (segment_failure_due_to_recovery(PQerrorMessage(segdbDesc->conn)))
-						{
-							in_recovery_mode_count++;
-							connStatusDone[i] = true;
-							elog(LOG, "segment is in recovery mode (%s)", segdbDesc->whoami);
-						}
-						else
-						{
-							ereport(ERROR, (errcode(ERRCODE_GP_INTERCONNECTION_ERROR),
-											errmsg("failed to acquire resources on one or more segments"),
-											errdetail("%s (%s)", PQerrorMessage(segdbDesc->conn), segdbDesc->whoami)));
-						}
-						break;
-
-					default:
+						elog(LOG, "segment is in recovery mode (%s)", segdbDesc->whoami);
+					}
+					else
+					{
 						ereport(ERROR, (errcode(ERRCODE_GP_INTERCONNECTION_ERROR),
 										errmsg("failed to acquire resources on one or more segments"),
-										errdetail("unknow pollstatus (%s)", segdbDesc->whoami)));
-						break;
-				}
+										errdetail("%s (%s)", PQerrorMessage(segdbDesc->conn), segdbDesc->whoami)));
+					}
+					break;
 
-				if (poll_timeout == 0)
+				default:
 					ereport(ERROR, (errcode(ERRCODE_GP_INTERCONNECTION_ERROR),
 									errmsg("failed to acquire resources on one or more segments"),
-									errdetail("timeout expired\n (%s)", segdbDesc->whoami)));
+									errdetail("unknow pollstatus (%s)", segdbDesc->whoami)));
+					break;
 			}
 
-			if (nfds == 0)
-				break;
-
-			CHECK_FOR_INTERRUPTS();
-
-			/* Wait until something happens */
-			nready = poll(fds, nfds, poll_timeout);
-
-			if (nready < 0)
-			{
-				int			sock_errno = SOCK_ERRNO;
-
-				if (sock_errno == EINTR)
-					continue;
-
+			if (poll_timeout == 0)
 				ereport(ERROR, (errcode(ERRCODE_GP_INTERCONNECTION_ERROR),
 								errmsg("failed to acquire resources on one or more segments"),
-								errdetail("poll() failed: errno = %d", sock_errno)));
-			}
-			else if (nready > 0)
-			{
-				int			currentFdNumber = 0;
-
-				for (i = 0; i < size; i++)
-				{
-					segdbDesc = &newGangDefinition->db_descriptors[i];
-					if (connStatusDone[i])
-						continue;
-
-					Assert(PQsocket(segdbDesc->conn) > 0);
-					Assert(PQsocket(segdbDesc->conn) == fds[currentFdNumber].fd);
-
-					if (fds[currentFdNumber].revents & fds[currentFdNumber].events ||
-						fds[currentFdNumber].revents & (POLLERR | POLLHUP | POLLNVAL))
-						pollingStatus[i] = PQconnectPoll(segdbDesc->conn);
-
-					currentFdNumber++;
-
-				}
-			}
+								errdetail("timeout expired\n (%s)", segdbDesc->whoami)));
 		}
 
-		ELOG_DISPATCHER_DEBUG("createGang: %d processes requested; %d successful connections %d in recovery",
-							  size, successful_connections, in_recovery_mode_count);
-
-		MemoryContextSwitchTo(GangContext);
-
-		/* some segments are in recovery mode */
-		if (successful_connections != size)
-		{
-			Assert(successful_connections + in_recovery_mode_count == size);
-
-			if (gp_gang_creation_retry_count <= 0 ||
-				create_gang_retry_counter++ >= gp_gang_creation_retry_count ||
-				type != GANGTYPE_PRIMARY_WRITER)
-				ereport(ERROR, (errcode(ERRCODE_GP_INTERCONNECTION_ERROR),
-								errmsg("failed to acquire resources on one or more segments"),
-								errdetail("segments is in recovery mode")));
+		if (nfds == 0)
+			break;
 
-			ELOG_DISPATCHER_DEBUG("createGang: gang creation failed, but retryable.");
+		CHECK_FOR_INTERRUPTS();
 
-			DisconnectAndDestroyGang(newGangDefinition);
-			newGangDefinition = NULL;
-			CurrentGangCreating = NULL;
-			retry = true;
-		}
-	}
-	PG_CATCH();
-	{
-		MemoryContextSwitchTo(GangContext);
+		/* Wait until something happens */
+		nready = poll(fds, nfds, poll_timeout);
 
-		/* FTS shows some segment DBs are down */
-		if (isFTSEnabled() &&
-			FtsTestSegmentDBIsDown(newGangDefinition->db_descriptors, size))
+		if (nready < 0)
 		{
+			int			sock_errno = SOCK_ERRNO;
+
+			if (sock_errno == EINTR)
+				continue;
 
-			DisconnectAndDestroyGang(newGangDefinition);
-			newGangDefinition = NULL;
-			CurrentGangCreating = NULL;
-			DisconnectAndDestroyAllGangs(true);
-			CheckForResetSession();
 			ereport(ERROR, (errcode(ERRCODE_GP_INTERCONNECTION_ERROR),
 							errmsg("failed to acquire resources on one or more segments"),
-							errdetail("FTS detected one or more segments are down")));
-
+							errdetail("poll() failed: errno = %d", sock_errno)));
 		}
-
-		DisconnectAndDestroyGang(newGangDefinition);
-		newGangDefinition = NULL;
-		CurrentGangCreating = NULL;
-
-		if (type == GANGTYPE_PRIMARY_WRITER)
+		else if (nready > 0)
 		{
-			DisconnectAndDestroyAllGangs(true);
-			CheckForResetSession();
-		}
+			int			currentFdNumber = 0;
 
-		PG_RE_THROW();
-	}
-	PG_END_TRY();
-
-	SIMPLE_FAULT_INJECTOR(GangCreated);
+			for (i = 0; i < nconns; i++)
+			{
+				segdbDesc = segdbDescs[i];
+				if (connStatusDone[i])
+					continue;
 
-	if (retry)
-	{
-		CHECK_FOR_INTERRUPTS();
-		pg_usleep(gp_gang_creation_retry_timer * 1000);
-		CHECK_FOR_INTERRUPTS();
+				Assert(PQsocket(segdbDesc->conn) > 0);
+				Assert(PQsocket(segdbDesc->conn) == fds[currentFdNumber].fd);
 
-		goto create_gang_retry;
-	}
+				if (fds[currentFdNumber].revents & fds[currentFdNumber].events ||
+					fds[currentFdNumber].revents & (POLLERR | POLLHUP | POLLNVAL))
+					pollingStatus[i] = PQconnectPoll(segdbDesc->conn);
 
-	setLargestGangsize(size);
+				currentFdNumber++;
 
-	CurrentGangCreating = NULL;
+			}
+		}
+	}
 
-	return newGangDefinition;
+	MemoryContextSwitchTo(GangContext);
 }
 
 static int
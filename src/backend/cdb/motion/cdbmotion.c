@@ -17,6 +17,7 @@
 #include "postgres.h"
 
 #include "access/htup.h"
+#include "access/tuptoaster.h"
 #include "gp-libpq-fe.h"
 #include "gp-libpq-int.h"
 #include "cdb/cdbconn.h"
@@ -68,6 +69,7 @@ static inline void reconstructTuple(MotionNodeEntry *pMNEntry, ChunkSorterEntry
 
 /* Stats-function declarations. */
 static void statSendTuple(MotionLayerState *mlStates, MotionNodeEntry *pMNEntry, TupleChunkList tcList);
+static void compressTupleChunks(MotionNodeEntry *pMNEntry, TupleChunkList tcList);
 static void statSendEOS(MotionLayerState *mlStates, MotionNodeEntry *pMNEntry);
 static void statChunksProcessed(MotionLayerState *mlStates, MotionNodeEntry *pMNEntry, int chunksProcessed, int chunkBytes, int tupleBytes);
 static void statNewTupleArrived(MotionNodeEntry *pMNEntry, ChunkSorterEntry *pCSEntry);
@@ -371,6 +373,12 @@ UpdateMotionLayerNode(MotionLayerState *mlStates, int16 motNodeID, bool preserve
 	pEntry->sel_rd_wait = 0;
 	pEntry->sel_wr_wait = 0;
 
+	pEntry->compress = (gp_interconnect_compress_min_size > 0);
+	pEntry->stat_compress_tried = 0;
+	pEntry->stat_compressed_tuples = 0;
+	pEntry->stat_compress_raw_bytes = 0;
+	pEntry->stat_compress_bytes = 0;
+
 	pEntry->cleanedUp = false;
 	pEntry->stopped = false;
 	pEntry->moreNetWork = true;
@@ -491,6 +499,7 @@ SendTuple(MotionLayerState *mlStates,
 	TupleChunkListData tcList;
 	MemoryContext oldCtxt;
 	SendReturnCode rc;
+	HeapTuple	flattened = NULL;
 
 	AssertArg(tuple != NULL);
 
@@ -511,13 +520,57 @@ SendTuple(MotionLayerState *mlStates,
 	elog(DEBUG5, "Serializing HeapTuple for sending.");
 #endif
 
+	/*
+	 * Out-of-line attributes have to be fetched before the tuple leaves this
+	 * process anyway. Fetching them up front gives us a tuple that can be
+	 * copied as-is, instead of one that has to be deformed and serialized
+	 * attribute by attribute.
+	 */
+	if (!is_heaptuple_memtuple(tuple) && HeapTupleHasExternal(tuple))
+	{
+		oldCtxt = MemoryContextSwitchTo(mlStates->motion_layer_mctx);
+		flattened = toast_flatten_tuple(tuple, pMNEntry->ser_tup_info.tupdesc);
+		MemoryContextSwitchTo(oldCtxt);
+
+		tuple = flattened;
+	}
+
 	if (targetRoute != BROADCAST_SEGIDX)
 	{
 		struct directTransportBuffer b;
+		int			needed;
+
+		needed = SerializeTupleDirectSize(tuple, &pMNEntry->ser_tup_info);
+
+		/* Tuples up for compression need to go through a chunk list. */
+		if (pMNEntry->compress &&
+			needed - TUPLE_CHUNK_HEADER_SIZE >= gp_interconnect_compress_min_size)
+			needed = 0;
 
 		getTransportDirectBuffer(transportStates, motNodeID, targetRoute, &b);
 
-		if (b.pri != NULL && b.prilen > TUPLE_CHUNK_HEADER_SIZE)
+		/*
+		 * If the tuple doesn't fit into what is left of the transmit buffer,
+		 * but would fit into an empty one, send the buffer off now. That way
+		 * the tuple still goes straight into the transport buffer, instead of
+		 * being split into partial chunks and copied twice.
+		 */
+		if (b.pri != NULL && needed > b.prilen &&
+			needed <= Gp_max_tuple_chunk_size + TUPLE_CHUNK_HEADER_SIZE)
+		{
+			if (!flushTransportDirectBuffer(mlStates, transportStates, motNodeID, targetRoute))
+			{
+				if (flattened)
+					heap_freetuple(flattened);
+				pMNEntry->stopped = true;
+				return STOP_SENDING;
+			}
+
+			getTransportDirectBuffer(transportStates, motNodeID, targetRoute, &b);
+		}
+
+		if (b.pri != NULL && b.prilen > TUPLE_CHUNK_HEADER_SIZE &&
+			needed > 0 && needed <= b.prilen)
 		{
 			int			sent = 0;
 
@@ -533,6 +586,9 @@ SendTuple(MotionLayerState *mlStates,
 				/* update stats */
 				statSendTuple(mlStates, pMNEntry, &tcList);
 
+				if (flattened)
+					heap_freetuple(flattened);
+
 				return SEND_COMPLETE;
 			}
 		}
@@ -544,6 +600,10 @@ SendTuple(MotionLayerState *mlStates,
 
 	SerializeTupleIntoChunks(tuple, &pMNEntry->ser_tup_info, &tcList);
 
+	if (pMNEntry->compress &&
+		tcList.serialized_data_length >= gp_interconnect_compress_min_size)
+		compressTupleChunks(pMNEntry, &tcList);
+
 	MemoryContextSwitchTo(oldCtxt);
 
 #ifdef AMS_VERBOSE_LOGGING
@@ -572,6 +632,8 @@ SendTuple(MotionLayerState *mlStates,
 
 	/* cleanup */
 	clearTCList(&pMNEntry->ser_tup_info.chunkCache, &tcList);
+	if (flattened)
+		heap_freetuple(flattened);
 
 	return rc;
 }
@@ -1234,6 +1296,71 @@ addChunkToSorter(MotionLayerState *mlStates,
 
 
 
+/*
+ * Compress the serialized tuple in a chunk list.
+ *
+ * Data that doesn't compress well is detected on the first
+ * COMPRESS_SAMPLE_TUPLES tuples: if they don't shrink by at least 10%, the
+ * motion node stops trying to compress for the rest of the query.
+ */
+#define COMPRESS_SAMPLE_TUPLES 100
+
+static void
+compressTupleChunks(MotionNodeEntry *pMNEntry, TupleChunkList tcList)
+{
+	uint32		rawlen = tcList->serialized_data_length;
+
+	pMNEntry->stat_compress_tried++;
+	pMNEntry->stat_compress_raw_bytes += rawlen;
+
+	if (CompressTupleChunkList(tcList, &pMNEntry->ser_tup_info))
+	{
+		pMNEntry->stat_compressed_tuples++;
+		pMNEntry->stat_compress_bytes += tcList->serialized_data_length;
+	}
+	else
+		pMNEntry->stat_compress_bytes += rawlen;
+
+	if (pMNEntry->stat_compress_tried == COMPRESS_SAMPLE_TUPLES &&
+		pMNEntry->stat_compress_bytes * 10 > pMNEntry->stat_compress_raw_bytes * 9)
+	{
+		pMNEntry->compress = false;
+
+		if (gp_log_interconnect >= GPVARS_VERBOSITY_DEBUG)
+			elog(DEBUG1, "motion node %d: tuples don't compress ("
+				 UINT64_FORMAT " of " UINT64_FORMAT " bytes left), disabling compression",
+				 pMNEntry->motion_node_id,
+				 pMNEntry->stat_compress_bytes, pMNEntry->stat_compress_raw_bytes);
+	}
+}
+
+/*
+ * Append EXPLAIN ANALYZE notes about a receiving motion node to a buffer.
+ */
+void
+ExplainMotionLayerNode(MotionLayerState *mlStates, int16 motNodeID, StringInfo buf)
+{
+	MotionNodeEntry *pMNEntry;
+	SerTupInfo *pSerInfo;
+
+	if (mlStates == NULL || motNodeID > mlStates->mneCount)
+		return;
+
+	pMNEntry = &mlStates->mnEntries[motNodeID - 1];
+	if (!pMNEntry->valid)
+		return;
+
+	pSerInfo = &pMNEntry->ser_tup_info;
+	if (pSerInfo->recv_compressed_tuples > 0)
+		appendStringInfo(buf, "Interconnect compression: " UINT64_FORMAT
+						 " tuples, " UINT64_FORMAT " bytes received for "
+						 UINT64_FORMAT " bytes of tuple data.\n",
+						 pSerInfo->recv_compressed_tuples,
+						 pSerInfo->recv_compressed_bytes,
+						 pSerInfo->recv_decompressed_bytes);
+}
+
+
 /*
  * STATISTICS HELPER-FUNCTIONS
  *
@@ -450,6 +450,47 @@ putTransportDirectBuffer(ChunkTransportState *transportStates,
 	return;
 }
 
+/*
+ * Transmit the contents of the transmit buffer of a point-to-point
+ * connection, leaving an empty buffer behind.
+ *
+ * This lets SendTuple() serialize a tuple straight into the transport buffer
+ * when the tuple fits into an empty buffer, but not into what is left of the
+ * current one.
+ */
+bool
+flushTransportDirectBuffer(MotionLayerState *mlStates,
+						   ChunkTransportState *transportStates,
+						   int16 motNodeID,
+						   int16 targetRoute)
+{
+	ChunkTransportStateEntry *pEntry = NULL;
+	MotionConn *conn;
+
+	if (!transportStates)
+	{
+		elog(FATAL, "flushTransportDirectBuffer: no transport states");
+	}
+	else if (!transportStates->activated)
+	{
+		elog(FATAL, "flushTransportDirectBuffer: inactive transport states");
+	}
+	else if (targetRoute == BROADCAST_SEGIDX)
+	{
+		elog(FATAL, "flushTransportDirectBuffer: can't direct-transport to broadcast");
+	}
+
+	getChunkTransportState(transportStates, motNodeID, &pEntry);
+
+	/* handle pt-to-pt message. Primary */
+	conn = pEntry->conns + targetRoute;
+	/* only send to interested connections */
+	if (!conn->stillActive || conn->tupleCount == 0)
+		return true;
+
+	return transportStates->FlushBuffer(mlStates, transportStates, pEntry, conn, motNodeID);
+}
+
 /*
  * DeregisterReadInterest is called on receiving nodes when they
  * believe that they're done with the receiver
@@ -503,7 +544,7 @@ DeregisterReadInterest(ChunkTransportState *transportStates,
 		 * deadlock the entire query (QEs wait in their Teardown calls, while
 		 * the QD waits for them to finish)
 		 */
-		shutdown(conn->sockfd, SHUT_WR);
+		markTCPConnDone(conn);
 
 		MPP_FD_CLR(conn->sockfd, &pEntry->readSet);
 	}
@@ -0,0 +1,231 @@
+/*-------------------------------------------------------------------------
+ * ic_stats.c
+ *	   Live interconnect statistics, published in shared memory.
+ *
+ * Each backend owns one ICStatsSlot.  The interconnect code fills it in
+ * while an interconnect is set up, and gp_interconnect_stats() reports
+ * the slots of all backends of the local database instance.
+ *
+ * Portions Copyright (c) 2012-Present Pivotal Software, Inc.
+ *
+ *
+ * IDENTIFICATION
+ *	    src/backend/cdb/motion/ic_stats.c
+ *
+ *-------------------------------------------------------------------------
+ */
+
+#include "postgres.h"
+
+#include "access/heapam.h"
+#include "catalog/pg_type.h"
+#include "funcapi.h"
+#include "miscadmin.h"
+#include "port/atomics.h"
+#include "storage/backendid.h"
+#include "storage/shmem.h"
+
+#include "cdb/cdbvars.h"
+#include "cdb/ic_stats.h"
+
+#define NUM_IC_STATS_COLUMNS 20
+
+static ICStatsSlot *ICStatsArray = NULL;
+
+/*
+ * Report shared memory space needed by ICStatsShmemInit.
+ */
+Size
+ICStatsShmemSize(void)
+{
+	return mul_size(sizeof(ICStatsSlot), MaxBackends);
+}
+
+/*
+ * Allocate and initialize the slots in shared memory.
+ */
+void
+ICStatsShmemInit(void)
+{
+	bool		found;
+
+	ICStatsArray = (ICStatsSlot *)
+		ShmemInitStruct("Interconnect Stats Array", ICStatsShmemSize(), &found);
+
+	if (!found)
+		MemSet(ICStatsArray, 0, ICStatsShmemSize());
+}
+
+/*
+ * Start updating this backend's slot.  Returns NULL if this process has
+ * no slot.  Every non-NULL result must be passed to ICStatsEndUpdate().
+ */
+volatile ICStatsSlot *
+ICStatsBeginUpdate(void)
+{
+	volatile ICStatsSlot *slot;
+
+	if (ICStatsArray == NULL || MyBackendId < 1 || MyBackendId > MaxBackends)
+		return NULL;
+
+	slot = &ICStatsArray[MyBackendId - 1];
+	slot->changecount++;
+	pg_write_barrier();
+
+	return slot;
+}
+
+void
+ICStatsEndUpdate(volatile ICStatsSlot *slot)
+{
+	pg_write_barrier();
+	slot->changecount++;
+	Assert((slot->changecount & 1) == 0);
+}
+
+/*
+ * Mark this backend as no longer being in an interconnect.
+ */
+void
+ICStatsClear(void)
+{
+	volatile ICStatsSlot *slot = ICStatsBeginUpdate();
+
+	if (slot == NULL)
+		return;
+
+	slot->pid = 0;
+	ICStatsEndUpdate(slot);
+}
+
+/*
+ * gp_interconnect_stats
+ *		Report the interconnect state of the backends of this database
+ *		instance that currently have an interconnect set up.
+ *
+ * To see the segments, call it in the target list of a query on
+ * gp_dist_random('gp_id').
+ */
+Datum
+gp_interconnect_stats(PG_FUNCTION_ARGS)
+{
+	typedef struct Context
+	{
+		int			currentIndex;
+	} Context;
+
+	FuncCallContext *funcctx = NULL;
+	Context    *context = NULL;
+
+	if (SRF_IS_FIRSTCALL())
+	{
+		TupleDesc	tupdesc;
+		MemoryContext oldcontext;
+
+		funcctx = SRF_FIRSTCALL_INIT();
+
+		oldcontext = MemoryContextSwitchTo(funcctx->multi_call_memory_ctx);
+
+		/* this had better match the definition in pg_proc.sql */
+		tupdesc = CreateTemplateTupleDesc(NUM_IC_STATS_COLUMNS, false);
+		TupleDescInitEntry(tupdesc, (AttrNumber) 1, "segid", INT4OID, -1, 0);
+		TupleDescInitEntry(tupdesc, (AttrNumber) 2, "pid", INT4OID, -1, 0);
+		TupleDescInitEntry(tupdesc, (AttrNumber) 3, "sess_id", INT4OID, -1, 0);
+		TupleDescInitEntry(tupdesc, (AttrNumber) 4, "command_count", INT4OID, -1, 0);
+		TupleDescInitEntry(tupdesc, (AttrNumber) 5, "slice_id", INT4OID, -1, 0);
+		TupleDescInitEntry(tupdesc, (AttrNumber) 6, "send_conns", INT4OID, -1, 0);
+		TupleDescInitEntry(tupdesc, (AttrNumber) 7, "recv_conns", INT4OID, -1, 0);
+		TupleDescInitEntry(tupdesc, (AttrNumber) 8, "rx_buffers_in_use", INT4OID, -1, 0);
+		TupleDescInitEntry(tupdesc, (AttrNumber) 9, "rx_buffers_max", INT4OID, -1, 0);
+		TupleDescInitEntry(tupdesc, (AttrNumber) 10, "recv_queue_len", INT4OID, -1, 0);
+		TupleDescInitEntry(tupdesc, (AttrNumber) 11, "max_recv_queue_len", INT4OID, -1, 0);
+		TupleDescInitEntry(tupdesc, (AttrNumber) 12, "max_recv_queue_content", INT4OID, -1, 0);
+		TupleDescInitEntry(tupdesc, (AttrNumber) 13, "unack_queue_len", INT4OID, -1, 0);
+		TupleDescInitEntry(tupdesc, (AttrNumber) 14, "max_unack_queue_len", INT4OID, -1, 0);
+		TupleDescInitEntry(tupdesc, (AttrNumber) 15, "max_unack_queue_content", INT4OID, -1, 0);
+		TupleDescInitEntry(tupdesc, (AttrNumber) 16, "retransmits", INT8OID, -1, 0);
+		TupleDescInitEntry(tupdesc, (AttrNumber) 17, "duplicates", INT8OID, -1, 0);
+		TupleDescInitEntry(tupdesc, (AttrNumber) 18, "put_rx_buffer_count", INT8OID, -1, 0);
+		TupleDescInitEntry(tupdesc, (AttrNumber) 19, "put_rx_buffer_time_us", INT8OID, -1, 0);
+		TupleDescInitEntry(tupdesc, (AttrNumber) 20, "wait_time_us", INT8OID, -1, 0);
+
+		funcctx->tuple_desc = BlessTupleDesc(tupdesc);
+
+		context = (Context *) palloc(sizeof(Context));
+		funcctx->user_fctx = (void *) context;
+		context->currentIndex = 0;
+		MemoryContextSwitchTo(oldcontext);
+	}
+
+	funcctx = SRF_PERCALL_SETUP();
+	context = (Context *) funcctx->user_fctx;
+	Assert(context);
+
+	if (ICStatsArray == NULL)
+		SRF_RETURN_DONE(funcctx);
+
+	while (context->currentIndex < MaxBackends)
+	{
+		volatile ICStatsSlot *slot = &ICStatsArray[context->currentIndex++];
+		ICStatsSlot local;
+		Datum		values[NUM_IC_STATS_COLUMNS];
+		bool		nulls[NUM_IC_STATS_COLUMNS];
+		HeapTuple	tuple;
+
+		/*
+		 * Follow the protocol of retrying if changecount changes while we
+		 * copy the slot, or if it's odd.
+		 */
+		for (;;)
+		{
+			int			save_changecount = slot->changecount;
+
+			pg_read_barrier();
+			memcpy(&local, (char *) slot, sizeof(ICStatsSlot));
+			pg_read_barrier();
+
+			if (save_changecount == slot->changecount &&
+				(save_changecount & 1) == 0)
+				break;
+
+			/* Make sure we can break out of loop if stuck... */
+			CHECK_FOR_INTERRUPTS();
+		}
+
+		if (local.pid == 0)
+			continue;
+
+		MemSet(nulls, false, sizeof(nulls));
+		values[0] = Int32GetDatum(GpIdentity.segindex);
+		values[1] = Int32GetDatum(local.pid);
+		values[2] = Int32GetDatum(local.sessionId);
+		values[3] = Int32GetDatum(local.commandCount);
+		values[4] = Int32GetDatum(local.sliceId);
+		values[5] = Int32GetDatum(local.numSendConns);
+		values[6] = Int32GetDatum(local.numRecvConns);
+		values[7] = Int32GetDatum(local.rxBuffersInUse);
+		values[8] = Int32GetDatum(local.rxBuffersMax);
+		values[9] = Int32GetDatum(local.recvQueueLength);
+		values[10] = Int32GetDatum(local.maxRecvQueueLength);
+		values[11] = Int32GetDatum(local.maxRecvQueueContent);
+		values[12] = Int32GetDatum(local.unackQueueLength);
+		values[13] = Int32GetDatum(local.maxUnackQueueLength);
+		values[14] = Int32GetDatum(local.maxUnackQueueContent);
+		values[15] = Int64GetDatum(local.retransmits);
+		values[16] = Int64GetDatum(local.duplicates);
+		values[17] = Int64GetDatum(local.putRxBufferCount);
+		values[18] = Int64GetDatum(local.putRxBufferTime);
+		values[19] = Int64GetDatum(local.waitTime);
+
+		/* No point printing content ids of empty queues */
+		if (local.maxRecvQueueLength == 0)
+			nulls[11] = true;
+		if (local.maxUnackQueueLength == 0)
+			nulls[14] = true;
+
+		tuple = heap_form_tuple(funcctx->tuple_desc, values, nulls);
+		SRF_RETURN_NEXT(funcctx, HeapTupleGetDatum(tuple));
+	}
+
+	SRF_RETURN_DONE(funcctx);
+}
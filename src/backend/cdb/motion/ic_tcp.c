@@ -167,6 +167,55 @@ static bool flushBuffer(MotionLayerState *mlStates, ChunkTransportState *transpo
 
 static void doSendStopMessageTCP(ChunkTransportState *transportStates, int16 motNodeID);
 
+static bool socketIsIdle(int sockfd);
+static int	takeOutgoingCachedConn(CdbProcess *cdbProc);
+static void cacheOutgoingConn(MotionConn *conn);
+static void cacheIncomingConn(int sockfd);
+static MotionConn *adoptIncomingCachedConn(int idx);
+static void purgeConnCache(bool all);
+
+/*
+ * Connection cache.
+ *
+ * When gp_interconnect_tcp_conn_cache_size is set, a connection over which a
+ * motion completed cleanly is not closed at teardown. Instead, the receiver
+ * answers the end-of-stream with a single TCP_CONN_DONE byte rather than
+ * half-closing the socket, and both ends keep the socket for a later
+ * statement of the same session. The sender looks it up by the receiving
+ * backend's listener address, port and pid, and sends the registration
+ * message of the new motion over it instead of connecting again; the
+ * receiver watches its idle cached sockets next to the listener socket while
+ * it waits for registrations.
+ *
+ * gp_interconnect_tcp_conn_cache_size bounds the sockets a backend keeps
+ * between statements, incoming and outgoing together, so a session never
+ * holds more than that many descriptors per backend beyond the ones of the
+ * statement that is running. The receiver only sends TCP_CONN_DONE if it has
+ * room to cache the socket, so it never has to evict a connection the sender
+ * may still reuse; room left over goes to outgoing connections. Either side
+ * closing a cached socket is noticed by the other as EOF, and the entry is
+ * dropped.
+ */
+#define TCP_CONN_DONE 'D'
+
+typedef struct TCPConnCacheEntry
+{
+	int			sockfd;
+
+	/* identity of the receiving backend, only for outgoing connections */
+	int			pid;
+	int			port;
+	char		addr[64];
+} TCPConnCacheEntry;
+
+static TCPConnCacheEntry *outgoingConnCache = NULL;
+static int	numOutgoingCached = 0;
+static TCPConnCacheEntry *incomingConnCache = NULL;
+static int	numIncomingCached = 0;
+
+/* TCP_CONN_DONE sent during this statement, not cached yet */
+static int	numIncomingPromised = 0;
+
 /*
  * setupTCPListeningSocket
  */
@@ -359,10 +408,234 @@ InitMotionTCP(int *listenerSocketFd, uint16 *listenerPort)
 void
 CleanupMotionTCP(void)
 {
-	/* nothing to do. */
+	purgeConnCache(true);
 	return;
 }
 
+/*
+ * socketIsIdle
+ *
+ * Returns true if nothing is pending on the socket and the peer has not
+ * closed it, i.e. it is safe to keep or to reuse.
+ */
+static bool
+socketIsIdle(int sockfd)
+{
+	char		buf;
+	int			n;
+
+	n = recv(sockfd, &buf, sizeof(buf), MSG_PEEK);
+
+	return n < 0 && (errno == EWOULDBLOCK || errno == EAGAIN);
+}
+
+static void
+ensureConnCache(void)
+{
+	if (outgoingConnCache == NULL)
+	{
+		outgoingConnCache = MemoryContextAlloc(TopMemoryContext,
+											   MAX_TCP_CONN_CACHE_SIZE * sizeof(TCPConnCacheEntry));
+		incomingConnCache = MemoryContextAlloc(TopMemoryContext,
+											   MAX_TCP_CONN_CACHE_SIZE * sizeof(TCPConnCacheEntry));
+	}
+}
+
+/*
+ * takeOutgoingCachedConn
+ *
+ * Returns a cached connection to the given receiving backend and removes it
+ * from the cache, or -1 if there is none that is still usable.
+ */
+static int
+takeOutgoingCachedConn(CdbProcess *cdbProc)
+{
+	int			i;
+
+	for (i = 0; i < numOutgoingCached; i++)
+	{
+		TCPConnCacheEntry *entry = &outgoingConnCache[i];
+		int			sockfd;
+
+		if (entry->pid != cdbProc->pid ||
+			entry->port != cdbProc->listenerPort ||
+			strcmp(entry->addr, cdbProc->listenerAddr) != 0)
+			continue;
+
+		sockfd = entry->sockfd;
+		*entry = outgoingConnCache[--numOutgoingCached];
+
+		if (!socketIsIdle(sockfd))
+		{
+			closesocket(sockfd);
+			return -1;
+		}
+
+		return sockfd;
+	}
+
+	return -1;
+}
+
+static void
+cacheOutgoingConn(MotionConn *conn)
+{
+	TCPConnCacheEntry *entry;
+
+	ensureConnCache();
+
+	if (numOutgoingCached + numIncomingCached >= Gp_interconnect_tcp_conn_cache_size ||
+		strlen(conn->cdbProc->listenerAddr) >= sizeof(entry->addr) ||
+		!socketIsIdle(conn->sockfd))
+	{
+		closesocket(conn->sockfd);
+		conn->sockfd = -1;
+		return;
+	}
+
+	entry = &outgoingConnCache[numOutgoingCached++];
+	entry->sockfd = conn->sockfd;
+	entry->pid = conn->cdbProc->pid;
+	entry->port = conn->cdbProc->listenerPort;
+	strcpy(entry->addr, conn->cdbProc->listenerAddr);
+
+	conn->sockfd = -1;
+}
+
+static void
+cacheIncomingConn(int sockfd)
+{
+	TCPConnCacheEntry *entry;
+
+	ensureConnCache();
+
+	if (numOutgoingCached + numIncomingCached >= Gp_interconnect_tcp_conn_cache_size ||
+		!socketIsIdle(sockfd))
+	{
+		closesocket(sockfd);
+		return;
+	}
+
+	entry = &incomingConnCache[numIncomingCached++];
+	MemSet(entry, 0, sizeof(*entry));
+	entry->sockfd = sockfd;
+}
+
+/*
+ * adoptIncomingCachedConn
+ *
+ * A cached incoming connection became readable during setup: take it out of
+ * the cache and prepare it for readRegisterMessage(), just like a freshly
+ * accepted connection. Returns NULL if the peer closed it instead.
+ */
+static MotionConn *
+adoptIncomingCachedConn(int idx)
+{
+	int			sockfd = incomingConnCache[idx].sockfd;
+	struct sockaddr_storage addr;
+	socklen_t	addrsize;
+	MotionConn *conn;
+	char		buf;
+
+	incomingConnCache[idx] = incomingConnCache[--numIncomingCached];
+
+	if (recv(sockfd, &buf, sizeof(buf), MSG_PEEK) <= 0)
+	{
+		closesocket(sockfd);
+		return NULL;
+	}
+
+	conn = palloc0(sizeof(MotionConn));
+	conn->sockfd = sockfd;
+	conn->pBuff = palloc(Gp_max_packet_size);
+	conn->stillActive = false;
+	conn->state = mcsAccepted;
+	conn->remoteContentId = -2;
+
+	addrsize = sizeof(addr);
+	if (getpeername(sockfd, (struct sockaddr *) &addr, &addrsize) == 0)
+		format_sockaddr((struct sockaddr *) &addr, conn->remoteHostAndPort,
+						sizeof(conn->remoteHostAndPort));
+	addrsize = sizeof(addr);
+	if (getsockname(sockfd, (struct sockaddr *) &addr, &addrsize) == 0)
+		format_sockaddr((struct sockaddr *) &addr, conn->localHostAndPort,
+						sizeof(conn->localHostAndPort));
+
+	if (gp_log_interconnect >= GPVARS_VERBOSITY_DEBUG)
+		elog(DEBUG4, "Interconnect reusing cached incoming connection "
+			 "from remote=%s to local=%s sockfd=%d",
+			 conn->remoteHostAndPort, conn->localHostAndPort, sockfd);
+
+	return conn;
+}
+
+/*
+ * purgeConnCache
+ *
+ * Close cached connections the peer has closed, outgoing and then incoming
+ * ones beyond the current cache size, or everything if 'all' is set. Cached
+ * incoming connections
+ * with pending data at teardown carry registrations nobody is waiting for
+ * any more (compare flushInterconnectListenerBacklog()), so close them too.
+ */
+static void
+purgeConnCache(bool all)
+{
+	int			i;
+
+	for (i = numOutgoingCached - 1; i >= 0; i--)
+	{
+		if (all ||
+			numOutgoingCached + numIncomingCached > Gp_interconnect_tcp_conn_cache_size ||
+			!socketIsIdle(outgoingConnCache[i].sockfd))
+		{
+			closesocket(outgoingConnCache[i].sockfd);
+			outgoingConnCache[i] = outgoingConnCache[--numOutgoingCached];
+		}
+	}
+
+	for (i = numIncomingCached - 1; i >= 0; i--)
+	{
+		if (all ||
+			numOutgoingCached + numIncomingCached > Gp_interconnect_tcp_conn_cache_size ||
+			!socketIsIdle(incomingConnCache[i].sockfd))
+		{
+			closesocket(incomingConnCache[i].sockfd);
+			incomingConnCache[i] = incomingConnCache[--numIncomingCached];
+		}
+	}
+}
+
+/*
+ * markTCPConnDone
+ *
+ * Called on the receiver once it needs no more data from a connection.
+ * Normally the socket is half-closed, which the sender waits for in
+ * waitOnOutbound(). If the sender completed its stream and there is room in
+ * the connection cache, send TCP_CONN_DONE instead and keep the socket.
+ */
+void
+markTCPConnDone(MotionConn *conn)
+{
+	char		m = TCP_CONN_DONE;
+
+	if (conn->tcpCacheable)
+		return;
+
+	if (!conn->stopRequested &&
+		Gp_interconnect_tcp_conn_cache_size > 0 &&
+		numOutgoingCached + numIncomingCached + numIncomingPromised <
+		Gp_interconnect_tcp_conn_cache_size &&
+		send(conn->sockfd, &m, sizeof(m), 0) == sizeof(m))
+	{
+		conn->tcpCacheable = true;
+		numIncomingPromised++;
+		return;
+	}
+
+	shutdown(conn->sockfd, SHUT_WR);
+}
+
 /* Function readPacket() is used to read in the next packet from the given
  * MotionConn.
  *
@@ -663,6 +936,26 @@ setupOutgoingConnection(ChunkTransportState *transportStates, ChunkTransportStat
 		conn->sockfd = -1;
 	}
 
+	/* Reuse a connection kept open by an earlier statement, if any. */
+	if (Gp_interconnect_tcp_conn_cache_size > 0)
+	{
+		conn->sockfd = takeOutgoingCachedConn(cdbProc);
+		if (conn->sockfd >= 0)
+		{
+			if (gp_log_interconnect >= GPVARS_VERBOSITY_DEBUG)
+				ereport(DEBUG1, (errmsg("Interconnect reusing cached connection to "
+										"seg%d slice%d %s pid=%d sockfd=%d",
+										conn->remoteContentId,
+										pEntry->recvSlice->sliceIndex,
+										conn->remoteHostAndPort,
+										cdbProc->pid,
+										conn->sockfd)));
+
+			sendRegisterMessage(transportStates, pEntry, conn);
+			return;
+		}
+	}
+
 	/* Initialize hint structure */
 	MemSet(&hint, 0, sizeof(hint));
 	hint.ai_socktype = SOCK_STREAM;
@@ -1438,6 +1731,7 @@ SetupTCPInterconnect(EState *estate)
 	estate->interconnect_context->RecvTupleChunkFromAny = RecvTupleChunkFromAnyTCP;
 	estate->interconnect_context->SendEos = SendEosTCP;
 	estate->interconnect_context->SendChunk = SendChunkTCP;
+	estate->interconnect_context->FlushBuffer = flushBuffer;
 	estate->interconnect_context->doSendStopMessage = doSendStopMessageTCP;
 
 	mySlice = (Slice *) list_nth(estate->interconnect_context->sliceTable->slices, LocallyExecutingSliceIndex(estate));
@@ -1531,6 +1825,13 @@ SetupTCPInterconnect(EState *estate)
 
 			MPP_FD_SET(TCP_listenerFd, &rset);
 			highsock = TCP_listenerFd;
+
+			/* Registrations may also arrive on connections kept from before */
+			for (i = 0; i < numIncomingCached; i++)
+			{
+				MPP_FD_SET(incomingConnCache[i].sockfd, &rset);
+				highsock = Max(highsock, incomingConnCache[i].sockfd);
+			}
 		}
 
 		/* Inbound connections awaiting registration message */
@@ -1845,6 +2146,28 @@ SetupTCPInterconnect(EState *estate)
 			}
 		}
 
+		/*
+		 * Registrations on cached connections: treat them like newly
+		 * accepted ones. Walk backwards, adopting one moves the last entry.
+		 */
+		for (i = numIncomingCached - 1; n > 0 && i >= 0; i--)
+		{
+			if (!MPP_FD_ISSET(incomingConnCache[i].sockfd, &rset))
+				continue;
+
+			n--;
+			conn = adoptIncomingCachedConn(i);
+			if (conn == NULL)
+				continue;
+
+			conn->state = mcsRecvRegMsg;
+			conn->msgSize = sizeof(RegisterMessage);
+			conn->msgPos = conn->pBuff;
+			conn->remapper = CreateTupleRemapper();
+
+			estate->interconnect_context->incompleteConns = lappend(estate->interconnect_context->incompleteConns, conn);
+		}
+
 		/*
 		 * Check our outgoing connections.
 		 */
@@ -2097,7 +2420,14 @@ TeardownTCPInterconnect(ChunkTransportState *transportStates,
 		for (i = 0; i < pEntry->numConns; i++)
 		{
 			conn = pEntry->conns + i;
-			if (conn->sockfd >= 0)
+
+			/*
+			 * A complete stream may be kept for reuse, so wait for the
+			 * receiver to tell us rather than half-closing it here.
+			 */
+			if (conn->sockfd >= 0 &&
+				(forceEOS || !conn->tcpEosSent ||
+				 Gp_interconnect_tcp_conn_cache_size == 0))
 				shutdown(conn->sockfd, SHUT_WR);
 
 			/* free up the tuple remapper */
@@ -2135,7 +2465,18 @@ TeardownTCPInterconnect(ChunkTransportState *transportStates,
 		{
 			conn = pEntry->conns + i;
 
-			if (conn->sockfd >= 0)
+			if (conn->sockfd >= 0 && conn->tcpCacheable && !forceEOS)
+			{
+				cacheIncomingConn(conn->sockfd);
+				conn->sockfd = -1;
+
+				if (conn->remapper)
+				{
+					DestroyTupleRemapper(conn->remapper);
+					conn->remapper = NULL;
+				}
+			}
+			else if (conn->sockfd >= 0)
 			{
 				flushIncomingData(conn->sockfd);
 				shutdown(conn->sockfd, SHUT_WR);
@@ -2172,7 +2513,10 @@ TeardownTCPInterconnect(ChunkTransportState *transportStates,
 		{
 			conn = pEntry->conns + i;
 
-			if (conn->sockfd >= 0)
+			if (conn->sockfd >= 0 && conn->tcpCacheable && !forceEOS &&
+				Gp_interconnect_tcp_conn_cache_size > 0)
+				cacheOutgoingConn(conn);
+			else if (conn->sockfd >= 0)
 			{
 				closesocket(conn->sockfd);
 				conn->sockfd = -1;
@@ -2189,6 +2533,15 @@ TeardownTCPInterconnect(ChunkTransportState *transportStates,
 	if (TCP_listenerFd != -1)
 		flushInterconnectListenerBacklog();
 
+	numIncomingPromised = 0;
+	purgeConnCache(false);
+
+	if (gp_log_interconnect >= GPVARS_VERBOSITY_DEBUG &&
+		numOutgoingCached + numIncomingCached > 0)
+		elog(DEBUG1, "Interconnect keeping %d outgoing and %d incoming "
+			 "connections open for later statements",
+			 numOutgoingCached, numIncomingCached);
+
 	transportStates->activated = false;
 	transportStates->sliceTable = NULL;
 
@@ -2524,8 +2877,12 @@ waitOnOutbound(ChunkTransportStateEntry *pEntry)
 
 				/* ready to read. */
 				count = recv(conn->sockfd, &buf, sizeof(buf), 0);
-				if (count == 0) /* done ! */
+				if (count == 0 || (count == 1 && buf == TCP_CONN_DONE))	/* done ! */
 				{
+					/* receiver asked to keep the connection open */
+					if (count == 1)
+						conn->tcpCacheable = true;
+
 					MPP_FD_CLR(conn->sockfd, &waitset);
 					/* we may have finished */
 					conn_count--;
@@ -2600,6 +2957,9 @@ doSendStopMessageTCP(ChunkTransportState *transportStates, int16 motNodeID)
 				elog(LOG, "SendStopMessage: failed on write.  %m");
 			}
 		}
+		/* a stopped stream is incomplete, don't keep the connection */
+		conn->stopRequested = true;
+
 		/* CRITICAL TO AVOID DEADLOCK */
 		DeregisterReadInterest(transportStates, motNodeID, i,
 							   "no more input needed");
@@ -2798,7 +3158,10 @@ SendEosTCP(MotionLayerState *mlStates,
 		conn = pEntry->conns + i;
 
 		if (conn->sockfd >= 0 && conn->state == mcsStarted)
-			flushBuffer(mlStates, transportStates, pEntry, conn, motNodeID);
+		{
+			if (flushBuffer(mlStates, transportStates, pEntry, conn, motNodeID))
+				conn->tcpEosSent = true;
+		}
 
 #ifdef AMS_VERBOSE_LOGGING
 		elog(DEBUG5, "SendEosTCP() Leaving");
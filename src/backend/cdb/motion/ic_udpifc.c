@@ -33,6 +33,7 @@
 #include "nodes/print.h"
 #include "utils/memutils.h"
 #include "miscadmin.h"
+#include "pgstat.h"
 #include "libpq/libpq-be.h"
 #include "libpq/ip.h"
 #include "utils/builtins.h"
@@ -48,6 +49,7 @@
 #include "cdb/cdbdisp.h"
 #include "cdb/cdbdispatchresult.h"
 #include "cdb/cdbicudpfaultinjection.h"
+#include "cdb/ic_stats.h"
 
 #include <fcntl.h>
 #include <limits.h>
@@ -315,6 +317,9 @@ struct RxBufferPool
 
 	/* The list of free buffers. */
 	char	   *freeList;
+
+	/* The number of buffers in the free list. */
+	int			freeCount;
 };
 
 /*
@@ -323,7 +328,7 @@ struct RxBufferPool
  * maxCount is set to 1 to make sure there is always a buffer
  * for picking packets from OS buffer.
  */
-static RxBufferPool rx_buffer_pool = {1, 0, NULL};
+static RxBufferPool rx_buffer_pool = {1, 0, NULL, 0};
 
 /*
  * SendBufferPool
@@ -522,6 +527,23 @@ static ICGlobalControlInfo ic_control_info;
 
 #define MAX_SEQS_IN_DISORDER_ACK (4)
 
+/*
+ * Both the loss based and the adaptive flow control methods keep outstanding
+ * packets in the unack queue ring and share the global congestion window. The
+ * adaptive method additionally keeps a congestion window per connection, paces
+ * packets within a round trip and uses an RTT based retransmit timeout with a
+ * bounded back-off.
+ */
+#define FC_METHOD_USES_UNACK_RING() \
+	(Gp_interconnect_fc_method == INTERCONNECT_FC_METHOD_LOSS || \
+	 Gp_interconnect_fc_method == INTERCONNECT_FC_METHOD_ADAPTIVE)
+#define FC_METHOD_IS_ADAPTIVE() \
+	(Gp_interconnect_fc_method == INTERCONNECT_FC_METHOD_ADAPTIVE)
+
+#define ADAPTIVE_INITIAL_CWND (2)
+#define ADAPTIVE_MIN_CWND (1)
+#define ADAPTIVE_MAX_BACKOFF_SHIFT (6)
+
 /*
  * UnackQueueRing
  *
@@ -607,6 +629,11 @@ typedef struct AckSendParam
  * duplicatedPktNum          - duplicate packet number.
  * recvAckNum                - the number of Acks received.
  * statusQueryMsgNum         - the number of status query messages sent.
+ * cwndReductions            - per-connection window reductions (adaptive flow control).
+ * pacedSends                - sends deferred by pacing (adaptive flow control).
+ * putRxBufferNum            - the number of receive buffers released by the main thread.
+ * putRxBufferTime           - time spent releasing them (including acks), in usecs.
+ * waitTime                  - time the main thread spent waiting for packets, in usecs.
  *
  */
 typedef struct ICStatistics
@@ -628,6 +655,11 @@ typedef struct ICStatistics
 	int32		duplicatedPktNum;
 	int32		recvAckNum;
 	int32		statusQueryMsgNum;
+	int32		cwndReductions;
+	int32		pacedSends;
+	uint64		putRxBufferNum;
+	uint64		putRxBufferTime;
+	uint64		waitTime;
 } ICStatistics;
 
 /* Statistics for UDP interconnect. */
@@ -722,6 +754,8 @@ static TupleChunkListItem receiveChunksUDPIFC(ChunkTransportState *pTransportSta
 
 static void SendEosUDPIFC(MotionLayerState *mlStates, ChunkTransportState *transportStates,
 			  int motNodeID, TupleChunkListItem tcItem);
+static bool flushBufferUDPIFC(MotionLayerState *mlStates, ChunkTransportState *transportStates,
+				  ChunkTransportStateEntry *pEntry, MotionConn *conn, int16 motionId);
 static bool SendChunkUDPIFC(MotionLayerState *mlStates, ChunkTransportState *transportStates,
 				ChunkTransportStateEntry *pEntry, MotionConn *conn, TupleChunkListItem tcItem, int16 motionId);
 
@@ -731,6 +765,7 @@ static void checkQDConnectionAlive(void);
 
 
 static void *rxThreadFunc(void *arg);
+static bool handleRxPacket(icpkthdr *pkt, int read_count, struct sockaddr_storage *peer, socklen_t peerlen);
 
 static bool handleMismatch(icpkthdr *pkt, struct sockaddr_storage *peer, int peer_len);
 static void handleAckedPacket(MotionConn *ackConn, ICBuffer *buf, uint64 now);
@@ -746,7 +781,11 @@ static inline void addCRC(icpkthdr *pkt);
 static inline bool checkCRC(icpkthdr *pkt);
 static void sendBuffers(ChunkTransportState *transportStates, ChunkTransportStateEntry *pEntry, MotionConn *conn);
 static void sendOnce(ChunkTransportState *transportStates, ChunkTransportStateEntry *pEntry, ICBuffer *buf, MotionConn *conn);
+static void sendBatch(ChunkTransportState *transportStates, ChunkTransportStateEntry *pEntry, ICBuffer **bufs, int nbufs);
 static inline uint64 computeExpirationPeriod(MotionConn *conn, uint32 retry);
+static inline void adaptiveCwndOnAck(MotionConn *conn);
+static void adaptiveCwndOnLoss(MotionConn *conn, icpkthdr *pkt, uint64 now, bool timeout);
+static inline uint64 adaptivePacingGap(MotionConn *conn);
 
 static ICBuffer *getSndBuffer(MotionConn *conn);
 static void initSndBufferPool();
@@ -767,6 +806,7 @@ static bool waitOnCondition(int timeout_us, pthread_cond_t *cond, pthread_mutex_
 
 static inline void logPkt(char *prefix, icpkthdr *pkt);
 static void aggregateStatistics(ChunkTransportStateEntry *pEntry);
+static void publishICStats(ChunkTransportState *transportStates, uint64 now, bool force);
 
 static inline bool pollAcks(ChunkTransportState *transportStates, int fd, int timeout);
 
@@ -777,7 +817,8 @@ typedef enum TransProtoEvent TransProtoEvent;
 enum TransProtoEvent
 {
 	TPE_DATA_PKT_SEND,
-	TPE_ACK_PKT_QUERY
+	TPE_ACK_PKT_QUERY,
+	TPE_CWND_REDUCE
 };
 
 typedef struct TransProtoStatEntry TransProtoStatEntry;
@@ -790,12 +831,12 @@ struct TransProtoStatEntry
 	TransProtoEvent event;
 	int			dstPid;
 	uint32		seq;
+	float		cwnd;
+	float		connCwnd;
+	int			capacity;
+	uint32		rtt;
 
 	/* more attributes can be added on demand. */
-
-	/*
-	 * float			cwnd; int				capacity;
-	 */
 };
 
 typedef struct TransProtoStats TransProtoStats;
@@ -871,11 +912,10 @@ updateStats(TransProtoEvent event, MotionConn *conn, icpkthdr *pkt)
 	new->event = event;
 	new->dstPid = pkt->dstPid;
 	new->seq = pkt->seq;
-
-	/*
-	 * Other attributes can be added on demand new->cwnd =
-	 * snd_control_info.cwnd; new->capacity = conn->capacity;
-	 */
+	new->cwnd = snd_control_info.cwnd;
+	new->connCwnd = conn->cwnd;
+	new->capacity = conn->capacity;
+	new->rtt = (uint32) conn->rtt;
 
 	pthread_mutex_unlock(&trans_proto_stats.lock);
 }
@@ -896,7 +936,9 @@ dumpTransProtoStats()
 		cur = trans_proto_stats.head;
 		trans_proto_stats.head = trans_proto_stats.head->next;
 
-		fprintf(ofile, "time %d event %d seq %d destpid %d\n", cur->time, cur->event, cur->seq, cur->dstPid);
+		fprintf(ofile, "time %d event %d seq %d destpid %d cwnd %f conncwnd %f capacity %d rtt %d\n",
+				cur->time, cur->event, cur->seq, cur->dstPid,
+				cur->cwnd, cur->connCwnd, cur->capacity, cur->rtt);
 		free(cur);
 		trans_proto_stats.count--;
 	}
@@ -1403,6 +1445,7 @@ InitMotionUDPIFC(int *listenerSocketFd, uint16 *listenerPort)
 	rx_buffer_pool.count = 0;
 	rx_buffer_pool.maxCount = 1;
 	rx_buffer_pool.freeList = NULL;
+	rx_buffer_pool.freeCount = 0;
 
 	/* Initialize send control data */
 	snd_control_info.cwnd = 0;
@@ -1546,7 +1589,17 @@ waitOnCondition(int timeout_us, pthread_cond_t *cond, pthread_mutex_t *mutex)
 	 * interrupts are checked.
 	 */
 
+	pgstat_report_wait_start(WAIT_EVENT_INTERCONNECT_RECV);
 	wait = pthread_cond_timedwait(cond, mutex, &ts);
+	pgstat_report_wait_end();
+
+	{
+		struct timeval endtv;
+
+		gettimeofday(&endtv, NULL);
+		ic_statistics.waitTime += (endtv.tv_sec - tv.tv_sec) * 1000000 +
+			(endtv.tv_usec - tv.tv_usec);
+	}
 
 	if (wait == ETIMEDOUT)
 	{
@@ -1984,6 +2037,7 @@ MlPutRxBufferIFC(ChunkTransportState *transportStates, int motNodeID, int route)
 	ChunkTransportStateEntry *pEntry = NULL;
 	MotionConn *conn = NULL;
 	AckSendParam param;
+	uint64		start = getCurrentTime();
 
 	getChunkTransportState(transportStates, motNodeID, &pEntry);
 
@@ -2011,6 +2065,9 @@ MlPutRxBufferIFC(ChunkTransportState *transportStates, int motNodeID, int route)
 	 */
 	if (param.msg.len != 0)
 		sendAckWithParam(&param);
+
+	ic_statistics.putRxBufferNum++;
+	ic_statistics.putRxBufferTime += getCurrentTime() - start;
 }
 
 /*
@@ -2084,6 +2141,7 @@ putRxBufferToFreeList(RxBufferPool *p, icpkthdr *buf)
 	/* return the buffer into the free list. */
 	*(char **) buf = p->freeList;
 	p->freeList = (char *) buf;
+	p->freeCount++;
 }
 
 /*
@@ -2107,6 +2165,7 @@ getRxBufferFromFreeList(RxBufferPool *p)
 
 	buf = (icpkthdr *) p->freeList;
 	p->freeList = *(char **) (p->freeList);
+	p->freeCount--;
 	return buf;
 }
 
@@ -2532,6 +2591,23 @@ computeExpirationPeriod(MotionConn *conn, uint32 retry)
 	}
 	else
 #endif
+	if (FC_METHOD_IS_ADAPTIVE())
+	{
+		/*
+		 * RTO = SRTT + 4 * RTTVAR (the variance term is at least one timer
+		 * span, since the unack queue ring cannot resolve anything finer).
+		 * The back-off is bounded much lower than below, and a small random
+		 * jitter keeps many senders that lost packets at the same time from
+		 * retransmitting in lockstep into the same receiver.
+		 */
+		uint32		factor = Min(retry, ADAPTIVE_MAX_BACKOFF_SHIFT);
+		uint64		rto = (conn->rtt + Max(conn->dev << 2, TIMER_SPAN)) << factor;
+
+		rto += random() % ((rto >> 3) + 1);
+
+		return Max(MIN_EXPIRATION_PERIOD, Min(MAX_EXPIRATION_PERIOD, rto));
+	}
+	else
 	{
 		uint32		factor = (retry <= 12 ? retry : 12);
 
@@ -2539,6 +2615,65 @@ computeExpirationPeriod(MotionConn *conn, uint32 retry)
 	}
 }
 
+/*
+ * adaptiveCwndOnAck
+ * 		Grow the per-connection congestion window on a new ack.
+ *
+ * Slow start below ssthresh, additive increase above it, bounded by the size
+ * of the shared send buffer pool.
+ */
+static inline void
+adaptiveCwndOnAck(MotionConn *conn)
+{
+	if (conn->cwnd < conn->ssthresh)
+		conn->cwnd += 1;
+	else
+		conn->cwnd += 1 / conn->cwnd;
+	conn->cwnd = Min(conn->cwnd, snd_buffer_pool.maxCount);
+}
+
+/*
+ * adaptiveCwndOnLoss
+ * 		Shrink the per-connection congestion window on a loss signal.
+ *
+ * A disorder ack halves the window, a retransmit timeout collapses it to the
+ * minimum. The window is reduced at most once per round trip, so that a burst
+ * of losses from one flight does not drive it down repeatedly.
+ */
+static void
+adaptiveCwndOnLoss(MotionConn *conn, icpkthdr *pkt, uint64 now, bool timeout)
+{
+	if (now - conn->lastCwndReductionTime < conn->rtt)
+		return;
+
+	conn->ssthresh = Max(conn->cwnd / 2, ADAPTIVE_MIN_CWND);
+	conn->cwnd = timeout ? ADAPTIVE_MIN_CWND : conn->ssthresh;
+	conn->lastCwndReductionTime = now;
+	conn->stat_cwnd_reductions++;
+	ic_statistics.cwndReductions++;
+
+#ifdef TRANSFER_PROTOCOL_STATS
+	updateStats(TPE_CWND_REDUCE, conn, pkt);
+#endif
+}
+
+/*
+ * adaptivePacingGap
+ * 		Compute the minimal gap between two packets sent on a connection.
+ *
+ * Packets are spread over the round trip instead of being sent as one burst
+ * whenever the window opens. The pacing rate is set a bit above cwnd/RTT (2x
+ * in slow start, 1.25x afterwards) so that pacing itself does not keep the
+ * window from growing.
+ */
+static inline uint64
+adaptivePacingGap(MotionConn *conn)
+{
+	float		rate = (conn->cwnd < conn->ssthresh ? 2.0 : 1.25) * conn->cwnd;
+
+	return (uint64) (conn->rtt / rate);
+}
+
 /*
  * initSndBufferPool
  * 		Initialize the send buffer pool.
@@ -2793,6 +2928,11 @@ setupOutgoingUDPConnection(ChunkTransportState *transportStates, ChunkTransportS
 	conn->remoteContentId = cdbProc->contentid;
 	conn->stat_min_ack_time = ~((uint64) 0);
 
+	conn->cwnd = ADAPTIVE_INITIAL_CWND;
+	conn->ssthresh = Gp_interconnect_snd_queue_depth;
+	conn->nextSendTime = 0;
+	conn->lastCwndReductionTime = 0;
+
 	/* Save the information for the error message if getaddrinfo fails */
 	if (strchr(cdbProc->listenerAddr, ':') != 0)
 		snprintf(conn->remoteHostAndPort, sizeof(conn->remoteHostAndPort),
@@ -3051,6 +3191,7 @@ SetupUDPIFCInterconnect_Internal(EState *estate)
 	estate->interconnect_context->RecvTupleChunkFromAny = RecvTupleChunkFromAnyUDPIFC;
 	estate->interconnect_context->SendEos = SendEosUDPIFC;
 	estate->interconnect_context->SendChunk = SendChunkUDPIFC;
+	estate->interconnect_context->FlushBuffer = flushBufferUDPIFC;
 	estate->interconnect_context->doSendStopMessage = doSendStopMessageUDPIFC;
 
 	mySlice = (Slice *) list_nth(estate->interconnect_context->sliceTable->slices, LocallyExecutingSliceIndex(estate));
@@ -3225,6 +3366,8 @@ SetupUDPIFCInterconnect_Internal(EState *estate)
 
 	estate->interconnect_context->activated = true;
 
+	publishICStats(estate->interconnect_context, 0, true);
+
 	pthread_mutex_unlock(&ic_control_info.lock);
 }
 
@@ -3591,7 +3734,8 @@ TeardownUDPIFCInterconnect_Internal(ChunkTransportState *transportStates,
 		 " freebuf_avg %f "
 		 "mismatch_pkt_num %d disordered_pkt_num %d duplicated_pkt_num %d"
 		 " rtt/dev [" UINT64_FORMAT "/" UINT64_FORMAT ", %f/%f, " UINT64_FORMAT "/" UINT64_FORMAT "] "
-		 " cwnd %f status_query_msg_num %d",
+		 " cwnd %f status_query_msg_num %d"
+		 " cwnd_reductions %d paced_sends %d",
 		 ic_control_info.isSender, isReceiver,
 		 Gp_interconnect_snd_queue_depth, Gp_interconnect_queue_depth, Gp_max_packet_size,
 		 UNACK_QUEUE_RING_SLOTS_NUM, TIMER_SPAN, DEFAULT_RTT,
@@ -3604,10 +3748,12 @@ TeardownUDPIFCInterconnect_Internal(ChunkTransportState *transportStates,
 		 (double) ((double) ic_statistics.totalBuffers) / ((double) ic_statistics.bufferCountingTime),
 		 ic_statistics.mismatchNum, ic_statistics.disorderedPktNum, ic_statistics.duplicatedPktNum,
 		 (minRtt == ~((uint64) 0) ? 0 : minRtt), (minDev == ~((uint64) 0) ? 0 : minDev), avgRtt, avgDev, maxRtt, maxDev,
-		 snd_control_info.cwnd, ic_statistics.statusQueryMsgNum);
+		 snd_control_info.cwnd, ic_statistics.statusQueryMsgNum,
+		 ic_statistics.cwndReductions, ic_statistics.pacedSends);
 
 	ic_control_info.isSender = false;
 	memset(&ic_statistics, 0, sizeof(ICStatistics));
+	ICStatsClear();
 
 	pthread_mutex_unlock(&ic_control_info.lock);
 
@@ -3729,6 +3875,7 @@ receiveChunksUDPIFC(ChunkTransportState *pTransportStates, ChunkTransportStateEn
 		}
 
 		aggregateStatistics(pEntry);
+		publishICStats(pTransportStates, 0, false);
 
 		if (rxconn != NULL)
 		{
@@ -4060,6 +4207,119 @@ aggregateStatistics(ChunkTransportStateEntry *pEntry)
 	}
 }
 
+/*
+ * publishICStats
+ * 		Copy the state of this backend's interconnect into its shared
+ * 		ICStatsSlot, for gp_interconnect_stats().
+ *
+ * Unless force is set, this does nothing if the slot was updated less than
+ * IC_STATS_PUBLISH_INTERVAL ago, so that it is cheap enough to call from
+ * the send and receive paths.  now is the current time, or 0 if the caller
+ * does not have it at hand.
+ *
+ * Must be called by the main thread.
+ */
+#define IC_STATS_PUBLISH_INTERVAL (100 * 1000)	/* 100ms */
+
+static void
+publishICStats(ChunkTransportState *transportStates, uint64 now, bool force)
+{
+	static uint64 lastPublishTime = 0;
+	volatile ICStatsSlot *slot;
+	int			numSendConns = 0;
+	int			numRecvConns = 0;
+	int			recvQueueLength = 0;
+	int			maxRecvQueueLength = 0;
+	int			maxRecvQueueContent = -1;
+	int			unackQueueLength = 0;
+	int			maxUnackQueueLength = 0;
+	int			maxUnackQueueContent = -1;
+	int			i;
+
+	if (now == 0)
+		now = getCurrentTime();
+
+	if (!force && now - lastPublishTime < IC_STATS_PUBLISH_INTERVAL)
+		return;
+	lastPublishTime = now;
+
+	if (transportStates == NULL)
+		return;
+
+	for (i = 0; i < transportStates->size; i++)
+	{
+		ChunkTransportStateEntry *pEntry = &transportStates->states[i];
+		bool		isSending;
+		int			connNo;
+
+		if (!pEntry->valid)
+			continue;
+
+		isSending = (pEntry->sendSlice != NULL &&
+					 pEntry->sendSlice->sliceIndex == transportStates->sliceId);
+
+		for (connNo = 0; connNo < pEntry->numConns; connNo++)
+		{
+			MotionConn *conn = &pEntry->conns[connNo];
+			int			contentId;
+			int			len;
+
+			if (conn->cdbProc == NULL)
+				continue;
+			contentId = conn->cdbProc->contentid;
+
+			if (isSending)
+			{
+				numSendConns++;
+				len = icBufferListLength(&conn->unackQueue);
+				unackQueueLength += len;
+				if (len > maxUnackQueueLength)
+				{
+					maxUnackQueueLength = len;
+					maxUnackQueueContent = contentId;
+				}
+			}
+			else
+			{
+				numRecvConns++;
+				len = conn->pkt_q_size;
+				recvQueueLength += len;
+				if (len > maxRecvQueueLength)
+				{
+					maxRecvQueueLength = len;
+					maxRecvQueueContent = contentId;
+				}
+			}
+		}
+	}
+
+	slot = ICStatsBeginUpdate();
+	if (slot == NULL)
+		return;
+
+	slot->pid = MyProcPid;
+	slot->sessionId = gp_session_id;
+	slot->commandCount = gp_command_count;
+	slot->sliceId = transportStates->sliceId;
+	slot->numSendConns = numSendConns;
+	slot->numRecvConns = numRecvConns;
+	slot->rxBuffersInUse = rx_buffer_pool.count - rx_buffer_pool.freeCount;
+	slot->rxBuffersMax = rx_buffer_pool.maxCount;
+	slot->recvQueueLength = recvQueueLength;
+	slot->maxRecvQueueLength = maxRecvQueueLength;
+	slot->maxRecvQueueContent = maxRecvQueueContent;
+	slot->unackQueueLength = unackQueueLength;
+	slot->maxUnackQueueLength = maxUnackQueueLength;
+	slot->maxUnackQueueContent = maxUnackQueueContent;
+	slot->retransmits = ic_statistics.retransmits;
+	slot->duplicates = ic_statistics.duplicatedPktNum;
+	slot->putRxBufferCount = ic_statistics.putRxBufferNum;
+	slot->putRxBufferTime = ic_statistics.putRxBufferTime;
+	slot->waitTime = ic_statistics.waitTime;
+
+	ICStatsEndUpdate(slot);
+}
+
 /*
  * logPkt
  * 		Log a packet.
@@ -4120,7 +4380,7 @@ handleAckedPacket(MotionConn *ackConn, ICBuffer *buf, uint64 now)
 
 	buf = icBufferListDelete(&ackConn->unackQueue, buf);
 
-	if (Gp_interconnect_fc_method == INTERCONNECT_FC_METHOD_LOSS)
+	if (FC_METHOD_USES_UNACK_RING())
 	{
 		buf = icBufferListDelete(&unack_queue_ring.slots[buf->unackQueueRingSlot], buf);
 		unack_queue_ring.numOutStanding--;
@@ -4157,6 +4417,9 @@ handleAckedPacket(MotionConn *ackConn, ICBuffer *buf, uint64 now)
 				else
 					snd_control_info.cwnd += 1 / snd_control_info.cwnd;
 				snd_control_info.cwnd = Min(snd_control_info.cwnd, snd_buffer_pool.maxCount);
+
+				if (FC_METHOD_IS_ADAPTIVE())
+					adaptiveCwndOnAck(buf->conn);
 			}
 		}
 	}
@@ -4553,6 +4816,77 @@ xmit_retry:
 	return;
 }
 
+/*
+ * sendBatch
+ * 		Send a batch of packets.
+ *
+ * When sendmmsg() is available, all packets of the batch are handed to the
+ * kernel with as few system calls as possible. A packet the kernel refuses
+ * is passed to sendOnce(), which knows how to handle the individual error
+ * cases, and so are the packets behind it.
+ */
+static void
+sendBatch(ChunkTransportState *transportStates, ChunkTransportStateEntry *pEntry, ICBuffer **bufs, int nbufs)
+{
+	int			i = 0;
+
+	Assert(nbufs <= MAX_MMSG_BATCH_SIZE);
+
+#ifdef HAVE_SENDMMSG
+	if (nbufs > 1
+#ifdef USE_ASSERT_CHECKING
+		/* packet dropping is injected in sendOnce() */
+		&& gp_udpic_dropxmit_percent == 0
+#endif
+		)
+	{
+		struct mmsghdr msgs[MAX_MMSG_BATCH_SIZE];
+		struct iovec iovs[MAX_MMSG_BATCH_SIZE];
+
+		memset(msgs, 0, sizeof(struct mmsghdr) * nbufs);
+		for (i = 0; i < nbufs; i++)
+		{
+			iovs[i].iov_base = bufs[i]->pkt;
+			iovs[i].iov_len = bufs[i]->pkt->len;
+			msgs[i].msg_hdr.msg_name = &bufs[i]->conn->peer;
+			msgs[i].msg_hdr.msg_namelen = bufs[i]->conn->peer_len;
+			msgs[i].msg_hdr.msg_iov = &iovs[i];
+			msgs[i].msg_hdr.msg_iovlen = 1;
+		}
+
+		i = 0;
+		while (i < nbufs)
+		{
+			int			n;
+			int			j;
+
+			n = sendmmsg(pEntry->txfd, &msgs[i], nbufs - i, 0);
+			if (n < 0)
+			{
+				if (errno == EINTR)
+					continue;
+
+				/* let sendOnce() deal with the failing packet */
+				break;
+			}
+
+			for (j = i; j < i + n; j++)
+			{
+				if (msgs[j].msg_len != bufs[j]->pkt->len && DEBUG1 >= log_min_messages)
+					write_log("Interconnect error writing an outgoing packet [seq %d]: short transmit (given %d sent %d) during sendmmsg() call."
+							  "For Remote Connection: contentId=%d at %s", bufs[j]->pkt->seq, bufs[j]->pkt->len, msgs[j].msg_len,
+							  bufs[j]->conn->remoteContentId,
+							  bufs[j]->conn->remoteHostAndPort);
+			}
+			i += n;
+		}
+	}
+#endif
+
+	for (; i < nbufs; i++)
+		sendOnce(transportStates, pEntry, bufs[i], bufs[i]->conn);
+}
+
 
 /*
  * handleStopMsgs
@@ -4658,27 +4992,50 @@ handleStopMsgs(ChunkTransportState *transportStates, ChunkTransportStateEntry *p
  *
  * After sending a buffer, the buffer will be placed into both the unack queue and
  * the corresponding queue in the unack queue ring.
+ *
+ * Up to gp_interconnect_mmsg_batch_size buffers are collected before they are
+ * handed to the kernel together by sendBatch().
  */
 static void
 sendBuffers(ChunkTransportState *transportStates, ChunkTransportStateEntry *pEntry, MotionConn *conn)
 {
+	ICBuffer   *batch[MAX_MMSG_BATCH_SIZE];
+	int			nbatch = 0;
+
 	while (conn->capacity > 0 && icBufferListLength(&conn->sndQueue) > 0)
 	{
 		ICBuffer   *buf = NULL;
+		uint64		now = getCurrentTime();
 
-		if (Gp_interconnect_fc_method == INTERCONNECT_FC_METHOD_LOSS &&
+		if (FC_METHOD_USES_UNACK_RING() &&
 			(icBufferListLength(&conn->unackQueue) > 0 &&
 			 unack_queue_ring.numSharedOutStanding >= (snd_control_info.cwnd - snd_control_info.minCwnd)))
 			break;
 
+		/*
+		 * With adaptive flow control, also respect the window of this
+		 * connection and the pacing gap. Both only apply when there is
+		 * something outstanding, so a later ack always restarts sending.
+		 */
+		if (FC_METHOD_IS_ADAPTIVE() && icBufferListLength(&conn->unackQueue) > 0)
+		{
+			if (icBufferListLength(&conn->unackQueue) >= (int) conn->cwnd)
+				break;
+
+			if (now < conn->nextSendTime)
+			{
+				conn->stat_count_paced++;
+				ic_statistics.pacedSends++;
+				break;
+			}
+		}
+
 		/* for connection setup, we only allow one outstanding packet. */
 		if (conn->state == mcsSetupOutgoingConnection && icBufferListLength(&conn->unackQueue) >= 1)
 			break;
 
 		buf = icBufferListPop(&conn->sndQueue);
 
-		uint64		now = getCurrentTime();
-
 		buf->sentTime = now;
 		buf->unackQueueRingSlot = -1;
 		buf->nRetry = 0;
@@ -4687,7 +5044,7 @@ sendBuffers(ChunkTransportState *transportStates, ChunkTransportStateEntry *pEnt
 
 		icBufferListAppend(&conn->unackQueue, buf);
 
-		if (Gp_interconnect_fc_method == INTERCONNECT_FC_METHOD_LOSS)
+		if (FC_METHOD_USES_UNACK_RING())
 		{
 			unack_queue_ring.numOutStanding++;
 			if (icBufferListLength(&conn->unackQueue) > 1)
@@ -4699,8 +5056,11 @@ sendBuffers(ChunkTransportState *transportStates, ChunkTransportStateEntry *pEnt
 								  now);
 		}
 
+		if (FC_METHOD_IS_ADAPTIVE())
+			conn->nextSendTime = now + adaptivePacingGap(conn);
+
 		/*
-		 * Note the place of sendOnce here. If we send before appending it to
+		 * Note the place of sendBatch here. If we send before appending it to
 		 * the unack queue and putting it into unack queue ring, and there is
 		 * a network error occurred in the sendOnce function, error message
 		 * will be output. In the time of error message output, interrupts is
@@ -4711,7 +5071,12 @@ sendBuffers(ChunkTransportState *transportStates, ChunkTransportStateEntry *pEnt
 		updateStats(TPE_DATA_PKT_SEND, conn, buf->pkt);
 #endif
 
-		sendOnce(transportStates, pEntry, buf, conn);
+		batch[nbatch++] = buf;
+		if (nbatch >= Gp_interconnect_mmsg_batch_size)
+		{
+			sendBatch(transportStates, pEntry, batch, nbatch);
+			nbatch = 0;
+		}
 		ic_statistics.sndPktNum++;
 
 #ifdef AMS_VERBOSE_LOGGING
@@ -4720,6 +5085,9 @@ sendBuffers(ChunkTransportState *transportStates, ChunkTransportStateEntry *pEnt
 
 		buf->conn->sentSeq = buf->pkt->seq;
 	}
+
+	if (nbatch > 0)
+		sendBatch(transportStates, pEntry, batch, nbatch);
 }
 
 /*
@@ -4863,7 +5231,7 @@ handleAckForDisorderPkt(ChunkTransportState *transportStates,
 			/* this is a lost packet, retransmit */
 
 			buf->nRetry++;
-			if (Gp_interconnect_fc_method == INTERCONNECT_FC_METHOD_LOSS)
+			if (FC_METHOD_USES_UNACK_RING())
 			{
 				buf = icBufferListDelete(&unack_queue_ring.slots[buf->unackQueueRingSlot], buf);
 				putIntoUnackQueueRing(&unack_queue_ring, buf,
@@ -4909,7 +5277,14 @@ handleAckForDisorderPkt(ChunkTransportState *transportStates,
 			lostPktCnt--;
 		}
 	}
-	if (Gp_interconnect_fc_method == INTERCONNECT_FC_METHOD_LOSS)
+
+	/*
+	 * The adaptive method only slows down the connection that reported the
+	 * loss, instead of every connection sharing the global window.
+	 */
+	if (FC_METHOD_IS_ADAPTIVE())
+		adaptiveCwndOnLoss(conn, pkt, now, false);
+	else if (FC_METHOD_USES_UNACK_RING())
 	{
 		snd_control_info.ssthresh = Max(snd_control_info.cwnd / 2, snd_control_info.minCwnd);
 		snd_control_info.cwnd = snd_control_info.ssthresh;
@@ -5049,6 +5424,9 @@ checkExpiration(ChunkTransportState *transportStates,
 
 			sendOnce(transportStates, pEntry, curBuf, curBuf->conn);
 
+			if (FC_METHOD_IS_ADAPTIVE())
+				adaptiveCwndOnLoss(curBuf->conn, curBuf->pkt, now, true);
+
 			retransmits++;
 			ic_statistics.retransmits++;
 			curBuf->conn->stat_count_resent++;
@@ -5075,7 +5453,16 @@ checkExpiration(ChunkTransportState *transportStates,
 	if (retransmits > 0)
 	{
 		snd_control_info.ssthresh = Max(snd_control_info.cwnd / 2, snd_control_info.minCwnd);
-		snd_control_info.cwnd = snd_control_info.minCwnd;
+
+		/*
+		 * Connections that timed out were already collapsed individually
+		 * above; only halve the shared window so that one congested receiver
+		 * (e.g. the QD under incast) does not stall all the others.
+		 */
+		if (FC_METHOD_IS_ADAPTIVE())
+			snd_control_info.cwnd = snd_control_info.ssthresh;
+		else
+			snd_control_info.cwnd = snd_control_info.minCwnd;
 	}
 }
 
@@ -5129,6 +5516,17 @@ checkDeadlock(ChunkTransportStateEntry *pEntry, MotionConn *conn)
 			ic_control_info.lastDeadlockCheckTime = now;
 			ic_statistics.statusQueryMsgNum++;
 
+			/*
+			 * The connection has been receiver limited for a long time, so
+			 * its window no longer reflects the network. Decay it instead of
+			 * bursting a full stale window once capacity comes back.
+			 */
+			if (FC_METHOD_IS_ADAPTIVE())
+			{
+				conn->ssthresh = Max(conn->ssthresh, conn->cwnd * 3 / 4);
+				conn->cwnd = Max(conn->cwnd / 2, ADAPTIVE_INITIAL_CWND);
+			}
+
 			/* check network error. */
 			if ((now - conn->deadlockCheckBeginTime) > ((uint64) Gp_interconnect_transmit_timeout * 1000 * 1000))
 			{
@@ -5155,7 +5553,10 @@ pollAcks(ChunkTransportState *transportStates, int fd, int timeout)
 	nfd.fd = fd;
 	nfd.events = POLLIN;
 
+	if (timeout != 0)
+		pgstat_report_wait_start(WAIT_EVENT_INTERCONNECT_SEND);
 	n = poll(&nfd, 1, timeout);
+	pgstat_report_wait_end();
 	if (n < 0)
 	{
 		ML_CHECK_FOR_INTERRUPTS(transportStates->teardownActive);
@@ -5247,7 +5648,7 @@ checkExceptions(ChunkTransportState *transportStates,
 		checkExpirationCapacityFC(transportStates, pEntry, conn, timeout);
 	}
 
-	if (Gp_interconnect_fc_method == INTERCONNECT_FC_METHOD_LOSS)
+	if (FC_METHOD_USES_UNACK_RING())
 	{
 		uint64		now = getCurrentTime();
 
@@ -5299,7 +5700,16 @@ computeTimeout(MotionConn *conn, int retry)
 	if (buf->nRetry == 0 && retry == 0)
 		return 0;
 
-	if (Gp_interconnect_fc_method == INTERCONNECT_FC_METHOD_LOSS)
+	/* wake up in time to send the next paced packet */
+	if (FC_METHOD_IS_ADAPTIVE() && icBufferListLength(&conn->sndQueue) > 0)
+	{
+		uint64		now = getCurrentTime();
+
+		if (conn->nextSendTime > now)
+			return Min(TIMER_CHECKING_PERIOD, (int) ((conn->nextSendTime - now) / 1000) + 1);
+	}
+
+	if (FC_METHOD_USES_UNACK_RING())
 		return TIMER_CHECKING_PERIOD;
 
 	/* for capacity based flow control */
@@ -5326,9 +5736,6 @@ SendChunkUDPIFC(MotionLayerState *mlStates,
 {
 
 	int			length = TYPEALIGN(TUPLE_CHUNK_ALIGN, tcItem->chunk_length);
-	int			retry = 0;
-	bool		doCheckExpiration = false;
-	bool		gotStops = false;
 
 	Assert(conn->msgSize > 0);
 
@@ -5346,6 +5753,39 @@ SendChunkUDPIFC(MotionLayerState *mlStates,
 		return true;
 	}
 
+	flushBufferUDPIFC(mlStates, transportStates, pEntry, conn, motionId);
+	if (!conn->stillActive)
+		return true;
+
+	/* now we can copy the input to the new buffer */
+	memcpy(conn->pBuff + conn->msgSize, tcItem->chunk_data, tcItem->chunk_length);
+	conn->msgSize += length;
+
+	conn->tupleCount++;
+
+	return true;
+}
+
+/*
+ * flushBufferUDPIFC
+ * 		Put the current buffer of a connection into its send queue and get
+ * 		a new, empty buffer for it.
+ *
+ * The connection may have become inactive on return, if a stop message was
+ * received in the mean time. The function always returns true: a stop
+ * message only ends the connection it was received for.
+ */
+static bool
+flushBufferUDPIFC(MotionLayerState *mlStates,
+				  ChunkTransportState *transportStates,
+				  ChunkTransportStateEntry *pEntry,
+				  MotionConn *conn,
+				  int16 motionId)
+{
+	int			retry = 0;
+	bool		doCheckExpiration = false;
+	bool		gotStops = false;
+
 	/* prepare this for transmit */
 
 	ic_statistics.totalCapacity += conn->capacity;
@@ -5360,6 +5800,8 @@ SendChunkUDPIFC(MotionLayerState *mlStates,
 
 	uint64		now = getCurrentTime();
 
+	publishICStats(transportStates, now, false);
+
 	if (Gp_interconnect_fc_method == INTERCONNECT_FC_METHOD_CAPACITY)
 		doCheckExpiration = false;
 	else
@@ -5391,6 +5833,10 @@ SendChunkUDPIFC(MotionLayerState *mlStates,
 		}
 		checkExceptions(transportStates, pEntry, conn, retry++, timeout);
 		doCheckExpiration = false;
+
+		/* packets held back by pacing are only sent when we come back here */
+		if (FC_METHOD_IS_ADAPTIVE() && icBufferListLength(&conn->sndQueue) > 0)
+			sendBuffers(transportStates, pEntry, conn);
 	}
 
 	conn->pBuff = (uint8 *) conn->curBuff->pkt;
@@ -5408,12 +5854,6 @@ SendChunkUDPIFC(MotionLayerState *mlStates,
 	conn->tupleCount = 0;
 	conn->msgSize = sizeof(conn->conn_info);
 
-	/* now we can copy the input to the new buffer */
-	memcpy(conn->pBuff + conn->msgSize, tcItem->chunk_data, tcItem->chunk_length);
-	conn->msgSize += length;
-
-	conn->tupleCount++;
-
 	return true;
 }
 
@@ -6100,10 +6540,132 @@ handleDataPacket(MotionConn *conn, icpkthdr *pkt, struct sockaddr_storage *peer,
 	return true;
 }
 
+/*
+ * handleRxPacket
+ * 		Process one packet read from the listener socket by the rx thread.
+ *
+ * Returns true if the packet buffer has been taken over (queued on a
+ * connection or cached), in which case the caller must not reuse it.
+ *
+ * NOTE: This function MUST NOT contain elog or ereport statements.
+ * elog is NOT thread-safe.  Developers should instead use something like:
+ *
+ *	if (DEBUG3 >= log_min_messages)
+ *		write_log("my brilliant log statement here.");
+ */
+static bool
+handleRxPacket(icpkthdr *pkt, int read_count, struct sockaddr_storage *peer, socklen_t peerlen)
+{
+	MotionConn *conn = NULL;
+	bool		consumed = false;
+	AckSendParam param;
+
+	if (DEBUG5 >= log_min_messages)
+		write_log("received inbound len %d", read_count);
+
+	if (read_count < sizeof(icpkthdr))
+	{
+		if (DEBUG1 >= log_min_messages)
+			write_log("Interconnect error: short conn receive (%d)", read_count);
+		return false;
+	}
+
+	/* length must be >= 0 */
+	if (pkt->len < 0)
+	{
+		if (DEBUG3 >= log_min_messages)
+			write_log("received inbound with negative length");
+		return false;
+	}
+
+	if (pkt->len != read_count)
+	{
+		if (DEBUG3 >= log_min_messages)
+			write_log("received inbound packet [%d], short: read %d bytes, pkt->len %d", pkt->seq, read_count, pkt->len);
+		return false;
+	}
+
+	/*
+	 * check the CRC of the payload.
+	 */
+	if (gp_interconnect_full_crc)
+	{
+		if (!checkCRC(pkt))
+		{
+			pg_atomic_add_fetch_u32((pg_atomic_uint32 *) &ic_statistics.crcErrors, 1);
+			if (DEBUG2 >= log_min_messages)
+				write_log("received network data error, dropping bad packet, user data unaffected.");
+			return false;
+		}
+	}
+
+#ifdef AMS_VERBOSE_LOGGING
+	logPkt("GOT MESSAGE", pkt);
+#endif
+
+	memset(&param, 0, sizeof(AckSendParam));
+
+	/*
+	 * Get the connection for the pkt.
+	 *
+	 * The connection hash table should be locked until finishing the
+	 * processing of the packet to avoid the connection addition/removal from
+	 * the hash table during the mean time.
+	 */
+
+	pthread_mutex_lock(&ic_control_info.lock);
+	conn = findConnByHeader(&ic_control_info.connHtab, pkt);
+
+	if (conn != NULL)
+	{
+		/* Handling a regular packet */
+		if (handleDataPacket(conn, pkt, peer, &peerlen, &param))
+			consumed = true;
+		ic_statistics.recvPktNum++;
+	}
+	else
+	{
+		/*
+		 * There may have two kinds of Mismatched packets: a) Past packets
+		 * from previous command after I was torn down b) Future packets from
+		 * current command before my connections are built.
+		 *
+		 * The handling logic is to "Ack the past and Nak the future".
+		 */
+		if ((pkt->flags & UDPIC_FLAGS_RECEIVER_TO_SENDER) == 0)
+		{
+			if (DEBUG1 >= log_min_messages)
+				write_log("mismatched packet received, seq %d, srcpid %d, dstpid %d, icid %d, sid %d", pkt->seq, pkt->srcPid, pkt->dstPid, pkt->icId, pkt->sessionId);
+
+#ifdef AMS_VERBOSE_LOGGING
+			logPkt("Got a Mismatched Packet", pkt);
+#endif
+
+			if (handleMismatch(pkt, peer, peerlen))
+				consumed = true;
+			ic_statistics.mismatchNum++;
+		}
+	}
+	pthread_mutex_unlock(&ic_control_info.lock);
+
+	/*
+	 * real ack sending is after lock release to decrease the lock holding
+	 * time.
+	 */
+	if (param.msg.len != 0)
+		sendAckWithParam(&param);
+
+	return consumed;
+}
+
 /*
  * rxThreadFunc
  * 		Main function of the receive background thread.
  *
+ * The thread keeps up to gp_interconnect_mmsg_batch_size receive buffers at
+ * hand, and drains as many packets as it has buffers for with a single
+ * recvmmsg() call when that is available.
+ *
  * NOTE: This function MUST NOT contain elog or ereport statements.
  * elog is NOT thread-safe.  Developers should instead use something like:
  *
@@ -6115,7 +6677,8 @@ handleDataPacket(MotionConn *conn, icpkthdr *pkt, struct sockaddr_storage *peer,
 static void *
 rxThreadFunc(void *arg)
 {
-	icpkthdr   *pkt = NULL;
+	icpkthdr   *pkts[MAX_MMSG_BATCH_SIZE];
+	int			npkts = 0;
 	bool		skip_poll = false;
 	uint32		expected = 1;
 
@@ -6125,6 +6688,7 @@ rxThreadFunc(void *arg)
 	{
 		struct pollfd nfd;
 		int			n;
+		int			batchSize;
 
 		/* check shutdown condition */
 		expected = 1;
@@ -6137,14 +6701,26 @@ rxThreadFunc(void *arg)
 			break;
 		}
 
-		/* Try to get a buffer */
-		if (pkt == NULL)
+		batchSize = Min(Max(Gp_interconnect_mmsg_batch_size, 1), MAX_MMSG_BATCH_SIZE);
+#ifndef HAVE_RECVMMSG
+		batchSize = 1;
+#endif
+
+		/* Try to get buffers */
+		if (npkts < batchSize)
 		{
 			pthread_mutex_lock(&ic_control_info.lock);
-			pkt = getRxBuffer(&rx_buffer_pool);
+			while (npkts < batchSize)
+			{
+				icpkthdr   *pkt = getRxBuffer(&rx_buffer_pool);
+
+				if (pkt == NULL)
+					break;
+				pkts[npkts++] = pkt;
+			}
 			pthread_mutex_unlock(&ic_control_info.lock);
 
-			if (pkt == NULL)
+			if (npkts == 0)
 			{
 				setRxThreadError(ENOMEM);
 				continue;
@@ -6195,15 +6771,45 @@ rxThreadFunc(void *arg)
 			/* we've got something interesting to read */
 			/* handle incoming */
 			/* ready to read on our socket */
-			MotionConn *conn = NULL;
-			int			read_count = 0;
+			struct sockaddr_storage peers[MAX_MMSG_BATCH_SIZE];
+			socklen_t	peerlens[MAX_MMSG_BATCH_SIZE];
+			int			read_counts[MAX_MMSG_BATCH_SIZE];
+			int			nread = 0;
+			int			nkept = 0;
+			int			i;
+
+#ifdef HAVE_RECVMMSG
+			if (npkts > 1)
+			{
+				struct mmsghdr msgs[MAX_MMSG_BATCH_SIZE];
+				struct iovec iovs[MAX_MMSG_BATCH_SIZE];
 
-			struct sockaddr_storage peer;
-			socklen_t	peerlen;
+				memset(msgs, 0, sizeof(struct mmsghdr) * npkts);
+				for (i = 0; i < npkts; i++)
+				{
+					iovs[i].iov_base = (char *) pkts[i];
+					iovs[i].iov_len = Gp_max_packet_size;
+					msgs[i].msg_hdr.msg_name = &peers[i];
+					msgs[i].msg_hdr.msg_namelen = sizeof(peers[i]);
+					msgs[i].msg_hdr.msg_iov = &iovs[i];
+					msgs[i].msg_hdr.msg_iovlen = 1;
+				}
 
-			peerlen = sizeof(peer);
-			read_count = recvfrom(UDP_listenerFd, (char *) pkt, Gp_max_packet_size, 0,
-								  (struct sockaddr *) &peer, &peerlen);
+				nread = recvmmsg(UDP_listenerFd, msgs, npkts, MSG_DONTWAIT, NULL);
+				for (i = 0; i < nread; i++)
+				{
+					read_counts[i] = msgs[i].msg_len;
+					peerlens[i] = msgs[i].msg_hdr.msg_namelen;
+				}
+			}
+			else
+#endif
+			{
+				peerlens[0] = sizeof(peers[0]);
+				read_counts[0] = recvfrom(UDP_listenerFd, (char *) pkts[0], Gp_max_packet_size, 0,
+										  (struct sockaddr *) &peers[0], &peerlens[0]);
+				nread = (read_counts[0] < 0 ? -1 : 1);
+			}
 
 			expected = 1;
 			if (pg_atomic_compare_exchange_u32((pg_atomic_uint32 *) &ic_control_info.shutdown, &expected, 0))
@@ -6215,10 +6821,7 @@ rxThreadFunc(void *arg)
 				break;
 			}
 
-			if (DEBUG5 >= log_min_messages)
-				write_log("received inbound len %d", read_count);
-
-			if (read_count < 0)
+			if (nread < 0)
 			{
 				skip_poll = false;
 
@@ -6239,117 +6842,36 @@ rxThreadFunc(void *arg)
 				continue;
 			}
 
-			if (read_count < sizeof(icpkthdr))
-			{
-				if (DEBUG1 >= log_min_messages)
-					write_log("Interconnect error: short conn receive (%d)", read_count);
-				continue;
-			}
-
 			/*
 			 * when we get a "good" recvfrom() result, we can skip poll()
 			 * until we get a bad one.
 			 */
 			skip_poll = true;
 
-			/* length must be >= 0 */
-			if (pkt->len < 0)
-			{
-				if (DEBUG3 >= log_min_messages)
-					write_log("received inbound with negative length");
-				continue;
-			}
-
-			if (pkt->len != read_count)
-			{
-				if (DEBUG3 >= log_min_messages)
-					write_log("received inbound packet [%d], short: read %d bytes, pkt->len %d", pkt->seq, read_count, pkt->len);
-				continue;
-			}
-
 			/*
-			 * check the CRC of the payload.
+			 * Hand the packets over; the buffers which have not been taken
+			 * over are moved to the front of the array to be reused.
 			 */
-			if (gp_interconnect_full_crc)
+			for (i = 0; i < npkts; i++)
 			{
-				if (!checkCRC(pkt))
-				{
-					pg_atomic_add_fetch_u32((pg_atomic_uint32 *) &ic_statistics.crcErrors, 1);
-					if (DEBUG2 >= log_min_messages)
-						write_log("received network data error, dropping bad packet, user data unaffected.");
+				if (i < nread &&
+					handleRxPacket(pkts[i], read_counts[i], &peers[i], peerlens[i]))
 					continue;
-				}
-			}
-
-#ifdef AMS_VERBOSE_LOGGING
-			logPkt("GOT MESSAGE", pkt);
-#endif
-
-			AckSendParam param;
-
-			memset(&param, 0, sizeof(AckSendParam));
-
-			/*
-			 * Get the connection for the pkt.
-			 *
-			 * The connection hash table should be locked until finishing the
-			 * processing of the packet to avoid the connection
-			 * addition/removal from the hash table during the mean time.
-			 */
 
-			pthread_mutex_lock(&ic_control_info.lock);
-			conn = findConnByHeader(&ic_control_info.connHtab, pkt);
-
-			if (conn != NULL)
-			{
-				/* Handling a regular packet */
-				if (handleDataPacket(conn, pkt, &peer, &peerlen, &param))
-					pkt = NULL;
-				ic_statistics.recvPktNum++;
+				pkts[nkept++] = pkts[i];
 			}
-			else
-			{
-				/*
-				 * There may have two kinds of Mismatched packets: a) Past
-				 * packets from previous command after I was torn down b)
-				 * Future packets from current command before my connections
-				 * are built.
-				 *
-				 * The handling logic is to "Ack the past and Nak the future".
-				 */
-				if ((pkt->flags & UDPIC_FLAGS_RECEIVER_TO_SENDER) == 0)
-				{
-					if (DEBUG1 >= log_min_messages)
-						write_log("mismatched packet received, seq %d, srcpid %d, dstpid %d, icid %d, sid %d", pkt->seq, pkt->srcPid, pkt->dstPid, pkt->icId, pkt->sessionId);
-
-#ifdef AMS_VERBOSE_LOGGING
-					logPkt("Got a Mismatched Packet", pkt);
-#endif
-
-					if (handleMismatch(pkt, &peer, peerlen))
-						pkt = NULL;
-					ic_statistics.mismatchNum++;
-				}
-			}
-			pthread_mutex_unlock(&ic_control_info.lock);
-
-			/*
-			 * real ack sending is after lock release to decrease the lock
-			 * holding time.
-			 */
-			if (param.msg.len != 0)
-				sendAckWithParam(&param);
+			npkts = nkept;
 		}
 
 		/* pthread_yield(); */
 	}
 
-	/* Before return, we release the packet. */
-	if (pkt)
+	/* Before return, we release the packets. */
+	if (npkts > 0)
 	{
 		pthread_mutex_lock(&ic_control_info.lock);
-		freeRxBuffer(&rx_buffer_pool, pkt);
-		pkt = NULL;
+		while (npkts > 0)
+			freeRxBuffer(&rx_buffer_pool, pkts[--npkts]);
 		pthread_mutex_unlock(&ic_control_info.lock);
 	}
 
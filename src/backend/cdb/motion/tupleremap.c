@@ -126,6 +126,8 @@ struct TupleRemapper
 	int			typmodmapsize;	/* size of typmodmap */
 	TupleDesc	tupledesc;		/* current top-level tuple descriptor */
 	TupleRemapInfo **field_remapinfo;	/* current top-level remap info */
+	bool		field_remapinfo_valid;	/* has field_remapinfo been built? */
+	MemTupleBinding *mt_bind;	/* binding for memtuples of tupledesc */
 	bool		remap_needed;	/* is remap needed */
 };
 
@@ -168,6 +170,8 @@ CreateTupleRemapper(void)
 	remapper->typmodmapsize = 0;
 	remapper->tupledesc = NULL;
 	remapper->field_remapinfo = NULL;
+	remapper->field_remapinfo_valid = false;
+	remapper->mt_bind = NULL;
 	remapper->remap_needed = false;
 
 	return remapper;
@@ -198,17 +202,47 @@ TRCheckAndRemap(TupleRemapper *remapper, TupleDesc tupledesc, HeapTuple tuple)
 	if (!remapper->remap_needed)
 		return tuple;
 
-	if (!remapper->field_remapinfo)
+	if (!remapper->field_remapinfo_valid)
 	{
 		Assert(remapper->tupledesc == NULL);
 		remapper->tupledesc = tupledesc;
 		remapper->field_remapinfo = BuildFieldRemapInfo(tupledesc,
 														remapper->mycontext);
+		remapper->field_remapinfo_valid = true;
 	}
 
+	/*
+	 * Fast path: no attribute of this row type can contain a transient
+	 * record, so the typmod map does not matter to it.
+	 */
+	if (remapper->field_remapinfo == NULL)
+		return tuple;
+
+	Assert(tupledesc == remapper->tupledesc);
+
 	return TRRemapTuple(remapper, tupledesc, remapper->field_remapinfo, tuple);
 }
 
+/*
+ * Could tuples of the given descriptor contain transient record typmods?
+ *
+ * Senders use this to decide whether the record cache needs to be sent
+ * ahead of their tuples at all.
+ */
+bool
+TRTupleDescNeedsRemap(TupleDesc tupledesc)
+{
+	TupleRemapInfo **remapinfo;
+
+	remapinfo = BuildFieldRemapInfo(tupledesc, CurrentMemoryContext);
+	if (remapinfo == NULL)
+		return false;
+
+	/* Any substructure is left to the caller's memory context. */
+	pfree(remapinfo);
+	return true;
+}
+
 /*
  * Handle the record type cache from motion sender.
  *
@@ -284,9 +318,17 @@ TRRemapTuple(TupleRemapper *remapper,
 	/* CDB */
 	if (is_heaptuple_memtuple(tuple))
 	{
-		MemTupleBinding *pbind = create_memtuple_binding(tupledesc);
+		/* Only top-level tuples can be memtuples */
+		Assert(tupledesc == remapper->tupledesc);
+
+		if (remapper->mt_bind == NULL)
+		{
+			MemoryContext oldcontext = MemoryContextSwitchTo(remapper->mycontext);
 
-		memtuple_deform((MemTuple) tuple, pbind, values, isnull);
+			remapper->mt_bind = create_memtuple_binding(tupledesc);
+			MemoryContextSwitchTo(oldcontext);
+		}
+		memtuple_deform((MemTuple) tuple, remapper->mt_bind, values, isnull);
 	}
 	else
 	{
@@ -303,9 +345,12 @@ TRRemapTuple(TupleRemapper *remapper,
 
 	/* Reconstruct the modified tuple, if anything was modified. */
 	if (changed)
-		return heap_form_tuple(tupledesc, values, isnull);
-	else
-		return tuple;
+		tuple = heap_form_tuple(tupledesc, values, isnull);
+
+	pfree(values);
+	pfree(isnull);
+
+	return tuple;
 }
 
 /*
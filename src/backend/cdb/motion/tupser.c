@@ -26,6 +26,7 @@
 #include "utils/acl.h"
 #include "utils/date.h"
 #include "utils/numeric.h"
+#include "utils/pg_lzcompress.h"
 #include "utils/memutils.h"
 #include "utils/builtins.h"
 #include "utils/syscache.h"
@@ -45,6 +46,14 @@
 #define RECORD_CACHE_MAGIC_NATTS	0xffff
 #define RECORD_CACHE_MAGIC_INFOMASK	0xffff
 
+/*
+ * Tuples compressed by CompressTupleChunkList() are sent as a header with
+ * below magic attributes, followed by the pglz-compressed serialized form of
+ * the original tuple.
+ */
+#define COMPRESSED_TUPLE_MAGIC_NATTS	0xfffe
+#define COMPRESSED_TUPLE_MAGIC_INFOMASK	0xffff
+
 /* A MemoryContext used within the tuple serialize code, so that freeing of
  * space is SUPAFAST.  It is initialized in the first call to InitSerTupInfo()
  * since that must be called before any tuple serialization or deserialization
@@ -53,6 +62,7 @@
 static MemoryContext s_tupSerMemCtxt = NULL;
 
 static void addByteStringToChunkList(TupleChunkList tcList, char *data, int datalen, TupleChunkListCache *cache);
+static HeapTuple CvtSerializedDataToHeapTup(StringInfo serData, SerTupInfo *pSerInfo, TupleRemapper *remapper);
 
 #define addCharToChunkList(tcList, x, c)							\
 	do															\
@@ -161,13 +171,6 @@ InitSerTupInfo(TupleDesc tupdesc, SerTupInfo *pSerInfo)
 				elog(ERROR, "cache lookup failed for type %u", attrInfo->atttypid);
 			pt = (Form_pg_type) GETSTRUCT(typeTuple);
 
-			/*
-			 * Consider any non-basic types as potential containers of record
-			 * types
-			 */
-			if (pt->typtype != TYPTYPE_BASE)
-				pSerInfo->has_record_types = true;
-
 			if (!pt->typisdefined)
 				ereport(ERROR,
 						(errcode(ERRCODE_UNDEFINED_OBJECT),
@@ -180,6 +183,12 @@ InitSerTupInfo(TupleDesc tupdesc, SerTupInfo *pSerInfo)
 			ReleaseSysCache(typeTuple);
 		}
 	}
+
+	/*
+	 * Only attributes that can contain records need the record cache to be
+	 * sent ahead of the tuples.
+	 */
+	pSerInfo->has_record_types = TRTupleDescNeedsRemap(tupdesc);
 }
 
 
@@ -615,6 +624,202 @@ SerializeTupleIntoChunks(HeapTuple tuple, SerTupInfo *pSerInfo, TupleChunkList t
 	return;
 }
 
+/*
+ * Replace the contents of a chunk list built by SerializeTupleIntoChunks()
+ * with a compressed version of it.
+ *
+ * Returns false, leaving the chunk list alone, if the data doesn't compress.
+ */
+bool
+CompressTupleChunkList(TupleChunkList tcList, SerTupInfo *pSerInfo)
+{
+	TupleChunkListItem tcItem;
+	TupleChunkType tcType;
+	TupSerHeader tsh;
+	MemoryContext oldCtxt;
+	int			rawlen = tcList->serialized_data_length;
+	int			pos = 0;
+	int			complen = 0;
+	char	   *raw;
+	PGLZ_Header *lz;
+
+	AssertArg(tcList != NULL);
+	AssertArg(tcList->p_first != NULL);
+	AssertArg(pSerInfo != NULL);
+
+	GetChunkType(tcList->p_first, &tcType);
+	if (tcType == TC_EMPTY)
+		return false;
+
+	AssertState(s_tupSerMemCtxt != NULL);
+
+	oldCtxt = MemoryContextSwitchTo(s_tupSerMemCtxt);
+	raw = palloc(rawlen);
+	lz = palloc(PGLZ_MAX_OUTPUT(rawlen));
+	MemoryContextSwitchTo(oldCtxt);
+
+	/* Gather the serialized tuple, without the chunk headers. */
+	for (tcItem = tcList->p_first; tcItem != NULL; tcItem = tcItem->p_next)
+	{
+		memcpy(raw + pos, tcItem->chunk_data + TUPLE_CHUNK_HEADER_SIZE,
+			   tcItem->chunk_length - TUPLE_CHUNK_HEADER_SIZE);
+		pos += tcItem->chunk_length - TUPLE_CHUNK_HEADER_SIZE;
+	}
+	Assert(pos == rawlen);
+
+	if (!pglz_compress(raw, rawlen, lz, PGLZ_strategy_always) ||
+		(complen = VARSIZE(lz)) + sizeof(TupSerHeader) >= rawlen)
+	{
+		MemoryContextReset(s_tupSerMemCtxt);
+		return false;
+	}
+
+	clearTCList(&pSerInfo->chunkCache, tcList);
+
+	tcItem = getChunkFromCache(&pSerInfo->chunkCache);
+	if (tcItem == NULL)
+	{
+		ereport(FATAL, (errcode(ERRCODE_OUT_OF_MEMORY),
+						errmsg("Could not allocate space for first chunk item in new chunk list.")));
+	}
+
+	/* assume that we'll take a single chunk */
+	SetChunkType(tcItem->chunk_data, TC_WHOLE);
+	tcItem->chunk_length = TUPLE_CHUNK_HEADER_SIZE;
+	appendChunkToTCList(tcList, tcItem);
+
+	tsh.tuplen = sizeof(TupSerHeader) + complen;
+	tsh.natts = COMPRESSED_TUPLE_MAGIC_NATTS;
+	tsh.infomask = COMPRESSED_TUPLE_MAGIC_INFOMASK;
+
+	addByteStringToChunkList(tcList, (char *) &tsh, sizeof(TupSerHeader), &pSerInfo->chunkCache);
+	addByteStringToChunkList(tcList, (char *) lz, complen, &pSerInfo->chunkCache);
+	addPadding(tcList, &pSerInfo->chunkCache, complen);
+
+	MemoryContextReset(s_tupSerMemCtxt);
+
+	/*
+	 * if we have more than 1 chunk we have to set the chunk types on our
+	 * first chunk and last chunk
+	 */
+	if (tcList->num_chunks > 1)
+	{
+		SetChunkType(tcList->p_first->chunk_data, TC_PARTIAL_START);
+		SetChunkType(tcList->p_last->chunk_data, TC_PARTIAL_END);
+	}
+
+	return true;
+}
+
+/*
+ * Serialize a HeapTuple, compressing it if asked to and it helps, and append
+ * the result to a flat buffer instead of a chunk list.  The bytes are the
+ * same ones that travel over the interconnect, less the chunk headers, and
+ * DeserializeTupleFromBuffer() turns them back into a tuple.
+ *
+ * This is for shipping tuples through channels other than the interconnect,
+ * such as the binary external table formatter.  The tuple descriptor must
+ * not contain record types, as there is no remapper on the other end.
+ */
+void
+SerializeTupleIntoBuffer(HeapTuple tuple, SerTupInfo *pSerInfo, bool compress, StringInfo buf)
+{
+	TupleChunkListData tcList;
+	TupleChunkListItem tcItem;
+
+	AssertArg(pSerInfo != NULL);
+	AssertArg(!pSerInfo->has_record_types);
+	AssertArg(buf != NULL);
+
+	SerializeTupleIntoChunks(tuple, pSerInfo, &tcList);
+	if (compress)
+		CompressTupleChunkList(&tcList, pSerInfo);
+
+	/* a TC_EMPTY tuple has no data, and comes out as zero bytes */
+	for (tcItem = tcList.p_first; tcItem != NULL; tcItem = tcItem->p_next)
+		appendBinaryStringInfo(buf,
+							   (const char *) GetChunkDataPtr(tcItem) + TUPLE_CHUNK_HEADER_SIZE,
+							   tcItem->chunk_length - TUPLE_CHUNK_HEADER_SIZE);
+
+	clearTCList(&pSerInfo->chunkCache, &tcList);
+}
+
+/*
+ * Convert the output of SerializeTupleIntoBuffer() back into a HeapTuple.
+ *
+ * Unlike the interconnect, the data may come from outside, so it is checked
+ * for being long enough to hold what its header claims.
+ */
+HeapTuple
+DeserializeTupleFromBuffer(SerTupInfo *pSerInfo, const char *data, int len)
+{
+	StringInfoData serData;
+	const TupSerHeader *tshp = (const TupSerHeader *) data;
+	uint32		tuplen;
+
+	AssertArg(pSerInfo != NULL);
+
+	if (len == 0)
+		return heap_form_tuple(pSerInfo->tupdesc, pSerInfo->values, pSerInfo->nulls);
+
+	if (len < sizeof(TupSerHeader))
+		ereport(ERROR,
+				(errcode(ERRCODE_INVALID_BINARY_REPRESENTATION),
+				 errmsg("serialized tuple too short: %d bytes", len)));
+
+	if (tshp->tuplen & MEMTUP_LEAD_BIT)
+		tuplen = memtuple_size_from_uint32(tshp->tuplen);
+	else
+		tuplen = tshp->tuplen;
+	if (tuplen > len)
+		ereport(ERROR,
+				(errcode(ERRCODE_INVALID_BINARY_REPRESENTATION),
+				 errmsg("serialized tuple length %u exceeds the %d bytes received",
+						tuplen, len)));
+
+	/* the converter wants its own, aligned, copy to own and free */
+	initStringInfoOfSize(&serData, len + 1);
+	appendBinaryStringInfo(&serData, data, len);
+
+	return CvtSerializedDataToHeapTup(&serData, pSerInfo, NULL);
+}
+
+/*
+ * Compute the number of bytes, including the tuple-chunk-header, that
+ * SerializeTupleDirect() needs to serialize a tuple.
+ *
+ * Returns 0 if the tuple can't be serialized directly at all.
+ */
+int
+SerializeTupleDirectSize(HeapTuple tuple, SerTupInfo *pSerInfo)
+{
+	HeapTupleHeader t_data;
+	unsigned int nullslen;
+
+	AssertArg(tuple != NULL);
+	AssertArg(pSerInfo != NULL);
+
+	if (pSerInfo->tupdesc->natts == 0)
+		return TUPLE_CHUNK_HEADER_SIZE;
+
+	if (is_heaptuple_memtuple(tuple))
+		return TUPLE_CHUNK_HEADER_SIZE +
+			TYPEALIGN(TUPLE_CHUNK_ALIGN, memtuple_get_size((MemTuple) tuple));
+
+	t_data = tuple->t_data;
+	if ((t_data->t_infomask & HEAP_HASEXTERNAL) != 0)
+		return 0;
+
+	if (HeapTupleHasNulls(tuple))
+		nullslen = BITMAPLEN(HeapTupleHeaderGetNatts(t_data));
+	else
+		nullslen = 0;
+
+	return TUPLE_CHUNK_HEADER_SIZE + sizeof(TupSerHeader) +
+		TYPEALIGN(TUPLE_CHUNK_ALIGN, nullslen) +
+		TYPEALIGN(TUPLE_CHUNK_ALIGN, tuple->t_len - t_data->t_hoff);
+}
+
 /*
  * Serialize a tuple directly into a buffer.
  *
@@ -953,128 +1158,183 @@ CvtChunksToHeapTup(TupleChunkList tcList, SerTupInfo *pSerInfo, TupleRemapper *r
 	/* we've finished with the TCList, free it now. */
 	clearTCList(NULL, tcList);
 
-	{
-		TupSerHeader *tshp;
-		unsigned int datalen;
-		unsigned int nullslen;
-		unsigned int hoff;
-		HeapTupleHeader t_data;
-		char	   *pos = (char *) serData.data;
+	return CvtSerializedDataToHeapTup(&serData, pSerInfo, remapper);
+}
 
+/*
+ * Convert the flattened serialized form of a tuple, as produced by
+ * SerializeTupleIntoChunks() less the chunk headers, into a HeapTuple.
+ * Takes ownership of serData->data, and frees it.
+ *
+ * Returns NULL if it was the special record-cache tuple, which has been
+ * handed to the remapper.
+ */
+static HeapTuple
+CvtSerializedDataToHeapTup(StringInfo serData, SerTupInfo *pSerInfo, TupleRemapper *remapper)
+{
+	HeapTuple	htup;
+	TupSerHeader *tshp;
+	unsigned int datalen;
+	unsigned int nullslen;
+	unsigned int hoff;
+	HeapTupleHeader t_data;
+	char	   *pos = (char *) serData->data;
+
+	tshp = (TupSerHeader *) pos;
+
+	if (!(tshp->tuplen & MEMTUP_LEAD_BIT) &&
+		tshp->natts == COMPRESSED_TUPLE_MAGIC_NATTS &&
+		tshp->infomask == COMPRESSED_TUPLE_MAGIC_INFOMASK)
+	{
+		/* a compressed tuple, see CompressTupleChunkList() */
+		PGLZ_Header *lz = (PGLZ_Header *) (pos + sizeof(TupSerHeader));
+		int32		rawlen;
+		char	   *raw;
+
+		if (tshp->tuplen < sizeof(TupSerHeader) + sizeof(PGLZ_Header) ||
+			tshp->tuplen > serData->len ||
+			VARSIZE(lz) != tshp->tuplen - sizeof(TupSerHeader))
+			ereport(ERROR, (errcode(ERRCODE_GP_INTERCONNECTION_ERROR),
+							errmsg("Interconnect error: cannot convert chunks to a  heap tuple."),
+							errdetail("invalid compressed tuple of length %d", tshp->tuplen)));
+
+		rawlen = PGLZ_RAW_SIZE(lz);
+		raw = palloc(rawlen + 1);
+		pglz_decompress(lz, raw);
+		raw[rawlen] = '\0';
+
+		pSerInfo->recv_compressed_tuples++;
+		pSerInfo->recv_compressed_bytes += tshp->tuplen;
+		pSerInfo->recv_decompressed_bytes += rawlen;
+
+		pfree(serData->data);
+		serData->data = raw;
+		serData->len = rawlen;
+		serData->maxlen = rawlen + 1;
+		serData->cursor = 0;
+
+		pos = serData->data;
 		tshp = (TupSerHeader *) pos;
+	}
 
-		if (!(tshp->tuplen & MEMTUP_LEAD_BIT) &&
-			tshp->natts == RECORD_CACHE_MAGIC_NATTS &&
-			tshp->infomask == RECORD_CACHE_MAGIC_INFOMASK)
-		{
-			uint32		tuplen = tshp->tuplen & ~MEMTUP_LEAD_BIT;
+	if (!(tshp->tuplen & MEMTUP_LEAD_BIT) &&
+		tshp->natts == RECORD_CACHE_MAGIC_NATTS &&
+		tshp->infomask == RECORD_CACHE_MAGIC_INFOMASK)
+	{
+		uint32		tuplen = tshp->tuplen & ~MEMTUP_LEAD_BIT;
 
-			/* a special tuple with record type cache */
-			List	   *typelist = (List *) deserializeNode(pos + sizeof(TupSerHeader),
-															tuplen - sizeof(TupSerHeader));
+		List	   *typelist;
 
-			TRHandleTypeLists(remapper, typelist);
+		if (remapper == NULL)
+			ereport(ERROR,
+					(errcode(ERRCODE_INVALID_BINARY_REPRESENTATION),
+					 errmsg("unexpected record type cache in serialized tuple data")));
 
-			/* Free up memory we used. */
-			pfree(serData.data);
+		/* a special tuple with record type cache */
+		typelist = (List *) deserializeNode(pos + sizeof(TupSerHeader),
+											tuplen - sizeof(TupSerHeader));
 
-			return NULL;
-		}
+		TRHandleTypeLists(remapper, typelist);
 
-		if ((tshp->tuplen & MEMTUP_LEAD_BIT) != 0)
-		{
-			uint32		tuplen = memtuple_size_from_uint32(tshp->tuplen);
+		/* Free up memory we used. */
+		pfree(serData->data);
 
-			htup = (HeapTuple) palloc(tuplen);
-			memcpy(htup, pos, tuplen);
+		return NULL;
+	}
 
-			pos += TYPEALIGN(TUPLE_CHUNK_ALIGN, tuplen);
-		}
-		else
-		{
-			pos += sizeof(TupSerHeader);
+	if ((tshp->tuplen & MEMTUP_LEAD_BIT) != 0)
+	{
+		uint32		tuplen = memtuple_size_from_uint32(tshp->tuplen);
 
-			/*
-			 * if the tuple had toasted elements we have to deserialize the
-			 * old slow way.
-			 */
-			if ((tshp->infomask & HEAP_HASEXTERNAL) != 0)
-			{
-				serData.cursor += sizeof(TupSerHeader);
+		htup = (HeapTuple) palloc(tuplen);
+		memcpy(htup, pos, tuplen);
 
-				htup = DeserializeTuple(pSerInfo, &serData);
+		pos += TYPEALIGN(TUPLE_CHUNK_ALIGN, tuplen);
+	}
+	else
+	{
+		pos += sizeof(TupSerHeader);
 
-				/* Free up memory we used. */
-				pfree(serData.data);
-				return htup;
-			}
+		/*
+		 * if the tuple had toasted elements we have to deserialize the
+		 * old slow way.
+		 */
+		if ((tshp->infomask & HEAP_HASEXTERNAL) != 0)
+		{
+			serData->cursor += sizeof(TupSerHeader);
 
-			/* reconstruct lengths of null bitmap and data part */
-			if (tshp->infomask & HEAP_HASNULL)
-				nullslen = BITMAPLEN(tshp->natts);
-			else
-				nullslen = 0;
+			htup = DeserializeTuple(pSerInfo, serData);
 
-			if (tshp->tuplen < sizeof(TupSerHeader) + nullslen)
-				ereport(ERROR, (errcode(ERRCODE_GP_INTERCONNECTION_ERROR),
-								errmsg("Interconnect error: cannot convert chunks to a  heap tuple."),
-								errdetail("tuple len %d < nullslen %d + headersize (%d)",
-										  tshp->tuplen, nullslen, (int) sizeof(TupSerHeader))));
+			/* Free up memory we used. */
+			pfree(serData->data);
+			return htup;
+		}
 
-			datalen = tshp->tuplen - sizeof(TupSerHeader) - TYPEALIGN(TUPLE_CHUNK_ALIGN, nullslen);
+		/* reconstruct lengths of null bitmap and data part */
+		if (tshp->infomask & HEAP_HASNULL)
+			nullslen = BITMAPLEN(tshp->natts);
+		else
+			nullslen = 0;
 
-			/* determine overhead size of tuple (should match heap_form_tuple) */
-			hoff = offsetof(HeapTupleHeaderData, t_bits) + TYPEALIGN(TUPLE_CHUNK_ALIGN, nullslen);
-			if (tshp->infomask & HEAP_HASOID)
-				hoff += sizeof(Oid);
-			hoff = MAXALIGN(hoff);
+		if (tshp->tuplen < sizeof(TupSerHeader) + nullslen)
+			ereport(ERROR, (errcode(ERRCODE_GP_INTERCONNECTION_ERROR),
+							errmsg("Interconnect error: cannot convert chunks to a  heap tuple."),
+							errdetail("tuple len %d < nullslen %d + headersize (%d)",
+									  tshp->tuplen, nullslen, (int) sizeof(TupSerHeader))));
 
-			/* Allocate the space in one chunk, like heap_form_tuple */
-			htup = (HeapTuple) palloc(HEAPTUPLESIZE + hoff + datalen);
+		datalen = tshp->tuplen - sizeof(TupSerHeader) - TYPEALIGN(TUPLE_CHUNK_ALIGN, nullslen);
 
-			t_data = (HeapTupleHeader) ((char *) htup + HEAPTUPLESIZE);
+		/* determine overhead size of tuple (should match heap_form_tuple) */
+		hoff = offsetof(HeapTupleHeaderData, t_bits) + TYPEALIGN(TUPLE_CHUNK_ALIGN, nullslen);
+		if (tshp->infomask & HEAP_HASOID)
+			hoff += sizeof(Oid);
+		hoff = MAXALIGN(hoff);
 
-			/* make sure unused header fields are zeroed */
-			MemSetAligned(t_data, 0, hoff);
+		/* Allocate the space in one chunk, like heap_form_tuple */
+		htup = (HeapTuple) palloc(HEAPTUPLESIZE + hoff + datalen);
 
-			/* reconstruct the HeapTupleData fields */
-			htup->t_len = hoff + datalen;
-			ItemPointerSetInvalid(&(htup->t_self));
-			htup->t_data = t_data;
+		t_data = (HeapTupleHeader) ((char *) htup + HEAPTUPLESIZE);
 
-			/* reconstruct the HeapTupleHeaderData fields */
-			ItemPointerSetInvalid(&(t_data->t_ctid));
-			HeapTupleHeaderSetNatts(t_data, tshp->natts);
-			t_data->t_infomask = tshp->infomask & ~HEAP_XACT_MASK;
-			t_data->t_infomask |= HEAP_XMIN_INVALID | HEAP_XMAX_INVALID;
-			t_data->t_hoff = hoff;
+		/* make sure unused header fields are zeroed */
+		MemSetAligned(t_data, 0, hoff);
 
-			if (nullslen)
-			{
-				memcpy((void *) t_data->t_bits, pos, nullslen);
-				pos += TYPEALIGN(TUPLE_CHUNK_ALIGN, nullslen);
-			}
+		/* reconstruct the HeapTupleData fields */
+		htup->t_len = hoff + datalen;
+		ItemPointerSetInvalid(&(htup->t_self));
+		htup->t_data = t_data;
 
-			/*
-			 * does the tuple descriptor expect an OID ? Note: we don't have
-			 * to set the oid itself, just the flag! (see heap_formtuple())
-			 */
-			if (pSerInfo->tupdesc->tdhasoid)	/* else leave infomask = 0 */
-			{
-				t_data->t_infomask |= HEAP_HASOID;
-			}
+		/* reconstruct the HeapTupleHeaderData fields */
+		ItemPointerSetInvalid(&(t_data->t_ctid));
+		HeapTupleHeaderSetNatts(t_data, tshp->natts);
+		t_data->t_infomask = tshp->infomask & ~HEAP_XACT_MASK;
+		t_data->t_infomask |= HEAP_XMIN_INVALID | HEAP_XMAX_INVALID;
+		t_data->t_hoff = hoff;
 
-			/*
-			 * and now the data proper (it would be nice if we could just
-			 * point our caller into our existing buffer in-place, but we'll
-			 * leave that for another day)
-			 */
-			memcpy((char *) t_data + hoff, pos, datalen);
+		if (nullslen)
+		{
+			memcpy((void *) t_data->t_bits, pos, nullslen);
+			pos += TYPEALIGN(TUPLE_CHUNK_ALIGN, nullslen);
+		}
+
+		/*
+		 * does the tuple descriptor expect an OID ? Note: we don't have
+		 * to set the oid itself, just the flag! (see heap_formtuple())
+		 */
+		if (pSerInfo->tupdesc->tdhasoid)	/* else leave infomask = 0 */
+		{
+			t_data->t_infomask |= HEAP_HASOID;
 		}
+
+		/*
+		 * and now the data proper (it would be nice if we could just
+		 * point our caller into our existing buffer in-place, but we'll
+		 * leave that for another day)
+		 */
+		memcpy((char *) t_data + hoff, pos, datalen);
 	}
 
 	/* Free up memory we used. */
-	pfree(serData.data);
+	pfree(serData->data);
 
 	return htup;
 }
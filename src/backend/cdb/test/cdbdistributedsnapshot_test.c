@@ -129,9 +129,9 @@ test__DistributedSnapshotWithLocalMapping_CommittedTest(void **state)
 	assert_true(dslm.currentLocalXidsCount == 3);
 	assert_true(dslm.minCachedLocalXid == 5);
 	assert_true(dslm.maxCachedLocalXid == 20);
-	assert_true(dslm.inProgressMappedLocalXids[0] == 10);
-	assert_true(dslm.inProgressMappedLocalXids[1] == 20);
-	assert_true(dslm.inProgressMappedLocalXids[2] == 5);
+	assert_true(dslm.inProgressMappedLocalXids[0] == 5);
+	assert_true(dslm.inProgressMappedLocalXids[1] == 10);
+	assert_true(dslm.inProgressMappedLocalXids[2] == 20);
 
 	/*
 	 * Lets revalidate that local cache is working and
@@ -143,9 +143,9 @@ test__DistributedSnapshotWithLocalMapping_CommittedTest(void **state)
 	assert_true(dslm.currentLocalXidsCount == 3);
 	assert_true(dslm.minCachedLocalXid == 5);
 	assert_true(dslm.maxCachedLocalXid == 20);
-	assert_true(dslm.inProgressMappedLocalXids[0] == 10);
-	assert_true(dslm.inProgressMappedLocalXids[1] == 20);
-	assert_true(dslm.inProgressMappedLocalXids[2] == 5);
+	assert_true(dslm.inProgressMappedLocalXids[0] == 5);
+	assert_true(dslm.inProgressMappedLocalXids[1] == 10);
+	assert_true(dslm.inProgressMappedLocalXids[2] == 20);
 
 	/*
 	 * Test where local cache should not be touched, if distributedXid is not
@@ -156,9 +156,9 @@ test__DistributedSnapshotWithLocalMapping_CommittedTest(void **state)
 	assert_true(dslm.currentLocalXidsCount == 3);
 	assert_true(dslm.minCachedLocalXid == 5);
 	assert_true(dslm.maxCachedLocalXid == 20);
-	assert_true(dslm.inProgressMappedLocalXids[0] == 10);
-	assert_true(dslm.inProgressMappedLocalXids[1] == 20);
-	assert_true(dslm.inProgressMappedLocalXids[2] == 5);
+	assert_true(dslm.inProgressMappedLocalXids[0] == 5);
+	assert_true(dslm.inProgressMappedLocalXids[1] == 10);
+	assert_true(dslm.inProgressMappedLocalXids[2] == 20);
 
 	free(ds->inProgressXidArray);
 	free(dslm.inProgressMappedLocalXids);
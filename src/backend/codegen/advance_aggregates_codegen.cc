@@ -340,6 +340,17 @@ bool AdvanceAggregatesCodegen::GenerateAdvanceAggregates(
   llvm::Function* llvm_ExecVariableList =
       codegen_utils->GetOrRegisterExternalFunction(ExecVariableList,
                                                    "ExecVariableList");
+  llvm::Function* llvm_ExecEvalExprSwitchContext =
+      codegen_utils->GetOrRegisterExternalFunction(ExecEvalExprSwitchContext,
+                                                   "ExecEvalExprSwitchContext");
+  llvm::Function* llvm_advance_transition_function =
+      codegen_utils->GetOrRegisterExternalFunction(
+          advance_transition_function_regular,
+          "advance_transition_function_regular");
+  llvm::Function* llvm_tuplesort_putdatum =
+      codegen_utils->GetOrRegisterExternalFunction(
+          tuplesort_putdatum_regular,
+          "tuplesort_putdatum_regular");
 
   // Function argument to advance_aggregates
   llvm::Value* llvm_aggstate_arg = ArgumentByPosition(
@@ -387,43 +398,84 @@ bool AdvanceAggregatesCodegen::GenerateAdvanceAggregates(
 
     AggStatePerAgg peraggstate = &aggstate_->peragg[aggno];
 
-    if (peraggstate->numSortCols > 0) {
-      elog(DEBUG1, "We don't codegen DISTINCT and/or ORDER BY case");
-      return false;
-    }
-
     Aggref *aggref = peraggstate->aggref;
     if (!aggref) {
       elog(DEBUG1, "We don't codegen non-aggref functions");
       return false;
     }
 
+    // DISTINCT and/or ORDER BY aggregates put their input into a tuplesort
+    // here; only the single input case puts a datum.
+    if (peraggstate->numSortCols > 0 && peraggstate->numInputs != 1) {
+      elog(DEBUG1, "We don't codegen DISTINCT and/or ORDER BY case "
+           "with more than one input");
+      return false;
+    }
+
     assert(peraggstate->evalproj);
     // Number of attributes to be retrieved. This is one less than
     // number of arguments of the transition function, since the transition
     // value is passed as the first argument to the transition function.
     int nargs = peraggstate->transfn.fn_nargs - 1;
     assert(nargs >= 0);
+    // The evaluated inputs also include the sort columns, if any
+    int ninputs = peraggstate->numInputs;
+    assert(ninputs >= nargs);
+
+    // Block of the next aggregate function, where a FILTERed out or NULL
+    // input skips to
+    llvm::BasicBlock* next_aggregate_block = codegen_utils->
+        CreateBasicBlock("next_aggregate_block_aggno_"
+            + std::to_string(aggno), advance_aggregates_func);
 
-    // Since we do not support ordered functions, we do not need to store
-    // the value of the variables, which are used as input to the aggregate
-    // function, in a slot.
+    // Skip anything FILTERed out {{
+    ExprState* filter = peraggstate->aggrefstate ?
+        peraggstate->aggrefstate->aggfilter : nullptr;
+    if (nullptr != filter) {
+      llvm::BasicBlock* filter_passed_block = codegen_utils->
+          CreateBasicBlock("filter_passed_block_aggno_"
+              + std::to_string(aggno), advance_aggregates_func);
+      llvm::Value* llvm_filter_isnull_ptr = irb->CreateAlloca(
+          codegen_utils->GetType<bool>(), nullptr, "filter_isnull");
+      // res = ExecEvalExprSwitchContext(filter, aggstate->tmpcontext,
+      //                                 &isnull, NULL);
+      llvm::Value* llvm_filter_res = irb->CreateCall(
+          llvm_ExecEvalExprSwitchContext, {
+              codegen_utils->GetConstant(filter),
+              codegen_utils->GetConstant(aggstate_->tmpcontext),
+              llvm_filter_isnull_ptr,
+              codegen_utils->GetConstant<ExprDoneCond *>(nullptr)});
+      // if (isnull || !DatumGetBool(res)) continue;
+      irb->CreateCondBr(
+          irb->CreateOr(
+              irb->CreateLoad(llvm_filter_isnull_ptr),
+              irb->CreateICmpEQ(llvm_filter_res,
+                                codegen_utils->GetConstant<Datum>(0))),
+          next_aggregate_block /* true */,
+          filter_passed_block /* false */);
+      irb->SetInsertPoint(filter_passed_block);
+    }
+    // }}
+
+    // Since we do not support ordered functions with more than one input, we
+    // do not need to store the value of the variables, which are used as
+    // input to the aggregate function, in a slot.
     llvm::Value* llvm_in_args_ptr = irb->CreateAlloca(
         codegen_utils->GetType<Datum>(),
-        codegen_utils->GetConstant(nargs));
+        codegen_utils->GetConstant(ninputs));
     llvm::Value* llvm_in_isnulls_ptr = irb->CreateAlloca(
         codegen_utils->GetType<bool>(),
-        codegen_utils->GetConstant(nargs));
+        codegen_utils->GetConstant(ninputs));
 
     llvm::BasicBlock* advance_transition_function_block = codegen_utils->
         CreateBasicBlock("advance_transition_function_block_aggno_"
             + std::to_string(aggno), advance_aggregates_func);
 
-    // Although the (nargs > 0) check does not exist in the regular
+    // Although the (ninputs > 0) check does not exist in the regular
     // advance_aggregates, the calls to ExecVariableList and
     // ExecTargetList becomes a no-op when it is true.
     // So we can avoid the call all together.
-    if (nargs > 0) {
+    if (ninputs > 0) {
       if (peraggstate->evalproj->pi_isVarList) {
         irb->CreateCall(llvm_ExecVariableList, {
             codegen_utils->GetConstant<ProjectionInfo *>(peraggstate->evalproj),
@@ -464,6 +516,51 @@ bool AdvanceAggregatesCodegen::GenerateAdvanceAggregates(
               codegen_utils->GetConstant(i)));
     }
 
+    if (peraggstate->numSortCols > 0) {
+      // If the transfn is strict, check for nullity before storing the value
+      // in the sorter
+      if (peraggstate->transfn.fn_strict && nargs > 0) {
+        llvm::BasicBlock* put_datum_block = codegen_utils->
+            CreateBasicBlock("put_datum_block_aggno_"
+                + std::to_string(aggno), advance_aggregates_func);
+        irb->CreateCondBr(llvm_in_args_isNull[1],
+                          next_aggregate_block /* true */,
+                          put_datum_block /* false */);
+        irb->SetInsertPoint(put_datum_block);
+      }
+      // tuplesort_putdatum(peraggstate->sortstate, value, isnull);
+      llvm::Value* llvm_sortstate = irb->CreateLoad(
+          codegen_utils->GetPointerToMember(
+              codegen_utils->GetConstant(peraggstate),
+              &AggStatePerAggData::sortstate));
+      irb->CreateCall(llvm_tuplesort_putdatum, {
+          llvm_sortstate,
+          irb->CreateLoad(llvm_in_args_ptr),
+          irb->CreateLoad(llvm_in_isnulls_ptr)});
+      irb->CreateBr(next_aggregate_block);
+      irb->SetInsertPoint(next_aggregate_block);
+      continue;
+    }
+
+    // Transition functions that have no generator, like the numeric ones, are
+    // called through the fmgr as in the regular advance_transition_function.
+    if (nullptr == gpcodegen::OpExprTreeGenerator::GetPGFuncGenerator(
+        peraggstate->transfn.fn_oid)) {
+      elog(DEBUG1, "Calling built-in function with oid = %d through fmgr",
+           peraggstate->transfn.fn_oid);
+      irb->CreateCall(llvm_advance_transition_function, {
+          llvm_aggstate,
+          codegen_utils->GetConstant(aggno),
+          irb->CreateGEP(llvm_pergroup_arg, {codegen_utils->GetConstant(
+              sizeof(AggStatePerGroupData) * aggno)}),
+          llvm_in_args_ptr,
+          llvm_in_isnulls_ptr,
+          llvm_mem_manager_arg});
+      irb->CreateBr(next_aggregate_block);
+      irb->SetInsertPoint(next_aggregate_block);
+      continue;
+    }
+
     gpcodegen::PGFuncGeneratorInfo pg_func_info(
         advance_aggregates_func,
         overflow_block,
@@ -475,6 +572,8 @@ bool AdvanceAggregatesCodegen::GenerateAdvanceAggregates(
         &pg_func_info, llvm_mem_manager_arg);
     if (!isGenerated)
       return false;
+    irb->CreateBr(next_aggregate_block);
+    irb->SetInsertPoint(next_aggregate_block);
   }  // End of for loop
 
   irb->CreateRetVoid();
@@ -10,15 +10,21 @@
 //
 //---------------------------------------------------------------------------
 #include <assert.h>
+#include <pthread.h>
+#include <signal.h>
 #include <iosfwd>
 #include <memory>
+#include <mutex>  // NOLINT(build/c++11)
 #include <string>
+#include <system_error>  // NOLINT(build/c++11)
+#include <thread>  // NOLINT(build/c++11)
 #include <vector>
 
 #include "llvm/Support/raw_ostream.h"
 
 #include "codegen/codegen_interface.h"
 #include "codegen/codegen_manager.h"
+#include "codegen/codegen_object_cache.h"
 #include "codegen/codegen_wrapper.h"
 #include "codegen/utils/codegen_utils.h"
 #include "codegen/utils/gp_codegen_utils.h"
@@ -30,11 +36,32 @@ extern "C" {
 
 using gpcodegen::CodegenManager;
 
-CodegenManager::CodegenManager(const std::string& module_name) {
+namespace {
+
+// MCJIT compiles through the per-backend CodegenObjectCache, so the managers
+// of a backend take turns compiling.
+std::mutex& CompilationMutex() {
+  // Never destroyed, a detached compilation may still hold it at exit
+  static std::mutex* mutex = new std::mutex();
+  return *mutex;
+}
+
+}  // namespace
+
+CodegenManager::CodegenManager(const std::string& module_name,
+                               int optimization_level)
+    : unique_id_counter_(0),
+      optimization_level_(optimization_level) {
   module_name_ = module_name;
   codegen_utils_.reset(new gpcodegen::GpCodegenUtils(module_name));
 }
 
+CodegenManager::~CodegenManager() {
+  if (compile_thread_.joinable()) {
+    compile_thread_.detach();
+  }
+}
+
 bool CodegenManager::EnrollCodeGenerator(
     CodegenFuncLifespan funcLifespan, CodegenInterface* generator) {
   // Only CodegenFuncLifespan_Parameter_Invariant is supported as of now
@@ -60,14 +87,7 @@ unsigned int CodegenManager::GenerateCode() {
   return success_count;
 }
 
-unsigned int CodegenManager::PrepareGeneratedFunctions() {
-  unsigned int success_count = 0;
-
-  // If no generator registered, just return with success count as 0
-  if (enrolled_code_generators_.empty()) {
-    return success_count;
-  }
-
+bool CodegenManager::SetUpExecutionEngine() {
   STATIC_ASSERT_OPTIMIZATION_LEVEL(kNone,
                                    CODEGEN_OPTIMIZATION_LEVEL_NONE);
   STATIC_ASSERT_OPTIMIZATION_LEVEL(kLess,
@@ -77,17 +97,25 @@ unsigned int CodegenManager::PrepareGeneratedFunctions() {
   STATIC_ASSERT_OPTIMIZATION_LEVEL(kAggressive,
                                    CODEGEN_OPTIMIZATION_LEVEL_AGGRESSIVE);
 
-  // Call GpCodegenUtils to compile entire module
-  bool compilation_status = codegen_utils_->PrepareForExecution(
-      gpcodegen::GpCodegenUtils::OptimizationLevel(codegen_optimization_level),
-      true);
-
-  if (!compilation_status) {
-    return success_count;
+  // Reuse the object code of an identical module compiled by an earlier query,
+  // of this backend or, through the on-disk cache, of another one
+  gpcodegen::CodegenObjectCache* object_cache = nullptr;
+  if (codegen_cache_size > 0 || codegen_disk_cache_size > 0) {
+    object_cache = gpcodegen::CodegenObjectCache::GetInstance();
+    object_cache->SetOptimizationLevel(optimization_level_);
   }
 
-  // On successful compilation, go through all generator and swap
-  // the pointer so compiled function get called
+  // Hand the entire module over to an ExecutionEngine
+  return codegen_utils_->PrepareForExecution(
+      gpcodegen::GpCodegenUtils::OptimizationLevel(optimization_level_),
+      true,
+      object_cache);
+}
+
+unsigned int CodegenManager::SetToGenerated() {
+  // Go through all generator and swap the pointer so compiled function get
+  // called
+  unsigned int success_count = 0;
   gpcodegen::GpCodegenUtils* codegen_utils = codegen_utils_.get();
   for (std::unique_ptr<CodegenInterface>& generator :
       enrolled_code_generators_) {
@@ -96,6 +124,87 @@ unsigned int CodegenManager::PrepareGeneratedFunctions() {
   return success_count;
 }
 
+unsigned int CodegenManager::PrepareGeneratedFunctions() {
+  // If no generator registered, just return with success count as 0
+  if (enrolled_code_generators_.empty()) {
+    return 0;
+  }
+
+  if (!SetUpExecutionEngine()) {
+    return 0;
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(CompilationMutex());
+    codegen_utils_->CompileForExecution();
+  }
+
+  return SetToGenerated();
+}
+
+bool CodegenManager::PrepareGeneratedFunctionsInBackground() {
+  if (enrolled_code_generators_.empty()) {
+    return false;
+  }
+
+  if (!SetUpExecutionEngine()) {
+    return false;
+  }
+
+  background_compilation_.reset(new BackgroundCompilation());
+  background_compilation_->codegen_utils = codegen_utils_;
+  background_compilation_->done = false;
+
+  // Signals are for the main thread of the backend to handle, so block them
+  // all in the thread, which inherits the signal mask.
+  sigset_t all_signals;
+  sigset_t old_signals;
+  sigfillset(&all_signals);
+  pthread_sigmask(SIG_SETMASK, &all_signals, &old_signals);
+  try {
+    compile_thread_ = std::thread(CompileInBackground,
+                                  background_compilation_);
+  } catch (const std::system_error&) {
+    background_compilation_.reset();
+  }
+  pthread_sigmask(SIG_SETMASK, &old_signals, nullptr);
+
+  if (nullptr == background_compilation_) {
+    // No thread to compile in, so compile right away
+    {
+      std::lock_guard<std::mutex> lock(CompilationMutex());
+      codegen_utils_->CompileForExecution();
+    }
+    SetToGenerated();
+    return false;
+  }
+  return true;
+}
+
+bool CodegenManager::PollGeneratedFunctions() {
+  if (nullptr == background_compilation_) {
+    return false;
+  }
+  if (!background_compilation_->done.load(std::memory_order_acquire)) {
+    return true;
+  }
+
+  compile_thread_.join();
+  background_compilation_.reset();
+  SetToGenerated();
+  return false;
+}
+
+void CodegenManager::CompileInBackground(
+    std::shared_ptr<BackgroundCompilation> compilation) {
+  // Only LLVM runs in this thread: nothing here may palloc() or elog().
+  {
+    std::lock_guard<std::mutex> lock(CompilationMutex());
+    compilation->codegen_utils->CompileForExecution();
+  }
+  compilation->done.store(true, std::memory_order_release);
+}
+
 void CodegenManager::NotifyParameterChange() {
   // no support for parameter change yet
   assert(false);
@@ -116,7 +225,7 @@ void CodegenManager::AccumulateExplainString() {
   // This is called only when EXPLAIN CODEGEN. Because we don't want to compile
   // at this time, we need to call CodegenUtils::Optimize to "optimize" LLVM IR.
   codegen_utils_->Optimize(gpcodegen::CodegenUtils::OptimizationLevel(
-                               codegen_optimization_level),
+                               optimization_level_),
                            gpcodegen::CodegenUtils::SizeLevel::kNormal,
                            false);
   llvm::raw_string_ostream out(explain_string_);
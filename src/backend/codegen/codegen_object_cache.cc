@@ -0,0 +1,248 @@
+//---------------------------------------------------------------------------
+//  Greenplum Database
+//  Copyright (C) 2016 Pivotal Software, Inc.
+//
+//  @filename:
+//    codegen_object_cache.cc
+//
+//  @doc:
+//    Implementation of the per-backend cache of compiled codegen modules
+//    and of the on-disk cache behind it
+//
+//---------------------------------------------------------------------------
+#include <dirent.h>
+#include <errno.h>
+#include <stdio.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <utime.h>
+
+#include <algorithm>
+#include <cstddef>
+#include <list>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "codegen/codegen_config.h"
+#include "codegen/codegen_object_cache.h"
+
+#include "llvm/ADT/SmallString.h"
+#include "llvm/IR/Function.h"
+#include "llvm/IR/GlobalVariable.h"
+#include "llvm/Config/llvm-config.h"
+#include "llvm/Support/MD5.h"
+#include "llvm/Support/raw_ostream.h"
+
+extern "C" {
+#include "postgres.h"  // NOLINT(build/include)
+#include "miscadmin.h"
+#include "utils/elog.h"
+}
+
+namespace {
+
+// Directory of the on-disk cache, relative to the data directory
+constexpr char kDiskCacheDir[] = "pg_codegen_cache";
+constexpr char kDiskCacheSuffix[] = ".o";
+
+}  // namespace
+
+using gpcodegen::CodegenObjectCache;
+
+CodegenObjectCache* CodegenObjectCache::GetInstance() {
+  // Lives as long as the backend
+  static CodegenObjectCache* instance = new CodegenObjectCache();
+  return instance;
+}
+
+CodegenObjectCache::CodegenObjectCache()
+    : total_size_(0),
+      optimization_level_(0),
+      pending_module_(nullptr) {
+}
+
+std::string CodegenObjectCache::ComputeKey(const llvm::Module* module) const {
+  // Print every global and function rather than the whole module, to leave
+  // out the module name, which carries the plan node id.
+  std::string ir;
+  llvm::raw_string_ostream out(ir);
+  out << "opt " << optimization_level_ << "\n";
+  // The on-disk cache outlives this binary and this LLVM
+  out << "llvm " << LLVM_VERSION_STRING << "\n";
+  out << "server " << PG_VERSION_STR << "\n";
+  for (const llvm::GlobalVariable& global : module->globals()) {
+    global.print(out);
+    out << "\n";
+  }
+  for (const llvm::Function& function : *module) {
+    function.print(out);
+  }
+  out.flush();
+
+  llvm::MD5 md5;
+  llvm::MD5::MD5Result digest;
+  llvm::SmallString<32> key;
+  md5.update(ir);
+  md5.final(digest);
+  llvm::MD5::stringifyResult(digest, key);
+  return std::string(key.begin(), key.end());
+}
+
+std::unique_ptr<llvm::MemoryBuffer> CodegenObjectCache::getObject(
+    const llvm::Module* module) {
+  std::string key = ComputeKey(module);
+
+  auto it = index_.find(key);
+  if (it == index_.end()) {
+    // Maybe another backend compiled it
+    std::unique_ptr<llvm::MemoryBuffer> object = ReadFromDisk(key);
+    if (nullptr != object) {
+      Insert(&key, object->getBufferStart(), object->getBufferSize());
+      return object;
+    }
+    pending_module_ = module;
+    pending_key_.swap(key);
+    return nullptr;
+  }
+
+  // Move to the front, it is the most recently used now
+  entries_.splice(entries_.begin(), entries_, it->second);
+  return llvm::MemoryBuffer::getMemBufferCopy(it->second->object);
+}
+
+void CodegenObjectCache::notifyObjectCompiled(const llvm::Module* module,
+                                              llvm::MemoryBufferRef object) {
+  if (module != pending_module_) {
+    return;
+  }
+  pending_module_ = nullptr;
+
+  WriteToDisk(pending_key_, object);
+  Insert(&pending_key_, object.getBufferStart(), object.getBufferSize());
+}
+
+void CodegenObjectCache::Insert(std::string* key,
+                                const char* object,
+                                std::size_t size) {
+  if (index_.count(*key) > 0 ||
+      !MakeRoom(size)) {
+    return;
+  }
+
+  entries_.push_front(Entry());
+  entries_.front().key.swap(*key);
+  entries_.front().object.assign(object, size);
+  index_[entries_.front().key] = entries_.begin();
+  total_size_ += size;
+}
+
+bool CodegenObjectCache::MakeRoom(std::size_t size) {
+  const std::size_t limit =
+      static_cast<std::size_t>(codegen_cache_size) * 1024L;
+
+  if (size > limit) {
+    return false;
+  }
+  while (total_size_ + size > limit) {
+    Entry& victim = entries_.back();
+    total_size_ -= victim.object.size();
+    index_.erase(victim.key);
+    entries_.pop_back();
+  }
+  return true;
+}
+
+std::string CodegenObjectCache::DiskPath(const std::string& key) {
+  return std::string(DataDir) + "/" + kDiskCacheDir + "/" + key +
+      kDiskCacheSuffix;
+}
+
+std::unique_ptr<llvm::MemoryBuffer> CodegenObjectCache::ReadFromDisk(
+    const std::string& key) {
+  if (codegen_disk_cache_size <= 0 || nullptr == DataDir) {
+    return nullptr;
+  }
+
+  std::string path = DiskPath(key);
+  llvm::ErrorOr<std::unique_ptr<llvm::MemoryBuffer>> object =
+      llvm::MemoryBuffer::getFile(path);
+  if (!object) {
+    return nullptr;
+  }
+
+  // Its modification time orders the eviction
+  utime(path.c_str(), nullptr);
+  return std::move(object.get());
+}
+
+void CodegenObjectCache::WriteToDisk(const std::string& key,
+                                     llvm::MemoryBufferRef object) {
+  const std::size_t limit =
+      static_cast<std::size_t>(codegen_disk_cache_size) * 1024L;
+  if (limit == 0 || object.getBufferSize() > limit || nullptr == DataDir) {
+    return;
+  }
+
+  std::string dir = std::string(DataDir) + "/" + kDiskCacheDir;
+  if (mkdir(dir.c_str(), S_IRWXU) != 0 && errno != EEXIST) {
+    elog(DEBUG1, "could not create codegen cache directory \"%s\": %m",
+         dir.c_str());
+    return;
+  }
+
+  // Evict the least recently used files until the object fits. Other
+  // backends may be evicting too, so files can vanish under us.
+  std::vector<std::pair<time_t, std::string>> files;
+  std::size_t total_size = 0;
+  DIR* dirp = opendir(dir.c_str());
+  if (nullptr == dirp) {
+    return;
+  }
+  const std::size_t suffix_len = sizeof(kDiskCacheSuffix) - 1;
+  struct dirent* entry;
+  while (nullptr != (entry = readdir(dirp))) {
+    std::string name(entry->d_name);
+    struct stat st;
+    if (name.size() <= suffix_len ||
+        name.compare(name.size() - suffix_len, suffix_len,
+                     kDiskCacheSuffix) != 0 ||
+        stat((dir + "/" + name).c_str(), &st) != 0) {
+      continue;
+    }
+    files.emplace_back(st.st_mtime, dir + "/" + name);
+    total_size += st.st_size;
+  }
+  closedir(dirp);
+
+  std::sort(files.begin(), files.end());
+  for (auto it = files.begin();
+       it != files.end() && total_size + object.getBufferSize() > limit;
+       ++it) {
+    struct stat st;
+    if (stat(it->second.c_str(), &st) == 0 &&
+        unlink(it->second.c_str()) == 0) {
+      total_size -= std::min<std::size_t>(total_size, st.st_size);
+    }
+  }
+
+  // Write under a name of our own and rename it into place, so that other
+  // backends see either the whole object or nothing
+  std::string path = DiskPath(key);
+  std::string tmp_path = path + "." + std::to_string(MyProcPid) + ".tmp";
+  FILE* file = fopen(tmp_path.c_str(), "wb");
+  if (nullptr == file) {
+    elog(DEBUG1, "could not create codegen cache file \"%s\": %m",
+         tmp_path.c_str());
+    return;
+  }
+  bool written = fwrite(object.getBufferStart(), 1, object.getBufferSize(),
+                        file) == object.getBufferSize();
+  written = (fclose(file) == 0) && written;
+  if (!written || rename(tmp_path.c_str(), path.c_str()) != 0) {
+    elog(DEBUG1, "could not write codegen cache file \"%s\": %m",
+         path.c_str());
+    unlink(tmp_path.c_str());
+  }
+}
@@ -19,7 +19,10 @@
 #include "codegen/codegen_config.h"
 #include "codegen/base_codegen.h"
 #include "codegen/codegen_manager.h"
+#include "codegen/datumstream_get_batch_codegen.h"
 #include "codegen/exec_eval_expr_codegen.h"
+#include "codegen/exec_hash_get_hash_value_codegen.h"
+#include "codegen/exec_scan_qual_project_codegen.h"
 #include "codegen/exec_variable_list_codegen.h"
 #include "codegen/expr_tree_generator.h"
 #include "codegen/utils/gp_codegen_utils.h"
@@ -28,6 +31,10 @@
 extern "C" {
 #include "lib/stringinfo.h"
 #include "postgres.h"  // NOLINT(build/include)
+#include "fmgr.h"
+#include "executor/nodeAgg.h"
+#include "utils/builtins.h"
+#include "utils/tuplesort.h"
 }
 
 using gpcodegen::CodegenManager;
@@ -35,6 +42,9 @@ using gpcodegen::BaseCodegen;
 using gpcodegen::ExecVariableListCodegen;
 using gpcodegen::ExecEvalExprCodegen;
 using gpcodegen::AdvanceAggregatesCodegen;
+using gpcodegen::ExecHashGetHashValueCodegen;
+using gpcodegen::DatumStreamBlockReadGetBatchCodegen;
+using gpcodegen::ExecScanQualProjectCodegen;
 
 // Current code generator manager that oversees all code generators
 static void* ActiveCodeGeneratorManager = nullptr;
@@ -45,27 +55,44 @@ unsigned int InitCodegen() {
   return gpcodegen::GpCodegenUtils::InitializeGlobal();
 }
 
-void* CodeGeneratorManagerCreate(const char* module_name) {
+void* CodeGeneratorManagerCreate(const char* module_name,
+                                 int optimization_level) {
   if (!codegen) {
     return nullptr;
   }
-  return new CodegenManager(module_name);
+  return new CodegenManager(module_name, optimization_level);
 }
 
 unsigned int CodeGeneratorManagerGenerateCode(void* manager) {
-  if (!codegen) {
+  // manager is NULL for queries that cost less than codegen_above_cost
+  if (!codegen || nullptr == manager) {
     return 0;
   }
   return static_cast<CodegenManager*>(manager)->GenerateCode();
 }
 
 unsigned int CodeGeneratorManagerPrepareGeneratedFunctions(void* manager) {
-  if (!codegen) {
+  if (!codegen || nullptr == manager) {
     return 0;
   }
   return static_cast<CodegenManager*>(manager)->PrepareGeneratedFunctions();
 }
 
+bool CodeGeneratorManagerPrepareGeneratedFunctionsInBackground(void* manager) {
+  if (!codegen || nullptr == manager) {
+    return false;
+  }
+  return static_cast<CodegenManager*>(manager)->
+      PrepareGeneratedFunctionsInBackground();
+}
+
+bool CodeGeneratorManagerPollGeneratedFunctions(void* manager) {
+  if (nullptr == manager) {
+    return false;
+  }
+  return static_cast<CodegenManager*>(manager)->PollGeneratedFunctions();
+}
+
 unsigned int CodeGeneratorManagerNotifyParameterChange(void* manager) {
   // parameter change notification is not supported yet
   assert(false);
@@ -73,10 +100,9 @@ unsigned int CodeGeneratorManagerNotifyParameterChange(void* manager) {
 }
 
 void CodeGeneratorManagerAccumulateExplainString(void* manager) {
-  if (!codegen) {
+  if (!codegen || nullptr == manager) {
     return;
   }
-  assert(nullptr != manager);
   static_cast<CodegenManager*>(manager)->AccumulateExplainString();
 }
 
@@ -85,9 +111,11 @@ char* CodeGeneratorManagerGetExplainString(void* manager) {
     return nullptr;
   }
   StringInfo return_string = makeStringInfo();
-  appendStringInfoString(
-      return_string,
-      static_cast<CodegenManager*>(manager)->GetExplainString().c_str());
+  if (nullptr != manager) {
+    appendStringInfoString(
+        return_string,
+        static_cast<CodegenManager*>(manager)->GetExplainString().c_str());
+  }
   return return_string->data;
 }
 
@@ -108,6 +136,11 @@ slot_getattr_regular(TupleTableSlot *slot, int attnum, bool *isnull) {
   return slot_getattr(slot, attnum, isnull);
 }
 
+void
+slot_getsomeattrs_regular(TupleTableSlot *slot, int attnum) {
+  slot_getsomeattrs(slot, attnum);
+}
+
 int
 att_align_nominal_regular(int cur_offset, char attalign) {
   return att_align_nominal(cur_offset, attalign);
@@ -122,6 +155,46 @@ VARSIZE_regular(void* ptr) {
   return VARSIZE(ptr);
 }
 
+bool
+textlike_regular(void* str, void* pat) {
+  return DatumGetBool(DirectFunctionCall2(textlike,
+                                          PointerGetDatum(str),
+                                          PointerGetDatum(pat)));
+}
+
+void
+advance_transition_function_regular(AggState *aggstate,
+                                    int aggno,
+                                    AggStatePerGroupData *pergroupstate,
+                                    Datum *args,
+                                    bool *argnulls,
+                                    MemoryManagerContainer *mem_manager) {
+  AggStatePerAgg peraggstate = &aggstate->peragg[aggno];
+  FunctionCallInfoData fcinfo;
+
+  // Start from 1, since the 0th arg will be the transition value
+  for (int i = 0; i < peraggstate->numArguments; i++) {
+    fcinfo.arg[i + 1] = args[i];
+    fcinfo.argnull[i + 1] = argnulls[i];
+  }
+  pergroupstate->transValue =
+      invoke_agg_trans_func(&(peraggstate->transfn),
+                            peraggstate->numArguments,
+                            pergroupstate->transValue,
+                            &(pergroupstate->noTransValue),
+                            &(pergroupstate->transValueIsNull),
+                            peraggstate->transtypeByVal,
+                            peraggstate->transtypeLen,
+                            &fcinfo, aggstate,
+                            aggstate->tmpcontext->ecxt_per_tuple_memory,
+                            mem_manager);
+}
+
+void
+tuplesort_putdatum_regular(void *sortstate, Datum val, bool isnull) {
+  tuplesort_putdatum(static_cast<Tuplesortstate *>(sortstate), val, isnull);
+}
+
 void* ExecVariableListCodegenEnroll(
     ExecVariableListFn regular_func_ptr,
     ExecVariableListFn* ptr_to_chosen_func_ptr,
@@ -173,3 +246,54 @@ void* AdvanceAggregatesCodegenEnroll(
   return generator;
 }
 
+void* ExecHashGetHashValueCodegenEnroll(
+    ExecHashGetHashValueFn regular_func_ptr,
+    ExecHashGetHashValueFn* ptr_to_chosen_func_ptr,
+    List *hashkeys,
+    List *hash_operators,
+    bool outer_tuple,
+    ExprContext *econtext) {
+  CodegenManager* manager = static_cast<CodegenManager*>(
+      GetActiveCodeGeneratorManager());
+  ExecHashGetHashValueCodegen* generator =
+      CodegenManager::CreateAndEnrollGenerator<ExecHashGetHashValueCodegen>(
+          manager,
+          regular_func_ptr,
+          ptr_to_chosen_func_ptr,
+          hashkeys,
+          hash_operators,
+          outer_tuple,
+          econtext);
+  return generator;
+}
+
+void* DatumStreamBlockReadGetBatchCodegenEnroll(
+    DatumStreamBlockReadGetBatchFn regular_func_ptr,
+    DatumStreamBlockReadGetBatchFn* ptr_to_chosen_func_ptr,
+    int32 datumlen) {
+  CodegenManager* manager = static_cast<CodegenManager*>(
+      GetActiveCodeGeneratorManager());
+  DatumStreamBlockReadGetBatchCodegen* generator =
+      CodegenManager::CreateAndEnrollGenerator<
+          DatumStreamBlockReadGetBatchCodegen>(
+          manager,
+          regular_func_ptr,
+          ptr_to_chosen_func_ptr,
+          datumlen);
+  return generator;
+}
+
+void* ExecScanQualProjectCodegenEnroll(
+    ExecScanQualProjectFn regular_func_ptr,
+    ExecScanQualProjectFn* ptr_to_chosen_func_ptr,
+    ScanState* scan_state) {
+  CodegenManager* manager = static_cast<CodegenManager*>(
+      GetActiveCodeGeneratorManager());
+  ExecScanQualProjectCodegen* generator =
+      CodegenManager::CreateAndEnrollGenerator<ExecScanQualProjectCodegen>(
+          manager,
+          regular_func_ptr,
+          ptr_to_chosen_func_ptr,
+          scan_state);
+  return generator;
+}
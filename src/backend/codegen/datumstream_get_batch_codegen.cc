@@ -0,0 +1,614 @@
+//---------------------------------------------------------------------------
+//  Greenplum Database
+//  Copyright (C) 2016 Pivotal Software, Inc.
+//
+//  @filename:
+//    datumstream_get_batch_codegen.cc
+//
+//  @doc:
+//    Generates code for DatumStreamBlockRead_GetBatch function.
+//
+//---------------------------------------------------------------------------
+#include <assert.h>
+#include <stddef.h>
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "codegen/base_codegen.h"
+#include "codegen/codegen_wrapper.h"
+#include "codegen/datumstream_get_batch_codegen.h"
+#include "codegen/utils/gp_codegen_utils.h"
+#include "codegen/utils/utility.h"
+
+#include "llvm/IR/Argument.h"
+#include "llvm/IR/Constant.h"
+#include "llvm/IR/IRBuilder.h"
+#include "llvm/IR/Instructions.h"
+
+extern "C" {
+#include "postgres.h"  // NOLINT(build/include)
+#include "utils/datumstreamblock.h"
+#include "utils/elog.h"
+}
+
+namespace llvm {
+class BasicBlock;
+class Function;
+class Value;
+}  // namespace llvm
+
+using gpcodegen::DatumStreamBlockReadGetBatchCodegen;
+
+constexpr char
+DatumStreamBlockReadGetBatchCodegen::kDatumStreamBlockReadGetBatchPrefix[];
+
+DatumStreamBlockReadGetBatchCodegen::DatumStreamBlockReadGetBatchCodegen(
+    CodegenManager* manager,
+    DatumStreamBlockReadGetBatchFn regular_func_ptr,
+    DatumStreamBlockReadGetBatchFn* ptr_to_regular_func_ptr,
+    int32 datumlen)
+    : BaseCodegen(manager,
+                  kDatumStreamBlockReadGetBatchPrefix,
+                  regular_func_ptr, ptr_to_regular_func_ptr),
+      datumlen_(datumlen) {
+}
+
+llvm::Value* DatumStreamBlockReadGetBatchCodegen::GenerateBitMapNext(
+    gpcodegen::GpCodegenUtils* codegen_utils,
+    llvm::Value* llvm_byte_ptr,
+    llvm::Value* llvm_byte_bit,
+    llvm::Value* llvm_bit_position) {
+  auto irb = codegen_utils->ir_builder();
+
+  llvm::Value* llvm_ptr = irb->CreateLoad(llvm_byte_ptr);
+  llvm::Value* llvm_bit = irb->CreateLoad(llvm_byte_bit);
+  llvm::Value* llvm_pos = irb->CreateLoad(llvm_bit_position);
+
+  // Reading starts before the first bit, at bit position -1 with byteBit 0.
+  // if (bitPosition == -1) byteBit = 1;
+  // else { byteBit <<= 1; if (byteBit == 0) { ++bytePointer; byteBit = 1; } }
+  llvm::Value* llvm_first = irb->CreateICmpEQ(
+      llvm_pos, codegen_utils->GetConstant<int32>(-1));
+  llvm::Value* llvm_shifted = irb->CreateShl(llvm_bit, 1);
+  llvm::Value* llvm_wrapped = irb->CreateICmpEQ(
+      llvm_shifted, codegen_utils->GetConstant<uint8>(0));
+  llvm::Value* llvm_new_bit = irb->CreateSelect(
+      llvm_wrapped, codegen_utils->GetConstant<uint8>(1), llvm_shifted);
+  llvm::Value* llvm_new_ptr = irb->CreateSelect(
+      irb->CreateAnd(llvm_wrapped, irb->CreateNot(llvm_first)),
+      irb->CreateInBoundsGEP(llvm_ptr,
+                             {codegen_utils->GetConstant<int32>(1)}),
+      llvm_ptr);
+
+  irb->CreateStore(llvm_new_ptr, llvm_byte_ptr);
+  irb->CreateStore(llvm_new_bit, llvm_byte_bit);
+  irb->CreateStore(
+      irb->CreateAdd(llvm_pos, codegen_utils->GetConstant<int32>(1)),
+      llvm_bit_position);
+
+  // ((*bytePointer) & byteBit) != 0
+  return irb->CreateICmpNE(
+      irb->CreateAnd(irb->CreateLoad(llvm_new_ptr), llvm_new_bit),
+      codegen_utils->GetConstant<uint8>(0));
+}
+
+llvm::Value* DatumStreamBlockReadGetBatchCodegen::GenerateRepeatCountDecode(
+    gpcodegen::GpCodegenUtils* codegen_utils,
+    llvm::Function* llvm_func,
+    llvm::Value* llvm_countsp) {
+  auto irb = codegen_utils->ir_builder();
+  llvm::Value* llvm_buffer = irb->CreateLoad(llvm_countsp);
+
+  // len = ((buffer[0] & Int32Compress_LenFieldMask) >>
+  //        Int32Compress_LenFieldShift) + 1;
+  // value = buffer[0] & ~Int32Compress_LenFieldMask;
+  llvm::Value* llvm_b0 = irb->CreateZExt(
+      irb->CreateLoad(llvm_buffer), codegen_utils->GetType<int32>());
+  llvm::Value* llvm_len = irb->CreateAdd(
+      irb->CreateLShr(llvm_b0, Int32Compress_LenFieldShift),
+      codegen_utils->GetConstant<int32>(1));
+  llvm::Value* llvm_value = irb->CreateAnd(
+      llvm_b0, codegen_utils->GetConstant<int32>(
+          static_cast<uint8>(~Int32Compress_LenFieldMask)));
+
+  // Shift in the following bytes, most significant first. Stop at the length
+  // of the encoding, not to read past the end of the repeat counts.
+  llvm::BasicBlock* decoded_block = codegen_utils->CreateBasicBlock(
+      "repeat_count_decoded", llvm_func);
+  std::vector<std::pair<llvm::Value*, llvm::BasicBlock*>> incoming;
+  for (int i = 1; i < Int32Compress_MaxByteLen; ++i) {
+    llvm::BasicBlock* byte_block = codegen_utils->CreateBasicBlock(
+        "repeat_count_byte_" + std::to_string(i), llvm_func);
+    incoming.emplace_back(llvm_value, irb->GetInsertBlock());
+    irb->CreateCondBr(
+        irb->CreateICmpSGT(llvm_len, codegen_utils->GetConstant<int32>(i)),
+        byte_block /* true */,
+        decoded_block /* false */);
+
+    irb->SetInsertPoint(byte_block);
+    llvm::Value* llvm_byte = irb->CreateZExt(
+        irb->CreateLoad(irb->CreateInBoundsGEP(
+            llvm_buffer, {codegen_utils->GetConstant<int32>(i)})),
+        codegen_utils->GetType<int32>());
+    llvm_value = irb->CreateOr(irb->CreateShl(llvm_value, 8), llvm_byte);
+  }
+  incoming.emplace_back(llvm_value, irb->GetInsertBlock());
+  irb->CreateBr(decoded_block);
+
+  irb->SetInsertPoint(decoded_block);
+  llvm::PHINode* llvm_repeat_count = irb->CreatePHI(
+      codegen_utils->GetType<int32>(), incoming.size());
+  for (auto& in : incoming) {
+    llvm_repeat_count->addIncoming(in.first, in.second);
+  }
+  // rle_repeatcountsp += byteLen;
+  irb->CreateStore(irb->CreateInBoundsGEP(llvm_buffer, {llvm_len}),
+                   llvm_countsp);
+  return llvm_repeat_count;
+}
+
+bool DatumStreamBlockReadGetBatchCodegen::GenerateGetBatch(
+    gpcodegen::GpCodegenUtils* codegen_utils) {
+
+  assert(NULL != codegen_utils);
+
+#ifdef USE_ASSERT_CHECKING
+  // The generated code doesn't keep readBitOnCount of the bit-maps, which the
+  // block read checks its counts against in assert enabled builds.
+  return false;
+#endif
+
+  switch (datumlen_) {
+    case sizeof(uint8):
+    case sizeof(uint16):
+    case sizeof(uint32):
+    case sizeof(Datum):
+      break;
+    default:
+      elog(DEBUG1, "Unsupported datum length %d for "
+           "DatumStreamBlockRead_GetBatch", datumlen_);
+      return false;
+  }
+
+  llvm::Function* get_batch_func =
+      CreateFunction<DatumStreamBlockReadGetBatchFn>(codegen_utils,
+                                                     GetUniqueFuncName());
+
+  auto irb = codegen_utils->ir_builder();
+
+  // BasicBlocks
+  llvm::BasicBlock* entry_block = codegen_utils->CreateBasicBlock(
+      "entry", get_batch_func);
+  llvm::BasicBlock* main_block = codegen_utils->CreateBasicBlock(
+      "main", get_batch_func);
+  llvm::BasicBlock* row_loop_block = codegen_utils->CreateBasicBlock(
+      "row_loop", get_batch_func);
+  llvm::BasicBlock* row_block = codegen_utils->CreateBasicBlock(
+      "row", get_batch_func);
+  llvm::BasicBlock* repeat_block = codegen_utils->CreateBasicBlock(
+      "repeat", get_batch_func);
+  llvm::BasicBlock* repeat_fill_loop_block = codegen_utils->CreateBasicBlock(
+      "repeat_fill_loop", get_batch_func);
+  llvm::BasicBlock* repeat_fill_block = codegen_utils->CreateBasicBlock(
+      "repeat_fill", get_batch_func);
+  llvm::BasicBlock* repeat_done_block = codegen_utils->CreateBasicBlock(
+      "repeat_done", get_batch_func);
+  llvm::BasicBlock* advance_block = codegen_utils->CreateBasicBlock(
+      "advance", get_batch_func);
+  llvm::BasicBlock* null_bitmap_block = codegen_utils->CreateBasicBlock(
+      "null_bitmap", get_batch_func);
+  llvm::BasicBlock* null_row_block = codegen_utils->CreateBasicBlock(
+      "null_row", get_batch_func);
+  llvm::BasicBlock* not_null_row_block = codegen_utils->CreateBasicBlock(
+      "not_null_row", get_batch_func);
+  llvm::BasicBlock* compress_bitmap_block = codegen_utils->CreateBasicBlock(
+      "compress_bitmap", get_batch_func);
+  llvm::BasicBlock* new_repeat_block = codegen_utils->CreateBasicBlock(
+      "new_repeat", get_batch_func);
+  llvm::BasicBlock* datum_block = codegen_utils->CreateBasicBlock(
+      "datum", get_batch_func);
+  llvm::BasicBlock* done_block = codegen_utils->CreateBasicBlock(
+      "done", get_batch_func);
+  llvm::BasicBlock* fallback_block = codegen_utils->CreateBasicBlock(
+      "fallback", get_batch_func);
+
+  // Generation-time constants
+  llvm::Type* llvm_datum_type = nullptr;
+  switch (datumlen_) {
+    case sizeof(uint8):
+      llvm_datum_type = codegen_utils->GetType<uint8>();
+      break;
+    case sizeof(uint16):
+      llvm_datum_type = codegen_utils->GetType<uint16>();
+      break;
+    case sizeof(uint32):
+      llvm_datum_type = codegen_utils->GetType<uint32>();
+      break;
+    default:
+      llvm_datum_type = codegen_utils->GetType<Datum>();
+      break;
+  }
+
+  // Function arguments to DatumStreamBlockRead_GetBatch
+  llvm::Value* llvm_dsr_arg = ArgumentByPosition(get_batch_func, 0);
+  llvm::Value* llvm_nrows_arg = ArgumentByPosition(get_batch_func, 1);
+  llvm::Value* llvm_values_arg = ArgumentByPosition(get_batch_func, 2);
+  llvm::Value* llvm_nulls_arg = ArgumentByPosition(get_batch_func, 3);
+
+  // Entry block
+  // -----------
+  // Fall back for blocks of other datums, and for delta compressed and
+  // dictionary encoded blocks.
+  irb->SetInsertPoint(entry_block);
+#ifdef CODEGEN_DEBUG
+  EXPAND_CREATE_ELOG(codegen_utils,
+                     DEBUG1,
+                     "Codegen'ed DatumStreamBlockRead_GetBatch called!");
+#endif
+  // Local copies of the read position, kept in registers during the loop
+  llvm::Value* llvm_row_ptr = irb->CreateAlloca(
+      codegen_utils->GetType<int>(), nullptr, "row");
+  llvm::Value* llvm_fill_ptr = irb->CreateAlloca(
+      codegen_utils->GetType<int>(), nullptr, "fill");
+  llvm::Value* llvm_nth_ptr = irb->CreateAlloca(
+      codegen_utils->GetType<int32>(), nullptr, "nth");
+  llvm::Value* llvm_datum_index_ptr = irb->CreateAlloca(
+      codegen_utils->GetType<int32>(), nullptr, "physical_datum_index");
+  llvm::Value* llvm_datump_ptr = irb->CreateAlloca(
+      codegen_utils->GetType<uint8*>(), nullptr, "datump");
+  llvm::Value* llvm_null_byte_ptr = irb->CreateAlloca(
+      codegen_utils->GetType<uint8*>(), nullptr, "null_bytePointer");
+  llvm::Value* llvm_null_byte_bit = irb->CreateAlloca(
+      codegen_utils->GetType<uint8>(), nullptr, "null_byteBit");
+  llvm::Value* llvm_null_bit_position = irb->CreateAlloca(
+      codegen_utils->GetType<int32>(), nullptr, "null_bitPosition");
+  llvm::Value* llvm_compress_byte_ptr = irb->CreateAlloca(
+      codegen_utils->GetType<uint8*>(), nullptr, "compress_bytePointer");
+  llvm::Value* llvm_compress_byte_bit = irb->CreateAlloca(
+      codegen_utils->GetType<uint8>(), nullptr, "compress_byteBit");
+  llvm::Value* llvm_compress_bit_position = irb->CreateAlloca(
+      codegen_utils->GetType<int32>(), nullptr, "compress_bitPosition");
+  llvm::Value* llvm_in_repeated_item_ptr = irb->CreateAlloca(
+      codegen_utils->GetType<bool>(), nullptr, "rle_in_repeated_item");
+  llvm::Value* llvm_repeated_item_count_ptr = irb->CreateAlloca(
+      codegen_utils->GetType<int32>(), nullptr, "rle_repeated_item_count");
+  llvm::Value* llvm_total_repeat_items_read_ptr = irb->CreateAlloca(
+      codegen_utils->GetType<int32>(), nullptr, "rle_total_repeat_items_read");
+  llvm::Value* llvm_repeatcounts_index_ptr = irb->CreateAlloca(
+      codegen_utils->GetType<int32>(), nullptr, "rle_repeatcounts_index");
+  llvm::Value* llvm_repeatcountsp_ptr = irb->CreateAlloca(
+      codegen_utils->GetType<uint8*>(), nullptr, "rle_repeatcountsp");
+
+  llvm::Value* llvm_supported = irb->CreateAnd(
+      irb->CreateAnd(
+          irb->CreateICmpEQ(
+              irb->CreateLoad(codegen_utils->GetPointerToMember(
+                  llvm_dsr_arg, &DatumStreamBlockRead::typeInfo,
+                  &DatumStreamTypeInfo::datumlen)),
+              codegen_utils->GetConstant<int32>(datumlen_)),
+          irb->CreateLoad(codegen_utils->GetPointerToMember(
+              llvm_dsr_arg, &DatumStreamBlockRead::typeInfo,
+              &DatumStreamTypeInfo::byval))),
+      irb->CreateNot(irb->CreateOr(
+          irb->CreateLoad(codegen_utils->GetPointerToMember(
+              llvm_dsr_arg, &DatumStreamBlockRead::delta_block_was_compressed)),
+          irb->CreateLoad(codegen_utils->GetPointerToMember(
+              llvm_dsr_arg, &DatumStreamBlockRead::dict_block_was_compressed)))));
+  irb->CreateCondBr(llvm_supported,
+                    main_block /* true */,
+                    fallback_block /* false */);
+
+  // Main block
+  // ----------
+  // Copy the read position of the block in
+  irb->SetInsertPoint(main_block);
+  llvm::Value* llvm_nth_member = codegen_utils->GetPointerToMember(
+      llvm_dsr_arg, &DatumStreamBlockRead::nth);
+  llvm::Value* llvm_datum_index_member = codegen_utils->GetPointerToMember(
+      llvm_dsr_arg, &DatumStreamBlockRead::physical_datum_index);
+  llvm::Value* llvm_datump_member = codegen_utils->GetPointerToMember(
+      llvm_dsr_arg, &DatumStreamBlockRead::datump);
+  llvm::Value* llvm_null_byte_ptr_member = codegen_utils->GetPointerToMember(
+      llvm_dsr_arg, &DatumStreamBlockRead::null_bitmap,
+      &DatumStreamBitMapRead::bytePointer);
+  llvm::Value* llvm_null_byte_bit_member = codegen_utils->GetPointerToMember(
+      llvm_dsr_arg, &DatumStreamBlockRead::null_bitmap,
+      &DatumStreamBitMapRead::byteBit);
+  llvm::Value* llvm_null_bit_position_member =
+      codegen_utils->GetPointerToMember(
+          llvm_dsr_arg, &DatumStreamBlockRead::null_bitmap,
+          &DatumStreamBitMapRead::bitPosition);
+  llvm::Value* llvm_compress_byte_ptr_member =
+      codegen_utils->GetPointerToMember(
+          llvm_dsr_arg, &DatumStreamBlockRead::rle_compress_bitmap,
+          &DatumStreamBitMapRead::bytePointer);
+  llvm::Value* llvm_compress_byte_bit_member =
+      codegen_utils->GetPointerToMember(
+          llvm_dsr_arg, &DatumStreamBlockRead::rle_compress_bitmap,
+          &DatumStreamBitMapRead::byteBit);
+  llvm::Value* llvm_compress_bit_position_member =
+      codegen_utils->GetPointerToMember(
+          llvm_dsr_arg, &DatumStreamBlockRead::rle_compress_bitmap,
+          &DatumStreamBitMapRead::bitPosition);
+  llvm::Value* llvm_in_repeated_item_member =
+      codegen_utils->GetPointerToMember(
+          llvm_dsr_arg, &DatumStreamBlockRead::rle_in_repeated_item);
+  llvm::Value* llvm_repeated_item_count_member =
+      codegen_utils->GetPointerToMember(
+          llvm_dsr_arg, &DatumStreamBlockRead::rle_repeated_item_count);
+  llvm::Value* llvm_total_repeat_items_read_member =
+      codegen_utils->GetPointerToMember(
+          llvm_dsr_arg, &DatumStreamBlockRead::rle_total_repeat_items_read);
+  llvm::Value* llvm_repeatcounts_index_member =
+      codegen_utils->GetPointerToMember(
+          llvm_dsr_arg, &DatumStreamBlockRead::rle_repeatcounts_index);
+  llvm::Value* llvm_repeatcountsp_member = codegen_utils->GetPointerToMember(
+      llvm_dsr_arg, &DatumStreamBlockRead::rle_repeatcountsp);
+
+  irb->CreateStore(codegen_utils->GetConstant<int>(0), llvm_row_ptr);
+  irb->CreateStore(irb->CreateLoad(llvm_nth_member), llvm_nth_ptr);
+  irb->CreateStore(irb->CreateLoad(llvm_datum_index_member),
+                   llvm_datum_index_ptr);
+  irb->CreateStore(irb->CreateLoad(llvm_datump_member), llvm_datump_ptr);
+  irb->CreateStore(irb->CreateLoad(llvm_null_byte_ptr_member),
+                   llvm_null_byte_ptr);
+  irb->CreateStore(irb->CreateLoad(llvm_null_byte_bit_member),
+                   llvm_null_byte_bit);
+  irb->CreateStore(irb->CreateLoad(llvm_null_bit_position_member),
+                   llvm_null_bit_position);
+  irb->CreateStore(irb->CreateLoad(llvm_compress_byte_ptr_member),
+                   llvm_compress_byte_ptr);
+  irb->CreateStore(irb->CreateLoad(llvm_compress_byte_bit_member),
+                   llvm_compress_byte_bit);
+  irb->CreateStore(irb->CreateLoad(llvm_compress_bit_position_member),
+                   llvm_compress_bit_position);
+  irb->CreateStore(irb->CreateLoad(llvm_in_repeated_item_member),
+                   llvm_in_repeated_item_ptr);
+  irb->CreateStore(irb->CreateLoad(llvm_repeated_item_count_member),
+                   llvm_repeated_item_count_ptr);
+  irb->CreateStore(irb->CreateLoad(llvm_total_repeat_items_read_member),
+                   llvm_total_repeat_items_read_ptr);
+  irb->CreateStore(irb->CreateLoad(llvm_repeatcounts_index_member),
+                   llvm_repeatcounts_index_ptr);
+  irb->CreateStore(irb->CreateLoad(llvm_repeatcountsp_member),
+                   llvm_repeatcountsp_ptr);
+
+  llvm::Value* llvm_has_null = irb->CreateLoad(
+      codegen_utils->GetPointerToMember(
+          llvm_dsr_arg, &DatumStreamBlockRead::has_null));
+  // Only Dense blocks are RLE_TYPE compressed
+  llvm::Value* llvm_rle = irb->CreateAnd(
+      irb->CreateICmpNE(
+          irb->CreateLoad(codegen_utils->GetPointerToMember(
+              llvm_dsr_arg, &DatumStreamBlockRead::datumStreamVersion)),
+          codegen_utils->GetConstant(DatumStreamVersion_Original)),
+      irb->CreateLoad(codegen_utils->GetPointerToMember(
+          llvm_dsr_arg, &DatumStreamBlockRead::rle_block_was_compressed)));
+  irb->CreateBr(row_loop_block);
+
+  // Row loop block
+  // --------------
+  // for (row = 0; row < nrows; row++)
+  irb->SetInsertPoint(row_loop_block);
+  llvm::Value* llvm_row = irb->CreateLoad(llvm_row_ptr);
+  irb->CreateCondBr(irb->CreateICmpSLT(llvm_row, llvm_nrows_arg),
+                    row_block /* true */,
+                    done_block /* false */);
+
+  // Row block
+  // ---------
+  irb->SetInsertPoint(row_block);
+  irb->CreateCondBr(
+      irb->CreateAnd(llvm_rle, irb->CreateLoad(llvm_in_repeated_item_ptr)),
+      repeat_block /* true */,
+      advance_block /* false */);
+
+  // Repeat block
+  // ------------
+  // The following rows repeat the current item. Instead of advancing to each
+  // of them, copy the item into as many rows as it repeats for, up to the end
+  // of the batch.
+  irb->SetInsertPoint(repeat_block);
+  llvm::Value* llvm_repeated_item_count =
+      irb->CreateLoad(llvm_repeated_item_count_ptr);
+  llvm::Value* llvm_rows_left = irb->CreateSub(llvm_nrows_arg, llvm_row);
+  llvm::Value* llvm_repeat_rows = irb->CreateSelect(
+      irb->CreateICmpSLT(llvm_repeated_item_count, llvm_rows_left),
+      llvm_repeated_item_count, llvm_rows_left);
+  llvm::Value* llvm_repeat_end = irb->CreateAdd(llvm_row, llvm_repeat_rows);
+  llvm::Value* llvm_repeat_value = irb->CreateZExt(
+      irb->CreateLoad(irb->CreateBitCast(irb->CreateLoad(llvm_datump_ptr),
+                                         llvm_datum_type->getPointerTo())),
+      codegen_utils->GetType<Datum>());
+  irb->CreateStore(llvm_row, llvm_fill_ptr);
+  irb->CreateBr(repeat_fill_loop_block);
+
+  irb->SetInsertPoint(repeat_fill_loop_block);
+  llvm::Value* llvm_fill = irb->CreateLoad(llvm_fill_ptr);
+  irb->CreateCondBr(irb->CreateICmpSLT(llvm_fill, llvm_repeat_end),
+                    repeat_fill_block /* true */,
+                    repeat_done_block /* false */);
+
+  irb->SetInsertPoint(repeat_fill_block);
+  irb->CreateStore(llvm_repeat_value,
+                   irb->CreateInBoundsGEP(llvm_values_arg, {llvm_fill}));
+  irb->CreateStore(codegen_utils->GetConstant<bool>(false),
+                   irb->CreateInBoundsGEP(llvm_nulls_arg, {llvm_fill}));
+  irb->CreateStore(
+      irb->CreateAdd(llvm_fill, codegen_utils->GetConstant<int>(1)),
+      llvm_fill_ptr);
+  irb->CreateBr(repeat_fill_loop_block);
+
+  irb->SetInsertPoint(repeat_done_block);
+  // nth += n; rle_repeated_item_count -= n; rle_total_repeat_items_read += n;
+  // rle_in_repeated_item = (rle_repeated_item_count > 0);
+  llvm::Value* llvm_repeat_left =
+      irb->CreateSub(llvm_repeated_item_count, llvm_repeat_rows);
+  irb->CreateStore(
+      irb->CreateAdd(irb->CreateLoad(llvm_nth_ptr), llvm_repeat_rows),
+      llvm_nth_ptr);
+  irb->CreateStore(llvm_repeat_left, llvm_repeated_item_count_ptr);
+  irb->CreateStore(
+      irb->CreateAdd(irb->CreateLoad(llvm_total_repeat_items_read_ptr),
+                     llvm_repeat_rows),
+      llvm_total_repeat_items_read_ptr);
+  irb->CreateStore(
+      irb->CreateICmpSGT(llvm_repeat_left,
+                         codegen_utils->GetConstant<int32>(0)),
+      llvm_in_repeated_item_ptr);
+  irb->CreateStore(llvm_repeat_end, llvm_row_ptr);
+  irb->CreateBr(row_loop_block);
+
+  // Advance block
+  // -------------
+  // ++nth; the caller made sure the rows are in this block.
+  irb->SetInsertPoint(advance_block);
+  irb->CreateStore(
+      irb->CreateAdd(irb->CreateLoad(llvm_nth_ptr),
+                     codegen_utils->GetConstant<int32>(1)),
+      llvm_nth_ptr);
+  irb->CreateCondBr(llvm_has_null,
+                    null_bitmap_block /* true */,
+                    not_null_row_block /* false */);
+
+  // Null bitmap block
+  // -----------------
+  irb->SetInsertPoint(null_bitmap_block);
+  irb->CreateCondBr(GenerateBitMapNext(codegen_utils,
+                                       llvm_null_byte_ptr,
+                                       llvm_null_byte_bit,
+                                       llvm_null_bit_position),
+                    null_row_block /* true */,
+                    not_null_row_block /* false */);
+
+  // Null row block
+  // --------------
+  irb->SetInsertPoint(null_row_block);
+  irb->CreateStore(codegen_utils->GetConstant<bool>(true),
+                   irb->CreateInBoundsGEP(llvm_nulls_arg, {llvm_row}));
+  irb->CreateStore(
+      irb->CreateAdd(llvm_row, codegen_utils->GetConstant<int>(1)),
+      llvm_row_ptr);
+  irb->CreateBr(row_loop_block);
+
+  // Not null row block
+  // ------------------
+  // A non-NULL item of an RLE_TYPE block may start a repeated item
+  irb->SetInsertPoint(not_null_row_block);
+  irb->CreateCondBr(llvm_rle,
+                    compress_bitmap_block /* true */,
+                    datum_block /* false */);
+
+  irb->SetInsertPoint(compress_bitmap_block);
+  irb->CreateCondBr(GenerateBitMapNext(codegen_utils,
+                                       llvm_compress_byte_ptr,
+                                       llvm_compress_byte_bit,
+                                       llvm_compress_bit_position),
+                    new_repeat_block /* true */,
+                    datum_block /* false */);
+
+  // New repeat block
+  // ----------------
+  irb->SetInsertPoint(new_repeat_block);
+  llvm::Value* llvm_repeat_count = GenerateRepeatCountDecode(
+      codegen_utils, get_batch_func, llvm_repeatcountsp_ptr);
+  irb->CreateStore(
+      irb->CreateAdd(irb->CreateLoad(llvm_repeatcounts_index_ptr),
+                     codegen_utils->GetConstant<int32>(1)),
+      llvm_repeatcounts_index_ptr);
+  irb->CreateStore(
+      irb->CreateAdd(irb->CreateLoad(llvm_total_repeat_items_read_ptr),
+                     codegen_utils->GetConstant<int32>(1)),
+      llvm_total_repeat_items_read_ptr);
+  irb->CreateStore(llvm_repeat_count, llvm_repeated_item_count_ptr);
+  irb->CreateStore(codegen_utils->GetConstant<bool>(true),
+                   llvm_in_repeated_item_ptr);
+  irb->CreateBr(datum_block);
+
+  // Datum block
+  // -----------
+  // ++physical_datum_index; the first item is pre-positioned by the block
+  // read, move past the previous one for the others.
+  irb->SetInsertPoint(datum_block);
+  llvm::Value* llvm_datum_index = irb->CreateAdd(
+      irb->CreateLoad(llvm_datum_index_ptr),
+      codegen_utils->GetConstant<int32>(1));
+  irb->CreateStore(llvm_datum_index, llvm_datum_index_ptr);
+  llvm::Value* llvm_datump = irb->CreateLoad(llvm_datump_ptr);
+  llvm_datump = irb->CreateSelect(
+      irb->CreateICmpEQ(llvm_datum_index,
+                        codegen_utils->GetConstant<int32>(0)),
+      llvm_datump,
+      irb->CreateInBoundsGEP(llvm_datump,
+                             {codegen_utils->GetConstant<int32>(datumlen_)}));
+  irb->CreateStore(llvm_datump, llvm_datump_ptr);
+  irb->CreateStore(
+      irb->CreateZExt(
+          irb->CreateLoad(irb->CreateBitCast(llvm_datump,
+                                             llvm_datum_type->getPointerTo())),
+          codegen_utils->GetType<Datum>()),
+      irb->CreateInBoundsGEP(llvm_values_arg, {llvm_row}));
+  irb->CreateStore(codegen_utils->GetConstant<bool>(false),
+                   irb->CreateInBoundsGEP(llvm_nulls_arg, {llvm_row}));
+  irb->CreateStore(
+      irb->CreateAdd(llvm_row, codegen_utils->GetConstant<int>(1)),
+      llvm_row_ptr);
+  irb->CreateBr(row_loop_block);
+
+  // Done block
+  // ----------
+  // Copy the read position back, for the next batch
+  irb->SetInsertPoint(done_block);
+  irb->CreateStore(irb->CreateLoad(llvm_nth_ptr), llvm_nth_member);
+  irb->CreateStore(irb->CreateLoad(llvm_datum_index_ptr),
+                   llvm_datum_index_member);
+  irb->CreateStore(irb->CreateLoad(llvm_datump_ptr), llvm_datump_member);
+  irb->CreateStore(irb->CreateLoad(llvm_null_byte_ptr),
+                   llvm_null_byte_ptr_member);
+  irb->CreateStore(irb->CreateLoad(llvm_null_byte_bit),
+                   llvm_null_byte_bit_member);
+  irb->CreateStore(irb->CreateLoad(llvm_null_bit_position),
+                   llvm_null_bit_position_member);
+  irb->CreateStore(irb->CreateLoad(llvm_compress_byte_ptr),
+                   llvm_compress_byte_ptr_member);
+  irb->CreateStore(irb->CreateLoad(llvm_compress_byte_bit),
+                   llvm_compress_byte_bit_member);
+  irb->CreateStore(irb->CreateLoad(llvm_compress_bit_position),
+                   llvm_compress_bit_position_member);
+  irb->CreateStore(irb->CreateLoad(llvm_in_repeated_item_ptr),
+                   llvm_in_repeated_item_member);
+  irb->CreateStore(irb->CreateLoad(llvm_repeated_item_count_ptr),
+                   llvm_repeated_item_count_member);
+  irb->CreateStore(irb->CreateLoad(llvm_total_repeat_items_read_ptr),
+                   llvm_total_repeat_items_read_member);
+  irb->CreateStore(irb->CreateLoad(llvm_repeatcounts_index_ptr),
+                   llvm_repeatcounts_index_member);
+  irb->CreateStore(irb->CreateLoad(llvm_repeatcountsp_ptr),
+                   llvm_repeatcountsp_member);
+  irb->CreateRetVoid();
+
+  // Fallback block
+  // --------------
+  irb->SetInsertPoint(fallback_block);
+  codegen_utils->CreateFallback<DatumStreamBlockReadGetBatchFn>(
+      codegen_utils->GetOrRegisterExternalFunction(
+          DatumStreamBlockRead_GetBatch,
+          "DatumStreamBlockRead_GetBatch"),
+      get_batch_func);
+  return true;
+}
+
+bool DatumStreamBlockReadGetBatchCodegen::GenerateCodeInternal(
+    GpCodegenUtils* codegen_utils) {
+  bool isGenerated = GenerateGetBatch(codegen_utils);
+
+  if (isGenerated) {
+    elog(DEBUG1, "DatumStreamBlockRead_GetBatch was generated successfully!");
+    return true;
+  } else {
+    elog(DEBUG1, "DatumStreamBlockRead_GetBatch generation failed!");
+    return false;
+  }
+}
@@ -87,6 +87,10 @@ void ExecEvalExprCodegen::PrepareSlotGetAttr() {
         assert(nullptr != slot);
       }
       break;
+    case T_HashJoinState:
+      // Join clauses read Vars from both the outer and the inner slot, whose
+      // tuple descriptors differ, so use the regular slot_getattr().
+      break;
     case T_AggState:
       // For now, we assume that tuples for the Aggs are already going to be
       // deformed in which case, we can avoid generating and calling the
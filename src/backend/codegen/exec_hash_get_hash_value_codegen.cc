@@ -0,0 +1,370 @@
+//---------------------------------------------------------------------------
+//  Greenplum Database
+//  Copyright (C) 2016 Pivotal Software, Inc.
+//
+//  @filename:
+//    exec_hash_get_hash_value_codegen.cc
+//
+//  @doc:
+//    Generates code for ExecHashGetHashValue function.
+//
+//---------------------------------------------------------------------------
+#include <assert.h>
+#include <stddef.h>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "codegen/base_codegen.h"
+#include "codegen/codegen_wrapper.h"
+#include "codegen/exec_hash_get_hash_value_codegen.h"
+#include "codegen/expr_tree_generator.h"
+#include "codegen/op_expr_tree_generator.h"
+#include "codegen/utils/gp_codegen_utils.h"
+#include "codegen/utils/utility.h"
+
+#include "llvm/IR/Argument.h"
+#include "llvm/IR/Constant.h"
+#include "llvm/IR/IRBuilder.h"
+#include "llvm/IR/Instructions.h"
+
+extern "C" {
+#include "postgres.h"  // NOLINT(build/include)
+#include "access/hash.h"
+#include "executor/nodeHash.h"
+#include "nodes/execnodes.h"
+#include "nodes/pg_list.h"
+#include "utils/elog.h"
+#include "utils/fmgroids.h"
+#include "utils/lsyscache.h"
+}
+
+namespace llvm {
+class BasicBlock;
+class Function;
+class Value;
+}  // namespace llvm
+
+using gpcodegen::ExecHashGetHashValueCodegen;
+
+constexpr char ExecHashGetHashValueCodegen::kExecHashGetHashValuePrefix[];
+
+ExecHashGetHashValueCodegen::ExecHashGetHashValueCodegen(
+    CodegenManager* manager,
+    ExecHashGetHashValueFn regular_func_ptr,
+    ExecHashGetHashValueFn* ptr_to_regular_func_ptr,
+    List *hashkeys,
+    List *hash_operators,
+    bool outer_tuple,
+    ExprContext *econtext)
+    : BaseCodegen(manager,
+                  kExecHashGetHashValuePrefix,
+                  regular_func_ptr, ptr_to_regular_func_ptr),
+      hashkeys_(hashkeys),
+      hash_operators_(hash_operators),
+      outer_tuple_(outer_tuple),
+      gen_info_(econtext, nullptr, nullptr, nullptr, 0),
+      keys_supported_(false) {
+}
+
+bool ExecHashGetHashValueCodegen::IsHashFunctionSupported(Oid hash_func) {
+  switch (hash_func) {
+    case F_HASHINT2:
+    case F_HASHINT4:
+    case F_HASHINT8:
+    case F_HASHOID:
+    case F_HASHCHAR:
+      return true;
+    default:
+      return false;
+  }
+}
+
+bool ExecHashGetHashValueCodegen::InitDependencies() {
+  OpExprTreeGenerator::InitializeSupportedFunction();
+
+  if (nullptr == hashkeys_ ||
+      list_length(hashkeys_) != list_length(hash_operators_)) {
+    return true;
+  }
+
+  // Look up the hash functions the same way ExecHashTableCreate() does
+  ListCell *lk;
+  ListCell *lo;
+  forboth(lk, hashkeys_, lo, hash_operators_) {
+    ExprState *keyexpr = reinterpret_cast<ExprState*>(lfirst(lk));
+    Oid hashop = lfirst_oid(lo);
+    Oid left_hashfn;
+    Oid right_hashfn;
+    HashKeyInfo key;
+
+    if (!get_op_hash_functions(hashop, &left_hashfn, &right_hashfn)) {
+      return true;
+    }
+    key.hash_func = outer_tuple_ ? left_hashfn : right_hashfn;
+    key.strict = op_strict(hashop);
+
+    if (!IsHashFunctionSupported(key.hash_func)) {
+      elog(DEBUG1, "Unsupported hash function %u for ExecHashGetHashValue",
+           key.hash_func);
+      return true;
+    }
+    if (!ExprTreeGenerator::VerifyAndCreateExprTree(
+        keyexpr, &gen_info_, &key.expr_tree)) {
+      return true;
+    }
+    keys_.push_back(std::move(key));
+  }
+  keys_supported_ = true;
+  return true;
+}
+
+llvm::Value* ExecHashGetHashValueCodegen::GenerateHashFunction(
+    gpcodegen::GpCodegenUtils* codegen_utils,
+    Oid hash_func,
+    llvm::Value* llvm_keyval) {
+  auto irb = codegen_utils->ir_builder();
+  llvm::Function* llvm_hash_uint32 =
+      codegen_utils->GetOrRegisterExternalFunction(hash_uint32,
+                                                   "hash_uint32");
+  llvm::Value* llvm_key = nullptr;
+
+  switch (hash_func) {
+    case F_HASHINT2:
+      // hash_uint32((int32) PG_GETARG_INT16(0))
+      llvm_key = irb->CreateSExt(
+          codegen_utils->CreateDatumToCppTypeCast<int16_t>(llvm_keyval),
+          codegen_utils->GetType<int32_t>());
+      break;
+    case F_HASHCHAR:
+      // hash_uint32((int32) PG_GETARG_CHAR(0))
+      llvm_key = irb->CreateSExt(
+          codegen_utils->CreateDatumToCppTypeCast<int8_t>(llvm_keyval),
+          codegen_utils->GetType<int32_t>());
+      break;
+    case F_HASHINT4:
+    case F_HASHOID:
+      // hash_uint32(PG_GETARG_INT32(0))
+      llvm_key = codegen_utils->CreateDatumToCppTypeCast<int32_t>(llvm_keyval);
+      break;
+    case F_HASHINT8: {
+      // lohalf ^= (val >= 0) ? hihalf : ~hihalf;
+      // hash_uint32(lohalf)
+      llvm::Value* llvm_val =
+          codegen_utils->CreateDatumToCppTypeCast<int64_t>(llvm_keyval);
+      llvm::Value* llvm_lohalf = irb->CreateTrunc(
+          llvm_val, codegen_utils->GetType<uint32_t>());
+      llvm::Value* llvm_hihalf = irb->CreateTrunc(
+          irb->CreateLShr(llvm_val, 32), codegen_utils->GetType<uint32_t>());
+      llvm_key = irb->CreateXor(
+          llvm_lohalf,
+          irb->CreateSelect(
+              irb->CreateICmpSGE(llvm_val,
+                                 codegen_utils->GetConstant<int64_t>(0)),
+              llvm_hihalf,
+              irb->CreateNot(llvm_hihalf)));
+      break;
+    }
+    default:
+      assert(false);
+      return nullptr;
+  }
+
+  // DatumGetUInt32(hash_uint32(key))
+  return codegen_utils->CreateDatumToCppTypeCast<uint32_t>(
+      irb->CreateCall(llvm_hash_uint32, {llvm_key}));
+}
+
+bool ExecHashGetHashValueCodegen::GenerateExecHashGetHashValue(
+    gpcodegen::GpCodegenUtils* codegen_utils) {
+
+  assert(NULL != codegen_utils);
+  if (!keys_supported_ ||
+      keys_.empty() ||
+      nullptr == gen_info_.econtext) {
+    return false;
+  }
+
+  // Every key Var may come from a different slot, so use the regular
+  // slot_getattr()
+  gen_info_.llvm_slot_getattr_func =
+      codegen_utils->GetOrRegisterExternalFunction(slot_getattr_regular,
+                                                   "slot_getattr_regular");
+
+  llvm::Function* exec_hash_get_hash_value_func =
+      CreateFunction<ExecHashGetHashValueFn>(codegen_utils,
+                                             GetUniqueFuncName());
+
+  auto irb = codegen_utils->ir_builder();
+
+  // BasicBlocks
+  llvm::BasicBlock* entry_block = codegen_utils->CreateBasicBlock(
+      "entry", exec_hash_get_hash_value_func);
+  llvm::BasicBlock* main_block = codegen_utils->CreateBasicBlock(
+      "main", exec_hash_get_hash_value_func);
+  llvm::BasicBlock* error_block = codegen_utils->CreateBasicBlock(
+      "error_block", exec_hash_get_hash_value_func);
+  llvm::BasicBlock* fallback_block = codegen_utils->CreateBasicBlock(
+      "fallback", exec_hash_get_hash_value_func);
+
+  gen_info_.llvm_main_func = exec_hash_get_hash_value_func;
+  gen_info_.llvm_error_block = error_block;
+
+  // Generation-time constants
+  llvm::Value* llvm_econtext = codegen_utils->GetConstant(gen_info_.econtext);
+  llvm::Value* llvm_hashkeys = codegen_utils->GetConstant(hashkeys_);
+
+  // Function arguments to ExecHashGetHashValue
+  llvm::Value* llvm_econtext_arg =
+      ArgumentByPosition(exec_hash_get_hash_value_func, 2);
+  llvm::Value* llvm_hashkeys_arg =
+      ArgumentByPosition(exec_hash_get_hash_value_func, 3);
+  llvm::Value* llvm_keep_nulls_arg =
+      ArgumentByPosition(exec_hash_get_hash_value_func, 5);
+  llvm::Value* llvm_hashvalue_arg =
+      ArgumentByPosition(exec_hash_get_hash_value_func, 6);
+  llvm::Value* llvm_hashkeys_null_arg =
+      ArgumentByPosition(exec_hash_get_hash_value_func, 7);
+
+  // Entry block
+  // -----------
+  // Fall back when called for other keys or in another context than the ones
+  // we generated the function for.
+  irb->SetInsertPoint(entry_block);
+#ifdef CODEGEN_DEBUG
+  EXPAND_CREATE_ELOG(codegen_utils,
+                     DEBUG1,
+                     "Codegen'ed ExecHashGetHashValue called!");
+#endif
+  irb->CreateCondBr(
+      irb->CreateAnd(irb->CreateICmpEQ(llvm_econtext, llvm_econtext_arg),
+                     irb->CreateICmpEQ(llvm_hashkeys, llvm_hashkeys_arg)),
+      main_block /* true */,
+      fallback_block /* false */);
+
+  // Main block
+  // ----------
+  // The keys we support are evaluated without allocating memory, so unlike
+  // the regular function we don't need to reset and switch to the per-tuple
+  // memory context.
+  irb->SetInsertPoint(main_block);
+  llvm::Value* llvm_hashkey_ptr = irb->CreateAlloca(
+      codegen_utils->GetType<uint32_t>(), nullptr, "hashkey");
+  llvm::Value* llvm_result_ptr = irb->CreateAlloca(
+      codegen_utils->GetType<bool>(), nullptr, "result");
+  llvm::Value* llvm_isnull_ptr = irb->CreateAlloca(
+      codegen_utils->GetType<bool>(), nullptr, "isNull");
+  irb->CreateStore(codegen_utils->GetConstant<uint32_t>(0), llvm_hashkey_ptr);
+  irb->CreateStore(codegen_utils->GetConstant<bool>(true), llvm_result_ptr);
+  // *hashkeys_null = true;
+  irb->CreateStore(codegen_utils->GetConstant<bool>(true),
+                   llvm_hashkeys_null_arg);
+
+  for (size_t i = 0; i < keys_.size(); ++i) {
+    HashKeyInfo& key = keys_[i];
+    llvm::BasicBlock* null_block = codegen_utils->CreateBasicBlock(
+        "null_key_" + std::to_string(i), exec_hash_get_hash_value_func);
+    llvm::BasicBlock* not_null_block = codegen_utils->CreateBasicBlock(
+        "not_null_key_" + std::to_string(i), exec_hash_get_hash_value_func);
+    llvm::BasicBlock* hash_block = codegen_utils->CreateBasicBlock(
+        "hash_key_" + std::to_string(i), exec_hash_get_hash_value_func);
+    llvm::BasicBlock* next_block = codegen_utils->CreateBasicBlock(
+        "next_key_" + std::to_string(i), exec_hash_get_hash_value_func);
+
+    // hashkey = (hashkey << 1) | ((hashkey & 0x80000000) ? 1 : 0);
+    llvm::Value* llvm_hashkey = irb->CreateLoad(llvm_hashkey_ptr);
+    irb->CreateStore(
+        irb->CreateOr(irb->CreateShl(llvm_hashkey, 1),
+                      irb->CreateLShr(llvm_hashkey, 31)),
+        llvm_hashkey_ptr);
+
+    // keyval = ExecEvalExpr(keyexpr, econtext, &isNull, NULL);
+    irb->CreateStore(codegen_utils->GetConstant<bool>(false),
+                     llvm_isnull_ptr);
+    llvm::Value* llvm_keyval = nullptr;
+    if (!key.expr_tree->GenerateCode(codegen_utils,
+                                     gen_info_,
+                                     &llvm_keyval,
+                                     llvm_isnull_ptr) ||
+        nullptr == llvm_keyval) {
+      return false;
+    }
+    irb->CreateCondBr(irb->CreateLoad(llvm_isnull_ptr),
+                      null_block /* true */,
+                      not_null_block /* false */);
+
+    // null_key_i
+    // ----------
+    // A NULL key of a strict operator can't match, unless we keep nulls;
+    // otherwise it hashes as zero, which leaves hashkey unmodified.
+    irb->SetInsertPoint(null_block);
+    if (key.strict) {
+      irb->CreateStore(
+          irb->CreateAnd(irb->CreateLoad(llvm_result_ptr),
+                         llvm_keep_nulls_arg),
+          llvm_result_ptr);
+    }
+    irb->CreateBr(next_block);
+
+    // not_null_key_i
+    // --------------
+    irb->SetInsertPoint(not_null_block);
+    irb->CreateStore(codegen_utils->GetConstant<bool>(false),
+                     llvm_hashkeys_null_arg);
+    irb->CreateCondBr(irb->CreateLoad(llvm_result_ptr),
+                      hash_block /* true */,
+                      next_block /* false */);
+
+    // hash_key_i
+    // ----------
+    // hashkey ^= DatumGetUInt32(FunctionCall1(&hashfunctions[i], keyval));
+    irb->SetInsertPoint(hash_block);
+    llvm::Value* llvm_hkey = GenerateHashFunction(
+        codegen_utils, key.hash_func, llvm_keyval);
+    irb->CreateStore(
+        irb->CreateXor(irb->CreateLoad(llvm_hashkey_ptr), llvm_hkey),
+        llvm_hashkey_ptr);
+    irb->CreateBr(next_block);
+
+    irb->SetInsertPoint(next_block);
+  }
+
+  // *hashvalue = hashkey;
+  irb->CreateStore(irb->CreateLoad(llvm_hashkey_ptr), llvm_hashvalue_arg);
+  irb->CreateRet(irb->CreateLoad(llvm_result_ptr));
+
+  // Error block
+  // -----------
+  // Reached only after an ereport(ERROR) raised by a key expression
+  irb->SetInsertPoint(error_block);
+  irb->CreateRet(codegen_utils->GetConstant<bool>(false));
+
+  // Fall back Block
+  // ---------------
+  irb->SetInsertPoint(fallback_block);
+  EXPAND_CREATE_ELOG(codegen_utils,
+                     DEBUG1,
+                     "Falling back to regular ExecHashGetHashValue");
+
+  codegen_utils->CreateFallback<ExecHashGetHashValueFn>(
+      codegen_utils->GetOrRegisterExternalFunction(ExecHashGetHashValue,
+                                                   "ExecHashGetHashValue"),
+      exec_hash_get_hash_value_func);
+
+  return true;
+}
+
+bool ExecHashGetHashValueCodegen::GenerateCodeInternal(
+    GpCodegenUtils* codegen_utils) {
+  bool isGenerated = GenerateExecHashGetHashValue(codegen_utils);
+
+  if (isGenerated) {
+    elog(DEBUG1, "ExecHashGetHashValue was generated successfully!");
+    return true;
+  } else {
+    elog(DEBUG1, "ExecHashGetHashValue generation failed!");
+    return false;
+  }
+}
@@ -0,0 +1,287 @@
+//---------------------------------------------------------------------------
+//  Greenplum Database
+//  Copyright (C) 2016 Pivotal Software, Inc.
+//
+//  @filename:
+//    exec_scan_qual_project_codegen.cc
+//
+//  @doc:
+//    Generates code for ExecScanQualProject function.
+//
+//---------------------------------------------------------------------------
+#include <assert.h>
+#include <stddef.h>
+#include <algorithm>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+#include "codegen/base_codegen.h"
+#include "codegen/codegen_wrapper.h"
+#include "codegen/exec_scan_qual_project_codegen.h"
+#include "codegen/expr_tree_generator.h"
+#include "codegen/op_expr_tree_generator.h"
+#include "codegen/slot_getattr_codegen.h"
+#include "codegen/utils/gp_codegen_utils.h"
+#include "codegen/utils/utility.h"
+
+#include "llvm/IR/Argument.h"
+#include "llvm/IR/Constant.h"
+#include "llvm/IR/IRBuilder.h"
+
+extern "C" {
+#include "postgres.h"  // NOLINT(build/include)
+#include "executor/executor.h"
+#include "executor/tuptable.h"
+#include "nodes/execnodes.h"
+#include "nodes/nodes.h"
+#include "nodes/pg_list.h"
+#include "utils/elog.h"
+#include "utils/palloc.h"
+}
+
+namespace llvm {
+class BasicBlock;
+class Function;
+class Value;
+}  // namespace llvm
+
+using gpcodegen::ExecScanQualProjectCodegen;
+using gpcodegen::SlotGetAttrCodegen;
+
+constexpr char ExecScanQualProjectCodegen::kExecScanQualProjectPrefix[];
+
+ExecScanQualProjectCodegen::ExecScanQualProjectCodegen(
+    CodegenManager* manager,
+    ExecScanQualProjectFn regular_func_ptr,
+    ExecScanQualProjectFn* ptr_to_regular_func_ptr,
+    ScanState* scan_state)
+    : BaseCodegen(manager,
+                  kExecScanQualProjectPrefix,
+                  regular_func_ptr, ptr_to_regular_func_ptr),
+      scan_state_(scan_state),
+      gen_info_(scan_state->ps.ps_ExprContext, nullptr, nullptr, nullptr, 0),
+      slot_getattr_codegen_(nullptr),
+      project_var_list_(false) {
+}
+
+bool ExecScanQualProjectCodegen::InitDependencies() {
+  assert(nullptr != scan_state_);
+  OpExprTreeGenerator::InitializeSupportedFunction();
+
+  // Create the generators of the quals; a nullptr records an unsupported one
+  ListCell* l;
+  foreach(l, scan_state_->ps.qual) {
+    ExprState* exprstate = static_cast<ExprState*>(lfirst(l));
+    std::unique_ptr<ExprTreeGenerator> expr_tree_generator;
+    ExprTreeGenerator::VerifyAndCreateExprTree(
+        exprstate, &gen_info_, &expr_tree_generator);
+    qual_generators_.push_back(std::move(expr_tree_generator));
+  }
+
+  // A simple Var list of the scan tuple is extracted with the same
+  // slot_getattr() as the quals
+  ProjectionInfo* proj_info = scan_state_->ps.ps_ProjInfo;
+  if (nullptr != proj_info &&
+      proj_info->pi_isVarList &&
+      nullptr != proj_info->pi_varSlotOffsets) {
+    project_var_list_ = true;
+    for (int i = 0; i < list_length(proj_info->pi_targetlist); ++i) {
+      if (proj_info->pi_varSlotOffsets[i] !=
+          offsetof(ExprContext, ecxt_scantuple) ||
+          proj_info->pi_varNumbers[i] <= 0) {
+        project_var_list_ = false;
+        break;
+      }
+    }
+    if (project_var_list_) {
+      for (int i = 0; i < list_length(proj_info->pi_targetlist); ++i) {
+        gen_info_.max_attr = std::max<int16_t>(gen_info_.max_attr,
+                                               proj_info->pi_varNumbers[i]);
+      }
+    }
+  }
+
+  // Prepare dependent slot_getattr() generation, so that the scan tuple is
+  // deformed once for both the quals and the projection
+  if (gen_info_.max_attr > 0) {
+    slot_getattr_codegen_ = SlotGetAttrCodegen::GetCodegenInstance(
+        manager(), scan_state_->ss_ScanTupleSlot, gen_info_.max_attr);
+  }
+  return true;
+}
+
+bool ExecScanQualProjectCodegen::GenerateExecScanQualProject(
+    gpcodegen::GpCodegenUtils* codegen_utils) {
+  assert(NULL != codegen_utils);
+  ExprContext* econtext = scan_state_->ps.ps_ExprContext;
+  ProjectionInfo* proj_info = scan_state_->ps.ps_ProjInfo;
+  if (nullptr == econtext) {
+    return false;
+  }
+
+  for (const std::unique_ptr<ExprTreeGenerator>& qual_generator :
+      qual_generators_) {
+    if (nullptr == qual_generator) {
+      elog(DEBUG1, "Cannot generate code for ExecScanQualProject "
+                   "because a qual is not supported.");
+      return false;
+    }
+  }
+
+  // If slot_getattr_codegen_ is not set or generation fails
+  // we revert to use the external slot_getattr()
+  if (nullptr == slot_getattr_codegen_ ||
+      false == slot_getattr_codegen_->GenerateCode(codegen_utils)) {
+    gen_info_.llvm_slot_getattr_func =
+        codegen_utils->GetOrRegisterExternalFunction(slot_getattr_regular,
+                                                     "slot_getattr_regular");
+  } else {
+    gen_info_.llvm_slot_getattr_func =
+        slot_getattr_codegen_->GetGeneratedFunction();
+    assert(nullptr != gen_info_.llvm_slot_getattr_func);
+  }
+
+  // External functions
+  llvm::Function* llvm_MemoryContextSwitchTo =
+      codegen_utils->GetOrRegisterExternalFunction(MemoryContextSwitchTo,
+                                                   "MemoryContextSwitchTo");
+  llvm::Function* llvm_ExecClearTuple =
+      codegen_utils->GetOrRegisterExternalFunction(ExecClearTuple,
+                                                   "ExecClearTuple");
+  llvm::Function* llvm_ExecStoreVirtualTuple =
+      codegen_utils->GetOrRegisterExternalFunction(ExecStoreVirtualTuple,
+                                                   "ExecStoreVirtualTuple");
+  llvm::Function* llvm_ExecProject =
+      codegen_utils->GetOrRegisterExternalFunction(ExecProject,
+                                                   "ExecProject");
+
+  llvm::Function* exec_scan_qual_project_func =
+      CreateFunction<ExecScanQualProjectFn>(
+          codegen_utils, GetUniqueFuncName());
+
+  // BasicBlocks
+  llvm::BasicBlock* entry_block = codegen_utils->CreateBasicBlock(
+      "entry", exec_scan_qual_project_func);
+  // BasicBlock for a tuple that fails a qual
+  llvm::BasicBlock* qual_failed_block = codegen_utils->CreateBasicBlock(
+      "qual_failed", exec_scan_qual_project_func);
+  llvm::BasicBlock* error_block = codegen_utils->CreateBasicBlock(
+      "error_block", exec_scan_qual_project_func);
+
+  gen_info_.llvm_main_func = exec_scan_qual_project_func;
+  gen_info_.llvm_error_block = error_block;
+
+  auto irb = codegen_utils->ir_builder();
+
+  // Entry block
+  // -----------
+  irb->SetInsertPoint(entry_block);
+#ifdef CODEGEN_DEBUG
+  EXPAND_CREATE_ELOG(codegen_utils,
+                     DEBUG1,
+                     "Codegen'ed ExecScanQualProject called!");
+#endif
+
+  // Evaluate in the per-tuple memory, as ExecQual does
+  // oldContext = MemoryContextSwitchTo(econtext->ecxt_per_tuple_memory);
+  llvm::Value* llvm_oldContext = irb->CreateCall(
+      llvm_MemoryContextSwitchTo, {
+          codegen_utils->GetConstant<MemoryContext>(
+              econtext->ecxt_per_tuple_memory)});
+  llvm::Value* llvm_isnull_ptr = irb->CreateAlloca(
+      codegen_utils->GetType<bool>(), nullptr, "isnull");
+
+  // Quals
+  // -----
+  // if (isNull || !DatumGetBool(expr_value)) return false;
+  for (const std::unique_ptr<ExprTreeGenerator>& qual_generator :
+      qual_generators_) {
+    llvm::Value* llvm_qual_value = nullptr;
+    if (!qual_generator->GenerateCode(codegen_utils, gen_info_,
+                                      &llvm_qual_value, llvm_isnull_ptr) ||
+        nullptr == llvm_qual_value) {
+      return false;
+    }
+    llvm::BasicBlock* qual_passed_block = codegen_utils->CreateBasicBlock(
+        "qual_passed", exec_scan_qual_project_func);
+    irb->CreateCondBr(
+        irb->CreateOr(
+            irb->CreateLoad(llvm_isnull_ptr),
+            irb->CreateICmpEQ(
+                codegen_utils->CreateCppTypeToDatumCast(llvm_qual_value),
+                codegen_utils->GetConstant<Datum>(0))),
+        qual_failed_block /* true */,
+        qual_passed_block /* false */);
+    irb->SetInsertPoint(qual_passed_block);
+  }
+
+  // Projection
+  // ----------
+  if (project_var_list_) {
+    // Like ExecProject() with call_ExecVariableList(), but the attributes
+    // come from the scan tuple that the quals already deformed
+    llvm::Value* llvm_result_slot = codegen_utils->GetConstant(
+        proj_info->pi_slot);
+    irb->CreateCall(llvm_ExecClearTuple, {llvm_result_slot});
+    llvm::Value* llvm_values = irb->CreateLoad(
+        codegen_utils->GetPointerToMember(
+            llvm_result_slot, &TupleTableSlot::PRIVATE_tts_values));
+    llvm::Value* llvm_isnulls = irb->CreateLoad(
+        codegen_utils->GetPointerToMember(
+            llvm_result_slot, &TupleTableSlot::PRIVATE_tts_isnull));
+    llvm::Value* llvm_scan_slot = irb->CreateLoad(
+        codegen_utils->GetConstant(&econtext->ecxt_scantuple));
+    for (int i = list_length(proj_info->pi_targetlist) - 1; i >= 0; i--) {
+      // values[i] = slot_getattr(varSlot, varNumber, &(isnull[i]));
+      llvm::Value* llvm_value = irb->CreateCall(
+          gen_info_.llvm_slot_getattr_func, {
+              llvm_scan_slot,
+              codegen_utils->GetConstant<int32_t>(
+                  proj_info->pi_varNumbers[i]),
+              irb->CreateInBoundsGEP(codegen_utils->GetType<bool>(),
+                                     llvm_isnulls,
+                                     codegen_utils->GetConstant(i))});
+      irb->CreateStore(llvm_value,
+                       irb->CreateInBoundsGEP(codegen_utils->GetType<Datum>(),
+                                              llvm_values,
+                                              codegen_utils->GetConstant(i)));
+    }
+    irb->CreateCall(llvm_ExecStoreVirtualTuple, {llvm_result_slot});
+    irb->CreateCall(llvm_MemoryContextSwitchTo, {llvm_oldContext});
+  } else {
+    irb->CreateCall(llvm_MemoryContextSwitchTo, {llvm_oldContext});
+    if (nullptr != proj_info) {
+      irb->CreateCall(llvm_ExecProject, {
+          codegen_utils->GetConstant(proj_info),
+          codegen_utils->GetConstant<ExprDoneCond*>(nullptr)});
+    }
+  }
+  irb->CreateRet(codegen_utils->GetConstant<bool>(true));
+
+  // Qual failed block
+  // -----------------
+  irb->SetInsertPoint(qual_failed_block);
+  irb->CreateCall(llvm_MemoryContextSwitchTo, {llvm_oldContext});
+  irb->CreateRet(codegen_utils->GetConstant<bool>(false));
+
+  // Error block
+  // -----------
+  irb->SetInsertPoint(error_block);
+  irb->CreateCall(llvm_MemoryContextSwitchTo, {llvm_oldContext});
+  irb->CreateRet(codegen_utils->GetConstant<bool>(false));
+  return true;
+}
+
+bool ExecScanQualProjectCodegen::GenerateCodeInternal(
+    GpCodegenUtils* codegen_utils) {
+  bool isGenerated = GenerateExecScanQualProject(codegen_utils);
+
+  if (isGenerated) {
+    elog(DEBUG1, "ExecScanQualProject was generated successfully!");
+    return true;
+  } else {
+    elog(DEBUG1, "ExecScanQualProject generation failed!");
+    return false;
+  }
+}
@@ -34,6 +34,15 @@ bool ExprTreeGenerator::VerifyAndCreateExprTree(
          nullptr != expr_state->expr &&
          nullptr != expr_tree);
 
+  // A RelabelType (e.g. varchar to text) evaluates to its argument's Datum
+  if (IsA(expr_state, GenericExprState) &&
+      IsA(expr_state->expr, RelabelType)) {
+    return VerifyAndCreateExprTree(
+        reinterpret_cast<const GenericExprState*>(expr_state)->arg,
+        gen_info,
+        expr_tree);
+  }
+
   if (!(IsA(expr_state, FuncExprState) ||
       IsA(expr_state, ExprState))) {
     elog(DEBUG1, "Input expression state type (%d) is not supported",
@@ -53,7 +53,9 @@ class AdvanceAggregatesCodegen: public BaseCodegen<AdvanceAggregatesFn> {
    *
    * @return true on successful generation; false otherwise.
    *
-   * This implementation does not support percentile and ordered aggregates.
+   * This implementation does not support percentile aggregates, and DISTINCT
+   * or ORDER BY aggregates with more than one input. Transition functions
+   * without a generator are called through the fmgr.
    *
    * If at execution time, we see any of the above types of attributes,
    * we fall backs to the regular function.
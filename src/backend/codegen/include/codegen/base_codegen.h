@@ -175,7 +175,8 @@ class BaseCodegen: public CodegenInterface {
                        FuncPtrType* ptr_to_chosen_func_ptr)
   : manager_(manager),
     orig_func_name_(orig_func_name),
-    unique_func_name_(CodegenInterface::GenerateUniqueName(orig_func_name)),
+    unique_func_name_(CodegenInterface::GenerateUniqueName(orig_func_name,
+                                                        manager)),
     regular_func_ptr_(regular_func_ptr),
     ptr_to_chosen_func_ptr_(ptr_to_chosen_func_ptr),
     is_generated_(false) {
@@ -21,11 +21,16 @@ extern bool codegen_exec_variable_list;
 extern bool codegen_slot_getattr;
 extern bool codegen_exec_eval_expr;
 extern bool codegen_advance_aggregate;
+extern bool codegen_exec_hash_get_hash_value;
+extern bool codegen_datumstream_get_batch;
+extern bool codegen_exec_scan_qual_project;
 // TODO(shardikar): Retire this GUC after performing experiments to find the
 // tradeoff of codegen-ing slot_getattr() (potentially by measuring the
 // difference in the number of instructions) when one of the first few
 // attributes is varlen.
 extern int codegen_varlen_tolerance;
+extern int codegen_cache_size;
+extern int codegen_disk_cache_size;
 }
 
 namespace gpcodegen {
@@ -39,6 +44,9 @@ class ExecVariableListCodegen;
 class SlotGetAttrCodegen;
 class ExecEvalExprCodegen;
 class AdvanceAggregatesCodegen;
+class ExecHashGetHashValueCodegen;
+class DatumStreamBlockReadGetBatchCodegen;
+class ExecScanQualProjectCodegen;
 
 class CodegenConfig {
  public:
@@ -73,6 +81,22 @@ inline bool CodegenConfig::IsGeneratorEnabled<AdvanceAggregatesCodegen>() {
   return codegen_advance_aggregate;
 }
 
+template<>
+inline bool CodegenConfig::IsGeneratorEnabled<ExecHashGetHashValueCodegen>() {
+  return codegen_exec_hash_get_hash_value;
+}
+
+template<>
+inline bool CodegenConfig::IsGeneratorEnabled<
+    DatumStreamBlockReadGetBatchCodegen>() {
+  return codegen_datumstream_get_batch;
+}
+
+template<>
+inline bool CodegenConfig::IsGeneratorEnabled<ExecScanQualProjectCodegen>() {
+  return codegen_exec_scan_qual_project;
+}
+
 
 /** @} */
 
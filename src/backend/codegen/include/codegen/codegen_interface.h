@@ -23,6 +23,7 @@ namespace gpcodegen {
 
 // Forward declaration
 class GpCodegenUtils;
+class CodegenManager;
 
 /**
  * @brief Interface for all code generators.
@@ -97,11 +98,18 @@ class CodegenInterface {
    * @brief	Utility function to construct a unique function name from the
    * 			original function name by appending a numeric suffix.
    *
+   * @note  The suffix is counted per manager when one is given, so that the
+   *        same plan produces the same function names (and hence the same
+   *        module) every time it is executed. This lets the compiled object
+   *        be found in the CodegenObjectCache.
+   *
    * @param orig_func_name	Function name that needs to be made unique.
+   * @param manager         Manager that will own the generator, or NULL.
    * @return 	Unique string for given input string.
    *
    **/
-  static std::string GenerateUniqueName(const std::string& orig_func_name);
+  static std::string GenerateUniqueName(const std::string& orig_func_name,
+                                        CodegenManager* manager = nullptr);
 
  private:
   // Unique counter for all instances of Codegen Interface.
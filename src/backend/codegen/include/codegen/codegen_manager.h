@@ -13,9 +13,11 @@
 #ifndef GPCODEGEN_CODEGEN_MANAGER_H_  // NOLINT(build/header_guard)
 #define GPCODEGEN_CODEGEN_MANAGER_H_
 
+#include <atomic>
 #include <memory>
 #include <vector>
 #include <string>
+#include <thread>  // NOLINT(build/c++11)
 
 #include "codegen/utils/macros.h"
 #include "codegen/codegen_config.h"
@@ -43,10 +45,18 @@ class CodegenManager {
    *
    * @param module_name A human-readable name for the module that this
    *        CodegenManager will manage.
+   * @param optimization_level One of CODEGEN_OPTIMIZATION_LEVEL_*, the level
+   *        the generated code is compiled at.
    **/
-  explicit CodegenManager(const std::string& module_name);
+  CodegenManager(const std::string& module_name, int optimization_level);
 
-  ~CodegenManager() = default;
+  /**
+   * @brief Destructor.
+   *
+   * @note A compilation still running in the background is left to finish on
+   *       its own; nothing calls the functions it produces any more.
+   **/
+  ~CodegenManager();
 
   /**
    * @brief Template function to facilitate enroll for any type of
@@ -137,6 +147,29 @@ class CodegenManager {
    **/
   unsigned int PrepareGeneratedFunctions();
 
+  /**
+   * @brief Start compiling all the generated functions in a background
+   *        thread. The callers keep calling the regular functions until
+   *        PollGeneratedFunctions() switches them to the compiled ones.
+   *
+   * @note Falls back to PrepareGeneratedFunctions() if no thread can be
+   *       started.
+   *
+   * @return true if a compilation was started, and is to be polled for.
+   **/
+  bool PrepareGeneratedFunctionsInBackground();
+
+  /**
+   * @brief Switch the callers to the compiled functions once the background
+   *        compilation is done.
+   *
+   * @note Must be called from the thread that set up the generators, at a
+   *       point where none of the generated functions is running.
+   *
+   * @return true while the compilation is still running.
+   **/
+  bool PollGeneratedFunctions();
+
   /**
    * @brief 	Notifies the manager of a parameter change.
    *
@@ -154,6 +187,14 @@ class CodegenManager {
    **/
   bool InvalidateGeneratedFunctions();
 
+  /**
+   * @return A number, unique within this manager, for naming a generated
+   *         function.
+   **/
+  unsigned int GetNextUniqueId() {
+    return unique_id_counter_++;
+  }
+
   /**
    * @return Number of enrolled generators.
    **/
@@ -173,8 +214,28 @@ class CodegenManager {
   const std::string& GetExplainString();
 
  private:
+  // What a background compilation shares with its thread, which may outlive
+  // the manager.
+  struct BackgroundCompilation {
+    std::shared_ptr<gpcodegen::GpCodegenUtils> codegen_utils;
+    std::atomic<bool> done;
+  };
+
+  // Set up the ExecutionEngine to compile all the generated functions with.
+  bool SetUpExecutionEngine();
+
+  // Point the callers of every generated function to its compiled version.
+  unsigned int SetToGenerated();
+
+  // Body of the background compilation thread
+  static void CompileInBackground(
+      std::shared_ptr<BackgroundCompilation> compilation);
+
   // GpCodegenUtils provides a facade to LLVM subsystem.
-  std::unique_ptr<gpcodegen::GpCodegenUtils> codegen_utils_;
+  std::shared_ptr<gpcodegen::GpCodegenUtils> codegen_utils_;
+
+  std::shared_ptr<BackgroundCompilation> background_compilation_;
+  std::thread compile_thread_;
 
   std::string module_name_;
 
@@ -184,6 +245,12 @@ class CodegenManager {
   // Holds the dumped IR of all underlying modules for EXPLAIN CODEGEN queries
   std::string explain_string_;
 
+  // Suffix for the next generated function name
+  unsigned int unique_id_counter_;
+
+  // CODEGEN_OPTIMIZATION_LEVEL_* picked for the query this manager serves
+  int optimization_level_;
+
   DISALLOW_COPY_AND_ASSIGN(CodegenManager);
 };
 
@@ -0,0 +1,131 @@
+//---------------------------------------------------------------------------
+//  Greenplum Database
+//  Copyright (C) 2016 Pivotal Software, Inc.
+//
+//  @filename:
+//    codegen_object_cache.h
+//
+//  @doc:
+//    Per-backend cache of compiled codegen modules, backed by an on-disk
+//    cache shared by the backends of the segment
+//
+//---------------------------------------------------------------------------
+#ifndef GPCODEGEN_CODEGEN_OBJECT_CACHE_H_  // NOLINT(build/header_guard)
+#define GPCODEGEN_CODEGEN_OBJECT_CACHE_H_
+
+#include <cstddef>
+#include <list>
+#include <memory>
+#include <string>
+#include <unordered_map>
+
+#include "codegen/utils/macros.h"
+#include "llvm/ExecutionEngine/ObjectCache.h"
+#include "llvm/IR/Module.h"
+#include "llvm/Support/MemoryBuffer.h"
+
+namespace gpcodegen {
+/** \addtogroup gpcodegen
+ *  @{
+ */
+
+/**
+ * @brief Keeps the object code MCJIT produced for recently executed modules,
+ *        so that running the same plan again skips machine code generation.
+ *
+ * Objects are cached before relocation. Generated code refers to executor
+ * state and to backend functions only through named external symbols, which
+ * the new ExecutionEngine maps to this execution's addresses when it loads
+ * the cached object. Anything else a generator specialized on (the
+ * expression tree, the tuple descriptor, the catalog lookups it made) shows
+ * up in the IR, so the key is a digest of the module's IR together with the
+ * optimization level it is compiled at. A catalog change that matters
+ * changes the IR and misses the cache; entries nothing asks for any more are
+ * evicted, least recently used first, once codegen_cache_size is exceeded.
+ *
+ * Objects are also written to the pg_codegen_cache directory of the data
+ * directory, so that a new backend finds what earlier backends compiled.
+ * The key of a file also covers the LLVM and server versions, as the object
+ * code and the symbols it refers to depend on both. Files are written under
+ * a temporary name and renamed into place, so concurrent backends never
+ * read a partial object; the least recently used files are removed once
+ * codegen_disk_cache_size is exceeded.
+ **/
+class CodegenObjectCache : public llvm::ObjectCache {
+ public:
+  /**
+   * @return The cache of this backend.
+   **/
+  static CodegenObjectCache* GetInstance();
+
+  /**
+   * @brief Set the optimization level that the following modules are
+   *        compiled at. It is part of the key.
+   **/
+  void SetOptimizationLevel(int optimization_level) {
+    optimization_level_ = optimization_level;
+  }
+
+  /**
+   * @brief Called by MCJIT after compiling a module that getObject() didn't
+   *        find.
+   **/
+  void notifyObjectCompiled(const llvm::Module* module,
+                            llvm::MemoryBufferRef object) override;
+
+  /**
+   * @brief Called by MCJIT before compiling a module.
+   *
+   * @return A copy of the cached object, or NULL to have the module compiled.
+   **/
+  std::unique_ptr<llvm::MemoryBuffer> getObject(
+      const llvm::Module* module) override;
+
+ private:
+  struct Entry {
+    std::string key;
+    std::string object;
+  };
+
+  CodegenObjectCache();
+
+  std::string ComputeKey(const llvm::Module* module) const;
+
+  // Evict least recently used entries until 'size' more bytes fit.
+  bool MakeRoom(std::size_t size);
+
+  // Add an object to the in-memory cache, if it fits.
+  void Insert(std::string* key, const char* object, std::size_t size);
+
+  // Path of the file of 'key' in the on-disk cache.
+  static std::string DiskPath(const std::string& key);
+
+  // Read the object of 'key' from the on-disk cache, or return NULL.
+  static std::unique_ptr<llvm::MemoryBuffer> ReadFromDisk(
+      const std::string& key);
+
+  // Write an object to the on-disk cache, evicting the least recently used
+  // files to stay within codegen_disk_cache_size.
+  static void WriteToDisk(const std::string& key,
+                          llvm::MemoryBufferRef object);
+
+  // Most recently used entry first.
+  std::list<Entry> entries_;
+  std::unordered_map<std::string, std::list<Entry>::iterator> index_;
+  std::size_t total_size_;
+
+  int optimization_level_;
+
+  // Key of the module getObject() last missed on. MCJIT compiles one module
+  // at a time, and the IR may have been changed by code generation by the
+  // time notifyObjectCompiled() is called, so the key is computed up front.
+  const llvm::Module* pending_module_;
+  std::string pending_key_;
+
+  DISALLOW_COPY_AND_ASSIGN(CodegenObjectCache);
+};
+
+/** @} */
+
+}  // namespace gpcodegen
+#endif  // GPCODEGEN_CODEGEN_OBJECT_CACHE_H_
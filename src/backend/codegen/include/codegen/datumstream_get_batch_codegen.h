@@ -0,0 +1,117 @@
+//---------------------------------------------------------------------------
+//  Greenplum Database
+//  Copyright (C) 2016 Pivotal Software, Inc.
+//
+//  @filename:
+//    datumstream_get_batch_codegen.h
+//
+//  @doc:
+//    Headers for DatumStreamBlockRead_GetBatch codegen.
+//
+//---------------------------------------------------------------------------
+
+#ifndef GPCODEGEN_DATUMSTREAM_GET_BATCH_CODEGEN_H_  // NOLINT(build/header_guard)
+#define GPCODEGEN_DATUMSTREAM_GET_BATCH_CODEGEN_H_
+
+#include "codegen/base_codegen.h"
+#include "codegen/codegen_wrapper.h"
+
+namespace gpcodegen {
+
+/** \addtogroup gpcodegen
+ *  @{
+ */
+
+class DatumStreamBlockReadGetBatchCodegen
+    : public BaseCodegen<DatumStreamBlockReadGetBatchFn> {
+ public:
+  /**
+   * @brief Constructor
+   *
+   * @param regular_func_ptr        Regular version of the target function.
+   * @param ptr_to_chosen_func_ptr  Reference to the function pointer that the
+   *                                caller will call.
+   * @param datumlen                Length of the datums passed by value that
+   *                                the generated function decodes.
+   *
+   * @note 	The ptr_to_chosen_func_ptr can refer to either the generated
+   *        function or the corresponding regular version.
+   *
+   **/
+  explicit DatumStreamBlockReadGetBatchCodegen(
+      CodegenManager* manager,
+      DatumStreamBlockReadGetBatchFn regular_func_ptr,
+      DatumStreamBlockReadGetBatchFn* ptr_to_regular_func_ptr,
+      int32 datumlen);
+
+  virtual ~DatumStreamBlockReadGetBatchCodegen() = default;
+
+ protected:
+  /**
+   * @brief Generate code for decoding a batch of rows of a datum stream block.
+   *
+   * @param codegen_utils
+   *
+   * @return true on successful generation; false otherwise.
+   *
+   * @note The generated function handles blocks of the original and the dense
+   * formats, with or without nulls and RLE_TYPE compression, of datums
+   * passed by value of the given length. A repeated item of an RLE_TYPE block
+   * is expanded in one go. Delta compressed and dictionary encoded blocks,
+   * and streams of other datums, are left to the regular function.
+   *
+   */
+  bool GenerateCodeInternal(gpcodegen::GpCodegenUtils* codegen_utils) final;
+
+ private:
+  int32 datumlen_;
+
+  static constexpr char kDatumStreamBlockReadGetBatchPrefix[] =
+      "DatumStreamBlockRead_GetBatch";
+
+  /**
+   * @brief Generates runtime code that implements
+   *        DatumStreamBlockRead_GetBatch.
+   *
+   * @param codegen_utils Utility to ease the code generation process.
+   * @return true on successful generation.
+   **/
+  bool GenerateGetBatch(gpcodegen::GpCodegenUtils* codegen_utils);
+
+  /**
+   * @brief Generates code that moves a bit-map read position to the next bit,
+   *        like DatumStreamBitMapRead_Next().
+   *
+   * @param codegen_utils     Utility to ease the code generation process.
+   * @param llvm_byte_ptr     Pointer to the local copy of bytePointer.
+   * @param llvm_byte_bit     Pointer to the local copy of byteBit.
+   * @param llvm_bit_position Pointer to the local copy of bitPosition.
+   *
+   * @return true (i1) if the new current bit is on.
+   **/
+  static llvm::Value* GenerateBitMapNext(
+      gpcodegen::GpCodegenUtils* codegen_utils,
+      llvm::Value* llvm_byte_ptr,
+      llvm::Value* llvm_byte_bit,
+      llvm::Value* llvm_bit_position);
+
+  /**
+   * @brief Generates code that decodes the repeat count at *llvm_countsp and
+   *        moves *llvm_countsp past it, like DatumStreamInt32Compress_Decode().
+   *
+   * @param codegen_utils   Utility to ease the code generation process.
+   * @param llvm_func       Function that the code is generated in.
+   * @param llvm_countsp    Pointer to the local copy of rle_repeatcountsp.
+   *
+   * @return The repeat count.
+   **/
+  static llvm::Value* GenerateRepeatCountDecode(
+      gpcodegen::GpCodegenUtils* codegen_utils,
+      llvm::Function* llvm_func,
+      llvm::Value* llvm_countsp);
+};
+
+/** @} */
+
+}  // namespace gpcodegen
+#endif  // GPCODEGEN_DATUMSTREAM_GET_BATCH_CODEGEN_H_
@@ -0,0 +1,130 @@
+//---------------------------------------------------------------------------
+//  Greenplum Database
+//  Copyright (C) 2016 Pivotal Software, Inc.
+//
+//  @filename:
+//    exec_hash_get_hash_value_codegen.h
+//
+//  @doc:
+//    Headers for ExecHashGetHashValue codegen.
+//
+//---------------------------------------------------------------------------
+
+#ifndef GPCODEGEN_EXECHASHGETHASHVALUE_CODEGEN_H_  // NOLINT(build/header_guard)
+#define GPCODEGEN_EXECHASHGETHASHVALUE_CODEGEN_H_
+
+#include <memory>
+#include <vector>
+
+#include "codegen/base_codegen.h"
+#include "codegen/codegen_wrapper.h"
+#include "codegen/expr_tree_generator.h"
+
+typedef struct List List;
+
+namespace gpcodegen {
+
+/** \addtogroup gpcodegen
+ *  @{
+ */
+
+class ExecHashGetHashValueCodegen
+    : public BaseCodegen<ExecHashGetHashValueFn> {
+ public:
+  /**
+   * @brief Constructor
+   *
+   * @param regular_func_ptr        Regular version of the target function.
+   * @param ptr_to_chosen_func_ptr  Reference to the function pointer that the
+   *                                caller will call.
+   * @param hashkeys                ExprStates of the hash keys of one side.
+   * @param hash_operators          OIDs of the hash join operators.
+   * @param outer_tuple             true for the probe (outer) side, false for
+   *                                the build (inner) side.
+   * @param econtext                The ExprContext the keys are evaluated in.
+   *
+   * @note 	The ptr_to_chosen_func_ptr can refer to either the generated
+   *        function or the corresponding regular version.
+   *
+   **/
+  explicit ExecHashGetHashValueCodegen(
+      CodegenManager* manager,
+      ExecHashGetHashValueFn regular_func_ptr,
+      ExecHashGetHashValueFn* ptr_to_regular_func_ptr,
+      List *hashkeys,
+      List *hash_operators,
+      bool outer_tuple,
+      ExprContext *econtext);
+
+  virtual ~ExecHashGetHashValueCodegen() = default;
+
+  bool InitDependencies() override;
+
+ protected:
+  /**
+   * @brief Generate code for computing the hash value of a tuple.
+   *
+   * @param codegen_utils
+   *
+   * @return true on successful generation; false otherwise.
+   *
+   * @note Every key is evaluated with an ExprTreeGenerator, and hashed inline
+   * when its hash function is one of the integer hash functions (hashint2,
+   * hashint4, hashint8, hashoid, hashchar), instead of through the fmgr.
+   *
+   * If any key expression or hash function is not supported, nothing is
+   * generated and the regular function is used.
+   *
+   */
+  bool GenerateCodeInternal(gpcodegen::GpCodegenUtils* codegen_utils) final;
+
+ private:
+  // What we know about each hash key at generation time
+  struct HashKeyInfo {
+    std::unique_ptr<ExprTreeGenerator> expr_tree;
+    Oid hash_func;
+    bool strict;
+  };
+
+  List *hashkeys_;
+  List *hash_operators_;
+  bool outer_tuple_;
+
+  ExprTreeGeneratorInfo gen_info_;
+  std::vector<HashKeyInfo> keys_;
+  bool keys_supported_;
+
+  static constexpr char kExecHashGetHashValuePrefix[] = "ExecHashGetHashValue";
+
+  /**
+   * @brief Generates runtime code that implements ExecHashGetHashValue.
+   *
+   * @param codegen_utils Utility to ease the code generation process.
+   * @return true on successful generation.
+   **/
+  bool GenerateExecHashGetHashValue(gpcodegen::GpCodegenUtils* codegen_utils);
+
+  /**
+   * @brief Generates code that applies the hash function hash_func to a key.
+   *
+   * @param codegen_utils Utility to ease the code generation process.
+   * @param hash_func     OID of the hash function.
+   * @param llvm_keyval   The key, as a Datum.
+   *
+   * @return The 32 bit hash of the key.
+   **/
+  static llvm::Value* GenerateHashFunction(
+      gpcodegen::GpCodegenUtils* codegen_utils,
+      Oid hash_func,
+      llvm::Value* llvm_keyval);
+
+  /**
+   * @return true if GenerateHashFunction() supports hash_func.
+   **/
+  static bool IsHashFunctionSupported(Oid hash_func);
+};
+
+/** @} */
+
+}  // namespace gpcodegen
+#endif  // GPCODEGEN_EXECHASHGETHASHVALUE_CODEGEN_H_
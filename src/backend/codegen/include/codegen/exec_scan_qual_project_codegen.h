@@ -0,0 +1,96 @@
+//---------------------------------------------------------------------------
+//  Greenplum Database
+//  Copyright (C) 2016 Pivotal Software, Inc.
+//
+//  @filename:
+//    exec_scan_qual_project_codegen.h
+//
+//  @doc:
+//    Headers for ExecScanQualProject codegen.
+//
+//---------------------------------------------------------------------------
+
+#ifndef GPCODEGEN_EXEC_SCAN_QUAL_PROJECT_CODEGEN_H_  // NOLINT(build/header_guard)
+#define GPCODEGEN_EXEC_SCAN_QUAL_PROJECT_CODEGEN_H_
+
+#include <memory>
+#include <vector>
+
+#include "codegen/base_codegen.h"
+#include "codegen/codegen_wrapper.h"
+#include "codegen/expr_tree_generator.h"
+#include "codegen/slot_getattr_codegen.h"
+
+namespace gpcodegen {
+
+/** \addtogroup gpcodegen
+ *  @{
+ */
+
+class ExecScanQualProjectCodegen: public BaseCodegen<ExecScanQualProjectFn> {
+ public:
+  /**
+   * @brief Constructor
+   *
+   * @param regular_func_ptr        Regular version of the target function.
+   * @param ptr_to_chosen_func_ptr  Reference to the function pointer that the
+   *                                caller will call.
+   * @param scan_state              The ScanState to use for generating code.
+   *
+   * @note 	The ptr_to_chosen_func_ptr can refer to either the generated
+   *        function or the corresponding regular version.
+   *
+   **/
+  explicit ExecScanQualProjectCodegen(
+      CodegenManager* manager,
+      ExecScanQualProjectFn regular_func_ptr,
+      ExecScanQualProjectFn* ptr_to_regular_func_ptr,
+      ScanState* scan_state);
+
+  virtual ~ExecScanQualProjectCodegen() = default;
+
+  bool InitDependencies() override;
+
+ protected:
+  /**
+   * @brief Generate code for the per tuple work of ExecScan.
+   *
+   * @param codegen_utils
+   *
+   * @return true on successful generation; false otherwise.
+   *
+   * @note Fuses deforming the scan tuple, evaluating all the quals and
+   * projecting a simple Var list into one function. The scan tuple is
+   * deformed once by the generated slot_getattr(), up to the largest
+   * attribute the quals and the projection need. Other projections are
+   * handed to ExecProject().
+   *
+   * Every qual must be supported by the ExprTreeGenerators; otherwise the
+   * regular function is used.
+   */
+  bool GenerateCodeInternal(gpcodegen::GpCodegenUtils* codegen_utils) final;
+
+ private:
+  ScanState* scan_state_;
+
+  ExprTreeGeneratorInfo gen_info_;
+  SlotGetAttrCodegen* slot_getattr_codegen_;
+  std::vector<std::unique_ptr<ExprTreeGenerator>> qual_generators_;
+  // Whether the projection is a simple Var list of the scan tuple
+  bool project_var_list_;
+
+  static constexpr char kExecScanQualProjectPrefix[] = "ExecScanQualProject";
+
+  /**
+   * @brief Generates runtime code that implements ExecScanQualProject.
+   *
+   * @param codegen_utils Utility to ease the code generation process.
+   * @return true on successful generation.
+   **/
+  bool GenerateExecScanQualProject(gpcodegen::GpCodegenUtils* codegen_utils);
+};
+
+/** @} */
+
+}  // namespace gpcodegen
+#endif  // GPCODEGEN_EXEC_SCAN_QUAL_PROJECT_CODEGEN_H_
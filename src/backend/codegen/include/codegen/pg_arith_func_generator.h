@@ -301,6 +301,56 @@ class PGArithFuncGenerator {
         llvm_out_value);
   }
 
+  /**
+   * @brief Create LLVM instructions that return the larger of two integers,
+   *        like int4larger, date_larger and (int64) timestamp_larger do.
+   *
+   * @param codegen_utils     Utility to easy code generation.
+   * @param pg_func_info      Details for pgfunc generation
+   * @param llvm_out_value    Store the results of function
+   *
+   * @return true if generation was successful otherwise return false
+   **/
+  static bool Larger(gpcodegen::GpCodegenUtils* codegen_utils,
+                     const PGFuncGeneratorInfo& pg_func_info,
+                     llvm::Value** llvm_out_value) {
+    static_assert(std::is_integral<rtype>::value,
+                  "Larger supports integer types only");
+    auto irb = codegen_utils->ir_builder();
+    // result = ((arg1 > arg2) ? arg1 : arg2);
+    *llvm_out_value = irb->CreateSelect(
+        irb->CreateICmpSGT(pg_func_info.llvm_args[0],
+                           pg_func_info.llvm_args[1]),
+        pg_func_info.llvm_args[0],
+        pg_func_info.llvm_args[1]);
+    return true;
+  }
+
+  /**
+   * @brief Create LLVM instructions that return the smaller of two integers,
+   *        like int4smaller, date_smaller and (int64) timestamp_smaller do.
+   *
+   * @param codegen_utils     Utility to easy code generation.
+   * @param pg_func_info      Details for pgfunc generation
+   * @param llvm_out_value    Store the results of function
+   *
+   * @return true if generation was successful otherwise return false
+   **/
+  static bool Smaller(gpcodegen::GpCodegenUtils* codegen_utils,
+                      const PGFuncGeneratorInfo& pg_func_info,
+                      llvm::Value** llvm_out_value) {
+    static_assert(std::is_integral<rtype>::value,
+                  "Smaller supports integer types only");
+    auto irb = codegen_utils->ir_builder();
+    // result = ((arg1 < arg2) ? arg1 : arg2);
+    *llvm_out_value = irb->CreateSelect(
+        irb->CreateICmpSLT(pg_func_info.llvm_args[0],
+                           pg_func_info.llvm_args[1]),
+        pg_func_info.llvm_args[0],
+        pg_func_info.llvm_args[1]);
+    return true;
+  }
+
   static bool ArithOpWithOverflow(gpcodegen::GpCodegenUtils* codegen_utils,
                                   CGArithOpFunc codegen_mem_funcptr,
                                   const char* error_msg,
@@ -0,0 +1,172 @@
+//---------------------------------------------------------------------------
+//  Greenplum Database
+//  Copyright (C) 2016 Pivotal Software, Inc.
+//
+//  @filename:
+//    pg_text_func_generator.h
+//
+//  @doc:
+//    Base class for text functions to generate code
+//
+//---------------------------------------------------------------------------
+#ifndef GPCODEGEN_PG_TEXT_FUNC_GENERATOR_H_  // NOLINT(build/header_guard)
+#define GPCODEGEN_PG_TEXT_FUNC_GENERATOR_H_
+
+#include <string>
+
+#include "codegen/pg_func_generator_interface.h"
+#include "codegen/utils/gp_codegen_utils.h"
+
+#include "llvm/IR/IRBuilder.h"
+#include "llvm/IR/Value.h"
+
+namespace llvm {
+class Value;
+}  // namespace llvm
+
+namespace gpcodegen {
+
+/** \addtogroup gpcodegen
+ *  @{
+ */
+
+class GpCodegenUtils;
+struct PGFuncGeneratorInfo;
+
+/**
+ * @brief Class with Static member functions to generate code for text
+ *        operators (texteq, text_lt, textlike, ...). The arguments are text,
+ *        varchar or bpchar datums, i.e. void* pointers to varlenas.
+ **/
+class PGTextFuncGenerator {
+ public:
+  /**
+   * @brief Create instructions for texteq and textne functions
+   *
+   * @param codegen_utils     Utility to easy code generation.
+   * @param pg_func_info      Details for pgfunc generation
+   * @param llvm_out_value    Store the results of function
+   *
+   * @return true if generation was successful otherwise return false
+   *
+   * @note  Equality is bitwise and does not depend on LC_COLLATE.
+   **/
+  static bool TextEq(gpcodegen::GpCodegenUtils* codegen_utils,
+                     const PGFuncGeneratorInfo& pg_func_info,
+                     llvm::Value** llvm_out_value);
+
+  static bool TextNe(gpcodegen::GpCodegenUtils* codegen_utils,
+                     const PGFuncGeneratorInfo& pg_func_info,
+                     llvm::Value** llvm_out_value);
+
+  /**
+   * @brief Create instructions for text_lt, text_le, text_gt and text_ge
+   *        functions
+   *
+   * @param codegen_utils     Utility to easy code generation.
+   * @param pg_func_info      Details for pgfunc generation
+   * @param llvm_out_value    Store the results of function
+   *
+   * @return true if generation was successful otherwise return false
+   *
+   * @note  Under the C collation the strings are compared inline like
+   *        varstr_cmp() does; otherwise varstr_cmp() is called.
+   **/
+  static bool TextLt(gpcodegen::GpCodegenUtils* codegen_utils,
+                     const PGFuncGeneratorInfo& pg_func_info,
+                     llvm::Value** llvm_out_value);
+
+  static bool TextLe(gpcodegen::GpCodegenUtils* codegen_utils,
+                     const PGFuncGeneratorInfo& pg_func_info,
+                     llvm::Value** llvm_out_value);
+
+  static bool TextGt(gpcodegen::GpCodegenUtils* codegen_utils,
+                     const PGFuncGeneratorInfo& pg_func_info,
+                     llvm::Value** llvm_out_value);
+
+  static bool TextGe(gpcodegen::GpCodegenUtils* codegen_utils,
+                     const PGFuncGeneratorInfo& pg_func_info,
+                     llvm::Value** llvm_out_value);
+
+  /**
+   * @brief Create instructions for textlike and textnlike functions
+   *
+   * @param codegen_utils     Utility to easy code generation.
+   * @param pg_func_info      Details for pgfunc generation
+   * @param llvm_out_value    Store the results of function
+   *
+   * @return true if generation was successful otherwise return false
+   *
+   * @note  A constant pattern made of literal characters followed by zero or
+   *        more '%' is matched inline as a prefix (or equality) test. Any
+   *        other pattern is matched by calling textlike.
+   **/
+  static bool TextLike(gpcodegen::GpCodegenUtils* codegen_utils,
+                       const PGFuncGeneratorInfo& pg_func_info,
+                       llvm::Value** llvm_out_value);
+
+  static bool TextNLike(gpcodegen::GpCodegenUtils* codegen_utils,
+                        const PGFuncGeneratorInfo& pg_func_info,
+                        llvm::Value** llvm_out_value);
+
+ private:
+  /**
+   * @brief Generate code that detoasts a text datum and computes its
+   *        VARDATA_ANY and VARSIZE_ANY_EXHDR.
+   *
+   * @param codegen_utils     Utility to easy code generation.
+   * @param llvm_arg          llvm value of the datum, as a void*
+   * @param llvm_out_data     Pointer to the first byte of the string
+   * @param llvm_out_len      Length of the string in bytes, as a size_t
+   **/
+  static void GenerateTextArg(gpcodegen::GpCodegenUtils* codegen_utils,
+                              llvm::Value* llvm_arg,
+                              llvm::Value** llvm_out_data,
+                              llvm::Value** llvm_out_len);
+
+  /**
+   * @brief Generate code that returns true if the two strings are equal.
+   **/
+  static llvm::Value* GenerateTextEq(gpcodegen::GpCodegenUtils* codegen_utils,
+                                     const PGFuncGeneratorInfo& pg_func_info);
+
+  /**
+   * @brief Generate code that returns the result of text_cmp() for the two
+   *        strings; negative, zero or positive.
+   **/
+  static llvm::Value* GenerateTextCmp(gpcodegen::GpCodegenUtils* codegen_utils,
+                                      const PGFuncGeneratorInfo& pg_func_info);
+
+  /**
+   * @brief Generate code that returns true if the string matches the pattern.
+   **/
+  static llvm::Value* GenerateTextLike(
+      gpcodegen::GpCodegenUtils* codegen_utils,
+      const PGFuncGeneratorInfo& pg_func_info);
+
+  /**
+   * @brief Generate code that returns true if the strncmp() of the first
+   *        llvm_len bytes of the two strings is zero.
+   **/
+  static llvm::Value* GenerateStrNEq(gpcodegen::GpCodegenUtils* codegen_utils,
+                                     llvm::Value* llvm_data0,
+                                     llvm::Value* llvm_data1,
+                                     llvm::Value* llvm_len);
+
+  /**
+   * @brief If llvm_pattern is a constant LIKE pattern that only consists of
+   *        literal characters followed by zero or more '%', store the
+   *        literal characters in prefix and whether it ends in '%' in
+   *        is_prefix.
+   *
+   * @return true if the pattern is such a constant.
+   **/
+  static bool GetConstPrefixPattern(llvm::Value* llvm_pattern,
+                                    std::string* prefix,
+                                    bool* is_prefix);
+};
+
+/** @} */
+}  // namespace gpcodegen
+
+#endif  // GPCODEGEN_PG_TEXT_FUNC_GENERATOR_H_
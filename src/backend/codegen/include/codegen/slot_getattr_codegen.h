@@ -24,6 +24,7 @@ extern "C" {
 #include "postgres.h"  // NOLINT(build/include)
 #include "utils/elog.h"
 #include "access/htup.h"
+#include "access/memtup.h"
 #include "nodes/execnodes.h"
 #include "executor/tuptable.h"
 
@@ -127,11 +128,12 @@ class SlotGetAttrCodegen : public BaseCodegen<SlotGetAttrFn> {
    * (through _slot_getsomeattrs), which fetches all yet unread attributes of
    * the slot until the given attribute.
    *
-   * This implementation does not support:
+   * For heap tuples, this implementation does not support:
    *  (1) Attributes passed by reference
    *
-   * If at execution time, we see any of the above types of attributes,
-   * we fall backs to the regular function.
+   * From the first such attribute on, the heap tuple is deformed by
+   * slot_deform_tuple(). Memtuples are deformed by the code from
+   * GenerateMemTupleDeform().
    **/
   bool GenerateSlotGetAttr(
       gpcodegen::GpCodegenUtils* codegen_utils,
@@ -139,6 +141,80 @@ class SlotGetAttrCodegen : public BaseCodegen<SlotGetAttrFn> {
       int max_attr,
       llvm::Function* out_func);
 
+  /**
+   * @brief Generate code for the codepath slot_getsomeattrs >
+   * memtuple_getattr, for memtuples in the given slot
+   *
+   * @param codegen_utils     Utilities for easy code generation
+   * @param slot              Use the TupleDesc and MemTupleBinding of this slot
+   * @param max_attr          Deform memtuples up to this many attributes
+   * @param slot_getattr_func The slot_getattr function being generated
+   * @param llvm_memtuple     slot->PRIVATE_tts_memtuple
+   * @param llvm_mt_bind      slot->tts_mt_bind
+   * @param llvm_attnum_arg   The attribute asked for
+   * @param llvm_values       slot->PRIVATE_tts_values
+   * @param llvm_isnull       slot->PRIVATE_tts_isnull
+   * @param return_block      Block that returns the attribute from the slot
+   *
+   * @note The offset of every attribute is known from the binding, so
+   * memtuples without nulls are deformed with straight line code, and
+   * memtuples with nulls adjust the offsets by the space the null attributes
+   * save. The deformed attributes are stored in the slot, and the slot marked
+   * as holding a virtual tuple, as slot_getsomeattrs() does.
+   *
+   * A memtuple built with another binding, a large memtuple, or a request for
+   * an attribute beyond max_attr is deformed by slot_getsomeattrs() instead.
+   **/
+  void GenerateMemTupleDeform(
+      gpcodegen::GpCodegenUtils* codegen_utils,
+      TupleTableSlot* slot,
+      int max_attr,
+      llvm::Function* slot_getattr_func,
+      llvm::Value* llvm_memtuple,
+      llvm::Value* llvm_mt_bind,
+      llvm::Value* llvm_attnum_arg,
+      llvm::Value* llvm_values,
+      llvm::Value* llvm_isnull,
+      llvm::BasicBlock* return_block);
+
+  /**
+   * @return true if GenerateMemTupleDeform() supports the first max_attr
+   * attributes of the memtuples in slot.
+   **/
+  static bool CanDeformMemTuple(TupleTableSlot* slot, int max_attr);
+
+  /**
+   * @brief Generate code that computes where the data of an attribute of a
+   * memtuple starts, like memtuple_get_attr_data_ptr().
+   *
+   * @param codegen_utils Utilities for easy code generation
+   * @param attrbind      Binding of the attribute
+   * @param llvm_start    Start of the attributes of the memtuple
+   * @param llvm_attr_ptr Location of the attribute in the memtuple
+   **/
+  static llvm::Value* GenerateMemTupleDataPtr(
+      gpcodegen::GpCodegenUtils* codegen_utils,
+      MemTupleAttrBinding* attrbind,
+      llvm::Value* llvm_start,
+      llvm::Value* llvm_attr_ptr);
+
+  /**
+   * @brief Generate code for fetchatt(thisatt, llvm_data_ptr).
+   *
+   * @note By value attributes must be of a length IsSupportedByValLength()
+   * accepts.
+   **/
+  static llvm::Value* GenerateFetchAtt(
+      gpcodegen::GpCodegenUtils* codegen_utils,
+      Form_pg_attribute thisatt,
+      llvm::Value* llvm_data_ptr);
+
+  /**
+   * @return true if attributes of length attlen passed by value can be
+   * loaded by the generated code.
+   **/
+  static bool IsSupportedByValLength(int attlen);
+
   /**
    * @brief Removes the entry of this SlotGetAttrCodegen from the static cache.
    */
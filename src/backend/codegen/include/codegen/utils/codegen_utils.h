@@ -32,6 +32,7 @@
 #include "llvm/ADT/Twine.h"
 #include "llvm/Analysis/CallGraph.h"
 #include "llvm/ExecutionEngine/ExecutionEngine.h"
+#include "llvm/ExecutionEngine/ObjectCache.h"
 #include "llvm/IR/BasicBlock.h"
 #include "llvm/IR/Constants.h"
 #include "llvm/IR/DerivedTypes.h"
@@ -464,11 +465,29 @@ class CodegenUtils {
    *        code at the expense of increased compilation time.
    * @param optimize_for_host_cpu If true, LLVM will optimize generated machine
    *        code for the specific CPU model we are running on.
+   * @param object_cache If not NULL, the ExecutionEngine looks up each module
+   *        in this cache before compiling it, and hands newly compiled objects
+   *        to it. Objects are kept before relocation, so pointer constants and
+   *        external functions are still resolved against this CodegenUtils.
    * @return true if an ExecutionEngine was set up successfully, false if some
    *         error occured.
    **/
   bool PrepareForExecution(const OptimizationLevel cpu_opt_level,
-                           const bool optimize_for_host_cpu);
+                           const bool optimize_for_host_cpu,
+                           llvm::ObjectCache* object_cache = nullptr);
+
+  /**
+   * @brief Translate all the modules to machine code now, rather than on the
+   *        first call to GetFunctionPointer().
+   *
+   * @note PrepareForExecution() should be called before calling this method.
+   *       Once it returns, GetFunctionPointer() only looks up the compiled
+   *       function.
+   *
+   * @return true if the modules were compiled, false if there is no
+   *         ExecutionEngine to compile them with.
+   **/
+  bool CompileForExecution();
 
   /**
    * @brief Get a pointer to the compiled machine-code version of a function
@@ -26,6 +26,7 @@
 #include "codegen/pg_arith_func_generator.h"
 #include "codegen/pg_date_func_generator.h"
 #include "codegen/pg_numeric_func_generator.h"
+#include "codegen/pg_text_func_generator.h"
 
 #include "llvm/IR/IRBuilder.h"
 
@@ -149,6 +150,26 @@ void OpExprTreeGenerator::InitializeSupportedFunction() {
           nullptr,
           true));
 
+  // Equality operators of the common hash join keys
+  supported_function_[65] = std::unique_ptr<PGFuncGeneratorInterface>(
+      new PGIRBuilderFuncGenerator<bool, int32_t, int32_t>(
+          65,
+          "int4eq",
+          &IRBuilder<>::CreateICmpEQ,
+          true));
+
+  supported_function_[467] = std::unique_ptr<PGFuncGeneratorInterface>(
+      new PGIRBuilderFuncGenerator<bool, int64_t, int64_t>(
+          467,
+          "int8eq",
+          &IRBuilder<>::CreateICmpEQ,
+          true));
+
+  supported_function_[1086] = std::unique_ptr<PGFuncGeneratorInterface>(
+      new PGIRBuilderFuncGenerator<bool, int32_t, int32_t>(
+          1086, "date_eq", &IRBuilder<>::CreateICmpEQ,
+          true));
+
   supported_function_[1088] = std::unique_ptr<PGFuncGeneratorInterface>(
       new PGIRBuilderFuncGenerator<bool, int32_t, int32_t>(
           1088, "date_le", &IRBuilder<>::CreateICmpSLE,
@@ -178,6 +199,139 @@ void OpExprTreeGenerator::InitializeSupportedFunction() {
           nullptr,
           true));
 
+  supported_function_[1962] = std::unique_ptr<PGFuncGeneratorInterface>(
+      new PGGenericFuncGenerator<void*, void*, int16>(
+          1962,
+          "int2_avg_accum",
+          &PGNumericFuncGenerator::GenerateIntFloatAvgAccum<int16>,
+          nullptr,
+          true));
+
+  supported_function_[3100] = std::unique_ptr<PGFuncGeneratorInterface>(
+      new PGGenericFuncGenerator<void*, void*, int64>(
+          3100,
+          "int8_avg_accum",
+          &PGNumericFuncGenerator::GenerateIntFloatAvgAccum<int64>,
+          nullptr,
+          true));
+
+  supported_function_[3106] = std::unique_ptr<PGFuncGeneratorInterface>(
+      new PGGenericFuncGenerator<void*, void*, float4>(
+          3106,
+          "float4_avg_accum",
+          &PGNumericFuncGenerator::GenerateIntFloatAvgAccum<float4>,
+          nullptr,
+          true));
+
+  // int2_sum is not a strict function, like int4_sum.
+  supported_function_[1840] = std::unique_ptr<PGFuncGeneratorInterface>(
+      new PGGenericFuncGenerator<int64_t, int64_t, int16_t>(
+          1840,
+          "int2_sum",
+          &PGArithFuncGenerator<int64_t, int64_t, int16_t>::AddWithOverflow,
+          &PGArithFuncGenerator<int64_t, int64_t, int16_t>::
+          CreateArgumentNullChecks,
+          false));
+
+  // Transition functions of min and max
+  supported_function_[768] = std::unique_ptr<PGFuncGeneratorInterface>(
+      new PGGenericFuncGenerator<int32_t, int32_t, int32_t>(
+          768,
+          "int4larger",
+          &PGArithFuncGenerator<int32_t, int32_t, int32_t>::Larger,
+          nullptr,
+          true));
+
+  supported_function_[769] = std::unique_ptr<PGFuncGeneratorInterface>(
+      new PGGenericFuncGenerator<int32_t, int32_t, int32_t>(
+          769,
+          "int4smaller",
+          &PGArithFuncGenerator<int32_t, int32_t, int32_t>::Smaller,
+          nullptr,
+          true));
+
+  supported_function_[770] = std::unique_ptr<PGFuncGeneratorInterface>(
+      new PGGenericFuncGenerator<int16_t, int16_t, int16_t>(
+          770,
+          "int2larger",
+          &PGArithFuncGenerator<int16_t, int16_t, int16_t>::Larger,
+          nullptr,
+          true));
+
+  supported_function_[771] = std::unique_ptr<PGFuncGeneratorInterface>(
+      new PGGenericFuncGenerator<int16_t, int16_t, int16_t>(
+          771,
+          "int2smaller",
+          &PGArithFuncGenerator<int16_t, int16_t, int16_t>::Smaller,
+          nullptr,
+          true));
+
+  supported_function_[1236] = std::unique_ptr<PGFuncGeneratorInterface>(
+      new PGGenericFuncGenerator<int64_t, int64_t, int64_t>(
+          1236,
+          "int8larger",
+          &PGArithFuncGenerator<int64_t, int64_t, int64_t>::Larger,
+          nullptr,
+          true));
+
+  supported_function_[1237] = std::unique_ptr<PGFuncGeneratorInterface>(
+      new PGGenericFuncGenerator<int64_t, int64_t, int64_t>(
+          1237,
+          "int8smaller",
+          &PGArithFuncGenerator<int64_t, int64_t, int64_t>::Smaller,
+          nullptr,
+          true));
+
+  supported_function_[1138] = std::unique_ptr<PGFuncGeneratorInterface>(
+      new PGGenericFuncGenerator<int32_t, int32_t, int32_t>(
+          1138,
+          "date_larger",
+          &PGArithFuncGenerator<int32_t, int32_t, int32_t>::Larger,
+          nullptr,
+          true));
+
+  supported_function_[1139] = std::unique_ptr<PGFuncGeneratorInterface>(
+      new PGGenericFuncGenerator<int32_t, int32_t, int32_t>(
+          1139,
+          "date_smaller",
+          &PGArithFuncGenerator<int32_t, int32_t, int32_t>::Smaller,
+          nullptr,
+          true));
+
+#ifdef HAVE_INT64_TIMESTAMP
+  supported_function_[2036] = std::unique_ptr<PGFuncGeneratorInterface>(
+      new PGGenericFuncGenerator<int64_t, int64_t, int64_t>(
+          2036,
+          "timestamp_larger",
+          &PGArithFuncGenerator<int64_t, int64_t, int64_t>::Larger,
+          nullptr,
+          true));
+
+  supported_function_[2035] = std::unique_ptr<PGFuncGeneratorInterface>(
+      new PGGenericFuncGenerator<int64_t, int64_t, int64_t>(
+          2035,
+          "timestamp_smaller",
+          &PGArithFuncGenerator<int64_t, int64_t, int64_t>::Smaller,
+          nullptr,
+          true));
+
+  supported_function_[1196] = std::unique_ptr<PGFuncGeneratorInterface>(
+      new PGGenericFuncGenerator<int64_t, int64_t, int64_t>(
+          1196,
+          "timestamptz_larger",
+          &PGArithFuncGenerator<int64_t, int64_t, int64_t>::Larger,
+          nullptr,
+          true));
+
+  supported_function_[1195] = std::unique_ptr<PGFuncGeneratorInterface>(
+      new PGGenericFuncGenerator<int64_t, int64_t, int64_t>(
+          1195,
+          "timestamptz_smaller",
+          &PGArithFuncGenerator<int64_t, int64_t, int64_t>::Smaller,
+          nullptr,
+          true));
+#endif  // HAVE_INT64_TIMESTAMP
+
   supported_function_[6009] = std::unique_ptr<PGFuncGeneratorInterface>(
       new PGGenericFuncGenerator<void*, void*, void*>(
           6009,
@@ -193,6 +347,103 @@ void OpExprTreeGenerator::InitializeSupportedFunction() {
           &PGNumericFuncGenerator::GenerateIntFloatAvgAmalg,
           nullptr,
           true));
+
+  // Text operators. varchar uses them as well, and bpchar the LIKE ones.
+  supported_function_[67] = std::unique_ptr<PGFuncGeneratorInterface>(
+      new PGGenericFuncGenerator<bool, void*, void*>(
+          67,
+          "texteq",
+          &PGTextFuncGenerator::TextEq,
+          nullptr,
+          true));
+
+  supported_function_[157] = std::unique_ptr<PGFuncGeneratorInterface>(
+      new PGGenericFuncGenerator<bool, void*, void*>(
+          157,
+          "textne",
+          &PGTextFuncGenerator::TextNe,
+          nullptr,
+          true));
+
+  supported_function_[740] = std::unique_ptr<PGFuncGeneratorInterface>(
+      new PGGenericFuncGenerator<bool, void*, void*>(
+          740,
+          "text_lt",
+          &PGTextFuncGenerator::TextLt,
+          nullptr,
+          true));
+
+  supported_function_[741] = std::unique_ptr<PGFuncGeneratorInterface>(
+      new PGGenericFuncGenerator<bool, void*, void*>(
+          741,
+          "text_le",
+          &PGTextFuncGenerator::TextLe,
+          nullptr,
+          true));
+
+  supported_function_[742] = std::unique_ptr<PGFuncGeneratorInterface>(
+      new PGGenericFuncGenerator<bool, void*, void*>(
+          742,
+          "text_gt",
+          &PGTextFuncGenerator::TextGt,
+          nullptr,
+          true));
+
+  supported_function_[743] = std::unique_ptr<PGFuncGeneratorInterface>(
+      new PGGenericFuncGenerator<bool, void*, void*>(
+          743,
+          "text_ge",
+          &PGTextFuncGenerator::TextGe,
+          nullptr,
+          true));
+
+  supported_function_[850] = std::unique_ptr<PGFuncGeneratorInterface>(
+      new PGGenericFuncGenerator<bool, void*, void*>(
+          850,
+          "textlike",
+          &PGTextFuncGenerator::TextLike,
+          nullptr,
+          true));
+
+  supported_function_[851] = std::unique_ptr<PGFuncGeneratorInterface>(
+      new PGGenericFuncGenerator<bool, void*, void*>(
+          851,
+          "textnlike",
+          &PGTextFuncGenerator::TextNLike,
+          nullptr,
+          true));
+
+  supported_function_[1569] = std::unique_ptr<PGFuncGeneratorInterface>(
+      new PGGenericFuncGenerator<bool, void*, void*>(
+          1569,
+          "like",
+          &PGTextFuncGenerator::TextLike,
+          nullptr,
+          true));
+
+  supported_function_[1570] = std::unique_ptr<PGFuncGeneratorInterface>(
+      new PGGenericFuncGenerator<bool, void*, void*>(
+          1570,
+          "notlike",
+          &PGTextFuncGenerator::TextNLike,
+          nullptr,
+          true));
+
+  supported_function_[1631] = std::unique_ptr<PGFuncGeneratorInterface>(
+      new PGGenericFuncGenerator<bool, void*, void*>(
+          1631,
+          "bpcharlike",
+          &PGTextFuncGenerator::TextLike,
+          nullptr,
+          true));
+
+  supported_function_[1632] = std::unique_ptr<PGFuncGeneratorInterface>(
+      new PGGenericFuncGenerator<bool, void*, void*>(
+          1632,
+          "bpcharnlike",
+          &PGTextFuncGenerator::TextNLike,
+          nullptr,
+          true));
 }
 
 PGFuncGeneratorInterface* OpExprTreeGenerator::GetPGFuncGenerator(
@@ -0,0 +1,396 @@
+//---------------------------------------------------------------------------
+//  Greenplum Database
+//  Copyright (C) 2016 Pivotal Software, Inc.
+//
+//  @filename:
+//    pg_text_func_generator.cc
+//
+//  @doc:
+//    Base class for text functions to generate code
+//
+//---------------------------------------------------------------------------
+
+#include <assert.h>
+#include <cstdint>
+#include <cstring>
+#include <string>
+
+#include "codegen/codegen_wrapper.h"
+#include "codegen/pg_func_generator_interface.h"
+#include "codegen/pg_text_func_generator.h"
+#include "codegen/utils/gp_codegen_utils.h"
+
+#include "llvm/IR/Constants.h"
+#include "llvm/IR/IRBuilder.h"
+#include "llvm/IR/Value.h"
+
+extern "C" {
+#include "postgres.h"  // NOLINT(build/include)
+#include "c.h"  // NOLINT(build/include)
+#include "fmgr.h"
+#include "utils/builtins.h"
+#include "utils/pg_locale.h"
+}
+
+using gpcodegen::GpCodegenUtils;
+using gpcodegen::PGTextFuncGenerator;
+using gpcodegen::PGFuncGeneratorInfo;
+
+bool PGTextFuncGenerator::TextEq(
+    gpcodegen::GpCodegenUtils* codegen_utils,
+    const PGFuncGeneratorInfo& pg_func_info,
+    llvm::Value** llvm_out_value) {
+  *llvm_out_value = GenerateTextEq(codegen_utils, pg_func_info);
+  return true;
+}
+
+bool PGTextFuncGenerator::TextNe(
+    gpcodegen::GpCodegenUtils* codegen_utils,
+    const PGFuncGeneratorInfo& pg_func_info,
+    llvm::Value** llvm_out_value) {
+  *llvm_out_value = codegen_utils->ir_builder()->CreateNot(
+      GenerateTextEq(codegen_utils, pg_func_info));
+  return true;
+}
+
+bool PGTextFuncGenerator::TextLt(
+    gpcodegen::GpCodegenUtils* codegen_utils,
+    const PGFuncGeneratorInfo& pg_func_info,
+    llvm::Value** llvm_out_value) {
+  *llvm_out_value = codegen_utils->ir_builder()->CreateICmpSLT(
+      GenerateTextCmp(codegen_utils, pg_func_info),
+      codegen_utils->GetConstant<int32_t>(0));
+  return true;
+}
+
+bool PGTextFuncGenerator::TextLe(
+    gpcodegen::GpCodegenUtils* codegen_utils,
+    const PGFuncGeneratorInfo& pg_func_info,
+    llvm::Value** llvm_out_value) {
+  *llvm_out_value = codegen_utils->ir_builder()->CreateICmpSLE(
+      GenerateTextCmp(codegen_utils, pg_func_info),
+      codegen_utils->GetConstant<int32_t>(0));
+  return true;
+}
+
+bool PGTextFuncGenerator::TextGt(
+    gpcodegen::GpCodegenUtils* codegen_utils,
+    const PGFuncGeneratorInfo& pg_func_info,
+    llvm::Value** llvm_out_value) {
+  *llvm_out_value = codegen_utils->ir_builder()->CreateICmpSGT(
+      GenerateTextCmp(codegen_utils, pg_func_info),
+      codegen_utils->GetConstant<int32_t>(0));
+  return true;
+}
+
+bool PGTextFuncGenerator::TextGe(
+    gpcodegen::GpCodegenUtils* codegen_utils,
+    const PGFuncGeneratorInfo& pg_func_info,
+    llvm::Value** llvm_out_value) {
+  *llvm_out_value = codegen_utils->ir_builder()->CreateICmpSGE(
+      GenerateTextCmp(codegen_utils, pg_func_info),
+      codegen_utils->GetConstant<int32_t>(0));
+  return true;
+}
+
+bool PGTextFuncGenerator::TextLike(
+    gpcodegen::GpCodegenUtils* codegen_utils,
+    const PGFuncGeneratorInfo& pg_func_info,
+    llvm::Value** llvm_out_value) {
+  *llvm_out_value = GenerateTextLike(codegen_utils, pg_func_info);
+  return true;
+}
+
+bool PGTextFuncGenerator::TextNLike(
+    gpcodegen::GpCodegenUtils* codegen_utils,
+    const PGFuncGeneratorInfo& pg_func_info,
+    llvm::Value** llvm_out_value) {
+  *llvm_out_value = codegen_utils->ir_builder()->CreateNot(
+      GenerateTextLike(codegen_utils, pg_func_info));
+  return true;
+}
+
+void PGTextFuncGenerator::GenerateTextArg(
+    gpcodegen::GpCodegenUtils* codegen_utils,
+    llvm::Value* llvm_arg,
+    llvm::Value** llvm_out_data,
+    llvm::Value** llvm_out_len) {
+  assert(nullptr != llvm_arg);
+  llvm::Function* llvm_pg_detoast_datum_packed = codegen_utils->
+      GetOrRegisterExternalFunction(pg_detoast_datum_packed,
+                                    "pg_detoast_datum_packed");
+
+  auto irb = codegen_utils->ir_builder();
+  llvm::Function* current_function = irb->GetInsertBlock()->getParent();
+
+  // text *arg = PG_GETARG_TEXT_PP(n);
+  llvm::Value* llvm_ptr =
+      irb->CreateCall(llvm_pg_detoast_datum_packed, {llvm_arg});
+
+  // The varlena header is stored in network byte order (see postgres.h), so
+  // the flag bits are always in the first byte.
+  llvm::Value* llvm_header0 = irb->CreateZExt(irb->CreateLoad(llvm_ptr),
+                                              codegen_utils->GetType<uint32>());
+
+  llvm::BasicBlock* short_header_block = codegen_utils->CreateBasicBlock(
+      "short_header_block", current_function);
+  llvm::BasicBlock* long_header_block = codegen_utils->CreateBasicBlock(
+      "long_header_block", current_function);
+  llvm::BasicBlock* header_done_block = codegen_utils->CreateBasicBlock(
+      "header_done_block", current_function);
+
+  // if (VARATT_IS_1B(arg))
+  irb->CreateCondBr(
+      irb->CreateICmpNE(
+          irb->CreateAnd(llvm_header0, codegen_utils->GetConstant<uint32>(0x80)),
+          codegen_utils->GetConstant<uint32>(0)),
+      short_header_block,
+      long_header_block);
+
+  // VARSIZE_1B(arg) - VARHDRSZ_SHORT {{
+  irb->SetInsertPoint(short_header_block);
+  llvm::Value* llvm_short_len = irb->CreateSub(
+      irb->CreateAnd(llvm_header0, codegen_utils->GetConstant<uint32>(0x7F)),
+      codegen_utils->GetConstant<uint32>(VARHDRSZ_SHORT));
+  irb->CreateBr(header_done_block);
+  // }}
+
+  // VARSIZE_4B(arg) - VARHDRSZ {{
+  irb->SetInsertPoint(long_header_block);
+  llvm::Value* llvm_size = irb->CreateShl(
+      irb->CreateAnd(llvm_header0, codegen_utils->GetConstant<uint32>(0x3F)),
+      24);
+  for (int i = 1; i < 4; ++i) {
+    llvm::Value* llvm_byte = irb->CreateZExt(
+        irb->CreateLoad(irb->CreateInBoundsGEP(
+            llvm_ptr, codegen_utils->GetConstant<int64>(i))),
+        codegen_utils->GetType<uint32>());
+    llvm_size = irb->CreateOr(llvm_size,
+                              irb->CreateShl(llvm_byte, 8 * (3 - i)));
+  }
+  llvm::Value* llvm_long_len = irb->CreateSub(
+      llvm_size, codegen_utils->GetConstant<uint32>(VARHDRSZ));
+  irb->CreateBr(header_done_block);
+  // }}
+
+  irb->SetInsertPoint(header_done_block);
+  llvm::PHINode* llvm_len = irb->CreatePHI(codegen_utils->GetType<uint32>(), 2);
+  llvm_len->addIncoming(llvm_short_len, short_header_block);
+  llvm_len->addIncoming(llvm_long_len, long_header_block);
+  llvm::PHINode* llvm_header_size =
+      irb->CreatePHI(codegen_utils->GetType<int64>(), 2);
+  llvm_header_size->addIncoming(
+      codegen_utils->GetConstant<int64>(VARHDRSZ_SHORT), short_header_block);
+  llvm_header_size->addIncoming(
+      codegen_utils->GetConstant<int64>(VARHDRSZ), long_header_block);
+
+  // VARDATA_ANY(arg) and VARSIZE_ANY_EXHDR(arg)
+  *llvm_out_data = irb->CreateInBoundsGEP(llvm_ptr, llvm_header_size);
+  *llvm_out_len = irb->CreateZExt(llvm_len, codegen_utils->GetType<size_t>());
+}
+
+llvm::Value* PGTextFuncGenerator::GenerateStrNEq(
+    gpcodegen::GpCodegenUtils* codegen_utils,
+    llvm::Value* llvm_data0,
+    llvm::Value* llvm_data1,
+    llvm::Value* llvm_len) {
+  llvm::Function* llvm_strncmp = codegen_utils->
+      GetOrRegisterExternalFunction(strncmp, "strncmp");
+
+  auto irb = codegen_utils->ir_builder();
+  return irb->CreateICmpEQ(
+      irb->CreateCall(llvm_strncmp, {llvm_data0, llvm_data1, llvm_len}),
+      codegen_utils->GetConstant<int32_t>(0));
+}
+
+llvm::Value* PGTextFuncGenerator::GenerateTextEq(
+    gpcodegen::GpCodegenUtils* codegen_utils,
+    const PGFuncGeneratorInfo& pg_func_info) {
+  assert(pg_func_info.llvm_args.size() == 2);
+  auto irb = codegen_utils->ir_builder();
+  llvm::Function* current_function = irb->GetInsertBlock()->getParent();
+
+  llvm::Value* llvm_data0 = nullptr;
+  llvm::Value* llvm_len0 = nullptr;
+  llvm::Value* llvm_data1 = nullptr;
+  llvm::Value* llvm_len1 = nullptr;
+  GenerateTextArg(codegen_utils, pg_func_info.llvm_args[0],
+                  &llvm_data0, &llvm_len0);
+  GenerateTextArg(codegen_utils, pg_func_info.llvm_args[1],
+                  &llvm_data1, &llvm_len1);
+
+  llvm::BasicBlock* len_check_block = irb->GetInsertBlock();
+  llvm::BasicBlock* compare_block = codegen_utils->CreateBasicBlock(
+      "texteq_compare_block", current_function);
+  llvm::BasicBlock* done_block = codegen_utils->CreateBasicBlock(
+      "texteq_done_block", current_function);
+
+  // if (VARSIZE_ANY_EXHDR(arg1) != VARSIZE_ANY_EXHDR(arg2)) result = false;
+  irb->CreateCondBr(irb->CreateICmpEQ(llvm_len0, llvm_len1),
+                    compare_block,
+                    done_block);
+
+  // else result = (strncmp(VARDATA_ANY(arg1), VARDATA_ANY(arg2), len) == 0);
+  irb->SetInsertPoint(compare_block);
+  llvm::Value* llvm_equal =
+      GenerateStrNEq(codegen_utils, llvm_data0, llvm_data1, llvm_len0);
+  irb->CreateBr(done_block);
+
+  irb->SetInsertPoint(done_block);
+  llvm::PHINode* llvm_result = irb->CreatePHI(codegen_utils->GetType<bool>(), 2);
+  llvm_result->addIncoming(codegen_utils->GetConstant<bool>(false),
+                           len_check_block);
+  llvm_result->addIncoming(llvm_equal, compare_block);
+  return llvm_result;
+}
+
+llvm::Value* PGTextFuncGenerator::GenerateTextCmp(
+    gpcodegen::GpCodegenUtils* codegen_utils,
+    const PGFuncGeneratorInfo& pg_func_info) {
+  assert(pg_func_info.llvm_args.size() == 2);
+  auto irb = codegen_utils->ir_builder();
+
+  llvm::Value* llvm_data0 = nullptr;
+  llvm::Value* llvm_len0 = nullptr;
+  llvm::Value* llvm_data1 = nullptr;
+  llvm::Value* llvm_len1 = nullptr;
+  GenerateTextArg(codegen_utils, pg_func_info.llvm_args[0],
+                  &llvm_data0, &llvm_len0);
+  GenerateTextArg(codegen_utils, pg_func_info.llvm_args[1],
+                  &llvm_data1, &llvm_len1);
+
+  // LC_COLLATE is fixed for the life of the backend, so pick the comparison
+  // when generating the code.
+  if (!lc_collate_is_c()) {
+    llvm::Function* llvm_varstr_cmp = codegen_utils->
+        GetOrRegisterExternalFunction(varstr_cmp, "varstr_cmp");
+    return irb->CreateCall(llvm_varstr_cmp, {
+        llvm_data0,
+        irb->CreateTrunc(llvm_len0, codegen_utils->GetType<int32_t>()),
+        llvm_data1,
+        irb->CreateTrunc(llvm_len1, codegen_utils->GetType<int32_t>())});
+  }
+
+  // varstr_cmp() for the C collation {{
+  llvm::Function* llvm_strncmp = codegen_utils->
+      GetOrRegisterExternalFunction(strncmp, "strncmp");
+  // result = strncmp(arg1, arg2, Min(len1, len2));
+  llvm::Value* llvm_len0_is_less = irb->CreateICmpULT(llvm_len0, llvm_len1);
+  llvm::Value* llvm_result = irb->CreateCall(llvm_strncmp, {
+      llvm_data0,
+      llvm_data1,
+      irb->CreateSelect(llvm_len0_is_less, llvm_len0, llvm_len1)});
+  // if ((result == 0) && (len1 != len2))
+  //   result = (len1 < len2) ? -1 : 1;
+  llvm::Value* llvm_len_result = irb->CreateSelect(
+      llvm_len0_is_less,
+      codegen_utils->GetConstant<int32_t>(-1),
+      irb->CreateSelect(irb->CreateICmpEQ(llvm_len0, llvm_len1),
+                        codegen_utils->GetConstant<int32_t>(0),
+                        codegen_utils->GetConstant<int32_t>(1)));
+  return irb->CreateSelect(
+      irb->CreateICmpEQ(llvm_result, codegen_utils->GetConstant<int32_t>(0)),
+      llvm_len_result,
+      llvm_result);
+  // }}
+}
+
+llvm::Value* PGTextFuncGenerator::GenerateTextLike(
+    gpcodegen::GpCodegenUtils* codegen_utils,
+    const PGFuncGeneratorInfo& pg_func_info) {
+  assert(pg_func_info.llvm_args.size() == 2);
+  auto irb = codegen_utils->ir_builder();
+  llvm::Function* current_function = irb->GetInsertBlock()->getParent();
+
+  std::string prefix;
+  bool is_prefix = false;
+  if (!GetConstPrefixPattern(pg_func_info.llvm_args[1], &prefix, &is_prefix)) {
+    // Leave the general pattern matching to textlike
+    llvm::Function* llvm_textlike = codegen_utils->
+        GetOrRegisterExternalFunction(textlike_regular, "textlike_regular");
+    return irb->CreateCall(llvm_textlike, {pg_func_info.llvm_args[0],
+                                           pg_func_info.llvm_args[1]});
+  }
+
+  llvm::Value* llvm_data = nullptr;
+  llvm::Value* llvm_len = nullptr;
+  GenerateTextArg(codegen_utils, pg_func_info.llvm_args[0],
+                  &llvm_data, &llvm_len);
+
+  // 'abc%' matches strings of at least 3 bytes that start with "abc", while
+  // 'abc' only matches "abc".
+  llvm::Value* llvm_prefix_len =
+      codegen_utils->GetConstant<size_t>(prefix.size());
+  llvm::Value* llvm_len_matches = is_prefix ?
+      irb->CreateICmpUGE(llvm_len, llvm_prefix_len) :
+      irb->CreateICmpEQ(llvm_len, llvm_prefix_len);
+  if (prefix.empty()) {
+    return llvm_len_matches;
+  }
+
+  llvm::BasicBlock* len_check_block = irb->GetInsertBlock();
+  llvm::BasicBlock* compare_block = codegen_utils->CreateBasicBlock(
+      "textlike_compare_block", current_function);
+  llvm::BasicBlock* done_block = codegen_utils->CreateBasicBlock(
+      "textlike_done_block", current_function);
+  irb->CreateCondBr(llvm_len_matches, compare_block, done_block);
+
+  irb->SetInsertPoint(compare_block);
+  llvm::Value* llvm_equal = GenerateStrNEq(
+      codegen_utils,
+      llvm_data,
+      irb->CreateGlobalStringPtr(prefix),
+      llvm_prefix_len);
+  irb->CreateBr(done_block);
+
+  irb->SetInsertPoint(done_block);
+  llvm::PHINode* llvm_result = irb->CreatePHI(codegen_utils->GetType<bool>(), 2);
+  llvm_result->addIncoming(codegen_utils->GetConstant<bool>(false),
+                           len_check_block);
+  llvm_result->addIncoming(llvm_equal, compare_block);
+  return llvm_result;
+}
+
+bool PGTextFuncGenerator::GetConstPrefixPattern(llvm::Value* llvm_pattern,
+                                                std::string* prefix,
+                                                bool* is_prefix) {
+  assert(nullptr != prefix && nullptr != is_prefix);
+
+  // A Const pattern arrives as the constant Datum cast to a pointer
+  llvm::ConstantExpr* llvm_cast = llvm::dyn_cast<llvm::ConstantExpr>(
+      llvm_pattern);
+  if (nullptr != llvm_cast &&
+      llvm::Instruction::IntToPtr == llvm_cast->getOpcode()) {
+    llvm_pattern = llvm_cast->getOperand(0);
+  }
+  llvm::ConstantInt* llvm_datum = llvm::dyn_cast<llvm::ConstantInt>(
+      llvm_pattern);
+  // A NULL pattern is never matched; the caller's strict checks skip it
+  if (nullptr == llvm_datum || 0 == llvm_datum->getZExtValue()) {
+    return false;
+  }
+
+  text* pattern = DatumGetTextPP(
+      static_cast<Datum>(llvm_datum->getZExtValue()));
+  const char* p = VARDATA_ANY(pattern);
+  int plen = VARSIZE_ANY_EXHDR(pattern);
+
+  // The server encodings never use ASCII bytes inside multibyte characters,
+  // so the wildcards can be looked for byte by byte.
+  int literal_len = 0;
+  while (literal_len < plen && '%' != p[literal_len]) {
+    if ('_' == p[literal_len] || '\\' == p[literal_len]) {
+      return false;
+    }
+    ++literal_len;
+  }
+  for (int i = literal_len; i < plen; ++i) {
+    if ('%' != p[i]) {
+      return false;
+    }
+  }
+
+  prefix->assign(p, literal_len);
+  *is_prefix = literal_len < plen;
+  return true;
+}
@@ -10,8 +10,11 @@
 //
 //---------------------------------------------------------------------------
 #include <assert.h>
+#include <stddef.h>
 #include <string.h>
+#include <algorithm>
 #include <string>
+#include <vector>
 
 #include "codegen/base_codegen.h"
 #include "codegen/codegen_wrapper.h"
@@ -124,9 +127,9 @@ bool SlotGetAttrCodegen::GenerateCodeInternal(
     return true;
   }
 
-  // Give the function a human readable name
+  // Give the function a human readable name. The slot address is left out so
+  // that the module stays the same across executions of the same plan.
   std::string function_name = GetUniqueFuncName() + "_" +
-      std::to_string(reinterpret_cast<uint64_t>(slot_)) + "_" +
       std::to_string(max_attr_);
   llvm::Function* function = CreateFunction<SlotGetAttrFn>(codegen_utils,
                                                            function_name);
@@ -189,9 +192,9 @@ bool SlotGetAttrCodegen::GenerateSlotGetAttr(
   // External functions
   llvm::Function* llvm_memset =
       codegen_utils->GetOrRegisterExternalFunction(memset, "memset");
-  llvm::Function* llvm_memtuple_getattr =
-      codegen_utils->GetOrRegisterExternalFunction(memtuple_getattr,
-                                                   "memtuple_getattr");
+  llvm::Function* llvm_slot_getsomeattrs =
+      codegen_utils->GetOrRegisterExternalFunction(slot_getsomeattrs_regular,
+                                                   "slot_getsomeattrs_regular");
   llvm::Function* llvm_slot_deform_tuple =
       codegen_utils->GetOrRegisterExternalFunction(slot_deform_tuple,
                                                    "slot_deform_tuple");
@@ -203,6 +206,10 @@ bool SlotGetAttrCodegen::GenerateSlotGetAttr(
   llvm::Value* llvm_slot = codegen_utils->GetConstant(slot);
   llvm::Value* llvm_max_attr = codegen_utils->GetConstant(max_attr);
 
+  // Memtuples built with the slot's binding are deformed by generated code
+  // as well
+  bool deform_memtuple = CanDeformMemTuple(slot, max_attr);
+
   // Function arguments to slot_getattr
   llvm::Value* llvm_slot_arg = ArgumentByPosition(slot_getattr_func, 0);
   llvm::Value* llvm_attnum_arg = ArgumentByPosition(slot_getattr_func, 1);
@@ -295,14 +302,26 @@ bool SlotGetAttrCodegen::GenerateSlotGetAttr(
   // --------------
 
   irb->SetInsertPoint(memtuple_block);
-  // return memtuple_getattr(slot->PRIVATE_tts_memtuple,
-  //    slot->tts_mt_bind, attnum, isnull);
-  llvm::Value* llvm_memtuple_ret = irb->CreateCall(llvm_memtuple_getattr, {
-      llvm_slot_PRIVATE_tts_memtuple,
-      llvm_slot_tts_mt_bind,
-      llvm_attnum_arg,
-      llvm_isnull_ptr_arg});
-  irb->CreateRet(llvm_memtuple_ret);
+  if (deform_memtuple) {
+    // Deform the memtuple into the slot, like slot_getsomeattrs() does, and
+    // return the attribute from there.
+    GenerateMemTupleDeform(codegen_utils,
+                           slot,
+                           max_attr,
+                           slot_getattr_func,
+                           llvm_slot_PRIVATE_tts_memtuple,
+                           llvm_slot_tts_mt_bind,
+                           llvm_attnum_arg,
+                           llvm_slot_PRIVATE_tts_values,
+                           llvm_slot_PRIVATE_tts_isnull,
+                           return_block);
+  } else {
+    // slot_getsomeattrs(slot, attnum), which deforms the memtuple with
+    // memtuple_getattr(). Unlike slot_getattr(), we keep the attributes in
+    // the slot, where the generated ExecVariableList() looks for them.
+    irb->CreateCall(llvm_slot_getsomeattrs, {llvm_slot, llvm_attnum_arg});
+    irb->CreateBr(return_block);
+  }
 
 
   // HeapTuple check block
@@ -402,12 +421,14 @@ bool SlotGetAttrCodegen::GenerateSlotGetAttr(
   for (; attnum < max_attr; ++attnum) {
     Form_pg_attribute thisatt = att[attnum];
 
-    // If any thisatt is varlen
-    if (thisatt->attlen < 0) {
+    // If any thisatt is varlen, passed by reference, or of a length we don't
+    // load by value
+    if (thisatt->attlen < 0 || !thisatt->attbyval ||
+        !IsSupportedByValLength(thisatt->attlen)) {
       // When we have variable length attributes, we can no longer benefit
       // from codegen, since the next offset needs to be computed after the
       // tuple is read into memory.
-      if (attnum < codegen_varlen_tolerance) {
+      if (attnum < codegen_varlen_tolerance && !deform_memtuple) {
         // Also, if one of the first few attributes is varlen, might as well
         // call slot_deform_tuple directly, instead of going through a codegen'd
         // wrapper function.
@@ -524,46 +545,9 @@ bool SlotGetAttrCodegen::GenerateSlotGetAttr(
         irb->CreateInBoundsGEP(llvm_tuple_data_ptr,
                                {irb->CreateLoad(llvm_off_ptr)});
 
-    llvm::Value* llvm_colVal = nullptr;
-    if (thisatt->attbyval) {
-      // Load the value from the calculated input address.
-      switch (thisatt->attlen) {
-        case sizeof(char):
-                  llvm_colVal = irb->CreateLoad(llvm_next_t_data_ptr);
-        break;
-        case sizeof(int16):
-                  llvm_colVal = irb->CreateLoad(
-                      codegen_utils->GetType<int16>(),
-                      irb->CreateBitCast(llvm_next_t_data_ptr,
-                                         codegen_utils->GetType<int16*>()));
-        break;
-        case sizeof(int32):
-                  llvm_colVal = irb->CreateLoad(
-                      codegen_utils->GetType<int32>(),
-                      irb->CreateBitCast(llvm_next_t_data_ptr,
-                                         codegen_utils->GetType<int32*>()));
-        break;
-        case sizeof(Datum):
-                  llvm_colVal = irb->CreateLoad(
-                      codegen_utils->GetType<int64>(),
-                      irb->CreateBitCast(llvm_next_t_data_ptr,
-                                         codegen_utils->GetType<int64*>()));
-        break;
-        default:
-          // We do not support other data type length, passed by value
-          elog(DEBUG1,
-               "We do not support other data type length, passed by value");
-          return false;
-      }
-    } else {
-      // We do not support attributes by reference
-      elog(DEBUG1, "We do not support attributes by reference");
-      return false;
-    }
-
     // store colVal into out_values[attnum]
     irb->CreateStore(
-        irb->CreateZExt(llvm_colVal, codegen_utils->GetType<Datum>()),
+        GenerateFetchAtt(codegen_utils, thisatt, llvm_next_t_data_ptr),
         llvm_next_values_ptr);
 
     // }}} End of values[attnum] = fetchatt(thisatt, tp + off)
@@ -595,7 +579,7 @@ bool SlotGetAttrCodegen::GenerateSlotGetAttr(
   // Note that we have iterated over all attributes already,
   // so simply jump to final block.
 
-  irb->SetInsertPoint(next_attribute_block);
+  irb->SetInsertPoint(attribute_block);
   irb->CreateBr(final_block);
 
 
@@ -712,3 +696,354 @@ bool SlotGetAttrCodegen::GenerateSlotGetAttr(
       slot_getattr_func);
   return true;
 }
+
+bool SlotGetAttrCodegen::IsSupportedByValLength(int attlen) {
+  switch (attlen) {
+    case sizeof(char):
+    case sizeof(int16):
+    case sizeof(int32):
+    case sizeof(Datum):
+      return true;
+    default:
+      return false;
+  }
+}
+
+llvm::Value* SlotGetAttrCodegen::GenerateFetchAtt(
+    gpcodegen::GpCodegenUtils* codegen_utils,
+    Form_pg_attribute thisatt,
+    llvm::Value* llvm_data_ptr) {
+  auto irb = codegen_utils->ir_builder();
+
+  // fetchatt(thisatt, ptr) for attributes passed by reference
+  if (!thisatt->attbyval) {
+    return irb->CreatePtrToInt(llvm_data_ptr, codegen_utils->GetType<Datum>());
+  }
+
+  // Load the value from the calculated input address.
+  llvm::Value* llvm_colVal = nullptr;
+  switch (thisatt->attlen) {
+    case sizeof(char):
+      llvm_colVal = irb->CreateLoad(
+          codegen_utils->GetType<int8>(),
+          irb->CreateBitCast(llvm_data_ptr,
+                             codegen_utils->GetType<int8*>()));
+      break;
+    case sizeof(int16):
+      llvm_colVal = irb->CreateLoad(
+          codegen_utils->GetType<int16>(),
+          irb->CreateBitCast(llvm_data_ptr,
+                             codegen_utils->GetType<int16*>()));
+      break;
+    case sizeof(int32):
+      llvm_colVal = irb->CreateLoad(
+          codegen_utils->GetType<int32>(),
+          irb->CreateBitCast(llvm_data_ptr,
+                             codegen_utils->GetType<int32*>()));
+      break;
+    case sizeof(Datum):
+      llvm_colVal = irb->CreateLoad(
+          codegen_utils->GetType<int64>(),
+          irb->CreateBitCast(llvm_data_ptr,
+                             codegen_utils->GetType<int64*>()));
+      break;
+    default:
+      assert(false);
+      return nullptr;
+  }
+  return irb->CreateZExt(llvm_colVal, codegen_utils->GetType<Datum>());
+}
+
+bool SlotGetAttrCodegen::CanDeformMemTuple(TupleTableSlot* slot,
+                                           int max_attr) {
+  MemTupleBinding* pbind = slot->tts_mt_bind;
+  TupleDesc tupleDesc = slot->tts_tupleDescriptor;
+
+  if (nullptr == pbind || nullptr == tupleDesc ||
+      max_attr > tupleDesc->natts) {
+    return false;
+  }
+
+  // Only memtuples with 2 byte offsets (pbind->bind) are deformed by the
+  // generated code; large ones are left to memtuple_getattr().
+  for (int attnum = 0; attnum < max_attr; ++attnum) {
+    Form_pg_attribute thisatt = tupleDesc->attrs[attnum];
+    MemTupleAttrBinding* attrbind = &pbind->bind.bindings[attnum];
+
+    switch (attrbind->flag) {
+      case MTB_ByVal_Native:
+        if (!IsSupportedByValLength(thisatt->attlen)) {
+          return false;
+        }
+        break;
+      case MTB_ByVal_Ptr:
+        break;
+      case MTB_ByRef:
+      case MTB_ByRef_CStr:
+        if (attrbind->len != sizeof(uint16)) {
+          return false;
+        }
+        break;
+      default:
+        return false;
+    }
+  }
+  return true;
+}
+
+void SlotGetAttrCodegen::GenerateMemTupleDeform(
+    gpcodegen::GpCodegenUtils* codegen_utils,
+    TupleTableSlot* slot,
+    int max_attr,
+    llvm::Function* slot_getattr_func,
+    llvm::Value* llvm_memtuple,
+    llvm::Value* llvm_mt_bind,
+    llvm::Value* llvm_attnum_arg,
+    llvm::Value* llvm_values,
+    llvm::Value* llvm_isnull,
+    llvm::BasicBlock* return_block) {
+  auto irb = codegen_utils->ir_builder();
+
+  MemTupleBinding* pbind = slot->tts_mt_bind;
+  MemTupleBindingCols* colbind = &pbind->bind;
+  Form_pg_attribute* att = slot->tts_tupleDescriptor->attrs;
+
+  llvm::BasicBlock* memtuple_deform_block = codegen_utils->CreateBasicBlock(
+      "memtuple_deform", slot_getattr_func);
+  llvm::BasicBlock* memtuple_no_nulls_block = codegen_utils->CreateBasicBlock(
+      "memtuple_no_nulls", slot_getattr_func);
+  llvm::BasicBlock* memtuple_nulls_block = codegen_utils->CreateBasicBlock(
+      "memtuple_nulls", slot_getattr_func);
+  llvm::BasicBlock* memtuple_final_block = codegen_utils->CreateBasicBlock(
+      "memtuple_final", slot_getattr_func);
+  llvm::BasicBlock* memtuple_regular_block = codegen_utils->CreateBasicBlock(
+      "memtuple_regular", slot_getattr_func);
+
+  llvm::Function* llvm_slot_getsomeattrs =
+      codegen_utils->GetOrRegisterExternalFunction(slot_getsomeattrs_regular,
+                                                   "slot_getsomeattrs_regular");
+
+  llvm::Value* llvm_slot = codegen_utils->GetConstant(slot);
+  llvm::Value* llvm_memtuple_bytes = irb->CreateBitCast(
+      llvm_memtuple, codegen_utils->GetType<char*>());
+
+  // Memtuple checks
+  // ---------------
+  // The binding may have been replaced since generation, and large memtuples
+  // use a different binding. Attributes past max_attr are not deformed by
+  // the generated code either.
+  llvm::Value* llvm_mt_len = irb->CreateLoad(
+      codegen_utils->GetPointerToMember(llvm_memtuple,
+                                        &MemTupleData::PRIVATE_mt_len));
+  llvm::Value* llvm_is_large = irb->CreateICmpNE(
+      irb->CreateAnd(llvm_mt_len,
+                     codegen_utils->GetConstant<uint32>(MEMTUP_LARGETUP)),
+      codegen_utils->GetConstant<uint32>(0));
+  llvm::Value* llvm_can_deform = irb->CreateAnd(
+      irb->CreateAnd(
+          irb->CreateICmpEQ(llvm_mt_bind, codegen_utils->GetConstant(pbind)),
+          irb->CreateNot(llvm_is_large)),
+      irb->CreateICmpSLE(llvm_attnum_arg,
+                         codegen_utils->GetConstant(max_attr)));
+  irb->CreateCondBr(llvm_can_deform,
+                    memtuple_deform_block /* true */,
+                    memtuple_regular_block /* false */);
+
+  // Memtuple deform block
+  // ---------------------
+  irb->SetInsertPoint(memtuple_deform_block);
+  llvm::Value* llvm_hasnull = irb->CreateICmpNE(
+      irb->CreateAnd(llvm_mt_len,
+                     codegen_utils->GetConstant<uint32>(MEMTUP_HASNULL)),
+      codegen_utils->GetConstant<uint32>(0));
+  irb->CreateCondBr(llvm_hasnull,
+                    memtuple_nulls_block /* true */,
+                    memtuple_no_nulls_block /* false */);
+
+  // No nulls block
+  // --------------
+  // Without nulls, every attribute is at the offset in its binding.
+  irb->SetInsertPoint(memtuple_no_nulls_block);
+  for (int attnum = 0; attnum < max_attr; ++attnum) {
+    MemTupleAttrBinding* attrbind = &colbind->bindings[attnum];
+    llvm::Value* llvm_attr_ptr = irb->CreateInBoundsGEP(
+        llvm_memtuple_bytes, {codegen_utils->GetConstant(attrbind->offset)});
+
+    irb->CreateStore(
+        GenerateFetchAtt(codegen_utils, att[attnum],
+                         GenerateMemTupleDataPtr(codegen_utils, attrbind,
+                                                 llvm_memtuple_bytes,
+                                                 llvm_attr_ptr)),
+        irb->CreateInBoundsGEP(llvm_values,
+                               {codegen_utils->GetConstant(attnum)}));
+    irb->CreateStore(
+        codegen_utils->GetConstant<bool>(false),
+        irb->CreateInBoundsGEP(llvm_isnull,
+                               {codegen_utils->GetConstant(attnum)}));
+  }
+  irb->CreateBr(memtuple_final_block);
+
+  // Nulls block
+  // -----------
+  // The attributes start after the null bitmap, and every null attribute
+  // that physically precedes an attribute moves it back by its aligned
+  // length. Like compute_null_save(), add up the saved bytes a byte of the
+  // null bitmap at a time, with the lookup tables in the binding.
+  irb->SetInsertPoint(memtuple_nulls_block);
+  llvm::Value* llvm_start = irb->CreateInBoundsGEP(
+      llvm_memtuple_bytes,
+      {codegen_utils->GetConstant(pbind->null_bitmap_extra_size)});
+  llvm::Value* llvm_nullp = irb->CreateInBoundsGEP(
+      llvm_memtuple_bytes,
+      {codegen_utils->GetConstant<int>(
+          offsetof(MemTupleData, PRIVATE_mt_bits) +
+          (mtbind_has_oid(pbind) ? sizeof(Oid) : 0))});
+  llvm::Value* llvm_null_saves =
+      codegen_utils->GetConstant(colbind->null_saves_aligned);
+
+  int max_null_byte = 0;
+  for (int attnum = 0; attnum < max_attr; ++attnum) {
+    max_null_byte = std::max(max_null_byte, colbind->bindings[attnum].null_byte);
+  }
+
+  // compute_null_save_b(null_saves + 32 * nbyte, b)
+  auto null_save_b = [&](int nbyte, llvm::Value* llvm_b) {
+    llvm::Value* llvm_low = irb->CreateZExt(
+        irb->CreateAnd(llvm_b, codegen_utils->GetConstant<uint8>(0xF)),
+        codegen_utils->GetType<int>());
+    llvm::Value* llvm_high = irb->CreateZExt(
+        irb->CreateLShr(llvm_b, codegen_utils->GetConstant<uint8>(4)),
+        codegen_utils->GetType<int>());
+    llvm::Value* llvm_table = irb->CreateInBoundsGEP(
+        llvm_null_saves, {codegen_utils->GetConstant(32 * nbyte)});
+    return irb->CreateAdd(
+        irb->CreateSExt(
+            irb->CreateLoad(irb->CreateInBoundsGEP(llvm_table, {llvm_low})),
+            codegen_utils->GetType<int>()),
+        irb->CreateSExt(
+            irb->CreateLoad(irb->CreateInBoundsGEP(
+                llvm_table,
+                {irb->CreateAdd(llvm_high, codegen_utils->GetConstant(16))})),
+            codegen_utils->GetType<int>()));
+  };
+
+  // null_bytes[nbyte] is the bitmap byte, and saved_before[nbyte] the bytes
+  // saved by the nulls of all the bytes before it
+  std::vector<llvm::Value*> null_bytes;
+  std::vector<llvm::Value*> saved_before;
+  llvm::Value* llvm_saved = codegen_utils->GetConstant(0);
+  for (int nbyte = 0; nbyte <= max_null_byte; ++nbyte) {
+    llvm::Value* llvm_b = irb->CreateLoad(
+        irb->CreateInBoundsGEP(llvm_nullp,
+                               {codegen_utils->GetConstant(nbyte)}));
+    null_bytes.push_back(llvm_b);
+    saved_before.push_back(llvm_saved);
+    if (nbyte < max_null_byte) {
+      llvm_saved = irb->CreateAdd(llvm_saved, null_save_b(nbyte, llvm_b));
+    }
+  }
+
+  for (int attnum = 0; attnum < max_attr; ++attnum) {
+    MemTupleAttrBinding* attrbind = &colbind->bindings[attnum];
+    int nbyte = attrbind->null_byte;
+    llvm::Value* llvm_values_ptr = irb->CreateInBoundsGEP(
+        llvm_values, {codegen_utils->GetConstant(attnum)});
+    llvm::Value* llvm_isnull_ptr = irb->CreateInBoundsGEP(
+        llvm_isnull, {codegen_utils->GetConstant(attnum)});
+
+    llvm::BasicBlock* is_null_block = codegen_utils->CreateBasicBlock(
+        "memtuple_is_null_block_" + std::to_string(attnum), slot_getattr_func);
+    llvm::BasicBlock* is_not_null_block = codegen_utils->CreateBasicBlock(
+        "memtuple_is_not_null_block_" + std::to_string(attnum),
+        slot_getattr_func);
+    llvm::BasicBlock* next_attribute_block = codegen_utils->CreateBasicBlock(
+        "memtuple_attribute_block_" + std::to_string(attnum + 1),
+        slot_getattr_func);
+
+    // nullp[null_byte] & null_mask
+    irb->CreateCondBr(
+        irb->CreateICmpNE(
+            irb->CreateAnd(null_bytes[nbyte],
+                           codegen_utils->GetConstant<uint8>(
+                               attrbind->null_mask)),
+            codegen_utils->GetConstant<uint8>(0)),
+        is_null_block /* true */,
+        is_not_null_block /* false */);
+
+    // Is null block
+    irb->SetInsertPoint(is_null_block);
+    irb->CreateStore(codegen_utils->GetConstant<Datum>(0), llvm_values_ptr);
+    irb->CreateStore(codegen_utils->GetConstant<bool>(true), llvm_isnull_ptr);
+    irb->CreateBr(next_attribute_block);
+
+    // Is not null block
+    // start + offset - compute_null_save(...)
+    irb->SetInsertPoint(is_not_null_block);
+    llvm::Value* llvm_null_save = irb->CreateAdd(
+        saved_before[nbyte],
+        null_save_b(nbyte, irb->CreateAnd(
+            null_bytes[nbyte],
+            codegen_utils->GetConstant<uint8>(attrbind->null_mask - 1))));
+    llvm::Value* llvm_attr_ptr = irb->CreateInBoundsGEP(
+        llvm_start,
+        {irb->CreateSub(codegen_utils->GetConstant(attrbind->offset),
+                        llvm_null_save)});
+    irb->CreateStore(
+        GenerateFetchAtt(codegen_utils, att[attnum],
+                         GenerateMemTupleDataPtr(codegen_utils, attrbind,
+                                                 llvm_start, llvm_attr_ptr)),
+        llvm_values_ptr);
+    irb->CreateStore(codegen_utils->GetConstant<bool>(false), llvm_isnull_ptr);
+    irb->CreateBr(next_attribute_block);
+
+    irb->SetInsertPoint(next_attribute_block);
+  }
+  irb->CreateBr(memtuple_final_block);
+
+  // Memtuple final block
+  // --------------------
+  irb->SetInsertPoint(memtuple_final_block);
+  // slot->PRIVATE_tts_nvalid = max_attr;
+  irb->CreateStore(codegen_utils->GetConstant(max_attr),
+                   codegen_utils->GetPointerToMember(
+                       llvm_slot, &TupleTableSlot::PRIVATE_tts_nvalid));
+  // TupSetVirtualTuple(slot);
+  llvm::Value* llvm_slot_PRIVATE_tts_flags_ptr =
+      codegen_utils->GetPointerToMember(
+          llvm_slot, &TupleTableSlot::PRIVATE_tts_flags);
+  irb->CreateStore(
+      irb->CreateOr(
+          irb->CreateLoad(llvm_slot_PRIVATE_tts_flags_ptr),
+          codegen_utils->GetConstant<int>(TTS_VIRTUAL)),
+      llvm_slot_PRIVATE_tts_flags_ptr);
+  irb->CreateBr(return_block);
+
+  // Memtuple regular block
+  // ----------------------
+  // slot_getsomeattrs(slot, attnum), which deforms the memtuple with
+  // memtuple_getattr()
+  irb->SetInsertPoint(memtuple_regular_block);
+  irb->CreateCall(llvm_slot_getsomeattrs, {llvm_slot, llvm_attnum_arg});
+  irb->CreateBr(return_block);
+}
+
+llvm::Value* SlotGetAttrCodegen::GenerateMemTupleDataPtr(
+    gpcodegen::GpCodegenUtils* codegen_utils,
+    MemTupleAttrBinding* attrbind,
+    llvm::Value* llvm_start,
+    llvm::Value* llvm_attr_ptr) {
+  auto irb = codegen_utils->ir_builder();
+
+  if (attrbind->flag == MTB_ByVal_Native || attrbind->flag == MTB_ByVal_Ptr) {
+    return llvm_attr_ptr;
+  }
+
+  // Variable length attributes store their 2 byte offset from start
+  assert(attrbind->len == sizeof(uint16));
+  llvm::Value* llvm_offset = irb->CreateLoad(
+      codegen_utils->GetType<uint16>(),
+      irb->CreateBitCast(llvm_attr_ptr, codegen_utils->GetType<uint16*>()));
+  return irb->CreateInBoundsGEP(
+      llvm_start,
+      {irb->CreateZExt(llvm_offset, codegen_utils->GetType<int>())});
+}
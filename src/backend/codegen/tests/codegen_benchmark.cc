@@ -0,0 +1,330 @@
+//---------------------------------------------------------------------------
+//  Greenplum Database
+//  Copyright 2016 Pivotal Software, Inc.
+//
+//  @filename:
+//    codegen_benchmark.cc
+//
+//  @doc:
+//    Standalone benchmarks for the code generators. For each generator and
+//    parameter, measures the time to generate and to compile the code, and
+//    the per call time of the regular and of the generated function. Results
+//    are printed to stdout as one JSON object per line, which
+//    src/test/performance/codegen_benchmark.py can compare to a baseline.
+//
+//    Usage: codegen_benchmark.t [iterations [optimization_level]]
+//
+//---------------------------------------------------------------------------
+
+#include <chrono>  // NOLINT(build/c++11)
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+extern "C" {
+#include "postgres.h"  // NOLINT(build/include)
+#undef newNode  // undef newNode so it doesn't have name collision with llvm
+#include "access/heapam.h"
+#include "access/tupdesc.h"
+#include "catalog/pg_type.h"
+#include "executor/tuptable.h"
+#include "nodes/execnodes.h"
+#include "nodes/pg_list.h"
+#include "utils/guc.h"
+#include "utils/int8.h"
+#include "utils/memutils.h"
+}
+
+#include "llvm/IR/BasicBlock.h"
+#include "llvm/IR/Function.h"
+#include "llvm/IR/Value.h"
+
+#include "codegen/base_codegen.h"
+#include "codegen/codegen_manager.h"
+#include "codegen/codegen_wrapper.h"
+#include "codegen/op_expr_tree_generator.h"
+#include "codegen/pg_func_generator_interface.h"
+#include "codegen/utils/gp_codegen_utils.h"
+#include "codegen/utils/utility.h"
+
+namespace gpcodegen {
+
+namespace {
+
+typedef std::chrono::steady_clock Clock;
+
+// Tuple widths for slot_getattr
+const int kTupleWidths[] = {4, 16, 64, 256};
+
+const int kDefaultIterations = 1000000;
+
+// int8pl, whose generator is used to build the expression trees
+const unsigned int kInt8PlOid = 463;
+
+double ElapsedMs(Clock::time_point start) {
+  return std::chrono::duration<double, std::milli>(Clock::now() - start)
+      .count();
+}
+
+double ElapsedNsPerCall(Clock::time_point start, int iterations) {
+  return std::chrono::duration<double, std::nano>(Clock::now() - start)
+      .count() / iterations;
+}
+
+void PrintResult(const char* benchmark, int param,
+                 double generation_ms, double compilation_ms,
+                 double regular_ns, double generated_ns) {
+  std::printf("{\"suite\": \"standalone\", \"benchmark\": \"%s\", "
+              "\"param\": %d, \"generation_ms\": %.3f, "
+              "\"compilation_ms\": %.3f, \"regular_ns_per_call\": %.3f, "
+              "\"generated_ns_per_call\": %.3f, \"speedup\": %.3f}\n",
+              benchmark, param, generation_ms, compilation_ms,
+              regular_ns, generated_ns, regular_ns / generated_ns);
+  std::fflush(stdout);
+}
+
+// Keep the results of the benchmarked calls alive
+volatile Datum sink;
+
+// Deform tuples of width int4 and int8 attributes through ExecVariableList,
+// which calls the generated slot_getattr.
+void BenchmarkSlotGetAttr(int width, int iterations, int optimization_level) {
+  TupleDesc tupdesc = CreateTemplateTupleDesc(width, false);
+  for (int i = 0; i < width; ++i) {
+    Form_pg_attribute att = tupdesc->attrs[i];
+    MemSet(att, 0, ATTRIBUTE_FIXED_PART_SIZE);
+    att->attnum = i + 1;
+    // Mix in an int8 every fourth attribute, so that alignment is exercised
+    if (i % 4 == 3) {
+      att->atttypid = INT8OID;
+      att->attlen = sizeof(int64);
+      att->attalign = 'd';
+    } else {
+      att->atttypid = INT4OID;
+      att->attlen = sizeof(int32);
+      att->attalign = 'i';
+    }
+    att->attbyval = true;
+    att->attstorage = 'p';
+  }
+
+  Datum* values = static_cast<Datum*>(palloc(width * sizeof(Datum)));
+  bool* isnull = static_cast<bool*>(palloc0(width * sizeof(bool)));
+  for (int i = 0; i < width; ++i) {
+    values[i] = (i % 4 == 3) ? Int64GetDatum(i) : Int32GetDatum(i);
+  }
+  HeapTuple tuple = heap_form_tuple(tupdesc, values, isnull);
+  TupleTableSlot* slot = MakeSingleTupleTableSlot(tupdesc);
+
+  // newNode is undefined above, so set the node tags by hand
+  ExprContext* econtext = static_cast<ExprContext*>(
+      palloc0(sizeof(ExprContext)));
+  econtext->type = T_ExprContext;
+  econtext->ecxt_scantuple = slot;
+  ProjectionInfo* proj_info = static_cast<ProjectionInfo*>(
+      palloc0(sizeof(ProjectionInfo)));
+  proj_info->type = T_ProjectionInfo;
+  proj_info->pi_exprContext = econtext;
+  proj_info->pi_varNumbers = static_cast<int*>(palloc(width * sizeof(int)));
+  proj_info->pi_varSlotOffsets =
+      static_cast<int*>(palloc(width * sizeof(int)));
+  for (int i = 0; i < width; ++i) {
+    proj_info->pi_targetlist = lappend(proj_info->pi_targetlist, nullptr);
+    proj_info->pi_varNumbers[i] = i + 1;
+    proj_info->pi_varSlotOffsets[i] = offsetof(ExprContext, ecxt_scantuple);
+  }
+
+  ExecVariableListFn exec_variable_list = ExecVariableList;
+  void* manager = CodeGeneratorManagerCreate("codegen_benchmark",
+                                             optimization_level);
+  void* old_manager = GetActiveCodeGeneratorManager();
+  SetActiveCodeGeneratorManager(manager);
+  ExecVariableListCodegenEnroll(ExecVariableList, &exec_variable_list,
+                                proj_info, slot);
+  SetActiveCodeGeneratorManager(old_manager);
+
+  Clock::time_point start = Clock::now();
+  CodeGeneratorManagerGenerateCode(manager);
+  double generation_ms = ElapsedMs(start);
+  start = Clock::now();
+  CodeGeneratorManagerPrepareGeneratedFunctions(manager);
+  double compilation_ms = ElapsedMs(start);
+
+  // Store the tuple again before each call, so that it is deformed again
+  start = Clock::now();
+  for (int i = 0; i < iterations; ++i) {
+    ExecStoreHeapTuple(tuple, slot, InvalidBuffer, false);
+    ExecVariableList(proj_info, values, isnull);
+  }
+  double regular_ns = ElapsedNsPerCall(start, iterations);
+  sink = values[width - 1];
+
+  start = Clock::now();
+  for (int i = 0; i < iterations; ++i) {
+    ExecStoreHeapTuple(tuple, slot, InvalidBuffer, false);
+    exec_variable_list(proj_info, values, isnull);
+  }
+  double generated_ns = ElapsedNsPerCall(start, iterations);
+  sink = values[width - 1];
+
+  PrintResult("slot_getattr", width, generation_ms, compilation_ms,
+              regular_ns, generated_ns);
+
+  CodeGeneratorManagerDestroy(manager);
+  ExecDropSingleTupleTableSlot(slot);
+  heap_freetuple(tuple);
+}
+
+typedef int64 (*ExprDepthFn)(int64 x, int64 y);
+
+// Evaluates x + y + ... + y, with depth additions, through the fmgr like
+// ExecEvalExpr does for an expression tree of that depth.
+template <int depth>
+int64 ExprDepthRegular(int64 x, int64 y) {
+  Datum result = Int64GetDatum(x);
+  for (int i = 0; i < depth; ++i) {
+    result = DirectFunctionCall2(int8pl, result, Int64GetDatum(y));
+  }
+  return DatumGetInt64(result);
+}
+
+// Generates x + y + ... + y with the int8pl generator of the OpExpr tree.
+class ExprDepthCodegen : public BaseCodegen<ExprDepthFn> {
+ public:
+  explicit ExprDepthCodegen(gpcodegen::CodegenManager* manager,
+                            ExprDepthFn regular_func_ptr,
+                            ExprDepthFn* ptr_to_regular_func_ptr,
+                            int depth) :
+                            BaseCodegen(manager,
+                                        kExprDepthFuncNamePrefix,
+                                        regular_func_ptr,
+                                        ptr_to_regular_func_ptr),
+                            depth_(depth) {
+  }
+
+  virtual ~ExprDepthCodegen() = default;
+
+ protected:
+  bool GenerateCodeInternal(gpcodegen::GpCodegenUtils* codegen_utils) final {
+    PGFuncGeneratorInterface* pg_func_gen =
+        OpExprTreeGenerator::GetPGFuncGenerator(kInt8PlOid);
+    if (nullptr == pg_func_gen) {
+      return false;
+    }
+
+    llvm::Function* expr_func = CreateFunction<ExprDepthFn>(
+        codegen_utils, GetUniqueFuncName());
+    auto irb = codegen_utils->ir_builder();
+    llvm::BasicBlock* entry_block = codegen_utils->CreateBasicBlock(
+        "entry", expr_func);
+    llvm::BasicBlock* error_block = codegen_utils->CreateBasicBlock(
+        "error", expr_func);
+
+    irb->SetInsertPoint(entry_block);
+    llvm::Value* llvm_isnull_ptr = irb->CreateAlloca(
+        codegen_utils->GetType<bool>(), nullptr, "isnull");
+    llvm::Value* llvm_y = codegen_utils->CreateCppTypeToDatumCast(
+        ArgumentByPosition(expr_func, 1));
+    llvm::Value* llvm_result = ArgumentByPosition(expr_func, 0);
+    for (int i = 0; i < depth_; ++i) {
+      std::vector<llvm::Value*> llvm_args = {
+          codegen_utils->CreateCppTypeToDatumCast(llvm_result), llvm_y};
+      std::vector<llvm::Value*> llvm_args_isNull = {
+          codegen_utils->GetConstant<bool>(false),
+          codegen_utils->GetConstant<bool>(false)};
+      PGFuncGeneratorInfo pg_func_info(expr_func, error_block,
+                                       llvm_args, llvm_args_isNull);
+      if (!pg_func_gen->GenerateCode(codegen_utils, pg_func_info,
+                                     &llvm_result, llvm_isnull_ptr)) {
+        return false;
+      }
+    }
+    irb->CreateRet(llvm_result);
+
+    irb->SetInsertPoint(error_block);
+    irb->CreateRet(codegen_utils->GetConstant<int64>(0));
+    return true;
+  }
+
+ public:
+  static constexpr char kExprDepthFuncNamePrefix[] = "ExprDepthFunc";
+
+ private:
+  int depth_;
+};
+
+constexpr char ExprDepthCodegen::kExprDepthFuncNamePrefix[];
+
+template <int depth>
+void BenchmarkExprDepth(int iterations, int optimization_level) {
+  ExprDepthFn expr_depth = ExprDepthRegular<depth>;
+  CodegenManager manager("codegen_benchmark", optimization_level);
+  manager.EnrollCodeGenerator(
+      CodegenFuncLifespan_Parameter_Invariant,
+      new ExprDepthCodegen(&manager, ExprDepthRegular<depth>, &expr_depth,
+                           depth));
+
+  Clock::time_point start = Clock::now();
+  manager.GenerateCode();
+  double generation_ms = ElapsedMs(start);
+  start = Clock::now();
+  manager.PrepareGeneratedFunctions();
+  double compilation_ms = ElapsedMs(start);
+
+  int64 result = 0;
+  start = Clock::now();
+  for (int i = 0; i < iterations; ++i) {
+    result += ExprDepthRegular<depth>(i, 1);
+  }
+  double regular_ns = ElapsedNsPerCall(start, iterations);
+  sink = Int64GetDatum(result);
+
+  result = 0;
+  start = Clock::now();
+  for (int i = 0; i < iterations; ++i) {
+    result += expr_depth(i, 1);
+  }
+  double generated_ns = ElapsedNsPerCall(start, iterations);
+  sink = Int64GetDatum(result);
+
+  PrintResult("expr_int8pl_depth", depth, generation_ms, compilation_ms,
+              regular_ns, generated_ns);
+}
+
+}  // namespace
+
+}  // namespace gpcodegen
+
+int main(int argc, char **argv) {
+  int iterations = gpcodegen::kDefaultIterations;
+  int optimization_level = CODEGEN_OPTIMIZATION_LEVEL_DEFAULT;
+  if (argc > 1) {
+    iterations = std::atoi(argv[1]);
+  }
+  if (argc > 2) {
+    optimization_level = std::atoi(argv[2]);
+  }
+  if (iterations <= 0) {
+    std::fprintf(stderr, "usage: %s [iterations [optimization_level]]\n",
+                 argv[0]);
+    return 1;
+  }
+
+  MemoryContextInit();
+  if (InitCodegen() != 1) {
+    std::fprintf(stderr, "could not initialize codegen\n");
+    return 1;
+  }
+
+  for (int width : gpcodegen::kTupleWidths) {
+    gpcodegen::BenchmarkSlotGetAttr(width, iterations, optimization_level);
+  }
+
+  gpcodegen::BenchmarkExprDepth<1>(iterations, optimization_level);
+  gpcodegen::BenchmarkExprDepth<4>(iterations, optimization_level);
+  gpcodegen::BenchmarkExprDepth<16>(iterations, optimization_level);
+  gpcodegen::BenchmarkExprDepth<64>(iterations, optimization_level);
+  return 0;
+}
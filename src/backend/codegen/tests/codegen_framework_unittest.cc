@@ -338,7 +338,8 @@ class CodegenManagerTestEnvironment : public ::testing::Environment {
 class CodegenManagerTest : public ::testing::Test {
  protected:
   virtual void SetUp() {
-    manager_.reset(new CodegenManager("CodegenManagerTest"));
+    manager_.reset(new CodegenManager("CodegenManagerTest",
+                                       CODEGEN_OPTIMIZATION_LEVEL_NONE));
     codegen_validate_functions = true;
   }
 
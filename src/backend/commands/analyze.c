@@ -25,6 +25,7 @@
 #include "catalog/indexing.h"
 #include "catalog/namespace.h"
 #include "catalog/pg_namespace.h"
+#include "cdb/cdbhash.h"
 #include "cdb/cdbpartition.h"
 #include "cdb/cdbtm.h"
 #include "cdb/cdbvars.h"
@@ -128,6 +129,13 @@ static Datum ind_fetch_func(VacAttrStatsP stats, int rownum, bool *isNull);
 static bool std_typanalyze(VacAttrStats *stats);
 
 static void analyzeEstimateReltuplesRelpages(Oid relationOid, float4 *relTuples, float4 *relPages, bool rootonly);
+static void analyzeSumReltuplesRelpages(List *relOids, const char *fromClause,
+										float4 *relTuples, float4 *relPages);
+static bool analyzeCanSampleAoBlocks(Relation onerel);
+static void analyzeComputeNDistinctHll(Relation onerel, int nattrs, VacAttrStats **attrstats,
+									   double totalrows);
+static void analyzeComputeDependencies(Relation onerel, int nattrs, VacAttrStats **attrstats,
+									   HeapTuple *rows, int numrows);
 static void analyzeEstimateIndexpages(Relation onerel, Relation indrel, BlockNumber *indexPages);
 
 static void analyze_rel_internal(Oid relid, VacuumStmt *vacstmt,
@@ -545,9 +553,24 @@ analyze_rel_internal(Oid relid, VacuumStmt *vacstmt,
 								rows, numrows,
 								col_context);
 
+		if (gp_statistics_collect_dependencies)
+		{
+			analyzeComputeDependencies(onerel, attr_cnt, vacattrstats,
+									   rows, numrows);
+			MemoryContextResetAndDeleteChildren(col_context);
+		}
+
 		MemoryContextSwitchTo(old_context);
 		MemoryContextDelete(col_context);
 
+		/*
+		 * The sample says little about the number of distinct values of a
+		 * column with many of them. Count them over the whole table, if
+		 * asked to.
+		 */
+		if (gp_statistics_use_hll && totalrows > numrows)
+			analyzeComputeNDistinctHll(onerel, attr_cnt, vacattrstats, totalrows);
+
 		/*
 		 * Emit the completed stats rows into pg_statistic, replacing any
 		 * previous statistics for the target columns.	(If there are stats in
@@ -1417,6 +1440,7 @@ acquire_sample_rows_by_query(Relation onerel, int nattrs, VacAttrStats **attrsta
 	const char *schemaName = NULL;
 	const char *tableName = NULL;
 	float4		randomThreshold = 0.0;
+	double		blockFraction = 1.0;
 	float4		relTuples;
 	float4		relPages;
 	int			ret;
@@ -1443,6 +1467,31 @@ acquire_sample_rows_by_query(Relation onerel, int nattrs, VacAttrStats **attrsta
 	 * thresholdStr is left empty.
 	 */
 	randomThreshold = targrows / relTuples;
+
+	/*
+	 * For append-only row tables, choose varblocks at random first, and rows
+	 * within the chosen varblocks, so that the scan can skip the other
+	 * varblocks without decompressing them. The probability for a row to be
+	 * selected stays the same.
+	 *
+	 * Aim for about one row per varblock, like acquire_sample_rows() does
+	 * with heap blocks. A varblock takes at most blocksize bytes on disk, so
+	 * this underestimates the number of varblocks, which errs towards
+	 * reading more of them.
+	 */
+	if (randomThreshold < 1.0 && gp_statistics_ao_block_sampling &&
+		analyzeCanSampleAoBlocks(onerel))
+	{
+		double		nvarblocks;
+
+		nvarblocks = ((double) relPages * BLCKSZ) / onerel->rd_appendonly->blocksize;
+		if (nvarblocks > targrows)
+		{
+			blockFraction = Max(targrows / nvarblocks, randomThreshold);
+			randomThreshold = randomThreshold / blockFraction;
+		}
+	}
+
 	initStringInfo(&thresholdStr);
 	if (randomThreshold < 1.0)
 		appendStringInfo(&thresholdStr, "where random() < %.38f", randomThreshold);
@@ -1552,6 +1601,23 @@ acquire_sample_rows_by_query(Relation onerel, int nattrs, VacAttrStats **attrsta
 		ereport(ERROR, (errcode(ERRCODE_CDB_INTERNAL_ERROR),
 						errmsg("Unable to connect to execute internal query.")));
 
+	/*
+	 * The scans pick up the fraction of varblocks to read from the GUC, so
+	 * set it for the sample query, on the QEs too. If the query fails, the
+	 * abort undoes the SET.
+	 */
+	if (blockFraction < 1.0)
+	{
+		StringInfoData setStr;
+
+		initStringInfo(&setStr);
+		appendStringInfo(&setStr, "set gp_statistics_ao_block_sample_fraction = %.38f",
+						 blockFraction);
+		elog(elevel, "Executing SQL: %s", setStr.data);
+		SPI_execute(setStr.data, false, 0);
+		pfree(setStr.data);
+	}
+
 	elog(elevel, "Executing SQL: %s", str.data);
 
 	/*
@@ -1634,12 +1700,135 @@ acquire_sample_rows_by_query(Relation onerel, int nattrs, VacAttrStats **attrsta
 			 quote_identifier(tableName));
 	}
 
+	if (blockFraction < 1.0)
+		SPI_execute("reset gp_statistics_ao_block_sample_fraction", false, 0);
+
 	SPI_finish();
 
 	return sampleTuples;
 }
 
 
+/*
+ * Replace the stadistinct estimates from the sample with estimates from
+ * gp_hll_ndistinct() over the whole relation. Each segment builds a
+ * HyperLogLog sketch of its rows, and the QD merges them; for a partitioned
+ * table, the sketches of all the parts are merged.
+ */
+static void
+analyzeComputeNDistinctHll(Relation onerel, int nattrs, VacAttrStats **attrstats,
+						   double totalrows)
+{
+	StringInfoData str;
+	VacAttrStats **hllstats;
+	int			nhllstats = 0;
+	int			i;
+
+	/* Same restriction as acquire_sample_rows_by_query() */
+	if (rel_has_external_partition(RelationGetRelid(onerel)))
+		return;
+
+	hllstats = (VacAttrStats **) palloc(nattrs * sizeof(VacAttrStats *));
+
+	initStringInfo(&str);
+	appendStringInfoString(&str, "select ");
+	for (i = 0; i < nattrs; i++)
+	{
+		VacAttrStats *stats = attrstats[i];
+
+		if (!stats->stats_valid || !isGreenplumDbHashable(stats->attr->atttypid))
+			continue;
+
+		if (nhllstats > 0)
+			appendStringInfoString(&str, ", ");
+		appendStringInfo(&str, "pg_catalog.gp_hll_ndistinct(Ta.%s)",
+						 quote_identifier(NameStr(stats->attr->attname)));
+		hllstats[nhllstats++] = stats;
+	}
+	appendStringInfo(&str, " from %s.%s as Ta",
+					 quote_identifier(get_namespace_name(RelationGetNamespace(onerel))),
+					 quote_identifier(RelationGetRelationName(onerel)));
+
+	if (nhllstats == 0)
+	{
+		pfree(str.data);
+		pfree(hllstats);
+		return;
+	}
+
+	if (SPI_OK_CONNECT != SPI_connect())
+		ereport(ERROR, (errcode(ERRCODE_CDB_INTERNAL_ERROR),
+						errmsg("Unable to connect to execute internal query.")));
+
+	elog(elevel, "Executing SQL: %s", str.data);
+
+	if (SPI_execute(str.data, false, 1) != SPI_OK_SELECT || SPI_processed != 1)
+		elog(ERROR, "could not estimate the number of distinct values of \"%s\"",
+			 RelationGetRelationName(onerel));
+
+	for (i = 0; i < nhllstats; i++)
+	{
+		VacAttrStats *stats = hllstats[i];
+		bool		isnull;
+		double		ndistinct;
+		double		nonnullrows;
+
+		ndistinct = DatumGetFloat8(heap_getattr(SPI_tuptable->vals[0], i + 1,
+												SPI_tuptable->tupdesc, &isnull));
+		if (isnull)
+			continue;
+
+		/* The estimate can't be more than the number of non-null rows */
+		nonnullrows = totalrows * (1.0 - stats->stanullfrac);
+		if (ndistinct > nonnullrows)
+			ndistinct = nonnullrows;
+		ndistinct = floor(ndistinct + 0.5);
+
+		/*
+		 * Like compute_scalar_stats(), store it as a fraction of the rows if
+		 * it is likely to scale with the table.
+		 */
+		if (ndistinct > 0.1 * totalrows)
+			stats->stadistinct = -(ndistinct / totalrows);
+		else
+			stats->stadistinct = ndistinct;
+	}
+
+	SPI_finish();
+
+	pfree(str.data);
+	pfree(hllstats);
+}
+
+/*
+ * Can the sample query of acquire_sample_rows_by_query() sample the relation
+ * by varblock? Only if everything it scans is append-only row storage; the
+ * rows of other tables would be undersampled.
+ */
+static bool
+analyzeCanSampleAoBlocks(Relation onerel)
+{
+	Oid			relid = RelationGetRelid(onerel);
+	List	   *leafRelids;
+	ListCell   *lc;
+
+	if (!RelationIsAoRows(onerel))
+		return false;
+
+	if (!rel_is_partitioned(relid) &&
+		rel_part_status(relid) != PART_STATUS_INTERIOR)
+		return true;
+
+	leafRelids = rel_get_leaf_children_relids(relid);
+	foreach(lc, leafRelids)
+	{
+		if (get_rel_relstorage(lfirst_oid(lc)) != RELSTORAGE_AOROWS)
+			return false;
+	}
+
+	return true;
+}
+
 /**
  * This method estimates reltuples/relpages for a relation. To do this, it employs
  * the built-in function 'gp_statistics_estimate_reltuples_relpages'. If the table to be
@@ -1674,62 +1863,97 @@ analyzeEstimateReltuplesRelpages(Oid relationOid, float4 *relTuples, float4 *rel
 		allRelOids = list_make1_oid(relationOid);
 	}
 
-	/* iterate over all parts and add up estimates */
-	ListCell *lc = NULL;
+	/*
+	 * Add up the estimates of all the parts. Rather than dispatching a query
+	 * for each part, which adds up to a long time for tables with many
+	 * parts, ask for all of them at once; the parts on the master and those
+	 * on the segments take one query each.
+	 */
+	List	   *entryRelOids = NIL;
+	List	   *distRelOids = NIL;
+	ListCell   *lc = NULL;
+
 	foreach (lc, allRelOids)
 	{
 		Oid			singleOid = lfirst_oid(lc);
-		StringInfoData	sqlstmt;
-		int			ret;
-		Datum		arrayDatum;
-		bool		isNull;
-		Datum	   *values = NULL;
-		int			valuesLength;
-
-		initStringInfo(&sqlstmt);
 
 		if (GpPolicyFetch(CurrentMemoryContext, singleOid)->ptype == POLICYTYPE_ENTRY)
-		{
-			appendStringInfo(&sqlstmt, "select sum(gp_statistics_estimate_reltuples_relpages_oid(c.oid))::float4[] "
-					"from pg_class c where c.oid=%d", singleOid);
-		}
+			entryRelOids = lappend_oid(entryRelOids, singleOid);
 		else
-		{
-			appendStringInfo(&sqlstmt, "select sum(gp_statistics_estimate_reltuples_relpages_oid(c.oid))::float4[] "
-					"from gp_dist_random('pg_class') c where c.oid=%d", singleOid);
-		}
-
-		if (SPI_OK_CONNECT != SPI_connect())
-			ereport(ERROR, (errcode(ERRCODE_CDB_INTERNAL_ERROR),
-							errmsg("Unable to connect to execute internal query.")));
+			distRelOids = lappend_oid(distRelOids, singleOid);
+	}
 
-		elog(elevel, "Executing SQL: %s", sqlstmt.data);
+	analyzeSumReltuplesRelpages(entryRelOids, "pg_class", relTuples, relPages);
+	analyzeSumReltuplesRelpages(distRelOids, "gp_dist_random('pg_class')", relTuples, relPages);
 
-		/* Do the query. */
-		ret = SPI_execute(sqlstmt.data, true, 0);
-		Assert(ret > 0);
-		Assert(SPI_tuptable != NULL);
-		Assert(SPI_processed == 1);
+	list_free(entryRelOids);
+	list_free(distRelOids);
 
-		arrayDatum = heap_getattr(SPI_tuptable->vals[0], 1, SPI_tuptable->tupdesc, &isNull);
-		if (isNull)
-			elog(ERROR, "could not get estimated number of tuples and pages for relation %u", singleOid);
+	return;
+}
 
-		deconstruct_array(DatumGetArrayTypeP(arrayDatum),
-						  FLOAT4OID,
-						  sizeof(float4),
-						  true,
-						  'i',
-						  &values, NULL, &valuesLength);
-		Assert(valuesLength == 2);
+/*
+ * Add the reltuples/relpages estimates of the relations in relOids to
+ * *relTuples and *relPages, with one query on pg_class as seen through
+ * fromClause.
+ */
+static void
+analyzeSumReltuplesRelpages(List *relOids, const char *fromClause,
+							float4 *relTuples, float4 *relPages)
+{
+	StringInfoData	sqlstmt;
+	int			ret;
+	Datum		arrayDatum;
+	bool		isNull;
+	Datum	   *values = NULL;
+	int			valuesLength;
+	ListCell   *lc;
 
-		*relTuples += DatumGetFloat4(values[0]);
-		*relPages += DatumGetFloat4(values[1]);
+	if (relOids == NIL)
+		return;
 
-		SPI_finish();
+	initStringInfo(&sqlstmt);
+	appendStringInfo(&sqlstmt, "select sum(gp_statistics_estimate_reltuples_relpages_oid(c.oid))::float4[] "
+					 "from %s c where c.oid in (", fromClause);
+	foreach (lc, relOids)
+	{
+		if (lc != list_head(relOids))
+			appendStringInfoString(&sqlstmt, ", ");
+		appendStringInfo(&sqlstmt, "%u", lfirst_oid(lc));
 	}
+	appendStringInfoChar(&sqlstmt, ')');
 
-	return;
+	if (SPI_OK_CONNECT != SPI_connect())
+		ereport(ERROR, (errcode(ERRCODE_CDB_INTERNAL_ERROR),
+						errmsg("Unable to connect to execute internal query.")));
+
+	elog(elevel, "Executing SQL: %s", sqlstmt.data);
+
+	/* Do the query. */
+	ret = SPI_execute(sqlstmt.data, true, 0);
+	Assert(ret > 0);
+	Assert(SPI_tuptable != NULL);
+	Assert(SPI_processed == 1);
+
+	arrayDatum = heap_getattr(SPI_tuptable->vals[0], 1, SPI_tuptable->tupdesc, &isNull);
+	if (isNull)
+		elog(ERROR, "could not get estimated number of tuples and pages for relation %u",
+			 linitial_oid(relOids));
+
+	deconstruct_array(DatumGetArrayTypeP(arrayDatum),
+					  FLOAT4OID,
+					  sizeof(float4),
+					  true,
+					  'i',
+					  &values, NULL, &valuesLength);
+	Assert(valuesLength == 2);
+
+	*relTuples += DatumGetFloat4(values[0]);
+	*relPages += DatumGetFloat4(values[1]);
+
+	SPI_finish();
+
+	pfree(sqlstmt.data);
 }
 
 /**
@@ -3067,3 +3291,174 @@ compare_mcvs(const void *a, const void *b)
 
 	return da - db;
 }
+
+/*
+ * Number of columns considered by analyzeComputeDependencies(). Each pair of
+ * them costs a pass over the sample, so only the leading columns of a wide
+ * table are considered.
+ */
+#define ANALYZE_MAX_DEPENDENCY_COLUMNS	8
+
+/*
+ * Measure the functional dependencies between the columns in the sample, and
+ * save them in a STATISTIC_KIND_DEPENDENCY slot of each determining column.
+ *
+ * The degree to which column a determines column b is the fraction of the
+ * sampled rows, with a not null, whose group of rows with the same value of a
+ * all have the same value of b (NULLs counting as one value). The rows are
+ * sorted once per column a, after which each group is a run of rows.
+ *
+ * Only columns analyzed by compute_scalar_stats() are considered, as the
+ * grouping needs a sort operator.
+ */
+static void
+analyzeComputeDependencies(Relation onerel, int nattrs, VacAttrStats **attrstats,
+						   HeapTuple *rows, int numrows)
+{
+	VacAttrStats *depstats[ANALYZE_MAX_DEPENDENCY_COLUMNS];
+	FmgrInfo	cmpfns[ANALYZE_MAX_DEPENDENCY_COLUMNS];
+	int			cmpflags[ANALYZE_MAX_DEPENDENCY_COLUMNS];
+	Datum	   *values[ANALYZE_MAX_DEPENDENCY_COLUMNS];
+	bool	   *nulls[ANALYZE_MAX_DEPENDENCY_COLUMNS];
+	int			ndepstats = 0;
+	ScalarItem *items;
+	int		   *tupnoLink;
+	int			a,
+				b,
+				i;
+
+	for (i = 0; i < nattrs && ndepstats < ANALYZE_MAX_DEPENDENCY_COLUMNS; i++)
+	{
+		VacAttrStats *stats = attrstats[i];
+		StdAnalyzeData *mystats;
+		Oid			cmpFn;
+		bool		is_varlena;
+		int			rownum;
+
+		if (!stats->stats_valid || stats->compute_stats != compute_scalar_stats)
+			continue;
+
+		mystats = (StdAnalyzeData *) stats->extra_data;
+		SelectSortFunction(mystats->ltopr, false, &cmpFn, &cmpflags[ndepstats]);
+		fmgr_info(cmpFn, &cmpfns[ndepstats]);
+
+		/* Fetch the values once, detoasted, as each is compared many times */
+		is_varlena = (!stats->attr->attbyval && stats->attr->attlen == -1);
+		values[ndepstats] = (Datum *) palloc(numrows * sizeof(Datum));
+		nulls[ndepstats] = (bool *) palloc(numrows * sizeof(bool));
+		for (rownum = 0; rownum < numrows; rownum++)
+		{
+			Datum		value;
+			bool		isnull;
+
+			value = heap_getattr(rows[rownum], stats->attr->attnum,
+								 onerel->rd_att, &isnull);
+			if (!isnull && is_varlena)
+				value = PointerGetDatum(PG_DETOAST_DATUM(value));
+			values[ndepstats][rownum] = value;
+			nulls[ndepstats][rownum] = isnull;
+		}
+
+		depstats[ndepstats++] = stats;
+	}
+
+	if (ndepstats < 2)
+		return;
+
+	items = (ScalarItem *) palloc(numrows * sizeof(ScalarItem));
+	tupnoLink = (int *) palloc(numrows * sizeof(int));
+
+	for (a = 0; a < ndepstats; a++)
+	{
+		VacAttrStats *stats = depstats[a];
+		CompareScalarsContext cxt;
+		int			nitems = 0;
+		int			slot;
+		float4	   *numbers;
+		int			nnumbers = 0;
+
+		for (slot = 0; slot < STATISTIC_NUM_SLOTS; slot++)
+		{
+			if (stats->stakind[slot] == 0)
+				break;
+		}
+		if (slot >= STATISTIC_NUM_SLOTS)
+			continue;
+
+		vacuum_delay_point();
+
+		for (i = 0; i < numrows; i++)
+		{
+			if (nulls[a][i])
+				continue;
+			items[nitems].value = values[a][i];
+			items[nitems].tupno = i;
+			tupnoLink[i] = i;
+			nitems++;
+		}
+		if (nitems == 0)
+			continue;
+
+		cxt.cmpFn = &cmpfns[a];
+		cxt.cmpFlags = cmpflags[a];
+		cxt.tupnoLink = tupnoLink;
+		qsort_arg((void *) items, nitems, sizeof(ScalarItem),
+				  compare_scalars, (void *) &cxt);
+
+		numbers = (float4 *) MemoryContextAlloc(stats->anl_context,
+												2 * (ndepstats - 1) * sizeof(float4));
+
+		for (b = 0; b < ndepstats; b++)
+		{
+			int			consistent = 0;
+			int			start;
+			int			end;
+
+			if (b == a)
+				continue;
+
+			for (start = 0; start < nitems; start = end)
+			{
+				int			first = items[start].tupno;
+				bool		same = true;
+
+				for (end = start + 1; end < nitems; end++)
+				{
+					int			tupno = items[end].tupno;
+
+					if (ApplySortFunction(&cmpfns[a], cmpflags[a],
+										  items[start].value, false,
+										  items[end].value, false) != 0)
+						break;
+
+					if (same &&
+						(nulls[b][first] != nulls[b][tupno] ||
+						 (!nulls[b][first] &&
+						  ApplySortFunction(&cmpfns[b], cmpflags[b],
+											values[b][first], false,
+											values[b][tupno], false) != 0)))
+						same = false;
+				}
+
+				if (same)
+					consistent += end - start;
+			}
+
+			if (consistent > 0)
+			{
+				numbers[nnumbers++] = (float4) depstats[b]->attr->attnum;
+				numbers[nnumbers++] = (float4) consistent / (float4) nitems;
+			}
+		}
+
+		if (nnumbers > 0)
+		{
+			stats->stakind[slot] = STATISTIC_KIND_DEPENDENCY;
+			stats->staop[slot] = InvalidOid;
+			stats->stanumbers[slot] = numbers;
+			stats->numnumbers[slot] = nnumbers;
+		}
+		else
+			pfree(numbers);
+	}
+}
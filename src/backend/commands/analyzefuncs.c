@@ -1,12 +1,18 @@
 #include "postgres.h"
 
+#include <math.h>
+
 #include "access/aocssegfiles.h"
+#include "access/hash.h"
 #include "catalog/pg_appendonly_fn.h"
 #include "cdb/cdbappendonlyam.h"
 #include "cdb/cdbfilerepprimary.h"
+#include "cdb/cdbhash.h"
 #include "cdb/cdbvars.h"
+#include "lib/hyperloglog.h"
 #include "storage/bufmgr.h"
 #include "utils/builtins.h"
+#include "utils/lsyscache.h"
 #include "utils/rel.h"
 #include "miscadmin.h"
 
@@ -20,6 +26,10 @@ bool			gp_statistics_use_fkeys = FALSE;
 int				gp_statistics_blocks_target = 25;
 double			gp_statistics_ndistinct_scaling_ratio_threshold = 0.10;
 double			gp_statistics_sampling_threshold = 10000;
+bool			gp_statistics_ao_block_sampling = TRUE;
+double			gp_statistics_ao_block_sample_fraction = 1.0;
+bool			gp_statistics_use_hll = FALSE;
+bool			gp_statistics_collect_dependencies = FALSE;
 
 /**
  * This method estimates the number of tuples and pages in a heaptable relation. Getting the number of blocks is straightforward.
@@ -370,3 +380,118 @@ gp_statistics_estimate_reltuples_relpages_oid(PG_FUNCTION_ARGS)
 
 	PG_RETURN_ARRAYTYPE_P(result);
 }
+
+/*
+ * gp_hll_ndistinct(anyelement) aggregate.
+ *
+ * Estimates the number of distinct non-NULL values with a HyperLogLog sketch.
+ * The transition state is a bytea holding the registers of the sketch; it
+ * starts out empty, and the registers are allocated on the first value. The
+ * preliminary function merges the sketches of the segments.
+ */
+typedef struct HllTypeCache
+{
+	Oid			typid;			/* type of the aggregated values */
+	Oid			basetypid;		/* its base type, for a domain */
+} HllTypeCache;
+
+#define HLL_SKETCH_SIZE		(VARHDRSZ + HLL_REGISTERS)
+
+static bytea *
+hll_sketch_for_update(bytea *sketch)
+{
+	if (VARSIZE(sketch) != HLL_SKETCH_SIZE)
+	{
+		Assert(VARSIZE(sketch) == VARHDRSZ);
+		sketch = (bytea *) palloc0(HLL_SKETCH_SIZE);
+		SET_VARSIZE(sketch, HLL_SKETCH_SIZE);
+	}
+	return sketch;
+}
+
+/* Implements datumHashFunction */
+static void
+hll_hash_buf(void *clientData, void *buf, size_t len)
+{
+	uint32	   *hash = (uint32 *) clientData;
+
+	*hash = ((*hash << 1) | (*hash >> 31)) ^
+		DatumGetUInt32(hash_any((unsigned char *) buf, len));
+}
+
+Datum
+gp_hll_accum(PG_FUNCTION_ARGS)
+{
+	bytea	   *sketch = PG_GETARG_BYTEA_P(0);
+	HllTypeCache *cache = (HllTypeCache *) fcinfo->flinfo->fn_extra;
+	uint32		hash = 0;
+
+	Assert(fcinfo->context && IS_AGG_EXECUTION_NODE(fcinfo->context));
+
+	if (cache == NULL)
+	{
+		cache = (HllTypeCache *) MemoryContextAlloc(fcinfo->flinfo->fn_mcxt,
+													sizeof(HllTypeCache));
+		cache->typid = get_fn_expr_argtype(fcinfo->flinfo, 1);
+		if (!OidIsValid(cache->typid))
+			ereport(ERROR,
+					(errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+					 errmsg("could not determine input data type")));
+		if (!isGreenplumDbHashable(cache->typid))
+			ereport(ERROR,
+					(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+					 errmsg("HyperLogLog sketches do not support type %s",
+							format_type_be(cache->typid))));
+		cache->basetypid = getBaseType(cache->typid);
+		fcinfo->flinfo->fn_extra = cache;
+	}
+
+	hashDatum(PG_GETARG_DATUM(1), cache->basetypid, hll_hash_buf, &hash);
+
+	sketch = hll_sketch_for_update(sketch);
+	hll_add_hash((uint8 *) VARDATA(sketch), hash);
+
+	PG_RETURN_BYTEA_P(sketch);
+}
+
+Datum
+gp_hll_merge(PG_FUNCTION_ARGS)
+{
+	bytea	   *sketch = PG_GETARG_BYTEA_P(0);
+	bytea	   *other = PG_GETARG_BYTEA_P(1);
+
+	if (VARSIZE(other) != HLL_SKETCH_SIZE)
+		PG_RETURN_BYTEA_P(sketch);
+
+	sketch = hll_sketch_for_update(sketch);
+	hll_merge((uint8 *) VARDATA(sketch), (uint8 *) VARDATA(other));
+
+	PG_RETURN_BYTEA_P(sketch);
+}
+
+Datum
+gp_hll_ndistinct_final(PG_FUNCTION_ARGS)
+{
+	bytea	   *sketch = PG_GETARG_BYTEA_P(0);
+
+	if (VARSIZE(sketch) != HLL_SKETCH_SIZE)
+		PG_RETURN_FLOAT8(0.0);
+
+	PG_RETURN_FLOAT8(hll_estimate((uint8 *) VARDATA(sketch)));
+}
+
+/*
+ * approx_count_distinct(anyelement) aggregate: the same sketch as
+ * gp_hll_ndistinct, for use in queries, so rounded to a count like
+ * count(DISTINCT).
+ */
+Datum
+approx_count_distinct_final(PG_FUNCTION_ARGS)
+{
+	bytea	   *sketch = PG_GETARG_BYTEA_P(0);
+
+	if (VARSIZE(sketch) != HLL_SKETCH_SIZE)
+		PG_RETURN_INT64(0);
+
+	PG_RETURN_INT64((int64) rint(hll_estimate((uint8 *) VARDATA(sketch))));
+}
@@ -22,6 +22,10 @@
 #include <netinet/in.h>
 #include <arpa/inet.h>
 
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
 #include "access/fileam.h"
 #include "access/heapam.h"
 #include "access/appendonlywriter.h"
@@ -30,6 +34,7 @@
 #include "catalog/pg_type.h"
 #include "cdb/cdbappendonlyam.h"
 #include "cdb/cdbaocsam.h"
+#include "cdb/cdbfilerepprimary.h"
 #include "cdb/cdbpartition.h"
 #include "commands/copy.h"
 #include "commands/tablecmds.h"
@@ -80,6 +85,15 @@ extern void CopyToDispatch(CopyState cstate);
 static void CopyTo(CopyState cstate);
 extern void CopyFromDispatch(CopyState cstate);
 static void CopyFrom(CopyState cstate);
+static void CopyFromInsertBatch(CopyState cstate, EState *estate,
+					CommandId mycid, bool use_wal, bool use_fsm,
+					ResultRelInfo *resultRelInfo, TupleTableSlot *slot,
+					int nbatch, HeapTuple *batch_tuples, int *batch_linenos);
+static void CopyFromFlushBatch(CopyState cstate, EState *estate,
+				   CommandId mycid, bool use_wal, bool use_fsm,
+				   TupleTableSlot *baseSlot, int nbatch,
+				   HeapTuple *batch_tuples, int *batch_linenos,
+				   ResultRelInfo **batch_relinfos);
 static void CopyFromProcessDataFileHeader(CopyState cstate, CdbCopy *cdbCopy, bool *pfile_has_oids);
 static char *CopyReadOidAttr(CopyState cstate, bool *isnull);
 static void CopyAttributeOutText(CopyState cstate, char *string);
@@ -112,6 +126,8 @@ static bool CopyGetInt64(CopyState cstate, int64 *val);
 /* byte scaning utils */
 static char *scanTextLine(CopyState cstate, const char *s, char c, size_t len);
 static char *scanCSVLine(CopyState cstate, const char *s, char c1, char c2, char c3, size_t len);
+static inline const char *scanSpecialChar(const char *s, const char *end,
+				char c1, char c2, char c3);
 
 static void CopyExtractRowMetaData(CopyState cstate);
 static void preProcessDataLine(CopyState cstate);
@@ -123,6 +139,9 @@ static void attr_get_key(CopyState cstate, CdbCopy *cdbCopy, int original_lineno
 						 FmgrInfo *in_functions, Oid *typioparams, Datum *values);
 static void copy_in_error_callback(void *arg);
 static void CopyInitPartitioningState(EState *estate);
+static bool CopyBeginBulkLoad(int64 *mirrorSessionNum);
+static void CopyFinishBulkLoad(Relation rel, int64 mirrorSessionNum);
+static void CopyLogRelationPages(Relation rel);
 static void CopyInitDataParser(CopyState cstate);
 static bool CopyCheckIsLastLine(CopyState cstate);
 static char *extract_line_buf(CopyState cstate);
@@ -1436,6 +1455,13 @@ DoCopyInternal(const CopyStmt *stmt, const char *queryString, CopyState cstate)
 					ereport(ERROR,
 							(errmsg("could not execute command \"%s\": %m",
 									cstate->filename)));
+
+				/*
+				 * Rows are written one at a time; as for a file, buffer them
+				 * so that the program gets large writes. With ON SEGMENT this
+				 * is how every segment feeds its own compressor.
+				 */
+				setvbuf(cstate->copy_file, NULL, _IOFBF, 393216); // 384 Kbytes
 			}
 			else
 			{
@@ -3247,6 +3273,14 @@ CopyFromDispatch(CopyState cstate)
 	AttrNumber	h_attnum;		/* hash key attribute number */
 	unsigned int target_seg = 0;	/* result segment of cdbhash */
 
+	/*
+	 * Variables for sending the rows of a randomly distributed table in
+	 * blocks, see gp_copy_dispatch_block_size
+	 */
+	bool		dispatch_in_blocks;
+	StringInfoData dispatch_block;
+	int			block_seg = 0;
+
 	tupDesc = RelationGetDescr(cstate->rel);
 	attr = tupDesc->attrs;
 	num_phys_attrs = tupDesc->natts;
@@ -3379,6 +3413,24 @@ CopyFromDispatch(CopyState cstate)
 	cdbHash = distData->cdbHash;
 	p_attr_types = distData->p_attr_types;
 	p_nattrs = distData->p_nattrs;
+
+	/*
+	 * A randomly distributed table has no key for us to parse, and any
+	 * segment can take any row. Skip parsing the attributes and send the
+	 * rows in large blocks, round-robin over the segments. The segments
+	 * parse the rows as usual.
+	 */
+	dispatch_in_blocks = (gp_copy_dispatch_block_size > 0 &&
+						  p_nattrs == 0 &&
+						  !estate->es_result_partitions &&
+						  !cstate->binary &&
+						  !cstate->on_segment);
+	if (dispatch_in_blocks)
+	{
+		initStringInfo(&dispatch_block);
+		block_seg = random() % cdbCopy->total_segs;
+	}
+
 	/* allocate memory for error and copy strings */
 	initStringInfo(&cdbcopy_err);
 	initStringInfo(&cdbcopy_cmd);
@@ -3709,7 +3761,11 @@ CopyFromDispatch(CopyState cstate)
 					/*
 					 * parse and convert the data line attributes.
 					 */
-					if (!cstate->binary)
+					if (dispatch_in_blocks)
+					{
+						/* nothing to parse, the segments will do it */
+					}
+					else if (!cstate->binary)
 					{
 					if (cstate->csv_mode)
 						CopyReadAttributesCSV(cstate, nulls, attr_offsets, num_phys_attrs, attr);
@@ -3993,7 +4049,8 @@ CopyFromDispatch(CopyState cstate)
 				 * key columns). Send COPY data line to the target segment
 				 * database executors. Data row will not be inserted locally.
 				 */
-				target_seg  = GetTargetSeg(part_distData, values, nulls);
+				if (!dispatch_in_blocks)
+					target_seg = GetTargetSeg(part_distData, values, nulls);
 				/*
 				 * Send data row to all databases for this segment.
 				 * Also send the original row number with the data.
@@ -4027,7 +4084,24 @@ CopyFromDispatch(CopyState cstate)
 				}
 				
 				/* send modified data */
-				if (!cstate->on_segment) {
+				if (dispatch_in_blocks)
+				{
+					appendBinaryStringInfo(&dispatch_block,
+										   line_buf_with_lineno.data,
+										   line_buf_with_lineno.len);
+					RESET_LINEBUF_WITH_LINENO;
+
+					if (dispatch_block.len >= gp_copy_dispatch_block_size * 1024L)
+					{
+						cdbCopySendData(cdbCopy,
+										block_seg,
+										dispatch_block.data,
+										dispatch_block.len);
+						resetStringInfo(&dispatch_block);
+						block_seg = (block_seg + 1) % cdbCopy->total_segs;
+					}
+				}
+				else if (!cstate->on_segment) {
 					cdbCopySendData(cdbCopy,
 									target_seg,
 									line_buf_with_lineno.data,
@@ -4057,6 +4131,19 @@ CopyFromDispatch(CopyState cstate)
 		}
 	} while (!no_more_data);
 
+	/* send the last, partly filled block */
+	if (dispatch_in_blocks && dispatch_block.len > 0 &&
+		!cdbCopy->io_errors && !QueryCancelPending)
+	{
+		cdbCopySendData(cdbCopy,
+						block_seg,
+						dispatch_block.data,
+						dispatch_block.len);
+
+		if (cdbCopy->io_errors)
+			appendBinaryStringInfo(&cdbcopy_err, cdbCopy->err_msg.data, cdbCopy->err_msg.len);
+	}
+
 	/*
 	 * Done reading input data and sending it off to the segment
 	 * databases Now we would like to end the copy command on
@@ -4261,6 +4348,7 @@ CopyFrom(CopyState cstate)
 	CommandId	mycid = GetCurrentCommandId(true);
 	bool		use_wal = true; /* by default, use WAL logging */
 	bool		use_fsm = true; /* by default, use FSM for free space */
+	int64		mirrorSessionNum = 0;
 	int		   *attr_offsets;
 	bool		no_more_data = false;
 	ListCell   *cur;
@@ -4277,10 +4365,26 @@ CopyFrom(CopyState cstate)
 	GpDistributionData	*distData = NULL; /* distribution data used to compute target seg */
 	unsigned int	target_seg = 0; /* result segment of cdbhash */
 
+	/*
+	 * Rows for a heap table, or for the heap partitions of a partitioned
+	 * table, are collected in batches, and each batch is inserted with
+	 * heap_multi_insert, one partition at a time. See CopyFromFlushBatch.
+	 */
+#define MAX_BUFFERED_TUPLES		1000
+#define MAX_BUFFERED_BYTES		65535
+	bool		use_multi_insert;
+	MemoryContext batchcontext = NULL;
+	HeapTuple  *batch_tuples = NULL;
+	int		   *batch_linenos = NULL;
+	ResultRelInfo **batch_relinfos = NULL;
+	int			nbatch = 0;
+	Size		batch_bytes = 0;
+
 	/*----------
 	 * Check to see if we can avoid writing WAL
 	 *
-	 * If archive logging is not enabled *and* either
+	 * If the WAL can be bypassed (on segments, see XLog_CanBypassWal) *and*
+	 * either
 	 *	- table was created in same transaction as this COPY
 	 *	- data is being written to relfilenode created in this transaction
 	 * then we can skip writing WAL.  It's safe because if the transaction
@@ -4288,6 +4392,13 @@ CopyFrom(CopyState cstate)
 	 * If it does commit, we'll have done the heap_sync at the bottom of this
 	 * routine first.
 	 *
+	 * Pages that are not WAL-logged reach the mirror only while it is in
+	 * sync, so the load starts without WAL only if the mirror is in sync
+	 * (or not configured), and the pages are WAL-logged after all at the
+	 * end if the mirror went out of sync meanwhile.  Only a plain heap
+	 * table is loaded this way, so that the pages to log are the table's
+	 * and its toast table's.
+	 *
 	 * As mentioned in comments in utils/rel.h, the in-same-transaction test
 	 * is not completely reliable, since in rare cases rd_createSubid or
 	 * rd_newRelfilenodeSubid can be cleared before the end of the transaction.
@@ -4308,7 +4419,11 @@ CopyFrom(CopyState cstate)
 		cstate->rel->rd_newRelfilenodeSubid != InvalidSubTransactionId)
 	{
 		use_fsm = false;
-		if (!XLogArchivingActive())
+		if (XLog_CanBypassWal() &&
+			RelationIsHeap(cstate->rel) &&
+			!cstate->rel->rd_istemp &&
+			!rel_is_partitioned(RelationGetRelid(cstate->rel)) &&
+			CopyBeginBulkLoad(&mirrorSessionNum))
 			use_wal = false;
 	}
 
@@ -4341,6 +4456,26 @@ CopyFrom(CopyState cstate)
 	/* Set up a tuple slot too */
 	baseSlot = MakeSingleTupleTableSlot(tupDesc);
 
+	/*
+	 * Row triggers must see the rows one at a time, so those take the
+	 * heap_insert path. Whether a row of a partitioned table can be batched
+	 * depends on the storage of its partition.
+	 */
+	use_multi_insert = ((RelationIsHeap(cstate->rel) ||
+						 estate->es_result_partitions) &&
+						resultRelInfo->ri_TrigDesc == NULL);
+	if (use_multi_insert)
+	{
+		batchcontext = AllocSetContextCreate(CurrentMemoryContext,
+											 "COPY batch",
+											 ALLOCSET_DEFAULT_MINSIZE,
+											 ALLOCSET_DEFAULT_INITSIZE,
+											 ALLOCSET_DEFAULT_MAXSIZE);
+		batch_tuples = palloc(MAX_BUFFERED_TUPLES * sizeof(HeapTuple));
+		batch_linenos = palloc(MAX_BUFFERED_TUPLES * sizeof(int));
+		batch_relinfos = palloc(MAX_BUFFERED_TUPLES * sizeof(ResultRelInfo *));
+	}
+
 	econtext = GetPerTupleExprContext(estate);
 
 	/*
@@ -4872,6 +5007,16 @@ PROCESS_SEGMENT_DATA:
 				{
                     tuple = NULL;
 				}
+				else if (use_multi_insert && relstorage == RELSTORAGE_HEAP)
+				{
+					/* form a heap tuple that lives until its batch is inserted */
+					MemoryContextSwitchTo(batchcontext);
+					tuple = (HeapTuple) heap_form_tuple(resultRelInfo->ri_RelationDesc->rd_att, values, nulls);
+					MemoryContextSwitchTo(GetPerTupleMemoryContext(estate));
+
+					if (cstate->oids && file_has_oids)
+						HeapTupleSetOid((HeapTuple)tuple, loaded_oid);
+				}
 				else
 				{
 					/* form a regular heap tuple */
@@ -4977,6 +5122,26 @@ PROCESS_SEGMENT_DATA:
 					{
 						external_insert(resultRelInfo->ri_extInsertDesc, tuple);
 					}
+					else if (use_multi_insert && relstorage == RELSTORAGE_HEAP)
+					{
+						batch_tuples[nbatch] = (HeapTuple) tuple;
+						batch_linenos[nbatch] = cstate->cur_lineno;
+						batch_relinfos[nbatch] = resultRelInfo;
+						nbatch++;
+						batch_bytes += ((HeapTuple) tuple)->t_len;
+
+						if (nbatch == MAX_BUFFERED_TUPLES ||
+							batch_bytes >= MAX_BUFFERED_BYTES)
+						{
+							CopyFromFlushBatch(cstate, estate, mycid,
+											   use_wal, use_fsm, baseSlot,
+											   nbatch, batch_tuples,
+											   batch_linenos, batch_relinfos);
+							nbatch = 0;
+							batch_bytes = 0;
+							MemoryContextReset(batchcontext);
+						}
+					}
 					else
 					{
 						heap_insert(resultRelInfo->ri_RelationDesc, tuple, mycid, use_wal, use_fsm, GetCurrentTransactionId());
@@ -5013,6 +5178,17 @@ PROCESS_SEGMENT_DATA:
 		}
 	} while (!no_more_data);
 
+	/* insert the rows left in the last batch */
+	if (nbatch > 0)
+	{
+		MemoryContextSwitchTo(estate->es_query_cxt);
+		CopyFromFlushBatch(cstate, estate, mycid, use_wal, use_fsm, baseSlot,
+						   nbatch, batch_tuples, batch_linenos, batch_relinfos);
+		nbatch = 0;
+		batch_bytes = 0;
+		MemoryContextReset(batchcontext);
+	}
+
 	/*
 	 * After processed data from QD, which is empty and just for workflow, now
 	 * to process the data on segment, only one shot if cstate->on_segment &&
@@ -5109,10 +5285,11 @@ PROCESS_SEGMENT_DATA:
 
 	/*
 	 * If we skipped writing WAL, then we need to sync the heap (but not
-	 * indexes since those use WAL anyway)
+	 * indexes since those use WAL anyway), and to make sure the mirror has
+	 * it too.
 	 */
 	if (!use_wal)
-		heap_sync(cstate->rel);
+		CopyFinishBulkLoad(cstate->rel, mirrorSessionNum);
 
 	/*
 	 * Finalize appends and close relations we opened.
@@ -5145,6 +5322,133 @@ PROCESS_SEGMENT_DATA:
 	FreeExecutorState(estate);
 }
 
+/*
+ * Insert a batch of heap tuples collected by CopyFrom with
+ * heap_multi_insert, and then create their index entries.
+ *
+ * The error context points at the line each index entry comes from, so
+ * that a unique violation reports the right row.
+ */
+static void
+CopyFromInsertBatch(CopyState cstate, EState *estate, CommandId mycid,
+					bool use_wal, bool use_fsm,
+					ResultRelInfo *resultRelInfo, TupleTableSlot *slot,
+					int nbatch, HeapTuple *batch_tuples, int *batch_linenos)
+{
+	MemoryContext oldcontext;
+	int			save_cur_lineno = cstate->cur_lineno;
+	int			i;
+
+	/* heap_multi_insert leaks, call it in the per-tuple context */
+	oldcontext = MemoryContextSwitchTo(GetPerTupleMemoryContext(estate));
+	heap_multi_insert(resultRelInfo->ri_RelationDesc, batch_tuples, nbatch,
+					  mycid, use_wal, use_fsm, GetCurrentTransactionId());
+	MemoryContextSwitchTo(oldcontext);
+
+	if (resultRelInfo->ri_NumIndices > 0)
+	{
+		for (i = 0; i < nbatch; i++)
+		{
+			cstate->cur_lineno = batch_linenos[i];
+
+			ExecStoreGenericTuple(batch_tuples[i], slot, false);
+			ExecInsertIndexTuples(slot, &(batch_tuples[i]->t_self), estate, false);
+			ResetPerTupleExprContext(estate);
+		}
+	}
+
+	/* the batch memory is about to be reset, don't leave it in the slot */
+	ExecClearTuple(slot);
+
+	cstate->cur_lineno = save_cur_lineno;
+}
+
+/* qsort_arg comparator: order batch positions by relation, then position */
+static int
+batch_relinfo_cmp(const void *a, const void *b, void *arg)
+{
+	ResultRelInfo **batch_relinfos = (ResultRelInfo **) arg;
+	int			ia = *(const int *) a;
+	int			ib = *(const int *) b;
+
+	if (batch_relinfos[ia] != batch_relinfos[ib])
+		return ((uintptr_t) batch_relinfos[ia] < (uintptr_t) batch_relinfos[ib]) ? -1 : 1;
+	return (ia < ib) ? -1 : (ia > ib) ? 1 : 0;
+}
+
+/*
+ * Insert the batch of heap tuples collected by CopyFrom. The tuples of a
+ * partitioned table may go to several partitions; group them by partition,
+ * keeping their order within each, and insert each group in one go, so
+ * that every partition gets its rows in bulk.
+ */
+static void
+CopyFromFlushBatch(CopyState cstate, EState *estate, CommandId mycid,
+				   bool use_wal, bool use_fsm, TupleTableSlot *baseSlot,
+				   int nbatch, HeapTuple *batch_tuples, int *batch_linenos,
+				   ResultRelInfo **batch_relinfos)
+{
+	ResultRelInfo *save_relinfo = estate->es_result_relation_info;
+	HeapTuple  *group_tuples;
+	int		   *group_linenos;
+	int		   *order;
+	int			i;
+	int			start;
+
+	/* the common case: all the rows go to one relation */
+	for (i = 1; i < nbatch; i++)
+	{
+		if (batch_relinfos[i] != batch_relinfos[0])
+			break;
+	}
+	if (i == nbatch)
+	{
+		ResultRelInfo *relinfo = batch_relinfos[0];
+
+		estate->es_result_relation_info = relinfo;
+		CopyFromInsertBatch(cstate, estate, mycid, use_wal, use_fsm, relinfo,
+							relinfo->ri_partSlot ? relinfo->ri_partSlot : baseSlot,
+							nbatch, batch_tuples, batch_linenos);
+		estate->es_result_relation_info = save_relinfo;
+		return;
+	}
+
+	order = palloc(nbatch * sizeof(int));
+	group_tuples = palloc(nbatch * sizeof(HeapTuple));
+	group_linenos = palloc(nbatch * sizeof(int));
+
+	for (i = 0; i < nbatch; i++)
+		order[i] = i;
+	qsort_arg(order, nbatch, sizeof(int), batch_relinfo_cmp, batch_relinfos);
+
+	start = 0;
+	while (start < nbatch)
+	{
+		ResultRelInfo *relinfo = batch_relinfos[order[start]];
+		int			n = 0;
+
+		while (start + n < nbatch && batch_relinfos[order[start + n]] == relinfo)
+		{
+			group_tuples[n] = batch_tuples[order[start + n]];
+			group_linenos[n] = batch_linenos[order[start + n]];
+			n++;
+		}
+
+		/* ExecInsertIndexTuples inserts into the indexes of this relation */
+		estate->es_result_relation_info = relinfo;
+		CopyFromInsertBatch(cstate, estate, mycid, use_wal, use_fsm, relinfo,
+							relinfo->ri_partSlot ? relinfo->ri_partSlot : baseSlot,
+							n, group_tuples, group_linenos);
+		start += n;
+	}
+
+	estate->es_result_relation_info = save_relinfo;
+
+	pfree(order);
+	pfree(group_tuples);
+	pfree(group_linenos);
+}
+
 /*
  * Finds the next TEXT line that is in the input buffer and loads
  * it into line_buf. Returns an indication if the line that was read
@@ -5904,8 +6208,8 @@ CopyReadAttributesText(CopyState cstate, bool * __restrict nulls,
 		*(stop-1) = delimc;
 
 		/* Find the next of: delimiter, or escape, or end of buffer */
-		for (scanner = scan_start; *scanner != delimc && *scanner != escapec; scanner++)
-			;
+		scanner = (char *) scanSpecialChar(scan_start, stop - 1,
+										   delimc, escapec, escapec);
 		if (scanner == (stop-1) && endchar != delimc)
 		{
 			if (endchar != escapec)
@@ -6338,6 +6642,32 @@ CopyReadAttributesCSV(CopyState cstate, bool *nulls, int *attr_offsets,
 			break;
 		}
 
+		/*
+		 * Copy the run of bytes up to the next one that means something in
+		 * the current state in one go.
+		 */
+		{
+			const char *run = &cstate->line_buf.data[cstate->line_buf.cursor];
+			const char *next;
+			int			runlen;
+
+			if (in_quote)
+				next = scanSpecialChar(run, cstate->line_buf.data + cstate->line_buf.len - 1,
+									   escapec, quotec, quotec);
+			else
+				next = scanSpecialChar(run, cstate->line_buf.data + cstate->line_buf.len - 1,
+									   cstate->delimiter_off ? quotec : delimc,
+									   quotec, quotec);
+			runlen = next - run;
+			if (runlen > 0)
+			{
+				appendBinaryStringInfo(&cstate->attribute_buf, run, runlen);
+				cstate->line_buf.cursor += runlen;
+				cstate->attribute_buf.cursor += runlen;
+				continue;
+			}
+		}
+
 		c = cstate->line_buf.data[cstate->line_buf.cursor++];
 
 		/* unquoted field delimiter  */
@@ -7252,6 +7582,43 @@ attr_get_key(CopyState cstate, CdbCopy *cdbCopy, int original_lineno_for_qe,
 	}			/* end for partitioning indexes */
 }
 
+/*
+ * scanSpecialChar
+ *
+ * Returns the first byte in [s, end) that is c1, c2 or c3, or end if there
+ * is none.  Pass the same character more than once to look for fewer.
+ * Looks at 16 bytes at a time where SSE2 is available.  Only safe on data
+ * in which a multibyte character can't contain any of the characters.
+ */
+static inline const char *
+scanSpecialChar(const char *s, const char *end, char c1, char c2, char c3)
+{
+#ifdef __SSE2__
+	__m128i		v1 = _mm_set1_epi8(c1);
+	__m128i		v2 = _mm_set1_epi8(c2);
+	__m128i		v3 = _mm_set1_epi8(c3);
+
+	while (end - s >= 16)
+	{
+		__m128i		chunk = _mm_loadu_si128((const __m128i *) s);
+		uint32		mask;
+
+		mask = _mm_movemask_epi8(_mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(chunk, v1),
+														   _mm_cmpeq_epi8(chunk, v2)),
+											  _mm_cmpeq_epi8(chunk, v3)));
+		if (mask != 0)
+			return s + __builtin_ctz(mask);
+		s += 16;
+	}
+#endif
+	for (; s < end; s++)
+	{
+		if (*s == c1 || *s == c2 || *s == c3)
+			break;
+	}
+	return s;
+}
+
 /*
  * The following are custom versions of the string function strchr().
  * As opposed to the original strchr which searches through
@@ -7341,6 +7708,19 @@ scanCSVLine(CopyState cstate, const char *s, char eol, char escapec, char quotec
 	{	
 		for ( ; *s != eol && s < end ; s++)
 		{
+			/* skip the bytes that only clear last_was_esc */
+			const char *next = scanSpecialChar(s, end, eol, escapec, quotec);
+
+			if (next != s)
+			{
+				cstate->last_was_esc = false;
+				s = next;
+				if (s == end)
+					break;
+				if (*s == eol)
+					break;
+			}
+
 			if (cstate->in_quote && *s == escapec)
 				cstate->last_was_esc = !cstate->last_was_esc;
 			if (*s == quotec && !cstate->last_was_esc)
@@ -7514,6 +7894,100 @@ CreateCopyDestReceiver(void)
 }
 
 
+/*
+ * Check whether a COPY into a heap table may skip WAL, as far as the mirror
+ * is concerned: the mirror must be in sync (or not configured), so that it
+ * gets every page written.  Returns the mirror data loss tracking session,
+ * for CopyFinishBulkLoad to tell whether that stayed so.
+ */
+static bool
+CopyBeginBulkLoad(int64 *mirrorSessionNum)
+{
+	MIRROREDLOCK_BUFMGR_DECLARE;
+
+	MirrorDataLossTrackingState mirrorState;
+
+	/* -------- MirroredLock ---------- */
+	MIRROREDLOCK_BUFMGR_LOCK;
+
+	mirrorState = FileRepPrimary_GetMirrorDataLossTrackingSessionNum(mirrorSessionNum);
+
+	MIRROREDLOCK_BUFMGR_UNLOCK;
+	/* -------- MirroredLock ---------- */
+
+	return (mirrorState == MirrorDataLossTrackingState_MirrorNotConfigured ||
+			mirrorState == MirrorDataLossTrackingState_MirrorCurrentlyUpInSync);
+}
+
+/*
+ * Finish a COPY that skipped WAL: sync the heap, and WAL-log its pages
+ * after all if the mirror went out of sync since CopyBeginBulkLoad, so
+ * that resynchronization brings them over.
+ */
+static void
+CopyFinishBulkLoad(Relation rel, int64 mirrorSessionNum)
+{
+	MIRROREDLOCK_BUFMGR_DECLARE;
+
+	int64		currentSessionNum;
+
+	heap_sync(rel);
+
+	/* -------- MirroredLock ---------- */
+	MIRROREDLOCK_BUFMGR_LOCK;
+
+	FileRepPrimary_GetMirrorDataLossTrackingSessionNum(&currentSessionNum);
+
+	MIRROREDLOCK_BUFMGR_UNLOCK;
+	/* -------- MirroredLock ---------- */
+
+	if (currentSessionNum == mirrorSessionNum)
+		return;
+
+	elog(DEBUG1, "mirror changed state during COPY into \"%s\", WAL-logging its pages",
+		 RelationGetRelationName(rel));
+
+	CopyLogRelationPages(rel);
+	if (OidIsValid(rel->rd_rel->reltoastrelid))
+	{
+		Relation	toastrel;
+
+		toastrel = heap_open(rel->rd_rel->reltoastrelid, AccessShareLock);
+		CopyLogRelationPages(toastrel);
+		heap_close(toastrel, AccessShareLock);
+	}
+}
+
+static void
+CopyLogRelationPages(Relation rel)
+{
+	MIRROREDLOCK_BUFMGR_DECLARE;
+
+	BlockNumber nblocks;
+	BlockNumber blkno;
+
+	nblocks = RelationGetNumberOfBlocks(rel);
+	for (blkno = 0; blkno < nblocks; blkno++)
+	{
+		Buffer		buffer;
+
+		CHECK_FOR_INTERRUPTS();
+
+		/* -------- MirroredLock ---------- */
+		MIRROREDLOCK_BUFMGR_LOCK;
+
+		buffer = ReadBuffer(rel, blkno);
+		LockBuffer(buffer, BUFFER_LOCK_SHARE);
+
+		log_newpage_rel(rel, blkno, BufferGetPage(buffer));
+
+		UnlockReleaseBuffer(buffer);
+
+		MIRROREDLOCK_BUFMGR_UNLOCK;
+		/* -------- MirroredLock ---------- */
+	}
+}
+
 static void CopyInitPartitioningState(EState *estate)
 {
 	if (estate->es_result_partitions)
@@ -287,12 +287,19 @@ ExplainOneQuery(Query *query, ExplainStmt *stmt, const char *queryString,
 	else
 	{
 		PlannedStmt *plan;
+		instr_time	planstart;
+		instr_time	planduration;
+
+		INSTR_TIME_SET_CURRENT(planstart);
 
 		/* plan the query */
 		plan = planner(query, 0, params);
 
+		INSTR_TIME_SET_CURRENT(planduration);
+		INSTR_TIME_SUBTRACT(planduration, planstart);
+
 		/* run it (if needed) and produce output */
-		ExplainOnePlan(plan, params, stmt, queryString, tstate);
+		ExplainOnePlan(plan, params, stmt, queryString, tstate, &planduration);
 	}
 }
 
@@ -362,10 +369,14 @@ ExplainCodegen(PlanState *planstate, TupOutputState *tstate) {
  * This is exported because it's called back from prepare.c in the
  * EXPLAIN EXECUTE case, and because an index advisor plugin would need
  * to call it.
+ *
+ * 'planduration' is the time spent planning the query, or NULL if it is not
+ * known; it is shown with ANALYZE.
  */
 void
 ExplainOnePlan(PlannedStmt *plannedstmt, ParamListInfo params,
-			   ExplainStmt *stmt, const char *queryString, TupOutputState *tstate)
+			   ExplainStmt *stmt, const char *queryString, TupOutputState *tstate,
+			   const instr_time *planduration)
 {
 	QueryDesc  *queryDesc;
 	instr_time	starttime;
@@ -590,7 +601,7 @@ ExplainOnePlan(PlannedStmt *plannedstmt, ParamListInfo params,
 			}
 			else if ((childPlan->directDispatch).isDirectDispatch)
 			{
-				numSegments = 1;
+				numSegments = list_length((childPlan->directDispatch).contentIds);
 			}
 			appendStringInfo(&buf, " (slice%d; segments: %d)", sliceNum, numSegments);
 			appendStringInfo(&buf, "  (rows=%.0f width=%d)\n", ceil(childPlan->plan_rows / numSegments), childPlan->plan_width);
@@ -671,8 +682,11 @@ ExplainOnePlan(PlannedStmt *plannedstmt, ParamListInfo params,
 #endif
 
     /*
-     * Display final elapsed time.
+     * Display planning time and final elapsed time.
      */
+	if (stmt->analyze && planduration)
+		appendStringInfo(&buf, "Planning time: %.3f ms\n",
+						 1000.0 * INSTR_TIME_GET_DOUBLE(*planduration));
 	if (stmt->analyze)
 		appendStringInfo(&buf, "Total runtime: %.3f ms\n",
 						 1000.0 * totaltime);
@@ -844,7 +858,6 @@ appendGangAndDirectDispatchInfo(StringInfo str, PlanState *planstate, int sliceI
 
 			if (slice->directDispatch.isDirectDispatch)
 			{
-				Assert( list_length(slice->directDispatch.contentIds) == 1);
 				numSegments = list_length(slice->directDispatch.contentIds);
 			}
 			else
@@ -1131,23 +1144,27 @@ explain_outNode(StringInfo str,
 			pname = "Unique";
 			break;
 		case T_SetOp:
-			switch (((SetOp *) plan)->cmd)
 			{
-				case SETOPCMD_INTERSECT:
-					pname = "SetOp Intersect";
-					break;
-				case SETOPCMD_INTERSECT_ALL:
-					pname = "SetOp Intersect All";
-					break;
-				case SETOPCMD_EXCEPT:
-					pname = "SetOp Except";
-					break;
-				case SETOPCMD_EXCEPT_ALL:
-					pname = "SetOp Except All";
-					break;
-				default:
-					pname = "SetOp ???";
-					break;
+				bool		hashed = (((SetOp *) plan)->strategy == SETOP_HASHED);
+
+				switch (((SetOp *) plan)->cmd)
+				{
+					case SETOPCMD_INTERSECT:
+						pname = hashed ? "HashSetOp Intersect" : "SetOp Intersect";
+						break;
+					case SETOPCMD_INTERSECT_ALL:
+						pname = hashed ? "HashSetOp Intersect All" : "SetOp Intersect All";
+						break;
+					case SETOPCMD_EXCEPT:
+						pname = hashed ? "HashSetOp Except" : "SetOp Except";
+						break;
+					case SETOPCMD_EXCEPT_ALL:
+						pname = hashed ? "HashSetOp Except All" : "SetOp Except All";
+						break;
+					default:
+						pname = "SetOp ???";
+						break;
+				}
 			}
 			break;
 		case T_Limit:
@@ -1651,6 +1668,11 @@ explain_outNode(StringInfo str,
 						   ((Sort *) plan)->sortColIdx,
 						   SortKeystr,
 						   str, indent, es);
+			show_sort_keys(plan,
+						   ((Sort *) plan)->numPresortedCols,
+						   ((Sort *) plan)->sortColIdx,
+						   "Presorted Key",
+						   str, indent, es);
 		}
 			break;
 		case T_Result:
@@ -1679,6 +1701,18 @@ explain_outNode(StringInfo str,
 							"Merge Key",
 							str, indent, es);
 
+				if (pMotion->skewMode != MOTIONSKEW_NONE)
+				{
+					int			i;
+
+					for (i = 0; i < indent; i++)
+						appendStringInfoString(str, "  ");
+					appendStringInfo(str, "  Hot Keys: %d (%s)\n",
+									 pMotion->numSkewHashes,
+									 pMotion->skewMode == MOTIONSKEW_SPREAD
+									 ? "spread" : "broadcast");
+				}
+
                 /* Descending into a new slice. */
                 if (sliceTable)
                     es->currentSlice = (Slice *)list_nth(sliceTable->slices,
@@ -33,6 +33,7 @@
 #include "utils/memutils.h"
 #include "utils/snapmgr.h"
 
+#include "cdb/cdbendpoint.h"
 #include "cdb/cdbgang.h"
 #include "cdb/cdbvars.h"
 #include "postmaster/backoff.h"
@@ -95,6 +96,30 @@ PerformCursorOpen(PlannedStmt *stmt, ParamListInfo params,
 	
 	Assert(!(cstmt->options & CURSOR_OPT_SCROLL && cstmt->options & CURSOR_OPT_NO_SCROLL));
 
+	/*
+	 * A PARALLEL RETRIEVE cursor's rows are retrieved from the endpoints on
+	 * the segments, so its top slice must run there.
+	 */
+	if (cstmt->options & CURSOR_OPT_PARALLEL_RETRIEVE)
+	{
+		if (Gp_role != GP_ROLE_DISPATCH)
+			ereport(ERROR,
+					(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+					 errmsg("parallel retrieve cursors can only be declared on the master")));
+		if (cstmt->options & CURSOR_OPT_HOLD)
+			ereport(ERROR,
+					(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+					 errmsg("parallel retrieve cursors cannot be WITH HOLD")));
+		if (stmt->planTree->dispatch != DISPATCH_PARALLEL ||
+			stmt->planTree->flow == NULL ||
+			stmt->planTree->flow->flotype != FLOW_PARTITIONED)
+			ereport(ERROR,
+					(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+					 errmsg("the result of this query cannot be retrieved in parallel"),
+					 errdetail("Only queries whose result is produced on all segments, "
+							   "without ORDER BY or LIMIT at the top, can be used.")));
+	}
+
 	/*
 	 * Create a portal and copy the plan into its memory context.
 	 */
@@ -105,6 +130,9 @@ PerformCursorOpen(PlannedStmt *stmt, ParamListInfo params,
 	stmt = copyObject(stmt);
 	stmt->utilityStmt = NULL;	/* make it look like plain SELECT */
 
+	if (cstmt->options & CURSOR_OPT_PARALLEL_RETRIEVE)
+		stmt->parallelRetrieveToken = GenerateEndpointToken();
+
 	if (queryString)			/* copy the source text too for safety */
 		queryString = pstrdup(queryString);
 
@@ -164,6 +192,19 @@ PerformCursorOpen(PlannedStmt *stmt, ParamListInfo params,
 
 	Assert(portal->strategy == PORTAL_ONE_SELECT);
 
+	if (cstmt->options & CURSOR_OPT_PARALLEL_RETRIEVE)
+	{
+		QueryDesc  *queryDesc = PortalGetQueryDesc(portal);
+
+		RegisterParallelRetrieveCursor(portal);
+
+		/*
+		 * No rows come back to this process, so there is nothing to squelch
+		 * when the cursor is closed.
+		 */
+		queryDesc->estate->es_got_eos = true;
+	}
+
 	/*
 	 * We're done; the query won't actually be run until PerformPortalFetch is
 	 * called.
@@ -208,6 +249,13 @@ PerformPortalFetch(FetchStmt *stmt,
 		return;					/* keep compiler happy */
 	}
 
+	if (portal->cursorOptions & CURSOR_OPT_PARALLEL_RETRIEVE)
+		ereport(ERROR,
+				(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+				 errmsg("cannot FETCH from parallel retrieve cursor \"%s\"",
+						stmt->portalname),
+				 errhint("Retrieve its rows from the endpoints listed by gp_endpoints().")));
+
 	/* Adjust dest if needed.  MOVE wants destination DestNone */
 	if (stmt->ismove)
 		dest = None_Receiver;
@@ -285,6 +333,9 @@ PortalCleanup(Portal portal)
 	AssertArg(PortalIsValid(portal));
 	AssertArg(portal->cleanup == PortalCleanup);
 
+	if (portal->cursorOptions & CURSOR_OPT_PARALLEL_RETRIEVE)
+		UnregisterParallelRetrieveCursor(portal);
+
 	/*
 	 * Shut down executor, if still running.  We skip this during error abort,
 	 * since other mechanisms will take care of releasing executor resources,
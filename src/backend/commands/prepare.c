@@ -235,7 +235,10 @@ ExecuteQuery(ExecuteStmt *stmt, const char *queryString,
 	 * In GPDB, we use the current parameter values in the planning, because
 	 * that potentially gives a better plan. It also means that we have to
 	 * re-plan the query on every EXECUTE, but for long-running OLAP queries
-	 * that GPDB is typically used for, that seems like a good tradeoff.
+	 * that GPDB is typically used for, that seems like a good tradeoff. With
+	 * gp_enable_generic_plans, RevalidateCachedPlanWithParams may decide to
+	 * reuse the generic plan instead, for short queries where planning time
+	 * dominates.
 	 *
 	 * In GPDB the plan for CREATE TABLE / AS EXECUTE also depends on the
 	 * DISTRIBUTED BY clause of the target table. For example, if the table is
@@ -732,7 +735,7 @@ ExplainExecuteQuery(ExecuteStmt *execstmt, ExplainStmt *stmt,
 				pstmt->intoClause = execstmt->into;
 			}
 
-			ExplainOnePlan(pstmt, paramLI, stmt, queryString, tstate);
+			ExplainOnePlan(pstmt, paramLI, stmt, queryString, tstate, NULL);
 		}
 		else
 		{
@@ -284,6 +284,7 @@ CreateResourceGroup(CreateResourceGroupStmt *stmt)
 		/* Create os dependent part for this resource group */
 		ResGroupOps_CreateGroup(groupid);
 		ResGroupOps_SetCpuRateLimit(groupid, options.cpuRateLimit);
+		ResGroupOps_SetCpuSet(groupid, stmt->name);
 	}
 	else if (Gp_role == GP_ROLE_DISPATCH)
 		ereport(WARNING,
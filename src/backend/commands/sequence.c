@@ -37,6 +37,7 @@
 #include "utils/lsyscache.h"
 #include "utils/resowner.h"
 #include "utils/syscache.h"
+#include "utils/timestamp.h"
 
 #include "cdb/cdbdisp_query.h"
 #include "cdb/cdbdoublylinked.h"
@@ -57,6 +58,14 @@
  */
 #define SEQ_LOG_VALS	32
 
+/*
+ * A QE that uses up its leased range of sequence values within this many
+ * milliseconds of fetching it asks the sequence server for twice as many
+ * values next time, up to gp_sequence_lease_max.  A slower consumer falls
+ * back to halving the lease.
+ */
+#define SEQ_LEASE_GROW_MS	100
+
 /*
  * The "special area" of a sequence's buffer page looks like this.
  */
@@ -88,6 +97,8 @@ typedef struct SeqTableData
 	/* if last != cached, we have not used up all the cached values */
 	int64		increment;		/* copy of sequence's increment field */
 	/* note that increment is zero until we first do read_seq_tuple() */
+	int64		lease;			/* QE: values to ask the seqserver for next */
+	TimestampTz lease_time;		/* QE: when the current lease was fetched */
 } SeqTableData;
 
 typedef SeqTableData *SeqTable;
@@ -116,9 +127,11 @@ cdb_sequence_nextval(SeqTable elm,
                      int64     *plast,
                      int64     *pcached,
                      int64     *pincrement,
-                     bool      *seq_overflow);
+                     bool      *seq_overflow,
+                     int64      nvalues);
 static void
 cdb_sequence_nextval_proxy(Relation seqrel,
+                           int64    nvalues,
                            int64   *plast,
                            int64   *pcached,
                            int64   *pincrement,
@@ -839,18 +852,39 @@ nextval_internal(Oid relid)
 
 	/* Update the sequence object. */
 	if (Gp_role == GP_ROLE_EXECUTE)
+	{
+		TimestampTz now = GetCurrentTimestamp();
+
+		/*
+		 * Size the lease by how fast the previous one ran out, so that a
+		 * bulk INSERT makes a handful of seqserver round-trips rather than
+		 * one per row, while an occasional nextval() doesn't burn values.
+		 */
+		if (elm->lease < 1)
+			elm->lease = 1;
+		else if (elm->lease_time != 0 &&
+				 TimestampDifferenceExceeds(elm->lease_time, now, SEQ_LEASE_GROW_MS))
+			elm->lease = Max(elm->lease / 2, 1);
+		else if (elm->lease_time != 0)
+			elm->lease = Min(elm->lease * 2, (int64) gp_sequence_lease_max);
+		elm->lease = Min(elm->lease, (int64) gp_sequence_lease_max);
+		elm->lease_time = now;
+
 		cdb_sequence_nextval_proxy(seqrel,
+								   elm->lease,
 								   &elm->last,
 								   &elm->cached,
 								   &elm->increment,
 								   &is_overflow);
+	}
 	else
 		cdb_sequence_nextval(elm,
 							 seqrel,
 							 &elm->last,
 							 &elm->cached,
 							 &elm->increment,
-							 &is_overflow);
+							 &is_overflow,
+							 1);
 	last_used_seq = elm;
 
 	if (is_overflow)
@@ -877,7 +911,8 @@ cdb_sequence_nextval(SeqTable elm,
                      int64     *plast,
                      int64     *pcached,
                      int64     *pincrement,
-                     bool      *poverflow)
+                     bool      *poverflow,
+                     int64      nvalues)
 {
 	MIRROREDLOCK_BUFMGR_DECLARE;
 
@@ -910,7 +945,7 @@ cdb_sequence_nextval(SeqTable elm,
 	incby = seq->increment_by;
 	maxv = seq->max_value;
 	minv = seq->min_value;
-	fetch = cache = seq->cache_value;
+	fetch = cache = Max(seq->cache_value, nvalues);
 	log = seq->log_cnt;
 
 	if (!seq->is_called)
@@ -1416,6 +1451,8 @@ init_sequence(Oid relid, SeqTable *p_elm, Relation *p_rel)
 		elm->lxid = InvalidLocalTransactionId;
 		elm->last_valid = false;
 		elm->last = elm->cached = elm->increment = 0;
+		elm->lease = 0;
+		elm->lease_time = 0;
 		elm->next = seqtab;
 		seqtab = elm;
 	}
@@ -1941,6 +1978,7 @@ cdb_sequence_relation_term(Relation seqrel)
  */
 void
 cdb_sequence_nextval_proxy(Relation	seqrel,
+                           int64    nvalues,
                            int64   *plast,
                            int64   *pcached,
                            int64   *pincrement,
@@ -1950,6 +1988,7 @@ cdb_sequence_nextval_proxy(Relation	seqrel,
 	sendSequenceRequest(GetSeqServerFD(),
 						seqrel,
     					gp_session_id,
+						nvalues,
     					plast,
     					pcached,
     					pincrement,
@@ -1966,6 +2005,7 @@ cdb_sequence_nextval_server(Oid    tablespaceid,
                             Oid    dbid,
                             Oid    relid,
                             bool   istemp,
+                            int64  nvalues,
                             int64 *plast,
                             int64 *pcached,
                             int64 *pincrement,
@@ -2003,7 +2043,8 @@ cdb_sequence_nextval_server(Oid    tablespaceid,
     /* CDB TODO: Catch errors. */
 
     /* Update the sequence object. */
-    cdb_sequence_nextval(elm, seqrel, plast, pcached, pincrement, poverflow);
+    cdb_sequence_nextval(elm, seqrel, plast, pcached, pincrement, poverflow,
+						 nvalues);
 
     /* Cleanup. */
     cdb_sequence_relation_term(seqrel);
@@ -706,7 +706,8 @@ DefineRelation(CreateStmt *stmt, char relkind, char relstorage, bool dispatch)
 		CdbDispatchUtilityStatement((Node *) stmt,
 									DF_CANCEL_ON_ERROR |
 									DF_NEED_TWO_PHASE |
-									DF_WITH_SNAPSHOT,
+									DF_WITH_SNAPSHOT |
+									DF_PIPELINE,
 									GetAssignedOidsForDispatch(),
 									NULL);
 	}
@@ -1290,7 +1291,8 @@ ExecuteTruncate(TruncateStmt *stmt)
 		CdbDispatchUtilityStatement((Node *) stmt,
 									DF_CANCEL_ON_ERROR |
 									DF_WITH_SNAPSHOT |
-									DF_NEED_TWO_PHASE,
+									DF_NEED_TWO_PHASE |
+									DF_PIPELINE,
 									GetAssignedOidsForDispatch(),
 									NULL);
 
@@ -2844,7 +2846,8 @@ AlterTable(AlterTableStmt *stmt)
 		CdbDispatchUtilityStatement((Node *) stmt,
 									DF_CANCEL_ON_ERROR |
 									DF_WITH_SNAPSHOT |
-									DF_NEED_TWO_PHASE,
+									DF_NEED_TWO_PHASE |
+									DF_PIPELINE,
 									GetAssignedOidsForDispatch(),
 									NULL);
 	}
@@ -485,7 +485,8 @@ DefineView(ViewStmt *stmt, const char *queryString)
 		CdbDispatchUtilityStatement((Node *) dispatchStmt,
 									DF_CANCEL_ON_ERROR|
 									DF_WITH_SNAPSHOT|
-									DF_NEED_TWO_PHASE,
+									DF_NEED_TWO_PHASE|
+									DF_PIPELINE,
 									GetAssignedOidsForDispatch(),
 									NULL);
 	}
@@ -14,11 +14,255 @@
  */
 #include "postgres.h"
 
+#include "catalog/pg_am.h"
+#include "catalog/pg_type.h"
+#include "commands/defrem.h"
+#include "optimizer/clauses.h"
+#include "utils/guc.h"
+#include "utils/lsyscache.h"
 #include "utils/snapmgr.h"
 #include "executor/executor.h"
+#include "executor/execBatchQual.h"
 #include "nodes/execnodes.h"
 #include "cdb/cdbaocsam.h"
 
+static bool
+IsIntegerType(Oid typid)
+{
+	return typid == INT2OID || typid == INT4OID || typid == INT8OID;
+}
+
+/*
+ * Turn a qual of the form "column op constant" (or "constant op column")
+ * into a zone qual, if the zone maps can use it.
+ */
+static bool
+ExtractZoneQual(Expr *clause, TupleDesc tupdesc, AppendOnlyZoneQual *zoneQual)
+{
+	OpExpr	   *op;
+	Node	   *left;
+	Node	   *right;
+	Var		   *var;
+	Const	   *con;
+	Oid			opno;
+	Oid			typid;
+	Oid			opclass;
+	int			strategy;
+
+	if (!IsA(clause, OpExpr))
+		return false;
+	op = (OpExpr *) clause;
+	if (list_length(op->args) != 2)
+		return false;
+
+	left = (Node *) linitial(op->args);
+	right = (Node *) lsecond(op->args);
+	if (IsA(left, RelabelType))
+		left = (Node *) ((RelabelType *) left)->arg;
+	if (IsA(right, RelabelType))
+		right = (Node *) ((RelabelType *) right)->arg;
+
+	opno = op->opno;
+	if (IsA(left, Var) && IsA(right, Const))
+	{
+		var = (Var *) left;
+		con = (Const *) right;
+	}
+	else if (IsA(left, Const) && IsA(right, Var))
+	{
+		var = (Var *) right;
+		con = (Const *) left;
+		opno = get_commutator(opno);
+		if (!OidIsValid(opno))
+			return false;
+	}
+	else
+		return false;
+
+	if (var->varattno <= 0 || var->varattno > tupdesc->natts ||
+		var->varlevelsup != 0 || con->constisnull)
+		return false;
+
+	typid = tupdesc->attrs[var->varattno - 1]->atttypid;
+	if (!AppendOnlyBlockDirectory_ZoneTypeSupported(typid))
+		return false;
+	if (con->consttype != typid &&
+		!(IsIntegerType(typid) && IsIntegerType(con->consttype)))
+		return false;
+
+	/* The operator must be one of the type's btree comparisons. */
+	opclass = GetDefaultOpClass(typid, BTREE_AM_OID);
+	if (!OidIsValid(opclass))
+		return false;
+	strategy = get_op_opfamily_strategy(opno, get_opclass_family(opclass));
+	if (strategy == 0)
+		return false;
+
+	zoneQual->attno = var->varattno - 1;
+	zoneQual->strategy = (StrategyNumber) strategy;
+	zoneQual->value = AppendOnlyBlockDirectory_ZoneValue(con->consttype,
+														 con->constvalue);
+	return true;
+}
+
+/*
+ * Hand the quals of the scan that the block directory zone maps can check
+ * to the scan.
+ */
+static void
+SetAOCSZoneQuals(ScanState *scanState, AOCSScanDesc scandesc)
+{
+	List	   *qual = scanState->ps.plan->qual;
+	TupleDesc	tupdesc = RelationGetDescr(scanState->ss_currentRelation);
+	AppendOnlyZoneQual *zoneQuals;
+	int			numZoneQuals = 0;
+	ListCell   *lc;
+
+	if (!gp_appendonly_zone_maps || qual == NIL ||
+		!IsA(scanState, TableScanState) ||
+		!OidIsValid(scanState->ss_currentRelation->rd_appendonly->blkdirrelid))
+		return;
+
+	zoneQuals = palloc(list_length(qual) * sizeof(AppendOnlyZoneQual));
+	foreach(lc, qual)
+	{
+		if (ExtractZoneQual((Expr *) lfirst(lc), tupdesc,
+							&zoneQuals[numZoneQuals]))
+			numZoneQuals++;
+	}
+
+	aocs_set_zone_quals(scandesc, zoneQuals, numZoneQuals);
+	pfree(zoneQuals);
+}
+
+/*
+ * If the quals can be evaluated ahead of ExecScan, have the scan read the
+ * columns only the targetlist needs for the rows that pass them.  If they
+ * depend on a single column, they can also be evaluated once per distinct
+ * value of a dictionary encoded block of it.
+ */
+static void
+SetAOCSLazyColumns(ScanState *scanState, AOCSScanDesc scandesc)
+{
+	AOCSScanOpaqueData *opaque = ((AOCSScanState *) scanState)->opaque;
+	List	   *qual = scanState->ps.plan->qual;
+	bool	   *qualCols;
+	bool	   *lazy;
+	bool		anyLazy = false;
+	int			nqualCols = 0;
+	int			qualAttno = -1;
+	int			i;
+
+	/*
+	 * The rows that pass get the quals evaluated again by ExecScan, so they
+	 * must not have side effects, and shouldn't be expensive.
+	 */
+	if (!gp_appendonly_late_materialization || qual == NIL ||
+		contain_volatile_functions((Node *) qual) ||
+		contain_subplans((Node *) qual))
+		return;
+
+	qualCols = palloc0(sizeof(bool) * opaque->ncol);
+	lazy = palloc0(sizeof(bool) * opaque->ncol);
+	GetNeededColumnsForScan((Node *) qual, qualCols, opaque->ncol);
+	for (i = 0; i < opaque->ncol; i++)
+	{
+		if (opaque->proj[i] && !qualCols[i])
+		{
+			lazy[i] = true;
+			anyLazy = true;
+		}
+		if (qualCols[i])
+		{
+			nqualCols++;
+			qualAttno = i;
+		}
+	}
+
+	if (anyLazy)
+		aocs_set_lazy_columns(scandesc, lazy);
+
+	if (nqualCols == 1 &&
+		scanState->ss_currentRelation->rd_att->attrs[qualAttno]->attlen == -1)
+	{
+		opaque->qualAttno = qualAttno;
+		opaque->dictQualResults = palloc(DATUMSTREAM_MAX_DICTIONARY_COUNT * sizeof(int8));
+	}
+
+	pfree(qualCols);
+	pfree(lazy);
+}
+
+/*
+ * Compile the leading quals of the scan that can be evaluated on a whole
+ * batch at a time.  When that covers all of them, ExecScan needn't check
+ * the rows that pass again.
+ */
+static void
+SetAOCSBatchQual(ScanState *scanState)
+{
+	AOCSScanOpaqueData *opaque = ((AOCSScanState *) scanState)->opaque;
+	List	   *qual = scanState->ps.plan->qual;
+
+	if (!gp_appendonly_vectorized_quals || qual == NIL)
+		return;
+
+	opaque->batchQual = ExecInitBatchQual(qual,
+										  RelationGetDescr(scanState->ss_currentRelation),
+										  AOCS_BATCH_SIZE,
+										  &opaque->batchQualComplete);
+	if (opaque->batchQual != NULL && opaque->batchQualComplete)
+		scanState->ss_qualsChecked = true;
+}
+
+/*
+ * Evaluate the quals on the rows of a batch whose lazy columns haven't been
+ * read yet, and keep only the rows that pass.
+ */
+static void
+FilterAOCSBatch(AOCSScanState *node)
+{
+	AOCSScanOpaqueData *opaque = node->opaque;
+	AOCSBatch	batch = opaque->batch;
+	ExprContext *econtext = node->ss.ps.ps_ExprContext;
+	TupleTableSlot *slot = node->ss.ss_ScanTupleSlot;
+	int32	   *codes = NULL;
+	int8	   *results = opaque->dictQualResults;
+	int			n = 0;
+	int			k;
+
+	if (opaque->qualAttno >= 0 && batch->dictCount[opaque->qualAttno] > 0)
+	{
+		codes = batch->codes[opaque->qualAttno];
+		memset(results, 0, batch->dictCount[opaque->qualAttno] * sizeof(int8));
+	}
+
+	econtext->ecxt_scantuple = slot;
+	for (k = 0; k < batch->nselected; k++)
+	{
+		int			row = batch->selected[k];
+		int32		code = (codes != NULL ? codes[row] : -1);
+		bool		pass;
+
+		if (code >= 0 && results[code] != 0)
+			pass = (results[code] == 1);
+		else
+		{
+			ResetExprContext(econtext);
+			aocs_batch_store_row(opaque->scandesc, batch, row, false, slot);
+			pass = ExecQual(node->ss.ps.qual, econtext, false);
+			if (code >= 0)
+				results[code] = (pass ? 1 : 2);
+		}
+
+		if (pass)
+			batch->selected[n++] = row;
+	}
+	ResetExprContext(econtext);
+
+	batch->nselected = n;
+}
+
 static void
 InitAOCSScanOpaque(ScanState *scanState)
 {
@@ -32,6 +276,11 @@ InitAOCSScanOpaque(ScanState *scanState)
 	Assert(currentRelation != NULL);
 
 	opaque->ncol = currentRelation->rd_att->natts;
+	opaque->batch = NULL;
+	opaque->qualAttno = -1;
+	opaque->dictQualResults = NULL;
+	opaque->batchQual = NULL;
+	opaque->batchQualComplete = false;
 	opaque->proj = palloc0(sizeof(bool) * opaque->ncol);
 	GetNeededColumnsForScan((Node *)scanState->ps.plan->targetlist, opaque->proj, opaque->ncol);
 	GetNeededColumnsForScan((Node *)scanState->ps.plan->qual, opaque->proj, opaque->ncol);
@@ -64,6 +313,10 @@ FreeAOCSScanOpaque(ScanState *scanState)
 	AOCSScanOpaqueData *opaque = (AOCSScanOpaqueData *)state->opaque;
 	Assert(opaque->proj != NULL);
 	pfree(opaque->proj);
+	if (opaque->dictQualResults != NULL)
+		pfree(opaque->dictQualResults);
+	if (opaque->batchQual != NULL)
+		ExecEndBatchQual(opaque->batchQual);
 	pfree(state->opaque);
 	state->opaque = NULL;
 }
@@ -75,10 +328,46 @@ AOCSScanNext(ScanState *scanState)
 		   IsA(scanState, DynamicTableScanState));
 	AOCSScanState *node = (AOCSScanState *)scanState;
 	Assert(node->opaque != NULL &&
-		   node->opaque->scandesc != NULL);
+		   node->opaque->scandesc != NULL &&
+		   node->opaque->batch != NULL);
+
+	AOCSBatch batch = node->opaque->batch;
+	TupleTableSlot *slot = node->ss.ss_ScanTupleSlot;
 
-	aocs_getnext(node->opaque->scandesc, node->ss.ps.state->es_direction, node->ss.ss_ScanTupleSlot);
-	return node->ss.ss_ScanTupleSlot;
+	/*
+	 * Rows are read from the column files a batch at a time, which keeps
+	 * each column's decoding in a tight loop, and then handed out one by
+	 * one.  With late materialization, the quals are evaluated on the whole
+	 * batch first, and the remaining columns are only read for the rows
+	 * that pass.  On a dictionary encoded column they are evaluated once
+	 * per distinct value.  The quals the batch evaluator handles are
+	 * evaluated first, a column at a time.
+	 */
+	while (batch->nextRow >= batch->nselected)
+	{
+		if (aocs_getnext_batch(node->opaque->scandesc,
+							   node->ss.ps.state->es_direction, batch) == 0)
+		{
+			ExecClearTuple(slot);
+			return slot;
+		}
+
+		if (node->opaque->batchQual != NULL)
+			batch->nselected = ExecBatchQual(node->opaque->batchQual,
+											 batch->values, batch->isnull,
+											 batch->selected,
+											 batch->nselected);
+
+		if (!node->opaque->batchQualComplete &&
+			(batch->lazy ||
+			 (node->opaque->qualAttno >= 0 &&
+			  batch->dictCount[node->opaque->qualAttno] > 0)))
+			FilterAOCSBatch(node);
+	}
+
+	aocs_batch_store_row(node->opaque->scandesc, batch,
+						 batch->selected[batch->nextRow++], true, slot);
+	return slot;
 }
 
 void
@@ -111,6 +400,16 @@ BeginScanAOCSRelation(ScanState *scanState)
 					   NULL /* relationTupleDesc */,
 					   node->opaque->proj);
 
+	SetAOCSZoneQuals(scanState, node->opaque->scandesc);
+	SetAOCSLazyColumns(scanState, node->opaque->scandesc);
+	SetAOCSBatchQual(scanState);
+
+	node->opaque->batch = aocs_create_batch(node->opaque->scandesc,
+											AOCS_BATCH_SIZE);
+	if (IsA(scanState, TableScanState))
+		node->opaque->batch->getBatchGenInfo =
+			((TableScanState *) scanState)->DatumStreamBlockReadGetBatch_gen_info;
+
 	node->ss.scan_state = SCAN_SCAN;
 }
  
@@ -125,9 +424,11 @@ EndScanAOCSRelation(ScanState *scanState)
 	Assert(node->opaque != NULL &&
 		   node->opaque->scandesc != NULL);
 
+	aocs_free_batch(node->opaque->scandesc, node->opaque->batch);
 	aocs_endscan(node->opaque->scandesc);
         
 	FreeAOCSScanOpaque(scanState);
+	node->ss.ss_qualsChecked = false;
 	
 	node->ss.scan_state = SCAN_INIT;
 }
@@ -142,4 +443,9 @@ ReScanAOCSRelation(ScanState *scanState)
 		   node->opaque->scandesc != NULL);
 
 	aocs_rescan(node->opaque->scandesc); 
+
+	/* Forget the rows read before the rescan. */
+	node->opaque->batch->nrows = 0;
+	node->opaque->batch->nselected = 0;
+	node->opaque->batch->nextRow = 0;
 }
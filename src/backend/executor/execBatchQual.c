@@ -0,0 +1,804 @@
+/*-------------------------------------------------------------------------
+ *
+ * execBatchQual.c
+ *	  Evaluation of scan quals over batches of rows stored column by column
+ *
+ * ExecQual() evaluates the quals of a scan one row at a time, calling the
+ * operator function of each comparison and each arithmetic step through the
+ * fmgr.  When the rows come in batches, with the values of each column in
+ * an array as the column-oriented scan returns them, the common quals --
+ * comparisons and arithmetic on integers, floats and dates, and NULL tests
+ * -- can instead be evaluated a column at a time: each expression is
+ * computed into a vector with one entry per selected row, in a tight loop
+ * specialized on its operator, and each qual narrows the selection vector
+ * of the rows that pass.
+ *
+ * The quals are compiled in order, up to the first one that can't be
+ * handled this way.  The rows that fail a qual aren't seen by the quals
+ * after it, as with ExecQual(), so a qual isn't evaluated on a row that
+ * an earlier one rejects.  An error, such as an integer overflow, is
+ * raised for the whole batch, so when several rows would raise one, which
+ * error is reported may differ from ExecQual().
+ *
+ * The kernels compute the same results as the operator functions, down to
+ * the NaN ordering of the float comparisons and the overflow checks of
+ * the arithmetic.
+ *
+ * Portions Copyright (c) 2012-Present Pivotal Software, Inc.
+ *
+ *
+ * IDENTIFICATION
+ *	    src/backend/executor/execBatchQual.c
+ *
+ *-------------------------------------------------------------------------
+ */
+#include "postgres.h"
+
+#include <limits.h>
+#include <math.h>
+
+#include "catalog/pg_type.h"
+#include "executor/execBatchQual.h"
+#include "nodes/primnodes.h"
+#include "utils/fmgroids.h"
+#include "utils/lsyscache.h"
+#include "utils/memutils.h"
+
+#define SAMESIGN(a,b)	(((a) < 0) == ((b) < 0))
+
+#define BATCH_IS_FLOAT(typid)	((typid) == FLOAT4OID || (typid) == FLOAT8OID)
+
+typedef enum BatchOp
+{
+	BOP_EQ,
+	BOP_NE,
+	BOP_LT,
+	BOP_LE,
+	BOP_GT,
+	BOP_GE,
+	BOP_ADD,
+	BOP_SUB,
+	BOP_MUL
+} BatchOp;
+
+/*
+ * An operator function with a kernel.  restype is BOOLOID for the
+ * comparisons.
+ */
+typedef struct BatchFunc
+{
+	Oid			funcid;
+	Oid			lefttype;
+	Oid			righttype;
+	Oid			restype;
+	BatchOp		op;
+} BatchFunc;
+
+#define BATCH_CMP_FUNCS(prefix, ltype, rtype) \
+	{F_##prefix##EQ, ltype, rtype, BOOLOID, BOP_EQ}, \
+	{F_##prefix##NE, ltype, rtype, BOOLOID, BOP_NE}, \
+	{F_##prefix##LT, ltype, rtype, BOOLOID, BOP_LT}, \
+	{F_##prefix##LE, ltype, rtype, BOOLOID, BOP_LE}, \
+	{F_##prefix##GT, ltype, rtype, BOOLOID, BOP_GT}, \
+	{F_##prefix##GE, ltype, rtype, BOOLOID, BOP_GE}
+
+#define BATCH_ARITH_FUNCS(prefix, ltype, rtype, restype) \
+	{F_##prefix##PL, ltype, rtype, restype, BOP_ADD}, \
+	{F_##prefix##MI, ltype, rtype, restype, BOP_SUB}, \
+	{F_##prefix##MUL, ltype, rtype, restype, BOP_MUL}
+
+static const BatchFunc batch_funcs[] =
+{
+	BATCH_CMP_FUNCS(INT2, INT2OID, INT2OID),
+	BATCH_CMP_FUNCS(INT4, INT4OID, INT4OID),
+	BATCH_CMP_FUNCS(INT8, INT8OID, INT8OID),
+	BATCH_CMP_FUNCS(INT24, INT2OID, INT4OID),
+	BATCH_CMP_FUNCS(INT42, INT4OID, INT2OID),
+	BATCH_CMP_FUNCS(INT28, INT2OID, INT8OID),
+	BATCH_CMP_FUNCS(INT82, INT8OID, INT2OID),
+	BATCH_CMP_FUNCS(INT48, INT4OID, INT8OID),
+	BATCH_CMP_FUNCS(INT84, INT8OID, INT4OID),
+	BATCH_CMP_FUNCS(DATE_, DATEOID, DATEOID),
+	BATCH_CMP_FUNCS(FLOAT4, FLOAT4OID, FLOAT4OID),
+	BATCH_CMP_FUNCS(FLOAT8, FLOAT8OID, FLOAT8OID),
+	BATCH_CMP_FUNCS(FLOAT48, FLOAT4OID, FLOAT8OID),
+	BATCH_CMP_FUNCS(FLOAT84, FLOAT8OID, FLOAT4OID),
+
+	BATCH_ARITH_FUNCS(INT2, INT2OID, INT2OID, INT2OID),
+	BATCH_ARITH_FUNCS(INT4, INT4OID, INT4OID, INT4OID),
+	BATCH_ARITH_FUNCS(INT8, INT8OID, INT8OID, INT8OID),
+	BATCH_ARITH_FUNCS(INT24, INT2OID, INT4OID, INT4OID),
+	BATCH_ARITH_FUNCS(INT42, INT4OID, INT2OID, INT4OID),
+	BATCH_ARITH_FUNCS(INT48, INT4OID, INT8OID, INT8OID),
+	BATCH_ARITH_FUNCS(INT84, INT8OID, INT4OID, INT8OID),
+	BATCH_ARITH_FUNCS(FLOAT4, FLOAT4OID, FLOAT4OID, FLOAT4OID),
+	BATCH_ARITH_FUNCS(FLOAT8, FLOAT8OID, FLOAT8OID, FLOAT8OID),
+	BATCH_ARITH_FUNCS(FLOAT48, FLOAT4OID, FLOAT8OID, FLOAT8OID),
+	BATCH_ARITH_FUNCS(FLOAT84, FLOAT8OID, FLOAT4OID, FLOAT8OID)
+};
+
+typedef enum BatchExprKind
+{
+	BEXPR_VAR,
+	BEXPR_CONST,
+	BEXPR_OP
+} BatchExprKind;
+
+/*
+ * A numeric expression.  Its value for the k'th selected row is ivals[k]
+ * (integers and dates) or fvals[k] (floats), and nulls[k].  A constant
+ * fills its vectors once, at compile time.
+ */
+typedef struct BatchExpr
+{
+	BatchExprKind kind;
+	Oid			typid;
+	int			attno;			/* BEXPR_VAR */
+	BatchOp		op;				/* BEXPR_OP */
+	struct BatchExpr *left;
+	struct BatchExpr *right;
+
+	int64	   *ivals;
+	double	   *fvals;
+	bool	   *nulls;
+} BatchExpr;
+
+typedef enum BatchClauseKind
+{
+	BCLAUSE_COMPARE,
+	BCLAUSE_NULLTEST
+} BatchClauseKind;
+
+typedef struct BatchClause
+{
+	BatchClauseKind kind;
+
+	/* BCLAUSE_COMPARE */
+	BatchOp		op;
+	BatchExpr  *left;
+	BatchExpr  *right;
+
+	/* BCLAUSE_NULLTEST */
+	int			attno;
+	NullTestType nulltesttype;
+} BatchClause;
+
+struct BatchQual
+{
+	MemoryContext context;
+	int			maxRows;
+	int			nclauses;
+	BatchClause *clauses;
+};
+
+static const BatchFunc *
+batch_lookup_func(Oid funcid)
+{
+	int			i;
+
+	for (i = 0; i < lengthof(batch_funcs); i++)
+	{
+		if (batch_funcs[i].funcid == funcid)
+			return &batch_funcs[i];
+	}
+	return NULL;
+}
+
+static bool
+batch_type_supported(Oid typid)
+{
+	switch (typid)
+	{
+		case INT2OID:
+		case INT4OID:
+		case INT8OID:
+		case DATEOID:
+		case FLOAT4OID:
+		case FLOAT8OID:
+			return true;
+		default:
+			return false;
+	}
+}
+
+static BatchExpr *
+batch_new_expr(BatchQual *bq, BatchExprKind kind, Oid typid)
+{
+	BatchExpr  *e = palloc0(sizeof(BatchExpr));
+
+	e->kind = kind;
+	e->typid = typid;
+	if (BATCH_IS_FLOAT(typid))
+		e->fvals = palloc(bq->maxRows * sizeof(double));
+	else
+		e->ivals = palloc(bq->maxRows * sizeof(int64));
+	e->nulls = palloc(bq->maxRows * sizeof(bool));
+	return e;
+}
+
+/*
+ * Look up the kernel of an operator expression, if it has one.
+ */
+static const BatchFunc *
+batch_lookup_opexpr(OpExpr *op)
+{
+	Oid			funcid = op->opfuncid;
+
+	if (list_length(op->args) != 2)
+		return NULL;
+	if (!OidIsValid(funcid))
+		funcid = get_opcode(op->opno);
+	return batch_lookup_func(funcid);
+}
+
+static BatchExpr *
+batch_compile_expr(BatchQual *bq, Node *node, TupleDesc tupdesc)
+{
+	BatchExpr  *e;
+
+	if (IsA(node, RelabelType))
+		node = (Node *) ((RelabelType *) node)->arg;
+
+	if (IsA(node, Var))
+	{
+		Var		   *var = (Var *) node;
+
+		if (var->varlevelsup != 0 ||
+			var->varattno <= 0 || var->varattno > tupdesc->natts ||
+			!batch_type_supported(var->vartype) ||
+			tupdesc->attrs[var->varattno - 1]->atttypid != var->vartype)
+			return NULL;
+
+		e = batch_new_expr(bq, BEXPR_VAR, var->vartype);
+		e->attno = var->varattno - 1;
+	}
+	else if (IsA(node, Const))
+	{
+		Const	   *con = (Const *) node;
+		int			k;
+
+		if (!batch_type_supported(con->consttype))
+			return NULL;
+
+		e = batch_new_expr(bq, BEXPR_CONST, con->consttype);
+		memset(e->nulls, con->constisnull, bq->maxRows * sizeof(bool));
+		for (k = 0; k < bq->maxRows; k++)
+		{
+			if (con->constisnull)
+			{
+				if (e->fvals)
+					e->fvals[k] = 0.0;
+				else
+					e->ivals[k] = 0;
+				continue;
+			}
+
+			switch (con->consttype)
+			{
+				case INT2OID:
+					e->ivals[k] = DatumGetInt16(con->constvalue);
+					break;
+				case INT4OID:
+				case DATEOID:
+					e->ivals[k] = DatumGetInt32(con->constvalue);
+					break;
+				case INT8OID:
+					e->ivals[k] = DatumGetInt64(con->constvalue);
+					break;
+				case FLOAT4OID:
+					e->fvals[k] = DatumGetFloat4(con->constvalue);
+					break;
+				case FLOAT8OID:
+					e->fvals[k] = DatumGetFloat8(con->constvalue);
+					break;
+			}
+		}
+	}
+	else if (IsA(node, OpExpr))
+	{
+		OpExpr	   *op = (OpExpr *) node;
+		const BatchFunc *func = batch_lookup_opexpr(op);
+		BatchExpr  *left;
+		BatchExpr  *right;
+
+		if (func == NULL || func->restype == BOOLOID)
+			return NULL;
+
+		left = batch_compile_expr(bq, linitial(op->args), tupdesc);
+		right = batch_compile_expr(bq, lsecond(op->args), tupdesc);
+		if (left == NULL || right == NULL ||
+			left->typid != func->lefttype || right->typid != func->righttype)
+			return NULL;
+
+		e = batch_new_expr(bq, BEXPR_OP, func->restype);
+		e->op = func->op;
+		e->left = left;
+		e->right = right;
+	}
+	else
+		return NULL;
+
+	return e;
+}
+
+static bool
+batch_compile_clause(BatchQual *bq, Node *node, TupleDesc tupdesc,
+					 BatchClause *clause)
+{
+	if (IsA(node, OpExpr))
+	{
+		OpExpr	   *op = (OpExpr *) node;
+		const BatchFunc *func = batch_lookup_opexpr(op);
+
+		if (func == NULL || func->restype != BOOLOID)
+			return false;
+
+		clause->kind = BCLAUSE_COMPARE;
+		clause->op = func->op;
+		clause->left = batch_compile_expr(bq, linitial(op->args), tupdesc);
+		clause->right = batch_compile_expr(bq, lsecond(op->args), tupdesc);
+		return (clause->left != NULL && clause->right != NULL &&
+				clause->left->typid == func->lefttype &&
+				clause->right->typid == func->righttype);
+	}
+	else if (IsA(node, NullTest))
+	{
+		NullTest   *ntest = (NullTest *) node;
+		Node	   *arg = (Node *) ntest->arg;
+		Var		   *var;
+
+		if (IsA(arg, RelabelType))
+			arg = (Node *) ((RelabelType *) arg)->arg;
+		if (!IsA(arg, Var))
+			return false;
+		var = (Var *) arg;
+
+		/* a row is NULL when all its fields are, which isn't a NULL datum */
+		if (var->varlevelsup != 0 ||
+			var->varattno <= 0 || var->varattno > tupdesc->natts ||
+			type_is_rowtype(var->vartype))
+			return false;
+
+		clause->kind = BCLAUSE_NULLTEST;
+		clause->attno = var->varattno - 1;
+		clause->nulltesttype = ntest->nulltesttype;
+		return true;
+	}
+
+	return false;
+}
+
+/*
+ * ExecInitBatchQual
+ *
+ * Compile the leading quals of the list (an implicit AND of plan quals over
+ * the columns of tupdesc) that the kernels can evaluate, for batches of up
+ * to maxRows rows.  *complete tells whether that is all of them.  Returns
+ * NULL if none can be.
+ */
+BatchQual *
+ExecInitBatchQual(List *qual, TupleDesc tupdesc, int maxRows, bool *complete)
+{
+	MemoryContext context;
+	MemoryContext oldcontext;
+	BatchQual  *bq;
+	ListCell   *lc;
+
+	context = AllocSetContextCreate(CurrentMemoryContext,
+									"BatchQual",
+									ALLOCSET_DEFAULT_MINSIZE,
+									ALLOCSET_DEFAULT_INITSIZE,
+									ALLOCSET_DEFAULT_MAXSIZE);
+	oldcontext = MemoryContextSwitchTo(context);
+
+	bq = palloc0(sizeof(BatchQual));
+	bq->context = context;
+	bq->maxRows = maxRows;
+	bq->clauses = palloc0(Max(list_length(qual), 1) * sizeof(BatchClause));
+	foreach(lc, qual)
+	{
+		if (!batch_compile_clause(bq, lfirst(lc), tupdesc,
+								  &bq->clauses[bq->nclauses]))
+			break;
+		bq->nclauses++;
+	}
+
+	MemoryContextSwitchTo(oldcontext);
+
+	*complete = (bq->nclauses == list_length(qual));
+	if (bq->nclauses == 0)
+	{
+		MemoryContextDelete(context);
+		return NULL;
+	}
+	return bq;
+}
+
+void
+ExecEndBatchQual(BatchQual *bq)
+{
+	MemoryContextDelete(bq->context);
+}
+
+/*
+ * Gather the selected rows of a column into the vectors of a Var.  The
+ * datum of a NULL may be garbage, so zero is loaded for it instead.
+ */
+static void
+batch_load_column(BatchExpr *e, const Datum *col, const bool *colnull,
+				  const int *selected, int n)
+{
+	int64	   *ivals = e->ivals;
+	double	   *fvals = e->fvals;
+	bool	   *nulls = e->nulls;
+	int			k;
+
+	for (k = 0; k < n; k++)
+		nulls[k] = colnull[selected[k]];
+
+	switch (e->typid)
+	{
+		case INT2OID:
+			for (k = 0; k < n; k++)
+				ivals[k] = nulls[k] ? 0 : DatumGetInt16(col[selected[k]]);
+			break;
+		case INT4OID:
+		case DATEOID:
+			for (k = 0; k < n; k++)
+				ivals[k] = nulls[k] ? 0 : DatumGetInt32(col[selected[k]]);
+			break;
+		case INT8OID:
+			for (k = 0; k < n; k++)
+				ivals[k] = nulls[k] ? 0 : DatumGetInt64(col[selected[k]]);
+			break;
+		case FLOAT4OID:
+			for (k = 0; k < n; k++)
+				fvals[k] = nulls[k] ? 0.0 : DatumGetFloat4(col[selected[k]]);
+			break;
+		case FLOAT8OID:
+			for (k = 0; k < n; k++)
+				fvals[k] = nulls[k] ? 0.0 : DatumGetFloat8(col[selected[k]]);
+			break;
+		default:
+			elog(ERROR, "unexpected type %u in batch qual", e->typid);
+	}
+}
+
+/*
+ * Integer arithmetic, with the overflow checks of int2pl() and friends.
+ * The narrower types are computed in int64, which can't overflow, and
+ * range checked.
+ */
+static void
+batch_int_arith(BatchExpr *e, int n)
+{
+	const int64 *l = e->left->ivals;
+	const int64 *r = e->right->ivals;
+	const bool *nulls = e->nulls;
+	int64	   *res = e->ivals;
+	bool		overflow = false;
+	int			k;
+
+	switch (e->op)
+	{
+		case BOP_ADD:
+			for (k = 0; k < n; k++)
+				res[k] = l[k] + r[k];
+			break;
+		case BOP_SUB:
+			for (k = 0; k < n; k++)
+				res[k] = l[k] - r[k];
+			break;
+		case BOP_MUL:
+			for (k = 0; k < n; k++)
+				res[k] = l[k] * r[k];
+			break;
+		default:
+			elog(ERROR, "unexpected batch arithmetic operator %d", e->op);
+	}
+
+	switch (e->typid)
+	{
+		case INT2OID:
+			for (k = 0; k < n; k++)
+				overflow |= !nulls[k] & (res[k] < SHRT_MIN || res[k] > SHRT_MAX);
+			if (overflow)
+				ereport(ERROR,
+						(errcode(ERRCODE_NUMERIC_VALUE_OUT_OF_RANGE),
+						 errmsg("smallint out of range")));
+			break;
+
+		case INT4OID:
+			for (k = 0; k < n; k++)
+				overflow |= !nulls[k] & (res[k] < INT_MIN || res[k] > INT_MAX);
+			if (overflow)
+				ereport(ERROR,
+						(errcode(ERRCODE_NUMERIC_VALUE_OUT_OF_RANGE),
+						 errmsg("integer out of range")));
+			break;
+
+		case INT8OID:
+			if (e->op == BOP_ADD)
+			{
+				for (k = 0; k < n; k++)
+					overflow |= !nulls[k] & SAMESIGN(l[k], r[k]) &
+						!SAMESIGN(res[k], l[k]);
+			}
+			else if (e->op == BOP_SUB)
+			{
+				for (k = 0; k < n; k++)
+					overflow |= !nulls[k] & !SAMESIGN(l[k], r[k]) &
+						!SAMESIGN(res[k], l[k]);
+			}
+			else
+			{
+				/* as in int8mul(), only check when an input exceeds int32 */
+				for (k = 0; k < n; k++)
+				{
+					if (!nulls[k] &&
+						(l[k] != (int64) ((int32) l[k]) ||
+						 r[k] != (int64) ((int32) r[k])) &&
+						r[k] != 0 &&
+						((r[k] == -1 && l[k] < 0 && res[k] < 0) ||
+						 res[k] / r[k] != l[k]))
+						overflow = true;
+				}
+			}
+			if (overflow)
+				ereport(ERROR,
+						(errcode(ERRCODE_NUMERIC_VALUE_OUT_OF_RANGE),
+						 errmsg("bigint out of range")));
+			break;
+
+		default:
+			elog(ERROR, "unexpected type %u in batch qual", e->typid);
+	}
+}
+
+/*
+ * Float arithmetic, with the checks of CHECKFLOATVAL.  float4 results are
+ * computed in double and rounded, which gives the same result for these
+ * operators.
+ */
+static void
+batch_float_arith(BatchExpr *e, int n)
+{
+	const double *l = e->left->fvals;
+	const double *r = e->right->fvals;
+	const bool *nulls = e->nulls;
+	double	   *res = e->fvals;
+	bool		overflow = false;
+	bool		underflow = false;
+	int			k;
+
+	switch (e->op)
+	{
+		case BOP_ADD:
+			for (k = 0; k < n; k++)
+				res[k] = l[k] + r[k];
+			break;
+		case BOP_SUB:
+			for (k = 0; k < n; k++)
+				res[k] = l[k] - r[k];
+			break;
+		case BOP_MUL:
+			for (k = 0; k < n; k++)
+				res[k] = l[k] * r[k];
+			break;
+		default:
+			elog(ERROR, "unexpected batch arithmetic operator %d", e->op);
+	}
+
+	if (e->typid == FLOAT4OID)
+	{
+		for (k = 0; k < n; k++)
+			res[k] = (float4) res[k];
+	}
+
+	for (k = 0; k < n; k++)
+	{
+		if (!nulls[k] && isinf(res[k]) && !isinf(l[k]) && !isinf(r[k]))
+			overflow = true;
+	}
+	if (e->op == BOP_MUL)
+	{
+		for (k = 0; k < n; k++)
+		{
+			if (!nulls[k] && res[k] == 0.0 && l[k] != 0.0 && r[k] != 0.0)
+				underflow = true;
+		}
+	}
+
+	if (overflow)
+		ereport(ERROR,
+				(errcode(ERRCODE_NUMERIC_VALUE_OUT_OF_RANGE),
+				 errmsg("value out of range: overflow")));
+	if (underflow)
+		ereport(ERROR,
+				(errcode(ERRCODE_NUMERIC_VALUE_OUT_OF_RANGE),
+				 errmsg("value out of range: underflow")));
+}
+
+static void
+batch_eval_expr(BatchExpr *e, Datum **values, bool **isnull,
+				const int *selected, int n)
+{
+	int			k;
+
+	switch (e->kind)
+	{
+		case BEXPR_CONST:
+			break;
+
+		case BEXPR_VAR:
+			batch_load_column(e, values[e->attno], isnull[e->attno],
+							  selected, n);
+			break;
+
+		case BEXPR_OP:
+			batch_eval_expr(e->left, values, isnull, selected, n);
+			batch_eval_expr(e->right, values, isnull, selected, n);
+			for (k = 0; k < n; k++)
+				e->nulls[k] = e->left->nulls[k] | e->right->nulls[k];
+			if (BATCH_IS_FLOAT(e->typid))
+				batch_float_arith(e, n);
+			else
+				batch_int_arith(e, n);
+			break;
+	}
+}
+
+/*
+ * Keep the selected rows for which test is true and neither side is NULL.
+ * The selection vector is compacted in place, without branches.
+ */
+#define BATCH_FILTER(test) \
+	do { \
+		for (k = 0; k < n; k++) \
+		{ \
+			selected[m] = selected[k]; \
+			m += (!lnull[k] & !rnull[k] & (test)); \
+		} \
+	} while (0)
+
+static int
+batch_int_compare(BatchOp op, const BatchExpr *left, const BatchExpr *right,
+				  int *selected, int n)
+{
+	const int64 *l = left->ivals;
+	const int64 *r = right->ivals;
+	const bool *lnull = left->nulls;
+	const bool *rnull = right->nulls;
+	int			m = 0;
+	int			k;
+
+	switch (op)
+	{
+		case BOP_EQ:
+			BATCH_FILTER(l[k] == r[k]);
+			break;
+		case BOP_NE:
+			BATCH_FILTER(l[k] != r[k]);
+			break;
+		case BOP_LT:
+			BATCH_FILTER(l[k] < r[k]);
+			break;
+		case BOP_LE:
+			BATCH_FILTER(l[k] <= r[k]);
+			break;
+		case BOP_GT:
+			BATCH_FILTER(l[k] > r[k]);
+			break;
+		case BOP_GE:
+			BATCH_FILTER(l[k] >= r[k]);
+			break;
+		default:
+			elog(ERROR, "unexpected batch comparison operator %d", op);
+	}
+	return m;
+}
+
+/*
+ * As float8_cmp_internal(), NaNs are equal to each other and greater than
+ * anything else.
+ */
+#define BATCH_FLOAT_EQ(a, b)	((a) == (b) || (isnan(a) && isnan(b)))
+#define BATCH_FLOAT_LT(a, b)	(!isnan(a) && (isnan(b) || (a) < (b)))
+#define BATCH_FLOAT_LE(a, b)	(isnan(b) || (!isnan(a) && (a) <= (b)))
+
+static int
+batch_float_compare(BatchOp op, const BatchExpr *left, const BatchExpr *right,
+					int *selected, int n)
+{
+	const double *l = left->fvals;
+	const double *r = right->fvals;
+	const bool *lnull = left->nulls;
+	const bool *rnull = right->nulls;
+	int			m = 0;
+	int			k;
+
+	switch (op)
+	{
+		case BOP_EQ:
+			BATCH_FILTER(BATCH_FLOAT_EQ(l[k], r[k]));
+			break;
+		case BOP_NE:
+			BATCH_FILTER(!BATCH_FLOAT_EQ(l[k], r[k]));
+			break;
+		case BOP_LT:
+			BATCH_FILTER(BATCH_FLOAT_LT(l[k], r[k]));
+			break;
+		case BOP_LE:
+			BATCH_FILTER(BATCH_FLOAT_LE(l[k], r[k]));
+			break;
+		case BOP_GT:
+			BATCH_FILTER(BATCH_FLOAT_LT(r[k], l[k]));
+			break;
+		case BOP_GE:
+			BATCH_FILTER(BATCH_FLOAT_LE(r[k], l[k]));
+			break;
+		default:
+			elog(ERROR, "unexpected batch comparison operator %d", op);
+	}
+	return m;
+}
+
+static int
+batch_null_test(const BatchClause *clause, const bool *isnull,
+				int *selected, int n)
+{
+	bool		wantnull = (clause->nulltesttype == IS_NULL);
+	int			m = 0;
+	int			k;
+
+	for (k = 0; k < n; k++)
+	{
+		int			row = selected[k];
+
+		selected[m] = row;
+		m += (isnull[row] == wantnull);
+	}
+	return m;
+}
+
+/*
+ * ExecBatchQual
+ *
+ * Evaluate the compiled quals on the rows of a batch listed in selected[],
+ * values[attno][row] and isnull[attno][row] holding the columns.  The rows
+ * that pass all of them are left at the start of selected[], in order, and
+ * their count is returned.
+ */
+int
+ExecBatchQual(BatchQual *bq, Datum **values, bool **isnull,
+			  int *selected, int nselected)
+{
+	int			i;
+
+	Assert(nselected <= bq->maxRows);
+
+	for (i = 0; i < bq->nclauses && nselected > 0; i++)
+	{
+		BatchClause *clause = &bq->clauses[i];
+
+		if (clause->kind == BCLAUSE_NULLTEST)
+		{
+			nselected = batch_null_test(clause, isnull[clause->attno],
+										selected, nselected);
+			continue;
+		}
+
+		batch_eval_expr(clause->left, values, isnull, selected, nselected);
+		batch_eval_expr(clause->right, values, isnull, selected, nselected);
+		if (BATCH_IS_FLOAT(clause->left->typid))
+			nselected = batch_float_compare(clause->op, clause->left,
+											clause->right, selected,
+											nselected);
+		else
+			nselected = batch_int_compare(clause->op, clause->left,
+										  clause->right, selected,
+										  nselected);
+	}
+
+	return nselected;
+}
@@ -257,6 +257,23 @@ BitmapAOScanNext(ScanState *scanState)
 
       	if (TupIsNull(slot))
       	{
+			bool		pastEnd;
+
+			/*
+			 * The row numbers of a page are visited in ascending order, and
+			 * all belong to the same segment file. Once one of them is past
+			 * the last row of the segment file, so are the rest of them;
+			 * don't look each of them up in the block directory. This
+			 * matters for the last lossy page of a segment file, which would
+			 * otherwise probe up to 2^15 row numbers that don't exist.
+			 */
+			if (scanState->tableType == TableTypeAppendOnly)
+				pastEnd = appendonly_fetch_past_end((AppendOnlyFetchDesc)node->scanDesc, &aoTid);
+			else
+				pastEnd = aocs_fetch_past_end((AOCSFetchDesc)node->scanDesc, &aoTid);
+
+			if (pastEnd)
+				iterator->tupleIndex = iterator->nTuples - 1;
 			continue;
       	}
 
@@ -111,6 +111,8 @@ BitmapHeapScanNext(ScanState *scanState)
 
 		if (node->iterator == NULL)
 		{
+			bitprefetch(scan, node->tbm);
+
 			/*
 			 * Fetch the current heap page and identify candidate tuples.
 			 */
@@ -18,6 +18,10 @@
  */
 #include "postgres.h"
 
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
 #include "miscadmin.h" /* work_mem */
 #include "executor/executor.h"
 #include "nodes/execnodes.h"
@@ -29,6 +33,7 @@
 #include "utils/datum.h"
 #include "utils/memutils.h"
 #include "utils/lsyscache.h"
+#include "utils/resgroup.h"
 #include "utils/elog.h"
 #include "cdb/memquota.h"
 #include "utils/workfile_mgr.h"
@@ -36,12 +41,16 @@
 #include "access/hash.h"
 
 #include "cdb/cdbexplain.h"
+#include "cdb/cdbqueryhistory.h"
 #include "cdb/cdbvars.h"
 #include "postmaster/primary_mirror_mode.h"
 
 
 #define HHA_MSG_LVL DEBUG2
 
+/* Input tuples a streaming round must see before it may turn pass-through */
+#define HHA_PASSTHROUGH_MIN_TUPLES 1000
+
 
 /* Encapture data related to a batch file. */
 struct BatchFileInfo
@@ -102,6 +111,19 @@ typedef enum InputRecordType
 
 #define LOG2(x) (ceil(log((x)) / log(2)))
 
+/* Group index: slots per control group, empty marker, initial size */
+#define IDX_GROUP 16
+#define IDX_EMPTY 0x80
+#define IDX_INIT_SLOTS 1024
+#define IDX_SLOT_SIZE (sizeof(uint8) + sizeof(HashAggEntry *))
+
+/*
+ * The bucket index takes the low bits of the hash value; remix them so the
+ * index's group number and tag don't repeat the bucket number.
+ */
+#define IDX_MIX(hashkey) ((uint32) (hashkey) * 0x9E3779B1U)
+#define IDX_TAG(mixed) ((uint8) ((mixed) >> 25))
+
 /* Methods that handle batch files */
 static SpillSet *createSpillSet(unsigned branching_factor, unsigned parent_hash_bit);
 static int closeSpillFile(AggState *aggstate, SpillSet *spill_set, int file_no);
@@ -124,8 +146,17 @@ static HashAggEntry *lookup_agg_hash_entry(AggState *aggstate, void *input_recor
 										   InputRecordType input_type, int32 input_size,
 										   uint32 hashkey, bool *p_isnew);
 static void agg_hash_table_stat_upd(HashAggTable *ht);
+static bool grow_max_mem(HashAggTable *hashtable, Size needed);
 static void reset_agg_hash_table(AggState *aggstate, int64 nentries);
 static bool agg_hash_reload(AggState *aggstate);
+static int32 hash_entry_serial_size(AggState *aggstate, HashAggEntry *entry,
+									int32 *p_tuple_agg_size);
+static bool keep_hash_entry(AggState *aggstate, HashAggEntry *entry);
+static void restore_kept_groups(AggState *aggstate);
+static bool agg_index_alloc(HashAggTable *hashtable, MemoryContext cxt, uint32 nslots);
+static void agg_index_free(HashAggTable *hashtable);
+static void agg_index_clear(HashAggTable *hashtable);
+static void agg_index_insert(HashAggTable *hashtable, HashAggEntry *entry);
 static void reCalcNumberBatches(HashAggTable *hashtable, SpillFile *spill_file);
 static inline void *mpool_cxt_alloc(void *manager, Size len);
 
@@ -215,6 +246,24 @@ adjustInputGroup(AggState *aggstate,
 	}
 }
 
+/* Function: grow_max_mem
+ *
+ * Raise max_mem by the quota that finished operators gave back to the
+ * query (see MemoryAccounting_RelinquishQuota), before the caller gives
+ * up and spills. Returns true if another needed bytes now fit.
+ */
+static bool
+grow_max_mem(HashAggTable *hashtable, Size needed)
+{
+	uint64 acquired = MemoryAccounting_RequestQuotaIncrease();
+
+	if (acquired == 0)
+		return false;
+
+	hashtable->max_mem += (double) acquired;
+	return GET_TOTAL_USED_SIZE(hashtable) + needed < hashtable->max_mem;
+}
+
 /* Function: getEmptyHashAggEntry
  *
  * Obtain a new empty HashAggEntry.
@@ -269,6 +318,7 @@ makeHashAggEntryForInput(AggState *aggstate, TupleTableSlot *inputslot, uint32 h
 	entry->tuple_and_aggs = NULL;
 	entry->hashvalue = hashvalue;
 	entry->is_primodial = !(hashtable->is_spilling);
+	entry->nhits = 0;
 	entry->next = NULL;
 
 	/*
@@ -285,7 +335,8 @@ makeHashAggEntryForInput(AggState *aggstate, TupleTableSlot *inputslot, uint32 h
 	Assert(tup_len > 0 && entry->tuple_and_aggs == NULL);
 
 	if (GET_TOTAL_USED_SIZE(hashtable) + MAXALIGN(MAXALIGN(tup_len) + aggs_len) >=
-		hashtable->max_mem)
+		hashtable->max_mem &&
+		!grow_max_mem(hashtable, MAXALIGN(MAXALIGN(tup_len) + aggs_len)))
 		return NULL;
 
 	entry->tuple_and_aggs = mpool_alloc(hashtable->group_buf,
@@ -328,7 +379,8 @@ makeHashAggEntryForGroup(AggState *aggstate, void *tuple_and_aggs,
 
 	MemoryContext oldcxt;
 
-	if (GET_TOTAL_USED_SIZE(hashtable) + input_size >= hashtable->max_mem)
+	if (GET_TOTAL_USED_SIZE(hashtable) + input_size >= hashtable->max_mem &&
+		!grow_max_mem(hashtable, input_size))
 		return NULL;
 
 	copy_tuple_and_aggs = mpool_alloc(hashtable->group_buf, input_size);
@@ -339,6 +391,7 @@ makeHashAggEntryForGroup(AggState *aggstate, void *tuple_and_aggs,
 	entry = getEmptyHashAggEntry(aggstate);
 	entry->hashvalue = hashvalue;
 	entry->is_primodial = !(hashtable->is_spilling);
+	entry->nhits = 0;
 	entry->tuple_and_aggs = copy_tuple_and_aggs;
 	entry->next = NULL;
 
@@ -368,6 +421,55 @@ setGroupAggs(HashAggTable *hashtable, HashAggEntry *entry)
 	}
 }
 
+/*
+ * Does the given hash entry hold the group of the input record?
+ *
+ * The input record is either an input tuple or a group's byte array; see
+ * lookup_agg_hash_entry.
+ */
+static inline bool
+agg_hash_entry_matches(AggState *aggstate, HashAggEntry *entry,
+					   void *input_record, InputRecordType input_type)
+{
+	MemTupleBinding *mt_bind = aggstate->hashslot->tts_mt_bind;
+	Agg *agg = (Agg*)aggstate->ss.ps.plan;
+	MemTuple mtup = (MemTuple) entry->tuple_and_aggs;
+	int i;
+
+	for (i = 0; i < agg->numCols; i++)
+	{
+		AttrNumber	att = agg->grpColIdx[i];
+		Datum input_datum = 0;
+		Datum entry_datum = 0;
+		bool input_isNull = false;
+		bool entry_isNull = false;
+
+		switch(input_type)
+		{
+			case INPUT_RECORD_TUPLE:
+				input_datum = slot_getattr((TupleTableSlot *)input_record, att, &input_isNull);
+				break;
+			case INPUT_RECORD_GROUP_AND_AGGS:
+				input_datum = memtuple_getattr((MemTuple)input_record, mt_bind, att, &input_isNull);
+				break;
+			default:
+				insist_log(false, "invalid record type %d", input_type);
+		}
+
+		entry_datum = memtuple_getattr(mtup, mt_bind, att, &entry_isNull);
+
+		if ( !input_isNull && !entry_isNull &&
+			 (DatumGetBool(FunctionCall2(&aggstate->eqfunctions[i],
+										 input_datum,
+										 entry_datum)) ) )
+			continue; /* Both non-NULL and equal. */
+		if (!(input_isNull && entry_isNull)) /* NULLs match in group keys. */
+			return false;
+	}
+
+	return true;
+}
+
 /*
  * Function: lookup_agg_hash_entry
  *
@@ -393,14 +495,12 @@ lookup_agg_hash_entry(AggState *aggstate,
 {
 	HashAggEntry *entry;
 	HashAggTable *hashtable = aggstate->hhashtable;
-	MemTupleBinding *mt_bind = aggstate->hashslot->tts_mt_bind;
 	ExprContext *tmpcontext = aggstate->tmpcontext; /* per input tuple context */
-	Agg *agg = (Agg*)aggstate->ss.ps.plan;
 	MemoryContext oldcxt;
 	unsigned int bucket_idx;
 	uint64 bloomval;			/* bloom filter value */
    
-	Assert(mt_bind != NULL);
+	Assert(aggstate->hashslot->tts_mt_bind != NULL);
 
 	if (p_isnew != NULL)
 		*p_isnew = false;
@@ -409,62 +509,82 @@ lookup_agg_hash_entry(AggState *aggstate,
 
 	bucket_idx = BUCKET_IDX(hashtable, hashkey);
 	bloomval = BLOOMVAL(hashkey);
-	entry = (0 == (hashtable->bloom[bucket_idx] & bloomval) ? NULL :
-			 hashtable->buckets[bucket_idx]);
 
-	/*
-	 * Search entry chain for the bucket. If such an entry found in the
-	 * chain, move it to the front of the chain. Otherwise, if there
-	 * are any space left, create a new entry, and insert it in
-	 * the front of the chain.
-	 */
-	while (entry != NULL)
+	if (hashtable->idx_nslots > 0)
 	{
-		MemTuple mtup = (MemTuple) entry->tuple_and_aggs;
-		int i;
-		bool match = true;
+		/*
+		 * Probe the index one group of slots at a time.  Only slots whose
+		 * tag matches lead to an entry, so a miss usually touches nothing
+		 * but the control bytes.  A group with an empty slot ends the
+		 * probe sequence.
+		 */
+		uint32 mixed = IDX_MIX(hashkey);
+		uint8 tag = IDX_TAG(mixed);
+		uint32 group_mask = hashtable->idx_nslots / IDX_GROUP - 1;
+		uint32 group = mixed & group_mask;
 
-		if (hashkey != entry->hashvalue)
-		{
-			entry = entry->next;
-			continue;
-		}
-		
-		for (i = 0; match && i < agg->numCols; i++)
+		entry = NULL;
+		for (;;)
 		{
-			AttrNumber	att = agg->grpColIdx[i];
-			Datum input_datum = 0;
-			Datum entry_datum = 0;
-			bool input_isNull = false;
-			bool entry_isNull = false;
-				
-			switch(input_type)
+			uint8 *ctrl = hashtable->idx_ctrl + group * IDX_GROUP;
+			HashAggEntry **slots = hashtable->idx_slots + group * IDX_GROUP;
+			uint32 match;
+			uint32 empty;
+
+			__builtin_prefetch(slots);
+#ifdef __SSE2__
 			{
-				case INPUT_RECORD_TUPLE:
-					input_datum = slot_getattr((TupleTableSlot *)input_record, att, &input_isNull);
-					break;
-				case INPUT_RECORD_GROUP_AND_AGGS:
-					input_datum = memtuple_getattr((MemTuple)input_record, mt_bind, att, &input_isNull);
-					break;
-				default:
-					insist_log(false, "invalid record type %d", input_type);
+				__m128i c = _mm_loadu_si128((const __m128i *) ctrl);
+
+				match = _mm_movemask_epi8(_mm_cmpeq_epi8(c, _mm_set1_epi8((char) tag)));
+				empty = _mm_movemask_epi8(_mm_cmpeq_epi8(c, _mm_set1_epi8((char) IDX_EMPTY)));
+			}
+#else
+			{
+				int i;
+
+				match = empty = 0;
+				for (i = 0; i < IDX_GROUP; i++)
+				{
+					if (ctrl[i] == tag)
+						match |= 1 << i;
+					else if (ctrl[i] == IDX_EMPTY)
+						empty |= 1 << i;
+				}
 			}
+#endif
+			while (match != 0)
+			{
+				HashAggEntry *candidate = slots[__builtin_ctz(match)];
 
-			entry_datum = memtuple_getattr(mtup, mt_bind, att, &entry_isNull);
+				match &= match - 1;
+				if (candidate->hashvalue == hashkey &&
+					agg_hash_entry_matches(aggstate, candidate, input_record, input_type))
+				{
+					entry = candidate;
+					break;
+				}
+			}
 
-			if ( !input_isNull && !entry_isNull &&
-				 (DatumGetBool(FunctionCall2(&aggstate->eqfunctions[i],
-											 input_datum,
-											 entry_datum)) ) )
-				continue; /* Both non-NULL and equal. */
-			match = (input_isNull && entry_isNull);/* NULLs match in group keys. */
+			if (entry != NULL || empty != 0)
+				break;
+			group = (group + 1) & group_mask;
 		}
-		
-		/* Break if found an existing matching entry. */
-		if (match)
-			break;
+	}
+	else
+	{
+		entry = (0 == (hashtable->bloom[bucket_idx] & bloomval) ? NULL :
+				 hashtable->buckets[bucket_idx]);
 
-		entry = entry->next;
+		/* Search entry chain for the bucket. */
+		while (entry != NULL)
+		{
+			if (hashkey == entry->hashvalue &&
+				agg_hash_entry_matches(aggstate, entry, input_record, input_type))
+				break;
+
+			entry = entry->next;
+		}
 	}
 
 	if (entry == NULL)
@@ -496,6 +616,17 @@ lookup_agg_hash_entry(AggState *aggstate,
 			entry->next = hashtable->buckets[bucket_idx];
 			hashtable->buckets[bucket_idx] = entry;
 			hashtable->bloom[bucket_idx] |= bloomval;
+
+			if (hashtable->idx_nslots > 0)
+			{
+				/* Keep the index at most 7/8 full, or give it up */
+				if ((hashtable->idx_used + 1) * 8 > (uint64) hashtable->idx_nslots * 7 &&
+					!agg_index_alloc(hashtable, aggstate->aggcontext,
+									 hashtable->idx_nslots * 2))
+					agg_index_free(hashtable);
+				else
+					agg_index_insert(hashtable, entry);
+			}
 			
 			++hashtable->num_ht_groups;
 			++hashtable->num_entries;
@@ -512,6 +643,111 @@ lookup_agg_hash_entry(AggState *aggstate,
 	return entry;
 }
 
+/*
+ * agg_index_alloc -- (re)build the group index with nslots slots.
+ *
+ * The entries already in the index are moved over.  The index is charged
+ * to the hash table's metadata.  Returns false, leaving the index as it
+ * was, if there isn't memory for it.
+ */
+static bool
+agg_index_alloc(HashAggTable *hashtable, MemoryContext cxt, uint32 nslots)
+{
+	uint8 *old_ctrl = hashtable->idx_ctrl;
+	HashAggEntry **old_slots = hashtable->idx_slots;
+	uint32 old_nslots = hashtable->idx_nslots;
+	MemoryContext oldcxt;
+	uint32 i;
+
+	Assert(nslots >= IDX_GROUP && (nslots & (nslots - 1)) == 0);
+
+	/* The old index is still around while the new one is filled */
+	if (nslots > PG_UINT32_MAX / 2 ||
+		(double) nslots * IDX_SLOT_SIZE >= AVAIL_MEM(hashtable))
+	{
+		elog(HHA_MSG_LVL, "HashAgg: no memory for a %u-slot group index", nslots);
+		return false;
+	}
+
+	oldcxt = MemoryContextSwitchTo(cxt);
+	hashtable->idx_ctrl = (uint8 *) palloc(nslots * sizeof(uint8));
+	hashtable->idx_slots = (HashAggEntry **) palloc(nslots * sizeof(HashAggEntry *));
+	MemoryContextSwitchTo(oldcxt);
+
+	memset(hashtable->idx_ctrl, IDX_EMPTY, nslots * sizeof(uint8));
+	hashtable->idx_nslots = nslots;
+	hashtable->idx_used = 0;
+	hashtable->mem_for_metadata += (double) (nslots - old_nslots) * IDX_SLOT_SIZE;
+
+	for (i = 0; i < old_nslots; i++)
+	{
+		if (old_ctrl[i] != IDX_EMPTY)
+			agg_index_insert(hashtable, old_slots[i]);
+	}
+
+	if (old_ctrl != NULL)
+	{
+		pfree(old_ctrl);
+		pfree(old_slots);
+	}
+
+	return true;
+}
+
+/*
+ * agg_index_free -- give up the group index; lookups walk the chains.
+ */
+static void
+agg_index_free(HashAggTable *hashtable)
+{
+	if (hashtable->idx_nslots == 0)
+		return;
+
+	pfree(hashtable->idx_ctrl);
+	pfree(hashtable->idx_slots);
+	hashtable->mem_for_metadata -= (double) hashtable->idx_nslots * IDX_SLOT_SIZE;
+	hashtable->idx_ctrl = NULL;
+	hashtable->idx_slots = NULL;
+	hashtable->idx_nslots = 0;
+	hashtable->idx_used = 0;
+}
+
+/*
+ * agg_index_clear -- empty the group index, along with the hash chains.
+ */
+static void
+agg_index_clear(HashAggTable *hashtable)
+{
+	if (hashtable->idx_nslots == 0)
+		return;
+
+	memset(hashtable->idx_ctrl, IDX_EMPTY, hashtable->idx_nslots * sizeof(uint8));
+	hashtable->idx_used = 0;
+}
+
+/*
+ * agg_index_insert -- add an entry to the group index.
+ *
+ * The caller makes sure there is a free slot.
+ */
+static void
+agg_index_insert(HashAggTable *hashtable, HashAggEntry *entry)
+{
+	uint32 mixed = IDX_MIX(entry->hashvalue);
+	uint32 slot_mask = hashtable->idx_nslots - 1;
+	uint32 slot = (mixed & (hashtable->idx_nslots / IDX_GROUP - 1)) * IDX_GROUP;
+
+	Assert(hashtable->idx_used < hashtable->idx_nslots);
+
+	/* Same probe sequence as the lookup: first free slot from the group on */
+	while (hashtable->idx_ctrl[slot] != IDX_EMPTY)
+		slot = (slot + 1) & slot_mask;
+
+	hashtable->idx_ctrl[slot] = IDX_TAG(mixed);
+	hashtable->idx_slots[slot] = entry;
+	hashtable->idx_used++;
+}
+
 /*
  * Compute HHashTable entry size
  *
@@ -800,6 +1036,9 @@ create_agg_hash_table(AggState *aggstate)
 
 	hashtable->prev_slot = NULL;
 
+	if (gp_hashagg_index_groups)
+		agg_index_alloc(hashtable, aggstate->aggcontext, IDX_INIT_SLOTS);
+
 	MemSet(padding_dummy, 0, MAXIMUM_ALIGNOF);
 	
 	init_agg_hash_iter(hashtable);
@@ -938,11 +1177,14 @@ agg_hash_initial_pass(AggState *aggstate)
 			initialize_aggregates(aggstate, aggstate->peragg, hashtable->groupaggs->aggs,
 								  &(aggstate->mem_manager));
 		}
+		else if (entry->nhits < PG_UINT16_MAX)
+			entry->nhits++;
 			
 		/* Advance the aggregates */
 		call_AdvanceAggregates(aggstate, hashtable->groupaggs->aggs, &(aggstate->mem_manager));
 		
 		hashtable->num_tuples++;
+		hashtable->stream_tuples++;
 
 		/* Reset per-input-tuple context after each tuple */
 		ResetExprContext(tmpcontext);
@@ -955,6 +1197,22 @@ agg_hash_initial_pass(AggState *aggstate)
 			break;
 		}
 
+		/*
+		 * Spill early if the resource group memory is exhausted, rather
+		 * than having the query cancelled.
+		 */
+		if (!streaming && hashtable->num_ht_groups > 1 &&
+			ResGroupConsumeSpillRequest())
+		{
+			if (GET_TOTAL_USED_SIZE(hashtable) > hashtable->mem_used)
+				hashtable->mem_used = GET_TOTAL_USED_SIZE(hashtable);
+
+			if (!hashtable->is_spilling && aggstate->ss.ps.instrument)
+				agg_hash_table_stat_upd(hashtable);
+
+			spill_hash_table(aggstate);
+		}
+
 		/* Read the next tuple */
 		outerslot = ExecProcNode(outerPlanState(aggstate));
 	}
@@ -993,6 +1251,45 @@ agg_hash_initial_pass(AggState *aggstate)
 	if(tuple_remaining) 
 		elog(HHA_MSG_LVL, "HashAgg: streaming out the intermediate results.");
 
+	/*
+	 * If more input is coming, the groups that got more than twice their
+	 * share of this round's input are likely to be hit again.  Hold them
+	 * back and send on only the rest, so that hot groups don't go out as
+	 * a new partial group every time the table fills up.  Once the input
+	 * is exhausted, everything goes out.
+	 */
+	hashtable->stream_keep = false;
+
+	/*
+	 * If this round found nearly as many groups as it read rows, the local
+	 * aggregation isn't reducing anything, and each flush only costs.  Stop
+	 * aggregating then, and let ExecAgg pass the rest of the input on row
+	 * by row.  Rollup input keeps its grouping columns and HAVING quals
+	 * need the real groups, so those always aggregate.
+	 */
+	if (tuple_remaining && gp_hashagg_passthrough_ratio > 0 &&
+		hashtable->stream_tuples >= HHA_PASSTHROUGH_MIN_TUPLES &&
+		hashtable->num_entries >= gp_hashagg_passthrough_ratio * hashtable->stream_tuples &&
+		!((Agg *) aggstate->ss.ps.plan)->inputHasGrouping &&
+		aggstate->ss.ps.qual == NIL)
+	{
+		elog(HHA_MSG_LVL, "HashAgg: " INT64_FORMAT " groups from " INT64_FORMAT " tuples, "
+			 "switching to pass-through",
+			 hashtable->num_entries, hashtable->stream_tuples);
+		hashtable->passthrough = true;
+	}
+	else if (tuple_remaining && gp_hashagg_stream_keep_hot &&
+		hashtable->num_entries > 0)
+	{
+		hashtable->stream_keep = true;
+		hashtable->keep_min_hits =
+			Max(2, (uint32) Min(2 * hashtable->stream_tuples / hashtable->num_entries,
+								PG_UINT16_MAX));
+		hashtable->keep_max_bytes =
+			(hashtable->max_mem - hashtable->mem_for_metadata) / 4;
+		hashtable->num_stream_flushes++;
+	}
+
 	return tuple_remaining;
 }
 
@@ -1349,6 +1646,8 @@ spill_hash_table(AggState *aggstate)
 		}
 	}
 
+	agg_index_clear(hashtable);
+
 	/* Reset the buffer */
 	mpool_reset(hashtable->group_buf);
 
@@ -1443,28 +1742,21 @@ expand_hash_table(AggState *aggstate)
 }
 
 /*
- * writeHashEntry -- write an hash entry to a batch file.
+ * hash_entry_serial_size -- size of a hash entry as written by
+ * writeHashEntry(), not counting its hash value and size words.
  *
- * The hash entry is serialized here, including the tuple that contains
- * grouping keys and aggregate values.
- *
- * readHashEntry() should expect to retrieve hash entries in the
- * format defined in this function.
+ * *p_tuple_agg_size is set to the size of the grouping key memtuple plus
+ * the per-group data, which is the part stored in tuple_and_aggs.
  */
 static int32
-writeHashEntry(AggState *aggstate, BatchFileInfo *file_info,
-			   HashAggEntry *entry)
+hash_entry_serial_size(AggState *aggstate, HashAggEntry *entry,
+					   int32 *p_tuple_agg_size)
 {
-	int32 tuple_agg_size = 0;
-	int32 total_size = 0;
+	int32 tuple_agg_size;
+	int32 total_size;
 	AggStatePerGroup pergroup;
-	int aggno;
 	AggStatePerAgg peragg = aggstate->peragg;
-
-	Assert(file_info != NULL);
-	Assert(file_info->wfile != NULL);
-
-	ExecWorkFile_Write(file_info->wfile, (void *)(&(entry->hashvalue)), sizeof(entry->hashvalue));
+	int aggno;
 
 	tuple_agg_size = memtuple_get_size((MemTuple)entry->tuple_and_aggs);
 	pergroup = (AggStatePerGroup) ((char *)entry->tuple_and_aggs + MAXALIGN(tuple_agg_size));
@@ -1487,6 +1779,38 @@ writeHashEntry(AggState *aggstate, BatchFileInfo *file_info,
 		}
 	}
 
+	*p_tuple_agg_size = tuple_agg_size;
+	return total_size;
+}
+
+/*
+ * writeHashEntry -- write an hash entry to a batch file.
+ *
+ * The hash entry is serialized here, including the tuple that contains
+ * grouping keys and aggregate values.
+ *
+ * readHashEntry() should expect to retrieve hash entries in the
+ * format defined in this function.
+ */
+static int32
+writeHashEntry(AggState *aggstate, BatchFileInfo *file_info,
+			   HashAggEntry *entry)
+{
+	int32 tuple_agg_size = 0;
+	int32 total_size = 0;
+	AggStatePerGroup pergroup;
+	int aggno;
+	AggStatePerAgg peragg = aggstate->peragg;
+
+	Assert(file_info != NULL);
+	Assert(file_info->wfile != NULL);
+
+	ExecWorkFile_Write(file_info->wfile, (void *)(&(entry->hashvalue)), sizeof(entry->hashvalue));
+
+	pergroup = (AggStatePerGroup) ((char *)entry->tuple_and_aggs +
+								   MAXALIGN(memtuple_get_size((MemTuple)entry->tuple_and_aggs)));
+	total_size = hash_entry_serial_size(aggstate, entry, &tuple_agg_size);
+
 	ExecWorkFile_Write(file_info->wfile, (char *)&total_size, sizeof(total_size));
 	ExecWorkFile_Write(file_info->wfile, entry->tuple_and_aggs, tuple_agg_size);
 	Assert(MAXALIGN(tuple_agg_size) - tuple_agg_size <= MAXIMUM_ALIGNOF);
@@ -1584,22 +1908,36 @@ agg_hash_iter(AggState *aggstate)
 	
 	oldcxt = MemoryContextSwitchTo(hashtable->entry_cxt);
 
-	while (entry == NULL &&
-		   hashtable->nbuckets > ++ hashtable->curr_bucket_idx)
+	for (;;)
 	{
-		entry = hashtable->buckets[hashtable->curr_bucket_idx];
-		if (entry != NULL)
+		while (entry == NULL &&
+			   hashtable->nbuckets > ++ hashtable->curr_bucket_idx)
 		{
-			Assert(entry->is_primodial);
-			break;
+			entry = hashtable->buckets[hashtable->curr_bucket_idx];
+			if (entry != NULL)
+			{
+				Assert(entry->is_primodial);
+				break;
+			}
 		}
-	}
 
-	if (entry != NULL)
-	{
-		hashtable->num_output_groups++;
+		if (entry == NULL)
+			break;
+
 		hashtable->next_entry = entry->next;
 		entry->next = NULL;
+
+		/* Hold back hot groups when streaming; see agg_hash_initial_pass */
+		if (hashtable->stream_keep &&
+			entry->nhits >= hashtable->keep_min_hits &&
+			keep_hash_entry(aggstate, entry))
+		{
+			entry = hashtable->next_entry;
+			continue;
+		}
+
+		hashtable->num_output_groups++;
+		break;
 	}
 
 	MemoryContextSwitchTo(oldcxt);
@@ -1675,10 +2013,130 @@ agg_hash_stream(AggState *aggstate)
 		"HashAgg: streaming");
 
 	reset_agg_hash_table(aggstate, 0 /* don't reallocate buckets */);
+	restore_kept_groups(aggstate);
 	
 	return agg_hash_initial_pass(aggstate);
 }
 
+/*
+ * keep_hash_entry -- hold back a group from a streaming flush.
+ *
+ * The entry is copied to hashtable->kept_groups in the format of
+ * writeHashEntry(), preceded by its hash value, hit count and size.
+ * Returns false, and keeps nothing, if there is no room left for it.
+ */
+static bool
+keep_hash_entry(AggState *aggstate, HashAggEntry *entry)
+{
+	HashAggTable *hashtable = aggstate->hhashtable;
+	StringInfo kept;
+	AggStatePerGroup pergroup;
+	AggStatePerAgg peragg = aggstate->peragg;
+	int32 tuple_agg_size;
+	int32 total_size;
+	uint32 header[3];
+	char *p;
+	int aggno;
+
+	total_size = hash_entry_serial_size(aggstate, entry, &tuple_agg_size);
+
+	/* Charge what the group will take up once it is back in the table */
+	if (hashtable->kept_bytes + total_size + sizeof(HashAggEntry) >
+		hashtable->keep_max_bytes)
+		return false;
+	hashtable->kept_bytes += total_size + sizeof(HashAggEntry);
+
+	if (hashtable->kept_groups == NULL)
+	{
+		MemoryContext oldcxt = MemoryContextSwitchTo(aggstate->aggcontext);
+
+		hashtable->kept_groups = makeStringInfo();
+		MemoryContextSwitchTo(oldcxt);
+	}
+	kept = hashtable->kept_groups;
+
+	/* Each record starts MAXALIGNed, so its memtuple can be read in place */
+	enlargeStringInfo(kept, MAXALIGN(sizeof(header)) + total_size);
+	p = kept->data + kept->len;
+	MemSet(p, 0, MAXALIGN(sizeof(header)) + total_size);
+
+	header[0] = entry->hashvalue;
+	header[1] = entry->nhits;
+	header[2] = total_size;
+	memcpy(p, header, sizeof(header));
+	p += MAXALIGN(sizeof(header));
+
+	memcpy(p, entry->tuple_and_aggs, tuple_agg_size);
+	p += MAXALIGN(tuple_agg_size);
+
+	pergroup = (AggStatePerGroup) ((char *)entry->tuple_and_aggs +
+								   MAXALIGN(memtuple_get_size((MemTuple)entry->tuple_and_aggs)));
+	for (aggno = 0; aggno < aggstate->numaggs; aggno++)
+	{
+		AggStatePerAgg peraggstate = &peragg[aggno];
+		AggStatePerGroup pergroupstate = &pergroup[aggno];
+
+		if (!peraggstate->transtypeByVal &&
+			!pergroupstate->transValueIsNull)
+		{
+			Size datum_size = datumGetSize(pergroupstate->transValue,
+										   peraggstate->transtypeByVal,
+										   peraggstate->transtypeLen);
+			memcpy(p, DatumGetPointer(pergroupstate->transValue), datum_size);
+			p += MAXALIGN(datum_size);
+		}
+	}
+	Assert(p == kept->data + kept->len + MAXALIGN(sizeof(header)) + total_size);
+
+	kept->len += MAXALIGN(sizeof(header)) + total_size;
+	hashtable->num_kept_groups++;
+
+	return true;
+}
+
+/*
+ * restore_kept_groups -- put the groups held back by keep_hash_entry()
+ * into the freshly reset hash table.
+ *
+ * Their hit counts are halved, so a group that cools down is sent on in
+ * one of the next flushes.
+ */
+static void
+restore_kept_groups(AggState *aggstate)
+{
+	HashAggTable *hashtable = aggstate->hhashtable;
+	StringInfo kept = hashtable->kept_groups;
+	int off = 0;
+
+	hashtable->stream_tuples = 0;
+	hashtable->kept_bytes = 0;
+	if (kept == NULL)
+		return;
+
+	while (off < kept->len)
+	{
+		uint32 header[3];
+		HashAggEntry *entry;
+		bool isNew;
+
+		memcpy(header, kept->data + off, sizeof(header));
+		off += MAXALIGN(sizeof(header));
+
+		entry = lookup_agg_hash_entry(aggstate, kept->data + off,
+									  INPUT_RECORD_GROUP_AND_AGGS, (int32) header[2],
+									  header[0], &isNew);
+
+		/* keep_hash_entry() only holds back what fits in the empty table */
+		if (entry == NULL || !isNew)
+			elog(ERROR, "could not restore held back hash aggregate group");
+
+		entry->nhits = (uint16) (header[1] / 2);
+		off += header[2];
+	}
+
+	resetStringInfo(kept);
+}
+
 /*
  * Function: agg_hash_load
  *
@@ -2048,6 +2506,8 @@ agg_hash_next_pass(AggState *aggstate)
 		elog(HHA_MSG_LVL, "HashAgg: processing %d level batch file %d",
 			 spill_set->level, file_no);
 
+		QueryHistoryCountHashAggPass();
+
 		more = agg_hash_reload(aggstate);
 	}
 	else
@@ -2094,6 +2554,22 @@ agg_hash_explain(AggState *aggstate)
 		appendStringInfo(hbuf, ".\n");
 	}
 
+	/* If the streaming bottom stage held back hot groups */
+	if (hashtable->num_kept_groups > 0)
+	{
+		appendStringInfo(hbuf,
+				INT64_FORMAT " hot groups kept in memory over %d flushes.\n",
+				hashtable->num_kept_groups,
+				hashtable->num_stream_flushes);
+	}
+
+	if (hashtable->passthrough)
+	{
+		appendStringInfo(hbuf,
+				"Passed " INT64_FORMAT " tuples through without aggregating.\n",
+				hashtable->num_passthrough_tuples);
+	}
+
 	/* Hash chain statistics */
 	if (hashtable->chainlength.vcnt > 0)
 	{
@@ -2186,6 +2662,12 @@ void reset_agg_hash_table(AggState *aggstate, int64 nentries)
 
 	Assert(hashtable->mem_for_metadata > 0);
 
+	/* Empty the group index, or retry one given up for lack of memory */
+	if (hashtable->idx_nslots > 0)
+		agg_index_clear(hashtable);
+	else if (gp_hashagg_index_groups)
+		agg_index_alloc(hashtable, aggstate->aggcontext, IDX_INIT_SLOTS);
+
 	hashtable->num_ht_groups = 0;
 	hashtable->num_entries = 0;
 
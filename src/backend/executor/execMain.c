@@ -91,7 +91,10 @@
 #include "cdb/cdbdisp_query.h"
 #include "cdb/cdbdispatchresult.h"
 #include "cdb/cdbexplain.h"             /* cdbexplain_sendExecStats() */
+#include "cdb/cdbstmtstats.h"
 #include "cdb/cdbplan.h"
+#include "cdb/cdbprogress.h"
+#include "cdb/cdbqueryhistory.h"
 #include "cdb/cdbsrlz.h"
 #include "cdb/cdbsubplan.h"
 #include "cdb/cdbvars.h"
@@ -132,6 +135,7 @@ static void ExecSelect(TupleTableSlot *slot,
 
 static TupleTableSlot *EvalPlanQualNext(EState *estate);
 static void EndEvalPlanQual(EState *estate);
+static bool ExecConcurrentUpdateNeedsError(Relation rel);
 static void ExecCheckXactReadOnly(PlannedStmt *plannedstmt);
 static void EvalPlanQualStart(evalPlanQual *epq, EState *estate,
 				  evalPlanQual *priorepq);
@@ -184,6 +188,18 @@ CopyDirectDispatchToSlice( Plan *ddPlan, int sliceId, CopyDirectDispatchToSliceC
 		slice->directDispatch.isDirectDispatch = true;
 		slice->directDispatch.contentIds = list_copy(ddPlan->directDispatch.contentIds);
 	}
+	else if ( ddPlan->directDispatch.paramKeys != NIL)
+	{
+		/* targets depend on the parameter values, which are now known */
+		List *contentIds = GetContentIdsFromParamKeys(&ddPlan->directDispatch,
+													  estate->es_param_list_info);
+
+		if (contentIds != NIL)
+		{
+			slice->directDispatch.isDirectDispatch = true;
+			slice->directDispatch.contentIds = contentIds;
+		}
+	}
 }
 
 static bool
@@ -536,6 +552,10 @@ ExecutorStart(QueryDesc *queryDesc, int eflags)
 	 */
 	AssignParentMotionToPlanNodes(queryDesc->plannedstmt);
 
+	/* ExecInitNode() adds the nodes to this backend's progress slot */
+	QueryProgressStart(estate);
+	QueryHistoryStart(queryDesc, eflags);
+
 	/* If the interconnect has been set up; we need to catch any
 	 * errors to shut it down -- so we have to wrap InitPlan in a PG_TRY() block. */
 	PG_TRY();
@@ -566,7 +586,22 @@ ExecutorStart(QueryDesc *queryDesc, int eflags)
 				 * On return, gangs have been allocated and CDBProcess lists have
 				 * been filled in in the slice table.)
 				 */
+				instr_time	starttime;
+
+				INSTR_TIME_SET_CURRENT(starttime);
 				AssignGangs(queryDesc);
+				StmtStatsAddTime(STMT_PHASE_DISPATCH, starttime);
+
+				if (queryDesc->showstatctx)
+				{
+					instr_time	endtime;
+
+					INSTR_TIME_SET_CURRENT(endtime);
+					INSTR_TIME_SUBTRACT(endtime, starttime);
+
+					cdbexplain_recordGangAllocTime(queryDesc->showstatctx,
+												   INSTR_TIME_GET_DOUBLE(endtime));
+				}
 			}
 		}
 
@@ -635,6 +670,8 @@ ExecutorStart(QueryDesc *queryDesc, int eflags)
 		 */
 		if (shouldDispatch)
 		{
+			instr_time	starttime;
+
 			/*
 			 * MPP-2869: preprocess_initplans() may
 			 * dispatch. (interacted with MPP-2859, which caused an
@@ -673,7 +710,9 @@ ExecutorStart(QueryDesc *queryDesc, int eflags)
 			 * finish unless an error is detected before all slices have been
 			 * dispatched.
 			 */
+			INSTR_TIME_SET_CURRENT(starttime);
 			CdbDispatchPlan(queryDesc, needDtxTwoPhase, true, estate->dispatcherState);
+			StmtStatsAddTime(STMT_PHASE_DISPATCH, starttime);
 		}
 
 		/*
@@ -1047,6 +1086,9 @@ ExecutorEnd(QueryDesc *queryDesc)
 	}
 	PG_END_TRY();
 
+	QueryProgressEnd(estate);
+	QueryHistoryEnd(queryDesc);
+
     /*
      * If normal termination, let each operator clean itself up.
      * Otherwise don't risk it... an error might have left some
@@ -1054,6 +1096,10 @@ ExecutorEnd(QueryDesc *queryDesc)
      */
 	ExecEndPlan(queryDesc->planstate, estate);
 
+	/* Send the final state of the nodes that gpmon is still batching */
+	if (gp_enable_gpperfmon)
+		gpmon_flush();
+
 	WorkfileQueryspace_ReleaseEntry();
 
 	/*
@@ -1728,6 +1774,27 @@ InitPlan(QueryDesc *queryDesc, int eflags)
         /* CDB: On QD, lock whole table in S or X mode, if distributed. */
 		lockmode = rc->forUpdate ? RowExclusiveLock : RowShareLock;
 		relation = CdbOpenRelation(relid, lockmode, rc->noWait, &lockUpgraded);
+
+		/*
+		 * Tables covered by the global deadlock detector aren't upgraded for
+		 * UPDATE and DELETE, but FOR UPDATE/SHARE still locks the whole of a
+		 * distributed table on the QD.
+		 */
+		if (!lockUpgraded && rc->forUpdate &&
+			Gp_role == GP_ROLE_DISPATCH &&
+			relation->rd_cdbpolicy &&
+			relation->rd_cdbpolicy->ptype == POLICYTYPE_PARTITIONED)
+		{
+			if (!rc->noWait)
+				LockRelationOid(relid, ExclusiveLock);
+			else if (!ConditionalLockRelationOid(relid, ExclusiveLock))
+				ereport(ERROR,
+						(errcode(ERRCODE_LOCK_NOT_AVAILABLE),
+						 errmsg("could not obtain lock on relation \"%s\"",
+								RelationGetRelationName(relation))));
+			lockUpgraded = true;
+		}
+
 		if (lockUpgraded)
 		{
             heap_close(relation, NoLock);
@@ -3315,6 +3382,22 @@ ExecInsert(TupleTableSlot *slot,
 	}
 }
 
+/*
+ * A QE that finds its target row updated by a concurrent transaction can't
+ * follow the update chain with EvalPlanQual: the plan below it may hold Motion
+ * nodes, which can't be rerun for a single row. Nor can the delete half of a
+ * split update skip a row that is already gone, because the insert half has
+ * been sent to another segment regardless. Without the global deadlock
+ * detector, the ExclusiveLock taken on the QD keeps either from happening;
+ * with it, fail the statement instead, as serializable mode does.
+ */
+static bool
+ExecConcurrentUpdateNeedsError(Relation rel)
+{
+	return Gp_role == GP_ROLE_EXECUTE &&
+		CdbGlobalDeadlockDetectorCovers(RelationGetRelid(rel));
+}
+
 /* ----------------------------------------------------------------
  *		ExecDelete
  *
@@ -3499,7 +3582,9 @@ ldelete:;
 			break;
 
 		case HeapTupleUpdated:
-			if (IsXactIsoLevelSerializable)
+			if (IsXactIsoLevelSerializable ||
+				(ExecConcurrentUpdateNeedsError(resultRelationDesc) &&
+				 (isUpdate || !ItemPointerEquals(tupleid, &update_ctid))))
 				ereport(ERROR,
 						(errcode(ERRCODE_T_R_SERIALIZATION_FAILURE),
 						 errmsg("could not serialize access due to concurrent update")));
@@ -3925,7 +4010,9 @@ lreplace:;
 				break;
 
 			case HeapTupleUpdated:
-				if (IsXactIsoLevelSerializable)
+				if (IsXactIsoLevelSerializable ||
+					(ExecConcurrentUpdateNeedsError(resultRelationDesc) &&
+					 !ItemPointerEquals(tupleid, &update_ctid)))
 					ereport(ERROR,
 							(errcode(ERRCODE_T_R_SERIALIZATION_FAILURE),
 							 errmsg("could not serialize access due to concurrent update")));
@@ -109,6 +109,7 @@
 #include "executor/nodeWorktablescan.h"
 #include "miscadmin.h"
 
+#include "cdb/cdbprogress.h"
 #include "cdb/cdbvars.h"
 #include "cdb/ml_ipc.h"			/* interconnect context */
 #include "executor/nodeAssertOp.h"
@@ -130,6 +131,7 @@
 #include "executor/nodeWindow.h"
 #include "pg_trace.h"
 #include "tcop/tcopprot.h"
+#include "utils/datumstreamblock.h"
 #include "utils/debugbreak.h"
 
 #include "codegen/codegen_wrapper.h"
@@ -167,6 +169,12 @@ static void
 static void
 			EnrollProjInfoTargetList(PlanState *result, ProjectionInfo *ProjInfo);
 
+static void
+			EnrollHashJoin(PlanState *result);
+
+static void
+			EnrollAOCSScan(PlanState *result);
+
 /*
  * setSubplanSliceId
  *	 Set the slice id info for the given subplan.
@@ -232,7 +240,26 @@ ExecInitNode(Plan *node, EState *estate, int eflags)
 	StringInfo	codegenManagerName = makeStringInfo();
 
 	appendStringInfo(codegenManagerName, "%s-%d-%d", "execProcnode", node->plan_node_id, node->type);
-	void	   *CodegenManager = CodeGeneratorManagerCreate(codegenManagerName->data);
+
+	/*
+	 * Generating and compiling code only pays off for queries that process
+	 * enough rows, so decide on the estimated cost of the whole plan, which
+	 * already accounts for the rows and the per-tuple cost of the expressions.
+	 * All the nodes of a query make the same decision.
+	 */
+	void	   *CodegenManager = NULL;
+	Cost		queryCost = estate->es_plannedstmt && estate->es_plannedstmt->planTree ?
+		estate->es_plannedstmt->planTree->total_cost : node->total_cost;
+
+	if (codegen_above_cost >= 0 && queryCost >= codegen_above_cost)
+	{
+		int			optimizationLevel = CODEGEN_OPTIMIZATION_LEVEL_NONE;
+
+		if (codegen_optimize_above_cost >= 0 && queryCost >= codegen_optimize_above_cost)
+			optimizationLevel = codegen_optimization_level;
+
+		CodegenManager = CodeGeneratorManagerCreate(codegenManagerName->data, optimizationLevel);
+	}
 
 	START_CODE_GENERATOR_MANAGER(CodegenManager);
 	{
@@ -261,8 +288,9 @@ ExecInitNode(Plan *node, EState *estate, int eflags)
 	 * On master we don't do alien elimination because of EXPLAIN ANALYZE
 	 * gathering stats from all slices.
 	 */
-	bool isAlienPlanNode = !((localMotionId == parentMotionId) || (parentMotionId == UNSET_SLICE_ID) ||
-			(nodeTag(node) == T_Motion && ((Motion*)node)->motionID == localMotionId) || Gp_segment == -1);
+	bool isLocalSliceNode = (localMotionId == parentMotionId) || (parentMotionId == UNSET_SLICE_ID) ||
+			(nodeTag(node) == T_Motion && ((Motion*)node)->motionID == localMotionId);
+	bool isAlienPlanNode = !(isLocalSliceNode || Gp_segment == -1);
 
 	/* We cannot have alien nodes if we are eliminating aliens */
 	AssertImply(estate->eliminateAliens, !isAlienPlanNode);
@@ -380,8 +408,13 @@ ExecInitNode(Plan *node, EState *estate, int eflags)
 			{
 				ScanState *scanState = (ScanState *) result;
 				ProjectionInfo *projInfo = result->ps_ProjInfo;
+				/*
+				 * AOCS tables deliver virtual tuples, which the generated
+				 * slot_getattr() doesn't need to deform.
+				 */
 				if (NULL != scanState &&
-				    scanState->tableType == TableTypeHeap &&
+				    (scanState->tableType == TableTypeHeap ||
+				     scanState->tableType == TableTypeAppendOnly) &&
 				    NULL != projInfo &&
 				    projInfo->pi_isVarList &&
 				    NULL != projInfo->pi_targetlist)
@@ -389,8 +422,26 @@ ExecInitNode(Plan *node, EState *estate, int eflags)
 					enroll_ExecVariableList_codegen(ExecVariableList,
 							&projInfo->ExecVariableList_gen_info.ExecVariableList_fn, projInfo, scanState->ss_ScanTupleSlot);
 				}
+
+				/*
+				 * Enroll the qual and projection step of ExecScan, which
+				 * deforms the scan tuple once for both of them.
+				 */
+				if (NULL != scanState &&
+				    (scanState->tableType == TableTypeHeap ||
+				     scanState->tableType == TableTypeAppendOnly) &&
+				    (NULL != result->qual || NULL != projInfo))
+				{
+					enroll_ExecScanQualProject_codegen(ExecScanQualProject,
+							scanState->ExecScanQualProject_gen_info, scanState);
+				}
 			}
 
+			/*
+			 * Enroll the column readers of AOCS tables in codegen_manager
+			 */
+			EnrollAOCSScan(result);
+
 			/*
 			 * Enroll targetlist & quals' expression evaluation functions
 			 * in codegen_manager
@@ -601,6 +652,11 @@ ExecInitNode(Plan *node, EState *estate, int eflags)
 			{
 			result = (PlanState *) ExecInitHashJoin((HashJoin *) node,
 													estate, eflags);
+			/*
+			 * Enroll hash value computations and the join clauses checked
+			 * on every probe in codegen_manager
+			 */
+			EnrollHashJoin(result);
 			}
 			END_MEMORY_ACCOUNT();
 			break;
@@ -832,6 +888,10 @@ ExecInitNode(Plan *node, EState *estate, int eflags)
 	if (estate->es_instrument && result != NULL)
 		result->instrument = InstrAlloc(1);
 
+	/* Publish the progress of the nodes this process executes */
+	if (result != NULL && isLocalSliceNode)
+		result->progress = QueryProgressAddNode(result);
+
 	if (result != NULL)
 	{
 		SAVE_EXECUTOR_MEMORY_ACCOUNT(result, curMemoryAccountId);
@@ -860,7 +920,16 @@ ExecInitNode(Plan *node, EState *estate, int eflags)
 			}
 			if (!isExplainCodegenOnMaster)
 			{
-				(void) CodeGeneratorManagerPrepareGeneratedFunctions(CodegenManager);
+				/*
+				 * Compiling in the background lets execution start right
+				 * away on the regular functions; ExecProcNode() switches to
+				 * the generated ones once they are compiled.
+				 */
+				if (codegen_background_compile)
+					result->CodegenCompiling =
+						CodeGeneratorManagerPrepareGeneratedFunctionsInBackground(CodegenManager);
+				else
+					(void) CodeGeneratorManagerPrepareGeneratedFunctions(CodegenManager);
 			}
 		}
 	}
@@ -950,6 +1019,120 @@ EnrollProjInfoTargetList(PlanState *result, ProjectionInfo *ProjInfo)
 }
 
 
+/* ----------------------------------------------------------------
+ *	  EnrollHashJoin
+ *
+ *	  Enroll the hash value computation of both sides of a HashJoin, and
+ *	  the join clauses it checks for every tuple of a probed bucket, to
+ *	  Codegen
+ * ----------------------------------------------------------------
+ */
+void
+EnrollHashJoin(PlanState *result)
+{
+#ifdef USE_CODEGEN
+	if (NULL == result)
+	{
+		return;
+	}
+
+	HashJoinState *hjstate = (HashJoinState *) result;
+	HashState  *hashState = (HashState *) innerPlanState(hjstate);
+	ListCell   *l;
+
+	enroll_ExecHashGetHashValue_codegen(ExecHashGetHashValue,
+										hjstate->ExecHashGetHashValue_gen_info,
+										hjstate->hj_OuterHashKeys,
+										hjstate->hj_HashOperators,
+										true,
+										result->ps_ExprContext);
+	enroll_ExecHashGetHashValue_codegen(ExecHashGetHashValue,
+										hashState->ExecHashGetHashValue_gen_info,
+										hashState->hashkeys,
+										hjstate->hj_HashOperators,
+										false,
+										hashState->ps.ps_ExprContext);
+
+	foreach(l, hjstate->hashqualclauses)
+	{
+		ExprState  *exprstate = (ExprState *) lfirst(l);
+
+		enroll_ExecEvalExpr_codegen(exprstate->evalfunc,
+									&exprstate->evalfunc,
+									exprstate,
+									result->ps_ExprContext,
+									result);
+	}
+#endif
+}
+
+/* ----------------------------------------------------------------
+ *	  EnrollAOCSScan
+ *
+ *	  Enroll the batch decoding of the columns of an AOCS table, one
+ *	  generator per datum length passed by value, to Codegen
+ * ----------------------------------------------------------------
+ */
+void
+EnrollAOCSScan(PlanState *result)
+{
+#ifdef USE_CODEGEN
+	if (NULL == result)
+	{
+		return;
+	}
+
+	TableScanState *node = (TableScanState *) result;
+	TupleDesc	tupdesc;
+	bool		enrolled[NUM_DATUMSTREAM_GET_BATCH_LENGTHS] = {false};
+	int			i;
+
+	if (node->ss.tableType != TableTypeAOCS)
+	{
+		return;
+	}
+
+	tupdesc = RelationGetDescr(node->ss.ss_currentRelation);
+	for (i = 0; i < tupdesc->natts; i++)
+	{
+		Form_pg_attribute attr = tupdesc->attrs[i];
+		int			idx;
+
+		if (!attr->attbyval)
+		{
+			continue;
+		}
+
+		switch (attr->attlen)
+		{
+			case 1:
+				idx = 0;
+				break;
+			case 2:
+				idx = 1;
+				break;
+			case 4:
+				idx = 2;
+				break;
+			case 8:
+				idx = 3;
+				break;
+			default:
+				continue;
+		}
+
+		if (!enrolled[idx])
+		{
+			enroll_DatumStreamBlockReadGetBatch_codegen(DatumStreamBlockRead_GetBatch,
+														node->DatumStreamBlockReadGetBatch_gen_info[idx],
+														attr->attlen);
+			enrolled[idx] = true;
+		}
+	}
+#endif
+}
+
+
 /* ----------------------------------------------------------------
  *		ExecSliceDependencyNode
  *
@@ -1030,6 +1213,10 @@ ExecProcNode(PlanState *node)
 	if (node->chgParam != NULL) /* something changed */
 		ExecReScan(node, NULL); /* let ReScan handle this */
 
+	if (node->CodegenCompiling)
+		node->CodegenCompiling =
+			CodeGeneratorManagerPollGeneratedFunctions(node->CodegenManager);
+
 	if (node->instrument)
 		InstrStartNode(node->instrument);
 
@@ -1217,6 +1404,9 @@ ExecProcNode(PlanState *node)
 	if (node->instrument)
 		InstrStopNode(node->instrument, TupIsNull(result) ? 0.0 : 1.0);
 
+	if (node->progress && !TupIsNull(result))
+		node->progress->tuples++;
+
 	if (node->plan)
 		TRACE_POSTGRESQL_EXECPROCNODE_EXIT(Gp_segment, currentSliceId, nodeTag(node), node->plan->plan_node_id);
 
@@ -1285,6 +1475,10 @@ MultiExecProcNode(PlanState *node)
 	if (node->chgParam != NULL) /* something changed */
 		ExecReScan(node, NULL); /* let ReScan handle this */
 
+	if (node->CodegenCompiling)
+		node->CodegenCompiling =
+			CodeGeneratorManagerPollGeneratedFunctions(node->CodegenManager);
+
 	switch (nodeTag(node))
 	{
 			/*
@@ -1825,9 +2019,8 @@ ExecEndNode(PlanState *node)
 	if (codegen)
 	{
 		/*
-		 * if codegen guc is true, then assert if CodegenManager is NULL
+		 * CodegenManager is NULL for queries below codegen_above_cost
 		 */
-		Assert(NULL != node->CodegenManager);
 		CodeGeneratorManagerDestroy(node->CodegenManager);
 		node->CodegenManager = NULL;
 	}
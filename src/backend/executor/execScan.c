@@ -18,6 +18,7 @@
 #include "codegen/codegen_wrapper.h"
 
 #include "executor/executor.h"
+#include "executor/nodeHash.h"
 #include "miscadmin.h"
 #include "utils/memutils.h"
 #include "utils/debugbreak.h"
@@ -99,7 +100,7 @@ ExecScan(ScanState *node,
 	 * If we have neither a qual to check nor a projection to do, just skip
 	 * all the overhead and return the raw scan tuple.
 	 */
-	if (!qual && !projInfo)
+	if (!qual && !projInfo && !node->ss_runtimeFilter)
 		return (*accessMtd) (node);
 
 	/*
@@ -143,6 +144,31 @@ ExecScan(ScanState *node,
 		 */
 		econtext->ecxt_scantuple = slot;
 
+		/*
+		 * CDB: drop the tuple early if the hash join above us says it can't
+		 * find a match.
+		 */
+		if (node->ss_runtimeFilter &&
+			!ExecHashRuntimeFilterCheck(node->ss_runtimeFilter, slot, econtext))
+		{
+			ResetExprContext(econtext);
+			continue;
+		}
+
+		/*
+		 * The access method may have checked the quals already, a batch of
+		 * tuples at a time.
+		 */
+		if (node->ss_qualsChecked)
+		{
+			if (projInfo)
+			{
+				ExecProject(projInfo, NULL);
+				return projInfo->pi_slot;
+			}
+			return slot;
+		}
+
 		/*
 		 * check that the current tuple satisfies the qual-clause
 		 *
@@ -150,26 +176,13 @@ ExecScan(ScanState *node,
 		 * when the qual is nil ... saves only a few cycles, but they add up
 		 * ...
 		 */
-		if (!qual || ExecQual(qual, econtext, false))
+		if (call_ExecScanQualProject(node->ExecScanQualProject_gen_info, node))
 		{
 			/*
-			 * Found a satisfactory scan tuple.
+			 * Found a satisfactory scan tuple. Return the projection tuple
+			 * if we're projecting, else the scan tuple.
 			 */
-			if (projInfo)
-			{
-				/*
-				 * Form a projection tuple, store it in the result tuple slot
-				 * and return it.
-				 */
-				return ExecProject(projInfo, NULL);
-			}
-			else
-			{
-				/*
-				 * Here, we aren't projecting, so just return scan tuple.
-				 */
-				return slot;
-			}
+			return projInfo ? projInfo->pi_slot : slot;
 		}
 
 		/*
@@ -179,6 +192,38 @@ ExecScan(ScanState *node,
 	}
 }
 
+/*
+ * ExecScanQualProject
+ *		Check the current scan tuple of the expression context against the
+ *		quals of the node, and form the projection tuple in the result slot
+ *		if it satisfies them.
+ *
+ * Returns false if the tuple fails the quals.  This is the per-tuple work of
+ * ExecScan that codegen fuses with deforming the scan tuple.
+ */
+bool
+ExecScanQualProject(ScanState *node)
+{
+	List	   *qual = node->ps.qual;
+	ProjectionInfo *projInfo = node->ps.ps_ProjInfo;
+
+	/*
+	 * check for non-nil qual here to avoid a function call to ExecQual()
+	 * when the qual is nil ... saves only a few cycles, but they add up
+	 * ...
+	 */
+	if (qual && !ExecQual(qual, node->ps.ps_ExprContext, false))
+		return false;
+
+	/*
+	 * Form a projection tuple and store it in the result tuple slot.
+	 */
+	if (projInfo)
+		ExecProject(projInfo, NULL);
+
+	return true;
+}
+
 /*
  * ExecAssignScanProjectionInfo
  *		Set up projection info for a scan node, if necessary.
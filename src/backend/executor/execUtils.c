@@ -1395,6 +1395,7 @@ InitSliceTable(EState *estate, int nMotions, int nSubplans)
 		slice->numGangMembersToBeActive = 0;
 		slice->directDispatch.isDirectDispatch = false;
 		slice->directDispatch.contentIds = NIL;
+		slice->directDispatch.paramKeys = NIL;
 		slice->primaryGang = NULL;
 		slice->parentIndex = -1;
 		slice->children = NIL;
@@ -1492,6 +1493,9 @@ sliceCalculateNumSendingProcesses(Slice *slice)
  * which we represent as
  *
  *	  (gangType, gangSize) =  <GANGTYPE_PRIMARY_WRITER, N>
+ *
+ * The root slice of a PARALLEL RETRIEVE cursor runs on a primary reader
+ * gang, whose members send the rows to their endpoints.
  */
 void
 InitRootSlices(QueryDesc *queryDesc)
@@ -1519,6 +1523,13 @@ InitRootSlices(QueryDesc *queryDesc)
 						slice->gangSize = getgpsegmentCount();
 						slice->numGangMembersToBeActive = sliceCalculateNumSendingProcesses(slice);
 					}
+					else if (queryDesc->plannedstmt->parallelRetrieveToken != NULL)
+					{
+						/* PARALLEL RETRIEVE cursor: send to the endpoints */
+						slice->gangType = GANGTYPE_PRIMARY_READER;
+						slice->gangSize = getgpsegmentCount();
+						slice->numGangMembersToBeActive = sliceCalculateNumSendingProcesses(slice);
+					}
 					break;
 
 				case CMD_INSERT:
@@ -1648,19 +1659,19 @@ AssignGangs(QueryDesc *queryDesc)
 	if (inv.numNgangs > 0)
 	{
 		inv.vecNgangs = (Gang **) palloc(sizeof(Gang *) * inv.numNgangs);
-		for (i = 0; i < inv.numNgangs; i++)
+		i = 0;
+		if (!queryDesc->extended_query)
 		{
-			if (i == 0 && !queryDesc->extended_query)
-			{
-				inv.vecNgangs[i] = AllocateWriterGang();
+			inv.vecNgangs[i++] = AllocateWriterGang();
 
-				Assert(inv.vecNgangs[i] != NULL);
-			}
-			else
-			{
-				inv.vecNgangs[i] = AllocateReaderGang(GANGTYPE_PRIMARY_READER, queryDesc->portal_name);
-			}
+			Assert(inv.vecNgangs[0] != NULL);
 		}
+
+		/* Set up all the reader gangs we're missing at once. */
+		PrewarmReaderGangs(inv.numNgangs - i);
+
+		for (; i < inv.numNgangs; i++)
+			inv.vecNgangs[i] = AllocateReaderGang(GANGTYPE_PRIMARY_READER, queryDesc->portal_name);
 	}
 	if (inv.num1gangs_primary_reader > 0)
 	{
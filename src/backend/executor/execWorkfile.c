@@ -22,6 +22,7 @@
 #include "storage/bfz.h"
 #include "executor/execWorkfile.h"
 #include "miscadmin.h"
+#include "pgstat.h"
 #include "cdb/cdbvars.h"
 #include "utils/workfile_mgr.h"
 #include "utils/memutils.h"
@@ -219,6 +220,8 @@ ExecWorkFile_Write(ExecWorkFile *workfile,
 		workfile_mgr_report_error();
 	}
 
+	pgstat_report_wait_start(WAIT_EVENT_WORKFILE_WRITE);
+
 	switch(workfile->fileType)
 	{
 		case BUFFILE:
@@ -282,6 +285,8 @@ ExecWorkFile_Write(ExecWorkFile *workfile,
 			insist_log(false, "invalid work file type: %d", workfile->fileType);
 	}
 
+	pgstat_report_wait_end();
+
 	return true;
 }
 
@@ -302,7 +307,9 @@ ExecWorkFile_Read(ExecWorkFile *workfile,
 {
 	Assert(workfile != NULL);
 	uint64 bytes = 0;
-	
+
+	pgstat_report_wait_start(WAIT_EVENT_WORKFILE_READ);
+
 	switch(workfile->fileType)
 	{
 		case BUFFILE:
@@ -315,7 +322,9 @@ ExecWorkFile_Read(ExecWorkFile *workfile,
 		default:
 			insist_log(false, "invalid work file type: %d", workfile->fileType);
 	}
-	
+
+	pgstat_report_wait_end();
+
 	return bytes;
 }
 
@@ -730,8 +739,10 @@ ExecWorkFile_AdjustBFZSize(ExecWorkFile *workfile, int64 file_size)
 		/* Actual file on disk is bigger than expected. This can happen when:
 		 *  - added checksums to an uncompressed file
 		 *  - closing empty or very small compressed file (zlib header overhead larger than saved space)
+		 *  - compressing data that doesn't shrink (lz4 stores such blocks as
+		 *    they are, plus a frame header)
 		 */
-		Assert( (bfz_file->has_checksum && bfz_file->compression_index == 0) || (bfz_file->compression_index > 0 && workfile->size < BFZ_BUFFER_SIZE));
+		Assert( (bfz_file->has_checksum && bfz_file->compression_index == 0) || bfz_file->compression_index > 0);
 
 		/*
 		 * If we're already under disk full, don't try to reserve, as it will
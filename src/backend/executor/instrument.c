@@ -17,6 +17,7 @@
 
 #include <unistd.h>
 
+#include "cdb/cdbvars.h"
 #include "executor/instrument.h"
 
 
@@ -32,10 +33,28 @@ InstrAlloc(int n)
 	return instr;
 }
 
-/* Entry to a plan node */
+/*
+ * Entry to a plan node
+ *
+ * Reading the clock twice per tuple can cost more than the node's own work.
+ * With gp_explain_analyze_timing_sample = N > 1, the first N calls of each
+ * cycle are timed, then only one call in N; InstrEndLoop extrapolates the
+ * rest. The first call is always timed, so the startup time is exact.
+ */
 void
 InstrStartNode(Instrumentation *instr)
 {
+	instr->ncalls++;
+
+	if (gp_explain_analyze_timing_sample > 1 &&
+		instr->ncalls > gp_explain_analyze_timing_sample &&
+		instr->ncalls % gp_explain_analyze_timing_sample != 0)
+	{
+		instr->untimed = true;
+		return;
+	}
+	instr->untimed = false;
+
 	if (INSTR_TIME_IS_ZERO(instr->starttime))
 		INSTR_TIME_SET_CURRENT(instr->starttime);
 	else
@@ -51,6 +70,12 @@ InstrStopNode(Instrumentation *instr, double nTuples)
 	/* count the returned tuples */
 	instr->tuplecount += nTuples;
 
+	if (instr->untimed)
+	{
+		instr->untimed = false;
+		return;
+	}
+
 	if (INSTR_TIME_IS_ZERO(instr->starttime))
 	{
 		elog(DEBUG2, "InstrStopNode called without start");
@@ -59,6 +84,7 @@ InstrStopNode(Instrumentation *instr, double nTuples)
 
 	INSTR_TIME_SET_CURRENT(endtime);
 	INSTR_TIME_ACCUM_DIFF(instr->counter, endtime, instr->starttime);
+	instr->ntimed++;
 
 	/* Is this the first tuple of this cycle? */
 	if (!instr->running)
@@ -88,6 +114,16 @@ InstrEndLoop(Instrumentation *instr)
 	/* Accumulate per-cycle statistics into totals */
 	totaltime = INSTR_TIME_GET_DOUBLE(instr->counter);
 
+	/*
+	 * If only some calls were timed, assume the untimed ones took as long
+	 * as the timed ones, leaving out the first call, which usually does the
+	 * node's startup work.
+	 */
+	if (instr->ntimed > 1 && instr->ncalls > instr->ntimed)
+		totaltime = instr->firsttuple +
+			(totaltime - instr->firsttuple) *
+			(double) (instr->ncalls - 1) / (double) (instr->ntimed - 1);
+
 	/* CDB: Report startup time from only the first cycle. */
 	if (instr->nloops == 0)
 		instr->startup = instr->firsttuple;
@@ -102,4 +138,7 @@ InstrEndLoop(Instrumentation *instr)
 	INSTR_TIME_SET_ZERO(instr->counter);
 	instr->firsttuple = 0;
 	instr->tuplecount = 0;
+	instr->ncalls = 0;
+	instr->ntimed = 0;
+	instr->untimed = false;
 }
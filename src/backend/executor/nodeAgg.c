@@ -154,6 +154,7 @@ static bool find_unaggregated_cols_walker(Node *node, Bitmapset **colnos);
 static void clear_agg_object(AggState *aggstate);
 static TupleTableSlot *agg_retrieve_direct(AggState *aggstate);
 static TupleTableSlot *agg_retrieve_hash_table(AggState *aggstate);
+static TupleTableSlot *agg_retrieve_passthrough(AggState *aggstate);
 static void ExecAggExplainEnd(PlanState *planstate, struct StringInfoData *buf);
 static int count_extra_agg_slots(Node *node);
 static bool count_extra_agg_slots_walker(Node *node, int *count);
@@ -968,7 +969,8 @@ ExecAgg(AggState *node)
 		 */
 		for (;;)
 		{
-			if (!node->hhashtable->is_spilling)
+			if (!node->hhashtable->is_spilling &&
+				node->hashaggstatus != HASHAGG_PASSTHROUGH)
 			{
 				tuple = agg_retrieve_hash_table(node);
 				node->agg_done = false; /* Not done 'til batches used up. */
@@ -1004,10 +1006,23 @@ ExecAgg(AggState *node)
 
 				case HASHAGG_STREAMING:
 					Assert(streaming);
+					if (node->hhashtable->passthrough)
+					{
+						node->hashaggstatus = HASHAGG_PASSTHROUGH;
+						continue;
+					}
 					if (!agg_hash_stream(node))
 						node->hashaggstatus = HASHAGG_END_OF_PASSES;
 					continue;
 
+				case HASHAGG_PASSTHROUGH:
+					Assert(streaming);
+					tuple = agg_retrieve_passthrough(node);
+					if (tuple != NULL)
+						return tuple;
+					node->hashaggstatus = HASHAGG_END_OF_PASSES;
+					continue;
+
 				case HASHAGG_BEFORE_FIRST_PASS:
 				default:
 					elog(ERROR, "hybrid hash aggregation sequencing error");
@@ -1489,6 +1504,81 @@ agg_retrieve_direct(AggState *aggstate)
 	return NULL;
 }
 
+/*
+ * ExecAgg for the pass-through mode of a streaming hashed aggregation:
+ * turn the next input tuple into a partial group of its own.
+ *
+ * agg_hash_initial_pass switches to this mode when local aggregation is
+ * found not to reduce the rows.  The hash table is empty by then; its
+ * memory pool holds the by-ref transition values, and is reset once it
+ * has grown a little, since each group is done with by the next call.
+ */
+static TupleTableSlot *
+agg_retrieve_passthrough(AggState *aggstate)
+{
+	Agg		   *node = (Agg *) aggstate->ss.ps.plan;
+	HashAggTable *hashtable = aggstate->hhashtable;
+	ExprContext *econtext = aggstate->ss.ps.ps_ExprContext;
+	ExprContext *tmpcontext = aggstate->tmpcontext;
+	AggStatePerGroup pergroup;
+	TupleTableSlot *outerslot;
+	int			aggno;
+
+	Assert(hashtable->num_entries == 0);
+
+	if (aggstate->pergroup == NULL)
+		aggstate->pergroup = (AggStatePerGroup)
+			MemoryContextAllocZero(aggstate->aggcontext,
+								   sizeof(AggStatePerGroupData) * aggstate->numaggs);
+	pergroup = aggstate->pergroup;
+
+	if (hashtable->prev_slot != NULL)
+	{
+		outerslot = hashtable->prev_slot;
+		hashtable->prev_slot = NULL;
+	}
+	else
+		outerslot = ExecProcNode(outerPlanState(aggstate));
+
+	if (TupIsNull(outerslot))
+		return NULL;
+
+	Gpmon_Incr_Rows_In(GpmonPktFromAggState(aggstate));
+
+	if (mpool_bytes_used(hashtable->group_buf) > BLCKSZ * 8)
+		mpool_reset(hashtable->group_buf);
+
+	/*
+	 * The transition values live in the memory pool, so don't let
+	 * initialize_aggregates pfree the previous row's values.
+	 */
+	MemSet(pergroup, 0, sizeof(AggStatePerGroupData) * aggstate->numaggs);
+	initialize_aggregates(aggstate, aggstate->peragg, pergroup,
+						  &(aggstate->mem_manager));
+
+	tmpcontext->ecxt_outertuple = outerslot;
+	call_AdvanceAggregates(aggstate, pergroup, &(aggstate->mem_manager));
+	ResetExprContext(tmpcontext);
+
+	ResetExprContext(econtext);
+	for (aggno = 0; aggno < aggstate->numaggs; aggno++)
+		finalize_aggregate(aggstate, &aggstate->peragg[aggno], &pergroup[aggno],
+						   &econtext->ecxt_aggvalues[aggno],
+						   &econtext->ecxt_aggnulls[aggno]);
+
+	/* The input tuple stands in for the group's representative tuple */
+	econtext->ecxt_outertuple = outerslot;
+	econtext->group_id = node->rollupGSTimes;
+	econtext->grouping = node->grouping;
+
+	hashtable->num_tuples++;
+	hashtable->num_passthrough_tuples++;
+
+	Gpmon_Incr_Rows_Out(GpmonPktFromAggState(aggstate));
+	CheckSendPlanStateGpmonPkt(&aggstate->ss.ps);
+	return ExecProject(aggstate->ss.ps.ps_ProjInfo, NULL);
+}
+
 /*
  * ExecAgg for hashed case: retrieve groups from hash table
  */
@@ -2463,6 +2553,11 @@ ExecReScanAgg(AggState *node, ExprContext *exprCtxt)
 		MemSet(node->pergroup, 0,
 			   sizeof(AggStatePerGroupData) * node->numaggs);
 	}
+	else
+	{
+		/* A pass-through pergroup was allocated in the aggcontext */
+		node->pergroup = NULL;
+	}
 
 	if (((Agg *) node->ss.ps.plan)->inputHasGrouping)
 	{
@@ -2858,4 +2953,7 @@ ExecEagerFreeAgg(AggState *node)
 		pfree(node->grp_firstTuple);
 		node->grp_firstTuple = NULL;
 	}
+
+	/* Give our quota to the operators that still run */
+	MemoryAccounting_RelinquishQuota(node->ss.ps.plan->memoryAccountId);
 }
@@ -232,6 +232,8 @@ BitmapHeapNext(BitmapHeapScanState *node)
 				break;
 			}
 
+			bitprefetch(scan, tbm);
+
 			/*
 			 * Ignore any claimed entries past what we think is the end of
 			 * the relation.  (This is probably not necessary given that we
@@ -334,6 +336,40 @@ BitmapHeapNext(BitmapHeapScanState *node)
 	return ExecClearTuple(slot);
 }
 
+/*
+ * bitprefetch - subroutine for BitmapHeapNext()
+ *
+ * Called each time the scan moves to the next page of the bitmap, to keep
+ * effective_io_concurrency pages of the bitmap prefetched ahead of it.
+ */
+void
+bitprefetch(HeapScanDesc scan, Node *tbm)
+{
+	BlockNumber blockno;
+
+	if (effective_io_concurrency <= 0)
+		return;
+
+	/*
+	 * The page just reached was prefetched already, unless the prefetch
+	 * cursor has run out of pages ahead; then keep it in step.
+	 */
+	if (scan->rs_prefetch_pages > 0)
+		scan->rs_prefetch_pages--;
+	else if (!tbm_prefetch_next(tbm, &blockno))
+		return;
+
+	while (scan->rs_prefetch_pages < effective_io_concurrency)
+	{
+		if (!tbm_prefetch_next(tbm, &blockno))
+			break;
+		scan->rs_prefetch_pages++;
+
+		if (blockno < scan->rs_nblocks)
+			PrefetchBuffer(scan->rs_rd, blockno);
+	}
+}
+
 /*
  * bitgetpage - subroutine for BitmapHeapNext()
  *
@@ -204,6 +204,7 @@ ExecInitExternalScan(ExternalScan *node, EState *estate, int eflags)
 	ExternalScanState *externalstate;
 	Relation	currentRelation;
 	FileScanDesc currentScanDesc;
+	bool	   *proj;
 
 	Assert(outerPlan(node) == NULL);
 	Assert(innerPlan(node) == NULL);
@@ -250,6 +251,21 @@ ExecInitExternalScan(ExternalScan *node, EState *estate, int eflags)
 	 */
 	currentRelation = ExecOpenScanExternalRelation(estate, node->scan.scanrelid);
 
+	/*
+	 * Obtain the projection.  The check constraints of an external partition
+	 * are checked on the scan tuple, so then every column is needed.
+	 */
+	proj = NULL;
+	if (gp_external_projection &&
+		(currentRelation->rd_att->constr == NULL ||
+		 currentRelation->rd_att->constr->num_check == 0))
+	{
+		int			natts = currentRelation->rd_att->natts;
+
+		proj = (bool *) palloc0(sizeof(bool) * natts);
+		GetNeededColumnsForScan((Node *) node->scan.plan.targetlist, proj, natts);
+		GetNeededColumnsForScan((Node *) node->scan.plan.qual, proj, natts);
+	}
 
 	currentScanDesc = external_beginscan(currentRelation,
 									 node->scan.scanrelid,
@@ -261,7 +277,9 @@ ExecInitExternalScan(ExternalScan *node, EState *estate, int eflags)
 									 node->rejLimit,
 									 node->rejLimitInRows,
 									 node->fmterrtbl,
-									 node->encoding);
+									 node->encoding,
+									 proj,
+									 node->scan.plan.qual);
 
 	externalstate->ss.ss_currentRelation = currentRelation;
 	externalstate->ess_ScanDesc = currentScanDesc;
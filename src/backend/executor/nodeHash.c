@@ -25,6 +25,7 @@
 
 #include <math.h>
 #include <limits.h>
+#include <pthread.h>
 
 #include "access/hash.h"
 #include "commands/tablespace.h"
@@ -34,14 +35,20 @@
 #include "executor/nodeHash.h"
 #include "executor/nodeHashjoin.h"
 #include "miscadmin.h"
+#include "nodes/nodeFuncs.h"
 #include "parser/parse_expr.h"
+#include "parser/parsetree.h"
 #include "utils/dynahash.h"
 #include "utils/memutils.h"
 #include "utils/lsyscache.h"
+#include "utils/resgroup.h"
 #include "utils/debugbreak.h"
 #include "utils/faultinjector.h"
 
 #include "cdb/cdbexplain.h"
+#include "cdb/cdbgang.h"		/* gp_pthread_create */
+#include "cdb/cdbhostarena.h"
+#include "cdb/cdbqueryhistory.h"
 #include "cdb/cdbvars.h"
 
 static void ExecHashIncreaseNumBatches(HashJoinTable hashtable);
@@ -53,6 +60,66 @@ ExecHashTableExplainBatches(HashJoinTable   hashtable,
                             int             ibatch_end,
                             const char     *title);
 static void ExecHashTableReallocBatchData(HashJoinTable hashtable, int new_nbatch);
+static HashRuntimeFilter *ExecHashRuntimeFilterCreate(HashJoinTable hashtable,
+							HashJoinState *hjstate, double ntuples);
+static void ExecHashRuntimeFilterAdd(HashRuntimeFilter *filter, uint32 hashvalue);
+static void ExecHashTableLinkPending(HashJoinTable hashtable);
+static void ExecHashTableSetupDedup(HashJoinTable hashtable, HashState *hashState,
+						HashJoinState *hjstate, List *hashOperators);
+static bool ExecHashTableIsDuplicate(HashState *hashState, HashJoinTable hashtable,
+						 TupleTableSlot *slot, uint32 hashvalue);
+static void ExecHashTableShareBroadcast(HashState *node, HashJoinTable hashtable);
+
+/*
+ * Runtime filter sizing.  We aim for HRF_BITS_PER_TUPLE bits per inner tuple,
+ * which with HRF_NHASHES bits set per tuple passes about 2% of the rows that
+ * have no match.  If the planner underestimated the inner side so badly that
+ * there are fewer than HRF_MIN_BITS_PER_TUPLE bits per tuple, the filter is
+ * not used at all.  Once the scan has checked HRF_SAMPLE_TUPLES rows, the
+ * filter is turned off if it rejected less than HRF_MIN_REJECT_RATIO of
+ * them; most of the outer side then has matches and checking is a waste.
+ */
+#define HRF_BITS_PER_TUPLE		16
+#define HRF_MIN_BITS_PER_TUPLE	4
+#define HRF_NHASHES				3
+#define HRF_MIN_BITS			((uint32) 1 << 13)
+#define HRF_MAX_BITS			((uint32) 1 << 26)	/* 8 MB */
+#define HRF_SAMPLE_TUPLES		65536
+#define HRF_MIN_REJECT_RATIO	0.1
+
+/*
+ * Threaded build.  Pending tuples are linked in bulk once HJ_PENDING_MAX of
+ * them have been collected, or when the bucket chains are needed.  Threads
+ * are only started for at least HJ_THREADED_MIN_TUPLES tuples; below that,
+ * starting them costs more than it saves.
+ */
+#define HJ_PENDING_MAX			(1 << 20)
+#define HJ_THREADED_MIN_TUPLES	65536
+
+/*
+ * A build worker's share of the work: the buckets lo .. hi - 1.  The
+ * worker functions run in threads other than the backend's, so they must
+ * not palloc, elog or look at anything but their HashBuildWorker and the
+ * arrays it points to.
+ */
+typedef struct HashBuildWorker
+{
+	HashJoinTable hashtable;
+	int			lo;
+	int			hi;
+	uint32		ntuples;		/* compaction: tuples in lo .. hi - 1 */
+	uint32		base;			/* compaction: position of bucket lo */
+	void	   *(*fn) (void *);	/* what a worker thread runs */
+} HashBuildWorker;
+
+static int ExecHashBuildWorkers(HashJoinTable hashtable, double ntuples,
+					 HashBuildWorker **workers);
+static void ExecHashRunWorkers(HashBuildWorker *workers, int nworkers,
+				   void *(*fn) (void *));
+static void *ExecHashWorkerThread(void *arg);
+static void *ExecHashLinkWorker(void *arg);
+static void *ExecHashCompactCountWorker(void *arg);
+static void *ExecHashCompactFillWorker(void *arg);
 
 void ExecChooseHashTableSize(double ntuples, int tupwidth,
 						int *numbuckets,
@@ -131,8 +198,9 @@ MultiExecHash(HashState *node)
 		econtext->ecxt_innertuple = slot;
 		bool hashkeys_null = false;
 
-		if (ExecHashGetHashValue(node, hashtable, econtext, hashkeys, false,
-								 node->hs_keepnull, &hashvalue, &hashkeys_null))
+		if (call_ExecHashGetHashValue(node->ExecHashGetHashValue_gen_info,
+									  node, hashtable, econtext, hashkeys, false,
+									  node->hs_keepnull, &hashvalue, &hashkeys_null))
 		{
 			ExecHashTableInsert(node, hashtable, slot, hashvalue);
 		}
@@ -152,6 +220,11 @@ MultiExecHash(HashState *node)
 	/* Now we have set up all the initial batches & primary overflow batches. */
 	hashtable->nbatch_outstart = hashtable->nbatch;
 
+	ExecHashTableCompact(hashtable);
+
+	if (gp_hashjoin_share_broadcast)
+		ExecHashTableShareBroadcast(node, hashtable);
+
 	/* must provide our own instrumentation support */
 	if (node->ps.instrument)
 		InstrStopNode(node->ps.instrument, hashtable->totalTuples);
@@ -329,6 +402,19 @@ ExecHashTableCreate(HashState *hashState, HashJoinState *hjstate, List *hashOper
 	hashtable->eagerlyReleased = false;
 	hashtable->hjstate = hjstate;
 	hashtable->first_pass = true;
+	hashtable->compactBuckets = gp_hashjoin_compact_buckets;
+	hashtable->compactTupleSpace = gp_hashjoin_compact_buckets ?
+		sizeof(uint32) + sizeof(HashJoinTuple) : 0;
+	hashtable->compactStart = NULL;
+	hashtable->buildThreads = gp_hashjoin_build_threads;
+	hashtable->pendingTupleSpace = gp_hashjoin_build_threads > 0 ?
+		sizeof(HashJoinPending) : 0;
+	hashtable->pendingTuples = NULL;
+	hashtable->npending = 0;
+	hashtable->maxpending = 0;
+	hashtable->dedupInner = false;
+	hashtable->ndupsDropped = 0;
+	hashtable->hostArena = NULL;
 
 	/*
 	 * Get info about the hash functions to be used for each hash key. Also
@@ -356,6 +442,9 @@ ExecHashTableCreate(HashState *hashState, HashJoinState *hjstate, List *hashOper
 		i++;
 	}
 
+	if (gp_hashjoin_dedup_inner)
+		ExecHashTableSetupDedup(hashtable, hashState, hjstate, hashOperators);
+
 	/*
 	 * Create temporary memory contexts in which to keep the hashtable working
 	 * storage.  See notes in executor/hashjoin.h.
@@ -372,6 +461,11 @@ ExecHashTableCreate(HashState *hashState, HashJoinState *hjstate, List *hashOper
 												ALLOCSET_DEFAULT_INITSIZE,
 												ALLOCSET_DEFAULT_MAXSIZE);
 
+	hashtable->tupleCxt = BumpContextCreate(hashtable->batchCxt,
+											"HashTupleContext",
+											ALLOCSET_DEFAULT_INITSIZE,
+											ALLOCSET_DEFAULT_MAXSIZE);
+
 	/* CDB */ /* track temp buf file allocations in separate context */
 	hashtable->bfCxt = AllocSetContextCreate(CurrentMemoryContext,
 											 "hbbfcxt",
@@ -429,6 +523,13 @@ ExecHashTableCreate(HashState *hashState, HashJoinState *hjstate, List *hashOper
 	if(gp_hashjoin_bloomfilter!=0)
 		hashtable->bloom = (uint64*) palloc0(nbuckets * sizeof(uint64));
 
+	/* The runtime filter lives as long as the hash table. */
+	MemoryContextSwitchTo(hashtable->hashCxt);
+
+	if (gp_hashjoin_runtime_filter)
+		hashtable->runtimeFilter =
+			ExecHashRuntimeFilterCreate(hashtable, hjstate, outerNode->plan_rows);
+
 	MemoryContextSwitchTo(oldcxt);
 	}
 	END_MEMORY_ACCOUNT();
@@ -690,6 +791,8 @@ ExecHashTableDestroy(HashState *hashState, HashJoinTable hashtable)
 		}
 	}
 
+	QueryHistoryCountHashJoinBatches(hashtable->nbatch);
+
 	/* Close state file as well */
 	if (hashtable->state_file != NULL)
 	{
@@ -703,6 +806,19 @@ ExecHashTableDestroy(HashState *hashState, HashJoinTable hashtable)
 		hashtable->work_set = NULL;
 	}
 
+	/* The runtime filter goes away with hashCxt. */
+	if (hashtable->runtimeFilterTarget != NULL)
+		hashtable->runtimeFilterTarget->ss_runtimeFilter = NULL;
+	hashtable->runtimeFilterTarget = NULL;
+	hashtable->runtimeFilter = NULL;
+
+	if (hashtable->hostArena != NULL)
+	{
+		hashtable->compactStart = NULL;
+		HostArenaDetach(hashtable->hostArena);
+		hashtable->hostArena = NULL;
+	}
+
 	/* Release working memory (batchCxt is a child, so it goes away too) */
 	MemoryContextDelete(hashtable->hashCxt);
 	hashtable->batches = NULL;
@@ -726,6 +842,7 @@ ExecHashIncreaseNumBatches(HashJoinTable hashtable)
 	long		ninmemory;
 	long		nfreed;
 	Size		spaceFreed = 0;
+	MemoryContext oldTupleCxt;
 	HashJoinTableStats *stats = hashtable->stats;
 
 	/* do nothing if we've decided to shut off growth */
@@ -739,6 +856,9 @@ ExecHashIncreaseNumBatches(HashJoinTable hashtable)
 	/* A reusable hash table can only respill during first pass */
 	AssertImply(hashtable->hjstate->reuse_hashtable, hashtable->first_pass);
 
+	/* The scan below walks the bucket chains. */
+	ExecHashTableLinkPending(hashtable);
+
 	nbatch = oldnbatch * 2;
 	Assert(nbatch > 1);
 
@@ -769,7 +889,16 @@ ExecHashIncreaseNumBatches(HashJoinTable hashtable)
 	/*
 	 * Scan through the existing hash table entries and dump out any that are
 	 * no longer of the current batch.
+	 *
+	 * The tuple context can't give back the space of single tuples, so the
+	 * tuples that stay are copied to a new one and the old one is dropped
+	 * at the end.  This briefly needs the space of the kept tuples twice.
 	 */
+	oldTupleCxt = hashtable->tupleCxt;
+	hashtable->tupleCxt = BumpContextCreate(hashtable->batchCxt,
+											"HashTupleContext",
+											ALLOCSET_DEFAULT_INITSIZE,
+											ALLOCSET_DEFAULT_MAXSIZE);
 	ninmemory = nfreed = 0;
 
 	for (i = 0; i < hashtable->nbuckets; i++)
@@ -794,8 +923,20 @@ ExecHashIncreaseNumBatches(HashJoinTable hashtable)
 			Assert(bucketno == i);
 			if (batchno == curbatch)
 			{
-				/* keep tuple */
-				prevtuple = tuple;
+				/* keep tuple, moving it to the new tuple context */
+				Size		spaceTuple;
+				HashJoinTuple copytuple;
+
+				spaceTuple = HJTUPLE_OVERHEAD + memtuple_get_size(HJTUPLE_MINTUPLE(tuple));
+				copytuple = (HashJoinTuple) MemoryContextAlloc(hashtable->tupleCxt,
+															   spaceTuple);
+				memcpy(copytuple, tuple, spaceTuple);
+				if (prevtuple)
+					prevtuple->next = copytuple;
+				else
+					hashtable->buckets[i] = copytuple;
+
+				prevtuple = copytuple;
 				bloom |= BLOOMVAL(tuple->hashvalue);
 			}
 			else
@@ -819,11 +960,11 @@ ExecHashIncreaseNumBatches(HashJoinTable hashtable)
 				hashtable->totalTuples--;
 
 				spaceTuple = HJTUPLE_OVERHEAD + memtuple_get_size(HJTUPLE_MINTUPLE(tuple));
-				spaceFreed += spaceTuple;
+				spaceFreed += spaceTuple + hashtable->compactTupleSpace +
+					hashtable->pendingTupleSpace;
 				if (stats)
 					stats->batchstats[batchno].spillspace_in += spaceTuple;
 
-				pfree(tuple);
 				nfreed++;
 			}
 
@@ -834,6 +975,8 @@ ExecHashIncreaseNumBatches(HashJoinTable hashtable)
 			hashtable->bloom[i] = bloom;
 	}
 
+	MemoryContextDelete(oldTupleCxt);
+
 #ifdef HJDEBUG
 	elog(gp_workfile_caching_loglevel, "HJ batch %d: Freed %ld of %ld tuples, %lu of %lu bytes, space now %lu",
 		 curbatch,
@@ -940,12 +1083,22 @@ ExecHashTableInsert(HashState *hashState, HashJoinTable hashtable,
 					TupleTableSlot *slot,
 					uint32 hashvalue)
 {
-	MemTuple tuple = ExecFetchSlotMemTuple(slot, false);
+	MemTuple tuple;
 	HashJoinBatchData  *batch;
 	int			bucketno;
 	int			batchno;
 	int			hashTupleSize;
 
+	/* The tuple belongs to this batch, but a copy of its keys is there. */
+	if (hashtable->dedupInner &&
+		ExecHashTableIsDuplicate(hashState, hashtable, slot, hashvalue))
+	{
+		hashtable->ndupsDropped++;
+		return true;
+	}
+
+	tuple = ExecFetchSlotMemTuple(slot, false);
+
 	START_MEMORY_ACCOUNT(hashState->ps.plan->memoryAccountId);
 	{
 	PlanState *ps = &hashState->ps;
@@ -958,7 +1111,12 @@ ExecHashTableInsert(HashState *hashState, HashJoinTable hashtable,
 
 	/* Update batch size. */
 	batch->innertuples++;
-	batch->innerspace += hashTupleSize;
+	batch->innerspace += hashTupleSize + hashtable->compactTupleSpace +
+		hashtable->pendingTupleSpace;
+
+	/* Reloading a later batch adds nothing new to the filter. */
+	if (hashtable->runtimeFilter != NULL && !hashtable->runtimeFilter->complete)
+		ExecHashRuntimeFilterAdd(hashtable->runtimeFilter, hashvalue);
 
 	/*
 	 * decide whether to put the tuple in the hash table or a temp file
@@ -970,20 +1128,60 @@ ExecHashTableInsert(HashState *hashState, HashJoinTable hashtable,
 		 */
 		HashJoinTuple hashTuple;
 
-		hashTuple = (HashJoinTuple) MemoryContextAlloc(hashtable->batchCxt,
+		hashTuple = (HashJoinTuple) MemoryContextAlloc(hashtable->tupleCxt,
 													   hashTupleSize);
 		hashTuple->hashvalue = hashvalue;
 		memcpy(HJTUPLE_MINTUPLE(hashTuple), tuple, memtuple_get_size(tuple));
-		hashTuple->next = hashtable->buckets[bucketno];
-		hashtable->buckets[bucketno] = hashTuple;
 		hashtable->totalTuples += 1;
 
-		if(gp_hashjoin_bloomfilter!=0)
-			hashtable->bloom[bucketno] |= BLOOMVAL(hashvalue);
+		/* The compact layout no longer covers the batch. */
+		hashtable->compactStart = NULL;
+
+		if (hashtable->buildThreads > 0)
+		{
+			HashJoinPending *pending;
+
+			/* Leave it to ExecHashTableLinkPending */
+			if (hashtable->npending == hashtable->maxpending)
+			{
+				if (hashtable->maxpending >= HJ_PENDING_MAX)
+					ExecHashTableLinkPending(hashtable);
+				else if (hashtable->pendingTuples == NULL)
+				{
+					hashtable->maxpending = 1024;
+					hashtable->pendingTuples = (HashJoinPending *)
+						MemoryContextAlloc(hashtable->batchCxt,
+										   hashtable->maxpending * sizeof(HashJoinPending));
+				}
+				else
+				{
+					hashtable->maxpending *= 2;
+					hashtable->pendingTuples = (HashJoinPending *)
+						repalloc(hashtable->pendingTuples,
+								 hashtable->maxpending * sizeof(HashJoinPending));
+				}
+			}
+
+			pending = &hashtable->pendingTuples[hashtable->npending++];
+			pending->tuple = hashTuple;
+			pending->bucketno = bucketno;
+		}
+		else
+		{
+			hashTuple->next = hashtable->buckets[bucketno];
+			hashtable->buckets[bucketno] = hashTuple;
+
+			if(gp_hashjoin_bloomfilter!=0)
+				hashtable->bloom[bucketno] |= BLOOMVAL(hashvalue);
+		}
 
-		/* Double the number of batches when too much data in hash table. */
+		/*
+		 * Double the number of batches when too much data in hash table, or
+		 * when the resource group memory is exhausted.
+		 */
 		if (batch->innerspace > hashtable->spaceAllowed ||
-			batch->innertuples > UINT_MAX/2)
+			batch->innertuples > UINT_MAX/2 ||
+			(hashtable->growEnabled && ResGroupConsumeSpillRequest()))
 		{
 			ExecHashIncreaseNumBatches(hashtable);
 
@@ -1015,6 +1213,779 @@ ExecHashTableInsert(HashState *hashState, HashJoinTable hashtable,
 	return (batchno == hashtable->curbatch);
 }
 
+/*
+ * Does the expression reference the inner side of a join?
+ */
+static bool
+ExecHashRefsInner_walker(Node *node, void *context)
+{
+	if (node == NULL)
+		return false;
+	if (IsA(node, Var))
+		return ((Var *) node)->varno == INNER;
+	return expression_tree_walker(node, ExecHashRefsInner_walker, context);
+}
+
+/*
+ * ExecHashTableSetupDedup
+ *		Decide whether inner tuples with duplicate keys can be dropped
+ *
+ * That is safe for a semi or anti join in which only the hash clauses look
+ * at the inner tuple: then any one tuple of a set with equal keys matches
+ * the same outer tuples as all of them.  Each hash operator must take the
+ * same type on both sides, so that it can compare two inner keys.
+ */
+static void
+ExecHashTableSetupDedup(HashJoinTable hashtable, HashState *hashState,
+						HashJoinState *hjstate, List *hashOperators)
+{
+	HashJoin   *node = (HashJoin *) hjstate->js.ps.plan;
+	int			nkeys = list_length(hashOperators);
+	ListCell   *ho;
+	int			i;
+
+	if (hjstate->js.jointype != JOIN_SEMI &&
+		hjstate->js.jointype != JOIN_ANTI &&
+		hjstate->js.jointype != JOIN_LASJ_NOTIN)
+		return;
+
+	if (node->join.joinqual != NIL || node->hashqualclauses != NIL ||
+		hjstate->hj_nonequijoin)
+		return;
+
+	if (ExecHashRefsInner_walker((Node *) node->join.plan.targetlist, NULL) ||
+		ExecHashRefsInner_walker((Node *) node->join.plan.qual, NULL))
+		return;
+
+	hashtable->inner_eqfunctions = (FmgrInfo *) palloc(nkeys * sizeof(FmgrInfo));
+	i = 0;
+	foreach(ho, hashOperators)
+	{
+		Oid			hashop = lfirst_oid(ho);
+		Oid			lefttype;
+		Oid			righttype;
+
+		op_input_types(hashop, &lefttype, &righttype);
+		if (lefttype != righttype)
+		{
+			pfree(hashtable->inner_eqfunctions);
+			hashtable->inner_eqfunctions = NULL;
+			return;
+		}
+		fmgr_info(get_opcode(hashop), &hashtable->inner_eqfunctions[i]);
+		i++;
+	}
+
+	hashtable->dedupValues = (Datum *) palloc(nkeys * sizeof(Datum));
+	hashtable->dedupSlot = MakeSingleTupleTableSlot(ExecGetResultType(&hashState->ps));
+	hashtable->dedupInner = true;
+
+	/* Duplicates are found by walking the chain, which must be complete. */
+	hashtable->buildThreads = 0;
+	hashtable->pendingTupleSpace = 0;
+}
+
+/*
+ * ExecHashTableIsDuplicate
+ *		Is a tuple with the same keys already in the current batch?
+ *
+ * Only tuples with the same hash value are compared, and the new tuple's
+ * keys are only evaluated once one is found.  Tuples with a NULL key are
+ * never duplicates.
+ */
+static bool
+ExecHashTableIsDuplicate(HashState *hashState, HashJoinTable hashtable,
+						 TupleTableSlot *slot, uint32 hashvalue)
+{
+	ExprContext *econtext = hashState->ps.ps_ExprContext;
+	TupleTableSlot *saveslot = econtext->ecxt_innertuple;
+	HashJoinTuple tuple;
+	MemoryContext oldcxt;
+	bool		evaluated = false;
+	bool		result = false;
+	int			bucketno;
+	int			batchno;
+
+	ExecHashGetBucketAndBatch(hashtable, hashvalue, &bucketno, &batchno);
+	if (batchno != hashtable->curbatch)
+		return false;
+
+	START_MEMORY_ACCOUNT(hashState->ps.plan->memoryAccountId);
+	{
+	ResetExprContext(econtext);
+	oldcxt = MemoryContextSwitchTo(econtext->ecxt_per_tuple_memory);
+
+	for (tuple = hashtable->buckets[bucketno];
+		 tuple != NULL && !result;
+		 tuple = tuple->next)
+	{
+		ListCell   *hk;
+		int			i;
+
+		if (tuple->hashvalue != hashvalue)
+			continue;
+
+		if (!evaluated)
+		{
+			bool		anynull = false;
+
+			econtext->ecxt_innertuple = slot;
+			i = 0;
+			foreach(hk, hashState->hashkeys)
+			{
+				bool		isNull;
+
+				hashtable->dedupValues[i++] =
+					ExecEvalExpr((ExprState *) lfirst(hk), econtext, &isNull, NULL);
+				if (isNull)
+					anynull = true;
+			}
+			if (anynull)
+				break;
+			evaluated = true;
+		}
+
+		ExecStoreMinimalTuple(HJTUPLE_MINTUPLE(tuple), hashtable->dedupSlot, false);
+		econtext->ecxt_innertuple = hashtable->dedupSlot;
+
+		result = true;
+		i = 0;
+		foreach(hk, hashState->hashkeys)
+		{
+			bool		isNull;
+			Datum		keyval;
+
+			keyval = ExecEvalExpr((ExprState *) lfirst(hk), econtext, &isNull, NULL);
+			if (isNull ||
+				!DatumGetBool(FunctionCall2(&hashtable->inner_eqfunctions[i],
+											hashtable->dedupValues[i],
+											keyval)))
+			{
+				result = false;
+				break;
+			}
+			i++;
+		}
+	}
+
+	MemoryContextSwitchTo(oldcxt);
+	econtext->ecxt_innertuple = saveslot;
+	}
+	END_MEMORY_ACCOUNT();
+
+	return result;
+}
+
+/*
+ * ExecHashTableCompact
+ *		Build the compact probe layout of the current batch
+ *
+ * Called once the batch is loaded.  The bucket chains stay as they are, for
+ * respilling and EXPLAIN; the layout goes away with the batch.
+ */
+void
+ExecHashTableCompact(HashJoinTable hashtable)
+{
+	int			nbuckets = hashtable->nbuckets;
+	uint32	   *start;
+	uint32	   *hashvalues;
+	HashJoinTuple *tuples;
+	uint32		ntuples;
+	HashBuildWorker *workers;
+	int			nworkers;
+	int			i;
+	MemoryContext oldcxt;
+
+	ExecHashTableLinkPending(hashtable);
+
+	hashtable->compactStart = NULL;
+
+	if (!hashtable->compactBuckets)
+		return;
+
+	oldcxt = MemoryContextSwitchTo(hashtable->batchCxt);
+
+	start = (uint32 *) palloc((nbuckets + 1) * sizeof(uint32));
+	hashtable->compactStart = start;
+
+	nworkers = ExecHashBuildWorkers(hashtable, hashtable->totalTuples, &workers);
+
+	ExecHashRunWorkers(workers, nworkers, ExecHashCompactCountWorker);
+
+	ntuples = 0;
+	for (i = 0; i < nworkers; i++)
+	{
+		workers[i].base = ntuples;
+		ntuples += workers[i].ntuples;
+	}
+	start[nbuckets] = ntuples;
+	hashtable->compactStart = NULL;
+
+	if ((Size) ntuples > MaxAllocSize / sizeof(HashJoinTuple))
+	{
+		pfree(workers);
+		pfree(start);
+		MemoryContextSwitchTo(oldcxt);
+		return;
+	}
+
+	hashvalues = (uint32 *) palloc((ntuples + 1) * sizeof(uint32));
+	tuples = (HashJoinTuple *) palloc((ntuples + 1) * sizeof(HashJoinTuple));
+
+	hashtable->compactStart = start;
+	hashtable->compactHashvalues = hashvalues;
+	hashtable->compactTuples = tuples;
+
+	ExecHashRunWorkers(workers, nworkers, ExecHashCompactFillWorker);
+
+	pfree(workers);
+
+	MemoryContextSwitchTo(oldcxt);
+}
+
+/*
+ * Layout of a hash table in a host arena: this header, then compactStart[]
+ * and compactHashvalues[] as in HashJoinTableData, then the offsets of the
+ * tuples from the start of the arena, in compactTuples[] order, then the
+ * tuples themselves, MAXALIGN'd, with their next links cleared.
+ */
+typedef struct HashSharedTable
+{
+	uint32		nbuckets;
+	uint32		ntuples;
+} HashSharedTable;
+
+/* How long a QE waits for another one to copy its table to the arena */
+#define HASH_SHARE_WAIT_MS		10000
+
+/*
+ * ExecHashTableShareBroadcast
+ *		Share the hash table of a broadcast inner side with the host's QEs
+ *
+ * The QEs of a slice all get every row of a broadcast inner side, so on a
+ * host running several segments they build the same hash table.  Each of
+ * them still builds its own, as it has to consume its Motion's stream
+ * anyway; but then the first one to get here copies its table to a host
+ * arena, and every QE, that one included, frees its own tuples and probes
+ * the shared copy through the compact probe layout.  A QE that can't
+ * attach, or finds a table that doesn't look like its own, keeps its own.
+ *
+ * Only a table that fits in one batch is shared.
+ */
+static void
+ExecHashTableShareBroadcast(HashState *node, HashJoinTable hashtable)
+{
+	Plan	   *inner = outerPlan(node->ps.plan);
+	Motion	   *motion = (Motion *) inner;
+	uint32		nbuckets = hashtable->nbuckets;
+	uint32		ntuples;
+	char		name[64];
+	HostArena  *arena;
+	HashSharedTable *shared;
+	uint32	   *start;
+	uint32	   *hashvalues;
+	Size	   *offsets;
+	HashJoinTuple *tuples;
+	Size		size;
+	uint32		i;
+	MemoryContext oldcxt;
+
+	if (Gp_role != GP_ROLE_EXECUTE ||
+		inner == NULL || !IsA(inner, Motion) ||
+		motion->motionType != MOTIONTYPE_FIXED || motion->numOutputSegs != 0)
+		return;
+
+	if (hashtable->nbatch != 1 || hashtable->compactStart == NULL)
+		return;
+
+	ntuples = hashtable->compactStart[nbuckets];
+	if (ntuples == 0)
+		return;
+
+	HostArenaName(name, sizeof(name), currentSliceId, node->ps.plan->plan_node_id);
+
+	/* Try to be the one to copy the table to the arena. */
+	size = MAXALIGN(sizeof(HashSharedTable));
+	size += MAXALIGN((nbuckets + 1) * sizeof(uint32));
+	size += MAXALIGN((ntuples + 1) * sizeof(uint32));
+	size += MAXALIGN(ntuples * sizeof(Size));
+	for (i = 0; i < ntuples; i++)
+	{
+		HashJoinTuple tuple = hashtable->compactTuples[i];
+
+		size += MAXALIGN(HJTUPLE_OVERHEAD +
+						 memtuple_get_size(HJTUPLE_MINTUPLE(tuple)));
+	}
+
+	arena = HostArenaCreate(name, size);
+	if (arena != NULL)
+	{
+		char	   *ptr = arena->data;
+
+		shared = (HashSharedTable *) ptr;
+		shared->nbuckets = nbuckets;
+		shared->ntuples = ntuples;
+		ptr += MAXALIGN(sizeof(HashSharedTable));
+
+		memcpy(ptr, hashtable->compactStart, (nbuckets + 1) * sizeof(uint32));
+		ptr += MAXALIGN((nbuckets + 1) * sizeof(uint32));
+		memcpy(ptr, hashtable->compactHashvalues, (ntuples + 1) * sizeof(uint32));
+		ptr += MAXALIGN((ntuples + 1) * sizeof(uint32));
+		offsets = (Size *) ptr;
+		ptr += MAXALIGN(ntuples * sizeof(Size));
+
+		for (i = 0; i < ntuples; i++)
+		{
+			HashJoinTuple tuple = hashtable->compactTuples[i];
+			Size		tuplesize = HJTUPLE_OVERHEAD +
+				memtuple_get_size(HJTUPLE_MINTUPLE(tuple));
+
+			memcpy(ptr, tuple, tuplesize);
+			((HashJoinTuple) ptr)->next = NULL;
+			offsets[i] = ptr - arena->data;
+			ptr += MAXALIGN(tuplesize);
+		}
+		Assert(ptr == arena->data + size);
+
+		HostArenaPublish(arena, true);
+	}
+	else
+	{
+		arena = HostArenaAttach(name, HASH_SHARE_WAIT_MS);
+		if (arena == NULL)
+			return;
+	}
+
+	shared = (HashSharedTable *) arena->data;
+	if (arena->size < MAXALIGN(sizeof(HashSharedTable)) ||
+		shared->nbuckets != nbuckets || shared->ntuples != ntuples)
+	{
+		elog(DEBUG1, "hash table in host arena \"%s\" doesn't match the local one",
+			 name);
+		HostArenaDetach(arena);
+		return;
+	}
+
+	start = (uint32 *) (arena->data + MAXALIGN(sizeof(HashSharedTable)));
+	hashvalues = (uint32 *) ((char *) start +
+							 MAXALIGN((nbuckets + 1) * sizeof(uint32)));
+	offsets = (Size *) ((char *) hashvalues +
+						MAXALIGN((ntuples + 1) * sizeof(uint32)));
+
+	/* Switch over to the shared copy, and free the local one. */
+	oldcxt = MemoryContextSwitchTo(hashtable->batchCxt);
+
+	tuples = (HashJoinTuple *) palloc((ntuples + 1) * sizeof(HashJoinTuple));
+	for (i = 0; i < ntuples; i++)
+		tuples[i] = (HashJoinTuple) (arena->data + offsets[i]);
+	tuples[ntuples] = NULL;
+
+	pfree(hashtable->compactStart);
+	pfree(hashtable->compactHashvalues);
+	pfree(hashtable->compactTuples);
+	memset(hashtable->buckets, 0, nbuckets * sizeof(HashJoinTuple));
+	MemoryContextReset(hashtable->tupleCxt);
+
+	hashtable->compactStart = start;
+	hashtable->compactHashvalues = hashvalues;
+	hashtable->compactTuples = tuples;
+	hashtable->hostArena = arena;
+
+	MemoryContextSwitchTo(oldcxt);
+}
+
+/*
+ * ExecHashBuildWorkers
+ *		Split the buckets into ranges for the build workers
+ *
+ * One range per build thread plus one for the backend itself, if there are
+ * at least HJ_THREADED_MIN_TUPLES tuples to deal with, else just one range.
+ * Returns the number of ranges; *workers is palloc'd.
+ */
+static int
+ExecHashBuildWorkers(HashJoinTable hashtable, double ntuples,
+					 HashBuildWorker **workers)
+{
+	int			nbuckets = hashtable->nbuckets;
+	int			nworkers = 1;
+	int			i;
+
+	if (hashtable->buildThreads > 0 && ntuples >= HJ_THREADED_MIN_TUPLES)
+		nworkers = Min(hashtable->buildThreads + 1, nbuckets);
+
+	*workers = (HashBuildWorker *) palloc0(nworkers * sizeof(HashBuildWorker));
+	for (i = 0; i < nworkers; i++)
+	{
+		(*workers)[i].hashtable = hashtable;
+		(*workers)[i].lo = (int) ((int64) nbuckets * i / nworkers);
+		(*workers)[i].hi = (int) ((int64) nbuckets * (i + 1) / nworkers);
+	}
+
+	return nworkers;
+}
+
+/*
+ * ExecHashRunWorkers
+ *		Run fn on every worker's range, and wait for all of them
+ *
+ * The backend takes the first range itself.  A range whose thread can't be
+ * started is done by the backend too, after its own; the ranges don't
+ * overlap, so it doesn't matter which thread does which.
+ */
+static void
+ExecHashRunWorkers(HashBuildWorker *workers, int nworkers,
+				   void *(*fn) (void *))
+{
+	pthread_t  *threads = NULL;
+	bool	   *started = NULL;
+	int			i;
+
+	if (nworkers > 1)
+	{
+		threads = (pthread_t *) palloc(nworkers * sizeof(pthread_t));
+		started = (bool *) palloc0(nworkers * sizeof(bool));
+
+		for (i = 1; i < nworkers; i++)
+		{
+			workers[i].fn = fn;
+			started[i] = (gp_pthread_create(&threads[i], ExecHashWorkerThread,
+											&workers[i],
+											"ExecHashRunWorkers") == 0);
+		}
+	}
+
+	fn(&workers[0]);
+
+	for (i = 1; i < nworkers; i++)
+	{
+		if (started[i])
+			pthread_join(threads[i], NULL);
+		else
+			fn(&workers[i]);
+	}
+
+	if (threads)
+	{
+		pfree(threads);
+		pfree(started);
+	}
+}
+
+/*
+ * ExecHashWorkerThread
+ *		Entry point of a worker thread
+ *
+ * Blocks the signals the backend handles, so that their handlers don't run
+ * on this thread, and then does the worker's part.
+ */
+static void *
+ExecHashWorkerThread(void *arg)
+{
+	HashBuildWorker *worker = (HashBuildWorker *) arg;
+
+	gp_set_thread_sigmasks();
+
+	return worker->fn(arg);
+}
+
+/*
+ * ExecHashLinkWorker
+ *		Link the pending tuples that fall in the worker's buckets
+ *
+ * Every worker scans all of the pending tuples, in arrival order, so each
+ * chain ends up in the same order as if the tuples had been linked one by
+ * one as they came in.
+ */
+static void *
+ExecHashLinkWorker(void *arg)
+{
+	HashBuildWorker *worker = (HashBuildWorker *) arg;
+	HashJoinTable hashtable = worker->hashtable;
+	HashJoinPending *pending = hashtable->pendingTuples;
+	HashJoinTuple *buckets = hashtable->buckets;
+	uint64	   *bloom = gp_hashjoin_bloomfilter != 0 ? hashtable->bloom : NULL;
+	uint32		lo = (uint32) worker->lo;
+	uint32		hi = (uint32) worker->hi;
+	int			n = hashtable->npending;
+	int			i;
+
+	for (i = 0; i < n; i++)
+	{
+		uint32		bucketno = pending[i].bucketno;
+		HashJoinTuple tuple;
+
+		if (bucketno < lo || bucketno >= hi)
+			continue;
+
+		tuple = pending[i].tuple;
+		tuple->next = buckets[bucketno];
+		buckets[bucketno] = tuple;
+
+		if (bloom != NULL)
+			bloom[bucketno] |= BLOOMVAL(tuple->hashvalue);
+	}
+
+	return NULL;
+}
+
+/*
+ * ExecHashCompactCountWorker
+ *		Count the tuples in the worker's buckets
+ *
+ * Sets compactStart[] relative to the start of the range; the fill pass
+ * adds the range's base.
+ */
+static void *
+ExecHashCompactCountWorker(void *arg)
+{
+	HashBuildWorker *worker = (HashBuildWorker *) arg;
+	HashJoinTable hashtable = worker->hashtable;
+	uint32	   *start = hashtable->compactStart;
+	uint32		ntuples = 0;
+	int			i;
+
+	for (i = worker->lo; i < worker->hi; i++)
+	{
+		HashJoinTuple tuple;
+
+		start[i] = ntuples;
+		for (tuple = hashtable->buckets[i]; tuple != NULL; tuple = tuple->next)
+			ntuples++;
+	}
+	worker->ntuples = ntuples;
+
+	return NULL;
+}
+
+/*
+ * ExecHashCompactFillWorker
+ *		Copy the worker's buckets into the compact layout
+ */
+static void *
+ExecHashCompactFillWorker(void *arg)
+{
+	HashBuildWorker *worker = (HashBuildWorker *) arg;
+	HashJoinTable hashtable = worker->hashtable;
+	uint32	   *start = hashtable->compactStart;
+	uint32	   *hashvalues = hashtable->compactHashvalues;
+	HashJoinTuple *tuples = hashtable->compactTuples;
+	uint32		pos = worker->base;
+	int			i;
+
+	for (i = worker->lo; i < worker->hi; i++)
+	{
+		HashJoinTuple tuple;
+
+		start[i] += worker->base;
+		for (tuple = hashtable->buckets[i]; tuple != NULL; tuple = tuple->next)
+		{
+			hashvalues[pos] = tuple->hashvalue;
+			tuples[pos] = tuple;
+			pos++;
+		}
+	}
+	Assert(pos == worker->base + worker->ntuples);
+
+	return NULL;
+}
+
+/*
+ * ExecHashTableLinkPending
+ *		Link the tuples collected by a threaded build into their buckets
+ */
+static void
+ExecHashTableLinkPending(HashJoinTable hashtable)
+{
+	HashBuildWorker *workers;
+	int			nworkers;
+
+	if (hashtable->npending == 0)
+		return;
+
+	nworkers = ExecHashBuildWorkers(hashtable, hashtable->npending, &workers);
+	ExecHashRunWorkers(workers, nworkers, ExecHashLinkWorker);
+	pfree(workers);
+
+	hashtable->npending = 0;
+}
+
+/*
+ * ExecHashRuntimeFilterCreate
+ *		Set up a runtime filter for the hash join, if its outer side can use one
+ *
+ * The filter can only drop outer rows that won't join, so the join must be
+ * one that discards those: an inner or a semi join.  The outer side must be
+ * a scan of a table, with each outer hash key a column of the scanned
+ * table, so that the scan can compute the key's hash value from its own
+ * tuple.  ntuples is the planner's estimate of the inner side; it may be
+ * the total over all segments, which just makes the filter sparser.
+ */
+static HashRuntimeFilter *
+ExecHashRuntimeFilterCreate(HashJoinTable hashtable, HashJoinState *hjstate,
+							double ntuples)
+{
+	PlanState  *outerState = outerPlanState(hjstate);
+	HashRuntimeFilter *filter;
+	AttrNumber *attnos;
+	int			nkeys;
+	uint32		nbits;
+	ListCell   *lc;
+	int			i;
+
+	if (hjstate->js.jointype != JOIN_INNER &&
+		hjstate->js.jointype != JOIN_SEMI)
+		return NULL;
+
+	if (!IsA(outerState, SeqScanState) &&
+		!IsA(outerState, TableScanState))
+		return NULL;
+
+	nkeys = list_length(hjstate->hj_OuterHashKeys);
+	attnos = (AttrNumber *) palloc(nkeys * sizeof(AttrNumber));
+
+	i = 0;
+	foreach(lc, hjstate->hj_OuterHashKeys)
+	{
+		ExprState  *keystate = (ExprState *) lfirst(lc);
+		Var		   *keyvar = (Var *) keystate->expr;
+		TargetEntry *tle;
+
+		if (!IsA(keyvar, Var) || keyvar->varno != OUTER)
+			return NULL;
+
+		tle = get_tle_by_resno(outerState->plan->targetlist, keyvar->varattno);
+		if (tle == NULL || !IsA(tle->expr, Var) ||
+			((Var *) tle->expr)->varattno <= 0)
+			return NULL;
+
+		attnos[i++] = ((Var *) tle->expr)->varattno;
+	}
+
+	nbits = HRF_MIN_BITS;
+	while (nbits < HRF_MAX_BITS && nbits < ntuples * HRF_BITS_PER_TUPLE)
+		nbits <<= 1;
+
+	filter = (HashRuntimeFilter *) palloc0(sizeof(HashRuntimeFilter));
+	filter->bits = (uint64 *) palloc0(nbits / 8);
+	filter->mask = nbits - 1;
+	filter->nkeys = nkeys;
+	filter->attnos = attnos;
+	filter->hashfunctions = hashtable->outer_hashfunctions;
+	filter->hashStrict = hashtable->hashStrict;
+
+	return filter;
+}
+
+/*
+ * The bit positions of a hash value, by double hashing.  The second hash is
+ * the first one rotated, made odd so that all HRF_NHASHES positions differ.
+ */
+#define HRF_BIT(filter, hashvalue, i) \
+	(((hashvalue) + (i) * ((((hashvalue) >> 16) | ((hashvalue) << 16)) | 1)) & (filter)->mask)
+
+static void
+ExecHashRuntimeFilterAdd(HashRuntimeFilter *filter, uint32 hashvalue)
+{
+	int			i;
+
+	for (i = 0; i < HRF_NHASHES; i++)
+	{
+		uint32		bit = HRF_BIT(filter, hashvalue, i);
+
+		filter->bits[bit / 64] |= ((uint64) 1) << (bit % 64);
+	}
+	filter->ninserted++;
+}
+
+/*
+ * ExecHashRuntimeFilterPushdown
+ *		Hand the runtime filter to the outer scan, once the inner side is in
+ *
+ * Called after the hash table is built.  The filter stays with the scan
+ * until the hash table is destroyed.
+ */
+void
+ExecHashRuntimeFilterPushdown(HashJoinTable hashtable, PlanState *outerNode)
+{
+	HashRuntimeFilter *filter = hashtable->runtimeFilter;
+
+	if (filter == NULL || filter->complete)
+		return;
+
+	filter->complete = true;
+
+	if (filter->ninserted * HRF_MIN_BITS_PER_TUPLE > (double) filter->mask + 1)
+		return;
+
+	Assert(IsA(outerNode, SeqScanState) || IsA(outerNode, TableScanState));
+	((ScanState *) outerNode)->ss_runtimeFilter = filter;
+	hashtable->runtimeFilterTarget = (ScanState *) outerNode;
+}
+
+/*
+ * ExecHashRuntimeFilterCheck
+ *		Check a scan tuple against a hash join's runtime filter
+ *
+ * Returns false if the tuple can't have a match on the inner side and may
+ * be dropped.
+ */
+bool
+ExecHashRuntimeFilterCheck(HashRuntimeFilter *filter, TupleTableSlot *slot,
+						   ExprContext *econtext)
+{
+	uint32		hashkey = 0;
+	MemoryContext oldContext;
+	bool		pass = true;
+	int			i;
+
+	if (filter->disabled)
+		return true;
+
+	oldContext = MemoryContextSwitchTo(econtext->ecxt_per_tuple_memory);
+
+	/* Same as ExecHashGetHashValue, on the scan tuple's columns */
+	for (i = 0; i < filter->nkeys; i++)
+	{
+		Datum		keyval;
+		bool		isNull;
+
+		hashkey = (hashkey << 1) | ((hashkey & 0x80000000) ? 1 : 0);
+
+		keyval = slot_getattr(slot, filter->attnos[i], &isNull);
+		if (isNull)
+		{
+			if (filter->hashStrict[i])
+			{
+				pass = false;
+				break;
+			}
+		}
+		else
+			hashkey ^= DatumGetUInt32(FunctionCall1(&filter->hashfunctions[i],
+													keyval));
+	}
+
+	MemoryContextSwitchTo(oldContext);
+
+	for (i = 0; pass && i < HRF_NHASHES; i++)
+	{
+		uint32		bit = HRF_BIT(filter, hashkey, i);
+
+		if ((filter->bits[bit / 64] & (((uint64) 1) << (bit % 64))) == 0)
+			pass = false;
+	}
+
+	filter->nchecked++;
+	if (!pass)
+		filter->nrejected++;
+
+	if (filter->nchecked == HRF_SAMPLE_TUPLES &&
+		filter->nrejected < filter->nchecked * HRF_MIN_REJECT_RATIO)
+		filter->disabled = true;
+
+	return pass;
+}
+
 /*
  * ExecHashGetHashValue
  *		Compute the hash value for a tuple
@@ -1181,28 +2152,34 @@ ExecScanHashBucket(HashState *hashState, HashJoinState *hjstate,
 	HashJoinTable hashtable = hjstate->hj_HashTable;
 	HashJoinTuple hashTuple = hjstate->hj_CurTuple;
 	uint32		hashvalue = hjstate->hj_CurHashValue;
+	HashJoinTuple result = NULL;
 
 	START_MEMORY_ACCOUNT(hashState->ps.plan->memoryAccountId);
 	{
-	/*
-	 * hj_CurTuple is NULL to start scanning a new bucket, or the address of
-	 * the last tuple returned from the current bucket.
-	 */
-	if (hashTuple == NULL)
+	if (hashtable->compactStart != NULL)
 	{
-		/* if bloom filter fails, then no match - don't even bother to scan */
-		if (gp_hashjoin_bloomfilter == 0 || 0 != (hashtable->bloom[hjstate->hj_CurBucketNo] & BLOOMVAL(hashvalue)))
-			hashTuple = hashtable->buckets[hjstate->hj_CurBucketNo];
-	}
-	else
-		hashTuple = hashTuple->next;
+		/*
+		 * With the compact layout, look for the hash value in the bucket's
+		 * run of hash values, and only go to the tuples that have it.
+		 */
+		uint32		end = hashtable->compactStart[hjstate->hj_CurBucketNo + 1];
+		uint32	   *hashvalues = hashtable->compactHashvalues;
+		uint32		pos;
 
-	while (hashTuple != NULL)
-	{
-		if (hashTuple->hashvalue == hashvalue)
+		if (hashTuple == NULL)
+			pos = hashtable->compactStart[hjstate->hj_CurBucketNo];
+		else
+			pos = hjstate->hj_CurCompactPos + 1;
+
+		for (; pos < end; pos++)
 		{
 			TupleTableSlot *inntuple;
 
+			if (hashvalues[pos] != hashvalue)
+				continue;
+
+			hashTuple = hashtable->compactTuples[pos];
+
 			/* insert hashtable's tuple into exec slot so ExecQual sees it */
 			inntuple = ExecStoreMinimalTuple(HJTUPLE_MINTUPLE(hashTuple),
 											 hjstate->hj_HashTupleSlot,
@@ -1215,19 +2192,60 @@ ExecScanHashBucket(HashState *hashState, HashJoinState *hjstate,
 			if (ExecQual(hjclauses, econtext, false))
 			{
 				hjstate->hj_CurTuple = hashTuple;
-				return hashTuple;
+				hjstate->hj_CurCompactPos = pos;
+				result = hashTuple;
+				break;
 			}
 		}
+	}
+	else
+	{
+		/*
+		 * hj_CurTuple is NULL to start scanning a new bucket, or the address
+		 * of the last tuple returned from the current bucket.
+		 */
+		if (hashTuple == NULL)
+		{
+			/* if bloom filter fails, then no match - don't even bother to scan */
+			if (gp_hashjoin_bloomfilter == 0 || 0 != (hashtable->bloom[hjstate->hj_CurBucketNo] & BLOOMVAL(hashvalue)))
+				hashTuple = hashtable->buckets[hjstate->hj_CurBucketNo];
+		}
+		else
+			hashTuple = hashTuple->next;
+
+		while (hashTuple != NULL)
+		{
+			if (hashTuple->hashvalue == hashvalue)
+			{
+				TupleTableSlot *inntuple;
+
+				/* insert hashtable's tuple into exec slot so ExecQual sees it */
+				inntuple = ExecStoreMinimalTuple(HJTUPLE_MINTUPLE(hashTuple),
+												 hjstate->hj_HashTupleSlot,
+												 false);	/* do not pfree */
+				econtext->ecxt_innertuple = inntuple;
+
+				/* reset temp memory each time to avoid leaks from qual expr */
+				ResetExprContext(econtext);
 
-		hashTuple = hashTuple->next;
+				if (ExecQual(hjclauses, econtext, false))
+				{
+					hjstate->hj_CurTuple = hashTuple;
+					result = hashTuple;
+					break;
+				}
+			}
+
+			hashTuple = hashTuple->next;
+		}
 	}
 	}
 	END_MEMORY_ACCOUNT();
 
 	/*
-	 * no match
+	 * NULL if no match
 	 */
-	return NULL;
+	return result;
 }
 
 /*
@@ -1262,6 +2280,10 @@ ExecHashTableReset(HashState *hashState, HashJoinTable hashtable)
 	hashtable->batches[hashtable->curbatch]->innerspace = 0;
 	hashtable->batches[hashtable->curbatch]->innertuples = 0;
 	hashtable->totalTuples = 0;
+	hashtable->compactStart = NULL;
+	hashtable->pendingTuples = NULL;
+	hashtable->npending = 0;
+	hashtable->maxpending = 0;
 
 	MemoryContextSwitchTo(oldcxt);
 	}
@@ -1421,6 +2443,11 @@ ExecHashTableExplainEnd(PlanState *planstate, struct StringInfoData *buf)
 				"Secondary Overflow");
     }
 
+    if (hashtable->ndupsDropped > 0)
+        appendStringInfo(buf,
+                         "Dropped %.0f inner rows with duplicate keys.\n",
+                         hashtable->ndupsDropped);
+
     /* Report hash chain statistics. */
     total_buckets = stats->nonemptybatches * hashtable->nbuckets;
     if (total_buckets > 0)
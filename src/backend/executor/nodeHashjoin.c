@@ -249,6 +249,11 @@ ExecHashJoin(HashJoinState *node)
 			return NULL;
 		}
 
+		/*
+		 * Let the outer scan drop the rows that can't find a match.
+		 */
+		ExecHashRuntimeFilterPushdown(hashtable, outerNode);
+
 		/*
 		 * Reset OuterNotEmpty for scan.  (It's OK if we fetched a tuple
 		 * above, because ExecHashJoinOuterGetTuple will immediately set it
@@ -735,12 +740,13 @@ ExecHashJoinOuterGetTuple(PlanState *outerNode,
 			bool hashkeys_null = false;
 			bool keep_nulls = (HASHJOIN_IS_OUTER(hjstate))||
 					hjstate->hj_nonequijoin;
-			if (ExecHashGetHashValue(hashState, hashtable, econtext,
-									 hjstate->hj_OuterHashKeys,
-									 true,		/* outer tuple */
-									 keep_nulls,
-									 hashvalue,
-									 &hashkeys_null))
+			if (call_ExecHashGetHashValue(hjstate->ExecHashGetHashValue_gen_info,
+										  hashState, hashtable, econtext,
+										  hjstate->hj_OuterHashKeys,
+										  true,		/* outer tuple */
+										  keep_nulls,
+										  hashvalue,
+										  &hashkeys_null))
 			{
 				/* remember outer relation is not empty for possible rescan */
 				hjstate->hj_OuterNotEmpty = true;
@@ -1263,6 +1269,9 @@ ExecEagerFreeHashJoin(HashJoinState *node)
 	if (node->hj_HashTable != NULL && !node->hj_HashTable->eagerlyReleased)
 	{
 		ReleaseHashTable(node);
+
+		/* The hash table was the Hash node's; give its quota back */
+		MemoryAccounting_RelinquishQuota(innerPlanState(node)->plan->memoryAccountId);
 	}
 }
 
@@ -1418,6 +1427,8 @@ ExecHashJoinReloadHashTable(HashJoinState *hjstate)
 		}
 	}
 
+	ExecHashTableCompact(hashtable);
+
 	return true;
 }
 
@@ -26,8 +26,10 @@
 #include "cdb/cdbvars.h"
 #include "executor/executor.h"
 #include "executor/nodeLimit.h"
+#include "nodes/nodeFuncs.h"
 
 static void recompute_limits(LimitState *node);
+static void pass_down_bound(PlanState *child, bool bounded, int64 bound);
 
 
 /* ----------------------------------------------------------------
@@ -326,22 +328,56 @@ recompute_limits(LimitState *node)
 	 * good idea to integrate this signaling with the parameter-change
 	 * mechanism.
 	 */
-	if (IsA(outerPlanState(node), SortState))
 	{
-		SortState  *sortState = (SortState *) outerPlanState(node);
 		int64		tuples_needed = node->count + node->offset;
 
 		/* negative test checks for overflow */
 		if (node->noCount || tuples_needed < 0 || !gp_enable_sort_limit)
 		{
 			/* make sure flag gets reset if needed upon rescan */
-			sortState->bounded = false;
+			pass_down_bound(outerPlanState(node), false, 0);
 		}
 		else
-		{
-			sortState->bounded = true;
-			sortState->bound = tuples_needed;
-		}
+			pass_down_bound(outerPlanState(node), true, tuples_needed);
+	}
+}
+
+/*
+ * Tell the Sort below us, if any, how many tuples we need.
+ *
+ * The Sort may sit below nodes that return one row per input row, such as
+ * the projection Result or SubqueryScan that often ends up between the
+ * preliminary Limit and the Sort on the segments.  A qual, a hash filter
+ * or a set-returning function in between could change the row count, so
+ * we stop there.
+ */
+static void
+pass_down_bound(PlanState *child, bool bounded, int64 bound)
+{
+	if (child == NULL)
+		return;
+
+	if (IsA(child, SortState))
+	{
+		SortState  *sortState = (SortState *) child;
+
+		sortState->bounded = bounded;
+		if (bounded)
+			sortState->bound = bound;
+	}
+	else if (IsA(child, ResultState))
+	{
+		Result	   *plan = (Result *) child->plan;
+
+		if (child->qual == NIL && !plan->hashFilter &&
+			!expression_returns_set((Node *) plan->plan.targetlist))
+			pass_down_bound(outerPlanState(child), bounded, bound);
+	}
+	else if (IsA(child, SubqueryScanState))
+	{
+		if (child->qual == NIL &&
+			!expression_returns_set((Node *) child->plan->targetlist))
+			pass_down_bound(((SubqueryScanState *) child)->subplan, bounded, bound);
 	}
 }
 
@@ -23,18 +23,61 @@
  */
 #include "postgres.h"
 
+#include "access/hash.h"
+#include "access/xact.h"
 #include "executor/executor.h"
 #include "executor/nodeMaterial.h"
 #include "executor/instrument.h"        /* Instrumentation */
+#include "optimizer/clauses.h"
+#include "parser/parsetree.h"
+#include "utils/memutils.h"
+#include "utils/resowner.h"
 #include "utils/tuplestorenew.h"
 
 #include "miscadmin.h"
 
 #include "cdb/cdbvars.h"
 
+/*
+ * Spilled results of Material nodes can be kept for later queries of the
+ * same transaction, up to gp_workfile_reuse_limit kilobytes of workfiles.
+ * A later Material node over the same subplan, reading the same relations,
+ * then reads the kept tuplestore instead of running its subplan.
+ *
+ * The result is only the same if the later query sees the same data. The
+ * transaction must be serializable, so that every query uses its snapshot,
+ * and the snapshot's command id must be the same, so that the transaction
+ * hasn't changed anything in between.  The subplan must not depend on
+ * parameters or call functions that aren't immutable. It also must not
+ * contain a Motion, whose sending slice would hang if it wasn't run.
+ *
+ * The kept results are local to the backend and are all dropped at the end
+ * of the transaction.
+ */
+typedef struct MaterialReuseEntry
+{
+	char	   *key;			/* subplan and the relations it scans */
+	uint32		hash;			/* hash of key */
+	CommandId	curcid;			/* command id of the snapshot */
+	bool		complete;		/* written to the end, can be read */
+	int			refcount;		/* Material nodes using it */
+	int64		size;			/* bytes on disk, once complete */
+	NTupleStore *store;
+	workfile_set *work_set;
+} MaterialReuseEntry;
+
+/* Kept results, most recently used first */
+static List *material_reuse_entries = NIL;
+static int64 material_reuse_size = 0;
+static MemoryContext material_reuse_context = NULL;
+static bool material_reuse_callback_registered = false;
+
 static void ExecMaterialExplainEnd(PlanState *planstate, struct StringInfoData *buf);
 static void ExecChildRescan(MaterialState *node, ExprContext *exprCtxt);
 static void DestroyTupleStore(MaterialState *node);
+static MaterialReuseEntry *MaterialReuseStart(MaterialState *node);
+static void MaterialReuseDrop(MaterialReuseEntry *entry);
+static void MaterialReuseFinish(MaterialState *node);
 
 
 /* ----------------------------------------------------------------
@@ -101,10 +144,28 @@ ExecMaterial(MaterialState *node)
 		else
 		{
 			/* Non-shared Materialize node */
-			workfile_set *work_set =  workfile_mgr_create_set(BUFFILE, false /* can_reuse */, &node->ss.ps);
+			MaterialReuseEntry *entry = MaterialReuseStart(node);
+
+			if (entry != NULL && entry->complete)
+			{
+				/* Read a result kept by an earlier query, the subplan needn't run */
+				ts = entry->store;
+				tsa = ntuplestore_create_accessor(ts, false /* isWriter */);
+				node->eof_underlying = true;
+			}
+			else if (entry != NULL)
+			{
+				ts = entry->store;
+				tsa = ntuplestore_create_accessor(ts, true /* isWriter */);
+			}
+			else
+			{
+				workfile_set *work_set =  workfile_mgr_create_set(BUFFILE, false /* can_reuse */, &node->ss.ps);
 
-			ts = ntuplestore_create_workset(work_set, PlanStateOperatorMemKB((PlanState *) node) * 1024);
-			tsa = ntuplestore_create_accessor(ts, true /* isWriter */);
+				ts = ntuplestore_create_workset(work_set, PlanStateOperatorMemKB((PlanState *) node) * 1024);
+				tsa = ntuplestore_create_accessor(ts, true /* isWriter */);
+			}
+			node->reuse_entry = entry;
 		}
 
 		Assert(ts && tsa);
@@ -112,7 +173,8 @@ ExecMaterial(MaterialState *node)
 		node->ts_pos = (void *) tsa;
 
         /* CDB: Offer extra info for EXPLAIN ANALYZE. */
-        if (node->ss.ps.instrument)
+        if (node->ss.ps.instrument &&
+			!(node->reuse_entry && ((MaterialReuseEntry *) node->reuse_entry)->complete))
         {
             /* Let the tuplestore share our Instrumentation object. */
 			ntuplestore_setinstrument(ts, node->ss.ps.instrument);
@@ -133,14 +195,16 @@ ExecMaterial(MaterialState *node)
 		 * is used to share input, we will need to fetch all rows and put
 		 * them in tuple store
 		 */
-		while (((Material *) node->ss.ps.plan)->cdb_strict
-				|| ma->share_type != SHARE_NOTSHARED)
+		while (!node->eof_underlying &&
+			   (((Material *) node->ss.ps.plan)->cdb_strict
+				|| ma->share_type != SHARE_NOTSHARED))
 		{
 			TupleTableSlot *outerslot = ExecProcNode(outerPlanState(node));
 
 			if (TupIsNull(outerslot))
 			{
 				node->eof_underlying = true;
+				MaterialReuseFinish(node);
 				ntuplestore_acc_seek_bof(tsa);
 
 				break;
@@ -169,7 +233,9 @@ ExecMaterial(MaterialState *node)
 			{
 				if (ma->driver_slice == currentSliceId)
 				{
-					ntuplestore_flush(ts);
+					/* A small share goes to shared memory, others to disk */
+					if (!shareinput_shmem_publish(ma->share_id, ts))
+						ntuplestore_flush(ts);
 
 					node->share_lk_ctxt = shareinput_writer_notifyready(ma->share_id, ma->nsharer_xslice,
 							estate->es_plannedstmt->planGen);
@@ -226,6 +292,7 @@ ExecMaterial(MaterialState *node)
 		if (TupIsNull(outerslot))
 		{
 			node->eof_underlying = true;
+			MaterialReuseFinish(node);
 			if (!node->ss.ps.delayEagerFree)
 			{
 				ExecEagerFreeMaterial(node);
@@ -295,6 +362,7 @@ ExecInitMaterial(Material *node, EState *estate, int eflags)
 	matstate->ts_markpos = NULL;
 	matstate->share_lk_ctxt = NULL;
 	matstate->ts_destroyed = false;
+	matstate->reuse_entry = NULL;
 
 	/*
 	 * Miscellaneous initialization
@@ -521,7 +589,19 @@ DestroyTupleStore(MaterialState *node)
 	Assert(NULL != node->ts_state->matstore);
 
 	ntuplestore_destroy_accessor((NTupleStoreAccessor *) node->ts_pos);
-	ntuplestore_destroy(node->ts_state->matstore);
+	if (node->reuse_entry != NULL)
+	{
+		MaterialReuseEntry *entry = (MaterialReuseEntry *) node->reuse_entry;
+
+		/* A kept result stays for later readers, one not kept is dropped */
+		if (entry->complete)
+			entry->refcount--;
+		else
+			MaterialReuseDrop(entry);
+		node->reuse_entry = NULL;
+	}
+	else
+		ntuplestore_destroy(node->ts_state->matstore);
 	if(node->ts_markpos)
 	{
 		pfree(node->ts_markpos);
@@ -663,4 +743,310 @@ ExecEagerFreeMaterial(MaterialState *node)
 
 		DestroyTupleStore(node);
 	}
+
+	/* Give our quota to the operators that still run */
+	MemoryAccounting_RelinquishQuota(ma->plan.memoryAccountId);
+}
+
+/*
+ * Can the result of this subplan be kept for a later query?  See the
+ * comment at MaterialReuseEntry.  Only plan nodes that just read
+ * relations and compute on their rows are accepted.  The OIDs of the
+ * scanned relations are appended to relids.
+ */
+static bool
+MaterialReusePlanOk(Plan *plan, EState *estate, StringInfo relids)
+{
+	ListCell   *lc;
+
+	if (plan == NULL)
+		return true;
+
+	switch (nodeTag(plan))
+	{
+		case T_SeqScan:
+		case T_AppendOnlyScan:
+		case T_AOCSScan:
+		case T_BitmapHeapScan:
+		case T_BitmapAppendOnlyScan:
+			break;
+		case T_IndexScan:
+		case T_BitmapIndexScan:
+			/* Partitioned tables choose their partitions at run time */
+			if (((IndexScan *) plan)->logicalIndexInfo != NULL)
+				return false;
+			if (contain_mutable_functions((Node *) ((IndexScan *) plan)->indexqualorig))
+				return false;
+			break;
+		case T_HashJoin:
+			if (contain_mutable_functions((Node *) ((HashJoin *) plan)->hashclauses) ||
+				contain_mutable_functions((Node *) ((HashJoin *) plan)->hashqualclauses))
+				return false;
+			/* fall through */
+		case T_NestLoop:
+		case T_MergeJoin:
+			if (contain_mutable_functions((Node *) ((Join *) plan)->joinqual) ||
+				contain_subplans((Node *) ((Join *) plan)->joinqual))
+				return false;
+			if (IsA(plan, MergeJoin) &&
+				contain_mutable_functions((Node *) ((MergeJoin *) plan)->mergeclauses))
+				return false;
+			break;
+		case T_Hash:
+		case T_Agg:
+		case T_Sort:
+		case T_Unique:
+			break;
+		case T_Limit:
+			if (contain_mutable_functions(((Limit *) plan)->limitOffset) ||
+				contain_mutable_functions(((Limit *) plan)->limitCount))
+				return false;
+			break;
+		case T_Result:
+			if (contain_mutable_functions(((Result *) plan)->resconstantqual))
+				return false;
+			break;
+		case T_Material:
+			if (((Material *) plan)->share_type != SHARE_NOTSHARED)
+				return false;
+			break;
+		case T_Append:
+			foreach(lc, ((Append *) plan)->appendplans)
+			{
+				if (!MaterialReusePlanOk((Plan *) lfirst(lc), estate, relids))
+					return false;
+			}
+			break;
+		default:
+			return false;
+	}
+
+	if (contain_mutable_functions((Node *) plan->targetlist) ||
+		contain_mutable_functions((Node *) plan->qual) ||
+		contain_subplans((Node *) plan->targetlist) ||
+		contain_subplans((Node *) plan->qual))
+		return false;
+
+	switch (nodeTag(plan))
+	{
+		case T_SeqScan:
+		case T_AppendOnlyScan:
+		case T_AOCSScan:
+		case T_BitmapHeapScan:
+		case T_BitmapAppendOnlyScan:
+		case T_IndexScan:
+		case T_BitmapIndexScan:
+			{
+				RangeTblEntry *rte = rt_fetch(((Scan *) plan)->scanrelid,
+											  estate->es_range_table);
+
+				appendStringInfo(relids, " %u", rte->relid);
+			}
+			break;
+		default:
+			break;
+	}
+
+	return MaterialReusePlanOk(plan->lefttree, estate, relids) &&
+		MaterialReusePlanOk(plan->righttree, estate, relids);
+}
+
+static void
+MaterialReuseDrop(MaterialReuseEntry *entry)
+{
+	material_reuse_entries = list_delete_ptr(material_reuse_entries, entry);
+	if (entry->complete)
+		material_reuse_size -= entry->size;
+	ntuplestore_destroy(entry->store);
+	pfree(entry->key);
+	pfree(entry);
+}
+
+/*
+ * At the end of the transaction drop all kept results, before the
+ * resource owner that holds their workfiles is released.
+ */
+static void
+MaterialReuseXactCallback(XactEvent event, void *arg)
+{
+	if (material_reuse_context == NULL)
+		return;
+
+	while (material_reuse_entries != NIL)
+		MaterialReuseDrop((MaterialReuseEntry *) linitial(material_reuse_entries));
+
+	Assert(material_reuse_size == 0);
+	material_reuse_size = 0;
+
+	MemoryContextDelete(material_reuse_context);
+	material_reuse_context = NULL;
+}
+
+/*
+ * Called when a non-shared Material node first needs its tuplestore.
+ *
+ * Returns NULL if its result can't be kept: the node then makes its own
+ * tuplestore as usual.  Otherwise returns either a complete kept result of
+ * the same subplan to read, or a new entry whose tuplestore the node
+ * writes, and which MaterialReuseFinish may keep.
+ */
+static MaterialReuseEntry *
+MaterialReuseStart(MaterialState *node)
+{
+	EState	   *estate = node->ss.ps.state;
+	Plan	   *plan = node->ss.ps.plan;
+	MaterialReuseEntry *entry;
+	StringInfoData relids;
+	char	   *key;
+	uint32		hash;
+	ListCell   *lc;
+	ListCell   *next;
+	ListCell   *prev;
+	MemoryContext oldcxt;
+	ResourceOwner oldowner;
+
+	if (gp_workfile_reuse_limit <= 0 || !IsXactIsoLevelSerializable ||
+		estate->es_snapshot == NULL || !IsMVCCSnapshot(estate->es_snapshot) ||
+		plan->allParam != NULL || plan->extParam != NULL)
+		return NULL;
+
+	initStringInfo(&relids);
+	if (!MaterialReusePlanOk(outerPlan(plan), estate, &relids))
+	{
+		pfree(relids.data);
+		return NULL;
+	}
+
+	if (material_reuse_context == NULL)
+	{
+		material_reuse_context = AllocSetContextCreate(TopTransactionContext,
+													   "MaterialReuse",
+													   ALLOCSET_DEFAULT_MINSIZE,
+													   ALLOCSET_DEFAULT_INITSIZE,
+													   ALLOCSET_DEFAULT_MAXSIZE);
+		if (!material_reuse_callback_registered)
+		{
+			RegisterXactCallback(MaterialReuseXactCallback, NULL);
+			material_reuse_callback_registered = true;
+		}
+	}
+
+	oldcxt = MemoryContextSwitchTo(material_reuse_context);
+	key = nodeToString(outerPlan(plan));
+	key = repalloc(key, strlen(key) + relids.len + 1);
+	strcat(key, relids.data);
+	MemoryContextSwitchTo(oldcxt);
+	pfree(relids.data);
+
+	hash = DatumGetUInt32(hash_any((unsigned char *) key, strlen(key)));
+
+	/*
+	 * Look for a complete result.  Results of older command ids can never
+	 * be read again, drop those that aren't in use.
+	 */
+	prev = NULL;
+	for (lc = list_head(material_reuse_entries); lc != NULL; lc = next)
+	{
+		entry = (MaterialReuseEntry *) lfirst(lc);
+		next = lnext(lc);
+
+		if (entry->complete && entry->curcid == estate->es_snapshot->curcid &&
+			entry->hash == hash && strcmp(entry->key, key) == 0)
+		{
+			pfree(key);
+			entry->refcount++;
+			material_reuse_entries = list_delete_cell(material_reuse_entries, lc, prev);
+			oldcxt = MemoryContextSwitchTo(material_reuse_context);
+			material_reuse_entries = lcons(entry, material_reuse_entries);
+			MemoryContextSwitchTo(oldcxt);
+			return entry;
+		}
+
+		if (entry->complete && entry->refcount == 0 &&
+			entry->curcid != estate->es_snapshot->curcid)
+			MaterialReuseDrop(entry);
+		else
+			prev = lc;
+	}
+
+	/*
+	 * Write a new result.  The tuplestore and its workfile set must outlive
+	 * the query, so they are made in the transaction's memory context and
+	 * resource owner.
+	 */
+	oldcxt = MemoryContextSwitchTo(material_reuse_context);
+	entry = (MaterialReuseEntry *) palloc0(sizeof(MaterialReuseEntry));
+	entry->key = key;
+	entry->hash = hash;
+	entry->curcid = estate->es_snapshot->curcid;
+	entry->refcount = 1;
+
+	oldowner = CurrentResourceOwner;
+	CurrentResourceOwner = TopTransactionResourceOwner;
+	entry->work_set = workfile_mgr_create_set(BUFFILE, false /* can_reuse */, &node->ss.ps);
+	CurrentResourceOwner = oldowner;
+
+	entry->store = ntuplestore_create_workset(entry->work_set,
+											  PlanStateOperatorMemKB((PlanState *) node) * 1024);
+	material_reuse_entries = lcons(entry, material_reuse_entries);
+	MemoryContextSwitchTo(oldcxt);
+
+	return entry;
+}
+
+/*
+ * Called when a Material node has read all of its subplan.  Keeps the
+ * result it wrote if it spilled and fits in gp_workfile_reuse_limit, after
+ * dropping the least recently used results that aren't being read.
+ */
+static void
+MaterialReuseFinish(MaterialState *node)
+{
+	MaterialReuseEntry *entry = (MaterialReuseEntry *) node->reuse_entry;
+	int64		limit = (int64) gp_workfile_reuse_limit * 1024;
+	int64		size;
+	ListCell   *lc;
+
+	if (entry == NULL || entry->complete)
+		return;
+
+	/* A result that fits in memory is cheap to compute again */
+	if (!ntuplestore_has_workfiles(entry->store))
+		return;
+
+	size = entry->work_set->in_progress_size;
+	if (size > limit)
+		return;
+
+	/* An identical result may have been kept meanwhile */
+	foreach(lc, material_reuse_entries)
+	{
+		MaterialReuseEntry *other = (MaterialReuseEntry *) lfirst(lc);
+
+		if (other->complete && other->curcid == entry->curcid &&
+			other->hash == entry->hash && strcmp(other->key, entry->key) == 0)
+			return;
+	}
+
+	while (material_reuse_size + size > limit)
+	{
+		MaterialReuseEntry *victim = NULL;
+
+		foreach(lc, material_reuse_entries)
+		{
+			MaterialReuseEntry *other = (MaterialReuseEntry *) lfirst(lc);
+
+			if (other->complete && other->refcount == 0)
+				victim = other;
+		}
+
+		if (victim == NULL)
+			return;
+		MaterialReuseDrop(victim);
+	}
+
+	ntuplestore_keep_workfiles(entry->store);
+	entry->size = size;
+	entry->complete = true;
+	material_reuse_size += size;
 }
@@ -19,6 +19,7 @@
 #include "nodes/execnodes.h" /* Slice, SliceTable */
 #include "cdb/cdbheap.h"
 #include "cdb/cdbmotion.h"
+#include "cdb/cdbprogress.h"
 #include "cdb/cdbutil.h"
 #include "cdb/cdbvars.h"
 #include "cdb/cdbhash.h"
@@ -110,6 +111,7 @@ CdbMergeComparator_DestroyContext(CdbMergeComparatorContext *ctx);
  * FUNCTIONS PROTOTYPES
  */
 static TupleTableSlot *execMotionSender(MotionState * node);
+static TupleTableSlot *execMotionSenderHashBatch(MotionState * node);
 static TupleTableSlot *execMotionUnsortedReceiver(MotionState * node);
 static TupleTableSlot *execMotionSortedReceiver(MotionState * node);
 static TupleTableSlot *execMotionSortedReceiver_mk(MotionState * node);
@@ -119,9 +121,15 @@ static void execMotionSortedReceiverFirstTime(MotionState * node);
 static int
 CdbMergeComparator(void *lhs, void *rhs, void *context);
 static uint32 evalHashKey(ExprContext *econtext, List *hashkeys, List *hashtypes, CdbHash * h);
+static void evalHashKeyBatch(MotionState * node, int ntuples);
 
 static void doSendEndOfStream(Motion * motion, MotionState * node);
 static void doSendTuple(Motion * motion, MotionState * node, TupleTableSlot *outerTupleSlot);
+static void doSendTupleToRoute(Motion * motion, MotionState * node, TupleTableSlot *outerTupleSlot,
+							   int16 targetRoute);
+static bool isHotKeyHash(Motion * motion, uint32 hash);
+static void doSendHotKeyTuple(Motion * motion, MotionState * node, TupleTableSlot *outerTupleSlot);
+static void ExecMotionExplainEnd(PlanState *planstate, struct StringInfoData *buf);
 
 
 /*=========================================================================
@@ -165,7 +173,8 @@ bool isMotionGather(const Motion *m)
 }
 
 /*
- * Set the statistic info in gpmon packet.
+ * Set the statistic info in gpmon packet, and in the live progress
+ * counters.
  */
 static void
 setMotionStatsForGpmon(MotionState *node)
@@ -173,6 +182,23 @@ setMotionStatsForGpmon(MotionState *node)
 	ChunkTransportState *transportStates = node->ps.state->interconnect_context;
 	int motionId = ((Motion *) node->ps.plan)->motionID;
 
+	if (node->ps.progress)
+	{
+		MotionNodeEntry *pMNEntry;
+
+		pMNEntry = getMotionNodeEntry(node->ps.state->motionlayer_context,
+									  motionId, "setMotionStatsForGpmon");
+
+		/* a sender returns no tuples to ExecProcNode() to count */
+		if (node->mstype == MOTIONSTATE_SEND)
+		{
+			node->ps.progress->tuples = node->numTuplesToAMS;
+			node->ps.progress->motionBytes = pMNEntry->stat_total_bytes_sent;
+		}
+		else
+			node->ps.progress->motionBytes = pMNEntry->stat_total_bytes_recvd;
+	}
+
 	ChunkTransportStateEntry *transportEntry = NULL;
 	getChunkTransportState(transportStates, motionId, &transportEntry);
 	uint64 avgAckTime = 0;
@@ -299,6 +325,9 @@ execMotionSender(MotionState * node)
 			(motion->motionType == MOTIONTYPE_FIXED && motion->numOutputSegs <= 1));
 	Assert(node->ps.state->interconnect_context);
 
+	if (node->hashBatchSize > 1)
+		return execMotionSenderHashBatch(node);
+
 	while (!done)
 	{
 		/* grab TupleTableSlot from our child. */
@@ -372,6 +401,88 @@ execMotionSender(MotionState * node)
 	return NULL;
 }
 
+/*
+ * Sender logic for a redistribute motion that hashes its tuples in batches.
+ *
+ * Up to hashBatchSize tuples are copied out of the child's slot, their hash
+ * keys are evaluated and hashed one key column at a time, and they are then
+ * sent in the order they arrived.
+ */
+static TupleTableSlot *
+execMotionSenderHashBatch(MotionState * node)
+{
+	PlanState  *outerNode = outerPlanState(node);
+	Motion	   *motion = (Motion *) node->ps.plan;
+	bool		done = false;
+
+	Assert(motion->motionType == MOTIONTYPE_HASH);
+
+	while (!done)
+	{
+		int			ntuples = 0;
+		int			i;
+
+		/* grab a batch of tuples from our child. */
+		while (ntuples < node->hashBatchSize)
+		{
+			TupleTableSlot *outerTupleSlot = ExecProcNode(outerNode);
+
+			if (TupIsNull(outerTupleSlot))
+			{
+				done = true;
+				break;
+			}
+			ExecCopySlot(node->hashBatchSlots[ntuples++], outerTupleSlot);
+		}
+
+		if (ntuples > 0)
+		{
+			node->numTuplesFromChild += ntuples;
+
+			evalHashKeyBatch(node, ntuples);
+
+			for (i = 0; i < ntuples; i++)
+			{
+				int16		targetRoute = motion->outputSegIdx[node->hashBatchSegs[i]];
+
+				Assert(targetRoute != BROADCAST_SEGIDX);
+
+				if (motion->skewMode != MOTIONSKEW_NONE &&
+					isHotKeyHash(motion, node->hashBatchHashes[i]))
+					doSendHotKeyTuple(motion, node, node->hashBatchSlots[i]);
+				else
+					doSendTupleToRoute(motion, node, node->hashBatchSlots[i], targetRoute);
+				/* doSendTupleToRoute() may have set node->stopRequested */
+
+				Gpmon_Incr_Rows_Out(GpmonPktFromMotionState(node));
+				setMotionStatsForGpmon(node);
+				CheckSendPlanStateGpmonPkt(&node->ps);
+
+				if (node->stopRequested)
+					break;
+			}
+
+			for (i = 0; i < ntuples; i++)
+				ExecClearTuple(node->hashBatchSlots[i]);
+		}
+
+		if (node->stopRequested)
+		{
+			elog(gp_workfile_caching_loglevel, "Motion initiating Squelch walker");
+			/* propagate stop notification to our children */
+			ExecSquelchNode(outerNode);
+			done = true;
+		}
+		else if (done)
+			doSendEndOfStream(motion, node);
+	}
+
+	Assert(node->stopRequested || node->numTuplesFromChild == node->numTuplesToAMS);
+
+	/* nothing else to send out, so we return NULL up the tree. */
+	return NULL;
+}
+
 
 static TupleTableSlot *
 execMotionUnsortedReceiver(MotionState * node)
@@ -486,7 +597,23 @@ typedef struct MotionMKHeapContext
     MKHeapReader *readers;      /* Readers, one per sender */
     MKHeap *heap;               /* The mkheap */
     MKContext mkctxt;           /* compare context */
+    int nleaf;                  /* Number of leaf heaps, 0 if merging flat */
+    MKHeapReader *leafreaders;  /* Readers of the leaf heaps, for the top heap */
 } MotionMKHeapContext;
+
+/*
+ * With many senders, the senders can be split into groups of at most
+ * gp_motion_merge_fanout, each merged by a leaf heap of its own.  The top
+ * heap then merges the outputs of the leaf heaps, read through these.  All
+ * heaps share the compare context.
+ */
+typedef struct MotionMKLeafReaderContext
+{
+    MKHeapReader *readers;      /* This leaf's slice of the sender readers */
+    int nreader;
+    MKHeap *heap;               /* Built on the first read */
+    MKContext *mkctxt;
+} MotionMKLeafReaderContext;
     
 static bool motion_mkhp_read(void *vpctxt, MKEntry *a)
 {
@@ -541,6 +668,26 @@ static bool motion_mkhp_read(void *vpctxt, MKEntry *a)
     return false;
 }
 
+static bool motion_mkhp_read_leaf(void *vpctxt, MKEntry *a)
+{
+    MotionMKLeafReaderContext *ctxt = (MotionMKLeafReaderContext *) vpctxt;
+    void *ptr;
+
+    if (!ctxt->heap)
+        ctxt->heap = mkheap_from_reader(ctxt->readers, ctxt->nreader, ctxt->mkctxt);
+
+    mke_set_empty(a);
+    mkheap_putAndGet(ctxt->heap, a);
+    if (mke_is_empty(a))
+        return false;
+
+    /* Hand the tuple up as a fresh entry, as motion_mkhp_read() does */
+    ptr = a->ptr;
+    MemSet(a, 0, sizeof(MKEntry));
+    a->ptr = ptr;
+    return true;
+}
+
 static Datum tupsort_fetch_datum_motion(MKEntry *a, MKContext *mkctxt, MKLvContext *lvctxt, bool *isNullOut)
 {
 	Datum d;
@@ -587,6 +734,27 @@ static void create_motion_mk_heap(MotionState *node)
         ctxt->readers[i].mkhr_ctxt = hrctxt;
     }
 
+    /* Split the senders among leaf heaps if there are too many for one */
+    if (gp_motion_merge_fanout > 1 && nreader > gp_motion_merge_fanout)
+    {
+        int fanout = gp_motion_merge_fanout;
+
+        ctxt->nleaf = (nreader + fanout - 1) / fanout;
+        ctxt->leafreaders = palloc0(sizeof(MKHeapReader) * ctxt->nleaf);
+
+        for (i = 0; i < ctxt->nleaf; ++i)
+        {
+            MotionMKLeafReaderContext *lrctxt = palloc0(sizeof(MotionMKLeafReaderContext));
+            int first = i * fanout;
+
+            lrctxt->readers = ctxt->readers + first;
+            lrctxt->nreader = Min(fanout, nreader - first);
+            lrctxt->mkctxt = &ctxt->mkctxt;
+            ctxt->leafreaders[i].reader = motion_mkhp_read_leaf;
+            ctxt->leafreaders[i].mkhr_ctxt = lrctxt;
+        }
+    }
+
     node->tupleheap = (void *) ctxt;
 }
     
@@ -625,7 +793,10 @@ execMotionSortedReceiver_mk(MotionState * node)
     {
         Assert(ctxt->readers); 
         Assert(!ctxt->heap);
-        ctxt->heap = mkheap_from_reader(ctxt->readers, node->numInputSegs, &ctxt->mkctxt);
+        if (ctxt->nleaf > 0)
+            ctxt->heap = mkheap_from_reader(ctxt->leafreaders, ctxt->nleaf, &ctxt->mkctxt);
+        else
+            ctxt->heap = mkheap_from_reader(ctxt->readers, node->numInputSegs, &ctxt->mkctxt);
         node->tupleheapReady = true;
     }
 
@@ -895,6 +1066,8 @@ ExecInitMotion(Motion * node, EState *estate, int eflags)
 	motionstate->stopRequested = false;
 	motionstate->hashExpr = NULL;
 	motionstate->cdbhash = NULL;
+	motionstate->hashBatchSize = 1;
+	motionstate->hashBatchSlots = NULL;
 
     /* Look up the sending gang's slice table entry. */
     sendSlice = (Slice *)list_nth(sliceTable->slices, node->motionID);
@@ -1014,6 +1187,31 @@ ExecInitMotion(Motion * node, EState *estate, int eflags)
 		 * Create hash API reference
 		 */
 		motionstate->cdbhash = makeCdbHash(node->numOutputSegs);
+
+		/*
+		 * Each sender starts spreading hot-key rows at a different segment,
+		 * so that the first rows of every sender don't all go to one place.
+		 */
+		if (node->skewMode == MOTIONSKEW_SPREAD)
+			motionstate->skewNextRoute = Max(GpIdentity.segindex, 0) % node->numOutputSegs;
+
+		/*
+		 * Set up for hashing the tuples in batches, if enabled.
+		 */
+		motionstate->hashBatchSize = gp_motion_hash_batch_size;
+		if (motionstate->hashBatchSize > 1)
+		{
+			int			batchSize = motionstate->hashBatchSize;
+			int			i;
+
+			motionstate->hashBatchSlots = palloc(batchSize * sizeof(TupleTableSlot *));
+			for (i = 0; i < batchSize; i++)
+				motionstate->hashBatchSlots[i] = MakeSingleTupleTableSlot(tupDesc);
+			motionstate->hashBatchValues = palloc(batchSize * sizeof(Datum));
+			motionstate->hashBatchIsnull = palloc(batchSize * sizeof(bool));
+			motionstate->hashBatchHashes = palloc(batchSize * sizeof(uint32));
+			motionstate->hashBatchSegs = palloc(batchSize * sizeof(unsigned int));
+		}
     }
 
 	/* Merge Receive: Set up the key comparator and priority queue. */
@@ -1050,6 +1248,12 @@ ExecInitMotion(Motion * node, EState *estate, int eflags)
 			tupDesc, 
 			PlanStateOperatorMemKB((PlanState *) motionstate));
 
+	/*
+	 * CDB: Offer extra info for EXPLAIN ANALYZE.
+	 */
+	if (estate->es_instrument && motionstate->mstype == MOTIONSTATE_RECV)
+		motionstate->ps.cdbexplainfun = ExecMotionExplainEnd;
+
 	
 #ifdef CDB_MOTION_DEBUG
     motionstate->outputFunArray = (Oid *)palloc(tupDesc->natts * sizeof(Oid));
@@ -1074,6 +1278,19 @@ ExecInitMotion(Motion * node, EState *estate, int eflags)
 	return motionstate;
 }
 
+/*
+ * ExecMotionExplainEnd
+ *      Called before ExecutorEnd to finish EXPLAIN ANALYZE reporting.
+ */
+static void
+ExecMotionExplainEnd(PlanState *planstate, struct StringInfoData *buf)
+{
+	Motion	   *motion = (Motion *) planstate->plan;
+
+	ExplainMotionLayerNode(planstate->state->motionlayer_context,
+						   motion->motionID, buf);
+}								/* ExecMotionExplainEnd */
+
 #define MOTION_NSLOTS 1
 
 /* ----------------------------------------------------------------
@@ -1187,6 +1404,20 @@ ExecEndMotion(MotionState * node)
 		node->cdbhash = NULL;
 	}
 
+	if (node->hashBatchSlots != NULL)
+	{
+		int			i;
+
+		for (i = 0; i < node->hashBatchSize; i++)
+			ExecDropSingleTupleTableSlot(node->hashBatchSlots[i]);
+		pfree(node->hashBatchSlots);
+		pfree(node->hashBatchValues);
+		pfree(node->hashBatchIsnull);
+		pfree(node->hashBatchHashes);
+		pfree(node->hashBatchSegs);
+		node->hashBatchSlots = NULL;
+	}
+
 	/*
 	 * Free up this motion node's resources in the Motion Layer.
 	 *
@@ -1389,6 +1620,68 @@ evalHashKey(ExprContext *econtext, List *hashkeys, List *hashtypes, CdbHash * h)
 	return cdbhashreduce(h);
 }
 
+/*
+ * Batch version of evalHashKey(), computing the target segment of each of
+ * the first ntuples tuples in node->hashBatchSlots into node->hashBatchSegs.
+ *
+ * Key values are evaluated in the per-tuple memory of the expression
+ * context, which is only reset once per batch.
+ */
+static void
+evalHashKeyBatch(MotionState * node, int ntuples)
+{
+	Motion	   *motion = (Motion *) node->ps.plan;
+	ExprContext *econtext = node->ps.ps_ExprContext;
+	CdbHash    *h = node->cdbhash;
+	uint32	   *hashes = node->hashBatchHashes;
+	MemoryContext oldContext;
+	int			i;
+
+	Assert(h->numsegs == motion->numOutputSegs);
+
+	ResetExprContext(econtext);
+
+	oldContext = MemoryContextSwitchTo(econtext->ecxt_per_tuple_memory);
+
+	cdbhashinit_batch(hashes, ntuples);
+
+	/* As in evalHashKey(), use cdbhashnokey_batch() for an empty policy */
+	if (list_length(node->hashExpr) > 0)
+	{
+		ListCell   *hk;
+		ListCell   *ht;
+
+		forboth(hk, node->hashExpr, ht, motion->hashDataTypes)
+		{
+			ExprState  *keyexpr = (ExprState *) lfirst(hk);
+
+			for (i = 0; i < ntuples; i++)
+			{
+				econtext->ecxt_outertuple = node->hashBatchSlots[i];
+				node->hashBatchValues[i] = ExecEvalExpr(keyexpr, econtext,
+														&node->hashBatchIsnull[i],
+														NULL);
+			}
+
+			cdbhash_batch(hashes, ntuples, node->hashBatchValues,
+						  node->hashBatchIsnull, lfirst_oid(ht));
+		}
+	}
+	else
+	{
+		cdbhashnokey_batch(h, hashes, ntuples);
+	}
+
+	MemoryContextSwitchTo(oldContext);
+
+	cdbhashreduce_batch(h, hashes, ntuples, node->hashBatchSegs);
+
+#ifdef USE_ASSERT_CHECKING
+	for (i = 0; i < ntuples; i++)
+		Assert(node->hashBatchSegs[i] < getgpsegmentCount() && "redistribute destination outside segment array");
+#endif
+}
+
 
 void
 doSendEndOfStream(Motion * motion, MotionState * node)
@@ -1433,8 +1726,6 @@ void
 doSendTuple(Motion * motion, MotionState * node, TupleTableSlot *outerTupleSlot)
 {
 	int16		    targetRoute;
-	HeapTuple       tuple;
-	SendReturnCode  sendRC;
 	ExprContext    *econtext = node->ps.ps_ExprContext;
 	
 	/* We got a tuple from the child-plan. */
@@ -1474,6 +1765,13 @@ doSendTuple(Motion * motion, MotionState * node, TupleTableSlot *outerTupleSlot)
 				motion->hashDataTypes, node->cdbhash);
 
 		Assert(hval < getgpsegmentCount() && "redistribute destination outside segment array");
+
+		if (motion->skewMode != MOTIONSKEW_NONE &&
+			isHotKeyHash(motion, node->cdbhash->hash))
+		{
+			doSendHotKeyTuple(motion, node, outerTupleSlot);
+			return;
+		}
 		
 		/* hashSegIdx takes our uint32 and maps it to an int, and here
 		 * we assign it to an int16. See below. */
@@ -1499,6 +1797,72 @@ doSendTuple(Motion * motion, MotionState * node, TupleTableSlot *outerTupleSlot)
 		Assert(!is_null);
 	}
 
+	doSendTupleToRoute(motion, node, outerTupleSlot, targetRoute);
+}
+
+/*
+ * Is 'hash' the cdbhash() value of one of the motion's hot join keys?
+ */
+static bool
+isHotKeyHash(Motion * motion, uint32 hash)
+{
+	int			lo = 0;
+	int			hi = motion->numSkewHashes - 1;
+
+	while (lo <= hi)
+	{
+		int			mid = (lo + hi) / 2;
+
+		if (motion->skewHashes[mid] == hash)
+			return true;
+		if (motion->skewHashes[mid] < hash)
+			lo = mid + 1;
+		else
+			hi = mid - 1;
+	}
+	return false;
+}
+
+/*
+ * Send a tuple whose hash key is one of the hot join keys.
+ *
+ * On the spread side of the join the tuples go round-robin to the output
+ * segments; on the other side each one goes to all of them.  The broadcast
+ * is done one route at a time rather than with BROADCAST_SEGIDX so that the
+ * record cache bookkeeping, which is per connection for point-to-point sends,
+ * stays right for the tuples that are hashed as usual.
+ */
+static void
+doSendHotKeyTuple(Motion * motion, MotionState * node, TupleTableSlot *outerTupleSlot)
+{
+	if (motion->skewMode == MOTIONSKEW_SPREAD)
+	{
+		int16		targetRoute = motion->outputSegIdx[node->skewNextRoute];
+
+		node->skewNextRoute = (node->skewNextRoute + 1) % motion->numOutputSegs;
+		doSendTupleToRoute(motion, node, outerTupleSlot, targetRoute);
+	}
+	else
+	{
+		int			i;
+
+		Assert(motion->skewMode == MOTIONSKEW_BROADCAST);
+
+		for (i = 0; i < motion->numOutputSegs && !node->stopRequested; i++)
+			doSendTupleToRoute(motion, node, outerTupleSlot, motion->outputSegIdx[i]);
+	}
+}
+
+/*
+ * Send one tuple to the given route, the second half of doSendTuple().
+ */
+static void
+doSendTupleToRoute(Motion * motion, MotionState * node, TupleTableSlot *outerTupleSlot,
+				   int16 targetRoute)
+{
+	HeapTuple       tuple;
+	SendReturnCode  sendRC;
+
 	tuple = ExecFetchSlotGenericTuple(outerTupleSlot, true);
 
 	CheckAndSendRecordCache(node->ps.state->motionlayer_context,
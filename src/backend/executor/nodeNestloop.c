@@ -23,12 +23,80 @@
 
 #include "postgres.h"
 
+#include "access/nbtree.h"
+#include "catalog/pg_am.h"
+#include "cdb/cdbvars.h"
 #include "executor/execdebug.h"
 #include "executor/nodeNestloop.h"
+#include "nodes/nodeFuncs.h"
+#include "optimizer/clauses.h"
+#include "utils/datum.h"
+#include "utils/lsyscache.h"
 #include "utils/memutils.h"
 
+/*
+ * Batched probing of an inner index scan.
+ *
+ * When the inner side is an index scan whose keys are computed from the
+ * outer tuple, the join reads gp_nestloop_probe_batch outer tuples ahead.
+ * It sorts them on the key values, runs the index scan once for each
+ * distinct key, in key order so that consecutive probes descend to the same
+ * or neighbouring btree pages, and keeps the inner tuples each probe
+ * returned. The outer tuples are then joined in their original order, each
+ * with the inner tuples cached for its key, so the join's output is the
+ * same as with one probe per outer tuple.
+ *
+ * The inner tuples cached for one batch are limited to work_mem. Once that
+ * is reached, the remaining keys of the batch aren't probed ahead, and their
+ * outer tuples rescan the index scan as usual.
+ */
+typedef struct NestLoopBatchRow
+{
+	void	   *tuple;			/* copy of the outer tuple */
+	Datum	   *keys;			/* its index scan key values */
+	bool	   *keynulls;
+	int			group;			/* its distinct key, index into groups */
+} NestLoopBatchRow;
+
+typedef struct NestLoopBatchGroup
+{
+	bool		cached;			/* false: probe for each outer tuple */
+	int			ntuples;
+	void	  **tuples;			/* copies of the inner tuples */
+} NestLoopBatchGroup;
+
+typedef struct NestLoopBatch
+{
+	int			maxRows;
+	IndexRuntimeKeyInfo *keyInfo;	/* the inner index scan's runtime keys */
+	int			nkeys;
+	FmgrInfo   *cmpProcs;		/* btree comparison procs of the keys */
+	int16	   *keyLens;
+	bool	   *keyByVals;
+
+	MemoryContext cxt;			/* tuples of the current batch */
+	Size		cacheLimit;
+	TupleTableSlot *outerSlot;
+	TupleTableSlot *innerSlot;
+
+	NestLoopBatchRow *rows;
+	int		   *order;			/* rows sorted on their keys */
+	NestLoopBatchGroup *groups;
+	int			nrows;
+	int			ngroups;
+	bool		outerDone;
+
+	int			next;			/* next row to join */
+	NestLoopBatchGroup *current;	/* key group of the row being joined */
+	int			nextInner;		/* next cached inner tuple to return */
+} NestLoopBatch;
+
 static void splitJoinQualExpr(NestLoopState *nlstate);
 static void extractFuncExprArgs(FuncExprState *fstate, List **lclauses, List **rclauses);
+static NestLoopBatch *ExecInitNestLoopBatch(NestLoopState *nlstate, NestLoop *node,
+											EState *estate, int eflags);
+static TupleTableSlot *NestLoopBatchNextOuter(NestLoopState *node);
+static TupleTableSlot *NestLoopBatchNextInner(NestLoopState *node);
 
 /* ----------------------------------------------------------------
  *		ExecNestLoop(node)
@@ -165,8 +233,13 @@ ExecNestLoop(NestLoopState *node)
 		if (node->nl_NeedNewOuter)
 		{
 			ENL1_printf("getting new outer tuple");
-			outerTupleSlot = ExecProcNode(outerPlan);
-			Gpmon_Incr_Rows_In(GpmonPktFromNLJState(node));
+			if (node->nl_batch)
+				outerTupleSlot = NestLoopBatchNextOuter(node);
+			else
+			{
+				outerTupleSlot = ExecProcNode(outerPlan);
+				Gpmon_Incr_Rows_In(GpmonPktFromNLJState(node));
+			}
 
 			/*
 			 * if there are no more outer tuples, then the join is complete..
@@ -214,9 +287,11 @@ ExecNestLoop(NestLoopState *node)
 			/*
 			 * The scan key of the inner plan might depend on the current
 			 * outer tuple (e.g. in index scans), that's why we pass our expr
-			 * context.
+			 * context.  In batched mode, NestLoopBatchNextOuter has already
+			 * set up the inner tuples.
 			 */
-			if ( node->require_inner_reset || node->reset_inner )
+			if (node->nl_batch == NULL &&
+				(node->require_inner_reset || node->reset_inner))
 			{
 				ExecReScan(innerPlan, econtext);
 				node->reset_inner = false;
@@ -228,7 +303,10 @@ ExecNestLoop(NestLoopState *node)
 		 */
 		ENL1_printf("getting new inner tuple");
 
-		innerTupleSlot = ExecProcNode(innerPlan);
+		if (node->nl_batch)
+			innerTupleSlot = NestLoopBatchNextInner(node);
+		else
+			innerTupleSlot = ExecProcNode(innerPlan);
 		CheckSendPlanStateGpmonPkt(&node->js.ps);
 
 		node->reset_inner = true;
@@ -449,7 +527,7 @@ ExecInitNestLoop(NestLoop *node, EState *estate, int eflags)
 				eflags | EXEC_FLAG_REWIND);
 	}
 
-#define NESTLOOP_NSLOTS 2
+#define NESTLOOP_NSLOTS 4
 
 	/*
 	 * tuple table initialization
@@ -487,6 +565,8 @@ ExecInitNestLoop(NestLoop *node, EState *estate, int eflags)
 	nlstate->nl_MatchedOuter = false;
 	nlstate->nl_innerSquelchNeeded = true;		/*CDB*/
 
+	nlstate->nl_batch = ExecInitNestLoopBatch(nlstate, node, estate, eflags);
+
 
     if (node->join.jointype == JOIN_LASJ_NOTIN)
     {
@@ -541,6 +621,13 @@ ExecEndNestLoop(NestLoopState *node)
 	 */
 	ExecClearTuple(node->js.ps.ps_ResultTupleSlot);
 
+	if (node->nl_batch)
+	{
+		ExecClearTuple(node->nl_batch->outerSlot);
+		ExecClearTuple(node->nl_batch->innerSlot);
+		MemoryContextDelete(node->nl_batch->cxt);
+	}
+
 	/*
 	 * close down subplans
 	 */
@@ -578,6 +665,19 @@ ExecReScanNestLoop(NestLoopState *node, ExprContext *exprCtxt)
 	node->nl_MatchedOuter = false;
 	node->nl_innerSideScanned = false;
 	/* CDB: We intentionally leave node->nl_innerSquelchNeeded unchanged on ReScan */
+
+	/* The inner tuples cached for a key may change with the parameters */
+	if (node->nl_batch)
+	{
+		NestLoopBatch *batch = node->nl_batch;
+
+		ExecClearTuple(batch->outerSlot);
+		ExecClearTuple(batch->innerSlot);
+		MemoryContextReset(batch->cxt);
+		batch->nrows = 0;
+		batch->next = 0;
+		batch->outerDone = false;
+	}
 }
 
 void
@@ -667,3 +767,381 @@ extractFuncExprArgs(FuncExprState *fstate, List **lclauses, List **rclauses)
 	*lclauses = lappend(*lclauses, linitial(fstate->args));
 	*rclauses = lappend(*rclauses, lsecond(fstate->args));
 }
+
+/*
+ * Does the expression reference the outer tuple of a join?
+ */
+static bool
+contain_outer_vars_walker(Node *node, void *context)
+{
+	if (node == NULL)
+		return false;
+	if (IsA(node, Var))
+		return ((Var *) node)->varno == OUTER;
+	return expression_tree_walker(node, contain_outer_vars_walker, context);
+}
+
+/* ----------------------------------------------------------------
+ * ExecInitNestLoopBatch
+ *
+ * Set up batched probing of the inner index scan, or return NULL if the
+ * join doesn't qualify for it.
+ * ----------------------------------------------------------------
+ */
+static NestLoopBatch *
+ExecInitNestLoopBatch(NestLoopState *nlstate, NestLoop *node,
+					  EState *estate, int eflags)
+{
+	NestLoopBatch *batch;
+	IndexScanState *inner;
+	IndexScan  *innerNode;
+	Relation	index;
+	Oid		   *keyTypes;
+	Datum	   *keys;
+	bool	   *keynulls;
+	int			nkeys;
+	int			i;
+
+	if (gp_nestloop_probe_batch <= 1 ||
+		(eflags & EXEC_FLAG_EXPLAIN_ONLY) != 0 ||
+		nlstate->prefetch_inner ||
+		nlstate->shared_outer ||
+		!nlstate->require_inner_reset)
+		return NULL;
+
+	switch (node->join.jointype)
+	{
+		case JOIN_INNER:
+		case JOIN_LEFT:
+		case JOIN_SEMI:
+		case JOIN_ANTI:
+			break;
+		default:
+			return NULL;
+	}
+
+	/*
+	 * The inner side must be a btree index scan whose result depends on the
+	 * outer tuple only through its runtime keys, and in the same way every
+	 * time it is run with the same key values.  Array keys (= ANY) may also
+	 * be computed from the outer tuple, and aren't part of the cache key.
+	 */
+	if (!IsA(innerPlanState(nlstate), IndexScanState))
+		return NULL;
+	inner = (IndexScanState *) innerPlanState(nlstate);
+	innerNode = (IndexScan *) inner->ss.ps.plan;
+	index = inner->iss_RelationDesc;
+	nkeys = inner->iss_NumRuntimeKeys;
+
+	if (nkeys == 0 ||
+		inner->iss_NumArrayKeys != 0 ||
+		index->rd_rel->relam != BTREE_AM_OID ||
+		contain_volatile_functions((Node *) innerNode->indexqualorig) ||
+		contain_volatile_functions((Node *) innerNode->scan.plan.qual) ||
+		contain_volatile_functions((Node *) innerNode->scan.plan.targetlist) ||
+		contain_outer_vars_walker((Node *) innerNode->scan.plan.qual, NULL) ||
+		contain_outer_vars_walker((Node *) innerNode->scan.plan.targetlist, NULL))
+		return NULL;
+
+	/*
+	 * The key values are sorted with the comparison proc of the index
+	 * column's operator family, for the type the scan compares them as.
+	 */
+	keyTypes = palloc(nkeys * sizeof(Oid));
+	for (i = 0; i < nkeys; i++)
+	{
+		ScanKey		scanKey = inner->iss_RuntimeKeys[i].scan_key;
+		int			col = scanKey->sk_attno - 1;
+
+		keyTypes[i] = OidIsValid(scanKey->sk_subtype) ?
+			scanKey->sk_subtype : index->rd_opcintype[col];
+
+		if (contain_volatile_functions((Node *) inner->iss_RuntimeKeys[i].key_expr->expr) ||
+			!OidIsValid(get_opfamily_proc(index->rd_opfamily[col],
+										  keyTypes[i], keyTypes[i],
+										  BTORDER_PROC)))
+		{
+			pfree(keyTypes);
+			return NULL;
+		}
+	}
+
+	batch = palloc0(sizeof(NestLoopBatch));
+	batch->maxRows = gp_nestloop_probe_batch;
+	batch->keyInfo = inner->iss_RuntimeKeys;
+	batch->nkeys = nkeys;
+	batch->cmpProcs = palloc(nkeys * sizeof(FmgrInfo));
+	batch->keyLens = palloc(nkeys * sizeof(int16));
+	batch->keyByVals = palloc(nkeys * sizeof(bool));
+	for (i = 0; i < nkeys; i++)
+	{
+		int			col = inner->iss_RuntimeKeys[i].scan_key->sk_attno - 1;
+
+		fmgr_info(get_opfamily_proc(index->rd_opfamily[col],
+									keyTypes[i], keyTypes[i],
+									BTORDER_PROC),
+				  &batch->cmpProcs[i]);
+		get_typlenbyval(keyTypes[i], &batch->keyLens[i], &batch->keyByVals[i]);
+	}
+	pfree(keyTypes);
+
+	batch->rows = palloc(batch->maxRows * sizeof(NestLoopBatchRow));
+	keys = palloc(batch->maxRows * nkeys * sizeof(Datum));
+	keynulls = palloc(batch->maxRows * nkeys * sizeof(bool));
+	for (i = 0; i < batch->maxRows; i++)
+	{
+		batch->rows[i].keys = keys + i * nkeys;
+		batch->rows[i].keynulls = keynulls + i * nkeys;
+	}
+	batch->order = palloc(batch->maxRows * sizeof(int));
+	batch->groups = palloc(batch->maxRows * sizeof(NestLoopBatchGroup));
+
+	batch->cxt = AllocSetContextCreate(CurrentMemoryContext,
+									   "NestLoopBatch",
+									   ALLOCSET_DEFAULT_MINSIZE,
+									   ALLOCSET_DEFAULT_INITSIZE,
+									   ALLOCSET_DEFAULT_MAXSIZE);
+	batch->cacheLimit = (Size) work_mem * 1024L;
+
+	batch->outerSlot = ExecInitExtraTupleSlot(estate);
+	ExecSetSlotDescriptor(batch->outerSlot,
+						  ExecGetResultType(outerPlanState(nlstate)));
+	batch->innerSlot = ExecInitExtraTupleSlot(estate);
+	ExecSetSlotDescriptor(batch->innerSlot,
+						  ExecGetResultType(innerPlanState(nlstate)));
+
+	return batch;
+}
+
+/*
+ * Order batch rows, given by their index in the batch, on their key values.
+ * NULL keys sort last.
+ */
+static int
+NestLoopBatchCompare(const void *a, const void *b, void *arg)
+{
+	NestLoopBatch *batch = (NestLoopBatch *) arg;
+	NestLoopBatchRow *rowa = &batch->rows[*(const int *) a];
+	NestLoopBatchRow *rowb = &batch->rows[*(const int *) b];
+	int			i;
+
+	for (i = 0; i < batch->nkeys; i++)
+	{
+		int32		cmp;
+
+		if (rowa->keynulls[i] || rowb->keynulls[i])
+		{
+			if (rowa->keynulls[i] && rowb->keynulls[i])
+				continue;
+			return rowa->keynulls[i] ? 1 : -1;
+		}
+
+		cmp = DatumGetInt32(FunctionCall2(&batch->cmpProcs[i],
+										  rowa->keys[i], rowb->keys[i]));
+		if (cmp != 0)
+			return cmp;
+	}
+
+	return 0;
+}
+
+/*
+ * Read the next batch of outer tuples, and probe the inner index scan for
+ * each of their distinct keys, in key order.
+ */
+static void
+NestLoopBatchFill(NestLoopState *node)
+{
+	NestLoopBatch *batch = node->nl_batch;
+	PlanState  *outerPlan = outerPlanState(node);
+	PlanState  *innerPlan = innerPlanState(node);
+	ExprContext *econtext = node->js.ps.ps_ExprContext;
+	MemoryContext oldcxt;
+	Size		cached = 0;
+	bool		caching = true;
+	int			i;
+	int			j;
+
+	ExecClearTuple(batch->outerSlot);
+	ExecClearTuple(batch->innerSlot);
+	MemoryContextReset(batch->cxt);
+	batch->nrows = 0;
+	batch->ngroups = 0;
+	batch->next = 0;
+
+	while (batch->nrows < batch->maxRows)
+	{
+		TupleTableSlot *slot = ExecProcNode(outerPlan);
+		NestLoopBatchRow *row = &batch->rows[batch->nrows];
+
+		Gpmon_Incr_Rows_In(GpmonPktFromNLJState(node));
+
+		if (TupIsNull(slot))
+		{
+			batch->outerDone = true;
+			break;
+		}
+
+		econtext->ecxt_outertuple = slot;
+		for (j = 0; j < batch->nkeys; j++)
+		{
+			Datum		value;
+
+			value = ExecEvalExprSwitchContext(batch->keyInfo[j].key_expr,
+											  econtext,
+											  &row->keynulls[j],
+											  NULL);
+
+			oldcxt = MemoryContextSwitchTo(batch->cxt);
+			row->keys[j] = row->keynulls[j] ? (Datum) 0 :
+				datumCopy(value, batch->keyByVals[j], batch->keyLens[j]);
+			MemoryContextSwitchTo(oldcxt);
+		}
+
+		oldcxt = MemoryContextSwitchTo(batch->cxt);
+		row->tuple = ExecCopyGenericTuple(slot);
+		MemoryContextSwitchTo(oldcxt);
+
+		ResetExprContext(econtext);
+
+		batch->order[batch->nrows] = batch->nrows;
+		batch->nrows++;
+	}
+
+	qsort_arg(batch->order, batch->nrows, sizeof(int),
+			  NestLoopBatchCompare, batch);
+
+	for (i = 0; i < batch->nrows; i++)
+	{
+		NestLoopBatchRow *row = &batch->rows[batch->order[i]];
+		NestLoopBatchGroup *group;
+		int			maxtuples = 0;
+
+		if (i > 0 && NestLoopBatchCompare(&batch->order[i - 1],
+										  &batch->order[i], batch) == 0)
+		{
+			row->group = batch->ngroups - 1;
+			continue;
+		}
+
+		row->group = batch->ngroups;
+		group = &batch->groups[batch->ngroups++];
+		group->cached = false;
+		group->ntuples = 0;
+		group->tuples = NULL;
+
+		if (!caching)
+			continue;
+
+		/* Probe for this key, with this row as the outer tuple */
+		ExecStoreGenericTuple(row->tuple, batch->outerSlot, false);
+		econtext->ecxt_outertuple = batch->outerSlot;
+		ExecReScan(innerPlan, econtext);
+		group->cached = true;
+
+		for (;;)
+		{
+			TupleTableSlot *slot = ExecProcNode(innerPlan);
+			void	   *tuple;
+
+			if (TupIsNull(slot))
+				break;
+
+			oldcxt = MemoryContextSwitchTo(batch->cxt);
+			tuple = ExecCopyGenericTuple(slot);
+			if (group->ntuples == maxtuples)
+			{
+				maxtuples = Max(maxtuples * 2, 4);
+				if (group->tuples == NULL)
+					group->tuples = palloc(maxtuples * sizeof(void *));
+				else
+					group->tuples = repalloc(group->tuples,
+											 maxtuples * sizeof(void *));
+			}
+			MemoryContextSwitchTo(oldcxt);
+
+			group->tuples[group->ntuples++] = tuple;
+			cached += GetMemoryChunkSpace(tuple);
+
+			if (cached > batch->cacheLimit)
+			{
+				/*
+				 * Out of memory for the cache. The outer tuples of this
+				 * and the remaining keys rescan the inner side themselves.
+				 */
+				for (j = 0; j < group->ntuples; j++)
+					pfree(group->tuples[j]);
+				pfree(group->tuples);
+				group->cached = false;
+				group->ntuples = 0;
+				group->tuples = NULL;
+				caching = false;
+				break;
+			}
+		}
+	}
+
+	ExecClearTuple(batch->outerSlot);
+}
+
+/*
+ * Return the next outer tuple to join, reading and probing a new batch if
+ * the current one is used up, or NULL at the end of the outer side.
+ */
+static TupleTableSlot *
+NestLoopBatchNextOuter(NestLoopState *node)
+{
+	NestLoopBatch *batch = node->nl_batch;
+	NestLoopBatchRow *row;
+
+	if (batch->next == batch->nrows)
+	{
+		if (!batch->outerDone)
+			NestLoopBatchFill(node);
+
+		if (batch->next == batch->nrows)
+		{
+			/* Release the last batch's tuples */
+			ExecClearTuple(batch->outerSlot);
+			ExecClearTuple(batch->innerSlot);
+			MemoryContextReset(batch->cxt);
+			batch->nrows = batch->next = 0;
+			return NULL;
+		}
+	}
+
+	row = &batch->rows[batch->next++];
+	ExecStoreGenericTuple(row->tuple, batch->outerSlot, false);
+	batch->current = &batch->groups[row->group];
+	batch->nextInner = 0;
+
+	if (!batch->current->cached)
+	{
+		ExprContext *econtext = node->js.ps.ps_ExprContext;
+
+		econtext->ecxt_outertuple = batch->outerSlot;
+		ExecReScan(innerPlanState(node), econtext);
+	}
+
+	return batch->outerSlot;
+}
+
+/*
+ * Return the next inner tuple for the current outer tuple, or NULL if there
+ * are no more.
+ */
+static TupleTableSlot *
+NestLoopBatchNextInner(NestLoopState *node)
+{
+	NestLoopBatch *batch = node->nl_batch;
+	NestLoopBatchGroup *group = batch->current;
+
+	if (!group->cached)
+		return ExecProcNode(innerPlanState(node));
+
+	if (batch->nextInner == group->ntuples)
+		return NULL;
+
+	return ExecStoreGenericTuple(group->tuples[batch->nextInner++],
+								 batch->innerSlot, false);
+}
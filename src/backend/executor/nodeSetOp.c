@@ -11,6 +11,13 @@
  * Then it is a simple matter to emit the output demanded by the SQL spec
  * for INTERSECT, INTERSECT ALL, EXCEPT, or EXCEPT ALL.
  *
+ * In SETOP_HASHED mode, the input need not be sorted.  Instead, the node
+ * counts the tuples of each group in a hash table, and emits the output
+ * once the whole input has been read.  If the hash table outgrows the
+ * operator's memory, tuples of groups that are not in it yet are written
+ * to spill files instead, split by hash value, and each spill file is
+ * processed the same way once the hash table has been emitted.
+ *
  * This node type is not used for UNION or UNION ALL, since those can be
  * implemented more cheaply (there's no need for the junk attribute to
  * identify the source relation).
@@ -34,11 +41,92 @@
 
 #include "postgres.h"
 
+#include "access/hash.h"
 #include "cdb/cdbvars.h"
 #include "executor/executor.h"
+#include "executor/instrument.h"
 #include "executor/nodeSetOp.h"
 #include "utils/memutils.h"
+#include "utils/workfile_mgr.h"
+
+/*
+ * Number of spill files the tuples are split into each time the hash table
+ * fills up, and how many times a tuple may be spilled again when its spill
+ * file doesn't fit either.  After that, the hash table just grows.
+ */
+#define SETOP_SPILL_FILES		32
+#define SETOP_MAX_SPILL_DEPTH	4
+
+/*
+ * SetOpHashEntryData is the per-group data kept in the hash table.
+ */
+typedef struct SetOpHashEntryData
+{
+	TupleHashEntryData shared;	/* common header for hash table entries */
+	long		numLeft;		/* number of left-input dups in group */
+	long		numRight;		/* number of right-input dups in group */
+} SetOpHashEntryData;
+
+typedef SetOpHashEntryData *SetOpHashEntry;
+
+/*
+ * A spill file holds the input tuples of groups that didn't fit in the hash
+ * table.  depth is the number of times its tuples have been spilled.
+ */
+struct SetOpSpillFile
+{
+	ExecWorkFile *file;
+	int			depth;
+};
 
+static void set_output_count(SetOpState *setopstate, SetOp *plannode);
+static TupleTableSlot *ExecSetOpHashed(SetOpState *setopstate);
+static void build_hash_table(SetOpState *setopstate);
+static void setop_fill_hash_table(SetOpState *setopstate);
+static void setop_spill_tuple(SetOpState *setopstate, TupleTableSlot *slot,
+				  int depth);
+static TupleTableSlot *setop_read_spilled(SetOpState *setopstate);
+static void setop_close_spill_files(SetOpState *setopstate);
+
+
+/*
+ * Decide how many copies of a group to emit, given the number of tuples of
+ * it that came from each input.  This logic is straight from the SQL92
+ * specification.
+ */
+static void
+set_output_count(SetOpState *setopstate, SetOp *plannode)
+{
+	switch (plannode->cmd)
+	{
+		case SETOPCMD_INTERSECT:
+			if (setopstate->numLeft > 0 && setopstate->numRight > 0)
+				setopstate->numOutput = 1;
+			else
+				setopstate->numOutput = 0;
+			break;
+		case SETOPCMD_INTERSECT_ALL:
+			setopstate->numOutput =
+				(setopstate->numLeft < setopstate->numRight) ?
+				setopstate->numLeft : setopstate->numRight;
+			break;
+		case SETOPCMD_EXCEPT:
+			if (setopstate->numLeft > 0 && setopstate->numRight == 0)
+				setopstate->numOutput = 1;
+			else
+				setopstate->numOutput = 0;
+			break;
+		case SETOPCMD_EXCEPT_ALL:
+			setopstate->numOutput =
+				(setopstate->numLeft < setopstate->numRight) ?
+				0 : (setopstate->numLeft - setopstate->numRight);
+			break;
+		default:
+			elog(ERROR, "unrecognized set op: %d",
+				 (int) plannode->cmd);
+			break;
+	}
+}
 
 /* ----------------------------------------------------------------
  *		ExecSetOp
@@ -70,6 +158,9 @@ ExecSetOp(SetOpState *node)
 	/* Flag that we have no current tuple */
 	ExecClearTuple(resultTupleSlot);
 
+	if (plannode->strategy == SETOP_HASHED)
+		return ExecSetOpHashed(node);
+
 	/*
 	 * Absorb groups of duplicate tuples, counting them, and saving the first
 	 * of each group as a possible return value. At the end of each group,
@@ -139,38 +230,9 @@ ExecSetOp(SetOpState *node)
 		{
 			/*
 			 * We've reached the end of the group containing resultTuple.
-			 * Decide how many copies (if any) to emit.  This logic is
-			 * straight from the SQL92 specification.
+			 * Decide how many copies (if any) to emit.
 			 */
-			switch (plannode->cmd)
-			{
-				case SETOPCMD_INTERSECT:
-					if (node->numLeft > 0 && node->numRight > 0)
-						node->numOutput = 1;
-					else
-						node->numOutput = 0;
-					break;
-				case SETOPCMD_INTERSECT_ALL:
-					node->numOutput =
-						(node->numLeft < node->numRight) ?
-						node->numLeft : node->numRight;
-					break;
-				case SETOPCMD_EXCEPT:
-					if (node->numLeft > 0 && node->numRight == 0)
-						node->numOutput = 1;
-					else
-						node->numOutput = 0;
-					break;
-				case SETOPCMD_EXCEPT_ALL:
-					node->numOutput =
-						(node->numLeft < node->numRight) ?
-						0 : (node->numLeft - node->numRight);
-					break;
-				default:
-					elog(ERROR, "unrecognized set op: %d",
-						 (int) plannode->cmd);
-					break;
-			}
+			set_output_count(node, plannode);
 			/* Fall out of for-loop if we have tuples to emit */
 			if (node->numOutput > 0)
 				break;
@@ -212,6 +274,322 @@ ExecSetOp(SetOpState *node)
 	return resultTupleSlot;
 }
 
+/*
+ * ExecSetOp for SETOP_HASHED mode: fill the hash table from the current
+ * input, then emit the groups in it.  Repeat with each spill file.
+ */
+static TupleTableSlot *
+ExecSetOpHashed(SetOpState *setopstate)
+{
+	SetOp	   *plannode = (SetOp *) setopstate->ps.plan;
+	TupleTableSlot *resultTupleSlot = setopstate->ps.ps_ResultTupleSlot;
+
+	for (;;)
+	{
+		SetOpHashEntry entry;
+
+		if (!setopstate->table_filled)
+			setop_fill_hash_table(setopstate);
+
+		entry = (SetOpHashEntry) ScanTupleHashTable(&setopstate->hashiter);
+		if (entry == NULL)
+		{
+			/* Done with the hash table; go on to the next spill file */
+			if (setopstate->pendingfiles == NIL)
+				return NULL;
+
+			setopstate->curfile = (SetOpSpillFile *) linitial(setopstate->pendingfiles);
+			setopstate->pendingfiles = list_delete_first(setopstate->pendingfiles);
+
+			if (!ExecWorkFile_Rewind(setopstate->curfile->file))
+				ereport(ERROR,
+						(errcode_for_file_access(),
+						 errmsg("could not access temporary file")));
+
+			MemoryContextResetAndDeleteChildren(setopstate->tableContext);
+			build_hash_table(setopstate);
+			setopstate->table_filled = false;
+			continue;
+		}
+
+		setopstate->numLeft = entry->numLeft;
+		setopstate->numRight = entry->numRight;
+		set_output_count(setopstate, plannode);
+
+		if (setopstate->numOutput > 0)
+		{
+			ExecStoreMinimalTuple(entry->shared.firstTuple, resultTupleSlot, false);
+			setopstate->numOutput--;
+
+			Gpmon_Incr_Rows_Out(GpmonPktFromSetOpState(setopstate));
+			CheckSendPlanStateGpmonPkt(&setopstate->ps);
+
+			return resultTupleSlot;
+		}
+	}
+}
+
+/*
+ * Initialize the hash table to empty.
+ */
+static void
+build_hash_table(SetOpState *setopstate)
+{
+	SetOp	   *plannode = (SetOp *) setopstate->ps.plan;
+
+	Assert(plannode->strategy == SETOP_HASHED);
+	Assert(plannode->numGroups > 0);
+
+	setopstate->hashtable = BuildTupleHashTable(plannode->numCols,
+												plannode->dupColIdx,
+												setopstate->eqfunctions,
+												setopstate->hashfunctions,
+												Min(plannode->numGroups, 16384),
+												sizeof(SetOpHashEntryData),
+												setopstate->tableContext,
+												setopstate->ps.ps_ExprContext->ecxt_per_tuple_memory);
+}
+
+/*
+ * Read the current input, the subplan or a spill file, and count the tuples
+ * of each group in the hash table.
+ *
+ * Once the hash table uses up the operator's memory, tuples of groups that
+ * are already in it are still counted, but the others are spilled.
+ */
+static void
+setop_fill_hash_table(SetOpState *setopstate)
+{
+	SetOp	   *plannode = (SetOp *) setopstate->ps.plan;
+	PlanState  *outerPlan = outerPlanState(setopstate);
+	ExprContext *econtext = setopstate->ps.ps_ExprContext;
+	Size		memLimit = (Size) PlanStateOperatorMemKB((PlanState *) setopstate) * 1024L;
+	int			depth = setopstate->curfile ? setopstate->curfile->depth : 0;
+	bool		full = false;
+	int			i;
+
+	for (;;)
+	{
+		TupleTableSlot *inputTupleSlot;
+		SetOpHashEntry entry;
+		bool		isnew;
+		int			flag;
+		bool		isNull;
+
+		if (setopstate->curfile == NULL)
+		{
+			inputTupleSlot = ExecProcNode(outerPlan);
+			if (TupIsNull(inputTupleSlot))
+				break;
+			Gpmon_Incr_Rows_In(GpmonPktFromSetOpState(setopstate));
+		}
+		else
+		{
+			inputTupleSlot = setop_read_spilled(setopstate);
+			if (inputTupleSlot == NULL)
+				break;
+		}
+
+		if (!full)
+		{
+			entry = (SetOpHashEntry) LookupTupleHashEntry(setopstate->hashtable,
+														  inputTupleSlot,
+														  &isnew);
+			if (isnew &&
+				depth < SETOP_MAX_SPILL_DEPTH &&
+				MemoryContextGetCurrentSpace(setopstate->tableContext) > memLimit)
+				full = true;
+		}
+		else
+		{
+			entry = (SetOpHashEntry) LookupTupleHashEntry(setopstate->hashtable,
+														  inputTupleSlot,
+														  NULL);
+			if (entry == NULL)
+			{
+				setop_spill_tuple(setopstate, inputTupleSlot, depth);
+				ResetExprContext(econtext);
+				continue;
+			}
+		}
+
+		flag = DatumGetInt32(slot_getattr(inputTupleSlot,
+										  plannode->flagColIdx,
+										  &isNull));
+		Assert(!isNull);
+		if (flag)
+			entry->numRight++;
+		else
+			entry->numLeft++;
+
+		/* Must reset temp context after each hashtable lookup */
+		ResetExprContext(econtext);
+		CheckSendPlanStateGpmonPkt(&setopstate->ps);
+	}
+
+	/* Done with this input; queue up whatever it spilled */
+	if (setopstate->curfile != NULL)
+	{
+		workfile_mgr_close_file(setopstate->work_set, setopstate->curfile->file);
+		pfree(setopstate->curfile);
+		setopstate->curfile = NULL;
+	}
+
+	if (setopstate->spillfiles != NULL)
+	{
+		for (i = 0; i < SETOP_SPILL_FILES; i++)
+		{
+			if (setopstate->spillfiles[i] != NULL)
+				setopstate->pendingfiles = lappend(setopstate->pendingfiles,
+												   setopstate->spillfiles[i]);
+		}
+		pfree(setopstate->spillfiles);
+		setopstate->spillfiles = NULL;
+	}
+
+	setopstate->table_filled = true;
+	ResetTupleHashIterator(setopstate->hashtable, &setopstate->hashiter);
+}
+
+/*
+ * Write a tuple whose group is not in the full hash table to a spill file,
+ * chosen by a hash of the group columns that differs at each depth.
+ */
+static void
+setop_spill_tuple(SetOpState *setopstate, TupleTableSlot *slot, int depth)
+{
+	SetOp	   *plannode = (SetOp *) setopstate->ps.plan;
+	MemoryContext oldContext;
+	SetOpSpillFile *spillfile;
+	MemTuple	tuple;
+	uint32		hashkey = 0;
+	int			i;
+
+	/* Same per-column hash as the hash table uses */
+	oldContext = MemoryContextSwitchTo(setopstate->ps.ps_ExprContext->ecxt_per_tuple_memory);
+	for (i = 0; i < plannode->numCols; i++)
+	{
+		Datum		attr;
+		bool		isNull;
+
+		hashkey = (hashkey << 1) | ((hashkey & 0x80000000) ? 1 : 0);
+
+		attr = slot_getattr(slot, plannode->dupColIdx[i], &isNull);
+		if (!isNull)
+			hashkey ^= DatumGetUInt32(FunctionCall1(&setopstate->hashfunctions[i],
+													attr));
+	}
+	MemoryContextSwitchTo(oldContext);
+
+	hashkey = DatumGetUInt32(hash_uint32(hashkey + depth));
+
+	if (setopstate->work_set == NULL)
+	{
+		setopstate->work_set = workfile_mgr_create_set(BFZ, false /* can_be_reused */,
+													   &setopstate->ps);
+		if (setopstate->ps.instrument)
+			setopstate->ps.instrument->workfileCreated = true;
+	}
+
+	if (setopstate->spillfiles == NULL)
+		setopstate->spillfiles = (SetOpSpillFile **)
+			palloc0(SETOP_SPILL_FILES * sizeof(SetOpSpillFile *));
+
+	spillfile = setopstate->spillfiles[hashkey % SETOP_SPILL_FILES];
+	if (spillfile == NULL)
+	{
+		spillfile = (SetOpSpillFile *) palloc(sizeof(SetOpSpillFile));
+		spillfile->file = workfile_mgr_create_file(setopstate->work_set);
+		spillfile->depth = depth + 1;
+		setopstate->spillfiles[hashkey % SETOP_SPILL_FILES] = spillfile;
+	}
+
+	tuple = ExecFetchSlotMemTuple(slot, false);
+	if (!ExecWorkFile_Write(spillfile->file, (void *) tuple, memtuple_get_size(tuple)))
+		workfile_mgr_report_error();
+}
+
+/*
+ * Read the next tuple from the current spill file into spillslot.  Returns
+ * NULL at the end of the file.
+ */
+static TupleTableSlot *
+setop_read_spilled(SetOpState *setopstate)
+{
+	ExecWorkFile *file = setopstate->curfile->file;
+	uint32		len;
+	MemTuple	tuple;
+	size_t		nread;
+
+	nread = ExecWorkFile_Read(file, (void *) &len, sizeof(uint32));
+	if (nread != sizeof(uint32))
+	{
+		ExecClearTuple(setopstate->spillslot);
+		return NULL;
+	}
+
+	tuple = (MemTuple) palloc(memtuple_size_from_uint32(len));
+	memtuple_set_mtlen(tuple, len);
+
+	nread = ExecWorkFile_Read(file,
+							  (void *) ((char *) tuple + sizeof(uint32)),
+							  memtuple_size_from_uint32(len) - sizeof(uint32));
+	if (nread != memtuple_size_from_uint32(len) - sizeof(uint32))
+		ereport(ERROR,
+				(errcode_for_file_access(),
+				 errmsg("could not read from SetOp temporary file")));
+
+	return ExecStoreMinimalTuple(tuple, setopstate->spillslot, true);
+}
+
+/*
+ * Close all spill files, and the workfile set they belong to.
+ */
+static void
+setop_close_spill_files(SetOpState *setopstate)
+{
+	ListCell   *lc;
+	int			i;
+
+	if (setopstate->work_set == NULL)
+		return;
+
+	if (setopstate->curfile != NULL)
+	{
+		workfile_mgr_close_file(setopstate->work_set, setopstate->curfile->file);
+		pfree(setopstate->curfile);
+		setopstate->curfile = NULL;
+	}
+
+	if (setopstate->spillfiles != NULL)
+	{
+		for (i = 0; i < SETOP_SPILL_FILES; i++)
+		{
+			if (setopstate->spillfiles[i] != NULL)
+			{
+				workfile_mgr_close_file(setopstate->work_set,
+										setopstate->spillfiles[i]->file);
+				pfree(setopstate->spillfiles[i]);
+			}
+		}
+		pfree(setopstate->spillfiles);
+		setopstate->spillfiles = NULL;
+	}
+
+	foreach(lc, setopstate->pendingfiles)
+	{
+		SetOpSpillFile *spillfile = (SetOpSpillFile *) lfirst(lc);
+
+		workfile_mgr_close_file(setopstate->work_set, spillfile->file);
+		pfree(spillfile);
+	}
+	list_free(setopstate->pendingfiles);
+	setopstate->pendingfiles = NIL;
+
+	workfile_mgr_close_set(setopstate->work_set);
+	setopstate->work_set = NULL;
+}
+
 /* ----------------------------------------------------------------
  *		ExecInitSetOp
  *
@@ -237,6 +615,11 @@ ExecInitSetOp(SetOp *node, EState *estate, int eflags)
 	setopstate->ps.ps_OuterTupleSlot = NULL;
 	setopstate->subplan_done = false;
 	setopstate->numOutput = 0;
+	setopstate->table_filled = false;
+	setopstate->curfile = NULL;
+	setopstate->spillfiles = NULL;
+	setopstate->pendingfiles = NIL;
+	setopstate->work_set = NULL;
 
 	/*
 	 * Miscellaneous initialization
@@ -250,12 +633,28 @@ ExecInitSetOp(SetOp *node, EState *estate, int eflags)
 	 */
 	 ExecAssignExprContext(estate, &setopstate->ps);
 
-#define SETOP_NSLOTS 1
+	/*
+	 * If hashing, we also need a longer-lived context to store the hash
+	 * table.  The table can't just be kept in the per-query context because
+	 * we want to be able to throw it away when it is emitted, or in
+	 * ExecReScanSetOp.
+	 */
+	if (node->strategy == SETOP_HASHED)
+		setopstate->tableContext =
+			AllocSetContextCreate(CurrentMemoryContext,
+								  "SetOp hash table",
+								  ALLOCSET_DEFAULT_MINSIZE,
+								  ALLOCSET_DEFAULT_INITSIZE,
+								  ALLOCSET_DEFAULT_MAXSIZE);
+
+#define SETOP_NSLOTS 2
 
 	/*
 	 * Tuple table initialization
 	 */
 	ExecInitResultTupleSlot(estate, &setopstate->ps);
+	if (node->strategy == SETOP_HASHED)
+		setopstate->spillslot = ExecInitExtraTupleSlot(estate);
 
 	/*
 	 * then initialize outer plan
@@ -269,12 +668,27 @@ ExecInitSetOp(SetOp *node, EState *estate, int eflags)
 	ExecAssignResultTypeFromTL(&setopstate->ps);
 	setopstate->ps.ps_ProjInfo = NULL;
 
+	if (node->strategy == SETOP_HASHED)
+		ExecSetSlotDescriptor(setopstate->spillslot,
+							  ExecGetResultType(outerPlanState(setopstate)));
+
 	/*
-	 * Precompute fmgr lookup data for inner loop
+	 * Precompute fmgr lookup data for inner loop. We need both equality and
+	 * hashing functions to do it by hashing, but only equality if not
+	 * hashing.
 	 */
-	setopstate->eqfunctions =
-		execTuplesMatchPrepare(node->numCols,
-							   node->dupOperators);
+	if (node->strategy == SETOP_HASHED)
+	{
+		execTuplesHashPrepare(node->numCols,
+							  node->dupOperators,
+							  &setopstate->eqfunctions,
+							  &setopstate->hashfunctions);
+		build_hash_table(setopstate);
+	}
+	else
+		setopstate->eqfunctions =
+			execTuplesMatchPrepare(node->numCols,
+								   node->dupOperators);
 
 	initGpmonPktForSetOp((Plan *)node, &setopstate->ps.gpmon_pkt, estate);
 
@@ -299,6 +713,12 @@ ExecCountSlotsSetOp(SetOp *node)
 void
 ExecEndSetOp(SetOpState *node)
 {
+	setop_close_spill_files(node);
+
+	/* free subsidiary stuff including hashtable */
+	if (node->tableContext)
+		MemoryContextDelete(node->tableContext);
+
 	ExecFreeExprContext(&node->ps);
 
 	/* clean up tuple table */
@@ -319,6 +739,27 @@ ExecReScanSetOp(SetOpState *node, ExprContext *exprCtxt)
 	node->subplan_done = false;
 	node->numOutput = 0;
 
+	if (((SetOp *) node->ps.plan)->strategy == SETOP_HASHED)
+	{
+		/*
+		 * If we have the whole input in the hash table, and the subplan does
+		 * not have any parameter changes, we can just rescan the table.
+		 */
+		if (node->table_filled &&
+			node->work_set == NULL &&
+			((PlanState *) node)->lefttree->chgParam == NULL)
+		{
+			ResetTupleHashIterator(node->hashtable, &node->hashiter);
+			return;
+		}
+
+		/* Otherwise we have to forget everything and read the input again */
+		setop_close_spill_files(node);
+		MemoryContextResetAndDeleteChildren(node->tableContext);
+		build_hash_table(node);
+		node->table_filled = false;
+	}
+
 	/*
 	 * if chgParam of subnode is not null then plan will be re-scanned by
 	 * first ExecProcNode.
@@ -32,9 +32,13 @@
 #include "executor/executor.h"
 #include "executor/nodeShareInputScan.h"
 #include "miscadmin.h"
+#include "pgstat.h"
 #include "postmaster/primary_mirror_mode.h"
+#include "storage/shmem.h"
+#include "storage/spin.h"
 #include "utils/faultinjector.h"
 #include "utils/gp_alloc.h"
+#include "utils/memutils.h"
 #include "utils/tuplesort.h"
 #include "utils/tuplestorenew.h"
 
@@ -49,8 +53,44 @@ typedef struct ShareInput_Lk_Context
 	char lkname_done[MAXPGPATH];
 } ShareInput_Lk_Context;
 
+/*
+ * A cross-slice Material share small enough to fit in a slot of shared
+ * memory is handed to its readers there, instead of through the files
+ * named by shareinput_create_bufname_prefix.  The slot holds the blocks of
+ * the writer's tuplestore, laid out as in the file.
+ *
+ * A slot is in use while session_id is not 0.  It is referenced by the
+ * writer until shareinput_writer_waitdone, and by each reader until it
+ * drops its tuplestore; the last one to let go frees it.  nblocks is -1
+ * until the writer has filled the slot.
+ */
+typedef struct ShareInputShmemSlot
+{
+	int			session_id;
+	int			command_count;
+	int			share_id;
+	int			nblocks;
+	int			refcount;
+} ShareInputShmemSlot;
+
+typedef struct ShareInputShmemCtl
+{
+	slock_t		mutex;
+	ShareInputShmemSlot slots[1];	/* VARIABLE LENGTH ARRAY */
+} ShareInputShmemCtl;
+
+int			gp_shareinput_shmem_slots = 0;
+int			gp_shareinput_shmem_slot_size = 1024;
+
+static ShareInputShmemCtl *ShareInputShmem = NULL;
+
+/* Slots referenced by this backend, released at the latest at transaction end */
+static List *shareinput_shmem_held = NIL;
+
 static TupleTableSlot *ShareInputNext(ShareInputScanState *node);
 static void writer_wait_for_acks(ShareInput_Lk_Context *pctxt, int share_id, int xslice);
+static NTupleStore *shareinput_shmem_open(int share_id);
+static void shareinput_shmem_release(int share_id);
 
 /* ------------------------------------------------------------------
  * 	ExecShareInputScan 
@@ -99,7 +139,9 @@ init_tuplestore_state(ShareInputScanState *node)
 	
 		node->ts_state = palloc0(sizeof(GenericTupStore));
 
-		node->ts_state->matstore = ntuplestore_create_readerwriter(rwfile_prefix, 0, false);
+		node->ts_state->matstore = shareinput_shmem_open(sisc->share_id);
+		if (node->ts_state->matstore == NULL)
+			node->ts_state->matstore = ntuplestore_create_readerwriter(rwfile_prefix, 0, false);
 		node->ts_pos = (void *) ntuplestore_create_accessor(node->ts_state->matstore, false);
 		ntuplestore_acc_seek_bof((NTupleStoreAccessor *)node->ts_pos);
 	}
@@ -633,7 +675,9 @@ shareinput_reader_waitready(int share_id, PlanGenerator planGen)
 		tval.tv_sec = 1;
 		tval.tv_usec = 0;
 
+		pgstat_report_wait_start(WAIT_EVENT_SHAREINPUT);
 		n = select(pctxt->readyfd+1, (fd_set *) &rset, NULL, NULL, &tval);
+		pgstat_report_wait_end();
 
 		if(n==1)
 		{
@@ -769,7 +813,9 @@ writer_wait_for_acks(ShareInput_Lk_Context *pctxt, int share_id, int xslice)
 
 		tval.tv_sec = 1;
 		tval.tv_usec = 0;
+		pgstat_report_wait_start(WAIT_EVENT_SHAREINPUT);
 		int numReady = select(pctxt->donefd+1, (fd_set *) &rset, NULL, NULL, &tval);
+		pgstat_report_wait_end();
 
 		if(numReady==1)
 		{
@@ -857,7 +903,9 @@ shareinput_writer_waitdone(void *ctxt, int share_id, int nsharer_xslice)
 
 		tval.tv_sec = 1;
 		tval.tv_usec = 0;
+		pgstat_report_wait_start(WAIT_EVENT_SHAREINPUT);
 		numReady = select(pctxt->donefd+1, (fd_set *) &rset, NULL, NULL, &tval);
+		pgstat_report_wait_end();
 	
 		if(numReady==1)
 		{
@@ -887,6 +935,8 @@ shareinput_writer_waitdone(void *ctxt, int share_id, int nsharer_xslice)
 	elog(DEBUG1, "SISC WRITER (shareid=%d, slice=%d): Writer received all %d reader done notifications",
 			share_id, currentSliceId, nsharer_xslice - pctxt->zcnt);
 
+	shareinput_shmem_release(share_id);
+
 	shareinput_clean_lk_ctxt(ctxt);
 	UnregisterXactCallbackOnce(XCallBack_ShareInput_FIFO, (void *) ctxt);
 }
@@ -936,6 +986,7 @@ ExecEagerFreeShareInputScan(ShareInputScanState *node)
 			if(ntuplestore_is_readerwriter_reader(node->ts_state->matstore))
 			{
 				ntuplestore_destroy(node->ts_state->matstore);
+				shareinput_shmem_release(sisc->share_id);
 			}
 		}
 	}
@@ -965,3 +1016,240 @@ ExecEagerFreeShareInputScan(ShareInputScanState *node)
 	}
 	node->freed = true;
 }
+
+/*
+ * Shared memory for small cross-slice Material shares.
+ */
+static int
+shareinput_shmem_slot_blocks(void)
+{
+	return ((int64) gp_shareinput_shmem_slot_size * 1024) / BLCKSZ;
+}
+
+static Size
+shareinput_shmem_header_size(void)
+{
+	return BUFFERALIGN(add_size(offsetof(ShareInputShmemCtl, slots),
+								mul_size(sizeof(ShareInputShmemSlot),
+										 gp_shareinput_shmem_slots)));
+}
+
+static char *
+shareinput_shmem_slot_data(int slotno)
+{
+	return (char *) ShareInputShmem + shareinput_shmem_header_size() +
+		(Size) slotno * shareinput_shmem_slot_blocks() * BLCKSZ;
+}
+
+/*
+ * Report shared memory space needed by ShareInputShmemInit.
+ */
+Size
+ShareInputShmemSize(void)
+{
+	if (gp_shareinput_shmem_slots == 0 || shareinput_shmem_slot_blocks() == 0)
+		return 0;
+
+	return add_size(shareinput_shmem_header_size(),
+					mul_size(mul_size(gp_shareinput_shmem_slots,
+									  shareinput_shmem_slot_blocks()),
+							 BLCKSZ));
+}
+
+/*
+ * Allocate and initialize the shared memory slots for ShareInput.
+ */
+void
+ShareInputShmemInit(void)
+{
+	bool		found;
+	int			i;
+
+	if (ShareInputShmemSize() == 0)
+		return;
+
+	ShareInputShmem = (ShareInputShmemCtl *)
+		ShmemInitStruct("ShareInput Shared Slots", ShareInputShmemSize(), &found);
+
+	if (!found)
+	{
+		SpinLockInit(&ShareInputShmem->mutex);
+		for (i = 0; i < gp_shareinput_shmem_slots; i++)
+			ShareInputShmem->slots[i].session_id = 0;
+	}
+}
+
+static bool
+shareinput_shmem_slot_matches(ShareInputShmemSlot *slot, int share_id)
+{
+	return slot->session_id == gp_session_id &&
+		slot->command_count == gp_command_count &&
+		slot->share_id == share_id;
+}
+
+/* Drop one reference to a slot.  Caller must hold the mutex. */
+static void
+shareinput_shmem_unref(int slotno)
+{
+	ShareInputShmemSlot *slot = &ShareInputShmem->slots[slotno];
+
+	Assert(slot->refcount > 0);
+	if (--slot->refcount == 0)
+		slot->session_id = 0;
+}
+
+static void
+shareinput_shmem_xact_callback(XactEvent event, void *arg)
+{
+	ListCell   *lc;
+
+	if (shareinput_shmem_held == NIL)
+		return;
+
+	SpinLockAcquire(&ShareInputShmem->mutex);
+	foreach(lc, shareinput_shmem_held)
+		shareinput_shmem_unref(lfirst_int(lc));
+	SpinLockRelease(&ShareInputShmem->mutex);
+
+	list_free(shareinput_shmem_held);
+	shareinput_shmem_held = NIL;
+}
+
+static void
+shareinput_shmem_hold(int slotno)
+{
+	static bool callback_registered = false;
+	MemoryContext oldcxt;
+
+	if (!callback_registered)
+	{
+		RegisterXactCallback(shareinput_shmem_xact_callback, NULL);
+		callback_registered = true;
+	}
+
+	oldcxt = MemoryContextSwitchTo(TopMemoryContext);
+	shareinput_shmem_held = lappend_int(shareinput_shmem_held, slotno);
+	MemoryContextSwitchTo(oldcxt);
+}
+
+/*
+ * shareinput_shmem_publish
+ *
+ *  Called by the writer of a cross-slice Material share, instead of
+ *  flushing its tuplestore to disk.  If the tuplestore is still all in
+ *  memory and fits in a free slot, copy it there and return true.  The
+ *  readers then find it in shareinput_shmem_open.
+ */
+bool
+shareinput_shmem_publish(int share_id, NTupleStore *ts)
+{
+	int			nblocks;
+	int			slotno;
+	ShareInputShmemSlot *slot = NULL;
+
+	if (ShareInputShmem == NULL)
+		return false;
+
+	nblocks = ntuplestore_inmem_blocks(ts);
+	if (nblocks < 0 || nblocks > shareinput_shmem_slot_blocks())
+		return false;
+
+	SpinLockAcquire(&ShareInputShmem->mutex);
+	for (slotno = 0; slotno < gp_shareinput_shmem_slots; slotno++)
+	{
+		if (ShareInputShmem->slots[slotno].session_id == 0)
+		{
+			slot = &ShareInputShmem->slots[slotno];
+			slot->session_id = gp_session_id;
+			slot->command_count = gp_command_count;
+			slot->share_id = share_id;
+			slot->nblocks = -1;
+			slot->refcount = 1;
+			break;
+		}
+	}
+	SpinLockRelease(&ShareInputShmem->mutex);
+
+	if (slot == NULL)
+		return false;
+
+	shareinput_shmem_hold(slotno);
+
+	ntuplestore_copy_blocks(ts, shareinput_shmem_slot_data(slotno));
+
+	SpinLockAcquire(&ShareInputShmem->mutex);
+	slot->nblocks = nblocks;
+	SpinLockRelease(&ShareInputShmem->mutex);
+
+	elog(DEBUG1, "SISC WRITER (shareid=%d, slice=%d): published %d blocks in shared memory slot %d",
+		 share_id, currentSliceId, nblocks, slotno);
+
+	return true;
+}
+
+/*
+ * shareinput_shmem_open
+ *
+ *  Called by a reader once the writer is ready.  Return a tuplestore over
+ *  the shared memory slot the writer published the share in, or NULL if
+ *  it went to disk.
+ */
+static NTupleStore *
+shareinput_shmem_open(int share_id)
+{
+	int			slotno;
+	int			nblocks = -1;
+
+	if (ShareInputShmem == NULL)
+		return NULL;
+
+	SpinLockAcquire(&ShareInputShmem->mutex);
+	for (slotno = 0; slotno < gp_shareinput_shmem_slots; slotno++)
+	{
+		ShareInputShmemSlot *slot = &ShareInputShmem->slots[slotno];
+
+		if (shareinput_shmem_slot_matches(slot, share_id) && slot->nblocks >= 0)
+		{
+			slot->refcount++;
+			nblocks = slot->nblocks;
+			break;
+		}
+	}
+	SpinLockRelease(&ShareInputShmem->mutex);
+
+	if (nblocks < 0)
+		return NULL;
+
+	shareinput_shmem_hold(slotno);
+
+	elog(DEBUG1, "SISC READER (shareid=%d, slice=%d): reading %d blocks from shared memory slot %d",
+		 share_id, currentSliceId, nblocks, slotno);
+
+	return ntuplestore_create_block_reader(shareinput_shmem_slot_data(slotno), nblocks);
+}
+
+/*
+ * shareinput_shmem_release
+ *
+ *  Drop this backend's reference to the slot of a share, if it has one.
+ */
+static void
+shareinput_shmem_release(int share_id)
+{
+	ListCell   *lc;
+
+	foreach(lc, shareinput_shmem_held)
+	{
+		int			slotno = lfirst_int(lc);
+
+		if (shareinput_shmem_slot_matches(&ShareInputShmem->slots[slotno], share_id))
+		{
+			SpinLockAcquire(&ShareInputShmem->mutex);
+			shareinput_shmem_unref(slotno);
+			SpinLockRelease(&ShareInputShmem->mutex);
+
+			shareinput_shmem_held = list_delete_int(shareinput_shmem_held, slotno);
+			return;
+		}
+	}
+}
@@ -21,13 +21,161 @@
 #include "executor/nodeSort.h"
 #include "lib/stringinfo.h"             /* StringInfo */
 #include "miscadmin.h"
+#include "utils/lsyscache.h"
 #include "utils/tuplesort.h"
 #include "cdb/cdbvars.h" /* CDB *//* gp_sort_flags */
 #include "utils/workfile_mgr.h"
 #include "executor/instrument.h"
 #include "utils/faultinjector.h"
 
+/*
+ * In incremental mode, a batch holds at least this many tuples, plus the
+ * rest of the group of equal leading keys the last of them belongs to, so
+ * that runs of tiny groups don't each pay for setting up a tuplesort.
+ */
+#define INCSORT_MIN_BATCH_TUPLES	32
+
 static void ExecSortExplainEnd(PlanState *planstate, struct StringInfoData *buf);
+static Tuplesortstate *ExecSortBegin(SortState *node);
+static TupleTableSlot *ExecIncrementalSort(SortState *node);
+
+/*
+ * ExecSortBegin
+ *		Set up a tuplesort for the node's sort keys.
+ */
+static Tuplesortstate *
+ExecSortBegin(SortState *node)
+{
+	Sort	   *plannode = (Sort *) node->ss.ps.plan;
+	TupleDesc	tupDesc = ExecGetResultType(outerPlanState(node));
+	Tuplesortstate *tuplesortstate;
+
+	tuplesortstate = tuplesort_begin_heap(&node->ss, tupDesc,
+										  plannode->numCols,
+										  plannode->sortColIdx,
+										  plannode->sortOperators, plannode->nullsFirst,
+										  PlanStateOperatorMemKB((PlanState *) node),
+										  node->randomAccess);
+
+	/* CDB */
+	cdb_tuplesort_init(tuplesortstate, node->noduplicates ? 1 : 0,
+					   gp_sort_flags, gp_sort_max_distinct);
+
+	/* If EXPLAIN ANALYZE, share our Instrumentation object with sort. */
+	if (node->ss.ps.instrument)
+		tuplesort_set_instrument(tuplesortstate,
+								 node->ss.ps.instrument,
+								 node->ss.ps.cdbexplainbuf);
+
+	tuplesort_set_gpmon(tuplesortstate, &node->ss.ps.gpmon_pkt,
+						&node->ss.ps.gpmon_plan_tick);
+
+	return tuplesortstate;
+}
+
+/* ----------------------------------------------------------------
+ *		ExecIncrementalSort
+ *
+ *		Sorts input that is already sorted on the leading numPresortedCols
+ *		keys.  Tuples are read a batch at a time, where a batch ends only
+ *		where the leading keys change, and each batch is sorted and returned
+ *		before the next one is read.  Only one batch is held at a time, and
+ *		the first tuples come back as soon as the first batch is read.
+ *
+ *		Each batch is sorted on all the keys, since a batch made of several
+ *		small groups is not ordered on the remaining ones.
+ * ----------------------------------------------------------------
+ */
+static TupleTableSlot *
+ExecIncrementalSort(SortState *node)
+{
+	Sort	   *plannode = (Sort *) node->ss.ps.plan;
+	PlanState  *outerNode = outerPlanState(node);
+	TupleTableSlot *pivot = node->ss.ss_ScanTupleSlot;
+	TupleTableSlot *slot = node->ss.ps.ps_ResultTupleSlot;
+	MemoryContext evalContext = node->ss.ps.ps_ExprContext->ecxt_per_tuple_memory;
+
+	for (;;)
+	{
+		Tuplesortstate *tuplesortstate = node->tuplesortstate->sortstore;
+		int			ntuples = 0;
+		bool		havePivot = false;
+
+		/* Return the next tuple of the current batch, if any is left */
+		if (tuplesortstate != NULL)
+		{
+			(void) tuplesort_gettupleslot(tuplesortstate, true, slot);
+			if (!TupIsNull(slot))
+			{
+				node->incr_returned++;
+				return slot;
+			}
+
+			tuplesort_finalize_stats(tuplesortstate);
+			tuplesort_end(tuplesortstate);
+			node->tuplesortstate->sortstore = NULL;
+		}
+
+		if (node->input_Done && TupIsNull(pivot))
+		{
+			node->sort_Done = true;
+			return slot;
+		}
+
+		/*
+		 * Read the next batch.  The pivot slot carries the tuple that ended
+		 * the previous batch; once the batch is big enough, it holds the
+		 * tuple whose group of leading keys is the last one of this batch.
+		 */
+		tuplesortstate = ExecSortBegin(node);
+		node->tuplesortstate->sortstore = tuplesortstate;
+
+		if (node->bounded && node->bound > node->incr_returned)
+			tuplesort_set_bound(tuplesortstate, node->bound - node->incr_returned);
+
+		if (!TupIsNull(pivot))
+		{
+			tuplesort_puttupleslot(tuplesortstate, pivot);
+			ExecClearTuple(pivot);
+			ntuples++;
+		}
+
+		while (!node->input_Done)
+		{
+			TupleTableSlot *outerslot = ExecProcNode(outerNode);
+
+			if (TupIsNull(outerslot))
+			{
+				node->input_Done = true;
+				ExecClearTuple(pivot);
+				break;
+			}
+
+			if (havePivot &&
+				!execTuplesMatch(outerslot, pivot,
+								 node->numPresortedCols,
+								 plannode->sortColIdx,
+								 node->presortedEqfuncs,
+								 evalContext))
+			{
+				ExecCopySlot(pivot, outerslot);
+				break;
+			}
+
+			CheckSendPlanStateGpmonPkt(&node->ss.ps);
+			tuplesort_puttupleslot(tuplesortstate, outerslot);
+
+			if (!havePivot && ++ntuples >= INCSORT_MIN_BATCH_TUPLES)
+			{
+				ExecCopySlot(pivot, outerslot);
+				havePivot = true;
+			}
+		}
+
+		tuplesort_performsort(tuplesortstate);
+		CheckSendPlanStateGpmonPkt(&node->ss.ps);
+	}
+}
 
 /* ----------------------------------------------------------------
  *		ExecSort
@@ -78,6 +226,17 @@ ExecSort(SortState *node)
 
 	plannode = (Sort *) node->ss.ps.plan;
 
+	if (node->numPresortedCols > 0)
+	{
+		Assert(ScanDirectionIsForward(dir));
+
+		slot = ExecIncrementalSort(node);
+
+		if (TupIsNull(slot) && !node->ss.ps.delayEagerFree)
+			ExecEagerFreeSort(node);
+
+		return slot;
+	}
 
 	/*
 	 * If called for the first time, initialize tuplesort_state
@@ -294,6 +453,37 @@ ExecInitSort(Sort *node, EState *estate, int eflags)
 	sortstate->tuplesortstate = palloc0(sizeof(GenericTupStore));
 	sortstate->share_lk_ctxt = NULL;
 
+	/*
+	 * Sort incrementally if the planner says the input is partially sorted,
+	 * unless the whole output has to be kept for rescans or random access.
+	 */
+	sortstate->numPresortedCols = 0;
+	sortstate->input_Done = false;
+	sortstate->incr_returned = 0;
+	if (node->numPresortedCols > 0 &&
+		node->numPresortedCols < node->numCols &&
+		node->share_type == SHARE_NOTSHARED &&
+		!sortstate->randomAccess)
+	{
+		Oid		   *eqOperators = palloc(node->numPresortedCols * sizeof(Oid));
+		int			i;
+
+		for (i = 0; i < node->numPresortedCols; i++)
+		{
+			eqOperators[i] = get_equality_op_for_ordering_op(node->sortOperators[i]);
+			if (!OidIsValid(eqOperators[i]))
+				break;
+		}
+
+		if (i == node->numPresortedCols)
+		{
+			sortstate->numPresortedCols = node->numPresortedCols;
+			sortstate->presortedEqfuncs =
+				execTuplesMatchPrepare(node->numPresortedCols, eqOperators);
+		}
+		pfree(eqOperators);
+	}
+
 	/* CDB */
 
 	/* BUT:
@@ -471,6 +661,29 @@ ExecSortRestrPos(SortState *node)
 void
 ExecReScanSort(SortState *node, ExprContext *exprCtxt)
 {
+	/*
+	 * In incremental mode only the current batch is kept, so forget it and
+	 * read the input again, even if we stopped part way through it.
+	 */
+	if (node->numPresortedCols > 0)
+	{
+		ExecClearTuple(node->ss.ps.ps_ResultTupleSlot);
+		ExecClearTuple(node->ss.ss_ScanTupleSlot);
+
+		if (NULL != node->tuplesortstate->sortstore)
+		{
+			tuplesort_end(node->tuplesortstate->sortstore);
+			node->tuplesortstate->sortstore = NULL;
+		}
+		node->sort_Done = false;
+		node->input_Done = false;
+		node->incr_returned = 0;
+
+		if (((PlanState *) node)->lefttree->chgParam == NULL)
+			ExecReScan(((PlanState *) node)->lefttree, exprCtxt);
+		return;
+	}
+
 	/*
 	 * If we haven't sorted yet, just return. If outerplan' chgParam is not
 	 * NULL then it will be re-scanned by ExecProcNode, else - no reason to
@@ -588,4 +801,7 @@ ExecEagerFreeSort(SortState *node)
 		tuplesort_end(node->tuplesortstate->sortstore);
 		node->tuplesortstate->sortstore = NULL;
 	}
+
+	/* Give our quota to the operators that still run */
+	MemoryAccounting_RelinquishQuota(plan->plan.memoryAccountId);
 }
@@ -94,6 +94,28 @@ typedef struct FrameBufferEntry
 	List	   *func_values;
 } FrameBufferEntry;
 
+/*
+ * SlidingExtremesData -- the buffered values that can still become the
+ * result of a min/max-like aggregate as its frame moves forward.
+ *
+ * The values are kept in frame buffer order, and each one beats every
+ * value after it under the aggregate's sort operator, so the first one is
+ * the aggregate of the buffered entries in the frame. A value is dropped
+ * from the back when a later value beats or ties it, and from the front
+ * when the trailing edge passes it. Every buffered entry is therefore
+ * added and removed at most once, instead of being rescanned for each
+ * output row the frame covers.
+ */
+typedef struct SlidingExtremesData
+{
+	MemoryContext mcxt;			/* holds the arrays and by-ref values */
+	int			head;			/* slot of the first value */
+	int			count;			/* number of values in the ring */
+	int			size;			/* number of allocated slots */
+	NTupleStorePos *pos;		/* frame buffer position of each value */
+	Datum	   *values;
+} SlidingExtremesData;
+
 /*
  * WindowStatePerLevelData - per-level working state
  */
@@ -222,6 +244,14 @@ typedef struct WindowStatePerLevelData
 	FrameBufferEntry *trail_entry_buf;
 	FrameBufferEntry *lead_entry_buf;
 	
+	/*
+	 * The last frame buffer entry added to the SlidingExtremesData of the
+	 * functions in this level, and the trailing edge it was added for.
+	 */
+	bool		sliding_has_last;
+	NTupleStorePos sliding_last_pos;
+	NTupleStorePos sliding_start_pos;
+
 	/* A char buffer to temporarily hold serialized data before
 	*  writing them to the frame buffer, and keep deserialized
 	*  data when reading from the frame buffer.
@@ -271,6 +301,14 @@ typedef struct WindowStatePerFunctionData
 	FmgrInfo	invtransfn;
 	FmgrInfo	invprelimfn;
 
+	/*
+	 * For a min/max-like aggregate in a moving frame, the function of its
+	 * sort operator and the values that can still become its result. NULL
+	 * when the frame is evaluated by scanning the frame buffer.
+	 */
+	FmgrInfo	sortopfn;
+	SlidingExtremesData *extremes;
+
 	Datum		aggInitValue;
 	bool		aggInitValueIsNull;
 
@@ -532,6 +570,7 @@ static void resetTransValues(WindowStatePerLevel level_state,
 				 WindowState * wstate);
 static void freeFrameBuffer(WindowFrameBuffer buffer);
 static void freeFrameBuffers(WindowState * wstate);
+static void resetSlidingExtremes(WindowStatePerLevel level_state);
 
 /*
  * WindowBufferCursor
@@ -778,6 +817,8 @@ resetFrameBuffers(WindowState *wstate)
 		level_state->num_trail_rows = 0;
 		level_state->num_lead_rows = 0;
 		level_state->lead_ready = false;
+
+		resetSlidingExtremes(level_state);
 	}
 }
 
@@ -1800,6 +1841,252 @@ freeTransValue(Datum *transValue,
 	*noTransValue = true;
 }
 
+/*
+ * pos_is_before -- is frame buffer position 'a' before position 'b'?
+ */
+static bool
+pos_is_before(NTupleStorePos *a, NTupleStorePos *b)
+{
+	if (a->blockn != b->blockn)
+		return a->blockn < b->blockn;
+	return a->slotn < b->slotn;
+}
+
+/*
+ * popSlidingExtreme -- remove the first (front) or last value from
+ * the SlidingExtremesData of a function.
+ */
+static void
+popSlidingExtreme(WindowStatePerFunction funcstate, bool front)
+{
+	SlidingExtremesData *ext = funcstate->extremes;
+	int			idx;
+
+	Assert(ext->count > 0);
+
+	if (front)
+	{
+		idx = ext->head;
+		ext->head = (ext->head + 1) % ext->size;
+	}
+	else
+		idx = (ext->head + ext->count - 1) % ext->size;
+
+	if (!funcstate->aggTranstypeByVal)
+		pfree(DatumGetPointer(ext->values[idx]));
+	ext->count--;
+}
+
+/*
+ * resetSlidingExtremes -- forget the values collected for the min/max-like
+ * aggregates of a level, e.g. when a new partition starts.
+ */
+static void
+resetSlidingExtremes(WindowStatePerLevel level_state)
+{
+	ListCell   *lc;
+
+	foreach(lc, level_state->level_funcs)
+	{
+		WindowStatePerFunction funcstate = (WindowStatePerFunction) lfirst(lc);
+
+		if (funcstate->extremes == NULL)
+			continue;
+
+		while (funcstate->extremes->count > 0)
+			popSlidingExtreme(funcstate, true);
+		funcstate->extremes->head = 0;
+	}
+
+	level_state->sliding_has_last = false;
+}
+
+/*
+ * pushSlidingExtreme -- add the value of a new frame buffer entry to the
+ * SlidingExtremesData of a function, after dropping the values it beats.
+ */
+static void
+pushSlidingExtreme(WindowStatePerFunction funcstate, WindowState *wstate,
+				   NTupleStorePos *pos, Datum value)
+{
+	SlidingExtremesData *ext = funcstate->extremes;
+	ExprContext *econtext = wstate->ps.ps_ExprContext;
+	MemoryContext oldctx;
+	int			idx;
+
+	oldctx = MemoryContextSwitchTo(econtext->ecxt_per_tuple_memory);
+	while (ext->count > 0)
+	{
+		idx = (ext->head + ext->count - 1) % ext->size;
+		if (DatumGetBool(FunctionCall2(&funcstate->sortopfn,
+									   ext->values[idx], value)))
+			break;
+		popSlidingExtreme(funcstate, false);
+	}
+	MemoryContextSwitchTo(oldctx);
+
+	if (ext->count == ext->size)
+	{
+		int			newsize = ext->size * 2;
+		NTupleStorePos *newpos;
+		Datum	   *newvalues;
+		int			i;
+
+		newpos = MemoryContextAlloc(ext->mcxt, newsize * sizeof(NTupleStorePos));
+		newvalues = MemoryContextAlloc(ext->mcxt, newsize * sizeof(Datum));
+		for (i = 0; i < ext->count; i++)
+		{
+			newpos[i] = ext->pos[(ext->head + i) % ext->size];
+			newvalues[i] = ext->values[(ext->head + i) % ext->size];
+		}
+		pfree(ext->pos);
+		pfree(ext->values);
+		ext->pos = newpos;
+		ext->values = newvalues;
+		ext->size = newsize;
+		ext->head = 0;
+	}
+
+	idx = (ext->head + ext->count) % ext->size;
+	ext->pos[idx] = *pos;
+	oldctx = MemoryContextSwitchTo(ext->mcxt);
+	ext->values[idx] = datumCopy(value, funcstate->aggTranstypeByVal,
+								 funcstate->aggTranstypeLen);
+	MemoryContextSwitchTo(oldctx);
+	ext->count++;
+}
+
+/*
+ * computeSlidingExtremes -- compute the aggregate over the frame buffer
+ * entries in the current frame for the min/max-like aggregates of a
+ * level, i.e. those having a SlidingExtremesData.
+ *
+ * The trail_reader must already point to the first entry in the frame.
+ * Only the entries that entered the frame since the last call are read.
+ * If either edge moved backwards, the collected values are thrown away
+ * and the whole frame is read again.
+ */
+static void
+computeSlidingExtremes(WindowStatePerLevel level_state,
+					   WindowState * wstate,
+					   bool has_tuples)
+{
+	NTupleStoreAccessor *reader = level_state->frame_buffer->reader;
+	FrameBufferEntry *curr_entry = level_state->curr_entry_buf;
+	NTupleStorePos start_pos;
+	NTupleStorePos lead_pos;
+	NTupleStorePos pos;
+	bool		has_start;
+	bool		has_lead;
+	bool		found;
+	ListCell   *lc;
+
+	has_start = has_tuples &&
+		ntuplestore_acc_tell(level_state->trail_reader, &start_pos);
+	has_lead = ntuplestore_acc_tell(level_state->lead_reader, &lead_pos);
+
+	if (has_start)
+	{
+		/*
+		 * Start over if an edge moved backwards, or if the trailing edge
+		 * passed every entry added so far.
+		 */
+		if (level_state->sliding_has_last &&
+			(pos_is_before(&start_pos, &level_state->sliding_start_pos) ||
+			 pos_is_before(&level_state->sliding_last_pos, &start_pos) ||
+			 (has_lead &&
+			  pos_is_before(&lead_pos, &level_state->sliding_last_pos))))
+			resetSlidingExtremes(level_state);
+
+		/* Continue after the last entry added. */
+		found = false;
+		if (level_state->sliding_has_last)
+		{
+			found = ntuplestore_acc_seek(reader, &level_state->sliding_last_pos);
+			if (found)
+				found = ntuplestore_acc_advance(reader, 1);
+			else
+				resetSlidingExtremes(level_state);
+		}
+		if (!level_state->sliding_has_last)
+			found = ntuplestore_acc_seek(reader, &start_pos);
+
+		while (found)
+		{
+			if (has_lead &&
+				ntuplestore_acc_is_before(level_state->lead_reader, reader))
+				break;
+
+			found = getCurrentValue(reader, level_state, curr_entry);
+			Assert(found);
+			ntuplestore_acc_tell(reader, &pos);
+
+			foreach(lc, level_state->level_funcs)
+			{
+				WindowStatePerFunction funcstate =
+					(WindowStatePerFunction) lfirst(lc);
+				WindowValue *curr_value;
+
+				if (funcstate->extremes == NULL)
+					continue;
+
+				curr_value = (WindowValue *)
+					list_nth(curr_entry->func_values, funcstate->serial_index);
+				if (!curr_value->valueIsNull)
+					pushSlidingExtreme(funcstate, wstate, &pos,
+									   curr_value->value);
+			}
+
+			level_state->sliding_has_last = true;
+			level_state->sliding_last_pos = pos;
+			found = ntuplestore_acc_advance(reader, 1);
+		}
+
+		level_state->sliding_start_pos = start_pos;
+	}
+
+	foreach(lc, level_state->level_funcs)
+	{
+		WindowStatePerFunction funcstate = (WindowStatePerFunction) lfirst(lc);
+		SlidingExtremesData *ext = funcstate->extremes;
+
+		if (ext == NULL)
+			continue;
+
+		freeTransValue(&funcstate->final_aggTransValue,
+					   funcstate->aggTranstypeByVal,
+					   &funcstate->final_aggTransValueIsNull,
+					   &funcstate->final_aggNoTransValue,
+					   funcstate->final_aggShouldFree);
+
+		if (has_start)
+		{
+			while (ext->count > 0 &&
+				   pos_is_before(&ext->pos[ext->head], &start_pos))
+				popSlidingExtreme(funcstate, true);
+		}
+
+		if (has_start && ext->count > 0)
+		{
+			funcstate->final_aggTransValue =
+				datumCopyWithMemManager(0, ext->values[ext->head],
+										funcstate->aggTranstypeByVal,
+										funcstate->aggTranstypeLen,
+										&(wstate->mem_manager));
+			funcstate->final_aggTransValueIsNull = false;
+			funcstate->final_aggNoTransValue = false;
+			funcstate->final_aggShouldFree = true;
+		}
+		else
+		{
+			funcstate->final_aggTransValue = funcstate->aggInitValue;
+			funcstate->final_aggTransValueIsNull = funcstate->aggInitValueIsNull;
+			funcstate->final_aggNoTransValue = funcstate->aggInitValueIsNull;
+			funcstate->final_aggShouldFree = false;
+		}
+	}
+}
+
 /*
  * computeTransValuesThroughScan -- compute transition values
  * for those functions in the given level whose aggregate values
@@ -1819,6 +2106,8 @@ computeTransValuesThroughScan(WindowStatePerLevel level_state,
 	ExprContext *econtext = wstate->ps.ps_ExprContext;
 	FunctionCallInfoData fcinfo;
 	NTupleStorePos orig_pos;
+	bool		need_scan = false;
+	bool		has_extremes = false;
 
 	has_tuples = hasTuplesInFrame(level_state, wstate);
 
@@ -1858,6 +2147,15 @@ computeTransValuesThroughScan(WindowStatePerLevel level_state,
 			!funcstate->plain_agg)
 			continue;
 
+		/* min/max-like aggregates are computed by computeSlidingExtremes. */
+		if (funcstate->extremes != NULL)
+		{
+			has_extremes = true;
+			continue;
+		}
+
+		need_scan = true;
+
 		freeTransValue(&funcstate->final_aggTransValue,
 					   funcstate->aggTranstypeByVal,
 					   &funcstate->final_aggTransValueIsNull,
@@ -1874,11 +2172,15 @@ computeTransValuesThroughScan(WindowStatePerLevel level_state,
 		funcstate->final_aggShouldFree = !funcstate->aggInitValueIsNull;
 	}
 
+	if (has_extremes)
+		computeSlidingExtremes(level_state, wstate, has_tuples);
+
 	if (has_tuples)
 	{
 		bool		include_last_agg = false;
 
-		while (ntuplestore_acc_tell(level_state->trail_reader, NULL))
+		while (need_scan &&
+			   ntuplestore_acc_tell(level_state->trail_reader, NULL))
 		{
 			if (ntuplestore_acc_tell(level_state->lead_reader, NULL) &&
 				ntuplestore_acc_is_before(level_state->lead_reader,
@@ -1904,7 +2206,8 @@ computeTransValuesThroughScan(WindowStatePerLevel level_state,
 					funcstate->winpeercount ||
 					(funcstate->plain_agg &&
 					 OidIsValid(funcstate->invprelimfn_oid)) ||
-					!funcstate->plain_agg)
+					!funcstate->plain_agg ||
+					funcstate->extremes != NULL)
 					continue;
 
 				if (OidIsValid(funcstate->prelimfn_oid))
@@ -6080,6 +6383,34 @@ initialize_peragg(WindowState *winstate, WindowFunc *wfunc,
 							wfunc->winfnoid)));
 	}
 
+	/*
+	 * A min/max-like aggregate, whose result is the first input under its
+	 * sort operator, can follow a moving frame with SlidingExtremesData
+	 * instead of scanning the frame buffer for every row. This only holds
+	 * when each buffered value is an input value itself.
+	 */
+	if (gp_enable_window_sliding_extremes &&
+		!funcstate->trivial_frame &&
+		OidIsValid(aggform->aggsortop) &&
+		OidIsValid(prelimfn_oid) &&
+		!OidIsValid(invprelimfn_oid) &&
+		numArguments == 1 &&
+		aggtranstype == inputTypes[0] &&
+		funcstate->aggInitValueIsNull)
+	{
+		SlidingExtremesData *ext = palloc(sizeof(SlidingExtremesData));
+
+		fmgr_info(get_opcode(aggform->aggsortop), &funcstate->sortopfn);
+
+		ext->mcxt = CurrentMemoryContext;
+		ext->head = 0;
+		ext->count = 0;
+		ext->size = 64;
+		ext->pos = palloc(ext->size * sizeof(NTupleStorePos));
+		ext->values = palloc(ext->size * sizeof(Datum));
+		funcstate->extremes = ext;
+	}
+
 	ReleaseSysCache(aggTuple);
 }
 
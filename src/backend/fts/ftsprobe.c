@@ -13,7 +13,6 @@
  *-------------------------------------------------------------------------
  */
 #include "postgres.h"
-#include <pthread.h>
 #include <limits.h>
 
 #include <sys/socket.h>
@@ -23,7 +22,6 @@
 #include "gp-libpq-fe.h"
 #include "gp-libpq-int.h"
 
-#include "cdb/cdbgang.h"		/* gp_pthread_create */
 #include "libpq/ip.h"
 #include "postmaster/fts.h"
 #include "postmaster/ftsprobe.h"
@@ -52,6 +50,8 @@
 #define PROBE_RESPONSE_LEN  (20)         /* size of segment response message */
 #endif
 
+#define PROBE_POLL_TIMEOUT_MS  (1000)     /* how long one poll() over all probes may wait */
+
 
 /*
  * MACROS
@@ -69,226 +69,261 @@ typedef struct ProbeMsg
 	PrimaryMirrorTransitionPacket payload;
 } ProbeMsg;
 
-/*
- * STATIC VARIABLES
- */
-
-#ifdef USE_SEGWALREP
-/* mutex used for pthread synchronization in parallel probing */
-static pthread_mutex_t worker_thread_mutex = PTHREAD_MUTEX_INITIALIZER;
-#endif
-
 /*
  * FUNCTION PROTOTYPES
  */
 
-static bool probeConnect(CdbComponentDatabaseInfo *dbInfo, ProbeConnectionInfo *probeInfo);
-static bool probePollOut(ProbeConnectionInfo *probeInfo);
+static void probeEventLoop(ProbeConnectionInfo *probes, int nprobes);
+static void probeFinish(ProbeConnectionInfo *probeInfo, bool succeeded);
+static bool probeConnect(ProbeConnectionInfo *probeInfo);
+static bool probePollOut(ProbeConnectionInfo *probeInfo, short revents);
 static bool probeSend(ProbeConnectionInfo *probeInfo);
-static bool probePollIn(ProbeConnectionInfo *probeInfo);
+static bool probePollIn(ProbeConnectionInfo *probeInfo, short revents);
 static bool probeReceive(ProbeConnectionInfo *probeInfo);
 static bool probeProcessResponse(ProbeConnectionInfo *probeInfo);
 static bool probeTimeout(ProbeConnectionInfo *probeInfo, const char* calledFrom);
 
 /*
- * strerror() is not threadsafe.  Therefore, prober threads must use
- * the correct strerror_r() available on the platform to obtain error
- * message corresponding to errno.
+ * Probe a set of segments in parallel.
+ *
+ * One event loop drives all of the probes: a non-blocking connection is
+ * started to every segment up front, and a single poll() over all of the
+ * sockets advances whichever probes are ready.  A probe round thus takes
+ * about as long as the slowest segment instead of growing with the number
+ * of segments.
+ *
+ * Segments that fail a round (error or timeout) are suspected to be down,
+ * and only those are probed again, for at most gp_fts_probe_retries rounds
+ * in total; the segments that responded are not probed a second time.
  */
-static char *errmessage(ProbeConnectionInfo *probeInfo)
+void
+probeSegments(ProbeConnectionInfo *probes, int nprobes)
 {
-#if (_POSIX_C_SOURCE >= 200112L || _XOPEN_SOURCE >= 600) && ! _GNU_SOURCE
-	/* POSIX compliant version (seen on OSX 10.9) */
-	int ret = strerror_r(probeInfo->probe_errno,
-						 probeInfo->errmsg, PROBE_ERR_MSG_LEN);
-	if (ret != 0)
-		probeInfo->errmsg[0] = '\0';
-#else
-	/* GNU version (seen on RHEL 6.2) */
-	char *msg = strerror_r(probeInfo->probe_errno,
-						   probeInfo->errmsg, PROBE_ERR_MSG_LEN);
-	if (msg == NULL)
-		probeInfo->errmsg[0] = '\0';
-	else
+	int			retryCnt = 0;
+	int			nsuspected = 0;
+	int			i;
+
+	for (i = 0; i < nprobes; i++)
 	{
-		strncpy(probeInfo->errmsg, msg, PROBE_ERR_MSG_LEN-1);
-		/* In case strncpy doesn't null-terminate errmsg */
-		probeInfo->errmsg[PROBE_ERR_MSG_LEN-1] = '\0';
+		probes[i].state = PROBE_CONN_PENDING;
+		probes[i].conn = NULL;
 	}
-#endif
-	return probeInfo->errmsg;
-}
 
-#ifdef USE_SEGWALREP
-void
-#else
-char
-#endif
-probeSegmentHelper(CdbComponentDatabaseInfo *dbInfo, ProbeConnectionInfo probeInfo)
-{
-	/*
-	 * probe segment: open socket -> connect -> send probe msg -> receive response;
-	 * on any error the connection is shut down, the socket is closed
-	 * and the probe process is restarted;
-	 * this is repeated until no error occurs (response is received) or timeout expires;
-	 */
-
-	int retryCnt = 0;
-	/* reset timer */
-	gp_set_monotonic_begin_time(&probeInfo.startTime);
-	while (retryCnt < gp_fts_probe_retries && FtsIsActive() && (
-			   !probeConnect(dbInfo, &probeInfo) ||
-			   !probePollOut(&probeInfo) ||
-			   !probeSend(&probeInfo) ||
-			   !probePollIn(&probeInfo) ||
-			   !probeReceive(&probeInfo) ||
-			   !probeProcessResponse(&probeInfo)))
+	while (retryCnt < gp_fts_probe_retries && FtsIsActive())
 	{
-		PQfinish(probeInfo.conn);
-		probeInfo.conn = NULL;
+		probeEventLoop(probes, nprobes);
+		retryCnt++;
+
+		nsuspected = 0;
+		for (i = 0; i < nprobes; i++)
+		{
+			if (probes[i].state == PROBE_CONN_FAILED)
+				nsuspected++;
+		}
+
+		if (nsuspected == 0 || retryCnt == gp_fts_probe_retries || !FtsIsActive())
+			break;
 
 		/* sleep for 1 second to avoid tight loops */
 		pg_usleep(USECS_PER_SEC);
-		retryCnt++;
 
-		write_log("FTS: retry %d to probe segment (content=%d, dbid=%d).",
-				  retryCnt - 1, probeInfo.segmentId, probeInfo.dbId);
-
-		/* reset timer */
-		gp_set_monotonic_begin_time(&probeInfo.startTime);
-	}
+		/* re-probe just the suspected segments */
+		for (i = 0; i < nprobes; i++)
+		{
+			if (probes[i].state != PROBE_CONN_FAILED)
+				continue;
 
-	if (!FtsIsActive())
-	{
-		/* the returned value will be ignored */
-#ifndef USE_SEGWALREP
-		probeInfo.segmentStatus = PROBE_ALIVE;
-#endif
+			write_log("FTS: retry %d to probe segment (content=%d, dbid=%d).",
+					  retryCnt, probes[i].segmentId, probes[i].dbId);
+			probes[i].state = PROBE_CONN_PENDING;
+		}
 	}
 
-	if (retryCnt == gp_fts_probe_retries)
+	if (nsuspected > 0 && retryCnt == gp_fts_probe_retries)
 	{
-		write_log("FTS: failed to probe segment (content=%d, dbid=%d) after trying %d time(s), "
-				  "maximum number of retries reached.",
-				  probeInfo.segmentId,
-				  probeInfo.dbId,
-				  retryCnt);
+		for (i = 0; i < nprobes; i++)
+		{
+			if (probes[i].state != PROBE_CONN_FAILED)
+				continue;
+
+			write_log("FTS: failed to probe segment (content=%d, dbid=%d) after trying %d time(s), "
+					  "maximum number of retries reached.",
+					  probes[i].segmentId,
+					  probes[i].dbId,
+					  retryCnt);
+		}
 	}
-
-	if (probeInfo.conn)
-		PQfinish(probeInfo.conn);
-
-#ifndef USE_SEGWALREP
-	return probeInfo.segmentStatus;
-#endif
 }
 
-#ifdef USE_SEGWALREP
+/*
+ * Run one probe round over all pending probes: connect -> wait for the
+ * socket to become writable -> send probe msg -> wait for the socket to
+ * become readable -> receive and process the response.  Every probe ends
+ * up either succeeded or failed; a failed probe has its connection closed.
+ */
 static void
-probeWalRepSegment(probe_response_per_segment *response)
+probeEventLoop(ProbeConnectionInfo *probes, int nprobes)
 {
-	Assert(response);
-	CdbComponentDatabaseInfo *segment_db_info = response->segment_db_info;
-	Assert(segment_db_info);
+	struct pollfd *fds;
+	ProbeConnectionInfo **fdProbes;
+	ProbeConnectionInfo *probeInfo;
+	int			i;
 
-	if(!FtsIsSegmentAlive(response->segment_db_info))
+	fds = (struct pollfd *) palloc(nprobes * sizeof(struct pollfd));
+	fdProbes = (ProbeConnectionInfo **) palloc(nprobes * sizeof(ProbeConnectionInfo *));
+
+	/* start non-blocking connections to all the segments at once */
+	for (i = 0; i < nprobes; i++)
 	{
-		response->result.isPrimaryAlive = false;
-		response->result.isMirrorAlive = false;
+		probeInfo = &probes[i];
+
+		if (probeInfo->state != PROBE_CONN_PENDING)
+			continue;
+
+		gp_set_monotonic_begin_time(&probeInfo->startTime);
 
-		return;
+		if (probeConnect(probeInfo))
+			probeInfo->state = PROBE_CONN_CONNECTING;
+		else
+			probeFinish(probeInfo, false);
 	}
 
-	/* setup probe descriptor */
-	ProbeConnectionInfo probeInfo;
-	memset(&probeInfo, 0, sizeof(ProbeConnectionInfo));
-	probeInfo.segmentId = segment_db_info->segindex;
-	probeInfo.dbId = segment_db_info->dbid;
-	probeInfo.role = segment_db_info->role;
-	probeInfo.mode = segment_db_info->mode;
-	probeInfo.result = &(response->result);
+	while (FtsIsActive())
+	{
+		int			nfds = 0;
+		int			ret;
 
-	probeSegmentHelper(segment_db_info, probeInfo);
-}
+		/* collect the sockets of the probes still in flight */
+		for (i = 0; i < nprobes; i++)
+		{
+			probeInfo = &probes[i];
 
-static void *
-probeWalRepSegmentFromThread(void *arg)
-{
-	probe_context *context = (probe_context *)arg;
+			if (probeInfo->state != PROBE_CONN_CONNECTING &&
+				probeInfo->state != PROBE_CONN_AWAITING_RESPONSE)
+				continue;
 
-	Assert(context);
+			if (probeTimeout(probeInfo, "probeEventLoop"))
+			{
+				probeFinish(probeInfo, false);
+				continue;
+			}
 
-	int number_of_probed_segments = 0;
+			fds[nfds].fd = PQsocket(probeInfo->conn);
+			fds[nfds].events =
+				(probeInfo->state == PROBE_CONN_CONNECTING) ? POLLOUT : POLLIN;
+			fds[nfds].revents = 0;
+			fdProbes[nfds] = probeInfo;
+			nfds++;
+		}
 
-	while(number_of_probed_segments < context->count)
-	{
-		/*
-		 * Look for the unprocessed context
-		 */
-		int response_index = number_of_probed_segments;
+		if (nfds == 0)
+			break;
 
-		pthread_mutex_lock(&worker_thread_mutex);
-		while(response_index < context->count)
+		ret = poll(fds, nfds, PROBE_POLL_TIMEOUT_MS);
+		if (ret < 0)
 		{
-			if (!context->responses[response_index].isScheduled)
+			if (SYS_ERR_TRANSIENT(errno))
+				continue;
+
+			write_log("FTS: poll error on libpq sockets: %s", strerror(errno));
+			break;
+		}
+
+		for (i = 0; i < nfds && ret > 0; i++)
+		{
+			probeInfo = fdProbes[i];
+
+			if (fds[i].revents == 0)
+				continue;
+			ret--;
+
+			if (probeInfo->state == PROBE_CONN_CONNECTING)
 			{
-				context->responses[response_index].isScheduled = true;
-				break;
+				if (probePollOut(probeInfo, fds[i].revents) && probeSend(probeInfo))
+					probeInfo->state = PROBE_CONN_AWAITING_RESPONSE;
+				else
+					probeFinish(probeInfo, false);
+			}
+			else
+			{
+				if (!probePollIn(probeInfo, fds[i].revents) || !probeReceive(probeInfo))
+					probeFinish(probeInfo, false);
+				else if (probeInfo->conn->inEnd - probeInfo->conn->inStart >= PROBE_RESPONSE_LEN)
+					probeFinish(probeInfo, probeProcessResponse(probeInfo));
+
+				/* otherwise wait for the rest of the response */
 			}
-			number_of_probed_segments++;
-			response_index++;
 		}
-		pthread_mutex_unlock(&worker_thread_mutex);
+	}
 
-		/*
-		 * If probed all the segments, we are done.
-		 */
-		if (response_index == context->count)
-			break;
+	/* FTS is pausing or shutting down, or poll() failed: abandon the rest */
+	for (i = 0; i < nprobes; i++)
+	{
+		probeInfo = &probes[i];
 
-		/*
-		 * If FTS is shutdown, abort.
-		 */
-		if (!FtsIsActive())
-			break;
+		if (probeInfo->state == PROBE_CONN_CONNECTING ||
+			probeInfo->state == PROBE_CONN_AWAITING_RESPONSE)
+			probeFinish(probeInfo, false);
+	}
 
-		/* now let's probe the primary. */
-		probe_response_per_segment *response = &context->responses[response_index];
-		Assert(SEGMENT_IS_ACTIVE_PRIMARY(response->segment_db_info));
-		probeWalRepSegment(response);
+	pfree(fds);
+	pfree(fdProbes);
+}
+
+/*
+ * Close the probe's connection and record the outcome of this round.
+ */
+static void
+probeFinish(ProbeConnectionInfo *probeInfo, bool succeeded)
+{
+	if (probeInfo->conn)
+	{
+		PQfinish(probeInfo->conn);
+		probeInfo->conn = NULL;
 	}
 
-	return NULL;
+	probeInfo->state = succeeded ? PROBE_CONN_SUCCEEDED : PROBE_CONN_FAILED;
 }
 
+#ifdef USE_SEGWALREP
 void
 FtsWalRepProbeSegments(probe_context *context)
 {
-	int workers = gp_fts_probe_threadcount;
-	pthread_t *threads = NULL;
+	ProbeConnectionInfo *probes;
+	int			nprobes = 0;
+
 	Assert(context);
 
-	threads = (pthread_t *)palloc(workers * sizeof(pthread_t));
+	probes = (ProbeConnectionInfo *) palloc0(context->count * sizeof(ProbeConnectionInfo));
 
-	for(int i = 0; i < workers; i++)
+	for (int response_index = 0; response_index < context->count; response_index++)
 	{
-		int ret = gp_pthread_create(&threads[i], probeWalRepSegmentFromThread, context, "FtsWalRepProbeSegments");
+		probe_response_per_segment *response = &context->responses[response_index];
+		CdbComponentDatabaseInfo *segment_db_info = response->segment_db_info;
+
+		Assert(segment_db_info);
+		Assert(SEGMENT_IS_ACTIVE_PRIMARY(segment_db_info));
 
-		if (ret)
+		if (!FtsIsSegmentAlive(segment_db_info))
 		{
-			ereport(ERROR, (errmsg("FTS: failed to create probing thread")));
+			response->result.isPrimaryAlive = false;
+			response->result.isMirrorAlive = false;
+			continue;
 		}
+
+		/* setup probe descriptor */
+		ProbeConnectionInfo *probeInfo = &probes[nprobes++];
+		probeInfo->dbInfo = segment_db_info;
+		probeInfo->segmentId = segment_db_info->segindex;
+		probeInfo->dbId = segment_db_info->dbid;
+		probeInfo->role = segment_db_info->role;
+		probeInfo->mode = segment_db_info->mode;
+		probeInfo->result = &(response->result);
 	}
 
-	for(int i = 0; i < workers; i++)
-	{
-		int ret = pthread_join(threads[i], NULL);
+	probeSegments(probes, nprobes);
 
-		if (ret)
-		{
-			ereport(ERROR, (errmsg("FTS: failed to join probing thread")));
-		}
-	}
+	pfree(probes);
 }
 #endif
 
@@ -296,8 +331,9 @@ FtsWalRepProbeSegments(probe_context *context)
  * Establish async libpq connection to a segment
  */
 static bool
-probeConnect(CdbComponentDatabaseInfo *dbInfo, ProbeConnectionInfo *probeInfo)
+probeConnect(ProbeConnectionInfo *probeInfo)
 {
+	CdbComponentDatabaseInfo *dbInfo = probeInfo->dbInfo;
 	char conninfo[1024];
 	snprintf(conninfo, 1024, "postgresql://%s:%d", dbInfo->hostip, dbInfo->port);
 	probeInfo->conn = PQconnectStart(conninfo);
@@ -318,30 +354,15 @@ probeConnect(CdbComponentDatabaseInfo *dbInfo, ProbeConnectionInfo *probeInfo)
 }
 
 /*
- * Wait for a socket to become available for writing.
+ * The socket has become available for writing: advance the connection.
  */
 static bool
-probePollOut(ProbeConnectionInfo *probeInfo)
+probePollOut(ProbeConnectionInfo *probeInfo, short revents)
 {
-	struct pollfd nfd;
-	nfd.fd = PQsocket(probeInfo->conn);
-	nfd.events = POLLOUT;
-	int ret;
-
-	while ((ret = poll(&nfd, 1, 1000)) < 0 &&
-		   (errno == EAGAIN || errno == EINTR) &&
-		   !probeTimeout(probeInfo, "probePollOut"));
-	if (ret == 0)
+	if (revents & POLLNVAL)
 	{
-		write_log("FTS: pollout timeout waiting for libpq socket to become available,"
-				  " (content=%d, dbid=%d)", probeInfo->segmentId, probeInfo->dbId);
-		return false;
-	}
-	if (ret == -1)
-	{
-		probeInfo->probe_errno = errno;
-		write_log("FTS: pollout error on libpq socket (content=%d, dbid=%d): %s",
-				  probeInfo->segmentId, probeInfo->dbId, errmessage(probeInfo));
+		write_log("FTS: pollout error on libpq socket (content=%d, dbid=%d): "
+				  "invalid socket", probeInfo->segmentId, probeInfo->dbId);
 		return false;
 	}
 
@@ -390,54 +411,38 @@ probeSend(ProbeConnectionInfo *probeInfo)
 }
 
 /*
- * Wait for a socket to become available for reading.
+ * The socket has become available for reading.
  */
 static bool
-probePollIn(ProbeConnectionInfo *probeInfo)
+probePollIn(ProbeConnectionInfo *probeInfo, short revents)
 {
-	struct pollfd nfd;
-	nfd.fd = PQsocket(probeInfo->conn);
-	nfd.events = POLLIN;
-	int ret;
-	while ((ret = poll(&nfd, 1, 1000)) < 0 &&
-		   (errno == EAGAIN || errno == EINTR) &&
-		   !probeTimeout(probeInfo, "probePollIn"));
-	if (ret == 0)
+	if (revents & POLLNVAL)
 	{
-		write_log("FTS: pollin timeout waiting for libpq socket to become "
-				  "available (content=%d, dbid=%d)", probeInfo->segmentId,
-				  probeInfo->dbId);
-	}
-	else if (ret == -1)
-	{
-		probeInfo->probe_errno = errno;
-		write_log("FTS: pollin error on libpq socket (content=%d, dbid=%d): %s",
-				  probeInfo->segmentId, probeInfo->dbId, errmessage(probeInfo));
+		write_log("FTS: pollin error on libpq socket (content=%d, dbid=%d): "
+				  "invalid socket", probeInfo->segmentId, probeInfo->dbId);
+		return false;
 	}
-	return (ret > 0);
+
+	/* on POLLERR or POLLHUP, probeReceive() reports the actual error */
+	return true;
 }
 
 /*
- * Receive segment response
+ * Receive segment response; returns false on error.  A partial response
+ * is left in the connection's input buffer until the rest arrives.
  */
 static bool
 probeReceive(ProbeConnectionInfo *probeInfo)
 {
-	int ret;
-	if ((ret = pqReadData(probeInfo->conn)) == -1)
+	if (pqReadData(probeInfo->conn) == -1)
 	{
 		write_log("FTS: error reading probe response from libpq socket "
 				  "(content=%d, dbid=%d): %s",
 				  probeInfo->segmentId, probeInfo->dbId,
 				  probeInfo->conn->errorMessage.data);
+		return false;
 	}
-	else if (ret == 0)
-	{
-		write_log("FTS: no probe response available on libpq socket "
-				  "(content=%d, dbid=%d)",
-				  probeInfo->segmentId, probeInfo->dbId);
-	}
-	return (ret > 0);
+	return true;
 }
 
 /*
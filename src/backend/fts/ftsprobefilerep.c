@@ -12,16 +12,8 @@
  *-------------------------------------------------------------------------
  */
 #include "postgres.h"
-#include <pthread.h>
 #include "postmaster/fts.h"
 #include "postmaster/ftsprobe.h"
-#include "gp-libpq-fe.h"
-#include "gp-libpq-int.h"
-
-typedef struct threadWorkerInfo
-{
-	uint8 *scan_status;
-} threadWorkerInfo;
 
 /* struct holding segment configuration */
 static CdbComponentDatabases *cdb_component_dbs = NULL;
@@ -29,144 +21,22 @@ static CdbComponentDatabases *cdb_component_dbs = NULL;
 /* one byte of status for each segment */
 static uint8 *scan_status;
 
-/* mutex used for pthread synchronization in parallel probing */
-static pthread_mutex_t worker_thread_mutex = PTHREAD_MUTEX_INITIALIZER;
-
 /*
- * This is called from several different threads: ONLY USE THREADSAFE FUNCTIONS INSIDE.
+ * Setup the probe descriptor for a segment.
  */
-static char probeSegment(CdbComponentDatabaseInfo *dbInfo)
+static void
+probeInitSegment(ProbeConnectionInfo *probeInfo, CdbComponentDatabaseInfo *dbInfo)
 {
 	Assert(dbInfo != NULL);
 
-	/* setup probe descriptor */
-	ProbeConnectionInfo probeInfo;
-	memset(&probeInfo, 0, sizeof(ProbeConnectionInfo));
-	probeInfo.segmentId = dbInfo->segindex;
-	probeInfo.dbId = dbInfo->dbid;
-	probeInfo.role = dbInfo->role;
-	probeInfo.mode = dbInfo->mode;
-
-	probeInfo.segmentStatus = PROBE_DEAD;
+	memset(probeInfo, 0, sizeof(ProbeConnectionInfo));
+	probeInfo->dbInfo = dbInfo;
+	probeInfo->segmentId = dbInfo->segindex;
+	probeInfo->dbId = dbInfo->dbid;
+	probeInfo->role = dbInfo->role;
+	probeInfo->mode = dbInfo->mode;
 
-	return probeSegmentHelper(dbInfo, probeInfo);
-}
-
-/*
- * Function called by probing thread;
- * iteratively picks next segment pair to probe until all segments are probed;
- * probes primary; probes mirror if primary reports crash fault or does not respond
- */
-static void *
-probeSegmentFromThread(void *arg)
-{
-	threadWorkerInfo *worker_info;
-	int i;
-
-	worker_info = (threadWorkerInfo *) arg;
-	Assert(cdb_component_dbs != NULL);
-	i = 0;
-
-	for (;;)
-	{
-		CdbComponentDatabaseInfo *primary = NULL;
-		CdbComponentDatabaseInfo *mirror = NULL;
-
-		char probe_result_primary = PROBE_DEAD;
-		char probe_result_mirror = PROBE_DEAD;
-
-		/*
-		 * find untested primary, mark primary and mirror "tested" and unlock.
-		 */
-		pthread_mutex_lock(&worker_thread_mutex);
-		for (; i < cdb_component_dbs->total_segment_dbs; i++)
-		{
-			primary = &cdb_component_dbs->segment_db_info[i];
-
-			/* check segments in pairs of primary-mirror */
-			if (!SEGMENT_IS_ACTIVE_PRIMARY(primary))
-			{
-				continue;
-			}
-
-			if (PROBE_CHECK_FLAG(worker_info->scan_status[primary->dbid], PROBE_SEGMENT))
-			{
-				/* prevent re-checking this pair */
-				worker_info->scan_status[primary->dbid] &= ~PROBE_SEGMENT;
-
-				mirror = FtsGetPeerSegment(primary->segindex, primary->dbid);
-
-				/* check if mirror is marked for probing */
-				if (mirror != NULL &&
-					PROBE_CHECK_FLAG(worker_info->scan_status[mirror->dbid], PROBE_SEGMENT))
-				{
-					worker_info->scan_status[mirror->dbid] &= ~PROBE_SEGMENT;
-				}
-				else
-				{
-					mirror = NULL;
-				}
-
-				break;
-			}
-		}
-		pthread_mutex_unlock(&worker_thread_mutex);
-
-		/* check if all segments were probed */
-		if (i == cdb_component_dbs->total_segment_dbs || primary == NULL)
-		{
-			break;
-		}
-
-		/* if we've gotten a pause or shutdown request, we ignore probe results. */
-		if (!FtsIsActive())
-		{
-			break;
-		}
-
-		/* probe primary */
-		probe_result_primary = probeSegment(primary);
-		Assert(!PROBE_CHECK_FLAG(probe_result_primary, PROBE_SEGMENT));
-
-		if ((probe_result_primary & PROBE_ALIVE) == 0 && gp_log_fts >= GPVARS_VERBOSITY_VERBOSE)
-		{
-			write_log("FTS: primary (content=%d, dbid=%d, status 0x%x) didn't respond to probe.",
-			          primary->segindex, primary->dbid, probe_result_primary);
-		}
-
-		if (mirror != NULL)
-		{
-			/* assume mirror is alive */
-			probe_result_mirror = PROBE_ALIVE;
-
-			/* probe mirror only if primary is dead or has a crash/network fault */
-			if (!PROBE_CHECK_FLAG(probe_result_primary, PROBE_ALIVE) ||
-				PROBE_CHECK_FLAG(probe_result_primary, PROBE_FAULT_CRASH) ||
-				PROBE_CHECK_FLAG(probe_result_primary, PROBE_FAULT_NET))
-			{
-				/* probe mirror */
-				probe_result_mirror = probeSegment(mirror);
-				Assert(!PROBE_CHECK_FLAG(probe_result_mirror, PROBE_SEGMENT));
-
-				if ((probe_result_mirror & PROBE_ALIVE) == 0 && gp_log_fts >= GPVARS_VERBOSITY_VERBOSE)
-				{
-					write_log("FTS: mirror (content=%d, dbid=%d, status 0x%x) didn't respond to probe.",
-					          mirror->segindex, mirror->dbid, probe_result_mirror);
-				}
-			}
-		}
-
-		/* update results */
-		pthread_mutex_lock(&worker_thread_mutex);
-		worker_info->scan_status[primary->dbid] = probe_result_primary;
-		if (mirror != NULL)
-		{
-			worker_info->scan_status[mirror->dbid] = probe_result_mirror;
-		}
-		pthread_mutex_unlock(&worker_thread_mutex);
-	}
-
-	return NULL;
+	probeInfo->segmentStatus = PROBE_DEAD;
 }
 
 /*
@@ -177,9 +47,10 @@ FtsProbeSegments(CdbComponentDatabases *dbs, uint8 *probeRes)
 {
 	int i;
 
-	threadWorkerInfo worker_info;
-	int workers = gp_fts_probe_threadcount;
-	pthread_t *threads = NULL;
+	ProbeConnectionInfo *probes;
+	ProbeConnectionInfo *mirrorProbes;
+	int nprobes;
+	int nmirrorProbes;
 
 	cdb_component_dbs = dbs;
 	scan_status = probeRes;
@@ -208,32 +79,82 @@ FtsProbeSegments(CdbComponentDatabases *dbs, uint8 *probeRes)
 		}
 	}
 
-	worker_info.scan_status = scan_status;
+	/*
+	 * Probe all the primaries marked for probing in one parallel round.
+	 */
+	probes = (ProbeConnectionInfo *) palloc(dbs->total_segment_dbs * sizeof(ProbeConnectionInfo));
+	nprobes = 0;
+	for (i = 0; i < dbs->total_segment_dbs; i++)
+	{
+		CdbComponentDatabaseInfo *primary = &dbs->segment_db_info[i];
+
+		/* check segments in pairs of primary-mirror */
+		if (!SEGMENT_IS_ACTIVE_PRIMARY(primary) ||
+			!PROBE_CHECK_FLAG(scan_status[primary->dbid], PROBE_SEGMENT))
+			continue;
 
-	threads = (pthread_t *)palloc(workers * sizeof(pthread_t));
-	for (i = 0; i < workers; i++)
+		probeInitSegment(&probes[nprobes++], primary);
+	}
+
+	probeSegments(probes, nprobes);
+
+	/*
+	 * Record the primaries' results, and collect the mirrors that need
+	 * probing: a mirror is probed only if its primary is dead or has a
+	 * crash/network fault, otherwise it is assumed to be alive.
+	 */
+	mirrorProbes = (ProbeConnectionInfo *) palloc(nprobes * sizeof(ProbeConnectionInfo));
+	nmirrorProbes = 0;
+	for (i = 0; i < nprobes; i++)
 	{
-#ifdef USE_ASSERT_CHECKING
-		int ret =
-#endif /* USE_ASSERT_CHECKING */
-		gp_pthread_create(&threads[i], probeSegmentFromThread, &worker_info, "probeSegments");
+		CdbComponentDatabaseInfo *primary = probes[i].dbInfo;
+		CdbComponentDatabaseInfo *mirror;
+		char probe_result_primary = probes[i].segmentStatus;
+
+		Assert(!PROBE_CHECK_FLAG(probe_result_primary, PROBE_SEGMENT));
+
+		if ((probe_result_primary & PROBE_ALIVE) == 0 && gp_log_fts >= GPVARS_VERBOSITY_VERBOSE)
+		{
+			write_log("FTS: primary (content=%d, dbid=%d, status 0x%x) didn't respond to probe.",
+			          primary->segindex, primary->dbid, probe_result_primary);
+		}
+
+		scan_status[primary->dbid] = probe_result_primary;
 
-		Assert(ret == 0 && "FTS: failed to create probing thread");
+		/* check if mirror is marked for probing */
+		mirror = FtsGetPeerSegment(primary->segindex, primary->dbid);
+		if (mirror == NULL ||
+			!PROBE_CHECK_FLAG(scan_status[mirror->dbid], PROBE_SEGMENT))
+			continue;
+
+		if (!PROBE_CHECK_FLAG(probe_result_primary, PROBE_ALIVE) ||
+			PROBE_CHECK_FLAG(probe_result_primary, PROBE_FAULT_CRASH) ||
+			PROBE_CHECK_FLAG(probe_result_primary, PROBE_FAULT_NET))
+			probeInitSegment(&mirrorProbes[nmirrorProbes++], mirror);
+		else
+			scan_status[mirror->dbid] = PROBE_ALIVE;
 	}
 
-	/* we have nothing left to do but wait */
-	for (i = 0; i < workers; i++)
+	probeSegments(mirrorProbes, nmirrorProbes);
+
+	for (i = 0; i < nmirrorProbes; i++)
 	{
-#ifdef USE_ASSERT_CHECKING
-		int ret =
-#endif /* USE_ASSERT_CHECKING */
-		pthread_join(threads[i], NULL);
+		CdbComponentDatabaseInfo *mirror = mirrorProbes[i].dbInfo;
+		char probe_result_mirror = mirrorProbes[i].segmentStatus;
+
+		Assert(!PROBE_CHECK_FLAG(probe_result_mirror, PROBE_SEGMENT));
+
+		if ((probe_result_mirror & PROBE_ALIVE) == 0 && gp_log_fts >= GPVARS_VERBOSITY_VERBOSE)
+		{
+			write_log("FTS: mirror (content=%d, dbid=%d, status 0x%x) didn't respond to probe.",
+			          mirror->segindex, mirror->dbid, probe_result_mirror);
+		}
 
-		Assert(ret == 0 && "FTS: failed to join probing thread");
+		scan_status[mirror->dbid] = probe_result_mirror;
 	}
 
-	pfree(threads);
-	threads = NULL;
+	pfree(probes);
+	pfree(mirrorProbes);
 
 	/* if we're shutting down, just exit. */
 	if (!FtsIsActive())
@@ -32,6 +32,8 @@
 
 #include "utils/ext_alloc.h"
 
+static void mdcache_track_relation(Oid relid);
+
 #define GP_WRAP_START	\
 	sigjmp_buf local_sigjmp_buf;	\
 	{	\
@@ -2459,7 +2461,11 @@ gpdb::RelGetRelation
 	GP_WRAP_START;
 	{
 		/* catalog tables: relcache */
-		return RelationIdGetRelation(relationId);
+		Relation rel = RelationIdGetRelation(relationId);
+
+		if (NULL != rel)
+			mdcache_track_relation(relationId);
+		return rel;
 	}
 	GP_WRAP_END;
 	return NULL;
@@ -2978,11 +2984,56 @@ gpdb::UlLeafPartitions
  * which catalog tables each function uses. We conservatively assume that
  * anything fetched via the wrapper functions in this file can end up in the
  * metadata cache and hence need to have an invalidation callback registered.
+ *
+ * Relcache invalidations are much more frequent than changes to the other
+ * catalogs, and most of them are for relations the optimizer has never
+ * looked at, such as temporary tables of other queries. So we remember the
+ * relations that were opened through RelGetRelation() since the last reset,
+ * along with all the partitions of the partitioned ones (whose indexes and
+ * statistics make up the metadata of the root), and only count relcache
+ * invalidations for those.
  */
 static bool mdcache_invalidation_counter_registered = false;
 static int64 mdcache_invalidation_counter = 0;
 static int64 last_mdcache_invalidation_counter = 0;
 
+/* relations that can be in the metadata cache, NULL if none */
+static HTAB *mdcache_relids = NULL;
+
+static void
+mdcache_track_relation(Oid relid)
+{
+	bool		found;
+
+	if (NULL == mdcache_relids)
+	{
+		HASHCTL		ctl;
+
+		MemSet(&ctl, 0, sizeof(ctl));
+		ctl.keysize = sizeof(Oid);
+		ctl.entrysize = sizeof(Oid);
+		ctl.hash = oid_hash;
+		ctl.hcxt = TopMemoryContext;
+		mdcache_relids = hash_create("ORCA metadata cache relations", 256, &ctl,
+									 HASH_ELEM | HASH_FUNCTION | HASH_CONTEXT);
+	}
+
+	hash_search(mdcache_relids, &relid, HASH_ENTER, &found);
+	if (found || !rel_is_partitioned(relid))
+		return;
+
+	List	   *children = find_all_inheritors(relid);
+	ListCell   *lc;
+
+	foreach(lc, children)
+	{
+		Oid			child = lfirst_oid(lc);
+
+		hash_search(mdcache_relids, &child, HASH_ENTER, NULL);
+	}
+	list_free(children);
+}
+
 static void
 mdsyscache_invalidation_counter_callback(Datum arg, int cacheid,  ItemPointer tuplePtr)
 {
@@ -2992,6 +3043,12 @@ mdsyscache_invalidation_counter_callback(Datum arg, int cacheid,  ItemPointer tu
 static void
 mdrelcache_invalidation_counter_callback(Datum arg, Oid relid)
 {
+	/* InvalidOid means that the whole relcache was reset */
+	if (OidIsValid(relid) &&
+		(NULL == mdcache_relids ||
+		 NULL == hash_search(mdcache_relids, &relid, HASH_FIND, NULL)))
+		return;
+
 	mdcache_invalidation_counter++;
 }
 
@@ -3082,6 +3139,13 @@ gpdb::FMDCacheNeedsReset
 		else
 		{
 			last_mdcache_invalidation_counter = mdcache_invalidation_counter;
+
+			/* the cache is about to be emptied */
+			if (NULL != mdcache_relids)
+			{
+				hash_destroy(mdcache_relids);
+				mdcache_relids = NULL;
+			}
 			return true;
 		}
 	}
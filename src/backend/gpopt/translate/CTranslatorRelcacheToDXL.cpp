@@ -2487,6 +2487,7 @@ CTranslatorRelcacheToDXL::PimdobjColStats
 		PdrgpdxlbucketTransformStats
 		(
 		 pmp,
+		 pmda,
 		 oidAttType,
 		 dDistinct,
 		 dNullFrequency,
@@ -2799,13 +2800,16 @@ CTranslatorRelcacheToDXL::PmdobjScCmp
 //		CTranslatorRelcacheToDXL::PdrgpdxlbucketTransformStats
 //
 //	@doc:
-//		transform stats from pg_stats form to optimizer's preferred form
+//		transform stats from pg_stats form to optimizer's preferred form.
+//		The column type is looked up through the MD accessor, so that it is
+//		translated once rather than for the stats of every column of that type
 //
 //---------------------------------------------------------------------------
 DrgPdxlbucket *
 CTranslatorRelcacheToDXL::PdrgpdxlbucketTransformStats
 	(
 	IMemoryPool *pmp,
+	CMDAccessor *pmda,
 	OID oidAttType,
 	CDouble dDistinct,
 	CDouble dNullFreq,
@@ -2817,7 +2821,7 @@ CTranslatorRelcacheToDXL::PdrgpdxlbucketTransformStats
 	)
 {
 	CMDIdGPDB *pmdidAttType = GPOS_NEW(pmp) CMDIdGPDB(oidAttType);
-	IMDType *pmdtype = Pmdtype(pmp, pmdidAttType);
+	const IMDType *pmdtype = pmda->Pmdtype(pmdidAttType);
 
 	// translate MCVs to Orca histogram. Create an empty histogram if there are no MCVs.
 	CHistogram *phistGPDBMCV = PhistTransformGPDBMCV
@@ -2890,7 +2894,6 @@ CTranslatorRelcacheToDXL::PdrgpdxlbucketTransformStats
 
 	// cleanup
 	pmdidAttType->Release();
-	pmdtype->Release();
 	GPOS_DELETE(phistGPDBMCV);
 
 	if (NULL != phistGPDBHist)
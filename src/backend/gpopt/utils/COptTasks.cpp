@@ -486,6 +486,13 @@ COptTasks::PvMDScCmp
 //		Execute a task using GPOS. TODO extend gpos to provide
 //		this functionality
 //
+//		The task runs on the calling backend thread only. The metadata
+//		callbacks in gpdbwrappers.cpp use palloc, the syscaches and
+//		elog/longjmp error handling, none of which may be entered from
+//		another thread, and GPOS allocations are made in a backend memory
+//		context too (see gpdb::OptimizerAlloc). Running the search on
+//		several workers would need all of these to stay on this thread.
+//
 //---------------------------------------------------------------------------
 void
 COptTasks::Execute
@@ -718,6 +725,36 @@ COptTasks::PdrgPssLoad
 	return pdrgpss;
 }
 
+//---------------------------------------------------------------------------
+//	@function:
+//		COptTasks::PdrgPssTimeLimited
+//
+//	@doc:
+//		Create the default search strategy, a single stage with all
+//		exploration and implementation xforms, limited to the given number
+//		of milliseconds. When the stage times out, the optimizer finishes
+//		with the best plan found so far.
+//
+//---------------------------------------------------------------------------
+DrgPss *
+COptTasks::PdrgPssTimeLimited
+	(
+	IMemoryPool *pmp,
+	ULONG ulTimeLimit
+	)
+{
+	CXformSet *pxfs = GPOS_NEW(pmp) CXformSet(pmp);
+	pxfs->Union(CXformFactory::Pxff()->PxfsExploration());
+	pxfs->Union(CXformFactory::Pxff()->PxfsImplementation());
+
+	DrgPss *pdrgpss = GPOS_NEW(pmp) DrgPss(pmp);
+	pdrgpss->Append(GPOS_NEW(pmp) CSearchStage(pxfs, ulTimeLimit, CCost(0.0)));
+
+	elog(DEBUG2, "\n[OPT]: Using default search strategy, limited to %u ms", ulTimeLimit);
+
+	return pdrgpss;
+}
+
 //---------------------------------------------------------------------------
 //	@function:
 //		COptTasks::PoconfCreate
@@ -973,6 +1010,10 @@ COptTasks::PvOptimizeTask
 
 	// load search strategy
 	DrgPss *pdrgpss = PdrgPssLoad(pmp, optimizer_search_strategy_path);
+	if (NULL == pdrgpss && 0 < optimizer_search_time_limit)
+	{
+		pdrgpss = PdrgPssTimeLimited(pmp, (ULONG) optimizer_search_time_limit);
+	}
 
 	CBitSet *pbsTraceFlags = NULL;
 	CBitSet *pbsEnabled = NULL;
@@ -0,0 +1,120 @@
+/*-------------------------------------------------------------------------
+ *
+ * hyperloglog.c
+ *	  HyperLogLog sketches, to estimate the number of distinct values
+ *
+ * Each value is hashed. The first HLL_BITS bits of the hash pick a
+ * register, which keeps the largest position of the first 1 bit seen in
+ * the rest of the hash. See Flajolet et al., "HyperLogLog: the analysis of
+ * a near-optimal cardinality estimation algorithm" (2007), for the
+ * estimator and its corrections for small and large cardinalities.
+ *
+ * Portions Copyright (c) 2012-Present Pivotal Software, Inc.
+ *
+ *
+ * IDENTIFICATION
+ *	    src/backend/lib/hyperloglog.c
+ *
+ *-------------------------------------------------------------------------
+ */
+#include "postgres.h"
+
+#include <math.h>
+
+#include "lib/hyperloglog.h"
+
+/* The hashes are 32 bits wide */
+#define HLL_HASH_SPACE	4294967296.0
+
+/*
+ * Spread the bits of a hash, in case the caller's hash function does not
+ * mix its high bits well. This is the finalizer of MurmurHash3.
+ */
+static uint32
+hll_mix(uint32 h)
+{
+	h ^= h >> 16;
+	h *= 0x85ebca6b;
+	h ^= h >> 13;
+	h *= 0xc2b2ae35;
+	h ^= h >> 16;
+	return h;
+}
+
+/*
+ * Add the hash of a value to the sketch.
+ */
+void
+hll_add_hash(uint8 *registers, uint32 hash)
+{
+	uint32		index;
+	uint32		rest;
+	uint8		rank = 1;
+
+	hash = hll_mix(hash);
+	index = hash >> (32 - HLL_BITS);
+	rest = hash << HLL_BITS;
+
+	/* position of the first 1 bit, counting from 1 */
+	while (rank <= 32 - HLL_BITS && (rest & 0x80000000) == 0)
+	{
+		rank++;
+		rest <<= 1;
+	}
+
+	if (registers[index] < rank)
+		registers[index] = rank;
+}
+
+/*
+ * Merge another sketch into the sketch, which then counts the union of
+ * their values.
+ */
+void
+hll_merge(uint8 *registers, const uint8 *other)
+{
+	int			i;
+
+	for (i = 0; i < HLL_REGISTERS; i++)
+	{
+		if (registers[i] < other[i])
+			registers[i] = other[i];
+	}
+}
+
+/*
+ * Estimate the number of distinct values added to the sketch.
+ */
+double
+hll_estimate(const uint8 *registers)
+{
+	double		m = HLL_REGISTERS;
+	double		alpha = 0.7213 / (1.0 + 1.079 / m);
+	double		sum = 0.0;
+	int			zeros = 0;
+	double		estimate;
+	int			i;
+
+	for (i = 0; i < HLL_REGISTERS; i++)
+	{
+		sum += ldexp(1.0, -registers[i]);
+		if (registers[i] == 0)
+			zeros++;
+	}
+
+	estimate = alpha * m * m / sum;
+
+	if (estimate <= 2.5 * m)
+	{
+		/* Small cardinalities: count the empty registers instead */
+		if (zeros > 0)
+			estimate = m * log(m / zeros);
+	}
+	else if (estimate > HLL_HASH_SPACE / 30.0)
+	{
+		/* Large cardinalities: correct for collisions of the hashes */
+		estimate = -HLL_HASH_SPACE * log(1.0 - estimate / HLL_HASH_SPACE);
+	}
+
+	return estimate;
+}
@@ -0,0 +1,205 @@
+/*-------------------------------------------------------------------------
+ *
+ * tdigest.c
+ *	  t-digest sketches, to estimate quantiles of a stream of numbers
+ *
+ * This is the "merging" variant of the t-digest: new values are buffered,
+ * and when the buffer fills up it is sorted together with the existing
+ * centroids and swept once, folding neighbours into a centroid as long as
+ * the centroid covers at most one unit of the scale function
+ *
+ *		k(q) = compression / (2 pi) * asin(2q - 1)
+ *
+ * which keeps centroids small near q = 0 and q = 1. See Dunning and Ertl,
+ * "Computing extremely accurate quantiles using t-digests" (2019).
+ *
+ * Portions Copyright (c) 2012-Present Pivotal Software, Inc.
+ *
+ *
+ * IDENTIFICATION
+ *	    src/backend/lib/tdigest.c
+ *
+ *-------------------------------------------------------------------------
+ */
+#include "postgres.h"
+
+#include <math.h>
+
+#include "lib/tdigest.h"
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+static double
+tdigest_scale(double q)
+{
+	return TDIGEST_COMPRESSION / (2.0 * M_PI) * asin(2.0 * q - 1.0);
+}
+
+static int
+centroid_cmp(const void *a, const void *b)
+{
+	double		ma = ((const TDigestCentroid *) a)->mean;
+	double		mb = ((const TDigestCentroid *) b)->mean;
+
+	if (ma < mb)
+		return -1;
+	if (ma > mb)
+		return 1;
+	return 0;
+}
+
+/*
+ * Fold the buffered centroids into the merged ones.
+ */
+static void
+tdigest_compress(TDigest *digest)
+{
+	TDigestCentroid *c = digest->centroids;
+	int			n = digest->nmerged + digest->nbuffered;
+	int			nout = 0;
+	double		before = 0.0;	/* count of the centroids already emitted */
+	double		klow;
+	int			i;
+
+	if (digest->nbuffered == 0)
+		return;
+
+	qsort(c, n, sizeof(TDigestCentroid), centroid_cmp);
+
+	klow = tdigest_scale(0.0);
+	for (i = 1; i < n; i++)
+	{
+		double		q = (before + c[nout].count + c[i].count) / digest->total;
+
+		if (tdigest_scale(q) - klow <= 1.0)
+		{
+			/* fold c[i] into the current centroid */
+			c[nout].count += c[i].count;
+			c[nout].mean += (c[i].mean - c[nout].mean) * c[i].count / c[nout].count;
+		}
+		else
+		{
+			before += c[nout].count;
+			klow = tdigest_scale(before / digest->total);
+			c[++nout] = c[i];
+		}
+	}
+
+	digest->nmerged = nout + 1;
+	digest->nbuffered = 0;
+	Assert(digest->nmerged <= TDIGEST_MAX_MERGED);
+}
+
+static void
+tdigest_add_centroid(TDigest *digest, double mean, double count)
+{
+	if (digest->nbuffered == TDIGEST_BUFFER)
+		tdigest_compress(digest);
+
+	digest->centroids[digest->nmerged + digest->nbuffered].mean = mean;
+	digest->centroids[digest->nmerged + digest->nbuffered].count = count;
+	digest->nbuffered++;
+	digest->total += count;
+}
+
+void
+tdigest_init(TDigest *digest)
+{
+	digest->total = 0.0;
+	digest->min = 0.0;
+	digest->max = 0.0;
+	digest->nmerged = 0;
+	digest->nbuffered = 0;
+}
+
+/*
+ * Add a value to the digest.
+ */
+void
+tdigest_add(TDigest *digest, double value)
+{
+	if (digest->total == 0.0 || value < digest->min)
+		digest->min = value;
+	if (digest->total == 0.0 || value > digest->max)
+		digest->max = value;
+
+	tdigest_add_centroid(digest, value, 1.0);
+}
+
+/*
+ * Merge the other digest into this one.
+ */
+void
+tdigest_merge(TDigest *digest, const TDigest *other)
+{
+	int			i;
+
+	if (other->total == 0.0)
+		return;
+
+	if (digest->total == 0.0 || other->min < digest->min)
+		digest->min = other->min;
+	if (digest->total == 0.0 || other->max > digest->max)
+		digest->max = other->max;
+
+	for (i = 0; i < other->nmerged + other->nbuffered; i++)
+		tdigest_add_centroid(digest, other->centroids[i].mean,
+							 other->centroids[i].count);
+}
+
+/*
+ * Estimate the q-quantile, 0 <= q <= 1, of the values added so far. The
+ * digest must not be empty.
+ *
+ * Each centroid stands for its count of values spread around its mean, so
+ * the estimate interpolates linearly between the means of the two centroids
+ * whose middles surround the target rank, or towards min or max past the
+ * outermost ones.
+ */
+double
+tdigest_quantile(TDigest *digest, double q)
+{
+	TDigestCentroid *c = digest->centroids;
+	double		target;
+	double		before = 0.0;
+	int			i;
+
+	Assert(digest->total > 0.0);
+
+	tdigest_compress(digest);
+
+	if (q <= 0.0)
+		return digest->min;
+	if (q >= 1.0)
+		return digest->max;
+	if (digest->nmerged == 1)
+		return c[0].mean;
+
+	target = q * digest->total;
+
+	if (target < c[0].count / 2.0)
+		return digest->min + (c[0].mean - digest->min) *
+			target / (c[0].count / 2.0);
+
+	for (i = 0; i < digest->nmerged - 1; i++)
+	{
+		double		mid = before + c[i].count / 2.0;
+		double		nextmid = before + c[i].count + c[i + 1].count / 2.0;
+
+		if (target <= nextmid)
+			return c[i].mean + (c[i + 1].mean - c[i].mean) *
+				(target - mid) / (nextmid - mid);
+
+		before += c[i].count;
+	}
+
+	/* past the middle of the last centroid */
+	{
+		double		mid = before + c[i].count / 2.0;
+
+		return c[i].mean + (digest->max - c[i].mean) *
+			(target - mid) / (digest->total - mid);
+	}
+}
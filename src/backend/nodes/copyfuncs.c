@@ -132,6 +132,7 @@ _copyPlannedStmt(PlannedStmt *from)
 		newnode->intoPolicy = NULL;
 
 	COPY_SCALAR_FIELD(query_mem);
+	COPY_STRING_FIELD(parallelRetrieveToken);
 
 	return newnode;
 }
@@ -193,6 +194,7 @@ CopyPlanFields(Plan *from, Plan *newnode)
 
 	COPY_SCALAR_FIELD(directDispatch.isDirectDispatch);
 	COPY_NODE_FIELD(directDispatch.contentIds);
+	COPY_NODE_FIELD(directDispatch.paramKeys);
 	COPY_SCALAR_FIELD(operatorMemKB);
 	/*
 	 * Don't copy memoryAccountId and this is an index to the account array
@@ -939,6 +941,7 @@ _copySort(Sort *from)
 	COPY_POINTER_FIELD(sortColIdx, from->numCols * sizeof(AttrNumber));
 	COPY_POINTER_FIELD(sortOperators, from->numCols * sizeof(Oid));
 	COPY_POINTER_FIELD(nullsFirst, from->numCols * sizeof(bool));
+	COPY_SCALAR_FIELD(numPresortedCols);
 
     /* CDB */
 	COPY_SCALAR_FIELD(noduplicates);
@@ -1084,10 +1087,12 @@ _copySetOp(SetOp *from)
 	 * copy remainder of node
 	 */
 	COPY_SCALAR_FIELD(cmd);
+	COPY_SCALAR_FIELD(strategy);
 	COPY_SCALAR_FIELD(numCols);
 	COPY_POINTER_FIELD(dupColIdx, from->numCols * sizeof(AttrNumber));
 	COPY_POINTER_FIELD(dupOperators, from->numCols * sizeof(Oid));
 	COPY_SCALAR_FIELD(flagColIdx);
+	COPY_SCALAR_FIELD(numGroups);
 
 	return newnode;
 }
@@ -1149,6 +1154,9 @@ _copyMotion(Motion *from)
 
 	COPY_NODE_FIELD(hashExpr);
 	COPY_NODE_FIELD(hashDataTypes);
+	COPY_SCALAR_FIELD(skewMode);
+	COPY_SCALAR_FIELD(numSkewHashes);
+	COPY_POINTER_FIELD(skewHashes, from->numSkewHashes * sizeof(uint32));
 
 	COPY_SCALAR_FIELD(numOutputSegs);
 	COPY_POINTER_FIELD(outputSegIdx, from->numOutputSegs * sizeof(int));
@@ -3479,6 +3487,17 @@ _copyFetchStmt(FetchStmt *from)
 	return newnode;
 }
 
+static RetrieveStmt *
+_copyRetrieveStmt(RetrieveStmt *from)
+{
+	RetrieveStmt *newnode = makeNode(RetrieveStmt);
+
+	COPY_STRING_FIELD(endpoint);
+	COPY_SCALAR_FIELD(count);
+
+	return newnode;
+}
+
 static IndexStmt *
 _copyIndexStmt(IndexStmt *from)
 {
@@ -4347,6 +4366,7 @@ _copySlice(Slice *from)
 	COPY_SCALAR_FIELD(numGangMembersToBeActive);
 	COPY_SCALAR_FIELD(directDispatch.isDirectDispatch);
 	COPY_NODE_FIELD(directDispatch.contentIds);
+	COPY_NODE_FIELD(directDispatch.paramKeys);
 
 	newnode->primaryGang = from->primaryGang;
 	COPY_SCALAR_FIELD(parentIndex);
@@ -5033,6 +5053,9 @@ copyObject(void *from)
 		case T_FetchStmt:
 			retval = _copyFetchStmt(from);
 			break;
+		case T_RetrieveStmt:
+			retval = _copyRetrieveStmt(from);
+			break;
 		case T_IndexStmt:
 			retval = _copyIndexStmt(from);
 			break;
@@ -1340,6 +1340,15 @@ _equalFetchStmt(FetchStmt *a, FetchStmt *b)
 	return true;
 }
 
+static bool
+_equalRetrieveStmt(RetrieveStmt *a, RetrieveStmt *b)
+{
+	COMPARE_STRING_FIELD(endpoint);
+	COMPARE_SCALAR_FIELD(count);
+
+	return true;
+}
+
 static bool
 _equalIndexStmt(IndexStmt *a, IndexStmt *b)
 {
@@ -2857,6 +2866,9 @@ equal(void *a, void *b)
 		case T_FetchStmt:
 			retval = _equalFetchStmt(a, b);
 			break;
+		case T_RetrieveStmt:
+			retval = _equalRetrieveStmt(a, b);
+			break;
 		case T_IndexStmt:
 			retval = _equalIndexStmt(a, b);
 			break;
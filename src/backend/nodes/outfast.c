@@ -292,6 +292,7 @@ _outPlanInfo(StringInfo str, Plan *node)
 	WRITE_INT_FIELD(dispatch);
 	WRITE_BOOL_FIELD(directDispatch.isDirectDispatch);
 	WRITE_NODE_FIELD(directDispatch.contentIds);
+	WRITE_NODE_FIELD(directDispatch.paramKeys);
 
 	WRITE_INT_FIELD(nMotionNodes);
 	WRITE_INT_FIELD(nInitPlans);
@@ -346,6 +347,7 @@ _outPlannedStmt(StringInfo str, PlannedStmt *node)
 	/* Don't serialize policy */
 
 	WRITE_UINT64_FIELD(query_mem);
+	WRITE_STRING_FIELD(parallelRetrieveToken);
 }
 
 static void
@@ -470,6 +472,7 @@ _outSort(StringInfo str, Sort *node)
 	WRITE_INT_ARRAY(sortColIdx, node->numCols, AttrNumber);
 	WRITE_OID_ARRAY(sortOperators, node->numCols);
 	WRITE_BOOL_ARRAY(nullsFirst, node->numCols);
+	WRITE_INT_FIELD(numPresortedCols);
 
     /* CDB */
     WRITE_BOOL_FIELD(noduplicates);
@@ -503,11 +506,13 @@ _outSetOp(StringInfo str, SetOp *node)
 	_outPlanInfo(str, (Plan *) node);
 
 	WRITE_ENUM_FIELD(cmd, SetOpCmd);
+	WRITE_ENUM_FIELD(strategy, SetOpStrategy);
 	WRITE_INT_FIELD(numCols);
 	WRITE_INT_ARRAY(dupColIdx, node->numCols, AttrNumber);
 	WRITE_OID_ARRAY(dupOperators, node->numCols);
 
 	WRITE_INT_FIELD(flagColIdx);
+	WRITE_LONG_FIELD(numGroups);
 }
 
 static void
@@ -522,6 +527,9 @@ _outMotion(StringInfo str, Motion *node)
 
 	WRITE_NODE_FIELD(hashExpr);
 	WRITE_NODE_FIELD(hashDataTypes);
+	WRITE_ENUM_FIELD(skewMode, MotionSkewMode);
+	WRITE_INT_FIELD(numSkewHashes);
+	WRITE_INT_ARRAY(skewHashes, node->numSkewHashes, uint32);
 
 	WRITE_INT_FIELD(numOutputSegs);
 	WRITE_INT_ARRAY(outputSegIdx, node->numOutputSegs, int);
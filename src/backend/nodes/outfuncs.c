@@ -319,6 +319,7 @@ _outPlannedStmt(StringInfo str, PlannedStmt *node)
 	/* Don't serialize policy */
 
 	WRITE_UINT64_FIELD(query_mem);
+	WRITE_STRING_FIELD(parallelRetrieveToken);
 }
 #endif /* COMPILING_BINARY_FUNCS */
 
@@ -368,6 +369,9 @@ _outPlanInfo(StringInfo str, Plan *node)
 
 	WRITE_NODE_FIELD(flow);
 	WRITE_ENUM_FIELD(dispatch, DispatchMethod);
+	WRITE_BOOL_FIELD(directDispatch.isDirectDispatch);
+	WRITE_NODE_FIELD(directDispatch.contentIds);
+	WRITE_NODE_FIELD(directDispatch.paramKeys);
 	WRITE_INT_FIELD(nMotionNodes);
 	WRITE_INT_FIELD(nInitPlans);
 	WRITE_NODE_FIELD(sliceTable);
@@ -911,6 +915,8 @@ _outSort(StringInfo str, Sort *node)
 	for (i = 0; i < node->numCols; i++)
 		appendStringInfo(str, " %s", booltostr(node->nullsFirst[i]));
 
+	WRITE_INT_FIELD(numPresortedCols);
+
 	/* CDB */
     WRITE_BOOL_FIELD(noduplicates);
 
@@ -964,6 +970,7 @@ _outSetOp(StringInfo str, SetOp *node)
 	_outPlanInfo(str, (Plan *) node);
 
 	WRITE_ENUM_FIELD(cmd, SetOpCmd);
+	WRITE_ENUM_FIELD(strategy, SetOpStrategy);
 	WRITE_INT_FIELD(numCols);
 
 	appendStringInfoLiteral(str, " :dupColIdx");
@@ -975,6 +982,7 @@ _outSetOp(StringInfo str, SetOp *node)
 		appendStringInfo(str, " %u", node->dupOperators[i]);
 
 	WRITE_INT_FIELD(flagColIdx);
+	WRITE_LONG_FIELD(numGroups);
 }
 #endif /* COMPILING_BINARY_FUNCS */
 
@@ -1017,6 +1025,11 @@ _outMotion(StringInfo str, Motion *node)
 
 	WRITE_NODE_FIELD(hashExpr);
 	WRITE_NODE_FIELD(hashDataTypes);
+	WRITE_ENUM_FIELD(skewMode, MotionSkewMode);
+	WRITE_INT_FIELD(numSkewHashes);
+	appendStringInfoLiteral(str, " :skewHashes");
+	for (i = 0; i < node->numSkewHashes; i++)
+		appendStringInfo(str, " %u", node->skewHashes[i]);
 
 	WRITE_INT_FIELD(numOutputSegs);
 	appendStringInfoLiteral(str, " :outputSegIdx");
@@ -1942,6 +1955,8 @@ _outCdbMotionPath(StringInfo str, CdbMotionPath *node)
     _outPathInfo(str, &node->path);
 
     WRITE_NODE_FIELD(subpath);
+    WRITE_ENUM_FIELD(skewMode, MotionSkewMode);
+    WRITE_INT_FIELD(numSkewHashes);
 }
 
 #ifndef COMPILING_BINARY_FUNCS
@@ -4079,6 +4094,7 @@ _outSlice(StringInfo str, Slice *node)
 	WRITE_INT_FIELD(numGangMembersToBeActive);
 	WRITE_BOOL_FIELD(directDispatch.isDirectDispatch);
 	WRITE_NODE_FIELD(directDispatch.contentIds); /* List of int */
+	WRITE_NODE_FIELD(directDispatch.paramKeys); /* List of List of Node */
 	WRITE_DUMMY_FIELD(primaryGang);
 	WRITE_NODE_FIELD(primaryProcesses); /* List of (CDBProcess *) */
 }
@@ -1472,6 +1472,7 @@ _readPlannedStmt(void)
 	/* intoPolicy not serialized in outfast.c */
 
 	READ_UINT64_FIELD(query_mem);
+	READ_STRING_FIELD(parallelRetrieveToken);
 	READ_DONE();
 }
 
@@ -2072,6 +2073,7 @@ _readSort(void)
 	READ_INT_ARRAY(sortColIdx, local_node->numCols, AttrNumber);
 	READ_OID_ARRAY(sortOperators, local_node->numCols);
 	READ_BOOL_ARRAY(nullsFirst, local_node->numCols);
+	READ_INT_FIELD(numPresortedCols);
 
     /* CDB */
 	READ_BOOL_FIELD(noduplicates);
@@ -2113,11 +2115,13 @@ _readSetOp(void)
 	readPlanInfo((Plan *)local_node);
 
 	READ_ENUM_FIELD(cmd, SetOpCmd);
+	READ_ENUM_FIELD(strategy, SetOpStrategy);
 	READ_INT_FIELD(numCols);
 	READ_INT_ARRAY(dupColIdx, local_node->numCols, AttrNumber);
 	READ_OID_ARRAY(dupOperators, local_node->numCols);
 
 	READ_INT_FIELD(flagColIdx);
+	READ_LONG_FIELD(numGroups);
 
 	READ_DONE();
 }
@@ -2188,6 +2192,9 @@ _readMotion(void)
 
 	READ_NODE_FIELD(hashExpr);
 	READ_NODE_FIELD(hashDataTypes);
+	READ_ENUM_FIELD(skewMode, MotionSkewMode);
+	READ_INT_FIELD(numSkewHashes);
+	READ_INT_ARRAY(skewHashes, local_node->numSkewHashes, uint32);
 
 	READ_INT_FIELD(numOutputSegs);
 	READ_INT_ARRAY(outputSegIdx, local_node->numOutputSegs, int);
@@ -2317,6 +2324,7 @@ _readSlice(void)
 	READ_INT_FIELD(numGangMembersToBeActive);
 	READ_BOOL_FIELD(directDispatch.isDirectDispatch);
 	READ_NODE_FIELD(directDispatch.contentIds); /* List of int index */
+	READ_NODE_FIELD(directDispatch.paramKeys); /* List of List of Node */
 	READ_DUMMY_FIELD(primaryGang, NULL);
 	READ_NODE_FIELD(primaryProcesses); /* List of (CDBProcess *) */
 
@@ -2349,6 +2357,7 @@ void readPlanInfo(Plan *local_node)
 	READ_INT_FIELD(dispatch);
 	READ_BOOL_FIELD(directDispatch.isDirectDispatch);
 	READ_NODE_FIELD(directDispatch.contentIds);
+	READ_NODE_FIELD(directDispatch.paramKeys);
 
 	READ_INT_FIELD(nMotionNodes);
 	READ_INT_FIELD(nInitPlans);
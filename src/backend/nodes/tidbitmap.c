@@ -42,9 +42,43 @@
 #define WORDNUM(x)	((x) / TBM_BITS_PER_BITMAPWORD)
 #define BITNUM(x)	((x) % TBM_BITS_PER_BITMAPWORD)
 
+/*
+ * The pages of a HashBitmap.  A PagetableEntry has room for the
+ * MAX_TUPLES_PER_PAGE offsets of an append-only pseudo page, which makes it
+ * 8K with the standard BLCKSZ, while a heap page has no more than
+ * MaxHeapTuplesPerPage tuples.  So, like the containers of a roaring bitmap,
+ * the words of each page are allocated separately, and only as many of them
+ * as are needed to reach the highest offset set on the page.  A lossy chunk
+ * always has WORDS_PER_CHUNK words.  The words beyond nwords are implicitly
+ * zero.
+ */
+typedef struct HashPageEntry
+{
+	BlockNumber blockno;		/* page number (hashtable key) */
+	bool		ischunk;		/* T = lossy storage, F = exact */
+	bool		recheck;		/* should the tuples be rechecked? */
+	int			nwords;			/* number of words allocated in words[] */
+	tbm_bitmapword *words;		/* bitmap, or NULL if nwords is 0 */
+} HashPageEntry;
+
+/*
+ * A position in the sorted output of a HashBitmap.  Besides the cursor that
+ * tbm_iterate advances, a HashBitmap has one that runs ahead of it, so that
+ * the pages it is about to return can be prefetched.
+ */
+typedef struct HashBitmapCursor
+{
+	int			spageptr;		/* next spages index */
+	int			schunkptr;		/* next schunks index */
+	int			schunkbit;		/* next bit to check in current schunk */
+	HashPageEntry lossypage;	/* lossy page indicator returned by
+								 * tbm_next_page */
+} HashBitmapCursor;
+
 static bool tbm_iterate_page(PagetableEntry *page, TBMIterateResult *output);
 static bool tbm_iterate_hash(HashBitmap *tbm, TBMIterateResult *output);
-static PagetableEntry *tbm_next_page(HashBitmap *tbm, bool *more);
+static HashPageEntry *tbm_next_page(HashBitmap *tbm, HashBitmapCursor *cursor,
+			  bool *more);
 
 /*
  * dynahash.c is optimized for relatively large, long-lived hash tables.
@@ -72,20 +106,20 @@ struct HashBitmap
 	NodeTag		type;			/* to make it a valid Node */
 	MemoryContext mcxt;			/* memory context containing me */
 	TBMStatus	status;			/* see codes above */
-	HTAB	   *pagetable;		/* hash table of PagetableEntry's */
+	HTAB	   *pagetable;		/* hash table of HashPageEntry's */
 	int			nentries;		/* number of entries in pagetable */
-	int			nentries_hwm;	/* high-water mark for number of entries */
-	int			maxentries;		/* limit on same to meet maxbytes */
 	int			npages;			/* number of exact entries in pagetable */
 	int			nchunks;		/* number of lossy entries in pagetable */
+	long		nwords;			/* number of words allocated for entries */
+	long		maxbytes;		/* limit on memory used by entries and words */
+	Size		membytes_hwm;	/* high-water mark for memory used */
 	bool		iterating;		/* tbm_begin_iterate called? */
-	PagetableEntry entry1;		/* used when status == HASHBM_ONE_PAGE */
+	HashPageEntry entry1;		/* used when status == HASHBM_ONE_PAGE */
 	/* the remaining fields are used while producing sorted output: */
-	PagetableEntry **spages;	/* sorted exact-page list, or NULL */
-	PagetableEntry **schunks;	/* sorted lossy-chunk list, or NULL */
-	int			spageptr;		/* next spages index */
-	int			schunkptr;		/* next schunks index */
-	int			schunkbit;		/* next bit to check in current schunk */
+	HashPageEntry **spages;		/* sorted exact-page list, or NULL */
+	HashPageEntry **schunks;	/* sorted lossy-chunk list, or NULL */
+	HashBitmapCursor iter;		/* next page to return */
+	HashBitmapCursor prefetch;	/* next page to prefetch */
 
 	/* CDB: Statistics for EXPLAIN ANALYZE */
 	struct Instrumentation *instrument;
@@ -96,22 +130,31 @@ struct HashBitmap
 typedef struct HashStreamOpaque
 {
 	HashBitmap *tbm;  /* HashStreamOpaque will not take the ownership of freeing HashBitmap */
-	PagetableEntry *entry;
+	HashPageEntry *entry;
 }	HashStreamOpaque;
 
+/* Memory used by the entries of a HashBitmap, and the words they point to */
+#define TBM_MEMORY_USED(tbm) \
+	((tbm)->nentries * (tbm)->bytesperentry + \
+	 (tbm)->nwords * sizeof(tbm_bitmapword))
+
 /* Local function prototypes */
-static void tbm_union_page(HashBitmap *a, const PagetableEntry *bpage);
-static bool tbm_intersect_page(HashBitmap *a, PagetableEntry *apage,
+static void tbm_union_page(HashBitmap *a, const HashPageEntry *bpage);
+static bool tbm_intersect_page(HashBitmap *a, HashPageEntry *apage,
 				   const HashBitmap *b);
-static const PagetableEntry *tbm_find_pageentry(const HashBitmap *tbm,
+static const HashPageEntry *tbm_find_pageentry(const HashBitmap *tbm,
 				   BlockNumber pageno);
 
-static PagetableEntry *tbm_get_pageentry(HashBitmap *tbm, BlockNumber pageno);
+static HashPageEntry *tbm_get_pageentry(HashBitmap *tbm, BlockNumber pageno);
+static void tbm_page_reserve(HashBitmap *tbm, HashPageEntry *page, int nwords);
+static void tbm_page_release(HashBitmap *tbm, HashPageEntry *page);
+static void tbm_note_memory(HashBitmap *tbm);
 static bool tbm_page_is_lossy(const HashBitmap *tbm, BlockNumber pageno);
 static void tbm_mark_page_lossy(HashBitmap *tbm, BlockNumber pageno);
 static void tbm_lossify(HashBitmap *tbm);
 static int	tbm_comparator(const void *left, const void *right);
 static bool tbm_stream_block(StreamNode * self, PagetableEntry *e);
+static void tbm_expand_page(const HashPageEntry *page, PagetableEntry *e);
 static void tbm_stream_free(StreamNode * self);
 static void tbm_stream_set_instrument(StreamNode * self, struct Instrumentation *instr);
 static void tbm_stream_upd_instrument(StreamNode * self);
@@ -127,7 +170,6 @@ HashBitmap *
 tbm_create(long maxbytes)
 {
 	HashBitmap *tbm;
-	long		nbuckets;
 
 	/*
 	 * Ensure that we don't have heap tuple offsets going beyond (INT16_MAX +
@@ -147,19 +189,16 @@ tbm_create(long maxbytes)
 	tbm->instrument = NULL;
 
 	/*
-	 * Estimate number of hashtable entries we can have within maxbytes. This
-	 * estimates the hash overhead at MAXALIGN(sizeof(HASHELEMENT)) plus a
-	 * pointer per hash entry, which is crude but good enough for our purpose.
-	 * Also count an extra Pointer per entry for the arrays created during
-	 * iteration readout.
+	 * Estimate the memory used by a hashtable entry, not counting its words.
+	 * This estimates the hash overhead at MAXALIGN(sizeof(HASHELEMENT)) plus
+	 * a pointer per hash entry, which is crude but good enough for our
+	 * purpose.  Also count an extra Pointer per entry for the arrays created
+	 * during iteration readout, and the palloc overhead of the words.
 	 */
 	tbm->bytesperentry =
-		(MAXALIGN(sizeof(HASHELEMENT)) + MAXALIGN(sizeof(PagetableEntry))
-		 + sizeof(Pointer) + sizeof(Pointer));
-	nbuckets = maxbytes / tbm->bytesperentry;
-	nbuckets = Min(nbuckets, INT_MAX - 1);		/* safety limit */
-	nbuckets = Max(nbuckets, 16);		/* sanity limit */
-	tbm->maxentries = (int) nbuckets;
+		(MAXALIGN(sizeof(HASHELEMENT)) + MAXALIGN(sizeof(HashPageEntry))
+		 + sizeof(Pointer) + sizeof(Pointer) + 2 * sizeof(Pointer));
+	tbm->maxbytes = Max(maxbytes, 16 * (long) tbm->bytesperentry);	/* sanity limit */
 
 	return tbm;
 }
@@ -179,7 +218,7 @@ tbm_create_pagetable(HashBitmap *tbm)
 	/* Create the hashtable proper */
 	MemSet(&hash_ctl, 0, sizeof(hash_ctl));
 	hash_ctl.keysize = sizeof(BlockNumber);
-	hash_ctl.entrysize = sizeof(PagetableEntry);
+	hash_ctl.entrysize = sizeof(HashPageEntry);
 	hash_ctl.hash = tag_hash;
 	hash_ctl.hcxt = tbm->mcxt;
 	tbm->pagetable = hash_create("HashBitmap",
@@ -190,14 +229,15 @@ tbm_create_pagetable(HashBitmap *tbm)
 	/* If entry1 is valid, push it into the hashtable */
 	if (tbm->status == HASHBM_ONE_PAGE)
 	{
-		PagetableEntry *page;
+		HashPageEntry *page;
 		bool		found;
 
-		page = (PagetableEntry *) hash_search(tbm->pagetable,
-											  (void *) &tbm->entry1.blockno,
-											  HASH_ENTER, &found);
+		page = (HashPageEntry *) hash_search(tbm->pagetable,
+											 (void *) &tbm->entry1.blockno,
+											 HASH_ENTER, &found);
 		Assert(!found);
-		memcpy(page, &tbm->entry1, sizeof(PagetableEntry));
+		/* the words move along with the entry */
+		memcpy(page, &tbm->entry1, sizeof(HashPageEntry));
 	}
 
 	tbm->status = HASHBM_HASH;
@@ -211,8 +251,18 @@ tbm_free(HashBitmap *tbm)
 {
 	if (tbm->instrument)
 		tbm_bitmap_upd_instrument((Node *) tbm);
+	if (tbm->status == HASHBM_ONE_PAGE)
+		tbm_page_release(tbm, &tbm->entry1);
 	if (tbm->pagetable)
+	{
+		HASH_SEQ_STATUS status;
+		HashPageEntry *page;
+
+		hash_seq_init(&status, tbm->pagetable);
+		while ((page = (HashPageEntry *) hash_seq_search(&status)) != NULL)
+			tbm_page_release(tbm, page);
 		hash_destroy(tbm->pagetable);
+	}
 	if (tbm->spages)
 		pfree(tbm->spages);
 	if (tbm->schunks)
@@ -233,14 +283,26 @@ tbm_upd_instrument(HashBitmap *tbm)
 	if (!instr)
 		return;
 
-	/* Update page table high-water mark. */
-	tbm->nentries_hwm = Max(tbm->nentries_hwm, tbm->nentries);
+	/* Update memory high-water mark. */
+	tbm_note_memory(tbm);
 
 	/* How much of our work_mem quota was actually used? */
-	workmemused = tbm->nentries_hwm * tbm->bytesperentry;
+	workmemused = tbm->membytes_hwm;
 	instr->workmemused = Max(instr->workmemused, workmemused);
 }	/* tbm_upd_instrument */
 
+/*
+ * tbm_note_memory - update the high-water mark for memory used.  Must be
+ * called before entries or words are released.
+ */
+static void
+tbm_note_memory(HashBitmap *tbm)
+{
+	Size		membytes = TBM_MEMORY_USED(tbm);
+
+	tbm->membytes_hwm = Max(tbm->membytes_hwm, membytes);
+}
+
 
 /*
  * tbm_set_instrument
@@ -275,7 +337,7 @@ tbm_add_tuples(HashBitmap *tbm, const ItemPointer tids, int ntids,
 	{
 		BlockNumber blk = ItemPointerGetBlockNumber(tids + i);
 		OffsetNumber off = ItemPointerGetOffsetNumber(tids + i);
-		PagetableEntry *page;
+		HashPageEntry *page;
 		int			wordnum,
 					bitnum;
 
@@ -302,11 +364,12 @@ tbm_add_tuples(HashBitmap *tbm, const ItemPointer tids, int ntids,
 			/* Page is exact, so set bit for individual tuple */
 			wordnum = WORDNUM(off - 1);
 			bitnum = BITNUM(off - 1);
+			tbm_page_reserve(tbm, page, wordnum + 1);
 		}
 		page->words[wordnum] |= ((tbm_bitmapword) 1 << bitnum);
 		page->recheck |= recheck;
 
-		if (tbm->nentries > tbm->maxentries)
+		if (TBM_MEMORY_USED(tbm) > tbm->maxbytes)
 			tbm_lossify(tbm);
 	}
 }
@@ -329,41 +392,35 @@ tbm_union(HashBitmap *a, const HashBitmap *b)
 	else
 	{
 		HASH_SEQ_STATUS status;
-		PagetableEntry *bpage;
+		HashPageEntry *bpage;
 
 		Assert(b->status == HASHBM_HASH);
 		hash_seq_init(&status, b->pagetable);
-		while ((bpage = (PagetableEntry *) hash_seq_search(&status)) != NULL)
+		while ((bpage = (HashPageEntry *) hash_seq_search(&status)) != NULL)
 			tbm_union_page(a, bpage);
 	}
 }
 
 /* Process one page of b during a union op */
 static void
-tbm_union_page(HashBitmap *a, const PagetableEntry *bpage)
+tbm_union_page(HashBitmap *a, const HashPageEntry *bpage)
 {
-	PagetableEntry *apage;
+	HashPageEntry *apage;
 	int			wordnum;
 
 	if (bpage->ischunk)
 	{
 		/* Scan b's chunk, mark each indicated page lossy in a */
-		for (wordnum = 0; wordnum < WORDS_PER_PAGE; wordnum++)
+		for (wordnum = 0; wordnum < bpage->nwords; wordnum++)
 		{
 			tbm_bitmapword w = bpage->words[wordnum];
+			BlockNumber pg;
 
-			if (w != 0)
+			pg = bpage->blockno + (wordnum * TBM_BITS_PER_BITMAPWORD);
+			while (w != 0)
 			{
-				BlockNumber pg;
-
-				pg = bpage->blockno + (wordnum * TBM_BITS_PER_BITMAPWORD);
-				while (w != 0)
-				{
-					if (w & 1)
-						tbm_mark_page_lossy(a, pg);
-					pg++;
-					w >>= 1;
-				}
+				tbm_mark_page_lossy(a, pg + __builtin_ctzll(w));
+				w &= w - 1;
 			}
 		}
 	}
@@ -383,12 +440,14 @@ tbm_union_page(HashBitmap *a, const PagetableEntry *bpage)
 		else
 		{
 			/* Both pages are exact, merge at the bit level */
-			for (wordnum = 0; wordnum < WORDS_PER_PAGE; wordnum++)
+			tbm_page_reserve(a, apage, bpage->nwords);
+			for (wordnum = 0; wordnum < bpage->nwords; wordnum++)
 				apage->words[wordnum] |= bpage->words[wordnum];
+			apage->recheck |= bpage->recheck;
 		}
 	}
 
-	if (a->nentries > a->maxentries)
+	if (TBM_MEMORY_USED(a) > a->maxbytes)
 		tbm_lossify(a);
 }
 
@@ -405,7 +464,7 @@ tbm_intersect(HashBitmap *a, const HashBitmap *b)
 	if (a->nentries == 0)
 		return;
 
-	a->nentries_hwm = Max(a->nentries_hwm, a->nentries);
+	tbm_note_memory(a);
 
 	/* Scan through chunks and pages in a, try to match to b */
 	if (a->status == HASHBM_ONE_PAGE)
@@ -414,6 +473,7 @@ tbm_intersect(HashBitmap *a, const HashBitmap *b)
 		{
 			/* Page is now empty, remove it from a */
 			Assert(!a->entry1.ischunk);
+			tbm_page_release(a, &a->entry1);
 			a->npages--;
 			a->nentries--;
 			Assert(a->nentries == 0);
@@ -423,15 +483,16 @@ tbm_intersect(HashBitmap *a, const HashBitmap *b)
 	else
 	{
 		HASH_SEQ_STATUS status;
-		PagetableEntry *apage;
+		HashPageEntry *apage;
 
 		Assert(a->status == HASHBM_HASH);
 		hash_seq_init(&status, a->pagetable);
-		while ((apage = (PagetableEntry *) hash_seq_search(&status)) != NULL)
+		while ((apage = (HashPageEntry *) hash_seq_search(&status)) != NULL)
 		{
 			if (tbm_intersect_page(a, apage, b))
 			{
 				/* Page or chunk is now empty, remove it from a */
+				tbm_page_release(a, apage);
 				if (apage->ischunk)
 					a->nchunks--;
 				else
@@ -452,9 +513,9 @@ tbm_intersect(HashBitmap *a, const HashBitmap *b)
  * Returns TRUE if apage is now empty and should be deleted from a
  */
 static bool
-tbm_intersect_page(HashBitmap *a, PagetableEntry *apage, const HashBitmap *b)
+tbm_intersect_page(HashBitmap *a, HashPageEntry *apage, const HashBitmap *b)
 {
-	const PagetableEntry *bpage;
+	const HashPageEntry *bpage;
 	int			wordnum;
 
 	if (apage->ischunk)
@@ -462,37 +523,28 @@ tbm_intersect_page(HashBitmap *a, PagetableEntry *apage, const HashBitmap *b)
 		/* Scan each bit in chunk, try to clear */
 		bool		candelete = true;
 
-		for (wordnum = 0; wordnum < WORDS_PER_PAGE; wordnum++)
+		for (wordnum = 0; wordnum < apage->nwords; wordnum++)
 		{
 			tbm_bitmapword w = apage->words[wordnum];
+			tbm_bitmapword neww = w;
+			BlockNumber pg;
 
-			if (w != 0)
+			pg = apage->blockno + (wordnum * TBM_BITS_PER_BITMAPWORD);
+			while (w != 0)
 			{
-				tbm_bitmapword neww = w;
-				BlockNumber pg;
-				int			bitnum;
+				int			bitnum = __builtin_ctzll(w);
 
-				pg = apage->blockno + (wordnum * TBM_BITS_PER_BITMAPWORD);
-				bitnum = 0;
-				while (w != 0)
+				if (!tbm_page_is_lossy(b, pg + bitnum) &&
+					tbm_find_pageentry(b, pg + bitnum) == NULL)
 				{
-					if (w & 1)
-					{
-						if (!tbm_page_is_lossy(b, pg) &&
-							tbm_find_pageentry(b, pg) == NULL)
-						{
-							/* Page is not in b at all, lose lossy bit */
-							neww &= ~((tbm_bitmapword) 1 << bitnum);
-						}
-					}
-					pg++;
-					bitnum++;
-					w >>= 1;
+					/* Page is not in b at all, lose lossy bit */
+					neww &= ~((tbm_bitmapword) 1 << bitnum);
 				}
-				apage->words[wordnum] = neww;
-				if (neww != 0)
-					candelete = false;
+				w &= w - 1;
 			}
+			apage->words[wordnum] = neww;
+			if (neww != 0)
+				candelete = false;
 		}
 		return candelete;
 	}
@@ -514,14 +566,19 @@ tbm_intersect_page(HashBitmap *a, PagetableEntry *apage, const HashBitmap *b)
 		bpage = tbm_find_pageentry(b, apage->blockno);
 		if (bpage != NULL)
 		{
+			int			nwords = Min(apage->nwords, bpage->nwords);
+
 			/* Both pages are exact, merge at the bit level */
 			Assert(!bpage->ischunk);
-			for (wordnum = 0; wordnum < WORDS_PER_PAGE; wordnum++)
+			for (wordnum = 0; wordnum < nwords; wordnum++)
 			{
 				apage->words[wordnum] &= bpage->words[wordnum];
 				if (apage->words[wordnum] != 0)
 					candelete = false;
 			}
+			/* the words b doesn't have are all zero there */
+			for (; wordnum < apage->nwords; wordnum++)
+				apage->words[wordnum] = 0;
 			apage->recheck |= bpage->recheck;
 		}
 		/* If there is no matching b page, we can just delete the a page */
@@ -549,7 +606,7 @@ void
 tbm_begin_iterate(HashBitmap *tbm)
 {
 	HASH_SEQ_STATUS status;
-	PagetableEntry *page;
+	HashPageEntry *page;
 	int			npages;
 	int			nchunks;
 
@@ -558,9 +615,10 @@ tbm_begin_iterate(HashBitmap *tbm)
 	/*
 	 * Reset iteration pointers.
 	 */
-	tbm->spageptr = 0;
-	tbm->schunkptr = 0;
-	tbm->schunkbit = 0;
+	tbm->iter.spageptr = 0;
+	tbm->iter.schunkptr = 0;
+	tbm->iter.schunkbit = 0;
+	tbm->prefetch = tbm->iter;
 
 	/*
 	 * Nothing else to do if no entries, nor if we don't have a hashtable.
@@ -572,17 +630,17 @@ tbm_begin_iterate(HashBitmap *tbm)
 	 * Create and fill the sorted page lists if we didn't already.
 	 */
 	if (!tbm->spages && tbm->npages > 0)
-		tbm->spages = (PagetableEntry **)
+		tbm->spages = (HashPageEntry **)
 			MemoryContextAlloc(tbm->mcxt,
-							   tbm->npages * sizeof(PagetableEntry *));
+							   tbm->npages * sizeof(HashPageEntry *));
 	if (!tbm->schunks && tbm->nchunks > 0)
-		tbm->schunks = (PagetableEntry **)
+		tbm->schunks = (HashPageEntry **)
 			MemoryContextAlloc(tbm->mcxt,
-							   tbm->nchunks * sizeof(PagetableEntry *));
+							   tbm->nchunks * sizeof(HashPageEntry *));
 
 	hash_seq_init(&status, tbm->pagetable);
 	npages = nchunks = 0;
-	while ((page = (PagetableEntry *) hash_seq_search(&status)) != NULL)
+	while ((page = (HashPageEntry *) hash_seq_search(&status)) != NULL)
 	{
 		if (page->ischunk)
 			tbm->schunks[nchunks++] = page;
@@ -592,9 +650,9 @@ tbm_begin_iterate(HashBitmap *tbm)
 	Assert(npages == tbm->npages);
 	Assert(nchunks == tbm->nchunks);
 	if (npages > 1)
-		qsort(tbm->spages, npages, sizeof(PagetableEntry *), tbm_comparator);
+		qsort(tbm->spages, npages, sizeof(HashPageEntry *), tbm_comparator);
 	if (nchunks > 1)
-		qsort(tbm->schunks, nchunks, sizeof(PagetableEntry *), tbm_comparator);
+		qsort(tbm->schunks, nchunks, sizeof(HashPageEntry *), tbm_comparator);
 }
 
 /*
@@ -638,6 +696,36 @@ tbm_iterate(Node *tbm, TBMIterateResult *output)
 	return false;
 }
 
+/*
+ * tbm_prefetch_next - return the next page for the caller to prefetch.
+ *
+ * The pages come in the order tbm_iterate returns them, from a cursor of
+ * their own that the caller keeps ahead of tbm_iterate.  Only a HashBitmap
+ * can be looked ahead in; a StreamBitmap has no more pages than it has
+ * pulled from its inputs, so this returns false for one.
+ */
+bool
+tbm_prefetch_next(Node *tbm, BlockNumber *blockno)
+{
+	HashBitmap *hashBitmap;
+	HashPageEntry *e;
+	bool		more;
+
+	if (!IsA(tbm, HashBitmap))
+		return false;
+
+	hashBitmap = (HashBitmap *) tbm;
+	if (!hashBitmap->iterating)
+		tbm_begin_iterate(hashBitmap);
+
+	e = tbm_next_page(hashBitmap, &hashBitmap->prefetch, &more);
+	if (!more || !e)
+		return false;
+
+	*blockno = e->blockno;
+	return true;
+}
+
 /*
  * tbm_iterate_page - get a TBMIterateResult from a given PagetableEntry.
  */
@@ -696,26 +784,48 @@ tbm_iterate_page(PagetableEntry *page, TBMIterateResult *output)
 static bool
 tbm_iterate_hash(HashBitmap *tbm, TBMIterateResult *output)
 {
-	PagetableEntry *e;
+	HashPageEntry *e;
 	bool		more;
+	int			ntuples;
+	int			wordnum;
+
+	e = tbm_next_page(tbm, &tbm->iter, &more);
+	if (!more || !e)
+		return false;
 
-	e = tbm_next_page(tbm, &more);
-	if (more && e)
+	if (e->ischunk)
+		ntuples = -1;
+	else
 	{
-		tbm_iterate_page(e, output);
-		return true;
+		/* scan the page's words to extract individual offset numbers */
+		ntuples = 0;
+		for (wordnum = 0; wordnum < e->nwords; wordnum++)
+		{
+			tbm_bitmapword w = e->words[wordnum];
+			int			off = wordnum * TBM_BITS_PER_BITMAPWORD + 1;
+
+			while (w != 0)
+			{
+				output->offsets[ntuples++] = (OffsetNumber) (off + __builtin_ctzll(w));
+				w &= w - 1;
+			}
+		}
 	}
-	return false;
+
+	output->blockno = e->blockno;
+	output->ntuples = ntuples;
+
+	return true;
 }
 
 /*
  * tbm_next_page - actually traverse the HashBitmap
  *
- * Store the next block of matches in nextpage.
+ * Returns the next page at the cursor, and advances the cursor past it.
  */
 
-static PagetableEntry *
-tbm_next_page(HashBitmap *tbm, bool *more)
+static HashPageEntry *
+tbm_next_page(HashBitmap *tbm, HashBitmapCursor *cursor, bool *more)
 {
 	Assert(tbm->iterating);
 
@@ -725,10 +835,10 @@ tbm_next_page(HashBitmap *tbm, bool *more)
 	 * If lossy chunk pages remain, make sure we've advanced schunkptr/
 	 * schunkbit to the next set bit.
 	 */
-	while (tbm->schunkptr < tbm->nchunks)
+	while (cursor->schunkptr < tbm->nchunks)
 	{
-		PagetableEntry *chunk = tbm->schunks[tbm->schunkptr];
-		int			schunkbit = tbm->schunkbit;
+		HashPageEntry *chunk = tbm->schunks[cursor->schunkptr];
+		int			schunkbit = cursor->schunkbit;
 
 		while (schunkbit < PAGES_PER_CHUNK)
 		{
@@ -741,49 +851,51 @@ tbm_next_page(HashBitmap *tbm, bool *more)
 		}
 		if (schunkbit < PAGES_PER_CHUNK)
 		{
-			tbm->schunkbit = schunkbit;
+			cursor->schunkbit = schunkbit;
 			break;
 		}
 		/* advance to next chunk */
-		tbm->schunkptr++;
-		tbm->schunkbit = 0;
+		cursor->schunkptr++;
+		cursor->schunkbit = 0;
 	}
 
 	/*
 	 * If both chunk and per-page data remain, must output the numerically
 	 * earlier page.
 	 */
-	if (tbm->schunkptr < tbm->nchunks)
+	if (cursor->schunkptr < tbm->nchunks)
 	{
-		PagetableEntry *chunk = tbm->schunks[tbm->schunkptr];
-		PagetableEntry *nextpage;
+		HashPageEntry *chunk = tbm->schunks[cursor->schunkptr];
+		HashPageEntry *nextpage;
 		BlockNumber chunk_blockno;
 
-		chunk_blockno = chunk->blockno + tbm->schunkbit;
-		if (tbm->spageptr >= tbm->npages ||
-			chunk_blockno < tbm->spages[tbm->spageptr]->blockno)
+		chunk_blockno = chunk->blockno + cursor->schunkbit;
+		if (cursor->spageptr >= tbm->npages ||
+			chunk_blockno < tbm->spages[cursor->spageptr]->blockno)
 		{
 			/* Return a lossy page indicator from the chunk */
-			nextpage = (PagetableEntry *) palloc(sizeof(PagetableEntry));
+			nextpage = &cursor->lossypage;
 			nextpage->ischunk = true;
 			nextpage->blockno = chunk_blockno;
 			nextpage->recheck = true;
-			tbm->schunkbit++;
+			nextpage->nwords = 0;
+			nextpage->words = NULL;
+			cursor->schunkbit++;
 			return nextpage;
 		}
 	}
 
-	if (tbm->spageptr < tbm->npages)
+	if (cursor->spageptr < tbm->npages)
 	{
-		PagetableEntry *e;
+		HashPageEntry *e;
 
 		/* In ONE_PAGE state, we don't allocate an spages[] array */
 		if (tbm->status == HASHBM_ONE_PAGE)
 			e = &tbm->entry1;
 		else
-			e = tbm->spages[tbm->spageptr];
+			e = tbm->spages[cursor->spageptr];
 
-		tbm->spageptr++;
+		cursor->spageptr++;
 		return e;
 	}
 
@@ -793,14 +905,14 @@ tbm_next_page(HashBitmap *tbm, bool *more)
 }
 
 /*
- * tbm_find_pageentry - find a PagetableEntry for the pageno
+ * tbm_find_pageentry - find a HashPageEntry for the pageno
  *
  * Returns NULL if there is no non-lossy entry for the pageno.
  */
-static const PagetableEntry *
+static const HashPageEntry *
 tbm_find_pageentry(const HashBitmap *tbm, BlockNumber pageno)
 {
-	const PagetableEntry *page;
+	const HashPageEntry *page;
 
 	if (tbm->nentries == 0)		/* in case pagetable doesn't exist */
 		return NULL;
@@ -814,9 +926,9 @@ tbm_find_pageentry(const HashBitmap *tbm, BlockNumber pageno)
 		return page;
 	}
 
-	page = (PagetableEntry *) hash_search(tbm->pagetable,
-										  (void *) &pageno,
-										  HASH_FIND, NULL);
+	page = (HashPageEntry *) hash_search(tbm->pagetable,
+										 (void *) &pageno,
+										 HASH_FIND, NULL);
 	if (page == NULL)
 		return NULL;
 	if (page->ischunk)
@@ -825,17 +937,18 @@ tbm_find_pageentry(const HashBitmap *tbm, BlockNumber pageno)
 }
 
 /*
- * tbm_get_pageentry - find or create a PagetableEntry for the pageno
+ * tbm_get_pageentry - find or create a HashPageEntry for the pageno
  *
- * If new, the entry is marked as an exact (non-chunk) entry.
+ * If new, the entry is marked as an exact (non-chunk) entry, with no words
+ * allocated yet.
  *
  * This may cause the table to exceed the desired memory size.	It is
  * up to the caller to call tbm_lossify() at the next safe point if so.
  */
-static PagetableEntry *
+static HashPageEntry *
 tbm_get_pageentry(HashBitmap *tbm, BlockNumber pageno)
 {
-	PagetableEntry *page;
+	HashPageEntry *page;
 	bool		found;
 
 	if (tbm->status == HASHBM_EMPTY)
@@ -857,15 +970,15 @@ tbm_get_pageentry(HashBitmap *tbm, BlockNumber pageno)
 		}
 
 		/* Look up or create an entry */
-		page = (PagetableEntry *) hash_search(tbm->pagetable,
-											  (void *) &pageno,
-											  HASH_ENTER, &found);
+		page = (HashPageEntry *) hash_search(tbm->pagetable,
+											 (void *) &pageno,
+											 HASH_ENTER, &found);
 	}
 
 	/* Initialize it if not present before */
 	if (!found)
 	{
-		MemSet(page, 0, sizeof(PagetableEntry));
+		MemSet(page, 0, sizeof(HashPageEntry));
 		page->blockno = pageno;
 		/* must count it too */
 		tbm->nentries++;
@@ -875,13 +988,61 @@ tbm_get_pageentry(HashBitmap *tbm, BlockNumber pageno)
 	return page;
 }
 
+/*
+ * tbm_page_reserve - make sure the page has at least nwords words
+ *
+ * The words are grown by doubling, so that adding the offsets of a page in
+ * ascending order doesn't copy them over and over.  New words are zeroed.
+ */
+static void
+tbm_page_reserve(HashBitmap *tbm, HashPageEntry *page, int nwords)
+{
+	int			newnwords;
+	tbm_bitmapword *newwords;
+
+	if (page->nwords >= nwords)
+		return;
+
+	newnwords = Max(page->nwords * 2, nwords);
+	newnwords = Min(newnwords, page->ischunk ? WORDS_PER_CHUNK : WORDS_PER_PAGE);
+	Assert(newnwords >= nwords);
+
+	newwords = (tbm_bitmapword *)
+		MemoryContextAllocZero(tbm->mcxt, newnwords * sizeof(tbm_bitmapword));
+	if (page->nwords > 0)
+	{
+		memcpy(newwords, page->words, page->nwords * sizeof(tbm_bitmapword));
+		pfree(page->words);
+	}
+
+	tbm->nwords += newnwords - page->nwords;
+	page->words = newwords;
+	page->nwords = newnwords;
+}
+
+/*
+ * tbm_page_release - free the words of a page
+ */
+static void
+tbm_page_release(HashBitmap *tbm, HashPageEntry *page)
+{
+	if (page->nwords == 0)
+		return;
+
+	tbm_note_memory(tbm);
+	pfree(page->words);
+	tbm->nwords -= page->nwords;
+	page->words = NULL;
+	page->nwords = 0;
+}
+
 /*
  * tbm_page_is_lossy - is the page marked as lossily stored?
  */
 static bool
 tbm_page_is_lossy(const HashBitmap *tbm, BlockNumber pageno)
 {
-	PagetableEntry *page;
+	HashPageEntry *page;
 	BlockNumber chunk_pageno;
 	int			bitno;
 
@@ -892,9 +1053,9 @@ tbm_page_is_lossy(const HashBitmap *tbm, BlockNumber pageno)
 
 	bitno = pageno % PAGES_PER_CHUNK;
 	chunk_pageno = pageno - bitno;
-	page = (PagetableEntry *) hash_search(tbm->pagetable,
-										  (void *) &chunk_pageno,
-										  HASH_FIND, NULL);
+	page = (HashPageEntry *) hash_search(tbm->pagetable,
+										 (void *) &chunk_pageno,
+										 HASH_FIND, NULL);
 	if (page != NULL && page->ischunk)
 	{
 		int			wordnum = WORDNUM(bitno);
@@ -915,7 +1076,7 @@ tbm_page_is_lossy(const HashBitmap *tbm, BlockNumber pageno)
 static void
 tbm_mark_page_lossy(HashBitmap *tbm, BlockNumber pageno)
 {
-	PagetableEntry *page;
+	HashPageEntry *page;
 	bool		found;
 	BlockNumber chunk_pageno;
 	int			bitno;
@@ -935,28 +1096,34 @@ tbm_mark_page_lossy(HashBitmap *tbm, BlockNumber pageno)
 	 */
 	if (bitno != 0)
 	{
-		if (hash_search(tbm->pagetable,
-						(void *) &pageno,
-						HASH_REMOVE, NULL) != NULL)
+		page = (HashPageEntry *) hash_search(tbm->pagetable,
+											 (void *) &pageno,
+											 HASH_FIND, NULL);
+		if (page != NULL)
 		{
-			/* It was present, so adjust counts */
-			tbm->nentries_hwm = Max(tbm->nentries_hwm, tbm->nentries);
+			/* It is present, so release it and adjust counts */
+			tbm_page_release(tbm, page);
 			tbm->nentries--;
 			tbm->npages--;		/* assume it must have been non-lossy */
+			if (hash_search(tbm->pagetable,
+							(void *) &pageno,
+							HASH_REMOVE, NULL) == NULL)
+				elog(ERROR, "hash table corrupted");
 		}
 	}
 
 	/* Look up or create entry for chunk-header page */
-	page = (PagetableEntry *) hash_search(tbm->pagetable,
-										  (void *) &chunk_pageno,
-										  HASH_ENTER, &found);
+	page = (HashPageEntry *) hash_search(tbm->pagetable,
+										 (void *) &chunk_pageno,
+										 HASH_ENTER, &found);
 
 	/* Initialize it if not present before */
 	if (!found)
 	{
-		MemSet(page, 0, sizeof(PagetableEntry));
+		MemSet(page, 0, sizeof(HashPageEntry));
 		page->blockno = chunk_pageno;
 		page->ischunk = true;
+		tbm_page_reserve(tbm, page, WORDS_PER_CHUNK);
 		/* must count it too */
 		tbm->nentries++;
 		tbm->nchunks++;
@@ -964,9 +1131,11 @@ tbm_mark_page_lossy(HashBitmap *tbm, BlockNumber pageno)
 	else if (!page->ischunk)
 	{
 		/* chunk header page was formerly non-lossy, make it lossy */
-		MemSet(page, 0, sizeof(PagetableEntry));
+		tbm_page_release(tbm, page);
+		MemSet(page, 0, sizeof(HashPageEntry));
 		page->blockno = chunk_pageno;
 		page->ischunk = true;
+		tbm_page_reserve(tbm, page, WORDS_PER_CHUNK);
 		/* we assume it had some tuple bit(s) set, so mark it lossy */
 		page->words[0] = ((tbm_bitmapword) 1 << 0);
 		/* adjust counts */
@@ -987,22 +1156,25 @@ static void
 tbm_lossify(HashBitmap *tbm)
 {
 	HASH_SEQ_STATUS status;
-	PagetableEntry *page;
+	HashPageEntry *page;
 
 	/*
 	 * XXX Really stupid implementation: this just lossifies pages in
 	 * essentially random order.  We should be paying some attention to the
 	 * number of bits set in each page, instead.
 	 *
-	 * Since we are called as soon as nentries exceeds maxentries, we should
-	 * push nentries down to significantly less than maxentries, or else we'll
-	 * just end up doing this again very soon.  We shoot for maxentries/2.
+	 * Since we are called as soon as the memory used exceeds maxbytes, we
+	 * should push it down to significantly less than maxbytes, or else we'll
+	 * just end up doing this again very soon.  We shoot for maxbytes/2.
 	 */
 	Assert(!tbm->iterating);
-	Assert(tbm->status == HASHBM_HASH);
+
+	/* A single page can only exceed maxbytes if maxbytes is tiny */
+	if (tbm->status != HASHBM_HASH)
+		return;
 
 	hash_seq_init(&status, tbm->pagetable);
-	while ((page = (PagetableEntry *) hash_seq_search(&status)) != NULL)
+	while ((page = (HashPageEntry *) hash_seq_search(&status)) != NULL)
 	{
 		if (page->ischunk)
 			continue;			/* already a chunk header */
@@ -1017,7 +1189,7 @@ tbm_lossify(HashBitmap *tbm)
 		/* This does the dirty work ... */
 		tbm_mark_page_lossy(tbm, page->blockno);
 
-		if (tbm->nentries <= tbm->maxentries)
+		if (TBM_MEMORY_USED(tbm) <= tbm->maxbytes / 2)
 		{
 			/* we have done enough */
 			hash_seq_term(&status);
@@ -1033,26 +1205,26 @@ tbm_lossify(HashBitmap *tbm)
 
 	/*
 	 * With a big bitmap and small work_mem, it's possible that we cannot
-	 * get under maxentries.  Again, if that happens, we'd end up uselessly
+	 * get under maxbytes.  Again, if that happens, we'd end up uselessly
 	 * calling tbm_lossify over and over.  To prevent this from becoming a
-	 * performance sink, force maxentries up to at least double the current
-	 * number of entries.  (In essence, we're admitting inability to fit
-	 * within work_mem when we do this.)  Note that this test will not fire
-	 * if we broke out of the loop early; and if we didn't, the current
-	 * number of entries is simply not reducible any further.
+	 * performance sink, force maxbytes up to at least double the current
+	 * memory used.  (In essence, we're admitting inability to fit within
+	 * work_mem when we do this.)  Note that this test will not fire if we
+	 * broke out of the loop early; and if we didn't, the current memory used
+	 * is simply not reducible any further.
 	 */
-	if (tbm->nentries > tbm->maxentries / 2)
-		tbm->maxentries = Min(tbm->nentries, (INT_MAX - 1) / 2) * 2;
+	if (TBM_MEMORY_USED(tbm) > tbm->maxbytes / 2)
+		tbm->maxbytes = Min((long) TBM_MEMORY_USED(tbm), LONG_MAX / 2) * 2;
 }
 
 /*
- * qsort comparator to handle PagetableEntry pointers.
+ * qsort comparator to handle HashPageEntry pointers.
  */
 static int
 tbm_comparator(const void *left, const void *right)
 {
-	BlockNumber l = (*((const PagetableEntry **) left))->blockno;
-	BlockNumber r = (*((const PagetableEntry **) right))->blockno;
+	BlockNumber l = (*((const HashPageEntry **) left))->blockno;
+	BlockNumber r = (*((const HashPageEntry **) right))->blockno;
 
 	if (l < r)
 		return -1;
@@ -1231,13 +1403,13 @@ tbm_stream_block(StreamNode *self, PagetableEntry *e)
 	IndexStream *is = self;
 	HashStreamOpaque *op = (HashStreamOpaque *) is->opaque;
 	HashBitmap *tbm = op->tbm;
-	PagetableEntry *next = op->entry;
+	HashPageEntry *next = op->entry;
 	bool		more;
 
 	/* have we already got an entry? */
 	if (next && is->nextblock <= next->blockno)
 	{
-		memcpy(e, next, sizeof(PagetableEntry));
+		tbm_expand_page(next, e);
 		return true;
 	}
 
@@ -1245,16 +1417,31 @@ tbm_stream_block(StreamNode *self, PagetableEntry *e)
 		tbm_begin_iterate(tbm);
 
 	/* we need a new entry */
-	op->entry = tbm_next_page(tbm, &more);
+	op->entry = tbm_next_page(tbm, &tbm->iter, &more);
 	if (more)
 	{
 		Assert(op->entry);
-		memcpy(e, op->entry, sizeof(PagetableEntry));
+		tbm_expand_page(op->entry, e);
 	}
 	is->nextblock++;
 	return more;
 }
 
+/*
+ * tbm_expand_page - copy a HashPageEntry into the PagetableEntry of a stream
+ */
+static void
+tbm_expand_page(const HashPageEntry *page, PagetableEntry *e)
+{
+	e->blockno = page->blockno;
+	e->ischunk = page->ischunk;
+	e->recheck = page->recheck;
+	if (page->nwords > 0)
+		memcpy(e->words, page->words, page->nwords * sizeof(tbm_bitmapword));
+	MemSet(e->words + page->nwords, 0,
+		   (lengthof(e->words) - page->nwords) * sizeof(tbm_bitmapword));
+}
+
 static void
 tbm_stream_free(StreamNode *self)
 {
@@ -27,6 +27,7 @@
 #include "optimizer/paths.h"
 #include "optimizer/plancat.h"
 #include "optimizer/planmain.h"
+#include "optimizer/planpartition.h"
 #include "optimizer/planner.h"
 #include "optimizer/prep.h"
 #include "optimizer/var.h"
@@ -42,6 +43,7 @@
 // TODO: these planner gucs need to be refactored into PlannerConfig.
 bool		gp_enable_sort_limit = FALSE;
 bool		gp_enable_sort_distinct = FALSE;
+bool		gp_enable_incremental_sort = FALSE;
 
 /* Hook for plugins to replace standard_join_search() */
 join_search_hook_type join_search_hook = NULL;
@@ -496,6 +498,12 @@ set_append_rel_pathlist(PlannerInfo *root, RelOptInfo *rel,
 			continue;
 		}
 
+		/*
+		 * If the partition can only be excluded once the parameter values
+		 * are known, let the executor do it.
+		 */
+		add_param_partition_gate(root, childrel, childRTE);
+
 		/* CE failed, so finish copying targetlist and join quals */
 		childrel->joininfo = (List *)
 			adjust_appendrel_attrs(root, (Node *) rel->joininfo,
@@ -43,8 +43,24 @@ typedef struct RangeQueryClause
 	Selectivity hibound;		/* Selectivity of a var < something clause */
 } RangeQueryClause;
 
+/*
+ * Data structure for accumulating "var = constant" clauses in
+ * clauselist_selectivity, to discount the ones implied by others.
+ */
+typedef struct EqualityClauses
+{
+	int			count;
+	Index	   *varnos;			/* range table index of each Var */
+	AttrNumber *attnos;			/* and its column */
+	int		   *rgselpos;		/* where the clause's selectivity is in rgsel */
+} EqualityClauses;
+
 static void addRangeClause(RangeQueryClause **rqlist, Node *clause,
 			   bool varonleft, bool isLTsel, Selectivity s2);
+static void addEqualityClause(EqualityClauses *eqclauses, Node *clause,
+				  bool varonleft, int rgselpos);
+static void applyEqualityDependencies(PlannerInfo *root,
+						  EqualityClauses *eqclauses, Selectivity *rgsel);
 
 /* cmpSelectivity
  * comparison function for using qsort on an array of Selectivity entries
@@ -112,6 +128,11 @@ cmpSelectivity
  *
  * Of course this is all very dependent on the behavior of
  * scalarltsel/scalargtsel; perhaps some day we can generalize the approach.
+ *
+ * We also recognize "x = constant" clauses on columns of the same relation
+ * between which ANALYZE found functional dependencies: if x determines y to
+ * degree d, the selectivity of y's clause given x's is d + (1 - d) * sel(y)
+ * rather than sel(y).  See find_attribute_dependencies().
  */
 Selectivity
 clauselist_selectivity(PlannerInfo *root,
@@ -124,6 +145,7 @@ clauselist_selectivity(PlannerInfo *root,
 	Selectivity s1 = 1.0;
 	Selectivity *rgsel = NULL;
 	RangeQueryClause *rqlist = NULL;
+	EqualityClauses eqclauses;
 	ListCell   *l;
 
 	int pos = 0;
@@ -140,6 +162,11 @@ clauselist_selectivity(PlannerInfo *root,
 		return clause_selectivity(root, (Node *) linitial(clauses),
 								  varRelid, jointype, sjinfo, use_damping);
 
+	eqclauses.count = 0;
+	eqclauses.varnos = (Index *) palloc(sizeof(Index) * list_length(clauses));
+	eqclauses.attnos = (AttrNumber *) palloc(sizeof(AttrNumber) * list_length(clauses));
+	eqclauses.rgselpos = (int *) palloc(sizeof(int) * list_length(clauses));
+
 	/*
 	 * Initial scan over clauses.  Anything that doesn't look like a potential
 	 * rangequery clause gets directly added as selectivity factor. Anything that
@@ -219,6 +246,11 @@ clauselist_selectivity(PlannerInfo *root,
 						addRangeClause(&rqlist, clause,
 									   varonleft, false, s2);
 						break;
+					case F_EQSEL:
+						addEqualityClause(&eqclauses, clause,
+										  varonleft, pos);
+						rgsel[pos++] = s2;
+						break;
 					default:
 						/* Just merge the selectivity in generically */
 						rgsel[pos++] = s2;
@@ -232,6 +264,14 @@ clauselist_selectivity(PlannerInfo *root,
 		rgsel[pos++] = s2;
 	}
 
+	/*
+	 * Discount the equality clauses implied by others.
+	 */
+	applyEqualityDependencies(root, &eqclauses, rgsel);
+	pfree(eqclauses.varnos);
+	pfree(eqclauses.attnos);
+	pfree(eqclauses.rgselpos);
+
 	/*
 	 * Now scan the rangequery pair list.
 	 */
@@ -342,6 +382,100 @@ clauselist_selectivity(PlannerInfo *root,
 	return s1;
 }
 
+/*
+ * addEqualityClause --- remember a "var = constant" clause for
+ * clauselist_selectivity, if it is on a plain column of a relation
+ */
+static void
+addEqualityClause(EqualityClauses *eqclauses, Node *clause,
+				  bool varonleft, int rgselpos)
+{
+	Node	   *var;
+
+	if (varonleft)
+		var = get_leftop((Expr *) clause);
+	else
+		var = get_rightop((Expr *) clause);
+
+	if (var && IsA(var, RelabelType))
+		var = (Node *) ((RelabelType *) var)->arg;
+
+	if (var == NULL || !IsA(var, Var) ||
+		((Var *) var)->varlevelsup != 0 ||
+		((Var *) var)->varattno <= 0)
+		return;
+
+	eqclauses->varnos[eqclauses->count] = ((Var *) var)->varno;
+	eqclauses->attnos[eqclauses->count] = ((Var *) var)->varattno;
+	eqclauses->rgselpos[eqclauses->count] = rgselpos;
+	eqclauses->count++;
+}
+
+/*
+ * applyEqualityDependencies --- adjust the selectivities of the equality
+ * clauses collected by clauselist_selectivity for the dependencies between
+ * their columns
+ *
+ * The clauses of each relation are looked up together. The selectivity of a
+ * clause whose column is determined to degree d by another's becomes
+ * d + (1 - d) * s in rgsel[].
+ */
+static void
+applyEqualityDependencies(PlannerInfo *root, EqualityClauses *eqclauses,
+						  Selectivity *rgsel)
+{
+	AttrNumber *attnos;
+	double	   *degrees;
+	int		   *members;
+	bool	   *done;
+	int			i,
+				j;
+
+	if (eqclauses->count < 2)
+		return;
+
+	attnos = (AttrNumber *) palloc(sizeof(AttrNumber) * eqclauses->count);
+	degrees = (double *) palloc(sizeof(double) * eqclauses->count);
+	members = (int *) palloc(sizeof(int) * eqclauses->count);
+	done = (bool *) palloc0(sizeof(bool) * eqclauses->count);
+
+	for (i = 0; i < eqclauses->count; i++)
+	{
+		int			nmembers = 0;
+
+		if (done[i])
+			continue;
+
+		/* Gather the clauses on the same relation */
+		for (j = i; j < eqclauses->count; j++)
+		{
+			if (!done[j] && eqclauses->varnos[j] == eqclauses->varnos[i])
+			{
+				done[j] = true;
+				attnos[nmembers] = eqclauses->attnos[j];
+				members[nmembers] = j;
+				nmembers++;
+			}
+		}
+
+		find_attribute_dependencies(root, eqclauses->varnos[i], nmembers,
+									attnos, degrees);
+
+		for (j = 0; j < nmembers; j++)
+		{
+			Selectivity *s2 = &rgsel[eqclauses->rgselpos[members[j]]];
+
+			if (degrees[j] > 0.0)
+				*s2 = degrees[j] + (1.0 - degrees[j]) * (*s2);
+		}
+	}
+
+	pfree(attnos);
+	pfree(degrees);
+	pfree(members);
+	pfree(done);
+}
+
 /*
  * addRangeClause --- add a new range clause for clauselist_selectivity
  *
@@ -622,6 +622,29 @@ pathkeys_contained_in(List *keys1, List *keys2)
 	return false;
 }
 
+/*
+ * pathkeys_common_prefix
+ *	  Count the leading pathkeys keys1 and keys2 have in common.
+ *
+ * Used to tell how much of a wanted ordering (keys1) the input ordering
+ * (keys2) already provides, when it doesn't provide all of it.
+ */
+int
+pathkeys_common_prefix(List *keys1, List *keys2)
+{
+	ListCell   *key1,
+			   *key2;
+	int			n = 0;
+
+	forboth(key1, keys1, key2, keys2)
+	{
+		if (lfirst(key1) != lfirst(key2))
+			break;
+		n++;
+	}
+	return n;
+}
+
 /*
  * get_cheapest_path_for_pathkeys
  *	  Find the cheapest path (according to the specified criterion) that
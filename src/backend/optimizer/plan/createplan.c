@@ -697,6 +697,13 @@ create_join_plan(PlannerInfo *root, JoinPath *best_path)
 		plan->targetlist = add_to_flat_tlist(plan->targetlist, plan->flow->hashExpr, true /* resjunk */ );
 	}
 
+	/*
+	 * A hash join of two identically partitioned tables may be done one
+	 * pair of partitions at a time.
+	 */
+	if (IsA(plan, HashJoin) && !partition_selector_created)
+		plan = partitionwise_hashjoin_plan(root, (HashJoin *) plan);
+
 	/*
 	 * If there are any pseudoconstant clauses attached to this node, insert a
 	 * gating Result node that evaluates the pseudoconstants as one-time
@@ -5352,12 +5359,12 @@ make_unique(Plan *lefttree, List *distinctList)
 
 /*
  * distinctList is a list of SortClauses, identifying the targetlist items
- * that should be considered by the SetOp filter.  The input path must
- * already be sorted accordingly.
+ * that should be considered by the SetOp filter.  For SETOP_SORTED, the
+ * input path must already be sorted accordingly.
  */
 SetOp *
-make_setop(SetOpCmd cmd, Plan *lefttree,
-		   List *distinctList, AttrNumber flagColIdx)
+make_setop(SetOpCmd cmd, SetOpStrategy strategy, Plan *lefttree,
+		   List *distinctList, AttrNumber flagColIdx, long numGroups)
 {
 	SetOp	   *node = makeNode(SetOp);
 	Plan	   *plan = &node->plan;
@@ -5411,10 +5418,12 @@ make_setop(SetOpCmd cmd, Plan *lefttree,
 	}
 
 	node->cmd = cmd;
+	node->strategy = strategy;
 	node->numCols = numCols;
 	node->dupColIdx = dupColIdx;
 	node->dupOperators = dupOperators;
 	node->flagColIdx = flagColIdx;
+	node->numGroups = numGroups;
 
 	return node;
 }
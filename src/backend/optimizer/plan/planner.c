@@ -57,6 +57,7 @@
 #include "cdb/cdbgroup.h"		/* grouping_planner extensions */
 #include "cdb/cdbsetop.h"		/* motion utilities */
 #include "cdb/cdbvars.h"
+#include "cdb/cdbendpoint.h"		/* IsParallelRetrieveCursorQuery() */
 
 
 /* GUC parameter */
@@ -183,10 +184,12 @@ standard_planner(Query *parse, int cursorOptions, ParamListInfo boundParams)
 
 	/*
 	 * If ORCA has been enabled, and we are in a state in which ORCA planning
-	 * is supported, then go ahead.
+	 * is supported, then go ahead.  The top slice of a PARALLEL RETRIEVE
+	 * cursor is only kept on the segments by the Postgres planner.
 	 */
 	if (optimizer &&
-		GP_ROLE_UTILITY != Gp_role && MASTER_CONTENT_ID == GpIdentity.segindex)
+		GP_ROLE_UTILITY != Gp_role && MASTER_CONTENT_ID == GpIdentity.segindex &&
+		!IsParallelRetrieveCursorQuery(parse))
 	{
 		if (gp_log_optimization_time)
 			INSTR_TIME_SET_CURRENT(starttime);
@@ -560,6 +563,15 @@ subquery_planner(PlannerGlobal *glob, Query *parse,
 		SS_process_ctes(root);
 	 */
 
+	/*
+	 * CDB: Compute DISTINCT-qualified aggregates on several arguments from
+	 * a single hashed deduplication of the input, rather than a join of a
+	 * 3-phase aggregation per argument.
+	 */
+	if (parse->hasAggs && config->gp_enable_dqa_expand &&
+		config->enable_hashagg)
+		cdb_expand_multi_dqa(parse);
+
 	/*
 	 * Ensure that jointree has been normalized. See
 	 * normalize_query_jointree_mutator()
@@ -2027,12 +2039,22 @@ grouping_planner(PlannerInfo *root, double tuple_fraction)
 	{
 		if (!pathkeys_contained_in(sort_pathkeys, current_pathkeys))
 		{
+			int			npresorted = pathkeys_common_prefix(sort_pathkeys,
+															current_pathkeys);
+
 			result_plan = (Plan *) make_sort_from_pathkeys(root,
 														   result_plan,
 														   sort_pathkeys,
 														limit_tuples, false);
 			if (result_plan == NULL)
 				elog(ERROR, "could not find sort pathkeys in result target list");
+
+			/*
+			 * If the input is already ordered on some leading sort keys, let
+			 * the executor sort it one group of equal leading keys at a time.
+			 */
+			if (gp_enable_incremental_sort && npresorted > 0)
+				((Sort *) result_plan)->numPresortedCols = npresorted;
 			current_pathkeys = sort_pathkeys;
 			mark_sort_locus(result_plan);
 		}
@@ -15,14 +15,24 @@
 
 #include "postgres.h"
 
+#include "catalog/pg_am.h"
+#include "commands/defrem.h"
 #include "optimizer/planpartition.h"
 #include "optimizer/paths.h"
 #include "optimizer/pathnode.h"
+#include "optimizer/clauses.h"
+#include "optimizer/cost.h"
+#include "optimizer/plancat.h"
+#include "optimizer/planmain.h"
+#include "optimizer/prep.h"
 #include "optimizer/restrictinfo.h"
+#include "optimizer/var.h"
 #include "cdb/cdbpartition.h"
 #include "cdb/cdbplan.h"
 #include "nodes/makefuncs.h"
+#include "parser/parsetree.h"
 #include "utils/lsyscache.h"
+#include "utils/typcache.h"
 #include "cdb/cdbvars.h"
 #include "parser/parse_oper.h"
 
@@ -34,6 +44,10 @@ static void add_restrictinfos(PlannerInfo *root, DynamicScanInfo *dsinfo, Bitmap
 
 static bool IsPartKeyVar(Expr *expr, int partVarno, int partKeyAttno);
 
+static bool contain_param_walker(Node *node, void *context);
+
+static Node *replace_var_mutator(Node *node, Expr **context);
+
 /*
  * Try to perform "partition selection" on a join.
  *
@@ -415,6 +429,201 @@ add_restrictinfos(PlannerInfo *root, DynamicScanInfo *dsinfo, Bitmapset *childre
 	}
 }
 
+/*
+ * Try to perform "partition selection" on parameter values.
+ *
+ * If a partition of a partitioned table is restricted by
+ *
+ *   partkey = <expression of Params>
+ *
+ * constraint exclusion can't tell at planning time whether the partition is
+ * needed, since the Params are only known at execution time. These are the
+ * parameters of a prepared statement, or the results of InitPlans, as in
+ * "WHERE partkey = (SELECT max(x) FROM othertable)". But the partition's
+ * CHECK constraints on the partitioning key can be checked against the
+ * expression instead of the key: if they are false, no row of the partition
+ * can match. We add them as a One-Time Filter on the partition scan:
+ *
+ * Append
+ *  -> Result
+ *     One-Time Filter: (($1 >= 1) AND ($1 < 10)) IS NOT FALSE
+ *        -> Seq Scan partition1
+ *           Filter: partkey = $1
+ *  -> Result
+ *     One-Time Filter: (($1 >= 10) AND ($1 < 20)) IS NOT FALSE
+ *        -> Seq Scan partition2
+ *           Filter: partkey = $1
+ *
+ * IS NOT FALSE, because a CHECK constraint lets the rows through that it
+ * is NULL for.
+ */
+void
+add_param_partition_gate(PlannerInfo *root, RelOptInfo *childrel,
+						 RangeTblEntry *childRTE)
+{
+	List	   *gates = NIL;
+	List	   *constraints = NIL;
+	bool		have_constraints = false;
+	bool		is_partition = false;
+	ListCell   *lc;
+	RestrictInfo *rinfo;
+
+	if (Gp_role != GP_ROLE_DISPATCH || !root->config->gp_dynamic_partition_pruning)
+		return;
+
+	if (childRTE->rtekind != RTE_RELATION || childRTE->inh)
+		return;
+
+	/* Only for the parts of partitioned tables */
+	foreach(lc, root->dynamicScans)
+	{
+		DynamicScanInfo *dyninfo = (DynamicScanInfo *) lfirst(lc);
+
+		if (bms_is_member(childrel->relid, dyninfo->children))
+		{
+			is_partition = true;
+			break;
+		}
+	}
+	if (!is_partition)
+		return;
+
+	foreach(lc, childrel->baserestrictinfo)
+	{
+		RestrictInfo *restriction = (RestrictInfo *) lfirst(lc);
+		OpExpr	   *opexpr = (OpExpr *) restriction->clause;
+		Expr	   *left;
+		Expr	   *right;
+		Var		   *var;
+		Expr	   *value;
+		ListCell   *lcc;
+
+		if (restriction->pseudoconstant ||
+			!IsA(opexpr, OpExpr) ||
+			list_length(opexpr->args) != 2 ||
+			!op_mergejoinable(opexpr->opno))
+			continue;
+
+		left = (Expr *) linitial(opexpr->args);
+		right = (Expr *) lsecond(opexpr->args);
+		while (IsA(left, RelabelType))
+			left = ((RelabelType *) left)->arg;
+		while (IsA(right, RelabelType))
+			right = ((RelabelType *) right)->arg;
+
+		if (IsA(left, Var))
+		{
+			var = (Var *) left;
+			value = (Expr *) lsecond(opexpr->args);
+		}
+		else if (IsA(right, Var))
+		{
+			var = (Var *) right;
+			value = (Expr *) linitial(opexpr->args);
+		}
+		else
+			continue;
+
+		/*
+		 * The value must be computable before the scan, once, and be of the
+		 * key's type so that it can stand in for it in the constraints.
+		 * Don't duplicate SubPlans, see FindEqKey().
+		 */
+		if (var->varno != childrel->relid || var->varlevelsup != 0 ||
+			contain_var_clause((Node *) value) ||
+			contain_volatile_functions((Node *) value) ||
+			contain_subplans((Node *) value) ||
+			!contain_param_walker((Node *) value, NULL) ||
+			exprType((Node *) value) != var->vartype)
+			continue;
+
+		if (!have_constraints)
+		{
+			constraints = get_relation_constraints(root, childRTE->relid,
+												   childrel, false);
+			have_constraints = true;
+		}
+
+		foreach(lcc, constraints)
+		{
+			Node	   *cons = (Node *) lfirst(lcc);
+			List	   *vars = pull_var_clause(cons, false);
+			ListCell   *lcv;
+			bool		only_key = (vars != NIL);
+			Expr	   *replace[2];
+			BooleanTest *btest;
+
+			foreach(lcv, vars)
+			{
+				Var		   *v = (Var *) lfirst(lcv);
+
+				if (v->varno != var->varno || v->varattno != var->varattno)
+				{
+					only_key = false;
+					break;
+				}
+			}
+			list_free(vars);
+
+			if (!only_key || contain_mutable_functions(cons))
+				continue;
+
+			replace[0] = (Expr *) var;
+			replace[1] = value;
+
+			btest = makeNode(BooleanTest);
+			btest->arg = (Expr *) replace_var_mutator(cons, replace);
+			btest->booltesttype = IS_NOT_FALSE;
+			gates = lappend(gates, btest);
+		}
+	}
+
+	if (gates == NIL)
+		return;
+
+	rinfo = make_restrictinfo(make_ands_explicit(gates),
+							  true,
+							  false,
+							  true,
+							  NULL,
+							  NULL,
+							  NULL);
+
+	childrel->baserestrictinfo = lappend(childrel->baserestrictinfo, rinfo);
+
+	root->hasPseudoConstantQuals = true;
+}
+
+static bool
+contain_param_walker(Node *node, void *context)
+{
+	if (node == NULL)
+		return false;
+	if (IsA(node, Param))
+		return true;
+	return expression_tree_walker(node, contain_param_walker, context);
+}
+
+/*
+ * Replace the Var context[0] with a copy of the expression context[1].
+ */
+static Node *
+replace_var_mutator(Node *node, Expr **context)
+{
+	if (node == NULL)
+		return NULL;
+	if (IsA(node, Var))
+	{
+		Var		   *var = (Var *) node;
+		Var		   *target = (Var *) context[0];
+
+		if (var->varno == target->varno && var->varattno == target->varattno &&
+			var->varlevelsup == 0)
+			return (Node *) copyObject(context[1]);
+	}
+	return expression_tree_mutator(node, replace_var_mutator, (void *) context);
+}
+
 RestrictInfo *
 make_mergeclause(Node *outer, Node *inner)
 {
@@ -454,3 +663,359 @@ IsPartKeyVar(Expr *expr, int partVarno, int partKeyAttno)
 	}
 	return false;
 }
+
+/*
+ * Return the AppendRelInfo of the given child range table entry, or NULL.
+ */
+static AppendRelInfo *
+find_child_appendrelinfo(PlannerInfo *root, Index child_relid)
+{
+	ListCell   *lc;
+
+	foreach(lc, root->append_rel_list)
+	{
+		AppendRelInfo *appinfo = (AppendRelInfo *) lfirst(lc);
+
+		if (appinfo->child_relid == child_relid)
+			return appinfo;
+	}
+	return NULL;
+}
+
+/*
+ * If 'plan' is an Append of plain scans on the partitions of one
+ * single-level partitioned table, return the AppendRelInfos of its
+ * children, in the order of the subplans, and the table's partitioning.
+ * Otherwise return NIL.
+ */
+static List *
+get_partitionwise_children(PlannerInfo *root, Plan *plan,
+						   Index *parent_relid, PartitionNode **pnode)
+{
+	List	   *appinfos = NIL;
+	ListCell   *lc;
+	RangeTblEntry *rte;
+	PartitionNode *pn;
+
+	if (!IsA(plan, Append) || ((Append *) plan)->isTarget)
+		return NIL;
+
+	*parent_relid = 0;
+	foreach(lc, ((Append *) plan)->appendplans)
+	{
+		Plan	   *subplan = (Plan *) lfirst(lc);
+		AppendRelInfo *appinfo;
+
+		switch (nodeTag(subplan))
+		{
+			case T_SeqScan:
+			case T_ExternalScan:
+			case T_AppendOnlyScan:
+			case T_AOCSScan:
+			case T_TableScan:
+			case T_IndexScan:
+			case T_BitmapHeapScan:
+			case T_BitmapAppendOnlyScan:
+			case T_BitmapTableScan:
+				break;
+			default:
+				return NIL;
+		}
+
+		appinfo = find_child_appendrelinfo(root, ((Scan *) subplan)->scanrelid);
+		if (appinfo == NULL)
+			return NIL;
+		if (*parent_relid == 0)
+			*parent_relid = appinfo->parent_relid;
+		else if (*parent_relid != appinfo->parent_relid)
+			return NIL;
+
+		appinfos = lappend(appinfos, appinfo);
+	}
+
+	if (appinfos == NIL)
+		return NIL;
+
+	rte = rt_fetch(*parent_relid, root->parse->rtable);
+	if (rte->rtekind != RTE_RELATION || !rel_is_partitioned(rte->relid))
+		return NIL;
+
+	pn = RelationBuildPartitionDescByOid(rte->relid, false);
+	if (pn == NULL || pn->part->parnatts != 1 ||
+		(pn->part->parkind != 'r' && pn->part->parkind != 'l'))
+		return NIL;
+
+	*pnode = pn;
+	return appinfos;
+}
+
+/*
+ * Are the two partitioning levels identical, that is, does every partition
+ * of one hold exactly the key values of the matching partition of the other?
+ * Only single-level partitioning is considered.
+ */
+static bool
+partition_nodes_equivalent(PartitionNode *a, PartitionNode *b)
+{
+	ListCell   *lca;
+	ListCell   *lcb;
+
+	if (a->part->parkind != b->part->parkind ||
+		a->part->parclass[0] != b->part->parclass[0] ||
+		list_length(a->rules) != list_length(b->rules) ||
+		(a->default_part == NULL) != (b->default_part == NULL))
+		return false;
+
+	if (a->default_part && (a->default_part->children || b->default_part->children))
+		return false;
+
+	forboth(lca, a->rules, lcb, b->rules)
+	{
+		PartitionRule *ra = (PartitionRule *) lfirst(lca);
+		PartitionRule *rb = (PartitionRule *) lfirst(lcb);
+
+		if (ra->children || rb->children)
+			return false;
+
+		if (!equal(ra->parrangestart, rb->parrangestart) ||
+			ra->parrangestartincl != rb->parrangestartincl ||
+			!equal(ra->parrangeend, rb->parrangeend) ||
+			ra->parrangeendincl != rb->parrangeendincl ||
+			!equal(ra->parlistvalues, rb->parlistvalues))
+			return false;
+	}
+
+	return true;
+}
+
+/*
+ * Position of the partition with the given OID among the rules of 'pnode'.
+ * The default partition comes after all the others. Returns -1 if the
+ * relation is not a partition at this level.
+ */
+static int
+partition_rule_index(PartitionNode *pnode, Oid relid)
+{
+	ListCell   *lc;
+	int			i = 0;
+
+	foreach(lc, pnode->rules)
+	{
+		if (((PartitionRule *) lfirst(lc))->parchildrelid == relid)
+			return i;
+		i++;
+	}
+	if (pnode->default_part && pnode->default_part->parchildrelid == relid)
+		return i;
+
+	return -1;
+}
+
+/*
+ * Is one of the hash clauses an equality between the partitioning keys of
+ * the two tables, using the operator that the partitioning is based on?
+ */
+static bool
+hashclauses_join_partkeys(List *hashclauses,
+						  Index outer_relid, PartitionNode *outer_pnode,
+						  Index inner_relid, PartitionNode *inner_pnode)
+{
+	ListCell   *lc;
+
+	foreach(lc, hashclauses)
+	{
+		OpExpr	   *opexpr = (OpExpr *) lfirst(lc);
+		Var		   *outervar;
+		Var		   *innervar;
+		TypeCacheEntry *typentry;
+
+		if (!IsA(opexpr, OpExpr) || list_length(opexpr->args) != 2)
+			continue;
+
+		if (!IsPartKeyVar(linitial(opexpr->args), outer_relid,
+						  outer_pnode->part->paratts[0]) ||
+			!IsPartKeyVar(lsecond(opexpr->args), inner_relid,
+						  inner_pnode->part->paratts[0]))
+			continue;
+
+		outervar = (Var *) strip_implicit_coercions(linitial(opexpr->args));
+		innervar = (Var *) strip_implicit_coercions(lsecond(opexpr->args));
+		if (!IsA(outervar, Var) || !IsA(innervar, Var) ||
+			outervar->vartype != innervar->vartype)
+			continue;
+
+		typentry = lookup_type_cache(outervar->vartype, TYPECACHE_EQ_OPR);
+		if (opexpr->opno != typentry->eq_opr ||
+			outer_pnode->part->parclass[0] !=
+			GetDefaultOpClass(outervar->vartype, BTREE_AM_OID))
+			continue;
+
+		return true;
+	}
+
+	return false;
+}
+
+/*
+ * Translate an expression of the join of two partitioned tables into the
+ * join of one partition of each.
+ */
+static Node *
+adjust_partitionwise_expr(PlannerInfo *root, Node *node,
+						  AppendRelInfo *outer_appinfo,
+						  AppendRelInfo *inner_appinfo)
+{
+	node = adjust_appendrel_attrs(root, node, outer_appinfo);
+	return adjust_appendrel_attrs(root, node, inner_appinfo);
+}
+
+/*
+ * Try to turn a hash join of two identically partitioned tables into an
+ * Append of hash joins between the matching partitions:
+ *
+ * Hash Join                             Append
+ *  -> Append                             -> Hash Join
+ *     -> Seq Scan a_1                       -> Seq Scan a_1
+ *     -> Seq Scan a_2           ==>         -> Hash
+ *  -> Hash                                     -> Seq Scan b_1
+ *     -> Append                          -> Hash Join
+ *        -> Seq Scan b_1                    -> Seq Scan a_2
+ *        -> Seq Scan b_2                    -> Hash
+ *                                              -> Seq Scan b_2
+ *
+ * Each of the smaller joins only needs a hash table of one partition, which
+ * is more likely to fit in memory, and partitions that were pruned on one
+ * side are not joined at all. This is only valid if the tables are
+ * partitioned on the join key, with the same boundaries, and the join is
+ * local to the segments, i.e. there is no Motion between the join and the
+ * scans. Only inner joins are handled, so a partition with no match on the
+ * other side can be left out.
+ *
+ * Returns the new plan, or the join unchanged.
+ */
+Plan *
+partitionwise_hashjoin_plan(PlannerInfo *root, HashJoin *join)
+{
+	Plan	   *outer_plan = join->join.plan.lefttree;
+	Hash	   *hash_plan = (Hash *) join->join.plan.righttree;
+	Index		outer_relid;
+	Index		inner_relid;
+	PartitionNode *outer_pnode;
+	PartitionNode *inner_pnode;
+	List	   *outer_appinfos;
+	List	   *inner_appinfos;
+	int			nparts;
+	Plan	  **inner_plans;
+	AppendRelInfo **inner_infos;
+	List	   *subplans = NIL;
+	ListCell   *lcp;
+	ListCell   *lca;
+	Plan	   *result;
+
+	if (!gp_enable_partitionwise_join ||
+		join->join.jointype != JOIN_INNER ||
+		!IsA(hash_plan, Hash))
+		return (Plan *) join;
+
+	if (contain_subplans((Node *) join->join.plan.qual) ||
+		contain_subplans((Node *) join->join.joinqual) ||
+		contain_subplans((Node *) join->join.plan.targetlist))
+		return (Plan *) join;
+
+	outer_appinfos = get_partitionwise_children(root, outer_plan,
+												&outer_relid, &outer_pnode);
+	if (outer_appinfos == NIL)
+		return (Plan *) join;
+	inner_appinfos = get_partitionwise_children(root, hash_plan->plan.lefttree,
+												&inner_relid, &inner_pnode);
+	if (inner_appinfos == NIL || inner_relid == outer_relid)
+		return (Plan *) join;
+
+	if (!partition_nodes_equivalent(outer_pnode, inner_pnode) ||
+		!hashclauses_join_partkeys(join->hashclauses,
+								   outer_relid, outer_pnode,
+								   inner_relid, inner_pnode))
+		return (Plan *) join;
+
+	/* Index the inner partitions by their position in the partitioning. */
+	nparts = list_length(inner_pnode->rules) + 1;
+	inner_plans = (Plan **) palloc0(nparts * sizeof(Plan *));
+	inner_infos = (AppendRelInfo **) palloc0(nparts * sizeof(AppendRelInfo *));
+	forboth(lcp, ((Append *) hash_plan->plan.lefttree)->appendplans,
+			lca, inner_appinfos)
+	{
+		AppendRelInfo *appinfo = (AppendRelInfo *) lfirst(lca);
+		RangeTblEntry *rte = rt_fetch(appinfo->child_relid, root->parse->rtable);
+		int			idx = partition_rule_index(inner_pnode, rte->relid);
+
+		if (idx < 0 || inner_plans[idx] != NULL)
+			return (Plan *) join;
+		inner_plans[idx] = (Plan *) lfirst(lcp);
+		inner_infos[idx] = appinfo;
+	}
+
+	/* Join each outer partition with the matching inner one. */
+	forboth(lcp, ((Append *) outer_plan)->appendplans, lca, outer_appinfos)
+	{
+		Plan	   *outer_child = (Plan *) lfirst(lcp);
+		AppendRelInfo *outer_info = (AppendRelInfo *) lfirst(lca);
+		RangeTblEntry *rte = rt_fetch(outer_info->child_relid, root->parse->rtable);
+		int			idx = partition_rule_index(outer_pnode, rte->relid);
+		AppendRelInfo *inner_info;
+		Hash	   *child_hash;
+		HashJoin   *child_join;
+		double		fraction;
+
+		if (idx < 0)
+			return (Plan *) join;
+
+		/* No matching inner partition, no rows out of this one. */
+		if (inner_plans[idx] == NULL)
+			continue;
+		inner_info = inner_infos[idx];
+
+		child_hash = make_hash(inner_plans[idx]);
+		child_hash->rescannable = hash_plan->rescannable;
+		child_hash->plan.flow = copyObject(inner_plans[idx]->flow);
+
+		child_join = make_hashjoin((List *) adjust_partitionwise_expr(root, (Node *) join->join.plan.targetlist, outer_info, inner_info),
+								   (List *) adjust_partitionwise_expr(root, (Node *) join->join.joinqual, outer_info, inner_info),
+								   (List *) adjust_partitionwise_expr(root, (Node *) join->join.plan.qual, outer_info, inner_info),
+								   (List *) adjust_partitionwise_expr(root, (Node *) join->hashclauses, outer_info, inner_info),
+								   (List *) adjust_partitionwise_expr(root, (Node *) join->hashqualclauses, outer_info, inner_info),
+								   outer_child,
+								   (Plan *) child_hash,
+								   JOIN_INNER);
+		child_join->join.prefetch_inner = join->join.prefetch_inner;
+
+		/* Charge each join its share of the estimated join, by outer rows. */
+		if (outer_plan->plan_rows > 0)
+			fraction = outer_child->plan_rows / outer_plan->plan_rows;
+		else
+			fraction = 1.0 / list_length(outer_appinfos);
+		child_join->join.plan.startup_cost = join->join.plan.startup_cost;
+		child_join->join.plan.total_cost = join->join.plan.total_cost * fraction;
+		child_join->join.plan.plan_rows = join->join.plan.plan_rows * fraction;
+		child_join->join.plan.plan_width = join->join.plan.plan_width;
+
+		if (join->join.plan.flow)
+		{
+			Flow	   *flow = copyObject(join->join.plan.flow);
+
+			flow->hashExpr = (List *) adjust_partitionwise_expr(root, (Node *) flow->hashExpr,
+																outer_info, inner_info);
+			child_join->join.plan.flow = flow;
+		}
+
+		subplans = lappend(subplans, child_join);
+	}
+
+	/* Keep the plain join if no pair is left; it handles the empty case. */
+	if (subplans == NIL)
+		return (Plan *) join;
+
+	result = (Plan *) make_append(subplans, false, join->join.plan.targetlist);
+	result->flow = join->join.plan.flow;
+
+	return result;
+}
@@ -52,6 +52,8 @@
 #include "cdb/cdbllize.h"                   /* pull_up_Flow() */
 #include "cdb/cdbvars.h"
 #include "cdb/cdbsetop.h"
+#include "executor/execHHashagg.h"		/* calcHashAggTableSizes() */
+#include "optimizer/cost.h"
 
 static Plan *recurse_set_operations(Node *setOp, PlannerInfo *root,
 					   double tuple_fraction,
@@ -67,6 +69,10 @@ static Plan *generate_union_plan(SetOperationStmt *op, PlannerInfo *root,
 					List *refnames_tlist, List **sortClauses);
 static Plan *generate_nonunion_plan(SetOperationStmt *op, PlannerInfo *root,
 					   List *refnames_tlist, List **sortClauses);
+static bool choose_hashed_setop(PlannerInfo *root, List *groupClauses,
+					Plan *input_plan, double dNumGroups);
+static Plan *make_hashed_unique(PlannerInfo *root, Plan *lefttree,
+				   List *distinctList, double dNumGroups);
 static List *recurse_union_children(Node *setOp, PlannerInfo *root,
 					   double tuple_fraction,
 					   SetOperationStmt *top_union,
@@ -412,14 +418,26 @@ generate_union_plan(SetOperationStmt *op, PlannerInfo *root,
 		sortList = addAllTargetsToSortList(NULL, NIL, tlist, false);
 		if (sortList)
 		{
+			/* We have no better estimate than that all rows are distinct */
+			double		dNumGroups = plan->plan_rows;
+
 			if ( optype == PSETOP_PARALLEL_PARTITIONED )
 			{
 				/* CDB: Hash motion to collocate non-distinct tuples. */
 				plan = (Plan *) make_motion_hash_all_targets(root, plan);
 			}
-			plan = (Plan *) make_sort_from_sortclauses(root, sortList, plan);
-			mark_sort_locus(plan); /* CDB */
-			plan = (Plan *) make_unique(plan, sortList);
+
+			if (choose_hashed_setop(root, sortList, plan, dNumGroups))
+			{
+				plan = make_hashed_unique(root, plan, sortList, dNumGroups);
+				sortList = NIL;		/* hashed output is unsorted */
+			}
+			else
+			{
+				plan = (Plan *) make_sort_from_sortclauses(root, sortList, plan);
+				mark_sort_locus(plan); /* CDB */
+				plan = (Plan *) make_unique(plan, sortList);
+			}
             plan->flow = pull_up_Flow(plan, plan->lefttree);
 		}
 		*sortClauses = sortList;
@@ -446,6 +464,8 @@ generate_nonunion_plan(SetOperationStmt *op, PlannerInfo *root,
 			   *planlist,
 			   *child_sortclauses;
 	SetOpCmd	cmd;
+	SetOpStrategy strategy;
+	double		dNumGroups;
 	GpSetOpType optype = PSETOP_NONE; /* CDB */
 
 	/* Recurse on children, ensuring their outputs are marked */
@@ -492,8 +512,8 @@ generate_nonunion_plan(SetOperationStmt *op, PlannerInfo *root,
 	mark_append_locus(plan, optype); /* CDB: Mark the plan result locus. */
 
 	/*
-	 * Sort the child results, then add a SetOp plan node to generate the
-	 * correct output.
+	 * Sort or hash the child results, then add a SetOp plan node to generate
+	 * the correct output.
 	 */
 	sortList = addAllTargetsToSortList(NULL, NIL, tlist, false);
 
@@ -509,9 +529,18 @@ generate_nonunion_plan(SetOperationStmt *op, PlannerInfo *root,
 		plan = (Plan *) make_motion_hash_all_targets(root, plan);
 	}
 
-	plan = (Plan *) make_sort_from_sortclauses(root, sortList, plan);
-	mark_sort_locus(plan); /* CDB */
-	
+	/* We have no better estimate than that all rows are distinct */
+	dNumGroups = plan->plan_rows;
+
+	if (choose_hashed_setop(root, sortList, plan, dNumGroups))
+		strategy = SETOP_HASHED;
+	else
+	{
+		strategy = SETOP_SORTED;
+		plan = (Plan *) make_sort_from_sortclauses(root, sortList, plan);
+		mark_sort_locus(plan); /* CDB */
+	}
+
 	switch (op->op)
 	{
 		case SETOP_INTERSECT:
@@ -526,14 +555,118 @@ generate_nonunion_plan(SetOperationStmt *op, PlannerInfo *root,
 			cmd = SETOPCMD_INTERSECT;	/* keep compiler quiet */
 			break;
 	}
-	plan = (Plan *) make_setop(cmd, plan, sortList, list_length(op->colTypes) + 1);
+	plan = (Plan *) make_setop(cmd, strategy, plan, sortList,
+							   list_length(op->colTypes) + 1,
+							   (long) Min(dNumGroups, (double) LONG_MAX));
     plan->flow = pull_up_Flow(plan, plan->lefttree);
 
-	*sortClauses = sortList;
+	/* Hashed output is unsorted */
+	*sortClauses = (strategy == SETOP_SORTED) ? sortList : NIL;
 
 	return plan;
 }
 
+/*
+ * choose_hashed_setop - should we hash, rather than sort, the input of a
+ * UNION, INTERSECT or EXCEPT to find the duplicates?
+ *
+ * Like choose_hashed_grouping, but the hash table needn't fit in work_mem,
+ * since both the hashed Agg and the hashed SetOp spill to workfiles.
+ */
+static bool
+choose_hashed_setop(PlannerInfo *root, List *groupClauses,
+					Plan *input_plan, double dNumGroups)
+{
+	int			numGroupCols = list_length(groupClauses);
+	double		hashentrysize;
+	HashAggTableSizes hash_info;
+	Path		hashed_p;
+	Path		sorted_p;
+	ListCell   *lc;
+
+	if (!gp_enable_hashed_setop || !root->config->enable_hashagg)
+		return false;
+
+	/* All the columns must be hashable */
+	foreach(lc, groupClauses)
+	{
+		SortClause *sortcl = (SortClause *) lfirst(lc);
+		Oid			eqop = get_equality_op_for_ordering_op(sortcl->sortop);
+
+		if (!OidIsValid(eqop) || !op_hashjoinable(eqop))
+			return false;
+	}
+
+	hashentrysize = agg_hash_entrywidth(0,
+						sizeof(HeapTupleData) + sizeof(HeapTupleHeaderData) +
+										input_plan->plan_width,
+										0);
+	if (!calcHashAggTableSizes(global_work_mem(root),
+							   dNumGroups,
+							   hashentrysize,
+							   false,
+							   &hash_info))
+		return false;
+
+	cost_agg(&hashed_p, root, AGG_HASHED, 0,
+			 numGroupCols, dNumGroups,
+			 input_plan->startup_cost, input_plan->total_cost,
+			 input_plan->plan_rows, hash_info.workmem_per_entry,
+			 hash_info.nbatches, hash_info.hashentry_width, false);
+
+	sorted_p.startup_cost = input_plan->startup_cost;
+	sorted_p.total_cost = input_plan->total_cost;
+	cost_sort(&sorted_p, root, NIL, sorted_p.total_cost,
+			  input_plan->plan_rows, input_plan->plan_width, -1.0);
+	cost_group(&sorted_p, root, numGroupCols, dNumGroups,
+			   sorted_p.startup_cost, sorted_p.total_cost,
+			   input_plan->plan_rows);
+
+	return hashed_p.total_cost < sorted_p.total_cost;
+}
+
+/*
+ * make_hashed_unique
+ *	  Remove duplicates from the input with a hashed Agg that has no
+ *	  aggregates, grouping on all of distinctList.
+ */
+static Plan *
+make_hashed_unique(PlannerInfo *root, Plan *lefttree,
+				   List *distinctList, double dNumGroups)
+{
+	int			numCols = list_length(distinctList);
+	AttrNumber *grpColIdx = (AttrNumber *) palloc(numCols * sizeof(AttrNumber));
+	Oid		   *grpOperators = (Oid *) palloc(numCols * sizeof(Oid));
+	int			keyno = 0;
+	ListCell   *lc;
+
+	foreach(lc, distinctList)
+	{
+		SortClause *sortcl = (SortClause *) lfirst(lc);
+		TargetEntry *tle = get_sortgroupclause_tle(sortcl, lefttree->targetlist);
+
+		grpColIdx[keyno] = tle->resno;
+		grpOperators[keyno] = get_equality_op_for_ordering_op(sortcl->sortop);
+		keyno++;
+	}
+
+	return (Plan *) make_agg(root,
+							 lefttree->targetlist,
+							 NIL,
+							 AGG_HASHED, false,
+							 numCols,
+							 grpColIdx,
+							 grpOperators,
+							 (long) Min(dNumGroups, (double) LONG_MAX),
+							 0, /* num_nullcols */
+							 0, /* input_grouping */
+							 0, /* grouping */
+							 0, /* rollup_gs_times */
+							 0, /* numAggs */
+							 0, /* transSpace */
+							 lefttree);
+}
+
 /*
  * Pull up children of a UNION node that are identically-propertied UNIONs.
  *
@@ -55,10 +55,6 @@ bool		constraint_exclusion = false;
 get_relation_info_hook_type get_relation_info_hook = NULL;
 
 
-static List *get_relation_constraints(PlannerInfo *root,
-						 Oid relationObjectId, RelOptInfo *rel,
-						 bool include_notnull);
-
 static void
 estimate_tuple_width(Relation   rel,
                      int32     *attr_widths,
@@ -689,11 +685,11 @@ estimate_tuple_width(Relation   rel,
  * If include_notnull is true, "col IS NOT NULL" expressions are generated
  * and added to the result for each column that's marked attnotnull.
  *
- * Note: at present this is invoked at most once per relation per planner
- * run, and in many cases it won't be invoked at all, so there seems no
+ * Note: at present this is invoked at most a couple of times per relation per
+ * planner run, and in many cases it won't be invoked at all, so there seems no
  * point in caching the data in RelOptInfo.
  */
-static List *
+List *
 get_relation_constraints(PlannerInfo *root,
 						 Oid relationObjectId, RelOptInfo *rel,
 						 bool include_notnull)
@@ -210,7 +210,7 @@ static Node *makeIsNotDistinctFromNode(Node *expr, int position);
 %type <node>	AlterTypeStmt AlterQueueStmt AlterResourceGroupStmt
 		CreateExternalStmt CreateFileSpaceStmt
 		CreateQueueStmt CreateResourceGroupStmt
-		DropQueueStmt DropResourceGroupStmt
+		DropQueueStmt DropResourceGroupStmt RetrieveStmt
 		ExtTypedesc OptSingleRowErrorHandling
 
 %type <node>    deny_login_role deny_interval deny_point deny_day_specifier
@@ -512,7 +512,7 @@ static Node *makeIsNotDistinctFromNode(Node *expr, int position);
 	DEFERRABLE DEFERRED DEFINER DELETE_P DELIMITER DELIMITERS DESC
 	DICTIONARY DISABLE_P DISCARD DISTINCT DO DOCUMENT_P DOMAIN_P DOUBLE_P DROP
 
-	EACH ELSE ENABLE_P ENCODING ENCRYPTED END_P ENUM_P ESCAPE EXCEPT
+	EACH ELSE ENABLE_P ENCODING ENCRYPTED END_P ENDPOINT ENUM_P ESCAPE EXCEPT
 	EXCLUDING EXCLUSIVE EXECUTE EXISTS EXPLAIN EXTENSION EXTERNAL EXTRACT
 
 	FALSE_P FAMILY FETCH FIRST_P FLOAT_P FOR FORCE FOREIGN FORWARD
@@ -545,14 +545,14 @@ static Node *makeIsNotDistinctFromNode(Node *expr, int position);
 	OBJECT_P OF OFF OFFSET OIDS OLD ON ONLY OPERATOR OPTION OPTIONS OR
 	ORDER OUT_P OUTER_P OVERLAPS OVERLAY OWNED OWNER
 
-	PARSER PARTIAL PASSWORD PLACING PLANS POSITION
+	PARALLEL PARSER PARTIAL PASSWORD PLACING PLANS POSITION
 	PRECISION PRESERVE PREPARE PREPARED PRIMARY
 	PRIOR PRIVILEGES PROCEDURAL PROCEDURE PROGRAM
 
 	QUOTE
 
 	READ REAL REASSIGN RECHECK RECURSIVE REFERENCES REINDEX RELATIVE_P RELEASE
-	RENAME REPEATABLE REPLACE REPLICA RESET RESTART RESTRICT RETURNING RETURNS
+	RENAME REPEATABLE REPLACE REPLICA RESET RESTART RESTRICT RETRIEVE RETURNING RETURNS
 	REVOKE RIGHT ROLE ROLLBACK ROW ROWS RULE
 
 	SAVEPOINT SCHEMA SCROLL SEARCH SECOND_P SECURITY SELECT SEQUENCE
@@ -737,6 +737,7 @@ static Node *makeIsNotDistinctFromNode(Node *expr, int position);
 			%nonassoc ENABLE_P
 			%nonassoc ENCODING
 			%nonassoc ENCRYPTED
+			%nonassoc ENDPOINT
 			%nonassoc END_P
 			%nonassoc ENUM_P
 			%nonassoc ERRORS
@@ -834,6 +835,7 @@ static Node *makeIsNotDistinctFromNode(Node *expr, int position);
 			%nonassoc OVERCOMMIT
 			%nonassoc OWNED
 			%nonassoc OWNER
+			%nonassoc PARALLEL
 			%nonassoc PARTIAL
 			%nonassoc PARTITIONS
 			%nonassoc PASSWORD
@@ -865,6 +867,7 @@ static Node *makeIsNotDistinctFromNode(Node *expr, int position);
 			%nonassoc RESOURCE
 			%nonassoc RESTART
 			%nonassoc RESTRICT
+			%nonassoc RETRIEVE
 			%nonassoc RETURNS
 			%nonassoc REVOKE
 			%nonassoc ROLE
@@ -1122,6 +1125,7 @@ stmt :
 			| PrepareStmt
 			| ReassignOwnedStmt
 			| ReindexStmt
+			| RetrieveStmt
 			| RemoveAggrStmt
 			| RemoveFuncStmt
 			| RemoveOperStmt
@@ -6553,6 +6557,32 @@ FetchStmt:	FETCH fetch_direction from_in name
 				}
 		;
 
+/*****************************************************************************
+ *
+ *		QUERY:
+ *			RETRIEVE { ALL | count } FROM ENDPOINT 'token'
+ *
+ *		Reads the rows of a PARALLEL RETRIEVE cursor on a segment.
+ *
+ *****************************************************************************/
+
+RetrieveStmt:
+			RETRIEVE ALL FROM ENDPOINT Sconst
+				{
+					RetrieveStmt *n = makeNode(RetrieveStmt);
+					n->endpoint = $5;
+					n->count = FETCH_ALL;
+					$$ = (Node *)n;
+				}
+			| RETRIEVE SignedIconst FROM ENDPOINT Sconst
+				{
+					RetrieveStmt *n = makeNode(RetrieveStmt);
+					n->endpoint = $5;
+					n->count = $2;
+					$$ = (Node *)n;
+				}
+		;
+
 fetch_direction:
 			/*EMPTY*/
 				{
@@ -9339,6 +9369,7 @@ cursor_options: /*EMPTY*/					{ $$ = 0; }
 			| cursor_options SCROLL			{ $$ = $1 | CURSOR_OPT_SCROLL; }
 			| cursor_options BINARY			{ $$ = $1 | CURSOR_OPT_BINARY; }
 			| cursor_options INSENSITIVE	{ $$ = $1 | CURSOR_OPT_INSENSITIVE; }
+			| cursor_options PARALLEL RETRIEVE	{ $$ = $1 | CURSOR_OPT_PARALLEL_RETRIEVE; }
 		;
 
 opt_hold: /* EMPTY */						{ $$ = 0; }
@@ -13169,6 +13200,7 @@ unreserved_keyword:
 			| ENABLE_P
 			| ENCODING
 			| ENCRYPTED
+			| ENDPOINT
 			| ENUM_P
 			| ERRORS
 			| ESCAPE
@@ -13274,6 +13306,7 @@ unreserved_keyword:
 			| OVERCOMMIT
 			| OWNED
 			| OWNER
+			| PARALLEL
 			| PARSER
 			| PARTIAL
 			| PARTITIONS
@@ -13312,6 +13345,7 @@ unreserved_keyword:
 			| RESOURCE
 			| RESTART
 			| RESTRICT
+			| RETRIEVE
 			| RETURNS
 			| REVOKE
 			| ROLE
@@ -13477,6 +13511,7 @@ PartitionIdentKeyword: ABORT_P
 			| ENABLE_P
 			| ENCODING
 			| ENCRYPTED
+			| ENDPOINT
 			| ERRORS
 			| ENUM_P
 			| ESCAPE
@@ -13569,6 +13604,7 @@ PartitionIdentKeyword: ABORT_P
 			| OVERCOMMIT
 			| OWNED
 			| OWNER
+			| PARALLEL
 			| PARTIAL
 			| PARTITIONS
 			| PASSWORD
@@ -13596,6 +13632,7 @@ PartitionIdentKeyword: ABORT_P
 			| RESOURCE
 			| RESTART
 			| RESTRICT
+			| RETRIEVE
 			| RETURNS
 			| REVOKE
 			| ROLE
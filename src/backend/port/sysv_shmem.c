@@ -29,6 +29,10 @@
 #ifdef HAVE_KERNEL_OS_H
 #include <kernel/OS.h>
 #endif
+#ifdef __linux__
+#include <sys/syscall.h>
+#include <linux/mempolicy.h>
+#endif
 
 #include "miscadmin.h"
 #include "storage/ipc.h"
@@ -46,11 +50,17 @@ typedef int IpcMemoryId;		/* shared memory ID returned by shmget(2) */
 #define PG_SHMAT_FLAGS			0
 #endif
 
+/* Huge page size assumed if /proc/meminfo doesn't tell */
+#define DEFAULT_HUGE_PAGE_SIZE	(2 * 1024 * 1024)
+
 
 unsigned long UsedShmemSegID = 0;
 void	   *UsedShmemSegAddr = NULL;
 
 static void *InternalIpcMemoryCreate(IpcMemoryKey memKey, Size size);
+static Size GetHugePageSize(void);
+static void ApplySharedMemoryNumaPolicy(void *memAddress, Size size);
+static void ApplyProcessNumaPolicy(void);
 static void IpcMemoryDetach(int status, Datum shmaddr);
 static void IpcMemoryDelete(int status, Datum shmId);
 static PGShmemHeader *PGSharedMemoryAttach(IpcMemoryKey key,
@@ -72,10 +82,55 @@ static PGShmemHeader *PGSharedMemoryAttach(IpcMemoryKey key,
 static void *
 InternalIpcMemoryCreate(IpcMemoryKey memKey, Size size)
 {
-	IpcMemoryId shmid;
+	IpcMemoryId shmid = -1;
 	void	   *memAddress;
 
-	shmid = shmget(memKey, size, IPC_CREAT | IPC_EXCL | IPCProtection);
+#ifdef SHM_HUGETLB
+	if (huge_pages == HUGE_PAGES_ON || huge_pages == HUGE_PAGES_TRY)
+	{
+		Size		hugepagesize = GetHugePageSize();
+		Size		allocsize = size;
+
+		/* The kernel wants a multiple of the huge page size */
+		if (allocsize % hugepagesize != 0)
+			allocsize += hugepagesize - (allocsize % hugepagesize);
+
+		shmid = shmget(memKey, allocsize,
+					   IPC_CREAT | IPC_EXCL | IPCProtection | SHM_HUGETLB);
+
+		/*
+		 * On a collision, leave it to the regular shmget() below to fail the
+		 * same way.  Any other failure means huge pages are unavailable.
+		 */
+		if (shmid < 0 && errno != EEXIST && errno != EACCES
+#ifdef EIDRM
+			&& errno != EIDRM
+#endif
+			)
+		{
+			if (huge_pages == HUGE_PAGES_ON)
+				ereport(FATAL,
+						(errmsg("could not create huge page shared memory segment: %m"),
+						 errdetail("Failed system call was shmget(key=%lu, size=%lu, 0%o).",
+								   (unsigned long) memKey, (unsigned long) allocsize,
+								   IPC_CREAT | IPC_EXCL | IPCProtection | SHM_HUGETLB),
+						 errhint("This error usually means that the kernel has fewer than %lu "
+								 "free huge pages (see vm.nr_hugepages), or that the server's "
+								 "group is not allowed to use them (see vm.hugetlb_shm_group).  "
+								 "Set huge_pages to \"try\" or \"off\" to use regular pages.",
+								 (unsigned long) (allocsize / hugepagesize))));
+			elog(DEBUG1, "shmget(SHM_HUGETLB) failed, using regular pages: %m");
+		}
+	}
+#else
+	if (huge_pages == HUGE_PAGES_ON)
+		ereport(FATAL,
+				(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+				 errmsg("huge pages are not supported on this platform")));
+#endif
+
+	if (shmid < 0)
+		shmid = shmget(memKey, size, IPC_CREAT | IPC_EXCL | IPCProtection);
 
 	if (shmid < 0)
 	{
@@ -192,6 +247,9 @@ InternalIpcMemoryCreate(IpcMemoryKey memKey, Size size)
 	if (memAddress == (void *) -1)
 		elog(FATAL, "shmat(id=%d) failed: %m", shmid);
 
+	/* Place the pages before anything touches them */
+	ApplySharedMemoryNumaPolicy(memAddress, size);
+
 	/* Register on-exit routine to detach new segment before deleting */
 	on_shmem_exit(IpcMemoryDetach, PointerGetDatum(memAddress));
 
@@ -202,6 +260,101 @@ InternalIpcMemoryCreate(IpcMemoryKey memKey, Size size)
 	return memAddress;
 }
 
+/*
+ * GetHugePageSize
+ *
+ * Return the default huge page size of the kernel, from /proc/meminfo.
+ */
+static Size
+GetHugePageSize(void)
+{
+	Size		hugepagesize = DEFAULT_HUGE_PAGE_SIZE;
+#ifdef __linux__
+	FILE	   *fp;
+	char		buf[128];
+	unsigned long sz;
+
+	fp = fopen("/proc/meminfo", "r");
+	if (fp)
+	{
+		while (fgets(buf, sizeof(buf), fp))
+		{
+			if (sscanf(buf, "Hugepagesize: %lu kB", &sz) == 1)
+			{
+				if (sz > 0)
+					hugepagesize = (Size) sz * 1024;
+				break;
+			}
+		}
+		fclose(fp);
+	}
+#endif
+	return hugepagesize;
+}
+
+/*
+ * ApplySharedMemoryNumaPolicy
+ *
+ * Set the NUMA policy of a newly attached segment, per gp_numa_policy.
+ * Pages are placed when first touched, so this must be done before the
+ * segment is initialized.
+ *
+ * With "interleave", the pages are spread round-robin over all the nodes,
+ * so that the segments of a host share the memory bandwidth of all the
+ * sockets.  With "local", the pages are placed on the node of the process
+ * that touches them first, which is where the postmaster runs when the
+ * segment is bound to a node (e.g. with numactl --cpunodebind).  Failures
+ * are only logged; the segment still works without the policy.
+ */
+static void
+ApplySharedMemoryNumaPolicy(void *memAddress, Size size)
+{
+#if defined(__linux__) && defined(SYS_mbind)
+	unsigned long nodemask = 0;
+	unsigned long maxnode = sizeof(nodemask) * BITS_PER_BYTE;
+	long		rc;
+
+	if (gp_numa_policy == NUMA_POLICY_INTERLEAVE)
+	{
+		/* Interleave over the nodes this process may allocate from */
+		rc = syscall(SYS_get_mempolicy, NULL, &nodemask, maxnode, NULL,
+					 MPOL_F_MEMS_ALLOWED);
+		/* mbind() counts maxnode one past the last node */
+		if (rc == 0)
+			rc = syscall(SYS_mbind, memAddress, size, MPOL_INTERLEAVE,
+						 &nodemask, maxnode + 1, 0);
+	}
+	else if (gp_numa_policy == NUMA_POLICY_LOCAL)
+		rc = syscall(SYS_mbind, memAddress, size, MPOL_PREFERRED,
+					 NULL, 0, 0);
+	else
+		return;
+
+	if (rc != 0)
+		elog(LOG, "could not set NUMA policy of shared memory segment: %m");
+#endif
+}
+
+/*
+ * ApplyProcessNumaPolicy
+ *
+ * Make the private memory of the postmaster, and so of every process it
+ * forks, local to the node the process runs on.  Without this, a
+ * postmaster started under "numactl --interleave" would interleave the
+ * executor memory of every backend too.
+ */
+static void
+ApplyProcessNumaPolicy(void)
+{
+#if defined(__linux__) && defined(SYS_set_mempolicy)
+	if (gp_numa_policy == NUMA_POLICY_OFF)
+		return;
+
+	if (syscall(SYS_set_mempolicy, MPOL_PREFERRED, NULL, 0) != 0)
+		elog(LOG, "could not set NUMA policy of process memory: %m");
+#endif
+}
+
 /****************************************************************************/
 /*	IpcMemoryDetach(status, shmaddr)	removes a shared memory segment		*/
 /*										from process' address spaceq		*/
@@ -440,6 +593,9 @@ PGSharedMemoryCreate(Size size, bool makePrivate, int port)
 	UsedShmemSegAddr = memAddress;
 	UsedShmemSegID = (unsigned long) NextShmemSegID;
 
+	/* Children inherit the policy across fork() */
+	ApplyProcessNumaPolicy();
+
 	return hdr;
 }
 
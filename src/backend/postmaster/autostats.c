@@ -18,7 +18,9 @@
  */
 #include "postgres.h"
 
+#include "access/heapam.h"
 #include "catalog/catalog.h"
+#include "catalog/gp_policy.h"
 #include "cdb/cdbvars.h"
 #include "cdb/cdbpartition.h"
 #include "commands/vacuum.h"
@@ -26,7 +28,9 @@
 #include "nodes/makefuncs.h"
 #include "nodes/plannodes.h"
 #include "parser/parsetree.h"
+#include "pgstat.h"
 #include "postmaster/autostats.h"
+#include "postmaster/autovacuum.h"
 #include "utils/acl.h"
 #include "miscadmin.h"
 #include "utils/lsyscache.h"
@@ -38,6 +42,9 @@
 static void autostats_issue_analyze(Oid relationOid);
 static bool autostats_on_change_check(AutoStatsCmdType cmdType, uint64 ntuples);
 static bool autostats_on_no_stats_check(AutoStatsCmdType cmdType, Oid relationOid);
+static bool autostats_on_change_since_analyze_check(AutoStatsCmdType cmdType, Oid relationOid,
+										uint64 ntuples);
+static void autostats_count_changes(AutoStatsCmdType cmdType, Oid relationOid, uint64 ntuples);
 
 /*
  * Auto-stats employs this sub-routine to issue an analyze on a specific relation.
@@ -156,6 +163,128 @@ autostats_on_no_stats_check(AutoStatsCmdType cmdType, Oid relationOid)
 	/* we should not get here at all */
 }
 
+/*
+ * Method determines if auto-stats should run as per onchangesinceanalyze auto-stats policy.
+ * This policy enables auto-analyze once the tuples inserted, updated or deleted since the
+ * table was last analyzed, by this and earlier commands, exceed the autovacuum analyze
+ * threshold:
+ *
+ *		autovacuum_analyze_threshold + autovacuum_analyze_scale_factor * reltuples
+ *
+ * The table is not analyzed again until gp_autostats_min_interval has passed since it was
+ * last analyzed, so that a stream of small commands does not analyze it over and over.
+ */
+static bool
+autostats_on_change_since_analyze_check(AutoStatsCmdType cmdType, Oid relationOid,
+										uint64 ntuples)
+{
+	PgStat_StatTabEntry *tabentry;
+	HeapTuple	tuple;
+	float4		reltuples;
+	double		changes;
+	double		threshold;
+	TimestampTz lastAnalyze;
+
+	switch (cmdType)
+	{
+		case AUTOSTATS_CMDTYPE_CTAS:
+		case AUTOSTATS_CMDTYPE_INSERT:
+		case AUTOSTATS_CMDTYPE_DELETE:
+		case AUTOSTATS_CMDTYPE_UPDATE:
+		case AUTOSTATS_CMDTYPE_COPY:
+			break;
+		default:
+			return false;
+	}
+
+	tuple = SearchSysCache(RELOID,
+						   ObjectIdGetDatum(relationOid),
+						   0, 0, 0);
+	if (!HeapTupleIsValid(tuple))
+		ereport(ERROR,
+				(errcode(ERRCODE_UNDEFINED_TABLE),
+				 errmsg("relation with OID %u does not exist",
+						relationOid)));
+	reltuples = ((Form_pg_class) GETSTRUCT(tuple))->reltuples;
+	ReleaseSysCache(tuple);
+
+	/*
+	 * The collector has not seen the changes of this command yet, nor those
+	 * of the earlier commands of this transaction, so add this command's.
+	 */
+	changes = (double) ntuples;
+	lastAnalyze = 0;
+	tabentry = pgstat_fetch_stat_tabentry(relationOid);
+	if (tabentry != NULL)
+	{
+		changes += tabentry->changes_since_analyze;
+		lastAnalyze = Max(tabentry->analyze_timestamp,
+						  tabentry->autovac_analyze_timestamp);
+	}
+
+	threshold = (double) autovacuum_anl_thresh + autovacuum_anl_scale * reltuples;
+
+	elog(DEBUG5, "Auto-stats ONCHANGESINCEANALYZE check on tableoid %d has %.0f changes, threshold %.0f.",
+		 relationOid, changes, threshold);
+
+	if (changes <= threshold)
+		return false;
+
+	if (lastAnalyze != 0 &&
+		!TimestampDifferenceExceeds(lastAnalyze, GetCurrentTimestamp(),
+									gp_autostats_min_interval * 1000))
+	{
+		elog(DEBUG3, "Auto-stats did not issue ANALYZE on tableoid %d since it was analyzed less than %d s ago.",
+			 relationOid, gp_autostats_min_interval);
+		return false;
+	}
+
+	return true;
+}
+
+/*
+ * Count the tuples a command changed in a distributed table, so that the
+ * statistics collector of the master knows how much the table changed since
+ * it was last analyzed. The tuples are changed on the segments, so nothing
+ * else counts them on the master.
+ */
+static void
+autostats_count_changes(AutoStatsCmdType cmdType, Oid relationOid, uint64 ntuples)
+{
+	Relation	rel;
+
+	if (ntuples == 0)
+		return;
+
+	/* the command holds a lock on the relation already */
+	rel = try_relation_open(relationOid, NoLock, false);
+	if (rel == NULL)
+		return;
+
+	if (rel->rd_cdbpolicy != NULL &&
+		rel->rd_cdbpolicy->ptype == POLICYTYPE_PARTITIONED)
+	{
+		switch (cmdType)
+		{
+			case AUTOSTATS_CMDTYPE_CTAS:
+			case AUTOSTATS_CMDTYPE_INSERT:
+			case AUTOSTATS_CMDTYPE_COPY:
+				pgstat_count_dispatched_changes(rel, ntuples, 0, 0);
+				break;
+			case AUTOSTATS_CMDTYPE_UPDATE:
+				pgstat_count_dispatched_changes(rel, 0, ntuples, 0);
+				break;
+			case AUTOSTATS_CMDTYPE_DELETE:
+				pgstat_count_dispatched_changes(rel, 0, 0, ntuples);
+				break;
+			default:
+				break;
+		}
+	}
+
+	relation_close(rel, NoLock);
+}
+
 /*
  * Convert command type to string for logging purposes.
  */
@@ -244,6 +373,8 @@ autostats_get_cmdtype(QueryDesc *queryDesc, AutoStatsCmdType * pcmdType, Oid *pr
  * on_change	:	if the number of modified tuples > gp_onchange_threshold, then an automatic analyze is issued.
  * on_no_stats	:	if the operation is a ctas/insert-select and there are no stats on the modified table,
  *					an automatic analyze is issued.
+ * on_change_since_analyze	:	if the number of tuples modified since the table was last analyzed
+ *					exceeds the autovacuum analyze threshold, an automatic analyze is issued.
  */
 void
 auto_stats(AutoStatsCmdType cmdType, Oid relationOid, uint64 ntuples, bool inFunction)
@@ -273,6 +404,8 @@ auto_stats(AutoStatsCmdType cmdType, Oid relationOid, uint64 ntuples, bool inFun
 		actual_gp_autostats_mode = gp_autostats_mode;
 	}
 
+	autostats_count_changes(cmdType, relationOid, ntuples);
+
 	switch (actual_gp_autostats_mode)
 	{
 		case GP_AUTOSTATS_ON_CHANGE:
@@ -281,6 +414,9 @@ auto_stats(AutoStatsCmdType cmdType, Oid relationOid, uint64 ntuples, bool inFun
 		case GP_AUTOSTATS_ON_NO_STATS:
 			policyCheck = autostats_on_no_stats_check(cmdType, relationOid);
 			break;
+		case GP_AUTOSTATS_ON_CHANGE_SINCE_ANALYZE:
+			policyCheck = autostats_on_change_since_analyze_check(cmdType, relationOid, ntuples);
+			break;
 		default:
 			Assert(actual_gp_autostats_mode == GP_AUTOSTATS_NONE);
 			policyCheck = false;
@@ -16,6 +16,11 @@
  *						  backoff.
  * BackoffSweeper()		- workhorse for the sweeper process
  *
+ * With gp_resqueue_priority_mode set to 'nice', the weight of a statement
+ * is instead mapped to the nice value of its backends, and the kernel
+ * scheduler shares the CPU by weight without any sleeps. Backends fall
+ * back to backing off if their nice value cannot be set.
+ *
  * Portions Copyright (c) 2009-2010, Greenplum inc.
  * Portions Copyright (c) 2012-Present Pivotal Software, Inc.
  *
@@ -46,7 +51,9 @@
 #include "cdb/cdbdisp_query.h"
 #include "cdb/cdbdispatchresult.h"
 #include "gp-libpq-fe.h"
+#include <math.h>
 #include <unistd.h>
+#include <sys/resource.h>
 
 #include <signal.h>
 #include "libpq/pqsignal.h"
@@ -82,6 +89,12 @@ extern bool gp_debug_resqueue_priority;
 /* In ms */
 #define DEFAULT_SLEEP_TIME 100.0
 
+/* Weight that keeps the nice value of the postmaster */
+#define NICE_REFERENCE_WEIGHT 2000.0
+
+/* Each nice level changes the share of the kernel scheduler by about 1.25x */
+#define NICE_WEIGHT_RATIO 1.25
+
 /**
  * A statement id consists of a session id and command count.
  */
@@ -112,6 +125,8 @@ typedef struct BackoffBackendLocalEntry
 								 * prevent nested calls */
 	bool		groupingTimeExpired;	/* Should backend try to find better
 										 * leader? */
+	int			niceWeight;		/* Weight applied as nice value, 0 if none */
+	bool		niceApplied;	/* Is the kernel enforcing niceWeight? */
 }	BackoffBackendLocalEntry;
 
 /**
@@ -211,6 +226,7 @@ static volatile bool sweeperShutdownRequested = false;
 static volatile bool isSweeperProcess = false;
 
 /* Resource queue related routines */
+static void BackoffApplyNice(int weight);
 static int	BackoffPriorityValueToInt(const char *priorityVal);
 static char *BackoffPriorityIntToValue(int weight);
 extern List *GetResqueueCapabilityEntry(Oid queueid);
@@ -467,6 +483,9 @@ BackoffBackendEntryInit(int sessionid, int commandcount, int weight)
 	myLocalEntry->counter = 1;
 	myLocalEntry->inTick = false;
 
+	if (gp_resqueue_priority_mode == RESQUEUE_PRIORITY_MODE_NICE)
+		BackoffApplyNice(weight);
+
 	/* Try to find a better leader for my group */
 	findBetterGroupLeader();
 
@@ -665,6 +684,20 @@ BackoffBackendTick()
 
 	le->inTick = true;
 
+	if (gp_resqueue_priority_mode == RESQUEUE_PRIORITY_MODE_NICE)
+	{
+		/* The weight may have been adjusted by gp_adjust_priority() */
+		if (le->niceWeight != se->weight)
+			BackoffApplyNice(se->weight);
+
+		if (le->niceApplied)
+		{
+			/* The kernel enforces the weight, no need to backoff */
+			le->inTick = false;
+			return;
+		}
+	}
+
 	le->counter++;
 	if (le->counter == gp_resqueue_priority_local_interval)
 	{
@@ -1507,6 +1540,52 @@ ResourceQueueGetPriorityWeight(Oid queueId)
 	return weight;
 }
 
+/**
+ * Set the nice value of this backend according to the weight of its
+ * statement, relative to the nice value the backend started with. An
+ * unprivileged process may not be able to lower its nice value again (see
+ * RLIMIT_NICE); if setting it fails, the backend backs off instead.
+ */
+static void
+BackoffApplyNice(int weight)
+{
+	static int	baseNice = 0;
+	static bool baseNiceKnown = false;
+	BackoffBackendLocalEntry *le = myBackoffLocalEntry();
+	int			niceOffset;
+
+	Assert(weight > 0);
+
+	if (le->niceApplied && le->niceWeight == weight)
+		return;
+
+	le->niceWeight = weight;
+	le->niceApplied = false;
+
+	if (!baseNiceKnown)
+	{
+		errno = 0;
+		baseNice = getpriority(PRIO_PROCESS, 0);
+		if (errno != 0)
+			return;
+		baseNiceKnown = true;
+	}
+
+	niceOffset = (int) rint(log(NICE_REFERENCE_WEIGHT / weight) / log(NICE_WEIGHT_RATIO));
+	niceOffset = Max(niceOffset, 0);
+	niceOffset = Min(niceOffset, 19);
+
+	if (setpriority(PRIO_PROCESS, 0, baseNice + niceOffset) < 0)
+	{
+		if (gp_debug_resqueue_priority)
+			elog(LOG, "could not set nice value %d for weight %d, backing off instead: %m",
+				 baseNice + niceOffset, weight);
+		return;
+	}
+
+	le->niceApplied = true;
+}
+
 typedef struct PriorityMapping
 {
 	const char *priorityVal;
@@ -0,0 +1,621 @@
+/*-------------------------------------------------------------------------
+ *
+ * globaldeadlock.c
+ *	  Global deadlock detector process.
+ *
+ * Each segment runs the local deadlock detector over its own lock table,
+ * but a deadlock can span several segments: one session waits for another
+ * on segment 0, while that one waits for the first on segment 1. Greenplum
+ * used to rule these out by taking ExclusiveLock on the master for every
+ * UPDATE and DELETE, which serializes all writers to a table.
+ *
+ * When gp_enable_global_deadlock_detector is on, heap tables keep
+ * RowExclusiveLock instead (see CdbTryOpenRelation()), and this process
+ * breaks the deadlocks. Every gp_global_deadlock_detector_period seconds it
+ * connects to the master like any client and reads pg_locks, which the
+ * master gathers from all segments. It builds the graph of sessions waiting
+ * for each other, from every lock a session waits for to the other sessions
+ * holding a conflicting mode of the same lock on the same segment. A cycle
+ * in that graph is a deadlock. To keep a transient picture from costing a
+ * session, the cycle must still be there at a second check a moment later;
+ * then the youngest session in it, the one with the highest session id, has
+ * its statement cancelled.
+ *
+ * Portions Copyright (c) 2012-Present Pivotal Software, Inc.
+ *
+ *
+ * IDENTIFICATION
+ *	    src/backend/postmaster/globaldeadlock.c
+ *
+ *-------------------------------------------------------------------------
+ */
+#include "postgres.h"
+
+#include <unistd.h>
+#include <signal.h>
+
+#include "access/hash.h"
+#include "cdb/cdbvars.h"
+#include "gp-libpq-fe.h"
+#include "lib/stringinfo.h"
+#include "libpq/pqsignal.h"
+#include "miscadmin.h"
+#include "postmaster/fork_process.h"
+#include "postmaster/globaldeadlock.h"
+#include "postmaster/postmaster.h"
+#include "storage/ipc.h"
+#include "storage/lock.h"
+#include "storage/pmsignal.h"			/* PostmasterIsAlive */
+#include "tcop/tcopprot.h"				/* quickdie() */
+#include "utils/guc.h"
+#include "utils/hsearch.h"
+#include "utils/memutils.h"
+#include "utils/ps_status.h"
+
+/*
+ * The locks of all sessions but our own. The first columns identify the
+ * locked object, as in the pg_locks view.
+ */
+#define GDD_LOCKS_QUERY \
+	"SELECT locktype, database, relation, page, tuple, virtualxid, " \
+	"transactionid, classid, objid, objsubid, gp_segment_id, " \
+	"mode, granted, mppsessionid " \
+	"FROM pg_locks " \
+	"WHERE mppsessionid <> 0 " \
+	"AND mppsessionid <> current_setting('gp_session_id')::int4"
+
+#define GDD_NUM_KEY_COLUMNS		11
+#define GDD_MODE_COLUMN			11
+#define GDD_GRANTED_COLUMN		12
+#define GDD_SESSION_COLUMN		13
+
+/* Seconds to wait before the check that confirms a deadlock */
+#define GDD_CONFIRM_DELAY		1
+
+typedef struct GddLock
+{
+	char	   *key;			/* identifies the locked object */
+	uint32		keyhash;		/* hash of key */
+	LOCKMODE	mode;			/* NoLock if the mode is unknown */
+	bool		granted;
+	int			session;		/* index into the session array */
+	int			nextHolder;		/* next granted lock with the same keyhash */
+} GddLock;
+
+/* Granted locks by the hash of their key */
+typedef struct GddHolderEntry
+{
+	uint32		keyhash;		/* hash key */
+	int			firstHolder;	/* index of a lock; chained by nextHolder */
+} GddHolderEntry;
+
+/* Graph indexes of the session ids */
+typedef struct GddSessionEntry
+{
+	int			sessionId;		/* hash key */
+	int			index;
+} GddSessionEntry;
+
+/*
+ * The edges from session u are edgeTo[edgeStart[u] .. edgeStart[u + 1] - 1].
+ */
+typedef struct GddGraph
+{
+	int		   *sessions;		/* session ids */
+	int			nsessions;
+	int		   *edgeStart;
+	int		   *edgeTo;			/* session waited for */
+} GddGraph;
+
+static volatile bool shutdown_requested = false;
+static volatile sig_atomic_t got_SIGHUP = false;
+
+static MemoryContext gddContext = NULL;
+static PGconn *gddConn = NULL;
+
+/* Victim found by the previous check, to be confirmed by the next one */
+static int	suspectSession = 0;
+
+NON_EXEC_STATIC void GlobalDeadlockDetectorMain(int argc, char *argv[]);
+static void GddLoop(void);
+static void GddCheck(void);
+static bool GddConnect(void);
+static void GddDisconnect(void);
+static int	GddFindVictim(GddLock *locks, int nlocks, StringInfo cycle);
+static void GddCancelSession(int sessionId);
+
+/*
+ * Main entry point for the global deadlock detector process.
+ */
+int
+globaldeadlock_start(void)
+{
+	pid_t		gddPid;
+
+	switch ((gddPid = fork_process()))
+	{
+		case -1:
+			ereport(LOG,
+					(errmsg("could not fork global deadlock detector process: %m")));
+			return 0;
+
+		case 0:
+			/* in postmaster child ... */
+			/* Close the postmaster's sockets */
+			ClosePostmasterPorts(false);
+
+			GlobalDeadlockDetectorMain(0, NULL);
+			break;
+
+		default:
+			return (int) gddPid;
+	}
+
+	/* shouldn't get here */
+	Assert(false);
+	return 0;
+}
+
+static void
+GddRequestShutdown(SIGNAL_ARGS)
+{
+	shutdown_requested = true;
+}
+
+static void
+GddSigHupHandler(SIGNAL_ARGS)
+{
+	got_SIGHUP = true;
+}
+
+/*
+ * The detector is only a client of the master, so it doesn't attach to
+ * shared memory.
+ */
+NON_EXEC_STATIC void
+GlobalDeadlockDetectorMain(int argc, char *argv[])
+{
+	sigjmp_buf	local_sigjmp_buf;
+
+	IsUnderPostmaster = true;
+
+	/* Stay away from PMChildSlot */
+	MyPMChildSlot = -1;
+
+	/* reset MyProcPid */
+	MyProcPid = getpid();
+
+	/* Lose the postmaster's on-exit routines */
+	on_exit_reset();
+
+	/* Identify myself via ps */
+	init_ps_display("global deadlock detector process", "", "", "");
+
+	pqsignal(SIGHUP, GddSigHupHandler);
+	pqsignal(SIGINT, SIG_IGN);
+	pqsignal(SIGALRM, SIG_IGN);
+	pqsignal(SIGPIPE, SIG_IGN);
+	pqsignal(SIGUSR1, SIG_IGN);
+
+	pqsignal(SIGTERM, GddRequestShutdown);
+	pqsignal(SIGQUIT, quickdie);
+	pqsignal(SIGUSR2, GddRequestShutdown);
+
+	pqsignal(SIGFPE, FloatExceptionHandler);
+	pqsignal(SIGCHLD, SIG_DFL);
+
+	/*
+	 * If an exception is encountered, report it and go away; the postmaster
+	 * starts a new detector.
+	 */
+	if (sigsetjmp(local_sigjmp_buf, 1) != 0)
+	{
+		HOLD_INTERRUPTS();
+		EmitErrorReport();
+		GddDisconnect();
+		proc_exit(1);
+	}
+
+	/* We can now handle ereport(ERROR) */
+	PG_exception_stack = &local_sigjmp_buf;
+
+	PG_SETMASK(&UnBlockSig);
+
+	gddContext = AllocSetContextCreate(TopMemoryContext,
+									   "GlobalDeadlockDetector",
+									   ALLOCSET_DEFAULT_MINSIZE,
+									   ALLOCSET_DEFAULT_INITSIZE,
+									   ALLOCSET_DEFAULT_MAXSIZE);
+
+	GddLoop();
+
+	GddDisconnect();
+	proc_exit(0);
+}
+
+static void
+GddLoop(void)
+{
+	for (;;)
+	{
+		MemoryContext oldcontext;
+		int			sleepSecs;
+		int			i;
+
+		if (shutdown_requested)
+			break;
+
+		/* no need to live on if postmaster has died */
+		if (!PostmasterIsAlive(true))
+			exit(1);
+
+		if (got_SIGHUP)
+		{
+			got_SIGHUP = false;
+			ProcessConfigFile(PGC_SIGHUP);
+		}
+
+		MemoryContextReset(gddContext);
+		oldcontext = MemoryContextSwitchTo(gddContext);
+		GddCheck();
+		MemoryContextSwitchTo(oldcontext);
+
+		/* Sleep a while, in steps so that we notice signals */
+		sleepSecs = (suspectSession != 0) ? GDD_CONFIRM_DELAY :
+			gp_global_deadlock_detector_period;
+		for (i = 0; i < sleepSecs && !shutdown_requested && !got_SIGHUP; i++)
+			pg_usleep(1000000L);
+	}
+}
+
+/*
+ * Read the locks of the cluster, and cancel a session if they confirm a
+ * deadlock.
+ */
+static void
+GddCheck(void)
+{
+	PGresult   *res;
+	GddLock    *locks;
+	int			nlocks;
+	int			victim;
+	int			i;
+	StringInfoData cycle;
+
+	if (!GddConnect())
+		return;
+
+	res = PQexec(gddConn, GDD_LOCKS_QUERY);
+	if (PQresultStatus(res) != PGRES_TUPLES_OK)
+	{
+		elog(LOG, "global deadlock detector could not read pg_locks: %s",
+			 PQerrorMessage(gddConn));
+		PQclear(res);
+		GddDisconnect();
+		return;
+	}
+
+	nlocks = PQntuples(res);
+	locks = palloc(Max(nlocks, 1) * sizeof(GddLock));
+	for (i = 0; i < nlocks; i++)
+	{
+		StringInfoData key;
+		int			col;
+
+		initStringInfo(&key);
+		for (col = 0; col < GDD_NUM_KEY_COLUMNS; col++)
+		{
+			if (PQgetisnull(res, i, col))
+				appendStringInfoString(&key, "\\N|");
+			else
+				appendStringInfo(&key, "%s|", PQgetvalue(res, i, col));
+		}
+
+		locks[i].key = key.data;
+		locks[i].keyhash = DatumGetUInt32(hash_any((unsigned char *) key.data,
+												   key.len));
+		locks[i].mode = GetLockmodeByName(PQgetvalue(res, i, GDD_MODE_COLUMN));
+		locks[i].granted = (strcmp(PQgetvalue(res, i, GDD_GRANTED_COLUMN), "t") == 0);
+		locks[i].session = atoi(PQgetvalue(res, i, GDD_SESSION_COLUMN));
+	}
+	PQclear(res);
+
+	initStringInfo(&cycle);
+	victim = GddFindVictim(locks, nlocks, &cycle);
+
+	if (victim == 0)
+	{
+		suspectSession = 0;
+		return;
+	}
+
+	/* A deadlock found for the first time gets confirmed first */
+	if (victim != suspectSession)
+	{
+		suspectSession = victim;
+		return;
+	}
+
+	suspectSession = 0;
+
+	ereport(LOG,
+			(errmsg("global deadlock detected, cancelling session %d", victim),
+			 errdetail("Sessions waiting for each other: %s.", cycle.data)));
+
+	GddCancelSession(victim);
+}
+
+static HTAB *
+GddCreateHash(const char *name, Size keysize, Size entrysize, long nelem)
+{
+	HASHCTL		ctl;
+
+	MemSet(&ctl, 0, sizeof(ctl));
+	ctl.keysize = keysize;
+	ctl.entrysize = entrysize;
+	ctl.hash = tag_hash;
+	ctl.hcxt = CurrentMemoryContext;
+
+	return hash_create(name, Max(nelem, 16), &ctl,
+					   HASH_ELEM | HASH_FUNCTION | HASH_CONTEXT);
+}
+
+static int
+GddSessionIndex(GddGraph *graph, HTAB *sessionIndex, int sessionId)
+{
+	GddSessionEntry *entry;
+	bool		found;
+
+	entry = hash_search(sessionIndex, &sessionId, HASH_ENTER, &found);
+	if (!found)
+	{
+		entry->index = graph->nsessions;
+		graph->sessions[graph->nsessions++] = sessionId;
+	}
+	return entry->index;
+}
+
+/*
+ * Does waiting lock w wait for granted lock h?
+ */
+static bool
+GddLockWaitsFor(GddLock *w, GddLock *h)
+{
+	if (h->session == w->session || strcmp(h->key, w->key) != 0)
+		return false;
+
+	/* Modes we don't know are taken to conflict */
+	return w->mode == NoLock || h->mode == NoLock ||
+		LockModesConflict(w->mode, h->mode);
+}
+
+/*
+ * Depth-first search for a cycle through session u. Returns the index of a
+ * session on the cycle, or -1; the cycle is then found by following parent
+ * from that session.
+ */
+static int
+GddSearchCycle(GddGraph *graph, int u, char *color, int *parent)
+{
+	int			e;
+
+	color[u] = 1;
+
+	for (e = graph->edgeStart[u]; e < graph->edgeStart[u + 1]; e++)
+	{
+		int			v = graph->edgeTo[e];
+		int			found;
+
+		if (color[v] == 1)
+		{
+			/* back edge: u -> v closes the cycle v -> ... -> u */
+			parent[v] = u;
+			return v;
+		}
+		if (color[v] == 0)
+		{
+			parent[v] = u;
+			found = GddSearchCycle(graph, v, color, parent);
+			if (found >= 0)
+				return found;
+		}
+	}
+
+	color[u] = 2;
+	return -1;
+}
+
+/*
+ * Build the wait-for graph of the sessions, and look for a cycle in it.
+ * Returns the session to cancel to break it, or 0 if there is no cycle;
+ * the sessions of the cycle are described in *cycle.
+ */
+static int
+GddFindVictim(GddLock *locks, int nlocks, StringInfo cycle)
+{
+	GddGraph	graph;
+	HTAB	   *sessionIndex;
+	HTAB	   *holders;
+	char	   *color;
+	int		   *parent;
+	int		   *fill;
+	bool		waiting = false;
+	int			w;
+	int			h;
+	int			u;
+
+	graph.sessions = palloc(Max(nlocks, 1) * sizeof(int));
+	graph.nsessions = 0;
+
+	/* Turn the session ids into graph indexes */
+	sessionIndex = GddCreateHash("GDD sessions", sizeof(int),
+								 sizeof(GddSessionEntry), nlocks);
+	for (w = 0; w < nlocks; w++)
+	{
+		locks[w].session = GddSessionIndex(&graph, sessionIndex,
+										   locks[w].session);
+		if (!locks[w].granted)
+			waiting = true;
+	}
+	if (!waiting)
+		return 0;
+
+	/* Chain the granted locks on each object together */
+	holders = GddCreateHash("GDD lock holders", sizeof(uint32),
+							sizeof(GddHolderEntry), nlocks);
+	for (h = 0; h < nlocks; h++)
+	{
+		GddHolderEntry *entry;
+		bool		found;
+
+		if (!locks[h].granted)
+			continue;
+
+		entry = hash_search(holders, &locks[h].keyhash, HASH_ENTER, &found);
+		locks[h].nextHolder = found ? entry->firstHolder : -1;
+		entry->firstHolder = h;
+	}
+
+	/*
+	 * Two passes over the waiting locks: count the edges from each session,
+	 * then fill them in.
+	 */
+	graph.edgeStart = palloc0((graph.nsessions + 1) * sizeof(int));
+	fill = palloc0(graph.nsessions * sizeof(int));
+	for (w = 0; w < nlocks; w++)
+	{
+		GddHolderEntry *entry;
+
+		if (locks[w].granted)
+			continue;
+
+		entry = hash_search(holders, &locks[w].keyhash, HASH_FIND, NULL);
+		for (h = entry ? entry->firstHolder : -1; h >= 0; h = locks[h].nextHolder)
+		{
+			if (GddLockWaitsFor(&locks[w], &locks[h]))
+				graph.edgeStart[locks[w].session + 1]++;
+		}
+	}
+	for (u = 0; u < graph.nsessions; u++)
+		graph.edgeStart[u + 1] += graph.edgeStart[u];
+
+	graph.edgeTo = palloc(Max(graph.edgeStart[graph.nsessions], 1) * sizeof(int));
+	for (w = 0; w < nlocks; w++)
+	{
+		GddHolderEntry *entry;
+
+		if (locks[w].granted)
+			continue;
+
+		entry = hash_search(holders, &locks[w].keyhash, HASH_FIND, NULL);
+		for (h = entry ? entry->firstHolder : -1; h >= 0; h = locks[h].nextHolder)
+		{
+			if (GddLockWaitsFor(&locks[w], &locks[h]))
+			{
+				u = locks[w].session;
+				graph.edgeTo[graph.edgeStart[u] + fill[u]++] = locks[h].session;
+			}
+		}
+	}
+
+	color = palloc0(graph.nsessions * sizeof(char));
+	parent = palloc(graph.nsessions * sizeof(int));
+
+	for (u = 0; u < graph.nsessions; u++)
+	{
+		int			start;
+		int			v;
+		int			victim;
+
+		if (color[u] != 0)
+			continue;
+
+		start = GddSearchCycle(&graph, u, color, parent);
+		if (start < 0)
+			continue;
+
+		/* Walk the cycle backwards, picking the youngest session */
+		victim = graph.sessions[start];
+		appendStringInfo(cycle, "con%d", graph.sessions[start]);
+		for (v = parent[start]; v != start; v = parent[v])
+		{
+			victim = Max(victim, graph.sessions[v]);
+			appendStringInfo(cycle, " <- con%d", graph.sessions[v]);
+		}
+		appendStringInfo(cycle, " <- con%d", graph.sessions[start]);
+
+		return victim;
+	}
+
+	return 0;
+}
+
+static void
+GddCancelSession(int sessionId)
+{
+	char		query[128];
+	PGresult   *res;
+
+	snprintf(query, sizeof(query),
+			 "SELECT pg_cancel_backend(procpid) FROM pg_stat_activity "
+			 "WHERE sess_id = %d", sessionId);
+
+	res = PQexec(gddConn, query);
+	if (PQresultStatus(res) != PGRES_TUPLES_OK)
+		elog(LOG, "global deadlock detector could not cancel session %d: %s",
+			 sessionId, PQerrorMessage(gddConn));
+	PQclear(res);
+}
+
+/*
+ * Connect to the master as a client, unless we already are.
+ */
+static bool
+GddConnect(void)
+{
+	char		portbuf[11];
+	const char *keys[4];
+	const char *vals[4];
+	int			n = 0;
+
+	if (gddConn != NULL && PQstatus(gddConn) == CONNECTION_OK)
+		return true;
+
+	GddDisconnect();
+
+	snprintf(portbuf, sizeof(portbuf), "%d", PostPortNumber);
+
+	keys[n] = "port";
+	vals[n++] = portbuf;
+	keys[n] = "dbname";
+	vals[n++] = "postgres";
+	if (UnixSocketDir != NULL && UnixSocketDir[0] != '\0')
+	{
+		keys[n] = "host";
+		vals[n++] = UnixSocketDir;
+	}
+	keys[n] = NULL;
+	vals[n] = NULL;
+
+	gddConn = PQconnectdbParams(keys, vals, false);
+	if (PQstatus(gddConn) != CONNECTION_OK)
+	{
+		/* The master may not be accepting connections yet */
+		elog(DEBUG1, "global deadlock detector could not connect: %s",
+			 PQerrorMessage(gddConn));
+		GddDisconnect();
+		return false;
+	}
+
+	return true;
+}
+
+static void
+GddDisconnect(void)
+{
+	if (gddConn != NULL)
+	{
+		PQfinish(gddConn);
+		gddConn = NULL;
+	}
+}
@@ -1667,6 +1667,43 @@ pgstat_update_heap_dead_tuples(Relation rel, int delta)
 }
 
 
+/*
+ * pgstat_count_dispatched_changes - count the tuples a dispatched command
+ * changed
+ *
+ * On the QD, the tuples of a distributed table are changed by the QEs, and
+ * the heap and append-only code count them in the QEs' statistics only.
+ * Count them here too, in bulk, so that the QD knows how much each table
+ * changed since it was last analyzed.
+ */
+void
+pgstat_count_dispatched_changes(Relation rel, PgStat_Counter inserted,
+								PgStat_Counter updated, PgStat_Counter deleted)
+{
+	PgStat_TableStatus *pgstat_info;
+	int			nest_level = GetCurrentTransactionNestLevel();
+
+	pgstat_initstats(rel);
+	pgstat_info = rel->pgstat_info;
+
+	if (!pgstat_track_counts || pgstat_info == NULL)
+		return;
+
+	pgstat_info->t_counts.t_tuples_inserted += inserted;
+	pgstat_info->t_counts.t_tuples_updated += updated;
+	pgstat_info->t_counts.t_tuples_deleted += deleted;
+
+	/* We have to log the transactional effect at the proper level */
+	if (pgstat_info->trans == NULL ||
+		pgstat_info->trans->nest_level != nest_level)
+		add_tabstat_xact_level(pgstat_info, nest_level);
+
+	/* An UPDATE both inserts a new tuple and deletes the old */
+	pgstat_info->trans->tuples_inserted += inserted + updated;
+	pgstat_info->trans->tuples_deleted += deleted + updated;
+}
+
+
 /* ----------
  * AtEOXact_PgStat
  *
@@ -2097,6 +2134,9 @@ pgstat_fetch_global(void)
 
 static PgBackendStatus *BackendStatusArray = NULL;
 static PgBackendStatus *MyBEEntry = NULL;
+
+static uint32 local_my_wait_event;
+volatile uint32 *my_wait_event = &local_my_wait_event;
 static char *BackendAppnameBuffer = NULL;
 static char *BackendActivityBuffer = NULL;
 
@@ -2483,6 +2523,65 @@ pgstat_report_waiting(char waiting)
 	beentry->st_waiting = waiting;
 }
 
+/* ----------
+ * pgstat_set_wait_event_storage() -
+ *
+ *	Make pgstat_report_wait_start() report into MyProc, once we have one.
+ * ----------
+ */
+void
+pgstat_set_wait_event_storage(uint32 *wait_event)
+{
+	my_wait_event = wait_event;
+}
+
+/* ----------
+ * pgstat_reset_wait_event_storage() -
+ *
+ *	Stop reporting into MyProc, when it's no longer ours.
+ * ----------
+ */
+void
+pgstat_reset_wait_event_storage(void)
+{
+	my_wait_event = &local_my_wait_event;
+}
+
+/* ----------
+ * pgstat_get_wait_event() -
+ *
+ *	Return the name of a wait event, as shown by gp_wait_event_samples().
+ * ----------
+ */
+const char *
+pgstat_get_wait_event(uint32 wait_event)
+{
+	switch ((WaitEvent) wait_event)
+	{
+		case WAIT_EVENT_NONE:
+			return "none";
+		case WAIT_EVENT_LOCK:
+			return "lock";
+		case WAIT_EVENT_RESQUEUE:
+			return "resource queue";
+		case WAIT_EVENT_RESGROUP:
+			return "resource group";
+		case WAIT_EVENT_INTERCONNECT_RECV:
+			return "interconnect receive";
+		case WAIT_EVENT_INTERCONNECT_SEND:
+			return "interconnect send";
+		case WAIT_EVENT_SHAREINPUT:
+			return "shareinput";
+		case WAIT_EVENT_WORKFILE_READ:
+			return "workfile read";
+		case WAIT_EVENT_WORKFILE_WRITE:
+			return "workfile write";
+		case WAIT_EVENT_DISTRIBUTEDLOG_IO:
+			return "distributedlog io";
+	}
+	return "unknown";
+}
+
 /* ----------
  * pgstat_read_current_status() -
  *
@@ -3770,6 +3869,10 @@ pgstat_recv_tabstat(PgStat_MsgTabstat *msg, int len)
 			tabentry->tuples_hot_updated = tabmsg[i].t_counts.t_tuples_hot_updated;
 			tabentry->n_live_tuples = tabmsg[i].t_counts.t_new_live_tuples;
 			tabentry->n_dead_tuples = tabmsg[i].t_counts.t_new_dead_tuples;
+			tabentry->changes_since_analyze =
+				tabmsg[i].t_counts.t_tuples_inserted +
+				tabmsg[i].t_counts.t_tuples_updated +
+				tabmsg[i].t_counts.t_tuples_deleted;
 			tabentry->blocks_fetched = tabmsg[i].t_counts.t_blocks_fetched;
 			tabentry->blocks_hit = tabmsg[i].t_counts.t_blocks_hit;
 
@@ -3793,6 +3896,10 @@ pgstat_recv_tabstat(PgStat_MsgTabstat *msg, int len)
 			tabentry->tuples_hot_updated += tabmsg[i].t_counts.t_tuples_hot_updated;
 			tabentry->n_live_tuples += tabmsg[i].t_counts.t_new_live_tuples;
 			tabentry->n_dead_tuples += tabmsg[i].t_counts.t_new_dead_tuples;
+			tabentry->changes_since_analyze +=
+				tabmsg[i].t_counts.t_tuples_inserted +
+				tabmsg[i].t_counts.t_tuples_updated +
+				tabmsg[i].t_counts.t_tuples_deleted;
 			tabentry->blocks_fetched += tabmsg[i].t_counts.t_blocks_fetched;
 			tabentry->blocks_hit += tabmsg[i].t_counts.t_blocks_hit;
 		}
@@ -4058,6 +4165,7 @@ pgstat_recv_analyze(PgStat_MsgAnalyze *msg, int len)
 	tabentry->n_live_tuples = msg->m_live_tuples;
 	tabentry->n_dead_tuples = msg->m_dead_tuples;
 	tabentry->last_anl_tuples = msg->m_live_tuples + msg->m_dead_tuples;
+	tabentry->changes_since_analyze = 0;
 }
 
 
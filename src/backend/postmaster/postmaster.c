@@ -122,6 +122,7 @@
 #include "postmaster/postmaster.h"
 #include "postmaster/seqserver.h"
 #include "postmaster/fts.h"
+#include "postmaster/globaldeadlock.h"
 #include "postmaster/perfmon.h"
 #include "postmaster/primary_mirror_mode.h"
 #include "postmaster/syslogger.h"
@@ -144,6 +145,7 @@
 #include "utils/resscheduler.h"
 
 #include "cdb/cdbgang.h"                /* cdbgang_parse_gpqeid_params */
+#include "cdb/cdbhostarena.h"
 #include "cdb/cdbtm.h"
 #include "cdb/cdbvars.h"
 
@@ -192,6 +194,7 @@ typedef enum pmsub_type
 	PerfmonProc,
 	BackoffProc,
 	PerfmonSegmentInfoProc,
+	GlobalDeadlockDetectorProc,
 	MaxPMSubType
 } PMSubType;
 
@@ -470,6 +473,9 @@ static PMSubProc PMSubProcList[MaxPMSubType] =
 	{0, PerfmonSegmentInfoProc,
 	(PMSubStartCallback*)&perfmon_segmentinfo_start,
 	"stats sender process", PMSUBPROC_FLAG_QD_AND_QE, true},
+	{0, GlobalDeadlockDetectorProc,
+	(PMSubStartCallback*)&globaldeadlock_start,
+	"global deadlock detector process", PMSUBPROC_FLAG_QD, false},
 };
 
 bool		ClientAuthInProgress = false;		/* T during new-client
@@ -2130,6 +2136,9 @@ ServiceStartable(PMSubProc *subProc)
 	if ((subProc->procType == PerfmonProc || subProc->procType == PerfmonSegmentInfoProc)
 	    && !gp_enable_gpperfmon)
 		result = 0;
+	else if (subProc->procType == GlobalDeadlockDetectorProc &&
+			 !gp_enable_global_deadlock_detector)
+		result = 0;
 	else
 		result = ((subProc->flags & flagNeeded) != 0);
 
@@ -3963,6 +3972,9 @@ reset_shared(int port, bool isReset)
 	 */
 	CreateSharedMemoryAndSemaphores(false, port);
 
+	/* Host arenas left behind by backends that are gone, too */
+	HostArenaRemoveStale();
+
 	if (isReset)
 	{
 		primaryMirrorHandlePostmasterReset();
@@ -160,6 +160,7 @@ void
 sendSequenceRequest(int     sockfd, 
 					Relation seqrel,
                     int     session_id,
+					int64   nvalues,
 					int64  *plast, 
                     int64  *pcached,
 			 		int64  *pincrement,
@@ -198,6 +199,7 @@ sendSequenceRequest(int     sockfd,
 	request.seq_oid = htonl(seq_oid);
 	request.isTemp = htonl(isTemp);
     request.session_id = htonl(session_id);
+	request.nvalues = htonl((uint32_t) Min(nvalues, PG_UINT32_MAX));
 	request.endCookie = SEQ_SERVER_REQUEST_END;
 
 	/*
@@ -628,6 +630,7 @@ SeqServerLoop(void)
 				 * more useful info as to why this happened.
 				 */
 				elog(LOG, "seqserver: error during accept() call (error:%d)", errno);
+				continue;
 			}
 			
 			/* make socket non-blocking BEFORE we connect. */
@@ -801,14 +804,16 @@ processSequenceRequest(int sockfd )
 	nextValRequest.seq_oid      = ntohl(nextValRequest.seq_oid);
 	nextValRequest.isTemp       = ntohl(nextValRequest.isTemp);
     nextValRequest.session_id   = ntohl(nextValRequest.session_id);
+	nextValRequest.nvalues      = ntohl(nextValRequest.nvalues);
 	
 	elog(DEBUG5, "Received nextval request for dbid: %ld tablespaceid: %ld seqoid: "
-				  "%ld isTemp: %s session_id: %ld",
+				  "%ld isTemp: %s session_id: %ld nvalues: %ld",
 				  (long int)nextValRequest.dbid,
 				  (long int)nextValRequest.tablespaceid,
 				  (long int)nextValRequest.seq_oid,
 				  nextValRequest.isTemp ? "true" : "false",
-				  (long)nextValRequest.session_id);
+				  (long)nextValRequest.session_id,
+				  (long)nextValRequest.nvalues);
 
 	/*
 	 * Process request.
@@ -822,6 +827,7 @@ processSequenceRequest(int sockfd )
 									nextValRequest.dbid,
 									nextValRequest.seq_oid,
 									nextValRequest.isTemp,
+									Max(nextValRequest.nvalues, 1),
 									&plast,
 									&pcached,
 									&pincrement,
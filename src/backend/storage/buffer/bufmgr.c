@@ -75,6 +75,12 @@ bool		zero_damaged_pages = false;
 int			bgwriter_lru_maxpages = 100;
 double		bgwriter_lru_multiplier = 2.0;
 
+/*
+ * How many pages a scan keeps requested from the kernel ahead of the page
+ * it is reading, see PrefetchBuffer().  0 disables prefetching.
+ */
+int			effective_io_concurrency = 0;
+
 long		NDirectFileRead;	/* some I/O's are direct file access. bypass
 								 * bufmgr */
 long		NDirectFileWrite;	/* e.g., I/O in psort and hashjoin. */
@@ -173,6 +179,45 @@ static inline bool ConditionalAcquireContentLock( volatile BufferDesc *buf, LWLo
     else return false;
 }
 
+/*
+ * PrefetchBuffer -- initiate asynchronous read of a block of a relation
+ *
+ * This is named by analogy to ReadBuffer but doesn't actually allocate a
+ * buffer.  Instead it tries to ensure that a future ReadBuffer for the given
+ * block will not be delayed by the I/O.  Prefetching is optional, so a block
+ * that is already in shared buffers, or a temp relation, is left alone.
+ */
+void
+PrefetchBuffer(Relation reln, BlockNumber blockNum)
+{
+	BufferTag	newTag;
+	uint32		newHash;
+	LWLockId	newPartitionLock;
+	int			buf_id;
+
+	Assert(RelationIsValid(reln));
+	Assert(BlockNumberIsValid(blockNum));
+
+	if (reln->rd_istemp)
+		return;
+
+	/* Open it at the smgr level if not already done */
+	RelationOpenSmgr(reln);
+
+	INIT_BUFFERTAG(newTag, reln, blockNum);
+	newHash = BufTableHashCode(&newTag);
+	newPartitionLock = BufMappingPartitionLock(newHash);
+
+	/* see if the block is in the buffer pool already */
+	LWLockAcquire(newPartitionLock, LW_SHARED);
+	buf_id = BufTableLookup(&newTag, newHash);
+	LWLockRelease(newPartitionLock);
+
+	/* If not in buffers, initiate prefetch */
+	if (buf_id < 0)
+		smgrprefetch(reln->rd_smgr, blockNum);
+}
+
 /*
  * ReadBuffer -- a shorthand for ReadBuffer_Ex 
  */
@@ -373,6 +373,32 @@ GetAccessStrategy(BufferAccessStrategyType btype)
 	BufferAccessStrategy strategy;
 	int			ring_size;
 
+	/* if someone asks for NORMAL, just give 'em a "default" object */
+	if (btype == BAS_NORMAL)
+		return NULL;
+
+	ring_size = GetAccessStrategyRingSize(btype);
+
+	/* Allocate the object and initialize all elements to zeroes */
+	strategy = (BufferAccessStrategy)
+		palloc0(offsetof(BufferAccessStrategyData, buffers) +
+				ring_size * sizeof(Buffer));
+
+	/* Set fields that don't start out zero */
+	strategy->btype = btype;
+	strategy->ring_size = ring_size;
+
+	return strategy;
+}
+
+/*
+ * GetAccessStrategyRingSize -- number of buffers in the ring of a strategy
+ */
+int
+GetAccessStrategyRingSize(BufferAccessStrategyType btype)
+{
+	int			ring_size;
+
 	/*
 	 * Select ring size to use.  See buffer/README for rationales. (Currently
 	 * all cases are the same size, but keep this code structure for
@@ -384,8 +410,7 @@ GetAccessStrategy(BufferAccessStrategyType btype)
 	switch (btype)
 	{
 		case BAS_NORMAL:
-			/* if someone asks for NORMAL, just give 'em a "default" object */
-			return NULL;
+			return 0;
 
 		case BAS_BULKREAD:
 			ring_size = 256 * 1024 / BLCKSZ;
@@ -397,22 +422,11 @@ GetAccessStrategy(BufferAccessStrategyType btype)
 		default:
 			elog(ERROR, "unrecognized buffer access strategy: %d",
 				 (int) btype);
-			return NULL;		/* keep compiler quiet */
+			return 0;			/* keep compiler quiet */
 	}
 
 	/* Make sure ring isn't an undue fraction of shared buffers */
-	ring_size = Min(NBuffers / 8, ring_size);
-
-	/* Allocate the object and initialize all elements to zeroes */
-	strategy = (BufferAccessStrategy)
-		palloc0(offsetof(BufferAccessStrategyData, buffers) +
-				ring_size * sizeof(Buffer));
-
-	/* Set fields that don't start out zero */
-	strategy->btype = btype;
-	strategy->ring_size = ring_size;
-
-	return strategy;
+	return Min(NBuffers / 8, ring_size);
 }
 
 /*
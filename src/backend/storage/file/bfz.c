@@ -33,6 +33,9 @@ static const struct{
 {
     {{"none", "false", "no", "off", "0", 0}, bfz_nothing_init},
     {{"zlib", 0}, bfz_zlib_init},
+#ifdef HAVE_LIBLZ4
+    {{"lz4", 0}, bfz_lz4_init},
+#endif
     {{0}}
 };
 
@@ -313,10 +316,11 @@ bfz_create_internal(const char *fileName, bool open_existing,
 	bfz_handle->compression_index = compress;
 	bfz_handle->del_on_close = delOnClose;
 
-	compression_algorithms[compress].init(bfz_handle);
-
+	/* Set before init, a compressor may checksum its own blocks instead */
 	bfz_handle->has_checksum = gp_workfile_checksumming;
 
+	compression_algorithms[compress].init(bfz_handle);
+
 	bfz_handle->numBlocks = bfz_handle->blockNo = bfz_handle->chosenBlockNo = 0;
 	
 	fs = bfz_handle->freeable_stuff;
@@ -532,3 +536,56 @@ bfz_read_ex(bfz_t * thiz, char *buffer, int size)
 	}
 	return orig_size - size;
 }
+
+/*
+ * bfz_io_size
+ *	The size of the I/O unit that compression algorithms which stage their
+ *	reads and writes should use, or 0 if gp_workfile_io_size leaves that to
+ *	the algorithm.
+ */
+int
+bfz_io_size(void)
+{
+	if (gp_workfile_io_size <= 0)
+		return 0;
+
+	return Max(gp_workfile_io_size * 1024, BFZ_BUFFER_SIZE);
+}
+
+/*
+ * bfz_write_io_unit
+ *	Write out one staged I/O unit.
+ *
+ *	With gp_workfile_io_size set, the kernel is also asked to start writing
+ *	the unit back to disk, without waiting for it. The disk then works on
+ *	a large spill while the executor produces the rest of it, instead of
+ *	the dirty pages piling up until the kernel stalls the backend on them.
+ */
+void
+bfz_write_io_unit(bfz_t *thiz, const char *buffer, int size)
+{
+	int64		offset = 0;
+	int			left = size;
+
+	/* A zero amount would make the writeback cover the rest of the file */
+	if (size == 0)
+		return;
+
+	if (gp_workfile_io_size > 0)
+		offset = FileSeek(thiz->file, 0, SEEK_CUR);
+
+	while (left > 0)
+	{
+		int			n = FileWrite(thiz->file, (char *) buffer, left);
+
+		if (n < 0)
+			ereport(ERROR,
+					(errcode_for_file_access(),
+					 errmsg("could not write to temporary file: %m")));
+		buffer += n;
+		left -= n;
+	}
+
+	if (gp_workfile_io_size > 0 && offset >= 0)
+		(void) FileWriteback(thiz->file, offset, size, false);
+}
@@ -0,0 +1,290 @@
+/* compress_lz4.c */
+#include "postgres.h"
+
+#ifdef HAVE_LIBLZ4
+
+#include <lz4.h>
+
+#include "port/pg_crc32c.h"
+#include "storage/bfz.h"
+#include "storage/fd.h"
+
+/*
+ * This file implements bfz compression algorithm "lz4".
+ *
+ * Unlike zlib, which runs one deflate stream over the whole file, every
+ * buffer handed to write_ex is compressed on its own as one LZ4 block.
+ * bfz always writes full BFZ_BUFFER_SIZE buffers except for the last one,
+ * and always reads with size == BFZ_BUFFER_SIZE, so one read_ex returns
+ * exactly one block.  Each block on disk is preceded by a frame header:
+ *
+ *		uint32	length of the block on disk, with BFZ_LZ4_RAW set if the
+ *				block did not shrink and is stored as is
+ *		uint32	length of the block after decompression, with BFZ_LZ4_CRC
+ *				set if a CRC-32C of the block on disk follows
+ *
+ * With gp_workfile_checksumming on, every frame carries that CRC and bfz
+ * itself doesn't add its checksum: the CRC covers every byte of the much
+ * smaller compressed block, rather than a few sampled bytes per sector of
+ * the uncompressed one, and is verified before the block is decompressed.
+ *
+ * Frames are collected in an I/O buffer of BFZ_LZ4_IO_SIZE and written out
+ * and read back in that unit, so the file sees few large sequential calls
+ * instead of one per bfz buffer.  The I/O buffer is kept small enough that
+ * a hash join with hundreds of open batch files doesn't blow its memory;
+ * gp_workfile_io_size makes it larger for spills of few, large files.
+ */
+
+#define BFZ_LZ4_IO_SIZE			(1<<16)
+#define BFZ_LZ4_RAW				0x80000000
+#define BFZ_LZ4_CRC				0x80000000
+#define BFZ_LZ4_HDRSZ			(2 * sizeof(uint32))
+#define BFZ_LZ4_CRCSZ			sizeof(pg_crc32c)
+
+/* Room needed to append the largest possible frame to the I/O buffer */
+#define BFZ_LZ4_MAX_FRAME		(BFZ_LZ4_HDRSZ + BFZ_LZ4_CRCSZ + \
+								 LZ4_COMPRESSBOUND(BFZ_BUFFER_SIZE))
+
+struct bfz_lz4_freeable_stuff
+{
+	struct bfz_freeable_stuff super;
+
+	/* true if compressing, false if decompressing */
+	bool		compressing;
+	bool		eof_in;
+
+	/* true if the frames we write carry a CRC */
+	bool		checksum;
+
+	/* Valid bytes in io_buf, and the read position when decompressing */
+	int			io_len;
+	int			io_pos;
+
+	/* The I/O unit, and io_buf, which has room for one more frame past it */
+	int			io_size;
+	char	   *io_buf;
+};
+
+static void
+bfz_lz4_flush(bfz_t *thiz, struct bfz_lz4_freeable_stuff *fs)
+{
+	bfz_write_io_unit(thiz, fs->io_buf, fs->io_len);
+	fs->io_len = 0;
+}
+
+/*
+ * Fill the I/O buffer so that at least 'need' unread bytes are in it,
+ * unless the file ends first.  Returns the number of unread bytes.
+ */
+static int
+bfz_lz4_fill(bfz_t *thiz, struct bfz_lz4_freeable_stuff *fs, int need)
+{
+	int			avail = fs->io_len - fs->io_pos;
+
+	if (avail >= need || fs->eof_in)
+		return avail;
+
+	/* Move the unread tail to the front and read a full unit after it */
+	if (avail > 0)
+		memmove(fs->io_buf, fs->io_buf + fs->io_pos, avail);
+	fs->io_pos = 0;
+	fs->io_len = avail;
+
+	while (fs->io_len < need && !fs->eof_in)
+	{
+		int			n = FileRead(thiz->file, fs->io_buf + fs->io_len,
+								 fs->io_size + BFZ_LZ4_MAX_FRAME - fs->io_len);
+
+		if (n < 0)
+			ereport(ERROR,
+					(errcode_for_file_access(),
+					 errmsg("could not read from temporary file: %m")));
+		if (n == 0)
+			fs->eof_in = true;
+		fs->io_len += n;
+	}
+
+	return fs->io_len;
+}
+
+/*
+ * bfz_lz4_close_ex
+ *	Flush pending frames and free buffers. Does not close the underlying file!
+ */
+static void
+bfz_lz4_close_ex(bfz_t *thiz)
+{
+	struct bfz_lz4_freeable_stuff *fs = (void *) thiz->freeable_stuff;
+
+	if (NULL != fs)
+	{
+		if (fs->compressing)
+			bfz_lz4_flush(thiz, fs);
+
+		pfree(fs->io_buf);
+		pfree(fs);
+		thiz->freeable_stuff = NULL;
+	}
+}
+
+static void
+bfz_lz4_write_ex(bfz_t *thiz, const char *buffer, int size)
+{
+	struct bfz_lz4_freeable_stuff *fs = (void *) thiz->freeable_stuff;
+
+	while (size > 0)
+	{
+		int			chunk = Min(size, BFZ_BUFFER_SIZE);
+		int			hdrsz = BFZ_LZ4_HDRSZ + (fs->checksum ? BFZ_LZ4_CRCSZ : 0);
+		uint32		hdr[2];
+		char	   *dst;
+		int			clen;
+
+		if (fs->io_len >= fs->io_size)
+			bfz_lz4_flush(thiz, fs);
+
+		dst = fs->io_buf + fs->io_len + hdrsz;
+		clen = LZ4_compress_default(buffer, dst, chunk,
+									LZ4_compressBound(chunk));
+
+		if (clen <= 0 || clen >= chunk)
+		{
+			/* Didn't shrink, store it as is */
+			memcpy(dst, buffer, chunk);
+			clen = chunk;
+			hdr[0] = (uint32) clen | BFZ_LZ4_RAW;
+		}
+		else
+			hdr[0] = (uint32) clen;
+		hdr[1] = (uint32) chunk;
+
+		if (fs->checksum)
+		{
+			pg_crc32c	crc;
+
+			INIT_CRC32C(crc);
+			COMP_CRC32C(crc, dst, clen);
+			FIN_CRC32C(crc);
+			memcpy(fs->io_buf + fs->io_len + BFZ_LZ4_HDRSZ, &crc, BFZ_LZ4_CRCSZ);
+			hdr[1] |= BFZ_LZ4_CRC;
+		}
+
+		memcpy(fs->io_buf + fs->io_len, hdr, BFZ_LZ4_HDRSZ);
+		fs->io_len += hdrsz + clen;
+
+		buffer += chunk;
+		size -= chunk;
+	}
+}
+
+/*
+ * bfz_lz4_read_ex
+ *	Decompress the next block into buffer.
+ *
+ *	Returns the block's length, or 0 at the end of the file.  The caller
+ *	always asks for a full bfz buffer, which any block fits in.
+ */
+static int
+bfz_lz4_read_ex(bfz_t *thiz, char *buffer, int size)
+{
+	struct bfz_lz4_freeable_stuff *fs = (void *) thiz->freeable_stuff;
+	uint32		hdr[2];
+	int			hdrsz;
+	int			clen;
+	int			rawlen;
+	int			avail;
+	char	   *src;
+
+	avail = bfz_lz4_fill(thiz, fs, BFZ_LZ4_HDRSZ);
+	if (avail == 0)
+		return 0;
+	if (avail < BFZ_LZ4_HDRSZ)
+		ereport(ERROR,
+				(errcode_for_file_access(),
+				 errmsg("unexpected end of temporary file")));
+
+	memcpy(hdr, fs->io_buf + fs->io_pos, BFZ_LZ4_HDRSZ);
+	clen = (int) (hdr[0] & ~BFZ_LZ4_RAW);
+	rawlen = (int) (hdr[1] & ~BFZ_LZ4_CRC);
+	hdrsz = BFZ_LZ4_HDRSZ + ((hdr[1] & BFZ_LZ4_CRC) ? BFZ_LZ4_CRCSZ : 0);
+
+	if (rawlen > size || clen > LZ4_COMPRESSBOUND(BFZ_BUFFER_SIZE))
+		ereport(ERROR,
+				(errcode(ERRCODE_DATA_CORRUPTED),
+				 errmsg("invalid block header in temporary file")));
+
+	if (bfz_lz4_fill(thiz, fs, hdrsz + clen) < hdrsz + clen)
+		ereport(ERROR,
+				(errcode_for_file_access(),
+				 errmsg("unexpected end of temporary file")));
+
+	src = fs->io_buf + fs->io_pos + hdrsz;
+
+	if (hdr[1] & BFZ_LZ4_CRC)
+	{
+		pg_crc32c	storedCrc;
+		pg_crc32c	crc;
+
+		memcpy(&storedCrc, fs->io_buf + fs->io_pos + BFZ_LZ4_HDRSZ, BFZ_LZ4_CRCSZ);
+		INIT_CRC32C(crc);
+		COMP_CRC32C(crc, src, clen);
+		FIN_CRC32C(crc);
+
+		if (!EQ_CRC32C(crc, storedCrc))
+			ereport(ERROR,
+					(errcode(ERRCODE_IO_ERROR),
+					 errmsg("temporary file block checksum mismatch: current %u, "
+							"expected %u", storedCrc, crc)));
+	}
+
+	fs->io_pos += hdrsz + clen;
+
+	if (hdr[0] & BFZ_LZ4_RAW)
+	{
+		memcpy(buffer, src, rawlen);
+		return rawlen;
+	}
+
+	if (LZ4_decompress_safe(src, buffer, clen, size) != rawlen)
+		ereport(ERROR,
+				(errcode(ERRCODE_DATA_CORRUPTED),
+				 errmsg("could not uncompress data from temporary file")));
+
+	return rawlen;
+}
+
+/*
+ * bfz_lz4_init
+ *	Initialize lz4 compression for a file.
+ *
+ *	The underlying file descriptor should already be opened and valid.
+ *	Memory is allocated in the current memory context.
+ *
+ *	When a new file asks for checksums, the frames carry them, and bfz is
+ *	told not to add its own by clearing has_checksum.  Reading needs no
+ *	flag, since every frame says whether it has a CRC.
+ */
+void
+bfz_lz4_init(bfz_t *thiz)
+{
+	struct bfz_lz4_freeable_stuff *fs = palloc(sizeof *fs);
+
+	fs->compressing = (thiz->mode == BFZ_MODE_APPEND);
+	fs->checksum = fs->compressing && thiz->has_checksum;
+	if (fs->checksum)
+		thiz->has_checksum = false;
+	fs->eof_in = false;
+	fs->io_len = 0;
+	fs->io_pos = 0;
+	fs->io_size = bfz_io_size();
+	if (fs->io_size == 0)
+		fs->io_size = BFZ_LZ4_IO_SIZE;
+	fs->io_buf = palloc(fs->io_size + BFZ_LZ4_MAX_FRAME);
+
+	thiz->freeable_stuff = &fs->super;
+	fs->super.read_ex = bfz_lz4_read_ex;
+	fs->super.write_ex = bfz_lz4_write_ex;
+	fs->super.close_ex = bfz_lz4_close_ex;
+}
+
+#endif							/* HAVE_LIBLZ4 */
@@ -8,8 +8,25 @@
 /*
  * This file implements bfz compression algorithm "nothing".
  * We don't compress at all.
+ *
+ * By default every bfz buffer is read or written with its own call.  With
+ * gp_workfile_io_size set, buffers are staged in an I/O buffer of that
+ * size instead, and the file is read and written in that unit.
  */
 
+struct bfz_nothing_freeable_stuff
+{
+	struct bfz_freeable_stuff super;
+
+	/* Valid bytes in io_buf, and the read position when reading */
+	int			io_len;
+	int			io_pos;
+
+	/* The I/O unit, or 0 if the buffers aren't staged */
+	int			io_size;
+	char	   *io_buf;
+};
+
 /*
  * bfz_nothing_close_ex
  *	Free up descriptor, buffers etc. Does not close the underlying file!
@@ -17,12 +34,20 @@
 static void
 bfz_nothing_close_ex(bfz_t * thiz)
 {
-	pfree(thiz->freeable_stuff);
+	struct bfz_nothing_freeable_stuff *fs = (void *) thiz->freeable_stuff;
+
+	if (fs->io_buf)
+	{
+		if (thiz->mode == BFZ_MODE_APPEND)
+			bfz_write_io_unit(thiz, fs->io_buf, fs->io_len);
+		pfree(fs->io_buf);
+	}
+	pfree(fs);
 	thiz->freeable_stuff = NULL;
 }
 
 static int
-bfz_nothing_read_ex(bfz_t * thiz, char *buffer, int size)
+bfz_nothing_read_file(bfz_t * thiz, char *buffer, int size)
 {
 	int			orig_size = size;
 
@@ -42,30 +67,77 @@ bfz_nothing_read_ex(bfz_t * thiz, char *buffer, int size)
 	return orig_size - size;
 }
 
+static int
+bfz_nothing_read_ex(bfz_t * thiz, char *buffer, int size)
+{
+	struct bfz_nothing_freeable_stuff *fs = (void *) thiz->freeable_stuff;
+	int			orig_size = size;
+
+	if (fs->io_buf == NULL)
+		return bfz_nothing_read_file(thiz, buffer, size);
+
+	while (size)
+	{
+		int			n;
+
+		if (fs->io_pos == fs->io_len)
+		{
+			fs->io_len = bfz_nothing_read_file(thiz, fs->io_buf, fs->io_size);
+			fs->io_pos = 0;
+			if (fs->io_len == 0)
+				break;
+		}
+
+		n = Min(size, fs->io_len - fs->io_pos);
+		memcpy(buffer, fs->io_buf + fs->io_pos, n);
+		fs->io_pos += n;
+		buffer += n;
+		size -= n;
+	}
+	return orig_size - size;
+}
+
 static void
 bfz_nothing_write_ex(bfz_t * bfz, const char *buffer, int size)
 {
+	struct bfz_nothing_freeable_stuff *fs = (void *) bfz->freeable_stuff;
+
+	if (fs->io_buf == NULL)
+	{
+		bfz_write_io_unit(bfz, buffer, size);
+		return;
+	}
+
 	while (size)
 	{
-		int			i = FileWrite(bfz->file, (char *) buffer, size);
+		int			n = Min(size, fs->io_size - fs->io_len);
 
-		if (i < 0)
-			ereport(ERROR,
-					(errcode_for_file_access(),
-					 errmsg("could not write to temporary file: %m")));
-		buffer += i;
-		size -= i;
+		memcpy(fs->io_buf + fs->io_len, buffer, n);
+		fs->io_len += n;
+		buffer += n;
+		size -= n;
+
+		if (fs->io_len == fs->io_size)
+		{
+			bfz_write_io_unit(bfz, fs->io_buf, fs->io_len);
+			fs->io_len = 0;
+		}
 	}
 }
 
 void
 bfz_nothing_init(bfz_t * thiz)
 {
-	struct bfz_freeable_stuff *fs = palloc(sizeof *fs);
+	struct bfz_nothing_freeable_stuff *fs = palloc(sizeof *fs);
+
+	thiz->freeable_stuff = &fs->super;
 
-	thiz->freeable_stuff = fs;
+	fs->io_len = 0;
+	fs->io_pos = 0;
+	fs->io_size = bfz_io_size();
+	fs->io_buf = fs->io_size > 0 ? palloc(fs->io_size) : NULL;
 
-	fs->read_ex = bfz_nothing_read_ex;
-	fs->write_ex = bfz_nothing_write_ex;
-	fs->close_ex = bfz_nothing_close_ex;
+	fs->super.read_ex = bfz_nothing_read_ex;
+	fs->super.write_ex = bfz_nothing_write_ex;
+	fs->super.close_ex = bfz_nothing_close_ex;
 }
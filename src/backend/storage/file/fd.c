@@ -114,6 +114,14 @@
  */
 int			max_files_per_process = 1000;
 
+/*
+ * Bytes this process has read and written with FileRead() and FileWrite(),
+ * for EXPLAIN ANALYZE.  Reads that hit the shared buffer cache don't get
+ * this far, so they aren't counted.
+ */
+uint64		FileReadBytes = 0;
+uint64		FileWriteBytes = 0;
+
 /*
  * Maximum number of file descriptors to open for either VFD entries or
  * AllocateFile/AllocateDir/OpenTransientFile operations.  This is initialized
@@ -781,6 +789,8 @@ FreeVfd(File file)
  * make_database_relative()
  *		Prepend DatabasePath to the given file name.
  *
+ * An absolute name, of a work file in a spill location, is kept as is.
+ *
  * Result is a palloc'd string.
  */
 static char *
@@ -788,7 +798,9 @@ make_database_relative(const char *filename)
 {
 	char	   *buf;
 
-	Assert(!is_absolute_path(filename));
+	if (is_absolute_path(filename))
+		return pstrdup(filename);
+
 	buf = (char *) palloc(PATH_MAX);
 	if (snprintf(buf, PATH_MAX, "%s/%s", getCurrentTempFilePath, filename) > PATH_MAX)
 	{
@@ -1176,6 +1188,135 @@ FileClose(File file)
 	FreeVfd(file);
 }
 
+/*
+ * FilePrefetch - initiate asynchronous read of a given range of the file.
+ * The logical seek position is unaffected.
+ *
+ * Currently the only implementation of this function is using posix_fadvise
+ * which is the simplest standardized interface that accomplishes this.
+ * We could add an implementation using libaio in the future; but note that
+ * this API is inappropriate for libaio, which wants to have a buffer provided
+ * to read into.
+ */
+int
+FilePrefetch(File file, int64 offset, int amount)
+{
+#if defined(HAVE_DECL_POSIX_FADVISE) && HAVE_DECL_POSIX_FADVISE && defined(POSIX_FADV_WILLNEED)
+	int			returnCode;
+
+	Assert(FileIsValid(file));
+
+	DO_DB(elog(LOG, "FilePrefetch: %d (%s) " INT64_FORMAT " %d",
+			   file, VfdCache[file].fileName,
+			   offset, amount));
+
+	returnCode = FileAccess(file);
+	if (returnCode < 0)
+		return returnCode;
+
+	returnCode = posix_fadvise(VfdCache[file].fd, offset, amount,
+							   POSIX_FADV_WILLNEED);
+
+	return returnCode;
+#else
+	Assert(FileIsValid(file));
+	return 0;
+#endif
+}
+
+/*
+ * FileWriteback - write out the dirty pages of a given range of the file.
+ * If wait is false, only start the writeback; otherwise also wait for it,
+ * and for any started earlier, to complete.  This does not make the data
+ * durable; use FileSync for that.  The logical seek position is unaffected.
+ *
+ * Uses sync_file_range where available; elsewhere this is a no-op.
+ */
+int
+FileWriteback(File file, int64 offset, int64 amount, bool wait)
+{
+#if defined(SYNC_FILE_RANGE_WRITE)
+	int			returnCode;
+
+	Assert(FileIsValid(file));
+
+	DO_DB(elog(LOG, "FileWriteback: %d (%s) " INT64_FORMAT " " INT64_FORMAT " %d",
+			   file, VfdCache[file].fileName,
+			   offset, amount, wait));
+
+	returnCode = FileAccess(file);
+	if (returnCode < 0)
+		return returnCode;
+
+	return sync_file_range(VfdCache[file].fd, offset, amount,
+						   wait ? (SYNC_FILE_RANGE_WAIT_BEFORE |
+								   SYNC_FILE_RANGE_WRITE |
+								   SYNC_FILE_RANGE_WAIT_AFTER) :
+						   SYNC_FILE_RANGE_WRITE);
+#else
+	Assert(FileIsValid(file));
+	return 0;
+#endif
+}
+
+/*
+ * FileDropCache - evict a given range of the file from the kernel page
+ * cache.  Dirty pages are kept; write them out first with FileWriteback if
+ * they should go too.  The logical seek position is unaffected.
+ */
+int
+FileDropCache(File file, int64 offset, int64 amount)
+{
+#if defined(HAVE_DECL_POSIX_FADVISE) && HAVE_DECL_POSIX_FADVISE && defined(POSIX_FADV_DONTNEED)
+	int			returnCode;
+
+	Assert(FileIsValid(file));
+
+	DO_DB(elog(LOG, "FileDropCache: %d (%s) " INT64_FORMAT " " INT64_FORMAT,
+			   file, VfdCache[file].fileName,
+			   offset, amount));
+
+	returnCode = FileAccess(file);
+	if (returnCode < 0)
+		return returnCode;
+
+	return posix_fadvise(VfdCache[file].fd, offset, amount,
+						 POSIX_FADV_DONTNEED);
+#else
+	Assert(FileIsValid(file));
+	return 0;
+#endif
+}
+
+/*
+ * FileAllocate - reserve disk space for a given range of the file, without
+ * changing its size.  The logical seek position is unaffected.
+ *
+ * Uses fallocate where available; elsewhere this is a no-op.
+ */
+int
+FileAllocate(File file, int64 offset, int64 amount)
+{
+#if defined(FALLOC_FL_KEEP_SIZE)
+	int			returnCode;
+
+	Assert(FileIsValid(file));
+
+	DO_DB(elog(LOG, "FileAllocate: %d (%s) " INT64_FORMAT " " INT64_FORMAT,
+			   file, VfdCache[file].fileName,
+			   offset, amount));
+
+	returnCode = FileAccess(file);
+	if (returnCode < 0)
+		return returnCode;
+
+	return fallocate(VfdCache[file].fd, FALLOC_FL_KEEP_SIZE, offset, amount);
+#else
+	Assert(FileIsValid(file));
+	return 0;
+#endif
+}
+
 int
 FileRead(File file, char *buffer, int amount)
 {
@@ -1201,7 +1342,10 @@ retry:
 	returnCode = read(VfdCache[file].fd, buffer, amount);
 
 	if (returnCode >= 0)
+	{
 		VfdCache[file].seekPos += returnCode;
+		FileReadBytes += returnCode;
+	}
 	else
 	{
 		/*
@@ -1287,7 +1431,10 @@ retry:
 		errno = ENOSPC;
 
 	if (returnCode >= 0)
+	{
 		VfdCache[file].seekPos += returnCode;
+		FileWriteBytes += returnCode;
+	}
 	else
 	{
 		/*
@@ -2075,6 +2222,24 @@ RemovePgTempFiles(void)
 #ifdef EXEC_BACKEND
 	RemovePgTempFilesInDir(PG_TEMP_FILES_DIR);
 #endif
+
+	/* And this segment's directories in the workfile spill locations */
+	{
+		List	   *tiers = workfile_mgr_spill_locations();
+		ListCell   *lc;
+		ListCell   *lc2;
+
+		foreach(lc, tiers)
+		{
+			foreach(lc2, (List *) lfirst(lc))
+			{
+				char	   *tmpdir = workfile_mgr_spill_location_tmpdir((char *) lfirst(lc2));
+
+				RemovePgTempFilesInDir(tmpdir);
+				pfree(tmpdir);
+			}
+		}
+	}
 }
 
 /* Process one pgsql_tmp directory for RemovePgTempFiles */
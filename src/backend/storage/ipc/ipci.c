@@ -28,6 +28,7 @@
 #include "cdb/cdbfilerepprimaryack.h"
 #include "cdb/cdbfilerepprimaryrecovery.h"
 #include "cdb/cdbfilerepresyncmanager.h"
+#include "cdb/cdbappendonlyblockdirectory.h"
 #include "cdb/cdblocaldistribxact.h"
 #include "cdb/cdbpersistentfilesysobj.h"
 #include "cdb/cdbpersistentfilespace.h"
@@ -37,6 +38,11 @@
 #include "cdb/cdbpersistentcheck.h"
 #include "cdb/cdbresynchronizechangetracking.h"
 #include "cdb/cdbvars.h"
+#include "cdb/cdbendpoint.h"
+#include "cdb/cdbprogress.h"
+#include "cdb/cdbqueryhistory.h"
+#include "cdb/cdbstmtstats.h"
+#include "cdb/ic_stats.h"
 #include "miscadmin.h"
 #include "pgstat.h"
 #include "postmaster/autovacuum.h"
@@ -67,8 +73,10 @@
 #include "utils/tqual.h"
 #include "postmaster/backoff.h"
 #include "cdb/memquota.h"
+#include "executor/nodeShareInputScan.h"
 #include "executor/spi.h"
 #include "utils/workfile_mgr.h"
+#include "utils/sharedcatcache.h"
 #include "utils/session_state.h"
 
 shmem_startup_hook_type shmem_startup_hook = NULL;
@@ -139,6 +147,7 @@ CreateSharedMemoryAndSemaphores(bool makePrivate, int port)
 		size = add_size(size, BufferShmemSize());
 		size = add_size(size, LockShmemSize());
 		size = add_size(size, workfile_mgr_shmem_size());
+		size = add_size(size, SharedCatCacheShmemSize());
 		if (Gp_role == GP_ROLE_DISPATCH)
 			size = add_size(size, AppendOnlyWriterShmemSize());
 
@@ -161,6 +170,13 @@ CreateSharedMemoryAndSemaphores(bool makePrivate, int port)
 		size = add_size(size, LWLockShmemSize());
 		size = add_size(size, ProcArrayShmemSize());
 		size = add_size(size, BackendStatusShmemSize());
+		size = add_size(size, ICStatsShmemSize());
+		size = add_size(size, QueryProgressShmemSize());
+		size = add_size(size, QueryHistoryShmemSize());
+		size = add_size(size, StmtStatsShmemSize());
+		size = add_size(size, EndpointShmemSize());
+		size = add_size(size, AppendOnlyBlockDirectory_CacheShmemSize());
+		size = add_size(size, ShareInputShmemSize());
 		size = add_size(size, SharedSnapshotShmemSize());
 
 		size = add_size(size, SInvalShmemSize());
@@ -342,6 +358,13 @@ CreateSharedMemoryAndSemaphores(bool makePrivate, int port)
 
 	CreateSharedProcArray();
 	CreateSharedBackendStatus();
+	ICStatsShmemInit();
+	QueryProgressShmemInit();
+	QueryHistoryShmemInit();
+	StmtStatsShmemInit();
+	EndpointShmemInit();
+	AppendOnlyBlockDirectory_CacheShmemInit();
+	ShareInputShmemInit();
 	
 	/*
 	 * Set up Shared snapshot slots
@@ -404,6 +427,7 @@ CreateSharedMemoryAndSemaphores(bool makePrivate, int port)
 	BTreeShmemInit();
 	SyncScanShmemInit();
 	workfile_mgr_cache_init();
+	SharedCatCacheShmemInit();
 	BackendCancelShmemInit();
 
 #ifdef EXEC_BACKEND
@@ -62,6 +62,27 @@ SendSharedInvalidMessages(const SharedInvalidationMessage *msgs, int n)
 	SIInsertDataEntries(msgs, n);
 }
 
+/*
+ * SendSharedInvalidReset
+ *	Make every backend, ourselves included, reset its caches, in place of
+ *	sending a set of messages too large for the SI message queue.
+ */
+void
+SendSharedInvalidReset(void)
+{
+	SIResetAll();
+}
+
+/*
+ * SharedInvalQueueSize
+ *	The number of messages the SI message queue can hold.
+ */
+int
+SharedInvalQueueSize(void)
+{
+	return SIQueueSize();
+}
+
 /*
  * ReceiveSharedInvalidMessages
  *		Process shared-cache-invalidation messages waiting for this backend
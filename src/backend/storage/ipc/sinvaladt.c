@@ -45,16 +45,21 @@
  * SICleanupQueue is called, and we try not to do that often.)
  *
  * In reality, the messages are stored in a circular buffer of MAXNUMMESSAGES
- * entries.  We translate MsgNum values into circular-buffer indexes by
- * computing MsgNum % MAXNUMMESSAGES (this should be fast as long as
- * MAXNUMMESSAGES is a constant and a power of 2).	As long as maxMsgNum
- * doesn't exceed minMsgNum by more than MAXNUMMESSAGES, we have enough space
- * in the buffer.  If the buffer does overflow, we recover by setting the
- * "reset" flag for each backend that has fallen too far behind.  A backend
- * that is in "reset" state is ignored while determining minMsgNum.  When
- * it does finally attempt to receive inval messages, it must discard all
+ * entries, set by gp_sinval_queue_size at postmaster start.  We translate
+ * MsgNum values into circular-buffer indexes by masking them with
+ * MAXNUMMESSAGES - 1, which is why it is rounded up to a power of 2.  As long
+ * as maxMsgNum doesn't exceed minMsgNum by more than MAXNUMMESSAGES, we have
+ * enough space in the buffer.  If the buffer does overflow, we recover by
+ * setting the "reset" flag for each backend that has fallen too far behind.
+ * A backend that is in "reset" state is ignored while determining minMsgNum.
+ * When it does finally attempt to receive inval messages, it must discard all
  * its invalidatable state, since it won't know what it missed.
  *
+ * A transaction with more messages than the whole buffer would push every
+ * backend that does not read concurrently into reset anyway, and the others
+ * through thousands of single invalidations, so it resets everyone up front
+ * instead (SIResetAll).
+ *
  * To reduce the probability of needing resets, we send a "catchup" interrupt
  * to any backend that seems to be falling unreasonably far behind.  The
  * normal behavior is that at most one such interrupt is in flight at a time;
@@ -109,7 +114,10 @@
  * Configurable parameters.
  *
  * MAXNUMMESSAGES: max number of shared-inval messages we can buffer.
- * Must be a power of 2 for speed.
+ * Must be a power of 2 for speed.  It is gp_sinval_queue_size rounded up,
+ * kept in the shared segment; larger queues let bursts of invalidations,
+ * such as DDL on a table with many partitions, through without forcing the
+ * backends that did not keep up into a reset of all their caches.
  *
  * MSGNUMWRAPAROUND: how often to reduce MsgNum variables to avoid overflow.
  * Must be a multiple of MAXNUMMESSAGES.  Should be large.
@@ -129,8 +137,9 @@
  * per iteration.
  */
 
-#define MAXNUMMESSAGES 4096
-#define MSGNUMWRAPAROUND (MAXNUMMESSAGES * 262144)
+#define MAXNUMMESSAGES (shmInvalBuffer->numMessages)
+#define MAX_SINVAL_QUEUE_SIZE (1 << 20)
+#define MSGNUMWRAPAROUND (MAX_SINVAL_QUEUE_SIZE * 1024)
 #define CLEANUP_MIN (MAXNUMMESSAGES / 2)
 #define CLEANUP_QUANTUM (MAXNUMMESSAGES / 16)
 #define SIG_THRESHOLD (MAXNUMMESSAGES / 2)
@@ -175,24 +184,23 @@ typedef struct SISeg
 	int			nextThreshold;	/* # of messages to call SICleanupQueue */
 	int			lastBackend;	/* index of last active procState entry, +1 */
 	int			maxBackends;	/* size of procState array */
+	int			numMessages;	/* size of the message buffer */
 
 	slock_t		msgnumLock;		/* spinlock protecting maxMsgNum */
 
-	/*
-	 * Circular buffer holding shared-inval messages
-	 */
-	SharedInvalidationMessage buffer[MAXNUMMESSAGES];
-
 	/*
 	 * Per-backend state info.
 	 *
 	 * We declare procState as 1 entry because C wants a fixed-size array, but
 	 * actually it is maxBackends entries long.
+	 *
+	 * The circular buffer holding the shared-inval messages follows it.
 	 */
 	ProcState	procState[1];	/* reflects the invalidation state */
 } SISeg;
 
 static SISeg *shmInvalBuffer;	/* pointer to the shared inval buffer */
+static SharedInvalidationMessage *shmInvalMessages;	/* its message buffer */
 
 
 static LocalTransactionId nextLocalTransactionId;
@@ -200,6 +208,22 @@ static LocalTransactionId nextLocalTransactionId;
 static void CleanupInvalidationState(int status, Datum arg);
 
 
+/*
+ * SInvalQueueSize --- the number of messages the buffer holds:
+ * gp_sinval_queue_size, rounded up to a power of 2
+ */
+static int
+SInvalQueueSize(void)
+{
+	int			numMessages = 1;
+
+	while (numMessages < gp_sinval_queue_size &&
+		   numMessages < MAX_SINVAL_QUEUE_SIZE)
+		numMessages <<= 1;
+
+	return numMessages;
+}
+
 /*
  * SInvalShmemSize --- return shared-memory space needed
  */
@@ -210,6 +234,9 @@ SInvalShmemSize(void)
 
 	size = offsetof(SISeg, procState);
 	size = add_size(size, mul_size(sizeof(ProcState), MaxBackends));
+	size = MAXALIGN(size);
+	size = add_size(size, mul_size(sizeof(SharedInvalidationMessage),
+								   SInvalQueueSize()));
 
 	return size;
 }
@@ -226,23 +253,32 @@ CreateSharedInvalidationState(void)
 	bool		found;
 
 	/* Allocate space in shared memory */
-	size = offsetof(SISeg, procState);
-	size = add_size(size, mul_size(sizeof(ProcState), MaxBackends));
+	size = SInvalShmemSize();
 
 	shmInvalBuffer = (SISeg *)
 		ShmemInitStruct("shmInvalBuffer", size, &found);
+
+	size = offsetof(SISeg, procState);
+	size = add_size(size, mul_size(sizeof(ProcState), MaxBackends));
+	shmInvalMessages = (SharedInvalidationMessage *)
+		((char *) shmInvalBuffer + MAXALIGN(size));
+
 	if (found)
 		return;
 
-	/* Clear message counters, save size of procState array, init spinlock */
+	/*
+	 * Clear message counters, save size of procState array and of the
+	 * message buffer, init spinlock
+	 */
 	shmInvalBuffer->minMsgNum = 0;
 	shmInvalBuffer->maxMsgNum = 0;
+	shmInvalBuffer->numMessages = SInvalQueueSize();
 	shmInvalBuffer->nextThreshold = CLEANUP_MIN;
 	shmInvalBuffer->lastBackend = 0;
 	shmInvalBuffer->maxBackends = MaxBackends;
 	SpinLockInit(&shmInvalBuffer->msgnumLock);
 
-	/* The buffer[] array is initially all unused, so we need not fill it */
+	/* The message buffer is initially all unused, so we need not fill it */
 
 	/* Mark all backends inactive, and initialize nextLXID */
 	for (i = 0; i < shmInvalBuffer->maxBackends; i++)
@@ -422,7 +458,7 @@ SIInsertDataEntries(const SharedInvalidationMessage *data, int n)
 		max = segP->maxMsgNum;
 		while (nthistime-- > 0)
 		{
-			segP->buffer[max % MAXNUMMESSAGES] = *data++;
+			shmInvalMessages[max & (MAXNUMMESSAGES - 1)] = *data++;
 			max++;
 		}
 
@@ -454,6 +490,45 @@ SIInsertDataEntries(const SharedInvalidationMessage *data, int n)
 	}
 }
 
+/*
+ * SIQueueSize
+ *		The number of messages the buffer can hold.
+ */
+int
+SIQueueSize(void)
+{
+	return MAXNUMMESSAGES;
+}
+
+/*
+ * SIResetAll
+ *		Put every receiving backend, ourselves included, into reset state,
+ *		in place of adding a set of messages too large for the buffer.
+ */
+void
+SIResetAll(void)
+{
+	SISeg	   *segP = shmInvalBuffer;
+	int			i;
+
+	LWLockAcquire(SInvalWriteLock, LW_EXCLUSIVE);
+	LWLockAcquire(SInvalReadLock, LW_EXCLUSIVE);
+
+	for (i = 0; i < segP->lastBackend; i++)
+	{
+		ProcState  *stateP = &segP->procState[i];
+
+		if (stateP->procPid == 0 || stateP->sendOnly)
+			continue;
+
+		stateP->resetState = true;
+		stateP->hasMessages = true;
+	}
+
+	LWLockRelease(SInvalReadLock);
+	LWLockRelease(SInvalWriteLock);
+}
+
 /*
  * SIGetDataEntries
  *		get next SI message(s) for current backend, if there are any
@@ -555,7 +630,7 @@ SIGetDataEntries(SharedInvalidationMessage *data, int datasize)
 	n = 0;
 	while (n < datasize && stateP->nextMsgNum < max)
 	{
-		data[n++] = segP->buffer[stateP->nextMsgNum % MAXNUMMESSAGES];
+		data[n++] = shmInvalMessages[stateP->nextMsgNum & (MAXNUMMESSAGES - 1)];
 		stateP->nextMsgNum++;
 	}
 
@@ -193,14 +193,20 @@ NumLWLocks(void)
     /* cdbfts.c needs one lock */
     numLocks++;
 
+	/* cdbstmtstats.c needs one lock */
+	numLocks++;
+
 	/* multixact.c needs two SLRU areas */
 	numLocks += NUM_MXACTOFFSET_BUFFERS + NUM_MXACTMEMBER_BUFFERS;
 
 	/* cdbdistributedlog.c needs one per DistributedLog buffer */
-	numLocks += NUM_DISTRIBUTEDLOG_BUFFERS;
+	numLocks += gp_distributedlog_buffers;
 
 	/* sharedsnapshot.c needs one per shared snapshot slot */
 	numLocks += NUM_SHARED_SNAPSHOT_SLOTS;
+
+	/* proc.c needs one for each backend or auxiliary process */
+	numLocks += MaxBackends + NUM_AUXILIARY_PROCS;
     
 	/*
 	 * Add any requested by loadable modules; for backwards-compatibility
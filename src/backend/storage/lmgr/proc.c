@@ -42,6 +42,7 @@
 #include "catalog/namespace.h" /* TempNamespaceOidIsValid */
 #include "commands/async.h"
 #include "miscadmin.h"
+#include "pgstat.h"
 #include "postmaster/autovacuum.h"
 #include "replication/syncrep.h"
 #include "replication/walsender.h"
@@ -87,7 +88,7 @@ PGPROC	   *lockHolderProcPtr = NULL;
 NON_EXEC_STATIC slock_t *ProcStructLock = NULL;
 
 /* Pointers to shared-memory structures */
-NON_EXEC_STATIC PROC_HDR *ProcGlobal = NULL;
+PROC_HDR   *ProcGlobal = NULL;
 NON_EXEC_STATIC PGPROC *AuxiliaryProcs = NULL;
 
 /* If we are waiting for a lock, this points to the associated LOCALLOCK */
@@ -205,43 +206,42 @@ InitProcGlobal(int mppLocalProcessCounter)
 
 	/*
 	 * Pre-create the PGPROC structures and create a semaphore for each.
+	 * Regular backends and autovacuum workers share one array, so that the
+	 * lock manager can scan every PGPROC that may hold fast-path locks.
 	 */
-	procs = (PGPROC *) ShmemAlloc((MaxConnections) * sizeof(PGPROC));
+	procs = (PGPROC *) ShmemAlloc((MaxBackends) * sizeof(PGPROC));
 	if (!procs)
 		ereport(FATAL,
 				(errcode(ERRCODE_OUT_OF_MEMORY),
 				 errmsg("out of shared memory")));
-	MemSet(procs, 0, MaxConnections * sizeof(PGPROC));
-	for (i = 0; i < MaxConnections; i++)
+	MemSet(procs, 0, MaxBackends * sizeof(PGPROC));
+	for (i = 0; i < MaxBackends; i++)
 	{
 		PGSemaphoreCreate(&(procs[i].sem));
 		InitSharedLatch(&(procs[i].procLatch));
+		procs[i].backendLock = LWLockAssign();
 
-		procs[i].links.next = ProcGlobal->freeProcs;
-		ProcGlobal->freeProcs = MAKE_OFFSET(&procs[i]);
+		if (i < MaxConnections)
+		{
+			procs[i].links.next = ProcGlobal->freeProcs;
+			ProcGlobal->freeProcs = MAKE_OFFSET(&procs[i]);
+		}
+		else
+		{
+			procs[i].links.next = ProcGlobal->autovacFreeProcs;
+			ProcGlobal->autovacFreeProcs = MAKE_OFFSET(&procs[i]);
+		}
 	}
 	ProcGlobal->procs = procs;
+	ProcGlobal->numProcs = MaxBackends;
 	ProcGlobal->numFreeProcs = MaxConnections;
 
-	procs = (PGPROC *) ShmemAlloc((autovacuum_max_workers) * sizeof(PGPROC));
-	if (!procs)
-		ereport(FATAL,
-				(errcode(ERRCODE_OUT_OF_MEMORY),
-				 errmsg("out of shared memory")));
-	MemSet(procs, 0, autovacuum_max_workers * sizeof(PGPROC));
-	for (i = 0; i < autovacuum_max_workers; i++)
-	{
-		PGSemaphoreCreate(&(procs[i].sem));
-		InitSharedLatch(&(procs[i].procLatch));
-		procs[i].links.next = ProcGlobal->autovacFreeProcs;
-		ProcGlobal->autovacFreeProcs = MAKE_OFFSET(&procs[i]);
-	}
-
 	MemSet(AuxiliaryProcs, 0, NUM_AUXILIARY_PROCS * sizeof(PGPROC));
 	for (i = 0; i < NUM_AUXILIARY_PROCS; i++)
 	{
 		AuxiliaryProcs[i].pid = 0;		/* marks auxiliary proc as not in use */
 		PGSemaphoreCreate(&(AuxiliaryProcs[i].sem));
+		AuxiliaryProcs[i].backendLock = LWLockAssign();
 		InitSharedLatch(&(AuxiliaryProcs[i].procLatch));
 	}
 
@@ -384,8 +384,11 @@ InitProcess(void)
 	MyProc->waitProcLock = NULL;
 	MyProc->resWaiting = false;
 	MyProc->resSlotId = -1;
+	MyProc->waitEvent = WAIT_EVENT_NONE;
 	for (i = 0; i < NUM_LOCK_PARTITIONS; i++)
 		SHMQueueInit(&(MyProc->myProcLocks[i]));
+	/* the previous owner released all its fast-path locks */
+	Assert(MyProc->fpLockBits == 0);
 
     /* 
      * mppLocalProcessSerial uniquely identifies this backend process among
@@ -439,6 +442,9 @@ InitProcess(void)
 
 	MyProc->queryCommandId = -1;
 
+	/* Report wait events in our PGPROC from now on */
+	pgstat_set_wait_event_storage(&MyProc->waitEvent);
+
 	/*
 	 * Arrange to clean up at backend exit.
 	 */
@@ -571,6 +577,7 @@ InitAuxiliaryProcess(void)
 	MyProc->lwWaitLink = NULL;
 	MyProc->waitLock = NULL;
 	MyProc->waitProcLock = NULL;
+	MyProc->waitEvent = WAIT_EVENT_NONE;
 	for (i = 0; i < NUM_LOCK_PARTITIONS; i++)
 		SHMQueueInit(&(MyProc->myProcLocks[i]));
 
@@ -596,6 +603,8 @@ InitAuxiliaryProcess(void)
 
 	MyProc->queryCommandId = -1;
 
+	pgstat_set_wait_event_storage(&MyProc->waitEvent);
+
 	/*
 	 * Arrange to clean up at process exit.
 	 */
@@ -625,6 +634,9 @@ LockWaitCancel(void)
 {
 	LWLockId	partitionLock;
 
+	/* Drop the strong lock count of a relation lock we failed to get */
+	AbortStrongLockAcquire();
+
 	/* Nothing to do if we weren't waiting for a lock */
 	if (lockAwaited == NULL)
 		return;
@@ -797,6 +809,7 @@ ProcKill(int code, Datum arg)
 	 */
 	proc = MyProc;
 	MyProc = NULL;
+	pgstat_reset_wait_event_storage();
 	DisownLatch(&proc->procLatch);
 
 	SpinLockAcquire(ProcStructLock);
@@ -880,6 +893,7 @@ AuxiliaryProcKill(int code, Datum arg)
 
 	/* PGPROC struct isn't mine anymore */
 	MyProc = NULL;
+	pgstat_reset_wait_event_storage();
 	lockHolderProcPtr = NULL;
 }
 
@@ -53,6 +53,7 @@ test__RemoveLocalLock_Null(void **state)
 
 	/* Assume lockOwners is NULL and we go into cleanup */
 	locallock->lockOwners = NULL;
+	locallock->holdsStrongLockCount = false;
 	RemoveLocalLock(locallock);
 }
 
@@ -1501,6 +1501,30 @@ mdclose(SMgrRelation reln)
 	}
 }
 
+/*
+ *	mdprefetch() -- Initiate asynchronous read of the specified block
+ *				   of a relation.
+ *
+ *		Only the primary's copy is read, so only it is prefetched.
+ */
+void
+mdprefetch(SMgrRelation reln, BlockNumber blocknum)
+{
+	off_t		seekpos;
+	MdMirVec    *v;
+
+	v = _mdmir_getseg(reln, blocknum, false, EXTENSION_FAIL);
+
+	if (!StorageManagerMirrorMode_DoPrimaryWork(v->mdmir_open.mirrorMode))
+		return;
+
+	seekpos = (off_t) BLCKSZ * (blocknum % ((BlockNumber) RELSEG_SIZE));
+	Assert(seekpos < (off_t) BLCKSZ * RELSEG_SIZE);
+
+	/* Purely advisory; a failure just means the read is synchronous. */
+	(void) FilePrefetch(v->mdmir_open.primaryFile, seekpos, BLCKSZ);
+}
+
 /*
  *	mdread() -- Read the specified block from a relation.
  */
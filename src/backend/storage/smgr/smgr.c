@@ -1309,6 +1309,16 @@ smgrextend(SMgrRelation reln, BlockNumber blocknum, char *buffer, bool isTemp)
 	mdextend(reln, blocknum, buffer, isTemp);
 }
 
+/*
+ *	smgrprefetch() -- Initiate asynchronous read of the specified block
+ *				  of a relation.
+ */
+void
+smgrprefetch(SMgrRelation reln, BlockNumber blocknum)
+{
+	mdprefetch(reln, blocknum);
+}
+
 /*
  *	smgrread() -- read a particular block from a relation into the supplied
  *				  buffer.
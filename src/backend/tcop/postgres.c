@@ -89,7 +89,10 @@
 #include "cdb/cdbdtxcontextinfo.h"
 #include "cdb/cdbdisp_query.h"
 #include "cdb/cdbdispatchresult.h"
+#include "cdb/cdbendpoint.h"
+#include "cdb/cdbexplain.h"
 #include "cdb/cdbgang.h"
+#include "cdb/cdbstmtstats.h"
 #include "cdb/ml_ipc.h"
 #include "utils/guc.h"
 #include "access/twophase.h"
@@ -883,6 +886,7 @@ PlannedStmt *
 pg_plan_query(Query *querytree, int cursorOptions, ParamListInfo boundParams)
 {
 	PlannedStmt *plan;
+	instr_time	starttime;
 
 	/* Utility commands have no plans. */
 	if (querytree->commandType == CMD_UTILITY)
@@ -895,7 +899,9 @@ pg_plan_query(Query *querytree, int cursorOptions, ParamListInfo boundParams)
 		ResetUsage();
 
 	/* call the optimizer */
+	INSTR_TIME_SET_CURRENT(starttime);
 	plan = planner(querytree, cursorOptions, boundParams);
+	StmtStatsAddTime(STMT_PHASE_PLAN, starttime);
 
 	if (log_planner_stats)
 		ShowUsage("PLANNER STATISTICS");
@@ -1029,8 +1035,20 @@ exec_mpp_query(const char *query_string,
 	SliceTable *sliceTable = NULL;
     Slice      *slice = NULL;
 	ParamListInfo paramLI = NULL;
+	instr_time	starttime;
+	instr_time	endtime;
 
 	Assert(Gp_role == GP_ROLE_EXECUTE);
+
+	/*
+	 * Note when the command arrived, and how long each step takes on the
+	 * way to running it.  EXPLAIN ANALYZE sends these back to the QD.
+	 */
+	memset(&cdbexplain_qeDispatchTiming, 0, sizeof(cdbexplain_qeDispatchTiming));
+	cdbexplain_qeDispatchTiming.receivedAt = GetCurrentTimestamp();
+	INSTR_TIME_SET_CURRENT(cdbexplain_qeDispatchTiming.received);
+	cdbexplain_startSliceUsage();
+
 	/*
 	 * If we didn't get passed a query string, dummy something up for ps display and pg_stat_activity
 	 */
@@ -1088,12 +1106,14 @@ exec_mpp_query(const char *query_string,
 		utilityStmt = query->utilityStmt;
 	}
 
+	INSTR_TIME_SET_CURRENT(starttime);
+
  	/*
      * Deserialize the query execution plan (a PlannedStmt node), if there is one.
      */
 	if (serializedPlantree != NULL && serializedPlantreelen > 0)
 	{
-		plan = (PlannedStmt *) deserializeNode(serializedPlantree,serializedPlantreelen);
+		plan = (PlannedStmt *) deserializeNodeCached(serializedPlantree,serializedPlantreelen);
 		if (!plan || !IsA(plan, PlannedStmt))
 			elog(ERROR, "MPPEXEC: receive invalid planned statement");
     }
@@ -1129,6 +1149,10 @@ exec_mpp_query(const char *query_string,
 			AddPreassignedOids(ddesc->oidAssignments);
     }
 
+	INSTR_TIME_SET_CURRENT(endtime);
+	INSTR_TIME_SUBTRACT(endtime, starttime);
+	cdbexplain_qeDispatchTiming.deserializeTime = INSTR_TIME_GET_DOUBLE(endtime);
+
 	/*
 	 * Choose the command type from either the Query or the PlannedStmt.
 	 */
@@ -1361,7 +1385,11 @@ exec_mpp_query(const char *query_string,
 		/*
 		 * Start the portal.
 		 */
+		INSTR_TIME_SET_CURRENT(starttime);
 		PortalStart(portal, paramLI, InvalidSnapshot, ddesc);
+		INSTR_TIME_SET_CURRENT(endtime);
+		INSTR_TIME_SUBTRACT(endtime, starttime);
+		cdbexplain_qeDispatchTiming.executorStartTime = INSTR_TIME_GET_DOUBLE(endtime);
 
 		/*
 		 * Select text output format, the default.
@@ -1370,9 +1398,15 @@ exec_mpp_query(const char *query_string,
 		PortalSetResultFormat(portal, 1, &format);
 
 		/*
-		 * Now we can create the destination receiver object.
+		 * Now we can create the destination receiver object.  The root
+		 * slice of a PARALLEL RETRIEVE cursor sends its rows to an endpoint
+		 * instead of the QD.
 		 */
-		receiver = CreateDestReceiver(dest, portal);
+		if (plan && plan->parallelRetrieveToken &&
+			sliceTable && sliceTable->localSlice == 0)
+			receiver = CreateEndpointDestReceiver(plan->parallelRetrieveToken);
+		else
+			receiver = CreateDestReceiver(dest, portal);
 
 		/*
 		 * Switch back to transaction context for execution.
@@ -1382,6 +1416,7 @@ exec_mpp_query(const char *query_string,
 		/*
 		 * Run the portal to completion, and then drop it (and the receiver).
 		 */
+		INSTR_TIME_SET_CURRENT(cdbexplain_qeDispatchTiming.runStarted);
 		(void) PortalRun(portal,
 						 FETCH_ALL,
 						 true, /* Effectively always top level. */
@@ -1582,6 +1617,8 @@ exec_simple_query(const char *query_string, const char *seqServerHost, int seqSe
 
 	pgstat_report_activity(query_string);
 
+	StmtStatsStart(query_string);
+
 	/*
 	 * We use save_log_statement_stats so ShowUsage doesn't report incorrect
 	 * results because ResetUsage wasn't called.
@@ -1876,6 +1913,8 @@ exec_simple_query(const char *query_string, const char *seqServerHost, int seqSe
 	 */
 	finish_xact_command();
 
+	StmtStatsEnd();
+
 	/*
 	 * If there were no parsetrees, return EmptyQueryResponse message.
 	 */
@@ -2267,6 +2306,9 @@ exec_bind_message(StringInfo input_message)
 
 	set_ps_display("BIND", false);
 
+	/* Time the statement from Bind, which plans it, to its completion */
+	StmtStatsStart(psrc->query_string);
+
 	if (save_log_statement_stats)
 		ResetUsage();
 
@@ -2859,6 +2901,8 @@ exec_execute_message(const char *portal_name, int64 max_rows)
 			CommandCounterIncrement();
 		}
 
+		StmtStatsEnd();
+
 		/* Send appropriate CommandComplete to client */
 		EndCommand(completionTag, dest);
 	}
@@ -5046,6 +5090,7 @@ PostgresMain(int argc, char *argv[],
 					const char *serializedQueryDispatchDesc = NULL;
 					const char *seqServerHost = NULL;
 					const char *resgroupInfoBuf = NULL;
+					const char *sessionStateBuf = NULL;
 
 					int query_string_len = 0;
 					int serializedDtxContextInfolen = 0;
@@ -5056,6 +5101,7 @@ PostgresMain(int argc, char *argv[],
 					int seqServerHostlen = 0;
 					int seqServerPort = -1;
 					int resgroupInfoLen = 0;
+					int sessionStateLen = 0;
 
 					int localSlice = -1, i;
 					int rootIdx;
@@ -5157,6 +5203,10 @@ PostgresMain(int argc, char *argv[],
 					if (resgroupInfoLen > 0)
 						resgroupInfoBuf = pq_getmsgbytes(&input_message, resgroupInfoLen);
 
+					sessionStateLen = pq_getmsgint(&input_message, 4);
+					if (sessionStateLen > 0)
+						sessionStateBuf = pq_getmsgbytes(&input_message, sessionStateLen);
+
 					pq_getmsgend(&input_message);
 
 					elog((Debug_print_full_dtm ? LOG : DEBUG5), "MPP dispatched stmt from QD: %s.",query_string);
@@ -5176,6 +5226,13 @@ PostgresMain(int argc, char *argv[],
 
 					setupQEDtxContext(&TempDtxContextInfo);
 
+					/* catch up with SET commands issued on the QD */
+					if (sessionStateLen > 0)
+					{
+						start_xact_command();
+						ApplySessionState(sessionStateBuf, sessionStateLen);
+					}
+
 					if (cuid > 0)
 						SetUserIdAndContext(cuid, false); /* Set current userid */
 
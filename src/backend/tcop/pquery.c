@@ -977,6 +977,23 @@ PortalRun(Portal portal, int64 count, bool isTopLevel,
 			case PORTAL_ONE_RETURNING:
 			case PORTAL_UTIL_SELECT:
 
+				/*
+				 * GPDB: a RETRIEVE that is run to completion streams its
+				 * rows straight to the client.  Going through the tuplestore
+				 * would keep all the rows of the endpoint on this segment.
+				 */
+				if (!portal->holdStore && count == FETCH_ALL &&
+					IsA(PortalGetPrimaryStmt(portal), RetrieveStmt))
+				{
+					PortalRunUtility(portal, PortalGetPrimaryStmt(portal),
+									 isTopLevel, dest, completionTag);
+
+					portal->atEnd = true;
+					portal->status = PORTAL_DONE;
+					result = true;
+					break;
+				}
+
 				/*
 				 * If we have not yet run the command, do so, storing its
 				 * results in the portal's tuplestore.
@@ -1360,6 +1377,7 @@ PortalRunUtility(Portal portal, Node *utilityStmt, bool isTopLevel,
 		  IsA(utilityStmt, ConstraintsSetStmt) ||
 	/* efficiency hacks from here down */
 		  IsA(utilityStmt, FetchStmt) ||
+		  IsA(utilityStmt, RetrieveStmt) ||
 		  IsA(utilityStmt, ListenStmt) ||
 		  IsA(utilityStmt, NotifyStmt) ||
 		  IsA(utilityStmt, UnlistenStmt) ||
@@ -65,6 +65,7 @@
 #include "utils/syscache.h"
 
 #include "cdb/cdbdisp_query.h"
+#include "cdb/cdbendpoint.h"
 #include "cdb/cdbpartition.h"
 #include "cdb/cdbvars.h"
 
@@ -893,6 +894,11 @@ ProcessUtility(Node *parsetree,
 							   completionTag);
 			break;
 
+		case T_RetrieveStmt:
+			ExecRetrieveStmt((RetrieveStmt *) parsetree, dest,
+							 completionTag);
+			break;
+
 			/*
 			 * relation and attribute manipulation
 			 */
@@ -1108,7 +1114,8 @@ ProcessUtility(Node *parsetree,
 							CdbDispatchUtilityStatement((Node *) stmt,
 														DF_CANCEL_ON_ERROR|
 														DF_WITH_SNAPSHOT|
-														DF_NEED_TWO_PHASE,
+														DF_NEED_TWO_PHASE|
+														DF_PIPELINE,
 														NIL,
 														NULL);
 						}
@@ -1852,6 +1859,9 @@ UtilityReturnsTuples(Node *parsetree)
 				return portal->tupDesc ? true : false;
 			}
 
+		case T_RetrieveStmt:
+			return true;
+
 		case T_ExecuteStmt:
 			{
 				ExecuteStmt *stmt = (ExecuteStmt *) parsetree;
@@ -1904,6 +1914,9 @@ UtilityTupleDescriptor(Node *parsetree)
 				return CreateTupleDescCopy(portal->tupDesc);
 			}
 
+		case T_RetrieveStmt:
+			return GetRetrieveStmtTupleDesc((RetrieveStmt *) parsetree);
+
 		case T_ExecuteStmt:
 			{
 				ExecuteStmt *stmt = (ExecuteStmt *) parsetree;
@@ -2042,6 +2055,10 @@ CreateCommandTag(Node *parsetree)
 			}
 			break;
 
+		case T_RetrieveStmt:
+			tag = "RETRIEVE";
+			break;
+
 		case T_CreateDomainStmt:
 			tag = "CREATE DOMAIN";
 			break;
@@ -2848,6 +2865,10 @@ GetCommandLogLevel(Node *parsetree)
 			lev = LOGSTMT_ALL;
 			break;
 
+		case T_RetrieveStmt:
+			lev = LOGSTMT_ALL;
+			break;
+
 		case T_CreateDomainStmt:
 			lev = LOGSTMT_DDL;
 			break;
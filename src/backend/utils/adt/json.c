@@ -1304,6 +1304,7 @@ json_categorize_type(Oid typoid,
 			break;
 
 		case JSONOID:
+		case JSONBOID:
 			*tcategory = JSONTYPE_JSON;
 			break;
 
@@ -0,0 +1,1037 @@
+/*-------------------------------------------------------------------------
+ *
+ * jsonb.c
+ *		Support for jsonb, JSON kept in a binary format
+ *
+ * The text of a json value has to be parsed again by every -> or ->>. A
+ * jsonb value is parsed once, on input, into the format described in
+ * utils/jsonb.h: the operators then go straight to the key or element
+ * they want, with a binary search over an object's sorted keys.
+ *
+ * As in a JSON object, a key appears at most once in a jsonb object; if the
+ * input repeats a key, the last value wins. Whitespace and the order of the
+ * keys are not kept.
+ *
+ * Portions Copyright (c) 2012-Present Pivotal Software, Inc.
+ *
+ *
+ * IDENTIFICATION
+ *	    src/backend/utils/adt/jsonb.c
+ *
+ *-------------------------------------------------------------------------
+ */
+#include "postgres.h"
+
+#include <limits.h>
+
+#include "catalog/pg_type.h"
+#include "lib/stringinfo.h"
+#include "libpq/pqformat.h"
+#include "miscadmin.h"
+#include "utils/array.h"
+#include "utils/builtins.h"
+#include "utils/json.h"
+#include "utils/jsonapi.h"
+#include "utils/jsonb.h"
+
+/*
+ * A parsed JSON value, before it is laid out in the binary format.
+ */
+typedef enum JsonbValueType
+{
+	jbvNull,
+	jbvString,
+	jbvNumeric,
+	jbvBool,
+	jbvArray,
+	jbvObject
+} JsonbValueType;
+
+typedef struct JsonbValue JsonbValue;
+
+typedef struct JsonbPair
+{
+	char	   *key;
+	int			keylen;
+	int			order;			/* position in the input, to keep the last
+								 * of duplicate keys */
+	JsonbValue *value;
+} JsonbPair;
+
+struct JsonbValue
+{
+	JsonbValueType type;
+
+	/* jbvString, jbvNumeric: the de-escaped string or the number's text */
+	char	   *str;
+	int			len;
+
+	/* jbvBool */
+	bool		boolean;
+
+	/* jbvArray, jbvObject */
+	int			nchildren;
+	int			maxchildren;
+	JsonbValue **elems;			/* elements of an array */
+	JsonbPair  *pairs;			/* key/value pairs of an object */
+
+	JsonbValue *parent;
+};
+
+typedef struct JsonbParseState
+{
+	JsonbValue *root;
+	JsonbValue *current;		/* innermost open array or object */
+	char	   *key;			/* key of the object field being parsed */
+} JsonbParseState;
+
+static void jsonb_attach(JsonbParseState *state, JsonbValue *v);
+static void jsonb_in_object_start(void *pstate);
+static void jsonb_in_array_start(void *pstate);
+static void jsonb_in_end(void *pstate);
+static void jsonb_in_object_field_start(void *pstate, char *fname, bool isnull);
+static void jsonb_in_scalar(void *pstate, char *token, JsonTokenType tokentype);
+static int	jsonb_pair_cmp(const void *a, const void *b);
+static void jsonb_put_container(StringInfo buf, JsonbValue *v, uint32 flags);
+static JEntry jsonb_put_child(StringInfo buf, JsonbValue *v, int dataoff);
+static Jsonb *jsonb_from_text(text *json);
+static void jsonb_get_child(JsonbContainer *jc, int i,
+				uint32 *type, char **data, int *len);
+static int	jsonb_find_key(JsonbContainer *jc, const char *key, int keylen);
+static void jsonb_put_text(StringInfo out, JsonbContainer *jc);
+static void jsonb_put_scalar_text(StringInfo out, uint32 type,
+					  char *data, int len);
+static Datum jsonb_child_datum(JsonbContainer *jc, int i, bool as_text,
+				  bool *isnull);
+
+/*
+ * Parsing: the semantic actions of pg_parse_json() build a tree of
+ * JsonbValues.
+ */
+static JsonbValue *
+jsonb_new_value(JsonbValueType type)
+{
+	JsonbValue *v = palloc0(sizeof(JsonbValue));
+
+	v->type = type;
+	return v;
+}
+
+static void
+jsonb_attach(JsonbParseState *state, JsonbValue *v)
+{
+	JsonbValue *parent = state->current;
+
+	v->parent = parent;
+
+	if (parent == NULL)
+	{
+		state->root = v;
+		return;
+	}
+
+	if (parent->nchildren >= JB_CMASK)
+		ereport(ERROR,
+				(errcode(ERRCODE_PROGRAM_LIMIT_EXCEEDED),
+				 errmsg("number of jsonb %s elements exceeds the maximum allowed (%d)",
+						parent->type == jbvObject ? "object" : "array",
+						JB_CMASK)));
+
+	if (parent->nchildren == parent->maxchildren)
+	{
+		parent->maxchildren = parent->maxchildren == 0 ? 8 : parent->maxchildren * 2;
+		if (parent->type == jbvObject)
+			parent->pairs = parent->pairs == NULL ?
+				palloc(parent->maxchildren * sizeof(JsonbPair)) :
+				repalloc(parent->pairs, parent->maxchildren * sizeof(JsonbPair));
+		else
+			parent->elems = parent->elems == NULL ?
+				palloc(parent->maxchildren * sizeof(JsonbValue *)) :
+				repalloc(parent->elems, parent->maxchildren * sizeof(JsonbValue *));
+	}
+
+	if (parent->type == jbvObject)
+	{
+		JsonbPair  *pair = &parent->pairs[parent->nchildren];
+
+		pair->key = state->key;
+		pair->keylen = strlen(state->key);
+		pair->order = parent->nchildren;
+		pair->value = v;
+	}
+	else
+		parent->elems[parent->nchildren] = v;
+
+	parent->nchildren++;
+}
+
+static void
+jsonb_in_object_start(void *pstate)
+{
+	JsonbParseState *state = (JsonbParseState *) pstate;
+	JsonbValue *v = jsonb_new_value(jbvObject);
+
+	jsonb_attach(state, v);
+	state->current = v;
+}
+
+static void
+jsonb_in_array_start(void *pstate)
+{
+	JsonbParseState *state = (JsonbParseState *) pstate;
+	JsonbValue *v = jsonb_new_value(jbvArray);
+
+	jsonb_attach(state, v);
+	state->current = v;
+}
+
+static void
+jsonb_in_end(void *pstate)
+{
+	JsonbParseState *state = (JsonbParseState *) pstate;
+	JsonbValue *v = state->current;
+
+	/* Sort the keys, and keep only the last value of a repeated one. */
+	if (v->type == jbvObject && v->nchildren > 1)
+	{
+		int			i;
+		int			n = 0;
+
+		qsort(v->pairs, v->nchildren, sizeof(JsonbPair), jsonb_pair_cmp);
+
+		for (i = 1; i < v->nchildren; i++)
+		{
+			if (v->pairs[i].keylen == v->pairs[n].keylen &&
+				memcmp(v->pairs[i].key, v->pairs[n].key, v->pairs[i].keylen) == 0)
+				v->pairs[n] = v->pairs[i];
+			else
+				v->pairs[++n] = v->pairs[i];
+		}
+		v->nchildren = n + 1;
+	}
+
+	state->current = v->parent;
+}
+
+static void
+jsonb_in_object_field_start(void *pstate, char *fname, bool isnull)
+{
+	JsonbParseState *state = (JsonbParseState *) pstate;
+
+	/* the parser frees fname once the field is done */
+	state->key = pstrdup(fname);
+}
+
+static void
+jsonb_in_scalar(void *pstate, char *token, JsonTokenType tokentype)
+{
+	JsonbParseState *state = (JsonbParseState *) pstate;
+	JsonbValue *v;
+
+	switch (tokentype)
+	{
+		case JSON_TOKEN_STRING:
+			v = jsonb_new_value(jbvString);
+			v->str = token;
+			v->len = strlen(token);
+			break;
+		case JSON_TOKEN_NUMBER:
+			v = jsonb_new_value(jbvNumeric);
+			v->str = token;
+			v->len = strlen(token);
+			break;
+		case JSON_TOKEN_TRUE:
+			v = jsonb_new_value(jbvBool);
+			v->boolean = true;
+			break;
+		case JSON_TOKEN_FALSE:
+			v = jsonb_new_value(jbvBool);
+			v->boolean = false;
+			break;
+		default:
+			Assert(tokentype == JSON_TOKEN_NULL);
+			v = jsonb_new_value(jbvNull);
+			break;
+	}
+
+	jsonb_attach(state, v);
+}
+
+/*
+ * Keys are ordered by length first, then bytewise: cheaper to compare than
+ * a collation, and all a lookup needs. Equal keys stay in input order.
+ */
+static int
+jsonb_key_cmp(const char *a, int alen, const char *b, int blen)
+{
+	if (alen != blen)
+		return alen < blen ? -1 : 1;
+	return memcmp(a, b, alen);
+}
+
+static int
+jsonb_pair_cmp(const void *a, const void *b)
+{
+	const JsonbPair *pa = (const JsonbPair *) a;
+	const JsonbPair *pb = (const JsonbPair *) b;
+	int			cmp;
+
+	cmp = jsonb_key_cmp(pa->key, pa->keylen, pb->key, pb->keylen);
+	if (cmp == 0)
+		cmp = pa->order < pb->order ? -1 : 1;
+	return cmp;
+}
+
+/*
+ * Layout: write the container v, with the given flags in its header, at the
+ * end of buf, which must be 4-byte aligned.
+ */
+static void
+jsonb_put_container(StringInfo buf, JsonbValue *v, uint32 flags)
+{
+	int			n = v->nchildren;
+	int			nentries = v->type == jbvObject ? 2 * n : n;
+	int			hdroff;
+	int			dataoff;
+	uint32		header;
+	JEntry	   *entries;
+	int			i;
+
+	Assert(buf->len % sizeof(uint32) == 0);
+
+	/* reserve room for the header and the JEntrys */
+	hdroff = buf->len;
+	enlargeStringInfo(buf, sizeof(uint32) + nentries * sizeof(JEntry));
+	buf->len += sizeof(uint32) + nentries * sizeof(JEntry);
+	dataoff = buf->len;
+
+	entries = palloc((nentries + 1) * sizeof(JEntry));
+
+	if (v->type == jbvObject)
+	{
+		for (i = 0; i < n; i++)
+		{
+			JsonbValue	key;
+
+			key.type = jbvString;
+			key.str = v->pairs[i].key;
+			key.len = v->pairs[i].keylen;
+			entries[i] = jsonb_put_child(buf, &key, dataoff);
+		}
+		for (i = 0; i < n; i++)
+			entries[n + i] = jsonb_put_child(buf, v->pairs[i].value, dataoff);
+	}
+	else
+	{
+		for (i = 0; i < n; i++)
+			entries[i] = jsonb_put_child(buf, v->elems[i], dataoff);
+	}
+
+	header = n | flags;
+	memcpy(buf->data + hdroff, &header, sizeof(uint32));
+	memcpy(buf->data + hdroff + sizeof(uint32), entries, nentries * sizeof(JEntry));
+
+	pfree(entries);
+}
+
+static JEntry
+jsonb_put_child(StringInfo buf, JsonbValue *v, int dataoff)
+{
+	JEntry		type;
+	int			end;
+
+	switch (v->type)
+	{
+		case jbvNull:
+			type = JENTRY_ISNULL;
+			break;
+		case jbvBool:
+			type = v->boolean ? JENTRY_ISTRUE : JENTRY_ISFALSE;
+			break;
+		case jbvString:
+			appendBinaryStringInfo(buf, v->str, v->len);
+			type = JENTRY_ISSTRING;
+			break;
+		case jbvNumeric:
+			appendBinaryStringInfo(buf, v->str, v->len);
+			type = JENTRY_ISNUMERIC;
+			break;
+		default:
+			while (buf->len % sizeof(uint32) != 0)
+				appendStringInfoCharMacro(buf, '\0');
+			jsonb_put_container(buf, v,
+								v->type == jbvObject ? JB_FOBJECT : JB_FARRAY);
+			type = JENTRY_ISCONTAINER;
+			break;
+	}
+
+	end = buf->len - dataoff;
+	if (end > JENTRY_ENDMASK)
+		ereport(ERROR,
+				(errcode(ERRCODE_PROGRAM_LIMIT_EXCEEDED),
+				 errmsg("total size of jsonb elements exceeds the maximum of %u bytes",
+						JENTRY_ENDMASK)));
+
+	return type | end;
+}
+
+/*
+ * Parse the text of a JSON value into a new jsonb.
+ */
+static Jsonb *
+jsonb_from_text(text *json)
+{
+	JsonLexContext *lex = makeJsonLexContext(json, true);
+	JsonbParseState state;
+	JsonSemAction sem;
+	StringInfoData buf;
+	int32		vlen = 0;
+	Jsonb	   *result;
+
+	memset(&state, 0, sizeof(state));
+	memset(&sem, 0, sizeof(sem));
+	sem.semstate = (void *) &state;
+	sem.object_start = jsonb_in_object_start;
+	sem.object_end = jsonb_in_end;
+	sem.array_start = jsonb_in_array_start;
+	sem.array_end = jsonb_in_end;
+	sem.object_field_start = jsonb_in_object_field_start;
+	sem.scalar = jsonb_in_scalar;
+
+	pg_parse_json(lex, &sem);
+	Assert(state.root != NULL && state.current == NULL);
+
+	/* leave room for the varlena header, so that the alignment is right */
+	initStringInfo(&buf);
+	appendBinaryStringInfo(&buf, (char *) &vlen, VARHDRSZ);
+
+	if (state.root->type == jbvArray || state.root->type == jbvObject)
+		jsonb_put_container(&buf, state.root,
+							state.root->type == jbvObject ? JB_FOBJECT : JB_FARRAY);
+	else
+	{
+		JsonbValue	scalar;
+
+		memset(&scalar, 0, sizeof(scalar));
+		scalar.type = jbvArray;
+		scalar.nchildren = 1;
+		scalar.elems = &state.root;
+		jsonb_put_container(&buf, &scalar, JB_FARRAY | JB_FSCALAR);
+	}
+
+	result = (Jsonb *) buf.data;
+	SET_VARSIZE(result, buf.len);
+	return result;
+}
+
+/*
+ * Access: find the i'th child of a container. For an object, children
+ * 0 .. n-1 are the keys, and n .. 2n-1 their values.
+ */
+static void
+jsonb_get_child(JsonbContainer *jc, int i, uint32 *type, char **data, int *len)
+{
+	int			nentries = JsonbContainerSize(jc);
+	char	   *base;
+	uint32		start;
+	uint32		end;
+
+	if (JsonbContainerIsObject(jc))
+		nentries *= 2;
+	Assert(i >= 0 && i < nentries);
+
+	base = (char *) &jc->children[nentries];
+	start = i == 0 ? 0 : JBE_END(jc->children[i - 1]);
+	end = JBE_END(jc->children[i]);
+
+	*type = JBE_TYPE(jc->children[i]);
+	if (*type == JENTRY_ISCONTAINER)
+		start = INTALIGN(start);
+
+	*data = base + start;
+	*len = end - start;
+}
+
+/*
+ * Binary search for a key of an object. Returns the index of the child
+ * holding its value, or -1 if the object doesn't have the key.
+ */
+static int
+jsonb_find_key(JsonbContainer *jc, const char *key, int keylen)
+{
+	int			n = JsonbContainerSize(jc);
+	int			lo = 0;
+	int			hi = n;
+
+	Assert(JsonbContainerIsObject(jc));
+
+	while (lo < hi)
+	{
+		int			mid = lo + (hi - lo) / 2;
+		uint32		type;
+		char	   *data;
+		int			len;
+		int			cmp;
+
+		jsonb_get_child(jc, mid, &type, &data, &len);
+		cmp = jsonb_key_cmp(data, len, key, keylen);
+		if (cmp == 0)
+			return n + mid;
+		if (cmp < 0)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+
+	return -1;
+}
+
+/*
+ * Output: append the JSON text of a container, or of a scalar child.
+ */
+static void
+jsonb_put_text(StringInfo out, JsonbContainer *jc)
+{
+	int			n = JsonbContainerSize(jc);
+	uint32		type;
+	char	   *data;
+	int			len;
+	int			i;
+
+	if (JsonbContainerIsScalar(jc))
+	{
+		jsonb_get_child(jc, 0, &type, &data, &len);
+		jsonb_put_scalar_text(out, type, data, len);
+		return;
+	}
+
+	appendStringInfoChar(out, JsonbContainerIsObject(jc) ? '{' : '[');
+	for (i = 0; i < n; i++)
+	{
+		if (i > 0)
+			appendStringInfoString(out, ", ");
+		if (JsonbContainerIsObject(jc))
+		{
+			jsonb_get_child(jc, i, &type, &data, &len);
+			jsonb_put_scalar_text(out, type, data, len);
+			appendStringInfoString(out, ": ");
+			jsonb_get_child(jc, n + i, &type, &data, &len);
+		}
+		else
+			jsonb_get_child(jc, i, &type, &data, &len);
+		jsonb_put_scalar_text(out, type, data, len);
+	}
+	appendStringInfoChar(out, JsonbContainerIsObject(jc) ? '}' : ']');
+}
+
+static void
+jsonb_put_scalar_text(StringInfo out, uint32 type, char *data, int len)
+{
+	char	   *str;
+
+	switch (type)
+	{
+		case JENTRY_ISSTRING:
+			str = pnstrdup(data, len);
+			escape_json(out, str);
+			pfree(str);
+			break;
+		case JENTRY_ISNUMERIC:
+			appendBinaryStringInfo(out, data, len);
+			break;
+		case JENTRY_ISTRUE:
+			appendStringInfoString(out, "true");
+			break;
+		case JENTRY_ISFALSE:
+			appendStringInfoString(out, "false");
+			break;
+		case JENTRY_ISNULL:
+			appendStringInfoString(out, "null");
+			break;
+		case JENTRY_ISCONTAINER:
+			jsonb_put_text(out, (JsonbContainer *) data);
+			break;
+		default:
+			elog(ERROR, "unknown jsonb entry type 0x%08x", type);
+	}
+}
+
+/*
+ * Return the i'th child of a container, as a jsonb or as text. The text of
+ * a string is the string itself, and a JSON null is an SQL NULL.
+ */
+static Datum
+jsonb_child_datum(JsonbContainer *jc, int i, bool as_text, bool *isnull)
+{
+	uint32		type;
+	char	   *data;
+	int			len;
+	Jsonb	   *result;
+
+	jsonb_get_child(jc, i, &type, &data, &len);
+
+	*isnull = false;
+
+	if (as_text)
+	{
+		StringInfoData out;
+
+		switch (type)
+		{
+			case JENTRY_ISNULL:
+				*isnull = true;
+				return (Datum) 0;
+			case JENTRY_ISSTRING:
+			case JENTRY_ISNUMERIC:
+				return PointerGetDatum(cstring_to_text_with_len(data, len));
+			default:
+				initStringInfo(&out);
+				jsonb_put_scalar_text(&out, type, data, len);
+				return PointerGetDatum(cstring_to_text_with_len(out.data, out.len));
+		}
+	}
+
+	if (type == JENTRY_ISCONTAINER)
+	{
+		/* the offsets are relative, so the container can be copied as is */
+		result = palloc(VARHDRSZ + len);
+		SET_VARSIZE(result, VARHDRSZ + len);
+		memcpy(&result->root, data, len);
+	}
+	else
+	{
+		/* wrap the scalar in a one-element array, as jsonb_in would */
+		Size		size = offsetof(Jsonb, root.children) + sizeof(JEntry) + len;
+
+		result = palloc(size);
+		SET_VARSIZE(result, size);
+		result->root.header = 1 | JB_FARRAY | JB_FSCALAR;
+		result->root.children[0] = type | len;
+		memcpy(&result->root.children[1], data, len);
+	}
+
+	return JsonbGetDatum(result);
+}
+
+/*
+ * jsonb type input function
+ */
+Datum
+jsonb_in(PG_FUNCTION_ARGS)
+{
+	char	   *json = PG_GETARG_CSTRING(0);
+
+	PG_RETURN_JSONB(jsonb_from_text(cstring_to_text(json)));
+}
+
+/*
+ * jsonb type output function
+ */
+Datum
+jsonb_out(PG_FUNCTION_ARGS)
+{
+	Jsonb	   *jb = PG_GETARG_JSONB(0);
+	StringInfoData out;
+
+	initStringInfo(&out);
+	jsonb_put_text(&out, &jb->root);
+
+	PG_RETURN_CSTRING(out.data);
+}
+
+/*
+ * jsonb type recv function
+ *
+ * The binary form is a version byte followed by the JSON text, so that the
+ * wire format doesn't depend on the storage format.
+ */
+Datum
+jsonb_recv(PG_FUNCTION_ARGS)
+{
+	StringInfo	buf = (StringInfo) PG_GETARG_POINTER(0);
+	int			version = pq_getmsgint(buf, 1);
+	char	   *str;
+	int			nbytes;
+
+	if (version != 1)
+		ereport(ERROR,
+				(errcode(ERRCODE_INVALID_BINARY_REPRESENTATION),
+				 errmsg("unsupported jsonb version number %d", version)));
+
+	str = pq_getmsgtext(buf, buf->len - buf->cursor, &nbytes);
+
+	PG_RETURN_JSONB(jsonb_from_text(cstring_to_text_with_len(str, nbytes)));
+}
+
+/*
+ * jsonb type send function
+ */
+Datum
+jsonb_send(PG_FUNCTION_ARGS)
+{
+	Jsonb	   *jb = PG_GETARG_JSONB(0);
+	StringInfoData out;
+	StringInfoData buf;
+
+	initStringInfo(&out);
+	jsonb_put_text(&out, &jb->root);
+
+	pq_begintypsend(&buf);
+	pq_sendint(&buf, 1, 1);
+	pq_sendtext(&buf, out.data, out.len);
+	pfree(out.data);
+
+	PG_RETURN_BYTEA_P(pq_endtypsend(&buf));
+}
+
+/*
+ * Casts between json and jsonb.
+ */
+Datum
+json_to_jsonb(PG_FUNCTION_ARGS)
+{
+	text	   *json = PG_GETARG_TEXT_P(0);
+
+	PG_RETURN_JSONB(jsonb_from_text(json));
+}
+
+Datum
+jsonb_to_json(PG_FUNCTION_ARGS)
+{
+	Jsonb	   *jb = PG_GETARG_JSONB(0);
+	StringInfoData out;
+
+	initStringInfo(&out);
+	jsonb_put_text(&out, &jb->root);
+
+	PG_RETURN_TEXT_P(cstring_to_text_with_len(out.data, out.len));
+}
+
+/*
+ * Operators. They report the same errors as their json counterparts in
+ * jsonfuncs.c.
+ */
+static Datum
+jsonb_object_field_worker(FunctionCallInfo fcinfo, bool as_text)
+{
+	Jsonb	   *jb = PG_GETARG_JSONB(0);
+	text	   *key = PG_GETARG_TEXT_PP(1);
+	int			i;
+	Datum		result;
+	bool		isnull;
+
+	if (!JsonbContainerIsObject(&jb->root))
+		ereport(ERROR,
+				(errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+				 errmsg(JsonbContainerIsScalar(&jb->root) ?
+						"cannot extract element from a scalar" :
+						"cannot extract field from a non-object")));
+
+	i = jsonb_find_key(&jb->root, VARDATA_ANY(key), VARSIZE_ANY_EXHDR(key));
+	if (i < 0)
+		PG_RETURN_NULL();
+
+	result = jsonb_child_datum(&jb->root, i, as_text, &isnull);
+	if (isnull)
+		PG_RETURN_NULL();
+	PG_RETURN_DATUM(result);
+}
+
+Datum
+jsonb_object_field(PG_FUNCTION_ARGS)
+{
+	return jsonb_object_field_worker(fcinfo, false);
+}
+
+Datum
+jsonb_object_field_text(PG_FUNCTION_ARGS)
+{
+	return jsonb_object_field_worker(fcinfo, true);
+}
+
+static Datum
+jsonb_array_element_worker(FunctionCallInfo fcinfo, bool as_text)
+{
+	Jsonb	   *jb = PG_GETARG_JSONB(0);
+	int			element = PG_GETARG_INT32(1);
+	Datum		result;
+	bool		isnull;
+
+	if (!JsonbContainerIsArray(&jb->root) || JsonbContainerIsScalar(&jb->root))
+		ereport(ERROR,
+				(errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+				 errmsg(JsonbContainerIsScalar(&jb->root) ?
+						"cannot extract element from a scalar" :
+						"cannot extract array element from a non-array")));
+
+	if (element < 0 || element >= JsonbContainerSize(&jb->root))
+		PG_RETURN_NULL();
+
+	result = jsonb_child_datum(&jb->root, element, as_text, &isnull);
+	if (isnull)
+		PG_RETURN_NULL();
+	PG_RETURN_DATUM(result);
+}
+
+Datum
+jsonb_array_element(PG_FUNCTION_ARGS)
+{
+	return jsonb_array_element_worker(fcinfo, false);
+}
+
+Datum
+jsonb_array_element_text(PG_FUNCTION_ARGS)
+{
+	return jsonb_array_element_worker(fcinfo, true);
+}
+
+/*
+ * Follow a path of keys and array indexes. A path element that doesn't
+ * match the structure of the document gives NULL, as for json.
+ */
+static Datum
+jsonb_extract_path_worker(FunctionCallInfo fcinfo, bool as_text)
+{
+	Jsonb	   *jb = PG_GETARG_JSONB(0);
+	ArrayType  *path = PG_GETARG_ARRAYTYPE_P(1);
+	JsonbContainer *jc = &jb->root;
+	Datum	   *pathtext;
+	bool	   *pathnulls;
+	int			npath;
+	int			i;
+	int			child = -1;
+	Datum		result;
+	bool		isnull;
+
+	if (array_contains_nulls(path))
+		ereport(ERROR,
+				(errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+				 errmsg("cannot call function with null path elements")));
+
+	deconstruct_array(path, TEXTOID, -1, false, 'i',
+					  &pathtext, &pathnulls, &npath);
+
+	if (npath == 0 || JsonbContainerIsScalar(jc))
+		PG_RETURN_NULL();
+
+	for (i = 0; i < npath; i++)
+	{
+		text	   *elem = DatumGetTextPP(pathtext[i]);
+		char	   *str = VARDATA_ANY(elem);
+		int			len = VARSIZE_ANY_EXHDR(elem);
+
+		if (len == 0)
+			ereport(ERROR,
+					(errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+				   errmsg("cannot call function with empty path elements")));
+
+		/* descend into the child found at the previous step */
+		if (child >= 0)
+		{
+			uint32		type;
+			char	   *data;
+			int			datalen;
+
+			jsonb_get_child(jc, child, &type, &data, &datalen);
+			if (type != JENTRY_ISCONTAINER)
+				PG_RETURN_NULL();
+			jc = (JsonbContainer *) data;
+		}
+
+		if (JsonbContainerIsObject(jc))
+			child = jsonb_find_key(jc, str, len);
+		else
+		{
+			char	   *cstr = pnstrdup(str, len);
+			char	   *endptr;
+			long		ind;
+
+			ind = strtol(cstr, &endptr, 10);
+			if (*endptr != '\0' || ind < 0 || ind >= JsonbContainerSize(jc))
+				child = -1;
+			else
+				child = (int) ind;
+			pfree(cstr);
+		}
+
+		if (child < 0)
+			PG_RETURN_NULL();
+	}
+
+	result = jsonb_child_datum(jc, child, as_text, &isnull);
+	if (isnull)
+		PG_RETURN_NULL();
+	PG_RETURN_DATUM(result);
+}
+
+Datum
+jsonb_extract_path(PG_FUNCTION_ARGS)
+{
+	return jsonb_extract_path_worker(fcinfo, false);
+}
+
+Datum
+jsonb_extract_path_text(PG_FUNCTION_ARGS)
+{
+	return jsonb_extract_path_worker(fcinfo, true);
+}
+
+/*
+ * jsonb ? text: does the top-level object have the key, or the top-level
+ * array the string element?
+ */
+Datum
+jsonb_exists(PG_FUNCTION_ARGS)
+{
+	Jsonb	   *jb = PG_GETARG_JSONB(0);
+	text	   *key = PG_GETARG_TEXT_PP(1);
+	char	   *keystr = VARDATA_ANY(key);
+	int			keylen = VARSIZE_ANY_EXHDR(key);
+	int			i;
+
+	if (JsonbContainerIsObject(&jb->root))
+		PG_RETURN_BOOL(jsonb_find_key(&jb->root, keystr, keylen) >= 0);
+
+	for (i = 0; i < JsonbContainerSize(&jb->root); i++)
+	{
+		uint32		type;
+		char	   *data;
+		int			len;
+
+		jsonb_get_child(&jb->root, i, &type, &data, &len);
+		if (type == JENTRY_ISSTRING && len == keylen &&
+			memcmp(data, keystr, len) == 0)
+			PG_RETURN_BOOL(true);
+	}
+
+	PG_RETURN_BOOL(false);
+}
+
+/*
+ * Containment. An object contains another if it has each of the other's
+ * keys, with a value that contains the other's value. An array contains
+ * another if each of the other's elements is contained in one of its own;
+ * an array also contains a lone scalar that is one of its elements. Scalars
+ * contain only equal scalars: numbers compare as numeric, strings bytewise.
+ */
+static bool
+jsonb_scalar_equal(uint32 type, char *adata, int alen, char *bdata, int blen)
+{
+	char	   *astr;
+	char	   *bstr;
+	bool		result;
+
+	if (type != JENTRY_ISSTRING && type != JENTRY_ISNUMERIC)
+		return true;			/* true, false and null have no data */
+
+	if (alen == blen && memcmp(adata, bdata, alen) == 0)
+		return true;
+	if (type == JENTRY_ISSTRING)
+		return false;
+
+	/* the same number may be written differently, as 1 and 1.0 */
+	astr = pnstrdup(adata, alen);
+	bstr = pnstrdup(bdata, blen);
+	result = DatumGetBool(DirectFunctionCall2(numeric_eq,
+				DirectFunctionCall3(numeric_in, CStringGetDatum(astr),
+									ObjectIdGetDatum(InvalidOid),
+									Int32GetDatum(-1)),
+				DirectFunctionCall3(numeric_in, CStringGetDatum(bstr),
+									ObjectIdGetDatum(InvalidOid),
+									Int32GetDatum(-1))));
+	pfree(astr);
+	pfree(bstr);
+	return result;
+}
+
+static bool
+jsonb_deep_contains(JsonbContainer *a, JsonbContainer *b)
+{
+	int			na = JsonbContainerSize(a);
+	int			nb = JsonbContainerSize(b);
+	int			i;
+	int			j;
+
+	check_stack_depth();
+
+	if (JsonbContainerIsObject(a) != JsonbContainerIsObject(b))
+		return false;
+	if (JsonbContainerIsScalar(a) && !JsonbContainerIsScalar(b))
+		return false;
+
+	for (i = 0; i < nb; i++)
+	{
+		uint32		btype;
+		char	   *bdata;
+		int			blen;
+		int			lo;
+		int			hi;
+		bool		found = false;
+
+		/* an object's value is compared with one value, an element with all */
+		if (JsonbContainerIsObject(b))
+		{
+			uint32		ktype;
+			char	   *kdata;
+			int			klen;
+
+			jsonb_get_child(b, i, &ktype, &kdata, &klen);
+			lo = jsonb_find_key(a, kdata, klen);
+			if (lo < 0)
+				return false;
+			hi = lo + 1;
+			jsonb_get_child(b, nb + i, &btype, &bdata, &blen);
+		}
+		else
+		{
+			lo = 0;
+			hi = na;
+			jsonb_get_child(b, i, &btype, &bdata, &blen);
+		}
+
+		for (j = lo; j < hi && !found; j++)
+		{
+			uint32		atype;
+			char	   *adata;
+			int			alen;
+
+			jsonb_get_child(a, j, &atype, &adata, &alen);
+			if (atype != btype)
+				continue;
+			if (atype == JENTRY_ISCONTAINER)
+				found = jsonb_deep_contains((JsonbContainer *) adata,
+											(JsonbContainer *) bdata);
+			else
+				found = jsonb_scalar_equal(atype, adata, alen, bdata, blen);
+		}
+
+		if (!found)
+			return false;
+	}
+
+	return true;
+}
+
+/*
+ * jsonb @> jsonb
+ */
+Datum
+jsonb_contains(PG_FUNCTION_ARGS)
+{
+	Jsonb	   *a = PG_GETARG_JSONB(0);
+	Jsonb	   *b = PG_GETARG_JSONB(1);
+
+	PG_RETURN_BOOL(jsonb_deep_contains(&a->root, &b->root));
+}
+
+/*
+ * jsonb <@ jsonb
+ */
+Datum
+jsonb_contained(PG_FUNCTION_ARGS)
+{
+	Jsonb	   *a = PG_GETARG_JSONB(0);
+	Jsonb	   *b = PG_GETARG_JSONB(1);
+
+	PG_RETURN_BOOL(jsonb_deep_contains(&b->root, &a->root));
+}
@@ -3210,18 +3210,185 @@ float8_avg(PG_FUNCTION_ARGS)
 }
 
 /* 
- * AVG for numeric types
+ * AVG (and SUM) for numeric types
+ *
+ * While every input has the same display scale and fits in an int64 once
+ * scaled by 10^dscale -- which is the case for any numeric(p,s) column with
+ * p <= 18 -- the sum is kept as a 128-bit fixed-point integer, so a row
+ * costs one integer add instead of a NumericVar add and re-packing the
+ * result.  An int128 cannot overflow from adding up fewer than 2^63 such
+ * values, so the only way out of the fast path is an input that doesn't
+ * qualify, at which point the sum is converted to a regular numeric.
  */
 
+#if defined(__SIZEOF_INT128__)
+#define NUMERIC_FIXED_ACCUM
+typedef __int128 int128;
+typedef unsigned __int128 uint128;
+
+/* Largest display scale the fixed-point sum is used for */
+#define NUMERIC_FIXED_MAX_SCALE 18
+#endif
+
 typedef struct NumericAvgTransData
 {
 	int32 _len; /* varattrib len, do not touch directly */
-#if 1
-	int32   pad;  /* pad so int64 and float64 will be 8 bytes alligned */
-#endif
+	int32 fixscale;	/* dscale of a fixed-point sum, or -1 if sum is numeric */
 	int64 count; 
-	NumericData sum;
+	NumericData sum;	/* or an int128, unaligned, when fixscale >= 0 */
 } NumericAvgTransData;
+
+#define NUMERIC_AVG_TRANS_IS_EMPTY(tr) \
+	(!(tr) || VARSIZE(tr) < sizeof(NumericAvgTransData))
+
+#ifdef NUMERIC_FIXED_ACCUM
+
+#define NUMERIC_AVG_FIXED_LEN \
+	Max(offsetof(NumericAvgTransData, sum) + sizeof(int128), \
+		sizeof(NumericAvgTransData))
+
+static const int64 fixed_pow10[NUMERIC_FIXED_MAX_SCALE + 1] = {
+	INT64CONST(1), INT64CONST(10), INT64CONST(100), INT64CONST(1000),
+	INT64CONST(10000), INT64CONST(100000), INT64CONST(1000000),
+	INT64CONST(10000000), INT64CONST(100000000), INT64CONST(1000000000),
+	INT64CONST(10000000000), INT64CONST(100000000000),
+	INT64CONST(1000000000000), INT64CONST(10000000000000),
+	INT64CONST(100000000000000), INT64CONST(1000000000000000),
+	INT64CONST(10000000000000000), INT64CONST(100000000000000000),
+	INT64CONST(1000000000000000000)
+};
+
+static inline int128
+num_avg_get_fixsum(NumericAvgTransData *tr)
+{
+	int128		sum;
+
+	memcpy(&sum, &tr->sum, sizeof(sum));
+	return sum;
+}
+
+static inline void
+num_avg_set_fixsum(NumericAvgTransData *tr, int128 sum)
+{
+	memcpy(&tr->sum, &sum, sizeof(sum));
+}
+
+/*
+ * numeric_to_fixed() -
+ *
+ *	Return num * 10^dscale in *result if num is not NaN, its dscale is at
+ *	most NUMERIC_FIXED_MAX_SCALE and the scaled value fits in an int64.
+ */
+static bool
+numeric_to_fixed(Numeric num, int64 *result)
+{
+	NumericDigit *digits = NUMERIC_DIGITS(num);
+	int			ndigits = NUMERIC_NDIGITS(num);
+	int			dscale = NUMERIC_DSCALE(num);
+	int			exp10;
+	int128		val = 0;
+	int			i;
+
+	if (NUMERIC_IS_NAN(num) || dscale > NUMERIC_FIXED_MAX_SCALE)
+		return false;
+
+	/* 19 decimal digits is as much as an int64 can hold */
+	if (ndigits > (19 + 2 * DEC_DIGITS - 1) / DEC_DIGITS)
+		return false;
+
+	for (i = 0; i < ndigits; i++)
+		val = val * NBASE + digits[i];
+
+	/*
+	 * The last stored digit is worth NBASE^(weight - ndigits + 1); scale
+	 * that to 10^-dscale.  Digits past dscale are always zero, so dividing
+	 * out the difference is exact.
+	 */
+	exp10 = (NUMERIC_WEIGHT(num) - ndigits + 1) * DEC_DIGITS + dscale;
+	if (ndigits == 0)
+		exp10 = 0;
+	if (exp10 < 0)
+	{
+		if (-exp10 >= DEC_DIGITS)
+			return false;		/* not a normalized numeric */
+		val /= fixed_pow10[-exp10];
+	}
+	else if (exp10 > 0)
+	{
+		if (exp10 > NUMERIC_FIXED_MAX_SCALE ||
+			val > PG_INT64_MAX / fixed_pow10[exp10])
+			return false;
+		val *= fixed_pow10[exp10];
+	}
+
+	if (val > PG_INT64_MAX)
+		return false;
+
+	*result = (NUMERIC_SIGN(num) == NUMERIC_NEG) ? -(int64) val : (int64) val;
+	return true;
+}
+
+/*
+ * fixed_to_var() -
+ *
+ *	Convert sum / 10^dscale to a NumericVar.
+ */
+static void
+fixed_to_var(int128 sum, int dscale, NumericVar *var)
+{
+	NumericDigit buf[(39 + DEC_DIGITS - 1) / DEC_DIGITS + NUMERIC_FIXED_MAX_SCALE];
+	int			nbuf = 0;
+	int			nfrac = (dscale + DEC_DIGITS - 1) / DEC_DIGITS;
+	uint128		absval = (sum < 0) ? -(uint128) sum : (uint128) sum;
+	uint128		intpart = absval / (uint128) fixed_pow10[dscale];
+	uint128		fracpart = absval % (uint128) fixed_pow10[dscale];
+	int			i;
+
+	/* fractional digits, least significant first, padded to whole digits */
+	fracpart *= (uint128) fixed_pow10[nfrac * DEC_DIGITS - dscale];
+	for (i = 0; i < nfrac; i++)
+	{
+		buf[nbuf++] = (NumericDigit) (fracpart % NBASE);
+		fracpart /= NBASE;
+	}
+	while (intpart > 0)
+	{
+		buf[nbuf++] = (NumericDigit) (intpart % NBASE);
+		intpart /= NBASE;
+	}
+
+	init_alloc_var(var, nbuf);
+	for (i = 0; i < nbuf; i++)
+		var->digits[i] = buf[nbuf - 1 - i];
+	var->weight = nbuf - nfrac - 1;
+	var->sign = (sum < 0) ? NUMERIC_NEG : NUMERIC_POS;
+	var->dscale = dscale;
+	strip_var(var);
+}
+#endif   /* NUMERIC_FIXED_ACCUM */
+
+/*
+ * Set var to the sum held in tr, whichever form it is in.  A numeric sum is
+ * referenced in place, so tr must outlive var.
+ */
+static void
+num_avg_sum_var(NumericAvgTransData *tr, NumericVar *var)
+{
+#ifdef NUMERIC_FIXED_ACCUM
+	if (tr->fixscale >= 0)
+	{
+		fixed_to_var(num_avg_get_fixsum(tr), tr->fixscale, var);
+		return;
+	}
+#endif
+	init_ro_var_from_num((Numeric) (&(tr->sum)), var);
+}
+
+static inline bool
+num_avg_sum_is_nan(NumericAvgTransData *tr)
+{
+	return tr->fixscale < 0 && NUMERIC_IS_NAN((Numeric) (&(tr->sum)));
+}
 	
 static inline NumericAvgTransData *num_avg_store_sum(NumericAvgTransData* tr, NumericVar *var)
 {
@@ -3229,6 +3396,7 @@ static inline NumericAvgTransData *num_avg_store_sum(NumericAvgTransData* tr, Nu
 	int newlen = 0;
 	Numeric num_sum = (Numeric) (&(tr->sum));
 
+	tr->fixscale = -1;
 	newlen = make_result_inplace(var, num_sum, oldlen);
 	if(newlen != 0)
 	{
@@ -3236,6 +3404,7 @@ static inline NumericAvgTransData *num_avg_store_sum(NumericAvgTransData* tr, Nu
 		int newtrlen = newlen + offsetof(NumericAvgTransData, sum) + 10;
 		tr = palloc(newtrlen);
 		SET_VARSIZE(tr, newtrlen);
+		tr->fixscale = -1;
 		tr->count = oldtr->count;
 		num_sum = (Numeric) (&(tr->sum));
 
@@ -3256,12 +3425,32 @@ static inline NumericAvgTransData *num_avg_store_sum(NumericAvgTransData* tr, Nu
 static Datum 
 numeric_avg_accum_decum(NumericAvgTransData *tr, Numeric newval, bool acc) 
 {
-	if(!tr || VARSIZE(tr) < sizeof(NumericAvgTransData))
+#ifdef NUMERIC_FIXED_ACCUM
+	int64		fixval;
+	bool		isfixed = numeric_to_fixed(newval, &fixval);
+#endif
+
+	if(NUMERIC_AVG_TRANS_IS_EMPTY(tr))
 	{
-		/* Give it 5 extra digits hope that we do not need to palloc immediately */
-		int len = offsetof(NumericAvgTransData, sum) + VARSIZE(newval) + 10;
-		
+		int len;
+
 		Assert(acc);
+
+#ifdef NUMERIC_FIXED_ACCUM
+		if (isfixed)
+		{
+			tr = (NumericAvgTransData *) palloc(NUMERIC_AVG_FIXED_LEN);
+			SET_VARSIZE(tr, NUMERIC_AVG_FIXED_LEN);
+			tr->fixscale = NUMERIC_DSCALE(newval);
+			tr->count = 1;
+			num_avg_set_fixsum(tr, (int128) fixval);
+
+			return PointerGetDatum(tr);
+		}
+#endif
+
+		/* Give it 5 extra digits hope that we do not need to palloc immediately */
+		len = offsetof(NumericAvgTransData, sum) + VARSIZE(newval) + 10;
 		
 		/* Per comments in review CR-206 we assume that the newval arguement
 		 * is a plain (untoasted) 4-byte-header Datum, so we can copy the
@@ -3269,6 +3458,7 @@ numeric_avg_accum_decum(NumericAvgTransData *tr, Numeric newval, bool acc)
 		 */
 		tr = (NumericAvgTransData *) palloc(len); 
 		SET_VARSIZE(tr, len); 
+		tr->fixscale = -1;
 		tr->count = 1;
 		memcpy(&(tr->sum), newval, VARSIZE(newval));
 
@@ -3276,14 +3466,22 @@ numeric_avg_accum_decum(NumericAvgTransData *tr, Numeric newval, bool acc)
 	}
 	else
 	{
-		Numeric num_sum = (Numeric) (&(tr->sum));
-
 		if(acc)
 			++tr->count;
 		else 
 			--tr->count;
 
-		if(NUMERIC_IS_NAN(newval) || NUMERIC_IS_NAN(num_sum))
+#ifdef NUMERIC_FIXED_ACCUM
+		if (isfixed && tr->fixscale == NUMERIC_DSCALE(newval))
+		{
+			int128		sum = num_avg_get_fixsum(tr);
+
+			num_avg_set_fixsum(tr, acc ? sum + fixval : sum - fixval);
+			return PointerGetDatum(tr);
+		}
+#endif
+
+		if(NUMERIC_IS_NAN(newval) || num_avg_sum_is_nan(tr))
 			tr = num_avg_store_sum(tr, &const_nan);
 		else
 		{
@@ -3291,8 +3489,9 @@ numeric_avg_accum_decum(NumericAvgTransData *tr, Numeric newval, bool acc)
 			NumericVar v2;
 			NumericVar result;
 
+			quick_init_var(&v1);
 			quick_init_var(&result);
-			init_ro_var_from_num(num_sum, &v1);
+			num_avg_sum_var(tr, &v1);
 			init_ro_var_from_num(newval, &v2);
 
 			if(acc)
@@ -3342,25 +3541,33 @@ numeric_avg_decum(PG_FUNCTION_ARGS)
 static Datum numeric_avg_amalg_demalg(NumericAvgTransData* tr0, NumericAvgTransData* tr1, bool amalg)
 {
 
-	if(!tr0 || VARSIZE(tr0) < sizeof(NumericAvgTransData))
+	if(NUMERIC_AVG_TRANS_IS_EMPTY(tr0))
 	{
 		Assert(amalg);
 		return PointerGetDatum(tr1);
 	}
 
-	if(!tr1 || VARSIZE(tr1) < sizeof(NumericAvgTransData))
+	if(NUMERIC_AVG_TRANS_IS_EMPTY(tr1))
 		return PointerGetDatum(tr0);
 	else
 	{
-		Numeric n0 = (Numeric) (&(tr0->sum));
-		Numeric n1 = (Numeric) (&(tr1->sum));
-
 		if(amalg)
 			tr0->count += tr1->count;
 		else
 			tr0->count -= tr1->count;
 
-		if(NUMERIC_IS_NAN(n0) || NUMERIC_IS_NAN(n1))
+#ifdef NUMERIC_FIXED_ACCUM
+		if (tr0->fixscale >= 0 && tr0->fixscale == tr1->fixscale)
+		{
+			int128		sum0 = num_avg_get_fixsum(tr0);
+			int128		sum1 = num_avg_get_fixsum(tr1);
+
+			num_avg_set_fixsum(tr0, amalg ? sum0 + sum1 : sum0 - sum1);
+			return PointerGetDatum(tr0);
+		}
+#endif
+
+		if(num_avg_sum_is_nan(tr0) || num_avg_sum_is_nan(tr1))
 			tr0 = num_avg_store_sum(tr0, &const_nan);
 		else
 		{
@@ -3368,9 +3575,11 @@ static Datum numeric_avg_amalg_demalg(NumericAvgTransData* tr0, NumericAvgTransD
 			NumericVar v1;
 			NumericVar result;
 
+			quick_init_var(&v0);
+			quick_init_var(&v1);
 			quick_init_var(&result);
-			init_ro_var_from_num(n0, &v0);
-			init_ro_var_from_num(n1, &v1);
+			num_avg_sum_var(tr0, &v0);
+			num_avg_sum_var(tr1, &v1);
 
 			if(amalg)
 				add_var(&v0, &v1, &result);
@@ -3402,6 +3611,24 @@ Datum numeric_avg_demalg(PG_FUNCTION_ARGS)
 	return numeric_avg_amalg_demalg(tr0, tr1, false);
 }
 
+/*
+ * Return the sum held in tr as a freshly palloc'd numeric.
+ */
+static Numeric
+num_avg_sum_result(NumericAvgTransData *tr)
+{
+	NumericVar	sumvar;
+	Numeric		result;
+
+	quick_init_var(&sumvar);
+	num_avg_sum_var(tr, &sumvar);
+	result = make_result(&sumvar);
+	if (tr->fixscale >= 0)
+		free_var(&sumvar);
+
+	return result;
+}
+
 Datum
 numeric_avg(PG_FUNCTION_ARGS)
 {
@@ -3411,18 +3638,39 @@ numeric_avg(PG_FUNCTION_ARGS)
 	Datum result;
 
 	/* SQL92 defines AVG of no values to be NULL */
-	if(!tr || VARSIZE(tr) < sizeof(NumericAvgTransData) || tr->count == 0)
+	if(NUMERIC_AVG_TRANS_IS_EMPTY(tr) || tr->count == 0)
 		PG_RETURN_NULL();
 
 	countX = DirectFunctionCall1(int8_numeric, Int64GetDatum(tr->count));
-	sumX = (Numeric) (&(tr->sum));
+	sumX = num_avg_sum_result(tr);
 
 	result = DirectFunctionCall2(numeric_div, NumericGetDatum(sumX), countX); 
 	pfree(DatumGetPointer(countX));
+	pfree(sumX);
 
 	return result;
 }
 
+/*
+ * SUM(numeric) final function; SUM shares AVG's transition functions so it
+ * gets the same fixed-point fast path.
+ */
+Datum
+numeric_sum(PG_FUNCTION_ARGS)
+{
+	NumericAvgTransData *tr = (NumericAvgTransData *) PG_GETARG_BYTEA_P(0); 
+
+	/*
+	 * SUM of no values is NULL, too.  But a state whose rows have all been
+	 * taken out again by numeric_avg_decum or numeric_avg_demalg sums to
+	 * zero, as it did when SUM's inverse functions were numeric_sub.
+	 */
+	if(NUMERIC_AVG_TRANS_IS_EMPTY(tr))
+		PG_RETURN_NULL();
+
+	PG_RETURN_NUMERIC(num_avg_sum_result(tr));
+}
+
 /* ----------------------------------------------------------------------
  *
  * Debug support
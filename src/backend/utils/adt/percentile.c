@@ -15,6 +15,10 @@
  *-------------------------------------------------------------------------
  */
 #include "postgres.h"
+
+#include <math.h>
+
+#include "lib/tdigest.h"
 #include "utils/builtins.h"
 #include "utils/datum.h"
 #include "utils/lsyscache.h"
@@ -266,3 +270,81 @@ percentile_disc_trans(PG_FUNCTION_ARGS)
 
 	PG_RETURN_NULL();
 }
+
+/*
+ * approx_percentile(value float8, fraction float8) aggregate.
+ *
+ * Unlike percentile_cont(), this doesn't need its input sorted: each value
+ * goes into a t-digest, and the preliminary function merges the digests of
+ * the segments, so it can be computed in two stages. The transition state
+ * is a bytea that starts out empty; the digest is allocated on the first
+ * value, and remembers the fraction asked for, which should be the same in
+ * every row. NaNs are ignored.
+ */
+typedef struct ApproxPercentileState
+{
+	int32		vl_len_;		/* varlena header (do not touch directly!) */
+	float8		fraction;
+	TDigest		digest;
+} ApproxPercentileState;
+
+#define APPROX_PERCENTILE_IS_EMPTY(state) \
+	(VARSIZE(state) != sizeof(ApproxPercentileState))
+
+Datum
+approx_percentile_accum(PG_FUNCTION_ARGS)
+{
+	ApproxPercentileState *state = (ApproxPercentileState *) PG_GETARG_BYTEA_P(0);
+	float8		value = PG_GETARG_FLOAT8(1);
+
+	Assert(fcinfo->context && IS_AGG_EXECUTION_NODE(fcinfo->context));
+
+	if (APPROX_PERCENTILE_IS_EMPTY(state))
+	{
+		float8		fraction = PG_GETARG_FLOAT8(2);
+
+		if (fraction < 0.0 || fraction > 1.0)
+			ereport(ERROR,
+					(errcode(ERRCODE_NUMERIC_VALUE_OUT_OF_RANGE),
+					 errmsg("input is out of range"),
+					 errhint("Argument to percentile function must be between 0.0 and 1.0.")));
+
+		state = (ApproxPercentileState *) palloc(sizeof(ApproxPercentileState));
+		SET_VARSIZE(state, sizeof(ApproxPercentileState));
+		state->fraction = fraction;
+		tdigest_init(&state->digest);
+	}
+
+	if (!isnan(value))
+		tdigest_add(&state->digest, value);
+
+	PG_RETURN_BYTEA_P(state);
+}
+
+Datum
+approx_percentile_merge(PG_FUNCTION_ARGS)
+{
+	ApproxPercentileState *state = (ApproxPercentileState *) PG_GETARG_BYTEA_P(0);
+	ApproxPercentileState *other = (ApproxPercentileState *) PG_GETARG_BYTEA_P(1);
+
+	if (APPROX_PERCENTILE_IS_EMPTY(other))
+		PG_RETURN_BYTEA_P(state);
+	if (APPROX_PERCENTILE_IS_EMPTY(state))
+		PG_RETURN_BYTEA_P(other);
+
+	tdigest_merge(&state->digest, &other->digest);
+
+	PG_RETURN_BYTEA_P(state);
+}
+
+Datum
+approx_percentile_final(PG_FUNCTION_ARGS)
+{
+	ApproxPercentileState *state = (ApproxPercentileState *) PG_GETARG_BYTEA_P(0);
+
+	/* like percentile_cont(), NULL if there were no values */
+	if (APPROX_PERCENTILE_IS_EMPTY(state) || state->digest.total == 0.0)
+		PG_RETURN_NULL();
+
+	PG_RETURN_FLOAT8(tdigest_quantile(&state->digest, state->fraction));
+}
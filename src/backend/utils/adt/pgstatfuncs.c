@@ -15,11 +15,15 @@
 #include "postgres.h"
 
 #include "storage/lock.h"
+#include "access/aosegfiles.h"
+#include "access/heapam.h"
+#include "catalog/pg_class.h"
 #include "commands/resgroupcmds.h"
 #include "funcapi.h"
 #include "miscadmin.h"
 #include "pgstat.h"
 #include "catalog/pg_type.h"
+#include "storage/proc.h"
 #include "utils/builtins.h"
 #include "utils/fmgroids.h"
 #include "utils/guc.h"
@@ -44,6 +48,8 @@ extern Datum pg_stat_get_last_vacuum_time(PG_FUNCTION_ARGS);
 extern Datum pg_stat_get_last_autovacuum_time(PG_FUNCTION_ARGS);
 extern Datum pg_stat_get_last_analyze_time(PG_FUNCTION_ARGS);
 extern Datum pg_stat_get_last_autoanalyze_time(PG_FUNCTION_ARGS);
+extern Datum gp_stat_get_changes_since_analyze(PG_FUNCTION_ARGS);
+extern Datum gp_wait_event_samples(PG_FUNCTION_ARGS);
 
 extern Datum pg_stat_get_backend_idset(PG_FUNCTION_ARGS);
 extern Datum pg_stat_get_activity(PG_FUNCTION_ARGS);
@@ -356,6 +362,142 @@ pg_stat_get_last_autoanalyze_time(PG_FUNCTION_ARGS)
 		PG_RETURN_TIMESTAMPTZ(result);
 }
 
+/* what gp_stat_get_changes_since_analyze collects about each table */
+typedef struct RelChanges
+{
+	Oid			relid;
+	char		relstorage;
+	int64		modcount;
+} RelChanges;
+
+/*
+ * gp_stat_get_changes_since_analyze
+ *		One row for every table of the current database, with what has
+ *		changed in it since it was last analyzed.
+ *
+ * For heap tables that is the collector's count of tuples inserted,
+ * updated or deleted since the last ANALYZE.  For AO and AOCS tables it is
+ * the sum of the segment files' modcounts, which the caller has to compare
+ * against the sum it saw when it last analyzed the table.  This lets
+ * analyzedb find the tables that need analyzing in a single query, instead
+ * of one query per table.
+ */
+Datum
+gp_stat_get_changes_since_analyze(PG_FUNCTION_ARGS)
+{
+	FuncCallContext *funcctx;
+	RelChanges *rels;
+
+	if (SRF_IS_FIRSTCALL())
+	{
+		MemoryContext oldcontext;
+		TupleDesc	tupdesc;
+		Relation	pg_class_rel;
+		HeapScanDesc scan;
+		HeapTuple	tuple;
+		int			nrels = 0;
+		int			maxrels = 64;
+
+		funcctx = SRF_FIRSTCALL_INIT();
+		oldcontext = MemoryContextSwitchTo(funcctx->multi_call_memory_ctx);
+
+		tupdesc = CreateTemplateTupleDesc(5, false);
+		TupleDescInitEntry(tupdesc, (AttrNumber) 1, "relid",
+						   OIDOID, -1, 0);
+		TupleDescInitEntry(tupdesc, (AttrNumber) 2, "relstorage",
+						   CHAROID, -1, 0);
+		TupleDescInitEntry(tupdesc, (AttrNumber) 3, "modcount",
+						   INT8OID, -1, 0);
+		TupleDescInitEntry(tupdesc, (AttrNumber) 4, "changes_since_analyze",
+						   INT8OID, -1, 0);
+		TupleDescInitEntry(tupdesc, (AttrNumber) 5, "last_analyze",
+						   TIMESTAMPTZOID, -1, 0);
+		funcctx->tuple_desc = BlessTupleDesc(tupdesc);
+
+		rels = palloc(maxrels * sizeof(RelChanges));
+
+		pg_class_rel = heap_open(RelationRelationId, AccessShareLock);
+		scan = heap_beginscan(pg_class_rel, SnapshotNow, 0, NULL);
+		while ((tuple = heap_getnext(scan, ForwardScanDirection)) != NULL)
+		{
+			Form_pg_class classForm = (Form_pg_class) GETSTRUCT(tuple);
+
+			if (classForm->relkind != RELKIND_RELATION)
+				continue;
+			if (classForm->relstorage != RELSTORAGE_HEAP &&
+				classForm->relstorage != RELSTORAGE_AOROWS &&
+				classForm->relstorage != RELSTORAGE_AOCOLS)
+				continue;
+
+			if (nrels >= maxrels)
+			{
+				maxrels *= 2;
+				rels = repalloc(rels, maxrels * sizeof(RelChanges));
+			}
+			rels[nrels].relid = HeapTupleGetOid(tuple);
+			rels[nrels].relstorage = classForm->relstorage;
+			if (classForm->relstorage == RELSTORAGE_HEAP)
+				rels[nrels].modcount = 0;
+			else
+				rels[nrels].modcount =
+					GetAOModCount(rels[nrels].relid,
+								  classForm->relstorage == RELSTORAGE_AOCOLS,
+								  SnapshotNow);
+			nrels++;
+		}
+		heap_endscan(scan);
+		heap_close(pg_class_rel, AccessShareLock);
+
+		funcctx->user_fctx = rels;
+		funcctx->max_calls = nrels;
+
+		MemoryContextSwitchTo(oldcontext);
+	}
+
+	funcctx = SRF_PERCALL_SETUP();
+	rels = (RelChanges *) funcctx->user_fctx;
+
+	if (funcctx->call_cntr < funcctx->max_calls)
+	{
+		RelChanges *rel = &rels[funcctx->call_cntr];
+		PgStat_StatTabEntry *tabentry;
+		TimestampTz lastAnalyze = 0;
+		Datum		values[5];
+		bool		nulls[5];
+		HeapTuple	tuple;
+
+		MemSet(nulls, false, sizeof(nulls));
+
+		values[0] = ObjectIdGetDatum(rel->relid);
+		values[1] = CharGetDatum(rel->relstorage);
+
+		if (rel->relstorage == RELSTORAGE_HEAP)
+			nulls[2] = true;
+		else
+			values[2] = Int64GetDatum(rel->modcount);
+
+		tabentry = pgstat_fetch_stat_tabentry(rel->relid);
+		if (tabentry == NULL)
+			nulls[3] = true;
+		else
+		{
+			values[3] = Int64GetDatum((int64) tabentry->changes_since_analyze);
+			lastAnalyze = Max(tabentry->analyze_timestamp,
+							  tabentry->autovac_analyze_timestamp);
+		}
+
+		if (lastAnalyze == 0)
+			nulls[4] = true;
+		else
+			values[4] = TimestampTzGetDatum(lastAnalyze);
+
+		tuple = heap_form_tuple(funcctx->tuple_desc, values, nulls);
+		SRF_RETURN_NEXT(funcctx, HeapTupleGetDatum(tuple));
+	}
+
+	SRF_RETURN_DONE(funcctx);
+}
+
 Datum
 pg_stat_get_backend_idset(PG_FUNCTION_ARGS)
 {
@@ -1277,3 +1419,153 @@ pg_stat_reset(PG_FUNCTION_ARGS)
 
 	PG_RETURN_VOID();
 }
+
+typedef struct WaitEventSampleKey
+{
+	int			sessionId;
+	int			commandCount;
+	uint32		waitEvent;
+} WaitEventSampleKey;
+
+typedef struct WaitEventSample
+{
+	WaitEventSampleKey key;
+	int64		samples;
+} WaitEventSample;
+
+typedef struct WaitEventSamplerState
+{
+	HASH_SEQ_STATUS seq;
+	int64		rounds;
+} WaitEventSamplerState;
+
+/*
+ * gp_wait_event_samples
+ *		Sample the wait events of the backends of this database instance
+ *		every interval_ms milliseconds, for duration_ms milliseconds, and
+ *		report how many times each query was seen waiting on each event.
+ *
+ * Each backend reports what it's waiting on in its PGPROC (see
+ * pgstat_report_wait_start()), so taking a sample is just a pass over the
+ * PGPROC array without any locking.  Dividing samples by sample_rounds
+ * gives the average number of the query's backends waiting on the event.
+ */
+Datum
+gp_wait_event_samples(PG_FUNCTION_ARGS)
+{
+	FuncCallContext *funcctx;
+	WaitEventSamplerState *state;
+	WaitEventSample *entry;
+
+	if (SRF_IS_FIRSTCALL())
+	{
+		MemoryContext oldcontext;
+		TupleDesc	tupdesc;
+		HASHCTL		hash_ctl;
+		HTAB	   *samples;
+		int32		duration_ms = PG_GETARG_INT32(0);
+		int32		interval_ms = PG_GETARG_INT32(1);
+		TimestampTz endtime;
+
+		if (duration_ms < 0)
+			ereport(ERROR,
+					(errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+					 errmsg("sampling duration must not be negative")));
+		if (interval_ms <= 0)
+			ereport(ERROR,
+					(errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+					 errmsg("sampling interval must be positive")));
+
+		funcctx = SRF_FIRSTCALL_INIT();
+		oldcontext = MemoryContextSwitchTo(funcctx->multi_call_memory_ctx);
+
+		tupdesc = CreateTemplateTupleDesc(6, false);
+		TupleDescInitEntry(tupdesc, (AttrNumber) 1, "segid",
+						   INT4OID, -1, 0);
+		TupleDescInitEntry(tupdesc, (AttrNumber) 2, "sess_id",
+						   INT4OID, -1, 0);
+		TupleDescInitEntry(tupdesc, (AttrNumber) 3, "command_count",
+						   INT4OID, -1, 0);
+		TupleDescInitEntry(tupdesc, (AttrNumber) 4, "wait_event",
+						   TEXTOID, -1, 0);
+		TupleDescInitEntry(tupdesc, (AttrNumber) 5, "samples",
+						   INT8OID, -1, 0);
+		TupleDescInitEntry(tupdesc, (AttrNumber) 6, "sample_rounds",
+						   INT8OID, -1, 0);
+		funcctx->tuple_desc = BlessTupleDesc(tupdesc);
+
+		MemSet(&hash_ctl, 0, sizeof(hash_ctl));
+		hash_ctl.keysize = sizeof(WaitEventSampleKey);
+		hash_ctl.entrysize = sizeof(WaitEventSample);
+		hash_ctl.hash = tag_hash;
+		hash_ctl.hcxt = funcctx->multi_call_memory_ctx;
+		samples = hash_create("wait event samples", 64, &hash_ctl,
+							  HASH_ELEM | HASH_FUNCTION | HASH_CONTEXT);
+
+		state = palloc0(sizeof(WaitEventSamplerState));
+
+		endtime = TimestampTzPlusMilliseconds(GetCurrentTimestamp(), duration_ms);
+		for (;;)
+		{
+			int			i;
+
+			for (i = 0; i < ProcGlobal->numProcs; i++)
+			{
+				volatile PGPROC *proc = &ProcGlobal->procs[i];
+				WaitEventSampleKey key;
+				bool		found;
+
+				if (proc == MyProc || proc->pid == 0)
+					continue;
+
+				MemSet(&key, 0, sizeof(key));
+				key.waitEvent = proc->waitEvent;
+				if (key.waitEvent == WAIT_EVENT_NONE)
+					continue;
+				key.sessionId = proc->mppSessionId;
+				key.commandCount = proc->queryCommandId;
+
+				entry = (WaitEventSample *) hash_search(samples, &key,
+														HASH_ENTER, &found);
+				if (!found)
+					entry->samples = 0;
+				entry->samples++;
+			}
+			state->rounds++;
+
+			if (GetCurrentTimestamp() >= endtime)
+				break;
+			pg_usleep(interval_ms * 1000L);
+			CHECK_FOR_INTERRUPTS();
+		}
+
+		hash_seq_init(&state->seq, samples);
+		funcctx->user_fctx = state;
+
+		MemoryContextSwitchTo(oldcontext);
+	}
+
+	funcctx = SRF_PERCALL_SETUP();
+	state = (WaitEventSamplerState *) funcctx->user_fctx;
+
+	if ((entry = (WaitEventSample *) hash_seq_search(&state->seq)) != NULL)
+	{
+		Datum		values[6];
+		bool		nulls[6];
+		HeapTuple	tuple;
+
+		MemSet(nulls, false, sizeof(nulls));
+
+		values[0] = Int32GetDatum(GpIdentity.segindex);
+		values[1] = Int32GetDatum(entry->key.sessionId);
+		values[2] = Int32GetDatum(entry->key.commandCount);
+		values[3] = CStringGetTextDatum(pgstat_get_wait_event(entry->key.waitEvent));
+		values[4] = Int64GetDatum(entry->samples);
+		values[5] = Int64GetDatum(state->rounds);
+
+		tuple = heap_form_tuple(funcctx->tuple_desc, values, nulls);
+		SRF_RETURN_NEXT(funcctx, HeapTupleGetDatum(tuple));
+	}
+
+	SRF_RETURN_DONE(funcctx);
+}
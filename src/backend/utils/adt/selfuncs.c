@@ -2611,6 +2611,112 @@ fail:
 }
 
 
+/*
+ * find_attribute_dependencies
+ *		Find how much the columns of a relation determine each other.
+ *
+ * attnums[] are nattrs columns of the base relation at range table index
+ * varno.  On return, degrees[i] is the degree (see STATISTIC_KIND_DEPENDENCY)
+ * to which another of the columns determines attnums[i], or 0 if none does
+ * or ANALYZE did not collect dependencies.  The caller can then treat column
+ * i as contributing only a (1 - degrees[i]) share of its own selectivity or
+ * number of distinct values.
+ *
+ * Dependencies are chosen greedily, the strongest first, and a column whose
+ * values are implied by another is not used to imply any other column, so
+ * that two columns that determine each other are not both discounted.
+ */
+void
+find_attribute_dependencies(PlannerInfo *root, Index varno, int nattrs,
+							const AttrNumber *attnums, double *degrees)
+{
+	RangeTblEntry *rte = planner_rt_fetch(varno, root);
+	double	   *matrix;			/* matrix[i * nattrs + j]: i determines j */
+	bool	   *implied;
+	bool		found = false;
+	int			i,
+				j;
+
+	for (i = 0; i < nattrs; i++)
+		degrees[i] = 0.0;
+
+	if (nattrs < 2 || rte->rtekind != RTE_RELATION)
+		return;
+
+	matrix = (double *) palloc0(nattrs * nattrs * sizeof(double));
+	implied = (bool *) palloc0(nattrs * sizeof(bool));
+
+	for (i = 0; i < nattrs; i++)
+	{
+		HeapTuple	statsTuple;
+		float4	   *numbers;
+		int			nnumbers;
+		int			k;
+
+		if (attnums[i] <= 0)
+			continue;
+
+		statsTuple = SearchSysCache(STATRELATT,
+									ObjectIdGetDatum(rte->relid),
+									Int16GetDatum(attnums[i]),
+									0, 0);
+		if (!HeapTupleIsValid(statsTuple))
+			continue;
+
+		if (get_attstatsslot(statsTuple, InvalidOid, 0,
+							 STATISTIC_KIND_DEPENDENCY, InvalidOid,
+							 NULL, NULL, &numbers, &nnumbers))
+		{
+			for (k = 0; k + 1 < nnumbers; k += 2)
+			{
+				for (j = 0; j < nattrs; j++)
+				{
+					if (j != i && attnums[j] == (AttrNumber) numbers[k])
+					{
+						matrix[i * nattrs + j] = numbers[k + 1];
+						found = true;
+					}
+				}
+			}
+			free_attstatsslot(InvalidOid, NULL, 0, numbers, nnumbers);
+		}
+		ReleaseSysCache(statsTuple);
+	}
+
+	while (found)
+	{
+		double		best = 0.0;
+		int			besti = -1;
+		int			bestj = -1;
+
+		for (i = 0; i < nattrs; i++)
+		{
+			if (implied[i])
+				continue;
+			for (j = 0; j < nattrs; j++)
+			{
+				if (implied[j] || attnums[j] == attnums[i])
+					continue;
+				if (matrix[i * nattrs + j] > best)
+				{
+					best = matrix[i * nattrs + j];
+					besti = i;
+					bestj = j;
+				}
+			}
+		}
+
+		if (besti < 0)
+			break;
+
+		implied[bestj] = true;
+		degrees[bestj] = Min(best, 1.0);
+	}
+
+	pfree(matrix);
+	pfree(implied);
+}
+
 /*
  * Helper routine for estimate_num_groups: add an item to a list of
  * GroupVarInfos, but only if it's not known equal to any of the existing
@@ -2731,6 +2837,10 @@ add_unique_group_var(PlannerInfo *root, List *varinfos,
  *		by the restriction selectivity is effectively assuming that the
  *		restriction clauses are independent of the grouping, which is a crummy
  *		assumption, but it's hard to do better.
+ *		If ANALYZE collected dependencies between the columns, a Var that
+ *		another Var of the rel determines to degree d contributes only its
+ *		number of values to the power (1 - d); see
+ *		find_attribute_dependencies().
  *	5.	If there are Vars from multiple rels, we repeat step 4 for each such
  *		rel, and multiply the results together.
  * Note that rels not containing grouped Vars are ignored completely, as are
@@ -2848,14 +2958,15 @@ estimate_num_groups(PlannerInfo *root, List *groupExprs, double input_rows)
 	{
 		GroupVarInfo *varinfo1 = (GroupVarInfo *) linitial(varinfos);
 		RelOptInfo *rel = varinfo1->rel;
-		double		reldistinct = varinfo1->ndistinct;
-		double		relmaxndistinct = reldistinct;
+		double		reldistinct = 1.0;
+		double		relmaxndistinct = varinfo1->ndistinct;
 		int			relvarcount = 1;
+		List	   *relvarinfos = list_make1(varinfo1);
 		List	   *newvarinfos = NIL;
 
 		/*
-		 * Get the product of numdistinct estimates of the Vars for this rel.
-		 * Also, construct new varinfos list of remaining Vars.
+		 * Collect the Vars for this rel. Also, construct new varinfos list of
+		 * remaining Vars.
 		 */
 		for_each_cell(l, lnext(list_head(varinfos)))
 		{
@@ -2863,7 +2974,7 @@ estimate_num_groups(PlannerInfo *root, List *groupExprs, double input_rows)
 
 			if (varinfo2->rel == varinfo1->rel)
 			{
-				reldistinct *= varinfo2->ndistinct;
+				relvarinfos = lappend(relvarinfos, varinfo2);
 				if (relmaxndistinct < varinfo2->ndistinct)
 					relmaxndistinct = varinfo2->ndistinct;
 				relvarcount++;
@@ -2875,6 +2986,46 @@ estimate_num_groups(PlannerInfo *root, List *groupExprs, double input_rows)
 			}
 		}
 
+		/*
+		 * Get the product of numdistinct estimates of the Vars for this rel,
+		 * discounting the Vars determined by others.
+		 */
+		{
+			AttrNumber *attnums = (AttrNumber *) palloc(relvarcount * sizeof(AttrNumber));
+			double	   *degrees = (double *) palloc(relvarcount * sizeof(double));
+			int			n = 0;
+
+			foreach(l, relvarinfos)
+			{
+				GroupVarInfo *varinfo2 = (GroupVarInfo *) lfirst(l);
+				Var		   *var = (Var *) varinfo2->var;
+
+				if (IsA(var, Var) && var->varlevelsup == 0 &&
+					var->varno == rel->relid)
+					attnums[n++] = var->varattno;
+				else
+					attnums[n++] = InvalidAttrNumber;
+			}
+
+			if (rel->reloptkind == RELOPT_BASEREL)
+				find_attribute_dependencies(root, rel->relid, relvarcount,
+											attnums, degrees);
+			else
+				memset(degrees, 0, relvarcount * sizeof(double));
+
+			n = 0;
+			foreach(l, relvarinfos)
+			{
+				GroupVarInfo *varinfo2 = (GroupVarInfo *) lfirst(l);
+
+				reldistinct *= pow(varinfo2->ndistinct, 1.0 - degrees[n++]);
+			}
+
+			pfree(attnums);
+			pfree(degrees);
+			list_free(relvarinfos);
+		}
+
 		/*
 		 * Sanity check --- don't divide by zero if empty relation.
 		 */
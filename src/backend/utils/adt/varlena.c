@@ -3286,6 +3286,114 @@ md5_bytea(PG_FUNCTION_ARGS)
 	PG_RETURN_TEXT_P(cstring_to_text(hexsum));
 }
 
+/*
+ * gp_unordered_md5(text) aggregate
+ *
+ * Digest of a set of strings that does not depend on the order they come
+ * in: the md5 of each value is split into two 64-bit halves, and each half
+ * is summed up separately, modulo 2^64.  Two sets get the same digest if
+ * they hold the same values, duplicates included.  gpcheckcat uses it to
+ * compare a catalog table across segments without moving its rows.
+ *
+ * The transition state is a bytea, empty until the first value is added,
+ * then holding the two sums.
+ */
+#define UNORDERED_MD5_SIZE	(VARHDRSZ + 2 * sizeof(uint64))
+
+static bytea *
+unordered_md5_for_update(bytea *state)
+{
+	if (VARSIZE(state) != UNORDERED_MD5_SIZE)
+	{
+		state = palloc0(UNORDERED_MD5_SIZE);
+		SET_VARSIZE(state, UNORDERED_MD5_SIZE);
+	}
+	return state;
+}
+
+static void
+unordered_md5_add(bytea *state, const uint8 *sum)
+{
+	uint64		halves[2];
+	int			i;
+	int			j;
+
+	memcpy(halves, VARDATA(state), sizeof(halves));
+	for (i = 0; i < 2; i++)
+	{
+		uint64		h = 0;
+
+		/* read the digest big-endian, so every platform sums the same */
+		for (j = 0; j < 8; j++)
+			h = (h << 8) | sum[i * 8 + j];
+		halves[i] += h;
+	}
+	memcpy(VARDATA(state), halves, sizeof(halves));
+}
+
+Datum
+gp_unordered_md5_accum(PG_FUNCTION_ARGS)
+{
+	bytea	   *state = PG_GETARG_BYTEA_P(0);
+	text	   *in = PG_GETARG_TEXT_PP(1);
+	uint8		sum[16];
+
+	Assert(fcinfo->context && IS_AGG_EXECUTION_NODE(fcinfo->context));
+
+	if (!pg_md5_binary(VARDATA_ANY(in), VARSIZE_ANY_EXHDR(in), sum))
+		ereport(ERROR,
+				(errcode(ERRCODE_OUT_OF_MEMORY),
+				 errmsg("out of memory")));
+
+	state = unordered_md5_for_update(state);
+	unordered_md5_add(state, sum);
+
+	PG_RETURN_BYTEA_P(state);
+}
+
+Datum
+gp_unordered_md5_merge(PG_FUNCTION_ARGS)
+{
+	bytea	   *state = PG_GETARG_BYTEA_P(0);
+	bytea	   *other = PG_GETARG_BYTEA_P(1);
+	uint64		halves[2];
+	uint8		sum[16];
+	int			i;
+	int			j;
+
+	if (VARSIZE(other) != UNORDERED_MD5_SIZE)
+		PG_RETURN_BYTEA_P(state);
+
+	/* turn the other partial sums back into bytes, and add them as one value */
+	memcpy(halves, VARDATA(other), sizeof(halves));
+	for (i = 0; i < 2; i++)
+		for (j = 0; j < 8; j++)
+			sum[i * 8 + j] = (uint8) (halves[i] >> (56 - 8 * j));
+
+	state = unordered_md5_for_update(state);
+	unordered_md5_add(state, sum);
+
+	PG_RETURN_BYTEA_P(state);
+}
+
+Datum
+gp_unordered_md5_final(PG_FUNCTION_ARGS)
+{
+	bytea	   *state = PG_GETARG_BYTEA_P(0);
+	uint64		halves[2] = {0, 0};
+	char		hexsum[MD5_HASH_LEN + 1];
+	int			i;
+
+	if (VARSIZE(state) == UNORDERED_MD5_SIZE)
+		memcpy(halves, VARDATA(state), sizeof(halves));
+
+	for (i = 0; i < MD5_HASH_LEN; i++)
+		hexsum[i] = "0123456789abcdef"[(halves[i / 16] >> (60 - 4 * (i % 16))) & 0xf];
+	hexsum[MD5_HASH_LEN] = '\0';
+
+	PG_RETURN_TEXT_P(cstring_to_text(hexsum));
+}
+
 /*
  * Return the size of a datum, possibly compressed
  *
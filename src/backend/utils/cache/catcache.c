@@ -35,6 +35,7 @@
 #include "utils/relcache.h"
 #include "utils/rel.h"
 #include "utils/resowner.h"
+#include "utils/sharedcatcache.h"
 #include "utils/syscache.h"
 #include "utils/tqual.h"
 
@@ -872,6 +873,7 @@ CatalogCacheInitializeCache(CatCache *cache)
 	/*
 	 * initialize cache's key information
 	 */
+	cache->cc_shareable = true;
 	for (i = 0; i < cache->cc_nkeys; ++i)
 	{
 		Oid			keytype;
@@ -894,6 +896,12 @@ CatalogCacheInitializeCache(CatCache *cache)
 
 		cache->cc_isname[i] = (keytype == NAMEOID);
 
+		/* the shared tier only compares keys of up to 32 bits */
+		if (cache->cc_key[i] > 0 &&
+			(!tupdesc->attrs[cache->cc_key[i] - 1]->attbyval ||
+			 tupdesc->attrs[cache->cc_key[i] - 1]->attlen > sizeof(uint32)))
+			cache->cc_shareable = false;
+
 		/*
 		 * Do equality-function lookup (we assume this won't need a catalog
 		 * lookup for any supported type)
@@ -1098,6 +1106,8 @@ SearchCatCache(CatCache *cache,
 	Relation	relation;
 	SysScanDesc scandesc;
 	HeapTuple	ntp;
+	bool		shared;
+	uint64		sharedGeneration = 0;
 
 	/*
 	 * one-time startup overhead for each cache
@@ -1206,9 +1216,38 @@ SearchCatCache(CatCache *cache,
 	 * will eventually age out of the cache, so there's no functional problem.
 	 * This case is rare enough that it's not worth expending extra cycles to
 	 * detect.
+	 *
+	 * Another backend may have read the tuple already and left it in the
+	 * shared catalog cache, in which case we take it from there.
 	 */
+	shared = SharedCatCacheUsable(cache);
+	if (shared)
+	{
+		ntp = SharedCatCacheLookup(cache, hashValue, cur_skey);
+		if (ntp != NULL)
+		{
+			ct = CatalogCacheCreateEntry(cache, ntp,
+										 hashValue, hashIndex,
+										 false);
+			pfree(ntp);
+
+			ResourceOwnerEnlargeCatCacheRefs(CurrentResourceOwner);
+			ct->refcount++;
+			ResourceOwnerRememberCatCacheRef(CurrentResourceOwner, &ct->tuple);
+
+			CACHE2_elog(DEBUG2, "SearchCatCache(%s): found in shared cache",
+						cache->cc_relname);
+
+			return &ct->tuple;
+		}
+	}
+
 	relation = heap_open(cache->cc_reloid, AccessShareLock);
 
+	/* A tuple read after this may be offered to the shared cache */
+	if (shared)
+		sharedGeneration = SharedCatCacheGeneration();
+
 	scandesc = systable_beginscan(relation,
 								  cache->cc_indexoid,
 								  IndexScanOK(cache, cur_skey),
@@ -1234,6 +1273,9 @@ SearchCatCache(CatCache *cache,
 		ct = CatalogCacheCreateEntry(cache, ntp,
 									 hashValue, hashIndex,
 									 false);
+		if (shared)
+			SharedCatCacheInsert(cache, hashValue, cur_skey,
+								 &ct->tuple, sharedGeneration);
 		/* immediately set the refcount to 1 */
 		ResourceOwnerEnlargeCatCacheRefs(CurrentResourceOwner);
 		ct->refcount++;
@@ -97,6 +97,7 @@
 #include "utils/inval.h"
 #include "utils/memutils.h"
 #include "utils/relcache.h"
+#include "utils/sharedcatcache.h"
 #include "utils/simex.h"
 #include "utils/syscache.h"
 
@@ -415,6 +416,23 @@ ProcessInvalidationMessageMulti(InvalidationListHeader *hdr,
 	ProcessMessageListMulti(hdr->rclist, func(msgs, n));
 }
 
+/*
+ * Count the messages in a list
+ */
+static int
+CountInvalidationMessages(InvalidationListHeader *hdr)
+{
+	InvalidationChunk *chunk;
+	int			count = 0;
+
+	for (chunk = hdr->cclist; chunk != NULL; chunk = chunk->next)
+		count += chunk->nitems;
+	for (chunk = hdr->rclist; chunk != NULL; chunk = chunk->next)
+		count += chunk->nitems;
+
+	return count;
+}
+
 /* ----------------------------------------------------------------
  *					  private support functions
  * ----------------------------------------------------------------
@@ -525,6 +543,9 @@ LocalExecuteInvalidationMessage(SharedInvalidationMessage *msg)
 
 	if (msg->id >= 0)
 	{
+		/* The shared catalog cache has entries of all databases */
+		SharedCatCacheInvalidate(msg->cc.dbId, msg->cc.id, msg->cc.hashValue);
+
 		if (msg->cc.dbId == MyDatabaseId || msg->cc.dbId == 0)
 		{
 			CatalogCacheIdInvalidate(msg->cc.id,
@@ -589,6 +610,7 @@ InvalidateSystemCaches(void)
 	int			i;
 
 	ResetCatalogCaches();
+	SharedCatCacheReset();
 	RelationCacheInvalidate();	/* gets smgr cache too */
 
 	for (i = 0; i < syscache_callback_count; i++)
@@ -971,8 +993,18 @@ AtEOXact_Inval(bool isCommit)
 		AppendInvalidationMessages(&transInvalInfo->PriorCmdInvalidMsgs,
 								   &transInvalInfo->CurrentCmdInvalidMsgs);
 
-		ProcessInvalidationMessageMulti(&transInvalInfo->PriorCmdInvalidMsgs,
-										SendSharedInvalidMessages);
+		/*
+		 * DDL on a table with many partitions can produce more messages than
+		 * the SI queue holds.  Every backend not reading along would be
+		 * reset anyway, so reset them all at once instead of streaming the
+		 * messages through.
+		 */
+		if (CountInvalidationMessages(&transInvalInfo->PriorCmdInvalidMsgs) >
+			SharedInvalQueueSize())
+			SendSharedInvalidReset();
+		else
+			ProcessInvalidationMessageMulti(&transInvalInfo->PriorCmdInvalidMsgs,
+											SendSharedInvalidMessages);
 
 		if (transInvalInfo->RelcacheInitFileInval)
 			RelationCacheInitFilePostInvalidate();
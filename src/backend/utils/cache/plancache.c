@@ -42,8 +42,10 @@
 #include "postgres.h"
 
 #include "utils/plancache.h"
+#include "access/heapam.h"
 #include "access/transam.h"
 #include "catalog/namespace.h"
+#include "cdb/cdbvars.h"
 #include "executor/executor.h"
 #include "executor/spi.h"
 #include "nodes/nodeFuncs.h"
@@ -70,6 +72,9 @@ static bool ScanQueryWalker(Node *node, bool *acquire);
 static bool rowmark_member(List *rowMarks, int rt_index);
 static bool plan_list_is_transient(List *stmt_list);
 static bool plan_list_is_oneoff(List *stmt_list);
+static double cached_plan_cost(List *stmt_list);
+static bool plan_list_is_direct_dispatch(List *stmt_list);
+static bool choose_generic_plan(CachedPlanSource *plansource);
 static void PlanCacheRelCallback(Datum arg, Oid relid);
 static void PlanCacheFuncCallback(Datum arg, int cacheid, ItemPointer tuplePtr);
 static void PlanCacheSysCallback(Datum arg, int cacheid, ItemPointer tuplePtr);
@@ -166,6 +171,13 @@ CreateCachedPlan(Node *raw_parse_tree,
 	plansource->plan = NULL;
 	plansource->context = source_context;
 	plansource->orig_plan = NULL;
+	plansource->num_custom_plans = 0;
+	plansource->total_custom_cost = 0;
+	plansource->generic_cost = (fully_planned && num_params > 0) ?
+		cached_plan_cost(stmt_list) : -1;
+	plansource->num_direct_custom_plans = 0;
+	plansource->generic_direct = fully_planned &&
+		plan_list_is_direct_dispatch(stmt_list);
 
 	/*
 	 * Copy the current output plans into the plancache entry.
@@ -250,6 +262,13 @@ FastCreateCachedPlan(Node *raw_parse_tree,
 	plansource->plan = NULL;
 	plansource->context = context;
 	plansource->orig_plan = NULL;
+	plansource->num_custom_plans = 0;
+	plansource->total_custom_cost = 0;
+	plansource->generic_cost = (fully_planned && num_params > 0) ?
+		cached_plan_cost(stmt_list) : -1;
+	plansource->num_direct_custom_plans = 0;
+	plansource->generic_direct = fully_planned &&
+		plan_list_is_direct_dispatch(stmt_list);
 
 	/*
 	 * Store the current output plans into the plancache entry.
@@ -433,6 +452,14 @@ RevalidateCachedPlanWithParams(CachedPlanSource *plansource, bool useResOwner,
 	 */
 	plan = plansource->plan;
 
+	/*
+	 * Planning with the parameter values gives a better plan, but costs a
+	 * planner run on every execution. Once the generic plan has proven to be
+	 * about as cheap as the custom ones, use that instead.
+	 */
+	if (boundParams && !intoClause && choose_generic_plan(plansource))
+		boundParams = NULL;
+
 	/*
 	 * If we are to use the parameter values in the plan, or this is a
 	 * CREATE TABLE AS EXECUTE, we cannot re-use a generic plan.
@@ -641,6 +668,27 @@ RevalidateCachedPlanWithParams(CachedPlanSource *plansource, bool useResOwner,
 		 */
 		if (boundParams || intoClause)
 			plan->saved_xmin = BootstrapTransactionId;
+
+		/* Remember the cost, for choose_generic_plan() */
+		if (plansource->fully_planned && !intoClause)
+		{
+			double		cost = cached_plan_cost(plan->stmt_list);
+
+			bool		direct = plan_list_is_direct_dispatch(plan->stmt_list);
+
+			if (boundParams)
+			{
+				plansource->num_custom_plans++;
+				plansource->total_custom_cost += cost;
+				if (direct)
+					plansource->num_direct_custom_plans++;
+			}
+			else if (plansource->num_params > 0)
+			{
+				plansource->generic_cost = cost;
+				plansource->generic_direct = direct;
+			}
+		}
 	}
 
 	/*
@@ -769,9 +817,11 @@ AcquireExecutorLocks(List *stmt_list, bool acquire)
 				 * concurrent UPDATE/DELETE on the same table.  This is in
 				 * parity with CdbTryOpenRelation().  Catalog tables are
 				 * replicated across cluster and don't suffer from the
-				 * deadlock.
+				 * deadlock, nor do tables the global deadlock detector
+				 * covers.
 				 */
-				if (rte->relid > FirstNormalObjectId)
+				if (rte->relid > FirstNormalObjectId &&
+					!CdbGlobalDeadlockDetectorCovers(rte->relid))
 					lockmode = ExclusiveLock;
 				else
 					lockmode = RowExclusiveLock;
@@ -842,9 +892,11 @@ ScanQueryForLocks(Query *parsetree, bool acquire)
 					 * deadlock due to concurrent UPDATE/DELETE on the same
 					 * table.  This is in parity with CdbTryOpenRelation().
 					 * Catalog tables are replicated across cluster and don't
-					 * suffer from the deadlock.
+					 * suffer from the deadlock, nor do tables the global
+					 * deadlock detector covers.
 					 */
-					if (rte->relid > FirstNormalObjectId)
+					if (rte->relid > FirstNormalObjectId &&
+						!CdbGlobalDeadlockDetectorCovers(rte->relid))
 						lockmode = ExclusiveLock;
 					else
 						lockmode = RowExclusiveLock;
@@ -977,6 +1029,105 @@ plan_list_is_oneoff(List *stmt_list)
 	return false;
 }
 
+/*
+ * cached_plan_cost: estimated total cost of the fully-planned statements in
+ * the list.
+ */
+static double
+cached_plan_cost(List *stmt_list)
+{
+	double		cost = 0;
+	ListCell   *lc;
+
+	foreach(lc, stmt_list)
+	{
+		PlannedStmt *plannedstmt = (PlannedStmt *) lfirst(lc);
+
+		if (!IsA(plannedstmt, PlannedStmt))
+			continue;			/* Ignore utility statements */
+
+		cost += plannedstmt->planTree->total_cost;
+	}
+
+	return cost;
+}
+
+/*
+ * plan_list_is_direct_dispatch: are all the fully-planned statements in the
+ * list dispatched to some of the segments only?
+ *
+ * A plan whose target segments follow from its parameters counts, since the
+ * executor works them out from the bound values. As in cdbtm.c, looking at
+ * the root of the plan is enough: parent slices are never more directed than
+ * their children.
+ */
+static bool
+plan_list_is_direct_dispatch(List *stmt_list)
+{
+	bool		found = false;
+	ListCell   *lc;
+
+	foreach(lc, stmt_list)
+	{
+		PlannedStmt *plannedstmt = (PlannedStmt *) lfirst(lc);
+
+		if (!IsA(plannedstmt, PlannedStmt))
+			continue;			/* Ignore utility statements */
+
+		if (plannedstmt->planTree == NULL ||
+			(!plannedstmt->planTree->directDispatch.isDirectDispatch &&
+			 plannedstmt->planTree->directDispatch.paramKeys == NIL))
+			return false;
+
+		found = true;
+	}
+
+	return found;
+}
+
+/*
+ * choose_generic_plan: should an execution with parameter values use the
+ * generic plan rather than a custom plan for those values?
+ *
+ * Like later PostgreSQL releases, we build a few custom plans first, and
+ * then use the generic plan if it isn't more than 10% more expensive than
+ * the custom plans on average. The custom plans are usually cheaper, as they
+ * can eliminate partitions with the actual values, but for short queries the
+ * planning time saved matters more.
+ *
+ * The costs leave out dispatching, though. A point query on the distribution
+ * key costs the same whether it runs on one segment or on all of them, so a
+ * generic plan that has to go to every segment would win exactly where
+ * reusing it hurts most. Keep planning with the values if that let the
+ * custom plans dispatch directly and the generic plan can't.
+ */
+static bool
+choose_generic_plan(CachedPlanSource *plansource)
+{
+	double		avg_custom_cost;
+
+	if (!gp_enable_generic_plans ||
+		!plansource->fully_planned ||
+		plansource->num_params == 0)
+		return false;
+
+	/* Generate custom plans until we have done at least 5 */
+	if (plansource->num_custom_plans < 5)
+		return false;
+
+	/* Don't give up direct dispatch */
+	if (plansource->num_direct_custom_plans > 0 && !plansource->generic_direct)
+		return false;
+
+	/* Try the generic plan if we don't know its cost */
+	if (plansource->generic_cost < 0)
+		return true;
+
+	avg_custom_cost = plansource->total_custom_cost / plansource->num_custom_plans;
+
+	return plansource->generic_cost < avg_custom_cost * 1.1;
+}
+
 /*
  * PlanCacheComputeResultDesc: given a list of either fully-planned statements
  * or Queries, determine the result tupledesc it will produce.	Returns NULL
@@ -0,0 +1,374 @@
+/*-------------------------------------------------------------------------
+ *
+ * sharedcatcache.c
+ *	  A shared-memory tier under the per-backend system catalog caches.
+ *
+ * Every backend keeps its own catcache.c entries, and a backend that starts
+ * cold has to read each catalog tuple it needs from the catalogs again,
+ * even though hundreds of other backends on the host read the same tuples
+ * moments ago.  When gp_shared_catcache_entries is set, a backend that
+ * misses in its own catcache looks in a hashtable in shared memory first,
+ * and puts the tuples it does read from the catalogs there for the others.
+ *
+ * Only caches keyed on fixed-size by-value columns (OIDs, attribute numbers
+ * and the like) are shared, and only tuples up to SHARED_CATCACHE_MAX_TUPLE
+ * bytes; negative entries and lists stay per-backend.  The hashtable is a
+ * SyncHT keyed on (database, cache, hash value), which is all a catcache
+ * invalidation message carries, with one tuple per key; a tuple whose hash
+ * value collides with another one's is simply not shared.  Entries leave the
+ * table only when invalidated, and once the table is full nothing more is
+ * added to it.
+ *
+ * Invalidation: every backend that executes a catcache invalidation message
+ * from sinval (including the one that sent it, during its own transaction)
+ * drops the shared entry too.  A backend reading a tuple from the catalogs
+ * might still put a version back after it was invalidated, so each
+ * invalidation also bumps a generation counter, and a tuple is only added if
+ * the counter has not moved since before the catalog scan it came from.
+ * A catcache reset bumps the counter too and marks everything older invalid.
+ *
+ * The shared tier holds committed catalog contents only, so it is not used
+ * in a transaction that has an XID, which might have changed the catalogs
+ * (for a reader gang member, the XID of its writer).
+ *
+ * Portions Copyright (c) 2012-Present Pivotal Software, Inc.
+ *
+ *
+ * IDENTIFICATION
+ *	    src/backend/utils/cache/sharedcatcache.c
+ *
+ *-------------------------------------------------------------------------
+ */
+#include "postgres.h"
+
+#include "access/transam.h"
+#include "access/xact.h"
+#include "cdb/cdbtm.h"
+#include "cdb/cdbvars.h"
+#include "miscadmin.h"
+#include "storage/lwlock.h"
+#include "storage/proc.h"
+#include "storage/shmem.h"
+#include "storage/spin.h"
+#include "utils/sharedcatcache.h"
+#include "utils/sharedsnapshot.h"
+#include "utils/syncrefhashtable.h"
+
+typedef struct SharedCatCacheKey
+{
+	Oid			dbId;			/* InvalidOid for shared catalogs */
+	int32		cacheId;
+	uint32		hashValue;
+} SharedCatCacheKey;
+
+typedef struct SharedCatCacheEntry
+{
+	SharedCatCacheKey key;
+	int32		pinCount;		/* maintained by SyncHT */
+
+	slock_t		mutex;			/* protects the fields below */
+	bool		valid;			/* holds a tuple? */
+	uint64		generation;		/* generation when the tuple was added */
+	uint32		keys[CATCACHE_MAXKEYS];	/* search keys of the tuple */
+	uint32		t_len;
+	ItemPointerData t_self;
+	char		data[SHARED_CATCACHE_MAX_TUPLE];
+} SharedCatCacheEntry;
+
+typedef struct SharedCatCacheHeader
+{
+	slock_t		mutex;
+	uint64		generation;			/* bumped by every invalidation */
+	uint64		resetGeneration;	/* entries older than this are invalid */
+} SharedCatCacheHeader;
+
+static SharedCatCacheHeader *SharedCatCacheHdr = NULL;
+static SyncHT *SharedCatCacheTable = NULL;
+
+static bool
+SharedCatCacheEntryIsEmpty(const void *entry)
+{
+	return !((SharedCatCacheEntry *) entry)->valid;
+}
+
+static void
+SharedCatCacheEntryInit(void *entry)
+{
+	SharedCatCacheEntry *e = (SharedCatCacheEntry *) entry;
+
+	SpinLockInit(&e->mutex);
+	e->pinCount = 0;
+	e->valid = false;
+}
+
+/*
+ * Compute the shared memory needed by the shared catalog cache.
+ */
+Size
+SharedCatCacheShmemSize(void)
+{
+	Size		size;
+
+	if (gp_shared_catcache_entries <= 0)
+		return 0;
+
+	size = MAXALIGN(sizeof(SharedCatCacheHeader));
+	size = add_size(size, hash_estimate_size(gp_shared_catcache_entries,
+											 sizeof(SharedCatCacheEntry)));
+	return size;
+}
+
+/*
+ * Initialize the shared catalog cache in shared memory, or attach to it.
+ */
+void
+SharedCatCacheShmemInit(void)
+{
+	SyncHTCtl	ctl;
+	bool		found;
+
+	if (gp_shared_catcache_entries <= 0)
+		return;
+
+	SharedCatCacheHdr = (SharedCatCacheHeader *)
+		ShmemInitStruct("Shared Catalog Cache Header",
+						sizeof(SharedCatCacheHeader), &found);
+	if (!found)
+	{
+		SpinLockInit(&SharedCatCacheHdr->mutex);
+		SharedCatCacheHdr->generation = 0;
+		SharedCatCacheHdr->resetGeneration = 0;
+	}
+
+	MemSet(&ctl, 0, sizeof(ctl));
+	ctl.keySize = sizeof(SharedCatCacheKey);
+	ctl.entrySize = sizeof(SharedCatCacheEntry);
+	ctl.hash = tag_hash;
+	ctl.match = (HashCompareFunc) memcmp;
+	ctl.keyCopy = (HashCopyFunc) memcpy;
+	ctl.tabName = "Shared Catalog Cache";
+	ctl.numElements = gp_shared_catcache_entries;
+	ctl.baseLWLockId = FirstSharedCatCacheLock;
+	ctl.numPartitions = NUM_SHARED_CATCACHE_PARTITIONS;
+	ctl.keyOffset = GPDB_OFFSET(SharedCatCacheEntry, key);
+	ctl.pinCountOffset = GPDB_OFFSET(SharedCatCacheEntry, pinCount);
+	ctl.isEmptyEntry = SharedCatCacheEntryIsEmpty;
+	ctl.initEntry = SharedCatCacheEntryInit;
+
+	SharedCatCacheTable = SyncHTCreate(&ctl);
+	if (SharedCatCacheTable == NULL)
+		elog(FATAL, "could not initialize shared catalog cache");
+}
+
+/*
+ * Can this backend use the shared tier for this cache, right now?
+ */
+bool
+SharedCatCacheUsable(CatCache *cache)
+{
+	TransactionId xid;
+
+	if (SharedCatCacheTable == NULL || !cache->cc_shareable)
+		return false;
+
+	if (!IsUnderPostmaster || IsBootstrapProcessingMode())
+		return false;
+
+	if (DistributedTransactionContext == DTX_CONTEXT_QE_READER ||
+		DistributedTransactionContext == DTX_CONTEXT_QE_ENTRY_DB_SINGLETON)
+	{
+		PGPROC	   *writer_proc;
+
+		if (SharedLocalSnapshotSlot == NULL)
+			return false;
+
+		LWLockAcquire(SharedLocalSnapshotSlot->slotLock, LW_SHARED);
+		writer_proc = SharedLocalSnapshotSlot->writer_proc;
+		xid = (writer_proc != NULL) ? writer_proc->xid : FirstNormalTransactionId;
+		LWLockRelease(SharedLocalSnapshotSlot->slotLock);
+	}
+	else
+		xid = GetTopTransactionIdIfAny();
+
+	return !TransactionIdIsValid(xid);
+}
+
+/*
+ * Get the current invalidation generation, to pass to SharedCatCacheInsert
+ * for a tuple read from the catalogs after this call.
+ */
+uint64
+SharedCatCacheGeneration(void)
+{
+	volatile SharedCatCacheHeader *hdr = SharedCatCacheHdr;
+	uint64		generation;
+
+	SpinLockAcquire(&hdr->mutex);
+	generation = hdr->generation;
+	SpinLockRelease(&hdr->mutex);
+
+	return generation;
+}
+
+static void
+SharedCatCacheMakeKey(SharedCatCacheKey *key, CatCache *cache, uint32 hashValue)
+{
+	key->dbId = cache->cc_relisshared ? InvalidOid : MyDatabaseId;
+	key->cacheId = cache->id;
+	key->hashValue = hashValue;
+}
+
+/*
+ * Look for the tuple matching the search keys in the shared tier.  Returns a
+ * palloc'd copy of it, or NULL.
+ */
+HeapTuple
+SharedCatCacheLookup(CatCache *cache, uint32 hashValue, ScanKey skey)
+{
+	volatile SharedCatCacheEntry *entry;
+	SharedCatCacheKey key;
+	HeapTuple	tuple = NULL;
+	uint64		resetGeneration;
+	char	   *data;
+	int			i;
+
+	SharedCatCacheMakeKey(&key, cache, hashValue);
+
+	/* Allocate before pinning the entry; any tuple fits in this */
+	data = palloc(HEAPTUPLESIZE + SHARED_CATCACHE_MAX_TUPLE);
+
+	entry = SyncHTLookup(SharedCatCacheTable, &key);
+	if (entry == NULL)
+	{
+		pfree(data);
+		return NULL;
+	}
+
+	SpinLockAcquire(&SharedCatCacheHdr->mutex);
+	resetGeneration = SharedCatCacheHdr->resetGeneration;
+	SpinLockRelease(&SharedCatCacheHdr->mutex);
+
+	SpinLockAcquire(&entry->mutex);
+	if (entry->valid && entry->generation >= resetGeneration)
+	{
+		for (i = 0; i < cache->cc_nkeys; i++)
+		{
+			if (entry->keys[i] != DatumGetUInt32(skey[i].sk_argument))
+				break;
+		}
+		if (i == cache->cc_nkeys)
+		{
+			tuple = (HeapTuple) data;
+			tuple->t_len = entry->t_len;
+			tuple->t_self = entry->t_self;
+			tuple->t_data = (HeapTupleHeader) (data + HEAPTUPLESIZE);
+			memcpy(tuple->t_data, (char *) entry->data, entry->t_len);
+		}
+	}
+	SpinLockRelease(&entry->mutex);
+
+	SyncHTRelease(SharedCatCacheTable, (void *) entry);
+
+	if (tuple == NULL)
+		pfree(data);
+
+	return tuple;
+}
+
+/*
+ * Offer a tuple read from the catalogs to the shared tier.  generation is
+ * what SharedCatCacheGeneration returned before the tuple was read; if
+ * anything was invalidated since, the tuple might be stale and is dropped.
+ */
+void
+SharedCatCacheInsert(CatCache *cache, uint32 hashValue, ScanKey skey,
+					 HeapTuple tuple, uint64 generation)
+{
+	volatile SharedCatCacheEntry *entry;
+	SharedCatCacheKey key;
+	bool		existing;
+	uint64		resetGeneration;
+	int			i;
+
+	if (tuple->t_len > SHARED_CATCACHE_MAX_TUPLE)
+		return;
+
+	SharedCatCacheMakeKey(&key, cache, hashValue);
+
+	entry = SyncHTInsert(SharedCatCacheTable, &key, &existing);
+	if (entry == NULL)
+		return;					/* the table is full */
+
+	SpinLockAcquire(&SharedCatCacheHdr->mutex);
+	resetGeneration = SharedCatCacheHdr->resetGeneration;
+	SpinLockRelease(&SharedCatCacheHdr->mutex);
+
+	/*
+	 * Check the generation while holding the entry's mutex: an invalidation
+	 * bumps the generation before it takes the mutex to clear the entry.
+	 * An entry left over from before a reset may be replaced.
+	 */
+	SpinLockAcquire(&entry->mutex);
+	if ((!entry->valid || entry->generation < resetGeneration) &&
+		SharedCatCacheGeneration() == generation)
+	{
+		for (i = 0; i < cache->cc_nkeys; i++)
+			entry->keys[i] = DatumGetUInt32(skey[i].sk_argument);
+		entry->t_len = tuple->t_len;
+		entry->t_self = tuple->t_self;
+		memcpy((char *) entry->data, tuple->t_data, tuple->t_len);
+		entry->generation = generation;
+		entry->valid = true;
+	}
+	SpinLockRelease(&entry->mutex);
+
+	SyncHTRelease(SharedCatCacheTable, (void *) entry);
+}
+
+/*
+ * Drop the shared entry for a catcache invalidation message.
+ */
+void
+SharedCatCacheInvalidate(Oid dbId, int cacheId, uint32 hashValue)
+{
+	volatile SharedCatCacheEntry *entry;
+	SharedCatCacheKey key;
+
+	if (SharedCatCacheTable == NULL)
+		return;
+
+	SpinLockAcquire(&SharedCatCacheHdr->mutex);
+	SharedCatCacheHdr->generation++;
+	SpinLockRelease(&SharedCatCacheHdr->mutex);
+
+	key.dbId = dbId;
+	key.cacheId = cacheId;
+	key.hashValue = hashValue;
+
+	entry = SyncHTLookup(SharedCatCacheTable, &key);
+	if (entry == NULL)
+		return;
+
+	SpinLockAcquire(&entry->mutex);
+	entry->valid = false;
+	SpinLockRelease(&entry->mutex);
+
+	/* Removes the entry, unless someone else has it pinned */
+	SyncHTRelease(SharedCatCacheTable, (void *) entry);
+}
+
+/*
+ * Invalidate the whole shared tier, for a catcache reset.  The entries are
+ * left in place, but ignored; they are replaced as tuples are read again.
+ */
+void
+SharedCatCacheReset(void)
+{
+	if (SharedCatCacheTable == NULL)
+		return;
+
+	SpinLockAcquire(&SharedCatCacheHdr->mutex);
+	SharedCatCacheHdr->generation++;
+	SharedCatCacheHdr->resetGeneration = SharedCatCacheHdr->generation;
+	SpinLockRelease(&SharedCatCacheHdr->mutex);
+}
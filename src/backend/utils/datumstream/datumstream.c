@@ -880,6 +880,16 @@ datumstreamread_open_file(DatumStreamRead * ds, char *fn, int64 eof, int64 eofUn
 
 	AppendOnlyStorageRead_OpenFile(&ds->ao_read, fn, version, ds->eof);
 
+	/*
+	 * Start out with no current block, so that the first advance asks for
+	 * one, however far the previous file was read.
+	 */
+	ds->largeObjectState = DatumStreamLargeObjectState_None;
+	ds->blockFirstRowNum = 0;
+	ds->blockRowCount = 0;
+	ds->blockRead.nth = -1;
+	ds->blockRead.logical_row_count = 0;
+
 	ds->need_close_file = true;
 }
 
@@ -1330,10 +1340,11 @@ datumstreamread_block_content(DatumStreamRead * acc)
 }
 
 
-int
-datumstreamread_block(DatumStreamRead * acc,
-					  AppendOnlyBlockDirectory *blockDirectory,
-					  int colGroupNo)
+/*
+ * Read the header of the next block, without its content.
+ */
+static bool
+datumstreamread_next_block_info(DatumStreamRead * acc)
 {
 	bool		readOK = false;
 
@@ -1349,7 +1360,7 @@ datumstreamread_block(DatumStreamRead * acc,
 												&acc->getBlockInfo.isLarge,
 											&acc->getBlockInfo.isCompressed);
 	if (!readOK)
-		return -1;
+		return false;
 
 	if (Debug_appendonly_print_datumstream)
 		elog(LOG,
@@ -1391,6 +1402,17 @@ datumstreamread_block(DatumStreamRead * acc,
 			 acc->blockFileOffset,
 			 acc->blockRowCount);
 
+	return true;
+}
+
+int
+datumstreamread_block(DatumStreamRead * acc,
+					  AppendOnlyBlockDirectory *blockDirectory,
+					  int colGroupNo)
+{
+	if (!datumstreamread_next_block_info(acc))
+		return -1;
+
 	datumstreamread_block_content(acc);
 
 	if (blockDirectory)
@@ -1406,6 +1428,65 @@ datumstreamread_block(DatumStreamRead * acc,
 	return 0;
 }
 
+/*
+ * Skip forward to the given row for a sequential scan.
+ *
+ * Afterwards, the next datumstreamread_advance() returns the first row of
+ * the stream numbered targetRowNum or higher.  Blocks that end before the
+ * target are passed over by their headers, without reading or decompressing
+ * their content.
+ *
+ * Blocks written before 4.0 don't carry their first row number, so we stop
+ * skipping at the first of those; the caller just sees more rows than it
+ * asked for.
+ *
+ * Returns -1 if the end of the file was reached, 0 otherwise.
+ */
+int
+datumstreamread_skip_to_row(DatumStreamRead * acc, int64 targetRowNum)
+{
+	Assert(acc);
+
+	while (true)
+	{
+		if (targetRowNum < acc->blockFirstRowNum + acc->blockRowCount)
+		{
+			int32		rowNumInBlock;
+
+			/*
+			 * Step to the row just before the target.  If the target is
+			 * the first row, a freshly read block is already positioned
+			 * before it.
+			 */
+			rowNumInBlock = (int32) (targetRowNum - acc->blockFirstRowNum);
+			if (rowNumInBlock > 0)
+			{
+				while (datumstreamread_nth(acc) < rowNumInBlock - 1)
+				{
+					if (datumstreamread_advance(acc) == 0)
+						break;
+				}
+			}
+			return 0;
+		}
+
+		if (!datumstreamread_next_block_info(acc))
+			return -1;
+
+		if (acc->getBlockInfo.firstRow >= 0 &&
+			acc->blockFirstRowNum + acc->blockRowCount <= targetRowNum)
+		{
+			AppendOnlyStorageRead_SkipCurrentBlock(&acc->ao_read);
+			continue;
+		}
+
+		datumstreamread_block_content(acc);
+
+		if (acc->getBlockInfo.firstRow < 0)
+			return 0;
+	}
+}
+
 void
 datumstreamread_rewind_block(DatumStreamRead * datumStream)
 {
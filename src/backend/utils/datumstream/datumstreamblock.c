@@ -13,6 +13,7 @@
  */
 
 #include "postgres.h"
+#include "access/hash.h"
 #include "access/tupmacs.h"
 #include "access/tuptoaster.h"
 #include "utils/datumstreamblock.h"
@@ -402,7 +403,36 @@ void
 DatumStreamBlockRead_Finish(
 							DatumStreamBlockRead * dsr)
 {
-	/* Place holder. */
+	if (dsr->dict_entries != NULL)
+	{
+		pfree(dsr->dict_entries);
+		dsr->dict_entries = NULL;
+	}
+}
+
+/*
+ * Read the next nrows datums of the block into values[] and nulls[].
+ *
+ * The caller makes sure that the rows are in the current block.  This is the
+ * regular version of the function that codegen specializes on the datum
+ * length, for reading a column of an AOCS table a batch at a time.
+ */
+void
+DatumStreamBlockRead_GetBatch(DatumStreamBlockRead * dsr,
+							  int nrows,
+							  Datum *values,
+							  bool *nulls)
+{
+	int			i;
+
+	for (i = 0; i < nrows; i++)
+	{
+		int			err PG_USED_FOR_ASSERTS_ONLY;
+
+		err = DatumStreamBlockRead_Advance(dsr);
+		Assert(err > 0);
+		DatumStreamBlockRead_Get(dsr, &values[i], &nulls[i]);
+	}
 }
 
 /*
@@ -607,6 +637,68 @@ DatumStreamBlockRead_ResetDense(DatumStreamBlockRead * dsr)
 
 	dsr->delta_block_was_compressed = false;
 	dsr->delta_item = false;
+
+	dsr->dict_block_was_compressed = false;
+	dsr->dict_count = 0;
+	dsr->dict_code_size = 0;
+	dsr->dict_codesp = NULL;
+}
+
+/*
+ * Unpack the dictionary at the start of the datum area.  Afterwards the
+ * datum area covers only the distinct datums, which are located up front
+ * so that advancing is just a lookup of the next code.
+ */
+static void
+DatumStreamBlockRead_GetReadyDictionary(DatumStreamBlockRead * dsr)
+{
+	DatumStreamBlock_Dictionary *dictionary;
+	uint8	   *p;
+	int32		i;
+
+	dictionary = (DatumStreamBlock_Dictionary *) dsr->datum_beginp;
+
+	dsr->dict_count = dictionary->dictionary_count;
+	dsr->dict_code_size = dictionary->code_size;
+	dsr->dict_codesp = dsr->datum_beginp + sizeof(DatumStreamBlock_Dictionary);
+
+	if ((dsr->dict_code_size != 1 && dsr->dict_code_size != 2) ||
+		dsr->dict_count <= 0 ||
+		dsr->dict_count > DATUMSTREAM_MAX_DICTIONARY_COUNT)
+	{
+		ereport(ERROR,
+				(errmsg("Bad datum stream Dense block dictionary header (dictionary count %d, code size %d)",
+						dsr->dict_count,
+						dsr->dict_code_size),
+				 errdetail_datumstreamblockread(dsr),
+				 errcontext_datumstreamblockread(dsr)));
+	}
+
+	dsr->datum_beginp += MAXALIGN(sizeof(DatumStreamBlock_Dictionary) +
+							dsr->physical_datum_count * dsr->dict_code_size);
+	Assert(dsr->datum_beginp + dictionary->dictionary_size == dsr->datum_afterp);
+
+	if (dsr->dict_entries_maxcount < dsr->dict_count)
+	{
+		MemoryContext oldCtxt;
+
+		oldCtxt = MemoryContextSwitchTo(dsr->memctxt);
+		if (dsr->dict_entries != NULL)
+			pfree(dsr->dict_entries);
+		dsr->dict_entries_maxcount = DATUMSTREAM_MAX_DICTIONARY_COUNT;
+		dsr->dict_entries = (uint8 **) palloc(dsr->dict_entries_maxcount * sizeof(uint8 *));
+		MemoryContextSwitchTo(oldCtxt);
+	}
+
+	p = dsr->datum_beginp;
+	for (i = 0; i < dsr->dict_count; i++)
+	{
+		dsr->dict_entries[i] = p;
+
+		p += VARSIZE_ANY(p);
+		if (p < dsr->datum_afterp && *p == 0)
+			p = (uint8 *) att_align_nominal(p, dsr->typeInfo.align);
+	}
 }
 
 void
@@ -940,6 +1032,11 @@ DatumStreamBlockRead_GetReadyDense(
 					 errcontext_datumstreamblockread(dsr)));
 		}
 	}
+
+	dsr->dict_block_was_compressed = ((blockDense->orig_4_bytes.flags & DSB_HAS_DICTIONARY) != 0);
+	if (dsr->dict_block_was_compressed)
+		DatumStreamBlockRead_GetReadyDictionary(dsr);
+
 	dsr->datump = dsr->datum_beginp;
 }
 
@@ -1603,8 +1700,12 @@ DatumStreamBlockWrite_PutOrig(
 		/*
 		 * If toFree comes back non-NULL, we have created a palloc'd de-toasted and/or
 		 * de-compressed varlena copy.
+		 *
+		 * A toast pointer is stored as it is: the caller only hands us
+		 * pointers into the table's own toast relation.
 		 */
-		if (dsw->typeInfo->datumlen == -1)
+		if (dsw->typeInfo->datumlen == -1 &&
+			!VARATT_IS_EXTERNAL(DatumGetPointer(d)))
 		{
 			varattrib_untoast_ptr_len(d, (char **) &dataStart,
 									  &dataLen,
@@ -1634,6 +1735,13 @@ DatumStreamBlockWrite_PutOrig(
 			p = DatumGetPointer(d);
 			wsz = sz;
 		}
+		else if (VARATT_IS_EXTERNAL(DatumGetPointer(d)))
+		{
+			/* Like a short varlena, a toast pointer is never aligned. */
+			sz = VARSIZE_EXTERNAL(DatumGetPointer(d));
+			p = DatumGetPointer(d);
+			wsz = sz;
+		}
 		else if (VARATT_IS_SHORT(DatumGetPointer(d)))
 		{
 			sz = VARSIZE_SHORT(DatumGetPointer(d));
@@ -3156,7 +3264,17 @@ DatumStreamBlockWrite_PutDense(
 		 * If toFree comes back non-NULL, we have created a palloc'd de-toasted and/or
 		 * de-compressed varlena copy.
 		 */
-		if (dsw->typeInfo->datumlen == -1)
+		if (dsw->typeInfo->datumlen == -1 &&
+			VARATT_IS_EXTERNAL(DatumGetPointer(d)))
+		{
+			/*
+			 * A toast pointer is stored as it is. Leaving dataStart NULL
+			 * keeps it out of RLE_TYPE repeat detection.
+			 */
+			dataLen = 0;
+			dataStart = NULL;
+		}
+		else if (dsw->typeInfo->datumlen == -1)
 		{
 			varattrib_untoast_ptr_len(
 									  d,
@@ -3263,6 +3381,13 @@ DatumStreamBlockWrite_PutDense(
 			p = DatumGetPointer(d);
 			wsz = sz;
 		}
+		else if (VARATT_IS_EXTERNAL(DatumGetPointer(d)))
+		{
+			/* Like a short varlena, a toast pointer is never aligned. */
+			sz = VARSIZE_EXTERNAL(DatumGetPointer(d));
+			p = DatumGetPointer(d);
+			wsz = sz;
+		}
 		else if (VARATT_IS_SHORT(DatumGetPointer(d)))
 		{
 			sz = VARSIZE_SHORT(DatumGetPointer(d));
@@ -3313,7 +3438,14 @@ DatumStreamBlockWrite_PutDense(
 
 		storedDatum = PointerGetDatum(item_beginp);
 
-		if (dsw->typeInfo->datumlen == -1)
+		if (dsw->typeInfo->datumlen == -1 &&
+			VARATT_IS_EXTERNAL(DatumGetPointer(storedDatum)))
+		{
+			/* No item compares equal to a toast pointer; see above. */
+			storedDataStart = NULL;
+			storedDataLen = -1;
+		}
+		else if (dsw->typeInfo->datumlen == -1)
 		{
 			varattrib_untoast_ptr_len(
 									  storedDatum,
@@ -3761,6 +3893,156 @@ DatumStreamBlockWrite_BlockOrig(
 	return writesz;
 }
 
+/*
+ * Try dictionary encoding the physical datums of a variable-length block.
+ *
+ * Each physical datum is replaced by a 1 or 2 byte code into a dictionary of
+ * the distinct datums of the block (see DatumStreamBlock_Dictionary).  This
+ * pays off for columns with few distinct values that do not repeat in runs,
+ * which RLE_TYPE alone does not catch.
+ *
+ * Returns the size of the encoded datum area in dsw->dict_buffer, or 0 when
+ * the block is better left as it is.
+ */
+static int32
+DatumStreamBlockWrite_DictionaryEncode(DatumStreamBlockWrite * dsw)
+{
+	int32		count = dsw->physical_datum_count;
+	int32		dataSize = dsw->datump - dsw->datum_buffer;
+	char		align = dsw->typeInfo->align;
+	MemoryContext oldCtxt;
+	int32		nbuckets;
+	int32	   *buckets;
+	uint8	  **entryp;
+	int32	   *entrylen;
+	int32	   *codes;
+	int32		nentries;
+	int32		dictionarySize;
+	int32		codeSize;
+	int32		codesSize;
+	int32		encodedSize;
+	uint8	   *p;
+	int32		i;
+
+	if (!dsw->dict_want_compression || count < 2)
+		return 0;
+
+	oldCtxt = MemoryContextSwitchTo(dsw->memctxt);
+
+	nbuckets = 1;
+	while (nbuckets < 2 * count)
+		nbuckets <<= 1;
+
+	/* Bucket entries are dictionary index + 1, so that 0 is empty. */
+	buckets = (int32 *) palloc0(nbuckets * sizeof(int32));
+	entryp = (uint8 **) palloc(count * sizeof(uint8 *));
+	entrylen = (int32 *) palloc(count * sizeof(int32));
+	codes = (int32 *) palloc(count * sizeof(int32));
+
+	nentries = 0;
+	dictionarySize = 0;
+	p = dsw->datum_buffer;
+	for (i = 0; i < count; i++)
+	{
+		int32		len = VARSIZE_ANY(p);
+		int32		b;
+		int32		e = -1;
+
+		b = DatumGetUInt32(hash_any(p, len)) & (nbuckets - 1);
+		while (buckets[b] != 0)
+		{
+			e = buckets[b] - 1;
+			if (entrylen[e] == len && memcmp(entryp[e], p, len) == 0)
+				break;
+			e = -1;
+			b = (b + 1) & (nbuckets - 1);
+		}
+
+		if (e < 0)
+		{
+			if (nentries >= DATUMSTREAM_MAX_DICTIONARY_COUNT)
+				break;
+
+			e = nentries++;
+			entryp[e] = p;
+			entrylen[e] = len;
+			buckets[b] = e + 1;
+
+			/* Short varlenas are not aligned, the same as in the datum area. */
+			if (!VARATT_IS_SHORT(p))
+				dictionarySize = att_align_nominal(dictionarySize, align);
+			dictionarySize += len;
+		}
+		codes[i] = e;
+
+		/* Advance past the datum and any alignment padding after it. */
+		p += len;
+		if (p < dsw->datump && *p == 0)
+			p = (uint8 *) att_align_nominal(p, align);
+	}
+
+	codeSize = (nentries <= 256 ? 1 : 2);
+	codesSize = MAXALIGN(sizeof(DatumStreamBlock_Dictionary) + count * codeSize);
+	encodedSize = codesSize + dictionarySize;
+
+	if (i < count || encodedSize >= dataSize)
+	{
+		/* Too many distinct values, or no smaller. */
+		encodedSize = 0;
+	}
+	else
+	{
+		DatumStreamBlock_Dictionary *dictionary;
+		uint8	   *codesp;
+		int32		offset;
+
+		if (dsw->dict_buffer == NULL)
+			dsw->dict_buffer = palloc(dsw->maxDataBlockSize);
+
+		dictionary = (DatumStreamBlock_Dictionary *) dsw->dict_buffer;
+		dictionary->dictionary_count = nentries;
+		dictionary->dictionary_size = dictionarySize;
+		dictionary->code_size = codeSize;
+		dictionary->unused = 0;
+
+		codesp = dsw->dict_buffer + sizeof(DatumStreamBlock_Dictionary);
+		for (i = 0; i < count; i++)
+		{
+			if (codeSize == 1)
+				codesp[i] = (uint8) codes[i];
+			else
+				((uint16 *) codesp)[i] = (uint16) codes[i];
+		}
+		memset(codesp + count * codeSize, 0,
+			   codesSize - sizeof(DatumStreamBlock_Dictionary) - count * codeSize);
+
+		p = dsw->dict_buffer + codesSize;
+		offset = 0;
+		for (i = 0; i < nentries; i++)
+		{
+			if (!VARATT_IS_SHORT(entryp[i]))
+			{
+				int32		alignedOffset = att_align_nominal(offset, align);
+
+				memset(p + offset, 0, alignedOffset - offset);
+				offset = alignedOffset;
+			}
+			memcpy(p + offset, entryp[i], entrylen[i]);
+			offset += entrylen[i];
+		}
+		Assert(offset == dictionarySize);
+	}
+
+	pfree(buckets);
+	pfree(entryp);
+	pfree(entrylen);
+	pfree(codes);
+
+	MemoryContextSwitchTo(oldCtxt);
+
+	return encodedSize;
+}
+
 static int64
 DatumStreamBlockWrite_BlockDense(
 								 DatumStreamBlockWrite * dsw,
@@ -3783,6 +4065,7 @@ DatumStreamBlockWrite_BlockDense(
 	int32		totalRepeatCountsSize;
 	int32		totalDeltasSize;
 	int64		formattedMetadataSize;
+	int32		dictionarySize;
 	bool		minimalIntegrityChecks;
 
 	totalRepeatCountsSize = 0;
@@ -3816,6 +4099,14 @@ DatumStreamBlockWrite_BlockDense(
 	dense.physical_datum_count = dsw->physical_datum_count;
 	dense.physical_data_size = dsw->datump - dsw->datum_buffer;
 
+	dictionarySize = DatumStreamBlockWrite_DictionaryEncode(dsw);
+	if (dictionarySize > 0)
+	{
+		dense.orig_4_bytes.flags |= DSB_HAS_DICTIONARY;
+		dsw->savings += (dense.physical_data_size - dictionarySize);
+		dense.physical_data_size = dictionarySize;
+	}
+
 	headerSize = sizeof(DatumStreamBlock_Dense);
 
 	/*
@@ -4038,7 +4329,8 @@ DatumStreamBlockWrite_BlockDense(
 				 errcontext_datumstreamblockwrite(dsw)));
 	}
 
-	memcpy(p, dsw->datum_buffer, dense.physical_data_size);
+	memcpy(p, (dictionarySize > 0 ? dsw->dict_buffer : dsw->datum_buffer),
+		   dense.physical_data_size);
 	p += dense.physical_data_size;
 
 	/* Calculate write size. */
@@ -4249,6 +4541,14 @@ DatumStreamBlockWrite_Init(
 	dsw->rle_want_compression = rle_want_compression;
 	dsw->delta_want_compression = delta_want_compression;
 
+	/*
+	 * Dictionary encoding goes along with RLE_TYPE for variable-length types.
+	 * It changes the block format, so it is only done when asked for.
+	 */
+	dsw->dict_want_compression = (gp_appendonly_dictionary_encoding &&
+								  rle_want_compression &&
+								  typeInfo->datumlen == -1);
+
 	dsw->initialMaxDatumPerBlock = initialMaxDatumPerBlock;
 	dsw->maxDatumPerBlock = maxDatumPerBlock;
 
@@ -4458,6 +4758,9 @@ DatumStreamBlockWrite_Finish(
 	if (dsw->delta_sign != NULL)
 		pfree(dsw->delta_sign);
 
+	if (dsw->dict_buffer != NULL)
+		pfree(dsw->dict_buffer);
+
 	MemoryContextSwitchTo(oldCtxt);
 }
 
@@ -4546,15 +4849,26 @@ DatumStreamBlock_IntegrityCheckVarlena(
 		 */
 		if (VARATT_IS_EXTERNAL(p))
 		{
-			ereport(ERROR,
-					(errmsg("Bad datum stream %s variable-length item at physical offset %d is corrupt (varlena is EXTERNAL, physical item index #%d)",
-							DatumStreamVersion_String(datumStreamVersion),
-							currentOffset,
-							count),
-					 errdetailCallback(errdetailArg),
-					 errcontextCallback(errcontextArg)));
-			varLen = 0;
-			/* Never reaches here. */
+			/*
+			 * A toast pointer to a value stored out of line. It is written
+			 * unaligned, like a SHORT varlena.
+			 */
+			varLen = VARSIZE_EXTERNAL(p);
+
+			if (varLen != VARHDRSZ_EXTERNAL + sizeof(struct varatt_external) ||
+				varLen > remainingSize)
+			{
+				ereport(ERROR,
+						(errmsg("Bad datum stream %s variable-length item at physical offset %d.  EXTERNAL varlena size bad (size %d, remaining size %d, physical size %d, physical item index #%d)",
+								DatumStreamVersion_String(datumStreamVersion),
+								currentOffset,
+								varLen,
+								remainingSize,
+								physicalDataSize,
+								count),
+						 errdetailCallback(errdetailArg),
+						 errcontextCallback(errcontextArg)));
+			}
 		}
 		else if (VARATT_IS_SHORT(p))
 		{
@@ -5430,7 +5744,74 @@ DatumStreamBlock_IntegrityCheckDense(
 												  errcontextArg);
 	}
 
-	if (typeInfo->datumlen == -1)
+	if ((blockDense->orig_4_bytes.flags & DSB_HAS_DICTIONARY) != 0)
+	{
+		DatumStreamBlock_Dictionary *dictionary;
+		int32		codesSize;
+		int32		i;
+
+		/*
+		 * Dictionary.  The varlena check below covers the distinct datums.
+		 */
+		if (typeInfo->datumlen != -1 ||
+			blockDense->physical_data_size < sizeof(DatumStreamBlock_Dictionary))
+		{
+			ereport(ERROR,
+					(errmsg("Bad datum stream Dense block dictionary (datum length %d, physical data size %d)",
+							typeInfo->datumlen,
+							blockDense->physical_data_size),
+					 errdetailCallback(errdetailArg),
+					 errcontextCallback(errcontextArg)));
+		}
+
+		dictionary = (DatumStreamBlock_Dictionary *) (buffer + alignedHeaderSize);
+		codesSize = MAXALIGN(sizeof(DatumStreamBlock_Dictionary) +
+							 blockDense->physical_datum_count * dictionary->code_size);
+
+		if ((dictionary->code_size != 1 && dictionary->code_size != 2) ||
+			dictionary->dictionary_count <= 0 ||
+			dictionary->dictionary_count > DATUMSTREAM_MAX_DICTIONARY_COUNT ||
+			codesSize + dictionary->dictionary_size != blockDense->physical_data_size)
+		{
+			ereport(ERROR,
+					(errmsg("Bad datum stream Dense block dictionary header (dictionary count %d, dictionary size %d, code size %d, physical data size %d)",
+							dictionary->dictionary_count,
+							dictionary->dictionary_size,
+							dictionary->code_size,
+							blockDense->physical_data_size),
+					 errdetailCallback(errdetailArg),
+					 errcontextCallback(errcontextArg)));
+		}
+
+		for (i = 0; i < blockDense->physical_datum_count; i++)
+		{
+			uint8	   *codesp = (uint8 *) (dictionary + 1);
+			int32		code;
+
+			code = (dictionary->code_size == 1 ? codesp[i] : ((uint16 *) codesp)[i]);
+			if (code >= dictionary->dictionary_count)
+			{
+				ereport(ERROR,
+						(errmsg("Bad datum stream Dense block dictionary code %d at physical item index #%d (dictionary count %d)",
+								code,
+								i,
+								dictionary->dictionary_count),
+						 errdetailCallback(errdetailArg),
+						 errcontextCallback(errcontextArg)));
+			}
+		}
+
+		DatumStreamBlock_IntegrityCheckVarlena(
+											   buffer + alignedHeaderSize + codesSize,
+											   dictionary->dictionary_size,
+											blockDense->orig_4_bytes.version,
+											   typeInfo,
+											   errdetailCallback,
+											   errdetailArg,
+											   errcontextCallback,
+											   errcontextArg);
+	}
+	else if (typeInfo->datumlen == -1)
 	{
 		/*
 		 * Variable-length items.
@@ -41,6 +41,13 @@ struct  {
 
 int64 gpmon_tick = 0;
 
+/* QEXEC packets waiting to be sent, see gpmon_send() */
+static gpmon_qexec_batch_t qexec_batch;
+static int64 qexec_batch_tick = 0;
+
+static void gpmon_send_bytes(const void *p, int n);
+static void gpmon_batch_qexec(const gpmon_qexec_t *qexec);
+
 void gpmon_sig_handler(int sig);
 
 void gpmon_sig_handler(int sig) 
@@ -185,16 +192,84 @@ void gpmon_send(gpmon_packet_t* p)
 		}
 	}
 	
+	if (p->pkttype == GPMON_PKTTYPE_QEXEC)
+	{
+		gpmon_batch_qexec(&p->u.qexec);
+		return;
+	}
+
+	gpmon_send_bytes(p, sizeof(*p));
+}
+
+static void gpmon_send_bytes(const void *p, int n)
+{
 	if (gpmon.gxsock > 0) {
-		int n = sizeof(*p);
-		if (n != sendto(gpmon.gxsock, (const char *)p, n, 0, 
-						(struct sockaddr*) &gpmon.gxaddr, 
+		if (n != sendto(gpmon.gxsock, (const char *)p, n, 0,
+						(struct sockaddr*) &gpmon.gxaddr,
 						sizeof(gpmon.gxaddr))) {
 			elog(LOG, "gpmon: cannot send (%m socket %d)", gpmon.gxsock);
 		}
 	}
 }
 
+/*
+ * Add a QEXEC packet to the batch to send.
+ *
+ * Every plan node of a QE reports itself at least once a tick, so sending
+ * one datagram per node made gpsmon spend most of its time receiving them,
+ * and drop packets, with many concurrent QEs.  Instead, the packets of a
+ * tick are coalesced per node, keeping only the node's latest state, and
+ * sent together when the tick is over, when the batch is full, or when the
+ * query ends (gpmon_flush()).
+ */
+static void gpmon_batch_qexec(const gpmon_qexec_t *qexec)
+{
+	gpmon_qexec_rec_t *rec = NULL;
+	int i;
+
+	if (qexec_batch.nrecs > 0 && qexec_batch_tick != gpmon_tick)
+		gpmon_flush();
+
+	for (i = 0; i < qexec_batch.nrecs; i++)
+	{
+		if (memcmp(&qexec_batch.recs[i].key, &qexec->key, sizeof(qexec->key)) == 0)
+		{
+			rec = &qexec_batch.recs[i];
+			break;
+		}
+	}
+
+	if (rec == NULL)
+	{
+		if (qexec_batch.nrecs >= GPMON_QEXEC_BATCH_MAX)
+			gpmon_flush();
+		if (qexec_batch.nrecs == 0)
+			qexec_batch_tick = gpmon_tick;
+		rec = &qexec_batch.recs[qexec_batch.nrecs++];
+		memcpy(&rec->key, &qexec->key, sizeof(rec->key));
+	}
+
+	rec->status = qexec->status;
+	rec->rowsout = qexec->rowsout;
+	rec->rowsin = qexec->rowsin;
+}
+
+/*
+ * Send the QEXEC packets batched so far.
+ */
+void gpmon_flush(void)
+{
+	if (qexec_batch.nrecs == 0)
+		return;
+
+	qexec_batch.magic = GPMON_MAGIC;
+	qexec_batch.version = GPMON_PACKET_VERSION;
+	qexec_batch.pkttype = GPMON_PKTTYPE_QEXEC_BATCH;
+	gpmon_send_bytes(&qexec_batch, GPMON_QEXEC_BATCH_SIZE(qexec_batch.nrecs));
+
+	qexec_batch.nrecs = 0;
+}
+
 #define GPMON_QLOG_PACKET_ASSERTS(gpmonPacket) \
 		Assert(gp_enable_gpperfmon && Gp_role == GP_ROLE_DISPATCH); \
 		Assert(gpmonPacket); \
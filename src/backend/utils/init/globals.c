@@ -126,6 +126,10 @@ int			MaxBackends = 200;
 int			MaxConnections = 90;
 
 int			gp_workfile_max_entries = 8192; /* Number of unique entries we can hold in the workfile directory */
+int			gp_shared_catcache_entries = 0; /* Number of catalog tuples in the shared catalog cache */
+int			gp_persistent_relation_index_entries = 16384; /* Number of relation files in the persistent relation index */
+int			gp_sinval_queue_size = 16384; /* Number of messages the shared invalidation queue holds */
+int			gp_distributedlog_buffers = 32; /* Number of SLRU buffers for the distributed log */
 
 int			VacuumCostPageHit = 1;		/* GUC parameters for vacuum */
 int			VacuumCostPageMiss = 10;
@@ -240,6 +240,112 @@ static int bz_file_open(gfile_t *fd)
 }
 #endif
 
+#ifdef HAVE_LIBZSTD
+/* ZSTD */
+struct zstd_stuff
+{
+	ZSTD_DStream *ds;
+	ZSTD_inBuffer in;
+	size_t in_capacity;
+	size_t pending;		/* last ZSTD_decompressStream result, 0 at a frame end */
+	int eof;
+	char *inbuf;
+};
+
+static ssize_t
+zstd_file_read(gfile_t *fd, void *ptr, size_t len)
+{
+	struct zstd_stuff *z = fd->u.zstd;
+	ZSTD_outBuffer out;
+
+	out.dst = ptr;
+	out.size = len;
+	out.pos = 0;
+
+	for (;;)
+	{
+		size_t e;
+
+		if (z->in.pos == z->in.size && !z->eof)
+		{
+			ssize_t s = read_and_retry(fd, z->inbuf, z->in_capacity);
+
+			if (s < 0)
+				return -1;
+			if (s == 0)
+				z->eof = 1;
+			z->in.src = z->inbuf;
+			z->in.size = s;
+			z->in.pos = 0;
+		}
+
+		if (z->in.pos == z->in.size && z->eof)
+		{
+			if (z->pending != 0)
+			{
+				gfile_printf_then_putc_newline("zstd file is truncated");
+				return -1;
+			}
+			return out.pos;
+		}
+
+		e = ZSTD_decompressStream(z->ds, &out, &z->in);
+		if (ZSTD_isError(e))
+		{
+			gfile_printf_then_putc_newline("zstd decompression failed: %s",
+										   ZSTD_getErrorName(e));
+			return -1;
+		}
+		z->pending = e;
+
+		if (out.pos > 0)
+			return out.pos;
+	}
+}
+
+static int
+zstd_file_close(gfile_t *fd)
+{
+	ZSTD_freeDStream(fd->u.zstd->ds);
+	gfile_free(fd->u.zstd->inbuf);
+	gfile_free(fd->u.zstd);
+
+	return 0;
+}
+
+static int
+zstd_file_open(gfile_t *fd)
+{
+	if (!(fd->u.zstd = gfile_malloc(sizeof *fd->u.zstd)))
+	{
+		gfile_printf_then_putc_newline("Out of memory");
+		return 1;
+	}
+
+	memset(fd->u.zstd, 0, sizeof *fd->u.zstd);
+	fd->u.zstd->in_capacity = ZSTD_DStreamInSize();
+
+	if (!(fd->u.zstd->inbuf = gfile_malloc(fd->u.zstd->in_capacity)))
+	{
+		gfile_free(fd->u.zstd);
+		gfile_printf_then_putc_newline("Out of memory");
+		return 1;
+	}
+
+	fd->u.zstd->ds = ZSTD_createDStream();
+	if (!fd->u.zstd->ds || ZSTD_isError(ZSTD_initDStream(fd->u.zstd->ds)))
+	{
+		gfile_printf_then_putc_newline("ZSTD_initDStream failed");
+		return 1;
+	}
+
+	fd->read = zstd_file_read;
+	fd->close = zstd_file_close;
+
+	return 0;
+}
+#endif
+
 #ifdef HAVE_LIBZ
 /* GZ */
 struct zlib_stuff
@@ -979,6 +1085,18 @@ int gfile_open(gfile_t* fd, const char* fpath, int flags, int* response_code, co
 			gfile_printf_then_putc_newline(".bz2 not yet supported for writable tables");
 
 		return bz_file_open(fd);
+#endif
+	}
+	else if (s && strcasecmp(s,".zst")==0)
+	{
+#ifndef HAVE_LIBZSTD
+		gfile_printf_then_putc_newline(".zst not supported");
+#else
+		fd->compression = ZSTD_COMPRESSION;
+		if (flags != GFILE_OPEN_FOR_READ)
+			gfile_printf_then_putc_newline(".zst not yet supported for writable tables");
+
+		return zstd_file_open(fd);
 #endif
 	}
 	else if (s && strcasecmp(s,".z") == 0)
@@ -1014,7 +1132,8 @@ gfile_close(gfile_t*fd)
 		 * for the compressed data implementation we need to call the "close" callback. Other implementations
 		 * didn't use to call this callback here and it will remain so.
 		 */
-		if (  fd->compression == GZ_COMPRESSION ) 
+		if (  fd->compression == GZ_COMPRESSION ||
+			  fd->compression == ZSTD_COMPRESSION )
 		{
 			fd->close(fd);
 		}
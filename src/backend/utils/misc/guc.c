@@ -76,6 +76,7 @@
 #include "utils/tzparser.h"
 #include "utils/xml.h"
 #include "cdb/cdbdisp_query.h"
+#include "cdb/cdbgang.h"
 #include "cdb/cdbvars.h"
 
 #ifdef USE_SSL
@@ -1797,6 +1798,17 @@ static struct config_int ConfigureNamesInt[] =
 		100, 0, 1000, NULL, NULL
 	},
 
+	{
+		{"effective_io_concurrency", PGC_USERSET, RESOURCES,
+			gettext_noop("Number of pages a heap scan asks the kernel to read ahead of it."),
+			gettext_noop("Sequential scans read ahead in the relation, bitmap heap scans "
+						 "in their bitmap. 0 disables prefetching."),
+			GUC_NOT_IN_SAMPLE
+		},
+		&effective_io_concurrency,
+		0, 0, 1000, NULL, NULL
+	},
+
 	{
 		{"log_rotation_age", PGC_SIGHUP, LOGGING_WHERE,
 			gettext_noop("Automatic log file rotation will occur after N minutes."),
@@ -2874,6 +2886,7 @@ static char *_ShowOption(struct config_generic * record, bool use_units);
 static bool is_newvalue_equal(struct config_generic * record, const char *newvalue);
 
 static void DispatchSetPGVariable(const char *name, List *args, bool is_local);
+static bool CanDeferSetDispatch(bool is_local);
 
 /*
  * Some infrastructure for checking malloc/strdup/realloc calls
@@ -5881,7 +5894,12 @@ ExecSetVariableStmt(VariableSetStmt *stmt)
 		stmt->kind == VAR_RESET ||
 		stmt->kind == VAR_RESET_ALL)
 	{
-		if (Gp_role == GP_ROLE_DISPATCH)
+		if (Gp_role == GP_ROLE_DISPATCH && CanDeferSetDispatch(stmt->is_local))
+		{
+			RecordSessionStateChange(stmt->kind == VAR_RESET_ALL ? NULL : stmt->name,
+									 NULL);
+		}
+		else if (Gp_role == GP_ROLE_DISPATCH)
 		{
 			/*
 			 * RESET must be dispatched different, because it can't
@@ -5889,6 +5907,9 @@ ExecSetVariableStmt(VariableSetStmt *stmt)
 			 */
 			StringInfoData buffer;
 
+			RecordDispatchedSessionStateChange(stmt->kind == VAR_RESET_ALL ? NULL : stmt->name,
+											   NULL);
+
 			initStringInfo(&buffer);
 
 			if (stmt->kind == VAR_RESET_ALL)
@@ -5951,6 +5972,19 @@ SetPGVariableOptDispatch(const char *name, List *args, bool is_local, bool gp_di
 		DispatchSetPGVariable(name, args, is_local);
 }
 
+/*
+ * A session-level SET outside a transaction block need not be dispatched
+ * right away: the QEs get it with the next command sent to them, see
+ * RecordSessionStateChange().
+ */
+static bool
+CanDeferSetDispatch(bool is_local)
+{
+	return gp_dispatch_session_state_delta &&
+		!is_local &&
+		!IsTransactionBlock();
+}
+
 static void
 DispatchSetPGVariable(const char *name, List *args, bool is_local)
 {
@@ -5960,6 +5994,15 @@ DispatchSetPGVariable(const char *name, List *args, bool is_local)
 	if (Gp_role != GP_ROLE_DISPATCH || IsBootstrapProcessingMode())
 		return;
 
+	if (CanDeferSetDispatch(is_local))
+	{
+		RecordSessionStateChange(name, flatten_set_variable_args(name, args));
+		return;
+	}
+
+	if (!is_local)
+		RecordDispatchedSessionStateChange(name, flatten_set_variable_args(name, args));
+
 	initStringInfo( &buffer );
 
 	if (args == NIL)
@@ -29,15 +29,18 @@
 #include "cdb/cdbvars.h"
 #include "cdb/memquota.h"
 #include "commands/vacuum.h"
+#include "executor/nodeShareInputScan.h"
 #include "miscadmin.h"
 #include "libpq/password_hash.h"
 #include "optimizer/cost.h"
 #include "optimizer/planmain.h"
 #include "pgstat.h"
 #include "parser/scansup.h"
+#include "postmaster/backoff.h"
 #include "postmaster/syslogger.h"
 #include "replication/walsender.h"
 #include "storage/bfz.h"
+#include "storage/pg_shmem.h"
 #include "storage/proc.h"
 #include "utils/builtins.h"
 #include "utils/guc_tables.h"
@@ -146,7 +149,15 @@ bool		gp_appendonly_verify_block_checksums = true;
 bool		gp_appendonly_verify_write_block = false;
 bool		gp_appendonly_verify_eof = true;
 bool		gp_appendonly_compaction = true;
+bool		gp_appendonly_compaction_copy_blocks = false;
+bool		gp_appendonly_zone_maps = false;
+bool		gp_appendonly_dictionary_encoding = false;
+bool		gp_appendonly_late_materialization = false;
+bool		gp_appendonly_vectorized_quals = false;
+bool		gp_appendonly_write_nocache = false;
+bool		gp_appendonly_scan_nocache = false;
 int			gp_appendonly_compaction_threshold = 0;
+int			gp_appendonly_toast_threshold = 0;
 bool		gp_heap_verify_checksums_on_mirror = false;
 bool		gp_heap_require_relhasoids_match = true;
 bool		Debug_appendonly_rezero_quicklz_compress_scratch = false;
@@ -184,11 +195,14 @@ int			dtx_phase2_retry_count = 0;
 bool		log_dispatch_stats = false;
 
 int			explain_memory_verbosity = 0;
+int			huge_pages = HUGE_PAGES_TRY;
+int			gp_numa_policy = NUMA_POLICY_OFF;
 char	   *memory_profiler_run_id = "none";
 char	   *memory_profiler_dataset_id = "none";
 char	   *memory_profiler_query_id = "none";
 int			memory_profiler_dataset_size = 0;
 bool		gp_dump_memory_usage = FALSE;
+int			gp_memory_accounting_sample_size = 0;
 
 
 #define VERIFY_CHECKPOINT_INTERVAL_DEFAULT 180
@@ -320,11 +334,15 @@ int			gp_resqueue_priority_inactivity_timeout;
 int			gp_resqueue_priority_grouping_timeout;
 double		gp_resqueue_priority_cpucores_per_segment;
 char	   *gp_resqueue_priority_default_value;
+int			gp_resqueue_priority_mode = RESQUEUE_PRIORITY_MODE_BACKOFF;
 bool		gp_debug_resqueue_priority = false;
 
 /* Resource group GUCs */
 double		gp_resource_group_cpu_limit;
 double		gp_resource_group_memory_limit;
+bool		gp_resource_group_cpu_ceiling_enforcement = false;
+char	   *gp_resource_group_cpuset = NULL;
+int			gp_resource_group_spill_grace_mb = 32;
 
 /* Perfmon segment GUCs */
 int			gp_perfmon_segment_interval;
@@ -401,13 +419,16 @@ bool		fts_diskio_check = false;
 bool		gp_enable_hashjoin_size_heuristic = false;
 bool		gp_enable_fallback_plan = true;
 bool		gp_enable_predicate_propagation = false;
+bool		gp_enable_partitionwise_join = false;
 bool		gp_enable_multiphase_agg = true;
 bool		gp_enable_preunique = TRUE;
 bool		gp_eager_preunique = FALSE;
 bool		gp_enable_sequential_window_plans = FALSE;
 bool		gp_hashagg_streambottom = true;
 bool		gp_enable_agg_distinct = true;
+bool		gp_enable_hashed_setop = true;
 bool		gp_enable_dqa_pruning = true;
+bool		gp_enable_dqa_expand = true;
 bool		gp_eager_dqa_pruning = FALSE;
 bool		gp_eager_one_phase_agg = FALSE;
 bool		gp_eager_two_phase_agg = FALSE;
@@ -504,6 +525,7 @@ double		optimizer_sort_factor;
 
 /* Optimizer hints */
 int			optimizer_join_arity_for_associativity_commutativity;
+int			optimizer_search_time_limit;
 int         optimizer_array_expansion_threshold;
 int         optimizer_join_order_threshold;
 int			optimizer_cte_inlining_bound;
@@ -532,12 +554,20 @@ bool		optimizer_analyze_midlevel_partition;
 bool		init_codegen;
 bool		codegen;
 bool		codegen_validate_functions;
+bool		codegen_background_compile;
 bool		codegen_exec_variable_list;
 bool		codegen_slot_getattr;
 bool		codegen_exec_eval_expr;
 bool		codegen_advance_aggregate;
+bool		codegen_exec_hash_get_hash_value;
+bool		codegen_datumstream_get_batch;
+bool		codegen_exec_scan_qual_project;
 int		codegen_varlen_tolerance;
 int		codegen_optimization_level;
+int		codegen_cache_size;
+int		codegen_disk_cache_size;
+double		codegen_above_cost;
+double		codegen_optimize_above_cost;
 
 /* System Information */
 static int	gp_server_version_num;
@@ -548,6 +578,7 @@ bool		gp_reject_internal_tcp_conn = true;
 
 /* copy */
 bool		gp_enable_segment_copy_checking = true;
+int			gp_copy_dispatch_block_size = 0;
 /*
  * Default storage options GUC.  Value is comma-separated name=value
  * pairs.  E.g. "appendonly=true,orientation=column"
@@ -558,7 +589,14 @@ int			writable_external_table_bufsize = 64;
 
 /* Executor */
 bool		gp_enable_mk_sort = true;
+bool		gp_mk_sort_abbrev_keys = false;
+int			gp_mk_sort_threads = 0;
+bool		gp_tuplestore_arena = true;
+bool		gp_scan_resistant_buffers = false;
 bool		gp_enable_motion_mk_sort = true;
+int			gp_motion_hash_batch_size = 64;
+int			gp_motion_merge_fanout = 0;
+bool		gp_enable_window_sliding_extremes = true;
 
 static const struct config_enum_entry gp_log_format_options[] = {
 	{"text", 0},
@@ -611,6 +649,36 @@ static const struct config_enum_entry explain_memory_verbosity_options[] = {
 	{NULL, 0}
 };
 
+/*
+ * Although only "on", "off", and "try" are documented, we accept all the
+ * likely variants of "on" and "off".
+ */
+static const struct config_enum_entry huge_pages_options[] = {
+	{"off", HUGE_PAGES_OFF},
+	{"on", HUGE_PAGES_ON},
+	{"try", HUGE_PAGES_TRY},
+	{"true", HUGE_PAGES_ON},
+	{"false", HUGE_PAGES_OFF},
+	{"yes", HUGE_PAGES_ON},
+	{"no", HUGE_PAGES_OFF},
+	{"1", HUGE_PAGES_ON},
+	{"0", HUGE_PAGES_OFF},
+	{NULL, 0}
+};
+
+static const struct config_enum_entry gp_numa_policy_options[] = {
+	{"off", NUMA_POLICY_OFF},
+	{"interleave", NUMA_POLICY_INTERLEAVE},
+	{"local", NUMA_POLICY_LOCAL},
+	{NULL, 0}
+};
+
+static const struct config_enum_entry gp_resqueue_priority_mode_options[] = {
+	{"backoff", RESQUEUE_PRIORITY_MODE_BACKOFF},
+	{"nice", RESQUEUE_PRIORITY_MODE_NICE},
+	{NULL, 0}
+};
+
 static const struct config_enum_entry system_cache_flush_force_options[] = {
 	{"off", SysCacheFlushForce_Off},
 	{"recursive", SysCacheFlushForce_Recursive},
@@ -737,6 +805,26 @@ struct config_bool ConfigureNamesBool_gp[] =
 		&gp_enable_direct_dispatch,
 		true, NULL, NULL
 	},
+	{
+		{"gp_enable_global_deadlock_detector", PGC_POSTMASTER, LOCK_MANAGEMENT,
+			gettext_noop("Enables the global deadlock detector."),
+			gettext_noop("UPDATE and DELETE on heap tables then take RowExclusiveLock "
+						 "instead of ExclusiveLock on the master, and the detector cancels "
+						 "one of the sessions in a deadlock that spans several segments."),
+			GUC_NOT_IN_SAMPLE
+		},
+		&gp_enable_global_deadlock_detector,
+		false, NULL, NULL
+	},
+	{
+		{"gp_enable_generic_plans", PGC_USERSET, QUERY_TUNING_OTHER,
+			gettext_noop("Allows EXECUTE of a prepared statement to reuse its generic plan."),
+			gettext_noop("After a few executions planned with the parameter values, "
+						 "the generic plan is used if its cost is close to theirs.")
+		},
+		&gp_enable_generic_plans,
+		false, NULL, NULL
+	},
 	{
 		{"gp_enable_predicate_propagation", PGC_USERSET, QUERY_TUNING_OTHER,
 			gettext_noop("When two expressions are equivalent (such as with "
@@ -747,6 +835,16 @@ struct config_bool ConfigureNamesBool_gp[] =
 		&gp_enable_predicate_propagation,
 		true, NULL, NULL
 	},
+	{
+		{"gp_enable_partitionwise_join", PGC_USERSET, QUERY_TUNING_METHOD,
+			gettext_noop("Enables the planner to join identically partitioned tables "
+						 "one pair of partitions at a time."),
+			gettext_noop("Only hash joins on the partitioning key, without motion "
+						 "between the join and the partitions, are affected.")
+		},
+		&gp_enable_partitionwise_join,
+		false, NULL, NULL
+	},
 	{
 		{"gp_workfile_checksumming", PGC_USERSET, QUERY_TUNING_OTHER,
 			gettext_noop("Enable checksumming on the executor work files in order to "
@@ -880,6 +978,16 @@ struct config_bool ConfigureNamesBool_gp[] =
 		true, NULL, NULL
 	},
 
+	{
+		{"gp_enable_window_sliding_extremes", PGC_USERSET, QUERY_TUNING_METHOD,
+			gettext_noop("Enable incremental min/max evaluation over moving window frames."),
+			gettext_noop("Without it, min and max over a moving frame rescan the whole "
+						 "frame for every row.")
+		},
+		&gp_enable_window_sliding_extremes,
+		true, NULL, NULL
+	},
+
 	{
 		{"gp_enable_agg_distinct", PGC_USERSET, QUERY_TUNING_METHOD,
 			gettext_noop("Enable 2-phase aggregation to compute a single distinct-qualified aggregate."),
@@ -898,6 +1006,15 @@ struct config_bool ConfigureNamesBool_gp[] =
 		true, NULL, NULL
 	},
 
+	{
+		{"gp_enable_agg_distinct_expand", PGC_USERSET, QUERY_TUNING_METHOD,
+			gettext_noop("Enable computing distinct-qualified aggregates on several arguments from one hashed deduplication of the input."),
+			NULL,
+		},
+		&gp_enable_dqa_expand,
+		true, NULL, NULL
+	},
+
 	{
 		{"gp_enable_groupext_distinct_pruning", PGC_USERSET, QUERY_TUNING_METHOD,
 			gettext_noop("Enable 3-phase aggregation and join to compute distinct-qualified aggregates"
@@ -1000,6 +1117,26 @@ struct config_bool ConfigureNamesBool_gp[] =
 		true, NULL, NULL
 	},
 
+	{
+		{"gp_enable_incremental_sort", PGC_USERSET, QUERY_TUNING_METHOD,
+			gettext_noop("Enable sorting of partially sorted input one group of equal leading keys at a time."),
+			gettext_noop("Bounds sort memory and returns the first rows sooner when the input "
+						 "is already ordered on a prefix of the sort keys.")
+		},
+		&gp_enable_incremental_sort,
+		true, NULL, NULL
+	},
+
+	{
+		{"gp_enable_hashed_setop", PGC_USERSET, QUERY_TUNING_METHOD,
+			gettext_noop("Enable hashing, rather than sorting, to find duplicates for UNION, INTERSECT and EXCEPT."),
+			gettext_noop("The hash table spills to workfiles when it exceeds work_mem. "
+						 "The planner chooses between hashing and sorting by cost.")
+		},
+		&gp_enable_hashed_setop,
+		true, NULL, NULL
+	},
+
 	{
 		{"gp_enable_mk_sort", PGC_USERSET, QUERY_TUNING_METHOD,
 			gettext_noop("Enable multi-key sort."),
@@ -1011,6 +1148,27 @@ struct config_bool ConfigureNamesBool_gp[] =
 		true, NULL, NULL
 	},
 
+	{
+		{"gp_tuplestore_arena", PGC_USERSET, RESOURCES_MEM,
+			gettext_noop("Allocate tuplestore pages in growing arenas."),
+			gettext_noop("Large arenas are advised to use huge pages. When off, pages are allocated one at a time."),
+			GUC_NOT_IN_SAMPLE
+		},
+		&gp_tuplestore_arena,
+		true, NULL, NULL
+	},
+
+	{
+		{"gp_scan_resistant_buffers", PGC_USERSET, RESOURCES_MEM,
+			gettext_noop("Keep sequential scans of large tables from flushing shared buffers."),
+			gettext_noop("When on, a sequential scan of any user table larger than its buffer ring "
+						 "recycles its pages through the ring, unless the table has keep_cached set."),
+			GUC_NOT_IN_SAMPLE
+		},
+		&gp_scan_resistant_buffers,
+		false, NULL, NULL
+	},
+
 	{
 		{"gp_enable_motion_mk_sort", PGC_USERSET, QUERY_TUNING_METHOD,
 			gettext_noop("Enable multi-key sort in sorted motion recv."),
@@ -1022,6 +1180,17 @@ struct config_bool ConfigureNamesBool_gp[] =
 		true, NULL, NULL
 	},
 
+	{
+		{"gp_mk_sort_abbrev_keys", PGC_USERSET, QUERY_TUNING_METHOD,
+			gettext_noop("Compare multi-key sort keys through abbreviated binary keys."),
+			gettext_noop("Applies to text and char under the C collation, numeric, "
+						 "int8, date and timestamp sort keys."),
+			GUC_NO_SHOW_ALL | GUC_NOT_IN_SAMPLE | GUC_GPDB_ADDOPT
+		},
+		&gp_mk_sort_abbrev_keys,
+		false, NULL, NULL
+	},
+
 
 #ifdef USE_ASSERT_CHECKING
 	{
@@ -1045,6 +1214,26 @@ struct config_bool ConfigureNamesBool_gp[] =
 		true, NULL, NULL
 	},
 
+	{
+		{"gp_hashagg_stream_keep_hot", PGC_USERSET, QUERY_TUNING_METHOD,
+			gettext_noop("Keep frequently hit groups in memory when the streaming bottom stage of a two stage hashagg flushes."),
+			gettext_noop("Only the cold groups are sent on; up to a quarter of the operator's memory holds the hot ones."),
+			GUC_NO_SHOW_ALL | GUC_NOT_IN_SAMPLE | GUC_GPDB_ADDOPT
+		},
+		&gp_hashagg_stream_keep_hot,
+		false, NULL, NULL
+	},
+
+	{
+		{"gp_hashagg_index_groups", PGC_USERSET, QUERY_TUNING_METHOD,
+			gettext_noop("Look up hash aggregate groups through an open-addressing index of hash tags."),
+			gettext_noop("Costs about 10 bytes of work memory per group."),
+			GUC_NO_SHOW_ALL | GUC_NOT_IN_SAMPLE | GUC_GPDB_ADDOPT
+		},
+		&gp_hashagg_index_groups,
+		false, NULL, NULL
+	},
+
 	{
 		{"gp_enable_motion_deadlock_sanity", PGC_USERSET, DEVELOPER_OPTIONS,
 			gettext_noop("Enable verbose check at planning time."),
@@ -1213,6 +1402,75 @@ struct config_bool ConfigureNamesBool_gp[] =
 		true, NULL, NULL
 	},
 
+	{
+		{"gp_appendonly_compaction_copy_blocks", PGC_USERSET, APPENDONLY_TABLES,
+			gettext_noop("Copy blocks without deleted rows as they are during append-only compaction."),
+			gettext_noop("Blocks are only copied for row-oriented tables without indexes."),
+			GUC_GPDB_ADDOPT
+		},
+		&gp_appendonly_compaction_copy_blocks,
+		false, NULL, NULL
+	},
+
+	{
+		{"gp_appendonly_zone_maps", PGC_USERSET, APPENDONLY_TABLES,
+			gettext_noop("Keep zone maps in the block directory of column-oriented tables, and skip the blocks they rule out in scans."),
+			gettext_noop("Block directories written with zone maps cannot be read by servers without them."),
+			GUC_GPDB_ADDOPT
+		},
+		&gp_appendonly_zone_maps,
+		false, NULL, NULL
+	},
+
+	{
+		{"gp_appendonly_dictionary_encoding", PGC_USERSET, APPENDONLY_TABLES,
+			gettext_noop("Dictionary encode the blocks of variable-length RLE_TYPE columns of column-oriented tables when that makes them smaller."),
+			gettext_noop("Blocks written this way cannot be read by servers without dictionary support."),
+			GUC_GPDB_ADDOPT
+		},
+		&gp_appendonly_dictionary_encoding,
+		false, NULL, NULL
+	},
+
+	{
+		{"gp_appendonly_late_materialization", PGC_USERSET, APPENDONLY_TABLES,
+			gettext_noop("Read the columns of a column-oriented table that only the output needs for the rows that pass the scan's quals."),
+			NULL,
+			GUC_GPDB_ADDOPT
+		},
+		&gp_appendonly_late_materialization,
+		false, NULL, NULL
+	},
+
+	{
+		{"gp_appendonly_vectorized_quals", PGC_USERSET, APPENDONLY_TABLES,
+			gettext_noop("Evaluate the simple quals of scans of column-oriented tables a batch of rows at a time."),
+			gettext_noop("Comparisons and arithmetic on integer, float and date columns, and NULL tests, "
+						 "are evaluated a column at a time instead of row by row.")
+		},
+		&gp_appendonly_vectorized_quals,
+		false, NULL, NULL
+	},
+
+	{
+		{"gp_appendonly_write_nocache", PGC_USERSET, APPENDONLY_TABLES,
+			gettext_noop("Keep the data written to append-only tables out of the OS page cache."),
+			gettext_noop("Each large write is written back and evicted once the next one is done, "
+						 "so that big loads don't push out pages other queries need.")
+		},
+		&gp_appendonly_write_nocache,
+		false, NULL, NULL
+	},
+
+	{
+		{"gp_appendonly_scan_nocache", PGC_USERSET, APPENDONLY_TABLES,
+			gettext_noop("Evict the data read by sequential scans of append-only tables from the OS page cache."),
+			gettext_noop("Useful when scanning cold tables that won't be read again soon.")
+		},
+		&gp_appendonly_scan_nocache,
+		false, NULL, NULL
+	},
+
 	{
 		{"gp_heap_verify_checksums_on_mirror", PGC_USERSET, DEVELOPER_OPTIONS,
 		 gettext_noop("Verify the heap checksums on mirror after receiving block from primary before writing to disk."),
@@ -1340,6 +1598,25 @@ struct config_bool ConfigureNamesBool_gp[] =
 		true, NULL, NULL
 	},
 
+	{
+		{"gp_external_projection", PGC_USERSET, EXTERNAL_TABLES,
+			gettext_noop("Only parse the columns of a readable external table that a query uses."),
+			gettext_noop("Errors in the data of other columns are not reported.")
+		},
+		&gp_external_projection,
+		true, NULL, NULL
+	},
+
+	{
+		{"gpfdist_compress", PGC_USERSET, EXTERNAL_TABLES,
+			gettext_noop("Ask gpfdist to send the data of readable external tables zstd compressed."),
+			gettext_noop("Saves network bandwidth at the cost of CPU on both ends. "
+						 "Ignored unless both the server and gpfdist are built with zstd.")
+		},
+		&gpfdist_compress,
+		false, NULL, NULL
+	},
+
 	{
 		{"gp_enable_fast_sri", PGC_USERSET, QUERY_TUNING_OTHER,
 			gettext_noop("Enable single-slice single-row inserts."),
@@ -1349,6 +1626,18 @@ struct config_bool ConfigureNamesBool_gp[] =
 		true, NULL, NULL
 	},
 
+	{
+		{"gp_use_jump_consistent_hash", PGC_POSTMASTER, GP_ARRAY_CONFIGURATION,
+			gettext_noop("Map distribution key hashes to segments with jump consistent hash."),
+			gettext_noop("When the cluster is expanded, only the rows that belong on the new "
+						 "segments move. Must be the same on all segments, and can only be "
+						 "changed together with a redistribution of all hash distributed tables."),
+			GUC_NOT_IN_SAMPLE
+		},
+		&gp_use_jump_consistent_hash,
+		false, NULL, NULL
+	},
+
 	{
 		{"gp_interconnect_full_crc", PGC_USERSET, QUERY_TUNING_OTHER,
 			gettext_noop("Sanity check incoming data stream."),
@@ -1369,6 +1658,28 @@ struct config_bool ConfigureNamesBool_gp[] =
 		false, NULL, NULL
 	},
 
+	{
+		{"gp_dispatch_session_state_delta", PGC_USERSET, GP_ARRAY_TUNING,
+			gettext_noop("Sends session-level SET commands to the segments along with the next dispatched command."),
+			gettext_noop("Only applies to SET and RESET outside of a transaction block. "
+						 "Each segment worker is sent the settings it has not seen yet."),
+			GUC_NOT_IN_SAMPLE
+		},
+		&gp_dispatch_session_state_delta,
+		false, NULL, NULL
+	},
+
+	{
+		{"gp_dispatch_pipeline", PGC_USERSET, GP_ARRAY_TUNING,
+			gettext_noop("Does not wait for the segments to finish a utility command in a transaction block."),
+			gettext_noop("The results are collected when the next command is dispatched or the "
+						 "transaction commits, and an error is reported then."),
+			GUC_NOT_IN_SAMPLE
+		},
+		&gp_dispatch_pipeline,
+		false, NULL, NULL
+	},
+
 	{
 		{"gp_interconnect_cache_future_packets", PGC_USERSET, GP_ARRAY_TUNING,
 			gettext_noop("Control whether future packets are cached."),
@@ -2086,6 +2397,65 @@ struct config_bool ConfigureNamesBool_gp[] =
 		&gp_statistics_use_fkeys,
 		true, NULL, NULL
 	},
+	{
+		{"gp_statistics_ao_block_sampling", PGC_USERSET, STATS_ANALYZE,
+			gettext_noop("ANALYZE samples append-only row tables by varblock, skipping the varblocks not chosen."),
+			NULL
+		},
+		&gp_statistics_ao_block_sampling,
+		true, NULL, NULL
+	},
+	{
+		{"gp_statistics_use_hll", PGC_USERSET, STATS_ANALYZE,
+			gettext_noop("ANALYZE estimates the number of distinct values with HyperLogLog sketches over the whole table."),
+			gettext_noop("This costs an extra scan of the table, but is more accurate than extrapolating from the sample.")
+		},
+		&gp_statistics_use_hll,
+		false, NULL, NULL
+	},
+	{
+		{"gp_statistics_collect_dependencies", PGC_USERSET, STATS_ANALYZE,
+			gettext_noop("ANALYZE collects functional dependencies between the columns of a table."),
+			gettext_noop("The planner uses them to estimate clauses and groupings on correlated columns.")
+		},
+		&gp_statistics_collect_dependencies,
+		false, NULL, NULL
+	},
+	{
+		{"gp_hashjoin_runtime_filter", PGC_USERSET, QUERY_TUNING_METHOD,
+			gettext_noop("Filter the outer scan of a hash join by a Bloom filter of the inner side's join keys."),
+			gettext_noop("Only applies to inner and semi joins whose outer side is a plain table scan."),
+			GUC_GPDB_ADDOPT
+		},
+		&gp_hashjoin_runtime_filter,
+		false, NULL, NULL
+	},
+	{
+		{"gp_hashjoin_compact_buckets", PGC_USERSET, QUERY_TUNING_METHOD,
+			gettext_noop("Probe hash join batches through a contiguous array of their hash values."),
+			gettext_noop("Costs 12 bytes of work memory per inner tuple."),
+			GUC_GPDB_ADDOPT
+		},
+		&gp_hashjoin_compact_buckets,
+		false, NULL, NULL
+	},
+	{
+		{"gp_hashjoin_dedup_inner", PGC_USERSET, QUERY_TUNING_METHOD,
+			gettext_noop("Keep one inner row per distinct join key in semi and anti hash joins."),
+			NULL,
+			GUC_GPDB_ADDOPT
+		},
+		&gp_hashjoin_dedup_inner,
+		false, NULL, NULL
+	},
+	{
+		{"gp_hashjoin_share_broadcast", PGC_USERSET, QUERY_TUNING_METHOD,
+			gettext_noop("Share the hash table of a broadcast hash join inner side between the segments of a host."),
+			gettext_noop("The shared copy lives in POSIX shared memory, outside of the vmem limit.")
+		},
+		&gp_hashjoin_share_broadcast,
+		false, NULL, NULL
+	},
 	{
 		{"gp_resqueue_priority", PGC_POSTMASTER, RESOURCES_MGM,
 			gettext_noop("Enables priority scheduling."),
@@ -2125,6 +2495,16 @@ struct config_bool ConfigureNamesBool_gp[] =
 		false, NULL, NULL
 	},
 
+	{
+		{"filerep_compress_messages", PGC_SIGHUP, GP_ARRAY_TUNING,
+			gettext_noop("Compress messages shipped between primary and mirror segments with LZ4."),
+			gettext_noop("Has no effect if the server was built without LZ4 support."),
+			GUC_NOT_IN_SAMPLE
+		},
+		&file_rep_compress_messages,
+		false, NULL, NULL
+	},
+
 	{
 		{"filerep_crc_on", PGC_SUSET, DEVELOPER_OPTIONS,
 			gettext_noop("enable adler 32 crc in filerep"),
@@ -2439,6 +2819,15 @@ struct config_bool ConfigureNamesBool_gp[] =
 		false, NULL, NULL
 	},
 
+	{
+		{"gp_resource_group_cpu_ceiling_enforcement", PGC_POSTMASTER, RESOURCES,
+			gettext_noop("If the value is true, ceiling of cpu_rate_limit will be enforced."),
+			gettext_noop("A resource group can then not use the cpu that other groups leave idle.")
+		},
+		&gp_resource_group_cpu_ceiling_enforcement,
+		false, NULL, NULL
+	},
+
 	{
 		{"gp_resgroup_print_operator_memory_limits", PGC_USERSET, LOGGING_WHAT,
 			gettext_noop("Prints out the memory limit for operators (in explain) assigned by resource group's "
@@ -3287,6 +3676,20 @@ struct config_bool ConfigureNamesBool_gp[] =
 		true, 	/* true by default on debug builds. */
 #else
 		false,
+#endif
+		assign_codegen, NULL
+	},
+	{
+		{"codegen_background_compile", PGC_USERSET, DEVELOPER_OPTIONS,
+			gettext_noop("Compile generated code in a background thread, running the regular functions until it is ready"),
+			NULL,
+			GUC_NO_SHOW_ALL | GUC_NOT_IN_SAMPLE
+		},
+		&codegen_background_compile,
+#ifdef USE_CODEGEN
+		true,
+#else
+		false,
 #endif
 		assign_codegen, NULL
 	},
@@ -3343,6 +3746,48 @@ struct config_bool ConfigureNamesBool_gp[] =
 		true,
 #else
 		false,
+#endif
+		assign_codegen, NULL
+	},
+	{
+		{"codegen_exec_hash_get_hash_value", PGC_USERSET, DEVELOPER_OPTIONS,
+			gettext_noop("Enable codegen for ExecHashGetHashValue"),
+			NULL,
+			GUC_NO_SHOW_ALL | GUC_NOT_IN_SAMPLE | GUC_GPDB_ADDOPT
+		},
+		&codegen_exec_hash_get_hash_value,
+#ifdef USE_CODEGEN
+		true,
+#else
+		false,
+#endif
+		assign_codegen, NULL
+	},
+	{
+		{"codegen_datumstream_get_batch", PGC_USERSET, DEVELOPER_OPTIONS,
+			gettext_noop("Enable codegen for decoding fixed width datum streams of column oriented tables"),
+			NULL,
+			GUC_NO_SHOW_ALL | GUC_NOT_IN_SAMPLE | GUC_GPDB_ADDOPT
+		},
+		&codegen_datumstream_get_batch,
+#ifdef USE_CODEGEN
+		true,
+#else
+		false,
+#endif
+		assign_codegen, NULL
+	},
+	{
+		{"codegen_exec_scan_qual_project", PGC_USERSET, DEVELOPER_OPTIONS,
+			gettext_noop("Enable codegen for deforming, qualifying and projecting the tuples of table scans in one function"),
+			NULL,
+			GUC_NO_SHOW_ALL | GUC_NOT_IN_SAMPLE | GUC_GPDB_ADDOPT
+		},
+		&codegen_exec_scan_qual_project,
+#ifdef USE_CODEGEN
+		true,
+#else
+		false,
 #endif
 		assign_codegen, NULL
 	},
@@ -3411,6 +3856,29 @@ struct config_int ConfigureNamesInt_gp[] =
 		0, 0, INT_MAX, NULL, NULL
 	},
 
+	{
+		{"gp_copy_dispatch_block_size", PGC_USERSET, CUSTOM_OPTIONS,
+			gettext_noop("Size of the blocks of rows COPY FROM sends to each segment in turn, for randomly distributed tables."),
+			gettext_noop("The master then does not parse the rows, the segments do. "
+						 "0 sends the rows one at a time."),
+			GUC_UNIT_KB | GUC_NOT_IN_SAMPLE
+		},
+		&gp_copy_dispatch_block_size,
+		0, 0, 131072, NULL, NULL
+	},
+
+	{
+		{"gp_explain_analyze_timing_sample", PGC_USERSET, CLIENT_CONN_OTHER,
+			gettext_noop("Time only one in this many calls of each plan node during EXPLAIN ANALYZE."),
+			gettext_noop("The first calls are always timed, and the rest of the time is "
+						 "extrapolated from the timed calls. Row counts stay exact. "
+						 "1 times every call."),
+			GUC_GPDB_ADDOPT | GUC_NOT_IN_SAMPLE
+		},
+		&gp_explain_analyze_timing_sample,
+		1, 1, 1000000, NULL, NULL
+	},
+
 	{
 		{"writable_external_table_bufsize", PGC_USERSET, EXTERNAL_TABLES,
 			gettext_noop("Buffer size in kilo bytes for writable external table before writing data to gpfdist."),
@@ -3506,6 +3974,56 @@ struct config_int ConfigureNamesInt_gp[] =
 		DEFAULT_FS_SAFE_WRITE_SIZE, 0, INT_MAX, NULL, NULL
 	},
 
+	{
+		{"gp_appendonly_prefetch_depth", PGC_USERSET, RESOURCES,
+			gettext_noop("Number of large reads to prefetch ahead when scanning append-only tables."),
+			gettext_noop("Each column file of a column-oriented table prefetches independently. "
+						 "0 disables prefetching.")
+		},
+		&gp_appendonly_prefetch_depth,
+		1, 0, 64, NULL, NULL
+	},
+
+	{
+		{"gp_appendonly_compress_workers", PGC_USERSET, RESOURCES,
+			gettext_noop("Number of threads compressing append-only blocks while rows are inserted."),
+			gettext_noop("Only zlib, zstd and lz4 compression use them. "
+						 "0 compresses on the backend itself.")
+		},
+		&gp_appendonly_compress_workers,
+		0, 0, 64, NULL, NULL
+	},
+
+	{
+		{"gp_hashjoin_build_threads", PGC_USERSET, RESOURCES,
+			gettext_noop("Number of threads helping to build the in-memory hash table of a hash join."),
+			gettext_noop("Reading the inner side and hashing it stays on the backend. "
+						 "0 builds the hash table on the backend alone.")
+		},
+		&gp_hashjoin_build_threads,
+		0, 0, 64, NULL, NULL
+	},
+
+	{
+		{"gp_mk_sort_threads", PGC_USERSET, RESOURCES,
+			gettext_noop("Number of threads helping to sort in memory in a multi-key sort."),
+			gettext_noop("Only sorts on int4, int8, date and timestamp keys use them. "
+						 "0 sorts on the backend alone.")
+		},
+		&gp_mk_sort_threads,
+		0, 0, 64, NULL, NULL
+	},
+
+	{
+		{"gp_appendonly_preallocate_size", PGC_USERSET, RESOURCES,
+			gettext_noop("Disk space to reserve at a time ahead of writes to append-only segment files."),
+			gettext_noop("0 disables preallocation."),
+			GUC_UNIT_KB
+		},
+		&gp_appendonly_preallocate_size,
+		0, 0, INT_MAX / 1024, NULL, NULL
+	},
+
 	{
 		{"planner_work_mem", PGC_USERSET, RESOURCES_MEM,
 			gettext_noop("Sets the maximum memory to be used for query workspaces, "
@@ -3573,6 +4091,18 @@ struct config_int ConfigureNamesInt_gp[] =
 		0, 0, MAX_KILOBYTES, NULL, NULL
 	},
 
+	{
+		{"gp_dispatch_plan_cache_size", PGC_USERSET, RESOURCES_MEM,
+			gettext_noop("Sets the number of recently dispatched plans to keep serialized."),
+			gettext_noop("A plan that is dispatched again is not compressed again on the "
+						 "master, nor uncompressed and deserialized again on the segments. "
+						 "0 disables the cache."),
+			GUC_GPDB_ADDOPT
+		},
+		&gp_dispatch_plan_cache_size,
+		16, 0, 1024, NULL, NULL
+	},
+
 	{
 		{"gp_max_partition_level", PGC_SUSET, PRESET_OPTIONS,
 			gettext_noop("Sets the maximum number of levels allowed when creating a partitioned table."),
@@ -3593,6 +4123,18 @@ struct config_int ConfigureNamesInt_gp[] =
 		10, 0, 100, NULL, NULL
 	},
 
+	{
+		{"gp_appendonly_toast_threshold", PGC_USERSET, APPENDONLY_TABLES,
+			gettext_noop("Sets the size over which values of column-oriented tables are stored out of line."),
+			gettext_noop("Larger values go to the table's TOAST relation, and the column file only keeps "
+						 "a pointer to them. Zero, the default, keeps all values in the column files; "
+						 "releases that predate this setting cannot read the pointers."),
+			GUC_UNIT_KB
+		},
+		&gp_appendonly_toast_threshold,
+		0, 0, MAX_KILOBYTES, NULL, NULL
+	},
+
 	{
 		{"gp_workfile_max_entries", PGC_POSTMASTER, RESOURCES,
 			gettext_noop("Sets the maximum number of entries that can be stored in the workfile directory"),
@@ -3603,6 +4145,58 @@ struct config_int ConfigureNamesInt_gp[] =
 		8192, 32, INT_MAX, NULL, NULL
 	},
 
+	{
+		{"gp_shared_catcache_entries", PGC_POSTMASTER, RESOURCES_MEM,
+			gettext_noop("Sets the number of catalog tuples kept in the catalog cache shared by all backends."),
+			gettext_noop("0 disables the shared catalog cache; each backend then reads the catalogs for its own cache."),
+			GUC_NOT_IN_SAMPLE
+		},
+		&gp_shared_catcache_entries,
+		0, 0, INT_MAX / 1024, NULL, NULL
+	},
+
+	{
+		{"gp_persistent_relation_index_entries", PGC_POSTMASTER, RESOURCES_MEM,
+			gettext_noop("Sets the number of relation files kept in the shared index over gp_persistent_relation_node."),
+			gettext_noop("0 disables the index; looking up a relation file then scans the persistent table."),
+			GUC_NOT_IN_SAMPLE
+		},
+		&gp_persistent_relation_index_entries,
+		16384, 0, INT_MAX / 1024, NULL, NULL
+	},
+
+	{
+		{"gp_sinval_queue_size", PGC_POSTMASTER, RESOURCES_MEM,
+			gettext_noop("Sets the number of cache invalidation messages the shared queue holds."),
+			gettext_noop("Backends that fall further behind than this must reset all their caches. "
+						 "Rounded up to a power of 2."),
+			GUC_NOT_IN_SAMPLE
+		},
+		&gp_sinval_queue_size,
+		16384, 4096, 1024 * 1024, NULL, NULL
+	},
+
+	{
+		{"gp_distributedlog_buffers", PGC_POSTMASTER, RESOURCES_MEM,
+			gettext_noop("Sets the number of buffers used to cache distributed log pages."),
+			gettext_noop("Visibility checks of old data look up the distributed log, "
+						 "so more buffers keep more of it in memory."),
+			GUC_NOT_IN_SAMPLE
+		},
+		&gp_distributedlog_buffers,
+		32, 8, 256, NULL, NULL
+	},
+
+	{
+		{"gp_global_deadlock_detector_period", PGC_SIGHUP, LOCK_MANAGEMENT,
+			gettext_noop("Sets the time between two runs of the global deadlock detector."),
+			NULL,
+			GUC_UNIT_S | GUC_NOT_IN_SAMPLE
+		},
+		&gp_global_deadlock_detector_period,
+		120, 5, INT_MAX, NULL, NULL
+	},
+
 	{
 		{"gp_workfile_limit_files_per_query", PGC_USERSET, RESOURCES,
 			gettext_noop("Maximum number of workfiles allowed per query per segment."),
@@ -3613,6 +4207,48 @@ struct config_int ConfigureNamesInt_gp[] =
 		100000, 0, INT_MAX, NULL, NULL,
 	},
 
+	{
+		{"gp_workfile_spill_location_min_free", PGC_SIGHUP, RESOURCES,
+			gettext_noop("Free disk space below which a workfile spill location is passed over."),
+			gettext_noop("New workfile sets then go to the next location or tier."),
+			GUC_UNIT_KB | GUC_NOT_IN_SAMPLE
+		},
+		&gp_workfile_spill_location_min_free,
+		1048576, 0, INT_MAX, NULL, NULL,
+	},
+
+	{
+		{"gp_nestloop_probe_batch", PGC_USERSET, QUERY_TUNING_METHOD,
+			gettext_noop("Sets the number of outer rows a nested loop join reads ahead to probe its inner index scan in key order."),
+			gettext_noop("Each distinct key is probed once. 0 or 1 probes once per outer row."),
+			GUC_NO_SHOW_ALL | GUC_NOT_IN_SAMPLE | GUC_GPDB_ADDOPT
+		},
+		&gp_nestloop_probe_batch,
+		0, 0, 10000, NULL, NULL,
+	},
+
+	{
+		{"gp_workfile_io_size", PGC_USERSET, RESOURCES,
+			gettext_noop("Size of the reads and writes of executor work files."),
+			gettext_noop("0 uses the default of the compression algorithm. When set, "
+						 "uncompressed work files are buffered in this unit too, and "
+						 "each write is pushed to disk in the background."),
+			GUC_UNIT_KB | GUC_GPDB_ADDOPT
+		},
+		&gp_workfile_io_size,
+		0, 0, 8192, NULL, NULL,
+	},
+
+	{
+		{"gp_workfile_reuse_limit", PGC_USERSET, RESOURCES,
+			gettext_noop("Disk space of spilled Material results kept for later queries of the transaction."),
+			gettext_noop("Only serializable transactions keep results. 0 keeps none."),
+			GUC_UNIT_KB
+		},
+		&gp_workfile_reuse_limit,
+		0, 0, INT_MAX, NULL, NULL,
+	},
+
 	{
 		{"gp_vmem_idle_resource_timeout", PGC_USERSET, CLIENT_CONN_OTHER,
 			gettext_noop("Sets the time a session can be idle (in milliseconds) before we release gangs on the segment DBs to free resources."),
@@ -3767,6 +4403,17 @@ struct config_int ConfigureNamesInt_gp[] =
 		64, 0, INT_MAX, NULL, NULL
 	},
 
+	{
+		{"gp_resqueue_fast_lane_slots", PGC_SIGHUP, RESOURCES_MGM,
+			gettext_noop("Sets the number of extra active statements each resource queue reserves for short queries."),
+			gettext_noop("Queries with a cost below gp_resqueue_fast_lane_cost are admitted beyond "
+						 "the active statement and cost limits of their queue while fewer than this "
+						 "many extra statements are active.")
+		},
+		&gp_resqueue_fast_lane_slots,
+		0, 0, INT_MAX, NULL, NULL
+	},
+
 	{
 		{"max_appendonly_tables", PGC_POSTMASTER, APPENDONLY_TABLES,
 			gettext_noop("Maximum number of different (unrelated) append only tables that can participate in writing data concurrently."),
@@ -3865,6 +4512,57 @@ struct config_int ConfigureNamesInt_gp[] =
 		3600, 1, 7200, NULL, NULL
 	},
 
+	{
+		{"gp_interconnect_mmsg_batch_size", PGC_USERSET, GP_ARRAY_TUNING,
+			gettext_noop("Sets the maximum number of packets sent or received per system call in the UDP interconnect."),
+			gettext_noop("Batching uses sendmmsg()/recvmmsg() where available. 1 disables batching."),
+			GUC_GPDB_ADDOPT
+		},
+		&Gp_interconnect_mmsg_batch_size,
+		1, 1, MAX_MMSG_BATCH_SIZE, NULL, NULL
+	},
+
+	{
+		{"gp_interconnect_tcp_conn_cache_size", PGC_USERSET, GP_ARRAY_TUNING,
+			gettext_noop("Sets the maximum number of TCP interconnect connections a backend keeps open for reuse by later statements of a session."),
+			gettext_noop("Incoming and outgoing connections count together. 0 closes all interconnect connections at the end of each statement."),
+			GUC_GPDB_ADDOPT
+		},
+		&Gp_interconnect_tcp_conn_cache_size,
+		0, 0, MAX_TCP_CONN_CACHE_SIZE, NULL, NULL
+	},
+
+	{
+		{"gp_interconnect_compress_min_size", PGC_USERSET, GP_ARRAY_TUNING,
+			gettext_noop("Sets the minimum serialized tuple size, in bytes, for tuples to be compressed before they are sent over the interconnect."),
+			gettext_noop("0 disables interconnect compression."),
+			GUC_GPDB_ADDOPT
+		},
+		&gp_interconnect_compress_min_size,
+		0, 0, INT_MAX, NULL, NULL
+	},
+
+	{
+		{"gp_motion_hash_batch_size", PGC_USERSET, GP_ARRAY_TUNING,
+			gettext_noop("Sets the number of tuples a redistribute motion hashes at a time."),
+			gettext_noop("1 hashes each tuple as it is fetched from the child plan."),
+			GUC_GPDB_ADDOPT
+		},
+		&gp_motion_hash_batch_size,
+		64, 1, MAX_MOTION_HASH_BATCH_SIZE, NULL, NULL
+	},
+
+	{
+		{"gp_motion_merge_fanout", PGC_USERSET, GP_ARRAY_TUNING,
+			gettext_noop("Sets the maximum number of senders a sorted motion receiver merges in one heap."),
+			gettext_noop("With more senders, they are merged in groups whose outputs are merged in turn. "
+						 "0 merges all senders in one heap. Only used with gp_enable_motion_mk_sort."),
+			GUC_GPDB_ADDOPT
+		},
+		&gp_motion_merge_fanout,
+		0, 0, INT_MAX, NULL, NULL
+	},
+
 	{
 		{"gp_interconnect_min_retries_before_timeout", PGC_USERSET, GP_ARRAY_TUNING,
 			gettext_noop("Sets the min retries before reporting a transmit timeout in the interconnect."),
@@ -4006,6 +4704,38 @@ struct config_int ConfigureNamesInt_gp[] =
 		5, 0, INT_MAX, NULL, NULL
 	},
 
+	{
+		{"gp_cached_segworkers_low_watermark", PGC_USERSET, GP_ARRAY_TUNING,
+			gettext_noop("Sets the number of idle segment worker groups to set up ahead of need."),
+			gettext_noop("The missing groups are created together, once the writer group exists. "
+						 "gp_cached_segworkers_threshold is the upper bound."),
+			GUC_NOT_IN_SAMPLE
+		},
+		&gp_cached_gang_low_watermark,
+		0, 0, INT_MAX, NULL, NULL
+	},
+
+	{
+		{"gp_sequence_lease_max", PGC_USERSET, GP_ARRAY_TUNING,
+			gettext_noop("Sets the maximum number of sequence values a segment leases from the sequence server at once."),
+			gettext_noop("Segments start by leasing the sequence's CACHE values and double the "
+						 "lease while nextval() keeps using it up quickly. 1 disables leasing."),
+			GUC_GPDB_ADDOPT
+		},
+		&gp_sequence_lease_max,
+		1024, 1, INT_MAX, NULL, NULL
+	},
+
+	{
+		{"gp_max_endpoints", PGC_POSTMASTER, GP_ARRAY_TUNING,
+			gettext_noop("Sets the maximum number of endpoints of parallel retrieve cursors on each segment."),
+			gettext_noop("Each endpoint takes 256kB of shared memory."),
+			GUC_NOT_IN_SAMPLE
+		},
+		&gp_max_endpoints,
+		16, 0, 1024, NULL, NULL
+	},
+
 
 	{
 #ifdef USE_ASSERT_CHECKING
@@ -4149,10 +4879,10 @@ struct config_int ConfigureNamesInt_gp[] =
 	},
 
 	{
-		{"gp_fts_probe_threadcount", PGC_POSTMASTER, GP_ARRAY_TUNING,
+		{"gp_fts_probe_threadcount", PGC_POSTMASTER, DEFUNCT_OPTIONS,
 			gettext_noop("Use this number of threads for probing the segments."),
-			gettext_noop("The number of threads to create at each probe interval expiration."),
-			GUC_NOT_IN_SAMPLE
+			gettext_noop("Not used; all segments are probed in parallel by a single event loop."),
+			GUC_NO_SHOW_ALL | GUC_NOT_IN_SAMPLE
 		},
 		&gp_fts_probe_threadcount,
 		16, 1, 128, NULL, NULL
@@ -4298,6 +5028,40 @@ struct config_int ConfigureNamesInt_gp[] =
 		1, 1, 3600, gpvars_assign_gp_gpperfmon_send_interval, NULL
 	},
 
+	{
+		{"gp_query_progress_max_nodes", PGC_POSTMASTER, STATS_MONITORING,
+			gettext_noop("Sets the number of plan nodes of each backend whose live progress is tracked."),
+			gettext_noop("The progress is shown by gp_toolkit.gp_query_progress. "
+						 "Zero disables the tracking."),
+			GUC_NOT_IN_SAMPLE
+		},
+		&gp_query_progress_max_nodes,
+		64, 0, 1000, NULL, NULL
+	},
+
+	{
+		{"gp_query_history_size", PGC_POSTMASTER, STATS_MONITORING,
+			gettext_noop("Sets the number of completed queries whose memory and spill usage is kept."),
+			gettext_noop("Each process of a query keeps an entry of its own. The history is shown "
+						 "by gp_toolkit.gp_query_resource_history. Zero disables it."),
+			GUC_NOT_IN_SAMPLE
+		},
+		&gp_query_history_size,
+		1000, 0, 100000, NULL, NULL
+	},
+
+	{
+		{"gp_statement_stats_max", PGC_POSTMASTER, STATS_MONITORING,
+			gettext_noop("Sets the number of distinct statements whose latency the master keeps."),
+			gettext_noop("Statements are told apart by their text with constants removed. "
+						 "The latencies are shown by gp_toolkit.gp_statement_stats. "
+						 "Zero disables it."),
+			GUC_NOT_IN_SAMPLE
+		},
+		&gp_statement_stats_max,
+		1000, 0, 10000, NULL, NULL
+	},
+
 	{
 		{"wal_send_client_timeout", PGC_SIGHUP, GP_ARRAY_TUNING,
 			gettext_noop("The time in milliseconds for a backend process to wait on the WAL Send server to finish a request to the QD mirroring standby."),
@@ -4340,6 +5104,16 @@ struct config_int ConfigureNamesInt_gp[] =
 		90, 0, 100, NULL, NULL
 	},
 
+	{
+		{"gp_vmem_reserve_batch_chunks", PGC_SUSET, RESOURCES_MEM,
+			gettext_noop("Number of extra vmem chunks a process reserves ahead of need, to update the segment vmem counters less often."),
+			gettext_noop("Chunks are not reserved ahead once the vmem usage reaches the red zone. Zero reserves exactly what is needed."),
+			GUC_NO_SHOW_ALL | GUC_NOT_IN_SAMPLE
+		},
+		&gp_vmem_reserve_batch_chunks,
+		4, 0, 64, NULL, NULL
+	},
+
 	{
 		{"gp_vmem_protect_segworker_cache_limit", PGC_POSTMASTER, RESOURCES_MEM,
 			gettext_noop("Max virtual memory limit (in MB) for a segworker to be cachable."),
@@ -4358,6 +5132,16 @@ struct config_int ConfigureNamesInt_gp[] =
 		INT_MAX, 0, INT_MAX, NULL, NULL
 	},
 
+	{
+		{"gp_autostats_min_interval", PGC_USERSET, DEVELOPER_OPTIONS,
+			gettext_noop("Minimum time between two automatic analyzes of a table in on_change_since_analyze mode. See gp_autostats_mode."),
+			NULL,
+			GUC_UNIT_S
+		},
+		&gp_autostats_min_interval,
+		60, 0, INT_MAX / 1000, NULL, NULL
+	},
+
 	{
 		{"gp_distinct_grouping_sets_threshold", PGC_USERSET, QUERY_TUNING_METHOD,
 			gettext_noop("Threshold for the number of grouping sets whose distinct-qualified "
@@ -4495,6 +5279,36 @@ struct config_int ConfigureNamesInt_gp[] =
 		NUM_MINIPAGE_ENTRIES, 1, NUM_MINIPAGE_ENTRIES, NULL, NULL
 	},
 
+	{
+		{"gp_blockdirectory_cache_size", PGC_POSTMASTER, GP_ARRAY_TUNING,
+			gettext_noop("Number of block directory entries cached in shared memory for append-only index scans."),
+			gettext_noop("Zero disables the cache."),
+			GUC_NOT_IN_SAMPLE
+		},
+		&gp_blockdirectory_cache_size,
+		4096, 0, INT_MAX / 1024, NULL, NULL
+	},
+
+	{
+		{"gp_shareinput_shmem_slots", PGC_POSTMASTER, RESOURCES_MEM,
+			gettext_noop("Number of shared memory slots for handing small cross-slice shared scans to their readers."),
+			gettext_noop("A shared Material result that fits in a slot is not written to disk. Zero disables the slots."),
+			GUC_NOT_IN_SAMPLE
+		},
+		&gp_shareinput_shmem_slots,
+		0, 0, 1024, NULL, NULL
+	},
+
+	{
+		{"gp_shareinput_shmem_slot_size", PGC_POSTMASTER, RESOURCES_MEM,
+			gettext_noop("Size of each shared memory slot for cross-slice shared scans."),
+			NULL,
+			GUC_UNIT_KB | GUC_NOT_IN_SAMPLE
+		},
+		&gp_shareinput_shmem_slot_size,
+		1024, 32, MAX_KILOBYTES, NULL, NULL
+	},
+
 
 	{
 		{"gp_segworker_relative_priority", PGC_POSTMASTER, RESOURCES_MGM,
@@ -4569,6 +5383,18 @@ struct config_int ConfigureNamesInt_gp[] =
 		100, 50, INT_MAX, NULL, NULL
 	},
 
+	{
+		{"gp_resource_group_spill_grace_mb", PGC_USERSET, RESOURCES_MEM,
+			gettext_noop("Sets the memory a query may overuse in its resource group while operators spill to disk."),
+			gettext_noop("When the resource group memory is exhausted, spilling operators are asked to "
+						 "write their data to disk, and the query is cancelled only if it needs more than "
+						 "this much memory beyond the limit. Zero cancels the query right away."),
+			GUC_GPDB_ADDOPT
+		},
+		&gp_resource_group_spill_grace_mb,
+		32, 0, 1024 * 1024, NULL, NULL
+	},
+
 	{
 		{"gp_backup_directIO_read_chunk_mb", PGC_USERSET, DEVELOPER_OPTIONS,
 			gettext_noop("Size of read Chunk buffer in directIO dump (in MB)"),
@@ -4675,6 +5501,17 @@ struct config_int ConfigureNamesInt_gp[] =
 		7, 0, INT_MAX, NULL, NULL
 	},
 
+	{
+		{"optimizer_search_time_limit", PGC_USERSET, QUERY_TUNING_METHOD,
+			gettext_noop("Sets the maximum time the optimizer searches for a better plan."),
+			gettext_noop("When the limit is reached, the best plan found so far is used. "
+						 "Zero means no limit. Ignored if optimizer_search_strategy_path is set."),
+			GUC_UNIT_MS | GUC_NOT_IN_SAMPLE
+		},
+		&optimizer_search_time_limit,
+		0, 0, INT_MAX, NULL, NULL
+	},
+
 	{
 		{"optimizer_penalize_broadcast_threshold", PGC_USERSET, QUERY_TUNING_METHOD,
 			gettext_noop("Maximum number of rows of a relation that can be broadcasted without penalty."),
@@ -4704,6 +5541,16 @@ struct config_int ConfigureNamesInt_gp[] =
 		&memory_profiler_dataset_size,
 		0, 0, INT_MAX, NULL, NULL
 	},
+
+	{
+		{"gp_memory_accounting_sample_size", PGC_USERSET, RESOURCES_MEM,
+			gettext_noop("Sets the amount of memory allocated between updates of the memory accounts' peaks."),
+			gettext_noop("The memory accounts' balances stay exact. Zero updates the peaks on every allocation."),
+			GUC_GPDB_ADDOPT | GUC_UNIT_KB | GUC_NOT_IN_SAMPLE
+		},
+		&gp_memory_accounting_sample_size,
+		0, 0, MAX_KILOBYTES, NULL, NULL
+	},
 	{
 		{"repl_catchup_within_range", PGC_SUSET, WAL_REPLICATION,
 			gettext_noop("Sets the maximum number of xlog segments allowed to lag"
@@ -4770,6 +5617,31 @@ struct config_int ConfigureNamesInt_gp[] =
 		0, INT_MAX, NULL, NULL
 	},
 
+	{
+		{"codegen_cache_size", PGC_USERSET, DEVELOPER_OPTIONS,
+			gettext_noop("Sets the maximum memory to be used for keeping compiled code for reuse by later queries."),
+			gettext_noop("Zero disables the cache."),
+			GUC_UNIT_KB | GUC_NO_SHOW_ALL | GUC_NOT_IN_SAMPLE
+		},
+		&codegen_cache_size,
+		8192, 0, MAX_KILOBYTES, NULL, NULL
+	},
+
+	{
+		{"codegen_disk_cache_size", PGC_SUSET, DEVELOPER_OPTIONS,
+			gettext_noop("Sets the maximum disk space to be used for keeping compiled code for reuse by later backends."),
+			gettext_noop("The compiled code is kept in the pg_codegen_cache directory of the data directory. Zero disables the cache."),
+			GUC_UNIT_KB | GUC_NO_SHOW_ALL | GUC_NOT_IN_SAMPLE
+		},
+		&codegen_disk_cache_size,
+#ifdef USE_CODEGEN
+		65536,
+#else
+		0,
+#endif
+		0, MAX_KILOBYTES, NULL, NULL
+	},
+
 	{
 		{"dtx_phase2_retry_count", PGC_SUSET, DEVELOPER_OPTIONS,
 			gettext_noop("Maximum number of retries during two phase commit after which master PANICs."),
@@ -4840,6 +5712,26 @@ struct config_real ConfigureNamesReal_gp[] =
 		0, 0, DBL_MAX, NULL, NULL
 	},
 
+	{
+		{"gp_motion_hot_key_fraction", PGC_USERSET, QUERY_TUNING_OTHER,
+			gettext_noop("Sets the fraction of a rel's rows above which a redistributed join key is considered hot."),
+			gettext_noop("Rows with a hot join key are spread over all segments on one side of "
+						 "the join and broadcast on the other. 0 disables this.")
+		},
+		&gp_motion_hot_key_fraction,
+		0, 0, 1.0, NULL, NULL
+	},
+
+	{
+		{"gp_hashagg_passthrough_ratio", PGC_USERSET, QUERY_TUNING_METHOD,
+			gettext_noop("Sets the groups per input row above which the streaming bottom stage of a two stage hashagg stops aggregating."),
+			gettext_noop("Rows are then sent on as they come, each as its own partial group. 0 disables this."),
+			GUC_NO_SHOW_ALL | GUC_NOT_IN_SAMPLE
+		},
+		&gp_hashagg_passthrough_ratio,
+		0.9, 0, 1.0, NULL, NULL
+	},
+
 	{
 		{"gp_analyze_relative_error", PGC_USERSET, STATS_ANALYZE,
 			gettext_noop("target relative error fraction for row sampling during analyze"),
@@ -4879,6 +5771,16 @@ struct config_real ConfigureNamesReal_gp[] =
 		20000.0, 0.0, DBL_MAX, NULL, NULL
 	},
 
+	{
+		{"gp_statistics_ao_block_sample_fraction", PGC_USERSET, STATS_ANALYZE,
+			gettext_noop("Fraction of varblocks that scans of append-only row tables read."),
+			gettext_noop("Set by ANALYZE around its sample query."),
+			GUC_NOT_IN_SAMPLE | GUC_NO_SHOW_ALL
+		},
+		&gp_statistics_ao_block_sample_fraction,
+		1.0, 0.0, 1.0, NULL, NULL
+	},
+
 	{
 		{"gp_resqueue_priority_cpucores_per_segment", PGC_POSTMASTER, RESOURCES_MGM,
 			gettext_noop("Number of processing units associated with a segment."),
@@ -4888,6 +5790,15 @@ struct config_real ConfigureNamesReal_gp[] =
 		4.0, 0.1, 512.0, NULL, NULL
 	},
 
+	{
+		{"gp_resqueue_fast_lane_cost", PGC_SIGHUP, RESOURCES_MGM,
+			gettext_noop("Sets the planned cost below which queries use the fast lane of a resource queue."),
+			gettext_noop("See gp_resqueue_fast_lane_slots.")
+		},
+		&gp_resqueue_fast_lane_cost,
+		0.0, 0.0, DBL_MAX, NULL, NULL
+	},
+
 	{
 		{"gp_resource_group_cpu_limit", PGC_POSTMASTER, RESOURCES,
 			gettext_noop("Maximum percentage of CPU resources assigned to a cluster."),
@@ -4975,6 +5886,27 @@ struct config_real ConfigureNamesReal_gp[] =
 		1.0, 0.0, DBL_MAX, NULL, NULL
 	},
 
+	{
+		{"codegen_above_cost", PGC_USERSET, DEVELOPER_OPTIONS,
+			gettext_noop("Perform code generation for queries whose plan costs more than this."),
+			gettext_noop("-1 disables code generation by cost."),
+			GUC_NO_SHOW_ALL | GUC_NOT_IN_SAMPLE | GUC_GPDB_ADDOPT
+		},
+		&codegen_above_cost,
+		100000.0, -1.0, DBL_MAX, NULL, NULL
+	},
+
+	{
+		{"codegen_optimize_above_cost", PGC_USERSET, DEVELOPER_OPTIONS,
+			gettext_noop("Optimize generated code at codegen_optimization_level for queries whose plan costs more than this."),
+			gettext_noop("Cheaper queries compile their generated code without optimization. "
+						 "-1 disables optimization."),
+			GUC_NO_SHOW_ALL | GUC_NOT_IN_SAMPLE | GUC_GPDB_ADDOPT
+		},
+		&codegen_optimize_above_cost,
+		500000.0, -1.0, DBL_MAX, NULL, NULL
+	},
+
 	/* End-of-list marker */
 	{
 		{NULL, 0, 0, NULL, NULL}, NULL, 0.0, 0.0, 0.0, NULL, NULL
@@ -4986,13 +5918,24 @@ struct config_string ConfigureNamesString_gp[] =
 	{
 		{"gp_workfile_compress_algorithm", PGC_USERSET, DEVELOPER_OPTIONS,
 			gettext_noop("Specify the compression algorithm that work files in the query executor use."),
-			gettext_noop("Valid values are \"NONE\", \"ZLIB\"."),
+			gettext_noop("Valid values are \"NONE\", \"ZLIB\", and \"LZ4\" in builds with lz4 support."),
 			GUC_GPDB_ADDOPT
 		},
 		&gp_workfile_compress_algorithm_str,
 		"none", assign_gp_workfile_compress_algorithm, NULL
 	},
 
+	{
+		{"gp_workfile_spill_locations", PGC_POSTMASTER, RESOURCES,
+			gettext_noop("Directories that executor work files are created in, by tier."),
+			gettext_noop("Tiers are separated by ';', fastest first, and hold ','-separated "
+						 "directories that are used round-robin. Empty uses the temporary filespace."),
+			GUC_NOT_IN_SAMPLE
+		},
+		&gp_workfile_spill_locations,
+		"", NULL, NULL
+	},
+
 	{
 		{"gpperfmon_log_alert_level", PGC_USERSET, LOGGING,
 			gettext_noop("Specify the log alert level used by gpperfmon."),
@@ -5114,7 +6057,7 @@ struct config_string ConfigureNamesString_gp[] =
 	{
 		{"gp_interconnect_fc_method", PGC_USERSET, GP_ARRAY_TUNING,
 			gettext_noop("Sets the flow control method used for UDP interconnect."),
-			gettext_noop("Valid values are \"capacity\" and \"loss\"."),
+			gettext_noop("Valid values are \"capacity\", \"loss\" and \"adaptive\"."),
 			GUC_GPDB_ADDOPT
 		},
 		&gp_interconnect_fc_method_str,
@@ -5143,7 +6086,7 @@ struct config_string ConfigureNamesString_gp[] =
 	{
 		{"gp_autostats_mode", PGC_USERSET, DEVELOPER_OPTIONS,
 			gettext_noop("Sets the autostats mode."),
-			gettext_noop("Valid values are NONE, ON_CHANGE, ON_NO_STATS. ON_CHANGE requires setting gp_autostats_on_change_threshold.")
+			gettext_noop("Valid values are NONE, ON_CHANGE, ON_NO_STATS, ON_CHANGE_SINCE_ANALYZE. ON_CHANGE requires setting gp_autostats_on_change_threshold.")
 		},
 		&gp_autostats_mode_string,
 		"none", gpvars_assign_gp_autostats_mode, gpvars_show_gp_autostats_mode
@@ -5151,7 +6094,7 @@ struct config_string ConfigureNamesString_gp[] =
 	{
 		{"gp_autostats_mode_in_functions", PGC_USERSET, DEVELOPER_OPTIONS,
 			gettext_noop("Sets the autostats mode for statements in procedural language functions."),
-			gettext_noop("Valid values are NONE, ON_CHANGE, ON_NO_STATS. ON_CHANGE requires setting gp_autostats_on_change_threshold.")
+			gettext_noop("Valid values are NONE, ON_CHANGE, ON_NO_STATS, ON_CHANGE_SINCE_ANALYZE. ON_CHANGE requires setting gp_autostats_on_change_threshold.")
 		},
 		&gp_autostats_mode_in_functions_string,
 		"none", gpvars_assign_gp_autostats_mode_in_functions, gpvars_show_gp_autostats_mode_in_functions
@@ -5166,6 +6109,17 @@ struct config_string ConfigureNamesString_gp[] =
 		"MEDIUM", gpvars_assign_gp_resqueue_priority_default_value, NULL
 	},
 
+	{
+		{"gp_resource_group_cpuset", PGC_POSTMASTER, RESOURCES,
+			gettext_noop("Dedicates cpu cores to resource groups."),
+			gettext_noop("A semicolon separated list of group_name:cpu_list, e.g. "
+						 "\"etl_group:8-15;bi_group:0-3\". The other groups share "
+						 "the remaining cores.")
+		},
+		&gp_resource_group_cpuset,
+		"", NULL, NULL
+	},
+
 	{
 		{"gp_resource_manager", PGC_POSTMASTER, RESOURCES,
 			gettext_noop("Sets the type of resource manager."),
@@ -5544,6 +6498,40 @@ struct config_enum ConfigureNamesEnum_gp[] =
 		EXPLAIN_MEMORY_VERBOSITY_SUPPRESS, explain_memory_verbosity_options, NULL, NULL
 	},
 
+	{
+		{"huge_pages", PGC_POSTMASTER, RESOURCES_MEM,
+			gettext_noop("Use of huge pages for the shared memory segment."),
+			gettext_noop("Valid values are OFF, ON, and TRY. With TRY, regular pages "
+						 "are used if huge pages cannot be allocated.")
+		},
+		&huge_pages,
+		HUGE_PAGES_TRY, huge_pages_options, NULL, NULL
+	},
+
+	{
+		{"gp_numa_policy", PGC_POSTMASTER, RESOURCES_MEM,
+			gettext_noop("NUMA memory policy of the shared memory segment."),
+			gettext_noop("Valid values are OFF, INTERLEAVE, and LOCAL. INTERLEAVE spreads "
+						 "shared memory over all the nodes, LOCAL places it on the node "
+						 "of the postmaster. Both keep the private memory of backends "
+						 "on their local node.")
+		},
+		&gp_numa_policy,
+		NUMA_POLICY_OFF, gp_numa_policy_options, NULL, NULL
+	},
+
+	{
+		{"gp_resqueue_priority_mode", PGC_POSTMASTER, RESOURCES_MGM,
+			gettext_noop("Sets how the priorities of resource queues are enforced."),
+			gettext_noop("Valid values are BACKOFF and NICE. BACKOFF makes backends sleep "
+						 "to meet their target CPU usage, NICE maps the priority to the "
+						 "nice value of the backends and lets the kernel scheduler share "
+						 "the CPU without sleeps.")
+		},
+		&gp_resqueue_priority_mode,
+		RESQUEUE_PRIORITY_MODE_BACKOFF, gp_resqueue_priority_mode_options, NULL, NULL
+	},
+
 	{
 		{"gp_test_system_cache_flush_force", PGC_USERSET, GP_ERROR_HANDLING,
 			gettext_noop("Force invalidation of system caches on each access"),
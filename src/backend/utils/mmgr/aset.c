@@ -290,6 +290,17 @@ static void dump_mc_for(FILE *file, MemoryContext mc)
 	if (mc == NULL)
 		return;
 
+	/* Only the generic fields of other context types are dumped */
+	if (!IsA(mc, AllocSetContext))
+	{
+		fprintf(file, "%p|%p|%d|%s|"UINT64_FORMAT"|"UINT64_FORMAT"|%zu\n", mc, mc->parent, mc->type, mc->name,
+				mc->allBytesAlloc, mc->allBytesFreed, mc->maxBytesHeld);
+
+		dump_mc_for(file, mc->nextchild);
+		dump_mc_for(file, mc->firstchild);
+		return;
+	}
+
 	AllocSet set = (AllocSet) mc;
 	fprintf(file, "%p|%p|%d|%s|"UINT64_FORMAT"|"UINT64_FORMAT"|%zu|%zu|%zu|%zu|%d", mc, mc->parent, mc->type, mc->name,
 			mc->allBytesAlloc, mc->allBytesFreed, mc->maxBytesHeld,
@@ -338,7 +349,8 @@ void dump_memory_allocation_ctxt(FILE *ofile, void *ctxt)
 {
 	AllocSet set = (AllocSet) ctxt;
 	AllocSet next;
-	AllocChunk chunk = set->allocList;
+	/* Only AllocSet tracks its allocated chunks */
+	AllocChunk chunk = IsA(set, AllocSetContext) ? set->allocList : NULL;
 
 	while(chunk)
 	{
@@ -0,0 +1,705 @@
+/*-------------------------------------------------------------------------
+ *
+ * bump.c
+ *	  Bump allocator definitions.
+ *
+ * Bump is a MemoryContext implementation for memory that is allocated
+ * piece by piece and released all at once, such as the tuples of one
+ * hash join batch.  Chunks are carved one after the other out of the
+ * current block.  They are only MAXALIGN'ed, not rounded up to a power of
+ * 2 as AllocSet does, and there are no freelists to search or maintain.
+ *
+ * pfree() of a chunk releases its memory accounting, but its space is only
+ * reused if it is the most recently allocated chunk of the current block.
+ * Everything else is given back to malloc() when the context is reset, so
+ * Bump is a poor fit for memory that is freed and reallocated piecemeal
+ * over a long lifetime.
+ *
+ * Chunks still carry a StandardChunkHeader, so pfree(), repalloc() and
+ * GetMemoryChunkSpace() work as for any other context.  The
+ * SharedChunkHeaders they point to are carved out of the same blocks, and
+ * live until the next reset.
+ *
+ * Portions Copyright (c) 2017-Present Pivotal Software, Inc.
+ *
+ *
+ * IDENTIFICATION
+ *	    src/backend/utils/mmgr/bump.c
+ *
+ *-------------------------------------------------------------------------
+ */
+
+#include "postgres.h"
+
+#include "utils/memutils.h"
+#include "utils/memaccounting.h"
+#include "utils/gp_alloc.h"
+
+#include "utils/memaccounting_private.h"
+
+#ifdef CDB_PALLOC_CALLER_ID
+#define CDB_MCXT_WHERE(context) (context)->callerFile, (context)->callerLine
+#else
+#define CDB_MCXT_WHERE(context) __FILE__, __LINE__
+#endif
+
+#define BUMP_BLOCKHDRSZ		MAXALIGN(sizeof(BumpBlockData))
+#define BUMP_CHUNKHDRSZ		STANDARDCHUNKHEADERSIZE
+#define BUMP_SHAREDHDRSZ	MAXALIGN(sizeof(SharedChunkHeader))
+
+/*
+ * How many of the most recent shared headers are checked for the active
+ * memory account before a new one is carved, as in AllocSet.
+ */
+#define BUMP_SHAREDHDR_LOOKAHEAD	3
+
+typedef struct BumpBlockData *BumpBlock;
+typedef StandardChunkHeader *BumpChunk;
+
+/*
+ * BumpBlock
+ *		The unit of memory that is obtained from malloc().  Chunks and shared
+ *		headers are carved from freeptr up to endptr.
+ */
+typedef struct BumpBlockData
+{
+	BumpBlock	next;			/* next block in the context's blocks list */
+	char	   *freeptr;		/* start of free space in this block */
+	char	   *endptr;			/* end of space in this block */
+} BumpBlockData;
+
+/*
+ * BumpContext
+ *		The head of the blocks list is the block being carved.  Blocks for
+ *		oversize chunks are linked in behind it, so that its free space is
+ *		not wasted.
+ */
+typedef struct BumpContext
+{
+	MemoryContextData header;	/* Standard memory-context fields */
+	BumpBlock	blocks;			/* head of list of blocks in this context */
+	bool		isReset;		/* T = no space alloced since last reset */
+	uint64		nChunks;		/* number of chunks not pfree'd */
+	/* Allocation parameters for this context: */
+	Size		initBlockSize;	/* initial block size */
+	Size		maxBlockSize;	/* maximum block size */
+	Size		nextBlockSize;	/* next block size to allocate */
+	Size		chunkLimit;		/* larger chunks get a block of their own */
+
+	/* Points to the head of the sharedHeaderList */
+	SharedChunkHeader *sharedHeaderList;
+	/* The memory account of this SharedChunkHeader is NULL */
+	SharedChunkHeader *nullAccountHeader;
+} BumpContext;
+
+#define BumpIsValid(set) PointerIsValid(set)
+
+#define BumpPointerGetChunk(ptr)	\
+					((BumpChunk)(((char *)(ptr)) - BUMP_CHUNKHDRSZ))
+#define BumpChunkGetPointer(chk)	\
+					((void *)(((char *)(chk)) + BUMP_CHUNKHDRSZ))
+
+/*
+ * These functions implement the MemoryContext API for Bump contexts.
+ */
+static void *BumpAlloc(MemoryContext context, Size size);
+static void BumpFree(MemoryContext context, void *pointer);
+static void *BumpRealloc(MemoryContext context, void *pointer, Size size);
+static void BumpInit(MemoryContext context);
+static void BumpReset(MemoryContext context);
+static void BumpDelete(MemoryContext context);
+static Size BumpGetChunkSpace(MemoryContext context, void *pointer);
+static bool BumpIsEmpty(MemoryContext context);
+static void Bump_GetStats(MemoryContext context, uint64 *nBlocks, uint64 *nChunks,
+		uint64 *currentAvailable, uint64 *allAllocated, uint64 *allFreed, uint64 *maxHeld);
+static void BumpReleaseAccountingForAllAllocatedChunks(MemoryContext context);
+
+#ifdef MEMORY_CONTEXT_CHECKING
+static void BumpCheck(MemoryContext context);
+#endif
+
+/*
+ * This is the virtual function table for Bump contexts.
+ */
+static MemoryContextMethods BumpMethods = {
+	BumpAlloc,
+	BumpFree,
+	BumpRealloc,
+	BumpInit,
+	BumpReset,
+	BumpDelete,
+	BumpGetChunkSpace,
+	BumpIsEmpty,
+	Bump_GetStats,
+	BumpReleaseAccountingForAllAllocatedChunks
+#ifdef MEMORY_CONTEXT_CHECKING
+	,BumpCheck
+#endif
+};
+
+/*
+ * BumpNewBlock
+ *		Gets a block of blksize bytes from malloc().
+ */
+static BumpBlock
+BumpNewBlock(BumpContext *set, Size blksize)
+{
+	BumpBlock	block;
+
+	block = (BumpBlock) gp_malloc(blksize);
+	if (block == NULL)
+		MemoryContextError(ERRCODE_OUT_OF_MEMORY,
+						   &set->header, CDB_MCXT_WHERE(&set->header),
+						   "Out of memory.  Failed on request of size %lu bytes.",
+						   (unsigned long) blksize);
+
+	block->freeptr = ((char *) block) + BUMP_BLOCKHDRSZ;
+	block->endptr = ((char *) block) + blksize;
+
+	MemoryContextNoteAlloc(&set->header, blksize);
+
+	return block;
+}
+
+/*
+ * BumpCarve
+ *		Carves size bytes, which must be MAXALIGN'ed, out of the context.
+ */
+static void *
+BumpCarve(BumpContext *set, Size size)
+{
+	BumpBlock	block = set->blocks;
+	char	   *ptr;
+
+	Assert(size == MAXALIGN(size));
+
+	set->isReset = false;
+
+	if (size > set->chunkLimit)
+	{
+		block = BumpNewBlock(set, size + BUMP_BLOCKHDRSZ);
+		block->freeptr = block->endptr;
+
+		/* Keep carving the head block, if there is one */
+		if (set->blocks != NULL)
+		{
+			block->next = set->blocks->next;
+			set->blocks->next = block;
+		}
+		else
+		{
+			block->next = NULL;
+			set->blocks = block;
+		}
+
+		return ((char *) block) + BUMP_BLOCKHDRSZ;
+	}
+
+	if (block == NULL || (Size) (block->endptr - block->freeptr) < size)
+	{
+		/*
+		 * The rest of the head block is abandoned; it is less than
+		 * chunkLimit, which is a small fraction of the block.
+		 */
+		Size		blksize = Max(set->nextBlockSize, size + BUMP_BLOCKHDRSZ);
+
+		set->nextBlockSize <<= 1;
+		if (set->nextBlockSize > set->maxBlockSize)
+			set->nextBlockSize = set->maxBlockSize;
+
+		block = BumpNewBlock(set, blksize);
+		block->next = set->blocks;
+		set->blocks = block;
+	}
+
+	ptr = block->freeptr;
+	block->freeptr += size;
+	Assert(block->freeptr <= block->endptr);
+
+	return ptr;
+}
+
+/*
+ * BumpGetSharedHeader
+ *		Returns the shared header for a new chunk charged to the active
+ *		memory account, carving a new one if needed.
+ */
+static SharedChunkHeader *
+BumpGetSharedHeader(BumpContext *set)
+{
+	SharedChunkHeader *header;
+	int			i;
+
+	/*
+	 * Chunks allocated before memory accounting is set up have no owner,
+	 * and are not accounted for, as in AllocSet.
+	 */
+	if (ActiveMemoryAccountId == MEMORY_OWNER_TYPE_Undefined)
+	{
+		if (set->nullAccountHeader == NULL)
+		{
+			header = (SharedChunkHeader *) BumpCarve(set, BUMP_SHAREDHDRSZ);
+			header->context = (MemoryContext) set;
+			header->memoryAccountId = MEMORY_OWNER_TYPE_Undefined;
+			header->balance = 0;
+			header->prev = NULL;
+			header->next = NULL;
+
+			set->nullAccountHeader = header;
+		}
+
+		return set->nullAccountHeader;
+	}
+
+	header = set->sharedHeaderList;
+	for (i = 0; i < BUMP_SHAREDHDR_LOOKAHEAD && header != NULL; i++)
+	{
+		if (header->memoryAccountId == ActiveMemoryAccountId)
+			return header;
+		header = header->next;
+	}
+
+	header = (SharedChunkHeader *) BumpCarve(set, BUMP_SHAREDHDRSZ);
+	header->context = (MemoryContext) set;
+	header->memoryAccountId = ActiveMemoryAccountId;
+	header->balance = 0;
+
+	header->prev = NULL;
+	header->next = set->sharedHeaderList;
+	if (header->next != NULL)
+		header->next->prev = header;
+	set->sharedHeaderList = header;
+
+	if (SharedChunkHeadersMemoryAccount != NULL)
+		MemoryAccounting_Allocate(MEMORY_OWNER_TYPE_SharedChunkHeader, BUMP_SHAREDHDRSZ);
+
+	return header;
+}
+
+
+/*
+ * Public routines
+ */
+
+
+/*
+ * BumpContextCreate
+ *		Create a new Bump context.
+ *
+ * parent: parent context, or NULL if top-level context
+ * name: name of context (for debugging --- string will be copied)
+ * initBlockSize: initial allocation block size
+ * maxBlockSize: maximum allocation block size
+ */
+MemoryContext
+BumpContextCreate(MemoryContext parent,
+				  const char *name,
+				  Size initBlockSize,
+				  Size maxBlockSize)
+{
+	BumpContext *context;
+
+	/* Do the type-independent part of context creation */
+	context = (BumpContext *) MemoryContextCreate(T_BumpContext,
+												  sizeof(BumpContext),
+												  &BumpMethods,
+												  parent,
+												  name);
+
+	/*
+	 * Make sure alloc parameters are reasonable, and save them.
+	 *
+	 * We enforce the same minimum 1K block size as AllocSet.
+	 */
+	initBlockSize = MAXALIGN(initBlockSize);
+	if (initBlockSize < 1024)
+		initBlockSize = 1024;
+	maxBlockSize = MAXALIGN(maxBlockSize);
+	if (maxBlockSize < initBlockSize)
+		maxBlockSize = initBlockSize;
+	context->initBlockSize = initBlockSize;
+	context->maxBlockSize = maxBlockSize;
+	context->nextBlockSize = initBlockSize;
+
+	/*
+	 * A chunk bigger than an eighth of the largest block gets a block of its
+	 * own, so that at most that much is abandoned at the end of a block.
+	 */
+	context->chunkLimit = MAXALIGN(maxBlockSize / 8);
+
+	context->blocks = NULL;
+	context->nChunks = 0;
+	context->sharedHeaderList = NULL;
+	context->nullAccountHeader = NULL;
+	context->isReset = true;
+
+	return (MemoryContext) context;
+}
+
+/*
+ * BumpInit
+ *		Context-type-specific initialization routine.
+ */
+static void
+BumpInit(MemoryContext context)
+{
+	/*
+	 * Since MemoryContextCreate already zeroed the context node, we don't
+	 * have to do anything here: it's already OK.
+	 */
+}
+
+/*
+ * BumpReleaseAccountingForAllAllocatedChunks
+ * 		Releases the accounting of all the chunks and shared headers in the
+ * 		sharedHeaderList, without freeing any memory.
+ *
+ * Unlike AllocSet, a shared header is kept when its balance drops to zero,
+ * so the list may hold headers with nothing left to release.
+ */
+static void
+BumpReleaseAccountingForAllAllocatedChunks(MemoryContext context)
+{
+	BumpContext *set = (BumpContext *) context;
+	uint64		sharedHeaderMemoryOverhead = 0;
+
+	for (SharedChunkHeader *curHeader = set->sharedHeaderList; curHeader != NULL;
+			curHeader = curHeader->next)
+	{
+		Assert(curHeader->balance >= 0);
+		if (curHeader->balance > 0)
+			MemoryAccounting_Free(curHeader->memoryAccountId, curHeader->balance);
+
+		sharedHeaderMemoryOverhead += BUMP_SHAREDHDRSZ;
+	}
+
+	if (sharedHeaderMemoryOverhead > 0)
+		MemoryAccounting_Free(MEMORY_OWNER_TYPE_SharedChunkHeader, sharedHeaderMemoryOverhead);
+
+	set->sharedHeaderList = NULL;
+}
+
+/*
+ * BumpReset
+ *		Frees all memory which is allocated in the given context.
+ */
+static void
+BumpReset(MemoryContext context)
+{
+	BumpContext *set = (BumpContext *) context;
+	BumpBlock	block;
+
+	AssertArg(BumpIsValid(set));
+
+	/* Nothing to do if no pallocs since startup or last reset */
+	if (set->isReset)
+		return;
+
+#ifdef MEMORY_CONTEXT_CHECKING
+	/* Check for corruption before freeing */
+	BumpCheck(context);
+#endif
+
+	BumpReleaseAccountingForAllAllocatedChunks(context);
+
+	block = set->blocks;
+	set->blocks = NULL;
+
+	while (block != NULL)
+	{
+		BumpBlock	next = block->next;
+
+		MemoryContextNoteFree(&set->header, block->endptr - ((char *) block));
+
+#ifdef CLOBBER_FREED_MEMORY
+		/* Wipe freed memory for debugging purposes */
+		memset(block, 0x7F, block->freeptr - ((char *) block));
+#endif
+		gp_free(block);
+		block = next;
+	}
+
+	/* Reset block size allocation sequence, too */
+	set->nextBlockSize = set->initBlockSize;
+
+	set->nChunks = 0;
+	set->nullAccountHeader = NULL;
+	set->isReset = true;
+}
+
+/*
+ * BumpDelete
+ *		Frees all memory which is allocated in the given context,
+ *		in preparation for deletion of the context.
+ *
+ * Bump keeps no block over resets, so this is the same as a reset.
+ */
+static void
+BumpDelete(MemoryContext context)
+{
+	BumpReset(context);
+}
+
+/*
+ * BumpAlloc
+ *		Returns pointer to allocated memory of given size; memory is added
+ *		to the context.
+ */
+static void *
+BumpAlloc(MemoryContext context, Size size)
+{
+	BumpContext *set = (BumpContext *) context;
+	SharedChunkHeader *sharedHeader;
+	BumpChunk	chunk;
+	Size		chunk_size = MAXALIGN(size);
+
+	AssertArg(BumpIsValid(set));
+
+	/*
+	 * Get the shared header first: if it has to be carved, it must not end
+	 * up between the chunk and the free space that follows it.
+	 */
+	sharedHeader = BumpGetSharedHeader(set);
+
+	chunk = (BumpChunk) BumpCarve(set, chunk_size + BUMP_CHUNKHDRSZ);
+	chunk->sharedHeader = sharedHeader;
+	chunk->size = chunk_size;
+
+#ifdef MEMORY_CONTEXT_CHECKING
+	chunk->requested_size = size;
+	/* set mark to catch clobber of "unused" space */
+	if (size < chunk_size)
+		((char *) BumpChunkGetPointer(chunk))[size] = 0x7E;
+#endif
+#ifdef CDB_PALLOC_TAGS
+	chunk->alloc_tag = set->header.callerFile;
+	chunk->alloc_n = set->header.callerLine;
+	chunk->prev_chunk = NULL;
+	chunk->next_chunk = NULL;
+#endif
+
+	sharedHeader->balance += chunk_size + BUMP_CHUNKHDRSZ;
+	if (sharedHeader->memoryAccountId != MEMORY_OWNER_TYPE_Undefined)
+		MemoryAccounting_Allocate(sharedHeader->memoryAccountId, chunk_size + BUMP_CHUNKHDRSZ);
+
+	set->nChunks++;
+
+	return BumpChunkGetPointer(chunk);
+}
+
+/*
+ * BumpFree
+ *		Releases the accounting of the chunk.  Its space is reused only if it
+ *		is the last chunk carved from the head block.
+ */
+static void
+BumpFree(MemoryContext context, void *pointer)
+{
+	BumpContext *set = (BumpContext *) context;
+	BumpChunk	chunk = BumpPointerGetChunk(pointer);
+	SharedChunkHeader *sharedHeader = chunk->sharedHeader;
+	BumpBlock	block = set->blocks;
+
+	AssertArg(BumpIsValid(set));
+
+#ifdef MEMORY_CONTEXT_CHECKING
+	Assert(chunk->requested_size != 0xFFFFFFFF);
+	/* Test for someone scribbling on unused space in chunk */
+	if (chunk->requested_size < chunk->size)
+	{
+		if (((char *) pointer)[chunk->requested_size] != 0x7E)
+		{
+			Assert(!"Memory error");
+			elog(WARNING, "detected write past chunk end in %s %p (%s:%d)",
+					set->header.name, chunk, CDB_MCXT_WHERE(&set->header));
+		}
+	}
+	chunk->requested_size = 0xFFFFFFFF;
+#endif
+
+	Assert(sharedHeader->context == context);
+
+	sharedHeader->balance -= chunk->size + BUMP_CHUNKHDRSZ;
+	Assert(sharedHeader->balance >= 0);
+	if (sharedHeader->memoryAccountId != MEMORY_OWNER_TYPE_Undefined)
+		MemoryAccounting_Free(sharedHeader->memoryAccountId, chunk->size + BUMP_CHUNKHDRSZ);
+
+	set->nChunks--;
+
+#ifdef CLOBBER_FREED_MEMORY
+	/* Wipe freed memory for debugging purposes */
+	memset(pointer, 0x7F, chunk->size);
+#endif
+
+	if (block != NULL && ((char *) pointer) + chunk->size == block->freeptr)
+		block->freeptr = (char *) chunk;
+}
+
+/*
+ * BumpRealloc
+ *		Returns new pointer to allocated memory of given size; this memory
+ *		is added to the context.  Memory associated with given pointer is
+ *		copied into the new memory, and the old memory is freed.
+ */
+static void *
+BumpRealloc(MemoryContext context, void *pointer, Size size)
+{
+	BumpContext *set = (BumpContext *) context;
+	BumpChunk	chunk = BumpPointerGetChunk(pointer);
+	Size		oldsize = chunk->size;
+	BumpBlock	block = set->blocks;
+	void	   *newPointer;
+
+	AssertArg(BumpIsValid(set));
+
+	/*
+	 * The last chunk carved from the head block can grow or shrink in place,
+	 * like a stack top.
+	 */
+	if (block != NULL && ((char *) pointer) + oldsize == block->freeptr &&
+		MAXALIGN(size) <= (Size) (block->endptr - (char *) pointer))
+	{
+		SharedChunkHeader *sharedHeader = chunk->sharedHeader;
+		Size		chunk_size = MAXALIGN(size);
+
+		block->freeptr = ((char *) pointer) + chunk_size;
+		chunk->size = chunk_size;
+
+		sharedHeader->balance += (int64) chunk_size - (int64) oldsize;
+		Assert(sharedHeader->balance >= 0);
+		if (sharedHeader->memoryAccountId != MEMORY_OWNER_TYPE_Undefined)
+		{
+			if (chunk_size > oldsize)
+				MemoryAccounting_Allocate(sharedHeader->memoryAccountId, chunk_size - oldsize);
+			else
+				MemoryAccounting_Free(sharedHeader->memoryAccountId, oldsize - chunk_size);
+		}
+
+#ifdef MEMORY_CONTEXT_CHECKING
+		chunk->requested_size = size;
+		/* set mark to catch clobber of "unused" space */
+		if (size < chunk_size)
+			((char *) pointer)[size] = 0x7E;
+#endif
+		return pointer;
+	}
+
+	/* Any other chunk that is big enough stays where it is */
+	if (oldsize >= size)
+	{
+#ifdef MEMORY_CONTEXT_CHECKING
+		chunk->requested_size = size;
+		/* set mark to catch clobber of "unused" space */
+		if (size < oldsize)
+			((char *) pointer)[size] = 0x7E;
+#endif
+		return pointer;
+	}
+
+	newPointer = BumpAlloc(context, size);
+	memcpy(newPointer, pointer, oldsize);
+	BumpFree(context, pointer);
+
+	return newPointer;
+}
+
+/*
+ * BumpGetChunkSpace
+ *		Given a currently-allocated chunk, determine the total space
+ *		it occupies (including all memory-allocation overhead).
+ */
+static Size
+BumpGetChunkSpace(MemoryContext context, void *pointer)
+{
+	BumpChunk	chunk = BumpPointerGetChunk(pointer);
+
+	return chunk->size + BUMP_CHUNKHDRSZ;
+}
+
+/*
+ * BumpIsEmpty
+ *		Is a Bump context empty of any allocated space?
+ */
+static bool
+BumpIsEmpty(MemoryContext context)
+{
+	BumpContext *set = (BumpContext *) context;
+
+	return set->isReset;
+}
+
+/*
+ * Bump_GetStats
+ *		Returns stats about memory consumption of a Bump context.
+ *
+ *	Input parameters:
+ *		context: the context of interest
+ *
+ *	Output parameters:
+ *		nBlocks: number of blocks in the context
+ *		nChunks: number of chunks that were allocated and not freed yet
+ *		currentAvailable: free space left in the block being carved
+ *		allAllocated: total bytes allocated during lifetime (including
+ *		blocks that were dropped later on, e.g., by a reset)
+ *		allFreed: total bytes that were freed during lifetime
+ *		maxHeld: maximum bytes held during lifetime
+ */
+static void
+Bump_GetStats(MemoryContext context, uint64 *nBlocks, uint64 *nChunks,
+		uint64 *currentAvailable, uint64 *allAllocated, uint64 *allFreed, uint64 *maxHeld)
+{
+	BumpContext *set = (BumpContext *) context;
+	BumpBlock	block;
+
+	*nBlocks = 0;
+	*nChunks = set->nChunks;
+	*currentAvailable = 0;
+	*allAllocated = set->header.allBytesAlloc;
+	*allFreed = set->header.allBytesFreed;
+	*maxHeld = set->header.maxBytesHeld;
+
+	for (block = set->blocks; block != NULL; block = block->next)
+		*nBlocks = *nBlocks + 1;
+
+	/* Only the space at the end of the first block is available for use. */
+	if (set->blocks != NULL)
+		*currentAvailable = set->blocks->endptr - set->blocks->freeptr;
+}
+
+#ifdef MEMORY_CONTEXT_CHECKING
+
+/*
+ * BumpCheck
+ *		Check the consistency of the blocks and shared headers.
+ *
+ * Chunks and shared headers are interleaved in the blocks, so the chunks
+ * cannot be walked as in AllocSetCheck.
+ *
+ * NOTE: report errors as WARNING, *not* ERROR or FATAL, as AllocSetCheck
+ * does.
+ */
+static void
+BumpCheck(MemoryContext context)
+{
+	BumpContext *set = (BumpContext *) context;
+	char	   *name = set->header.name;
+	BumpBlock	block;
+	SharedChunkHeader *header;
+
+	for (block = set->blocks; block != NULL; block = block->next)
+	{
+		if (block->freeptr < ((char *) block) + BUMP_BLOCKHDRSZ ||
+			block->freeptr > block->endptr)
+			elog(WARNING, "problem in bump context %s: bogus freeptr in block %p",
+				 name, block);
+	}
+
+	for (header = set->sharedHeaderList; header != NULL; header = header->next)
+	{
+		if (header->context != context || header->balance < 0)
+			elog(WARNING, "problem in bump context %s: bogus shared header %p",
+				 name, header);
+	}
+}
+
+#endif   /* MEMORY_CONTEXT_CHECKING */
@@ -158,6 +158,9 @@ IdleTracker_DeactivateProcess()
 		Assert(isProcessActive);
 		Assert(deactivationVersion <= activationVersion);
 
+		/* An idle process doesn't keep vmem reserved ahead of need */
+		VmemTracker_ReleaseCachedVmemChunks();
+
 		/* No new runaway event can come in */
 		SpinLockAcquire(&MySessionState->spinLock);
 
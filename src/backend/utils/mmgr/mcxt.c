@@ -912,6 +912,16 @@ MemoryContextContainsGenericAllocation(MemoryContext context, void *pointer)
 	/*
 	 * OK, it's probably safe to look at the chunk header.
 	 */
+	/*
+	 * Only AllocSet is checked. For other context types we conclude that
+	 * the chunk does not belong to the context, which callers must already
+	 * be prepared for.
+	 */
+	if (!IsA(context, AllocSetContext))
+	{
+		return false;
+	}
+
 	header = (StandardChunkHeader *)
 		((char *) pointer - STANDARDCHUNKHEADERSIZE);
 
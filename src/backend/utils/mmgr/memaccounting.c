@@ -137,6 +137,9 @@ MemoryAccounting_ResetPeakBalance(void);
 static uint64
 MemoryAccounting_GetBalance(MemoryAccount* memoryAccount);
 
+static void
+MemoryAccounting_UpdateActivePeak(void);
+
 /*****************************************************************************
  * Global memory accounting variables, some are only visible via memaccounting_private.h
  */
@@ -196,6 +199,12 @@ uint64 MemoryAccountingOutstandingBalance = 0;
  */
 uint64 MemoryAccountingPeakBalance = 0;
 
+/*
+ * Bytes left to allocate before the peaks are brought up to date, when they
+ * are sampled (see gp_memory_accounting_sample_size)
+ */
+int64 MemoryAccountingBytesToSample = 0;
+
 /******************************************/
 /********** Public interface **************/
 
@@ -252,20 +261,55 @@ MemoryAccounting_DeclareDone()
 	{
 		relinquished = currentAccount->maxLimit - currentAccount->allocated;
 		RelinquishedPoolMemoryAccount->allocated += relinquished;
-		currentAccount->relinquishedMemory = relinquished;
+		currentAccount->relinquishedMemory += relinquished;
 	}
 
 	elog(DEBUG2, "Memory Account %d relinquished %lu bytes of memory", currentAccount->ownerType, relinquished);
 	return relinquished;
 }
 
+/*
+ * MemoryAccounting_RelinquishQuota
+ * 		Gives the remaining quota of an operator's Memory Account back to the
+ * 		RelinquishedPoolMemoryAccount, so that spilling operators can grow into it.
+ * 		Unlike MemoryAccounting_DeclareDone, this gives back the whole quota,
+ * 		including the memory acquired from the pool, less whatever was already
+ * 		relinquished. This should only be called once the operator has freed its
+ * 		memory, i.e., from the ExecEagerFree* functions.
+ *
+ * accountId: the account of the operator; long living accounts have no quota
+ */
+uint64
+MemoryAccounting_RelinquishQuota(MemoryAccountIdType accountId)
+{
+	MemoryAccount *account;
+	uint64 quota;
+	uint64 relinquished = 0;
+
+	/* Undefined, long living and dead accounts have nothing to give back */
+	if (accountId < liveAccountStartId)
+		return 0;
+
+	account = MemoryAccounting_ConvertIdToAccount(accountId);
+	quota = account->maxLimit + account->acquiredMemory;
+	if (quota > account->relinquishedMemory)
+	{
+		relinquished = quota - account->relinquishedMemory;
+		RelinquishedPoolMemoryAccount->allocated += relinquished;
+		account->relinquishedMemory += relinquished;
+	}
+
+	elog(DEBUG2, "Memory Account %d relinquished " UINT64_FORMAT " bytes of quota", account->ownerType, relinquished);
+	return relinquished;
+}
+
 uint64
 MemoryAccounting_RequestQuotaIncrease()
 {
 	MemoryAccount *currentAccount = MemoryAccounting_ConvertIdToAccount(ActiveMemoryAccountId);
 
 	uint64 result = RelinquishedPoolMemoryAccount->allocated;
-	currentAccount->acquiredMemory = result;
+	currentAccount->acquiredMemory += result;
 	RelinquishedPoolMemoryAccount->allocated = 0;
 	return result;
 }
@@ -325,6 +369,12 @@ MemoryAccounting_SwitchAccount(MemoryAccountIdType desiredAccountId)
 	Assert(desiredAccountId < nextAccountId);
 	MemoryAccountIdType oldAccountId = ActiveMemoryAccountId;
 
+	/* With sampled peaks, the account being left gets its peak up to date */
+	if (gp_memory_accounting_sample_size > 0)
+	{
+		MemoryAccounting_UpdateActivePeak();
+	}
+
 	ActiveMemoryAccountId = desiredAccountId;
 	return oldAccountId;
 }
@@ -351,6 +401,8 @@ MemoryAccounting_SizeOfAccountInBytes()
 uint64
 MemoryAccounting_GetAccountPeakBalance(MemoryAccountIdType memoryAccountId)
 {
+	MemoryAccounting_UpdateActivePeak();
+
 	return MemoryAccounting_ConvertIdToAccount(memoryAccountId)->peak;
 }
 
@@ -386,6 +438,8 @@ MemoryAccounting_GetBalance(MemoryAccount* memoryAccount)
 uint64
 MemoryAccounting_GetGlobalPeak()
 {
+	MemoryAccounting_UpdateActivePeak();
+
 	return MemoryAccountingPeakBalance;
 }
 
@@ -396,6 +450,8 @@ MemoryAccounting_GetGlobalPeak()
 uint32
 MemoryAccounting_Serialize(StringInfoData *buffer)
 {
+	MemoryAccounting_UpdateActivePeak();
+
 	START_MEMORY_ACCOUNT(MEMORY_OWNER_TYPE_MemAccount);
 	{
 		/* Ignore undefined account */
@@ -473,6 +529,9 @@ MemoryAccounting_SaveToFile(int currentSliceId)
 {
 	StringInfoData prefix;
 	StringInfoData memBuf;
+
+	MemoryAccounting_UpdateActivePeak();
+
 	initStringInfo(&prefix);
 	initStringInfo(&memBuf);
 
@@ -510,6 +569,8 @@ MemoryAccounting_SaveToLog()
 {
 	int64 vmem_reserved = VmemTracker_GetMaxReservedVmemBytes();
 
+	MemoryAccounting_UpdateActivePeak();
+
 	/* Write the header for the subsequent lines of memory usage information */
 	write_stderr("memory: account_name, account_id, parent_account_id, quota, peak, allocated, freed, current\n");
 
@@ -1434,6 +1495,23 @@ MemoryAccounting_ResetPeakBalance()
 	MemoryAccountingPeakBalance = MemoryAccountingOutstandingBalance;
 }
 
+/*
+ * MemoryAccounting_UpdateActivePeak
+ *    Brings the peak of the active account and the global peak up to date,
+ *    as they may lag behind when gp_memory_accounting_sample_size is set.
+ *    Accounts other than the active one are brought up to date when they are
+ *    switched away from, and their balance can only go down until they are
+ *    switched back to.
+ */
+static void
+MemoryAccounting_UpdateActivePeak()
+{
+	if (MemoryAccounting_IsLiveAccount(ActiveMemoryAccountId))
+	{
+		MemoryAccounting_UpdatePeak(MemoryAccounting_ConvertIdToAccount(ActiveMemoryAccountId));
+	}
+}
+
 /*
  * SaveMemoryBufToDisk
  *    Saves the memory account information in a file. The file name is auto
@@ -0,0 +1,617 @@
+/*-------------------------------------------------------------------------
+ *
+ * slab.c
+ *	  Slab allocator definitions.
+ *
+ * Slab is a MemoryContext implementation for many objects of one fixed
+ * size, such as the entries of a hash table.  Every chunk takes the same
+ * slot in a block, so a pfree'd chunk goes on a single freelist and is
+ * handed out again by the next palloc() with no search and no rounding of
+ * the request to a power of 2.  A request larger than the context's chunk
+ * size is an error.
+ *
+ * Blocks are only given back to malloc() when the context is reset.
+ *
+ * Chunks carry a StandardChunkHeader, so pfree(), repalloc() and
+ * GetMemoryChunkSpace() work as for any other context.  The
+ * SharedChunkHeaders they point to take slots of their own, and live until
+ * the next reset.
+ *
+ * Portions Copyright (c) 2017-Present Pivotal Software, Inc.
+ *
+ *
+ * IDENTIFICATION
+ *	    src/backend/utils/mmgr/slab.c
+ *
+ *-------------------------------------------------------------------------
+ */
+
+#include "postgres.h"
+
+#include "utils/memutils.h"
+#include "utils/memaccounting.h"
+#include "utils/gp_alloc.h"
+
+#include "utils/memaccounting_private.h"
+
+#ifdef CDB_PALLOC_CALLER_ID
+#define CDB_MCXT_WHERE(context) (context)->callerFile, (context)->callerLine
+#else
+#define CDB_MCXT_WHERE(context) __FILE__, __LINE__
+#endif
+
+#define SLAB_BLOCKHDRSZ		MAXALIGN(sizeof(SlabBlockData))
+#define SLAB_CHUNKHDRSZ		STANDARDCHUNKHEADERSIZE
+
+/*
+ * How many of the most recent shared headers are checked for the active
+ * memory account before a new one is made, as in AllocSet.
+ */
+#define SLAB_SHAREDHDR_LOOKAHEAD	3
+
+typedef struct SlabBlockData *SlabBlock;
+typedef StandardChunkHeader *SlabChunk;
+
+/*
+ * SlabBlock
+ *		The unit of memory that is obtained from malloc().  Slots that were
+ *		never used are carved from freeptr up to endptr.
+ */
+typedef struct SlabBlockData
+{
+	SlabBlock	next;			/* next block in the context's blocks list */
+	char	   *freeptr;		/* start of never used slots in this block */
+	char	   *endptr;			/* end of space in this block */
+} SlabBlockData;
+
+/*
+ * SlabContext
+ *		A free chunk's sharedHeader points to the next chunk in the freelist,
+ *		as in AllocSet.
+ */
+typedef struct SlabContext
+{
+	MemoryContextData header;	/* Standard memory-context fields */
+	SlabBlock	blocks;			/* head of list of blocks in this context */
+	SlabChunk	freelist;		/* pfree'd chunks */
+	bool		isReset;		/* T = no space alloced since last reset */
+	uint64		nChunks;		/* number of chunks not pfree'd */
+	/* Allocation parameters for this context: */
+	Size		chunkSize;		/* size of data space of every chunk */
+	Size		blockSize;		/* size of every block */
+
+	/* Points to the head of the sharedHeaderList */
+	SharedChunkHeader *sharedHeaderList;
+	/* The memory account of this SharedChunkHeader is NULL */
+	SharedChunkHeader *nullAccountHeader;
+} SlabContext;
+
+#define SlabIsValid(set) PointerIsValid(set)
+
+#define SlabPointerGetChunk(ptr)	\
+					((SlabChunk)(((char *)(ptr)) - SLAB_CHUNKHDRSZ))
+#define SlabChunkGetPointer(chk)	\
+					((void *)(((char *)(chk)) + SLAB_CHUNKHDRSZ))
+
+/*
+ * These functions implement the MemoryContext API for Slab contexts.
+ */
+static void *SlabAlloc(MemoryContext context, Size size);
+static void SlabFree(MemoryContext context, void *pointer);
+static void *SlabRealloc(MemoryContext context, void *pointer, Size size);
+static void SlabInit(MemoryContext context);
+static void SlabReset(MemoryContext context);
+static void SlabDelete(MemoryContext context);
+static Size SlabGetChunkSpace(MemoryContext context, void *pointer);
+static bool SlabIsEmpty(MemoryContext context);
+static void Slab_GetStats(MemoryContext context, uint64 *nBlocks, uint64 *nChunks,
+		uint64 *currentAvailable, uint64 *allAllocated, uint64 *allFreed, uint64 *maxHeld);
+static void SlabReleaseAccountingForAllAllocatedChunks(MemoryContext context);
+
+#ifdef MEMORY_CONTEXT_CHECKING
+static void SlabCheck(MemoryContext context);
+#endif
+
+/*
+ * This is the virtual function table for Slab contexts.
+ */
+static MemoryContextMethods SlabMethods = {
+	SlabAlloc,
+	SlabFree,
+	SlabRealloc,
+	SlabInit,
+	SlabReset,
+	SlabDelete,
+	SlabGetChunkSpace,
+	SlabIsEmpty,
+	Slab_GetStats,
+	SlabReleaseAccountingForAllAllocatedChunks
+#ifdef MEMORY_CONTEXT_CHECKING
+	,SlabCheck
+#endif
+};
+
+/*
+ * SlabGetSlot
+ *		Returns a slot for a chunk, from the freelist if possible.
+ */
+static SlabChunk
+SlabGetSlot(SlabContext *set)
+{
+	Size		slotSize = set->chunkSize + SLAB_CHUNKHDRSZ;
+	SlabBlock	block = set->blocks;
+	SlabChunk	chunk;
+
+	set->isReset = false;
+
+	if (set->freelist != NULL)
+	{
+		chunk = set->freelist;
+		set->freelist = (SlabChunk) chunk->sharedHeader;
+		return chunk;
+	}
+
+	if (block == NULL || (Size) (block->endptr - block->freeptr) < slotSize)
+	{
+		block = (SlabBlock) gp_malloc(set->blockSize);
+		if (block == NULL)
+			MemoryContextError(ERRCODE_OUT_OF_MEMORY,
+							   &set->header, CDB_MCXT_WHERE(&set->header),
+							   "Out of memory.  Failed on request of size %lu bytes.",
+							   (unsigned long) set->blockSize);
+
+		block->freeptr = ((char *) block) + SLAB_BLOCKHDRSZ;
+		block->endptr = ((char *) block) + set->blockSize;
+		block->next = set->blocks;
+		set->blocks = block;
+
+		MemoryContextNoteAlloc(&set->header, set->blockSize);
+	}
+
+	chunk = (SlabChunk) block->freeptr;
+	block->freeptr += slotSize;
+
+	return chunk;
+}
+
+/*
+ * SlabNewSharedHeader
+ *		Makes a shared header for the given memory account in a slot of its
+ *		own.  The slot is not returned to the freelist until the next reset.
+ */
+static SharedChunkHeader *
+SlabNewSharedHeader(SlabContext *set, MemoryAccountIdType memoryAccountId)
+{
+	SharedChunkHeader *header;
+
+	header = (SharedChunkHeader *) SlabChunkGetPointer(SlabGetSlot(set));
+	header->context = (MemoryContext) set;
+	header->memoryAccountId = memoryAccountId;
+	header->balance = 0;
+	header->prev = NULL;
+	header->next = NULL;
+
+	return header;
+}
+
+/*
+ * SlabGetSharedHeader
+ *		Returns the shared header for a new chunk charged to the active
+ *		memory account, making a new one if needed.
+ */
+static SharedChunkHeader *
+SlabGetSharedHeader(SlabContext *set)
+{
+	SharedChunkHeader *header;
+	int			i;
+
+	/*
+	 * Chunks allocated before memory accounting is set up have no owner,
+	 * and are not accounted for, as in AllocSet.
+	 */
+	if (ActiveMemoryAccountId == MEMORY_OWNER_TYPE_Undefined)
+	{
+		if (set->nullAccountHeader == NULL)
+			set->nullAccountHeader = SlabNewSharedHeader(set, MEMORY_OWNER_TYPE_Undefined);
+
+		return set->nullAccountHeader;
+	}
+
+	header = set->sharedHeaderList;
+	for (i = 0; i < SLAB_SHAREDHDR_LOOKAHEAD && header != NULL; i++)
+	{
+		if (header->memoryAccountId == ActiveMemoryAccountId)
+			return header;
+		header = header->next;
+	}
+
+	header = SlabNewSharedHeader(set, ActiveMemoryAccountId);
+	header->next = set->sharedHeaderList;
+	if (header->next != NULL)
+		header->next->prev = header;
+	set->sharedHeaderList = header;
+
+	if (SharedChunkHeadersMemoryAccount != NULL)
+		MemoryAccounting_Allocate(MEMORY_OWNER_TYPE_SharedChunkHeader,
+								  set->chunkSize + SLAB_CHUNKHDRSZ);
+
+	return header;
+}
+
+
+/*
+ * Public routines
+ */
+
+
+/*
+ * SlabContextCreate
+ *		Create a new Slab context.
+ *
+ * parent: parent context, or NULL if top-level context
+ * name: name of context (for debugging --- string will be copied)
+ * chunkSize: the largest request that the context will serve
+ * blockSize: allocation block size
+ */
+MemoryContext
+SlabContextCreate(MemoryContext parent,
+				  const char *name,
+				  Size chunkSize,
+				  Size blockSize)
+{
+	SlabContext *context;
+
+	/* Do the type-independent part of context creation */
+	context = (SlabContext *) MemoryContextCreate(T_SlabContext,
+												  sizeof(SlabContext),
+												  &SlabMethods,
+												  parent,
+												  name);
+
+	/*
+	 * Make sure alloc parameters are reasonable, and save them.
+	 *
+	 * A slot must be able to hold a shared header, and a block must hold a
+	 * reasonable number of slots.
+	 */
+	chunkSize = MAXALIGN(Max(chunkSize, sizeof(SharedChunkHeader)));
+	blockSize = MAXALIGN(blockSize);
+	if (blockSize < SLAB_BLOCKHDRSZ + 8 * (chunkSize + SLAB_CHUNKHDRSZ))
+		blockSize = SLAB_BLOCKHDRSZ + 8 * (chunkSize + SLAB_CHUNKHDRSZ);
+	context->chunkSize = chunkSize;
+	context->blockSize = blockSize;
+
+	context->blocks = NULL;
+	context->freelist = NULL;
+	context->nChunks = 0;
+	context->sharedHeaderList = NULL;
+	context->nullAccountHeader = NULL;
+	context->isReset = true;
+
+	return (MemoryContext) context;
+}
+
+/*
+ * SlabInit
+ *		Context-type-specific initialization routine.
+ */
+static void
+SlabInit(MemoryContext context)
+{
+	/*
+	 * Since MemoryContextCreate already zeroed the context node, we don't
+	 * have to do anything here: it's already OK.
+	 */
+}
+
+/*
+ * SlabReleaseAccountingForAllAllocatedChunks
+ * 		Releases the accounting of all the chunks and shared headers in the
+ * 		sharedHeaderList, without freeing any memory.
+ *
+ * Unlike AllocSet, a shared header is kept when its balance drops to zero,
+ * so the list may hold headers with nothing left to release.
+ */
+static void
+SlabReleaseAccountingForAllAllocatedChunks(MemoryContext context)
+{
+	SlabContext *set = (SlabContext *) context;
+	uint64		sharedHeaderMemoryOverhead = 0;
+
+	for (SharedChunkHeader *curHeader = set->sharedHeaderList; curHeader != NULL;
+			curHeader = curHeader->next)
+	{
+		Assert(curHeader->balance >= 0);
+		if (curHeader->balance > 0)
+			MemoryAccounting_Free(curHeader->memoryAccountId, curHeader->balance);
+
+		sharedHeaderMemoryOverhead += set->chunkSize + SLAB_CHUNKHDRSZ;
+	}
+
+	if (sharedHeaderMemoryOverhead > 0)
+		MemoryAccounting_Free(MEMORY_OWNER_TYPE_SharedChunkHeader, sharedHeaderMemoryOverhead);
+
+	set->sharedHeaderList = NULL;
+}
+
+/*
+ * SlabReset
+ *		Frees all memory which is allocated in the given context.
+ */
+static void
+SlabReset(MemoryContext context)
+{
+	SlabContext *set = (SlabContext *) context;
+	SlabBlock	block;
+
+	AssertArg(SlabIsValid(set));
+
+	/* Nothing to do if no pallocs since startup or last reset */
+	if (set->isReset)
+		return;
+
+#ifdef MEMORY_CONTEXT_CHECKING
+	/* Check for corruption before freeing */
+	SlabCheck(context);
+#endif
+
+	SlabReleaseAccountingForAllAllocatedChunks(context);
+
+	block = set->blocks;
+	set->blocks = NULL;
+	set->freelist = NULL;
+
+	while (block != NULL)
+	{
+		SlabBlock	next = block->next;
+
+		MemoryContextNoteFree(&set->header, set->blockSize);
+
+#ifdef CLOBBER_FREED_MEMORY
+		/* Wipe freed memory for debugging purposes */
+		memset(block, 0x7F, block->freeptr - ((char *) block));
+#endif
+		gp_free(block);
+		block = next;
+	}
+
+	set->nChunks = 0;
+	set->nullAccountHeader = NULL;
+	set->isReset = true;
+}
+
+/*
+ * SlabDelete
+ *		Frees all memory which is allocated in the given context,
+ *		in preparation for deletion of the context.
+ *
+ * Slab keeps no block over resets, so this is the same as a reset.
+ */
+static void
+SlabDelete(MemoryContext context)
+{
+	SlabReset(context);
+}
+
+/*
+ * SlabAlloc
+ *		Returns pointer to allocated memory of given size; memory is added
+ *		to the context.
+ */
+static void *
+SlabAlloc(MemoryContext context, Size size)
+{
+	SlabContext *set = (SlabContext *) context;
+	SharedChunkHeader *sharedHeader;
+	SlabChunk	chunk;
+
+	AssertArg(SlabIsValid(set));
+
+	if (size > set->chunkSize)
+		elog(ERROR, "request of %lu bytes exceeds the chunk size %lu of slab context \"%s\"",
+			 (unsigned long) size, (unsigned long) set->chunkSize, set->header.name);
+
+	sharedHeader = SlabGetSharedHeader(set);
+
+	chunk = SlabGetSlot(set);
+	chunk->sharedHeader = sharedHeader;
+	chunk->size = set->chunkSize;
+
+#ifdef MEMORY_CONTEXT_CHECKING
+	chunk->requested_size = size;
+	/* set mark to catch clobber of "unused" space */
+	if (size < set->chunkSize)
+		((char *) SlabChunkGetPointer(chunk))[size] = 0x7E;
+#endif
+#ifdef CDB_PALLOC_TAGS
+	chunk->alloc_tag = set->header.callerFile;
+	chunk->alloc_n = set->header.callerLine;
+	chunk->prev_chunk = NULL;
+	chunk->next_chunk = NULL;
+#endif
+
+	sharedHeader->balance += set->chunkSize + SLAB_CHUNKHDRSZ;
+	if (sharedHeader->memoryAccountId != MEMORY_OWNER_TYPE_Undefined)
+		MemoryAccounting_Allocate(sharedHeader->memoryAccountId, set->chunkSize + SLAB_CHUNKHDRSZ);
+
+	set->nChunks++;
+
+	return SlabChunkGetPointer(chunk);
+}
+
+/*
+ * SlabFree
+ *		Puts the chunk on the freelist.
+ */
+static void
+SlabFree(MemoryContext context, void *pointer)
+{
+	SlabContext *set = (SlabContext *) context;
+	SlabChunk	chunk = SlabPointerGetChunk(pointer);
+	SharedChunkHeader *sharedHeader = chunk->sharedHeader;
+
+	AssertArg(SlabIsValid(set));
+
+#ifdef MEMORY_CONTEXT_CHECKING
+	Assert(chunk->requested_size != 0xFFFFFFFF);
+	/* Test for someone scribbling on unused space in chunk */
+	if (chunk->requested_size < chunk->size)
+	{
+		if (((char *) pointer)[chunk->requested_size] != 0x7E)
+		{
+			Assert(!"Memory error");
+			elog(WARNING, "detected write past chunk end in %s %p (%s:%d)",
+					set->header.name, chunk, CDB_MCXT_WHERE(&set->header));
+		}
+	}
+	chunk->requested_size = 0xFFFFFFFF;
+#endif
+
+	Assert(sharedHeader->context == context);
+
+	sharedHeader->balance -= set->chunkSize + SLAB_CHUNKHDRSZ;
+	Assert(sharedHeader->balance >= 0);
+	if (sharedHeader->memoryAccountId != MEMORY_OWNER_TYPE_Undefined)
+		MemoryAccounting_Free(sharedHeader->memoryAccountId, set->chunkSize + SLAB_CHUNKHDRSZ);
+
+	set->nChunks--;
+
+#ifdef CLOBBER_FREED_MEMORY
+	/* Wipe freed memory for debugging purposes */
+	memset(pointer, 0x7F, chunk->size);
+#endif
+
+	chunk->sharedHeader = (SharedChunkHeader *) set->freelist;
+	set->freelist = chunk;
+}
+
+/*
+ * SlabRealloc
+ *		A chunk already has the room of the largest request the context
+ *		serves, so it never moves.
+ */
+static void *
+SlabRealloc(MemoryContext context, void *pointer, Size size)
+{
+	SlabContext *set = (SlabContext *) context;
+	SlabChunk	chunk = SlabPointerGetChunk(pointer);
+
+	AssertArg(SlabIsValid(set));
+
+	if (size > set->chunkSize)
+		elog(ERROR, "request of %lu bytes exceeds the chunk size %lu of slab context \"%s\"",
+			 (unsigned long) size, (unsigned long) set->chunkSize, set->header.name);
+
+#ifdef MEMORY_CONTEXT_CHECKING
+	chunk->requested_size = size;
+	/* set mark to catch clobber of "unused" space */
+	if (size < chunk->size)
+		((char *) pointer)[size] = 0x7E;
+#endif
+
+	return pointer;
+}
+
+/*
+ * SlabGetChunkSpace
+ *		Given a currently-allocated chunk, determine the total space
+ *		it occupies (including all memory-allocation overhead).
+ */
+static Size
+SlabGetChunkSpace(MemoryContext context, void *pointer)
+{
+	SlabChunk	chunk = SlabPointerGetChunk(pointer);
+
+	return chunk->size + SLAB_CHUNKHDRSZ;
+}
+
+/*
+ * SlabIsEmpty
+ *		Is a Slab context empty of any allocated space?
+ */
+static bool
+SlabIsEmpty(MemoryContext context)
+{
+	SlabContext *set = (SlabContext *) context;
+
+	return set->isReset;
+}
+
+/*
+ * Slab_GetStats
+ *		Returns stats about memory consumption of a Slab context.
+ *
+ *	Input parameters:
+ *		context: the context of interest
+ *
+ *	Output parameters:
+ *		nBlocks: number of blocks in the context
+ *		nChunks: number of chunks that were allocated and not freed yet
+ *		currentAvailable: free space in the freelist and the never used
+ *		slots of the first block
+ *		allAllocated: total bytes allocated during lifetime (including
+ *		blocks that were dropped later on, e.g., by a reset)
+ *		allFreed: total bytes that were freed during lifetime
+ *		maxHeld: maximum bytes held during lifetime
+ */
+static void
+Slab_GetStats(MemoryContext context, uint64 *nBlocks, uint64 *nChunks,
+		uint64 *currentAvailable, uint64 *allAllocated, uint64 *allFreed, uint64 *maxHeld)
+{
+	SlabContext *set = (SlabContext *) context;
+	SlabBlock	block;
+	SlabChunk	chunk;
+
+	*nBlocks = 0;
+	*nChunks = set->nChunks;
+	*currentAvailable = 0;
+	*allAllocated = set->header.allBytesAlloc;
+	*allFreed = set->header.allBytesFreed;
+	*maxHeld = set->header.maxBytesHeld;
+
+	for (block = set->blocks; block != NULL; block = block->next)
+		*nBlocks = *nBlocks + 1;
+
+	if (set->blocks != NULL)
+		*currentAvailable += set->blocks->endptr - set->blocks->freeptr;
+
+	for (chunk = set->freelist; chunk != NULL;
+		 chunk = (SlabChunk) chunk->sharedHeader)
+		*currentAvailable += chunk->size;
+}
+
+#ifdef MEMORY_CONTEXT_CHECKING
+
+/*
+ * SlabCheck
+ *		Check the consistency of the blocks and the freelist.
+ *
+ * NOTE: report errors as WARNING, *not* ERROR or FATAL, as AllocSetCheck
+ * does.
+ */
+static void
+SlabCheck(MemoryContext context)
+{
+	SlabContext *set = (SlabContext *) context;
+	char	   *name = set->header.name;
+	SlabBlock	block;
+	SlabChunk	chunk;
+
+	for (block = set->blocks; block != NULL; block = block->next)
+	{
+		if (block->freeptr < ((char *) block) + SLAB_BLOCKHDRSZ ||
+			block->freeptr > block->endptr)
+			elog(WARNING, "problem in slab context %s: bogus freeptr in block %p",
+				 name, block);
+	}
+
+	for (chunk = set->freelist; chunk != NULL;
+		 chunk = (SlabChunk) chunk->sharedHeader)
+	{
+		if (chunk->size != set->chunkSize || chunk->requested_size != 0xFFFFFFFF)
+			elog(WARNING, "problem in slab context %s: bogus free chunk %p",
+				 name, chunk);
+	}
+}
+
+#endif   /* MEMORY_CONTEXT_CHECKING */
@@ -0,0 +1,217 @@
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include "cmockery.h"
+
+#include "../bump.c"
+
+extern MemoryAccount* MemoryAccountMemoryAccount;
+extern MemoryAccount* RolloverMemoryAccount;
+extern MemoryAccount* AlienExecutorMemoryAccount;
+
+extern MemoryAccountIdType liveAccountStartId;
+extern MemoryAccountIdType nextAccountId;
+
+#define PG_RE_THROW() siglongjmp(*PG_exception_stack, 1)
+
+/*
+ * This method will emulate the real ExceptionalCondition
+ * function by re-throwing the exception, essentially falling
+ * back to the next available PG_CATCH();
+ */
+void
+_ExceptionalCondition()
+{
+     PG_RE_THROW();
+}
+
+/*
+ * This method sets up MemoryContext tree as well as
+ * the basic MemoryAccount data structures.
+ */
+void SetupMemoryDataStructures(void **state)
+{
+	MemoryContextInit();
+}
+
+/*
+ * This method cleans up MemoryContext tree and
+ * the MemoryAccount data structures.
+ */
+void
+TeardownMemoryDataStructures(void **state)
+{
+	/*
+	 * Ensure that no existing allocation refers to any short-living accounts. All
+	 * short living accounts live in MemoryAccountMemoryAccount which is soon going
+	 * to be reset via TopMemoryContext reset.
+	 */
+	MemoryAccounting_Reset();
+	MemoryAccounting_SwitchAccount(MEMORY_OWNER_TYPE_Rollover);
+
+	MemoryContextReset(TopMemoryContext); /* TopMemoryContext deletion is not supported */
+
+	/* These are needed to be NULL for calling MemoryContextInit() */
+	TopMemoryContext = NULL;
+	CurrentMemoryContext = NULL;
+
+	/*
+	 * Memory accounts related variables need to be NULL before we
+	 * try to setup memory account data structure again during the
+	 * execution of the next test.
+	 */
+	MemoryAccountMemoryAccount = NULL;
+	RolloverMemoryAccount = NULL;
+	SharedChunkHeadersMemoryAccount = NULL;
+	AlienExecutorMemoryAccount = NULL;
+	MemoryAccountMemoryContext = NULL;
+
+	ActiveMemoryAccountId = MEMORY_OWNER_TYPE_Undefined;
+
+	for (int longLivingIdx = MEMORY_OWNER_TYPE_LogicalRoot; longLivingIdx <= MEMORY_OWNER_TYPE_END_LONG_LIVING; longLivingIdx++)
+	{
+		longLivingMemoryAccountArray[longLivingIdx] = NULL;
+	}
+
+	shortLivingMemoryAccountArray = NULL;
+
+	liveAccountStartId = MEMORY_OWNER_TYPE_START_SHORT_LIVING;
+	nextAccountId = MEMORY_OWNER_TYPE_START_SHORT_LIVING;
+}
+
+
+/* Tests whether consecutive chunks are carved one after the other */
+void
+test__BumpAlloc__PacksChunks(void **state)
+{
+	MemoryContext context = BumpContextCreate(TopMemoryContext, "TestContext",
+			ALLOCSET_DEFAULT_INITSIZE, ALLOCSET_DEFAULT_MAXSIZE);
+
+	char *testAlloc1 = MemoryContextAlloc(context, 10);
+	char *testAlloc2 = MemoryContextAlloc(context, 10);
+
+	/* No rounding up to a power of 2, only MAXALIGN */
+	assert_true(testAlloc2 == testAlloc1 + MAXALIGN(10) + BUMP_CHUNKHDRSZ);
+	assert_true(GetMemoryChunkSpace(testAlloc1) == MAXALIGN(10) + BUMP_CHUNKHDRSZ);
+	assert_true(GetMemoryChunkContext(testAlloc2) == context);
+
+	MemoryContextDelete(context);
+}
+
+/* Tests whether the space of the last chunk is reused once it is freed */
+void
+test__BumpFree__ReusesLastChunk(void **state)
+{
+	MemoryContext context = BumpContextCreate(TopMemoryContext, "TestContext",
+			ALLOCSET_DEFAULT_INITSIZE, ALLOCSET_DEFAULT_MAXSIZE);
+
+	void *testAlloc1 = MemoryContextAlloc(context, 100);
+	void *testAlloc2 = MemoryContextAlloc(context, 100);
+
+	pfree(testAlloc2);
+	assert_true(MemoryContextAlloc(context, 100) == testAlloc2);
+
+	/* A chunk that is not the last one is not reused */
+	pfree(testAlloc1);
+	assert_true(MemoryContextAlloc(context, 100) != testAlloc1);
+
+	MemoryContextDelete(context);
+}
+
+/* Tests whether repalloc of the last chunk grows it in place */
+void
+test__BumpRealloc__GrowsLastChunkInPlace(void **state)
+{
+	MemoryContext context = BumpContextCreate(TopMemoryContext, "TestContext",
+			ALLOCSET_DEFAULT_INITSIZE, ALLOCSET_DEFAULT_MAXSIZE);
+
+	char *testAlloc1 = MemoryContextAlloc(context, 100);
+	char *testAlloc2 = MemoryContextAlloc(context, 100);
+
+	memset(testAlloc1, 'a', 100);
+	memset(testAlloc2, 'b', 100);
+
+	assert_true(repalloc(testAlloc2, 200) == testAlloc2);
+
+	/* Others are copied */
+	char *newAlloc1 = repalloc(testAlloc1, 200);
+	assert_true(newAlloc1 != testAlloc1);
+	assert_true(newAlloc1[0] == 'a' && newAlloc1[99] == 'a');
+
+	MemoryContextDelete(context);
+}
+
+/* Tests whether a large allocation gets a block behind the one being carved */
+void
+test__BumpAlloc__LargeAllocInNewBlock(void **state)
+{
+	MemoryContext context = BumpContextCreate(TopMemoryContext, "TestContext",
+			ALLOCSET_DEFAULT_INITSIZE, ALLOCSET_DEFAULT_MAXSIZE);
+	BumpContext *set = (BumpContext *) context;
+
+	void *testAlloc1 = MemoryContextAlloc(context, 100);
+	BumpBlock head = set->blocks;
+
+	void *testAlloc2 = MemoryContextAlloc(context, set->chunkLimit + 1);
+
+	assert_true(set->blocks == head);
+	assert_true(set->blocks->next != NULL &&
+				(char *) BumpPointerGetChunk(testAlloc2) ==
+				((char *) set->blocks->next) + BUMP_BLOCKHDRSZ);
+
+	/* The head block is still carved */
+	void *testAlloc3 = MemoryContextAlloc(context, 100);
+	assert_true((char *) testAlloc3 == (char *) testAlloc1 + MAXALIGN(100) + BUMP_CHUNKHDRSZ);
+
+	MemoryContextDelete(context);
+}
+
+/* Tests whether a reset gives back the balance of the memory account */
+void
+test__BumpReset__ReleasesAccounting(void **state)
+{
+	MemoryAccountIdType newActiveAccountId = MemoryAccounting_CreateAccount(0, MEMORY_OWNER_TYPE_Exec_Hash);
+	MemoryAccountIdType oldActiveAccountId = MemoryAccounting_SwitchAccount(newActiveAccountId);
+
+	MemoryContext context = BumpContextCreate(TopMemoryContext, "TestContext",
+			ALLOCSET_DEFAULT_INITSIZE, ALLOCSET_DEFAULT_MAXSIZE);
+
+	uint64 prevBalance = MemoryAccounting_GetAccountCurrentBalance(newActiveAccountId);
+	uint64 prevSharedBalance = SharedChunkHeadersMemoryAccount->allocated - SharedChunkHeadersMemoryAccount->freed;
+
+	MemoryContextAlloc(context, 100);
+	void *testAlloc = MemoryContextAlloc(context, 200);
+	MemoryContextAlloc(context, 300);
+	pfree(testAlloc);
+
+	assert_true(MemoryAccounting_GetAccountCurrentBalance(newActiveAccountId) == prevBalance +
+				MAXALIGN(100) + MAXALIGN(300) + 2 * BUMP_CHUNKHDRSZ);
+	assert_true(SharedChunkHeadersMemoryAccount->allocated - SharedChunkHeadersMemoryAccount->freed ==
+				prevSharedBalance + BUMP_SHAREDHDRSZ);
+
+	MemoryContextReset(context);
+
+	assert_true(MemoryAccounting_GetAccountCurrentBalance(newActiveAccountId) == prevBalance);
+	assert_true(SharedChunkHeadersMemoryAccount->allocated - SharedChunkHeadersMemoryAccount->freed ==
+				prevSharedBalance);
+	assert_true(MemoryContextIsEmpty(context));
+
+	MemoryContextDelete(context);
+	MemoryAccounting_SwitchAccount(oldActiveAccountId);
+}
+
+int
+main(int argc, char* argv[])
+{
+	cmockery_parse_arguments(argc, argv);
+
+	const UnitTest tests[] = {
+		unit_test_setup_teardown(test__BumpAlloc__PacksChunks, SetupMemoryDataStructures, TeardownMemoryDataStructures),
+		unit_test_setup_teardown(test__BumpFree__ReusesLastChunk, SetupMemoryDataStructures, TeardownMemoryDataStructures),
+		unit_test_setup_teardown(test__BumpRealloc__GrowsLastChunkInPlace, SetupMemoryDataStructures, TeardownMemoryDataStructures),
+		unit_test_setup_teardown(test__BumpAlloc__LargeAllocInNewBlock, SetupMemoryDataStructures, TeardownMemoryDataStructures),
+		unit_test_setup_teardown(test__BumpReset__ReleasesAccounting, SetupMemoryDataStructures, TeardownMemoryDataStructures),
+	};
+
+	return run_tests(tests);
+}
@@ -996,6 +996,86 @@ test__MemoryAccounting_GetGlobalPeak__Validate(void **state)
 	assert_true(peak == MemoryAccountingPeakBalance);
 }
 
+/*
+ * Tests if the peaks are only updated once gp_memory_accounting_sample_size
+ * is allocated, or when switching accounts, while the balance stays exact
+ */
+void
+test__MemoryAccounting_Allocate__SamplesPeak(void **state)
+{
+	MemoryAccountIdType newAccountId = MemoryAccounting_CreateAccount(0, MEMORY_OWNER_TYPE_Exec_Hash);
+	MemoryAccountIdType oldAccountId = MemoryAccounting_SwitchAccount(newAccountId);
+	MemoryAccount *newAccount = MemoryAccounting_ConvertIdToAccount(newAccountId);
+
+	gp_memory_accounting_sample_size = 1;
+	MemoryAccountingBytesToSample = 1024;
+
+	uint64 oldPeak = newAccount->peak;
+	uint64 oldBalance = MemoryAccounting_GetBalance(newAccount);
+
+	MemoryAccounting_Allocate(newAccountId, 100);
+
+	/* Not sampled yet */
+	assert_true(MemoryAccounting_GetBalance(newAccount) == oldBalance + 100);
+	assert_true(newAccount->peak == oldPeak);
+	assert_true(MemoryAccountingBytesToSample == 1024 - 100);
+
+	MemoryAccounting_Allocate(newAccountId, 1000);
+
+	/* Sampled */
+	assert_true(newAccount->peak == oldBalance + 1100);
+	assert_true(MemoryAccountingBytesToSample == 1024);
+
+	MemoryAccounting_Allocate(newAccountId, 100);
+	assert_true(newAccount->peak == oldBalance + 1100);
+
+	/* Leaving the account brings its peak up to date */
+	MemoryAccounting_SwitchAccount(oldAccountId);
+	assert_true(newAccount->peak == oldBalance + 1200);
+
+	MemoryAccounting_Free(newAccountId, 1200);
+	gp_memory_accounting_sample_size = 0;
+	MemoryAccountingBytesToSample = 0;
+}
+
+/*
+ * Tests if the quota of an eagerly freed operator goes to the relinquished
+ * pool only once, and if a spilling operator can take it from there
+ */
+void
+test__MemoryAccounting_RelinquishQuota__GivesQuotaToPool(void **state)
+{
+	MemoryAccountIdType hashAccountId = MemoryAccounting_CreateAccount(1, MEMORY_OWNER_TYPE_Exec_Hash);
+	MemoryAccountIdType sortAccountId = MemoryAccounting_CreateAccount(1, MEMORY_OWNER_TYPE_Exec_Sort);
+	MemoryAccount *hashAccount = MemoryAccounting_ConvertIdToAccount(hashAccountId);
+	MemoryAccount *sortAccount = MemoryAccounting_ConvertIdToAccount(sortAccountId);
+
+	RelinquishedPoolMemoryAccount->allocated = 0;
+
+	/* Long living accounts have no quota */
+	assert_true(MemoryAccounting_RelinquishQuota(MEMORY_OWNER_TYPE_Exec_AlienShared) == 0);
+
+	assert_true(MemoryAccounting_RelinquishQuota(hashAccountId) == 1024);
+	assert_true(RelinquishedPoolMemoryAccount->allocated == 1024);
+	assert_true(hashAccount->relinquishedMemory == 1024);
+
+	/* Eager free may be called again, e.g., from ExecEnd */
+	assert_true(MemoryAccounting_RelinquishQuota(hashAccountId) == 0);
+	assert_true(RelinquishedPoolMemoryAccount->allocated == 1024);
+
+	MemoryAccountIdType oldAccountId = MemoryAccounting_SwitchAccount(sortAccountId);
+	assert_true(MemoryAccounting_RequestQuotaIncrease() == 1024);
+	MemoryAccounting_SwitchAccount(oldAccountId);
+	assert_true(RelinquishedPoolMemoryAccount->allocated == 0);
+	assert_true(sortAccount->acquiredMemory == 1024);
+
+	/* The acquired quota is given back with the operator's own */
+	assert_true(MemoryAccounting_RelinquishQuota(sortAccountId) == 2048);
+	assert_true(RelinquishedPoolMemoryAccount->allocated == 2048);
+
+	RelinquishedPoolMemoryAccount->allocated = 0;
+}
+
 /* Tests if the MemoryAccounting_GetAccountPeakBalance is returning the correct peak balance */
 void
 test__MemoryAccounting_GetAccountPeakBalance__Validate(void **state)
@@ -1426,6 +1506,8 @@ main(int argc, char* argv[])
 		unit_test_setup_teardown(test__MemoryAccounting_CombinedAccountArrayToString__Validate, SetupMemoryDataStructures, TeardownMemoryDataStructures),
 		unit_test_setup_teardown(test__ConvertIdToUniversalArrayIndex__Validate, SetupMemoryDataStructures, TeardownMemoryDataStructures),
 		unit_test_setup_teardown(test__MemoryAccounting_GetAccountCurrentBalance__ResetPeakBalance, SetupMemoryDataStructures, TeardownMemoryDataStructures),
+		unit_test_setup_teardown(test__MemoryAccounting_Allocate__SamplesPeak, SetupMemoryDataStructures, TeardownMemoryDataStructures),
+		unit_test_setup_teardown(test__MemoryAccounting_RelinquishQuota__GivesQuotaToPool, SetupMemoryDataStructures, TeardownMemoryDataStructures),
 		unit_test_setup_teardown(test__MemoryAccounting_Optimizer_Oustanding_Balance_Rollover, SetupMemoryDataStructures, TeardownMemoryDataStructures),
 	};
 
@@ -0,0 +1,186 @@
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include "cmockery.h"
+
+#include "../slab.c"
+
+extern MemoryAccount* MemoryAccountMemoryAccount;
+extern MemoryAccount* RolloverMemoryAccount;
+extern MemoryAccount* AlienExecutorMemoryAccount;
+
+extern MemoryAccountIdType liveAccountStartId;
+extern MemoryAccountIdType nextAccountId;
+
+#define PG_RE_THROW() siglongjmp(*PG_exception_stack, 1)
+
+/*
+ * This method will emulate the real ExceptionalCondition
+ * function by re-throwing the exception, essentially falling
+ * back to the next available PG_CATCH();
+ */
+void
+_ExceptionalCondition()
+{
+     PG_RE_THROW();
+}
+
+/*
+ * This method sets up MemoryContext tree as well as
+ * the basic MemoryAccount data structures.
+ */
+void SetupMemoryDataStructures(void **state)
+{
+	MemoryContextInit();
+}
+
+/*
+ * This method cleans up MemoryContext tree and
+ * the MemoryAccount data structures.
+ */
+void
+TeardownMemoryDataStructures(void **state)
+{
+	/*
+	 * Ensure that no existing allocation refers to any short-living accounts. All
+	 * short living accounts live in MemoryAccountMemoryAccount which is soon going
+	 * to be reset via TopMemoryContext reset.
+	 */
+	MemoryAccounting_Reset();
+	MemoryAccounting_SwitchAccount(MEMORY_OWNER_TYPE_Rollover);
+
+	MemoryContextReset(TopMemoryContext); /* TopMemoryContext deletion is not supported */
+
+	/* These are needed to be NULL for calling MemoryContextInit() */
+	TopMemoryContext = NULL;
+	CurrentMemoryContext = NULL;
+
+	/*
+	 * Memory accounts related variables need to be NULL before we
+	 * try to setup memory account data structure again during the
+	 * execution of the next test.
+	 */
+	MemoryAccountMemoryAccount = NULL;
+	RolloverMemoryAccount = NULL;
+	SharedChunkHeadersMemoryAccount = NULL;
+	AlienExecutorMemoryAccount = NULL;
+	MemoryAccountMemoryContext = NULL;
+
+	ActiveMemoryAccountId = MEMORY_OWNER_TYPE_Undefined;
+
+	for (int longLivingIdx = MEMORY_OWNER_TYPE_LogicalRoot; longLivingIdx <= MEMORY_OWNER_TYPE_END_LONG_LIVING; longLivingIdx++)
+	{
+		longLivingMemoryAccountArray[longLivingIdx] = NULL;
+	}
+
+	shortLivingMemoryAccountArray = NULL;
+
+	liveAccountStartId = MEMORY_OWNER_TYPE_START_SHORT_LIVING;
+	nextAccountId = MEMORY_OWNER_TYPE_START_SHORT_LIVING;
+}
+
+
+/* Tests whether a freed chunk is handed out again */
+void
+test__SlabAlloc__ReusesFreedChunk(void **state)
+{
+	MemoryContext context = SlabContextCreate(TopMemoryContext, "TestContext",
+			64, ALLOCSET_DEFAULT_INITSIZE);
+
+	void *testAlloc1 = MemoryContextAlloc(context, 64);
+	void *testAlloc2 = MemoryContextAlloc(context, 10);
+
+	/* Every chunk takes the same slot size */
+	assert_true((char *) testAlloc2 == (char *) testAlloc1 + 64 + SLAB_CHUNKHDRSZ);
+	assert_true(GetMemoryChunkSpace(testAlloc2) == 64 + SLAB_CHUNKHDRSZ);
+	assert_true(GetMemoryChunkContext(testAlloc2) == context);
+
+	pfree(testAlloc1);
+	assert_true(MemoryContextAlloc(context, 32) == testAlloc1);
+
+	MemoryContextDelete(context);
+}
+
+/* Tests whether repalloc within the chunk size keeps the chunk */
+void
+test__SlabRealloc__KeepsChunk(void **state)
+{
+	MemoryContext context = SlabContextCreate(TopMemoryContext, "TestContext",
+			64, ALLOCSET_DEFAULT_INITSIZE);
+
+	void *testAlloc = MemoryContextAlloc(context, 10);
+
+	assert_true(repalloc(testAlloc, 64) == testAlloc);
+
+	MemoryContextDelete(context);
+}
+
+/* Tests whether new blocks are made once the first one is full */
+void
+test__SlabAlloc__FillsBlocks(void **state)
+{
+	MemoryContext context = SlabContextCreate(TopMemoryContext, "TestContext",
+			64, ALLOCSET_DEFAULT_INITSIZE);
+	SlabContext *set = (SlabContext *) context;
+	uint64 nBlocks, nChunks, currentAvailable, allAllocated, allFreed, maxHeld;
+
+	for (int i = 0; i < 1000; i++)
+		MemoryContextAlloc(context, 64);
+
+	context->methods.stats(context, &nBlocks, &nChunks, &currentAvailable,
+						   &allAllocated, &allFreed, &maxHeld);
+
+	assert_true(nChunks == 1000);
+	assert_true(nBlocks > 1);
+	assert_true(allAllocated == nBlocks * set->blockSize);
+
+	MemoryContextDelete(context);
+}
+
+/* Tests whether a reset gives back the balance of the memory account */
+void
+test__SlabReset__ReleasesAccounting(void **state)
+{
+	MemoryAccountIdType newActiveAccountId = MemoryAccounting_CreateAccount(0, MEMORY_OWNER_TYPE_Exec_Hash);
+	MemoryAccountIdType oldActiveAccountId = MemoryAccounting_SwitchAccount(newActiveAccountId);
+
+	MemoryContext context = SlabContextCreate(TopMemoryContext, "TestContext",
+			64, ALLOCSET_DEFAULT_INITSIZE);
+
+	uint64 prevBalance = MemoryAccounting_GetAccountCurrentBalance(newActiveAccountId);
+	uint64 prevSharedBalance = SharedChunkHeadersMemoryAccount->allocated - SharedChunkHeadersMemoryAccount->freed;
+
+	MemoryContextAlloc(context, 64);
+	void *testAlloc = MemoryContextAlloc(context, 64);
+	pfree(testAlloc);
+
+	assert_true(MemoryAccounting_GetAccountCurrentBalance(newActiveAccountId) == prevBalance +
+				64 + SLAB_CHUNKHDRSZ);
+	assert_true(SharedChunkHeadersMemoryAccount->allocated - SharedChunkHeadersMemoryAccount->freed ==
+				prevSharedBalance + 64 + SLAB_CHUNKHDRSZ);
+
+	MemoryContextReset(context);
+
+	assert_true(MemoryAccounting_GetAccountCurrentBalance(newActiveAccountId) == prevBalance);
+	assert_true(SharedChunkHeadersMemoryAccount->allocated - SharedChunkHeadersMemoryAccount->freed ==
+				prevSharedBalance);
+	assert_true(MemoryContextIsEmpty(context));
+
+	MemoryContextDelete(context);
+	MemoryAccounting_SwitchAccount(oldActiveAccountId);
+}
+
+int
+main(int argc, char* argv[])
+{
+	cmockery_parse_arguments(argc, argv);
+
+	const UnitTest tests[] = {
+		unit_test_setup_teardown(test__SlabAlloc__ReusesFreedChunk, SetupMemoryDataStructures, TeardownMemoryDataStructures),
+		unit_test_setup_teardown(test__SlabRealloc__KeepsChunk, SetupMemoryDataStructures, TeardownMemoryDataStructures),
+		unit_test_setup_teardown(test__SlabAlloc__FillsBlocks, SetupMemoryDataStructures, TeardownMemoryDataStructures),
+		unit_test_setup_teardown(test__SlabReset__ReleasesAccounting, SetupMemoryDataStructures, TeardownMemoryDataStructures),
+	};
+
+	return run_tests(tests);
+}
@@ -83,6 +83,8 @@ void VmemTrackerTestSetup(void **state)
 	gp_vmem_protect_limit = 8192;
 	/* Disable runaway detector */
 	runaway_detector_activation_percent = 100;
+	/* Reserve exactly what is needed, unless a test says otherwise */
+	gp_vmem_reserve_batch_chunks = 0;
 
 	will_return(ShmemInitStruct, &fakeSegmentVmemChunks);
 	will_assign_value(ShmemInitStruct, foundPtr, false);
@@ -230,6 +232,55 @@ test__VmemTracker_ReserveVmem__CacheSanity(void **state)
 	assert_true(5 == trackedVmemChunks);
 }
 
+/*
+ * Checks that chunks are reserved ahead in batches, used up without
+ * touching the segment counter, and kept up to a batch when freed.
+ */
+void
+test__VmemTracker_ReserveVmem__BatchReservation(void **state)
+{
+	/* GPDB Memory protection is enabled and initialized */
+	gp_mp_inited = true;
+	gp_vmem_reserve_batch_chunks = 2;
+
+	int64 oneChunkBytes = 1 << chunkSizeInBits;
+
+#ifdef USE_ASSERT_CHECKING
+	will_return_count(MemoryProtection_IsOwnerThread, true, 2);
+#endif
+
+	/* One chunk is needed, and two more are reserved ahead */
+	will_be_called(RedZoneHandler_DetectRunawaySession);
+	will_return(RedZoneHandler_GetRedZoneLimitChunks, INT32_MAX);
+	VmemTracker_ReserveVmem(oneChunkBytes);
+	assert_true(1 == trackedVmemChunks);
+	assert_true(2 == cachedVmemChunks);
+	assert_true(3 == *segmentVmemChunks);
+	assert_true(3 == MySessionState->sessionVmem);
+
+	/* The next two chunks come from what was reserved ahead */
+	will_be_called(RedZoneHandler_DetectRunawaySession);
+	VmemTracker_ReserveVmem(2 * oneChunkBytes);
+	assert_true(3 == trackedVmemChunks);
+	assert_true(0 == cachedVmemChunks);
+	assert_true(3 == *segmentVmemChunks);
+	assert_true(3 == maxVmemChunksTracked);
+
+	/* Freed chunks are kept for the next reservation */
+	will_return(RedZoneHandler_IsVmemRedZone, false);
+	VmemTracker_ReleaseVmem(2 * oneChunkBytes);
+	assert_true(1 == trackedVmemChunks);
+	assert_true(2 == cachedVmemChunks);
+	assert_true(3 == *segmentVmemChunks);
+
+	/* Going idle gives them back */
+	VmemTracker_ReleaseCachedVmemChunks();
+	assert_true(1 == trackedVmemChunks);
+	assert_true(0 == cachedVmemChunks);
+	assert_true(1 == *segmentVmemChunks);
+	assert_true(1 == MySessionState->sessionVmem);
+}
+
 /*
  * Checks the sanity of the tracked bytes.
  *
@@ -675,6 +726,7 @@ main(int argc, char* argv[])
 		unit_test_setup_teardown(test__VmemTracker_ReserveVmem__IgnoreWhenUninitialized, VmemTrackerTestSetup, VmemTrackerTestTeardown),
 		unit_test_setup_teardown(test__VmemTracker_ReserveVmem__FailForInvalidSize, VmemTrackerTestSetup, VmemTrackerTestTeardown),
 		unit_test_setup_teardown(test__VmemTracker_ReserveVmem__CacheSanity, VmemTrackerTestSetup, VmemTrackerTestTeardown),
+		unit_test_setup_teardown(test__VmemTracker_ReserveVmem__BatchReservation, VmemTrackerTestSetup, VmemTrackerTestTeardown),
 		unit_test_setup_teardown(test__VmemTracker_ReserveVmem__TrackedBytesSanity, VmemTrackerTestSetup, VmemTrackerTestTeardown),
 		unit_test_setup_teardown(test__VmemTracker_ReserveVmem__TrackedBytesSanityForRedzoneDetection, VmemTrackerTestSetup, VmemTrackerTestTeardown),
 		unit_test_setup_teardown(test__VmemTracker_ReserveVmem__OOMLoggingBeforeReservation, VmemTrackerTestSetup, VmemTrackerTestTeardown),
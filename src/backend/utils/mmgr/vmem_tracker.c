@@ -46,6 +46,13 @@ extern void IdleTracker_Shutdown(void);
 
 /* Number of Vmem chunks tracked by this process */
 static int32 trackedVmemChunks = 0;
+/*
+ * Number of Vmem chunks this process reserved ahead of trackedVmemChunks.
+ * They are counted in the session, segment and resource group, but not yet
+ * used, so trackedVmemChunks can grow into them without touching the shared
+ * counters.
+ */
+static int32 cachedVmemChunks = 0;
 /* Maximum number of vmem chunks tracked by this process */
 static int32 maxVmemChunksTracked = 0;
 /* Number of bytes tracked (i.e., allocated under the tutelage of vmem tracker) */
@@ -73,12 +80,20 @@ static int32 maxChunksPerQuery = 0;
  */
 static int32 waivedChunks = 0;
 
+/*
+ * Number of extra chunks to reserve ahead whenever the shared counters
+ * must be updated, and to keep when releasing. Zero reserves exactly what
+ * is needed.
+ */
+int gp_vmem_reserve_batch_chunks = 4;
+
 /*
  * Consumed vmem on the segment.
  */
 volatile int32 *segmentVmemChunks = NULL;
 
 static void ReleaseAllVmemChunks(void);
+static void VmemTracker_ReleaseVmemChunks(int reduction);
 
 /*
  * Initializes the shared memory states of the vmem tracker. This
@@ -90,6 +105,7 @@ VmemTracker_ShmemInit()
 {
 	Assert(!vmemTrackerInited);
 	trackedVmemChunks = 0;
+	cachedVmemChunks = 0;
 	maxVmemChunksTracked = 0;
 	trackedBytes = 0;
 
@@ -143,6 +159,7 @@ VmemTracker_Init()
 	Assert(NULL != MySessionState);
 	Assert(!vmemTrackerInited);
 	Assert(trackedVmemChunks == 0);
+	Assert(cachedVmemChunks == 0);
 	Assert(maxVmemChunksTracked == 0);
 	Assert(trackedBytes == 0);
 
@@ -151,6 +168,7 @@ VmemTracker_Init()
 	 * we still have 0 values in our counters.
 	 */
 	trackedVmemChunks = 0;
+	cachedVmemChunks = 0;
 	maxVmemChunksTracked = 0;
 	trackedBytes = 0;
 
@@ -263,8 +281,6 @@ VmemTracker_ReserveVmemChunks(int32 numChunksToReserve)
 	/* The current process now owns additional vmem in this segment */
 	trackedVmemChunks += numChunksToReserve;
 
-	maxVmemChunksTracked = Max(maxVmemChunksTracked, trackedVmemChunks);
-
 	if (waivedChunks > 0 && !waiverUsed)
 	{
 		/*
@@ -303,11 +319,45 @@ VmemTracker_ReleaseVmemChunks(int reduction)
 static void
 ReleaseAllVmemChunks()
 {
+	VmemTracker_ReleaseCachedVmemChunks();
 	VmemTracker_ReleaseVmemChunks(trackedVmemChunks);
 	Assert(0 == trackedVmemChunks);
 	trackedBytes = 0;
 }
 
+/*
+ * Moves "numChunks" chunks that were just reserved on top of trackedVmemChunks
+ * to the chunks reserved ahead by this process.
+ */
+static void
+VmemTracker_CacheVmemChunks(int32 numChunks)
+{
+	Assert(0 <= numChunks && numChunks <= trackedVmemChunks);
+	trackedVmemChunks -= numChunks;
+	cachedVmemChunks += numChunks;
+}
+
+/*
+ * Returns the chunks this process reserved ahead of need to the session,
+ * segment and resource group. This is called when the process goes idle and
+ * when the segment enters the red zone, so that the shared counters are
+ * exact whenever they matter for runaway detection.
+ */
+void
+VmemTracker_ReleaseCachedVmemChunks(void)
+{
+	if (0 == cachedVmemChunks)
+	{
+		return;
+	}
+
+	int32 numChunks = cachedVmemChunks;
+
+	cachedVmemChunks = 0;
+	trackedVmemChunks += numChunks;
+	VmemTracker_ReleaseVmemChunks(numChunks);
+}
+
 /*
  * Returns the available VMEM in "chunks" unit. If the available chunks
  * is less than 0, it return 0.
@@ -557,7 +607,60 @@ VmemTracker_ReserveVmem(int64 newlyRequestedBytes)
 		ReportOOMConsumption();
 
 		int32 needChunk = newszChunk - trackedVmemChunks;
-		status = VmemTracker_ReserveVmemChunks(needChunk);
+
+		if (needChunk <= cachedVmemChunks)
+		{
+			/* Use the chunks we reserved ahead, the shared counters have them */
+			cachedVmemChunks -= needChunk;
+			trackedVmemChunks += needChunk;
+			maxVmemChunksTracked = Max(maxVmemChunksTracked, trackedVmemChunks);
+		}
+		else
+		{
+			int32		batchChunks = gp_vmem_reserve_batch_chunks;
+			int32		usedCachedChunks = 0;
+
+			/*
+			 * In the red zone the shared counters must tell what is used, so
+			 * give back what we reserved ahead. Otherwise use it up, and
+			 * reserve the rest.
+			 */
+			if (cachedVmemChunks > 0 && RedZoneHandler_IsVmemRedZone())
+			{
+				VmemTracker_ReleaseCachedVmemChunks();
+			}
+			else
+			{
+				usedCachedChunks = cachedVmemChunks;
+				cachedVmemChunks = 0;
+				trackedVmemChunks += usedCachedChunks;
+				needChunk -= usedCachedChunks;
+			}
+
+			/*
+			 * Reserve a batch more ahead, unless that gets the segment into
+			 * the red zone. If the limits can't take the extra chunks,
+			 * reserve exactly what is needed.
+			 */
+			if (batchChunks > 0 && waivedChunks == 0 &&
+				*segmentVmemChunks + needChunk + batchChunks <= RedZoneHandler_GetRedZoneLimitChunks() &&
+				MemoryAllocation_Success == VmemTracker_ReserveVmemChunks(needChunk + batchChunks))
+			{
+				VmemTracker_CacheVmemChunks(batchChunks);
+			}
+			else
+			{
+				status = VmemTracker_ReserveVmemChunks(needChunk);
+			}
+
+			/* On failure, keep the chunks we had reserved ahead */
+			if (MemoryAllocation_Success != status)
+			{
+				VmemTracker_CacheVmemChunks(usedCachedChunks);
+			}
+
+			maxVmemChunksTracked = Max(maxVmemChunksTracked, trackedVmemChunks);
+		}
 	}
 
 	/* Failed to reserve vmem chunks. Revert changes to trackedBytes */
@@ -606,7 +709,19 @@ VmemTracker_ReleaseVmem(int64 toBeFreedRequested)
 	{
 		int reduction = trackedVmemChunks - newszChunk;
 
-		VmemTracker_ReleaseVmemChunks(reduction);
+		/* Keep up to a batch of freed chunks for the next reservation */
+		int keep = Min(reduction, gp_vmem_reserve_batch_chunks - cachedVmemChunks);
+
+		if (keep > 0 && !RedZoneHandler_IsVmemRedZone())
+		{
+			VmemTracker_CacheVmemChunks(keep);
+			reduction -= keep;
+		}
+
+		if (reduction > 0)
+		{
+			VmemTracker_ReleaseVmemChunks(reduction);
+		}
 	}
 }
 
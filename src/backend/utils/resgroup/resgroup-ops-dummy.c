@@ -129,6 +129,15 @@ ResGroupOps_SetCpuRateLimit(Oid group, int cpu_rate_limit)
 	unsupported_system();
 }
 
+/*
+ * Set the cores the OS group runs on, per gp_resource_group_cpuset.
+ */
+void
+ResGroupOps_SetCpuSet(Oid group, const char *groupName)
+{
+	unsupported_system();
+}
+
 /*
  * Get the cpu usage of the OS group, that is the total cpu time obtained
  * by this OS group, in nano seconds.
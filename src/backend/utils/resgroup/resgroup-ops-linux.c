@@ -14,6 +14,7 @@
 
 #include "postgres.h"
 
+#include "catalog/pg_resgroup.h"
 #include "cdb/cdbvars.h"
 #include "utils/resgroup.h"
 #include "utils/resgroup-ops.h"
@@ -39,6 +40,15 @@
  * We call it OS group in below function description.
  *
  * So far these operations are mainly for CPU rate limitation and accounting.
+ *
+ * Both cgroup v1, where each controller has its own hierarchy, and cgroup v2,
+ * where all the controllers share one unified hierarchy, are supported.  The
+ * v1 interface files and their v2 counterparts are:
+ *
+ *   cpu.shares               cpu.weight
+ *   cpu.cfs_quota_us         cpu.max
+ *   cpuacct.usage            cpu.stat (usage_usec)
+ *   memory.limit_in_bytes    memory.max
  */
 
 #define CGROUP_ERROR_PREFIX "cgroup is not properly configured: "
@@ -49,6 +59,13 @@
 #define PROC_MOUNTS "/proc/self/mounts"
 #define MAX_INT_STRING_LEN 20
 #define MAX_PATH_LEN 256
+#define MAX_CPUSET_STRING_LEN 1024
+
+#define CGROUP_V1 1
+#define CGROUP_V2 2
+
+/* range of cpu.weight in cgroup v2 */
+#define CGROUP_V2_WEIGHT_MAX 10000
 
 static char * buildPath(Oid group, const char *base, const char *comp, const char *prop, char *path, size_t pathsize);
 static int lockDir(const char *path, bool block);
@@ -65,16 +82,26 @@ static void getMemoryInfo(unsigned long *ram, unsigned long *swap);
 static void getCgMemoryInfo(uint64 *cgram, uint64 *cgmemsw);
 static int getOvercommitRatio(void);
 static void detectCgroupMountPoint(void);
+static void readStr(Oid group, const char *base, const char *comp, const char *prop, char *str, size_t strsize);
+static void writeStr(Oid group, const char *base, const char *comp, const char *prop, const char *str);
+static uint64 readLimit(Oid group, const char *base, const char *prop);
+static void readCpuMax(Oid group, int64 *quota, int64 *period);
+static bool cpusetEnabled(void);
+static void parseCpuList(const char *str, cpu_set_t *cpuset);
+static void formatCpuList(const cpu_set_t *cpuset, char *str, size_t strsize);
+static bool lookupCpuSet(const char *groupName, cpu_set_t *cpuset, cpu_set_t *reserved);
 
 static Oid currentGroupIdInCGroup = InvalidOid;
 static int cpucores = 0;
 static char cgdir[MAX_PATH_LEN];
+static int cgversion = 0;
 
 /*
  * Build path string with parameters.
  * - if base is NULL, use default value "gpdb"
  * - if group is 0 then the path is for the gpdb toplevel cgroup;
  * - if prop is "" then the path is for the cgroup dir;
+ * - comp is ignored on cgroup v2, where all the controllers share one dir;
  */
 static char *
 buildPath(Oid group,
@@ -89,7 +116,14 @@ buildPath(Oid group,
 	if (!base)
 		base = "gpdb";
 
-	if (group)
+	if (cgversion == CGROUP_V2)
+	{
+		if (group)
+			snprintf(path, pathsize, "%s/%s/%d/%s", cgdir, base, group, prop);
+		else
+			snprintf(path, pathsize, "%s/%s/%s", cgdir, base, prop);
+	}
+	else if (group)
 		snprintf(path, pathsize, "%s/%s/%s/%d/%s", cgdir, comp, base, group, prop);
 	else
 		snprintf(path, pathsize, "%s/%s/%s/%s", cgdir, comp, base, prop);
@@ -100,7 +134,9 @@ buildPath(Oid group,
 /*
  * Unassign all the processes from group.
  *
- * These processes will be moved to the gpdb toplevel cgroup.
+ * These processes will be moved to the gpdb toplevel cgroup.  On cgroup v2
+ * a cgroup with controllers enabled for its children can't have processes
+ * of its own, so they are moved to the default group instead.
  *
  * This function must be called with the gpdb toplevel dir locked,
  * fddir is the fd for this lock, on any failure fddir will be closed
@@ -167,7 +203,8 @@ unassignGroup(Oid group, const char *comp, int fddir)
 	if (buflen == 0)
 		return;
 
-	buildPath(0, NULL, comp, "cgroup.procs", path, pathsize);
+	buildPath(cgversion == CGROUP_V2 ? DEFAULTRESGROUP_OID : 0,
+			  NULL, comp, "cgroup.procs", path, pathsize);
 
 	fdw = open(path, O_WRONLY);
 	__CHECK(fdw >= 0, ( close(fddir) ), "can't open file for write");
@@ -482,6 +519,233 @@ writeInt64(Oid group, const char *base, const char *comp, const char *prop, int6
 	writeData(path, data, strlen(data));
 }
 
+/*
+ * Read a string from a cgroup interface file, without the trailing newline.
+ */
+static void
+readStr(Oid group, const char *base, const char *comp, const char *prop,
+		char *str, size_t strsize)
+{
+	char path[MAX_PATH_LEN];
+	size_t pathsize = sizeof(path);
+	size_t len;
+
+	buildPath(group, base, comp, prop, path, pathsize);
+
+	len = readData(path, str, strsize - 1);
+	while (len > 0 && str[len - 1] == '\n')
+		len--;
+	str[len] = '\0';
+}
+
+/*
+ * Write a string to a cgroup interface file.
+ */
+static void
+writeStr(Oid group, const char *base, const char *comp, const char *prop,
+		 const char *str)
+{
+	char path[MAX_PATH_LEN];
+	size_t pathsize = sizeof(path);
+
+	buildPath(group, base, comp, prop, path, pathsize);
+
+	writeData(path, (char *) str, strlen(str));
+}
+
+/*
+ * Read a cgroup v2 limit, which is either a number or "max".
+ *
+ * A missing file, like memory.max of the root cgroup, means no limit.
+ */
+static uint64
+readLimit(Oid group, const char *base, const char *prop)
+{
+	char data[MAX_INT_STRING_LEN + 1];
+	char path[MAX_PATH_LEN];
+	unsigned long long x;
+
+	buildPath(group, base, "", prop, path, sizeof(path));
+	if (access(path, F_OK))
+		return PG_UINT64_MAX;
+
+	readStr(group, base, "", prop, data, sizeof(data));
+	if (strcmp(data, "max") == 0)
+		return PG_UINT64_MAX;
+
+	if (sscanf(data, "%llu", &x) != 1)
+		CGROUP_ERROR("invalid number '%s'", data);
+
+	return (uint64) x;
+}
+
+/*
+ * Read the cgroup v2 cpu.max of group, "$MAX $PERIOD".
+ *
+ * quota is set to -1 if there is no limit, as in cpu.cfs_quota_us of v1.
+ */
+static void
+readCpuMax(Oid group, int64 *quota, int64 *period)
+{
+	char data[2 * MAX_INT_STRING_LEN + 2];
+	char max[MAX_INT_STRING_LEN + 1];
+	long long p;
+
+	readStr(group, NULL, "cpu", "cpu.max", data, sizeof(data));
+
+	if (sscanf(data, "%20s %lld", max, &p) != 2)
+		CGROUP_ERROR("invalid cpu.max '%s'", data);
+
+	*period = p;
+	*quota = strcmp(max, "max") == 0 ? -1 : strtoll(max, NULL, 10);
+}
+
+/*
+ * Is the cpuset isolation configured by gp_resource_group_cpuset?
+ */
+static bool
+cpusetEnabled(void)
+{
+	return gp_resource_group_cpuset != NULL && gp_resource_group_cpuset[0] != '\0';
+}
+
+/*
+ * Parse a cpu list in the format of cpuset.cpus, e.g. "0-3,8,10-11".
+ */
+static void
+parseCpuList(const char *str, cpu_set_t *cpuset)
+{
+	const char *ptr = str;
+
+	CPU_ZERO(cpuset);
+
+	while (*ptr)
+	{
+		char *end;
+		long first;
+		long last;
+
+		first = strtol(ptr, &end, 10);
+		if (end == ptr)
+			goto error;
+		last = first;
+		ptr = end;
+
+		if (*ptr == '-')
+		{
+			ptr++;
+			last = strtol(ptr, &end, 10);
+			if (end == ptr)
+				goto error;
+			ptr = end;
+		}
+
+		if (first < 0 || last < first || last >= CPU_SETSIZE)
+			goto error;
+
+		for (; first <= last; first++)
+			CPU_SET(first, cpuset);
+
+		if (*ptr == ',')
+			ptr++;
+		else if (*ptr)
+			goto error;
+	}
+	return;
+
+error:
+	ereport(ERROR,
+			(errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+			 errmsg("invalid cpu list \"%s\"", str)));
+}
+
+/*
+ * Format a cpu set as a cpu list in the format of cpuset.cpus.
+ */
+static void
+formatCpuList(const cpu_set_t *cpuset, char *str, size_t strsize)
+{
+	int len = 0;
+	int cpu = 0;
+
+	str[0] = '\0';
+
+	while (cpu < CPU_SETSIZE)
+	{
+		int first;
+
+		if (!CPU_ISSET(cpu, cpuset))
+		{
+			cpu++;
+			continue;
+		}
+
+		first = cpu;
+		while (cpu + 1 < CPU_SETSIZE && CPU_ISSET(cpu + 1, cpuset))
+			cpu++;
+
+		if (first == cpu)
+			len += snprintf(str + len, strsize - len, "%s%d",
+							len ? "," : "", first);
+		else
+			len += snprintf(str + len, strsize - len, "%s%d-%d",
+							len ? "," : "", first, cpu);
+
+		if (len >= strsize)
+			CGROUP_ERROR("cpu list is too long");
+		cpu++;
+	}
+}
+
+/*
+ * Look up the cores of a group in gp_resource_group_cpuset, which is a
+ * semicolon separated list of "group_name:cpu_list".
+ *
+ * Return true and set cpuset if the group has dedicated cores.  reserved, if
+ * not NULL, is set to the cores dedicated to any group.  Raises an error if
+ * the setting is malformed.
+ */
+static bool
+lookupCpuSet(const char *groupName, cpu_set_t *cpuset, cpu_set_t *reserved)
+{
+	char *setting = pstrdup(gp_resource_group_cpuset);
+	char *entry;
+	char *saveptr = NULL;
+	bool found = false;
+
+	if (reserved)
+		CPU_ZERO(reserved);
+
+	for (entry = strtok_r(setting, ";", &saveptr);
+		 entry != NULL;
+		 entry = strtok_r(NULL, ";", &saveptr))
+	{
+		char *colon = strchr(entry, ':');
+		cpu_set_t cpus;
+
+		if (colon == NULL || colon == entry)
+			ereport(ERROR,
+					(errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+					 errmsg("invalid entry \"%s\" in gp_resource_group_cpuset", entry),
+					 errhint("Entries are in the form group_name:cpu_list, e.g. etl_group:8-15.")));
+
+		*colon = '\0';
+		parseCpuList(colon + 1, &cpus);
+
+		if (reserved)
+			CPU_OR(reserved, reserved, &cpus);
+
+		if (groupName && strcmp(entry, groupName) == 0)
+		{
+			memcpy(cpuset, &cpus, sizeof(cpus));
+			found = true;
+		}
+	}
+
+	pfree(setting);
+	return found;
+}
+
 /*
  * Check permissions on group's cgroup dir & interface files.
  *
@@ -515,6 +779,23 @@ checkPermission(Oid group, bool report)
      * gpMgmt/bin/gpcheckresgroupimpl
      */
 
+	if (cgversion == CGROUP_V2)
+	{
+		comp = "";
+
+		__CHECK("", R_OK | W_OK | X_OK);
+		__CHECK("cgroup.procs", R_OK | W_OK);
+		__CHECK("cpu.max", R_OK | W_OK);
+		__CHECK("cpu.weight", R_OK | W_OK);
+		__CHECK("cpu.stat", R_OK);
+		if (group == 0)
+			__CHECK("cgroup.subtree_control", R_OK | W_OK);
+		if (cpusetEnabled())
+			__CHECK("cpuset.cpus", R_OK | W_OK);
+
+		return true;
+	}
+
 	comp = "cpu";
 
 	__CHECK("", R_OK | W_OK | X_OK);
@@ -530,6 +811,16 @@ checkPermission(Oid group, bool report)
 	__CHECK("cpuacct.usage", R_OK);
 	__CHECK("cpuacct.stat", R_OK);
 
+	if (cpusetEnabled())
+	{
+		comp = "cpuset";
+
+		__CHECK("", R_OK | W_OK | X_OK);
+		__CHECK("cgroup.procs", R_OK | W_OK);
+		__CHECK("cpuset.cpus", R_OK | W_OK);
+		__CHECK("cpuset.mems", R_OK | W_OK);
+	}
+
 #undef __CHECK
 
 	return true;
@@ -550,6 +841,18 @@ getMemoryInfo(unsigned long *ram, unsigned long *swap)
 static void
 getCgMemoryInfo(uint64 *cgram, uint64 *cgmemsw)
 {
+	if (cgversion == CGROUP_V2)
+	{
+		uint64 swap;
+
+		/* memory.swap.max doesn't count the ram, unlike memsw of v1 */
+		*cgram = readLimit(0, "", "memory.max");
+		swap = readLimit(0, "", "memory.swap.max");
+		*cgmemsw = (swap == PG_UINT64_MAX || *cgram == PG_UINT64_MAX) ?
+			PG_UINT64_MAX : *cgram + swap;
+		return;
+	}
+
 	*cgram = readInt64(0, "", "memory", "memory.limit_in_bytes");
 	*cgmemsw = readInt64(0, "", "memory", "memory.memsw.limit_in_bytes");
 }
@@ -571,12 +874,21 @@ getOvercommitRatio(void)
 	return ratio;
 }
 
-/* detect cgroup mount point */
+/*
+ * detect cgroup mount point and version
+ *
+ * cgroup v1 is used if its cpu controller is mounted, which is also the
+ * case of the "hybrid" layout where a v2 hierarchy without controllers
+ * is mounted next to the v1 ones.  Otherwise the v2 hierarchy is used.
+ */
 static void
 detectCgroupMountPoint(void)
 {
 	struct mntent *me;
 	FILE *fp;
+	char v1dir[MAX_PATH_LEN] = "";
+	char v2dir[MAX_PATH_LEN] = "";
+	bool v1cpu = false;
 
 	if (cgdir[0])
 		return;
@@ -590,21 +902,42 @@ detectCgroupMountPoint(void)
 	{
 		char * p;
 
+		if (strcmp(me->mnt_type, "cgroup2") == 0)
+		{
+			if (!v2dir[0])
+				strncpy(v2dir, me->mnt_dir, sizeof(v2dir) - 1);
+			continue;
+		}
+
 		if (strcmp(me->mnt_type, "cgroup"))
 			continue;
 
-		strncpy(cgdir, me->mnt_dir, sizeof(cgdir) - 1);
+		if (v1dir[0] && (v1cpu || !hasmntopt(me, "cpu")))
+			continue;
 
-		p = strrchr(cgdir, '/');
+		strncpy(v1dir, me->mnt_dir, sizeof(v1dir) - 1);
+		v1cpu = hasmntopt(me, "cpu") != NULL;
+
+		p = strrchr(v1dir, '/');
 		if (p == NULL)
-			CGROUP_ERROR("cgroup mount point parse error: %s", cgdir);
+			CGROUP_ERROR("cgroup mount point parse error: %s", v1dir);
 		else
 			*p = 0;
-		break;
 	}
 
 	endmntent(fp);
 
+	if (v1dir[0] && (v1cpu || !v2dir[0]))
+	{
+		strcpy(cgdir, v1dir);
+		cgversion = CGROUP_V1;
+	}
+	else if (v2dir[0])
+	{
+		strcpy(cgdir, v2dir);
+		cgversion = CGROUP_V2;
+	}
+
 	if (!cgdir[0])
 		CGROUP_ERROR("can not find cgroup mount point");
 }
@@ -613,7 +946,7 @@ detectCgroupMountPoint(void)
 const char *
 ResGroupOps_Name(void)
 {
-	return "cgroup";
+	return cgversion == CGROUP_V2 ? "cgroup2" : "cgroup";
 }
 
 /* Check whether the OS group implementation is available and useable */
@@ -622,6 +955,10 @@ ResGroupOps_Bless(void)
 {
 	detectCgroupMountPoint();
 	checkPermission(0, true);
+
+	/* Validate gp_resource_group_cpuset */
+	if (cpusetEnabled())
+		lookupCpuSet(NULL, NULL, NULL);
 }
 
 /* Initialize the OS group */
@@ -635,6 +972,26 @@ ResGroupOps_Init(void)
 	int ncores = getCpuCores();
 	const char *comp = "cpu";
 
+	if (cgversion == CGROUP_V2)
+	{
+		/* cpu.max := "cpu_max period", cpu.weight := 10000 (max possible value) */
+		char data[2 * MAX_INT_STRING_LEN + 2];
+		int64 quota;
+		int64 period;
+
+		/* Let the groups use the controllers */
+		writeStr(0, NULL, comp, "cgroup.subtree_control",
+				 cpusetEnabled() ? "+cpu +cpuset" : "+cpu");
+
+		readCpuMax(0, &quota, &period);
+		snprintf(data, sizeof(data), "%lld %lld",
+				 (long long) (period * ncores * gp_resource_group_cpu_limit),
+				 (long long) period);
+		writeStr(0, NULL, comp, "cpu.max", data);
+		writeInt64(0, NULL, comp, "cpu.weight", CGROUP_V2_WEIGHT_MAX);
+		return;
+	}
+
 	cfs_period_us = readInt64(0, NULL, comp, "cpu.cfs_period_us");
 	writeInt64(0, NULL, comp, "cpu.cfs_quota_us",
 			   cfs_period_us * ncores * gp_resource_group_cpu_limit);
@@ -669,7 +1026,9 @@ ResGroupOps_CreateGroup(Oid group)
 {
 	int retry = 0;
 
-	if (!createDir(group, "cpu") || !createDir(group, "cpuacct"))
+	if (cgversion == CGROUP_V2 ? !createDir(group, "cpu") :
+		(!createDir(group, "cpu") || !createDir(group, "cpuacct") ||
+		 (cpusetEnabled() && !createDir(group, "cpuset"))))
 	{
 		CGROUP_ERROR("can't create cgroup for resgroup '%d': %s",
 					 group, strerror(errno));
@@ -700,7 +1059,9 @@ ResGroupOps_CreateGroup(Oid group)
 void
 ResGroupOps_DestroyGroup(Oid group)
 {
-	if (!removeDir(group, "cpu", true) || !removeDir(group, "cpuacct", true))
+	if (cgversion == CGROUP_V2 ? !removeDir(group, "cpu", true) :
+		(!removeDir(group, "cpu", true) || !removeDir(group, "cpuacct", true) ||
+		 (cpusetEnabled() && !removeDir(group, "cpuset", true))))
 	{
 		CGROUP_ERROR("can't remove cgroup for resgroup '%d': %s",
 			 group, strerror(errno));
@@ -721,7 +1082,12 @@ ResGroupOps_AssignGroup(Oid group, int pid)
 		return;
 
 	writeInt64(group, NULL, "cpu", "cgroup.procs", pid);
-	writeInt64(group, NULL, "cpuacct", "cgroup.procs", pid);
+	if (cgversion == CGROUP_V1)
+	{
+		writeInt64(group, NULL, "cpuacct", "cgroup.procs", pid);
+		if (cpusetEnabled())
+			writeInt64(group, NULL, "cpuset", "cgroup.procs", pid);
+	}
 
 	currentGroupIdInCGroup = group;
 }
@@ -763,16 +1129,102 @@ ResGroupOps_UnLockGroup(Oid group, int fd)
  * Set the cpu rate limit for the OS group.
  *
  * cpu_rate_limit should be within [0, 100].
+ *
+ * The limit is a relative weight; with gp_resource_group_cpu_ceiling_enforcement
+ * it is also a hard cap, so the group can't use idle cpu of other groups.
  */
 void
 ResGroupOps_SetCpuRateLimit(Oid group, int cpu_rate_limit)
 {
 	const char *comp = "cpu";
+	int ncores = getCpuCores();
+	int64 quota;
+	int64 period;
+
+	if (cgversion == CGROUP_V2)
+	{
+		char data[2 * MAX_INT_STRING_LEN + 2];
+		int64 weight;
+
+		/* SUB/weight := TOP/weight * cpu_rate_limit */
+		weight = readInt64(0, NULL, comp, "cpu.weight") * cpu_rate_limit / 100;
+		writeInt64(group, NULL, comp, "cpu.weight", Max(weight, 1));
+
+		/* SUB/cpu.max := period * ncores * gp_resource_group_cpu_limit * cpu_rate_limit */
+		readCpuMax(group, &quota, &period);
+		if (gp_resource_group_cpu_ceiling_enforcement)
+			snprintf(data, sizeof(data), "%lld %lld",
+					 (long long) (period * ncores * gp_resource_group_cpu_limit *
+								  cpu_rate_limit / 100),
+					 (long long) period);
+		else
+			snprintf(data, sizeof(data), "max %lld", (long long) period);
+		writeStr(group, NULL, comp, "cpu.max", data);
+		return;
+	}
 
 	/* SUB/shares := TOP/shares * cpu_rate_limit */
 
 	int64 shares = readInt64(0, NULL, comp, "cpu.shares");
 	writeInt64(group, NULL, comp, "cpu.shares", shares * cpu_rate_limit / 100);
+
+	/* SUB/cfs_quota_us := period * ncores * gp_resource_group_cpu_limit * cpu_rate_limit */
+	if (gp_resource_group_cpu_ceiling_enforcement)
+	{
+		period = readInt64(group, NULL, comp, "cpu.cfs_period_us");
+		quota = period * ncores * gp_resource_group_cpu_limit * cpu_rate_limit / 100;
+	}
+	else
+		quota = -1;
+	writeInt64(group, NULL, comp, "cpu.cfs_quota_us", quota);
+}
+
+/*
+ * Set the cores the OS group runs on, per gp_resource_group_cpuset.
+ *
+ * A group listed in gp_resource_group_cpuset runs on its dedicated cores,
+ * the other groups share the cores of the gpdb toplevel cgroup that no
+ * group has reserved.  Nothing is done if gp_resource_group_cpuset is empty.
+ */
+void
+ResGroupOps_SetCpuSet(Oid group, const char *groupName)
+{
+	const char *comp = "cpuset";
+	char data[MAX_CPUSET_STRING_LEN];
+	cpu_set_t cpuset;
+	cpu_set_t reserved;
+
+	if (!cpusetEnabled())
+		return;
+
+	if (!lookupCpuSet(groupName, &cpuset, &reserved))
+	{
+		cpu_set_t all;
+
+		readStr(0, NULL, comp,
+				cgversion == CGROUP_V2 ? "cpuset.cpus.effective" : "cpuset.cpus",
+				data, sizeof(data));
+		parseCpuList(data, &all);
+
+		CPU_XOR(&cpuset, &all, &reserved);
+		CPU_AND(&cpuset, &cpuset, &all);
+		if (CPU_COUNT(&cpuset) == 0)
+			ereport(ERROR,
+					(errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+					 errmsg("no cores left for resource group \"%s\"", groupName),
+					 errhint("gp_resource_group_cpuset reserves all the cores (%s).",
+							 data)));
+	}
+
+	/* v1 requires the memory nodes to be set before any process can join */
+	if (cgversion == CGROUP_V1)
+	{
+		readStr(0, NULL, comp, "cpuset.mems", data, sizeof(data));
+		writeStr(group, NULL, comp, "cpuset.mems", data);
+	}
+
+	formatCpuList(&cpuset, data, sizeof(data));
+	writeStr(group, NULL, comp, "cpuset.cpus", data);
 }
 
 /*
@@ -784,6 +1236,22 @@ ResGroupOps_GetCpuUsage(Oid group)
 {
 	const char *comp = "cpuacct";
 
+	if (cgversion == CGROUP_V2)
+	{
+		char data[MAX_CPUSET_STRING_LEN];
+		const char *usage;
+		long long usec;
+
+		/* cpu.stat is "key value" lines, usage_usec is in micro seconds */
+		readStr(group, NULL, "cpu", "cpu.stat", data, sizeof(data));
+		usage = strstr(data, "usage_usec ");
+		if (usage == NULL ||
+			sscanf(usage, "usage_usec %lld", &usec) != 1)
+			CGROUP_ERROR("can't find usage_usec in cpu.stat");
+
+		return (int64) usec * 1000;
+	}
+
 	return readInt64(group, NULL, comp, "cpuacct.usage");
 }
 
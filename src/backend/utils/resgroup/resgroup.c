@@ -21,6 +21,7 @@
 #include "catalog/pg_authid.h"
 #include "catalog/pg_resgroup.h"
 #include "cdb/cdbgang.h"
+#include "cdb/cdbstmtstats.h"
 #include "cdb/cdbutil.h"
 #include "cdb/cdbvars.h"
 #include "cdb/memquota.h"
@@ -181,6 +182,9 @@ static ResGroupProcData *self = &__self;
 
 static bool localResWaiting = false;
 
+/* set when the group memory is exhausted and operators should spill */
+static bool spillRequested = false;
+
 /* static functions */
 
 static bool groupApplyMemCaps(ResGroupData *group, const ResGroupCaps *caps);
@@ -499,6 +503,8 @@ InitResGroups(void)
 
 		ResGroupOps_CreateGroup(groupId);
 		ResGroupOps_SetCpuRateLimit(groupId, cpuRateLimit);
+		ResGroupOps_SetCpuSet(groupId,
+							  NameStr(((Form_pg_resgroup) GETSTRUCT(tuple))->rsgname));
 
 		numGroups++;
 		Assert(numGroups <= MaxResourceGroups);
@@ -787,6 +793,10 @@ ResGroupDumpMemoryInfo(void)
  *
  * 'overuseChunks' number of chunks can be overused for error handling,
  * in such a case waiverUsed is marked as true.
+ *
+ * Before failing, up to gp_resource_group_spill_grace_mb more can be
+ * overused while the spilling operators are asked to write their data to
+ * disk, see ResGroupConsumeSpillRequest().
  */
 bool
 ResGroupReserveMemory(int32 memoryChunks, int32 overuseChunks, bool *waiverUsed)
@@ -852,6 +862,19 @@ ResGroupReserveMemory(int32 memoryChunks, int32 overuseChunks, bool *waiverUsed)
 	/* then check whether there is over usage */
 	if (CritSectionCount == 0 && overused > overuseChunks)
 	{
+		/*
+		 * Instead of failing right away, ask the spilling operators to write
+		 * their data to disk, and let the allocation through while the over
+		 * usage is within the spill grace.
+		 */
+		if (overused <= overuseChunks +
+			VmemTracker_ConvertVmemMBToChunks(gp_resource_group_spill_grace_mb))
+		{
+			spillRequested = true;
+			*waiverUsed = true;
+			return true;
+		}
+
 		/* if the over usage is larger than allowed then revert the change */
 		groupDecMemUsage(group, slot, memoryChunks);
 
@@ -873,6 +896,21 @@ ResGroupReserveMemory(int32 memoryChunks, int32 overuseChunks, bool *waiverUsed)
 	return true;
 }
 
+/*
+ * Check whether operators are asked to spill to disk because the resource
+ * group memory is exhausted; the request is cleared by the first operator
+ * that consumes it.
+ */
+bool
+ResGroupConsumeSpillRequest(void)
+{
+	if (!spillRequested)
+		return false;
+
+	spillRequested = false;
+	return true;
+}
+
 /*
  * Release the memory of resource group
  */
@@ -1008,6 +1046,16 @@ ResGroupDecideMemoryCaps(int groupId,
 	LWLockRelease(ResGroupLock);
 }
 
+/*
+ * Get the resource group the current query runs in, or InvalidOid if it
+ * doesn't run in one.
+ */
+Oid
+GetMyResGroupId(void)
+{
+	return self->groupId;
+}
+
 int64
 ResourceGroupGetQueryMemoryLimit(void)
 {
@@ -2118,6 +2166,7 @@ UnassignResGroup(void)
 
 	/* Stop memory limit checking */
 	self->doMemCheck = false;
+	spillRequested = false;
 
 	/* Cleanup self */
 	if (self->memUsage > 10)
@@ -2253,6 +2302,7 @@ static void
 ResGroupWait(ResGroupData *group)
 {
 	PGPROC *proc = MyProc;
+	instr_time	starttime;
 
 	Assert(!LWLockHeldExclusiveByMe(ResGroupLock));
 	Assert(selfHasGroup());
@@ -2262,6 +2312,8 @@ ResGroupWait(ResGroupData *group)
 
 	/* similar to lockAwaited in ProcSleep for interrupt cleanup */
 	localResWaiting = true;
+	pgstat_report_wait_start(WAIT_EVENT_RESGROUP);
+	INSTR_TIME_SET_CURRENT(starttime);
 
 	/*
 	 * Make sure we have released all locks before going to sleep, to eliminate
@@ -2290,6 +2342,8 @@ ResGroupWait(ResGroupData *group)
 	localResWaiting = false;
 
 	pgstat_report_waiting(PGBE_WAITING_NONE);
+	pgstat_report_wait_end();
+	StmtStatsAddTime(STMT_PHASE_QUEUE, starttime);
 }
 
 /*
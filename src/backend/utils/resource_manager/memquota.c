@@ -200,6 +200,10 @@ IsBlockingOperator(Node *node)
 		case T_Agg:
 			return IsAggBlockingOperator((Agg *)node);
 
+		case T_SetOp:
+			/* A hashed SetOp reads all its input before returning a row */
+			return ((SetOp *) node)->strategy == SETOP_HASHED;
+
 		default:
 			return false;
 	}
@@ -258,6 +262,8 @@ IsMemoryIntensiveOperator(Node *node, PlannedStmt *stmt)
 				Result *res = (Result *) node;
 				return IsResultMemoryIntesive(res);
 			}
+		case T_SetOp:
+			return ((SetOp *) node)->strategy == SETOP_HASHED;
 		default:
 			return false;
 	}
@@ -40,6 +40,7 @@
 #include "utils/ps_status.h"
 #include "utils/resowner.h"
 #include "utils/resscheduler.h"
+#include "cdb/cdbstmtstats.h"
 #include "cdb/memquota.h"
 #include "commands/queue.h"
 
@@ -56,12 +57,22 @@ static void ResGrantLock(LOCK *lock, PROCLOCK *proclock);
 static bool ResUnGrantLock(LOCK *lock, PROCLOCK *proclock);
 
 static uint64 ResourceQueueGetSuperuserQueryMemoryLimit(void);
+static void ResQueueRecordWait(Oid queueid, TimestampTz waitStart);
 /*
  * Global Variables
  */
 static HTAB *ResPortalIncrementHash;	/* Hash of resource increments. */
 static HTAB *ResQueueHash;		/* Hash of resource queues. */
 
+/*
+ * Upper bounds (in milliseconds) of the buckets of the wait time histogram
+ * of a queue; the last bucket counts the longer waits.
+ */
+static const long ResQueueWaitBucketBounds[RES_QUEUE_WAIT_BUCKETS - 1] =
+{
+	10, 100, 1000, 10000, 60000, 600000
+};
+
 
 /*
  * Record structure holding the to be exposed per queue data, used by
@@ -78,6 +89,7 @@ typedef struct
 	float4		queuememvalue;
 	int			queuewaiters;
 	int			queueholders;
+	int64		queuewaithistogram[RES_QUEUE_WAIT_BUCKETS];
 }	QueueStatusRec;
 
 
@@ -135,6 +147,7 @@ ResLockAcquire(LOCKTAG *locktag, ResPortalIncrement *incrementSet)
 	ResourceOwner owner;
 	ResQueue	queue;
 	int			status;
+	TimestampTz waitStart;
 
 	/* Setup the lock method bits. */
 	Assert(locktag->locktag_lockmethodid == RESOURCE_LOCKMETHOD);
@@ -162,6 +175,7 @@ ResLockAcquire(LOCKTAG *locktag, ResPortalIncrement *incrementSet)
 		locallock->lock = NULL;
 		locallock->proclock = NULL;
 		locallock->hashcode = LockTagHashCode(&(localtag.lock));
+		locallock->holdsStrongLockCount = false;
 		locallock->nLocks = 0;
 		locallock->numLockOwners = 0;
 		locallock->maxLockOwners = 8;
@@ -395,6 +409,9 @@ ResLockAcquire(LOCKTAG *locktag, ResPortalIncrement *incrementSet)
 		ResGrantLock(lock, proclock);
 		ResLockUpdateLimit(lock, proclock, incrementSet, true, false);
 
+		/* Admitted without waiting. */
+		queue->waitHistogram[0]++;
+
 		LWLockRelease(ResQueueLock);
 
 		/* Note the start time for queue statistics. */
@@ -438,6 +455,7 @@ ResLockAcquire(LOCKTAG *locktag, ResPortalIncrement *incrementSet)
 		/*
 		 * Sleep till someone wakes me up.
 		 */
+		waitStart = GetCurrentTimestamp();
 		ResWaitOnLock(locallock, owner, incrementSet);
 
 		/*
@@ -452,6 +470,9 @@ ResLockAcquire(LOCKTAG *locktag, ResPortalIncrement *incrementSet)
 		/* Reset the portal id. */
 		MyProc->waitPortalId = INVALID_PORTALID;
 
+		/* Add the wait to the histogram of the queue. */
+		ResQueueRecordWait(locktag->locktag_field1, waitStart);
+
 		/* End wait time and start execute time statistics for this queue. */
 		pgstat_record_end_queue_wait(incrementSet->portalId,
 									 locktag->locktag_field1);
@@ -653,6 +674,7 @@ ResLockCheckLimit(LOCK *lock, PROCLOCK *proclock, ResPortalIncrement *incrementS
 	int			status = STATUS_OK;
 	Cost		increment_amt;
 	int			i;
+	bool		fast_lane;
 
 	Assert(LWLockHeldExclusiveByMe(ResQueueLock));
 
@@ -660,6 +682,14 @@ ResLockCheckLimit(LOCK *lock, PROCLOCK *proclock, ResPortalIncrement *incrementS
 	queue = GetResQueueFromLock(lock);
 	limits = queue->limits;
 
+	/*
+	 * Short statements use the fast lane: they may go beyond the active
+	 * statement limit by gp_resqueue_fast_lane_slots, and ignore the cost
+	 * limit, so they don't queue behind long running ones.
+	 */
+	fast_lane = increment && gp_resqueue_fast_lane_slots > 0 &&
+		incrementSet->increments[RES_COST_LIMIT] < gp_resqueue_fast_lane_cost;
+
 	for (i = 0; i < NUM_RES_LIMIT_TYPES; i++)
 	{
 		/*
@@ -677,9 +707,14 @@ ResLockCheckLimit(LOCK *lock, PROCLOCK *proclock, ResPortalIncrement *incrementS
 					/* Setup whether to increment or decrement the # active. */
 					if (increment)
 					{
+						Cost		threshold = limits[i].threshold_value;
+
 						increment_amt = incrementSet->increments[i];
 
-						if (limits[i].current_value + increment_amt > limits[i].threshold_value)
+						if (fast_lane)
+							threshold += gp_resqueue_fast_lane_slots;
+
+						if (limits[i].current_value + increment_amt > threshold)
 							over_limit = true;
 					}
 					else
@@ -707,7 +742,11 @@ ResLockCheckLimit(LOCK *lock, PROCLOCK *proclock, ResPortalIncrement *incrementS
 						if (increment_amt > limits[i].threshold_value)
 							will_overcommit = true;
 
-						if (queue->overcommit)
+						if (fast_lane)
+						{
+							/* The fast lane is not held up by the cost limit. */
+						}
+						else if (queue->overcommit)
 						{
 							/*
 							 * Autocommit is enabled, allow statements that
@@ -1017,6 +1056,7 @@ ResWaitOnLock(LOCALLOCK *locallock, ResourceOwner owner, ResPortalIncrement *inc
 	const char *old_status;
 	char	   *new_status = NULL;
 	int			len;
+	instr_time	starttime;
 
 	/* Report change to waiting status */
 	if (update_process_title)
@@ -1029,6 +1069,8 @@ ResWaitOnLock(LOCALLOCK *locallock, ResourceOwner owner, ResPortalIncrement *inc
 		new_status[len] = '\0';
 	}
 	pgstat_report_waiting(PGBE_WAITING_LOCK);
+	pgstat_report_wait_start(WAIT_EVENT_RESQUEUE);
+	INSTR_TIME_SET_CURRENT(starttime);
 
 	awaitedLock = locallock;
 	awaitedOwner = owner;
@@ -1056,6 +1098,8 @@ ResWaitOnLock(LOCALLOCK *locallock, ResourceOwner owner, ResPortalIncrement *inc
 		pfree(new_status);
 	}
 	pgstat_report_waiting(PGBE_WAITING_NONE);
+	pgstat_report_wait_end();
+	StmtStatsAddTime(STMT_PHASE_QUEUE, starttime);
 
 	return;
 }
@@ -1637,8 +1681,40 @@ ResQueueHashRemove(Oid queueid)
 	return true;
 }
 
+/*
+ * ResQueueRecordWait -- add a statement admitted after waiting since
+ *	waitStart to the wait time histogram of its queue.
+ */
+static void
+ResQueueRecordWait(Oid queueid, TimestampTz waitStart)
+{
+	ResQueue	queue;
+	long		secs;
+	int			usecs;
+	long		waitMs;
+	int			bucket;
+
+	TimestampDifference(waitStart, GetCurrentTimestamp(), &secs, &usecs);
+	waitMs = secs * 1000 + usecs / 1000;
+
+	for (bucket = 0; bucket < RES_QUEUE_WAIT_BUCKETS - 1; bucket++)
+	{
+		if (waitMs < ResQueueWaitBucketBounds[bucket])
+			break;
+	}
+
+	LWLockAcquire(ResQueueLock, LW_EXCLUSIVE);
+
+	/* The queue may have been dropped meanwhile. */
+	queue = ResQueueHashFind(queueid);
+	if (queue != NULL)
+		queue->waitHistogram[bucket]++;
+
+	LWLockRelease(ResQueueLock);
+}
+
 /* Number of columns produced by pg_resqueue_status() */
-#define PG_RESQUEUE_STATUS_COLUMNS 5
+#define PG_RESQUEUE_STATUS_COLUMNS 6
 
 /*
  * pg_resqueue_status - produce a view with one row per resource queue
@@ -1680,6 +1756,7 @@ pg_resqueue_status(PG_FUNCTION_ARGS)
 		TupleDescInitEntry(tupledesc, (AttrNumber) 3, "queuecostvalue", FLOAT4OID, -1, 0);
 		TupleDescInitEntry(tupledesc, (AttrNumber) 4, "queuewaiters", INT4OID, -1, 0);
 		TupleDescInitEntry(tupledesc, (AttrNumber) 5, "queueholders", INT4OID, -1, 0);
+		TupleDescInitEntry(tupledesc, (AttrNumber) 6, "queuewaithistogram", INT8ARRAYOID, -1, 0);
 
 		funcctx->tuple_desc = BlessTupleDesc(tupledesc);
 
@@ -1738,6 +1815,20 @@ pg_resqueue_status(PG_FUNCTION_ARGS)
 		values[4] = record->queueholders;
 		nulls[4] = false;
 
+		/* Statements admitted by wait time, see ResQueueWaitBucketBounds. */
+		{
+			Datum		buckets[RES_QUEUE_WAIT_BUCKETS];
+			int			j;
+
+			for (j = 0; j < RES_QUEUE_WAIT_BUCKETS; j++)
+				buckets[j] = Int64GetDatum(record->queuewaithistogram[j]);
+
+			values[5] = PointerGetDatum(construct_array(buckets, RES_QUEUE_WAIT_BUCKETS,
+														INT8OID, sizeof(int64),
+														FLOAT8PASSBYVAL, 'd'));
+			nulls[5] = false;
+		}
+
 		/* Build and return the tuple. */
 		tuple = heap_form_tuple(funcctx->tuple_desc, values, nulls);
 		result = HeapTupleGetDatum(tuple);
@@ -1798,6 +1889,8 @@ BuildQueueStatusContext(QueueStatusContext *fctx)
 		limits = queue->limits;
 
 		fctx->record[i].queueid = queue->queueid;
+		memcpy(fctx->record[i].queuewaithistogram, queue->waitHistogram,
+			   sizeof(queue->waitHistogram));
 
 		for (j = 0; j < NUM_RES_LIMIT_TYPES; j++)
 		{
@@ -59,6 +59,10 @@ int		MaxResourcePortalsPerXact;				/* Max # tracked portals -
 												 * per backend . */
 bool	ResourceSelectOnly;						/* Only lock SELECT/DECLARE? */
 bool	ResourceCleanupIdleGangs;				/* Cleanup idle gangs? */
+double	gp_resqueue_fast_lane_cost;				/* Cost below which queries
+												 * use the fast lane. */
+int		gp_resqueue_fast_lane_slots;			/* # of extra statements
+												 * admitted by the fast lane. */
 
 
 /*
@@ -315,6 +319,9 @@ ResCreateQueue(Oid queueid, Cost limits[NUM_RES_LIMIT_TYPES], bool overcommit,
 	/* Set ignore cost limit. */
 	queue->ignorecostlimit = ignorelimit;
 
+	/* No statement has waited yet. */
+	MemSet(queue->waitHistogram, 0, sizeof(queue->waitHistogram));
+
 	/* Now run through all the possible limit types.*/
 	for (i = 0 ; i < NUM_RES_LIMIT_TYPES; i++)
 	{
@@ -118,6 +118,7 @@
 #include "utils/lsyscache.h"
 #include "utils/memutils.h"
 #include "utils/pg_rusage.h"
+#include "utils/resgroup.h"
 #include "utils/syscache.h"
 #include "utils/tuplesort.h"
 
@@ -968,6 +969,42 @@ grow_memtuples(Tuplesortstate *state)
 	return true;
 }
 
+/*
+ * Raise our memory limit by the quota that finished operators gave back to
+ * the query (see MemoryAccounting_RelinquishQuota).  Return TRUE if the
+ * limit was raised.
+ */
+static bool
+grow_allowed_mem(Tuplesortstate *state)
+{
+	long		acquired = (long) MemoryAccounting_RequestQuotaIncrease();
+
+	if (acquired <= 0)
+		return false;
+
+	state->allowedMem += acquired;
+	state->availMem += acquired;
+	return true;
+}
+
+/*
+ * Lower our memory limit to half of what is in use, when the resource group
+ * memory is exhausted, so that tuples are dumped to tape until we are under
+ * it.  Any later quota increase can raise it again.
+ */
+static void
+shrink_allowed_mem(Tuplesortstate *state)
+{
+	long		used = state->allowedMem - state->availMem;
+	long		newAllowed = Max(used / 2, 64 * 1024L);
+
+	if (newAllowed >= state->allowedMem)
+		return;
+
+	state->availMem -= state->allowedMem - newAllowed;
+	state->allowedMem = newAllowed;
+}
+
 /*
  * Accept one tuple while collecting input data for sort.
  *
@@ -1144,10 +1181,24 @@ puttuple_common(Tuplesortstate *state, SortTuple *tuple)
 			}
 
 			/*
-			 * Done if we still fit in available memory and have array slots.
+			 * Done if we still fit in available memory and have array slots,
+			 * unless the resource group memory is exhausted.
 			 */
-			if (state->memtupcount < state->memtupsize && !LACKMEM(state))
-				return;
+			if (ResGroupConsumeSpillRequest())
+				shrink_allowed_mem(state);
+			else
+			{
+				if (state->memtupcount < state->memtupsize && !LACKMEM(state))
+					return;
+
+				/*
+				 * Before spilling, grow into the quota given back by finished
+				 * operators, if that is enough to keep going in memory.
+				 */
+				if (grow_allowed_mem(state) && !LACKMEM(state) &&
+					(state->memtupcount < state->memtupsize || grow_memtuples(state)))
+					return;
+			}
 
 			state->memUsedBeforeSpill = MemoryContextGetPeakSpace(state->sortcontext);
 
@@ -1215,7 +1266,10 @@ puttuple_common(Tuplesortstate *state, SortTuple *tuple)
 
 			/*
 			 * If we are over the memory limit, dump tuples till we're under.
+			 * Lower the limit first if the resource group memory is exhausted.
 			 */
+			if (ResGroupConsumeSpillRequest())
+				shrink_allowed_mem(state);
 			dumptuples(state, false);
 			break;
 
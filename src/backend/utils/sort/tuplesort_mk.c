@@ -117,10 +117,14 @@
 #include "utils/lsyscache.h"
 #include "utils/memutils.h"
 #include "utils/pg_rusage.h"
+#include "utils/resgroup.h"
 #include "utils/syscache.h"
 #include "utils/tuplesort.h"
 #include "utils/pg_locale.h"
 #include "utils/builtins.h"
+#include "utils/date.h"
+#include "utils/numeric.h"
+#include "utils/timestamp.h"
 #include "utils/tuplesort_mk.h"
 #include "utils/tuplesort_mk_details.h"
 #include "utils/string_wrapper.h"
@@ -269,6 +273,15 @@ struct Tuplesortstate_mk
 	 */
 	MKHeap	   *mkheap;
 	MKHeapReader *mkhreader;
+
+	/*
+	 * Bounded sort, once the heap holds bound tuples: the first sort key of
+	 * the heap's top, i.e. of the last tuple still in the top N, prepared
+	 * like an MKEntry's datum.  Not valid after the heap changes.
+	 */
+	bool		limitTopValid;
+	bool		limitTopNull;
+	Datum		limitTopKey;
 	TupsortMergeReadCtxt *mkhreader_ctxt;
 	int			mkhreader_allocsize;
 
@@ -505,6 +518,10 @@ static void readtup_datum(Tuplesortstate_mk *state, TuplesortPos_mk *pos, MKEntr
 
 static void tupsort_prepare_char(MKEntry *a, bool isChar);
 static int	tupsort_compare_char(MKEntry *v1, MKEntry *v2, MKLvContext *lvctxt, MKContext *mkContext);
+static Datum tupsort_abbrev_text(Datum d, bool isCHAR);
+static Datum tupsort_abbrev_numeric(Datum d);
+static bool tuplesort_limit_reject_slot(Tuplesortstate_mk *state, TupleTableSlot *slot);
+static int	tupsort_compare_abbrev(MKEntry *v1, MKEntry *v2, MKLvContext *lvctxt, MKContext *mkContext);
 
 static Datum tupsort_fetch_datum_mtup(MKEntry *a, MKContext *mkctxt, MKLvContext *lvctxt, bool *isNullOut);
 static Datum tupsort_fetch_datum_itup(MKEntry *a, MKContext *mkctxt, MKLvContext *lvctxt, bool *isNullOut);
@@ -743,6 +760,25 @@ create_mksort_context(
 				else if (sinfo->scanKey.sk_func.fn_addr == bttextcmp)
 					sinfo->lvtype = MKLV_TYPE_TEXT;
 			}
+			if (gp_mk_sort_abbrev_keys)
+			{
+				PGFunction	cmpfn = sinfo->scanKey.sk_func.fn_addr;
+
+				if (cmpfn == date_cmp)
+					sinfo->lvtype = MKLV_TYPE_INT32;
+				else if (cmpfn == btint8cmp)
+					sinfo->lvtype = MKLV_TYPE_INT64;
+#ifdef HAVE_INT64_TIMESTAMP
+				else if (cmpfn == timestamp_cmp)
+					sinfo->lvtype = MKLV_TYPE_INT64;
+#endif
+				else if (cmpfn == numeric_cmp)
+					sinfo->lvtype = MKLV_TYPE_NUMERIC;
+				else if (lc_collate_is_c() && cmpfn == bpcharcmp)
+					sinfo->lvtype = MKLV_TYPE_CHAR_C;
+				else if (lc_collate_is_c() && cmpfn == bttextcmp)
+					sinfo->lvtype = MKLV_TYPE_TEXT_C;
+			}
 		}
 		else
 		{
@@ -1141,12 +1177,106 @@ tuplesort_puttupleslot_mk(Tuplesortstate_mk *state, TupleTableSlot *slot)
 
 	mke_blank(&e);
 
+	/*
+	 * In a bounded sort, most rows lose to the top N once it is full; turn
+	 * those away before copying them.
+	 */
+	if (state->status == TSS_INITIAL && state->mkheap != NULL &&
+		tuplesort_limit_reject_slot(state, slot))
+	{
+		state->totalNumTuples++;
+		if (state->gpmon_pkt)
+			Gpmon_Incr_Rows_In(state->gpmon_pkt);
+		MemoryContextSwitchTo(oldcontext);
+		return;
+	}
+
 	COPYTUP(state, &e, (void *) slot);
 	puttuple_common(state, &e);
 
 	MemoryContextSwitchTo(oldcontext);
 }
 
+/*
+ * tuplesort_limit_reject_slot
+ *	 Does the slot's tuple certainly sort after every tuple in the top N?
+ *
+ * Only looks at the first sort key: true if it sorts after the first key of
+ * the heap's top.  Ties, NULLs and keys that need a strxfrm'ed copy are left
+ * to the heap.
+ */
+static bool
+tuplesort_limit_reject_slot(Tuplesortstate_mk *state, TupleTableSlot *slot)
+{
+	MKContext  *mkctxt = &state->mkctxt;
+	MKLvContext *lvctxt = mkctxt->lvctxt;
+	Datum		d;
+	bool		isnull;
+	int			result;
+
+	Assert(mkctxt->bounded && state->mkheap != NULL);
+
+	if (lvctxt->lvtype == MKLV_TYPE_CHAR || lvctxt->lvtype == MKLV_TYPE_TEXT)
+		return false;
+
+	if (!state->limitTopValid)
+	{
+		MKEntry    *top = mkheap_peek(state->mkheap);
+
+		Assert(top != NULL);
+		d = (mkctxt->fetchForPrep) (top, mkctxt, lvctxt, &isnull);
+		if (!isnull && lvctxt->lvtype == MKLV_TYPE_CHAR_C)
+			d = tupsort_abbrev_text(d, true);
+		else if (!isnull && lvctxt->lvtype == MKLV_TYPE_TEXT_C)
+			d = tupsort_abbrev_text(d, false);
+		else if (!isnull && lvctxt->lvtype == MKLV_TYPE_NUMERIC)
+			d = tupsort_abbrev_numeric(d);
+
+		state->limitTopKey = d;
+		state->limitTopNull = isnull;
+		state->limitTopValid = true;
+	}
+
+	if (state->limitTopNull)
+		return false;
+
+	d = slot_getattr(slot, lvctxt->attno, &isnull);
+	if (isnull)
+		return false;
+
+	if (mklv_is_abbrev(lvctxt->lvtype))
+	{
+		uint64		key;
+
+		if (lvctxt->lvtype == MKLV_TYPE_NUMERIC)
+			key = DatumGetUInt64(tupsort_abbrev_numeric(d));
+		else
+			key = DatumGetUInt64(tupsort_abbrev_text(d, lvctxt->lvtype == MKLV_TYPE_CHAR_C));
+
+		/* Equal keys may still differ; let the heap decide */
+		if (key == DatumGetUInt64(state->limitTopKey))
+			return false;
+		result = (key < DatumGetUInt64(state->limitTopKey)) ? -1 : 1;
+		if ((lvctxt->scanKey.sk_flags & SK_BT_DESC) != 0)
+			result = -result;
+	}
+	else
+	{
+		MKEntry		v1;
+		MKEntry		v2;
+
+		mke_blank(&v1);
+		mke_blank(&v2);
+		mke_set_not_null(&v1);
+		mke_set_not_null(&v2);
+		v1.d = d;
+		v2.d = state->limitTopKey;
+		result = tupsort_compare_datum(&v1, &v2, lvctxt, mkctxt);
+	}
+
+	return result > 0;
+}
+
 /*
  * Accept one index tuple while collecting input data for sort.
  *
@@ -1202,6 +1332,25 @@ tuplesort_putdatum_mk(Tuplesortstate_mk *state, Datum val, bool isNull)
 	MemoryContextSwitchTo(oldcontext);
 }
 
+/*
+ * grow_mem_allowed
+ *	 Raise memAllowed by the quota that finished operators gave back to the
+ *	 query (see MemoryAccounting_RelinquishQuota).
+
+ * Returns true if memAllowed was raised.
+ */
+static bool
+grow_mem_allowed(Tuplesortstate_mk *state)
+{
+	uint64		acquired = MemoryAccounting_RequestQuotaIncrease();
+
+	if (acquired == 0)
+		return false;
+
+	state->memAllowed += acquired;
+	return true;
+}
+
 /*
  * grow_unsorted_array
  *	 Grow the unsorted array to allow more entries to be inserted later.
@@ -1271,8 +1420,19 @@ puttuple_common(Tuplesortstate_mk *state, MKEntry *e)
 			if (!state->mkheap && state->entry_count >= state->entry_allocsize - 1)
 			{
 				growSucceed = grow_unsorted_array(state);
+
+				/*
+				 * Before spilling, grow into the quota given back by
+				 * finished operators, and try again.
+				 */
+				if (!growSucceed && grow_mem_allowed(state))
+					growSucceed = grow_unsorted_array(state);
 			}
 
+			/* Also switch to diskmode if the resource group memory is exhausted */
+			if (growSucceed && !state->mkheap && ResGroupConsumeSpillRequest())
+				growSucceed = false;
+
 			/* full sort? */
 			if (!state->mkctxt.bounded)
 			{
@@ -1349,7 +1509,8 @@ tuplesort_performsort_mk(Tuplesortstate_mk *state)
 			 * amount of memory.  Just qsort 'em and we're done.
 			 */
 			if (!state->mkctxt.bounded)
-				mk_qsort(state->entries, state->entry_count, &state->mkctxt);
+				mk_qsort_parallel(state->entries, state->entry_count,
+								  &state->mkctxt, gp_mk_sort_threads);
 			else
 				tuplesort_limit_sort(state);
 
@@ -3058,6 +3219,18 @@ tupsort_compare_datum(MKEntry *v1, MKEntry *v2, MKLvContext *lvctxt, MKContext *
 
 				return ((lvctxt->scanKey.sk_flags & SK_BT_DESC) != 0) ? -result : result;
 			}
+		case MKLV_TYPE_INT64:
+			{
+				int64		i1 = DatumGetInt64(v1->d);
+				int64		i2 = DatumGetInt64(v2->d);
+				int			result = (i1 < i2) ? -1 : ((i1 == i2) ? 0 : 1);
+
+				return ((lvctxt->scanKey.sk_flags & SK_BT_DESC) != 0) ? -result : result;
+			}
+		case MKLV_TYPE_CHAR_C:
+		case MKLV_TYPE_TEXT_C:
+		case MKLV_TYPE_NUMERIC:
+			return tupsort_compare_abbrev(v1, v2, lvctxt, context);
 		default:
 			return tupsort_compare_char(v1, v2, lvctxt, context);
 	}
@@ -3093,7 +3266,7 @@ tupsort_cpfr(MKEntry *dst, MKEntry *src, MKLvContext *lvctxt)
 		{
 			if (mke_is_refc(src))
 				tupsort_refcnt(DatumGetPointer(dst->d), 1);
-			else if (!lvctxt->typByVal)
+			else if (!lvctxt->typByVal && !mklv_is_abbrev(lvctxt->lvtype))
 			{
 				Assert(src->d != 0);
 				dst->d = datumCopy(src->d, lvctxt->typByVal, lvctxt->typLen);
@@ -3282,6 +3455,12 @@ tupsort_prepare(MKEntry *a, MKContext *mkctxt, int lv)
 		tupsort_prepare_char(a, true);
 	else if (lvctxt->lvtype == MKLV_TYPE_TEXT)
 		tupsort_prepare_char(a, false);
+	else if (!isnull && lvctxt->lvtype == MKLV_TYPE_CHAR_C)
+		a->d = tupsort_abbrev_text(a->d, true);
+	else if (!isnull && lvctxt->lvtype == MKLV_TYPE_TEXT_C)
+		a->d = tupsort_abbrev_text(a->d, false);
+	else if (!isnull && lvctxt->lvtype == MKLV_TYPE_NUMERIC)
+		a->d = tupsort_abbrev_numeric(a->d);
 }
 
 /* "True" length (not counting trailing blanks) of a BpChar */
@@ -3298,6 +3477,136 @@ bcTruelen(char *p, int len)
 	return i + 1;
 }
 
+/*
+ * Abbreviated keys
+ *
+ * An abbreviated level keeps, instead of the datum, a 64 bit key such that
+ * a < b implies key(a) <= key(b) in unsigned order.  Keys that differ
+ * decide the comparison.  Equal keys decide it too if the key is exact,
+ * i.e. holds all of both values; otherwise the datums are fetched from the
+ * tuples again and compared with the sort function.
+ *
+ * Text and char under the C collation sort by memcmp, so the key is the
+ * first 8 bytes, big-endian and zero padded (trailing blanks of a char
+ * don't count).  Neither can contain a zero byte, so a key is exact when
+ * its last byte is zero.
+ *
+ * A numeric key holds, from the top, the weight offset by
+ * TUPSORT_NUMERIC_MIN_WEIGHT in 7 bits, the first 3 base-NBASE digits in
+ * 14 bits each, and in the lowest bit whether there are more digits; it is
+ * negated for negative values and exact when that bit is clear.  Weights
+ * out of range clamp to inexact keys, so do NaN and huge values.  The
+ * signed keys are turned into unsigned ones by flipping the top bit.
+ */
+#define TUPSORT_NUMERIC_MIN_WEIGHT	(-44)
+#define TUPSORT_NUMERIC_MAX_WEIGHT	83
+#define TUPSORT_ABBREV_SIGNBIT		(UINT64CONST(1) << 63)
+
+static Datum
+tupsort_abbrev_text(Datum d, bool isCHAR)
+{
+	char	   *p;
+	int			len;
+	void	   *tofree = NULL;
+	uint64		key = 0;
+	int			i;
+
+	varattrib_untoast_ptr_len(d, &p, &len, &tofree);
+
+	if (isCHAR)
+		len = bcTruelen(p, len);
+
+	for (i = 0; i < (int) sizeof(uint64); i++)
+	{
+		key <<= 8;
+		if (i < len)
+			key |= (unsigned char) p[i];
+	}
+
+	if (tofree)
+		pfree(tofree);
+
+	return UInt64GetDatum(key);
+}
+
+static Datum
+tupsort_abbrev_numeric(Datum d)
+{
+	char	   *p;
+	int			len;
+	void	   *tofree = NULL;
+	uint16		sign_dscale;
+	int16		weight;
+	int16		digits[3] = {0, 0, 0};
+	int			ndigits;
+	int64		key;
+
+	varattrib_untoast_ptr_len(d, &p, &len, &tofree);
+
+	/* The payload is n_sign_dscale, n_weight and the digits, maybe unaligned */
+	memcpy(&sign_dscale, p, sizeof(uint16));
+	memcpy(&weight, p + sizeof(uint16), sizeof(int16));
+	ndigits = (len - sizeof(uint16) - sizeof(int16)) / sizeof(int16);
+	memcpy(digits, p + sizeof(uint16) + sizeof(int16),
+		   Min(ndigits, 3) * sizeof(int16));
+
+	if (tofree)
+		pfree(tofree);
+
+	if ((sign_dscale & NUMERIC_SIGN_MASK) == NUMERIC_NAN)
+		key = INT64CONST(0x7FFFFFFFFFFFFFFF);
+	else if (ndigits == 0)
+		key = 0;
+	else
+	{
+		if (weight < TUPSORT_NUMERIC_MIN_WEIGHT)
+			key = 1;
+		else if (weight > TUPSORT_NUMERIC_MAX_WEIGHT)
+			key = INT64CONST(0x7FFFFFFFFFFFFFFF);
+		else
+			key = ((int64) (weight - TUPSORT_NUMERIC_MIN_WEIGHT) << 56) |
+				((int64) digits[0] << 42) |
+				((int64) digits[1] << 28) |
+				((int64) digits[2] << 14) |
+				(ndigits > 3 ? 1 : 0);
+
+		if ((sign_dscale & NUMERIC_SIGN_MASK) == NUMERIC_NEG)
+			key = -key;
+	}
+
+	return UInt64GetDatum((uint64) key ^ TUPSORT_ABBREV_SIGNBIT);
+}
+
+static int
+tupsort_compare_abbrev(MKEntry *v1, MKEntry *v2, MKLvContext *lvctxt, MKContext *mkContext)
+{
+	uint64		k1 = DatumGetUInt64(v1->d);
+	uint64		k2 = DatumGetUInt64(v2->d);
+	int			result;
+
+	if (k1 != k2)
+		result = (k1 < k2) ? -1 : 1;
+	else if (lvctxt->lvtype == MKLV_TYPE_NUMERIC ? (k1 & 1) == 0 : (k1 & 0xFF) == 0)
+		result = 0;
+	else
+	{
+		Datum		d1,
+					d2;
+		bool		isnull1,
+					isnull2;
+
+		d1 = (mkContext->fetchForPrep) (v1, mkContext, lvctxt, &isnull1);
+		d2 = (mkContext->fetchForPrep) (v2, mkContext, lvctxt, &isnull2);
+		Assert(!isnull1 && !isnull2);
+
+		/* The sort function takes care of DESC */
+		return inlineApplySortFunction(&lvctxt->scanKey.sk_func, lvctxt->scanKey.sk_flags,
+									   d1, false, d2, false);
+	}
+
+	return ((lvctxt->scanKey.sk_flags & SK_BT_DESC) != 0) ? -result : result;
+}
+
 /**
  * should only be called for non-null Datum (caller must check the isnull flag from the fetch)
  */
@@ -3568,6 +3877,7 @@ tuplesort_inmem_limit_insert(Tuplesortstate_mk *state, MKEntry *entry)
 		Assert(state->mkheap->count == state->numTuplesInMem);
 		Assert(state->entry_count == 0);
 		(void) mkheap_putAndGet(state->mkheap, entry);
+		state->limitTopValid = false;
 
 		Assert(!mke_is_empty(entry));
 		Assert(entry->ptr);
@@ -19,13 +19,49 @@
  */
 
 #include "postgres.h"
+
+#include <pthread.h>
+
 #include "access/genam.h"
 #include "utils/tuplesort.h"
 #include "utils/tuplesort_mk.h"
 #include "utils/tuplesort_mk_details.h"
 
+#include "cdb/cdbgang.h"		/* gp_pthread_create */
 #include "miscadmin.h"
 
+/*
+ * Parallel sort.  The backend splits the array with 3-way partitioning
+ * steps until there are about MKQS_TASKS_PER_THREAD ranges per thread, or
+ * no range left larger than MKQS_MIN_TASK, and the threads then sort the
+ * ranges.  Arrays smaller than MKQS_PARALLEL_MIN are sorted serially.
+ */
+#define MKQS_PARALLEL_MIN		100000
+#define MKQS_MIN_TASK			8192
+#define MKQS_TASKS_PER_THREAD	8
+
+typedef struct MKQSortTask
+{
+	int			left;
+	int			right;
+	int			lv;
+	bool		lvdown;
+	bool		seenNull;
+} MKQSortTask;
+
+typedef struct MKQSortPool
+{
+	MKEntry    *a;
+	MKContext  *ctxt;
+	MKQSortTask *tasks;
+	int			ntasks;
+	int			next;
+	pthread_mutex_t lock;
+} MKQSortPool;
+
+static void mk_qsort_rec(MKEntry *a, int left, int right, int lv, bool lvdown,
+			 MKContext *ctxt, bool seenNull, bool worker);
+
 #ifdef MKQSORT_VERIFY 
 extern void mkqsort_verify(MKEntry *a, int l, int r, MKContext *mkctxt);
 #endif
@@ -262,6 +298,16 @@ static void mk_qsort_part3(MKEntry *a, int left, int right, int lv, MKContext *m
 }
 
 void mk_qsort_impl(MKEntry *a, int left, int right, int lv, bool lvdown, MKContext *ctxt, bool seenNull)
+{
+	mk_qsort_rec(a, left, right, lv, lvdown, ctxt, seenNull, false);
+}
+
+/*
+ * worker is true in a thread other than the backend's; see
+ * mk_qsort_threadsafe for what that rules out.
+ */
+static void mk_qsort_rec(MKEntry *a, int left, int right, int lv, bool lvdown,
+			 MKContext *ctxt, bool seenNull, bool worker)
 {
 	int lastInLow;
 	int firstInHigh;
@@ -269,10 +315,13 @@ void mk_qsort_impl(MKEntry *a, int left, int right, int lv, bool lvdown, MKConte
 	Assert(ctxt);
 	Assert(lv < ctxt->total_lv);
 
-	CHECK_FOR_INTERRUPTS();
+	if (!worker)
+	{
+		CHECK_FOR_INTERRUPTS();
 
-	if (QueryFinishPending)
-		return;
+		if (QueryFinishPending)
+			return;
+	}
 
 	if(right <= left)
 		return;
@@ -293,7 +342,7 @@ void mk_qsort_impl(MKEntry *a, int left, int right, int lv, bool lvdown, MKConte
 	mk_qsort_part3(a, left, right, lv, ctxt, &lastInLow, &firstInHigh);
 
 	/* recurse to left chunk */
-	mk_qsort_impl(a, left, lastInLow, lv, false, ctxt, seenNull);
+	mk_qsort_rec(a, left, lastInLow, lv, false, ctxt, seenNull, worker);
 
 	/* recurse to middle (equal) chunk */
 	if(lv < ctxt->total_lv-1)
@@ -301,7 +350,7 @@ void mk_qsort_impl(MKEntry *a, int left, int right, int lv, bool lvdown, MKConte
 		/*
 		 * [lastInLow+1,firstInHigh-1] defines the pivot region which was all equal at level lv.  So increase the level and compare that region!
 		 */
-		mk_qsort_impl(a, lastInLow+1, firstInHigh-1, lv+1, true, ctxt, seenNull || mke_is_null(a+lastInLow+1)); /* a + lastInLow + 1 points to the pivot */
+		mk_qsort_rec(a, lastInLow+1, firstInHigh-1, lv+1, true, ctxt, seenNull || mke_is_null(a+lastInLow+1), worker); /* a + lastInLow + 1 points to the pivot */
 	}
 	else
 	{
@@ -310,6 +359,7 @@ void mk_qsort_impl(MKEntry *a, int left, int right, int lv, bool lvdown, MKConte
 				!seenNull &&
 				!mke_is_null(a+lastInLow+1)) /* a + lastInLow + 1 points to the pivot */
 		{
+			Assert(!worker || (!ctxt->enforceUnique && !ctxt->unique));
 			if ( ctxt->enforceUnique )
 			{
 				Datum	values[INDEX_MAX_KEYS];
@@ -340,14 +390,193 @@ void mk_qsort_impl(MKEntry *a, int left, int right, int lv, bool lvdown, MKConte
 	}
 
 	/* recurse to right chunk */
-	mk_qsort_impl(a, firstInHigh, right, lv, false, ctxt, seenNull);
+	mk_qsort_rec(a, firstInHigh, right, lv, false, ctxt, seenNull, worker);
 
 #ifdef MKQSORT_VERIFY 
-	if(lv == 0)
+	if(lv == 0 && !worker)
 		mkqsort_verify(a, left, right, ctxt);
 #endif
 }
 
+/*
+ * Can the sort run in threads other than the backend's?  Only if nothing
+ * it calls can palloc or elog: every level holds int32 or int64 values
+ * passed by value and compared inline, and no duplicates have to be
+ * removed or reported.
+ */
+static bool mk_qsort_threadsafe(MKContext *ctxt)
+{
+	int lv;
+
+	if (ctxt->unique || ctxt->enforceUnique || ctxt->fetchForPrep == NULL)
+		return false;
+
+	for (lv = 0; lv < ctxt->total_lv; lv++)
+	{
+		MKLvContext *lvctxt = ctxt->lvctxt + lv;
+
+		if (!lvctxt->typByVal)
+			return false;
+		if (lvctxt->lvtype != MKLV_TYPE_INT32 && lvctxt->lvtype != MKLV_TYPE_INT64)
+			return false;
+	}
+
+	return true;
+}
+
+static int mk_qsort_task_cmp(const void *a, const void *b)
+{
+	const MKQSortTask *ta = (const MKQSortTask *) a;
+	const MKQSortTask *tb = (const MKQSortTask *) b;
+	int na = ta->right - ta->left;
+	int nb = tb->right - tb->left;
+
+	/* largest first */
+	return (na > nb) ? -1 : ((na < nb) ? 1 : 0);
+}
+
+static void *mk_qsort_worker(void *arg)
+{
+	MKQSortPool *pool = (MKQSortPool *) arg;
+
+	for (;;)
+	{
+		MKQSortTask *task = NULL;
+
+		pthread_mutex_lock(&pool->lock);
+		if (pool->next < pool->ntasks)
+			task = &pool->tasks[pool->next++];
+		pthread_mutex_unlock(&pool->lock);
+
+		if (task == NULL)
+			break;
+
+		mk_qsort_rec(pool->a, task->left, task->right, task->lv, task->lvdown,
+					 pool->ctxt, task->seenNull, true);
+	}
+
+	return NULL;
+}
+
+/*
+ * Entry point of a worker thread: block the signals the backend handles,
+ * so that their handlers don't run on this thread, then take tasks.
+ */
+static void *mk_qsort_worker_thread(void *arg)
+{
+	gp_set_thread_sigmasks();
+
+	return mk_qsort_worker(arg);
+}
+
+static void mk_qsort_add_task(MKQSortPool *pool, int left, int right, int lv, bool lvdown, bool seenNull)
+{
+	MKQSortTask *task;
+
+	if (right <= left)
+		return;
+
+	task = &pool->tasks[pool->ntasks++];
+	task->left = left;
+	task->right = right;
+	task->lv = lv;
+	task->lvdown = lvdown;
+	task->seenNull = seenNull;
+}
+
+/*
+ * Sort with up to nthreads threads besides the backend, if the sort is big
+ * enough and mk_qsort_threadsafe allows it; else just mk_qsort.
+ *
+ * The ranges are the ones mk_qsort_impl would recurse into, so the result
+ * is the same as mk_qsort's.  The threads sort the array in place, so the
+ * sort needs no memory beyond what it already has.
+ */
+void mk_qsort_parallel(MKEntry *a, int n, MKContext *ctxt, int nthreads)
+{
+	MKQSortPool pool;
+	pthread_t *threads;
+	bool *started;
+	int maxtasks;
+	int i;
+
+	if (nthreads <= 0 || n < MKQS_PARALLEL_MIN || !mk_qsort_threadsafe(ctxt))
+	{
+		mk_qsort(a, n, ctxt);
+		return;
+	}
+
+	/* Each split replaces one task with at most three */
+	maxtasks = MKQS_TASKS_PER_THREAD * (nthreads + 1);
+	pool.a = a;
+	pool.ctxt = ctxt;
+	pool.tasks = (MKQSortTask *) palloc((maxtasks + 3) * sizeof(MKQSortTask));
+	pool.ntasks = 0;
+	pool.next = 0;
+
+	mk_qsort_add_task(&pool, 0, n - 1, 0, true, false);
+
+	while (pool.ntasks < maxtasks)
+	{
+		MKQSortTask task;
+		int largest = 0;
+		int lastInLow;
+		int firstInHigh;
+
+		for (i = 1; i < pool.ntasks; i++)
+		{
+			if (pool.tasks[i].right - pool.tasks[i].left >
+				pool.tasks[largest].right - pool.tasks[largest].left)
+				largest = i;
+		}
+
+		if (pool.ntasks == 0 ||
+			pool.tasks[largest].right - pool.tasks[largest].left < MKQS_MIN_TASK)
+			break;
+
+		CHECK_FOR_INTERRUPTS();
+
+		task = pool.tasks[largest];
+		pool.tasks[largest] = pool.tasks[--pool.ntasks];
+
+		if (task.lvdown)
+			mk_prepare_array(a, task.left, task.right, task.lv, ctxt);
+		mk_qsort_part3(a, task.left, task.right, task.lv, ctxt, &lastInLow, &firstInHigh);
+
+		mk_qsort_add_task(&pool, task.left, lastInLow, task.lv, false, task.seenNull);
+		if (task.lv < ctxt->total_lv - 1)
+			mk_qsort_add_task(&pool, lastInLow + 1, firstInHigh - 1, task.lv + 1, true,
+							  task.seenNull || mke_is_null(a + lastInLow + 1));
+		mk_qsort_add_task(&pool, firstInHigh, task.right, task.lv, false, task.seenNull);
+	}
+
+	qsort(pool.tasks, pool.ntasks, sizeof(MKQSortTask), mk_qsort_task_cmp);
+
+	pthread_mutex_init(&pool.lock, NULL);
+	threads = (pthread_t *) palloc(nthreads * sizeof(pthread_t));
+	started = (bool *) palloc0(nthreads * sizeof(bool));
+
+	for (i = 0; i < nthreads && i < pool.ntasks - 1; i++)
+		started[i] = (gp_pthread_create(&threads[i], mk_qsort_worker_thread, &pool,
+										"mk_qsort_parallel") == 0);
+
+	/* The backend takes tasks too, and picks up any a thread didn't start */
+	mk_qsort_worker(&pool);
+
+	for (i = 0; i < nthreads; i++)
+	{
+		if (started[i])
+			pthread_join(threads[i], NULL);
+	}
+	pthread_mutex_destroy(&pool.lock);
+
+	pfree(threads);
+	pfree(started);
+	pfree(pool.tasks);
+
+	CHECK_FOR_INTERRUPTS();
+}
+
 #ifdef MKQSORT_VERIFY 
 static int mkqsort_comp_entry_all_lv(MKEntry *a, MKEntry *b, MKContext *mkctxt)
 {
@@ -20,6 +20,11 @@
  */
 
 #include "postgres.h"
+
+#ifndef WIN32
+#include <sys/mman.h>
+#endif
+
 #include "access/heapam.h"
 #include "executor/instrument.h"
 #include "executor/execWorkfile.h"
@@ -57,6 +62,29 @@ typedef struct NTupleStorePage
 	NTupleStorePageSlotEntry slot[1];
 } NTupleStorePage;
 
+/*
+ * Pages are not palloc'd one by one, but carved from arenas: groups of
+ * pages allocated together, doubling in size from one page up to
+ * NTS_ARENA_MAX_BYTES.  This keeps a big store's pages close together and
+ * saves a palloc per page.  Arenas large enough to hold an aligned huge
+ * page are advised to be backed by huge pages, which cuts TLB misses when
+ * Material or Window nodes re-read their buffers.
+ *
+ * Pages are only given back when the store is destroyed.  A page dropped
+ * to shrink the store goes to the store's spare list, to be handed out
+ * before a new one is carved.
+ */
+#define NTS_HUGE_PAGE_SIZE (2 * 1024 * 1024)
+#define NTS_ARENA_MAX_BYTES (2 * NTS_HUGE_PAGE_SIZE)
+
+typedef struct NTupleStoreArena
+{
+	struct NTupleStoreArena *next;
+	int npages;		/* pages in the arena */
+	int nused;		/* pages carved so far */
+	NTupleStorePage *pages;
+} NTupleStoreArena;
+
 typedef struct NTupleStoreLobRef
 {
 	int64 start;
@@ -165,6 +193,10 @@ struct NTupleStore
 	NTupleStorePage *last_page;     	/* last page */
 	NTupleStorePage *first_free_page; 	/* free page, cached to save palloc */
 
+	NTupleStoreArena *arenas;			/* arenas pages are carved from, newest first */
+	NTupleStorePage *spare_pages;		/* carved pages not counted in page_cnt */
+	int arena_page_cnt;					/* pages in all arenas */
+
 	long first_ondisk_blockn;           /* first blockn that is written to disk */
 	int rwflag;  /* if I am ordinary store, or a reader, or a writer of readerwriter (share input) */
 
@@ -172,6 +204,13 @@ struct NTupleStore
 	bool workfiles_created; /* set if the operator created workfiles */
 	workfile_set *work_set; /* workfile set to use when using workfile manager */
 
+	/*
+	 * Reader of a store published in shared memory by its writer, see
+	 * ntuplestore_create_block_reader: the blocks, and how many there are.
+	 */
+	const char *blocks;
+	int nblocks;
+
 	ExecWorkFile *pfile; 	/* underlying backed file */
 	ExecWorkFile *plobfile;  /* underlying backed file for lobs (entries does not fit one page) */
 	int64     lobbytes;  /* number of bytes written to lob file */
@@ -318,6 +357,20 @@ static bool ntsReadBlock(NTupleStore *ts, int blockn, NTupleStorePage *page)
 {
 	long diskblockn = blockn - ts->first_ondisk_blockn;
 
+	if(ts->blocks)
+	{
+		if(blockn < 0 || blockn >= ts->nblocks)
+			return false;
+		memcpy(page, ts->blocks + (Size) blockn * BLCKSZ, BLCKSZ);
+		Assert(nts_page_blockn(page) == blockn);
+
+		nts_page_set_pin_cnt(page, 0);
+		nts_page_set_prev(page, NULL);
+		nts_page_set_next(page, NULL);
+
+		return true;
+	}
+
 	if(!ts->pfile)
 		return false;
 	
@@ -366,6 +419,72 @@ static bool ntsWriteBlock(NTupleStore *ts, NTupleStorePage *page)
 	return true;
 }
 
+/* Start a new arena, twice as big as the last one, within the store's limits */
+static NTupleStoreArena *nts_new_arena(NTupleStore *nts)
+{
+	NTupleStoreArena *arena;
+	int npages = 1;
+	Size bytes;
+
+	if(gp_tuplestore_arena && nts->arenas)
+	{
+		npages = Min(nts->arenas->npages * 2, NTS_ARENA_MAX_BYTES / (int) sizeof(NTupleStorePage));
+		npages = Min(npages, nts->page_max - nts->arena_page_cnt);
+		npages = Max(npages, 1);
+	}
+
+	bytes = (Size) npages * sizeof(NTupleStorePage);
+	arena = (NTupleStoreArena *) MemoryContextAlloc(nts->mcxt, MAXALIGN(sizeof(NTupleStoreArena)) + bytes);
+	arena->pages = (NTupleStorePage *) ((char *) arena + MAXALIGN(sizeof(NTupleStoreArena)));
+	arena->npages = npages;
+	arena->nused = 0;
+
+#if defined(MADV_HUGEPAGE)
+	if(bytes >= NTS_HUGE_PAGE_SIZE)
+	{
+		char *start = (char *) TYPEALIGN(NTS_HUGE_PAGE_SIZE, arena->pages);
+		char *end = (char *) TYPEALIGN_DOWN(NTS_HUGE_PAGE_SIZE, (char *) arena->pages + bytes);
+
+		/* Only a hint; the arena works the same without huge pages */
+		if(end > start)
+			(void) madvise(start, end - start, MADV_HUGEPAGE);
+	}
+#endif
+
+	arena->next = nts->arenas;
+	nts->arenas = arena;
+	nts->arena_page_cnt += npages;
+
+	return arena;
+}
+
+/* Allocate a page, from the spare list or the newest arena */
+static NTupleStorePage *nts_alloc_page(NTupleStore *nts)
+{
+	NTupleStoreArena *arena = nts->arenas;
+
+	if(nts->spare_pages)
+	{
+		NTupleStorePage *page = nts->spare_pages;
+
+		nts->spare_pages = nts_page_next(page);
+		return page;
+	}
+
+	if(!arena || arena->nused == arena->npages)
+		arena = nts_new_arena(nts);
+
+	return &arena->pages[arena->nused++];
+}
+
+/* Initialize the page allocation state of a new store */
+static void nts_init_arenas(NTupleStore *nts)
+{
+	nts->arenas = NULL;
+	nts->spare_pages = NULL;
+	nts->arena_page_cnt = 0;
+}
+
 /* Put a page onto the free list.  Do not increase nts->page_cnt */
 static void nts_return_free_page(NTupleStore *nts, NTupleStorePage *page)
 {
@@ -398,7 +517,7 @@ static NTupleStorePage *nts_get_free_page(NTupleStore *nts)
 
 	if(nts->page_cnt >= page_max)
 	{
-		if(!nts->pfile)
+		if(!nts->pfile && !nts->blocks)
 		{
 			if (nts->work_set != NULL)
 			{
@@ -441,7 +560,7 @@ static NTupleStorePage *nts_get_free_page(NTupleStore *nts)
 
 				if(nts->page_cnt >= page_max)
 				{
-					pfree(page_next);
+					nts->spare_pages = NTS_PREPEND_1(nts->spare_pages, page_next);
 					--nts->page_cnt;
 				}
 				else
@@ -463,7 +582,7 @@ static NTupleStorePage *nts_get_free_page(NTupleStore *nts)
 	}
 
 	Assert(page_next == NULL && nts->page_cnt < page_max);
-	page = (NTupleStorePage *) MemoryContextAlloc(nts->mcxt, sizeof(NTupleStorePage));
+	page = nts_alloc_page(nts);
 	init_page(page);
 	++nts->page_cnt;
 
@@ -594,7 +713,7 @@ static NTupleStorePage *nts_load_prev_page(NTupleStore *store, NTupleStorePage *
 void
 ntuplestore_destroy(NTupleStore *ts)
 {
-	NTupleStorePage *p = ts->first_page;
+	NTupleStoreArena *arena = ts->arenas;
 	ListCell *cell;
 
 	/* For each accessor, we mark it has no owning store. */
@@ -605,19 +724,12 @@ ntuplestore_destroy(NTupleStore *ts)
 		acc->page = NULL;
 	}
 
-	while(p)
-	{
-		NTupleStorePage *pnext = nts_page_next(p); 
-		pfree(p);
-		p = pnext;
-	}
-
-	p = ts->first_free_page;
-	while(p)
+	/* Every page, in use, free or spare, lives in an arena */
+	while(arena)
 	{
-		NTupleStorePage *pnext = nts_page_next(p); 
-		pfree(p);
-		p = pnext;
+		NTupleStoreArena *next = arena->next;
+		pfree(arena);
+		arena = next;
 	}
 
 	if(ts->pfile)
@@ -649,6 +761,9 @@ ntuplestore_create(int64 maxBytes)
 	store->pfile = NULL;
 	store->first_ondisk_blockn = 0;
 
+	store->blocks = NULL;
+	store->nblocks = 0;
+
 	store->plobfile = NULL;
 	store->lobbytes = 0;
 
@@ -661,7 +776,8 @@ ntuplestore_create(int64 maxBytes)
 	if(store->page_max < 16)
 		store->page_max = 16;
 
-	store->first_page = (NTupleStorePage *) MemoryContextAlloc(store->mcxt, sizeof(NTupleStorePage));
+	nts_init_arenas(store);
+	store->first_page = nts_alloc_page(store);
 	init_page(store->first_page);
 	nts_page_set_blockn(store->first_page, 0);
 
@@ -717,6 +833,8 @@ ntuplestore_create_readerwriter(const char *filename, int64 maxBytes, bool isWri
 		store->mcxt = CurrentMemoryContext;
 		store->work_set = NULL;
 		store->workfiles_created = false;
+		store->blocks = NULL;
+		store->nblocks = 0;
 
 		store->pfile = ExecWorkFile_Open(filenameprefix, BUFFILE,
 				false /* delOnClose */,
@@ -731,6 +849,78 @@ ntuplestore_create_readerwriter(const char *filename, int64 maxBytes, bool isWri
 	return store;
 }
 
+/*
+ * Initialize a reader of a store that its writer copied out with
+ * ntuplestore_copy_blocks.  The blocks are read from the given memory
+ * instead of files; the memory must stay valid until the store is destroyed.
+ */
+NTupleStore *
+ntuplestore_create_block_reader(const char *blocks, int nblocks)
+{
+	NTupleStore *store = (NTupleStore *) palloc(sizeof(NTupleStore));
+
+	store->mcxt = CurrentMemoryContext;
+	store->work_set = NULL;
+	store->workfiles_created = false;
+	store->pfile = NULL;
+	store->plobfile = NULL;
+	store->blocks = blocks;
+	store->nblocks = nblocks;
+
+	ntuplestore_init_reader(store, 0);
+
+	return store;
+}
+
+/*
+ * Number of blocks of a readerwriter store's writer, if all of them are
+ * still in memory and no tuple went to the lob file, so that the store can
+ * be handed to readers with ntuplestore_copy_blocks.  Otherwise -1.
+ */
+int
+ntuplestore_inmem_blocks(NTupleStore *ts)
+{
+	NTupleStorePage *p;
+	long blockn = 0;
+
+	Assert(ts->rwflag == NTS_IS_WRITER);
+
+	if(ts->lobbytes != 0)
+		return -1;
+
+	for(p = ts->first_page; p; p = nts_page_next(p))
+	{
+		if(nts_page_blockn(p) != blockn)
+			return -1;
+		++blockn;
+	}
+
+	return (int) blockn;
+}
+
+/*
+ * Copy the blocks counted by ntuplestore_inmem_blocks to dest, laid out
+ * the way ntsWriteBlock would write them to the file.
+ */
+void
+ntuplestore_copy_blocks(NTupleStore *ts, char *dest)
+{
+	NTupleStorePage *p;
+
+	for(p = ts->first_page; p; p = nts_page_next(p))
+	{
+		NTupleStorePage *copy = (NTupleStorePage *) dest;
+
+		memcpy(copy, p, BLCKSZ);
+		nts_page_set_dirty(copy, false);
+		nts_page_set_pin_cnt(copy, 0);
+		nts_page_set_prev(copy, NULL);
+		nts_page_set_next(copy, NULL);
+
+		dest += BLCKSZ;
+	}
+}
+
 /*
  * Initializes a ntuplestore based on existing files.
  *
@@ -740,8 +930,8 @@ static void
 ntuplestore_init_reader(NTupleStore *store, int maxBytes)
 {
 	Assert(NULL != store);
-	Assert(NULL != store->pfile);
-	Assert(NULL != store->plobfile);
+	Assert(NULL != store->blocks || NULL != store->pfile);
+	Assert(NULL != store->blocks || NULL != store->plobfile);
 	
 	store->first_ondisk_blockn = 0;
 	store->rwflag = NTS_IS_READER;
@@ -753,7 +943,8 @@ ntuplestore_init_reader(NTupleStore *store, int maxBytes)
 	if(store->page_max < 16)
 		store->page_max = 16;
 
-	store->first_page = (NTupleStorePage *) MemoryContextAlloc(store->mcxt, sizeof(NTupleStorePage));
+	nts_init_arenas(store);
+	store->first_page = nts_alloc_page(store);
 	init_page(store->first_page);
 
 	bool fOK = ntsReadBlock(store, 0, store->first_page);
@@ -1460,12 +1651,44 @@ ntuplestore_create_spill_files(NTupleStore *nts)
 	Assert(nts->work_set != NULL);
 
 	MemoryContext   oldcxt;
+	ResourceOwner   oldowner;
 	oldcxt = MemoryContextSwitchTo(TopMemoryContext);
 
+	/* The files belong to the same resource owner as their set */
+	oldowner = CurrentResourceOwner;
+	CurrentResourceOwner = nts->work_set->owner;
+
 	nts->pfile = workfile_mgr_create_fileno(nts->work_set, WORKFILE_NUM_TUPLESTORE_DATA);
 	nts->plobfile = workfile_mgr_create_fileno(nts->work_set, WORKFILE_NUM_TUPLESTORE_LOB);
 
+	CurrentResourceOwner = oldowner;
 	MemoryContextSwitchTo(oldcxt);
 }
 
+/*
+ * Did the tuplestore spill to workfiles of its workfile set?
+ */
+bool
+ntuplestore_has_workfiles(NTupleStore *ts)
+{
+	return ts->work_set != NULL && ts->pfile != NULL;
+}
+
+/*
+ * Keep a spilled tuplestore, and its workfile set, past the end of the
+ * query that wrote it.  The tuplestore and set must have been created in a
+ * memory context and resource owner that outlive the query; this takes
+ * the files out of the query's workfile accounting and drops the pointer
+ * to the query's instrumentation.
+ */
+void
+ntuplestore_keep_workfiles(NTupleStore *ts)
+{
+	Assert(ntuplestore_has_workfiles(ts));
+
+	ts->instrument = NULL;
+	workfile_mgr_set_outlives_query(ts->work_set,
+									ts->plobfile != NULL ? 2 : 1);
+}
+
 /* EOF */
@@ -157,11 +157,15 @@ adjust_size_temp_file_new(workfile_set *work_set, int64 size)
 	 */
 	workfile_set_update_in_progress_size(work_set, -size);
 
-	WorkfileDiskspace_Commit(0 /* commit_bytes */, size, true /* update_query_size */);
+	/* A set kept past its query was already taken out of the query's counts */
+	bool update_query_space = (NULL == work_set) || !work_set->outlives_query;
+
+	WorkfileDiskspace_Commit(0 /* commit_bytes */, size, update_query_space);
 	elog(gp_workfile_caching_loglevel, "closed and deleted temp file, subtracted size " INT64_FORMAT " from disk space", size);
 
 	/* About to physically delete a file we created. Update the per-query file count as well */
-	WorkfileQueryspace_SubtractWorkfile(1 /* nFiles */);
+	if (update_query_space)
+		WorkfileQueryspace_SubtractWorkfile(1 /* nFiles */);
 }
 
 /*
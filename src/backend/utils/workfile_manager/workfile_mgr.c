@@ -17,9 +17,11 @@
 
 #include <unistd.h>
 #include <sys/stat.h>
+#include <sys/statvfs.h>
 
 #include "utils/workfile_mgr.h"
 #include "miscadmin.h"
+#include "cdb/cdbqueryhistory.h"
 #include "cdb/cdbvars.h"
 #include "nodes/print.h"
 #include "utils/builtins.h"
@@ -53,6 +55,10 @@ static void workfile_mgr_unlink_directory(const char *dirpath);
 static StringInfo get_name_from_nodeType(const NodeTag node_type);
 static uint64 get_operator_work_mem(PlanState *ps);
 static char *create_workset_directory(NodeTag node_type, int slice_id);
+static char *choose_spill_location(void);
+
+/* Next spill location to try within a tier, see choose_spill_location() */
+static uint32 spill_location_next = 0;
 
 static workfile_set *open_workfile_sets = NULL;
 static bool workfile_sets_resowner_callback_registered = false;
@@ -176,6 +182,9 @@ get_name_from_nodeType(const NodeTag node_type)
 		case T_SortState:
 			appendStringInfoString(operator_name,"Sort");
 			break;
+		case T_SetOpState:
+			appendStringInfoString(operator_name,"SetOp");
+			break;
 		case T_Invalid:
 			/* When spilling from a builtin function, we don't have a valid node type */
 			appendStringInfoString(operator_name,"BuiltinFunction");
@@ -269,6 +278,52 @@ workfile_mgr_create_set(enum ExecWorkFileType type, bool can_be_reused, PlanStat
 static char *
 create_workset_directory(NodeTag node_type, int slice_id)
 {
+	char *spill_dir = choose_spill_location();
+
+	if (spill_dir != NULL)
+	{
+		/*
+		 * Spill location: the set lives in its pgsql_tmp directory, and the
+		 * set's path stays absolute so that fd.c doesn't prefix it.
+		 */
+		StringInfo operator_name = get_name_from_nodeType(node_type);
+		StringInfo workset_path_masked = makeStringInfo();
+		char *final_path;
+		char *workset_path_unmasked;
+
+		appendStringInfo(workset_path_masked,
+				"%s/%s_%s_Slice%d.%s",
+				 spill_dir,
+				 WORKFILE_SET_PREFIX,
+				 operator_name->data,
+				 slice_id,
+				 WORKFILE_SET_MASK);
+
+		if (workset_path_masked->len >= MAXPGPATH)
+		{
+			ereport(ERROR, (errmsg("cannot generate path %s", workset_path_masked->data)));
+		}
+
+		workset_path_unmasked = gp_mkdtemp(workset_path_masked->data);
+		if (workset_path_unmasked == NULL)
+		{
+			ereport(ERROR,
+					(errcode(ERRCODE_IO_ERROR),
+					errmsg("could not create spill file directory: %m")));
+		}
+
+		final_path = (char *) palloc0(MAXPGPATH);
+		strlcpy(final_path, workset_path_unmasked, MAXPGPATH);
+
+		pfree(workset_path_masked->data);
+		pfree(workset_path_masked);
+		pfree(operator_name->data);
+		pfree(operator_name);
+		pfree(spill_dir);
+
+		return final_path;
+	}
+
 	/* Create base directory here. We need database relative path */
 	StringInfo tmp_dirpath = makeStringInfo();
 
@@ -342,6 +397,143 @@ create_workset_directory(NodeTag node_type, int slice_id)
 	return final_path;
 }
 
+/*
+ * Returns the pgsql_tmp directory of this segment in a spill location,
+ * palloc-ed in the current memory context.  Segments on a host can share
+ * the locations, so each gets its own directory, named by dbid.
+ */
+char *
+workfile_mgr_spill_location_tmpdir(const char *location)
+{
+	char *path = (char *) palloc(MAXPGPATH);
+
+	if (snprintf(path, MAXPGPATH, "%s/%s_dbid%d",
+				 location, PG_TEMP_FILES_DIR, GpIdentity.dbid) >= MAXPGPATH)
+	{
+		ereport(ERROR, (errmsg("cannot generate path %s/%s_dbid%d",
+				location, PG_TEMP_FILES_DIR, GpIdentity.dbid)));
+	}
+
+	return path;
+}
+
+/*
+ * Splits gp_workfile_spill_locations into tiers.  Returns a List of
+ * tiers, fastest first, each a List of directory names.  The names point
+ * into a palloc-ed copy of the setting.
+ */
+List *
+workfile_mgr_spill_locations(void)
+{
+	List *tiers = NIL;
+	char *rawstring;
+	char *tier_str;
+	char *tier_save = NULL;
+
+	if (gp_workfile_spill_locations == NULL || gp_workfile_spill_locations[0] == '\0')
+		return NIL;
+
+	rawstring = pstrdup(gp_workfile_spill_locations);
+
+	for (tier_str = strtok_r(rawstring, ";", &tier_save);
+		 tier_str != NULL;
+		 tier_str = strtok_r(NULL, ";", &tier_save))
+	{
+		List *tier = NIL;
+		char *dir;
+		char *dir_save = NULL;
+
+		for (dir = strtok_r(tier_str, ",", &dir_save);
+			 dir != NULL;
+			 dir = strtok_r(NULL, ",", &dir_save))
+		{
+			char *end;
+
+			while (isspace((unsigned char) *dir))
+				dir++;
+			end = dir + strlen(dir);
+			while (end > dir && isspace((unsigned char) end[-1]))
+				*--end = '\0';
+
+			if (*dir != '\0')
+				tier = lappend(tier, dir);
+		}
+
+		if (tier != NIL)
+			tiers = lappend(tiers, tier);
+	}
+
+	return tiers;
+}
+
+/*
+ * Picks the spill location for a new workfile set, and returns its
+ * pgsql_tmp directory, or NULL to use the temporary filespace.
+ *
+ * Tiers are tried fastest first.  Within a tier the sets of this backend
+ * go round-robin over the locations, starting at a place that depends on
+ * the pid so that backends spread over the devices too.  A location is
+ * passed over when its file system has less than
+ * gp_workfile_spill_location_min_free left, or can't be used at all, so
+ * spills move on to the next tier as the fast devices fill up.
+ */
+static char *
+choose_spill_location(void)
+{
+	List *tiers = workfile_mgr_spill_locations();
+	ListCell *lc;
+	char *result = NULL;
+
+	if (tiers == NIL)
+		return NULL;
+
+	if (spill_location_next == 0)
+		spill_location_next = (uint32) MyProcPid;
+
+	foreach(lc, tiers)
+	{
+		List *tier = (List *) lfirst(lc);
+		int ndirs = list_length(tier);
+		int i;
+
+		for (i = 0; i < ndirs && result == NULL; i++)
+		{
+			char *location = (char *) list_nth(tier, (spill_location_next + i) % ndirs);
+			char *tmpdir;
+			struct statvfs fs;
+
+			if (statvfs(location, &fs) != 0)
+			{
+				elog(gp_workfile_caching_loglevel, "skipping spill location %s: %m", location);
+				continue;
+			}
+
+			if ((double) fs.f_bavail * fs.f_frsize <
+				(double) gp_workfile_spill_location_min_free * 1024.0)
+			{
+				elog(gp_workfile_caching_loglevel, "skipping spill location %s: file system is full", location);
+				continue;
+			}
+
+			/* Don't check for error from mkdir, gp_mkdtemp will report it */
+			tmpdir = workfile_mgr_spill_location_tmpdir(location);
+			mkdir(tmpdir, S_IRWXU);
+			result = tmpdir;
+		}
+
+		if (result != NULL)
+			break;
+	}
+
+	spill_location_next++;
+
+	foreach(lc, tiers)
+		list_free((List *) lfirst(lc));
+	list_free(tiers);
+
+	return result;
+}
+
 /*
  * SharedCache callback. Populates a newly acquired workfile_set before
  * returning it to the caller.
@@ -368,6 +560,7 @@ workfile_mgr_populate_set(const void *resource, const void *param)
 	work_set->session_id = gp_session_id;
 	work_set->command_count = gp_command_count;
 	work_set->session_start_time = set_info->session_start_time;
+	work_set->outlives_query = false;
 
 	work_set->owner = CurrentResourceOwner;
 	work_set->next = open_workfile_sets;
@@ -410,6 +603,13 @@ get_operator_work_mem(PlanState *ps)
 static void
 workfile_mgr_delete_set_directory(char *workset_path)
 {
+	/* Sets in a spill location have an absolute path */
+	if (is_absolute_path(workset_path))
+	{
+		workfile_mgr_unlink_directory(workset_path);
+		return;
+	}
+
 	/* Add filespace prefix to path */
 	char *reldirpath = (char*)palloc(PATH_MAX);
 	if (snprintf(reldirpath, PATH_MAX, "%s/%s", getCurrentTempFilePath, workset_path) > PATH_MAX)
@@ -481,7 +681,8 @@ workfile_mgr_cleanup_set(const void *resource)
 	 * In that case, the state is ACQUIRED, otherwise is CACHED or DELETED
 	 */
 	CacheEntry *cacheEntry = CACHE_ENTRY_HEADER(resource);
-	bool update_query_space = (cacheEntry->state == CACHE_ENTRY_ACQUIRED);
+	bool update_query_space = (cacheEntry->state == CACHE_ENTRY_ACQUIRED) &&
+		!work_set->outlives_query;
 
 	WorkfileDiskspace_Commit(0, size_to_delete, update_query_space);
 }
@@ -530,6 +731,10 @@ workfile_mgr_cleanup(void)
 void
 workfile_set_update_in_progress_size(workfile_set *work_set, int64 size)
 {
+	/* Only growth counts as spilling, shrinking is files being deleted */
+	if (size > 0)
+		QueryHistoryCountSpill(NULL != work_set ? work_set->node_type : T_Invalid, size);
+
 	if (NULL != work_set)
 	{
 		work_set->in_progress_size += size;
@@ -542,6 +747,25 @@ workfile_set_update_in_progress_size(workfile_set *work_set, int64 size)
 	}
 }
 
+/*
+ * Takes a workfile set, and the nfiles files it holds, out of the per-query
+ * accounting of the current query, so that it can be kept and closed by a
+ * later query of the transaction.  Its space stays counted in the
+ * per-segment total until it is closed.
+ */
+void
+workfile_mgr_set_outlives_query(workfile_set *work_set, int nfiles)
+{
+	Assert(NULL != work_set);
+	Assert(!work_set->outlives_query);
+
+	if (gp_workfile_limit_per_query > 0)
+		WorkfileQueryspace_Commit(0 /* commit_bytes */, work_set->in_progress_size);
+	WorkfileQueryspace_SubtractWorkfile(nfiles);
+
+	work_set->outlives_query = true;
+}
+
 /*
  * Reports corresponding error message when the query or segment size limit is exceeded.
  */
@@ -12,6 +12,9 @@
 #include <apr_hash.h>
 #include <apr_pools.h>
 #include <apr_strings.h>
+#include <apr_thread_cond.h>
+#include <apr_thread_mutex.h>
+#include <apr_thread_proc.h>
 #include <apr_time.h>
 #include <event.h>
 #include <fcntl.h>
@@ -52,6 +55,9 @@
 
 #include <pg_config.h>
 #include "gpfdist_helper.h"
+#ifdef HAVE_LIBZSTD
+#include <zstd.h>
+#endif
 #ifdef USE_SSL
 #include <openssl/ssl.h>
 #include <openssl/rand.h>
@@ -120,6 +126,10 @@ static void flush_ssl_buffer(int fd, short event, void* arg);
  not property terminated, then gpfdist encountered some error, and caller
  should check the gpfdist error log.
 
+ A client that sends X-GP-ZSTD may also get 'Z' blocks instead of 'D'
+ blocks: the data compressed as one zstd frame. A block that doesn't get
+ any smaller is still sent as a 'D' block, and so is the final one.
+
  **************/
 
 typedef struct gnet_request_t gnet_request_t;
@@ -147,6 +157,9 @@ static void percent_encoding_to_char(char* p, char* pp, char* path);
 #define GPFDIST_MAX_LINE_MESSAGE     "Error: -m max row length must be between 32KB and 1MB"
 #endif
 
+#define GPFDIST_MAX_READ_AHEAD 64	/* max --read-ahead blocks */
+#define GPFDIST_ZSTD_LEVEL 1		/* zstd level of compressed blocks, favors speed */
+
 
 /*	Struct of command line options */
 static struct
@@ -170,7 +183,8 @@ static struct
 	const char* ssl; /* path to certificates in case we use gpfdist with ssl */
 	int 		sslclean; /* Defines the time to wait [sec] until cleanup the SSL resources (internal, not documented) */
 	int			w; /* The time used for session timeout in seconds */
-} opt = { 8080, 8080, 0, 0, 0, ".", 0, 0, -1, 5, 0, 32768, 0, 256, 0, 0, 0, 0, 0 };
+	int			a; /* # blocks a thread reads ahead per session, 0 for none */
+} opt = { 8080, 8080, 0, 0, 0, ".", 0, 0, -1, 5, 0, 32768, 0, 256, 0, 0, 0, 0, 0, 0 };
 
 
 typedef union address
@@ -205,6 +219,40 @@ static struct
 #endif
 } gcb;
 
+/*
+ * Read ahead of a GET session. A thread reads, decompresses and splits
+ * into whole rows the next blocks of the session's fstream, while the event
+ * loop sends the ones read before. Slots head .. head + count - 1 of the
+ * ring are ready to be sent; the thread fills the one after them. A block
+ * of size 0 marks EOF, and one of size < 0 an error, after which the thread
+ * exits.
+ */
+typedef struct readahead_block_t readahead_block_t;
+struct readahead_block_t
+{
+	char*			data;
+	int				size;
+	struct fstream_filename_and_offset fos;
+	apr_int64_t		read_bytes;		/* compressed bytes it took */
+};
+
+typedef struct readahead_t readahead_t;
+struct readahead_t
+{
+	apr_thread_t*		thread;
+	apr_thread_mutex_t*	mutex;
+	apr_thread_cond_t*	not_empty;
+	apr_thread_cond_t*	not_full;
+	readahead_block_t*	blocks;
+	int					nblocks;
+	int					head;
+	int					count;
+	int					stop;		/* set by the event loop to end the thread */
+	char*				line_delim_str;
+	int					line_delim_length;
+	char				error[256];
+};
+
 /*  A session */
 typedef struct session_t session_t;
 struct session_t
@@ -228,6 +276,7 @@ struct session_t
 	struct timeval 	tm;             /* timeout for struct event */
 	struct event   	ev;             /* event we are watching for this session*/
 	apr_hash_t		*requests;
+	readahead_t*	readahead;		/* NULL if not reading ahead */
 };
 
 /*  An http request */
@@ -281,6 +330,14 @@ struct request_t
 	} in;
 
 	block_t	outblock;	/* next block to send out */
+#ifdef HAVE_LIBZSTD
+	struct
+	{
+		ZSTD_CCtx*	cctx;	/* compression context, NULL if not asked for */
+		char*		buf;	/* compressed copy of outblock */
+		size_t		bufmax;	/* size of buf[] */
+	} zstd;
+#endif
 	char*           line_delim_str;
 	int             line_delim_length;
 
@@ -358,6 +415,8 @@ static void setup_flush_ssl_buffer(request_t* r);
 static void request_cleanup_and_free_SSL_resources(int fd, short event, void* arg);
 #endif
 static int local_send(request_t *r, const char* buf, int buflen);
+static void readahead_start(session_t* session, const request_t* r);
+static void readahead_stop(session_t* session);
 
 static int get_unsent_bytes(request_t* r);
 
@@ -436,6 +495,51 @@ static void block_fill_header(const request_t *r, block_t* b,
 	gdebug(r, "header size: %d",h->htop-h->hbot);
 }
 
+#ifdef HAVE_LIBZSTD
+/*
+ * block_compress
+ *
+ * Compress the data of a block for a client that asked for zstd compressed
+ * blocks, and turn its 'D' header into a 'Z' one. The block is left alone if
+ * it doesn't get any smaller. The compressed data is smaller than the block
+ * buffer then, so it is copied back there and sent as usual.
+ */
+static void block_compress(request_t *r, block_t* b)
+{
+	blockhdr_t*		h = &b->hdr;
+	apr_int32_t		len;
+	size_t			n;
+
+	n = ZSTD_compressCCtx(r->zstd.cctx, r->zstd.buf, r->zstd.bufmax,
+						  b->data + b->bot, b->top - b->bot,
+						  GPFDIST_ZSTD_LEVEL);
+	if (ZSTD_isError(n))
+	{
+		gwarning(r, "zstd compression failed, sending block uncompressed: %s",
+				 ZSTD_getErrorName(n));
+		return;
+	}
+	if (n >= (size_t) (b->top - b->bot))
+		return;
+
+	memcpy(b->data, r->zstd.buf, n);
+	b->bot = 0;
+	b->top = (int) n;
+
+	/* DATA is always the last entry of the header */
+	h->hbyte[h->htop - 5] = 'Z';
+	len = htonl(b->top);
+	memcpy(h->hbyte + h->htop - 4, &len, 4);
+	gdebug(r, "Z %d", b->top);
+}
+
+static apr_status_t zstd_cctx_cleanup(void* cctx)
+{
+	ZSTD_freeCCtx((ZSTD_CCtx*) cctx);
+	return APR_SUCCESS;
+}
+#endif
+
 static unsigned short get_client_port(address_t *clientInformation)
 {
 	//check the family version of client IP address, so you
@@ -502,6 +606,7 @@ static void usage_error(const char* msg, int print_usage)
 						"        -l logfn   : log filename\n"
 						"        -t tm      : timeout in seconds \n"
 						"        -m maxlen  : max data row length expected, in bytes. default is 32768\n"
+						"        --read-ahead n : read n blocks ahead of the network in a thread per session, default is 0\n"
 #ifdef USE_SSL
 						"        --ssl dir  : start HTTPS server. Use the certificates from the specified directory\n"
 #endif
@@ -568,6 +673,7 @@ static void parse_command_line(int argc, const char* const argv[],
 	{ NULL, 'z', 1, "internal - queue size for listen call" },
 	{ "ssl", 257, 1, "ssl - certificates files under this directory" },
 	{ "sslclean", 258, 1, "Defines the time to wait [sec] until cleanup of the SSL resources" },
+	{ "read-ahead", 259, 1, "blocks to read ahead in a thread per session" },
 #ifdef GPFXDIST
 	{ NULL, 'c', 1, "transform configuration file" },
 #endif
@@ -655,6 +761,9 @@ static void parse_command_line(int argc, const char* const argv[],
 			usage_error("SSL is not supported by this build", 0);
 			break;
 #endif
+		case 259:
+			opt.a = atoi(arg);
+			break;
 		case 256:
 			print_version();
 			break;
@@ -686,6 +795,9 @@ static void parse_command_line(int argc, const char* const argv[],
     if (! ((GPFDIST_MAX_LINE_LOWER_LIMIT <= opt.m) && (opt.m <= GPFDIST_MAX_LINE_UPPER_LIMIT)))
     	usage_error(GPFDIST_MAX_LINE_MESSAGE, 0);
 
+	if (opt.a < 0 || opt.a > GPFDIST_MAX_READ_AHEAD)
+		usage_error("Error: --read-ahead must be between 0 and 64 (default is 0)", 0);
+
     if (!is_valid_listen_queue_size(opt.z))
 		usage_error("Error: -z listen queue size must be between 16 and 512 (default is 256)", 0);
 
@@ -1276,6 +1388,176 @@ static void gp1_send_errfile(request_t* r, apr_file_t* errfile)
 }
 #endif
 
+/*
+ * readahead_main
+ *
+ * Body of the read ahead thread of a session. Touches nothing but the
+ * session's fstream and its read ahead ring; all the logging and session
+ * bookkeeping is left to the event loop.
+ */
+static void* APR_THREAD_FUNC readahead_main(apr_thread_t* thread, void* arg)
+{
+	session_t*		session = (session_t*) arg;
+	readahead_t*	ra = session->readahead;
+	const int 		whole_rows = 1; /* gpfdist must not read data with partial rows */
+
+	for (;;)
+	{
+		readahead_block_t*	b;
+		apr_int64_t			pos;
+
+		apr_thread_mutex_lock(ra->mutex);
+		while (ra->count == ra->nblocks && !ra->stop)
+			apr_thread_cond_wait(ra->not_full, ra->mutex);
+		if (ra->stop)
+		{
+			apr_thread_mutex_unlock(ra->mutex);
+			break;
+		}
+		b = &ra->blocks[(ra->head + ra->count) % ra->nblocks];
+		apr_thread_mutex_unlock(ra->mutex);
+
+		memset(&b->fos, 0, sizeof(b->fos));
+		pos = fstream_get_compressed_position(session->fstream);
+		b->size = fstream_read(session->fstream, b->data, opt.m, &b->fos, whole_rows,
+							   ra->line_delim_str, ra->line_delim_length);
+		if (b->size == 0)
+			b->read_bytes = fstream_get_compressed_size(session->fstream) - pos;
+		else
+			b->read_bytes = fstream_get_compressed_position(session->fstream) - pos;
+		if (b->size < 0)
+			apr_cpystrn(ra->error, fstream_get_error(session->fstream), sizeof(ra->error));
+
+		apr_thread_mutex_lock(ra->mutex);
+		ra->count++;
+		apr_thread_cond_signal(ra->not_empty);
+		apr_thread_mutex_unlock(ra->mutex);
+
+		if (b->size <= 0)
+			break;
+	}
+
+	apr_thread_exit(thread, APR_SUCCESS);
+	return NULL;
+}
+
+/*
+ * readahead_start
+ *
+ * Start reading ahead in a GET session, if asked to. Falls back to reading
+ * in the event loop if the thread can't be started.
+ */
+static void readahead_start(session_t* session, const request_t* r)
+{
+	readahead_t*	ra;
+	int				i;
+
+	if (opt.a <= 0 || !session->is_get || session->readahead)
+		return;
+
+	ra = pcalloc_safe(NULL, session->pool, sizeof(readahead_t), "out of memory in readahead_start");
+	ra->nblocks = opt.a;
+	ra->blocks = pcalloc_safe(NULL, session->pool, sizeof(readahead_block_t) * ra->nblocks,
+							  "out of memory in readahead_start");
+	for (i = 0; i < ra->nblocks; i++)
+		ra->blocks[i].data = palloc_safe(NULL, session->pool, opt.m,
+										 "out of memory when allocating buffer: %d bytes", opt.m);
+	ra->line_delim_str = apr_pstrdup(session->pool, r->line_delim_str);
+	ra->line_delim_length = r->line_delim_length;
+
+	if (apr_thread_mutex_create(&ra->mutex, APR_THREAD_MUTEX_DEFAULT, session->pool) ||
+		apr_thread_cond_create(&ra->not_empty, session->pool) ||
+		apr_thread_cond_create(&ra->not_full, session->pool))
+	{
+		gwarning(r, "cannot create read ahead locks, reading in the event loop");
+		return;
+	}
+
+	session->readahead = ra;
+	if (apr_thread_create(&ra->thread, NULL, readahead_main, session, session->pool))
+	{
+		gwarning(r, "cannot create read ahead thread, reading in the event loop");
+		session->readahead = NULL;
+		return;
+	}
+
+	gprintlnif(r, "session reads %d blocks ahead", ra->nblocks);
+}
+
+/*
+ * readahead_stop
+ *
+ * End the read ahead thread of a session, before its fstream is closed.
+ * Waits for a read in progress to finish.
+ */
+static void readahead_stop(session_t* session)
+{
+	readahead_t*	ra = session->readahead;
+	apr_status_t	rv;
+
+	if (!ra)
+		return;
+
+	apr_thread_mutex_lock(ra->mutex);
+	ra->stop = 1;
+	apr_thread_cond_signal(ra->not_full);
+	apr_thread_mutex_unlock(ra->mutex);
+
+	apr_thread_join(&rv, ra->thread);
+	session->readahead = NULL;
+}
+
+/*
+ * readahead_get_block
+ *
+ * The read ahead version of session_get_block. Waits for the thread if it
+ * hasn't read the next block yet.
+ */
+static const char*
+readahead_get_block(const request_t* r, block_t* retblock)
+{
+	session_t*			session = r->session;
+	readahead_t*		ra = session->readahead;
+	readahead_block_t*	b;
+
+	apr_thread_mutex_lock(ra->mutex);
+	while (ra->count == 0)
+		apr_thread_cond_wait(ra->not_empty, ra->mutex);
+	b = &ra->blocks[ra->head];
+	apr_thread_mutex_unlock(ra->mutex);
+
+	gcb.read_bytes += b->read_bytes;
+
+	if (b->size == 0)
+	{
+		gprintln(NULL, "session_get_block: end session due to EOF");
+		session_end(session, 0);
+		return 0;
+	}
+
+	if (b->size < 0)
+	{
+		const char* ferror = apr_pstrdup(session->pool, ra->error);
+		gwarning(NULL, "session_get_block end session due to %s", ferror);
+		session_end(session, 1);
+		return ferror;
+	}
+
+	memcpy(retblock->data, b->data, b->size);
+	retblock->top = b->size;
+
+	/* fill the block header with meta data for the client to parse and use */
+	block_fill_header(r, retblock, &b->fos);
+
+	apr_thread_mutex_lock(ra->mutex);
+	ra->head = (ra->head + 1) % ra->nblocks;
+	ra->count--;
+	apr_thread_cond_signal(ra->not_full);
+	apr_thread_mutex_unlock(ra->mutex);
+
+	return 0;
+}
+
 /*
  * session_get_block
  *
@@ -1300,6 +1582,10 @@ session_get_block(const request_t* r, block_t* retblock, char* line_delim_str, i
 		return 0;
 	}
 
+	readahead_start(session, r);
+	if (session->readahead)
+		return readahead_get_block(r, retblock);
+
 	gcb.read_bytes -= fstream_get_compressed_position(session->fstream);
 
 	/* read data from our filestream as a chunk with whole data rows */
@@ -1340,6 +1626,8 @@ static void session_end(session_t* session, int error)
 	if (error)
 		session->is_error = error;
 
+	readahead_stop(session);
+
 	if (session->fstream)
 	{
 		fstream_close(session->fstream);
@@ -1352,6 +1640,8 @@ static void session_free(session_t* session)
 {
 	gprintln(NULL, "free session %s", session->key);
 
+	readahead_stop(session);
+
 	if (session->fstream)
 	{
 		fstream_close(session->fstream);
@@ -1744,6 +2034,10 @@ static void do_write(int fd, short event, void* arg)
 				request_end(r, 0, 0);
 				return;
 			}
+#ifdef HAVE_LIBZSTD
+			if (r->zstd.cctx)
+				block_compress(r, &r->outblock);
+#endif
 		}
 
 		datablock = &r->outblock;
@@ -3235,6 +3529,7 @@ static int request_parse_gp_headers(request_t *r, int opt_g)
 	const char* cid = 0;
 	const char* sn = 0;
 	const char* gp_proto = NULL; /* default to invalid, so that report error if not specified*/
+	int			zstd = 0;
 	int 		i;
 
 	r->csvopt = "";
@@ -3255,6 +3550,8 @@ static int request_parse_gp_headers(request_t *r, int opt_g)
 			gp_proto = r->in.req->hvalue[i];
 		else if (0 == strcmp("X-GP-DONE", r->in.req->hname[i]))
 			r->is_final = 1;
+		else if (0 == strcmp("X-GP-ZSTD", r->in.req->hname[i]))
+			zstd = atoi(r->in.req->hvalue[i]);
 		else if (0 == strcmp("X-GP-SEGMENT-COUNT", r->in.req->hname[i]))
 			r->totalsegs = atoi(r->in.req->hvalue[i]);
 		else if (0 == strcmp("X-GP-SEGMENT-ID", r->in.req->hname[i]))
@@ -3327,6 +3624,26 @@ static int request_parse_gp_headers(request_t *r, int opt_g)
 	if (opt_g != -1) /* override?  */
 		r->gp_proto = opt_g;
 
+#ifdef HAVE_LIBZSTD
+	if (zstd && r->gp_proto == 1)
+	{
+		r->zstd.cctx = ZSTD_createCCtx();
+		if (r->zstd.cctx)
+		{
+			apr_pool_cleanup_register(r->pool, r->zstd.cctx,
+									  zstd_cctx_cleanup, apr_pool_cleanup_null);
+			r->zstd.bufmax = ZSTD_compressBound(opt.m);
+			r->zstd.buf = palloc_safe(r, r->pool, r->zstd.bufmax,
+									  "out of memory when allocating r->zstd.buf: %d bytes",
+									  (int) r->zstd.bufmax);
+		}
+		else
+			gwarning(r, "could not create zstd context, sending blocks uncompressed");
+	}
+#else
+	(void) zstd;
+#endif
+
 	if (xid && cid && sn)
 	{
 		r->tid = apr_psprintf(r->pool, "%s.%s.%s.%d", xid, cid, sn, r->gp_proto);
@@ -298,6 +298,7 @@ usage(void)
 	printf(("                          or (i)ndividual segdb (must be followed with a list of dbid's\n"));
 	printf(("                          where backups are located. For example: --gp-l=i[10,12,15]\n"));
 	printf(("  --gp-f=FILE             FILE, present on all machines, with tables to include in restore\n"));
+	printf(("  --gp-nopostdata         do not restore the post-data items (indexes, constraints...)\n"));
 	printf(("  --prefix=PREFIX         PREFIX of the dump files to be restored\n"));
 	printf(("  --change-schema-file=SCHEMA_FILE  Schema file containing the name of the schema to which tables are to be restored\n"));
 	printf(("  --schema-level-file=SCHEMA_FILE  Schema file containing the name of the schemas under which all tables are to be restored\n"));
@@ -357,6 +358,7 @@ fillInputOptions(int argc, char **argv, InputOptions * pInputOpts)
 		{"change-schema-file", required_argument, NULL, 17},
 		{"schema-level-file", required_argument, NULL, 18},
 		{"old-format", no_argument, NULL, 20},
+		{"gp-nopostdata", no_argument, NULL, 21},
 		{NULL, 0, NULL, 0}
 	};
 
@@ -606,6 +608,10 @@ fillInputOptions(int argc, char **argv, InputOptions * pInputOpts)
 				g_is_old_format = true;
 				pInputOpts->pszPassThroughParms = addPassThroughLongParm("old-format", NULL, pInputOpts->pszPassThroughParms);
 				break;
+			case 21:
+				/* the caller restores the post-data items itself */
+				postdataRestore = false;
+				break;
 			default:
 				mpp_err_msg_cache(logError, progname, "Try \"%s --help\" for more information.\n", progname);
 				return false;
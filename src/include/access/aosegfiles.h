@@ -196,6 +196,8 @@ extern FileSegTotals *GetSegFilesTotals(Relation parentrel, Snapshot appendOnlyM
 
 extern int64 GetAOTotalBytes(Relation parentrel, Snapshot appendOnlyMetaDataSnapshot);
 
+extern int64 GetAOModCount(Oid relid, bool columnstore, Snapshot appendOnlyMetaDataSnapshot);
+
 extern void FreeAllSegFileInfo(FileSegInfo **allSegInfo,
 				   int totalSegFiles);
 
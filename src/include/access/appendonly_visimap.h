@@ -110,6 +110,13 @@ bool AppendOnlyVisimap_IsVisible(
 							AppendOnlyVisimap *visiMap,
 							AOTupleId *tupleId);
 
+bool AppendOnlyVisimap_GetVisibility(
+								AppendOnlyVisimap *visiMap,
+								int segno,
+								int64 firstRowNum,
+								int nrows,
+								bool *visible);
+
 void AppendOnlyVisimap_Finish(
 						 AppendOnlyVisimap *visiMap,
 						 LOCKMODE lockmode);
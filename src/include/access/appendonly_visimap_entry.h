@@ -124,6 +124,12 @@ bool AppendOnlyVisimapEntry_IsVisible(
 								 AppendOnlyVisimapEntry *visiMapEntry,
 								 AOTupleId *aoTupleId);
 
+bool AppendOnlyVisimapEntry_GetVisibility(
+									 AppendOnlyVisimapEntry *visiMapEntry,
+									 int64 rowNum,
+									 int count,
+									 bool *visible);
+
 HTSU_Result AppendOnlyVisimapEntry_HideTuple(
 								 AppendOnlyVisimapEntry *visiMapEntry,
 								 AOTupleId *aoTupleId);
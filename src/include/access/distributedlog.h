@@ -42,9 +42,6 @@ typedef struct DistributedLogEntry
 
 } DistributedLogEntry;
 
-/* Number of SLRU buffers to use for the distributed log */
-#define NUM_DISTRIBUTEDLOG_BUFFERS	8
-
 extern void DistributedLog_SetCommitted(
 							TransactionId localXid,
 							DistributedTransactionTimeStamp dtxStartTime,
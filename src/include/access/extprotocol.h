@@ -36,6 +36,15 @@ typedef struct ExtProtocolData
 	int				prot_maxbytes;
 	void*			prot_user_ctx;
 	bool			prot_last_call;
+
+	/*
+	 * pushdown, for a readable table: the columns the scan needs (NULL if
+	 * all), and the scan's quals as planned.  Like a formatter, a protocol
+	 * may send the other columns empty and skip data that can't pass the
+	 * quals; the scan still checks them.
+	 */
+	bool		   *prot_proj;
+	List		   *prot_quals;
 		
 } ExtProtocolData;
 
@@ -50,6 +59,8 @@ typedef ExtProtocolData *ExtProtocol;
 #define EXTPROTOCOL_GET_DATALEN(fcinfo)    (((ExtProtocolData*) fcinfo->context)->prot_maxbytes)
 #define EXTPROTOCOL_GET_USER_CTX(fcinfo)   (((ExtProtocolData*) fcinfo->context)->prot_user_ctx)
 #define EXTPROTOCOL_IS_LAST_CALL(fcinfo)   (((ExtProtocolData*) fcinfo->context)->prot_last_call)
+#define EXTPROTOCOL_GET_PROJECTION(fcinfo) (((ExtProtocolData*) fcinfo->context)->prot_proj)
+#define EXTPROTOCOL_GET_QUALS(fcinfo)      (((ExtProtocolData*) fcinfo->context)->prot_quals)
 
 #define EXTPROTOCOL_SET_LAST_CALL(fcinfo)  (((ExtProtocolData*) fcinfo->context)->prot_last_call = true)
 #define EXTPROTOCOL_SET_USER_CTX(fcinfo, p) \
@@ -64,6 +64,14 @@ typedef struct FormatterData
 	bool			fmt_needs_transcoding;
 	FmgrInfo*		fmt_conversion_proc;
 	int				fmt_external_encoding;
+
+	/*
+	 * pushdown: the columns the scan needs (NULL if all), and the scan's
+	 * quals as planned.  A formatter may leave the other columns NULL, and
+	 * skip data that can't pass the quals; the scan still checks them.
+	 */
+	bool		   *fmt_proj;
+	List		   *fmt_quals;
 		
 } FormatterData;
 
@@ -85,6 +93,8 @@ typedef struct FormatterData
 #define FORMATTER_GET_NTH_ARG_KEY(fcinfo, n)  (((DefElem *)(list_nth(FORMATTER_GET_ARG_LIST(fcinfo),(n - 1))))->defname)
 #define FORMATTER_GET_NTH_ARG_VAL(fcinfo, n)  (((Value *)((DefElem *)(list_nth(FORMATTER_GET_ARG_LIST(fcinfo),(n - 1))))->arg)->val.str)
 #define FORMATTER_GET_EXTENCODING(fcinfo)     (((FormatterData*) fcinfo->context)->fmt_external_encoding)
+#define FORMATTER_GET_PROJECTION(fcinfo)      (((FormatterData*) fcinfo->context)->fmt_proj)
+#define FORMATTER_GET_QUALS(fcinfo)           (((FormatterData*) fcinfo->context)->fmt_quals)
 
 #define FORMATTER_SET_USER_CTX(fcinfo, p) \
 	(((FormatterData*) fcinfo->context)->fmt_user_ctx = p)
@@ -220,6 +220,7 @@ extern Relation try_heap_open(Oid relationId, LOCKMODE lockmode, bool noWait);
 #define heap_close(r,l)  relation_close(r,l)
 
 /* CDB */
+extern bool CdbGlobalDeadlockDetectorCovers(Oid relid);
 extern Relation CdbOpenRelation(Oid relid, LOCKMODE reqmode, bool noWait, 
 								bool *lockUpgraded);
 extern Relation CdbTryOpenRelation(Oid relid, LOCKMODE reqmode, bool noWait, 
@@ -256,6 +257,8 @@ extern void setLastTid(const ItemPointer tid);
 
 extern Oid heap_insert(Relation relation, HeapTuple tup, CommandId cid,
 			bool use_wal, bool use_fsm, TransactionId xid);
+extern void heap_multi_insert(Relation relation, HeapTuple *tuples, int ntuples,
+				  CommandId cid, bool use_wal, bool use_fsm, TransactionId xid);
 extern HTSU_Result heap_delete(Relation relation, ItemPointer tid,
 			ItemPointer ctid, TransactionId *update_xmax,
 			CommandId cid, Snapshot crosscheck, bool wait);
@@ -41,6 +41,12 @@ typedef struct HeapScanDescData
 	BufferAccessStrategy rs_strategy;	/* access strategy for reads */
 	bool		rs_syncscan;	/* report location to syncscan logic? */
 
+	/* read-ahead state, see effective_io_concurrency */
+	BlockNumber rs_prefetch_next;	/* next page to prefetch, counted from
+									 * rs_startblock (seqscans) */
+	int			rs_prefetch_pages;	/* pages prefetched ahead of the current
+									 * one (bitmap scans) */
+
 	/* scan current state */
 	bool		rs_inited;		/* false = scan not init'd yet */
 	HeapTupleData rs_ctup;		/* current tuple in scan, if any */
@@ -118,6 +124,8 @@ typedef struct FileScanDescData
 	FmgrInfo   *in_functions;
 	Oid		   *typioparams;
 	Oid			in_func_oid;
+	bool	   *proj;			/* columns to parse, or NULL for all */
+	List	   *quals;			/* scan quals, for the source to filter on */
 	
 	/* current file scan state */
 	bool		fs_inited;		/* false = scan not init'd yet */
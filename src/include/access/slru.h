@@ -120,6 +120,12 @@ typedef struct SlruCtlData
 	 */
 	bool		(*PagePrecedes) (int, int);
 
+	/*
+	 * Wait event to report while doing page I/O, or WAIT_EVENT_NONE (zero)
+	 * to not report any.
+	 */
+	uint32		ioWaitEvent;
+
 	/*
 	 * Dir is set during SimpleLruInit and does not change thereafter. Since
 	 * it's always the same, it doesn't need to be in shared memory.
@@ -141,6 +147,7 @@ extern int SimpleLruReadPage(SlruCtl ctl, int pageno, bool write_ok,
 				  TransactionId xid);
 extern int SimpleLruReadPage_ReadOnly(SlruCtl ctl, int pageno,
 				      TransactionId xid, bool *valid);
+extern int	SimpleLruFindResidentPage(SlruCtl ctl, int pageno);
 extern void SimpleLruWritePage(SlruCtl ctl, int slotno, SlruFlush fdata);
 extern void SimpleLruFlush(SlruCtl ctl, bool checkpoint);
 extern void SimpleLruTruncate(SlruCtl ctl, int cutoffPage);
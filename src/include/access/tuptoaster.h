@@ -117,6 +117,25 @@ extern HeapTuple toast_insert_or_update(Relation rel,
  */
 extern void toast_delete(Relation rel, HeapTuple oldtup, MemTupleBinding *pbind);
 
+/* ----------
+ * toast_save_datum -
+ *
+ *	Save one single datum into the secondary relation of rel and return
+ *	a toast pointer to it. Used directly by append-only columnar tables,
+ *	which move large values out of line one column at a time.
+ * ----------
+ */
+extern Datum toast_save_datum(Relation rel, Datum value, bool isFrozen,
+				 bool use_wal, bool use_fsm);
+
+/* ----------
+ * toast_delete_datum -
+ *
+ *	Delete a single external stored value.
+ * ----------
+ */
+extern void toast_delete_datum(Relation rel, Datum value);
+
 /* ----------
  * heap_tuple_fetch_attr() -
  *
@@ -107,6 +107,7 @@ extern size_t url_execute_fread(void *ptr, size_t size, URL_FILE *file, CopyStat
 extern size_t url_execute_fwrite(void *ptr, size_t size, URL_FILE *file, CopyState pstate);
 
 extern URL_FILE *url_custom_fopen(char *url, bool forwrite, extvar_t *ev, CopyState pstate);
+extern void url_custom_set_pushdown(URL_FILE *file, bool *proj, List *quals);
 extern void url_custom_fclose(URL_FILE *file, bool failOnError, const char *relname);
 extern bool url_custom_feof(URL_FILE *file, int bytesread);
 extern bool url_custom_ferror(URL_FILE *file, int bytesread, char *ebuf, int ebuflen);
@@ -115,5 +116,6 @@ extern size_t url_custom_fwrite(void *ptr, size_t size, URL_FILE *file, CopyStat
 
 /* GUC */
 extern int readable_external_table_timeout;
+extern bool gpfdist_compress;
 
 #endif
@@ -116,7 +116,7 @@ DATA(insert ( 2110	float4pl		float4mi float4pl			float4mi -				0	700		_null_  f)
 DATA(insert ( 2111	float8pl		float8mi float8pl			float8mi -				0	701		_null_  f));
 DATA(insert ( 2112	cash_pl			cash_mi cash_pl			cash_mi -				0	790		_null_  f));
 DATA(insert ( 2113	interval_pl		interval_mi interval_pl		interval_mi -				0	1186	_null_  f));
-DATA(insert ( 2114	numeric_add		numeric_sub numeric_add		numeric_sub -				0	1700	_null_  f));
+DATA(insert ( 2114	numeric_avg_accum numeric_avg_decum numeric_avg_amalg numeric_avg_demalg numeric_sum 0	17 "" f));
 
 /* max */
 DATA(insert ( 2115	int8larger		- int8larger		- -				413		20		_null_  f));
@@ -269,6 +269,16 @@ DATA(insert ( 6098	array_agg_transfn        - - - array_agg_finalfn  0 2281 _nul
 DATA(insert ( 3537	string_agg_transfn       - - - string_agg_finalfn 0 2281 _null_ t));
 DATA(insert ( 3538	string_agg_delim_transfn - - - string_agg_finalfn 0 2281 _null_ t));
 
+/* distinct values estimate */
+DATA(insert ( 7185	gp_hll_accum - gp_hll_merge - gp_hll_ndistinct_final 0 17 "" f));
+
+/* approximate aggregates */
+DATA(insert ( 7242	gp_hll_accum - gp_hll_merge - approx_count_distinct_final 0 17 "" f));
+DATA(insert ( 7278	approx_percentile_accum - approx_percentile_merge - approx_percentile_final 0 17 "" f));
+
+/* order independent digest */
+DATA(insert ( 7195	gp_unordered_md5_accum - gp_unordered_md5_merge - gp_unordered_md5_final 0 17 "" f));
+
 
 /*
  * prototypes for functions in pg_aggregate.c
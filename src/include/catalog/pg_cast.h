@@ -364,4 +364,8 @@ DATA(insert (   27   20 6021 e ));
 DATA(insert (	27 3300    0 e ));
 DATA(insert ( 3300	 27    0 e ));
 
+/* json <-> jsonb */
+DATA(insert (  114 3802 3808 a ));
+DATA(insert ( 3802  114 3809 a ));
+
 #endif   /* PG_CAST_H */
@@ -85,6 +85,8 @@
 
  CREATE FUNCTION numeric_avg_decum(bytea, "numeric") RETURNS bytea LANGUAGE internal IMMUTABLE STRICT AS 'numeric_avg_decum' WITH (OID=3103, DESCRIPTION="aggregate inverse transition function");
 
+ CREATE FUNCTION numeric_sum(bytea) RETURNS "numeric" LANGUAGE internal IMMUTABLE STRICT AS 'numeric_sum' WITH (OID=7240, DESCRIPTION="SUM(numeric) aggregate final function");
+
  CREATE FUNCTION int2_decum(_numeric, int2) RETURNS _numeric LANGUAGE internal IMMUTABLE STRICT AS 'int2_decum' WITH (OID=7306, DESCRIPTION="aggregate inverse transition function");
 
  CREATE FUNCTION int4_decum(_numeric, int4) RETURNS _numeric LANGUAGE internal IMMUTABLE STRICT AS 'int4_decum' WITH (OID=7307, DESCRIPTION="aggregate inverse transition function");
@@ -822,6 +824,8 @@
 
  CREATE FUNCTION gp_write_backup_file(text, text, text) RETURNS text LANGUAGE internal VOLATILE AS 'gp_write_backup_file__' WITH (OID=6006, DESCRIPTION="write mpp backup file on outboard Postgres instances");
 
+ CREATE FUNCTION gp_relation_max_lsn(regclass) RETURNS text LANGUAGE internal VOLATILE STRICT AS 'gp_relation_max_lsn' WITH (OID=7191, DESCRIPTION="highest page LSN of a heap relation on this segment, for incremental backup");
+
  CREATE FUNCTION gp_pgdatabase() RETURNS SETOF record LANGUAGE internal VOLATILE AS 'gp_pgdatabase__' WITH (OID=6007, DESCRIPTION="view mpp pgdatabase state");
 
  CREATE FUNCTION numeric_amalg(_numeric, _numeric) RETURNS _numeric LANGUAGE internal IMMUTABLE STRICT AS 'numeric_amalg' WITH (OID=6008, DESCRIPTION="aggregate preliminary function");
@@ -1530,6 +1534,63 @@
 -- Analyze related
  CREATE FUNCTION gp_statistics_estimate_reltuples_relpages_oid(oid) RETURNS _float4 LANGUAGE internal VOLATILE STRICT AS 'gp_statistics_estimate_reltuples_relpages_oid' WITH (OID=5032, DESCRIPTION="Return reltuples/relpages information for relation.");
 
+ CREATE FUNCTION gp_hll_accum(bytea, anyelement) RETURNS bytea LANGUAGE internal IMMUTABLE STRICT AS 'gp_hll_accum' WITH (OID=7182, DESCRIPTION="gp_hll_ndistinct transition function");
+
+ CREATE FUNCTION gp_hll_merge(bytea, bytea) RETURNS bytea LANGUAGE internal IMMUTABLE STRICT AS 'gp_hll_merge' WITH (OID=7183, DESCRIPTION="gp_hll_ndistinct preliminary function");
+
+ CREATE FUNCTION gp_hll_ndistinct_final(bytea) RETURNS float8 LANGUAGE internal IMMUTABLE STRICT AS 'gp_hll_ndistinct_final' WITH (OID=7184, DESCRIPTION="gp_hll_ndistinct final function");
+
+ CREATE FUNCTION gp_hll_ndistinct(anyelement) RETURNS float8 LANGUAGE internal IMMUTABLE AS 'aggregate_dummy' WITH (OID=7185, DESCRIPTION="estimate the number of distinct values with a HyperLogLog sketch", proisagg="t");
+
+-- Approximate aggregates
+ CREATE FUNCTION approx_count_distinct_final(bytea) RETURNS int8 LANGUAGE internal IMMUTABLE STRICT AS 'approx_count_distinct_final' WITH (OID=7241, DESCRIPTION="approx_count_distinct final function");
+
+ CREATE FUNCTION approx_count_distinct(anyelement) RETURNS int8 LANGUAGE internal IMMUTABLE AS 'aggregate_dummy' WITH (OID=7242, DESCRIPTION="approximate number of distinct values, from a HyperLogLog sketch", proisagg="t");
+
+ CREATE FUNCTION approx_percentile_accum(bytea, float8, float8) RETURNS bytea LANGUAGE internal IMMUTABLE STRICT AS 'approx_percentile_accum' WITH (OID=7243, DESCRIPTION="approx_percentile transition function");
+
+ CREATE FUNCTION approx_percentile_merge(bytea, bytea) RETURNS bytea LANGUAGE internal IMMUTABLE STRICT AS 'approx_percentile_merge' WITH (OID=7276, DESCRIPTION="approx_percentile preliminary function");
+
+ CREATE FUNCTION approx_percentile_final(bytea) RETURNS float8 LANGUAGE internal IMMUTABLE STRICT AS 'approx_percentile_final' WITH (OID=7277, DESCRIPTION="approx_percentile final function");
+
+ CREATE FUNCTION approx_percentile(float8, float8) RETURNS float8 LANGUAGE internal IMMUTABLE AS 'aggregate_dummy' WITH (OID=7278, DESCRIPTION="approximate percentile of the values, from a t-digest; the second argument is the fraction", proisagg="t");
+
+ CREATE FUNCTION gp_stat_get_changes_since_analyze(OUT relid oid, OUT relstorage "char", OUT modcount int8, OUT changes_since_analyze int8, OUT last_analyze timestamptz) RETURNS SETOF pg_catalog.record LANGUAGE internal VOLATILE AS 'gp_stat_get_changes_since_analyze' WITH (OID=7196, DESCRIPTION="statistics: modifications of every table since it was last analyzed");
+
+-- Catalog consistency checks, for gpcheckcat
+ CREATE FUNCTION gp_unordered_md5_accum(bytea, text) RETURNS bytea LANGUAGE internal IMMUTABLE STRICT AS 'gp_unordered_md5_accum' WITH (OID=7192, DESCRIPTION="gp_unordered_md5 transition function");
+
+ CREATE FUNCTION gp_unordered_md5_merge(bytea, bytea) RETURNS bytea LANGUAGE internal IMMUTABLE STRICT AS 'gp_unordered_md5_merge' WITH (OID=7193, DESCRIPTION="gp_unordered_md5 preliminary function");
+
+ CREATE FUNCTION gp_unordered_md5_final(bytea) RETURNS text LANGUAGE internal IMMUTABLE STRICT AS 'gp_unordered_md5_final' WITH (OID=7194, DESCRIPTION="gp_unordered_md5 final function");
+
+ CREATE FUNCTION gp_unordered_md5(text) RETURNS text LANGUAGE internal IMMUTABLE AS 'aggregate_dummy' WITH (OID=7195, DESCRIPTION="md5 digest of a set of values, independent of their order", proisagg="t");
+
+-- Online redistribution, for gpexpand
+ CREATE FUNCTION gp_hash_target_segment(record, _int2) RETURNS int4 LANGUAGE internal STABLE STRICT AS 'gp_hash_target_segment' WITH (OID=7186, DESCRIPTION="segment a row belongs on if distributed by the given attributes");
+
+ CREATE FUNCTION gp_expand_redistribute(regclass, _int2, int4) RETURNS int8 LANGUAGE internal VOLATILE STRICT MODIFIES SQL DATA AS 'gp_expand_redistribute' WITH (OID=7187, DESCRIPTION="move the rows that belong on a segment of a randomly distributed table there");
+
+ CREATE FUNCTION gp_expand_redistribute_finish(regclass, _int2) RETURNS int8 LANGUAGE internal VOLATILE STRICT MODIFIES SQL DATA AS 'gp_expand_redistribute_finish' WITH (OID=7188, DESCRIPTION="move the remaining misplaced rows of a table and distribute it by the given attributes");
+
+-- Benchmarks of the database's own code paths
+ CREATE FUNCTION gp_bench_compress(IN compresstype text, IN compresslevel int4, IN mbytes int4, OUT compress_mbps float8, OUT decompress_mbps float8, OUT ratio float8) RETURNS pg_catalog.record LANGUAGE internal VOLATILE STRICT AS 'gp_bench_compress' WITH (OID=7197, DESCRIPTION="benchmark: AO block compression and decompression throughput of a codec");
+
+ CREATE FUNCTION gp_bench_workfile(IN mbytes int4, OUT write_mbps float8, OUT read_mbps float8) RETURNS pg_catalog.record LANGUAGE internal VOLATILE STRICT AS 'gp_bench_workfile' WITH (OID=7198, DESCRIPTION="benchmark: spill file write and read throughput");
+
+ CREATE FUNCTION gp_bench_hash(int4) RETURNS float8 LANGUAGE internal VOLATILE STRICT AS 'gp_bench_hash' WITH (OID=7199, DESCRIPTION="benchmark: millions of values hashed to a segment per second");
+
+ CREATE FUNCTION gp_bench_sort(int4) RETURNS float8 LANGUAGE internal VOLATILE STRICT AS 'gp_bench_sort' WITH (OID=7200, DESCRIPTION="benchmark: millions of int8 values sorted per second");
+
+ CREATE FUNCTION gp_bench_interconnect(IN mbytes int4, OUT mbps float8, OUT latency_ms float8) RETURNS pg_catalog.record LANGUAGE internal VOLATILE STRICT READS SQL DATA AS 'gp_bench_interconnect' WITH (OID=7201, DESCRIPTION="benchmark: interconnect throughput and latency through Motions");
+
+ CREATE FUNCTION gp_bench_operators(IN ntuples int4, IN width int4, IN ndistinct int4, OUT kernel text, OUT ns_per_tuple float8) RETURNS SETOF pg_catalog.record LANGUAGE internal VOLATILE STRICT AS 'gp_bench_operators' WITH (OID=7237, DESCRIPTION="benchmark: nanoseconds per row of the executor's operator kernels");
+
+-- Binary external table formatters, for gptransfer
+ CREATE FUNCTION gp_tuple_export(record) RETURNS bytea LANGUAGE internal STABLE AS 'gp_tuple_export' WITH (OID=7189, DESCRIPTION="external table formatter: serialize rows in the interconnect's binary form");
+
+ CREATE FUNCTION gp_tuple_import() RETURNS record LANGUAGE internal STABLE AS 'gp_tuple_import' WITH (OID=7190, DESCRIPTION="external table formatter: read rows written by gp_tuple_export");
+
 -- Backoff related
  CREATE FUNCTION gp_adjust_priority(int4, int4, int4) RETURNS int4 LANGUAGE internal VOLATILE STRICT AS 'gp_adjust_priority_int' WITH (OID=5040, DESCRIPTION="change weight of all the backends for a given session id");
 
@@ -1537,6 +1598,24 @@
 
  CREATE FUNCTION gp_list_backend_priorities() RETURNS SETOF record LANGUAGE internal VOLATILE AS 'gp_list_backend_priorities' WITH (OID=5042, DESCRIPTION="list priorities of backends");
 
+ CREATE FUNCTION gp_interconnect_stats(OUT segid int4, OUT pid int4, OUT sess_id int4, OUT command_count int4, OUT slice_id int4, OUT send_conns int4, OUT recv_conns int4, OUT rx_buffers_in_use int4, OUT rx_buffers_max int4, OUT recv_queue_len int4, OUT max_recv_queue_len int4, OUT max_recv_queue_content int4, OUT unack_queue_len int4, OUT max_unack_queue_len int4, OUT max_unack_queue_content int4, OUT retransmits int8, OUT duplicates int8, OUT put_rx_buffer_count int8, OUT put_rx_buffer_time_us int8, OUT wait_time_us int8) RETURNS SETOF pg_catalog.record LANGUAGE internal VOLATILE AS 'gp_interconnect_stats' WITH (OID=6099, DESCRIPTION="statistics: live UDP interconnect state of the backends of this instance");
+
+ CREATE FUNCTION gp_query_progress(OUT segid int4, OUT pid int4, OUT sess_id int4, OUT command_count int4, OUT slice_id int4, OUT node_id int4, OUT node_type text, OUT plan_rows float8, OUT actual_rows int8, OUT motion_bytes int8, OUT spill_bytes int8) RETURNS SETOF pg_catalog.record LANGUAGE internal VOLATILE AS 'gp_query_progress' WITH (OID=7202, DESCRIPTION="statistics: live per-node progress of the queries running on this instance");
+
+ CREATE FUNCTION gp_wait_event_samples(duration_ms int4, interval_ms int4, OUT segid int4, OUT sess_id int4, OUT command_count int4, OUT wait_event text, OUT samples int8, OUT sample_rounds int8) RETURNS SETOF pg_catalog.record LANGUAGE internal STRICT VOLATILE AS 'gp_wait_event_samples' WITH (OID=7203, DESCRIPTION="statistics: sample the wait events of the queries running on this instance");
+
+ CREATE FUNCTION gp_query_resource_history(OUT segid int4, OUT pid int4, OUT sess_id int4, OUT command_count int4, OUT slice_id int4, OUT userid oid, OUT rsgid oid, OUT aborted bool, OUT start_time timestamptz, OUT end_time timestamptz, OUT query_mem int8, OUT peak_vmem int8, OUT sort_spill_bytes int8, OUT hashjoin_spill_bytes int8, OUT hashagg_spill_bytes int8, OUT material_spill_bytes int8, OUT other_spill_bytes int8, OUT hashagg_passes int8, OUT hashjoin_batches int8, OUT spill_bytes int8) RETURNS SETOF pg_catalog.record LANGUAGE internal VOLATILE AS 'gp_query_resource_history' WITH (OID=7234, DESCRIPTION="statistics: memory and spill usage of the recently completed queries of this instance");
+
+ CREATE FUNCTION gp_statement_stats(OUT dbid oid, OUT userid oid, OUT fingerprint int8, OUT phase text, OUT calls int8, OUT total_ms float8, OUT mean_ms float8, OUT p50_ms float8, OUT p90_ms float8, OUT p99_ms float8, OUT max_ms float8, OUT query text) RETURNS SETOF pg_catalog.record LANGUAGE internal VOLATILE AS 'gp_statement_stats' WITH (OID=7235, DESCRIPTION="statistics: latency percentiles of the statements run on the master, by phase");
+
+ CREATE FUNCTION gp_statement_stats_reset() RETURNS void LANGUAGE internal VOLATILE AS 'gp_statement_stats_reset' WITH (OID=7236, DESCRIPTION="statistics: forget the latency of the statements run on the master");
+
+ CREATE FUNCTION gp_endpoints(OUT gp_segment_id int4, OUT hostname text, OUT port int4, OUT cursorname text, OUT token text) RETURNS SETOF pg_catalog.record LANGUAGE internal VOLATILE AS 'gp_endpoints' WITH (OID=6100, DESCRIPTION="endpoints of the parallel retrieve cursors of this session");
+
+ CREATE FUNCTION gp_wait_parallel_retrieve_cursor(cursorname text) RETURNS bool LANGUAGE internal STRICT VOLATILE AS 'gp_wait_parallel_retrieve_cursor' WITH (OID=6101, DESCRIPTION="wait until all rows of a parallel retrieve cursor have been retrieved");
+
+ CREATE FUNCTION gp_segment_endpoints(OUT token text, OUT username text, OUT session_id int4, OUT state text, OUT sender_pid int4, OUT receiver_pid int4) RETURNS SETOF pg_catalog.record LANGUAGE internal VOLATILE AS 'gp_segment_endpoints' WITH (OID=6124, DESCRIPTION="endpoints of parallel retrieve cursors on this instance");
+
 -- Functions to deal with SREH error logs
  CREATE FUNCTION gp_read_error_log(exttable text, OUT cmdtime timestamptz, OUT relname text, OUT filename text, OUT linenum int4, OUT bytenum int4, OUT errmsg text, OUT rawdata text, OUT rawbytes bytea) RETURNS SETOF record LANGUAGE INTERNAL STRICT VOLATILE EXECUTE ON ALL SEGMENTS AS 'gp_read_error_log' WITH (OID = 3000, DESCRIPTION="read the error log for the specified external table");
 
@@ -1652,6 +1731,26 @@ CREATE FUNCTION gp_nondbspecific_ptcat_verification() RETURNS bool LANGUAGE inte
 
  CREATE FUNCTION gp_zlib_validator(internal) RETURNS void LANGUAGE internal IMMUTABLE AS 'zlib_validator' WITH(OID=9924, DESCRIPTION="zlib compression validator");
 
+ CREATE FUNCTION gp_zstd_constructor(internal, internal, bool) RETURNS internal LANGUAGE internal VOLATILE AS 'zstd_constructor' WITH (OID=6109, DESCRIPTION="zstd constructor");
+
+ CREATE FUNCTION gp_zstd_destructor(internal) RETURNS void LANGUAGE internal VOLATILE AS 'zstd_destructor' WITH(OID=6110, DESCRIPTION="zstd destructor");
+
+ CREATE FUNCTION gp_zstd_compress(internal, int4, internal, int4, internal, internal) RETURNS void LANGUAGE internal IMMUTABLE AS 'zstd_compress' WITH(OID=6111, DESCRIPTION="zstd compressor");
+
+ CREATE FUNCTION gp_zstd_decompress(internal, int4, internal, int4, internal, internal) RETURNS void LANGUAGE internal IMMUTABLE AS 'zstd_decompress' WITH(OID=6112, DESCRIPTION="zstd decompressor");
+
+ CREATE FUNCTION gp_zstd_validator(internal) RETURNS void LANGUAGE internal IMMUTABLE AS 'zstd_validator' WITH(OID=6117, DESCRIPTION="zstd compression validator");
+
+ CREATE FUNCTION gp_lz4_constructor(internal, internal, bool) RETURNS internal LANGUAGE internal VOLATILE AS 'lz4_constructor' WITH (OID=6119, DESCRIPTION="lz4 constructor");
+
+ CREATE FUNCTION gp_lz4_destructor(internal) RETURNS void LANGUAGE internal VOLATILE AS 'lz4_destructor' WITH(OID=6120, DESCRIPTION="lz4 destructor");
+
+ CREATE FUNCTION gp_lz4_compress(internal, int4, internal, int4, internal, internal) RETURNS void LANGUAGE internal IMMUTABLE AS 'lz4_compress' WITH(OID=6121, DESCRIPTION="lz4 compressor");
+
+ CREATE FUNCTION gp_lz4_decompress(internal, int4, internal, int4, internal, internal) RETURNS void LANGUAGE internal IMMUTABLE AS 'lz4_decompress' WITH(OID=6122, DESCRIPTION="lz4 decompressor");
+
+ CREATE FUNCTION gp_lz4_validator(internal) RETURNS void LANGUAGE internal IMMUTABLE AS 'lz4_validator' WITH(OID=6123, DESCRIPTION="lz4 compression validator");
+
  CREATE FUNCTION gp_rle_type_constructor(internal, internal, bool) RETURNS internal LANGUAGE internal VOLATILE AS 'rle_type_constructor' WITH (OID=9914, DESCRIPTION="Type specific RLE constructor");
 
  CREATE FUNCTION gp_rle_type_destructor(internal) RETURNS void LANGUAGE internal VOLATILE AS 'rle_type_destructor' WITH(OID=9915, DESCRIPTION="Type specific RLE destructor");
@@ -1804,5 +1903,36 @@ CREATE FUNCTION gp_nondbspecific_ptcat_verification() RETURNS bool LANGUAGE inte
  
  CREATE FUNCTION complex_gte(complex, complex) RETURNS bool  LANGUAGE internal IMMUTABLE STRICT AS 'complex_gte' WITH (OID=3596, DESCRIPTION="greater than or equal");
 
+ -- functions for the jsonb data type
+ CREATE FUNCTION jsonb_in(cstring) RETURNS jsonb LANGUAGE internal IMMUTABLE STRICT AS 'jsonb_in' WITH (OID=3806, DESCRIPTION="I/O");
+
+ CREATE FUNCTION jsonb_out(jsonb) RETURNS cstring LANGUAGE internal IMMUTABLE STRICT AS 'jsonb_out' WITH (OID=3804, DESCRIPTION="I/O");
+
+ CREATE FUNCTION jsonb_recv(internal) RETURNS jsonb LANGUAGE internal IMMUTABLE STRICT AS 'jsonb_recv' WITH (OID=3805, DESCRIPTION="I/O");
+
+ CREATE FUNCTION jsonb_send(jsonb) RETURNS bytea LANGUAGE internal IMMUTABLE STRICT AS 'jsonb_send' WITH (OID=3803, DESCRIPTION="I/O");
+
+ CREATE FUNCTION jsonb(json) RETURNS jsonb LANGUAGE internal IMMUTABLE STRICT AS 'json_to_jsonb' WITH (OID=3808, DESCRIPTION="convert json to jsonb");
+
+ CREATE FUNCTION json(jsonb) RETURNS json LANGUAGE internal IMMUTABLE STRICT AS 'jsonb_to_json' WITH (OID=3809, DESCRIPTION="convert jsonb to json");
+
+ CREATE FUNCTION jsonb_object_field(from_json jsonb, field_name text) RETURNS jsonb LANGUAGE internal IMMUTABLE STRICT AS 'jsonb_object_field' WITH (OID=3810, DESCRIPTION="get jsonb object field");
+
+ CREATE FUNCTION jsonb_object_field_text(from_json jsonb, field_name text) RETURNS text LANGUAGE internal IMMUTABLE STRICT AS 'jsonb_object_field_text' WITH (OID=3811, DESCRIPTION="get jsonb object field as text");
+
+ CREATE FUNCTION jsonb_array_element(from_json jsonb, element_index int4) RETURNS jsonb LANGUAGE internal IMMUTABLE STRICT AS 'jsonb_array_element' WITH (OID=3812, DESCRIPTION="get jsonb array element");
+
+ CREATE FUNCTION jsonb_array_element_text(from_json jsonb, element_index int4) RETURNS text LANGUAGE internal IMMUTABLE STRICT AS 'jsonb_array_element_text' WITH (OID=3813, DESCRIPTION="get jsonb array element as text");
+
+ CREATE FUNCTION jsonb_extract_path_op(from_json jsonb, path_elems _text) RETURNS jsonb LANGUAGE internal IMMUTABLE STRICT AS 'jsonb_extract_path' WITH (OID=3814, DESCRIPTION="get value from jsonb with path elements");
+
+ CREATE FUNCTION jsonb_extract_path_text_op(from_json jsonb, path_elems _text) RETURNS text LANGUAGE internal IMMUTABLE STRICT AS 'jsonb_extract_path_text' WITH (OID=3815, DESCRIPTION="get value from jsonb as text with path elements");
+
+ CREATE FUNCTION jsonb_exists(jsonb, text) RETURNS bool LANGUAGE internal IMMUTABLE STRICT AS 'jsonb_exists' WITH (OID=3816, DESCRIPTION="does the jsonb object have the key");
+
+ CREATE FUNCTION jsonb_contains(jsonb, jsonb) RETURNS bool LANGUAGE internal IMMUTABLE STRICT AS 'jsonb_contains' WITH (OID=3824, DESCRIPTION="implementation of @> operator");
+
+ CREATE FUNCTION jsonb_contained(jsonb, jsonb) RETURNS bool LANGUAGE internal IMMUTABLE STRICT AS 'jsonb_contained' WITH (OID=3825, DESCRIPTION="implementation of <@ operator");
+
  -- functions for external table
  CREATE FUNCTION pg_options_to_table(IN options_array _text, OUT option_name text, OUT option_value text) RETURNS SETOF pg_catalog.record LANGUAGE internal IMMUTABLE STRICT AS 'pg_options_to_table' WITH (OID=2022, DESCRIPTION="convert generic options array to name/value table");
@@ -22,7 +22,7 @@
 
    WARNING: DO NOT MODIFY THE FOLLOWING SECTION: 
    Generated by catullus.pl version 8
-   on Thu Sep 28 17:42:48 2017
+   on Thu Oct 15 09:29:28 2026
 
    Please make your changes in pg_proc.sql
 */
@@ -197,6 +197,10 @@ DESCR("aggregate inverse transition function");
 DATA(insert OID = 3103 ( numeric_avg_decum  PGNSP PGUID 12 1 0 0 f f f t f i 2 0 17 "17 1700" _null_ _null_ _null_ _null_ numeric_avg_decum _null_ _null_ _null_ n a ));
 DESCR("aggregate inverse transition function");
 
+/* numeric_sum(bytea) => "numeric" */ 
+DATA(insert OID = 7240 ( numeric_sum  PGNSP PGUID 12 1 0 0 f f f t f i 1 0 1700 "17" _null_ _null_ _null_ _null_ numeric_sum _null_ _null_ _null_ n a ));
+DESCR("SUM(numeric) aggregate final function");
+
 /* int2_decum(_numeric, int2) => _numeric */ 
 DATA(insert OID = 7306 ( int2_decum  PGNSP PGUID 12 1 0 0 f f f t f i 2 0 1231 "1231 21" _null_ _null_ _null_ _null_ int2_decum _null_ _null_ _null_ n a ));
 DESCR("aggregate inverse transition function");
@@ -1362,6 +1366,10 @@ DESCR("read mpp backup file on outboard Postgres instances");
 DATA(insert OID = 6006 ( gp_write_backup_file  PGNSP PGUID 12 1 0 0 f f f f f v 3 0 25 "25 25 25" _null_ _null_ _null_ _null_ gp_write_backup_file__ _null_ _null_ _null_ n a ));
 DESCR("write mpp backup file on outboard Postgres instances");
 
+/* gp_relation_max_lsn(regclass) => text */ 
+DATA(insert OID = 7191 ( gp_relation_max_lsn  PGNSP PGUID 12 1 0 0 f f f t f v 1 0 25 "2205" _null_ _null_ _null_ _null_ gp_relation_max_lsn _null_ _null_ _null_ n a ));
+DESCR("highest page LSN of a heap relation on this segment, for incremental backup");
+
 /* gp_pgdatabase() => SETOF record */ 
 DATA(insert OID = 6007 ( gp_pgdatabase  PGNSP PGUID 12 1 1000 0 f f f f t v 0 0 2249 "" _null_ _null_ _null_ _null_ gp_pgdatabase__ _null_ _null_ _null_ n a ));
 DESCR("view mpp pgdatabase state");
@@ -2488,6 +2496,120 @@ DESCR("Greenplum fault testing only");
 DATA(insert OID = 5032 ( gp_statistics_estimate_reltuples_relpages_oid  PGNSP PGUID 12 1 0 0 f f f t f v 1 0 1021 "26" _null_ _null_ _null_ _null_ gp_statistics_estimate_reltuples_relpages_oid _null_ _null_ _null_ n a ));
 DESCR("Return reltuples/relpages information for relation.");
 
+/* gp_hll_accum(bytea, anyelement) => bytea */ 
+DATA(insert OID = 7182 ( gp_hll_accum  PGNSP PGUID 12 1 0 0 f f f t f i 2 0 17 "17 2283" _null_ _null_ _null_ _null_ gp_hll_accum _null_ _null_ _null_ n a ));
+DESCR("gp_hll_ndistinct transition function");
+
+/* gp_hll_merge(bytea, bytea) => bytea */ 
+DATA(insert OID = 7183 ( gp_hll_merge  PGNSP PGUID 12 1 0 0 f f f t f i 2 0 17 "17 17" _null_ _null_ _null_ _null_ gp_hll_merge _null_ _null_ _null_ n a ));
+DESCR("gp_hll_ndistinct preliminary function");
+
+/* gp_hll_ndistinct_final(bytea) => float8 */ 
+DATA(insert OID = 7184 ( gp_hll_ndistinct_final  PGNSP PGUID 12 1 0 0 f f f t f i 1 0 701 "17" _null_ _null_ _null_ _null_ gp_hll_ndistinct_final _null_ _null_ _null_ n a ));
+DESCR("gp_hll_ndistinct final function");
+
+/* gp_hll_ndistinct(anyelement) => float8 */ 
+DATA(insert OID = 7185 ( gp_hll_ndistinct  PGNSP PGUID 12 1 0 0 t f f f f i 1 0 701 "2283" _null_ _null_ _null_ _null_ aggregate_dummy _null_ _null_ _null_ n a ));
+DESCR("estimate the number of distinct values with a HyperLogLog sketch");
+
+
+/* Approximate aggregates */
+/* approx_count_distinct_final(bytea) => int8 */ 
+DATA(insert OID = 7241 ( approx_count_distinct_final  PGNSP PGUID 12 1 0 0 f f f t f i 1 0 20 "17" _null_ _null_ _null_ _null_ approx_count_distinct_final _null_ _null_ _null_ n a ));
+DESCR("approx_count_distinct final function");
+
+/* approx_count_distinct(anyelement) => int8 */ 
+DATA(insert OID = 7242 ( approx_count_distinct  PGNSP PGUID 12 1 0 0 t f f f f i 1 0 20 "2283" _null_ _null_ _null_ _null_ aggregate_dummy _null_ _null_ _null_ n a ));
+DESCR("approximate number of distinct values, from a HyperLogLog sketch");
+
+/* approx_percentile_accum(bytea, float8, float8) => bytea */ 
+DATA(insert OID = 7243 ( approx_percentile_accum  PGNSP PGUID 12 1 0 0 f f f t f i 3 0 17 "17 701 701" _null_ _null_ _null_ _null_ approx_percentile_accum _null_ _null_ _null_ n a ));
+DESCR("approx_percentile transition function");
+
+/* approx_percentile_merge(bytea, bytea) => bytea */ 
+DATA(insert OID = 7276 ( approx_percentile_merge  PGNSP PGUID 12 1 0 0 f f f t f i 2 0 17 "17 17" _null_ _null_ _null_ _null_ approx_percentile_merge _null_ _null_ _null_ n a ));
+DESCR("approx_percentile preliminary function");
+
+/* approx_percentile_final(bytea) => float8 */ 
+DATA(insert OID = 7277 ( approx_percentile_final  PGNSP PGUID 12 1 0 0 f f f t f i 1 0 701 "17" _null_ _null_ _null_ _null_ approx_percentile_final _null_ _null_ _null_ n a ));
+DESCR("approx_percentile final function");
+
+/* approx_percentile(float8, float8) => float8 */ 
+DATA(insert OID = 7278 ( approx_percentile  PGNSP PGUID 12 1 0 0 t f f f f i 2 0 701 "701 701" _null_ _null_ _null_ _null_ aggregate_dummy _null_ _null_ _null_ n a ));
+DESCR("approximate percentile of the values, from a t-digest; the second argument is the fraction");
+
+/* gp_stat_get_changes_since_analyze(OUT relid oid, OUT relstorage "char", OUT modcount int8, OUT changes_since_analyze int8, OUT last_analyze timestamptz) => SETOF pg_catalog.record */ 
+DATA(insert OID = 7196 ( gp_stat_get_changes_since_analyze  PGNSP PGUID 12 1 1000 0 f f f f t v 0 0 2249 "" "{26,18,20,20,1184}" "{o,o,o,o,o}" "{relid,relstorage,modcount,changes_since_analyze,last_analyze}" _null_ gp_stat_get_changes_since_analyze _null_ _null_ _null_ n a ));
+DESCR("statistics: modifications of every table since it was last analyzed");
+
+
+/* Catalog consistency checks, for gpcheckcat */
+/* gp_unordered_md5_accum(bytea, text) => bytea */ 
+DATA(insert OID = 7192 ( gp_unordered_md5_accum  PGNSP PGUID 12 1 0 0 f f f t f i 2 0 17 "17 25" _null_ _null_ _null_ _null_ gp_unordered_md5_accum _null_ _null_ _null_ n a ));
+DESCR("gp_unordered_md5 transition function");
+
+/* gp_unordered_md5_merge(bytea, bytea) => bytea */ 
+DATA(insert OID = 7193 ( gp_unordered_md5_merge  PGNSP PGUID 12 1 0 0 f f f t f i 2 0 17 "17 17" _null_ _null_ _null_ _null_ gp_unordered_md5_merge _null_ _null_ _null_ n a ));
+DESCR("gp_unordered_md5 preliminary function");
+
+/* gp_unordered_md5_final(bytea) => text */ 
+DATA(insert OID = 7194 ( gp_unordered_md5_final  PGNSP PGUID 12 1 0 0 f f f t f i 1 0 25 "17" _null_ _null_ _null_ _null_ gp_unordered_md5_final _null_ _null_ _null_ n a ));
+DESCR("gp_unordered_md5 final function");
+
+/* gp_unordered_md5(text) => text */ 
+DATA(insert OID = 7195 ( gp_unordered_md5  PGNSP PGUID 12 1 0 0 t f f f f i 1 0 25 "25" _null_ _null_ _null_ _null_ aggregate_dummy _null_ _null_ _null_ n a ));
+DESCR("md5 digest of a set of values, independent of their order");
+
+
+/* Online redistribution, for gpexpand */
+/* gp_hash_target_segment(record, _int2) => int4 */ 
+DATA(insert OID = 7186 ( gp_hash_target_segment  PGNSP PGUID 12 1 0 0 f f f t f s 2 0 23 "2249 1005" _null_ _null_ _null_ _null_ gp_hash_target_segment _null_ _null_ _null_ n a ));
+DESCR("segment a row belongs on if distributed by the given attributes");
+
+/* gp_expand_redistribute(regclass, _int2, int4) => int8 */ 
+DATA(insert OID = 7187 ( gp_expand_redistribute  PGNSP PGUID 12 1 0 0 f f f t f v 3 0 20 "2205 1005 23" _null_ _null_ _null_ _null_ gp_expand_redistribute _null_ _null_ _null_ m a ));
+DESCR("move the rows that belong on a segment of a randomly distributed table there");
+
+/* gp_expand_redistribute_finish(regclass, _int2) => int8 */ 
+DATA(insert OID = 7188 ( gp_expand_redistribute_finish  PGNSP PGUID 12 1 0 0 f f f t f v 2 0 20 "2205 1005" _null_ _null_ _null_ _null_ gp_expand_redistribute_finish _null_ _null_ _null_ m a ));
+DESCR("move the remaining misplaced rows of a table and distribute it by the given attributes");
+
+
+/* Benchmarks of the database's own code paths */
+/* gp_bench_compress(IN compresstype text, IN compresslevel int4, IN mbytes int4, OUT compress_mbps float8, OUT decompress_mbps float8, OUT ratio float8) => pg_catalog.record */ 
+DATA(insert OID = 7197 ( gp_bench_compress  PGNSP PGUID 12 1 0 0 f f f t f v 3 0 2249 "25 23 23" "{25,23,23,701,701,701}" "{i,i,i,o,o,o}" "{compresstype,compresslevel,mbytes,compress_mbps,decompress_mbps,ratio}" _null_ gp_bench_compress _null_ _null_ _null_ n a ));
+DESCR("benchmark: AO block compression and decompression throughput of a codec");
+
+/* gp_bench_workfile(IN mbytes int4, OUT write_mbps float8, OUT read_mbps float8) => pg_catalog.record */ 
+DATA(insert OID = 7198 ( gp_bench_workfile  PGNSP PGUID 12 1 0 0 f f f t f v 1 0 2249 "23" "{23,701,701}" "{i,o,o}" "{mbytes,write_mbps,read_mbps}" _null_ gp_bench_workfile _null_ _null_ _null_ n a ));
+DESCR("benchmark: spill file write and read throughput");
+
+/* gp_bench_hash(int4) => float8 */ 
+DATA(insert OID = 7199 ( gp_bench_hash  PGNSP PGUID 12 1 0 0 f f f t f v 1 0 701 "23" _null_ _null_ _null_ _null_ gp_bench_hash _null_ _null_ _null_ n a ));
+DESCR("benchmark: millions of values hashed to a segment per second");
+
+/* gp_bench_sort(int4) => float8 */ 
+DATA(insert OID = 7200 ( gp_bench_sort  PGNSP PGUID 12 1 0 0 f f f t f v 1 0 701 "23" _null_ _null_ _null_ _null_ gp_bench_sort _null_ _null_ _null_ n a ));
+DESCR("benchmark: millions of int8 values sorted per second");
+
+/* gp_bench_interconnect(IN mbytes int4, OUT mbps float8, OUT latency_ms float8) => pg_catalog.record */ 
+DATA(insert OID = 7201 ( gp_bench_interconnect  PGNSP PGUID 12 1 0 0 f f f t f v 1 0 2249 "23" "{23,701,701}" "{i,o,o}" "{mbytes,mbps,latency_ms}" _null_ gp_bench_interconnect _null_ _null_ _null_ r a ));
+DESCR("benchmark: interconnect throughput and latency through Motions");
+
+/* gp_bench_operators(IN ntuples int4, IN width int4, IN ndistinct int4, OUT kernel text, OUT ns_per_tuple float8) => SETOF pg_catalog.record */ 
+DATA(insert OID = 7237 ( gp_bench_operators  PGNSP PGUID 12 1 1000 0 f f f t t v 3 0 2249 "23 23 23" "{23,23,23,25,701}" "{i,i,i,o,o}" "{ntuples,width,ndistinct,kernel,ns_per_tuple}" _null_ gp_bench_operators _null_ _null_ _null_ n a ));
+DESCR("benchmark: nanoseconds per row of the executor's operator kernels");
+
+
+/* Binary external table formatters, for gptransfer */
+/* gp_tuple_export(record) => bytea */ 
+DATA(insert OID = 7189 ( gp_tuple_export  PGNSP PGUID 12 1 0 0 f f f f f s 1 0 17 "2249" _null_ _null_ _null_ _null_ gp_tuple_export _null_ _null_ _null_ n a ));
+DESCR("external table formatter: serialize rows in the interconnect's binary form");
+
+/* gp_tuple_import() => record */ 
+DATA(insert OID = 7190 ( gp_tuple_import  PGNSP PGUID 12 1 0 0 f f f f f s 0 0 2249 "" _null_ _null_ _null_ _null_ gp_tuple_import _null_ _null_ _null_ n a ));
+DESCR("external table formatter: read rows written by gp_tuple_export");
+
 
 /* Backoff related */
 /* gp_adjust_priority(int4, int4, int4) => int4 */ 
@@ -2502,6 +2624,42 @@ DESCR("change weight of all the backends for a given session id");
 DATA(insert OID = 5042 ( gp_list_backend_priorities  PGNSP PGUID 12 1 1000 0 f f f f t v 0 0 2249 "" _null_ _null_ _null_ _null_ gp_list_backend_priorities _null_ _null_ _null_ n a ));
 DESCR("list priorities of backends");
 
+/* gp_interconnect_stats(OUT segid int4, OUT pid int4, OUT sess_id int4, OUT command_count int4, OUT slice_id int4, OUT send_conns int4, OUT recv_conns int4, OUT rx_buffers_in_use int4, OUT rx_buffers_max int4, OUT recv_queue_len int4, OUT max_recv_queue_len int4, OUT max_recv_queue_content int4, OUT unack_queue_len int4, OUT max_unack_queue_len int4, OUT max_unack_queue_content int4, OUT retransmits int8, OUT duplicates int8, OUT put_rx_buffer_count int8, OUT put_rx_buffer_time_us int8, OUT wait_time_us int8) => SETOF pg_catalog.record */ 
+DATA(insert OID = 6099 ( gp_interconnect_stats  PGNSP PGUID 12 1 1000 0 f f f f t v 0 0 2249 "" "{23,23,23,23,23,23,23,23,23,23,23,23,23,23,23,20,20,20,20,20}" "{o,o,o,o,o,o,o,o,o,o,o,o,o,o,o,o,o,o,o,o}" "{segid,pid,sess_id,command_count,slice_id,send_conns,recv_conns,rx_buffers_in_use,rx_buffers_max,recv_queue_len,max_recv_queue_len,max_recv_queue_content,unack_queue_len,max_unack_queue_len,max_unack_queue_content,retransmits,duplicates,put_rx_buffer_count,put_rx_buffer_time_us,wait_time_us}" _null_ gp_interconnect_stats _null_ _null_ _null_ n a ));
+DESCR("statistics: live UDP interconnect state of the backends of this instance");
+
+/* gp_query_progress(OUT segid int4, OUT pid int4, OUT sess_id int4, OUT command_count int4, OUT slice_id int4, OUT node_id int4, OUT node_type text, OUT plan_rows float8, OUT actual_rows int8, OUT motion_bytes int8, OUT spill_bytes int8) => SETOF pg_catalog.record */ 
+DATA(insert OID = 7202 ( gp_query_progress  PGNSP PGUID 12 1 1000 0 f f f f t v 0 0 2249 "" "{23,23,23,23,23,23,25,701,20,20,20}" "{o,o,o,o,o,o,o,o,o,o,o}" "{segid,pid,sess_id,command_count,slice_id,node_id,node_type,plan_rows,actual_rows,motion_bytes,spill_bytes}" _null_ gp_query_progress _null_ _null_ _null_ n a ));
+DESCR("statistics: live per-node progress of the queries running on this instance");
+
+/* gp_wait_event_samples(duration_ms int4, interval_ms int4, OUT segid int4, OUT sess_id int4, OUT command_count int4, OUT wait_event text, OUT samples int8, OUT sample_rounds int8) => SETOF pg_catalog.record */ 
+DATA(insert OID = 7203 ( gp_wait_event_samples  PGNSP PGUID 12 1 1000 0 f f f t t v 2 0 2249 "23 23" "{23,23,23,23,23,25,20,20}" "{i,i,o,o,o,o,o,o}" "{duration_ms,interval_ms,segid,sess_id,command_count,wait_event,samples,sample_rounds}" _null_ gp_wait_event_samples _null_ _null_ _null_ n a ));
+DESCR("statistics: sample the wait events of the queries running on this instance");
+
+/* gp_query_resource_history(OUT segid int4, OUT pid int4, OUT sess_id int4, OUT command_count int4, OUT slice_id int4, OUT userid oid, OUT rsgid oid, OUT aborted bool, OUT start_time timestamptz, OUT end_time timestamptz, OUT query_mem int8, OUT peak_vmem int8, OUT sort_spill_bytes int8, OUT hashjoin_spill_bytes int8, OUT hashagg_spill_bytes int8, OUT material_spill_bytes int8, OUT other_spill_bytes int8, OUT hashagg_passes int8, OUT hashjoin_batches int8, OUT spill_bytes int8) => SETOF pg_catalog.record */ 
+DATA(insert OID = 7234 ( gp_query_resource_history  PGNSP PGUID 12 1 1000 0 f f f f t v 0 0 2249 "" "{23,23,23,23,23,26,26,16,1184,1184,20,20,20,20,20,20,20,20,20,20}" "{o,o,o,o,o,o,o,o,o,o,o,o,o,o,o,o,o,o,o,o}" "{segid,pid,sess_id,command_count,slice_id,userid,rsgid,aborted,start_time,end_time,query_mem,peak_vmem,sort_spill_bytes,hashjoin_spill_bytes,hashagg_spill_bytes,material_spill_bytes,other_spill_bytes,hashagg_passes,hashjoin_batches,spill_bytes}" _null_ gp_query_resource_history _null_ _null_ _null_ n a ));
+DESCR("statistics: memory and spill usage of the recently completed queries of this instance");
+
+/* gp_statement_stats(OUT dbid oid, OUT userid oid, OUT fingerprint int8, OUT phase text, OUT calls int8, OUT total_ms float8, OUT mean_ms float8, OUT p50_ms float8, OUT p90_ms float8, OUT p99_ms float8, OUT max_ms float8, OUT query text) => SETOF pg_catalog.record */ 
+DATA(insert OID = 7235 ( gp_statement_stats  PGNSP PGUID 12 1 1000 0 f f f f t v 0 0 2249 "" "{26,26,20,25,20,701,701,701,701,701,701,25}" "{o,o,o,o,o,o,o,o,o,o,o,o}" "{dbid,userid,fingerprint,phase,calls,total_ms,mean_ms,p50_ms,p90_ms,p99_ms,max_ms,query}" _null_ gp_statement_stats _null_ _null_ _null_ n a ));
+DESCR("statistics: latency percentiles of the statements run on the master, by phase");
+
+/* gp_statement_stats_reset() => void */ 
+DATA(insert OID = 7236 ( gp_statement_stats_reset  PGNSP PGUID 12 1 0 0 f f f f f v 0 0 2278 "" _null_ _null_ _null_ _null_ gp_statement_stats_reset _null_ _null_ _null_ n a ));
+DESCR("statistics: forget the latency of the statements run on the master");
+
+/* gp_endpoints(OUT gp_segment_id int4, OUT hostname text, OUT port int4, OUT cursorname text, OUT token text) => SETOF pg_catalog.record */ 
+DATA(insert OID = 6100 ( gp_endpoints  PGNSP PGUID 12 1 1000 0 f f f f t v 0 0 2249 "" "{23,25,23,25,25}" "{o,o,o,o,o}" "{gp_segment_id,hostname,port,cursorname,token}" _null_ gp_endpoints _null_ _null_ _null_ n a ));
+DESCR("endpoints of the parallel retrieve cursors of this session");
+
+/* gp_wait_parallel_retrieve_cursor(cursorname text) => bool */ 
+DATA(insert OID = 6101 ( gp_wait_parallel_retrieve_cursor  PGNSP PGUID 12 1 0 0 f f f t f v 1 0 16 "25" _null_ _null_ "{cursorname}" _null_ gp_wait_parallel_retrieve_cursor _null_ _null_ _null_ n a ));
+DESCR("wait until all rows of a parallel retrieve cursor have been retrieved");
+
+/* gp_segment_endpoints(OUT token text, OUT username text, OUT session_id int4, OUT state text, OUT sender_pid int4, OUT receiver_pid int4) => SETOF pg_catalog.record */ 
+DATA(insert OID = 6124 ( gp_segment_endpoints  PGNSP PGUID 12 1 1000 0 f f f f t v 0 0 2249 "" "{25,25,23,25,23,23}" "{o,o,o,o,o,o}" "{token,username,session_id,state,sender_pid,receiver_pid}" _null_ gp_segment_endpoints _null_ _null_ _null_ n a ));
+DESCR("endpoints of parallel retrieve cursors on this instance");
+
 
 /* Functions to deal with SREH error logs */
 /* gp_read_error_log(exttable text, OUT cmdtime timestamptz, OUT relname text, OUT filename text, OUT linenum int4, OUT bytenum int4, OUT errmsg text, OUT rawdata text, OUT rawbytes bytea) => SETOF record */ 
@@ -2725,6 +2883,46 @@ DESCR("zlib decompressor");
 DATA(insert OID = 9924 ( gp_zlib_validator  PGNSP PGUID 12 1 0 0 f f f f f i 1 0 2278 "2281" _null_ _null_ _null_ _null_ zlib_validator _null_ _null_ _null_ n a ));
 DESCR("zlib compression validator");
 
+/* gp_zstd_constructor(internal, internal, bool) => internal */ 
+DATA(insert OID = 6109 ( gp_zstd_constructor  PGNSP PGUID 12 1 0 0 f f f f f v 3 0 2281 "2281 2281 16" _null_ _null_ _null_ _null_ zstd_constructor _null_ _null_ _null_ n a ));
+DESCR("zstd constructor");
+
+/* gp_zstd_destructor(internal) => void */ 
+DATA(insert OID = 6110 ( gp_zstd_destructor  PGNSP PGUID 12 1 0 0 f f f f f v 1 0 2278 "2281" _null_ _null_ _null_ _null_ zstd_destructor _null_ _null_ _null_ n a ));
+DESCR("zstd destructor");
+
+/* gp_zstd_compress(internal, int4, internal, int4, internal, internal) => void */ 
+DATA(insert OID = 6111 ( gp_zstd_compress  PGNSP PGUID 12 1 0 0 f f f f f i 6 0 2278 "2281 23 2281 23 2281 2281" _null_ _null_ _null_ _null_ zstd_compress _null_ _null_ _null_ n a ));
+DESCR("zstd compressor");
+
+/* gp_zstd_decompress(internal, int4, internal, int4, internal, internal) => void */ 
+DATA(insert OID = 6112 ( gp_zstd_decompress  PGNSP PGUID 12 1 0 0 f f f f f i 6 0 2278 "2281 23 2281 23 2281 2281" _null_ _null_ _null_ _null_ zstd_decompress _null_ _null_ _null_ n a ));
+DESCR("zstd decompressor");
+
+/* gp_zstd_validator(internal) => void */ 
+DATA(insert OID = 6117 ( gp_zstd_validator  PGNSP PGUID 12 1 0 0 f f f f f i 1 0 2278 "2281" _null_ _null_ _null_ _null_ zstd_validator _null_ _null_ _null_ n a ));
+DESCR("zstd compression validator");
+
+/* gp_lz4_constructor(internal, internal, bool) => internal */ 
+DATA(insert OID = 6119 ( gp_lz4_constructor  PGNSP PGUID 12 1 0 0 f f f f f v 3 0 2281 "2281 2281 16" _null_ _null_ _null_ _null_ lz4_constructor _null_ _null_ _null_ n a ));
+DESCR("lz4 constructor");
+
+/* gp_lz4_destructor(internal) => void */ 
+DATA(insert OID = 6120 ( gp_lz4_destructor  PGNSP PGUID 12 1 0 0 f f f f f v 1 0 2278 "2281" _null_ _null_ _null_ _null_ lz4_destructor _null_ _null_ _null_ n a ));
+DESCR("lz4 destructor");
+
+/* gp_lz4_compress(internal, int4, internal, int4, internal, internal) => void */ 
+DATA(insert OID = 6121 ( gp_lz4_compress  PGNSP PGUID 12 1 0 0 f f f f f i 6 0 2278 "2281 23 2281 23 2281 2281" _null_ _null_ _null_ _null_ lz4_compress _null_ _null_ _null_ n a ));
+DESCR("lz4 compressor");
+
+/* gp_lz4_decompress(internal, int4, internal, int4, internal, internal) => void */ 
+DATA(insert OID = 6122 ( gp_lz4_decompress  PGNSP PGUID 12 1 0 0 f f f f f i 6 0 2278 "2281 23 2281 23 2281 2281" _null_ _null_ _null_ _null_ lz4_decompress _null_ _null_ _null_ n a ));
+DESCR("lz4 decompressor");
+
+/* gp_lz4_validator(internal) => void */ 
+DATA(insert OID = 6123 ( gp_lz4_validator  PGNSP PGUID 12 1 0 0 f f f f f i 1 0 2278 "2281" _null_ _null_ _null_ _null_ lz4_validator _null_ _null_ _null_ n a ));
+DESCR("lz4 compression validator");
+
 /* gp_rle_type_constructor(internal, internal, bool) => internal */ 
 DATA(insert OID = 9914 ( gp_rle_type_constructor  PGNSP PGUID 12 1 0 0 f f f f f v 3 0 2281 "2281 2281 16" _null_ _null_ _null_ _null_ rle_type_constructor _null_ _null_ _null_ n a ));
 DESCR("Type specific RLE constructor");
@@ -3028,6 +3226,68 @@ DATA(insert OID = 3596 ( complex_gte  PGNSP PGUID 12 1 0 0 f f f t f i 2 0 16 "1
 DESCR("greater than or equal");
 
 
+ /* functions for the jsonb data type */
+/* jsonb_in(cstring) => jsonb */ 
+DATA(insert OID = 3806 ( jsonb_in  PGNSP PGUID 12 1 0 0 f f f t f i 1 0 3802 "2275" _null_ _null_ _null_ _null_ jsonb_in _null_ _null_ _null_ n a ));
+DESCR("I/O");
+
+/* jsonb_out(jsonb) => cstring */ 
+DATA(insert OID = 3804 ( jsonb_out  PGNSP PGUID 12 1 0 0 f f f t f i 1 0 2275 "3802" _null_ _null_ _null_ _null_ jsonb_out _null_ _null_ _null_ n a ));
+DESCR("I/O");
+
+/* jsonb_recv(internal) => jsonb */ 
+DATA(insert OID = 3805 ( jsonb_recv  PGNSP PGUID 12 1 0 0 f f f t f i 1 0 3802 "2281" _null_ _null_ _null_ _null_ jsonb_recv _null_ _null_ _null_ n a ));
+DESCR("I/O");
+
+/* jsonb_send(jsonb) => bytea */ 
+DATA(insert OID = 3803 ( jsonb_send  PGNSP PGUID 12 1 0 0 f f f t f i 1 0 17 "3802" _null_ _null_ _null_ _null_ jsonb_send _null_ _null_ _null_ n a ));
+DESCR("I/O");
+
+/* jsonb(json) => jsonb */ 
+DATA(insert OID = 3808 ( jsonb  PGNSP PGUID 12 1 0 0 f f f t f i 1 0 3802 "114" _null_ _null_ _null_ _null_ json_to_jsonb _null_ _null_ _null_ n a ));
+DESCR("convert json to jsonb");
+
+/* json(jsonb) => json */ 
+DATA(insert OID = 3809 ( json  PGNSP PGUID 12 1 0 0 f f f t f i 1 0 114 "3802" _null_ _null_ _null_ _null_ jsonb_to_json _null_ _null_ _null_ n a ));
+DESCR("convert jsonb to json");
+
+/* jsonb_object_field(from_json jsonb, field_name text) => jsonb */ 
+DATA(insert OID = 3810 ( jsonb_object_field  PGNSP PGUID 12 1 0 0 f f f t f i 2 0 3802 "3802 25" _null_ _null_ "{from_json,field_name}" _null_ jsonb_object_field _null_ _null_ _null_ n a ));
+DESCR("get jsonb object field");
+
+/* jsonb_object_field_text(from_json jsonb, field_name text) => text */ 
+DATA(insert OID = 3811 ( jsonb_object_field_text  PGNSP PGUID 12 1 0 0 f f f t f i 2 0 25 "3802 25" _null_ _null_ "{from_json,field_name}" _null_ jsonb_object_field_text _null_ _null_ _null_ n a ));
+DESCR("get jsonb object field as text");
+
+/* jsonb_array_element(from_json jsonb, element_index int4) => jsonb */ 
+DATA(insert OID = 3812 ( jsonb_array_element  PGNSP PGUID 12 1 0 0 f f f t f i 2 0 3802 "3802 23" _null_ _null_ "{from_json,element_index}" _null_ jsonb_array_element _null_ _null_ _null_ n a ));
+DESCR("get jsonb array element");
+
+/* jsonb_array_element_text(from_json jsonb, element_index int4) => text */ 
+DATA(insert OID = 3813 ( jsonb_array_element_text  PGNSP PGUID 12 1 0 0 f f f t f i 2 0 25 "3802 23" _null_ _null_ "{from_json,element_index}" _null_ jsonb_array_element_text _null_ _null_ _null_ n a ));
+DESCR("get jsonb array element as text");
+
+/* jsonb_extract_path_op(from_json jsonb, path_elems _text) => jsonb */ 
+DATA(insert OID = 3814 ( jsonb_extract_path_op  PGNSP PGUID 12 1 0 0 f f f t f i 2 0 3802 "3802 1009" _null_ _null_ "{from_json,path_elems}" _null_ jsonb_extract_path _null_ _null_ _null_ n a ));
+DESCR("get value from jsonb with path elements");
+
+/* jsonb_extract_path_text_op(from_json jsonb, path_elems _text) => text */ 
+DATA(insert OID = 3815 ( jsonb_extract_path_text_op  PGNSP PGUID 12 1 0 0 f f f t f i 2 0 25 "3802 1009" _null_ _null_ "{from_json,path_elems}" _null_ jsonb_extract_path_text _null_ _null_ _null_ n a ));
+DESCR("get value from jsonb as text with path elements");
+
+/* jsonb_exists(jsonb, text) => bool */ 
+DATA(insert OID = 3816 ( jsonb_exists  PGNSP PGUID 12 1 0 0 f f f t f i 2 0 16 "3802 25" _null_ _null_ _null_ _null_ jsonb_exists _null_ _null_ _null_ n a ));
+DESCR("does the jsonb object have the key");
+
+/* jsonb_contains(jsonb, jsonb) => bool */ 
+DATA(insert OID = 3824 ( jsonb_contains  PGNSP PGUID 12 1 0 0 f f f t f i 2 0 16 "3802 3802" _null_ _null_ _null_ _null_ jsonb_contains _null_ _null_ _null_ n a ));
+DESCR("implementation of @> operator");
+
+/* jsonb_contained(jsonb, jsonb) => bool */ 
+DATA(insert OID = 3825 ( jsonb_contained  PGNSP PGUID 12 1 0 0 f f f t f i 2 0 16 "3802 3802" _null_ _null_ _null_ _null_ jsonb_contained _null_ _null_ _null_ n a ));
+DESCR("implementation of <@ operator");
+
+
  /* functions for external table */
 /* pg_options_to_table(IN options_array _text, OUT option_name text, OUT option_value text) => SETOF pg_catalog.record */ 
 DATA(insert OID = 2022 ( pg_options_to_table  PGNSP PGUID 12 1 1000 0 f f f t t i 1 0 2249 "1009" "{1009,25,25}" "{i,o,o}" "{options_array,option_name,option_value}" _null_ pg_options_to_table _null_ _null_ _null_ n a ));
@@ -246,6 +246,18 @@ typedef FormData_pg_statistic *Form_pg_statistic;
  */
 #define STATISTIC_KIND_CORRELATION	3
 
+/*
+ * A "dependency" slot describes how much the values of this column determine
+ * the values of other columns of the same table.  staop and stavalues are not
+ * used.  stanumbers holds pairs of entries: the attribute number of another
+ * column, and the degree to which this column determines it, from 0 (not at
+ * all) to 1 (functional dependency).  The degree is the fraction of the
+ * sampled rows whose group of equal values of this column has a single value
+ * of the other column.  This is a Greenplum addition, so it uses a kind code
+ * from the private range.
+ */
+#define STATISTIC_KIND_DEPENDENCY	10001
+
 /*
  * The CATALOG definition has to refer to the type of log_time as
  * "timestamptz" (lower case) so that bootstrap mode recognizes it.  But
@@ -364,6 +364,11 @@ DESCR("JSON content");
 #define JSONOID 114
 DATA(insert OID = 199 (	_json	   PGNSP PGUID -1 f b t \054 0 114 0 array_in array_out array_recv array_send - - - i x f 0 -1 0 _null_ _null_ ));
 
+DATA(insert OID = 3802 (	jsonb	   PGNSP PGUID -1 f b t \054 0 0 3807 jsonb_in jsonb_out jsonb_recv jsonb_send - - - i x f 0 -1 0 _null_ _null_ ));
+DESCR("Binary JSON");
+#define JSONBOID 3802
+DATA(insert OID = 3807 (	_jsonb	   PGNSP PGUID -1 f b t \054 0 3802 0 array_in array_out array_recv array_send - - - i x f 0 -1 0 _null_ _null_ ));
+
 DATA(insert OID = 195 (	complex	   PGNSP PGUID 16 f b t \054 0 0	196 complex_in complex_out complex_recv complex_send - - - d p f 0 -1 0 _null_ _null_ ));
 DESCR("double-precision floating point complex number, 16-byte storage");
 #define COMPLEXOID 195
@@ -67,10 +67,35 @@ typedef struct AOCSInsertDescData
 	 * Certain statistics are then counted differently.
 	 */ 
 	bool update_mode;
+
+	/*
+	 * Values larger than this many bytes are moved to the table's TOAST
+	 * relation, and only their toast pointer is kept in the column file.
+	 * 0 if values are never moved out of line.
+	 */
+	int32		toast_threshold;
+
+	/*
+	 * Set when the inserted rows are moved from another segment file of the
+	 * same table, by compaction. Values the table already stores out of line
+	 * then keep their toast pointers instead of being fetched and saved
+	 * again.
+	 */
+	bool		keepToastPointers;
 } AOCSInsertDescData;
 
 typedef AOCSInsertDescData *AOCSInsertDesc;
 
+/*
+ * A range of row numbers in the current segment file that the zone maps
+ * have shown cannot satisfy the scan's quals.
+ */
+typedef struct AOCSSkipRange
+{
+	int64		firstRowNum;
+	int64		lastRowNum;
+} AOCSSkipRange;
+
 /*
  * used for scan of append only relations using BufferedRead and VarBlocks
  */
@@ -110,6 +135,20 @@ typedef struct AOCSScanDescData
 	int		   *proj_atts;
 	int			num_proj_atts;
 
+	/*
+	 * Late materialization.  The lazy columns are only read for the rows
+	 * the caller keeps, the eager ones for every row.  read_atts points to
+	 * the columns read for every row of the current segment file: the
+	 * eager ones if segLazy, otherwise all of proj_atts.
+	 */
+	int		   *lazy_atts;
+	int			num_lazy_atts;
+	int		   *eager_atts;
+	int			num_eager_atts;
+	int		   *read_atts;
+	int			num_read_atts;
+	bool		segLazy;
+
 	/* synthetic system attributes */
 	ItemPointerData cdb_fake_ctid;
 	int64 total_row;
@@ -126,10 +165,74 @@ typedef struct AOCSScanDescData
 
 	AppendOnlyVisimap visibilityMap;
 
+	/*
+	 * Quals checked against the block directory zone maps, and the row
+	 * ranges of the current segment file they exclude, sorted and merged.
+	 */
+	AppendOnlyZoneQual *zoneQuals;
+	int			numZoneQuals;
+	AOCSSkipRange *skipRanges;
+	int			numSkipRanges;
+	int			curSkipRange;
+
 }	AOCSScanDescData;
 
 typedef AOCSScanDescData *AOCSScanDesc;
 
+/*
+ * A batch of rows returned by aocs_getnext_batch(), stored column by column.
+ *
+ * Only the columns the scan reads for every row have vectors.  By-reference values
+ * point into the datum stream buffers and stay valid until the next batch
+ * is read; a batch never spans a block boundary of any column.
+ */
+#define AOCS_BATCH_SIZE 1024
+
+typedef struct AOCSBatchData
+{
+	int			maxRows;
+	int			nrows;			/* rows in the batch */
+	int			nextRow;		/* next entry of selected[] to consume */
+
+	Datum	  **values;			/* values[attno][row] */
+	bool	  **isnull;			/* isnull[attno][row] */
+	AOTupleId  *tids;			/* tids[row] */
+
+	/*
+	 * The rows the caller still wants, in order.  aocs_getnext_batch()
+	 * selects them all; the caller may filter them.
+	 */
+	int		   *selected;
+	int			nselected;
+
+	/* visibility of each row, from the visimap */
+	bool	   *visible;
+
+	/* lazy columns have yet to be read for the rows of this batch */
+	bool		lazy;
+
+	/*
+	 * Dictionary codes of the read columns, codes[attno][row], valid when
+	 * dictCount[attno] > 0.  A batch stays within one block of every read
+	 * column, so equal codes mean equal values across the batch.  NULLs
+	 * have code -1.
+	 */
+	int32	  **codes;
+	int32	   *dictCount;
+
+	/* scratch space for the first row of a batch, indexed by attno */
+	Datum	   *rowValues;
+	bool	   *rowIsnull;
+
+	/*
+	 * Column readers for datums passed by value, indexed by the log2 of the
+	 * datum length, from the TableScanState.  NULL when scanned otherwise.
+	 */
+	struct DatumStreamBlockReadGetBatchCodegenInfo *getBatchGenInfo;
+} AOCSBatchData;
+
+typedef AOCSBatchData *AOCSBatch;
+
 /*
  * Used for fetch individual tuples from specified by TID of append only relations
  * using the AO Block Directory.
@@ -208,10 +311,19 @@ extern AOCSScanDesc aocs_beginrangescan(Relation relation, Snapshot snapshot,
 		int *segfile_no_arr, int segfile_count,
 	TupleDesc relationTupleDesc, bool *proj);
 
+extern void aocs_set_zone_quals(AOCSScanDesc scan,
+					AppendOnlyZoneQual *quals, int numQuals);
+extern void aocs_set_lazy_columns(AOCSScanDesc scan, bool *lazy);
 extern void aocs_rescan(AOCSScanDesc scan);
 extern void aocs_endscan(AOCSScanDesc scan);
 
 extern void aocs_getnext(AOCSScanDesc scan, ScanDirection direction, TupleTableSlot *slot);
+extern AOCSBatch aocs_create_batch(AOCSScanDesc scan, int maxRows);
+extern void aocs_free_batch(AOCSScanDesc scan, AOCSBatch batch);
+extern int aocs_getnext_batch(AOCSScanDesc scan, ScanDirection direction,
+				   AOCSBatch batch);
+extern void aocs_batch_store_row(AOCSScanDesc scan, AOCSBatch batch, int row,
+					 bool withLazyColumns, TupleTableSlot *slot);
 extern AOCSInsertDesc aocs_insert_init(Relation rel, int segno, bool update_mode);
 extern Oid aocs_insert_values(AOCSInsertDesc idesc, Datum *d, bool *null, AOTupleId *aoTupleId);
 static inline Oid aocs_insert(AOCSInsertDesc idesc, TupleTableSlot *slot)
@@ -233,6 +345,8 @@ extern AOCSFetchDesc aocs_fetch_init(Relation relation,
 extern bool aocs_fetch(AOCSFetchDesc aocsFetchDesc,
 					   AOTupleId *aoTupleId,
 					   TupleTableSlot *slot);
+extern bool aocs_fetch_past_end(AOCSFetchDesc aocsFetchDesc,
+								AOTupleId *aoTupleId);
 extern void aocs_fetch_finish(AOCSFetchDesc aocsFetchDesc);
 
 extern AOCSUpdateDesc aocs_update_init(Relation rel, int segno);
@@ -222,6 +222,29 @@ typedef struct AppendOnlyScanDescData
 	 */ 
 	AppendOnlyVisimap visibilityMap;
 
+	/*
+	 * Visibility of the rows of the current block, found with one visimap
+	 * lookup per block.  blockVisible is indexed by the row's offset in the
+	 * block, and only looked at when blockAllVisible is false.
+	 */
+	bool	   *blockVisible;
+	bool		blockAllVisible;
+
+	/*
+	 * Set by compaction.  Blocks whose rows are all visible are copied as
+	 * they are to this insert descriptor, instead of being returned one
+	 * tuple at a time.  blockCopyTupleCount counts the tuples copied so.
+	 */
+	struct AppendOnlyInsertDescData *blockCopyDesc;
+	int64		blockCopyTupleCount;
+
+	/*
+	 * Fraction of the varblocks to read, chosen at random.  The others are
+	 * skipped without decompressing them.  Less than 1.0 only for the sample
+	 * query of ANALYZE.
+	 */
+	double		blockSampleFraction;
+
 }	AppendOnlyScanDescData;
 
 typedef AppendOnlyScanDescData *AppendOnlyScanDesc;
@@ -349,6 +372,9 @@ extern bool appendonly_fetch(
 	AppendOnlyFetchDesc aoFetchDesc,
 	AOTupleId *aoTid,
 	TupleTableSlot *slot);
+extern bool appendonly_fetch_past_end(
+	AppendOnlyFetchDesc aoFetchDesc,
+	AOTupleId *aoTid);
 extern void appendonly_fetch_finish(AppendOnlyFetchDesc aoFetchDesc);
 extern AppendOnlyInsertDesc appendonly_insert_init(Relation rel, int segno, bool update_mode);
 extern void appendonly_insert(
@@ -21,6 +21,7 @@
 
 extern int gp_blockdirectory_entry_min_range;
 extern int gp_blockdirectory_minipage_size;
+extern int gp_blockdirectory_cache_size;
 
 typedef struct AppendOnlyBlockDirectoryEntry
 {
@@ -48,8 +49,29 @@ typedef struct MinipageEntry
 	int64 rowCount;
 } MinipageEntry;
 
+/*
+ * Value range ("zone map") of a minipage entry.
+ *
+ * Only kept for column-oriented tables, and only for types whose values
+ * map onto int64 in sort order (see AppendOnlyBlockDirectory_ZoneTypeSupported).
+ * A zone without MINIPAGE_ZONE_VALID says nothing about the entry's rows.
+ */
+typedef struct MinipageZone
+{
+	int64 minValue;
+	int64 maxValue;
+	int32 nullCount;
+	int32 flags;
+} MinipageZone;
+
+#define MINIPAGE_ZONE_VALID			0x1
+#define MINIPAGE_ZONE_HAS_VALUES	0x2		/* minValue/maxValue are set */
+
 /*
  * Define a varlena type for a minipage.
+ *
+ * In a MINIPAGE_VERSION_ZONES minipage, the entry array is followed by an
+ * array of nEntry MinipageZones.
  */
 typedef struct Minipage
 {
@@ -62,6 +84,9 @@ typedef struct Minipage
 	MinipageEntry entry[1];
 } Minipage;
 
+#define MINIPAGE_VERSION_ORIGINAL	0
+#define MINIPAGE_VERSION_ZONES		1
+
 /*
  * Define the relevant info for a minipage for each
  * column group.
@@ -71,8 +96,45 @@ typedef struct MinipagePerColumnGroup
 	Minipage *minipage;
 	uint32 numMinipageEntries;
 	ItemPointerData tupleTid;
+
+	/*
+	 * Zone of each entry, parallel to minipage->entry.  NULL if zones are
+	 * not maintained for this column group.
+	 */
+	MinipageZone *zones;
+	Oid zoneTypid;
+
+	/*
+	 * Values fed by AppendOnlyBlockDirectory_AddZoneValue() that don't
+	 * belong to an entry yet, and how many there were.  An entry's zone is
+	 * only valid if the number of values fed for it matches its row count.
+	 */
+	MinipageZone pendingZone;
+	int64 pendingRows;
+	int64 pendingExpectedRows;
 } MinipagePerColumnGroup;
 
+/*
+ * A "column op constant" qual that can be checked against a zone.
+ */
+typedef struct AppendOnlyZoneQual
+{
+	int attno;					/* 0-based column number */
+	StrategyNumber strategy;	/* btree strategy of the operator */
+	int64 value;
+} AppendOnlyZoneQual;
+
+/*
+ * The zone of one block directory entry, as returned by
+ * AppendOnlyBlockDirectory_GetZones().
+ */
+typedef struct AppendOnlyBlockDirectoryZone
+{
+	int64 firstRowNum;
+	int64 rowCount;
+	MinipageZone zone;
+} AppendOnlyBlockDirectoryZone;
+
 /*
  * I don't know the ideal value here. But let us put approximate
  * 8 minipages per heap page.
@@ -119,6 +181,14 @@ typedef struct AppendOnlyBlockDirectory
 	ScanKey scanKeys;
 	StrategyNumber *strategyNumbers;
 
+	/*
+	 * Zone values are normally fed before the entry of their block is
+	 * inserted (the insert path).  When the directory is built by scanning
+	 * existing blocks, each block's entry is inserted first and its values
+	 * are fed afterwards.
+	 */
+	bool zoneFeedAfterInsert;
+
 }	AppendOnlyBlockDirectory;
 
 
@@ -218,9 +288,29 @@ extern void AppendOnlyBlockDirectory_End_forSearch(
 	AppendOnlyBlockDirectory *blockDirectory);
 extern void AppendOnlyBlockDirectory_End_addCol(
 	AppendOnlyBlockDirectory *blockDirectory);
+extern bool AppendOnlyBlockDirectory_ZoneTypeSupported(Oid typid);
+extern int64 AppendOnlyBlockDirectory_ZoneValue(Oid typid, Datum value);
+extern void AppendOnlyBlockDirectory_AddZoneValue(
+	AppendOnlyBlockDirectory *blockDirectory,
+	int columnGroupNo,
+	Datum value,
+	bool isnull);
+extern bool AppendOnlyBlockDirectory_ZoneExcludes(
+	MinipageZone *zone,
+	AppendOnlyZoneQual *qual);
+extern AppendOnlyBlockDirectoryZone *AppendOnlyBlockDirectory_GetZones(
+	Relation aoRel,
+	Snapshot appendOnlyMetaDataSnapshot,
+	int segno,
+	int columnGroupNo,
+	int64 eof,
+	int *numZones);
 extern void AppendOnlyBlockDirectory_DeleteSegmentFile(
 	Relation aoRel,
 		Snapshot snapshot,
 		int segno,
 		int columnGroupNo);
+extern Size AppendOnlyBlockDirectory_CacheShmemSize(void);
+extern void AppendOnlyBlockDirectory_CacheShmemInit(void);
+extern void AppendOnlyBlockDirectory_InvalidateCache(Relation aoRel, int segno);
 #endif
@@ -219,6 +219,7 @@ extern int64 AppendOnlyStorageRead_CurrentHeaderOffsetInFile(AppendOnlyStorageRe
 extern int64 AppendOnlyStorageRead_CurrentCompressedLen(AppendOnlyStorageRead *storageRead);
 extern int64 AppendOnlyStorageRead_OverallBlockLen(AppendOnlyStorageRead *storageRead);
 extern uint8 *AppendOnlyStorageRead_GetBuffer(AppendOnlyStorageRead *storageRead);
+extern uint8 *AppendOnlyStorageRead_GetStoredContent(AppendOnlyStorageRead *storageRead);
 extern void AppendOnlyStorageRead_Content(AppendOnlyStorageRead *storageRead,
 							  uint8 *contentOut, int32 contentLen);
 extern void AppendOnlyStorageRead_SkipCurrentBlock(AppendOnlyStorageRead *storageRead);
@@ -178,6 +178,15 @@ typedef struct AppendOnlyStorageWrite
 	PGFunction *compression_functions;	/* For AO or CO compression.                   */
 	/* The array index corresponds to COMP_FUNC_*  */
 
+	/*
+	 * When gp_appendonly_compress_workers is set, the last small content
+	 * block may still be compressing on a compression worker thread, into
+	 * space reserved for it in the BufferedAppend buffer.  It is finished
+	 * before anything else is written to the file.
+	 */
+	struct AppendOnlyCompressJob *compressJob;
+	bool		compressJobChecked;
+
 } AppendOnlyStorageWrite;
 
 extern void AppendOnlyStorageWrite_Init(AppendOnlyStorageWrite *storageWrite,
@@ -241,9 +250,16 @@ extern void AppendOnlyStorageWrite_Content(AppendOnlyStorageWrite *storageWrite,
 							   int32 contentLen,
 							   int executorBlockKind,
 							   int rowCount);
+
+struct AppendOnlyStorageRead;		/* see cdbappendonlystorageread.h */
+
+extern bool AppendOnlyStorageWrite_CopyBlock(AppendOnlyStorageWrite *storageWrite,
+								 struct AppendOnlyStorageRead *storageRead);
 extern void AppendOnlyStorageWrite_SetFirstRowNum(AppendOnlyStorageWrite *storageWrite,
 									  int64 firstRowNum);
 
 extern char *AppendOnlyStorageWrite_ContextStr(AppendOnlyStorageWrite *storageWrite);
 
+extern void AtAbort_AppendOnlyCompress(void);
+
 #endif   /* CDBAPPENDONLYSTORAGEWRITE_H */
@@ -13,5 +13,6 @@ extern Datum gp_backup_launch__(PG_FUNCTION_ARGS);
 extern Datum gp_restore_launch__(PG_FUNCTION_ARGS);
 extern Datum gp_read_backup_file__(PG_FUNCTION_ARGS);
 extern Datum gp_write_backup_file__(PG_FUNCTION_ARGS);
+extern Datum gp_relation_max_lsn(PG_FUNCTION_ARGS);
 
 #endif   /* CDBBACKUP_H */
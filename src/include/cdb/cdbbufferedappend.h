@@ -76,6 +76,17 @@ typedef struct BufferedAppend
 
 	int64				initialSetFilePosition;
 
+	int64				allocatedEnd;
+							/*
+							 * End of the disk space reserved for the file so
+							 * far (see gp_appendonly_preallocate_size).
+							 */
+	int64				dropCachePosition;
+							/*
+							 * Start of the written range not yet evicted from
+							 * the page cache (see gp_appendonly_write_nocache).
+							 */
+
 	MirroredAppendOnlyOpen		mirroredOpen;
 
 } BufferedAppend;
@@ -77,6 +77,12 @@ typedef struct BufferedRead
 	bool				haveTemporaryLimitInEffect;
 	int64				temporaryLimitFileLen;
 
+	/*
+	 * Read-ahead support.  File offset up to which the kernel has already
+	 * been asked to prefetch (see gp_appendonly_prefetch_depth).
+	 */
+	int64				prefetchEnd;
+
 } BufferedRead;
 
 /*
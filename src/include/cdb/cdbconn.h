@@ -63,6 +63,14 @@ typedef struct SegmentDatabaseDescriptor
     int4					backendPid;
     char                   *whoami;         /* QE identifier for msgs */
 
+    /*
+     * Latest session state change (see RecordSessionStateChange()) that the
+     * QE has committed, and the latest one it was sent in the current
+     * transaction.
+     */
+    uint32                  sessionStateCommitted;
+    uint32                  sessionStateSent;
+
 } SegmentDatabaseDescriptor;
 
 
@@ -38,8 +38,7 @@ typedef enum DispatchWaitMode
 typedef struct CdbDispatchDirectDesc
 {
 	bool directed_dispatch;
-	uint16 count;
-	uint16 content[1];
+	List *contentIds;			/* of int; content ids to dispatch to */
 } CdbDispatchDirectDesc;
 
 extern CdbDispatchDirectDesc default_dispatch_direct_desc;
@@ -50,6 +49,13 @@ typedef struct CdbDispatcherState
 	struct CdbDispatchResults *primaryResults;
 	void *dispatchParams;
 	MemoryContext dispatchStateContext;
+
+	/*
+	 * The dispatched command carries the session state changes after
+	 * sessionStateFrom, up to sessionStateTo.
+	 */
+	uint32 sessionStateFrom;
+	uint32 sessionStateTo;
 } CdbDispatcherState;
 
 typedef struct DispatcherInternalFuncs
@@ -164,6 +170,21 @@ CdbDispatchHandleError(struct CdbDispatcherState *ds);
 void
 cdbdisp_cancelDispatch(CdbDispatcherState *ds);
 
+/*
+ * Pipelined dispatch in a transaction block.
+ *
+ * A command whose caller does not need its results can be left running on
+ * the QEs with cdbdisp_pipelineDispatch(), if cdbdisp_canPipeline() says so.
+ * Its results are collected, and its error thrown, at the next sync point:
+ * cdbdisp_syncPipeline() is called before the next command is dispatched and
+ * before the transaction commits.  cdbdisp_cancelPipeline() cancels it when
+ * the (sub)transaction aborts.
+ */
+extern bool cdbdisp_canPipeline(void);
+extern void cdbdisp_pipelineDispatch(CdbDispatcherState *ds);
+extern void cdbdisp_syncPipeline(void);
+extern void cdbdisp_cancelPipeline(void);
+
 /*
  * Allocate memory and initialize CdbDispatcherState.
  *
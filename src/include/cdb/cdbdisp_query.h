@@ -33,6 +33,12 @@
  * indicate whether the command should be dispatched to qExecs along with a snapshot.
  */
 #define DF_WITH_SNAPSHOT  0x4
+/*
+ * indicate that the caller does not need the command to have finished when the dispatch
+ * returns.  In a transaction block, with gp_dispatch_pipeline on, the command is left
+ * running on the qExecs and any error is reported when the next command is dispatched.
+ */
+#define DF_PIPELINE 0x8
 
 struct QueryDesc;
 struct CdbDispatcherState;
@@ -0,0 +1,50 @@
+/*-------------------------------------------------------------------------
+ *
+ * cdbendpoint.h
+ *	   Endpoints of PARALLEL RETRIEVE cursors.
+ *
+ * Portions Copyright (c) 2012-Present Pivotal Software, Inc.
+ *
+ *
+ * IDENTIFICATION
+ *	    src/include/cdb/cdbendpoint.h
+ *
+ *-------------------------------------------------------------------------
+ */
+
+#ifndef CDBENDPOINT_H
+#define CDBENDPOINT_H
+
+#include "fmgr.h"
+#include "nodes/parsenodes.h"
+#include "tcop/dest.h"
+#include "utils/portal.h"
+
+/* Length of a token, in hex digits. */
+#define ENDPOINT_TOKEN_LEN	32
+
+/* shared memory */
+extern Size EndpointShmemSize(void);
+extern void EndpointShmemInit(void);
+
+/* QD: the cursors of this session */
+extern bool IsParallelRetrieveCursorQuery(Query *query);
+extern char *GenerateEndpointToken(void);
+extern void RegisterParallelRetrieveCursor(Portal portal);
+extern void UnregisterParallelRetrieveCursor(Portal portal);
+
+/* QE: the root slice sends its rows to an endpoint */
+extern DestReceiver *CreateEndpointDestReceiver(const char *token);
+
+/* utility mode session on a segment: RETRIEVE */
+extern TupleDesc GetRetrieveStmtTupleDesc(RetrieveStmt *stmt);
+extern void ExecRetrieveStmt(RetrieveStmt *stmt, DestReceiver *dest,
+				 char *completionTag);
+
+extern void AtAbort_Endpoints(void);
+
+extern Datum gp_endpoints(PG_FUNCTION_ARGS);
+extern Datum gp_segment_endpoints(PG_FUNCTION_ARGS);
+extern Datum gp_wait_parallel_retrieve_cursor(PG_FUNCTION_ARGS);
+
+#endif   /* CDBENDPOINT_H */
@@ -17,6 +17,7 @@
 
 #include "executor/instrument.h"        /* instr_time */
 #include "cdb/cdbpublic.h"              /* CdbExplain_Agg */
+#include "utils/timestamp.h"             /* TimestampTz */
 
 struct CdbDispatchResults;              /* #include "cdb/cdbdispatchresult.h" */
 struct EState;                          /* #include "nodes/execnodes.h" */
@@ -31,6 +32,7 @@ static inline void
 cdbexplain_agg_init0(CdbExplain_Agg *agg)
 {
     agg->vmax = 0;
+    agg->vmin = 0;
     agg->vsum = 0;
     agg->vcnt = 0;
     agg->imax = 0;
@@ -44,6 +46,10 @@ cdbexplain_agg_upd(CdbExplain_Agg *agg, double v, int id)
         agg->vsum += v;
         agg->vcnt++;
 
+        if (v < agg->vmin ||
+            agg->vcnt == 1)
+            agg->vmin = v;
+
         if (v > agg->vmax ||
             agg->vcnt == 0)
         {
@@ -159,4 +165,58 @@ cdbexplain_showExecStatsEnd(struct PlannedStmt *stmt,
                             struct EState                  *estate);
 
 
+/*
+ * CdbExplain_QEDispatchTiming
+ *    Where a qExec spent its time between receiving a plan from the qDisp
+ *    and starting to run it.  exec_mpp_query() fills in
+ *    cdbexplain_qeDispatchTiming for each plan, and
+ *    cdbexplain_sendExecStats() reports it to the qDisp.
+ */
+typedef struct CdbExplain_QEDispatchTiming
+{
+    TimestampTz     receivedAt;         /* wall clock when the plan came in */
+    instr_time      received;           /* the same, for measuring intervals */
+    instr_time      runStarted;         /* when ExecutorRun() was entered */
+    double          deserializeTime;    /* secs to uncompress and read plan */
+    double          executorStartTime;  /* secs in ExecutorStart() */
+} CdbExplain_QEDispatchTiming;
+
+extern CdbExplain_QEDispatchTiming cdbexplain_qeDispatchTiming;
+
+/*
+ * cdbexplain_startSliceUsage
+ *    Note this process's CPU time, elapsed time and file I/O so far, so
+ *    that cdbexplain_sendExecStats() and cdbexplain_localExecStats() can
+ *    report what executing the slice added to them.  Called when a qExec
+ *    receives its plan, and by the qDisp when it starts EXPLAIN ANALYZE.
+ */
+void
+cdbexplain_startSliceUsage(void);
+
+/*
+ * cdbexplain_recordSerializeTime, cdbexplain_recordGangAllocTime,
+ * cdbexplain_recordSliceDispatch, cdbexplain_recordDispatchWaitTime
+ *    Called by qDisp to note where the time went when dispatching a plan
+ *    of an EXPLAIN ANALYZE, for the "Dispatch timing" section printed by
+ *    cdbexplain_showExecStatsEnd().  Times are in seconds.  All are no-ops
+ *    when 'ctx' is NULL.
+ *
+ * 'sendStart' is when the qDisp started sending the slice; the qExecs'
+ *      receive latency is measured against it, so it is only meaningful if
+ *      the hosts' clocks are in sync.
+ */
+void
+cdbexplain_recordSerializeTime(struct CdbExplain_ShowStatCtx *ctx,
+                               double serializeTime, double compressTime);
+void
+cdbexplain_recordGangAllocTime(struct CdbExplain_ShowStatCtx *ctx,
+                               double gangAllocTime);
+void
+cdbexplain_recordSliceDispatch(struct CdbExplain_ShowStatCtx *ctx,
+                               int sliceIndex, TimestampTz sendStart,
+                               double sendTime);
+void
+cdbexplain_recordDispatchWaitTime(struct CdbExplain_ShowStatCtx *ctx,
+                                  double waitTime);
+
 #endif   /* CDBEXPLAIN_H */
@@ -33,6 +33,9 @@
 
 #define FILEREP_MAX_OPEN_FILES 128 // 131072   // 128k
 
+#define FILEREP_MAX_OUTSTANDING_ACKS FILEREP_MAX_OPEN_FILES
+	/* Max number of operations waiting for an ack from the mirror */
+
 #define FILEREP_MAX_IPC_ARRAY	5
 #define FILEREP_MAX_SEMAPHORES	2 * FILEREP_MAX_IPC_ARRAY
 
@@ -75,6 +78,7 @@ extern int file_rep_ack_buffer_size;
 extern int file_rep_retry;
 extern int file_rep_min_data_before_flush;
 extern int file_rep_socket_timeout;
+extern bool file_rep_compress_messages;
 extern int file_rep_mirror_consumer_process_count;
 
 extern FileRepRole_e		fileRepRole;
@@ -28,10 +28,12 @@ extern void FileRepConnClient_CloseConnection(void);
  */
 extern bool FileRepConnClient_SendMessage(
 			  FileRepConsumerProcIndex_e	messageType, 
-			  bool					messageSynchronous,
+			  bool					flushNow,
 			  char					*message, 
 			  uint32				messageLength);
 
+extern bool FileRepConnClient_FlushMessages(void);
+
 #endif /* CDBFILEREPCONNCLIENT_H */
 
 
@@ -69,6 +69,8 @@ extern Gang *AllocateReaderGang(GangType type, char *portal_name);
 
 extern Gang *AllocateWriterGang(void);
 
+extern void PrewarmReaderGangs(int nreaders);
+
 extern List *getCdbProcessList(Gang *gang, int sliceIndex, struct DirectDispatchInfo *directDispatch);
 
 extern bool GangOK(Gang *gp);
@@ -99,6 +101,12 @@ void build_gpqeid_param(char *buf, int bufsz, int segIndex, bool is_writer, int
 char *makeOptions(void);
 extern bool segment_failure_due_to_recovery(const char *error_message);
 
+extern void RecordSessionStateChange(const char *name, const char *value);
+extern void RecordDispatchedSessionStateChange(const char *name, const char *value);
+extern void SerializeSessionState(struct StringInfoData *buf, List *gangs, uint32 *from, uint32 *to);
+extern void MarkSessionStateSent(Gang *gp, List *contentIds, uint32 from, uint32 to);
+extern void ApplySessionState(const char *buf, int len);
+
 /*
  * disconnectAndDestroyIdleReaderGangs()
  *
@@ -166,6 +174,8 @@ typedef struct CdbProcess
 } CdbProcess;
 
 typedef Gang *(*CreateGangFunc)(GangType type, int gang_id, int size, int content);
+typedef void (*CreateGangsFunc)(GangType type, int first_gang_id, int ngangs,
+								int size, int content, Gang **gangs);
 
 extern void cdbgang_setAsync(bool async);
 
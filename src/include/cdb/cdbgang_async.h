@@ -18,5 +18,6 @@
 #include "cdb/cdbgang.h"
 
 extern CreateGangFunc pCreateGangFuncAsync;
+extern CreateGangsFunc pCreateGangsFuncAsync;
 
 #endif
@@ -30,7 +30,8 @@ typedef enum
 typedef enum
 {
 	REDUCE_LAZYMOD = 1,
-	REDUCE_BITMASK
+	REDUCE_BITMASK,
+	REDUCE_JUMP_CONSISTENT
 } CdbHashReduce;
 
 /*
@@ -83,6 +84,15 @@ extern void cdbhashnokey(CdbHash *h);
  */
 extern unsigned int cdbhashreduce(CdbHash *h);
 
+/*
+ * Batch versions of the above, hashing n rows at a time. hashes[] holds one
+ * hash value per row.
+ */
+extern void cdbhashinit_batch(uint32 *hashes, int n);
+extern void cdbhash_batch(uint32 *hashes, int n, Datum *values, bool *isnull, Oid typid);
+extern void cdbhashnokey_batch(CdbHash *h, uint32 *hashes, int n);
+extern void cdbhashreduce_batch(CdbHash *h, const uint32 *hashes, int n, unsigned int *segs);
+
 /*
  * Return true if Oid is hashable internally in Greenplum Database.
  */
@@ -0,0 +1,36 @@
+/*-------------------------------------------------------------------------
+ *
+ * cdbhostarena.h
+ *	   Shared memory arenas between the QEs of a host.
+ *
+ * Portions Copyright (c) 2012-Present Pivotal Software, Inc.
+ *
+ *
+ * IDENTIFICATION
+ *	    src/include/cdb/cdbhostarena.h
+ *
+ *-------------------------------------------------------------------------
+ */
+
+#ifndef CDBHOSTARENA_H
+#define CDBHOSTARENA_H
+
+/* An arena this process has created or attached to */
+typedef struct HostArena
+{
+	char		name[64];		/* POSIX shared memory object name */
+	char	   *data;			/* the user data, read-only unless creator */
+	Size		size;			/* # bytes of user data */
+	bool		creator;		/* did we create it? */
+
+	struct HostArena *next;		/* next arena of this process */
+} HostArena;
+
+extern void HostArenaName(char *name, Size namesize, int sliceId, int planNodeId);
+extern HostArena *HostArenaCreate(const char *name, Size size);
+extern HostArena *HostArenaAttach(const char *name, int timeoutMs);
+extern void HostArenaPublish(HostArena *arena, bool success);
+extern void HostArenaDetach(HostArena *arena);
+extern void HostArenaRemoveStale(void);
+
+#endif   /* CDBHOSTARENA_H */
@@ -213,6 +213,15 @@ struct MotionConn
 	uint64 dev;
 	uint64 deadlockCheckBeginTime;
 
+	/*
+	 * per-connection congestion state, only used by the "adaptive" flow
+	 * control method.
+	 */
+	float cwnd;
+	float ssthresh;
+	uint64 nextSendTime;
+	uint64 lastCwndReductionTime;
+
 
 	ICBuffer *curBuff;
 
@@ -244,6 +253,14 @@ struct MotionConn
 	bool		stillActive;
 	bool		stopRequested;
 
+	/*
+	 * TCP connection reuse (see gp_interconnect_tcp_conn_cache_size).
+	 * tcpEosSent is set on the sender once end-of-stream went out.
+	 * tcpCacheable is set once both ends agreed to keep the socket open.
+	 */
+	bool		tcpEosSent;
+	bool		tcpCacheable;
+
     MotionConnState state;
 
 	uint64		wakeup_ms;
@@ -275,6 +292,8 @@ struct MotionConn
 	uint64 stat_count_resent;
 	uint64 stat_max_resent;
 	uint64 stat_count_dropped;
+	uint64 stat_count_paced;
+	uint64 stat_cwnd_reductions;
 
 	/*
 	 * used by the sender.
@@ -460,6 +479,17 @@ typedef struct MotionNodeEntry
 	uint64          sel_rd_wait;            /* Total time (usec) spent in select wait trying to read */
 	uint64          sel_wr_wait;            /* Total time spent (usec) in select wait trying to write */
 
+	/*
+	 * Tuple compression, see gp_interconnect_compress_min_size. SendTuple()
+	 * turns it off for the rest of the query if the data of this motion
+	 * node turns out to compress badly.
+	 */
+	bool            compress;
+	uint64          stat_compress_tried;    /* Tuples we tried to compress. */
+	uint64          stat_compressed_tuples; /* Tuples sent compressed. */
+	uint64          stat_compress_raw_bytes;        /* Tuple-data bytes before compression. */
+	uint64          stat_compress_bytes;    /* Tuple-data bytes after compression. */
+
 	uint64			memKB;	/* How much memory should this motion node use? */
 }       MotionNodeEntry;
 
@@ -527,6 +557,7 @@ typedef struct ChunkTransportState
 
 	/* Function pointers to our send/receive functions */
 	bool (*SendChunk)(MotionLayerState *mlStates, struct ChunkTransportState *transportStates, ChunkTransportStateEntry *pEntry, MotionConn *conn, TupleChunkListItem tcItem, int16 motionId);
+	bool (*FlushBuffer)(MotionLayerState *mlStates, struct ChunkTransportState *transportStates, ChunkTransportStateEntry *pEntry, MotionConn *conn, int16 motionId);
 	TupleChunkListItem (*RecvTupleChunkFrom)(struct ChunkTransportState *transportStates, int16 motNodeID, int16 srcRoute);
 	TupleChunkListItem (*RecvTupleChunkFromAny)(MotionLayerState *mlStates, struct ChunkTransportState *transportStates, int16 motNodeID, int16 *srcRoute);
 	void (*doSendStopMessage)(struct ChunkTransportState *transportStates, int16 motNodeID);
@@ -152,4 +152,10 @@ extern void setExpectedReceivers(MotionLayerState *mlStates, int16 motNodeID, in
  */
 extern TupleChunkListItem get_eos_tuplechunklist(void);
 
+/*
+ * Append EXPLAIN ANALYZE notes about a motion node
+ */
+extern void ExplainMotionLayerNode(MotionLayerState *mlStates, int16 motNodeID,
+								   struct StringInfoData *buf);
+
 #endif   /* CDBMOTION_H */
@@ -41,7 +41,8 @@ typedef struct PartitionRangeState
 	FmgrInfo *ltfuncs_inverse; /* comparator partRule < expr */
 	FmgrInfo *lefuncs_inverse; /* comparator partRule <= expr */
 	int last_rule; /* cache offset to the last rule and test if it matches */
-	PartitionRule **rules;
+	HTAB *nodeIndexes; /* rules of each PartitionNode of the level, as arrays */
+	MemoryContext cxt; /* context of the state and of nodeIndexes */
 } PartitionRangeState;
 
 /* likewise, for list */
@@ -49,6 +50,10 @@ typedef struct PartitionListState
 {
 	FmgrInfo *eqfuncs;
 	bool *eqinit;
+	FmgrInfo *hashfuncs; /* to look up the values in nodeIndexes */
+	int hashable; /* 1 if the key columns can be hashed, -1 if not, 0 if unknown */
+	HTAB *nodeIndexes; /* rules and values of each PartitionNode of the level */
+	MemoryContext cxt; /* context of the state and of nodeIndexes */
 } PartitionListState;
 
 /* likewise, for hash */
@@ -161,6 +161,26 @@ extern void PersistentRelation_MarkBufPoolRelationForScanIncrementalResync(
 	int64				persistentSerialNum);
 				/* Serial number for the relation.	Distinquishes the uses of the tuple. */
 
+// -----------------------------------------------------------------------------
+// Relation file index
+// -----------------------------------------------------------------------------
+
+extern void PersistentRelation_IndexAdd(
+	RelFileNode			*relFileNode,
+	int32				segmentFileNum,
+	ItemPointer			persistentTid,
+	int64				persistentSerialNum);
+
+extern bool PersistentRelation_IndexLookup(
+	RelFileNode			*relFileNode,
+	int32				segmentFileNum,
+	ItemPointer			persistentTid,
+	int64				*persistentSerialNum);
+
+extern void PersistentRelation_IndexRemove(
+	RelFileNode			*relFileNode,
+	int32				segmentFileNum);
+
 // -----------------------------------------------------------------------------
 // Shmem and Startup/Shutdown
 // -----------------------------------------------------------------------------
@@ -0,0 +1,71 @@
+/*-------------------------------------------------------------------------
+ *
+ * cdbprogress.h
+ *	   Live per-node progress of running queries, published in shared
+ *	   memory.
+ *
+ * Portions Copyright (c) 2012-Present Pivotal Software, Inc.
+ *
+ *
+ * IDENTIFICATION
+ *	    src/include/cdb/cdbprogress.h
+ *
+ *-------------------------------------------------------------------------
+ */
+
+#ifndef CDBPROGRESS_H
+#define CDBPROGRESS_H
+
+#include "fmgr.h"
+#include "nodes/execnodes.h"
+
+#define QUERY_PROGRESS_NODE_TYPE_LEN 32
+
+/*
+ * Progress of one plan node executed by this backend.  The counters are
+ * bumped by the executor as it goes, without any locking: readers may see
+ * a value that is slightly out of date, which is fine for monitoring.
+ */
+typedef struct QueryProgressNode
+{
+	int			planNodeId;
+	int			sliceId;
+	char		nodeType[QUERY_PROGRESS_NODE_TYPE_LEN];
+	double		planRows;		/* the planner's estimate */
+	int64		tuples;			/* tuples returned (or sent, by a Motion) */
+	int64		motionBytes;	/* bytes sent or received by a Motion */
+} QueryProgressNode;
+
+/*
+ * One slot per backend, indexed by MyBackendId, holding the nodes of the
+ * top-level query the backend is executing.  The slots are
+ * gp_query_progress_max_nodes nodes long; nodes beyond that are not
+ * tracked.
+ *
+ * Only the owning backend writes the slot.  Changes to the header and to
+ * the list of nodes bump changecount before and after, like
+ * PgBackendStatus.st_changecount, so that readers can take a consistent
+ * copy without a lock.
+ */
+typedef struct QueryProgressSlot
+{
+	int			changecount;
+
+	int			pid;			/* 0 when not executing a query */
+	int			sessionId;
+	int			commandCount;
+	int			numNodes;
+	QueryProgressNode nodes[1];	/* VARIABLE LENGTH ARRAY */
+} QueryProgressSlot;
+
+extern Size QueryProgressShmemSize(void);
+extern void QueryProgressShmemInit(void);
+
+extern void QueryProgressStart(EState *estate);
+extern QueryProgressNode *QueryProgressAddNode(PlanState *ps);
+extern void QueryProgressEnd(EState *estate);
+extern void AtAbort_QueryProgress(void);
+
+extern Datum gp_query_progress(PG_FUNCTION_ARGS);
+
+#endif   /* CDBPROGRESS_H */
@@ -53,6 +53,7 @@ typedef struct TMGXACT_CHECKPOINT
 struct CdbExplain_Agg
 {
     double      vmax;           /* maximum value of statistic */
+    double      vmin;           /* minimum value > 0 of statistic */
     double      vsum;           /* sum of values */
     int         vcnt;           /* count of values > 0 */
     int         imax;           /* id of 1st observation having maximum value */
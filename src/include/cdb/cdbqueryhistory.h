@@ -0,0 +1,77 @@
+/*-------------------------------------------------------------------------
+ *
+ * cdbqueryhistory.h
+ *	   Memory and spill usage of recently completed queries, kept in a ring
+ *	   buffer in shared memory.
+ *
+ * Portions Copyright (c) 2012-Present Pivotal Software, Inc.
+ *
+ *
+ * IDENTIFICATION
+ *	    src/include/cdb/cdbqueryhistory.h
+ *
+ *-------------------------------------------------------------------------
+ */
+
+#ifndef CDBQUERYHISTORY_H
+#define CDBQUERYHISTORY_H
+
+#include "fmgr.h"
+#include "executor/execdesc.h"
+#include "utils/timestamp.h"
+
+/* Kinds of operators whose spilling is accounted separately */
+typedef enum QueryHistorySpillKind
+{
+	QH_SPILL_SORT = 0,
+	QH_SPILL_HASHJOIN,
+	QH_SPILL_HASHAGG,
+	QH_SPILL_MATERIAL,			/* Material and ShareInputScan */
+	QH_SPILL_OTHER
+} QueryHistorySpillKind;
+
+#define NUM_QH_SPILL_KINDS (QH_SPILL_OTHER + 1)
+
+/*
+ * What one process used for one top-level query.  A query on a segment is
+ * usually run by several processes, one for each slice, each of which
+ * records an entry of its own.
+ *
+ * The writer bumps changecount before and after filling in the entry, like
+ * PgBackendStatus.st_changecount, so that readers can take a consistent
+ * copy without a lock.
+ */
+typedef struct QueryHistoryEntry
+{
+	int			changecount;
+
+	int			pid;			/* 0 if the entry was never used */
+	int			sessionId;
+	int			commandCount;
+	int			sliceId;
+	Oid			userId;
+	Oid			resGroupId;		/* InvalidOid without resource groups */
+	bool		aborted;
+	TimestampTz startTime;
+	TimestampTz endTime;
+	int64		queryMemBytes;	/* memory quota assigned to the query */
+	int64		peakVmemBytes;	/* peak vmem reserved by the process */
+	int64		spillBytes[NUM_QH_SPILL_KINDS];
+	int64		hashAggPasses;	/* HashAgg passes over spilled batches */
+	int64		hashJoinBatches;	/* batches of hash joins that spilled */
+} QueryHistoryEntry;
+
+extern Size QueryHistoryShmemSize(void);
+extern void QueryHistoryShmemInit(void);
+
+extern void QueryHistoryStart(QueryDesc *queryDesc, int eflags);
+extern void QueryHistoryEnd(QueryDesc *queryDesc);
+extern void AtAbort_QueryHistory(void);
+
+extern void QueryHistoryCountSpill(NodeTag nodeType, int64 bytes);
+extern void QueryHistoryCountHashAggPass(void);
+extern void QueryHistoryCountHashJoinBatches(int nbatch);
+
+extern Datum gp_query_resource_history(PG_FUNCTION_ARGS);
+
+#endif   /* CDBQUERYHISTORY_H */
@@ -19,6 +19,7 @@
 #include "access/xlogdefs.h"
 #include "storage/relfilenode.h"
 #include "utils/guc.h"
+#include "utils/hsearch.h"
 #include "utils/pg_crc.h"
 
 #define CHANGETRACKINGDIR  "pg_changetracking"
@@ -334,17 +335,11 @@ typedef struct ChangeTrackingResultEntry
 	BlockNumber		block_num;
 	/*
 	 * Most recent location in XLOG for a change made to this block while a
-	 * primary segment was tracking changes.  If a new change happens to the
-	 * block after primary segment has transitioned from changetracking to
-	 * resync, the block's LSN value will be newer than lsn_end.  If so, the
-	 * block will be mirrored already at the time the change was written on
-	 * primary and doesn't need to be shipped to mirror during resync.
-	 *
-	 * In theory, a single global "last change-tracked LSN"
-	 * (XLogLastChangeTrackedLoc() or fileRepResyncShmem->endIncrResyncLSN)
-	 * should be suffice to decide whether a page should be sent to mirror
-	 * during resync or not.  Keeping track of lsn_end for each block of every
-	 * relation seems redundant.  We leave this as TODO.
+	 * primary segment was tracking changes, if known.  Changes are served
+	 * from a per-relation dirty block bitmap (see
+	 * ChangeTracking_BuildDirtyBlockMap()), which doesn't keep per-block
+	 * LSNs, so this is left invalid and the block is always shipped to the
+	 * mirror.  Shipping a block that was already mirrored is harmless.
 	 */
 	XLogRecPtr		lsn_end;
 
@@ -366,6 +361,22 @@ extern ChangeTrackingResult* ChangeTracking_GetChanges(ChangeTrackingRequest* re
 extern void ChangeTracking_FreeRequest(ChangeTrackingRequest* request);
 extern void ChangeTracking_FreeResult(ChangeTrackingResult* result);
 
+/*
+ * Dirty blocks of a single relation, as recorded in the change tracking log.
+ * Bit N of 'words' is set if block N was changed while tracking changes.
+ */
+typedef struct ChangeTrackingDirtyBlocks
+{
+	RelFileNode		relFileNode;	/* hash key */
+	int				nwords;			/* allocated length of 'words' */
+	uint32		   *words;
+} ChangeTrackingDirtyBlocks;
+
+extern HTAB *ChangeTracking_BuildDirtyBlockMap(CTFType ftype, MemoryContext cxt);
+extern BlockNumber ChangeTracking_NextDirtyBlock(ChangeTrackingDirtyBlocks *blocks,
+												 BlockNumber start);
+extern void ChangeTracking_FreeDirtyBlockMap(void);
+
 extern bool ChangeTracking_GetLastChangeTrackingLogEndLoc(XLogRecPtr *lastChangeTrackingLogEndLoc);
 
 // -----------------------------------------------------------------------------
@@ -22,5 +22,8 @@
 
 extern char *serializeNode(Node *node, int *size, int *uncompressed_size);
 extern Node *deserializeNode(const char *strNode, int size);
+extern char *serializeNodeCached(Node *node, int *size, int *uncompressed_size,
+					double *serialize_time, double *compress_time);
+extern Node *deserializeNodeCached(const char *strNode, int size);
 
 #endif   /* CDBSRLZ_H */
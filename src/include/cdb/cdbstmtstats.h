@@ -0,0 +1,44 @@
+/*-------------------------------------------------------------------------
+ *
+ * cdbstmtstats.h
+ *	   Latency histograms of the statements run on the QD, by normalized
+ *	   query text and by phase, kept in shared memory.
+ *
+ * Portions Copyright (c) 2012-Present Pivotal Software, Inc.
+ *
+ *
+ * IDENTIFICATION
+ *	    src/include/cdb/cdbstmtstats.h
+ *
+ *-------------------------------------------------------------------------
+ */
+
+#ifndef CDBSTMTSTATS_H
+#define CDBSTMTSTATS_H
+
+#include "fmgr.h"
+#include "portability/instr_time.h"
+
+/* Phases of a statement whose latency is tracked separately */
+typedef enum StmtStatsPhase
+{
+	STMT_PHASE_QUEUE = 0,		/* waiting for a resource queue or group */
+	STMT_PHASE_PLAN,
+	STMT_PHASE_DISPATCH,		/* allocating gangs and sending the plan */
+	STMT_PHASE_EXECUTE,			/* the rest of the statement */
+	STMT_PHASE_TOTAL
+} StmtStatsPhase;
+
+#define NUM_STMT_PHASES (STMT_PHASE_TOTAL + 1)
+
+extern Size StmtStatsShmemSize(void);
+extern void StmtStatsShmemInit(void);
+
+extern void StmtStatsStart(const char *query_string);
+extern void StmtStatsAddTime(StmtStatsPhase phase, instr_time starttime);
+extern void StmtStatsEnd(void);
+
+extern Datum gp_statement_stats(PG_FUNCTION_ARGS);
+extern Datum gp_statement_stats_reset(PG_FUNCTION_ARGS);
+
+#endif   /* CDBSTMTSTATS_H */
@@ -22,6 +22,7 @@
 #ifndef CDBTARGETEDDISPATCH_H
 #define CDBTARGETEDDISPATCH_H
 
+#include "nodes/params.h"
 #include "nodes/plannodes.h"
 #include "nodes/parsenodes.h"
 #include "nodes/relation.h"
@@ -32,4 +33,11 @@
  */
 extern void AssignContentIdsToPlanData(Query *query, Plan *plan, PlannerInfo *root);
 
+/**
+ * @param dd the directDispatch info of a plan node, with paramKeys set
+ * @param params the values of the extern Params
+ * @return the content ids to dispatch to, or NIL to dispatch to all contents
+ */
+extern List *GetContentIdsFromParamKeys(DirectDispatchInfo *dd, ParamListInfo params);
+
 #endif   /* CDBTARGETEDDISPATCH_H */
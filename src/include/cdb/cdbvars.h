@@ -163,6 +163,21 @@ extern int qdPostmasterPort;
 /*How many gangs to keep around from stmt to stmt.*/
 extern int			gp_cached_gang_threshold;
 
+/*
+ * How many idle reader gangs to set up ahead of need, once the writer gang
+ * exists.  gp_cached_gang_threshold is the matching high watermark.
+ */
+extern int			gp_cached_gang_low_watermark;
+
+/*
+ * Upper bound on how many values of a sequence a QE leases from the
+ * sequence server in one round-trip.
+ */
+extern int			gp_sequence_lease_max;
+
+/* How many endpoints of PARALLEL RETRIEVE cursors each segment can hold. */
+extern int			gp_max_endpoints;
+
 /*
  * gp_reject_percent_threshold
  *
@@ -265,6 +280,16 @@ extern int gp_backup_directIO_read_chunk_mb;
  */
 extern bool gp_external_enable_exec;
 
+/*
+ * gp_external_projection
+ *
+ * When set to 'true' a scan of a readable external table only runs the input
+ * functions of the columns that the query uses, and the other columns are
+ * NULL.  Bad data in a column the query doesn't use then goes unnoticed.
+ * Custom formatters are told which columns are needed as well.
+ */
+extern bool gp_external_projection;
+
 /* gp_external_max_segs
  *
  * The maximum number of segment databases that will get assigned to
@@ -299,6 +324,34 @@ extern int gp_command_count;
  */
 extern int gp_safefswritesize;
 
+/*
+ * gp_appendonly_prefetch_depth
+ *
+ * Number of large reads to ask the kernel to prefetch ahead of the current
+ * one when scanning an append-only segment file (or AOCS column file).
+ * 0 disables read-ahead hints.
+ */
+extern int gp_appendonly_prefetch_depth;
+
+/*
+ * gp_appendonly_compress_workers
+ *
+ * Number of threads a backend uses to compress append-only blocks while it
+ * goes on producing the next ones.  Each writer (each column of a
+ * column-oriented table) has one block with them at a time.  0 compresses
+ * on the backend itself.
+ */
+extern int gp_appendonly_compress_workers;
+
+/*
+ * gp_appendonly_preallocate_size
+ *
+ * Disk space, in kB, to reserve at a time ahead of the writes to an
+ * append-only segment file, so that a big load gets large contiguous
+ * extents.  The file size is not changed.  0 disables preallocation.
+ */
+extern int gp_appendonly_preallocate_size;
+
 /*
  * Gp_write_shared_snapshot
  *
@@ -370,7 +423,7 @@ extern int	gp_snapshotadd_timeout; /* GUC var - timeout specifier for snapshot-c
 extern int	gp_fts_probe_retries; /* GUC var - specifies probe number of retries for FTS */
 extern int	gp_fts_probe_timeout; /* GUC var - specifies probe timeout for FTS */
 extern int	gp_fts_probe_interval; /* GUC var - specifies polling interval for FTS */
-extern int	gp_fts_probe_threadcount; /* GUC var - specifies number of threads to use for FTS probes */
+extern int	gp_fts_probe_threadcount; /* GUC var - defunct, FTS probes are no longer threaded */
 extern bool	gp_fts_transition_parallel; /* GUC var - controls parallel segment transition for FTS */
 
 extern int gp_gang_creation_retry_count; /* How many retries ? */
@@ -410,6 +463,7 @@ extern const char *gpvars_show_gp_interconnect_type(void);
 
 #define INTERCONNECT_FC_METHOD_CAPACITY (0)
 #define INTERCONNECT_FC_METHOD_LOSS     (2)
+#define INTERCONNECT_FC_METHOD_ADAPTIVE (3)
 
 extern int Gp_interconnect_fc_method;
 
@@ -446,6 +500,38 @@ extern int  Gp_interconnect_transmit_timeout;
 extern int	Gp_interconnect_min_retries_before_timeout;
 extern int	Gp_interconnect_debug_retry_interval;
 
+/*
+ * Parameter Gp_interconnect_mmsg_batch_size
+ *
+ * The run-time parameter Gp_interconnect_mmsg_batch_size controls the
+ * maximum number of packets handed to the kernel by a single sendmmsg()
+ * or recvmmsg() call. A value of 1 sends and receives one packet per
+ * system call.
+ *
+ * This guc is specific to the UDP-interconnect.
+ *
+ */
+extern int	Gp_interconnect_mmsg_batch_size;
+
+#define MAX_MMSG_BATCH_SIZE 64
+
+/*
+ * Parameter Gp_interconnect_tcp_conn_cache_size
+ *
+ * The run-time parameter Gp_interconnect_tcp_conn_cache_size controls how
+ * many interconnect connections a backend keeps open between statements of
+ * a session, incoming and outgoing together, so that later statements can
+ * register new motions on them instead of connecting again. Each one holds a
+ * file descriptor on both ends, so keep it small. The default of 0 closes
+ * every connection at teardown.
+ *
+ * This guc is specific to the TCP-interconnect.
+ *
+ */
+extern int	Gp_interconnect_tcp_conn_cache_size;
+
+#define MAX_TCP_CONN_CACHE_SIZE 64
+
 /* UDP recv buf size in KB.  For testing */
 extern int 	Gp_udp_bufsize_k;
 
@@ -485,6 +571,14 @@ extern bool gp_interconnect_log_stats;
 
 extern bool gp_interconnect_cache_future_packets;
 
+/*
+ * Parameter gp_interconnect_compress_min_size
+ *
+ * Tuples whose serialized form is at least this many bytes are compressed
+ * before they are handed to the interconnect. 0 disables compression.
+ */
+extern int	gp_interconnect_compress_min_size;
+
 /*
  * Parameter gp_segment
  *
@@ -547,9 +641,29 @@ typedef enum GpVars_Verbosity
 /* Enable single-slice single-row inserts. */
 extern bool gp_enable_fast_sri;
 
+/*
+ * Map distribution hashes to segments with jump consistent hash instead of
+ * modulo, so that expanding the cluster moves few rows. It decides where
+ * the rows of hash distributed tables are stored, so it can only be set
+ * when the cluster is initialized.
+ */
+extern bool gp_use_jump_consistent_hash;
+
 /* Enable single-mirror pair dispatch. */
 extern bool gp_enable_direct_dispatch;
 
+/*
+ * Run the global deadlock detector on the master, and let UPDATE and DELETE
+ * on heap tables take RowExclusiveLock instead of ExclusiveLock on the QD.
+ */
+extern bool gp_enable_global_deadlock_detector;
+
+/* Seconds between two runs of the global deadlock detector. */
+extern int gp_global_deadlock_detector_period;
+
+/* Allow EXECUTE to reuse the generic plan of a prepared statement. */
+extern bool gp_enable_generic_plans;
+
 /* Name of pseudo-function to access any table as if it was randomly distributed. */
 #define GP_DIST_RANDOM_NAME "GP_DIST_RANDOM"
 
@@ -616,6 +730,16 @@ const char *gpvars_show_gp_log_interconnect(void);
  */
 extern double   gp_motion_cost_per_row;
 
+/*
+ * "gp_motion_hot_key_fraction"
+ *
+ * If >0, a join key whose most-common-value frequency is at least this
+ * fraction of its rel is treated as hot when both sides of the join are
+ * redistributed: its rows are spread round-robin on one side and broadcast
+ * on the other, instead of all landing on one segment.
+ */
+extern double   gp_motion_hot_key_fraction;
+
 /*
  * "gp_segments_for_planner"
  *
@@ -704,6 +828,18 @@ extern bool gp_enable_agg_distinct;
  */
 extern bool gp_enable_dqa_pruning;
 
+/*
+ * "gp_enable_agg_distinct_expand"
+ *
+ * May Greenplum compute distinct-qualified aggregates on several arguments
+ * by expanding each input row into one row per argument and removing the
+ * duplicates of all of them with a single hashed grouping?
+ *
+ * See cdb_expand_multi_dqa().  Unlike the join of 3-phase aggregations,
+ * this reads the input once.
+ */
+extern bool gp_enable_dqa_expand;
+
 /*
  * "gp_eager_agg_distinct_pruning"
  *
@@ -789,12 +925,23 @@ extern bool gp_eager_preunique;
  */
 extern bool gp_enable_sequential_window_plans;
 
+/* May Greenplum keep min/max-like window aggregates over a moving frame up
+ * to date as the frame moves, instead of rescanning the frame for each row?
+ */
+extern bool gp_enable_window_sliding_extremes;
+
 /* May Greenplum dump statistics for all segments as a huge ugly string
  * during EXPLAIN ANALYZE?
  *
  */
 extern bool gp_enable_explain_allstat;
 
+/* During EXPLAIN ANALYZE, time only one in this many calls of each plan
+ * node, after the first ones, and extrapolate the node's total time from
+ * them. Row counts are always exact.
+ */
+extern int	gp_explain_analyze_timing_sample;
+
 /* May Greenplum restrict ORDER BY sorts to the first N rows if the ORDER BY
  * is wrapped by a LIMIT clause (where N=OFFSET+LIMIT)?
  *
@@ -811,10 +958,61 @@ extern bool gp_enable_sort_limit;
  */
 extern bool gp_enable_sort_distinct;
 
+/* May Greenplum sort ORDER BY input that is already ordered on a prefix of
+ * the sort keys one run of equal prefix keys at a time, instead of sorting
+ * all of it at once?
+ */
+extern bool gp_enable_incremental_sort;
+
+/* May Greenplum hash the input of UNION, INTERSECT and EXCEPT to find the
+ * duplicates, instead of sorting it?
+ *
+ * The planner uses its estimates to choose between the two, when enabled.
+ */
+extern bool gp_enable_hashed_setop;
+
 /* Greenplum MK Sort */
 extern bool gp_enable_mk_sort;
 extern bool gp_enable_motion_mk_sort;
 
+/*
+ * Let multi-key sort compare int8, date and timestamp keys inline, and
+ * text, char and numeric keys through a 64 bit abbreviation.
+ */
+extern bool gp_mk_sort_abbrev_keys;
+
+/*
+ * Number of threads, besides the backend, that sort a multi-key sort's
+ * in-memory array when every key is an integer type compared inline.
+ */
+extern int	gp_mk_sort_threads;
+
+/*
+ * Carve tuplestore pages from growing arenas, with huge pages advised for
+ * the large ones, instead of allocating them one at a time.
+ */
+extern bool gp_tuplestore_arena;
+
+/*
+ * Let sequential scans of user tables larger than a buffer ring stream
+ * through the ring, not only those larger than a quarter of shared buffers.
+ */
+extern bool gp_scan_resistant_buffers;
+
+/*
+ * Number of tuples a redistribute motion sender fetches from its child and
+ * hashes together, see execMotionSenderHashBatch(). 1 disables batching.
+ */
+extern int	gp_motion_hash_batch_size;
+
+#define MAX_MOTION_HASH_BATCH_SIZE 4096
+
+/*
+ * Maximum number of senders a sorted motion receiver merges in a single mk
+ * heap. With more, they are merged in a tree of heaps. 0 disables this.
+ */
+extern int	gp_motion_merge_fanout;
+
 #ifdef USE_ASSERT_CHECKING
 extern bool gp_mk_sort_check;
 #endif
@@ -861,6 +1059,15 @@ extern int gp_segworker_relative_priority;
 /*  Max size of dispatched plans; 0 if no limit */
 extern int gp_max_plan_size;
 
+/* Number of recently dispatched plans to keep serialized; 0 to disable */
+extern int gp_dispatch_plan_cache_size;
+
+/* Send session-level SET commands along with the next dispatched command */
+extern bool gp_dispatch_session_state_delta;
+
+/* Leave utility commands in a transaction block running on the QEs */
+extern bool gp_dispatch_pipeline;
+
 /* The maximum number of times on average that the hybrid hashed aggregation
  * algorithm will plan to spill an input row to disk before including it in
  * an aggregation.  Increasing this parameter will cause the planner to choose
@@ -877,9 +1084,74 @@ extern bool gp_hashagg_streambottom;
  */
 extern int gp_hashagg_default_nbatches;
 
+/*
+ * When the streaming bottom stage of a two stage hashagg runs out of memory,
+ * send out only its cold groups and keep the frequently hit ones in the
+ * hash table.
+ */
+extern bool gp_hashagg_stream_keep_hot;
+
+/*
+ * Look up hashagg groups through an open-addressing table of hash tags
+ * rather than by walking the bucket chains.
+ */
+extern bool gp_hashagg_index_groups;
+
+/*
+ * When a flush of the streaming bottom stage of a two stage hashagg finds
+ * at least this many groups per input row, the stage stops aggregating
+ * and passes each row on as its own partial group.  0 disables this.
+ */
+extern double gp_hashagg_passthrough_ratio;
+
+/*
+ * Number of outer tuples a nested loop join over an inner index scan reads
+ * ahead, to probe the index once per distinct key, in key order.  0 or 1
+ * probes once per outer tuple.
+ */
+extern int gp_nestloop_probe_batch;
+
 /* Hashjoin use bloom filter */
 extern int gp_hashjoin_bloomfilter;
 
+/*
+ * Hashjoin builds a Bloom filter of the inner side's hash values and has
+ * the scan below it on the outer side drop rows that can't match.
+ */
+extern bool gp_hashjoin_runtime_filter;
+
+/*
+ * Once a hashjoin batch is loaded, lay out its buckets' hash values in one
+ * contiguous array, so that probes don't chase the bucket chains.
+ */
+extern bool gp_hashjoin_compact_buckets;
+
+/*
+ * gp_hashjoin_build_threads
+ *
+ * Number of threads, besides the backend, that link a hashjoin batch's
+ * tuples into their buckets and lay out its compact probe array.  0 does
+ * it all on the backend.
+ */
+extern int gp_hashjoin_build_threads;
+
+/*
+ * gp_hashjoin_dedup_inner
+ *
+ * Drop inner tuples with duplicate join keys while building the hash table
+ * of a semi or anti join, when no other qual needs them.
+ */
+extern bool gp_hashjoin_dedup_inner;
+
+/*
+ * gp_hashjoin_share_broadcast
+ *
+ * When the inner side of a hashjoin is broadcast, the QEs of a slice on one
+ * host all build the same hash table.  The first one to finish copies it to
+ * a shared memory arena of the host, and all of them probe that copy.
+ */
+extern bool gp_hashjoin_share_broadcast;
+
 /* Get statistics for partitioned parent from a child */
 extern bool 	gp_statistics_pullup_from_child_partition;
 
@@ -891,6 +1163,35 @@ extern int 		gp_statistics_blocks_target;
 extern double	gp_statistics_ndistinct_scaling_ratio_threshold;
 extern double	gp_statistics_sampling_threshold;
 
+/*
+ * gp_statistics_ao_block_sampling
+ *
+ * ANALYZE samples append-only row tables by varblock, and then by row within
+ * the chosen varblocks.  It does so by setting
+ * gp_statistics_ao_block_sample_fraction around its sample query; scans of
+ * append-only row tables skip the other varblocks without decompressing them.
+ */
+extern bool		gp_statistics_ao_block_sampling;
+extern double	gp_statistics_ao_block_sample_fraction;
+
+/*
+ * gp_statistics_use_hll
+ *
+ * ANALYZE scans the whole table once more to estimate the number of distinct
+ * values of each column with HyperLogLog sketches, built on the segments and
+ * merged on the QD, instead of extrapolating from the sample.
+ */
+extern bool		gp_statistics_use_hll;
+
+/*
+ * gp_statistics_collect_dependencies
+ *
+ * ANALYZE measures from the sample how much each column determines the
+ * values of the others, and stores it in a STATISTIC_KIND_DEPENDENCY slot.
+ * The planner uses it for equality clauses and GROUP BY on several columns.
+ */
+extern bool		gp_statistics_collect_dependencies;
+
 /* Analyze tools */
 extern int gp_motion_slice_noop;
 
@@ -902,6 +1203,15 @@ extern bool gpvars_assign_gp_enable_gpperfmon(bool newval, bool doit, GucSource
 extern bool gpvars_assign_gp_gpperfmon_send_interval(int newval, bool doit, GucSource source);
 extern bool gp_enable_gpperfmon;
 extern int gp_gpperfmon_send_interval;
+
+/* Plan nodes per backend tracked for gp_query_progress(); 0 disables it */
+extern int	gp_query_progress_max_nodes;
+
+/* Entries of the ring buffer of gp_query_resource_history(); 0 disables it */
+extern int	gp_query_history_size;
+
+/* Statements whose latency gp_statement_stats() keeps; 0 disables it */
+extern int	gp_statement_stats_max;
 extern bool force_bitmap_table_scan;
 
 extern bool dml_ignore_target_partition_check;
@@ -925,9 +1235,32 @@ extern const char *gpvars_show_gp_gpperfmon_log_alert_level(void);
 
 extern int gp_workfile_compress_algorithm;
 extern bool gp_workfile_checksumming;
+
+/*
+ * Size, in kilobytes, of the reads and writes of bfz work files, and 0 for
+ * the default of each compression algorithm.  When set, the writeback of
+ * every write is started at once.
+ */
+extern int gp_workfile_io_size;
 extern double gp_workfile_limit_per_segment;
 extern double gp_workfile_limit_per_query;
 extern int gp_workfile_limit_files_per_query;
+
+/*
+ * Directories, outside the temporary filespace, that workfile sets are
+ * created in: tiers separated by ';', fastest first, each a ','-separated
+ * list of directories used round-robin.  A location whose file system has
+ * less than gp_workfile_spill_location_min_free kilobytes free is skipped.
+ */
+extern char *gp_workfile_spill_locations;
+extern int gp_workfile_spill_location_min_free;
+
+/*
+ * Kilobytes of workfiles that a backend may keep of spilled Material
+ * results, for later queries of a serializable transaction to read
+ * instead of running the same subplan again.  0 keeps none.
+ */
+extern int gp_workfile_reuse_limit;
 extern int gp_workfile_caching_loglevel;
 extern int gp_sessionstate_loglevel;
 extern bool gp_workfile_faultinject;
@@ -945,12 +1278,14 @@ typedef enum
 	GP_AUTOSTATS_NONE = 0,		/* Autostats is switched off */
 	GP_AUTOSTATS_ON_CHANGE,		/* Autostats is enabled on change (insert/delete/update/ctas) */
 	GP_AUTOSTATS_ON_NO_STATS,		/* Autostats is enabled on ctas or copy or insert if no stats are present */
+	GP_AUTOSTATS_ON_CHANGE_SINCE_ANALYZE,	/* Autostats is enabled once enough tuples changed since the last analyze */
 } GpAutoStatsModeValue;
 extern GpAutoStatsModeValue gp_autostats_mode;
 extern char                *gp_autostats_mode_string;
 extern GpAutoStatsModeValue gp_autostats_mode_in_functions;
 extern char                *gp_autostats_mode_in_functions_string;
 extern int                  gp_autostats_on_change_threshold;
+extern int                  gp_autostats_min_interval;
 extern bool					log_autostats;
 /* hook functions to set gp_autostats_mode and gp_autostats_mode_in_functions */
 extern const char *gpvars_assign_gp_autostats_mode(const char *newval, bool doit, GucSource source);
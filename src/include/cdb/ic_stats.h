@@ -0,0 +1,70 @@
+/*-------------------------------------------------------------------------
+ *
+ * ic_stats.h
+ *	   Live interconnect statistics, published in shared memory.
+ *
+ * Portions Copyright (c) 2012-Present Pivotal Software, Inc.
+ *
+ *
+ * IDENTIFICATION
+ *	    src/include/cdb/ic_stats.h
+ *
+ *-------------------------------------------------------------------------
+ */
+
+#ifndef IC_STATS_H
+#define IC_STATS_H
+
+#include "fmgr.h"
+
+/*
+ * One slot per backend, indexed by MyBackendId.  The owning backend
+ * periodically copies its interconnect state into the slot while an
+ * interconnect is set up, so that gp_interconnect_stats() can show it to
+ * other sessions while the query runs.
+ *
+ * Only the owning backend writes the slot.  Writers bump changecount
+ * before and after each update, like PgBackendStatus.st_changecount, so
+ * that readers can take a consistent copy without a lock.
+ */
+typedef struct ICStatsSlot
+{
+	int			changecount;
+
+	int			pid;			/* 0 when not in an interconnect */
+	int			sessionId;
+	int			commandCount;
+	int			sliceId;
+
+	int			numSendConns;	/* connections we send on */
+	int			numRecvConns;	/* connections we receive on */
+
+	/* receive side */
+	int			rxBuffersInUse;	/* buffers allocated from the RxBufferPool */
+	int			rxBuffersMax;	/* the pool's current limit */
+	int			recvQueueLength;	/* packets queued over all connections */
+	int			maxRecvQueueLength;	/* longest queue of any connection */
+	int			maxRecvQueueContent;	/* sender content of that queue */
+
+	/* send side */
+	int			unackQueueLength;	/* unacked packets over all connections */
+	int			maxUnackQueueLength;	/* longest unack queue of any connection */
+	int			maxUnackQueueContent;	/* receiver content of that queue */
+
+	int64		retransmits;
+	int64		duplicates;
+	int64		putRxBufferCount;	/* calls of MlPutRxBufferIFC() */
+	int64		putRxBufferTime;	/* usecs spent in MlPutRxBufferIFC() */
+	int64		waitTime;		/* usecs the main thread waited for packets */
+} ICStatsSlot;
+
+extern Size ICStatsShmemSize(void);
+extern void ICStatsShmemInit(void);
+
+extern volatile ICStatsSlot *ICStatsBeginUpdate(void);
+extern void ICStatsEndUpdate(volatile ICStatsSlot *slot);
+extern void ICStatsClear(void);
+
+extern Datum gp_interconnect_stats(PG_FUNCTION_ARGS);
+
+#endif   /* IC_STATS_H */
@@ -270,6 +270,16 @@ extern void putTransportDirectBuffer(ChunkTransportState *transportStates,
 									 int16 motNodeID,
 									 int16 targetRoute, int serializedLength);
 
+/*
+ * Transmit whatever the direct buffer holds, so that the next call to
+ * getTransportDirectBuffer() returns an empty buffer. Returns false if the
+ * receiver asked us to stop sending.
+ */
+extern bool flushTransportDirectBuffer(MotionLayerState *mlStates,
+									   ChunkTransportState *transportStates,
+									   int16 motNodeID,
+									   int16 targetRoute);
+
 /* doBroadcast() is used to send a TupleChunk to all recipients.
  *
  * PARAMETERS
@@ -320,6 +330,7 @@ extern TupleChunkListItem RecvTupleChunk(MotionConn *conn, ChunkTransportState *
 extern void InitMotionTCP(int *listenerSocketFd, uint16 *listenerPort);
 extern void InitMotionUDPIFC(int *listenerSocketFd, uint16 *listenerPort);
 extern void markUDPConnInactiveIFC(MotionConn *conn);
+extern void markTCPConnDone(MotionConn *conn);
 extern void CleanupMotionTCP(void);
 extern void CleanupMotionUDPIFC(void);
 extern void WaitInterconnectQuitUDPIFC(void);
@@ -22,5 +22,6 @@ extern TupleRemapper *CreateTupleRemapper(void);
 extern void DestroyTupleRemapper(TupleRemapper *remapper);
 extern HeapTuple TRCheckAndRemap(TupleRemapper *remapper, TupleDesc tupledesc, HeapTuple tuple);
 extern void TRHandleTypeLists(TupleRemapper *remapper, List *typelist);
+extern bool TRTupleDescNeedsRemap(TupleDesc tupledesc);
 
 #endif   /* TUPLEREMAP_H */
@@ -61,6 +61,11 @@ typedef struct SerTupInfo
 
 	/* true if tupdesc contains record types */
 	bool		has_record_types;
+
+	/* Compressed tuples received, see CompressTupleChunkList() */
+	uint64		recv_compressed_tuples;
+	uint64		recv_compressed_bytes;
+	uint64		recv_decompressed_bytes;
 }	SerTupInfo;
 
 /*
@@ -85,6 +90,18 @@ extern void SerializeRecordCacheIntoChunks(SerTupInfo *pSerInfo,
 /* Convert a HeapTuple into chunks ready to send out, in one pass */
 extern void SerializeTupleIntoChunks(HeapTuple tuple, SerTupInfo *pSerInfo, TupleChunkList tcList);
 
+/* Compress the serialized tuple in a chunk list, if that makes it smaller */
+extern bool CompressTupleChunkList(TupleChunkList tcList, SerTupInfo *pSerInfo);
+
+/* Serialize a HeapTuple, optionally compressed, into a flat buffer */
+extern void SerializeTupleIntoBuffer(HeapTuple tuple, SerTupInfo *pSerInfo, bool compress, StringInfo buf);
+
+/* Convert the output of SerializeTupleIntoBuffer() back into a HeapTuple */
+extern HeapTuple DeserializeTupleFromBuffer(SerTupInfo *pSerInfo, const char *data, int len);
+
+/* Space needed by SerializeTupleDirect(), or 0 if it can't handle the tuple */
+extern int SerializeTupleDirectSize(HeapTuple tuple, SerTupInfo *pSerInfo);
+
 /* Convert a HeapTuple into chunks directly in a set of transport buffers */
 extern int SerializeTupleDirect(HeapTuple tuple, SerTupInfo *pSerInfo, struct directTransportBuffer *b);
 
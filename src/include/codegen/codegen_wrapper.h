@@ -34,6 +34,11 @@ struct PlanState;
 struct AggState;
 struct MemoryManagerContainer;
 struct AggStatePerGroupData;
+struct HashState;
+struct HashJoinTableData;
+struct List;
+struct DatumStreamBlockRead;
+struct ScanState;
 /*
  * Enum used to mimic ExprDoneCond in ExecEvalExpr function pointer.
  */
@@ -45,13 +50,18 @@ typedef void (*AdvanceAggregatesFn) (struct AggState *aggstate, /*struct AggStat
 typedef void (*ExecVariableListFn) (struct ProjectionInfo *projInfo, Datum *values, bool *isnull);
 typedef Datum (*ExecEvalExprFn) (struct ExprState *expression, struct ExprContext *econtext, bool *isNull, /*ExprDoneCond*/ tmp_enum *isDone);
 typedef Datum (*SlotGetAttrFn) (struct TupleTableSlot *slot, int attnum, bool *isnull);
+typedef bool (*ExecHashGetHashValueFn) (struct HashState *hashState, struct HashJoinTableData *hashtable, struct ExprContext *econtext, struct List *hashkeys, bool outer_tuple, bool keep_nulls, uint32 *hashvalue, bool *hashkeys_null);
+typedef void (*DatumStreamBlockReadGetBatchFn) (struct DatumStreamBlockRead *dsr, int nrows, Datum *values, bool *nulls);
+typedef bool (*ExecScanQualProjectFn) (struct ScanState *node);
 
 #ifndef USE_CODEGEN
 
 #define InitCodegen() ((void) 1)
-#define CodeGeneratorManagerCreate(module_name) ((void *) NULL)
+#define CodeGeneratorManagerCreate(module_name, optimization_level) ((void *) NULL)
 #define CodeGeneratorManagerGenerateCode(manager) ((unsigned int) 1)
 #define CodeGeneratorManagerPrepareGeneratedFunctions(manager) ((unsigned int) 1)
+#define CodeGeneratorManagerPrepareGeneratedFunctionsInBackground(manager) ((bool) false)
+#define CodeGeneratorManagerPollGeneratedFunctions(manager) ((bool) false)
 #define CodeGeneratorManagerNotifyParameterChange(manager) ((unsigned int) 1)
 #define CodeGeneratorManagerAccumulateExplainString(manager) ((void) 1)
 #define CodeGeneratorManagerGetExplainString(manager) ((char *) NULL)
@@ -67,6 +77,14 @@ typedef Datum (*SlotGetAttrFn) (struct TupleTableSlot *slot, int attnum, bool *i
 #define enroll_ExecVariableList_codegen(regular_func, ptr_to_chosen_func, proj_info, slot)
 #define call_AdvanceAggregates(aggstate, pergroup, mem_manager) advance_aggregates(aggstate, pergroup, mem_manager)
 #define enroll_AdvanceAggregates_codegen(regular_func, ptr_to_chosen_func, aggstate)
+#define call_ExecHashGetHashValue(gen_info, hashState, hashtable, econtext, hashkeys, outer_tuple, keep_nulls, hashvalue, hashkeys_null) \
+		ExecHashGetHashValue(hashState, hashtable, econtext, hashkeys, outer_tuple, keep_nulls, hashvalue, hashkeys_null)
+#define enroll_ExecHashGetHashValue_codegen(regular_func, gen_info, hashkeys, hash_operators, outer_tuple, econtext)
+#define call_DatumStreamBlockReadGetBatch(gen_info, dsr, nrows, values, nulls) \
+		DatumStreamBlockRead_GetBatch(dsr, nrows, values, nulls)
+#define enroll_DatumStreamBlockReadGetBatch_codegen(regular_func, gen_info, datumlen)
+#define call_ExecScanQualProject(gen_info, node) ExecScanQualProject(node)
+#define enroll_ExecScanQualProject_codegen(regular_func, gen_info, scan_state)
 #else
 
 /*
@@ -106,10 +124,11 @@ unsigned int
 InitCodegen();
 
 /*
- * Creates a manager for an operator
+ * Creates a manager for an operator, that compiles the generated code at
+ * the given CODEGEN_OPTIMIZATION_LEVEL_*
  */
 void*
-CodeGeneratorManagerCreate(const char* module_name);
+CodeGeneratorManagerCreate(const char* module_name, int optimization_level);
 
 /*
  * Calls all the registered CodegenInterface to generate code
@@ -124,6 +143,21 @@ CodeGeneratorManagerGenerateCode(void* manager);
 unsigned int
 CodeGeneratorManagerPrepareGeneratedFunctions(void* manager);
 
+/*
+ * Starts compiling the Codegen functions in a background thread, leaving
+ * the regular functions in place meanwhile. Returns true if the compilation
+ * is to be polled for with CodeGeneratorManagerPollGeneratedFunctions
+ */
+bool
+CodeGeneratorManagerPrepareGeneratedFunctionsInBackground(void* manager);
+
+/*
+ * Switches to the Codegen functions once their background compilation is
+ * done. Returns true while it is still running
+ */
+bool
+CodeGeneratorManagerPollGeneratedFunctions(void* manager);
+
 /*
  * Notifies a manager that the underlying operator has a parameter change
  */
@@ -167,6 +201,12 @@ SetActiveCodeGeneratorManager(void* manager);
 Datum
 slot_getattr_regular(struct TupleTableSlot *slot, int attnum, bool *isnull);
 
+/*
+ * Wrapper function for slot_getsomeattrs.
+ */
+void
+slot_getsomeattrs_regular(struct TupleTableSlot *slot, int attnum);
+
 /*
  * Wrapper function for att_align_nominal.
  */
@@ -185,6 +225,30 @@ SET_VARSIZE_regular(void* ptr, size_t len);
 uint32
 VARSIZE_regular(void* ptr);
 
+/*
+ * Wrapper function for textlike.
+ */
+bool
+textlike_regular(void* str, void* pat);
+
+/*
+ * Wrapper function for advance_transition_function, for the aggno'th
+ * aggregate of aggstate whose arguments are in args and argnulls.
+ */
+void
+advance_transition_function_regular(struct AggState *aggstate,
+		int aggno,
+		struct AggStatePerGroupData *pergroupstate,
+		Datum *args,
+		bool *argnulls,
+		struct MemoryManagerContainer *mem_manager);
+
+/*
+ * Wrapper function for tuplesort_putdatum.
+ */
+void
+tuplesort_putdatum_regular(void *sortstate, Datum val, bool isnull);
+
 /*
  * returns the pointer to the ExecVariableList
  */
@@ -212,6 +276,33 @@ AdvanceAggregatesCodegenEnroll(AdvanceAggregatesFn regular_func_ptr,
 		AdvanceAggregatesFn* ptr_to_regular_func_ptr,
 		struct AggState *aggstate);
 
+/*
+ * Enroll and returns the pointer to ExecHashGetHashValueGenerator
+ */
+void*
+ExecHashGetHashValueCodegenEnroll(ExecHashGetHashValueFn regular_func_ptr,
+		ExecHashGetHashValueFn* ptr_to_regular_func_ptr,
+		struct List *hashkeys,
+		struct List *hash_operators,
+		bool outer_tuple,
+		struct ExprContext *econtext);
+
+/*
+ * Enroll and returns the pointer to DatumStreamBlockReadGetBatchGenerator
+ */
+void*
+DatumStreamBlockReadGetBatchCodegenEnroll(DatumStreamBlockReadGetBatchFn regular_func_ptr,
+		DatumStreamBlockReadGetBatchFn* ptr_to_regular_func_ptr,
+		int32 datumlen);
+
+/*
+ * Enroll and returns the pointer to ExecScanQualProjectGenerator
+ */
+void*
+ExecScanQualProjectCodegenEnroll(ExecScanQualProjectFn regular_func_ptr,
+		ExecScanQualProjectFn* ptr_to_regular_func_ptr,
+		struct ScanState *scan_state);
+
 #ifdef __cplusplus
 }  // extern "C"
 #endif
@@ -219,12 +310,12 @@ AdvanceAggregatesCodegenEnroll(AdvanceAggregatesFn regular_func_ptr,
 /*
  * START_CODE_GENERATOR_MANAGER would switch to the specified code generator manager,
  * saving the oldCodeGeneratorManager. Must be paired with END_CODE_GENERATOR_MANAGER
+ * The manager may be NULL, then nothing gets enrolled.
  */
 #define START_CODE_GENERATOR_MANAGER(newManager)  \
 	do { \
 	  void *oldManager = NULL; \
 	  if (codegen) { \
-	    Assert(newManager != NULL); \
 	    oldManager = GetActiveCodeGeneratorManager(); \
 	    SetActiveCodeGeneratorManager(newManager);\
 	  } \
@@ -269,6 +360,33 @@ AdvanceAggregatesCodegenEnroll(AdvanceAggregatesFn regular_func_ptr,
 #define call_AdvanceAggregates(aggstate, pergroup, mem_manager) \
 		aggstate->AdvanceAggregates_gen_info.AdvanceAggregates_fn(aggstate, pergroup, mem_manager)
 
+/*
+ * Call ExecHashGetHashValue using function pointer ExecHashGetHashValue_fn of
+ * the given ExecHashGetHashValueCodegenInfo.
+ * Function pointer may point to regular version or generated function
+ */
+#define call_ExecHashGetHashValue(gen_info, hashState, hashtable, econtext, hashkeys, outer_tuple, keep_nulls, hashvalue, hashkeys_null) \
+		(gen_info).ExecHashGetHashValue_fn(hashState, hashtable, econtext, hashkeys, outer_tuple, keep_nulls, hashvalue, hashkeys_null)
+
+/*
+ * Call DatumStreamBlockRead_GetBatch using function pointer
+ * DatumStreamBlockReadGetBatch_fn of the given
+ * DatumStreamBlockReadGetBatchCodegenInfo.
+ * Function pointer may point to regular version or generated function
+ */
+#define call_DatumStreamBlockReadGetBatch(gen_info, dsr, nrows, values, nulls) \
+		(gen_info).DatumStreamBlockReadGetBatch_fn(dsr, nrows, values, nulls)
+
+/*
+ * Call ExecScanQualProject using function pointer ExecScanQualProject_fn of
+ * the given ExecScanQualProjectCodegenInfo. Only table scans are enrolled,
+ * so the regular version is called when the pointer was never set.
+ * Function pointer may point to regular version or generated function
+ */
+#define call_ExecScanQualProject(gen_info, node) \
+		((gen_info).ExecScanQualProject_fn ? \
+		 (gen_info).ExecScanQualProject_fn(node) : ExecScanQualProject(node))
+
 /*
  * Enrollment macros
  * The enrollment process also ensures that the generated function pointer
@@ -289,6 +407,21 @@ AdvanceAggregatesCodegenEnroll(AdvanceAggregatesFn regular_func_ptr,
 				regular_func, ptr_to_regular_func_ptr, aggstate); \
 				Assert(aggstate->AdvanceAggregates_gen_info.AdvanceAggregates_fn == regular_func); \
 
+#define enroll_ExecHashGetHashValue_codegen(regular_func, gen_info, hashkeys, hash_operators, outer_tuple, econtext) \
+		(gen_info).code_generator = ExecHashGetHashValueCodegenEnroll( \
+				regular_func, &(gen_info).ExecHashGetHashValue_fn, hashkeys, hash_operators, outer_tuple, econtext); \
+				Assert((gen_info).ExecHashGetHashValue_fn == regular_func); \
+
+#define enroll_DatumStreamBlockReadGetBatch_codegen(regular_func, gen_info, datumlen) \
+		(gen_info).code_generator = DatumStreamBlockReadGetBatchCodegenEnroll( \
+				regular_func, &(gen_info).DatumStreamBlockReadGetBatch_fn, datumlen); \
+				Assert((gen_info).DatumStreamBlockReadGetBatch_fn == regular_func); \
+
+#define enroll_ExecScanQualProject_codegen(regular_func, gen_info, scan_state) \
+		(gen_info).code_generator = ExecScanQualProjectCodegenEnroll( \
+				regular_func, &(gen_info).ExecScanQualProject_fn, scan_state); \
+				Assert((gen_info).ExecScanQualProject_fn == regular_func); \
+
 #endif //USE_CODEGEN
 
 #endif  // CODEGEN_WRAPPER_H_
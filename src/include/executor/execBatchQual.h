@@ -0,0 +1,28 @@
+/*--------------------------------------------------------------------------
+ *
+ * execBatchQual.h
+ *	 Evaluation of scan quals over batches of rows stored column by column
+ *
+ * Portions Copyright (c) 2012-Present Pivotal Software, Inc.
+ *
+ *
+ * IDENTIFICATION
+ *	    src/include/executor/execBatchQual.h
+ *
+ *--------------------------------------------------------------------------
+ */
+#ifndef EXECBATCHQUAL_H
+#define EXECBATCHQUAL_H
+
+#include "access/tupdesc.h"
+#include "nodes/pg_list.h"
+
+typedef struct BatchQual BatchQual;
+
+extern BatchQual *ExecInitBatchQual(List *qual, TupleDesc tupdesc,
+									int maxRows, bool *complete);
+extern int	ExecBatchQual(BatchQual *bq, Datum **values, bool **isnull,
+						  int *selected, int nselected);
+extern void ExecEndBatchQual(BatchQual *bq);
+
+#endif   /* EXECBATCHQUAL_H */
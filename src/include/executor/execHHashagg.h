@@ -45,6 +45,7 @@ typedef struct HashAggEntry
 	void *tuple_and_aggs; /* grouping keys and aggregate values.*/
 	HashKey hashvalue;
 	bool is_primodial; /* indicates if this entry is there before spilling. */
+	uint16 nhits; /* input rows that found this entry, saturating */
 } HashAggEntry;
 
 typedef HashAggEntry* HashAggBucket;
@@ -157,6 +158,17 @@ typedef struct HashAggTable
 	HashAggBucket  *buckets;
 	uint64 *bloom;
 
+	/*
+	 * Open-addressing index over the same entries, probed instead of the
+	 * bucket chains when present.  Slots come in groups of 16, and each
+	 * slot's control byte holds 7 bits of the entry's hash value, or the
+	 * empty marker, so that a whole group is checked with one compare.
+	 */
+	uint8 *idx_ctrl;
+	HashAggEntry **idx_slots;
+	uint32 idx_nslots; /* 0 if there is no index */
+	uint32 idx_used;
+
 	/* hashkey bitshift amount to determine bucket - used when spilling */
 	unsigned pshift;
 
@@ -210,6 +222,22 @@ typedef struct HashAggTable
 	bool expandable;  /* hash table buckets still have space to grow */
 	struct TupleTableSlot *prev_slot; /* a slot that is read previously. */
 
+	/*
+	 * Streaming bottom stage: hot groups held back from a flush, in the
+	 * format written by keep_hash_entry(), to be put back into the table
+	 * once it has been reset.
+	 */
+	bool stream_keep; /* the iterator holds back hot groups */
+	uint32 keep_min_hits; /* nhits that makes a group hot */
+	double keep_max_bytes; /* room for held back groups */
+	double kept_bytes; /* room they take up once back in the table */
+	StringInfo kept_groups;
+	uint64 stream_tuples; /* input tuples since the last flush */
+	uint64 num_kept_groups; /* groups held back, summed over flushes */
+	uint32 num_stream_flushes;
+	bool passthrough; /* stop aggregating after this flush */
+	uint64 num_passthrough_tuples; /* input tuples passed on as they came */
+
 	/* Statistics used for EXPLAIN ANALYZE */
 	CdbExplain_Agg      chainlength;
 	uint64 total_buckets; /* total of nbuckets across spills and reloads */
@@ -313,6 +313,7 @@ extern bool isJoinExprNull(List *joinExpr, ExprContext *econtext);
 typedef TupleTableSlot *(*ExecScanAccessMtd) (ScanState *node);
 
 extern TupleTableSlot *ExecScan(ScanState *node, ExecScanAccessMtd accessMtd);
+extern bool ExecScanQualProject(ScanState *node);
 extern void ExecAssignScanProjectionInfo(ScanState *node);
 extern void InitScanStateRelationDetails(ScanState *scanState, Plan *plan, EState *estate);
 extern void InitScanStateInternal(ScanState *scanState, Plan *plan,
@@ -43,6 +43,9 @@ struct StringInfoData;                  /* #include "lib/stringinfo.h" */
  * "hashCxt", while storage that is only wanted for the current batch is
  * allocated in the "batchCxt".  By resetting the batchCxt at the end of
  * each batch, we free all the per-batch storage reliably and without tedium.
+ * The in-memory tuples of the batch live in "tupleCxt", a Bump context under
+ * batchCxt: they are never freed one at a time, except when nbatch is
+ * increased, and then the tuples that stay are copied to a new tupleCxt.
  *
  * During first scan of inner relation, we get its tuples from executor.
  * If nbatch > 1 then tuples that don't belong in first batch get saved
@@ -145,6 +148,40 @@ typedef struct HashJoinBatchData
 /*
  * HashJoinTableData
  */
+/*
+ * A Bloom filter of the hash values of the inner side, filled while the hash
+ * table is built.  The scan producing the outer side checks its rows against
+ * it, so that rows which can't find a match are dropped before the join and
+ * the nodes in between see them (see ExecHashRuntimeFilterCheck).
+ *
+ * attnos are the scan tuple columns holding the outer hash keys; the hash
+ * value of a scan row is computed from them just like ExecHashGetHashValue
+ * does for the outer tuple.
+ */
+typedef struct HashRuntimeFilter
+{
+	uint64	   *bits;
+	uint32		mask;			/* # bits - 1; # bits is a power of 2 */
+
+	int			nkeys;
+	AttrNumber *attnos;
+	FmgrInfo   *hashfunctions;	/* the hashtable's outer_hashfunctions */
+	bool	   *hashStrict;
+
+	bool		complete;		/* inner side is all in */
+	bool		disabled;		/* doesn't reject enough to pay off */
+	double		ninserted;
+	double		nchecked;
+	double		nrejected;
+} HashRuntimeFilter;
+
+/* A current-batch tuple not yet linked into its bucket chain */
+typedef struct HashJoinPending
+{
+	struct HashJoinTupleData *tuple;
+	uint32		bucketno;
+} HashJoinPending;
+
 typedef struct HashJoinTableData
 {
 	int			nbuckets;		/* # buckets in the in-memory hash table */
@@ -185,6 +222,7 @@ typedef struct HashJoinTableData
 
 	MemoryContext hashCxt;		/* context for whole-hash-join storage */
 	MemoryContext batchCxt;		/* context for this-batch-only storage */
+	MemoryContext tupleCxt;		/* Bump context for this batch's tuples */
 	MemoryContext bfCxt;		/* CDB */ /* context for temp buf file */
 
     HashJoinTableStats *stats;  /* statistics workarea for EXPLAIN ANALYZE */
@@ -192,6 +230,62 @@ typedef struct HashJoinTableData
 
     HashJoinState * hjstate; /* reference to the enclosing HashJoinState */
     bool first_pass; /* Is this the first pass (pre-rescan) */
+
+	/*
+	 * Probe layout of the current batch, built from the bucket chains once
+	 * the batch is loaded (see ExecHashTableCompact).  The tuples of bucket
+	 * b are compactTuples[compactStart[b] .. compactStart[b + 1] - 1], in
+	 * chain order, and compactHashvalues holds their hash values, so that a
+	 * probe reads one short run of that array instead of a chain of tuples
+	 * scattered over memory.  compactStart is NULL while the batch is being
+	 * loaded, or if compactBuckets is off.  compactTupleSpace is what it
+	 * costs per tuple, charged to the batch's innerspace.
+	 */
+	bool		compactBuckets;
+	Size		compactTupleSpace;
+	uint32	   *compactStart;
+	uint32	   *compactHashvalues;
+	struct HashJoinTupleData **compactTuples;
+
+	/*
+	 * With buildThreads > 0, tuples of the current batch are not linked into
+	 * their bucket chains as they arrive but collected in pendingTuples, and
+	 * linked in bulk by worker threads that each own a range of buckets (see
+	 * ExecHashTableLinkPending).  The bucket chains are only valid once the
+	 * pending tuples have been linked.  pendingTupleSpace is what an entry
+	 * costs, charged to the batch's innerspace.
+	 */
+	int			buildThreads;
+	Size		pendingTupleSpace;
+	struct HashJoinPending *pendingTuples;
+	int			npending;
+	int			maxpending;
+
+	/*
+	 * A semi or anti join only asks whether an outer tuple has a match, so
+	 * when nothing but the hash clauses looks at the inner tuple, one inner
+	 * tuple per distinct key is enough.  With dedupInner, a tuple whose keys
+	 * equal those of a tuple already in its bucket is dropped on insert.
+	 * inner_eqfunctions compare inner keys with each other, dedupValues
+	 * holds the new tuple's keys and dedupSlot is where the tuples already
+	 * in the bucket are put to evaluate theirs.
+	 */
+	bool		dedupInner;
+	FmgrInfo   *inner_eqfunctions;
+	Datum	   *dedupValues;
+	struct TupleTableSlot *dedupSlot;
+	double		ndupsDropped;
+
+	HashRuntimeFilter *runtimeFilter;	/* NULL if not applicable */
+	struct ScanState *runtimeFilterTarget;	/* scan it was pushed to */
+
+	/*
+	 * With gp_hashjoin_share_broadcast, the host arena holding the copy of a
+	 * broadcast inner side that all the QEs of the slice on this host probe
+	 * (see ExecHashTableShareBroadcast).  The compact probe layout then
+	 * points into the arena, and the bucket chains are empty.
+	 */
+	struct HostArena *hostArena;
 } HashJoinTableData;
 
 #endif   /* HASHJOIN_H */
@@ -28,6 +28,9 @@ typedef struct Instrumentation
 	instr_time	counter;		/* Accumulated runtime for this node */
 	double		firsttuple;		/* Time for first tuple of this cycle */
 	double		tuplecount;		/* Tuples emitted so far this cycle */
+	int64		ncalls;			/* CDB: calls of the node so far this cycle */
+	int64		ntimed;			/* CDB: how many of those calls were timed */
+	bool		untimed;		/* CDB: the current call is not being timed */
 	/* Accumulated statistics across all completed cycles: */
 	double		startup;		/* Total startup time (in seconds) */
 	double		total;			/* Total total time (in seconds) */
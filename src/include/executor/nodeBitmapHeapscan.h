@@ -24,6 +24,7 @@ extern void ExecBitmapHeapReScan(BitmapHeapScanState *node, ExprContext *exprCtx
 extern void ExecEagerFreeBitmapHeapScan(BitmapHeapScanState *node);
 
 extern void bitgetpage(HeapScanDesc scan, TBMIterateResult *tbmres);
+extern void bitprefetch(HeapScanDesc scan, Node *tbm);
 
 static inline gpmon_packet_t * GpmonPktFromBitmapHeapScanState(BitmapHeapScanState *node)
 {
@@ -29,6 +29,10 @@ extern void ExecReScanHash(HashState *node, ExprContext *exprCtxt);
 
 extern HashJoinTable ExecHashTableCreate(HashState *hashState, HashJoinState *hjstate, List *hashOperators, uint64 operatorMemKB);
 extern void ExecHashTableDestroy(HashState *hashState, HashJoinTable hashtable);
+extern void ExecHashTableCompact(HashJoinTable hashtable);
+extern void ExecHashRuntimeFilterPushdown(HashJoinTable hashtable, PlanState *outerNode);
+extern bool ExecHashRuntimeFilterCheck(HashRuntimeFilter *filter, TupleTableSlot *slot,
+						   ExprContext *econtext);
 extern bool ExecHashTableInsert(HashState *hashState, HashJoinTable hashtable,
 					struct TupleTableSlot *slot,
 					uint32 hashvalue);
@@ -26,6 +26,12 @@ extern void ExecEagerFreeShareInputScan(ShareInputScanState *node);
 
 extern void ExecSliceDependencyShareInputScan(ShareInputScanState *node);
 
+extern int gp_shareinput_shmem_slots;
+extern int gp_shareinput_shmem_slot_size;
+
+extern Size ShareInputShmemSize(void);
+extern void ShareInputShmemInit(void);
+
 static inline gpmon_packet_t * GpmonPktFromShareInputState(ShareInputScanState *node)
 {
 	return &node->ss.ps.gpmon_pkt;
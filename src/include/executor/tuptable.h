@@ -250,11 +250,8 @@ static inline void slot_getsomeattrs(TupleTableSlot *slot, int attnum)
 
 	if(TupHasMemTuple(slot))
 	{
-		int i; 
-		for(i=0; i<attnum; ++i)
-			slot->PRIVATE_tts_values[i] = memtuple_getattr(
-					slot->PRIVATE_tts_memtuple, slot->tts_mt_bind, 
-					i+1, &(slot->PRIVATE_tts_isnull[i]));
+		memtuple_getattrs(slot->PRIVATE_tts_memtuple, slot->tts_mt_bind, attnum,
+						  slot->PRIVATE_tts_values, slot->PRIVATE_tts_isnull);
 
 		TupSetVirtualTuple(slot);
 		slot->PRIVATE_tts_nvalid = attnum;
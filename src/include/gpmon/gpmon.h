@@ -8,6 +8,8 @@ typedef struct gpmon_packet_t gpmon_packet_t;
 typedef struct gpmon_qlogkey_t gpmon_qlogkey_t;
 typedef struct gpmon_qlog_t gpmon_qlog_t;
 typedef struct gpmon_qexec_t gpmon_qexec_t;
+typedef struct gpmon_qexec_rec_t gpmon_qexec_rec_t;
+typedef struct gpmon_qexec_batch_t gpmon_qexec_batch_t;
 typedef struct gpmon_hello_t gpmon_hello_t;
 typedef struct gpmon_metrics_t gpmon_metrics_t;
 typedef struct gpmon_seginfo_t gpmon_seginfo_t;
@@ -52,6 +54,7 @@ extern void gpmon_qlog_query_end(gpmon_packet_t *gpmonPacket);
 extern void gpmon_qlog_query_error(gpmon_packet_t *gpmonPacket);
 extern void gpmon_qlog_query_canceling(gpmon_packet_t *gpmonPacket);
 extern void gpmon_send(gpmon_packet_t*);
+extern void gpmon_flush(void);
 extern void gpmon_gettmid(int32*);
 
 /* ------------------------------------------------------------------
@@ -206,6 +209,35 @@ struct gpmon_qexec_t {
 	uint64 		rowsin;
 };
 
+/*
+ * QEXEC_BATCH
+ *
+ * A QE doesn't send its QEXEC packets one by one. It coalesces them per
+ * plan node and sends them in batches, at most one per tick, see
+ * gpmon_send(). Only the part of the batch that's filled in is sent, so the
+ * packet's length is that of the header plus nrecs records.
+ */
+#define GPMON_QEXEC_BATCH_MAX 64
+
+struct gpmon_qexec_rec_t {
+	gpmon_qexeckey_t key;
+	uint8		status;		/* node status using PerfmonNodeStatus */
+	uint64		rowsout;
+	uint64		rowsin;
+};
+
+struct gpmon_qexec_batch_t {
+    /* same header as gpmon_packet_t */
+    int32 magic;
+    int16 version;
+    int16 pkttype;
+    int32 nrecs;
+    gpmon_qexec_rec_t recs[GPMON_QEXEC_BATCH_MAX];
+};
+
+#define GPMON_QEXEC_BATCH_SIZE(nrecs) \
+	(offsetof(gpmon_qexec_batch_t, recs) + (nrecs) * sizeof(gpmon_qexec_rec_t))
+
 /*
  * Segment-related statistics
  */
@@ -234,7 +266,7 @@ struct gpmon_hello_t {
 /*
  *  This version must match the most significant digit of the greenplum system version.
  */
-#define GPMON_PACKET_VERSION   5
+#define GPMON_PACKET_VERSION   6
 #define GPMMON_PACKET_VERSION_STRING "gpmmon packet version 5\n"
 
 enum gpmon_pkttype_t {
@@ -247,6 +279,7 @@ enum gpmon_pkttype_t {
     GPMON_PKTTYPE_QUERY_HOST_METRICS = 7, // query metrics update from a segment such as CPU per query
     GPMON_PKTTYPE_FSINFO = 8,
     GPMON_PKTTYPE_QUERYSEG = 9,
+    GPMON_PKTTYPE_QEXEC_BATCH = 10,	/* gpmon_qexec_batch_t, QE to gpsmon only */
 
     GPMON_PKTTYPE_MAX
 };
@@ -246,6 +246,7 @@ namespace gpdxl
 			DrgPdxlbucket *PdrgpdxlbucketTransformStats
 								(
 								IMemoryPool *pmp,
+								CMDAccessor *pmda,
 								OID oidAttType,
 								CDouble dDistinct,
 								CDouble dNullFreq,
@@ -221,6 +221,10 @@ class COptTasks
 		static
 		DrgPss *PdrgPssLoad(IMemoryPool *pmp, char *szPath);
 
+		// create the default search strategy, with a time limit
+		static
+		DrgPss *PdrgPssTimeLimited(IMemoryPool *pmp, ULONG ulTimeLimit);
+
 		// helper for converting wide character string to regular string
 		static
 		CHAR *SzFromWsz(const WCHAR *wsz);
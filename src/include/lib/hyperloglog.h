@@ -0,0 +1,29 @@
+/*-------------------------------------------------------------------------
+ *
+ * hyperloglog.h
+ *	  HyperLogLog sketches, to estimate the number of distinct values
+ *
+ * A sketch is an array of HLL_REGISTERS one-byte registers. Sketches built
+ * from different sets of values can be merged into the sketch of their
+ * union, so that each segment can build its own.
+ *
+ * Portions Copyright (c) 2012-Present Pivotal Software, Inc.
+ *
+ *
+ * IDENTIFICATION
+ *	    src/include/lib/hyperloglog.h
+ *
+ *-------------------------------------------------------------------------
+ */
+#ifndef HYPERLOGLOG_H
+#define HYPERLOGLOG_H
+
+/* 2^12 registers give a standard error of about 1.6% */
+#define HLL_BITS		12
+#define HLL_REGISTERS	(1 << HLL_BITS)
+
+extern void hll_add_hash(uint8 *registers, uint32 hash);
+extern void hll_merge(uint8 *registers, const uint8 *other);
+extern double hll_estimate(const uint8 *registers);
+
+#endif   /* HYPERLOGLOG_H */
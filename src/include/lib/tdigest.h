@@ -0,0 +1,57 @@
+/*-------------------------------------------------------------------------
+ *
+ * tdigest.h
+ *	  t-digest sketches, to estimate quantiles of a stream of numbers
+ *
+ * A digest summarizes the values added to it by a bounded number of
+ * centroids, which are small near the tails so that extreme quantiles stay
+ * accurate. Digests built from different sets of values can be merged into
+ * the digest of their union, so that each segment can build its own.
+ *
+ * Portions Copyright (c) 2012-Present Pivotal Software, Inc.
+ *
+ *
+ * IDENTIFICATION
+ *	    src/include/lib/tdigest.h
+ *
+ *-------------------------------------------------------------------------
+ */
+#ifndef TDIGEST_H
+#define TDIGEST_H
+
+/*
+ * The compression bounds the number of merged centroids. With 200, a
+ * million values keep about 120 centroids, and the p99 estimate is within
+ * a fraction of a percent of the exact value.
+ */
+#define TDIGEST_COMPRESSION		200
+#define TDIGEST_MAX_MERGED		(2 * TDIGEST_COMPRESSION)
+#define TDIGEST_BUFFER			500
+#define TDIGEST_CENTROIDS		(TDIGEST_MAX_MERGED + TDIGEST_BUFFER)
+
+typedef struct TDigestCentroid
+{
+	double		mean;
+	double		count;
+} TDigestCentroid;
+
+/*
+ * A digest has a fixed size. The first nmerged centroids are sorted by mean
+ * and compressed; the next nbuffered ones are values added since.
+ */
+typedef struct TDigest
+{
+	double		total;			/* total count of all the centroids */
+	double		min;
+	double		max;
+	int32		nmerged;
+	int32		nbuffered;
+	TDigestCentroid centroids[TDIGEST_CENTROIDS];
+} TDigest;
+
+extern void tdigest_init(TDigest *digest);
+extern void tdigest_add(TDigest *digest, double value);
+extern void tdigest_merge(TDigest *digest, const TDigest *other);
+extern double tdigest_quantile(TDigest *digest, double q);
+
+#endif   /* TDIGEST_H */
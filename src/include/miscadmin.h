@@ -214,6 +214,10 @@ extern PGDLLIMPORT int NBuffers;
 extern int	MaxBackends;
 extern int	MaxConnections;
 extern int gp_workfile_max_entries;
+extern int gp_shared_catcache_entries;
+extern int gp_persistent_relation_index_entries;
+extern int gp_sinval_queue_size;
+extern int gp_distributedlog_buffers;
 
 extern PGDLLIMPORT int MyProcPid;
 extern PGDLLIMPORT pg_time_t MyStartTime;
@@ -1400,6 +1400,8 @@ typedef struct PlanState
 
 	/* The manager manages all the code generators and generation process */
 	void *CodegenManager;
+	/* true while the manager compiles the generated code in the background */
+	bool		CodegenCompiling;
 
 	/*
 	 * EXPLAIN ANALYZE statistics collection
@@ -1414,6 +1416,9 @@ typedef struct PlanState
 	 */
 	int		gpmon_plan_tick;
 	gpmon_packet_t gpmon_pkt;
+
+	/* live progress counters in shared memory, see cdbprogress.c */
+	struct QueryProgressNode *progress;
 } PlanState;
 
 typedef struct Gpmon_NameUnit_MaxVal
@@ -1614,6 +1619,14 @@ typedef enum
 	TableTypeInvalid,
 } TableType;
 
+typedef struct ExecScanQualProjectCodegenInfo
+{
+	/* Pointer to store ExecScanQualProjectCodegen from Codegen */
+	void* code_generator;
+	/* Function pointer that points to either regular or generated ExecScanQualProject */
+	ExecScanQualProjectFn ExecScanQualProject_fn;
+} ExecScanQualProjectCodegenInfo;
+
 /* ----------------
  *	 ScanState information
  *
@@ -1627,6 +1640,8 @@ typedef enum
  *		ScanTupleSlot	   pointer to slot in tuple table holding scan tuple
  *		scan_state		   the stage of scanning
  *		tableType		   the table type of the target relation
+ *		ss_runtimeFilter   hash join filter to drop scan tuples by (or NULL)
+ *		ExecScanQualProject_gen_info  the (generated) qual and projection step
  * ----------------
  */
 typedef struct ScanState
@@ -1639,6 +1654,15 @@ typedef struct ScanState
 
 	/* The type of the table that is being scanned */
 	TableType	tableType;
+
+	/* Set by a hash join above us, see ExecHashRuntimeFilterCheck */
+	struct HashRuntimeFilter *ss_runtimeFilter;
+
+	/* The access method has already checked the quals of its tuples */
+	bool		ss_qualsChecked;
+
+	/* Checks the quals of and projects each scan tuple */
+	ExecScanQualProjectCodegenInfo ExecScanQualProject_gen_info;
 } ScanState;
 
 /*
@@ -2036,6 +2060,25 @@ typedef struct AOCSScanOpaqueData
 	int			ncol;
 
 	struct AOCSScanDescData *scandesc;
+
+	/* The rows read from scandesc but not returned yet. */
+	struct AOCSBatchData *batch;
+
+	/*
+	 * The column the quals depend on, if they depend on exactly one and can
+	 * be evaluated ahead of ExecScan; -1 otherwise.  dictQualResults caches
+	 * the outcome of the quals per dictionary code of that column for the
+	 * current batch: 0 unknown, 1 pass, 2 fail.
+	 */
+	int			qualAttno;
+	int8	   *dictQualResults;
+
+	/*
+	 * The leading quals, evaluated on each batch a column at a time, or
+	 * NULL.  batchQualComplete if that is all of them.
+	 */
+	struct BatchQual *batchQual;
+	bool		batchQualComplete;
 } AOCSScanOpaqueData;
 
 /* -----------------------------------------------
@@ -2055,6 +2098,17 @@ typedef struct AOCSScanState
  * During execution, the 'opaque' is mapped to different XXXOpaqueData
  * for different table type.
  */
+typedef struct DatumStreamBlockReadGetBatchCodegenInfo
+{
+	/* Pointer to store DatumStreamBlockReadGetBatchCodegen from Codegen */
+	void* code_generator;
+	/* Function pointer that points to either regular or generated DatumStreamBlockRead_GetBatch */
+	DatumStreamBlockReadGetBatchFn DatumStreamBlockReadGetBatch_fn;
+} DatumStreamBlockReadGetBatchCodegenInfo;
+
+/* Datum lengths DatumStreamBlockRead_GetBatch is generated for: 1, 2, 4, 8 */
+#define NUM_DATUMSTREAM_GET_BATCH_LENGTHS 4
+
 typedef struct TableScanState
 {
 	ScanState	ss;
@@ -2063,6 +2117,12 @@ typedef struct TableScanState
 	 * Opaque data that is associated with different table type.
 	 */
 	void	   *opaque;
+
+	/*
+	 * Column readers of AOCS tables, one per datum length passed by value,
+	 * indexed by the log2 of the length.
+	 */
+	DatumStreamBlockReadGetBatchCodegenInfo DatumStreamBlockReadGetBatch_gen_info[NUM_DATUMSTREAM_GET_BATCH_LENGTHS];
 } TableScanState;
 
 /*
@@ -2163,6 +2223,8 @@ typedef struct NestLoopState
 	List	   *nl_OuterJoinKeys;        /* list of ExprState nodes */
 	bool		nl_innerSideScanned;      /* set to true once we've scanned all inner tuples the first time */
 	bool		nl_qualResultForNull;     /* the value of the join condition when one of the sides contains a NULL */
+
+	struct NestLoopBatch *nl_batch;	/* batched inner index probes, or NULL */
 } NestLoopState;
 
 /* ----------------
@@ -2219,6 +2281,8 @@ typedef struct MergeJoinState
  *		hj_CurBucketNo			bucket# for current outer tuple
  *		hj_CurTuple				last inner tuple matched to current outer
  *								tuple, or NULL if starting search
+ *		hj_CurCompactPos		position of hj_CurTuple in the hash table's
+ *								compact layout, if it has one
  *								(CurHashValue, CurBucketNo and CurTuple are
  *								 undefined if OuterTupleSlot is empty!)
  *		hj_OuterHashKeys		the outer hash keys in the hashjoin condition
@@ -2239,6 +2303,14 @@ typedef struct MergeJoinState
 typedef struct HashJoinTupleData *HashJoinTuple;
 typedef struct HashJoinTableData *HashJoinTable;
 
+typedef struct ExecHashGetHashValueCodegenInfo
+{
+	/* Pointer to store ExecHashGetHashValueCodegen from Codegen */
+	void* code_generator;
+	/* Function pointer that points to either regular or generated ExecHashGetHashValue */
+	ExecHashGetHashValueFn ExecHashGetHashValue_fn;
+} ExecHashGetHashValueCodegenInfo;
+
 typedef struct HashJoinState
 {
 	JoinState	js;				/* its first field is NodeTag */
@@ -2248,6 +2320,7 @@ typedef struct HashJoinState
 	uint32		hj_CurHashValue;
 	int			hj_CurBucketNo;
 	HashJoinTuple hj_CurTuple;
+	uint32		hj_CurCompactPos;
 	List	   *hj_OuterHashKeys;		/* list of ExprState nodes */
 	List	   *hj_InnerHashKeys;		/* list of ExprState nodes */
 	List	   *hj_HashOperators;		/* list of operator OIDs */
@@ -2265,6 +2338,9 @@ typedef struct HashJoinState
 	/* set if the operator created workfiles */
 	bool workfiles_created;
 	bool reuse_hashtable; /* Do we need to preserve hash table to support rescan */
+
+	/* Hashes the outer tuples */
+	ExecHashGetHashValueCodegenInfo ExecHashGetHashValue_gen_info;
 } HashJoinState;
 
 
@@ -2306,6 +2382,7 @@ typedef struct MaterialState
 	void	   *ts_pos;
 	void	   *ts_markpos;
 	void	   *share_lk_ctxt;
+	void	   *reuse_entry;	/* kept result being written or read, if any */
 } MaterialState;
 
 /* ----------------
@@ -2335,6 +2412,7 @@ extern void *shareinput_writer_notifyready(int share_id, int nsharer_xslice_noti
 extern void shareinput_reader_notifydone(void *, int share_id);
 extern void shareinput_writer_waitdone(void *, int share_id, int nsharer_xslice_wait_done);
 extern void shareinput_create_bufname_prefix(char* p, int size, int share_id);
+extern bool shareinput_shmem_publish(int share_id, struct NTupleStore *ts);
 
 /* ----------------
  *	 SortState information
@@ -2354,6 +2432,16 @@ typedef struct SortState
 
 	void	   *share_lk_ctxt;
 
+	/*
+	 * Incremental mode: the input is sorted on the first numPresortedCols
+	 * sort keys, and is sorted and returned a batch of whole groups of equal
+	 * leading keys at a time.  ss_ScanTupleSlot holds the first tuple of the
+	 * next batch, if it has been read already.
+	 */
+	int			numPresortedCols;	/* 0 if not in incremental mode */
+	FmgrInfo   *presortedEqfuncs;	/* equality fns for the leading keys */
+	bool		input_Done;		/* outer plan exhausted? */
+	int64		incr_returned;	/* tuples returned so far, for the bound */
 } SortState;
 
 /* ---------------------
@@ -2387,6 +2475,7 @@ typedef enum HashAggStatus
 	HASHAGG_IN_A_PASS,
 	HASHAGG_BETWEEN_PASSES,
 	HASHAGG_STREAMING,
+	HASHAGG_PASSTHROUGH,
 	HASHAGG_END_OF_PASSES
 } HashAggStatus;
 
@@ -2533,6 +2622,9 @@ typedef struct HashState
 	bool		hs_quit_if_hashkeys_null;	/* quit building hash table if hashkeys are all null */
 	bool		hs_hashkeys_null;	/* found an instance wherein hashkeys are all null */
 	/* hashkeys is same as parent's hj_InnerHashKeys */
+
+	/* Hashes the inner tuples; enrolled by the parent HashJoin */
+	ExecHashGetHashValueCodegenInfo ExecHashGetHashValue_gen_info;
 } HashState;
 
 /* ----------------
@@ -2544,6 +2636,9 @@ typedef struct HashState
  *		how many duplicates to return.
  * ----------------
  */
+/* this struct is private in nodeSetOp.c: */
+typedef struct SetOpSpillFile SetOpSpillFile;
+
 typedef struct SetOpState
 {
 	PlanState	ps;				/* its first field is NodeTag */
@@ -2552,6 +2647,17 @@ typedef struct SetOpState
 	long		numLeft;		/* number of left-input dups of cur group */
 	long		numRight;		/* number of right-input dups of cur group */
 	long		numOutput;		/* number of dups left to output */
+	/* these fields are used in SETOP_HASHED mode: */
+	FmgrInfo   *hashfunctions;	/* per-grouping-field hash fns */
+	TupleHashTable hashtable;	/* hash table with one entry per group */
+	MemoryContext tableContext; /* memory context containing hash table */
+	bool		table_filled;	/* hash table filled yet? */
+	TupleHashIterator hashiter; /* for iterating through hash table */
+	SetOpSpillFile *curfile;	/* spill file being read, NULL for subplan */
+	SetOpSpillFile **spillfiles;	/* spill files being written, or NULL */
+	List	   *pendingfiles;	/* spill files still to be read */
+	struct workfile_set *work_set;	/* workfile set for the spill files */
+	TupleTableSlot *spillslot;	/* slot for tuples read from a spill file */
 } SetOpState;
 
 /* ----------------
@@ -2673,6 +2779,13 @@ typedef struct MotionState
 	bool		sentEndOfStream;	/* set when end-of-stream has successfully been sent */
 	List	   *hashExpr;		/* state struct used for evaluating the hash expressions */
 	struct CdbHash *cdbhash;	/* hash api object */
+	int			hashBatchSize;	/* tuples hashed at a time, 1 if not batching */
+	TupleTableSlot **hashBatchSlots;	/* copies of the tuples in a batch */
+	Datum	   *hashBatchValues;	/* one key column of a batch */
+	bool	   *hashBatchIsnull;
+	uint32	   *hashBatchHashes;	/* running hash value of each tuple */
+	unsigned int *hashBatchSegs;	/* target segment of each tuple */
+	int			skewNextRoute;	/* next outputSegIdx entry for spread hot-key rows */
 
 	/* For Motion recv */
 	void	   *tupleheap;		/* data structure for match merge in sorted motion node */
@@ -326,6 +326,8 @@ typedef enum NodeTag
 	 */
 	T_MemoryContext = 600,
 	T_AllocSetContext,
+	T_SlabContext,
+	T_BumpContext,
 	T_MemoryAccount,
 
 	/*
@@ -457,6 +459,7 @@ typedef enum NodeTag
 	T_AlterExtensionStmt,
 	T_AlterExtensionContentsStmt,
 	T_SetDistributionCmd,
+	T_RetrieveStmt,
 
 	/*
 	 * TAGS FOR PARSE TREE NODES (parsenodes.h)
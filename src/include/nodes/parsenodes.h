@@ -2207,6 +2207,13 @@ typedef struct CommentStmt
  */
 #define CURSOR_OPT_UPDATABLE	0x0040	/* updateable with CURRENT OF, if possible */
 
+/*
+ * GPDB: PARALLEL RETRIEVE.  The result is not gathered to the QD; each
+ * segment sends its part of it to a client that connects to the segment
+ * and runs RETRIEVE against the cursor's token.  See cdbendpoint.c.
+ */
+#define CURSOR_OPT_PARALLEL_RETRIEVE	0x0080
+
 typedef struct DeclareCursorStmt
 {
 	NodeTag		type;
@@ -2251,6 +2258,20 @@ typedef struct FetchStmt
 	bool		ismove;			/* TRUE if MOVE */
 } FetchStmt;
 
+/* ----------------------
+ *		Retrieve Statement
+ *
+ * Run in utility mode on a segment, to read the rows of a PARALLEL RETRIEVE
+ * cursor that the segment produces.
+ * ----------------------
+ */
+typedef struct RetrieveStmt
+{
+	NodeTag		type;
+	char	   *endpoint;		/* token of the cursor, from gp_endpoints() */
+	int64		count;			/* number of rows, or FETCH_ALL */
+} RetrieveStmt;
+
 /* ----------------------
  *		Create Index Statement
  * ----------------------
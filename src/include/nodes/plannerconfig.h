@@ -37,6 +37,7 @@ typedef struct PlannerConfig
 	bool 		gp_hashagg_streambottom;
 	bool		gp_enable_agg_distinct;
 	bool		gp_enable_dqa_pruning;
+	bool		gp_enable_dqa_expand;
 	bool		gp_eager_dqa_pruning;
 	bool		gp_eager_one_phase_agg;
 	bool		gp_eager_two_phase_agg;
@@ -28,11 +28,18 @@ typedef struct DirectDispatchInfo
       * if true then this Slice requires an n-gang but the gang can be targeted to
       *   fewer segments than the entire cluster.
       *
-      * When true, directDispatchContentId and directDispathCount will combine to indicate
-      *    the content ids that need segments.
+      * When true, contentIds lists the content ids that need segments.
       */
 	bool isDirectDispatch;
     List *contentIds;
+
+     /**
+      * Set on plan nodes only, when isDirectDispatch is false but the target
+      *   segments follow from the values of extern Params: for each
+      *   distribution key column, the List of Const or Param nodes that it can
+      *   be equal to.  The executor computes contentIds from the bound values.
+      */
+    List *paramKeys;
 } DirectDispatchInfo;
 
 typedef enum PlanGenerator
@@ -148,6 +155,12 @@ typedef struct PlannedStmt
 
 	/* The overall memory consumption account (i.e., outside of an operator) */
 	MemoryAccountIdType memoryAccountId;
+
+	/*
+	 * GPDB: token of a PARALLEL RETRIEVE cursor, whose root slice runs on
+	 * the segments and sends its rows to an endpoint; NULL otherwise.
+	 */
+	char	   *parallelRetrieveToken;
 } PlannedStmt;
 
 /*
@@ -873,6 +886,13 @@ typedef struct Sort
 	AttrNumber *sortColIdx;		/* their indexes in the target list */
 	Oid		   *sortOperators;	/* OIDs of operators to sort them by */
 	bool	   *nullsFirst;		/* NULLS FIRST/LAST directions */
+
+	/*
+	 * Number of leading sort columns the input is already sorted on.  If
+	 * nonzero, the executor may sort the input a run of equal leading keys
+	 * at a time instead of all at once.
+	 */
+	int			numPresortedCols;
     /* CDB */
 	bool		noduplicates;   /* TRUE if sort should discard duplicates */
 
@@ -1049,15 +1069,23 @@ typedef enum SetOpCmd
 	SETOPCMD_EXCEPT_ALL
 } SetOpCmd;
 
+typedef enum SetOpStrategy
+{
+	SETOP_SORTED,				/* input must be sorted */
+	SETOP_HASHED				/* use internal hashtable, spilling to workfiles */
+} SetOpStrategy;
+
 typedef struct SetOp
 {
 	Plan		plan;
 	SetOpCmd	cmd;			/* what to do */
+	SetOpStrategy strategy;		/* how to do it */
 	int			numCols;		/* number of columns to check for
 								 * duplicate-ness */
 	AttrNumber *dupColIdx;		/* their indexes in the target list */
 	Oid		   *dupOperators;	/* equality operators to compare with */
 	AttrNumber	flagColIdx;		/* where is the flag column, if any */
+	long		numGroups;		/* estimated number of groups in input */
 } SetOp;
 
 /* ----------------
@@ -1085,6 +1113,18 @@ typedef enum MotionType
 	MOTIONTYPE_EXPLICIT		/* Send tuples to the segment explicitly specified in their segid column */
 } MotionType;
 
+/*
+ * For a Redistribute Motion feeding one side of a join, how rows whose
+ * join key is one of the hot (very frequent) keys are routed.  The hot keys
+ * are identified by their cdbhash() value, before reduction to a segment.
+ */
+typedef enum MotionSkewMode
+{
+	MOTIONSKEW_NONE = 0,		/* hash all rows */
+	MOTIONSKEW_SPREAD,			/* send hot-key rows round-robin */
+	MOTIONSKEW_BROADCAST		/* send hot-key rows to every segment */
+} MotionSkewMode;
+
 /*
  * Motion Node
  *
@@ -1100,6 +1140,9 @@ typedef struct Motion
 	/* For Hash */
 	List		*hashExpr;			/* list of hash expressions */
 	List		*hashDataTypes;	    /* list of hash expr data type oids */
+	MotionSkewMode skewMode;		/* routing of hot-key rows */
+	int			numSkewHashes;		/* number of hot key hash values */
+	uint32	   *skewHashes;			/* sorted hash values of the hot keys */
 
 	/* Output segments */
 	int 	  	numOutputSegs;		/* number of seg indexes in outputSegIdx array, 0 for broadcast */
@@ -1032,6 +1032,11 @@ typedef struct CdbMotionPath
 {
 	Path		path;
     Path	   *subpath;
+
+	/* Hot join keys of a Redistribute Motion; see cdbpath_motion_for_join */
+	MotionSkewMode skewMode;
+	int			numSkewHashes;
+	uint32	   *skewHashes;
 } CdbMotionPath;
 
 /*
@@ -172,6 +172,7 @@ extern bool tbm_is_empty(const HashBitmap *tbm);
 
 extern void tbm_begin_iterate(HashBitmap *tbm);
 extern bool tbm_iterate(Node *tbm, TBMIterateResult *output);
+extern bool tbm_prefetch_next(Node *tbm, BlockNumber *blockno);
 
 extern void stream_move_node(StreamBitmap *strm, StreamBitmap *other, StreamType kind);
 extern void stream_add_node(StreamBitmap *strm, StreamNode *node, StreamType kind);
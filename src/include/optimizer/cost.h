@@ -78,6 +78,7 @@ extern Cost disable_cost;
 extern bool gp_enable_hashjoin_size_heuristic;          /*CDB*/
 extern bool gp_enable_fallback_plan;
 extern bool gp_enable_predicate_propagation;
+extern bool gp_enable_partitionwise_join;
 
 extern double index_pages_fetched(double tuples_fetched, BlockNumber pages,
 					double index_pages, PlannerInfo *root);
@@ -21,6 +21,10 @@
 
 extern bool inject_partition_selectors_for_join(PlannerInfo *root, JoinPath *join_path, Plan **inner_plan_p);
 
+extern void add_param_partition_gate(PlannerInfo *root, RelOptInfo *childrel, RangeTblEntry *childRTE);
+
+extern Plan *partitionwise_hashjoin_plan(PlannerInfo *root, HashJoin *join);
+
 extern RestrictInfo *make_mergeclause(Node *outer, Node *inner);
 
 #endif /* PLANPARTITION_H */
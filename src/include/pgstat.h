@@ -448,7 +448,7 @@ typedef union PgStat_Msg
  * ------------------------------------------------------------
  */
 
-#define PGSTAT_FILE_FORMAT_ID	0x01A5BC98
+#define PGSTAT_FILE_FORMAT_ID	0x01A5BC99
 
 /* ----------
  * PgStat_StatDBEntry			The collector's data per database
@@ -498,6 +498,8 @@ typedef struct PgStat_StatTabEntry
 	PgStat_Counter n_live_tuples;
 	PgStat_Counter n_dead_tuples;
 	PgStat_Counter last_anl_tuples;
+	PgStat_Counter changes_since_analyze;	/* tuples inserted, updated or
+											 * deleted since the last analyze */
 
 	PgStat_Counter blocks_fetched;
 	PgStat_Counter blocks_hit;
@@ -593,6 +595,28 @@ typedef struct PgStat_GlobalStats
 #define PGBE_WAITING_RESGROUP		'g'
 #define PGBE_WAITING_NONE			'\0'
 
+/*
+ * Wait events, published in PGPROC->waitEvent.  Unlike st_waiting, they
+ * tell apart the Greenplum-specific waits, and they are cheap enough to be
+ * reported around every wait: gp_wait_event_samples() samples them to
+ * show where queries spend their time.
+ */
+typedef enum WaitEvent
+{
+	WAIT_EVENT_NONE = 0,
+	WAIT_EVENT_LOCK,			/* heavyweight lock */
+	WAIT_EVENT_RESQUEUE,		/* resource queue slot */
+	WAIT_EVENT_RESGROUP,		/* resource group slot */
+	WAIT_EVENT_INTERCONNECT_RECV,	/* Motion waiting for tuples */
+	WAIT_EVENT_INTERCONNECT_SEND,	/* Motion waiting for acks */
+	WAIT_EVENT_SHAREINPUT,		/* ShareInputScan waiting for its peer */
+	WAIT_EVENT_WORKFILE_READ,
+	WAIT_EVENT_WORKFILE_WRITE,
+	WAIT_EVENT_DISTRIBUTEDLOG_IO	/* distributed log SLRU page I/O */
+} WaitEvent;
+
+#define NUM_WAIT_EVENTS (WAIT_EVENT_DISTRIBUTEDLOG_IO + 1)
+
 /* ----------
  * PgBackendStatus
  *
@@ -724,6 +748,25 @@ extern void pgstat_report_activity(const char *what);
 extern void pgstat_report_txn_timestamp(TimestampTz tstamp);
 extern void pgstat_report_waiting(char reason);
 
+/* points to MyProc->waitEvent, or to a dummy before there is a MyProc */
+extern volatile uint32 *my_wait_event;
+
+static inline void
+pgstat_report_wait_start(WaitEvent wait_event)
+{
+	*my_wait_event = (uint32) wait_event;
+}
+
+static inline void
+pgstat_report_wait_end(void)
+{
+	*my_wait_event = (uint32) WAIT_EVENT_NONE;
+}
+
+extern void pgstat_set_wait_event_storage(uint32 *wait_event);
+extern void pgstat_reset_wait_event_storage(void);
+extern const char *pgstat_get_wait_event(uint32 wait_event);
+
 extern void pgstat_report_appname(const char *appname);
 extern void pgstat_report_xact_timestamp(TimestampTz tstamp);
 extern const char *pgstat_get_backend_current_activity(int pid, bool checkUser);
@@ -863,6 +906,10 @@ extern void pgstat_count_heap_insert(Relation rel);
 extern void pgstat_count_heap_update(Relation rel, bool hot);
 extern void pgstat_count_heap_delete(Relation rel);
 extern void pgstat_update_heap_dead_tuples(Relation rel, int delta);
+extern void pgstat_count_dispatched_changes(Relation rel,
+								PgStat_Counter inserted,
+								PgStat_Counter updated,
+								PgStat_Counter deleted);
 
 extern void pgstat_init_function_usage(FunctionCallInfoData *fcinfo,
 						   PgStat_FunctionCallUsage *fcu);
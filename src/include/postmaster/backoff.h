@@ -11,6 +11,13 @@
 #include "postgres.h"
 #include "storage/proc.h"
 
+/* Ways to enforce the priorities, see gp_resqueue_priority_mode */
+typedef enum ResQueuePriorityMode
+{
+	RESQUEUE_PRIORITY_MODE_BACKOFF,		/* backends sleep */
+	RESQUEUE_PRIORITY_MODE_NICE			/* kernel scheduler, by nice value */
+} ResQueuePriorityMode;
+
 /* GUCs */
 extern bool gp_enable_resqueue_priority;
 extern int gp_resqueue_priority_local_interval;
@@ -19,6 +26,7 @@ extern int gp_resqueue_priority_inactivity_timeout;
 extern int gp_resqueue_priority_grouping_timeout;
 extern double gp_resqueue_priority_cpucores_per_segment;
 extern char* gp_resqueue_priority_default_value;
+extern int gp_resqueue_priority_mode;
 
 extern void BackoffBackendEntryInit(int sessionid, int commandcount, int weight);
 extern void BackoffBackendEntryExit(void);
@@ -16,11 +16,21 @@
 
 #include "cdb/ml_ipc.h" /* gettime_elapsed_ms */
 
-#define PROBE_ERR_MSG_LEN   (256)        /* length of error message for errno */
-
 struct pg_conn; /* PGconn ... #include "gp-libpq-fe.h" */
+
+/* progress of a single segment probe through the prober's event loop */
+typedef enum ProbeConnState
+{
+	PROBE_CONN_PENDING,                  /* not started yet, or scheduled for re-probe */
+	PROBE_CONN_CONNECTING,               /* waiting for the connection to become writable */
+	PROBE_CONN_AWAITING_RESPONSE,        /* probe sent, waiting for the response */
+	PROBE_CONN_SUCCEEDED,                /* response received and processed */
+	PROBE_CONN_FAILED                    /* error or timeout, segment is suspected */
+} ProbeConnState;
+
 typedef struct ProbeConnectionInfo
 {
+	CdbComponentDatabaseInfo *dbInfo;    /* the segment to probe */
 	int16 dbId;                          /* the dbid of the segment */
 	int16 segmentId;                     /* content indicator: -1 for master, 0, ..., n-1 for segments */
 	char role;                           /* primary ('p'), mirror ('m') */
@@ -30,17 +40,10 @@ typedef struct ProbeConnectionInfo
 	probe_result *result;
 #endif
 	char segmentStatus;                  /* probed segment status */
-	int16 probe_errno;                   /* saved errno from the latest system call */
-	char errmsg[PROBE_ERR_MSG_LEN];      /* message returned by strerror() */
+	ProbeConnState state;                /* where the probe is in the event loop */
 	struct pg_conn *conn;                        /* libpq connection object */
 } ProbeConnectionInfo;
 
-extern
-#ifdef USE_SEGWALREP
-void
-#else
-char
-#endif
-probeSegmentHelper(CdbComponentDatabaseInfo *dbInfo, ProbeConnectionInfo probeInfo);
+extern void probeSegments(ProbeConnectionInfo *probes, int nprobes);
 
 #endif
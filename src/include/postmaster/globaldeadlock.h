@@ -0,0 +1,20 @@
+/*-------------------------------------------------------------------------
+ *
+ * globaldeadlock.h
+ *	  Interface for the global deadlock detector process.
+ *
+ *
+ * Portions Copyright (c) 2012-Present Pivotal Software, Inc.
+ *
+ *
+ * IDENTIFICATION
+ *	    src/include/postmaster/globaldeadlock.h
+ *
+ *-------------------------------------------------------------------------
+ */
+#ifndef GLOBALDEADLOCK_H
+#define GLOBALDEADLOCK_H
+
+extern int globaldeadlock_start(void);
+
+#endif   /* GLOBALDEADLOCK_H */
@@ -39,6 +39,7 @@ typedef struct NextValRequest
 	uint32_t    seq_oid;
 	uint32_t    isTemp;
 	uint32_t    session_id;
+	uint32_t    nvalues;		/* how many values the QE wants leased */
 	uint32_t	endCookie;
 }	NextValRequest;
 
@@ -60,6 +61,7 @@ extern void
 sendSequenceRequest(int     sockfd, 
 					Relation seqrel,
                     int     session_id,
+					int64   nvalues,
 					int64  *plast, 
                     int64  *pcached,
 			 		int64  *pincrement,
@@ -64,9 +64,14 @@ typedef struct bfz
 /* These functions are internal to bfz. */
 extern void bfz_nothing_init(bfz_t * thiz);
 extern void bfz_zlib_init(bfz_t * thiz);
+#ifdef HAVE_LIBLZ4
+extern void bfz_lz4_init(bfz_t * thiz);
+#endif
 extern void bfz_lzop_init(bfz_t * thiz);
 extern void bfz_write_ex(bfz_t * thiz, const char *buffer, int size);
 extern int	bfz_read_ex(bfz_t * thiz, char *buffer, int size);
+extern int	bfz_io_size(void);
+extern void bfz_write_io_unit(bfz_t * thiz, const char *buffer, int size);
 
 /* These functions are interface to bfz. */
 extern int	bfz_string_to_compression(const char *string);
@@ -56,6 +56,10 @@ typedef int File;
 /* GUC parameter */
 extern int	max_files_per_process;
 
+/* I/O done by this process through FileRead() and FileWrite() */
+extern uint64 FileReadBytes;
+extern uint64 FileWriteBytes;
+
 
 /*
  * prototypes for functions in fd.c
@@ -78,6 +82,10 @@ OpenNamedFile(const char   *fileName,
                   bool          closeAtEOXact);
 
 extern void FileClose(File file);
+extern int	FilePrefetch(File file, int64 offset, int amount);
+extern int	FileWriteback(File file, int64 offset, int64 amount, bool wait);
+extern int	FileDropCache(File file, int64 offset, int64 amount);
+extern int	FileAllocate(File file, int64 offset, int64 amount);
 extern int	FileRead(File file, char *buffer, int amount);
 extern int	FileWrite(File file, char *buffer, int amount);
 extern int	FileSync(File file);
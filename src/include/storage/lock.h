@@ -455,6 +455,7 @@ typedef struct LOCALLOCK
 	PROCLOCK   *proclock;		/* associated PROCLOCK object in shmem */
 	uint32		hashcode;		/* copy of LOCKTAG's hash value */
 	bool		preparable;		/* MPP: During prepare we populate this to avoid MPP-1094 */
+	bool		holdsStrongLockCount;	/* bumped FastPathStrongRelationLocks? */
 	int64		nLocks;			/* total number of times lock is held */
 	int			numLockOwners;	/* # of relevant ResourceOwners */
 	int			maxLockOwners;	/* allocated size of array */
@@ -549,6 +550,7 @@ extern LockAcquireResult LockAcquire(const LOCKTAG *locktag,
 extern bool LockRelease(const LOCKTAG *locktag,
 			LOCKMODE lockmode, bool sessionLock);
 extern void LockReleaseAll(LOCKMETHODID lockmethodid, bool allLocks);
+extern void AbortStrongLockAcquire(void);
 // TODO why are we missing extern void LockReleaseSession(LOCKMETHODID lockmethodid); ?
 extern void LockReleaseCurrentOwner(LOCALLOCK **locallocks, int nlocks);
 extern void LockReassignCurrentOwner(LOCALLOCK **locallocks, int nlocks);
@@ -566,6 +568,8 @@ extern void RemoveLocalLock(LOCALLOCK *locallock);
 extern Size LockShmemSize(void);
 extern LockData *GetLockStatusData(void);
 extern const char *GetLockmodeName(LOCKMETHODID lockmethodid, LOCKMODE mode);
+extern LOCKMODE GetLockmodeByName(const char *name);
+extern bool LockModesConflict(LOCKMODE mode1, LOCKMODE mode2);
 
 extern void lock_twophase_recover(TransactionId xid, uint16 info,
 					  void *recdata, uint32 len);
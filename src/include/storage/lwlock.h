@@ -28,12 +28,21 @@
 #define LOG2_NUM_LOCK_PARTITIONS  4
 #define NUM_LOCK_PARTITIONS  (1 << LOG2_NUM_LOCK_PARTITIONS)
 
+/* Number of locks under which WAL records are copied into the WAL buffers */
+#define NUM_XLOG_INSERT_SLOTS  8
+
 /* Number of partitions of the workfile manager hashtable */
 #define NUM_WORKFILEMGR_PARTITIONS 32
 
 /* Number of partitions of the workfile query diskspace hashtable */
 #define NUM_WORKFILE_QUERYSPACE_PARTITIONS 128
 
+/* Number of partitions of the shared catalog cache hashtable */
+#define NUM_SHARED_CATCACHE_PARTITIONS 16
+
+/* Number of partitions of the persistent relation index hashtable */
+#define NUM_PERSISTENT_RELATION_INDEX_PARTITIONS 16
+
 /*
  * We have a number of predefined LWLocks, plus a bunch of LWLocks that are
  * dynamically assigned (e.g., for shared buffers).  The LWLock structures
@@ -93,9 +102,12 @@ typedef enum LWLockId
 	FileRepAppendOnlyCommitCountLock,
 	SyncRepLock,
 	ErrorLogLock,
-	FirstWorkfileMgrLock,
+	FirstXLogInsertSlotLock,
+	FirstWorkfileMgrLock = FirstXLogInsertSlotLock + NUM_XLOG_INSERT_SLOTS,
 	FirstWorkfileQuerySpaceLock = FirstWorkfileMgrLock + NUM_WORKFILEMGR_PARTITIONS,
-	FirstBufMappingLock = FirstWorkfileQuerySpaceLock + NUM_WORKFILE_QUERYSPACE_PARTITIONS,
+	FirstSharedCatCacheLock = FirstWorkfileQuerySpaceLock + NUM_WORKFILE_QUERYSPACE_PARTITIONS,
+	FirstPersistentRelationIndexLock = FirstSharedCatCacheLock + NUM_SHARED_CATCACHE_PARTITIONS,
+	FirstBufMappingLock = FirstPersistentRelationIndexLock + NUM_PERSISTENT_RELATION_INDEX_PARTITIONS,
 	FirstLockMgrLock = FirstBufMappingLock + NUM_BUFFER_PARTITIONS,
 	SessionStateLock = FirstLockMgrLock + NUM_LOCK_PARTITIONS,
 	RelfilenodeGenLock,
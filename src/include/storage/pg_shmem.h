@@ -39,6 +39,26 @@ typedef struct PGShmemHeader	/* standard header for all Postgres shmem */
 } PGShmemHeader;
 
 
+/* Possible values for huge_pages */
+typedef enum
+{
+	HUGE_PAGES_OFF,
+	HUGE_PAGES_ON,
+	HUGE_PAGES_TRY
+} HugePagesType;
+
+/* Possible values for gp_numa_policy */
+typedef enum
+{
+	NUMA_POLICY_OFF,
+	NUMA_POLICY_INTERLEAVE,
+	NUMA_POLICY_LOCAL
+} NumaPolicyType;
+
+/* GUC variables */
+extern int	huge_pages;
+extern int	gp_numa_policy;
+
 #ifdef EXEC_BACKEND
 extern unsigned long UsedShmemSegID;
 extern void *UsedShmemSegAddr;
@@ -56,6 +56,14 @@ struct XidCache
 /* flags reset at EOXact */
 #define		PROC_VACUUM_STATE_MASK (0x0E)
 
+/*
+ * We allow a small number of "weak" relation locks (AccessShareLock,
+ * RowShareLock, RowExclusiveLock) to be recorded in the PGPROC structure
+ * rather than the main lock table.  This eases contention on the lock
+ * manager LWLocks.  See storage/lmgr/README for additional details.
+ */
+#define		FP_LOCK_SLOTS_PER_BACKEND 16
+
 /*
  * Each backend has a PGPROC struct in shared memory.  There is also a list of
  * currently-unused PGPROC structs that will be reallocated to new backends.
@@ -147,6 +155,13 @@ struct PGPROC
 	 */
 	SHM_QUEUE	myProcLocks[NUM_LOCK_PARTITIONS];
 
+	/* Per-backend LWLock.  Protects fields below. */
+	LWLockId	backendLock;
+
+	/* Lock manager data, recording fast-path locks taken by this backend. */
+	uint64		fpLockBits;		/* lock modes held for each fast-path slot */
+	Oid			fpRelId[FP_LOCK_SLOTS_PER_BACKEND];		/* slots for rel oids */
+
 	struct XidCache subxids;	/* cache for subtransaction XIDs */
 
 	/*
@@ -162,6 +177,8 @@ struct PGPROC
 
 	int queryCommandId; /* command_id for the running query */
 
+	uint32		waitEvent;		/* WaitEvent being waited on, see pgstat.h */
+
 	bool serializableIsoLevel; /* true if proc has serializable isolation level set */
 
 	bool inDropTransaction; /* true if proc is in vacuum drop transaction */
@@ -188,8 +205,10 @@ extern PGDLLIMPORT PGPROC *lockHolderProcPtr;
  */
 typedef struct PROC_HDR
 {
-	/* The PGPROC structures */
+	/* The PGPROC structures of regular backends, autovacuum workers last */
 	PGPROC *procs;
+	/* Length of the procs array, i.e. MaxBackends */
+	int			numProcs;
 	/* Head of list of free PGPROC structures */
 	SHMEM_OFFSET freeProcs;
 	/* Head of list of autovacuum's free PGPROC structures */
@@ -205,6 +224,8 @@ typedef struct PROC_HDR
 
 } PROC_HDR;
 
+extern PROC_HDR *ProcGlobal;
+
 /*
  * We set aside some extra PGPROC structures for auxiliary processes,
  * ie things that aren't full-fledged backends but need shmem access.
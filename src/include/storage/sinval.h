@@ -89,6 +89,8 @@ extern uint64 SharedInvalidMessageCounter;
 
 extern void SendSharedInvalidMessages(const SharedInvalidationMessage *msgs,
 						  int n);
+extern void SendSharedInvalidReset(void);
+extern int	SharedInvalQueueSize(void);
 extern void ReceiveSharedInvalidMessages(
 					  void (*invalFunction) (SharedInvalidationMessage *msg),
 							 void (*resetFunction) (void));
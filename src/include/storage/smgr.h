@@ -327,6 +327,7 @@ extern void smgrdormdbdir(
 	bool						*mirrorDataLossOccurred);
 extern void smgrextend(SMgrRelation reln, BlockNumber blocknum, char *buffer,
 		   bool isTemp);
+extern void smgrprefetch(SMgrRelation reln, BlockNumber blocknum);
 extern void smgrread(SMgrRelation reln, BlockNumber blocknum, char *buffer);
 extern void smgrwrite(SMgrRelation reln, BlockNumber blocknum, char *buffer,
 		  bool isTemp);
@@ -507,6 +508,7 @@ extern bool mdrmdbdir(
 	bool						*mirrorDataLossOccurred);
 extern void mdextend(SMgrRelation reln, BlockNumber blocknum, char *buffer,
 		 bool isTemp);
+extern void mdprefetch(SMgrRelation reln, BlockNumber blocknum);
 extern void mdread(SMgrRelation reln, BlockNumber blocknum, char *buffer);
 extern void mdwrite(SMgrRelation reln, BlockNumber blocknum, char *buffer,
 		bool isTemp);
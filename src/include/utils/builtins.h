@@ -435,6 +435,27 @@ extern Datum pg_total_relation_size_oid(PG_FUNCTION_ARGS);
 extern Datum pg_total_relation_size_name(PG_FUNCTION_ARGS);
 extern Datum pg_size_pretty(PG_FUNCTION_ARGS);
 extern Datum gp_statistics_estimate_reltuples_relpages_oid(PG_FUNCTION_ARGS);
+extern Datum gp_hll_accum(PG_FUNCTION_ARGS);
+extern Datum gp_hll_merge(PG_FUNCTION_ARGS);
+extern Datum gp_hll_ndistinct_final(PG_FUNCTION_ARGS);
+extern Datum approx_count_distinct_final(PG_FUNCTION_ARGS);
+
+/* cdb/cdbexpand.c */
+extern Datum gp_hash_target_segment(PG_FUNCTION_ARGS);
+extern Datum gp_expand_redistribute(PG_FUNCTION_ARGS);
+extern Datum gp_expand_redistribute_finish(PG_FUNCTION_ARGS);
+
+/* cdb/cdbbench.c */
+extern Datum gp_bench_compress(PG_FUNCTION_ARGS);
+extern Datum gp_bench_workfile(PG_FUNCTION_ARGS);
+extern Datum gp_bench_hash(PG_FUNCTION_ARGS);
+extern Datum gp_bench_sort(PG_FUNCTION_ARGS);
+extern Datum gp_bench_interconnect(PG_FUNCTION_ARGS);
+extern Datum gp_bench_operators(PG_FUNCTION_ARGS);
+
+/* access/external/fmt_tuple.c */
+extern Datum gp_tuple_export(PG_FUNCTION_ARGS);
+extern Datum gp_tuple_import(PG_FUNCTION_ARGS);
 
 /* genfile.c */
 extern bytea *read_binary_file(const char *filename,
@@ -754,6 +775,9 @@ extern Datum to_hex32(PG_FUNCTION_ARGS);
 extern Datum to_hex64(PG_FUNCTION_ARGS);
 extern Datum md5_text(PG_FUNCTION_ARGS);
 extern Datum md5_bytea(PG_FUNCTION_ARGS);
+extern Datum gp_unordered_md5_accum(PG_FUNCTION_ARGS);
+extern Datum gp_unordered_md5_merge(PG_FUNCTION_ARGS);
+extern Datum gp_unordered_md5_final(PG_FUNCTION_ARGS);
 
 extern Datum unknownin(PG_FUNCTION_ARGS);
 extern Datum unknownout(PG_FUNCTION_ARGS);
@@ -954,6 +978,7 @@ extern Datum int2_decum(PG_FUNCTION_ARGS);
 extern Datum int4_decum(PG_FUNCTION_ARGS);
 extern Datum int8_decum(PG_FUNCTION_ARGS);
 extern Datum numeric_avg(PG_FUNCTION_ARGS);
+extern Datum numeric_sum(PG_FUNCTION_ARGS);
 extern Datum numeric_var_pop(PG_FUNCTION_ARGS);
 extern Datum numeric_var_samp(PG_FUNCTION_ARGS);
 extern Datum numeric_stddev_pop(PG_FUNCTION_ARGS);
@@ -1185,6 +1210,18 @@ extern Datum zlib_compress(PG_FUNCTION_ARGS);
 extern Datum zlib_decompress(PG_FUNCTION_ARGS);
 extern Datum zlib_validator(PG_FUNCTION_ARGS);
 
+extern Datum zstd_constructor(PG_FUNCTION_ARGS);
+extern Datum zstd_destructor(PG_FUNCTION_ARGS);
+extern Datum zstd_compress(PG_FUNCTION_ARGS);
+extern Datum zstd_decompress(PG_FUNCTION_ARGS);
+extern Datum zstd_validator(PG_FUNCTION_ARGS);
+
+extern Datum lz4_constructor(PG_FUNCTION_ARGS);
+extern Datum lz4_destructor(PG_FUNCTION_ARGS);
+extern Datum lz4_compress(PG_FUNCTION_ARGS);
+extern Datum lz4_decompress(PG_FUNCTION_ARGS);
+extern Datum lz4_validator(PG_FUNCTION_ARGS);
+
 extern Datum rle_type_constructor(PG_FUNCTION_ARGS);
 extern Datum rle_type_destructor(PG_FUNCTION_ARGS);
 extern Datum rle_type_compress(PG_FUNCTION_ARGS);
@@ -1210,6 +1247,9 @@ extern Datum test_quicklz_compression(PG_FUNCTION_ARGS);
 /* percentile.c */
 extern Datum percentile_cont_trans(PG_FUNCTION_ARGS);
 extern Datum percentile_disc_trans(PG_FUNCTION_ARGS);
+extern Datum approx_percentile_accum(PG_FUNCTION_ARGS);
+extern Datum approx_percentile_merge(PG_FUNCTION_ARGS);
+extern Datum approx_percentile_final(PG_FUNCTION_ARGS);
 
 /* gp_partition_functions.c */
 extern void dumpDynamicTableScanPidIndex(EState *estate, int index);
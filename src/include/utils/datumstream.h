@@ -228,6 +228,44 @@ datumstreamread_nth(DatumStreamRead * acc)
 	}
 }
 
+/*
+ * Number of rows of the current block after the current one, i.e. how often
+ * datumstreamread_advance() will succeed before a new block must be read.
+ */
+inline static int
+datumstreamread_rows_left(DatumStreamRead * acc)
+{
+	return acc->blockRowCount - datumstreamread_nth(acc) - 1;
+}
+
+/*
+ * Number of distinct values in the dictionary of the current block, or 0 if
+ * the block is not dictionary encoded.
+ */
+inline static int32
+datumstreamread_dictionary_count(DatumStreamRead * acc)
+{
+	if (acc->largeObjectState != DatumStreamLargeObjectState_None ||
+		!acc->blockRead.dict_block_was_compressed)
+		return 0;
+
+	return acc->blockRead.dict_count;
+}
+
+/*
+ * Dictionary code of the current datum, or -1 if it is NULL or the block is
+ * not dictionary encoded.  Rows with the same code in a block have equal
+ * values.
+ */
+inline static int32
+datumstreamread_dictionary_code(DatumStreamRead * acc)
+{
+	if (acc->largeObjectState != DatumStreamLargeObjectState_None)
+		return -1;
+
+	return DatumStreamBlockRead_DictionaryCode(&acc->blockRead);
+}
+
 /* ------------------------------------------------------------------------------ */
 
 extern int datumstreamwrite_put(
@@ -294,6 +332,8 @@ extern int64 datumstreamwrite_lob(DatumStreamWrite *ds,
 extern int	datumstreamread_block(DatumStreamRead * ds,
 								  AppendOnlyBlockDirectory *blockDirectory,
 								  int colGroupNo);
+extern int	datumstreamread_skip_to_row(DatumStreamRead * ds,
+								  int64 targetRowNum);
 extern void datumstreamread_find(DatumStreamRead * datumStream,
 					 int32 rowNumInBlock);
 extern void datumstreamread_rewind_block(DatumStreamRead * datumStream);
@@ -196,6 +196,31 @@ typedef struct DatumStreamBlock_Delta_Extension
 	 */
 }	DatumStreamBlock_Delta_Extension;
 
+/*
+ * Datum Stream Block dictionary, used for variable-length types with
+ * RLE_TYPE compression when a block has few distinct values.  When
+ * DSB_HAS_DICTIONARY is set, the datum area (whose size is still given
+ * by physical_data_size) starts with this header, followed by one 1 or 2
+ * byte code per physical datum, padding to MAXALIGN, and then the
+ * dictionary_count distinct datums laid out like an ordinary datum area.
+ * 16 bytes.
+ */
+typedef struct DatumStreamBlock_Dictionary
+{
+	int32		dictionary_count;
+	/* Number of distinct datums in the dictionary. */
+
+	int32		dictionary_size;
+	/* Size of the dictionary datums, including alignment padding. */
+
+	int32		code_size;
+	/* Size of each code: 1 or 2 bytes. */
+
+	int32		unused;
+}	DatumStreamBlock_Dictionary;
+
+#define DATUMSTREAM_MAX_DICTIONARY_COUNT 65536
+
 
 /* Flags */
 enum
@@ -203,6 +228,7 @@ enum
 	DSB_HAS_NULLBITMAP = 0x1,
 	DSB_HAS_RLE_COMPRESSION = 0x2,
 	DSB_HAS_DELTA_COMPRESSION = 0x4,
+	DSB_HAS_DICTIONARY = 0x8,
 };
 
 typedef struct DatumStreamBitMapWrite
@@ -1008,6 +1034,7 @@ typedef struct DatumStreamBlockWrite
 
 	bool		rle_want_compression;
 	bool		delta_want_compression;
+	bool		dict_want_compression;
 
 	int32		initialMaxDatumPerBlock;
 	int32		maxDatumPerBlock;
@@ -1082,6 +1109,9 @@ typedef struct DatumStreamBlockWrite
 	bool	   *delta_sign;
 	int32		deltas_maxcount;
 
+	/* Dictionary buffer, allocated on first use */
+	uint8	   *dict_buffer;
+
 	/* EOF of current file */
 	int64		savings;
 	int64		remember_savings;
@@ -1164,6 +1194,14 @@ typedef struct DatumStreamBlockRead
 	bool		delta_block_was_compressed;
 	DatumStreamBitMapRead delta_bitmap;
 
+	/* Dictionary variables */
+	bool		dict_block_was_compressed;
+	int32		dict_count;
+	int32		dict_code_size;
+	uint8	   *dict_codesp;
+	uint8	  **dict_entries;
+	int32		dict_entries_maxcount;
+
 	/*
 	 * Keep less frequently accessed fields down here for possible better CPU data cache
 	 * performance.
@@ -1718,6 +1756,17 @@ DatumStreamBlockRead_AdvanceDenseDelta(DatumStreamBlockRead * dsr)
 	return DELTA_COMPRESSION_OK;
 }
 
+inline static int32
+DatumStreamBlockRead_DictionaryCodeAt(DatumStreamBlockRead * dsr, int32 index)
+{
+	Assert(index >= 0 && index < dsr->physical_datum_count);
+
+	if (dsr->dict_code_size == 1)
+		return dsr->dict_codesp[index];
+	else
+		return ((uint16 *) dsr->dict_codesp)[index];
+}
+
 inline static int
 DatumStreamBlockRead_AdvanceDense(DatumStreamBlockRead * dsr)
 {
@@ -1924,6 +1973,15 @@ DatumStreamBlockRead_AdvanceDense(DatumStreamBlockRead * dsr)
 	++dsr->physical_datum_index;
 	//Initially, -1.
 
+	if (dsr->dict_block_was_compressed)
+	{
+		/*
+		 * Each physical datum is a code into the dictionary.
+		 */
+		dsr->datump = dsr->dict_entries[DatumStreamBlockRead_DictionaryCodeAt(dsr, dsr->physical_datum_index)];
+		return 1;
+	}
+
 		if (dsr->physical_datum_index == 0)
 	{
 		/* Pre-positioned by block read to first item. */
@@ -2062,6 +2120,23 @@ DatumStreamBlockRead_Nth(DatumStreamBlockRead * dsr)
 	return dsr->nth;
 }
 
+/*
+ * Dictionary code of the current datum, or -1 if the block has no
+ * dictionary or the datum is NULL.  Equal codes within a block mean equal
+ * datums.
+ */
+inline static int32
+DatumStreamBlockRead_DictionaryCode(DatumStreamBlockRead * dsr)
+{
+	if (!dsr->dict_block_was_compressed)
+		return -1;
+
+	if (dsr->has_null && DatumStreamBitMapRead_CurrentIsOn(&dsr->null_bitmap))
+		return -1;
+
+	return DatumStreamBlockRead_DictionaryCodeAt(dsr, dsr->physical_datum_index);
+}
+
 extern void DatumStreamBlockRead_GetReadyOrig(
 								  DatumStreamBlockRead * dsr,
 								  uint8 * buffer,
@@ -2145,6 +2220,11 @@ extern void DatumStreamBlockRead_Init(
 						  void *errcontextArg);
 extern void DatumStreamBlockRead_Finish(
 							DatumStreamBlockRead * dsr);
+extern void DatumStreamBlockRead_GetBatch(
+							  DatumStreamBlockRead * dsr,
+							  int nrows,
+							  Datum *values,
+							  bool *nulls);
 
 extern void DatumStreamBlockWrite_Init(
 						   DatumStreamBlockWrite * dsw,
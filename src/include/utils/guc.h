@@ -196,6 +196,13 @@ extern bool gp_appendonly_verify_block_checksums;
 extern bool gp_appendonly_verify_write_block;
 extern bool gp_appendonly_verify_eof;
 extern bool gp_appendonly_compaction;
+extern bool gp_appendonly_compaction_copy_blocks;
+extern bool gp_appendonly_zone_maps;
+extern bool gp_appendonly_dictionary_encoding;
+extern bool gp_appendonly_late_materialization;
+extern bool gp_appendonly_vectorized_quals;
+extern bool gp_appendonly_write_nocache;
+extern bool gp_appendonly_scan_nocache;
 
 /*
  * Threshold of the ratio of dirty data in a segment file
@@ -206,6 +213,13 @@ extern bool gp_appendonly_compaction;
  * 10% of the tuples are hidden.
  */ 
 extern int  gp_appendonly_compaction_threshold;
+
+/*
+ * Size in kB over which the values of a column-oriented table are moved to
+ * its TOAST relation. 0, the default, keeps all values in the column files,
+ * which is the only layout older releases can read.
+ */
+extern int  gp_appendonly_toast_threshold;
 extern bool gp_heap_verify_checksums_on_mirror;
 extern bool gp_heap_require_relhasoids_match;
 extern bool	Debug_appendonly_rezero_quicklz_compress_scratch;
@@ -482,6 +496,7 @@ extern double optimizer_sort_factor;
 extern int optimizer_array_expansion_threshold;
 extern int optimizer_join_order_threshold;
 extern int optimizer_join_arity_for_associativity_commutativity;
+extern int optimizer_search_time_limit;
 extern int optimizer_cte_inlining_bound;
 extern bool optimizer_force_multistage_agg;
 extern bool optimizer_force_three_stage_scalar_dqa;
@@ -516,8 +531,12 @@ extern bool optimizer_use_gpdb_allocators;
 extern bool init_codegen;
 extern bool codegen;
 extern bool codegen_validate_functions;
+extern bool codegen_background_compile;
 extern int codegen_varlen_tolerance;
 extern int codegen_optimization_level;
+extern int codegen_cache_size;
+extern double codegen_above_cost;
+extern double codegen_optimize_above_cost;
 
 /**
  * Enable logging of DPE match in optimizer.
@@ -553,6 +572,7 @@ extern char  *gp_default_storage_options;
 
 /* copy GUC */
 extern bool gp_enable_segment_copy_checking;
+extern int	gp_copy_dispatch_block_size;
 
 /*
  * This is the batch size used when we want to display the number of files that
@@ -583,6 +603,7 @@ extern IndexCheckType gp_indexcheck_vacuum;
 #define SOPT_COMPLEVEL     "compresslevel"
 #define SOPT_CHECKSUM      "checksum"
 #define SOPT_ORIENTATION   "orientation"
+#define SOPT_KEEPCACHED    "keep_cached"
 /* Max number of chars needed to hold value of a storage option. */
 #define MAX_SOPT_VALUE_LEN 15
 
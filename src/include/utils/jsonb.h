@@ -0,0 +1,104 @@
+/*-------------------------------------------------------------------------
+ *
+ * jsonb.h
+ *	  Declarations for the jsonb data type, JSON kept in a binary format
+ *
+ * Portions Copyright (c) 2012-Present Pivotal Software, Inc.
+ *
+ *
+ * IDENTIFICATION
+ *	    src/include/utils/jsonb.h
+ *
+ *-------------------------------------------------------------------------
+ */
+#ifndef JSONB_H
+#define JSONB_H
+
+#include "fmgr.h"
+
+/*
+ * A jsonb value is a varlena holding one container, the root. A scalar at
+ * the top level is stored as a one-element array flagged JB_FSCALAR.
+ *
+ * A container is a uint32 header, holding the number of elements of an
+ * array or of key/value pairs of an object, followed by one JEntry per
+ * child. The keys of an object come first, sorted, and then the values in
+ * the same order. The children's data follows the JEntrys, in the same
+ * order.
+ *
+ * A JEntry holds the type of its child and the offset of the end of the
+ * child's data from the start of the data area. A child starts where the
+ * previous one ends, so the JEntrys give the position and length of every
+ * child without looking at any data. Looking up a key is a binary search
+ * over the keys' JEntrys.
+ *
+ * Strings are stored de-escaped, and numbers as the text of their JSON
+ * token, neither with a terminating zero. true, false and null take no
+ * space. A nested container starts at the next 4-byte boundary; the padding
+ * counts towards its length. All offsets are relative to the container, so
+ * a nested container can be copied out as it is.
+ */
+typedef uint32 JEntry;
+
+#define JENTRY_ENDMASK			0x0FFFFFFF
+#define JENTRY_TYPEMASK			0x70000000
+
+#define JENTRY_ISSTRING			0x00000000
+#define JENTRY_ISNUMERIC		0x10000000
+#define JENTRY_ISFALSE			0x20000000
+#define JENTRY_ISTRUE			0x30000000
+#define JENTRY_ISNULL			0x40000000
+#define JENTRY_ISCONTAINER		0x50000000
+
+#define JBE_END(je)				((je) & JENTRY_ENDMASK)
+#define JBE_TYPE(je)			((je) & JENTRY_TYPEMASK)
+
+#define JB_CMASK				0x0FFFFFFF
+#define JB_FSCALAR				0x10000000
+#define JB_FOBJECT				0x20000000
+#define JB_FARRAY				0x40000000
+
+typedef struct JsonbContainer
+{
+	uint32		header;			/* number of children, and flags */
+	JEntry		children[1];	/* VARIABLE LENGTH ARRAY */
+} JsonbContainer;
+
+typedef struct Jsonb
+{
+	int32		vl_len_;		/* varlena header (do not touch directly!) */
+	JsonbContainer root;
+} Jsonb;
+
+#define JsonbContainerSize(jc)		((jc)->header & JB_CMASK)
+#define JsonbContainerIsObject(jc)	(((jc)->header & JB_FOBJECT) != 0)
+#define JsonbContainerIsArray(jc)	(((jc)->header & JB_FARRAY) != 0)
+#define JsonbContainerIsScalar(jc)	(((jc)->header & JB_FSCALAR) != 0)
+
+#define DatumGetJsonb(d)		((Jsonb *) PG_DETOAST_DATUM(d))
+#define JsonbGetDatum(p)		PointerGetDatum(p)
+#define PG_GETARG_JSONB(n)		DatumGetJsonb(PG_GETARG_DATUM(n))
+#define PG_RETURN_JSONB(p)		PG_RETURN_POINTER(p)
+
+/* I/O routines */
+extern Datum jsonb_in(PG_FUNCTION_ARGS);
+extern Datum jsonb_out(PG_FUNCTION_ARGS);
+extern Datum jsonb_recv(PG_FUNCTION_ARGS);
+extern Datum jsonb_send(PG_FUNCTION_ARGS);
+
+/* casts */
+extern Datum json_to_jsonb(PG_FUNCTION_ARGS);
+extern Datum jsonb_to_json(PG_FUNCTION_ARGS);
+
+/* operators */
+extern Datum jsonb_object_field(PG_FUNCTION_ARGS);
+extern Datum jsonb_object_field_text(PG_FUNCTION_ARGS);
+extern Datum jsonb_array_element(PG_FUNCTION_ARGS);
+extern Datum jsonb_array_element_text(PG_FUNCTION_ARGS);
+extern Datum jsonb_extract_path(PG_FUNCTION_ARGS);
+extern Datum jsonb_extract_path_text(PG_FUNCTION_ARGS);
+extern Datum jsonb_exists(PG_FUNCTION_ARGS);
+extern Datum jsonb_contains(PG_FUNCTION_ARGS);
+extern Datum jsonb_contained(PG_FUNCTION_ARGS);
+
+#endif   /* JSONB_H */
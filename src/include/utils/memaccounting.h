@@ -56,6 +56,12 @@ extern int memory_profiler_dataset_size;
  */
 extern bool gp_dump_memory_usage;
 
+/*
+ * Allocated kB between updates of the memory accounts' peaks. 0 updates them
+ * on every allocation.
+ */
+extern int gp_memory_accounting_sample_size;
+
 /*
  * Each memory account can assume one of the following memory
  * owner types
@@ -237,6 +243,9 @@ MemoryAccounting_PrettyPrint(void);
 extern uint64
 MemoryAccounting_DeclareDone(void);
 
+extern uint64
+MemoryAccounting_RelinquishQuota(MemoryAccountIdType accountId);
+
 extern uint64
 MemoryAccounting_RequestQuotaIncrease(void);
 
@@ -64,6 +64,7 @@ extern MemoryAccount *SharedChunkHeadersMemoryAccount;
 
 extern uint64 MemoryAccountingOutstandingBalance;
 extern uint64 MemoryAccountingPeakBalance;
+extern int64 MemoryAccountingBytesToSample;
 
 /*
  * MemoryAccounting_IsLiveAccount
@@ -121,6 +122,25 @@ MemoryAccounting_ConvertIdToAccount(MemoryAccountIdType id)
 	return memoryAccount;
 }
 
+/*
+ * MemoryAccounting_UpdatePeak
+ *		Brings the peak of an account and the global peak up to date with
+ *		their current balance.
+ *
+ * memoryAccount: the account whose peak to update
+ */
+static inline void
+MemoryAccounting_UpdatePeak(MemoryAccount *memoryAccount)
+{
+	Size held = memoryAccount->allocated -
+			memoryAccount->freed;
+
+	memoryAccount->peak =
+			Max(memoryAccount->peak, held);
+
+	MemoryAccountingPeakBalance = Max(MemoryAccountingPeakBalance, MemoryAccountingOutstandingBalance);
+}
+
 /*
  * MemoryAccounting_Allocate
  *	 	When an allocation is made, this function will be called by the
@@ -141,17 +161,22 @@ MemoryAccounting_Allocate(MemoryAccountIdType memoryAccountId, Size allocatedSiz
 
 	memoryAccount->allocated += allocatedSize;
 
-	Size held = memoryAccount->allocated -
-			memoryAccount->freed;
-
-	memoryAccount->peak =
-			Max(memoryAccount->peak, held);
-
 	Assert(memoryAccount->allocated >=
 			memoryAccount->freed);
 
 	MemoryAccountingOutstandingBalance += allocatedSize;
-	MemoryAccountingPeakBalance = Max(MemoryAccountingPeakBalance, MemoryAccountingOutstandingBalance);
+
+	/*
+	 * The balances are always exact. If gp_memory_accounting_sample_size is
+	 * set, the peaks are only brought up to date once that much has been
+	 * allocated since the last update, and when switching accounts.
+	 */
+	MemoryAccountingBytesToSample -= allocatedSize;
+	if (MemoryAccountingBytesToSample <= 0)
+	{
+		MemoryAccountingBytesToSample = (int64) gp_memory_accounting_sample_size * 1024;
+		MemoryAccounting_UpdatePeak(memoryAccount);
+	}
 
 	return true;
 }
@@ -253,6 +253,18 @@ extern MemoryContext AllocSetContextCreate(MemoryContext parent,
 					  Size initBlockSize,
 					  Size maxBlockSize);
 
+/* slab.c */
+extern MemoryContext SlabContextCreate(MemoryContext parent,
+				  const char *name,
+				  Size chunkSize,
+				  Size blockSize);
+
+/* bump.c */
+extern MemoryContext BumpContextCreate(MemoryContext parent,
+				  const char *name,
+				  Size initBlockSize,
+				  Size maxBlockSize);
+
 /* mpool.c */
 typedef struct MPool MPool;
 extern MPool *mpool_create(MemoryContext parent,
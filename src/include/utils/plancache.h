@@ -63,6 +63,14 @@ typedef struct CachedPlanSource
 	struct CachedPlan *plan;	/* link to plan, or NULL if not valid */
 	MemoryContext context;		/* context containing this CachedPlanSource */
 	struct CachedPlan *orig_plan;		/* link to plan owning my context */
+
+	/* GPDB: used to choose between custom and generic plans */
+	int			num_custom_plans;	/* number of plans built with params */
+	double		total_custom_cost;	/* total cost of those plans */
+	double		generic_cost;	/* cost of generic plan, or -1 if not known */
+	int			num_direct_custom_plans;	/* how many of them were dispatched
+											 * directly */
+	bool		generic_direct;	/* generic plan is dispatched directly */
 } CachedPlanSource;
 
 /*
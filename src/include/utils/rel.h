@@ -272,6 +272,7 @@ typedef struct StdRdOptions
 	char*		compresstype;   /* compression type (AO rels only) */
 	bool		checksum;		/* checksum (AO rels only) */
 	bool 		columnstore;		/* columnstore (AO only) */
+	bool		keep_cached;	/* never scan through a buffer ring (heap only) */
 } StdRdOptions;
 
 #define HEAP_MIN_FILLFACTOR			10
@@ -285,6 +286,15 @@ typedef struct StdRdOptions
 	((relation)->rd_options ? \
 	 ((StdRdOptions *) (relation)->rd_options)->fillfactor : (defaultff))
 
+/*
+ * RelationKeepCached
+ *		Returns true if scans of the relation should leave its pages in
+ *		shared buffers, rather than recycle them through a buffer ring.
+ */
+#define RelationKeepCached(relation) \
+	((relation)->rd_options ? \
+	 ((StdRdOptions *) (relation)->rd_options)->keep_cached : false)
+
 /*
  * RelationGetTargetPageUsage
  *		Returns the relation's desired space usage per page in bytes.
@@ -98,6 +98,9 @@ extern int						memory_spill_ratio;
 
 extern double gp_resource_group_cpu_limit;
 extern double gp_resource_group_memory_limit;
+extern bool gp_resource_group_cpu_ceiling_enforcement;
+extern char *gp_resource_group_cpuset;
+extern int gp_resource_group_spill_grace_mb;
 
 /* Type of statistic infomation */
 typedef enum
@@ -151,6 +154,8 @@ extern void ResGroupDumpMemoryInfo(void);
 extern bool ResGroupReserveMemory(int32 memoryChunks, int32 overuseChunks, bool *waiverUsed);
 /* Update the memory usage of resource group */
 extern void ResGroupReleaseMemory(int32 memoryChunks);
+/* Check whether operators are asked to spill to disk */
+extern bool ResGroupConsumeSpillRequest(void);
 
 extern void ResGroupAlterOnCommit(Oid groupId,
 								  ResGroupLimitType limittype,
@@ -168,6 +173,7 @@ extern void ResGroupDecideConcurrencyCaps(Oid groupId,
 extern void ResGroupGetMemInfo(int *memLimit, int *slotQuota, int *sharedQuota);
 
 extern int64 ResourceGroupGetQueryMemoryLimit(void);
+extern Oid GetMyResGroupId(void);
 
 #define LOG_RESGROUP_DEBUG(...) \
 	do {if (Debug_resource_group) elog(__VA_ARGS__); } while(false);
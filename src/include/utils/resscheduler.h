@@ -37,6 +37,8 @@ extern int	MaxResourceQueues;
 extern int	MaxResourcePortalsPerXact;
 extern bool	ResourceSelectOnly;
 extern bool	ResourceCleanupIdleGangs;
+extern double gp_resqueue_fast_lane_cost;
+extern int	gp_resqueue_fast_lane_slots;
 
 extern Oid MyQueueId; /* resource queue for current role. */
 
@@ -71,6 +73,12 @@ typedef struct ResLimitData
 typedef ResLimitData	*ResLimit;
 
 
+/*
+ * Number of buckets of the wait time histogram of a resource queue, see
+ * ResQueueRecordWait().
+ */
+#define RES_QUEUE_WAIT_BUCKETS			7
+
 /* Resource Queues */
 typedef struct ResQueueData
 {
@@ -79,6 +87,8 @@ typedef struct ResQueueData
 	bool			overcommit;			/* Does queue allow overcommit? */
 	float4			ignorecostlimit;	/* Ignore queries with cost less than.*/
 	ResLimitData	limits[NUM_RES_LIMIT_TYPES];	/* The limits */
+	int64			waitHistogram[RES_QUEUE_WAIT_BUCKETS];	/* # of statements
+															 * by wait time */
 } ResQueueData;
 typedef ResQueueData	*ResQueue;
 
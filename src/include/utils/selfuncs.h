@@ -110,6 +110,9 @@ extern void get_join_variables(PlannerInfo *root, List *args,
 				   VariableStatData *vardata1,
 				   VariableStatData *vardata2);
 extern double get_variable_numdistinct(VariableStatData *vardata);
+extern void find_attribute_dependencies(PlannerInfo *root, Index varno,
+							int nattrs, const AttrNumber *attnums,
+							double *degrees);
 extern double mcv_selectivity(VariableStatData *vardata, FmgrInfo *opproc,
 				Datum constval, bool varonleft,
 				double *sumcommonp);
@@ -0,0 +1,37 @@
+/*-------------------------------------------------------------------------
+ *
+ * sharedcatcache.h
+ *	  Interface for the shared-memory tier of the system catalog caches.
+ *
+ *
+ * Portions Copyright (c) 2012-Present Pivotal Software, Inc.
+ *
+ *
+ * IDENTIFICATION
+ *	    src/include/utils/sharedcatcache.h
+ *
+ *-------------------------------------------------------------------------
+ */
+#ifndef SHAREDCATCACHE_H
+#define SHAREDCATCACHE_H
+
+#include "access/htup.h"
+#include "access/skey.h"
+#include "utils/catcache.h"
+
+/* Largest catalog tuple (header included) kept in the shared tier */
+#define SHARED_CATCACHE_MAX_TUPLE	512
+
+extern Size SharedCatCacheShmemSize(void);
+extern void SharedCatCacheShmemInit(void);
+
+extern bool SharedCatCacheUsable(CatCache *cache);
+extern uint64 SharedCatCacheGeneration(void);
+extern HeapTuple SharedCatCacheLookup(CatCache *cache, uint32 hashValue,
+					 ScanKey skey);
+extern void SharedCatCacheInsert(CatCache *cache, uint32 hashValue,
+					 ScanKey skey, HeapTuple tuple, uint64 generation);
+extern void SharedCatCacheInvalidate(Oid dbId, int cacheId, uint32 hashValue);
+extern void SharedCatCacheReset(void);
+
+#endif   /* SHAREDCATCACHE_H */
@@ -221,8 +221,23 @@ typedef enum MKLvType
     MKLV_TYPE_INT32, /* this level contains int32 values */
     MKLV_TYPE_CHAR,  /* this level contains char (blank padded) values */
     MKLV_TYPE_TEXT,  /* this level contains text values */
+    MKLV_TYPE_INT64, /* this level contains int64 values (int8, timestamp) */
+
+    /*
+     * Abbreviated levels: prepare replaces the datum with a 64 bit key whose
+     * unsigned order agrees with the sort order, and only a tie on the key
+     * goes back to the tuple and the sort function.  See tupsort_abbrev_*.
+     */
+    MKLV_TYPE_CHAR_C,   /* char (blank padded) values, C collation */
+    MKLV_TYPE_TEXT_C,   /* text values, C collation */
+    MKLV_TYPE_NUMERIC,  /* numeric values */
 } MKLvType;
 
+static inline bool mklv_is_abbrev(MKLvType t)
+{
+    return t == MKLV_TYPE_CHAR_C || t == MKLV_TYPE_TEXT_C || t == MKLV_TYPE_NUMERIC;
+}
+
 typedef struct MKLvContext
 {
 	/* Is the type of datums in this level passed by value instead of reference */
@@ -331,6 +346,7 @@ static inline void mk_qsort(MKEntry* a, int n, MKContext *ctxt)
 {
     mk_qsort_impl(a, 0, n-1, 0, true, ctxt, false);
 }
+extern void mk_qsort_parallel(MKEntry *a, int n, MKContext *ctxt, int nthreads);
 
 /* MK Heap stuff */
 typedef bool (*MKFlagPtrReader) (void *ctxt, MKEntry *e);
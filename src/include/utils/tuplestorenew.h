@@ -29,10 +29,15 @@ extern NTupleStore *ntuplestore_create(int64 maxBytes);
 extern NTupleStore *ntuplestore_create_readerwriter(const char* filename, int64 maxBytes, bool isWriter);
 extern NTupleStore *ntuplestore_create_workset(workfile_set *workSet, int64 maxBytes);
 extern bool ntuplestore_is_readerwriter_reader(NTupleStore* nts);
+extern NTupleStore *ntuplestore_create_block_reader(const char *blocks, int nblocks);
+extern int ntuplestore_inmem_blocks(NTupleStore *ts);
+extern void ntuplestore_copy_blocks(NTupleStore *ts, char *dest);
 extern void ntuplestore_reset(NTupleStore *ts);
 extern void ntuplestore_flush(NTupleStore *ts);
 extern void ntuplestore_destroy(NTupleStore *ts);
 extern void ntuplestore_trim(NTupleStore* ts, NTupleStorePos *pos);
+extern bool ntuplestore_has_workfiles(NTupleStore *ts);
+extern void ntuplestore_keep_workfiles(NTupleStore *ts);
 
 /* Tuple store accessor method 
  * Create Accessor: current we support 1 writer, many reader per store.  After created, the accessor
@@ -37,6 +37,7 @@ typedef enum MemoryAllocationStatus
 typedef int64 EventVersion;
 
 extern int runaway_detector_activation_percent;
+extern int gp_vmem_reserve_batch_chunks;
 
 extern int32 VmemTracker_ConvertVmemChunksToMB(int chunks);
 extern int32 VmemTracker_ConvertVmemMBToChunks(int mb);
@@ -58,6 +59,7 @@ extern void VmemTracker_Shutdown(void);
 extern void VmemTracker_ResetMaxVmemReserved(void);
 extern MemoryAllocationStatus VmemTracker_ReserveVmem(int64 newly_requested);
 extern void VmemTracker_ReleaseVmem(int64 to_be_freed_requested);
+extern void VmemTracker_ReleaseCachedVmemChunks(void);
 extern void VmemTracker_RequestWaiver(int64 waiver_bytes);
 extern void VmemTracker_ResetWaiver(void);
 extern int64 VmemTracker_Fault(int32 reason, int64 arg);
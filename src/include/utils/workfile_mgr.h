@@ -100,6 +100,12 @@ typedef struct workfile_set
 	/* Operator-specific metadata */
 	workfile_set_op_metadata metadata;
 
+	/*
+	 * Kept past the end of the query that created it, see
+	 * workfile_mgr_set_outlives_query()
+	 */
+	bool outlives_query;
+
   /*
    * To make sure we don't leak workfile_set handles on abort, we keep them in
    * a linked list. We use the ResourceOwner mechanism to free them on abort.
@@ -147,7 +153,10 @@ void workfile_mgr_cache_init(void);
 void workfile_mgr_mark_complete(workfile_set *work_set);
 Cache *workfile_mgr_get_cache(void);
 int32 workfile_mgr_clear_cache(int seg_id);
+List *workfile_mgr_spill_locations(void);
+char *workfile_mgr_spill_location_tmpdir(const char *location);
 void workfile_set_update_in_progress_size(workfile_set *work_set, int64 size);
+void workfile_mgr_set_outlives_query(workfile_set *work_set, int nfiles);
 
 /* Workfile File operations */
 ExecWorkFile *workfile_mgr_create_file(workfile_set *work_set);
@@ -0,0 +1,69 @@
+-- Relation locks that take the fast path (AccessShareLock, RowShareLock and
+-- RowExclusiveLock, kept in slots of the backend's PGPROC) must behave like
+-- locks in the main lock table to everyone else.
+
+CREATE EXTENSION IF NOT EXISTS gp_inject_fault;
+CREATE TABLE fpl (a int, b int) DISTRIBUTED BY (a);
+INSERT INTO fpl SELECT i, i FROM generate_series(1, 10) i;
+
+-- A strong lock moves the fast-path locks of other sessions to the main
+-- lock table and waits for them.
+1: BEGIN;
+1: SELECT count(*) FROM fpl;
+2: BEGIN;
+2: SELECT count(*) FROM fpl;
+-- pg_locks shows the fast-path locks of both, on the master and on every
+-- segment.
+3: SELECT mode, granted, count(*) >= 2 AS two_sessions, count(DISTINCT gp_segment_id) = (SELECT count(*) FROM gp_segment_configuration WHERE role = 'p') AS all_nodes FROM pg_locks WHERE relation = 'fpl'::regclass GROUP BY 1, 2;
+3: BEGIN;
+3&: LOCK fpl IN ACCESS EXCLUSIVE MODE;
+-- While the strong lock is awaited, weak lockers can't take the fast path,
+-- and queue up behind it.
+4: BEGIN;
+4&: SELECT count(*) FROM fpl;
+5: SELECT mode, granted, count(*) FROM pg_locks WHERE relation = 'fpl'::regclass AND gp_segment_id = -1 GROUP BY 1, 2 ORDER BY 1, 2;
+1: COMMIT;
+2: COMMIT;
+3<:
+3: COMMIT;
+4<:
+4: COMMIT;
+
+-- Reader gangs share the locks of their MPP session with its writer. They
+-- don't wait for a strong lock their writer holds.
+1: BEGIN;
+1: LOCK fpl IN ACCESS EXCLUSIVE MODE;
+1: SELECT count(*) FROM fpl x JOIN fpl y ON x.a = y.b;
+1: COMMIT;
+-- Nor does the writer wait for the locks its readers took through the fast
+-- path, when it asks for a strong lock later in the transaction.
+1: BEGIN;
+1: SELECT count(*) FROM fpl x JOIN fpl y ON x.a = y.b;
+1: ALTER TABLE fpl ADD COLUMN c int;
+1: SELECT count(*) FROM fpl x JOIN fpl y ON x.a = y.b;
+1: COMMIT;
+-- Another session waits for all of them.
+1: BEGIN;
+1: SELECT count(*) FROM fpl x JOIN fpl y ON x.a = y.b;
+2&: ALTER TABLE fpl DROP COLUMN c;
+5: SELECT mode, granted, count(*) FROM pg_locks WHERE relation = 'fpl'::regclass AND gp_segment_id = -1 GROUP BY 1, 2 ORDER BY 1, 2;
+1: COMMIT;
+2<:
+
+-- The segments prepare a distributed transaction while it holds fast-path
+-- locks. The prepared transaction keeps them until COMMIT PREPARED.
+select gp_inject_fault('dtm_broadcast_commit_prepared', 'suspend', 1);
+1: BEGIN;
+1: SELECT count(*) FROM fpl;
+1: INSERT INTO fpl SELECT i, i FROM generate_series(11, 20) i;
+1&: COMMIT;
+2U: BEGIN;
+2U&: LOCK fpl IN ACCESS EXCLUSIVE MODE;
+5: SELECT DISTINCT mode, granted FROM pg_locks WHERE relation = 'fpl'::regclass AND gp_segment_id = 0 ORDER BY 1, 2;
+select gp_inject_fault('dtm_broadcast_commit_prepared', 'reset', 1);
+1<:
+2U<:
+2U: COMMIT;
+1: SELECT count(*) FROM fpl;
+
+DROP TABLE fpl;
@@ -0,0 +1,42 @@
+-- With the global deadlock detector on, UPDATE on a heap table keeps
+-- RowExclusiveLock on the master, which takes the fast path. The detector
+-- builds its graph from pg_locks, so it must find a deadlock between two
+-- sessions that only wait for each other on the segments, while their
+-- master locks sit in fast-path slots.
+
+-- start_ignore
+! gpconfig -c gp_enable_global_deadlock_detector -v on;
+! gpconfig -c gp_global_deadlock_detector_period -v 5;
+! gpstop -rai;
+-- end_ignore
+
+-- one row on segment 0 and one on segment 1
+11: CREATE TABLE fpl_gdd_all AS SELECT i AS a, i AS b FROM generate_series(1, 100) i DISTRIBUTED BY (a);
+11: CREATE TABLE fpl_gdd (a int, b int) DISTRIBUTED BY (a);
+11: INSERT INTO fpl_gdd SELECT a, b FROM fpl_gdd_all WHERE a IN (SELECT min(a) FROM fpl_gdd_all WHERE gp_segment_id IN (0, 1) GROUP BY gp_segment_id);
+
+11: BEGIN;
+11: UPDATE fpl_gdd SET b = b + 1 WHERE gp_segment_id = 0;
+12: BEGIN;
+12: UPDATE fpl_gdd SET b = b + 1 WHERE gp_segment_id = 1;
+13: SELECT mode, granted, count(*) FROM pg_locks WHERE relation = 'fpl_gdd'::regclass AND gp_segment_id = -1 GROUP BY 1, 2;
+11&: UPDATE fpl_gdd SET b = b + 1 WHERE gp_segment_id = 1;
+12&: UPDATE fpl_gdd SET b = b + 1 WHERE gp_segment_id = 0;
+-- the detector cancels the younger session
+12<:
+11<:
+12: END;
+11: COMMIT;
+11: SELECT b - a AS delta, count(*) FROM fpl_gdd GROUP BY 1;
+
+11: DROP TABLE fpl_gdd;
+11: DROP TABLE fpl_gdd_all;
+11q:
+12q:
+13q:
+
+-- start_ignore
+! gpconfig -r gp_global_deadlock_detector_period;
+! gpconfig -r gp_enable_global_deadlock_detector;
+! gpstop -rai;
+-- end_ignore
@@ -0,0 +1,83 @@
+-- With the global deadlock detector on, UPDATE and DELETE on a heap table
+-- keep RowExclusiveLock on the master, so two sessions can reach the same
+-- row on a segment. The second one must not rerun its plan for the new
+-- version of the row (EvalPlanQual), which can't work below a Motion, and
+-- the delete half of a split update must not skip a row that is gone while
+-- its insert half goes ahead. Both fail with a serialization error instead.
+--
+-- Without ORCA, the planner refuses updates of the distribution key, and
+-- an UPDATE of a row deleted concurrently finds nothing to do; with ORCA,
+-- every UPDATE is a split update (see gdd_concurrent_update_1.out).
+
+-- start_ignore
+! gpconfig -c gp_enable_global_deadlock_detector -v on;
+! gpstop -rai;
+-- end_ignore
+
+1: SHOW gp_enable_global_deadlock_detector;
+
+1: CREATE TABLE gdd_update (id int, val int) DISTRIBUTED BY (id);
+1: INSERT INTO gdd_update SELECT g, g FROM generate_series(1, 5) g;
+
+-- concurrent UPDATE of the same row
+1: BEGIN;
+1: UPDATE gdd_update SET val = val + 10 WHERE id = 1;
+2&: UPDATE gdd_update SET val = val + 100 WHERE id = 1;
+1: COMMIT;
+2<:
+1: SELECT * FROM gdd_update WHERE id = 1;
+
+-- DELETE of a row updated concurrently
+1: BEGIN;
+1: UPDATE gdd_update SET val = val + 10 WHERE id = 2;
+2&: DELETE FROM gdd_update WHERE id = 2;
+1: COMMIT;
+2<:
+1: SELECT * FROM gdd_update WHERE id = 2;
+
+-- UPDATE and DELETE of a row deleted concurrently
+1: BEGIN;
+1: DELETE FROM gdd_update WHERE id = 3;
+2&: UPDATE gdd_update SET val = val + 100 WHERE id = 3;
+1: COMMIT;
+2<:
+1: BEGIN;
+1: DELETE FROM gdd_update WHERE id = 4;
+2&: DELETE FROM gdd_update WHERE id = 4;
+1: COMMIT;
+2<:
+1: SELECT * FROM gdd_update ORDER BY id;
+
+-- updates of the distribution key must neither duplicate a row updated
+-- concurrently nor bring back a row deleted concurrently
+1: INSERT INTO gdd_update VALUES (3, 3), (4, 4);
+1: BEGIN;
+1: UPDATE gdd_update SET val = val + 10 WHERE id = 3;
+2&: UPDATE gdd_update SET id = id + 200 WHERE id = 3;
+1: COMMIT;
+2<:
+1: BEGIN;
+1: DELETE FROM gdd_update WHERE id = 4;
+2&: UPDATE gdd_update SET id = id + 200 WHERE id = 4;
+1: COMMIT;
+2<:
+1: SELECT * FROM gdd_update ORDER BY id;
+
+-- writers of different rows don't wait for each other
+1: BEGIN;
+1: UPDATE gdd_update SET val = 0 WHERE id = 1;
+2: BEGIN;
+2: UPDATE gdd_update SET val = 0 WHERE id = 2;
+2: DELETE FROM gdd_update WHERE id = 5;
+2: COMMIT;
+1: COMMIT;
+1: SELECT * FROM gdd_update ORDER BY id;
+
+1: DROP TABLE gdd_update;
+1q:
+2q:
+
+-- start_ignore
+! gpconfig -r gp_enable_global_deadlock_detector;
+! gpstop -rai;
+-- end_ignore
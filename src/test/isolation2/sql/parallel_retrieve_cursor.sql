@@ -0,0 +1,138 @@
+-- Tests of PARALLEL RETRIEVE cursors, with the rows retrieved from the
+-- endpoints by utility mode sessions on the segments.
+--
+-- The tokens are only known to the session of the cursor, so the segment
+-- sessions find them with gp_segment_endpoints(), and RETRIEVE through
+-- EXECUTE in a function.
+
+1: CREATE TABLE prc_t (a int) DISTRIBUTED BY (a);
+1: INSERT INTO prc_t SELECT generate_series(1, 1000);
+
+-- The token of the endpoint on this segment, waiting for its QE to start.
+1: CREATE FUNCTION prc_token() RETURNS text AS $$ /*in func*/
+DECLARE /*in func*/
+  tok text; /*in func*/
+BEGIN /*in func*/
+  FOR i IN 1..100 LOOP /*in func*/
+    SELECT token INTO tok FROM gp_segment_endpoints(); /*in func*/
+    IF tok IS NOT NULL THEN /*in func*/
+      RETURN tok; /*in func*/
+    END IF; /*in func*/
+    PERFORM pg_sleep(0.1); /*in func*/
+  END LOOP; /*in func*/
+  RETURN NULL; /*in func*/
+END; /*in func*/
+$$ LANGUAGE plpgsql;
+
+-- Retrieves n rows from an endpoint, or all of them if n is NULL.  Returns
+-- the number of rows and their sum, as "count:sum".
+1: CREATE FUNCTION prc_retrieve(tok text, n int) RETURNS text AS $$ /*in func*/
+DECLARE /*in func*/
+  r record; /*in func*/
+  cnt bigint := 0; /*in func*/
+  total bigint := 0; /*in func*/
+BEGIN /*in func*/
+  FOR r IN EXECUTE 'RETRIEVE ' || coalesce(n::text, 'ALL') || ' FROM ENDPOINT ' || quote_literal(tok) LOOP /*in func*/
+    cnt := cnt + 1; /*in func*/
+    total := total + r.a; /*in func*/
+  END LOOP; /*in func*/
+  RETURN cnt || ':' || total; /*in func*/
+END; /*in func*/
+$$ LANGUAGE plpgsql;
+
+-- Waits for the endpoint on this segment to be aborted.
+1: CREATE FUNCTION prc_wait_aborted() RETURNS boolean AS $$ /*in func*/
+BEGIN /*in func*/
+  FOR i IN 1..100 LOOP /*in func*/
+    IF EXISTS (SELECT 1 FROM gp_segment_endpoints() WHERE state = 'aborted') THEN /*in func*/
+      RETURN true; /*in func*/
+    END IF; /*in func*/
+    PERFORM pg_sleep(0.1); /*in func*/
+  END LOOP; /*in func*/
+  RETURN false; /*in func*/
+END; /*in func*/
+$$ LANGUAGE plpgsql;
+
+-- The number of endpoints left on this segment, once they had time to go.
+1: CREATE FUNCTION prc_endpoints_left() RETURNS bigint AS $$ /*in func*/
+DECLARE /*in func*/
+  n bigint; /*in func*/
+BEGIN /*in func*/
+  FOR i IN 1..100 LOOP /*in func*/
+    SELECT count(*) INTO n FROM gp_segment_endpoints(); /*in func*/
+    IF n = 0 THEN /*in func*/
+      RETURN 0; /*in func*/
+    END IF; /*in func*/
+    PERFORM pg_sleep(0.1); /*in func*/
+  END LOOP; /*in func*/
+  RETURN n; /*in func*/
+END; /*in func*/
+$$ LANGUAGE plpgsql;
+
+-- Each segment retrieves exactly its own rows, and the cursor finishes
+-- once they all have.
+1: BEGIN;
+1: DECLARE c1 PARALLEL RETRIEVE CURSOR FOR SELECT a FROM prc_t;
+1: SELECT count(*) FROM gp_endpoints() WHERE cursorname = 'c1';
+2U: SELECT prc_retrieve(prc_token(), NULL) = (SELECT count(*) || ':' || sum(a) FROM prc_t) AS all_rows;
+3U: SELECT prc_retrieve(prc_token(), NULL) = (SELECT count(*) || ':' || sum(a) FROM prc_t) AS all_rows;
+4U: SELECT prc_retrieve(prc_token(), NULL) = (SELECT count(*) || ':' || sum(a) FROM prc_t) AS all_rows;
+1: SELECT gp_wait_parallel_retrieve_cursor('c1');
+1: CLOSE c1;
+1: COMMIT;
+2U: SELECT prc_endpoints_left();
+3U: SELECT prc_endpoints_left();
+4U: SELECT prc_endpoints_left();
+
+-- Rows can be retrieved a few at a time.  Waiting for the cursor blocks
+-- until the last ones are gone.
+1: BEGIN;
+1: DECLARE c2 PARALLEL RETRIEVE CURSOR FOR SELECT a FROM prc_t;
+2U: SELECT split_part(prc_retrieve(prc_token(), 10), ':', 1) AS first_rows;
+1&: SELECT gp_wait_parallel_retrieve_cursor('c2');
+2U: SELECT split_part(prc_retrieve(prc_token(), NULL), ':', 1)::int + 10 = (SELECT count(*) FROM prc_t) AS other_rows;
+3U: SELECT prc_retrieve(prc_token(), NULL) = (SELECT count(*) || ':' || sum(a) FROM prc_t) AS all_rows;
+4U: SELECT prc_retrieve(prc_token(), NULL) = (SELECT count(*) || ':' || sum(a) FROM prc_t) AS all_rows;
+1<:
+1: COMMIT;
+2U: SELECT prc_endpoints_left();
+3U: SELECT prc_endpoints_left();
+4U: SELECT prc_endpoints_left();
+
+-- Closing the cursor in the middle aborts its endpoints.  A session that
+-- was retrieving gets the rows that were already sent, then an error.
+1: BEGIN;
+1: DECLARE c3 PARALLEL RETRIEVE CURSOR FOR SELECT a FROM prc_t;
+2U: SELECT split_part(prc_retrieve(prc_token(), 5), ':', 1) AS first_rows;
+1: CLOSE c3;
+2U: SELECT prc_wait_aborted();
+2U: SELECT prc_retrieve(prc_token(), NULL);
+1: COMMIT;
+2U: SELECT prc_endpoints_left();
+3U: SELECT prc_endpoints_left();
+4U: SELECT prc_endpoints_left();
+
+-- A query that fails on the segments reports the error when waiting for
+-- the cursor, and leaves no endpoints behind.
+1: BEGIN;
+1: DECLARE c4 PARALLEL RETRIEVE CURSOR FOR SELECT a / (a - a) AS a FROM prc_t;
+1: SELECT gp_wait_parallel_retrieve_cursor('c4');
+1: ROLLBACK;
+2U: SELECT prc_endpoints_left();
+3U: SELECT prc_endpoints_left();
+4U: SELECT prc_endpoints_left();
+
+-- So does ending the transaction without retrieving anything.
+1: BEGIN;
+1: DECLARE c5 PARALLEL RETRIEVE CURSOR FOR SELECT a FROM prc_t;
+2U: SELECT prc_token() IS NOT NULL AS has_endpoint;
+1: ROLLBACK;
+2U: SELECT prc_endpoints_left();
+3U: SELECT prc_endpoints_left();
+4U: SELECT prc_endpoints_left();
+
+1: DROP FUNCTION prc_token();
+1: DROP FUNCTION prc_retrieve(text, int);
+1: DROP FUNCTION prc_wait_aborted();
+1: DROP FUNCTION prc_endpoints_left();
+1: DROP TABLE prc_t;
@@ -0,0 +1,149 @@
+#! /usr/bin/env python
+
+'''
+Benchmark codegen and track its regressions.
+
+  codegen_benchmark.py standalone BINARY [ITERATIONS]
+      Run the standalone benchmarks of src/backend/codegen (built with
+      'cmake -Dbuild_benchmarks=ON' and 'make benchmark'), which measure the
+      generation time, compilation time and speedup of each generator.
+
+  codegen_benchmark.py cluster [NUM_ROWS] [REPEAT]
+      Run queries that exercise slot_getattr, expression trees and aggregates
+      against the running cluster that psql connects to (see PGHOST, PGPORT
+      and PGDATABASE), with codegen off and on, and measure the speedup.
+
+  codegen_benchmark.py compare BASELINE CURRENT [THRESHOLD]
+      Compare two results files and exit with 1 if a benchmark got more than
+      THRESHOLD (default 0.1, i.e. 10%) slower to run, generate or compile.
+
+Results are printed as one JSON object per line, keyed by suite, benchmark
+and param.
+'''
+import json
+import re
+import subprocess
+import sys
+
+# Tuple widths, expression depths and aggregates of the cluster benchmarks
+TUPLE_WIDTHS = [4, 16, 64, 256]
+EXPR_DEPTHS = [1, 4, 16, 64]
+AGGREGATES = ['count(*)', 'sum(c1)', 'avg(c1)', 'min(c1)', 'max(c8)',
+              'sum(c1::numeric)']
+
+CODEGEN_ON = ['SET codegen = on', 'SET codegen_above_cost = 0']
+CODEGEN_OFF = ['SET codegen = off']
+
+def psql(sql):
+    proc = subprocess.Popen(['psql', '-X', '-q', '-A', '-t',
+                             '-v', 'ON_ERROR_STOP=1', '-c', sql],
+                            stdout=subprocess.PIPE, universal_newlines=True)
+    out = proc.communicate()[0]
+    if proc.returncode != 0:
+        sys.exit('psql failed: %s' % sql)
+    return out
+
+def runtime_ms(settings, query, repeat):
+    '''Best EXPLAIN ANALYZE runtime of a query out of repeat runs.'''
+    best = None
+    for _ in range(repeat):
+        out = psql(';'.join(settings + ['EXPLAIN ANALYZE ' + query]))
+        m = re.search(r'Total runtime: (\d+\.\d+) ms', out)
+        if m is None:
+            sys.exit('no runtime in EXPLAIN ANALYZE of: %s' % query)
+        if best is None or float(m.group(1)) < best:
+            best = float(m.group(1))
+    return best
+
+def print_result(benchmark, param, query, repeat):
+    regular = runtime_ms(CODEGEN_OFF, query, repeat)
+    generated = runtime_ms(CODEGEN_ON, query, repeat)
+    print(json.dumps({'suite': 'cluster', 'benchmark': benchmark,
+                      'param': param, 'regular_ms': regular,
+                      'generated_ms': generated,
+                      'speedup': regular / generated}, sort_keys=True))
+    sys.stdout.flush()
+
+def setup_cluster(num_rows):
+    width = max(TUPLE_WIDTHS)
+    columns = ', '.join('c%d int4' % i for i in range(1, width + 1))
+    values = ', '.join('i %% %d' % (i + 1) for i in range(1, width + 1))
+    psql('DROP TABLE IF EXISTS codegen_bench; '
+         'CREATE TABLE codegen_bench (%s) DISTRIBUTED RANDOMLY; '
+         'INSERT INTO codegen_bench SELECT %s FROM generate_series(1, %d) i; '
+         'ANALYZE codegen_bench' % (columns, values, num_rows))
+
+def run_cluster(num_rows, repeat):
+    setup_cluster(num_rows)
+    # Deform up to the last attribute of the given width
+    for width in TUPLE_WIDTHS:
+        print_result('slot_getattr', width,
+                     'SELECT count(*) FROM codegen_bench WHERE c%d >= 0'
+                     % width, repeat)
+    # c1 + c2 + ... with the given number of additions
+    for depth in EXPR_DEPTHS:
+        expr = ' + '.join('c%d' % (i % 8 + 1) for i in range(depth + 1))
+        print_result('expr_int4pl_depth', depth,
+                     'SELECT count(*) FROM codegen_bench WHERE %s > 0' % expr,
+                     repeat)
+    for agg in AGGREGATES:
+        print_result('aggregate_' + re.sub(r'\W+', '_', agg).strip('_'), 0,
+                     'SELECT %s FROM codegen_bench' % agg, repeat)
+    psql('DROP TABLE codegen_bench')
+
+def run_standalone(binary, iterations):
+    args = [binary] + ([iterations] if iterations else [])
+    if subprocess.call(args) != 0:
+        sys.exit('%s failed' % binary)
+
+def load(results_file):
+    results = {}
+    with open(results_file, 'r') as f:
+        for line in f:
+            if line.startswith('{'):
+                r = json.loads(line)
+                results[(r['suite'], r['benchmark'], r['param'])] = r
+    return results
+
+def compare(baseline_file, current_file, threshold):
+    baseline = load(baseline_file)
+    current = load(current_file)
+    regressions = 0
+    for key in sorted(baseline):
+        if key not in current:
+            print('%s %s %s: missing' % key)
+            regressions += 1
+            continue
+        # Lower is better for times, higher for the speedup
+        for metric in ('generation_ms', 'compilation_ms', 'speedup'):
+            if metric not in baseline[key]:
+                continue
+            old = baseline[key][metric]
+            new = current[key][metric]
+            if metric == 'speedup':
+                regressed = new < old * (1 - threshold)
+            else:
+                regressed = new > old * (1 + threshold)
+            if regressed:
+                print('%s %s %s: ' % key +
+                      '%s went from %.3f to %.3f' % (metric, old, new))
+                regressions += 1
+    print('%d regression(s) out of %d benchmarks' %
+          (regressions, len(baseline)))
+    return 1 if regressions else 0
+
+def main(argv):
+    if len(argv) >= 3 and argv[1] == 'standalone':
+        run_standalone(argv[2], argv[3] if len(argv) > 3 else None)
+    elif len(argv) >= 2 and argv[1] == 'cluster':
+        run_cluster(int(argv[2]) if len(argv) > 2 else 1000000,
+                    int(argv[3]) if len(argv) > 3 else 3)
+    elif len(argv) >= 4 and argv[1] == 'compare':
+        return compare(argv[2], argv[3],
+                       float(argv[4]) if len(argv) > 4 else 0.1)
+    else:
+        sys.exit(__doc__)
+    return 0
+
+if __name__ == '__main__':
+    sys.exit(main(sys.argv))
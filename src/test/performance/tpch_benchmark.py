@@ -0,0 +1,289 @@
+#! /usr/bin/env python
+
+'''
+Run TPC-H against a cluster with ORCA and the planner, and track its
+regressions.
+
+  tpch_benchmark.py load DBGEN SCALE [STORAGE]
+      Generate the TPC-H data of the given scale factor with DBGEN, the
+      dbgen program of the TPC-H kit with dists.dss next to it, in
+      $MASTER_DATA_DIRECTORY/tpchdata. Serve it with gpfdist on GPFDIST_PORT
+      (default 9001) and load it through external tables into the database
+      psql connects to (see PGHOST, PGPORT and PGDATABASE). STORAGE is the
+      WITH clause of the tables, e.g. 'appendonly=true, orientation=column'.
+
+  tpch_benchmark.py run [REPEAT] [QUERY_DIR]
+      Run every .sql file in QUERY_DIR (default: the 22 TPC-H queries in
+      tpch/) with ORCA and with the planner, and print the best of REPEAT
+      (default 3) runtimes of each. The plans are written to
+      plans/<optimizer>/<query>.txt. Any query directory works, e.g. TPC-DS
+      queries generated by dsqgen, as long as each file is one statement.
+
+  tpch_benchmark.py compare BASELINE CURRENT [THRESHOLD]
+      Compare two results files and exit with 1 if a query got more than
+      THRESHOLD (default 0.1, i.e. 10%) slower, started failing or started
+      falling back from ORCA to the planner. Plan changes are listed too, but
+      are not failures by themselves.
+
+Results are printed as one JSON object per line, keyed by suite, benchmark
+and param, like those of codegen_benchmark.py.
+'''
+import glob
+import hashlib
+import json
+import multiprocessing
+import os
+import re
+import socket
+import subprocess
+import sys
+import time
+
+# The TPC-H tables: dbgen's -T letter, distribution key and columns
+TABLES = [
+    ('region', 'r', 'r_regionkey', [
+        ('r_regionkey', 'int4'), ('r_name', 'char(25)'),
+        ('r_comment', 'varchar(152)')]),
+    ('nation', 'n', 'n_nationkey', [
+        ('n_nationkey', 'int4'), ('n_name', 'char(25)'),
+        ('n_regionkey', 'int4'), ('n_comment', 'varchar(152)')]),
+    ('part', 'P', 'p_partkey', [
+        ('p_partkey', 'int4'), ('p_name', 'varchar(55)'),
+        ('p_mfgr', 'char(25)'), ('p_brand', 'char(10)'),
+        ('p_type', 'varchar(25)'), ('p_size', 'int4'),
+        ('p_container', 'char(10)'), ('p_retailprice', 'numeric(15,2)'),
+        ('p_comment', 'varchar(23)')]),
+    ('supplier', 's', 's_suppkey', [
+        ('s_suppkey', 'int4'), ('s_name', 'char(25)'),
+        ('s_address', 'varchar(40)'), ('s_nationkey', 'int4'),
+        ('s_phone', 'char(15)'), ('s_acctbal', 'numeric(15,2)'),
+        ('s_comment', 'varchar(101)')]),
+    ('partsupp', 'S', 'ps_partkey', [
+        ('ps_partkey', 'int4'), ('ps_suppkey', 'int4'),
+        ('ps_availqty', 'int4'), ('ps_supplycost', 'numeric(15,2)'),
+        ('ps_comment', 'varchar(199)')]),
+    ('customer', 'c', 'c_custkey', [
+        ('c_custkey', 'int4'), ('c_name', 'varchar(25)'),
+        ('c_address', 'varchar(40)'), ('c_nationkey', 'int4'),
+        ('c_phone', 'char(15)'), ('c_acctbal', 'numeric(15,2)'),
+        ('c_mktsegment', 'char(10)'), ('c_comment', 'varchar(117)')]),
+    ('orders', 'O', 'o_orderkey', [
+        ('o_orderkey', 'int8'), ('o_custkey', 'int4'),
+        ('o_orderstatus', 'char(1)'), ('o_totalprice', 'numeric(15,2)'),
+        ('o_orderdate', 'date'), ('o_orderpriority', 'char(15)'),
+        ('o_clerk', 'char(15)'), ('o_shippriority', 'int4'),
+        ('o_comment', 'varchar(79)')]),
+    ('lineitem', 'L', 'l_orderkey', [
+        ('l_orderkey', 'int8'), ('l_partkey', 'int4'),
+        ('l_suppkey', 'int4'), ('l_linenumber', 'int4'),
+        ('l_quantity', 'numeric(15,2)'),
+        ('l_extendedprice', 'numeric(15,2)'),
+        ('l_discount', 'numeric(15,2)'), ('l_tax', 'numeric(15,2)'),
+        ('l_returnflag', 'char(1)'), ('l_linestatus', 'char(1)'),
+        ('l_shipdate', 'date'), ('l_commitdate', 'date'),
+        ('l_receiptdate', 'date'), ('l_shipinstruct', 'char(25)'),
+        ('l_shipmode', 'char(10)'), ('l_comment', 'varchar(44)')]),
+]
+
+# nation and region have a fixed size, and dbgen can't split them
+UNSPLIT_TABLES = ['n', 'r']
+
+OPTIMIZERS = [('orca', 'SET optimizer = on'),
+              ('planner', 'SET optimizer = off')]
+
+# Differences smaller than this are noise, however large relatively
+MIN_REGRESSION_MS = 100.0
+
+def psql(sql, stdin=None):
+    args = ['psql', '-X', '-q', '-A', '-t', '-v', 'ON_ERROR_STOP=1']
+    if stdin is None:
+        args += ['-c', sql]
+    proc = subprocess.Popen(args, stdin=subprocess.PIPE,
+                            stdout=subprocess.PIPE, stderr=subprocess.PIPE,
+                            universal_newlines=True)
+    out, err = proc.communicate(stdin)
+    return proc.returncode, out, err
+
+def psql_or_die(sql):
+    rc, out, err = psql(sql)
+    if rc != 0:
+        sys.exit('psql failed: %s\n%s' % (sql, err))
+    return out
+
+def generate(dbgen, scale, datadir):
+    '''Run dbgen in parallel, one chunk of each table per process.'''
+    dists = os.path.join(os.path.dirname(os.path.abspath(dbgen)), 'dists.dss')
+    nchunks = multiprocessing.cpu_count() if scale >= 1 else 1
+    commands = []
+    for _, letter, _, _ in TABLES:
+        base = [dbgen, '-q', '-f', '-b', dists, '-s', str(scale), '-T', letter]
+        if letter in UNSPLIT_TABLES or nchunks == 1:
+            commands.append(base)
+        else:
+            commands += [base + ['-C', str(nchunks), '-S', str(i)]
+                         for i in range(1, nchunks + 1)]
+    running = []
+    while commands or running:
+        while commands and len(running) < nchunks:
+            running.append(subprocess.Popen(commands.pop(0), cwd=datadir))
+        proc = running.pop(0)
+        if proc.wait() != 0:
+            sys.exit('dbgen failed')
+
+def load(dbgen, scale, storage):
+    if 'MASTER_DATA_DIRECTORY' not in os.environ:
+        sys.exit('MASTER_DATA_DIRECTORY is not set')
+    datadir = os.path.join(os.environ['MASTER_DATA_DIRECTORY'], 'tpchdata')
+    port = int(os.environ.get('GPFDIST_PORT', '9001'))
+    if not os.path.isdir(datadir):
+        os.makedirs(datadir)
+    for f in glob.glob(os.path.join(datadir, '*.tbl*')):
+        os.remove(f)
+
+    start = time.time()
+    generate(dbgen, scale, datadir)
+    print(json.dumps({'suite': 'tpch_load', 'benchmark': 'dbgen',
+                      'param': scale,
+                      'runtime_ms': (time.time() - start) * 1000.0},
+                     sort_keys=True))
+    sys.stdout.flush()
+
+    gpfdist = subprocess.Popen(['gpfdist', '-d', datadir, '-p', str(port),
+                                '-l', os.path.join(datadir, 'gpfdist.log')])
+    try:
+        time.sleep(2)
+        with_clause = ' WITH (%s)' % storage if storage else ''
+        for table, _, key, columns in TABLES:
+            names = ', '.join(c[0] for c in columns)
+            defs = ', '.join('%s %s' % c for c in columns)
+            # dbgen ends every line with a delimiter, hence the extra column
+            psql_or_die(
+                'DROP TABLE IF EXISTS %s; '
+                'DROP EXTERNAL TABLE IF EXISTS ext_%s; '
+                'CREATE TABLE %s (%s)%s DISTRIBUTED BY (%s); '
+                "CREATE EXTERNAL TABLE ext_%s (%s, dbgen_end text) "
+                "LOCATION ('gpfdist://%s:%d/%s.tbl*') "
+                "FORMAT 'TEXT' (DELIMITER '|')"
+                % (table, table, table, defs, with_clause, key,
+                   table, defs, socket.gethostname(), port, table))
+            start = time.time()
+            psql_or_die('INSERT INTO %s SELECT %s FROM ext_%s'
+                        % (table, names, table))
+            print(json.dumps({'suite': 'tpch_load', 'benchmark': table,
+                              'param': scale,
+                              'runtime_ms': (time.time() - start) * 1000.0},
+                             sort_keys=True))
+            sys.stdout.flush()
+            psql_or_die('DROP EXTERNAL TABLE ext_%s; ANALYZE %s'
+                        % (table, table))
+    finally:
+        gpfdist.terminate()
+        gpfdist.wait()
+
+def runtime_ms(setting, query, repeat):
+    '''Best runtime of a query out of repeat runs, as psql times it.'''
+    best = None
+    for _ in range(repeat):
+        rc, out, err = psql(None, '%s;\n\\o /dev/null\n\\timing on\n%s\n'
+                            % (setting, query))
+        if rc != 0:
+            return None, err.strip()
+        m = re.findall(r'^Time: (\d+\.\d+) ms', out, re.M)
+        if not m:
+            return None, 'no timing in psql output'
+        if best is None or float(m[-1]) < best:
+            best = float(m[-1])
+    return best, None
+
+def normalize_plan(plan):
+    '''The shape of a plan, without the estimates that change with stats.'''
+    plan = re.sub(r'\(cost=[^)]*\)', '', plan)
+    return '\n'.join(line.rstrip() for line in plan.splitlines()
+                     if not line.startswith(('Settings:', 'Optimizer status:')))
+
+def run(repeat, query_dir):
+    queries = sorted(glob.glob(os.path.join(query_dir, '*.sql')))
+    if not queries:
+        sys.exit('no queries in %s' % query_dir)
+    for param, setting in OPTIMIZERS:
+        plan_dir = os.path.join('plans', param)
+        if not os.path.isdir(plan_dir):
+            os.makedirs(plan_dir)
+        for path in queries:
+            name = os.path.splitext(os.path.basename(path))[0]
+            with open(path, 'r') as f:
+                query = f.read().strip()
+            result = {'suite': 'tpch', 'benchmark': name, 'param': param}
+
+            rc, plan, err = psql('%s; EXPLAIN %s' % (setting, query))
+            if rc == 0:
+                with open(os.path.join(plan_dir, name + '.txt'), 'w') as f:
+                    f.write(plan)
+                result['plan_hash'] = hashlib.md5(
+                    normalize_plan(plan).encode('utf-8')).hexdigest()
+                result['fallback'] = (param == 'orca' and
+                                      'legacy query optimizer' in plan)
+
+            result['runtime_ms'], error = runtime_ms(setting, query, repeat)
+            if error is not None:
+                result['error'] = error
+            print(json.dumps(result, sort_keys=True))
+            sys.stdout.flush()
+
+def load_results(results_file):
+    results = {}
+    with open(results_file, 'r') as f:
+        for line in f:
+            if line.startswith('{'):
+                r = json.loads(line)
+                results[(r['suite'], r['benchmark'], str(r['param']))] = r
+    return results
+
+def compare(baseline_file, current_file, threshold):
+    baseline = load_results(baseline_file)
+    current = load_results(current_file)
+    regressions = 0
+    for key in sorted(baseline):
+        old = baseline[key]
+        new = current.get(key)
+        if new is None:
+            print('%s %s %s: missing' % key)
+            regressions += 1
+            continue
+        if old.get('runtime_ms') is not None and new.get('runtime_ms') is None:
+            print('%s %s %s: ' % key + 'failed: %s' % new.get('error'))
+            regressions += 1
+            continue
+        if not old.get('fallback') and new.get('fallback'):
+            print('%s %s %s: ' % key + 'falls back to the planner')
+            regressions += 1
+        if old.get('plan_hash') != new.get('plan_hash'):
+            print('%s %s %s: ' % key + 'plan changed')
+        if old.get('runtime_ms') is None or new.get('runtime_ms') is None:
+            continue
+        if (new['runtime_ms'] > old['runtime_ms'] * (1 + threshold) and
+                new['runtime_ms'] - old['runtime_ms'] > MIN_REGRESSION_MS):
+            print('%s %s %s: ' % key +
+                  'runtime_ms went from %.3f to %.3f' %
+                  (old['runtime_ms'], new['runtime_ms']))
+            regressions += 1
+    print('%d regression(s) out of %d benchmarks' %
+          (regressions, len(baseline)))
+    return 1 if regressions else 0
+
+def main(argv):
+    here = os.path.dirname(os.path.abspath(__file__))
+    if len(argv) >= 4 and argv[1] == 'load':
+        load(argv[2], float(argv[3]), argv[4] if len(argv) > 4 else None)
+    elif len(argv) >= 2 and argv[1] == 'run':
+        run(int(argv[2]) if len(argv) > 2 else 3,
+            argv[3] if len(argv) > 3 else os.path.join(here, 'tpch'))
+    elif len(argv) >= 4 and argv[1] == 'compare':
+        return compare(argv[2], argv[3],
+                       float(argv[4]) if len(argv) > 4 else 0.1)
+    else:
+        sys.exit(__doc__)
+    return 0
+
+if __name__ == '__main__':
+    sys.exit(main(sys.argv))
@@ -0,0 +1,41 @@
+-- Run by the ic_tcp_conn_cache test in a session using the TCP interconnect,
+-- with gp_interconnect_tcp_conn_cache_size = 8.
+SET search_path = ic_tcp_conn_cache;
+SHOW gp_interconnect_type;
+SHOW gp_interconnect_tcp_conn_cache_size;
+
+-- Later statements register their motions on the connections kept by
+-- earlier ones, also when the motion layout changes between statements.
+SELECT count(*) FROM t1 JOIN t2 ON t1.b = t2.a;
+SELECT count(*) FROM t1 JOIN t2 ON t1.b = t2.a;
+SELECT b % 5 AS r, count(*) FROM t1 GROUP BY 1 ORDER BY 1;
+SELECT count(*) FROM t1 x JOIN t1 y ON x.b = y.b JOIN t2 z ON y.a = z.b;
+SELECT count(*) FROM t1 JOIN t2 ON t1.b = t2.a;
+
+-- A cache smaller than a statement needs, then none at all, then back.
+SET gp_interconnect_tcp_conn_cache_size = 1;
+SELECT count(*) FROM t1 x JOIN t1 y ON x.b = y.b JOIN t2 z ON y.a = z.b;
+SELECT count(*) FROM t1 JOIN t2 ON t1.b = t2.a;
+SET gp_interconnect_tcp_conn_cache_size = 0;
+SELECT count(*) FROM t1 JOIN t2 ON t1.b = t2.a;
+SET gp_interconnect_tcp_conn_cache_size = 8;
+SELECT count(*) FROM t1 JOIN t2 ON t1.b = t2.a;
+SELECT count(*) FROM t1 JOIN t2 ON t1.b = t2.a;
+
+-- Peer failure: a QE on seg0 exits right after setting up its interconnect.
+-- The connections cached towards the lost gang must not be used again.
+SELECT gp_inject_fault('qe_got_snapshot_and_interconnect', 'fatal', 2);
+SELECT count(*) FROM t1 JOIN t2 ON t1.b = t2.a;
+SELECT gp_inject_fault('qe_got_snapshot_and_interconnect', 'reset', 2);
+SELECT count(*) FROM t1 JOIN t2 ON t1.b = t2.a;
+SELECT count(*) FROM t1 x JOIN t1 y ON x.b = y.b JOIN t2 z ON y.a = z.b;
+
+-- Gang teardown: idle gangs are destroyed together with the connections
+-- cached on them, and the next statements start from new gangs.
+SET gp_vmem_idle_resource_timeout = 1;
+\! sleep 0.5
+SELECT count(*) FROM t1 JOIN t2 ON t1.b = t2.a;
+\! sleep 0.5
+SELECT b % 5 AS r, count(*) FROM t1 GROUP BY 1 ORDER BY 1;
+RESET gp_vmem_idle_resource_timeout;
+SELECT count(*) FROM t1 JOIN t2 ON t1.b = t2.a;
@@ -0,0 +1,147 @@
+--
+-- Append-only compaction copying blocks without deleted rows as they are
+-- (gp_appendonly_compaction_copy_blocks). The same tables are compacted
+-- with the GUC on and then off, with the same results.
+--
+
+SET gp_appendonly_compaction_copy_blocks = on;
+CREATE TABLE cc_plain (a int, b text) WITH (appendonly=true) DISTRIBUTED BY (a);
+INSERT INTO cc_plain SELECT i, 'v' || i || repeat('w', i % 20) FROM generate_series(1, 100000) i;
+CREATE TABLE cc_zlib (a int, b text) WITH (appendonly=true, compresstype=zlib, compresslevel=1, checksum=true) DISTRIBUTED BY (a);
+INSERT INTO cc_zlib SELECT i, 'v' || i || repeat('w', i % 20) FROM generate_series(1, 100000) i;
+CREATE TABLE cc_small (a int, b text) WITH (appendonly=true, blocksize=8192) DISTRIBUTED BY (a);
+INSERT INTO cc_small SELECT i, 'v' || i || repeat('w', i % 20) FROM generate_series(1, 100000) i;
+-- cc_plain: deletes in the first half only, so the blocks of the second half
+-- are copied.
+DELETE FROM cc_plain WHERE a <= 50000 AND a % 10 < 3;
+VACUUM cc_plain;
+SELECT count(*), sum(a), sum(length(b)) FROM cc_plain;
+SELECT a, b FROM cc_plain WHERE a IN (1, 3, 4, 49999, 50001, 77777, 99999, 100000, 100001) ORDER BY a;
+-- Index scans, through a block directory built from the copied blocks
+CREATE INDEX cc_plain_a ON cc_plain (a);
+SET enable_seqscan = off;
+SELECT a, b FROM cc_plain WHERE a = 4;
+SELECT a, b FROM cc_plain WHERE a = 50001;
+SELECT a, b FROM cc_plain WHERE a = 77777;
+SELECT count(*) FROM cc_plain WHERE a BETWEEN 49990 AND 50010;
+RESET enable_seqscan;
+DROP INDEX cc_plain_a;
+-- Compact the copied blocks again, then append
+DELETE FROM cc_plain WHERE a > 90000;
+VACUUM cc_plain;
+INSERT INTO cc_plain SELECT i, 'v' || i || repeat('w', i % 20) FROM generate_series(100001, 101000) i;
+SELECT count(*), sum(a), sum(length(b)) FROM cc_plain;
+SELECT a, b FROM cc_plain WHERE a IN (1, 3, 4, 49999, 50001, 77777, 99999, 100000, 100001) ORDER BY a;
+-- cc_zlib
+DELETE FROM cc_zlib WHERE a <= 50000 AND a % 10 < 3;
+VACUUM cc_zlib;
+SELECT count(*), sum(a), sum(length(b)) FROM cc_zlib;
+SELECT a, b FROM cc_zlib WHERE a IN (1, 3, 4, 49999, 50001, 77777, 99999, 100000, 100001) ORDER BY a;
+-- Index scans, through a block directory built from the copied blocks
+CREATE INDEX cc_zlib_a ON cc_zlib (a);
+SET enable_seqscan = off;
+SELECT a, b FROM cc_zlib WHERE a = 4;
+SELECT a, b FROM cc_zlib WHERE a = 50001;
+SELECT a, b FROM cc_zlib WHERE a = 77777;
+SELECT count(*) FROM cc_zlib WHERE a BETWEEN 49990 AND 50010;
+RESET enable_seqscan;
+DROP INDEX cc_zlib_a;
+-- Compact the copied blocks again, then append
+DELETE FROM cc_zlib WHERE a > 90000;
+VACUUM cc_zlib;
+INSERT INTO cc_zlib SELECT i, 'v' || i || repeat('w', i % 20) FROM generate_series(100001, 101000) i;
+SELECT count(*), sum(a), sum(length(b)) FROM cc_zlib;
+SELECT a, b FROM cc_zlib WHERE a IN (1, 3, 4, 49999, 50001, 77777, 99999, 100000, 100001) ORDER BY a;
+-- cc_small
+DELETE FROM cc_small WHERE a <= 50000 AND a % 10 < 3;
+VACUUM cc_small;
+SELECT count(*), sum(a), sum(length(b)) FROM cc_small;
+SELECT a, b FROM cc_small WHERE a IN (1, 3, 4, 49999, 50001, 77777, 99999, 100000, 100001) ORDER BY a;
+-- Index scans, through a block directory built from the copied blocks
+CREATE INDEX cc_small_a ON cc_small (a);
+SET enable_seqscan = off;
+SELECT a, b FROM cc_small WHERE a = 4;
+SELECT a, b FROM cc_small WHERE a = 50001;
+SELECT a, b FROM cc_small WHERE a = 77777;
+SELECT count(*) FROM cc_small WHERE a BETWEEN 49990 AND 50010;
+RESET enable_seqscan;
+DROP INDEX cc_small_a;
+-- Compact the copied blocks again, then append
+DELETE FROM cc_small WHERE a > 90000;
+VACUUM cc_small;
+INSERT INTO cc_small SELECT i, 'v' || i || repeat('w', i % 20) FROM generate_series(100001, 101000) i;
+SELECT count(*), sum(a), sum(length(b)) FROM cc_small;
+SELECT a, b FROM cc_small WHERE a IN (1, 3, 4, 49999, 50001, 77777, 99999, 100000, 100001) ORDER BY a;
+DROP TABLE cc_plain, cc_zlib, cc_small;
+
+SET gp_appendonly_compaction_copy_blocks = off;
+CREATE TABLE cc_plain (a int, b text) WITH (appendonly=true) DISTRIBUTED BY (a);
+INSERT INTO cc_plain SELECT i, 'v' || i || repeat('w', i % 20) FROM generate_series(1, 100000) i;
+CREATE TABLE cc_zlib (a int, b text) WITH (appendonly=true, compresstype=zlib, compresslevel=1, checksum=true) DISTRIBUTED BY (a);
+INSERT INTO cc_zlib SELECT i, 'v' || i || repeat('w', i % 20) FROM generate_series(1, 100000) i;
+CREATE TABLE cc_small (a int, b text) WITH (appendonly=true, blocksize=8192) DISTRIBUTED BY (a);
+INSERT INTO cc_small SELECT i, 'v' || i || repeat('w', i % 20) FROM generate_series(1, 100000) i;
+-- cc_plain: deletes in the first half only, so the blocks of the second half
+-- are copied.
+DELETE FROM cc_plain WHERE a <= 50000 AND a % 10 < 3;
+VACUUM cc_plain;
+SELECT count(*), sum(a), sum(length(b)) FROM cc_plain;
+SELECT a, b FROM cc_plain WHERE a IN (1, 3, 4, 49999, 50001, 77777, 99999, 100000, 100001) ORDER BY a;
+-- Index scans, through a block directory built from the copied blocks
+CREATE INDEX cc_plain_a ON cc_plain (a);
+SET enable_seqscan = off;
+SELECT a, b FROM cc_plain WHERE a = 4;
+SELECT a, b FROM cc_plain WHERE a = 50001;
+SELECT a, b FROM cc_plain WHERE a = 77777;
+SELECT count(*) FROM cc_plain WHERE a BETWEEN 49990 AND 50010;
+RESET enable_seqscan;
+DROP INDEX cc_plain_a;
+-- Compact the copied blocks again, then append
+DELETE FROM cc_plain WHERE a > 90000;
+VACUUM cc_plain;
+INSERT INTO cc_plain SELECT i, 'v' || i || repeat('w', i % 20) FROM generate_series(100001, 101000) i;
+SELECT count(*), sum(a), sum(length(b)) FROM cc_plain;
+SELECT a, b FROM cc_plain WHERE a IN (1, 3, 4, 49999, 50001, 77777, 99999, 100000, 100001) ORDER BY a;
+-- cc_zlib
+DELETE FROM cc_zlib WHERE a <= 50000 AND a % 10 < 3;
+VACUUM cc_zlib;
+SELECT count(*), sum(a), sum(length(b)) FROM cc_zlib;
+SELECT a, b FROM cc_zlib WHERE a IN (1, 3, 4, 49999, 50001, 77777, 99999, 100000, 100001) ORDER BY a;
+-- Index scans, through a block directory built from the copied blocks
+CREATE INDEX cc_zlib_a ON cc_zlib (a);
+SET enable_seqscan = off;
+SELECT a, b FROM cc_zlib WHERE a = 4;
+SELECT a, b FROM cc_zlib WHERE a = 50001;
+SELECT a, b FROM cc_zlib WHERE a = 77777;
+SELECT count(*) FROM cc_zlib WHERE a BETWEEN 49990 AND 50010;
+RESET enable_seqscan;
+DROP INDEX cc_zlib_a;
+-- Compact the copied blocks again, then append
+DELETE FROM cc_zlib WHERE a > 90000;
+VACUUM cc_zlib;
+INSERT INTO cc_zlib SELECT i, 'v' || i || repeat('w', i % 20) FROM generate_series(100001, 101000) i;
+SELECT count(*), sum(a), sum(length(b)) FROM cc_zlib;
+SELECT a, b FROM cc_zlib WHERE a IN (1, 3, 4, 49999, 50001, 77777, 99999, 100000, 100001) ORDER BY a;
+-- cc_small
+DELETE FROM cc_small WHERE a <= 50000 AND a % 10 < 3;
+VACUUM cc_small;
+SELECT count(*), sum(a), sum(length(b)) FROM cc_small;
+SELECT a, b FROM cc_small WHERE a IN (1, 3, 4, 49999, 50001, 77777, 99999, 100000, 100001) ORDER BY a;
+-- Index scans, through a block directory built from the copied blocks
+CREATE INDEX cc_small_a ON cc_small (a);
+SET enable_seqscan = off;
+SELECT a, b FROM cc_small WHERE a = 4;
+SELECT a, b FROM cc_small WHERE a = 50001;
+SELECT a, b FROM cc_small WHERE a = 77777;
+SELECT count(*) FROM cc_small WHERE a BETWEEN 49990 AND 50010;
+RESET enable_seqscan;
+DROP INDEX cc_small_a;
+-- Compact the copied blocks again, then append
+DELETE FROM cc_small WHERE a > 90000;
+VACUUM cc_small;
+INSERT INTO cc_small SELECT i, 'v' || i || repeat('w', i % 20) FROM generate_series(100001, 101000) i;
+SELECT count(*), sum(a), sum(length(b)) FROM cc_small;
+SELECT a, b FROM cc_small WHERE a IN (1, 3, 4, 49999, 50001, 77777, 99999, 100000, 100001) ORDER BY a;
+DROP TABLE cc_plain, cc_zlib, cc_small;
+
+RESET gp_appendonly_compaction_copy_blocks;
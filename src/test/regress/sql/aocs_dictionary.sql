@@ -0,0 +1,67 @@
+--
+-- Tests for dictionary encoded blocks of variable-length RLE_TYPE columns of
+-- column-oriented tables (gp_appendonly_dictionary_encoding).
+--
+CREATE SCHEMA aocs_dictionary;
+SET search_path = aocs_dictionary;
+
+-- few: a handful of values and no runs; nulls: NULLs between repeated
+-- values; runs: long runs of one value; uniq: no repeats, so a dictionary
+-- never pays off.
+CREATE TABLE dict_src (id int, few text, nulls text, runs text, uniq text)
+  DISTRIBUTED BY (id);
+INSERT INTO dict_src SELECT i, 'value number ' || (i % 7),
+  CASE WHEN i % 3 = 0 THEN NULL ELSE 'sometimes null ' || (i % 5) END,
+  'run ' || (i / 100), md5(i::text)
+  FROM generate_series(1, 20000) i;
+
+-- Off by default: only plain blocks.
+SHOW gp_appendonly_dictionary_encoding;
+CREATE TABLE dict_off (id int, few text, nulls text, runs text, uniq text)
+  WITH (appendonly=true, orientation=column, compresstype=rle_type)
+  DISTRIBUTED BY (id);
+INSERT INTO dict_off SELECT * FROM dict_src;
+
+SET gp_appendonly_dictionary_encoding = on;
+CREATE TABLE dict_on (id int, few text, nulls text, runs text, uniq text)
+  WITH (appendonly=true, orientation=column, compresstype=rle_type)
+  DISTRIBUTED BY (id);
+INSERT INTO dict_on SELECT * FROM dict_src;
+
+-- The few and nulls columns got dictionary encoded blocks.
+SELECT pg_relation_size('dict_on') < pg_relation_size('dict_off') AS smaller;
+
+-- A table with dictionary encoded and plain blocks of the same columns.
+CREATE TABLE dict_mixed (id int, few text, nulls text, runs text, uniq text)
+  WITH (appendonly=true, orientation=column, compresstype=rle_type)
+  DISTRIBUTED BY (id);
+INSERT INTO dict_mixed SELECT * FROM dict_src WHERE id <= 10000;
+SET gp_appendonly_dictionary_encoding = off;
+INSERT INTO dict_mixed SELECT * FROM dict_src WHERE id > 10000;
+
+-- Every table reads back what was written, whatever the setting.
+SELECT count(*) FROM (SELECT * FROM dict_off EXCEPT ALL SELECT * FROM dict_src) d;
+SELECT count(*) FROM (SELECT * FROM dict_on EXCEPT ALL SELECT * FROM dict_src) d;
+SELECT count(*) FROM (SELECT * FROM dict_src EXCEPT ALL SELECT * FROM dict_on) d;
+SELECT count(*) FROM (SELECT * FROM dict_mixed EXCEPT ALL SELECT * FROM dict_src) d;
+SELECT count(*) FROM (SELECT * FROM dict_src EXCEPT ALL SELECT * FROM dict_mixed) d;
+
+-- Quals on dictionary encoded columns, including NULLs.
+SELECT count(*) FROM dict_on WHERE few = 'value number 3';
+SELECT count(*) FROM dict_on WHERE few IN ('value number 1', 'value number 2');
+SELECT count(*) FROM dict_on WHERE nulls IS NULL;
+SELECT count(*) FROM dict_on WHERE nulls = 'sometimes null 1';
+SELECT count(*) FROM dict_on WHERE nulls <> 'sometimes null 1';
+SELECT count(*) FROM dict_on WHERE few = 'value number 3' AND nulls IS NOT NULL;
+SELECT count(DISTINCT runs) FROM dict_on;
+SELECT count(*) FROM dict_mixed WHERE few = 'value number 3';
+SELECT count(*) FROM dict_mixed WHERE nulls IS NULL;
+SELECT count(*) FROM dict_mixed WHERE few = 'value number 3' AND nulls IS NOT NULL;
+
+-- Single rows read back out of the middle of the blocks.
+SELECT * FROM dict_on WHERE id IN (1, 3, 9999, 15000) ORDER BY id;
+SELECT * FROM dict_mixed WHERE id IN (1, 3, 9999, 15000) ORDER BY id;
+
+RESET gp_appendonly_dictionary_encoding;
+DROP TABLE dict_src, dict_off, dict_on, dict_mixed;
+DROP SCHEMA aocs_dictionary;
@@ -0,0 +1,82 @@
+--
+-- Late materialization in scans of column-oriented tables
+-- (gp_appendonly_late_materialization): columns that only the output
+-- needs are read just for the rows that pass the quals. Every query runs
+-- with it on and then off, with the same results.
+--
+
+CREATE TABLE late_mat (a int, b int, c text ENCODING (compresstype=zlib), d numeric,
+                       e int ENCODING (compresstype=rle_type))
+  WITH (appendonly=true, orientation=column, blocksize=8192) DISTRIBUTED BY (a);
+INSERT INTO late_mat
+  SELECT i,
+         CASE WHEN i % 777 = 0 THEN NULL ELSE i % 100 END,
+         CASE WHEN i % 555 = 0 THEN NULL ELSE repeat('x', i % 50) || i END,
+         i % 1000,
+         i / 1000
+  FROM generate_series(1, 100000) i;
+
+SET gp_appendonly_late_materialization = on;
+SELECT count(*), sum(a), sum(length(c)), sum(d) FROM late_mat WHERE b = 7;
+SELECT count(*), sum(e) FROM late_mat WHERE b IS NULL;
+SELECT a, b, c, d, e FROM late_mat WHERE a % 10007 = 0 ORDER BY a;
+SELECT count(*), sum(a) FROM late_mat WHERE b < 0;
+SELECT count(*), sum(length(c)) FROM late_mat WHERE b >= 0;
+SELECT count(*), sum(d) FROM late_mat WHERE b = 3 AND random() < 2;
+SELECT count(*), sum(a), sum(e) FROM late_mat WHERE length(c) = 49 + length(a::text);
+SET gp_appendonly_late_materialization = off;
+SELECT count(*), sum(a), sum(length(c)), sum(d) FROM late_mat WHERE b = 7;
+SELECT count(*), sum(e) FROM late_mat WHERE b IS NULL;
+SELECT a, b, c, d, e FROM late_mat WHERE a % 10007 = 0 ORDER BY a;
+SELECT count(*), sum(a) FROM late_mat WHERE b < 0;
+SELECT count(*), sum(length(c)) FROM late_mat WHERE b >= 0;
+SELECT count(*), sum(d) FROM late_mat WHERE b = 3 AND random() < 2;
+SELECT count(*), sum(a), sum(e) FROM late_mat WHERE length(c) = 49 + length(a::text);
+
+-- Deleted rows
+DELETE FROM late_mat WHERE a % 3 = 0;
+SET gp_appendonly_late_materialization = on;
+SELECT count(*), sum(a), sum(length(c)), sum(d) FROM late_mat WHERE b = 7;
+SELECT count(*), sum(e) FROM late_mat WHERE b IS NULL;
+SELECT a, b, c, d, e FROM late_mat WHERE a % 10007 = 0 ORDER BY a;
+SELECT count(*), sum(a) FROM late_mat WHERE b < 0;
+SELECT count(*), sum(length(c)) FROM late_mat WHERE b >= 0;
+SELECT count(*), sum(d) FROM late_mat WHERE b = 3 AND random() < 2;
+SELECT count(*), sum(a), sum(e) FROM late_mat WHERE length(c) = 49 + length(a::text);
+SET gp_appendonly_late_materialization = off;
+SELECT count(*), sum(a), sum(length(c)), sum(d) FROM late_mat WHERE b = 7;
+SELECT count(*), sum(e) FROM late_mat WHERE b IS NULL;
+SELECT a, b, c, d, e FROM late_mat WHERE a % 10007 = 0 ORDER BY a;
+SELECT count(*), sum(a) FROM late_mat WHERE b < 0;
+SELECT count(*), sum(length(c)) FROM late_mat WHERE b >= 0;
+SELECT count(*), sum(d) FROM late_mat WHERE b = 3 AND random() < 2;
+SELECT count(*), sum(a), sum(e) FROM late_mat WHERE length(c) = 49 + length(a::text);
+
+-- Rows moved to another segment file, a column added later, and rows
+-- appended after that.
+VACUUM late_mat;
+ALTER TABLE late_mat ADD COLUMN f int DEFAULT 5;
+INSERT INTO late_mat
+  SELECT i, i % 100, repeat('y', i % 50) || i, i % 1000, i / 1000, i
+  FROM generate_series(100001, 120000) i;
+SET gp_appendonly_late_materialization = on;
+SELECT count(*), sum(a), sum(length(c)), sum(d) FROM late_mat WHERE b = 7;
+SELECT count(*), sum(e) FROM late_mat WHERE b IS NULL;
+SELECT a, b, c, d, e, f FROM late_mat WHERE a % 10007 = 0 ORDER BY a;
+SELECT count(*), sum(a) FROM late_mat WHERE b < 0;
+SELECT count(*), sum(length(c)) FROM late_mat WHERE b >= 0;
+SELECT count(*), sum(d) FROM late_mat WHERE b = 3 AND random() < 2;
+SELECT count(*), sum(a), sum(e) FROM late_mat WHERE length(c) = 49 + length(a::text);
+SELECT count(*), sum(f), sum(a) FROM late_mat WHERE b = 7;
+SET gp_appendonly_late_materialization = off;
+SELECT count(*), sum(a), sum(length(c)), sum(d) FROM late_mat WHERE b = 7;
+SELECT count(*), sum(e) FROM late_mat WHERE b IS NULL;
+SELECT a, b, c, d, e, f FROM late_mat WHERE a % 10007 = 0 ORDER BY a;
+SELECT count(*), sum(a) FROM late_mat WHERE b < 0;
+SELECT count(*), sum(length(c)) FROM late_mat WHERE b >= 0;
+SELECT count(*), sum(d) FROM late_mat WHERE b = 3 AND random() < 2;
+SELECT count(*), sum(a), sum(e) FROM late_mat WHERE length(c) = 49 + length(a::text);
+SELECT count(*), sum(f), sum(a) FROM late_mat WHERE b = 7;
+
+RESET gp_appendonly_late_materialization;
+DROP TABLE late_mat;
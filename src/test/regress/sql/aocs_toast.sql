@@ -0,0 +1,75 @@
+--
+-- Out-of-line storage of wide values in column-oriented tables
+--
+-- Counts the values stored in a table's TOAST relation, on all segments.
+CREATE FUNCTION aocs_toast_values(rel regclass) RETURNS bigint AS $$
+DECLARE
+  toastname text;
+  n bigint;
+BEGIN
+  SELECT t.relname INTO toastname FROM pg_class c, pg_class t
+    WHERE c.oid = rel AND t.oid = c.reltoastrelid;
+  EXECUTE 'SELECT count(DISTINCT gp_segment_id::text || '':'' || chunk_id::text) FROM gp_dist_random('
+    || quote_literal('pg_toast.' || toastname) || ')' INTO n;
+  RETURN n;
+END;
+$$ LANGUAGE plpgsql;
+-- Drops a table and checks that its TOAST relation went with it.
+CREATE FUNCTION aocs_toast_drop(rel text) RETURNS boolean AS $$
+DECLARE
+  toastname text;
+  before bigint;
+  after bigint;
+BEGIN
+  SELECT t.relname INTO toastname FROM pg_class c, pg_class t
+    WHERE c.relname = rel AND t.oid = c.reltoastrelid;
+  EXECUTE 'SELECT count(*) FROM gp_dist_random(''pg_class'') WHERE relname = '
+    || quote_literal(toastname) INTO before;
+  EXECUTE 'DROP TABLE ' || rel;
+  EXECUTE 'SELECT count(*) FROM gp_dist_random(''pg_class'') WHERE relname = '
+    || quote_literal(toastname) INTO after;
+  RETURN before > 0 AND after = 0;
+END;
+$$ LANGUAGE plpgsql;
+-- Values stay in the column files unless asked otherwise.
+SHOW gp_appendonly_toast_threshold;
+CREATE TABLE aocs_toast (id int, small text, wide text)
+  WITH (appendonly=true, orientation=column) DISTRIBUTED BY (id);
+INSERT INTO aocs_toast VALUES (0, 'inline', repeat(md5('0'), 1000));
+SELECT aocs_toast_values('aocs_toast');
+-- Above the threshold, only the wide values move out of line.
+SET gp_appendonly_toast_threshold = 1;
+INSERT INTO aocs_toast
+  SELECT i, 'row ' || i, repeat(md5(i::text), 1000) FROM generate_series(1, 10) i;
+SELECT aocs_toast_values('aocs_toast');
+SELECT id, small, length(wide), wide = repeat(md5(id::text), 1000) AS same
+  FROM aocs_toast ORDER BY id;
+SELECT id FROM aocs_toast WHERE wide LIKE md5('7') || '%';
+-- An UPDATE stores its own copy, so every row owns the values it points to.
+UPDATE aocs_toast SET small = 'updated' WHERE id BETWEEN 1 AND 5;
+SELECT aocs_toast_values('aocs_toast');
+-- Compaction deletes the values of the dead rows and keeps the others.
+VACUUM aocs_toast;
+SELECT aocs_toast_values('aocs_toast');
+DELETE FROM aocs_toast WHERE id > 5;
+VACUUM aocs_toast;
+SELECT aocs_toast_values('aocs_toast');
+SELECT id, small, length(wide), wide = repeat(md5(id::text), 1000) AS same
+  FROM aocs_toast ORDER BY id;
+-- Copying rows with the threshold off brings the values back inline.
+RESET gp_appendonly_toast_threshold;
+INSERT INTO aocs_toast SELECT id + 100, small, wide FROM aocs_toast WHERE id > 0;
+SELECT aocs_toast_values('aocs_toast');
+DELETE FROM aocs_toast WHERE id BETWEEN 1 AND 5;
+VACUUM aocs_toast;
+SELECT aocs_toast_values('aocs_toast');
+SELECT id, small, length(wide), wide = repeat(md5((id - 100)::text), 1000) AS same
+  FROM aocs_toast WHERE id > 100 ORDER BY id;
+-- DROP removes the TOAST relation, and the values in it.
+SET gp_appendonly_toast_threshold = 1;
+INSERT INTO aocs_toast VALUES (200, 'dropped', repeat(md5('200'), 1000));
+SELECT aocs_toast_values('aocs_toast');
+SELECT aocs_toast_drop('aocs_toast');
+RESET gp_appendonly_toast_threshold;
+DROP FUNCTION aocs_toast_values(regclass);
+DROP FUNCTION aocs_toast_drop(text);
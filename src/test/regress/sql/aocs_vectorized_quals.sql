@@ -0,0 +1,85 @@
+--
+-- Scan quals of column-oriented tables evaluated a batch at a time
+--
+-- Every query runs with gp_appendonly_vectorized_quals on, then off, and
+-- must give the same result.  The table spans several batches on each
+-- segment, and has NULLs, NaNs and infinities.
+CREATE TABLE aocs_vq (id int, i2 int2, i4 int4, i8 int8, f4 float4, f8 float8, d date, t text)
+  WITH (appendonly=true, orientation=column) DISTRIBUTED BY (id);
+INSERT INTO aocs_vq
+SELECT i,
+       CASE WHEN i % 7 = 0 THEN NULL ELSE (i % 200 - 100)::int2 END,
+       CASE WHEN i % 11 = 0 THEN NULL ELSE i * 700000 END,
+       CASE WHEN i % 13 = 0 THEN NULL ELSE i * 3000000000000000 END,
+       CASE WHEN i % 17 = 0 THEN 'NaN' WHEN i % 19 = 0 THEN NULL ELSE (i / 4.0)::float4 END,
+       CASE WHEN i % 23 = 0 THEN 'NaN' WHEN i % 29 = 0 THEN NULL
+            WHEN i % 31 = 0 THEN '-Infinity' ELSE ((i - 1500) * 0.5)::float8 END,
+       CASE WHEN i % 37 = 0 THEN NULL ELSE date '2000-01-01' + i END,
+       CASE WHEN i % 5 = 0 THEN NULL ELSE 'v' || (i % 3) END
+FROM generate_series(1, 3000) i;
+SET gp_appendonly_vectorized_quals = on;
+SELECT count(*), sum(id) FROM aocs_vq WHERE i2 < 0;
+SELECT count(*), sum(id) FROM aocs_vq WHERE i2 = 50 AND i4 > 1000000000;
+SELECT count(*), sum(id) FROM aocs_vq WHERE i2 + i4 > 1500000000;
+SELECT count(*), sum(id) FROM aocs_vq WHERE i2 * 2::int2 <= -150;
+SELECT count(*), sum(id) FROM aocs_vq WHERE i8 > i4 AND i2 >= i8 - i8;
+SELECT count(*), sum(id) FROM aocs_vq WHERE i4 = i8 / 4285714285;
+SELECT count(*), sum(id) FROM aocs_vq WHERE i8 - 3000000000000000 * id = 0;
+SELECT count(*), sum(id) FROM aocs_vq WHERE f4 > 100;
+SELECT count(*), sum(id) FROM aocs_vq WHERE f4 = 'NaN';
+SELECT count(*), sum(id) FROM aocs_vq WHERE f8 < 0;
+SELECT count(*), sum(id) FROM aocs_vq WHERE f8 <> f8;
+SELECT count(*), sum(id) FROM aocs_vq WHERE f4 <= f8;
+SELECT count(*), sum(id) FROM aocs_vq WHERE f4 * f8 > 1000;
+SELECT count(*), sum(id) FROM aocs_vq WHERE f8 - f4 >= 'Infinity';
+SELECT count(*), sum(id) FROM aocs_vq WHERE d >= '2000-06-01' AND d < '2001-01-01';
+SELECT count(*), sum(id) FROM aocs_vq WHERE d > '2006-01-01' OR d IS NULL;
+SELECT count(*), sum(id) FROM aocs_vq WHERE t IS NULL AND i4 IS NOT NULL;
+SELECT count(*), sum(id) FROM aocs_vq WHERE i4 > 0 AND t = 'v1';
+SELECT count(*), sum(id) FROM aocs_vq WHERE t = 'v1' AND i4 > 0;
+SELECT count(*), sum(id) FROM aocs_vq WHERE i4 + NULL::int4 > 0;
+SELECT id, i2, i4, f4, f8 FROM aocs_vq WHERE id < 40 AND f8 < -600 ORDER BY id;
+-- overflows raise the error of the operator, unless an earlier qual
+-- rejects the row
+SELECT count(*) FROM aocs_vq WHERE i4 * 2 > 0;
+SELECT count(*) FROM aocs_vq WHERE id < 1000 AND i4 * 2 > 0;
+SELECT count(*) FROM aocs_vq WHERE i8 + i8 > 0;
+SELECT count(*) FROM aocs_vq WHERE id <= 1500 AND i8 + i8 > 0;
+SELECT count(*) FROM aocs_vq WHERE i2 * 1000::int2 > 0;
+SELECT count(*) FROM aocs_vq WHERE i2 BETWEEN -32 AND 32 AND i2 * 1000::int2 > 0;
+SELECT count(*) FROM aocs_vq WHERE f8 * 1e308 > 0;
+SELECT count(*) FROM aocs_vq WHERE f8 = '-Infinity' AND f8 * 1e308 > 0;
+SET gp_appendonly_vectorized_quals = off;
+SELECT count(*), sum(id) FROM aocs_vq WHERE i2 < 0;
+SELECT count(*), sum(id) FROM aocs_vq WHERE i2 = 50 AND i4 > 1000000000;
+SELECT count(*), sum(id) FROM aocs_vq WHERE i2 + i4 > 1500000000;
+SELECT count(*), sum(id) FROM aocs_vq WHERE i2 * 2::int2 <= -150;
+SELECT count(*), sum(id) FROM aocs_vq WHERE i8 > i4 AND i2 >= i8 - i8;
+SELECT count(*), sum(id) FROM aocs_vq WHERE i4 = i8 / 4285714285;
+SELECT count(*), sum(id) FROM aocs_vq WHERE i8 - 3000000000000000 * id = 0;
+SELECT count(*), sum(id) FROM aocs_vq WHERE f4 > 100;
+SELECT count(*), sum(id) FROM aocs_vq WHERE f4 = 'NaN';
+SELECT count(*), sum(id) FROM aocs_vq WHERE f8 < 0;
+SELECT count(*), sum(id) FROM aocs_vq WHERE f8 <> f8;
+SELECT count(*), sum(id) FROM aocs_vq WHERE f4 <= f8;
+SELECT count(*), sum(id) FROM aocs_vq WHERE f4 * f8 > 1000;
+SELECT count(*), sum(id) FROM aocs_vq WHERE f8 - f4 >= 'Infinity';
+SELECT count(*), sum(id) FROM aocs_vq WHERE d >= '2000-06-01' AND d < '2001-01-01';
+SELECT count(*), sum(id) FROM aocs_vq WHERE d > '2006-01-01' OR d IS NULL;
+SELECT count(*), sum(id) FROM aocs_vq WHERE t IS NULL AND i4 IS NOT NULL;
+SELECT count(*), sum(id) FROM aocs_vq WHERE i4 > 0 AND t = 'v1';
+SELECT count(*), sum(id) FROM aocs_vq WHERE t = 'v1' AND i4 > 0;
+SELECT count(*), sum(id) FROM aocs_vq WHERE i4 + NULL::int4 > 0;
+SELECT id, i2, i4, f4, f8 FROM aocs_vq WHERE id < 40 AND f8 < -600 ORDER BY id;
+-- overflows raise the error of the operator, unless an earlier qual
+-- rejects the row
+SELECT count(*) FROM aocs_vq WHERE i4 * 2 > 0;
+SELECT count(*) FROM aocs_vq WHERE id < 1000 AND i4 * 2 > 0;
+SELECT count(*) FROM aocs_vq WHERE i8 + i8 > 0;
+SELECT count(*) FROM aocs_vq WHERE id <= 1500 AND i8 + i8 > 0;
+SELECT count(*) FROM aocs_vq WHERE i2 * 1000::int2 > 0;
+SELECT count(*) FROM aocs_vq WHERE i2 BETWEEN -32 AND 32 AND i2 * 1000::int2 > 0;
+SELECT count(*) FROM aocs_vq WHERE f8 * 1e308 > 0;
+SELECT count(*) FROM aocs_vq WHERE f8 = '-Infinity' AND f8 * 1e308 > 0;
+RESET gp_appendonly_vectorized_quals;
+DROP TABLE aocs_vq;
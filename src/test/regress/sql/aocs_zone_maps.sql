@@ -0,0 +1,103 @@
+--
+-- Block directory zone maps of column-oriented tables (gp_appendonly_zone_maps)
+--
+-- Every query runs with gp_appendonly_zone_maps on, then off, and must give
+-- the same result.  The column n only has NULLs in the first half of the
+-- rows, so some blocks have no values at all.
+CREATE SCHEMA aocs_zone_maps;
+SET search_path = aocs_zone_maps;
+SET optimizer = off;
+SET enable_indexscan = off;
+SET enable_bitmapscan = off;
+SHOW gp_appendonly_zone_maps;
+-- Minipages written without zone maps.
+CREATE TABLE zm_old (i2 int2, i4 int4, i8 int8, d date, n int4)
+  WITH (appendonly=true, orientation=column, blocksize=8192) DISTRIBUTED BY (i4);
+CREATE INDEX zm_old_i4 ON zm_old (i4);
+INSERT INTO zm_old SELECT i, i, i, date '2000-01-01' + i, CASE WHEN i > 10000 THEN i END FROM generate_series(1, 20000) i;
+SET gp_appendonly_zone_maps = on;
+-- CREATE INDEX fills in the zones of the rows already there.
+CREATE TABLE zm (i2 int2, i4 int4, i8 int8, d date, n int4)
+  WITH (appendonly=true, orientation=column, blocksize=8192) DISTRIBUTED BY (i4);
+INSERT INTO zm SELECT i, i, i, date '2000-01-01' + i, CASE WHEN i > 10000 THEN i END FROM generate_series(1, 20000) i;
+CREATE INDEX zm_i4 ON zm (i4);
+-- An added column has no zones for the rows that were there before.
+ALTER TABLE zm ADD COLUMN a int4 DEFAULT 7;
+INSERT INTO zm SELECT i, i, i, date '2000-01-01' + i, i, i FROM generate_series(20001, 21000) i;
+-- New rows of zm_old get zones, next to the entries that have none.
+INSERT INTO zm_old SELECT i, i, i, date '2000-01-01' + i, CASE WHEN i > 10000 THEN i END FROM generate_series(20001, 21000) i;
+SELECT count(*) FROM zm WHERE i4 < 5000;
+SELECT count(*) FROM zm WHERE i4 <= 5000;
+SELECT count(*) FROM zm WHERE i4 = 5000;
+SELECT count(*) FROM zm WHERE i4 >= 15000;
+SELECT count(*) FROM zm WHERE i4 > 15000;
+SELECT count(*) FROM zm WHERE i4 > 21000;
+SELECT count(*) FROM zm WHERE i4 < 1;
+SELECT count(*) FROM zm WHERE 5000 > i4;
+SELECT count(*) FROM zm WHERE i4 >= 4000 AND i4 < 5000;
+SELECT count(*) FROM zm WHERE i2 < 5000::int4;
+SELECT count(*) FROM zm WHERE i2 >= 15000::int8;
+SELECT count(*) FROM zm WHERE i2 < 100000;
+SELECT count(*) FROM zm WHERE i4 = 5000::int8;
+SELECT count(*) FROM zm WHERE i4 > 19999::int2;
+SELECT count(*) FROM zm WHERE i8 < 100::int2;
+SELECT count(*) FROM zm WHERE i8 <= 100::int4;
+SELECT count(*) FROM zm WHERE i8 = 20000::int4;
+SELECT count(*) FROM zm WHERE d < '2000-04-10';
+SELECT count(*) FROM zm WHERE d >= '2054-01-01';
+SELECT count(*) FROM zm WHERE n < 15000;
+SELECT count(*) FROM zm WHERE n = 5;
+SELECT count(*) FROM zm WHERE n >= 10001;
+SELECT count(*) FROM zm WHERE n IS NULL;
+SELECT count(*) FROM zm WHERE n > 0 AND i4 <= 12000;
+SELECT count(*) FROM zm WHERE a = 7;
+SELECT count(*) FROM zm WHERE a < 7;
+SELECT count(*) FROM zm WHERE a = 7 AND i4 < 100;
+SELECT count(*) FROM zm WHERE a > 20500;
+SELECT count(*) FROM zm_old WHERE i4 < 5000;
+SELECT count(*) FROM zm_old WHERE i4 > 20500;
+SELECT count(*) FROM zm_old WHERE i2 >= 15000::int8;
+SELECT count(*) FROM zm_old WHERE n < 15000;
+SELECT count(*) FROM zm_old WHERE n IS NULL;
+SELECT count(*) FROM zm_old WHERE d >= '2054-01-01';
+SET gp_appendonly_zone_maps = off;
+SELECT count(*) FROM zm WHERE i4 < 5000;
+SELECT count(*) FROM zm WHERE i4 <= 5000;
+SELECT count(*) FROM zm WHERE i4 = 5000;
+SELECT count(*) FROM zm WHERE i4 >= 15000;
+SELECT count(*) FROM zm WHERE i4 > 15000;
+SELECT count(*) FROM zm WHERE i4 > 21000;
+SELECT count(*) FROM zm WHERE i4 < 1;
+SELECT count(*) FROM zm WHERE 5000 > i4;
+SELECT count(*) FROM zm WHERE i4 >= 4000 AND i4 < 5000;
+SELECT count(*) FROM zm WHERE i2 < 5000::int4;
+SELECT count(*) FROM zm WHERE i2 >= 15000::int8;
+SELECT count(*) FROM zm WHERE i2 < 100000;
+SELECT count(*) FROM zm WHERE i4 = 5000::int8;
+SELECT count(*) FROM zm WHERE i4 > 19999::int2;
+SELECT count(*) FROM zm WHERE i8 < 100::int2;
+SELECT count(*) FROM zm WHERE i8 <= 100::int4;
+SELECT count(*) FROM zm WHERE i8 = 20000::int4;
+SELECT count(*) FROM zm WHERE d < '2000-04-10';
+SELECT count(*) FROM zm WHERE d >= '2054-01-01';
+SELECT count(*) FROM zm WHERE n < 15000;
+SELECT count(*) FROM zm WHERE n = 5;
+SELECT count(*) FROM zm WHERE n >= 10001;
+SELECT count(*) FROM zm WHERE n IS NULL;
+SELECT count(*) FROM zm WHERE n > 0 AND i4 <= 12000;
+SELECT count(*) FROM zm WHERE a = 7;
+SELECT count(*) FROM zm WHERE a < 7;
+SELECT count(*) FROM zm WHERE a = 7 AND i4 < 100;
+SELECT count(*) FROM zm WHERE a > 20500;
+SELECT count(*) FROM zm_old WHERE i4 < 5000;
+SELECT count(*) FROM zm_old WHERE i4 > 20500;
+SELECT count(*) FROM zm_old WHERE i2 >= 15000::int8;
+SELECT count(*) FROM zm_old WHERE n < 15000;
+SELECT count(*) FROM zm_old WHERE n IS NULL;
+SELECT count(*) FROM zm_old WHERE d >= '2054-01-01';
+RESET gp_appendonly_zone_maps;
+RESET optimizer;
+RESET enable_indexscan;
+RESET enable_bitmapscan;
+DROP TABLE zm, zm_old;
+DROP SCHEMA aocs_zone_maps;
@@ -0,0 +1,76 @@
+--
+-- approx_percentile(), from a t-digest, and approx_count_distinct(), from a
+-- HyperLogLog sketch
+--
+CREATE TABLE apx_small (id int, x float8) DISTRIBUTED BY (id);
+INSERT INTO apx_small SELECT i, i FROM generate_series(1, 10) i;
+INSERT INTO apx_small VALUES (11, NULL), (12, 'NaN');
+-- Each of a few values stays a centroid of its own, so the estimates are
+-- interpolated between the values themselves.  NULLs and NaNs are ignored,
+-- except that NaN is one more distinct value.
+SELECT approx_percentile(x, 0) AS p0, approx_percentile(x, 0.25) AS p25,
+  approx_percentile(x, 0.5) AS p50, approx_percentile(x, 0.9) AS p90,
+  approx_percentile(x, 1) AS p100
+  FROM apx_small;
+SELECT approx_count_distinct(x) BETWEEN 10 AND 11 AS ndistinct FROM apx_small;
+-- No values.
+SELECT approx_percentile(x, 0.5), approx_count_distinct(x)
+  FROM apx_small WHERE x IS NULL;
+SELECT approx_percentile(x, 0.5), approx_count_distinct(x)
+  FROM apx_small WHERE id > 100;
+-- Bad arguments.
+SELECT approx_percentile(x, 1.5) FROM (VALUES (1::float8)) v(x);
+SELECT approx_percentile(x, -0.1) FROM (VALUES (1::float8)) v(x);
+SELECT approx_count_distinct(x) FROM (VALUES (point '(1,1)')) v(x);
+-- 100000 values spread over the segments, ln(x) uniform between 0 and 10.
+-- The estimates are checked by the fraction of the values at or below them.
+CREATE TABLE apx_t (id int, k int, x float8) DISTRIBUTED BY (id);
+INSERT INTO apx_t
+  SELECT i, i % 4, exp(((i * 7919) % 100000) / 10000.0)
+  FROM generate_series(1, 100000) i;
+ANALYZE apx_t;
+CREATE FUNCTION apx_rank_close(q float8, maxerr float8) RETURNS boolean AS $$
+DECLARE
+  est float8;
+  rank float8;
+BEGIN
+  SELECT approx_percentile(x, q) INTO est FROM apx_t;
+  SELECT count(*) / 100000.0 INTO rank FROM apx_t WHERE x <= est;
+  RETURN abs(rank - q) <= maxerr;
+END;
+$$ LANGUAGE plpgsql;
+SELECT q, apx_rank_close(q, 0.001) AS close
+  FROM (VALUES (0.001), (0.01), (0.05), (0.95), (0.99), (0.999)) v(q) ORDER BY q;
+SELECT q, apx_rank_close(q, 0.005) AS close
+  FROM (VALUES (0.1), (0.25), (0.5), (0.75), (0.9)) v(q) ORDER BY q;
+SELECT approx_percentile(x, 0) = min(x) AS min, approx_percentile(x, 1) = max(x) AS max
+  FROM apx_t;
+-- Per group, against percentile_cont().  ln(x) is uniform, so compare that.
+SELECT k, count(*),
+  abs(ln(approx_percentile(x, 0.5)) - ln(percentile_cont(0.5) WITHIN GROUP (ORDER BY x))) < 0.05 AS p50,
+  abs(ln(approx_percentile(x, 0.95)) - ln(percentile_cont(0.95) WITHIN GROUP (ORDER BY x))) < 0.02 AS p95
+  FROM apx_t GROUP BY k ORDER BY k;
+-- Distinct counts within 5%, about three standard errors.  Duplicates and
+-- NULLs change nothing, and neither does the type of the values.
+SELECT abs(approx_count_distinct(x) - 100000) < 5000 AS x,
+  abs(approx_count_distinct(id % 30000) - 30000) < 1500 AS id,
+  abs(approx_count_distinct((id % 30000)::text) - 30000) < 1500 AS text
+  FROM apx_t;
+SELECT approx_count_distinct(id % 30000) =
+  (SELECT approx_count_distinct(CASE WHEN id % 7 = 0 THEN NULL ELSE id % 30000 END)
+   FROM apx_t WHERE id <= 60000) AS same
+  FROM apx_t;
+SELECT k, abs(approx_count_distinct(id) - 25000) < 1250 AS close
+  FROM apx_t GROUP BY k ORDER BY k;
+-- In one stage, the sketches are the same; the digest is built in another
+-- order, so only close.
+SET gp_enable_multiphase_agg = off;
+SELECT approx_count_distinct(id % 30000) =
+  (SELECT approx_count_distinct(id % 30000) FROM apx_t WHERE id <= 60000) AS same
+  FROM apx_t;
+SELECT q, apx_rank_close(q, 0.005) AS close
+  FROM (VALUES (0.01), (0.5), (0.99)) v(q) ORDER BY q;
+RESET gp_enable_multiphase_agg;
+DROP FUNCTION apx_rank_close(float8, float8);
+DROP TABLE apx_small;
+DROP TABLE apx_t;
@@ -259,6 +259,59 @@ drop table ddtesttab;
 drop sequence ddtestseq;
 
 
+----------------------------------------------------------------------------------
+-- Generic plans of prepared statements
+--  the segments follow from the bound values of the distribution key parameters;
+--  seg records where each row was stored, so a row is only found on its segment
+set test_print_direct_dispatch_info=off;
+set optimizer=off;
+set gp_enable_generic_plans=on;
+create table direct_dispatch_param (a int, seg int) distributed by (a);
+insert into direct_dispatch_param select i, 0 from generate_series(1, 100) i;
+update direct_dispatch_param set seg = gp_segment_id;
+create table direct_dispatch_param2 (a int, b text, seg int) distributed by (a, b);
+insert into direct_dispatch_param2 select i, 'b' || i, 0 from generate_series(1, 100) i;
+update direct_dispatch_param2 set seg = gp_segment_id;
+set test_print_direct_dispatch_info=on;
+prepare dd_by_key (int) as select a, seg = gp_segment_id as on_segment from direct_dispatch_param where a = $1;
+-- the first five are planned with the values, the rest use the generic plan
+execute dd_by_key(1);
+execute dd_by_key(2);
+execute dd_by_key(3);
+execute dd_by_key(4);
+execute dd_by_key(5);
+execute dd_by_key(16);
+execute dd_by_key(77);
+execute dd_by_key(100);
+execute dd_by_key(1000);
+execute dd_by_key(NULL);
+prepare dd_by_keys (int, text) as select a, b, seg = gp_segment_id as on_segment from direct_dispatch_param2 where a = $1 and b = $2;
+execute dd_by_keys(1, 'b1');
+execute dd_by_keys(2, 'b2');
+execute dd_by_keys(3, 'b3');
+execute dd_by_keys(4, 'b4');
+execute dd_by_keys(5, 'b5');
+execute dd_by_keys(16, 'b16');
+execute dd_by_keys(77, 'b77');
+execute dd_by_keys(100, 'b100');
+-- a constant and a parameter
+prepare dd_by_b (text) as select a, b, seg = gp_segment_id as on_segment from direct_dispatch_param2 where a = 42 and b = $1;
+execute dd_by_b('b42');
+execute dd_by_b('b42');
+execute dd_by_b('b42');
+execute dd_by_b('b42');
+execute dd_by_b('b42');
+execute dd_by_b('b42');
+execute dd_by_b('b43');
+set test_print_direct_dispatch_info=off;
+deallocate dd_by_key;
+deallocate dd_by_keys;
+deallocate dd_by_b;
+drop table direct_dispatch_param;
+drop table direct_dispatch_param2;
+reset gp_enable_generic_plans;
+reset optimizer;
+
 -- cleanup
 set test_print_direct_dispatch_info=off;
 
@@ -0,0 +1,65 @@
+--
+-- DISTINCT-qualified aggregates on several arguments
+--
+-- Every query runs with gp_enable_agg_distinct_expand on, then off, and
+-- must give the same result.
+CREATE TABLE dqa_t (id int, g int, a int, b int, c text, d numeric) DISTRIBUTED BY (id);
+INSERT INTO dqa_t
+  SELECT id,
+         CASE WHEN id % 47 = 0 THEN NULL ELSE id % 5 END,
+         CASE WHEN id % 7 = 0 THEN NULL ELSE (id / 3) % (9 + id % 5) END,
+         CASE WHEN id % 11 = 0 THEN NULL ELSE (id / 7) % (12 + 2 * (id % 5)) END,
+         CASE WHEN id % 3 = 0 THEN NULL ELSE 't' || (id % 4) END,
+         (id % (5 + id % 5)) * 1.5
+  FROM generate_series(1, 1000) id;
+-- Counts the NULLs it is given, so it must not be fed the NULLs that stand
+-- for the other arguments' rows.
+CREATE FUNCTION dqa_nulls_trans(int8, int4) RETURNS int8
+  AS 'SELECT CASE WHEN $2 IS NULL THEN $1 + 1 ELSE $1 END' LANGUAGE sql IMMUTABLE;
+CREATE AGGREGATE dqa_count_nulls(int4) (sfunc = dqa_nulls_trans, stype = int8, initcond = '0');
+SET enable_hashagg = on;
+SET gp_enable_agg_distinct_expand = on;
+SELECT count(DISTINCT a), count(DISTINCT b), sum(DISTINCT a), sum(DISTINCT b) FROM dqa_t;
+SELECT g, count(DISTINCT a), count(DISTINCT b), sum(DISTINCT a), sum(DISTINCT b)
+  FROM dqa_t GROUP BY g ORDER BY g;
+SELECT g, count(DISTINCT a), count(DISTINCT c), max(DISTINCT c)
+  FROM dqa_t GROUP BY g HAVING count(DISTINCT b) > 16 ORDER BY g;
+SELECT g + 1 AS g1, count(DISTINCT a) + count(DISTINCT b)
+  FROM dqa_t WHERE id > 500 GROUP BY g ORDER BY 1;
+SELECT g, count(DISTINCT a % 5), count(DISTINCT a + b), sum(DISTINCT d)
+  FROM dqa_t GROUP BY g ORDER BY g;
+-- NULL arguments, and empty input
+SELECT count(DISTINCT a), count(DISTINCT b), sum(DISTINCT b) FROM dqa_t WHERE a IS NULL;
+SELECT count(DISTINCT a), sum(DISTINCT b) FROM dqa_t WHERE id < 0;
+SELECT g, count(DISTINCT a), sum(DISTINCT b) FROM dqa_t WHERE id < 0 GROUP BY g;
+-- not rewritten: a plain aggregate, a single argument, a non-strict
+-- aggregate
+SELECT count(DISTINCT a), count(DISTINCT b), count(*) FROM dqa_t;
+SELECT count(DISTINCT a), sum(DISTINCT a) FROM dqa_t;
+SELECT dqa_count_nulls(DISTINCT a), dqa_count_nulls(DISTINCT b) FROM dqa_t;
+SELECT count(DISTINCT a), dqa_count_nulls(DISTINCT b) FROM dqa_t;
+SET gp_enable_agg_distinct_expand = off;
+SELECT count(DISTINCT a), count(DISTINCT b), sum(DISTINCT a), sum(DISTINCT b) FROM dqa_t;
+SELECT g, count(DISTINCT a), count(DISTINCT b), sum(DISTINCT a), sum(DISTINCT b)
+  FROM dqa_t GROUP BY g ORDER BY g;
+SELECT g, count(DISTINCT a), count(DISTINCT c), max(DISTINCT c)
+  FROM dqa_t GROUP BY g HAVING count(DISTINCT b) > 16 ORDER BY g;
+SELECT g + 1 AS g1, count(DISTINCT a) + count(DISTINCT b)
+  FROM dqa_t WHERE id > 500 GROUP BY g ORDER BY 1;
+SELECT g, count(DISTINCT a % 5), count(DISTINCT a + b), sum(DISTINCT d)
+  FROM dqa_t GROUP BY g ORDER BY g;
+-- NULL arguments, and empty input
+SELECT count(DISTINCT a), count(DISTINCT b), sum(DISTINCT b) FROM dqa_t WHERE a IS NULL;
+SELECT count(DISTINCT a), sum(DISTINCT b) FROM dqa_t WHERE id < 0;
+SELECT g, count(DISTINCT a), sum(DISTINCT b) FROM dqa_t WHERE id < 0 GROUP BY g;
+-- not rewritten: a plain aggregate, a single argument, a non-strict
+-- aggregate
+SELECT count(DISTINCT a), count(DISTINCT b), count(*) FROM dqa_t;
+SELECT count(DISTINCT a), sum(DISTINCT a) FROM dqa_t;
+SELECT dqa_count_nulls(DISTINCT a), dqa_count_nulls(DISTINCT b) FROM dqa_t;
+SELECT count(DISTINCT a), dqa_count_nulls(DISTINCT b) FROM dqa_t;
+RESET gp_enable_agg_distinct_expand;
+RESET enable_hashagg;
+DROP AGGREGATE dqa_count_nulls(int4);
+DROP FUNCTION dqa_nulls_trans(int8, int4);
+DROP TABLE dqa_t;
@@ -0,0 +1,82 @@
+--
+-- EXECUTE reusing the generic plan of a prepared statement
+-- (gp_enable_generic_plans).
+--
+-- Plans of the Postgres planner, whose generic plans can dispatch directly
+-- on a parameter.
+SET optimizer = off;
+
+-- The filters of a plan.
+CREATE FUNCTION generic_plan_filters(query text) RETURNS SETOF text AS $$
+DECLARE
+  line text;
+BEGIN
+  FOR line IN EXECUTE 'EXPLAIN ' || query LOOP
+    IF line ~ 'Filter:' THEN
+      RETURN NEXT substring(line from 'Filter: .*');
+    END IF;
+  END LOOP;
+END;
+$$ LANGUAGE plpgsql;
+
+CREATE TABLE generic_plans (a int, b int) DISTRIBUTED BY (a);
+INSERT INTO generic_plans SELECT i, i % 10 FROM generate_series(1, 1000) i;
+ANALYZE generic_plans;
+
+SET gp_enable_generic_plans = on;
+
+-- The first five executions are planned with the values. The generic plan
+-- costs about the same, so the later ones use it.
+PREPARE by_b(int) AS SELECT count(*) FROM generic_plans WHERE b = $1;
+SELECT generic_plan_filters('EXECUTE by_b(0)');
+EXECUTE by_b(1);
+EXECUTE by_b(2);
+EXECUTE by_b(3);
+EXECUTE by_b(4);
+SELECT generic_plan_filters('EXECUTE by_b(5)');
+EXECUTE by_b(6);
+EXECUTE by_b(10);
+SET gp_enable_generic_plans = off;
+SELECT generic_plan_filters('EXECUTE by_b(7)');
+SET gp_enable_generic_plans = on;
+
+-- Only the values let these dispatch to a single segment, as the generic
+-- plan cannot hash "$1 + 1". They keep being planned with the values.
+PREPARE by_a(int) AS SELECT b FROM generic_plans WHERE a = $1 + 1;
+SET test_print_direct_dispatch_info = on;
+EXECUTE by_a(0);
+EXECUTE by_a(1);
+EXECUTE by_a(2);
+EXECUTE by_a(3);
+EXECUTE by_a(4);
+EXECUTE by_a(5);
+SET test_print_direct_dispatch_info = off;
+SELECT generic_plan_filters('EXECUTE by_a(6)');
+SET test_print_direct_dispatch_info = on;
+EXECUTE by_a(7);
+SET test_print_direct_dispatch_info = off;
+
+-- The generic plan dispatches directly on the parameter, so it is used,
+-- and still runs on the one segment that holds the row.
+PREPARE by_key(int) AS SELECT b FROM generic_plans WHERE a = $1;
+SET test_print_direct_dispatch_info = on;
+EXECUTE by_key(1);
+EXECUTE by_key(2);
+EXECUTE by_key(3);
+EXECUTE by_key(4);
+EXECUTE by_key(5);
+SET test_print_direct_dispatch_info = off;
+SELECT generic_plan_filters('EXECUTE by_key(6)');
+SET test_print_direct_dispatch_info = on;
+EXECUTE by_key(16);
+EXECUTE by_key(999);
+EXECUTE by_key(1001);
+SET test_print_direct_dispatch_info = off;
+
+DEALLOCATE by_b;
+DEALLOCATE by_a;
+DEALLOCATE by_key;
+RESET gp_enable_generic_plans;
+DROP TABLE generic_plans;
+DROP FUNCTION generic_plan_filters(text);
+RESET optimizer;
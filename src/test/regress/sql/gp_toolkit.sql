@@ -101,6 +101,29 @@ create table toolkit_skew (a int);
 insert into toolkit_skew select i from generate_series(1,50000) i;
 select sifnamespace, sifrelname from gp_toolkit.gp_skew_idle_fractions where sifoid = 'toolkit_skew'::regclass;
 
+-- Test the gp_skew_size_coefficients view and the distribution key advisor
+select sscnamespace, sscrelname from gp_toolkit.gp_skew_size_coefficients where sscoid = 'toolkit_skew'::regclass;
+select dkaattname, dkacurrent, dkamovedfraction = 0 as dkanomove from gp_toolkit.gp_distribution_key_advice('toolkit_skew'::regclass, 1.0);
+
+-- Test the query progress views. The current query is published too, but
+-- the views leave out the current session.
+select count(*) > 0 as has_own_nodes from pg_catalog.gp_query_progress() where sess_id = current_setting('gp_session_id')::int;
+select count(*) as own_nodes from gp_toolkit.gp_query_progress where sess_id = current_setting('gp_session_id')::int;
+select count(*) as own_slices from gp_toolkit.gp_query_slice_progress where sess_id = current_setting('gp_session_id')::int;
+
+-- Test the wait event views. They leave out the current session, too.
+select count(*) as own_waits from gp_toolkit.gp_wait_events where sess_id = current_setting('gp_session_id')::int;
+select count(*) as own_waits from gp_toolkit.gp_wait_event_profile(100, 10) where sess_id = current_setting('gp_session_id')::int;
+select * from pg_catalog.gp_wait_event_samples(100, 0);
+
+-- Test the query resource history. The queries above were recorded on the
+-- master and on the segments.
+select count(distinct segid) > 1 as has_own_history from gp_toolkit.gp_query_resource_history where sess_id = current_setting('gp_session_id')::int;
+
+-- Test the statement latency view. The statement above was counted, with
+-- its constants removed.
+select phase, bool_and(calls > 0 and p99_ms <= max_ms) as counted from gp_toolkit.gp_statement_stats where query like 'select count(distinct segid) > ? as has_own_history %' group by phase order by phase;
+
 -----------------------------------
 -- Test gp_bloat_expected_pages and gp_bloat_diag views
 -- (re-using the toolkit_skew table)
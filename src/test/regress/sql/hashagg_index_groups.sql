@@ -0,0 +1,51 @@
+--
+-- Hash aggregate groups looked up through an index of hash tags
+-- (gp_hashagg_index_groups). Every query runs with the index on and then
+-- off, with the same results.
+--
+SET optimizer = off;
+SET enable_groupagg = off;
+
+-- n has the same values at two scales; f has both 0 and -0.
+CREATE TABLE ix_agg (a int, k int, t text, n numeric, f float8) DISTRIBUTED BY (k);
+INSERT INTO ix_agg
+  SELECT i,
+         CASE WHEN i % 1000 = 0 THEN NULL ELSE i % 30000 END,
+         'k' || (i % 20011),
+         CASE WHEN i % 2 = 0 THEN (i % 50)::numeric ELSE (i % 50)::numeric(10, 2) END,
+         CASE WHEN i % 100 = 0 THEN '-0'::float8 ELSE (i % 7)::float8 END
+  FROM generate_series(1, 100000) i;
+ANALYZE ix_agg;
+
+SET gp_hashagg_index_groups = on;
+SELECT count(*), sum(c), max(c) FROM (SELECT k, count(*) AS c FROM ix_agg GROUP BY k) x;
+SELECT c FROM (SELECT k, count(*) AS c FROM ix_agg GROUP BY k) x WHERE k IS NULL;
+SELECT count(*) FROM (SELECT t, k % 7 FROM ix_agg GROUP BY 1, 2) x;
+SELECT count(*) FROM (SELECT n FROM ix_agg GROUP BY n) x;
+SELECT f + 0 AS f, count(*) FROM ix_agg GROUP BY f ORDER BY 1;
+-- Two stage aggregates whose bottom stage spills.
+SET gp_hashagg_streambottom = off;
+SET statement_mem = '1000kB';
+SELECT count(*), sum(c), max(c) FROM (SELECT t, count(*) AS c FROM ix_agg GROUP BY t) x;
+SELECT count(*) FROM (SELECT t, a % 3 FROM ix_agg GROUP BY 1, 2) x;
+RESET statement_mem;
+RESET gp_hashagg_streambottom;
+
+SET gp_hashagg_index_groups = off;
+SELECT count(*), sum(c), max(c) FROM (SELECT k, count(*) AS c FROM ix_agg GROUP BY k) x;
+SELECT c FROM (SELECT k, count(*) AS c FROM ix_agg GROUP BY k) x WHERE k IS NULL;
+SELECT count(*) FROM (SELECT t, k % 7 FROM ix_agg GROUP BY 1, 2) x;
+SELECT count(*) FROM (SELECT n FROM ix_agg GROUP BY n) x;
+SELECT f + 0 AS f, count(*) FROM ix_agg GROUP BY f ORDER BY 1;
+-- Two stage aggregates whose bottom stage spills.
+SET gp_hashagg_streambottom = off;
+SET statement_mem = '1000kB';
+SELECT count(*), sum(c), max(c) FROM (SELECT t, count(*) AS c FROM ix_agg GROUP BY t) x;
+SELECT count(*) FROM (SELECT t, a % 3 FROM ix_agg GROUP BY 1, 2) x;
+RESET statement_mem;
+RESET gp_hashagg_streambottom;
+
+RESET gp_hashagg_index_groups;
+DROP TABLE ix_agg;
+RESET enable_groupagg;
+RESET optimizer;
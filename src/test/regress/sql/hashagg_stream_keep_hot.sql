@@ -0,0 +1,51 @@
+--
+-- Hot groups kept in memory when the streaming bottom stage of a two stage
+-- hash aggregate flushes (gp_hashagg_stream_keep_hot). Every query runs
+-- with the hot groups kept and then not, with the same results.
+--
+SET optimizer = off;
+SET enable_groupagg = off;
+SET gp_hashagg_streambottom = on;
+
+-- Half of the rows fall into four hot groups, the other half each into a
+-- group of its own.
+CREATE TABLE sk_agg (a int, g int, v int) DISTRIBUTED BY (a);
+INSERT INTO sk_agg
+  SELECT i, CASE WHEN i % 2 = 0 THEN i % 8 ELSE i END, i FROM generate_series(1, 200000) i;
+ANALYZE sk_agg;
+
+SET gp_hashagg_stream_keep_hot = on;
+SELECT count(*), sum(n), max(n), sum(s)
+FROM (SELECT g, count(*) AS n, sum(v) AS s FROM sk_agg GROUP BY g) x;
+SELECT g, count(*), sum(v), min(v), max(v) FROM sk_agg WHERE g < 10 GROUP BY g ORDER BY g;
+SELECT count(*) FROM (SELECT g % 50000, v % 2 FROM sk_agg GROUP BY 1, 2) x;
+SELECT (g % 1000)::text AS k, count(*) FROM sk_agg GROUP BY 1 ORDER BY 2 DESC, 1 LIMIT 5;
+-- The table of the bottom stage fills up and flushes, again and again.
+SET statement_mem = '1000kB';
+SELECT count(*), sum(n), max(n), sum(s)
+FROM (SELECT g, count(*) AS n, sum(v) AS s FROM sk_agg GROUP BY g) x;
+SELECT g, count(*), sum(v), min(v), max(v) FROM sk_agg WHERE g < 10 GROUP BY g ORDER BY g;
+SELECT count(*) FROM (SELECT g % 50000, v % 2 FROM sk_agg GROUP BY 1, 2) x;
+SELECT (g % 1000)::text AS k, count(*) FROM sk_agg GROUP BY 1 ORDER BY 2 DESC, 1 LIMIT 5;
+RESET statement_mem;
+
+SET gp_hashagg_stream_keep_hot = off;
+SELECT count(*), sum(n), max(n), sum(s)
+FROM (SELECT g, count(*) AS n, sum(v) AS s FROM sk_agg GROUP BY g) x;
+SELECT g, count(*), sum(v), min(v), max(v) FROM sk_agg WHERE g < 10 GROUP BY g ORDER BY g;
+SELECT count(*) FROM (SELECT g % 50000, v % 2 FROM sk_agg GROUP BY 1, 2) x;
+SELECT (g % 1000)::text AS k, count(*) FROM sk_agg GROUP BY 1 ORDER BY 2 DESC, 1 LIMIT 5;
+-- The table of the bottom stage fills up and flushes, again and again.
+SET statement_mem = '1000kB';
+SELECT count(*), sum(n), max(n), sum(s)
+FROM (SELECT g, count(*) AS n, sum(v) AS s FROM sk_agg GROUP BY g) x;
+SELECT g, count(*), sum(v), min(v), max(v) FROM sk_agg WHERE g < 10 GROUP BY g ORDER BY g;
+SELECT count(*) FROM (SELECT g % 50000, v % 2 FROM sk_agg GROUP BY 1, 2) x;
+SELECT (g % 1000)::text AS k, count(*) FROM sk_agg GROUP BY 1 ORDER BY 2 DESC, 1 LIMIT 5;
+RESET statement_mem;
+
+RESET gp_hashagg_stream_keep_hot;
+DROP TABLE sk_agg;
+RESET gp_hashagg_streambottom;
+RESET enable_groupagg;
+RESET optimizer;
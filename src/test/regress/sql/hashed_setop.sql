@@ -0,0 +1,107 @@
+--
+-- UNION, INTERSECT and EXCEPT by hashing rather than sorting
+--
+-- The nodes of a plan that remove duplicates.
+CREATE FUNCTION setop_nodes(query text) RETURNS SETOF text AS $$
+DECLARE
+  line text;
+BEGIN
+  FOR line IN EXECUTE 'EXPLAIN ' || query LOOP
+    IF line ~ 'SetOp|Unique|HashAggregate' THEN
+      RETURN NEXT substring(line from
+        '(HashSetOp [A-Za-z ]*[A-Za-z]|SetOp [A-Za-z ]*[A-Za-z]|Unique|HashAggregate)');
+    END IF;
+  END LOOP;
+END;
+$$ LANGUAGE plpgsql;
+-- Whether running a query spilled to workfiles.
+CREATE FUNCTION setop_spilled(query text) RETURNS boolean AS $$
+DECLARE
+  line text;
+  spilled boolean := false;
+BEGIN
+  FOR line IN EXECUTE 'EXPLAIN ANALYZE ' || query LOOP
+    IF line LIKE '%spilling)%' AND line NOT LIKE '%Workfile: (0 spilling)%' THEN
+      spilled := true;
+    END IF;
+  END LOOP;
+  RETURN spilled;
+END;
+$$ LANGUAGE plpgsql;
+-- Every (a, b) of setop_a is there twice, with 3000 of them in all; every
+-- (a, b) of setop_b twice, with 1500 of them.  1000 are in both.
+CREATE TABLE setop_a (a int, b text) DISTRIBUTED BY (a);
+CREATE TABLE setop_b (a int, b text) DISTRIBUTED BY (b);
+INSERT INTO setop_a SELECT i % 1000, 'x' || (i % 3) FROM generate_series(1, 6000) i;
+INSERT INTO setop_b SELECT i % 1500, 'x' || (i % 2) FROM generate_series(1, 3000) i;
+ANALYZE setop_a;
+ANALYZE setop_b;
+-- Hashing, with sorting made unattractive.
+SET enable_sort = off;
+SELECT setop_nodes('SELECT a, b FROM setop_a UNION SELECT a, b FROM setop_b');
+SELECT setop_nodes('SELECT a, b FROM setop_a INTERSECT SELECT a, b FROM setop_b');
+SELECT setop_nodes('SELECT a, b FROM setop_a INTERSECT ALL SELECT a, b FROM setop_b');
+SELECT setop_nodes('SELECT a, b FROM setop_a EXCEPT SELECT a, b FROM setop_b');
+SELECT setop_nodes('SELECT a, b FROM setop_a EXCEPT ALL SELECT a, b FROM setop_b');
+SELECT count(*), sum(a) FROM
+  (SELECT a, b FROM setop_a UNION SELECT a, b FROM setop_b) s;
+SELECT count(*), sum(a) FROM
+  (SELECT a, b FROM setop_a INTERSECT SELECT a, b FROM setop_b) s;
+SELECT count(*), sum(a) FROM
+  (SELECT a, b FROM setop_a INTERSECT ALL SELECT a, b FROM setop_b) s;
+SELECT count(*), sum(a) FROM
+  (SELECT a, b FROM setop_a EXCEPT SELECT a, b FROM setop_b) s;
+SELECT count(*), sum(a) FROM
+  (SELECT a, b FROM setop_a EXCEPT ALL SELECT a, b FROM setop_b) s;
+-- The output is not sorted, so ORDER BY still sorts it.
+SELECT a, b FROM setop_a WHERE a < 3 INTERSECT ALL SELECT a, b FROM setop_b
+  ORDER BY a, b;
+SELECT a, b FROM setop_a WHERE a < 3 EXCEPT ALL SELECT a, b FROM setop_b
+  ORDER BY a, b;
+-- NULLs are equal to each other here.
+SELECT a, b FROM (VALUES (1, NULL), (NULL, 'y'), (NULL, NULL)) v(a, b)
+  INTERSECT SELECT a, b FROM (VALUES (1, NULL), (NULL, NULL)) w(a, b)
+  ORDER BY a, b;
+SELECT a, b FROM (VALUES (1, NULL), (NULL, 'y'), (NULL, NULL)) v(a, b)
+  EXCEPT SELECT a, b FROM (VALUES (1, NULL), (NULL, NULL)) w(a, b)
+  ORDER BY a, b;
+-- Nested set operations.
+SELECT count(*), sum(a) FROM
+  ((SELECT a FROM setop_a EXCEPT SELECT a FROM setop_b WHERE a % 2 = 0)
+   INTERSECT SELECT a FROM setop_b WHERE a < 500) s;
+-- More groups than fit in memory: the hash tables spill, and the results
+-- stay the same.
+CREATE TABLE setop_big (a int) DISTRIBUTED BY (a);
+INSERT INTO setop_big SELECT generate_series(1, 200000);
+ANALYZE setop_big;
+SET statement_mem = '1000kB';
+SELECT setop_nodes('SELECT a FROM setop_big INTERSECT SELECT a FROM setop_big WHERE a % 3 = 0');
+SELECT setop_spilled('SELECT a FROM setop_big INTERSECT SELECT a FROM setop_big WHERE a % 3 = 0');
+SELECT count(*), sum(a) FROM
+  (SELECT a FROM setop_big INTERSECT SELECT a FROM setop_big WHERE a % 3 = 0) s;
+SELECT setop_spilled('SELECT a % 50000 FROM setop_big EXCEPT ALL SELECT a FROM setop_big WHERE a <= 25000');
+SELECT count(*), sum(a) FROM
+  (SELECT a % 50000 AS a FROM setop_big
+   EXCEPT ALL SELECT a FROM setop_big WHERE a <= 25000) s;
+SELECT setop_spilled('SELECT a FROM setop_big UNION SELECT a + 100000 FROM setop_big');
+SELECT count(*), sum(a) FROM
+  (SELECT a FROM setop_big UNION SELECT a + 100000 FROM setop_big) s;
+RESET statement_mem;
+RESET enable_sort;
+-- Sorting, as before.
+SET gp_enable_hashed_setop = off;
+SELECT setop_nodes('SELECT a, b FROM setop_a UNION SELECT a, b FROM setop_b');
+SELECT setop_nodes('SELECT a, b FROM setop_a INTERSECT SELECT a, b FROM setop_b');
+SELECT setop_nodes('SELECT a, b FROM setop_a EXCEPT ALL SELECT a, b FROM setop_b');
+SELECT count(*), sum(a) FROM
+  (SELECT a, b FROM setop_a UNION SELECT a, b FROM setop_b) s;
+SELECT count(*), sum(a) FROM
+  (SELECT a, b FROM setop_a INTERSECT SELECT a, b FROM setop_b) s;
+SELECT count(*), sum(a) FROM
+  (SELECT a, b FROM setop_a EXCEPT ALL SELECT a, b FROM setop_b) s;
+RESET gp_enable_hashed_setop;
+DROP TABLE setop_a;
+DROP TABLE setop_b;
+DROP TABLE setop_big;
+DROP FUNCTION setop_nodes(text);
+DROP FUNCTION setop_spilled(text);
@@ -0,0 +1,71 @@
+--
+-- Hash join probes through a compact array of hash values per batch
+-- (gp_hashjoin_compact_buckets). Every query runs with the array on and
+-- then off, with the same results.
+--
+SET optimizer = off;
+SET enable_nestloop = off;
+SET enable_mergejoin = off;
+
+-- Keys 1 to 9999 three times each, key 0 another 3000 times, and NULLs.
+CREATE TABLE cb_inner (a int, b text) DISTRIBUTED BY (a);
+INSERT INTO cb_inner SELECT i % 10000, 'v' || (i % 13) FROM generate_series(1, 30000) i;
+INSERT INTO cb_inner SELECT 0, 'hot' FROM generate_series(1, 3000);
+INSERT INTO cb_inner SELECT NULL, 'n' FROM generate_series(1, 5);
+CREATE TABLE cb_outer (a int, c int, t text) DISTRIBUTED BY (a);
+INSERT INTO cb_outer SELECT i % 15000, i, 'v' || (i % 17) FROM generate_series(1, 20000) i;
+INSERT INTO cb_outer VALUES (NULL, 0, NULL);
+ANALYZE cb_inner;
+ANALYZE cb_outer;
+
+SET gp_hashjoin_compact_buckets = on;
+SELECT count(*), sum(o.c) FROM cb_outer o JOIN cb_inner i ON o.a = i.a;
+SELECT count(*), sum(o.c) FROM cb_outer o JOIN cb_inner i ON o.t = i.b WHERE o.c <= 100;
+SELECT count(*), count(i.a) FROM cb_outer o LEFT JOIN cb_inner i ON o.a = i.a;
+SELECT count(*), sum(c) FROM cb_outer WHERE a IN (SELECT a FROM cb_inner);
+SELECT count(*), sum(c) FROM cb_outer o WHERE NOT EXISTS (SELECT 1 FROM cb_inner i WHERE i.a = o.a);
+-- Several batches
+SET statement_mem = '1000kB';
+SELECT count(*), sum(o.c) FROM cb_outer o JOIN cb_inner i ON o.a = i.a;
+SELECT count(*), sum(o.c) FROM cb_outer o JOIN cb_inner i ON o.t = i.b WHERE o.c <= 100;
+SELECT count(*), count(i.a) FROM cb_outer o LEFT JOIN cb_inner i ON o.a = i.a;
+SELECT count(*), sum(c) FROM cb_outer WHERE a IN (SELECT a FROM cb_inner);
+SELECT count(*), sum(c) FROM cb_outer o WHERE NOT EXISTS (SELECT 1 FROM cb_inner i WHERE i.a = o.a);
+RESET statement_mem;
+-- Rescans
+WITH RECURSIVE r(a, n) AS (
+  SELECT 1, 0
+  UNION ALL
+  SELECT i.a, r.n + 1 FROM cb_inner i, r
+  WHERE i.a = r.a + 1 AND i.b = 'v' || ((r.a + 1) % 13) AND r.n < 50
+)
+SELECT count(*), sum(a), max(n) FROM r;
+
+SET gp_hashjoin_compact_buckets = off;
+SELECT count(*), sum(o.c) FROM cb_outer o JOIN cb_inner i ON o.a = i.a;
+SELECT count(*), sum(o.c) FROM cb_outer o JOIN cb_inner i ON o.t = i.b WHERE o.c <= 100;
+SELECT count(*), count(i.a) FROM cb_outer o LEFT JOIN cb_inner i ON o.a = i.a;
+SELECT count(*), sum(c) FROM cb_outer WHERE a IN (SELECT a FROM cb_inner);
+SELECT count(*), sum(c) FROM cb_outer o WHERE NOT EXISTS (SELECT 1 FROM cb_inner i WHERE i.a = o.a);
+-- Several batches
+SET statement_mem = '1000kB';
+SELECT count(*), sum(o.c) FROM cb_outer o JOIN cb_inner i ON o.a = i.a;
+SELECT count(*), sum(o.c) FROM cb_outer o JOIN cb_inner i ON o.t = i.b WHERE o.c <= 100;
+SELECT count(*), count(i.a) FROM cb_outer o LEFT JOIN cb_inner i ON o.a = i.a;
+SELECT count(*), sum(c) FROM cb_outer WHERE a IN (SELECT a FROM cb_inner);
+SELECT count(*), sum(c) FROM cb_outer o WHERE NOT EXISTS (SELECT 1 FROM cb_inner i WHERE i.a = o.a);
+RESET statement_mem;
+-- Rescans
+WITH RECURSIVE r(a, n) AS (
+  SELECT 1, 0
+  UNION ALL
+  SELECT i.a, r.n + 1 FROM cb_inner i, r
+  WHERE i.a = r.a + 1 AND i.b = 'v' || ((r.a + 1) % 13) AND r.n < 50
+)
+SELECT count(*), sum(a), max(n) FROM r;
+
+RESET gp_hashjoin_compact_buckets;
+DROP TABLE cb_inner, cb_outer;
+RESET enable_nestloop;
+RESET enable_mergejoin;
+RESET optimizer;
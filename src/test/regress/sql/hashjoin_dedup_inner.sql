@@ -0,0 +1,91 @@
+--
+-- Duplicate inner keys dropped in semi and anti hash joins
+-- (gp_hashjoin_dedup_inner). Every query runs with the duplicates dropped
+-- and then kept, with the same results.
+--
+SET optimizer = off;
+SET enable_nestloop = off;
+SET enable_mergejoin = off;
+
+CREATE TABLE dd_outer (a int, b bigint, n numeric) DISTRIBUTED BY (a);
+INSERT INTO dd_outer SELECT i % 5000, i, i % 100 FROM generate_series(1, 20000) i;
+INSERT INTO dd_outer VALUES (NULL, 0, NULL);
+-- Even keys 0 to 5998, 20 times each; n at another scale than in dd_outer.
+CREATE TABLE dd_inner (a int, b bigint, n numeric) DISTRIBUTED BY (a);
+INSERT INTO dd_inner
+  SELECT (i % 3000) * 2, (i % 3000) * 2, (i % 40)::numeric(10, 2)
+  FROM generate_series(1, 60000) i;
+CREATE TABLE dd_nulls (a int) DISTRIBUTED BY (a);
+INSERT INTO dd_nulls SELECT i FROM generate_series(1, 10) i;
+INSERT INTO dd_nulls VALUES (NULL), (NULL);
+ANALYZE dd_outer;
+ANALYZE dd_inner;
+ANALYZE dd_nulls;
+
+SET gp_hashjoin_dedup_inner = on;
+SELECT count(*), sum(b) FROM dd_outer WHERE a IN (SELECT a FROM dd_inner);
+SELECT count(*), sum(b) FROM dd_outer o WHERE EXISTS (SELECT 1 FROM dd_inner i WHERE i.a = o.a);
+SELECT count(*), sum(b) FROM dd_outer o WHERE NOT EXISTS (SELECT 1 FROM dd_inner i WHERE i.a = o.a);
+-- NOT IN, with and without NULL inner keys
+SELECT count(*), sum(b) FROM dd_outer WHERE a NOT IN (SELECT a FROM dd_inner);
+SELECT count(*), sum(b) FROM dd_outer WHERE a NOT IN (SELECT a FROM dd_nulls);
+SELECT count(*), sum(b) FROM dd_outer WHERE a NOT IN (SELECT a FROM dd_nulls WHERE a IS NOT NULL);
+-- Cross-type and numeric keys
+SELECT count(*), sum(b) FROM dd_outer WHERE a IN (SELECT b FROM dd_inner);
+SELECT count(*), sum(b) FROM dd_outer WHERE b NOT IN (SELECT a FROM dd_inner);
+SELECT count(*), sum(b) FROM dd_outer WHERE n IN (SELECT n FROM dd_inner);
+-- A qual that needs the inner rows
+SELECT count(*), sum(b) FROM dd_outer o WHERE EXISTS (SELECT 1 FROM dd_inner i WHERE i.a = o.a AND i.b > o.b % 1000);
+-- Several batches
+SET statement_mem = '1000kB';
+SELECT count(*), sum(b) FROM dd_outer WHERE a IN (SELECT a FROM dd_inner);
+SELECT count(*), sum(b) FROM dd_outer o WHERE EXISTS (SELECT 1 FROM dd_inner i WHERE i.a = o.a);
+SELECT count(*), sum(b) FROM dd_outer o WHERE NOT EXISTS (SELECT 1 FROM dd_inner i WHERE i.a = o.a);
+-- NOT IN, with and without NULL inner keys
+SELECT count(*), sum(b) FROM dd_outer WHERE a NOT IN (SELECT a FROM dd_inner);
+SELECT count(*), sum(b) FROM dd_outer WHERE a NOT IN (SELECT a FROM dd_nulls);
+SELECT count(*), sum(b) FROM dd_outer WHERE a NOT IN (SELECT a FROM dd_nulls WHERE a IS NOT NULL);
+-- Cross-type and numeric keys
+SELECT count(*), sum(b) FROM dd_outer WHERE a IN (SELECT b FROM dd_inner);
+SELECT count(*), sum(b) FROM dd_outer WHERE b NOT IN (SELECT a FROM dd_inner);
+SELECT count(*), sum(b) FROM dd_outer WHERE n IN (SELECT n FROM dd_inner);
+-- A qual that needs the inner rows
+SELECT count(*), sum(b) FROM dd_outer o WHERE EXISTS (SELECT 1 FROM dd_inner i WHERE i.a = o.a AND i.b > o.b % 1000);
+RESET statement_mem;
+
+SET gp_hashjoin_dedup_inner = off;
+SELECT count(*), sum(b) FROM dd_outer WHERE a IN (SELECT a FROM dd_inner);
+SELECT count(*), sum(b) FROM dd_outer o WHERE EXISTS (SELECT 1 FROM dd_inner i WHERE i.a = o.a);
+SELECT count(*), sum(b) FROM dd_outer o WHERE NOT EXISTS (SELECT 1 FROM dd_inner i WHERE i.a = o.a);
+-- NOT IN, with and without NULL inner keys
+SELECT count(*), sum(b) FROM dd_outer WHERE a NOT IN (SELECT a FROM dd_inner);
+SELECT count(*), sum(b) FROM dd_outer WHERE a NOT IN (SELECT a FROM dd_nulls);
+SELECT count(*), sum(b) FROM dd_outer WHERE a NOT IN (SELECT a FROM dd_nulls WHERE a IS NOT NULL);
+-- Cross-type and numeric keys
+SELECT count(*), sum(b) FROM dd_outer WHERE a IN (SELECT b FROM dd_inner);
+SELECT count(*), sum(b) FROM dd_outer WHERE b NOT IN (SELECT a FROM dd_inner);
+SELECT count(*), sum(b) FROM dd_outer WHERE n IN (SELECT n FROM dd_inner);
+-- A qual that needs the inner rows
+SELECT count(*), sum(b) FROM dd_outer o WHERE EXISTS (SELECT 1 FROM dd_inner i WHERE i.a = o.a AND i.b > o.b % 1000);
+-- Several batches
+SET statement_mem = '1000kB';
+SELECT count(*), sum(b) FROM dd_outer WHERE a IN (SELECT a FROM dd_inner);
+SELECT count(*), sum(b) FROM dd_outer o WHERE EXISTS (SELECT 1 FROM dd_inner i WHERE i.a = o.a);
+SELECT count(*), sum(b) FROM dd_outer o WHERE NOT EXISTS (SELECT 1 FROM dd_inner i WHERE i.a = o.a);
+-- NOT IN, with and without NULL inner keys
+SELECT count(*), sum(b) FROM dd_outer WHERE a NOT IN (SELECT a FROM dd_inner);
+SELECT count(*), sum(b) FROM dd_outer WHERE a NOT IN (SELECT a FROM dd_nulls);
+SELECT count(*), sum(b) FROM dd_outer WHERE a NOT IN (SELECT a FROM dd_nulls WHERE a IS NOT NULL);
+-- Cross-type and numeric keys
+SELECT count(*), sum(b) FROM dd_outer WHERE a IN (SELECT b FROM dd_inner);
+SELECT count(*), sum(b) FROM dd_outer WHERE b NOT IN (SELECT a FROM dd_inner);
+SELECT count(*), sum(b) FROM dd_outer WHERE n IN (SELECT n FROM dd_inner);
+-- A qual that needs the inner rows
+SELECT count(*), sum(b) FROM dd_outer o WHERE EXISTS (SELECT 1 FROM dd_inner i WHERE i.a = o.a AND i.b > o.b % 1000);
+RESET statement_mem;
+
+RESET gp_hashjoin_dedup_inner;
+DROP TABLE dd_outer, dd_inner, dd_nulls;
+RESET enable_nestloop;
+RESET enable_mergejoin;
+RESET optimizer;
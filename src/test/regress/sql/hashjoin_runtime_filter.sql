@@ -0,0 +1,92 @@
+--
+-- Hash join runtime filters (gp_hashjoin_runtime_filter): the outer scan
+-- under a hash join skips rows whose key has no match on the inner side.
+-- Every query runs with the filter on and then off, with the same results.
+--
+SET optimizer = off;
+SET enable_nestloop = off;
+SET enable_mergejoin = off;
+
+CREATE TABLE rf_fact (a int, b int, c bigint) DISTRIBUTED BY (a);
+INSERT INTO rf_fact SELECT i % 2000, i % 7, i FROM generate_series(1, 20000) i;
+INSERT INTO rf_fact SELECT NULL, i % 7, 100000 + i FROM generate_series(1, 100) i;
+-- Only one in ten keys of rf_fact has a match. Keys 1 to 20 twice, and a
+-- NULL key.
+CREATE TABLE rf_dim (a int, b int) DISTRIBUTED BY (a);
+INSERT INTO rf_dim SELECT i, i % 5 FROM generate_series(1, 200) i;
+INSERT INTO rf_dim SELECT i, (i + 1) % 5 FROM generate_series(1, 20) i;
+INSERT INTO rf_dim VALUES (NULL, 0);
+CREATE TABLE rf_dim8 (a bigint) DISTRIBUTED BY (a);
+INSERT INTO rf_dim8 SELECT 3 * i FROM generate_series(1, 300) i;
+INSERT INTO rf_dim8 VALUES (5000000000), (NULL);
+CREATE TABLE rf_fact_ao WITH (appendonly=true) AS SELECT * FROM rf_fact DISTRIBUTED BY (a);
+CREATE TABLE rf_fact_co WITH (appendonly=true, orientation=column) AS SELECT * FROM rf_fact DISTRIBUTED BY (a);
+-- Wider than the memory of the join below.
+CREATE TABLE rf_big (a int, pad text) DISTRIBUTED BY (a);
+INSERT INTO rf_big SELECT 10 * i, repeat('x', 500) FROM generate_series(1, 5000) i;
+ANALYZE rf_fact;
+ANALYZE rf_dim;
+ANALYZE rf_dim8;
+ANALYZE rf_fact_ao;
+ANALYZE rf_fact_co;
+ANALYZE rf_big;
+
+SET gp_hashjoin_runtime_filter = on;
+-- Inner joins on one and two keys
+SELECT count(*), sum(f.c), sum(d.b) FROM rf_fact f JOIN rf_dim d ON f.a = d.a;
+SELECT count(*), sum(f.c) FROM rf_fact f JOIN rf_dim d ON f.a = d.a WHERE d.b = 1;
+SELECT count(*), sum(f.c) FROM rf_fact f JOIN rf_dim d ON f.a = d.a AND f.b = d.b;
+-- Semi, anti and outer joins
+SELECT count(*), sum(c) FROM rf_fact WHERE a IN (SELECT a FROM rf_dim WHERE b < 2);
+SELECT count(*), sum(c) FROM rf_fact f WHERE NOT EXISTS (SELECT 1 FROM rf_dim d WHERE d.a = f.a);
+SELECT count(*), count(d.a) FROM rf_fact f LEFT JOIN rf_dim d ON f.a = d.a;
+-- Cross-type keys
+SELECT count(*), sum(f.c) FROM rf_fact f JOIN rf_dim8 d ON f.a = d.a;
+SELECT count(*), sum(f.c) FROM rf_fact f JOIN rf_dim d ON f.c = d.a;
+-- Append-only outer sides
+SELECT count(*), sum(f.c) FROM rf_fact_ao f JOIN rf_dim d ON f.a = d.a WHERE d.b = 1;
+SELECT count(*), sum(f.c) FROM rf_fact_co f JOIN rf_dim d ON f.a = d.a WHERE d.b = 1;
+-- Several batches
+SET statement_mem = '1000kB';
+SELECT count(*), sum(f.c) FROM rf_fact f JOIN rf_big b ON f.a = b.a;
+RESET statement_mem;
+-- Rescans
+WITH RECURSIVE r(a, n) AS (
+  SELECT a, 0 FROM rf_dim WHERE a = 21
+  UNION ALL
+  SELECT d.a, r.n + 1 FROM rf_dim d, r WHERE d.a = r.a + 1 AND r.n < 50
+)
+SELECT count(*), sum(a), max(n) FROM r;
+
+SET gp_hashjoin_runtime_filter = off;
+-- Inner joins on one and two keys
+SELECT count(*), sum(f.c), sum(d.b) FROM rf_fact f JOIN rf_dim d ON f.a = d.a;
+SELECT count(*), sum(f.c) FROM rf_fact f JOIN rf_dim d ON f.a = d.a WHERE d.b = 1;
+SELECT count(*), sum(f.c) FROM rf_fact f JOIN rf_dim d ON f.a = d.a AND f.b = d.b;
+-- Semi, anti and outer joins
+SELECT count(*), sum(c) FROM rf_fact WHERE a IN (SELECT a FROM rf_dim WHERE b < 2);
+SELECT count(*), sum(c) FROM rf_fact f WHERE NOT EXISTS (SELECT 1 FROM rf_dim d WHERE d.a = f.a);
+SELECT count(*), count(d.a) FROM rf_fact f LEFT JOIN rf_dim d ON f.a = d.a;
+-- Cross-type keys
+SELECT count(*), sum(f.c) FROM rf_fact f JOIN rf_dim8 d ON f.a = d.a;
+SELECT count(*), sum(f.c) FROM rf_fact f JOIN rf_dim d ON f.c = d.a;
+-- Append-only outer sides
+SELECT count(*), sum(f.c) FROM rf_fact_ao f JOIN rf_dim d ON f.a = d.a WHERE d.b = 1;
+SELECT count(*), sum(f.c) FROM rf_fact_co f JOIN rf_dim d ON f.a = d.a WHERE d.b = 1;
+-- Several batches
+SET statement_mem = '1000kB';
+SELECT count(*), sum(f.c) FROM rf_fact f JOIN rf_big b ON f.a = b.a;
+RESET statement_mem;
+-- Rescans
+WITH RECURSIVE r(a, n) AS (
+  SELECT a, 0 FROM rf_dim WHERE a = 21
+  UNION ALL
+  SELECT d.a, r.n + 1 FROM rf_dim d, r WHERE d.a = r.a + 1 AND r.n < 50
+)
+SELECT count(*), sum(a), max(n) FROM r;
+
+RESET gp_hashjoin_runtime_filter;
+DROP TABLE rf_fact, rf_dim, rf_dim8, rf_fact_ao, rf_fact_co, rf_big;
+RESET enable_nestloop;
+RESET enable_mergejoin;
+RESET optimizer;
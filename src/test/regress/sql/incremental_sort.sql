@@ -0,0 +1,73 @@
+--
+-- Sorting input that is already sorted on the leading sort keys, one group
+-- of equal leading keys at a time
+--
+-- Whether the plan of a query sorts on top of presorted keys.
+CREATE FUNCTION incsort_presorted(query text) RETURNS boolean AS $$
+DECLARE
+  line text;
+BEGIN
+  FOR line IN EXECUTE 'EXPLAIN ' || query LOOP
+    IF line LIKE '%Presorted Key:%' THEN
+      RETURN true;
+    END IF;
+  END LOOP;
+  RETURN false;
+END;
+$$ LANGUAGE plpgsql;
+-- Counts the rows of a query on (g, x), and checks that they come out in
+-- ORDER BY g, x DESC order.
+CREATE FUNCTION incsort_check(query text) RETURNS text AS $$
+DECLARE
+  r record;
+  n int := 0;
+  prev_g int;
+  prev_x int;
+  ordered boolean := true;
+BEGIN
+  FOR r IN EXECUTE query LOOP
+    IF n > 0 AND (r.g < prev_g OR (r.g = prev_g AND r.x > prev_x)) THEN
+      ordered := false;
+    END IF;
+    prev_g := r.g;
+    prev_x := r.x;
+    n := n + 1;
+  END LOOP;
+  RETURN n || ' rows, ' || CASE WHEN ordered THEN 'ordered' ELSE 'not ordered' END;
+END;
+$$ LANGUAGE plpgsql;
+-- Groups of g grow from 3 rows to 63, so there are batches of several small
+-- groups as well as groups bigger than a batch.
+CREATE VIEW incsort_v AS
+  SELECT floor(sqrt(i))::int AS g, (i * 37) % 101 AS x
+  FROM generate_series(1, 1000) i ORDER BY 1;
+SELECT incsort_presorted('SELECT g, x FROM incsort_v ORDER BY g, x DESC');
+SELECT incsort_check('SELECT g, x FROM incsort_v ORDER BY g, x DESC');
+SELECT g, x FROM incsort_v ORDER BY g, x DESC LIMIT 12;
+SELECT incsort_check('SELECT g, x FROM incsort_v ORDER BY g, x DESC LIMIT 100');
+SELECT incsort_check('SELECT g, x FROM incsort_v ORDER BY g, x DESC LIMIT 100 OFFSET 500');
+SELECT sum(x), count(DISTINCT g) FROM
+  (SELECT g, x FROM incsort_v ORDER BY g, x DESC LIMIT 100 OFFSET 500) s;
+-- Two presorted keys.
+SELECT incsort_presorted('SELECT g, x, y FROM
+  (SELECT g, x % 3 AS x, x AS y FROM incsort_v ORDER BY 1, 2) s ORDER BY g, x, y');
+SELECT g, x, y FROM
+  (SELECT g, x % 3 AS x, x AS y FROM incsort_v ORDER BY 1, 2) s
+  WHERE g = 3 ORDER BY g, x, y;
+-- NULL leading keys form a group of their own.
+SELECT g, x FROM
+  (SELECT CASE WHEN i % 4 = 0 THEN NULL ELSE i % 3 END AS g, i AS x
+   FROM generate_series(1, 12) i ORDER BY 1) s
+  ORDER BY g, x DESC;
+-- A sort on other keys, or on all of the input's, is unchanged.
+SELECT incsort_presorted('SELECT g, x FROM incsort_v ORDER BY x, g');
+SELECT incsort_presorted('SELECT g FROM incsort_v ORDER BY g');
+-- Turned off, the same queries sort the whole input.
+SET gp_enable_incremental_sort = off;
+SELECT incsort_presorted('SELECT g, x FROM incsort_v ORDER BY g, x DESC');
+SELECT incsort_check('SELECT g, x FROM incsort_v ORDER BY g, x DESC');
+SELECT g, x FROM incsort_v ORDER BY g, x DESC LIMIT 12;
+RESET gp_enable_incremental_sort;
+DROP VIEW incsort_v;
+DROP FUNCTION incsort_presorted(text);
+DROP FUNCTION incsort_check(text);
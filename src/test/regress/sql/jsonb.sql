@@ -0,0 +1,77 @@
+--
+-- jsonb, JSON kept in a binary format
+--
+-- Input and output. Whitespace and the order of keys are not kept; keys
+-- come out shortest first. Numbers keep the text they were written with.
+SELECT '""'::jsonb;
+SELECT '"\n\"\\A"'::jsonb;
+SELECT '1'::jsonb AS a, '-0.5e10'::jsonb AS b, 'true'::jsonb AS c, 'null'::jsonb AS d;
+SELECT '[]'::jsonb AS a, '{}'::jsonb AS b;
+SELECT '  [1, "two" ,{"three": [3]} , null ]'::jsonb;
+SELECT '{"bb": 1, "a": 2, "aa": 3, "b": 4, "": 5}'::jsonb;
+SELECT '{"abc"}'::jsonb;
+SELECT '[1,2'::jsonb;
+SELECT '{"a":1,}'::jsonb;
+-- The output reads back as the same value, through json as well.
+SELECT j::text::jsonb::text = j::text AS same
+  FROM (SELECT '{"x": [1, {"y": "z"}, [true, false]], "w": null}'::jsonb AS j) s;
+SELECT '{"a": {"b": [1, 2]}}'::json::jsonb AS a, '{"b": 1, "a": [2]}'::jsonb::json AS b;
+-- Duplicate keys: the last value wins, at every level.
+SELECT '{"a": 1, "b": 2, "a": 3}'::jsonb;
+SELECT '{"a": 1, "a": {"b": 1, "b": 2}}'::jsonb;
+SELECT '{"k": 1, "k": [2], "k": "3"}'::jsonb -> 'k';
+-- Nesting: deep values round-trip, and too deep is an error, not a crash.
+SELECT (repeat('[', 1000) || repeat(']', 1000))::jsonb::text
+  = repeat('[', 1000) || repeat(']', 1000) AS same;
+SELECT (repeat('{"a": ', 100) || '"deep"' || repeat('}', 100))::jsonb
+  #>> array_fill('a'::text, ARRAY[100]);
+SELECT (repeat('{"a": ', 100) || '"deep"' || repeat('}', 100))::jsonb
+  #>> array_fill('a'::text, ARRAY[101]);
+SELECT repeat('[', 1000000)::jsonb;
+-- -> and ->>: a JSON null is a jsonb null for ->, and an SQL NULL for ->>.
+SELECT j -> 'b' AS b, j ->> 'b' AS b_text, j -> 'c' AS c, j -> 'e' ->> 'f' AS ef,
+       j -> 'c' -> 2 -> 'd' AS cd, j -> 'c' -> 2 ->> 'd' AS cd_text,
+       j -> 'missing' AS missing
+  FROM (SELECT '{"a": 1, "b": "two", "c": [1, 2, {"d": null}], "e": {"f": true}}'::jsonb AS j) s;
+SELECT j -> 0 AS a, j ->> 1 AS b, j -> 2 AS c, j -> 3 ->> 'a' AS d, j -> 4 AS e, j -> -1 AS f
+  FROM (SELECT '[10, "x", [20], {"a": 30}]'::jsonb AS j) s;
+SELECT '[1]'::jsonb -> 'a';
+SELECT '{"a": 1}'::jsonb -> 0;
+SELECT '"s"'::jsonb -> 'a';
+SELECT '"s"'::jsonb ->> 0;
+-- #> and #>>
+SELECT j #> '{a,1}' AS a, j #>> '{a,1,b}' AS b, j #>> '{a,5}' AS c, j #>> '{a,x}' AS d,
+       j #> '{}' AS e
+  FROM (SELECT '{"a": [1, {"b": "c"}]}'::jsonb AS j) s;
+-- ? looks at the top-level keys, or at the strings of a top-level array.
+SELECT '{"a": 1, "bb": 2}'::jsonb ? 'bb' AS a, '{"a": 1, "bb": 2}'::jsonb ? 'b' AS b,
+       '{"a": {"b": 1}}'::jsonb ? 'b' AS c, '["a", 1, "c"]'::jsonb ? 'c' AS d,
+       '["a", 1, "c"]'::jsonb ? '1' AS e, '"a"'::jsonb ? 'a' AS f;
+-- @> and <@. Numbers compare as numbers, and an array contains a scalar
+-- that is one of its elements.
+SELECT j @> '{"a": 1}' AS a, j @> '{"b": [3, 1]}' AS b, j @> '{"b": [4]}' AS c,
+       j @> '{"c": {"f": 1}}' AS d, j @> '{"c": {"d": "E"}}' AS e, j @> '{}' AS f,
+       j @> '{"a": "1"}' AS g, j @> '{"x": null}' AS h, j @> '{"b": 1}' AS i
+  FROM (SELECT '{"a": 1, "b": [1, 2, 3], "c": {"d": "e", "f": 1.0}}'::jsonb AS j) s;
+SELECT j @> '[[3]]' AS a, j @> '[3]' AS b, j @> '[{"k": "v"}]' AS c, j @> '1' AS d,
+       j @> '[]' AS e, j @> '{}' AS f, j @> '["a", 1, "a"]' AS g
+  FROM (SELECT '[1, "a", [2, 3], {"k": "v", "l": 0}]'::jsonb AS j) s;
+SELECT '1'::jsonb @> '[1]' AS a, '1'::jsonb @> '1.00' AS b, '{}'::jsonb @> '[]' AS c,
+       'null'::jsonb @> 'null' AS d, '[null]'::jsonb @> '[false]' AS e,
+       '{"a": [1]}'::jsonb <@ '{"a": [1, 2], "b": 3}' AS f,
+       '{"a": [1, 2], "b": 3}'::jsonb <@ '{"a": [1]}' AS g;
+-- Objects with many keys: every key is found by the binary search.
+CREATE TABLE jsonb_keys (id int, j jsonb) DISTRIBUTED BY (id);
+INSERT INTO jsonb_keys
+  SELECT n, ('{' || string_agg('"k' || i || '": ' || (i * n), ', ') || '}')::jsonb
+  FROM generate_series(1, 3) n, generate_series(1, 1000) i GROUP BY n;
+SELECT id, j -> 'k1' AS k1, j -> 'k9' AS k9, j -> 'k10' AS k10, j -> 'k999' AS k999,
+       j -> 'k1000' AS k1000, j -> 'k0' AS k0, j -> 'k1001' AS k1001, j -> 'k' AS k
+  FROM jsonb_keys ORDER BY id;
+SELECT id, count(*) FROM jsonb_keys, generate_series(1, 1000) i
+  WHERE (j ->> ('k' || i))::int = i * id GROUP BY id ORDER BY id;
+SELECT count(*) FROM jsonb_keys, generate_series(0, 1001) i WHERE j ? ('k' || i);
+SELECT substr(j::text, 1, 40) FROM jsonb_keys WHERE id = 1;
+SELECT id FROM jsonb_keys WHERE j @> '{"k500": 1000, "k1": 2}';
+SELECT id FROM jsonb_keys WHERE j::text::jsonb::text <> j::text;
+DROP TABLE jsonb_keys;
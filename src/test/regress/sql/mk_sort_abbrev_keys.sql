@@ -0,0 +1,91 @@
+--
+-- Multi-key sorts comparing abbreviated keys (gp_mk_sort_abbrev_keys).
+-- Every query runs with abbreviated keys on and then off, with the same
+-- results. row_number() over a sort gives a checksum of the whole order.
+--
+SET gp_enable_mk_sort = on;
+
+-- Half of the t values share a 16 byte prefix. The numeric, bigint, date
+-- and timestamp columns include NaN, the extremes and infinities.
+CREATE TABLE abbrev_sort (id int, t text, c char(12), n numeric, b bigint, d date, ts timestamp)
+  DISTRIBUTED BY (id);
+INSERT INTO abbrev_sort
+  SELECT id,
+         CASE WHEN id % 97 = 0 THEN NULL
+              ELSE CASE WHEN id % 2 = 0 THEN 'abcdefghijklmnop' ELSE '' END ||
+                   translate(lpad(((id * 7919) % 20011)::text, 5, '0'), '0123456789', 'abcdefghij')
+         END,
+         translate(lpad((id % 1000)::text, 3, '0'), '0123456789', 'abcdefghij'),
+         CASE WHEN id % 501 = 0 THEN 'NaN'
+              WHEN id % 503 = 0 THEN 1e30 + id
+              WHEN id % 509 = 0 THEN id * 1e-30
+              ELSE (((id * 7919) % 20011) - 10000)::numeric / 7
+         END,
+         CASE id WHEN 1 THEN '-9223372036854775808'::bigint
+                 WHEN 2 THEN '9223372036854775807'::bigint
+                 ELSE (((id * 7919) % 20011) - 10000) * 921000000000000::bigint
+         END,
+         CASE id WHEN 3 THEN 'infinity'::date
+                 WHEN 4 THEN '-infinity'::date
+                 ELSE '2000-01-01'::date + (((id * 7919) % 20011) - 10000)
+         END,
+         '2000-01-01'::timestamp + ((id * 7919) % 20011) * interval '1 hour 1 second'
+  FROM generate_series(1, 20000) id;
+
+SET gp_mk_sort_abbrev_keys = on;
+SELECT sum(rn * id) FROM (SELECT id, row_number() OVER (ORDER BY t, id) AS rn FROM abbrev_sort) x;
+SELECT sum(rn * id) FROM (SELECT id, row_number() OVER (ORDER BY t DESC, id) AS rn FROM abbrev_sort) x;
+SELECT sum(rn * id) FROM (SELECT id, row_number() OVER (ORDER BY t NULLS FIRST, id) AS rn FROM abbrev_sort) x;
+SELECT sum(rn * id) FROM (SELECT id, row_number() OVER (ORDER BY c, t DESC NULLS LAST, id) AS rn FROM abbrev_sort) x;
+SELECT sum(rn * id) FROM (SELECT id, row_number() OVER (ORDER BY n, id) AS rn FROM abbrev_sort) x;
+SELECT sum(rn * id) FROM (SELECT id, row_number() OVER (ORDER BY n DESC, id) AS rn FROM abbrev_sort) x;
+SELECT sum(rn * id) FROM (SELECT id, row_number() OVER (ORDER BY b, id) AS rn FROM abbrev_sort) x;
+SELECT sum(rn * id) FROM (SELECT id, row_number() OVER (ORDER BY d DESC, id) AS rn FROM abbrev_sort) x;
+SELECT sum(rn * id) FROM (SELECT id, row_number() OVER (ORDER BY ts, id) AS rn FROM abbrev_sort) x;
+SELECT id, t FROM abbrev_sort ORDER BY t, id LIMIT 3;
+SELECT id, b FROM abbrev_sort ORDER BY b DESC LIMIT 2;
+-- External sorts
+SET statement_mem = '1000kB';
+SELECT sum(rn * id) FROM (SELECT id, row_number() OVER (ORDER BY t, id) AS rn FROM abbrev_sort) x;
+SELECT sum(rn * id) FROM (SELECT id, row_number() OVER (ORDER BY t DESC, id) AS rn FROM abbrev_sort) x;
+SELECT sum(rn * id) FROM (SELECT id, row_number() OVER (ORDER BY t NULLS FIRST, id) AS rn FROM abbrev_sort) x;
+SELECT sum(rn * id) FROM (SELECT id, row_number() OVER (ORDER BY c, t DESC NULLS LAST, id) AS rn FROM abbrev_sort) x;
+SELECT sum(rn * id) FROM (SELECT id, row_number() OVER (ORDER BY n, id) AS rn FROM abbrev_sort) x;
+SELECT sum(rn * id) FROM (SELECT id, row_number() OVER (ORDER BY n DESC, id) AS rn FROM abbrev_sort) x;
+SELECT sum(rn * id) FROM (SELECT id, row_number() OVER (ORDER BY b, id) AS rn FROM abbrev_sort) x;
+SELECT sum(rn * id) FROM (SELECT id, row_number() OVER (ORDER BY d DESC, id) AS rn FROM abbrev_sort) x;
+SELECT sum(rn * id) FROM (SELECT id, row_number() OVER (ORDER BY ts, id) AS rn FROM abbrev_sort) x;
+SELECT id, t FROM abbrev_sort ORDER BY t, id LIMIT 3;
+SELECT id, b FROM abbrev_sort ORDER BY b DESC LIMIT 2;
+RESET statement_mem;
+
+SET gp_mk_sort_abbrev_keys = off;
+SELECT sum(rn * id) FROM (SELECT id, row_number() OVER (ORDER BY t, id) AS rn FROM abbrev_sort) x;
+SELECT sum(rn * id) FROM (SELECT id, row_number() OVER (ORDER BY t DESC, id) AS rn FROM abbrev_sort) x;
+SELECT sum(rn * id) FROM (SELECT id, row_number() OVER (ORDER BY t NULLS FIRST, id) AS rn FROM abbrev_sort) x;
+SELECT sum(rn * id) FROM (SELECT id, row_number() OVER (ORDER BY c, t DESC NULLS LAST, id) AS rn FROM abbrev_sort) x;
+SELECT sum(rn * id) FROM (SELECT id, row_number() OVER (ORDER BY n, id) AS rn FROM abbrev_sort) x;
+SELECT sum(rn * id) FROM (SELECT id, row_number() OVER (ORDER BY n DESC, id) AS rn FROM abbrev_sort) x;
+SELECT sum(rn * id) FROM (SELECT id, row_number() OVER (ORDER BY b, id) AS rn FROM abbrev_sort) x;
+SELECT sum(rn * id) FROM (SELECT id, row_number() OVER (ORDER BY d DESC, id) AS rn FROM abbrev_sort) x;
+SELECT sum(rn * id) FROM (SELECT id, row_number() OVER (ORDER BY ts, id) AS rn FROM abbrev_sort) x;
+SELECT id, t FROM abbrev_sort ORDER BY t, id LIMIT 3;
+SELECT id, b FROM abbrev_sort ORDER BY b DESC LIMIT 2;
+-- External sorts
+SET statement_mem = '1000kB';
+SELECT sum(rn * id) FROM (SELECT id, row_number() OVER (ORDER BY t, id) AS rn FROM abbrev_sort) x;
+SELECT sum(rn * id) FROM (SELECT id, row_number() OVER (ORDER BY t DESC, id) AS rn FROM abbrev_sort) x;
+SELECT sum(rn * id) FROM (SELECT id, row_number() OVER (ORDER BY t NULLS FIRST, id) AS rn FROM abbrev_sort) x;
+SELECT sum(rn * id) FROM (SELECT id, row_number() OVER (ORDER BY c, t DESC NULLS LAST, id) AS rn FROM abbrev_sort) x;
+SELECT sum(rn * id) FROM (SELECT id, row_number() OVER (ORDER BY n, id) AS rn FROM abbrev_sort) x;
+SELECT sum(rn * id) FROM (SELECT id, row_number() OVER (ORDER BY n DESC, id) AS rn FROM abbrev_sort) x;
+SELECT sum(rn * id) FROM (SELECT id, row_number() OVER (ORDER BY b, id) AS rn FROM abbrev_sort) x;
+SELECT sum(rn * id) FROM (SELECT id, row_number() OVER (ORDER BY d DESC, id) AS rn FROM abbrev_sort) x;
+SELECT sum(rn * id) FROM (SELECT id, row_number() OVER (ORDER BY ts, id) AS rn FROM abbrev_sort) x;
+SELECT id, t FROM abbrev_sort ORDER BY t, id LIMIT 3;
+SELECT id, b FROM abbrev_sort ORDER BY b DESC LIMIT 2;
+RESET statement_mem;
+
+RESET gp_mk_sort_abbrev_keys;
+DROP TABLE abbrev_sort;
+RESET gp_enable_mk_sort;
@@ -0,0 +1,90 @@
+--
+-- Batched probing of a nested loop's inner index scan
+--
+-- Every query runs with gp_nestloop_probe_batch at 64, with a batch of 2
+-- so that runs of equal keys straddle batches, and with batching off, the
+-- default; the results must be the same.  The outer side has duplicate and
+-- NULL keys, and keys with no match.
+CREATE TABLE nlpb_inner (id int, k int4, kt text, pad text) DISTRIBUTED BY (id);
+CREATE TABLE nlpb_outer (id int, k int4, k8 int8, k2 int2, kt text) DISTRIBUTED BY (id);
+INSERT INTO nlpb_inner
+  SELECT i, CASE WHEN i % 97 = 0 THEN NULL ELSE i % 50 END,
+         CASE WHEN i % 97 = 0 THEN NULL ELSE 'k' || (i % 50) END,
+         repeat('p', 1000)
+  FROM generate_series(1, 2000) i;
+INSERT INTO nlpb_outer
+  SELECT id, k, k, k, 'k' || k
+  FROM (SELECT id, CASE WHEN id % 13 = 0 THEN NULL ELSE id % 70 END AS k
+        FROM generate_series(1, 300) id) s;
+CREATE INDEX nlpb_inner_k ON nlpb_inner (k);
+CREATE INDEX nlpb_inner_kt ON nlpb_inner (kt);
+ANALYZE nlpb_inner;
+ANALYZE nlpb_outer;
+SET enable_nestloop = on;
+SET enable_hashjoin = off;
+SET enable_mergejoin = off;
+SET enable_bitmapscan = off;
+SET enable_seqscan = off;
+SHOW gp_nestloop_probe_batch;
+SET gp_nestloop_probe_batch = 64;
+SELECT count(*), sum(o.id), sum(i.k) FROM nlpb_outer o JOIN nlpb_inner i ON i.k = o.k;
+SELECT count(*), count(i.k), sum(o.id) FROM nlpb_outer o LEFT JOIN nlpb_inner i ON i.k = o.k;
+SELECT count(*), sum(o.id) FROM nlpb_outer o WHERE EXISTS (SELECT 1 FROM nlpb_inner i WHERE i.k = o.k);
+SELECT count(*), sum(o.id) FROM nlpb_outer o WHERE NOT EXISTS (SELECT 1 FROM nlpb_inner i WHERE i.k = o.k);
+SELECT count(*), sum(o.id) FROM nlpb_outer o JOIN nlpb_inner i ON i.k = o.k8;
+SELECT count(*), sum(o.id) FROM nlpb_outer o JOIN nlpb_inner i ON i.k = o.k2;
+SELECT count(*), sum(o.id) FROM nlpb_outer o JOIN nlpb_inner i ON i.kt = o.kt;
+SELECT count(*), count(i.id), sum(o.id) FROM nlpb_outer o LEFT JOIN nlpb_inner i ON i.k = o.k AND i.id < o.id;
+SELECT o.id, o.k, count(i.k) FROM nlpb_outer o LEFT JOIN nlpb_inner i ON i.k = o.k
+  WHERE o.id <= 15 GROUP BY o.id, o.k ORDER BY o.id;
+SELECT count(*) FROM (SELECT o.id FROM nlpb_outer o JOIN nlpb_inner i ON i.k = o.k LIMIT 10) s;
+SELECT o2.id, (SELECT count(*) FROM nlpb_outer o JOIN nlpb_inner i ON i.k = o.k
+               WHERE o.id <= o2.id) AS n
+  FROM nlpb_outer o2 WHERE o2.id <= 5 ORDER BY o2.id;
+SET gp_nestloop_probe_batch = 2;
+SELECT count(*), sum(o.id), sum(i.k) FROM nlpb_outer o JOIN nlpb_inner i ON i.k = o.k;
+SELECT count(*), count(i.k), sum(o.id) FROM nlpb_outer o LEFT JOIN nlpb_inner i ON i.k = o.k;
+SELECT count(*), sum(o.id) FROM nlpb_outer o WHERE EXISTS (SELECT 1 FROM nlpb_inner i WHERE i.k = o.k);
+SELECT count(*), sum(o.id) FROM nlpb_outer o WHERE NOT EXISTS (SELECT 1 FROM nlpb_inner i WHERE i.k = o.k);
+SELECT count(*), sum(o.id) FROM nlpb_outer o JOIN nlpb_inner i ON i.k = o.k8;
+SELECT count(*), sum(o.id) FROM nlpb_outer o JOIN nlpb_inner i ON i.k = o.k2;
+SELECT count(*), sum(o.id) FROM nlpb_outer o JOIN nlpb_inner i ON i.kt = o.kt;
+SELECT count(*), count(i.id), sum(o.id) FROM nlpb_outer o LEFT JOIN nlpb_inner i ON i.k = o.k AND i.id < o.id;
+SELECT o.id, o.k, count(i.k) FROM nlpb_outer o LEFT JOIN nlpb_inner i ON i.k = o.k
+  WHERE o.id <= 15 GROUP BY o.id, o.k ORDER BY o.id;
+SELECT count(*) FROM (SELECT o.id FROM nlpb_outer o JOIN nlpb_inner i ON i.k = o.k LIMIT 10) s;
+SELECT o2.id, (SELECT count(*) FROM nlpb_outer o JOIN nlpb_inner i ON i.k = o.k
+               WHERE o.id <= o2.id) AS n
+  FROM nlpb_outer o2 WHERE o2.id <= 5 ORDER BY o2.id;
+RESET gp_nestloop_probe_batch;
+SELECT count(*), sum(o.id), sum(i.k) FROM nlpb_outer o JOIN nlpb_inner i ON i.k = o.k;
+SELECT count(*), count(i.k), sum(o.id) FROM nlpb_outer o LEFT JOIN nlpb_inner i ON i.k = o.k;
+SELECT count(*), sum(o.id) FROM nlpb_outer o WHERE EXISTS (SELECT 1 FROM nlpb_inner i WHERE i.k = o.k);
+SELECT count(*), sum(o.id) FROM nlpb_outer o WHERE NOT EXISTS (SELECT 1 FROM nlpb_inner i WHERE i.k = o.k);
+SELECT count(*), sum(o.id) FROM nlpb_outer o JOIN nlpb_inner i ON i.k = o.k8;
+SELECT count(*), sum(o.id) FROM nlpb_outer o JOIN nlpb_inner i ON i.k = o.k2;
+SELECT count(*), sum(o.id) FROM nlpb_outer o JOIN nlpb_inner i ON i.kt = o.kt;
+SELECT count(*), count(i.id), sum(o.id) FROM nlpb_outer o LEFT JOIN nlpb_inner i ON i.k = o.k AND i.id < o.id;
+SELECT o.id, o.k, count(i.k) FROM nlpb_outer o LEFT JOIN nlpb_inner i ON i.k = o.k
+  WHERE o.id <= 15 GROUP BY o.id, o.k ORDER BY o.id;
+SELECT count(*) FROM (SELECT o.id FROM nlpb_outer o JOIN nlpb_inner i ON i.k = o.k LIMIT 10) s;
+SELECT o2.id, (SELECT count(*) FROM nlpb_outer o JOIN nlpb_inner i ON i.k = o.k
+               WHERE o.id <= o2.id) AS n
+  FROM nlpb_outer o2 WHERE o2.id <= 5 ORDER BY o2.id;
+-- A work_mem too small for the inner tuples of one batch: the keys past
+-- the limit are probed for each outer tuple.
+SET gp_nestloop_probe_batch = 64;
+SET work_mem = 64;
+SELECT count(*), sum(o.id), sum(i.k) FROM nlpb_outer o JOIN nlpb_inner i ON i.k = o.k;
+SELECT count(*), count(i.k), sum(o.id) FROM nlpb_outer o LEFT JOIN nlpb_inner i ON i.k = o.k;
+SELECT count(*), sum(o.id) FROM nlpb_outer o WHERE EXISTS (SELECT 1 FROM nlpb_inner i WHERE i.k = o.k);
+SELECT count(*), sum(o.id) FROM nlpb_outer o WHERE NOT EXISTS (SELECT 1 FROM nlpb_inner i WHERE i.k = o.k);
+RESET work_mem;
+RESET gp_nestloop_probe_batch;
+RESET enable_nestloop;
+RESET enable_hashjoin;
+RESET enable_mergejoin;
+RESET enable_bitmapscan;
+RESET enable_seqscan;
+DROP TABLE nlpb_inner;
+DROP TABLE nlpb_outer;
@@ -0,0 +1,68 @@
+--
+-- SUM and AVG of numeric, which keep the sum in fixed point while every
+-- input has the same scale and falls back to numeric otherwise
+--
+CREATE TABLE numeric_sum_t (id int, k int, m numeric(12,2), v numeric)
+  DISTRIBUTED BY (id);
+-- m has two decimals throughout, v between none and three.
+INSERT INTO numeric_sum_t
+  SELECT i, i % 4, ((i * 7919) % 100000 - 30000) / 100.0,
+    (CASE WHEN i % 4 = 0 THEN (i % 7)::text
+          ELSE (i % 7)::text || '.' || repeat('5', i % 4) END)::numeric
+  FROM generate_series(1, 200) i;
+-- Values that do not fit in 64 bits once scaled, or with too many decimals.
+INSERT INTO numeric_sum_t VALUES
+  (201, 4, NULL, 1.25),
+  (202, 4, NULL, 12345678901234567890.5),
+  (203, 4, NULL, 0.0000000000000000001),
+  (204, 4, NULL, -12345678901234567890.5);
+-- NaN.
+INSERT INTO numeric_sum_t VALUES
+  (205, 5, NULL, 1.5),
+  (206, 5, NULL, 'NaN'),
+  (207, 5, NULL, 2.5);
+-- Same scale: the fixed-point sum, per segment and then combined.
+SELECT k, count(m), sum(m), round(avg(m), 4) AS avg
+  FROM numeric_sum_t GROUP BY k ORDER BY k;
+SELECT count(m), sum(m), round(avg(m), 4) AS avg,
+  sum(m) = sum((m * 100)::int8) / 100 AS same
+  FROM numeric_sum_t;
+-- Mixed scales: the result has the largest one.
+SELECT k, count(v), sum(v), round(avg(v), 4) AS avg
+  FROM numeric_sum_t GROUP BY k ORDER BY k;
+SELECT sum(v), round(avg(v), 4) AS avg FROM numeric_sum_t WHERE k < 5;
+SELECT sum(v), avg(v) FROM numeric_sum_t;
+-- Both columns in one scan.
+SELECT k % 2 AS k2, sum(m), sum(v) FROM numeric_sum_t
+  WHERE k < 4 GROUP BY k % 2 ORDER BY 1;
+-- No rows, or only NULLs.
+SELECT sum(m), avg(m) FROM numeric_sum_t WHERE k = 4;
+SELECT sum(v), avg(v) FROM numeric_sum_t WHERE k > 5;
+-- Aggregating in one stage gives the same results.
+SET gp_enable_multiphase_agg = off;
+SELECT k, count(v), sum(v), round(avg(v), 4) AS avg
+  FROM numeric_sum_t GROUP BY k ORDER BY k;
+SELECT count(m), sum(m), round(avg(m), 4) AS avg FROM numeric_sum_t;
+RESET gp_enable_multiphase_agg;
+-- Window frames.  A frame without any non-NULL value sums to NULL, both
+-- before the first row and once the values have left it.  A frame's sum is
+-- worked out from the running sums, so it has their scale; cast it to
+-- compare the values.
+CREATE TABLE numeric_sum_w (id int, v numeric) DISTRIBUTED BY (id);
+INSERT INTO numeric_sum_w VALUES
+  (1, 1.50), (2, 2.25), (3, NULL), (4, NULL), (5, NULL), (6, 3.00),
+  (7, 100.125), (8, 4.00), (9, 1.00), (10, NULL);
+SELECT id, v,
+  (sum(v) OVER (ORDER BY id ROWS BETWEEN 1 PRECEDING AND CURRENT ROW))::numeric(10,3) AS s1,
+  (sum(v) OVER (ORDER BY id ROWS BETWEEN 2 PRECEDING AND 1 PRECEDING))::numeric(10,3) AS s2,
+  (sum(v) OVER (ORDER BY id))::numeric(10,3) AS running
+  FROM numeric_sum_w ORDER BY id;
+SELECT id, v,
+  sum(v) OVER (ORDER BY id RANGE BETWEEN 1 PRECEDING AND 1 FOLLOWING) AS s,
+  count(v) OVER (ORDER BY id RANGE BETWEEN 1 PRECEDING AND 1 FOLLOWING) AS n
+  FROM numeric_sum_w WHERE id <= 6 ORDER BY id;
+-- NaN stays in a running sum.
+SELECT id, v, sum(v) OVER (ORDER BY id) AS running
+  FROM numeric_sum_t WHERE k = 5 ORDER BY id;
+DROP TABLE numeric_sum_t;
+DROP TABLE numeric_sum_w;
@@ -0,0 +1,55 @@
+--
+-- PARALLEL RETRIEVE cursors, seen from the master. Retrieving their rows
+-- from the segments is tested in isolation2.
+--
+CREATE TABLE prc_t (a int, b text) DISTRIBUTED BY (a);
+INSERT INTO prc_t SELECT i, 'row ' || i FROM generate_series(1, 100) i;
+-- Each cursor has one endpoint per segment, all with the same token.
+BEGIN;
+DECLARE c1 PARALLEL RETRIEVE CURSOR FOR SELECT * FROM prc_t;
+DECLARE c2 PARALLEL RETRIEVE CURSOR FOR SELECT a, length(b) FROM prc_t WHERE a > 50;
+SELECT cursorname,
+       count(*) = (SELECT count(*) FROM gp_segment_configuration
+                   WHERE role = 'p' AND content >= 0) AS all_segments,
+       count(DISTINCT gp_segment_id) = count(*) AS distinct_segments,
+       count(DISTINCT token) AS tokens, min(length(token)) AS token_length,
+       bool_and(hostname IS NOT NULL AND port > 0) AS located
+  FROM gp_endpoints() GROUP BY cursorname ORDER BY cursorname;
+SELECT count(DISTINCT token) FROM gp_endpoints();
+-- Closing a cursor that nobody retrieved from ends its endpoints.
+CLOSE c1;
+SELECT DISTINCT cursorname FROM gp_endpoints();
+COMMIT;
+SELECT count(*) FROM gp_endpoints();
+-- The rows don't come to the master.
+BEGIN;
+DECLARE c1 PARALLEL RETRIEVE CURSOR FOR SELECT * FROM prc_t;
+FETCH 1 FROM c1;
+ROLLBACK;
+SELECT count(*) FROM gp_endpoints();
+BEGIN;
+DECLARE c1 PARALLEL RETRIEVE CURSOR FOR SELECT * FROM prc_t;
+MOVE 1 IN c1;
+ROLLBACK;
+RETRIEVE ALL FROM ENDPOINT '0123456789abcdef0123456789abcdef';
+-- Queries whose result is not produced on the segments, and WITH HOLD
+DECLARE c1 PARALLEL RETRIEVE CURSOR FOR SELECT * FROM prc_t;
+DECLARE c1 PARALLEL RETRIEVE CURSOR WITH HOLD FOR SELECT * FROM prc_t;
+BEGIN;
+DECLARE c1 PARALLEL RETRIEVE CURSOR FOR SELECT * FROM prc_t LIMIT 10;
+ROLLBACK;
+BEGIN;
+DECLARE c1 PARALLEL RETRIEVE CURSOR FOR SELECT count(*) FROM prc_t;
+ROLLBACK;
+BEGIN;
+DECLARE c1 PARALLEL RETRIEVE CURSOR FOR SELECT relname FROM pg_class;
+ROLLBACK;
+-- gp_wait_parallel_retrieve_cursor() only takes PARALLEL RETRIEVE cursors.
+BEGIN;
+DECLARE c1 CURSOR FOR SELECT * FROM prc_t;
+SELECT gp_wait_parallel_retrieve_cursor('c1');
+ROLLBACK;
+SELECT gp_wait_parallel_retrieve_cursor('nosuch');
+-- On the master, no segment endpoints are ever set up.
+SELECT count(*) FROM gp_segment_endpoints();
+DROP TABLE prc_t;
@@ -345,3 +345,5 @@ DROP USER rq_test_u;
 DROP RESOURCE QUEUE rq_test_q;
 DROP TABLE rq_product;
 
+-- Every queue has a wait time histogram
+SELECT count(*) FROM pg_resqueue_status WHERE array_length(rsqwaithistogram, 1) <> 7;
@@ -0,0 +1,163 @@
+--
+-- Session-level SETs sent to the QEs along with the next dispatched command
+-- (gp_dispatch_session_state_delta).
+--
+-- start_matchsubs
+-- m/^ERROR:(?!  failing on the segments).*seg0.*/
+-- s/^ERROR:.*/ERROR:  QE on seg0 failed/
+-- end_matchsubs
+-- start_matchignore
+-- m/^DETAIL:/
+-- m/^CONTEXT:/
+-- end_matchignore
+CREATE EXTENSION IF NOT EXISTS gp_inject_fault;
+CREATE SCHEMA session_state_delta;
+SET search_path = session_state_delta;
+
+-- The settings and users as seen by the QEs. The functions are volatile, so
+-- that they are not evaluated on the QD while planning. DISTINCT leaves one
+-- row as long as all segments agree.
+CREATE FUNCTION qe_setting(text) RETURNS text AS $$
+BEGIN
+	RETURN current_setting($1);
+END $$ LANGUAGE plpgsql VOLATILE;
+CREATE FUNCTION qe_current_user() RETURNS text AS $$
+BEGIN
+	RETURN current_user;
+END $$ LANGUAGE plpgsql VOLATILE;
+CREATE FUNCTION qe_session_user() RETURNS text AS $$
+BEGIN
+	RETURN session_user;
+END $$ LANGUAGE plpgsql VOLATILE;
+CREATE FUNCTION qe_fail() RETURNS int AS $$
+BEGIN
+	RAISE EXCEPTION 'failing on the segments';
+END $$ LANGUAGE plpgsql VOLATILE;
+CREATE VIEW qe_settings AS
+  SELECT DISTINCT qe_setting('work_mem') AS work_mem,
+         qe_setting('extra_float_digits') AS extra_float_digits
+  FROM gp_dist_random('gp_id');
+CREATE VIEW qe_users AS
+  SELECT DISTINCT qe_current_user() AS current_usr,
+         qe_session_user() AS session_usr
+  FROM gp_dist_random('gp_id');
+CREATE ROLE ssd_role;
+CREATE ROLE ssd_user;
+GRANT ssd_role TO ssd_user;
+GRANT USAGE ON SCHEMA session_state_delta TO PUBLIC;
+GRANT SELECT ON qe_settings, qe_users TO PUBLIC;
+
+SET gp_dispatch_session_state_delta = on;
+
+-- A SET reaches the QEs with the next command. work_mem is also part of the
+-- options of new QEs, extra_float_digits only reaches them this way.
+SET work_mem = '3MB';
+SET extra_float_digits = 2;
+SELECT * FROM qe_settings;
+SELECT * FROM qe_settings;
+
+-- The command carrying a SET fails on the QEs, which drop the SET along with
+-- the transaction. The next command must carry it again.
+SET work_mem = '4MB';
+SELECT qe_fail() FROM gp_dist_random('gp_id');
+SELECT * FROM qe_settings;
+
+-- An error on the QD, before anything is dispatched.
+SET extra_float_digits = 3;
+SELECT qe_fail() FROM gp_dist_random('gp_id') WHERE 1 / 0 = 1;
+SELECT * FROM qe_settings;
+
+-- SET in a transaction block is dispatched right away, and rolled back with
+-- the transaction, also on the QEs.
+BEGIN;
+SET work_mem = '5MB';
+SELECT * FROM qe_settings;
+SELECT qe_fail() FROM gp_dist_random('gp_id');
+ROLLBACK;
+SELECT * FROM qe_settings;
+
+BEGIN;
+SET work_mem = '5MB';
+SAVEPOINT sp;
+SET extra_float_digits = 1;
+SELECT qe_fail() FROM gp_dist_random('gp_id');
+ROLLBACK TO SAVEPOINT sp;
+SELECT * FROM qe_settings;
+COMMIT;
+SELECT * FROM qe_settings;
+
+-- The committed SET of the transaction block supersedes the earlier ones,
+-- also for QEs started later.
+SET gp_vmem_idle_resource_timeout = 1;
+\! sleep 0.5
+SELECT * FROM qe_settings;
+RESET gp_vmem_idle_resource_timeout;
+
+-- RESET and RESET ALL. RESET ALL also turns gp_dispatch_session_state_delta
+-- off; compare with the QD, whose defaults depend on the environment.
+RESET extra_float_digits;
+SELECT work_mem, extra_float_digits = current_setting('extra_float_digits') AS efd_synced
+FROM qe_settings;
+SET extra_float_digits = 2;
+SELECT * FROM qe_settings;
+RESET ALL;
+SELECT work_mem = current_setting('work_mem') AS work_mem_synced,
+       extra_float_digits = current_setting('extra_float_digits') AS efd_synced
+FROM qe_settings;
+SHOW gp_dispatch_session_state_delta;
+SET search_path = session_state_delta;
+SET gp_dispatch_session_state_delta = on;
+
+-- SET ROLE and SET SESSION AUTHORIZATION.
+SET ROLE ssd_role;
+SELECT current_usr, session_usr = session_user AS session_synced FROM qe_users;
+RESET ROLE;
+SELECT current_usr = current_user AS current_synced FROM qe_users;
+SET SESSION AUTHORIZATION ssd_user;
+SELECT * FROM qe_users;
+SET ROLE ssd_role;
+SELECT * FROM qe_users;
+SET work_mem = '6MB';
+SELECT work_mem FROM qe_settings;
+RESET SESSION AUTHORIZATION;
+SELECT current_usr = current_user AS current_synced,
+       session_usr = session_user AS session_synced
+FROM qe_users;
+
+-- A QE on seg0 fails. The gangs are created again, and the new QEs are sent
+-- all the settings.
+SET extra_float_digits = 2;
+SELECT * FROM qe_settings;
+SET work_mem = '7MB';
+SELECT gp_inject_fault('qe_got_snapshot_and_interconnect', 'fatal', 2);
+SELECT * FROM qe_settings;
+SELECT gp_inject_fault('qe_got_snapshot_and_interconnect', 'reset', 2);
+SELECT * FROM qe_settings;
+SET ROLE ssd_role;
+SELECT gp_inject_fault('qe_got_snapshot_and_interconnect', 'fatal', 2);
+SELECT * FROM qe_users;
+SELECT gp_inject_fault('qe_got_snapshot_and_interconnect', 'reset', 2);
+SELECT current_usr, session_usr = session_user AS session_synced FROM qe_users;
+RESET ROLE;
+
+-- Turning the GUC off dispatches SETs right away again. They still
+-- supersede the earlier ones for QEs started later.
+SET gp_dispatch_session_state_delta = off;
+SET work_mem = '8MB';
+SELECT * FROM qe_settings;
+SET gp_vmem_idle_resource_timeout = 1;
+\! sleep 0.5
+SELECT * FROM qe_settings;
+RESET gp_vmem_idle_resource_timeout;
+
+-- The fault must not be left behind for later tests.
+SELECT gp_inject_fault('qe_got_snapshot_and_interconnect', 'reset', 2);
+RESET ALL;
+DROP VIEW session_state_delta.qe_settings, session_state_delta.qe_users;
+DROP FUNCTION session_state_delta.qe_setting(text);
+DROP FUNCTION session_state_delta.qe_current_user();
+DROP FUNCTION session_state_delta.qe_session_user();
+DROP FUNCTION session_state_delta.qe_fail();
+DROP SCHEMA session_state_delta;
+DROP ROLE ssd_user;
+DROP ROLE ssd_role;
@@ -0,0 +1,46 @@
+--
+-- min and max over moving window frames, kept up to date as the frame
+-- moves instead of scanning it for every row
+--
+CREATE TABLE wse_small (p int, id int, x int, t text) DISTRIBUTED BY (id);
+INSERT INTO wse_small VALUES
+  (1, 1, 5, 'pear'), (1, 2, 3, 'fig'), (1, 3, 3, 'kiwi'), (1, 4, NULL, NULL),
+  (1, 5, 8, 'apple'), (1, 6, 1, 'plum'), (1, 7, 8, 'date'), (1, 8, 2, 'lime'),
+  (2, 1, NULL, NULL), (2, 2, NULL, NULL), (2, 3, 7, 'yam'), (2, 4, 4, 'nut');
+-- Frames ending at, before and after the current row, in each partition.
+SELECT p, id, x,
+  min(x) OVER (PARTITION BY p ORDER BY id ROWS BETWEEN 2 PRECEDING AND CURRENT ROW) AS min_2p,
+  max(x) OVER (PARTITION BY p ORDER BY id ROWS BETWEEN 2 PRECEDING AND CURRENT ROW) AS max_2p,
+  min(x) OVER (PARTITION BY p ORDER BY id ROWS BETWEEN 1 PRECEDING AND 1 FOLLOWING) AS min_1p1f,
+  max(x) OVER (PARTITION BY p ORDER BY id ROWS BETWEEN 2 PRECEDING AND 1 PRECEDING) AS max_prev,
+  min(x) OVER (PARTITION BY p ORDER BY id ROWS BETWEEN 1 FOLLOWING AND 2 FOLLOWING) AS min_next
+  FROM wse_small ORDER BY p, id;
+-- Other types, and RANGE frames.
+SELECT p, id, t,
+  min(t) OVER (PARTITION BY p ORDER BY id ROWS BETWEEN 2 PRECEDING AND CURRENT ROW) AS min_t,
+  max(t) OVER (PARTITION BY p ORDER BY id ROWS BETWEEN 2 PRECEDING AND CURRENT ROW) AS max_t,
+  max(x) OVER (PARTITION BY p ORDER BY id RANGE BETWEEN 2 PRECEDING AND 1 FOLLOWING) AS max_range
+  FROM wse_small ORDER BY p, id;
+-- A larger input, checked in total.  Both directions and a NULL now and then.
+CREATE TABLE wse_big (p int, id int, x int) DISTRIBUTED BY (id);
+INSERT INTO wse_big
+  SELECT i % 3, i, CASE WHEN i % 17 = 0 THEN NULL ELSE (i * 7919) % 1009 END
+  FROM generate_series(1, 3000) i;
+CREATE VIEW wse_big_frames AS
+  SELECT p, id,
+    min(x) OVER (PARTITION BY p ORDER BY id ROWS BETWEEN 10 PRECEDING AND CURRENT ROW) AS a,
+    max(x) OVER (PARTITION BY p ORDER BY id ROWS BETWEEN 10 PRECEDING AND CURRENT ROW) AS b,
+    min(x) OVER (PARTITION BY p ORDER BY id ROWS BETWEEN 7 PRECEDING AND 7 FOLLOWING) AS c,
+    max(x) OVER (PARTITION BY p ORDER BY id ROWS BETWEEN 3 FOLLOWING AND 30 FOLLOWING) AS d,
+    min(x) OVER (PARTITION BY p ORDER BY id RANGE BETWEEN 20 PRECEDING AND 5 FOLLOWING) AS e
+  FROM wse_big;
+SELECT p, count(a), sum(a), sum(b), sum(c), count(d), sum(d), sum(e)
+  FROM wse_big_frames GROUP BY p ORDER BY p;
+-- Scanning the frames gives the same results.
+SET gp_enable_window_sliding_extremes = off;
+SELECT p, count(a), sum(a), sum(b), sum(c), count(d), sum(d), sum(e)
+  FROM wse_big_frames GROUP BY p ORDER BY p;
+RESET gp_enable_window_sliding_extremes;
+DROP VIEW wse_big_frames;
+DROP TABLE wse_big;
+DROP TABLE wse_small;
@@ -13,7 +13,7 @@ InitCodegen()
 
 // creates a manager for an operator
 void*
-CodeGeneratorManagerCreate(const char* module_name)
+CodeGeneratorManagerCreate(const char* module_name, int optimization_level)
 {
 	elog(ERROR, "mock implementation of CodeGeneratorManager_Create called");
 	return NULL;
@@ -35,6 +35,22 @@ CodeGeneratorManagerPrepareGeneratedFunctions(void* manager)
 	return 1;
 }
 
+// starts compiling the code gened function pointers in the background
+bool
+CodeGeneratorManagerPrepareGeneratedFunctionsInBackground(void* manager)
+{
+	elog(ERROR, "mock implementation of CodeGeneratorManager_PrepareGeneratedFunctionsInBackground called");
+	return false;
+}
+
+// switches to the code gened functions once compiled in the background
+bool
+CodeGeneratorManagerPollGeneratedFunctions(void* manager)
+{
+	elog(ERROR, "mock implementation of CodeGeneratorManager_PollGeneratedFunctions called");
+	return false;
+}
+
 // notifies a manager that the underlying operator has a parameter change
 unsigned int
 CodeGeneratorManagerNotifyParameterChange(void* manager)
@@ -120,3 +136,36 @@ AdvanceAggregatesCodegenEnroll(AdvanceAggregatesFn regular_func_ptr,
 	return NULL;
 }
 
+
+// Enroll and returns the pointer to ExecHashGetHashValueGenerator
+void*
+ExecHashGetHashValueCodegenEnroll(ExecHashGetHashValueFn regular_func_ptr,
+		ExecHashGetHashValueFn* ptr_to_regular_func_ptr,
+		struct List *hashkeys,
+		struct List *hash_operators,
+		bool outer_tuple,
+		struct ExprContext *econtext) {
+	*ptr_to_regular_func_ptr = regular_func_ptr;
+	elog(ERROR, "mock implementation of ExecHashGetHashValueCodegenEnroll called");
+	return NULL;
+}
+
+// Enroll and returns the pointer to DatumStreamBlockReadGetBatchGenerator
+void*
+DatumStreamBlockReadGetBatchCodegenEnroll(DatumStreamBlockReadGetBatchFn regular_func_ptr,
+		DatumStreamBlockReadGetBatchFn* ptr_to_regular_func_ptr,
+		int32 datumlen) {
+	*ptr_to_regular_func_ptr = regular_func_ptr;
+	elog(ERROR, "mock implementation of DatumStreamBlockReadGetBatchCodegenEnroll called");
+	return NULL;
+}
+
+// Enroll and returns the pointer to ExecScanQualProjectGenerator
+void*
+ExecScanQualProjectCodegenEnroll(ExecScanQualProjectFn regular_func_ptr,
+		ExecScanQualProjectFn* ptr_to_regular_func_ptr,
+		struct ScanState *scan_state) {
+	*ptr_to_regular_func_ptr = regular_func_ptr;
+	elog(ERROR, "mock implementation of ExecScanQualProjectCodegenEnroll called");
+	return NULL;
+}